@@ -22,6 +22,17 @@
 #define DB_DISCOVERY_MAX_USERS BLE_DB_DISCOVERY_MAX_SRV  /**< The maximum number of users/registrations allowed by this module. */
 #define MODULE_INITIALIZED (m_initialized == true)       /**< Macro designating whether the module has been initialized properly. */
 
+#if BLE_DB_DISCOVERY_CACHE_ENABLED
+#include "fds.h"
+#include <stddef.h>
+#include <string.h>
+
+#define DB_INTERNAL_SRV        1                         /**< The GATT Service, discovered first for the Service Changed characteristic. */
+#define CACHE_RECORD_KEY       0x0001                    /**< Record key of all cache entries; the peer address tells them apart. */
+#else
+#define DB_INTERNAL_SRV        0
+#endif
+
 
 /**@brief Array of structures containing information about the registered application modules. */
 static ble_uuid_t m_registered_handlers[DB_DISCOVERY_MAX_USERS];
@@ -44,6 +55,31 @@ static uint32_t m_pending_usr_evt_index;    /**< The index to the pending user e
 static uint32_t m_num_of_handlers_reg;      /**< The number of handlers registered with the DB Discovery module. */
 static bool     m_initialized = false;      /**< This variable Indicates if the module is initialized or not. */
 
+#if BLE_DB_DISCOVERY_CACHE_ENABLED
+/**@brief Cache entry of one peer, as one FDS record: this header, then the registered services. */
+typedef struct
+{
+    ble_gap_addr_t    peer_addr;
+    uint8_t           srv_count;                                /**< Registered services stored. */
+    uint8_t           found;                                    /**< Bit per service: found at the peer. */
+    uint8_t           reserved;
+    uint16_t          sc_handle;                                /**< Value handle of the Service Changed characteristic. */
+    uint16_t          sc_cccd_handle;
+    uint16_t          reserved2;
+    ble_gatt_db_srv_t services[BLE_DB_DISCOVERY_CACHE_MAX_SRV];
+} db_cache_entry_t;
+
+#define CACHE_HDR_LEN  offsetof(db_cache_entry_t, services)
+
+STATIC_ASSERT(CACHE_HDR_LEN % sizeof(uint32_t) == 0);
+STATIC_ASSERT(sizeof(ble_gatt_db_srv_t) % sizeof(uint32_t) == 0);
+STATIC_ASSERT(BLE_DB_DISCOVERY_CACHE_MAX_SRV <= 8);
+
+__ALIGN(4) static db_cache_entry_t m_cache_entry;   /**< Entry being written; FDS reads it until done. */
+static bool                        m_cache_write_pending;
+static bool                        m_fds_registered;
+#endif
+
 /**@brief     Function for fetching the event handler provided by a registered application module.
  *
  * @param[in] srv_uuid UUID of the service.
@@ -55,7 +91,7 @@ static ble_db_discovery_evt_handler_t registered_handler_get(const ble_uuid_t *
 {
     uint32_t i;
 
-    for (i = 0; i < m_num_of_handlers_reg; i++)
+    for (i = DB_INTERNAL_SRV; i < m_num_of_handlers_reg; i++)
     {
         if (BLE_UUID_EQ(&(m_registered_handlers[i]), p_srv_uuid))
         {
@@ -103,7 +139,7 @@ static void pending_user_evts_send(void)
 {
     uint32_t i = 0;
 
-    for (i = 0; i < m_num_of_handlers_reg; i++)
+    for (i = 0; i < m_num_of_handlers_reg - DB_INTERNAL_SRV; i++)
     {
         // Pass the event to the corresponding event handler.
         m_pending_user_evts[i].evt_handler(&(m_pending_user_evts[i].evt));
@@ -134,6 +170,13 @@ static void discovery_error_evt_trigger(ble_db_discovery_t * const p_db_discover
     p_srv_being_discovered = &(p_db_discovery->services[p_db_discovery->curr_srv_ind]);
 
     p_evt_handler = registered_handler_get(&(p_srv_being_discovered->srv_uuid));
+#if BLE_DB_DISCOVERY_CACHE_ENABLED
+    if (p_db_discovery->curr_srv_ind < DB_INTERNAL_SRV)
+    {
+        // Nobody registered the GATT Service, but the discovery ends here for all.
+        p_evt_handler = m_evt_handler;
+    }
+#endif
 
     if (p_evt_handler != NULL)
     {
@@ -148,6 +191,325 @@ static void discovery_error_evt_trigger(ble_db_discovery_t * const p_db_discover
 }
 
 
+#if BLE_DB_DISCOVERY_CACHE_ENABLED
+static bool addr_equal(ble_gap_addr_t const * p_a, ble_gap_addr_t const * p_b)
+{
+    return (p_a->addr_type == p_b->addr_type) &&
+           (memcmp(p_a->addr, p_b->addr, BLE_GAP_ADDR_LEN) == 0);
+}
+
+
+/**@brief     Function for finding the cache entry of a peer.
+ *
+ * @param[in]  p_peer_addr Address of the peer.
+ * @param[out] p_desc      Descriptor of its entry.
+ * @param[out] p_count     Number of entries. May be NULL.
+ * @param[out] p_oldest    Descriptor of the first entry, the one to give up. May be NULL.
+ *
+ * @retval    True if the peer has an entry.
+ */
+static bool cache_find(ble_gap_addr_t const * p_peer_addr,
+                       fds_record_desc_t    * p_desc,
+                       uint8_t              * p_count,
+                       fds_record_desc_t    * p_oldest)
+{
+    fds_find_token_t   token = {0};
+    fds_record_desc_t  desc;
+    fds_flash_record_t record;
+    uint8_t            count = 0;
+    bool               found = false;
+
+    while (fds_record_find_in_file(BLE_DB_DISCOVERY_CACHE_FILE_ID, &desc, &token) == FDS_SUCCESS)
+    {
+        if ((count++ == 0) && (p_oldest != NULL))
+        {
+            *p_oldest = desc;
+        }
+        if (!found && (fds_record_open(&desc, &record) == FDS_SUCCESS))
+        {
+            if (addr_equal((ble_gap_addr_t const *)record.p_data, p_peer_addr))
+            {
+                *p_desc = desc;
+                found   = true;
+            }
+            (void)fds_record_close(&desc);
+        }
+    }
+
+    if (p_count != NULL)
+    {
+        *p_count = count;
+    }
+    return found;
+}
+
+
+/**@brief     Function for queuing the events of the registered services from the cache.
+ *
+ * @param[in] p_db_discovery Pointer to the DB discovery structure, with the peer address set.
+ *
+ * @retval    True if the peer was found with the services registered now.
+ */
+static bool cache_load(ble_db_discovery_t * const p_db_discovery)
+{
+    fds_record_desc_t        desc;
+    fds_flash_record_t       record;
+    db_cache_entry_t const * p_entry;
+    uint8_t                  users = m_num_of_handlers_reg - DB_INTERNAL_SRV;
+    bool                     hit   = false;
+
+    if ((users > BLE_DB_DISCOVERY_CACHE_MAX_SRV) ||
+        !cache_find(&p_db_discovery->peer_addr, &desc, NULL, NULL) ||
+        (fds_record_open(&desc, &record) != FDS_SUCCESS))
+    {
+        return false;
+    }
+
+    p_entry = (db_cache_entry_t const *)record.p_data;
+    if ((record.p_header->tl.length_words ==
+         BYTES_TO_WORDS(CACHE_HDR_LEN + users * sizeof(ble_gatt_db_srv_t))) &&
+        (p_entry->srv_count == users))
+    {
+        hit = true;
+        for (uint8_t i = 0; i < users; i++)
+        {
+            if (!BLE_UUID_EQ(&p_entry->services[i].srv_uuid, &m_registered_handlers[DB_INTERNAL_SRV + i]))
+            {
+                hit = false;
+            }
+        }
+    }
+
+    if (hit)
+    {
+        p_db_discovery->sc_handle      = p_entry->sc_handle;
+        p_db_discovery->sc_cccd_handle = p_entry->sc_cccd_handle;
+
+        for (uint8_t i = 0; i < users; i++)
+        {
+            p_db_discovery->services[DB_INTERNAL_SRV + i] = p_entry->services[i];
+
+            m_pending_user_evts[i].evt.conn_handle          = p_db_discovery->conn_handle;
+            m_pending_user_evts[i].evt.evt_type             = (p_entry->found & (1 << i)) ?
+                                                              BLE_DB_DISCOVERY_COMPLETE :
+                                                              BLE_DB_DISCOVERY_SRV_NOT_FOUND;
+            m_pending_user_evts[i].evt.params.discovered_db = p_entry->services[i];
+            m_pending_user_evts[i].evt_handler              = m_evt_handler;
+        }
+        m_pending_usr_evt_index = users;
+    }
+
+    (void)fds_record_close(&desc);
+    return hit;
+}
+
+
+/**@brief     Function for storing the result of a discovery, from the pending events.
+ *
+ * @details   Skipped while the previous entry is still being written; the peer is then
+ *            discovered again next time.
+ *
+ * @param[in] p_db_discovery Pointer to the DB discovery structure.
+ */
+static void cache_store(ble_db_discovery_t const * const p_db_discovery)
+{
+    fds_record_chunk_t chunk;
+    fds_record_t       record;
+    fds_record_desc_t  desc;
+    fds_record_desc_t  oldest;
+    uint8_t            count;
+    uint8_t            users = m_num_of_handlers_reg - DB_INTERNAL_SRV;
+    ret_code_t         err_code;
+
+    if (m_cache_write_pending || (users > BLE_DB_DISCOVERY_CACHE_MAX_SRV))
+    {
+        return;
+    }
+
+    memset(&m_cache_entry, 0, sizeof(m_cache_entry));
+    m_cache_entry.peer_addr      = p_db_discovery->peer_addr;
+    m_cache_entry.srv_count      = users;
+    m_cache_entry.sc_handle      = p_db_discovery->sc_handle;
+    m_cache_entry.sc_cccd_handle = p_db_discovery->sc_cccd_handle;
+    for (uint8_t i = 0; i < users; i++)
+    {
+        m_cache_entry.services[i] = m_pending_user_evts[i].evt.params.discovered_db;
+        if (m_pending_user_evts[i].evt.evt_type == BLE_DB_DISCOVERY_COMPLETE)
+        {
+            m_cache_entry.found |= (1 << i);
+        }
+    }
+
+    chunk.p_data       = &m_cache_entry;
+    chunk.length_words = BYTES_TO_WORDS(CACHE_HDR_LEN + users * sizeof(ble_gatt_db_srv_t));
+
+    record.file_id         = BLE_DB_DISCOVERY_CACHE_FILE_ID;
+    record.key             = CACHE_RECORD_KEY;
+    record.data.p_chunks   = &chunk;
+    record.data.num_chunks = 1;
+
+    if (cache_find(&p_db_discovery->peer_addr, &desc, &count, &oldest))
+    {
+        err_code = fds_record_update(&desc, &record);
+    }
+    else
+    {
+        if (count >= BLE_DB_DISCOVERY_CACHE_PEERS)
+        {
+            (void)fds_record_delete(&oldest);
+        }
+        err_code = fds_record_write(NULL, &record);
+    }
+
+    if (err_code == FDS_SUCCESS)
+    {
+        m_cache_write_pending = true;
+    }
+    else if (err_code == FDS_ERR_NO_SPACE_IN_FLASH)
+    {
+        // Old copies fill the pages; the next discovery of the peer finds room.
+        (void)fds_gc();
+    }
+}
+
+
+static void fds_evt_handler(fds_evt_t const * const p_evt)
+{
+    if (((p_evt->id == FDS_EVT_WRITE) || (p_evt->id == FDS_EVT_UPDATE)) &&
+        (p_evt->write.file_id == BLE_DB_DISCOVERY_CACHE_FILE_ID))
+    {
+        m_cache_write_pending = false;
+    }
+}
+
+
+/**@brief     Function for taking the Service Changed handles from the discovered GATT Service.
+ *
+ * @param[in] p_db_discovery Pointer to the DB discovery structure.
+ * @param[in] is_srv_found   Whether the peer has a GATT Service.
+ */
+static void sc_handles_get(ble_db_discovery_t * const p_db_discovery, bool is_srv_found)
+{
+    ble_gatt_db_srv_t const * p_srv = &p_db_discovery->services[0];
+
+    p_db_discovery->sc_handle      = BLE_GATT_HANDLE_INVALID;
+    p_db_discovery->sc_cccd_handle = BLE_GATT_HANDLE_INVALID;
+
+    if (!is_srv_found)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < p_srv->char_count; i++)
+    {
+        ble_gattc_char_t const * p_char = &p_srv->charateristics[i].characteristic;
+
+        if ((p_char->uuid.type == BLE_UUID_TYPE_BLE) &&
+            (p_char->uuid.uuid == BLE_UUID_GATT_CHARACTERISTIC_SERVICE_CHANGED))
+        {
+            p_db_discovery->sc_handle      = p_char->handle_value;
+            p_db_discovery->sc_cccd_handle = p_srv->charateristics[i].cccd_handle;
+        }
+    }
+}
+
+
+/**@brief     Function for enabling the Service Changed indications of the peer.
+ *
+ * @param[in] p_db_discovery Pointer to the DB discovery structure.
+ */
+static uint32_t sc_indication_enable(ble_db_discovery_t const * const p_db_discovery)
+{
+    uint8_t buf[BLE_CCCD_VALUE_LEN];
+
+    buf[0] = BLE_GATT_HVX_INDICATION;
+    buf[1] = 0;
+
+    const ble_gattc_write_params_t write_params = {
+        .write_op = BLE_GATT_OP_WRITE_REQ,
+        .flags    = BLE_GATT_EXEC_WRITE_FLAG_PREPARED_WRITE,
+        .handle   = p_db_discovery->sc_cccd_handle,
+        .offset   = 0,
+        .len      = sizeof(buf),
+        .p_value  = buf
+    };
+
+    return sd_ble_gattc_write(p_db_discovery->conn_handle, &write_params);
+}
+
+
+/**@brief     Function for handling the answer to the enabling of the Service Changed
+ *            indications of a cached peer.
+ *
+ * @param[in] p_db_discovery  Pointer to the DB discovery structure.
+ * @param[in] p_ble_gattc_evt Pointer to the GATT Client event.
+ */
+static void on_sc_cccd_write_rsp(ble_db_discovery_t * const    p_db_discovery,
+                                 const ble_gattc_evt_t * const p_ble_gattc_evt)
+{
+    if (!p_db_discovery->cache_wait ||
+        (p_ble_gattc_evt->conn_handle != p_db_discovery->conn_handle) ||
+        (p_ble_gattc_evt->params.write_rsp.handle != p_db_discovery->sc_cccd_handle))
+    {
+        return;
+    }
+
+    p_db_discovery->cache_wait            = false;
+    p_db_discovery->discovery_in_progress = false;
+
+    if (p_ble_gattc_evt->gatt_status == BLE_GATT_STATUS_SUCCESS)
+    {
+        pending_user_evts_send();
+        return;
+    }
+
+    // The handles are not what they were: discover the peer again.
+    m_pending_usr_evt_index = 0;
+    (void)ble_db_discovery_cache_drop(&p_db_discovery->peer_addr);
+    p_db_discovery->cache_store = true;
+    if (ble_db_discovery_start(p_db_discovery, p_db_discovery->conn_handle) != NRF_SUCCESS)
+    {
+        discovery_error_evt_trigger(p_db_discovery, NRF_ERROR_INVALID_STATE, p_db_discovery->conn_handle);
+    }
+}
+
+
+/**@brief     Function for handling a Service Changed indication from the peer.
+ *
+ * @param[in] p_db_discovery  Pointer to the DB discovery structure.
+ * @param[in] p_ble_gattc_evt Pointer to the GATT Client event.
+ */
+static void on_sc_indication(ble_db_discovery_t * const    p_db_discovery,
+                             const ble_gattc_evt_t * const p_ble_gattc_evt)
+{
+    if ((p_ble_gattc_evt->conn_handle != p_db_discovery->conn_handle) ||
+        (p_db_discovery->sc_handle == BLE_GATT_HANDLE_INVALID) ||
+        (p_ble_gattc_evt->params.hvx.handle != p_db_discovery->sc_handle) ||
+        (p_ble_gattc_evt->params.hvx.type != BLE_GATT_HVX_INDICATION))
+    {
+        return;
+    }
+
+    (void)sd_ble_gattc_hv_confirm(p_ble_gattc_evt->conn_handle, p_ble_gattc_evt->params.hvx.handle);
+    (void)ble_db_discovery_cache_drop(&p_db_discovery->peer_addr);
+
+    if (p_db_discovery->cache_wait)
+    {
+        // The cached events are stale; the CCCD write answer is let pass.
+        p_db_discovery->cache_wait            = false;
+        p_db_discovery->discovery_in_progress = false;
+        m_pending_usr_evt_index               = 0;
+    }
+
+    if (!p_db_discovery->discovery_in_progress)
+    {
+        p_db_discovery->cache_store = true;
+        (void)ble_db_discovery_start(p_db_discovery, p_db_discovery->conn_handle);
+    }
+}
+#endif // BLE_DB_DISCOVERY_CACHE_ENABLED
+
+
 /**@brief     Function for triggering a Discovery Complete or Service Not Found event to the
  *            application.
  *
@@ -169,6 +531,14 @@ static void discovery_complete_evt_trigger(ble_db_discovery_t * const p_db_disco
 
     p_srv_being_discovered = &(p_db_discovery->services[p_db_discovery->curr_srv_ind]);
 
+#if BLE_DB_DISCOVERY_CACHE_ENABLED
+    if (p_db_discovery->curr_srv_ind < DB_INTERNAL_SRV)
+    {
+        sc_handles_get(p_db_discovery, is_srv_found);
+        return;
+    }
+#endif
+
     p_evt_handler = registered_handler_get(&(p_srv_being_discovered->srv_uuid));
 
     if (p_evt_handler != NULL)
@@ -194,8 +564,15 @@ static void discovery_complete_evt_trigger(ble_db_discovery_t * const p_db_disco
 
             m_pending_usr_evt_index++;
 
-            if (m_pending_usr_evt_index == m_num_of_handlers_reg)
+            if (m_pending_usr_evt_index == m_num_of_handlers_reg - DB_INTERNAL_SRV)
             {
+#if BLE_DB_DISCOVERY_CACHE_ENABLED
+                if (p_db_discovery->cache_store)
+                {
+                    p_db_discovery->cache_store = false;
+                    cache_store(p_db_discovery);
+                }
+#endif
                 // All registered modules have pending events. Send all pending events to the user
                 // modules.
                 pending_user_evts_send();
@@ -846,6 +1223,21 @@ uint32_t ble_db_discovery_init(const ble_db_discovery_evt_handler_t evt_handler)
     m_pending_usr_evt_index    = 0;
     m_evt_handler              = evt_handler;
 
+#if BLE_DB_DISCOVERY_CACHE_ENABLED
+    // The first slot discovers the GATT Service, for the Service Changed handles.
+    m_registered_handlers[0].uuid = BLE_UUID_GATT;
+    m_registered_handlers[0].type = BLE_UUID_TYPE_BLE;
+    m_num_of_handlers_reg         = DB_INTERNAL_SRV;
+
+    if (!m_fds_registered)
+    {
+        err_code = fds_register(fds_evt_handler);
+        VERIFY_SUCCESS(err_code);
+        m_fds_registered = true;
+    }
+    err_code = fds_init();
+#endif
+
     return err_code;
 
 }
@@ -876,7 +1268,7 @@ uint32_t ble_db_discovery_start(ble_db_discovery_t * const p_db_discovery,
     VERIFY_PARAM_NOT_NULL(p_db_discovery);
     VERIFY_MODULE_INITIALIZED();
 
-    if (m_num_of_handlers_reg == 0)
+    if (m_num_of_handlers_reg <= DB_INTERNAL_SRV)
     {
         // No user modules were registered. There are no services to discover.
         return NRF_ERROR_INVALID_STATE;
@@ -895,6 +1287,8 @@ uint32_t ble_db_discovery_start(ble_db_discovery_t * const p_db_discovery,
     p_db_discovery->discoveries_count = 0;
     p_db_discovery->curr_srv_ind      = 0;
     p_db_discovery->curr_char_ind     = 0;
+    p_db_discovery->sc_handle         = BLE_GATT_HANDLE_INVALID;
+    p_db_discovery->sc_cccd_handle    = BLE_GATT_HANDLE_INVALID;
 
     p_srv_being_discovered = &(p_db_discovery->services[p_db_discovery->curr_srv_ind]);
 
@@ -915,6 +1309,78 @@ uint32_t ble_db_discovery_start(ble_db_discovery_t * const p_db_discovery,
 }
 
 
+uint32_t ble_db_discovery_cached_start(ble_db_discovery_t * const   p_db_discovery,
+                                       uint16_t                     conn_handle,
+                                       ble_gap_addr_t const * const p_peer_addr)
+{
+#if BLE_DB_DISCOVERY_CACHE_ENABLED
+    VERIFY_PARAM_NOT_NULL(p_db_discovery);
+    VERIFY_PARAM_NOT_NULL(p_peer_addr);
+    VERIFY_MODULE_INITIALIZED();
+
+    if (m_num_of_handlers_reg <= DB_INTERNAL_SRV)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if (p_db_discovery->discovery_in_progress)
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    p_db_discovery->conn_handle = conn_handle;
+    p_db_discovery->peer_addr   = *p_peer_addr;
+    p_db_discovery->cache_store = false;
+    p_db_discovery->cache_wait  = false;
+    m_pending_usr_evt_index     = 0;
+
+    if (cache_load(p_db_discovery))
+    {
+        NRF_LOG_INFO("Services of Connection handle %d taken from the cache\r\n", conn_handle);
+
+        if ((p_db_discovery->sc_cccd_handle == BLE_GATT_HANDLE_INVALID) ||
+            (sc_indication_enable(p_db_discovery) != NRF_SUCCESS))
+        {
+            // A peer without Service Changed is taken to never change its table.
+            pending_user_evts_send();
+            return NRF_SUCCESS;
+        }
+
+        // The events wait for the CCCD write: a peer that changed its table rejects it, or
+        // indicates Service Changed before the answer.
+        p_db_discovery->cache_wait            = true;
+        p_db_discovery->discovery_in_progress = true;
+        return NRF_SUCCESS;
+    }
+
+    p_db_discovery->cache_store = true;
+#else
+    UNUSED_PARAMETER(p_peer_addr);
+#endif
+
+    return ble_db_discovery_start(p_db_discovery, conn_handle);
+}
+
+
+uint32_t ble_db_discovery_cache_drop(ble_gap_addr_t const * const p_peer_addr)
+{
+#if BLE_DB_DISCOVERY_CACHE_ENABLED
+    fds_record_desc_t desc;
+
+    VERIFY_PARAM_NOT_NULL(p_peer_addr);
+
+    if (!cache_find(p_peer_addr, &desc, NULL, NULL))
+    {
+        return NRF_SUCCESS;
+    }
+    return fds_record_delete(&desc);
+#else
+    UNUSED_PARAMETER(p_peer_addr);
+    return NRF_SUCCESS;
+#endif
+}
+
+
 /**@brief     Function for handling disconnected event.
  *
  * @param[in] p_db_discovery    Pointer to the DB Discovery structure.
@@ -926,6 +1392,10 @@ static void on_disconnected(ble_db_discovery_t * const  p_db_discovery,
     if (p_evt->conn_handle == p_db_discovery->conn_handle)
     {
         p_db_discovery->discovery_in_progress = false;
+#if BLE_DB_DISCOVERY_CACHE_ENABLED
+        p_db_discovery->cache_store           = false;
+        p_db_discovery->cache_wait            = false;
+#endif
     }
 }
 
@@ -951,6 +1421,16 @@ void ble_db_discovery_on_ble_evt(ble_db_discovery_t * const p_db_discovery,
             on_descriptor_discovery_rsp(p_db_discovery, &(p_ble_evt->evt.gattc_evt));
             break;
 
+#if BLE_DB_DISCOVERY_CACHE_ENABLED
+        case BLE_GATTC_EVT_WRITE_RSP:
+            on_sc_cccd_write_rsp(p_db_discovery, &(p_ble_evt->evt.gattc_evt));
+            break;
+
+        case BLE_GATTC_EVT_HVX:
+            on_sc_indication(p_db_discovery, &(p_ble_evt->evt.gattc_evt));
+            break;
+#endif
+
         case BLE_GAP_EVT_DISCONNECTED:
             on_disconnected(p_db_discovery, &(p_ble_evt->evt.gap_evt));
             break;
@@ -36,6 +36,13 @@
  * @note     The application must propagate BLE stack events to this module by calling
  *           ble_db_discovery_on_ble_evt().
  *
+ * @note     With BLE_DB_DISCOVERY_CACHE_ENABLED, @ref ble_db_discovery_cached_start keeps the
+ *           result per peer address in FDS, together with the handles of the peer's Service
+ *           Changed characteristic. A known peer gets the events without discovery. If it has
+ *           a Service Changed characteristic, its indications are enabled first; an indication
+ *           drops the entry and starts the discovery again. The GATT Service is then discovered
+ *           as well, which takes one of the @ref BLE_DB_DISCOVERY_MAX_SRV registrations.
+ *
  */
 
 #ifndef BLE_DB_DISCOVERY_H__
@@ -84,6 +91,11 @@ typedef struct
     bool                discovery_in_progress;               /**< Variable to indicate if there is a service discovery in progress. */
     uint8_t             discoveries_count;                   /**< Number of service discoveries made, both successful and unsuccessful. */
     uint16_t            conn_handle;                         /**< Connection handle on which the discovery is started*/
+    ble_gap_addr_t      peer_addr;                           /**< Peer the result is cached for. This is intended for internal use by the cache.*/
+    bool                cache_store;                         /**< Store the result of the discovery in progress. This is intended for internal use by the cache.*/
+    bool                cache_wait;                          /**< Events held until the Service Changed indications are enabled. This is intended for internal use by the cache.*/
+    uint16_t            sc_handle;                           /**< Value handle of the peer's Service Changed characteristic, or @ref BLE_GATT_HANDLE_INVALID.*/
+    uint16_t            sc_cccd_handle;                      /**< Handle of its CCCD.*/
 } ble_db_discovery_t;
 
 
@@ -171,6 +183,38 @@ uint32_t ble_db_discovery_start(ble_db_discovery_t * const p_db_discovery,
                                 uint16_t                   conn_handle);
 
 
+/**@brief Function for starting the discovery of the GATT database at a peer, from the cache
+ *        when the peer is known.
+ *
+ * @details Without BLE_DB_DISCOVERY_CACHE_ENABLED, the same as @ref ble_db_discovery_start.
+ *          Otherwise, for a peer in the cache, the events of the registered services are sent
+ *          without discovery: at once, or when the peer has acknowledged the enabling of its
+ *          Service Changed indications. For other peers the discovery is run and its result
+ *          stored.
+ *
+ * @param[out] p_db_discovery    Pointer to the DB Discovery structure.
+ * @param[in]  conn_handle       The handle of the connection.
+ * @param[in]  p_peer_addr       Address of the peer, as in @ref BLE_GAP_EVT_CONNECTED.
+ *
+ * @return See @ref ble_db_discovery_start. A CCCD write the SoftDevice refuses sends the
+ *         cached events at once.
+ */
+uint32_t ble_db_discovery_cached_start(ble_db_discovery_t * const   p_db_discovery,
+                                       uint16_t                     conn_handle,
+                                       ble_gap_addr_t const * const p_peer_addr);
+
+
+/**@brief Function for dropping the cache entry of a peer, for example when the cached handles
+ *        turned out to be wrong.
+ *
+ * @param[in]  p_peer_addr       Address of the peer.
+ *
+ * @retval    NRF_SUCCESS               The entry is being deleted, or there was none.
+ * @return                              Otherwise the error of @ref fds_record_delete.
+ */
+uint32_t ble_db_discovery_cache_drop(ble_gap_addr_t const * const p_peer_addr);
+
+
 /**@brief Function for handling the Application's BLE Stack events.
  *
  * @param[in,out] p_db_discovery Pointer to the DB Discovery structure.
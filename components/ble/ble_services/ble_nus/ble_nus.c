@@ -22,6 +22,38 @@
 
 #define NUS_BASE_UUID                  {{0x9E, 0xCA, 0xDC, 0x24, 0x0E, 0xE5, 0xA9, 0xE0, 0x93, 0xF3, 0xA3, 0xB5, 0x00, 0x00, 0x40, 0x6E}} /**< Used vendor specific UUID. */
 
+/**@brief Function for finding the state of a connection.
+ *
+ * @param[in] p_nus        Nordic UART Service structure.
+ * @param[in] conn_handle  Connection, or BLE_CONN_HANDLE_INVALID for an unused entry.
+ *
+ * @return The entry, or NULL if there is none.
+ */
+static ble_nus_link_t * link_find(ble_nus_t const * p_nus, uint16_t conn_handle)
+{
+    for (uint32_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        if (p_nus->links[i].conn_handle == conn_handle)
+        {
+            return (ble_nus_link_t *)&p_nus->links[i];
+        }
+    }
+    return NULL;
+}
+
+
+/**@brief Function for making a link the one in conn_handle and is_notification_enabled.
+ *
+ * @param[in] p_nus   Nordic UART Service structure.
+ * @param[in] p_link  Link, or NULL for none.
+ */
+static void link_current_set(ble_nus_t * p_nus, ble_nus_link_t const * p_link)
+{
+    p_nus->conn_handle             = (p_link != NULL) ? p_link->conn_handle : BLE_CONN_HANDLE_INVALID;
+    p_nus->is_notification_enabled = (p_link != NULL) && p_link->is_notification_enabled;
+}
+
+
 /**@brief Function for handling the @ref BLE_GAP_EVT_CONNECTED event from the S110 SoftDevice.
  *
  * @param[in] p_nus     Nordic UART Service structure.
@@ -29,7 +61,15 @@
  */
 static void on_connect(ble_nus_t * p_nus, ble_evt_t * p_ble_evt)
 {
-    p_nus->conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+    ble_nus_link_t * p_link = link_find(p_nus, BLE_CONN_HANDLE_INVALID);
+
+    if (p_link != NULL)
+    {
+        p_link->conn_handle             = p_ble_evt->evt.gap_evt.conn_handle;
+        p_link->is_notification_enabled = false;
+        p_link->data_len                = BLE_NUS_DEFAULT_DATA_LEN;
+    }
+    link_current_set(p_nus, p_link);
 }
 
 
@@ -40,8 +80,27 @@ static void on_connect(ble_nus_t * p_nus, ble_evt_t * p_ble_evt)
  */
 static void on_disconnect(ble_nus_t * p_nus, ble_evt_t * p_ble_evt)
 {
-    UNUSED_PARAMETER(p_ble_evt);
-    p_nus->conn_handle = BLE_CONN_HANDLE_INVALID;
+    uint16_t         conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+    ble_nus_link_t * p_link      = link_find(p_nus, conn_handle);
+
+    if (p_link != NULL)
+    {
+        p_link->conn_handle             = BLE_CONN_HANDLE_INVALID;
+        p_link->is_notification_enabled = false;
+    }
+    if (p_nus->conn_handle == conn_handle)
+    {
+        // Any peer that is still connected.
+        link_current_set(p_nus, NULL);
+        for (uint32_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+        {
+            if (p_nus->links[i].conn_handle != BLE_CONN_HANDLE_INVALID)
+            {
+                link_current_set(p_nus, &p_nus->links[i]);
+                break;
+            }
+        }
+    }
 }
 
 
@@ -53,6 +112,12 @@ static void on_disconnect(ble_nus_t * p_nus, ble_evt_t * p_ble_evt)
 static void on_write(ble_nus_t * p_nus, ble_evt_t * p_ble_evt)
 {
     ble_gatts_evt_write_t * p_evt_write = &p_ble_evt->evt.gatts_evt.params.write;
+    ble_nus_link_t        * p_link      = link_find(p_nus, p_ble_evt->evt.gatts_evt.conn_handle);
+
+    if (p_link == NULL)
+    {
+        return;
+    }
 
     if (
         (p_evt_write->handle == p_nus->rx_handles.cccd_handle)
@@ -62,12 +127,13 @@ static void on_write(ble_nus_t * p_nus, ble_evt_t * p_ble_evt)
     {
         if (ble_srv_is_notification_enabled(p_evt_write->data))
         {
-            p_nus->is_notification_enabled = true;
+            p_link->is_notification_enabled = true;
         }
         else
         {
-            p_nus->is_notification_enabled = false;
+            p_link->is_notification_enabled = false;
         }
+        link_current_set(p_nus, p_link);
     }
     else if (
              (p_evt_write->handle == p_nus->tx_handles.value_handle)
@@ -75,6 +141,7 @@ static void on_write(ble_nus_t * p_nus, ble_evt_t * p_ble_evt)
              (p_nus->data_handler != NULL)
             )
     {
+        link_current_set(p_nus, p_link);
         p_nus->data_handler(p_nus, p_evt_write->data, p_evt_write->len);
     }
     else
@@ -84,6 +151,44 @@ static void on_write(ble_nus_t * p_nus, ble_evt_t * p_ble_evt)
 }
 
 
+/**@brief Function for handling the @ref BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST event: Write
+ *        Requests of the TX characteristic when it takes long writes.
+ *
+ * @details Prepared and executed writes are left to nrf_ble_qwr.
+ *
+ * @param[in] p_nus     Nordic UART Service structure.
+ * @param[in] p_ble_evt Pointer to the event received from BLE stack.
+ */
+static void on_rw_authorize_request(ble_nus_t * p_nus, ble_evt_t * p_ble_evt)
+{
+    uint16_t                                     conn_handle = p_ble_evt->evt.gatts_evt.conn_handle;
+    ble_gatts_evt_rw_authorize_request_t const * p_req       = &p_ble_evt->evt.gatts_evt.params.authorize_request;
+    ble_gatts_evt_write_t const                * p_write     = &p_req->request.write;
+    ble_gatts_rw_authorize_reply_params_t        auth_reply;
+
+    if ((p_req->type != BLE_GATTS_AUTHORIZE_TYPE_WRITE) ||
+        (p_write->op != BLE_GATTS_OP_WRITE_REQ) ||
+        (p_write->handle != p_nus->tx_handles.value_handle))
+    {
+        return;
+    }
+
+    memset(&auth_reply, 0, sizeof(auth_reply));
+
+    auth_reply.type                     = BLE_GATTS_AUTHORIZE_TYPE_WRITE;
+    auth_reply.params.write.gatt_status = BLE_GATT_STATUS_SUCCESS;
+    auth_reply.params.write.update      = 1;
+    auth_reply.params.write.offset      = p_write->offset;
+    auth_reply.params.write.len         = p_write->len;
+    auth_reply.params.write.p_data      = p_write->data;
+
+    if (sd_ble_gatts_rw_authorize_reply(conn_handle, &auth_reply) == NRF_SUCCESS)
+    {
+        ble_nus_data_put(p_nus, conn_handle, (uint8_t *)p_write->data, p_write->len);
+    }
+}
+
+
 /**@brief Function for adding RX characteristic.
  *
  * @param[in] p_nus       Nordic UART Service structure.
@@ -179,7 +284,7 @@ static uint32_t tx_char_add(ble_nus_t * p_nus, const ble_nus_init_t * p_nus_init
 
     attr_md.vloc    = BLE_GATTS_VLOC_STACK;
     attr_md.rd_auth = 0;
-    attr_md.wr_auth = 0;
+    attr_md.wr_auth = p_nus_init->long_write ? 1 : 0;
     attr_md.vlen    = 1;
 
     memset(&attr_char_value, 0, sizeof(attr_char_value));
@@ -218,6 +323,10 @@ void ble_nus_on_ble_evt(ble_nus_t * p_nus, ble_evt_t * p_ble_evt)
             on_write(p_nus, p_ble_evt);
             break;
 
+        case BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST:
+            on_rw_authorize_request(p_nus, p_ble_evt);
+            break;
+
         default:
             // No implementation needed.
             break;
@@ -238,6 +347,12 @@ uint32_t ble_nus_init(ble_nus_t * p_nus, const ble_nus_init_t * p_nus_init)
     p_nus->conn_handle             = BLE_CONN_HANDLE_INVALID;
     p_nus->data_handler            = p_nus_init->data_handler;
     p_nus->is_notification_enabled = false;
+    for (uint32_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        p_nus->links[i].conn_handle             = BLE_CONN_HANDLE_INVALID;
+        p_nus->links[i].is_notification_enabled = false;
+        p_nus->links[i].data_len                = BLE_NUS_DEFAULT_DATA_LEN;
+    }
 
     /**@snippet [Adding proprietary Service to S110 SoftDevice] */
     // Add a custom base UUID.
@@ -267,17 +382,96 @@ uint32_t ble_nus_init(ble_nus_t * p_nus, const ble_nus_init_t * p_nus_init)
 
 
 uint32_t ble_nus_string_send(ble_nus_t * p_nus, uint8_t * p_string, uint16_t length)
+{
+    VERIFY_PARAM_NOT_NULL(p_nus);
+
+    return ble_nus_string_send_to(p_nus, p_nus->conn_handle, p_string, length);
+}
+
+
+bool ble_nus_is_notification_enabled(ble_nus_t const * p_nus, uint16_t conn_handle)
+{
+    ble_nus_link_t const * p_link;
+
+    if ((p_nus == NULL) || (conn_handle == BLE_CONN_HANDLE_INVALID))
+    {
+        return false;
+    }
+    p_link = link_find(p_nus, conn_handle);
+
+    return (p_link != NULL) && p_link->is_notification_enabled;
+}
+
+
+void ble_nus_data_put(ble_nus_t * p_nus, uint16_t conn_handle, uint8_t * p_data, uint16_t length)
+{
+    ble_nus_link_t const * p_link;
+
+    if ((p_nus == NULL) || (p_nus->data_handler == NULL) || (conn_handle == BLE_CONN_HANDLE_INVALID))
+    {
+        return;
+    }
+    p_link = link_find(p_nus, conn_handle);
+    if (p_link == NULL)
+    {
+        return;
+    }
+
+    link_current_set(p_nus, p_link);
+    while (length != 0)
+    {
+        uint16_t piece = MIN(length, BLE_NUS_MAX_DATA_LEN);
+
+        p_nus->data_handler(p_nus, p_data, piece);
+        p_data += piece;
+        length -= piece;
+    }
+}
+
+
+uint32_t ble_nus_att_mtu_set(ble_nus_t * p_nus, uint16_t conn_handle, uint16_t att_mtu)
+{
+    ble_nus_link_t * p_link;
+
+    VERIFY_PARAM_NOT_NULL(p_nus);
+
+    p_link = (conn_handle != BLE_CONN_HANDLE_INVALID) ? link_find(p_nus, conn_handle) : NULL;
+    if (p_link == NULL)
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+    p_link->data_len = MAX(MIN(att_mtu - 3, BLE_NUS_MAX_DATA_LEN), BLE_NUS_DEFAULT_DATA_LEN);
+
+    return NRF_SUCCESS;
+}
+
+
+uint16_t ble_nus_data_len_get(ble_nus_t const * p_nus, uint16_t conn_handle)
+{
+    ble_nus_link_t const * p_link;
+
+    if ((p_nus == NULL) || (conn_handle == BLE_CONN_HANDLE_INVALID))
+    {
+        return BLE_NUS_DEFAULT_DATA_LEN;
+    }
+    p_link = link_find(p_nus, conn_handle);
+
+    return (p_link != NULL) ? p_link->data_len : BLE_NUS_DEFAULT_DATA_LEN;
+}
+
+
+uint32_t ble_nus_string_send_to(ble_nus_t * p_nus, uint16_t conn_handle, uint8_t * p_string, uint16_t length)
 {
     ble_gatts_hvx_params_t hvx_params;
 
     VERIFY_PARAM_NOT_NULL(p_nus);
 
-    if ((p_nus->conn_handle == BLE_CONN_HANDLE_INVALID) || (!p_nus->is_notification_enabled))
+    if (!ble_nus_is_notification_enabled(p_nus, conn_handle))
     {
         return NRF_ERROR_INVALID_STATE;
     }
 
-    if (length > BLE_NUS_MAX_DATA_LEN)
+    if (length > ble_nus_data_len_get(p_nus, conn_handle))
     {
         return NRF_ERROR_INVALID_PARAM;
     }
@@ -289,7 +483,7 @@ uint32_t ble_nus_string_send(ble_nus_t * p_nus, uint8_t * p_string, uint16_t len
     hvx_params.p_len  = &length;
     hvx_params.type   = BLE_GATT_HVX_NOTIFICATION;
 
-    return sd_ble_gatts_hvx(p_nus->conn_handle, &hvx_params);
+    return sd_ble_gatts_hvx(conn_handle, &hvx_params);
 }
 
 #endif // NRF_MODULE_ENABLED(BLE_NUS)
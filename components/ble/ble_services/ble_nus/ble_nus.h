@@ -34,6 +34,7 @@
 
 #include "ble.h"
 #include "ble_srv_common.h"
+#include "sdk_config.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -42,7 +43,16 @@ extern "C" {
 #endif
 
 #define BLE_UUID_NUS_SERVICE 0x0001                      /**< The UUID of the Nordic UART Service. */
+#if NRF_BLE_GATT_ENABLED
+#define BLE_NUS_MAX_DATA_LEN (NRF_BLE_GATT_MAX_MTU_SIZE - 3) /**< Maximum length of data (in bytes) that can be transmitted to the peer by the Nordic UART service module, with the largest ATT MTU negotiated. */
+#else
 #define BLE_NUS_MAX_DATA_LEN (GATT_MTU_SIZE_DEFAULT - 3) /**< Maximum length of data (in bytes) that can be transmitted to the peer by the Nordic UART service module. */
+#endif
+#define BLE_NUS_DEFAULT_DATA_LEN (GATT_MTU_SIZE_DEFAULT - 3) /**< Length of data a peer takes until it has exchanged a larger ATT MTU. */
+
+#ifndef BLE_NUS_LINK_COUNT
+#define BLE_NUS_LINK_COUNT 1                             /**< Number of peers the service keeps the notification state of. */
+#endif
 
 /* Forward declaration of the ble_nus_t type. */
 typedef struct ble_nus_s ble_nus_t;
@@ -59,11 +69,22 @@ typedef void (*ble_nus_data_handler_t) (ble_nus_t * p_nus, uint8_t * p_data, uin
 typedef struct
 {
     ble_nus_data_handler_t data_handler; /**< Event handler to be called for handling received data. */
+    bool                   long_write;   /**< Whether Write Requests of the TX characteristic need authorization, so nrf_ble_qwr can take long writes of it. */
 } ble_nus_init_t;
 
+/**@brief State of one connection to the service. */
+typedef struct
+{
+    uint16_t conn_handle;             /**< Handle of the connection. BLE_CONN_HANDLE_INVALID for an unused entry. */
+    bool     is_notification_enabled; /**< Whether this peer has enabled notification of the RX characteristic. */
+    uint16_t data_len;                /**< Longest notification to this peer: its ATT MTU less 3. */
+} ble_nus_link_t;
+
 /**@brief Nordic UART Service structure.
  *
- * @details This structure contains status information related to the service.
+ * @details This structure contains status information related to the service. With several
+ *          links, conn_handle and is_notification_enabled are those of the link of the last
+ *          connection or write, so the data handler can tell which peer wrote.
  */
 struct ble_nus_s
 {
@@ -74,6 +95,7 @@ struct ble_nus_s
     uint16_t                 conn_handle;             /**< Handle of the current connection (as provided by the SoftDevice). BLE_CONN_HANDLE_INVALID if not in a connection. */
     bool                     is_notification_enabled; /**< Variable to indicate if the peer has enabled notification of the RX characteristic.*/
     ble_nus_data_handler_t   data_handler;            /**< Event handler to be called for handling received data. */
+    ble_nus_link_t           links[BLE_NUS_LINK_COUNT]; /**< State of each connection. */
 };
 
 /**@brief Function for initializing the Nordic UART Service.
@@ -113,6 +135,59 @@ void ble_nus_on_ble_evt(ble_nus_t * p_nus, ble_evt_t * p_ble_evt);
  */
 uint32_t ble_nus_string_send(ble_nus_t * p_nus, uint8_t * p_string, uint16_t length);
 
+/**@brief Function for sending a string to one of the peers.
+ *
+ * @param[in] p_nus        Pointer to the Nordic UART Service structure.
+ * @param[in] conn_handle  Connection of the peer.
+ * @param[in] p_string     String to be sent.
+ * @param[in] length       Length of the string.
+ *
+ * @retval NRF_SUCCESS             If the string was sent successfully.
+ * @retval NRF_ERROR_INVALID_STATE If the peer is not connected or has not enabled notifications.
+ * @return Otherwise, an error code of sd_ble_gatts_hvx().
+ */
+uint32_t ble_nus_string_send_to(ble_nus_t * p_nus, uint16_t conn_handle, uint8_t * p_string, uint16_t length);
+
+/**@brief Function for handing data the peer wrote other than in a BLE_GATTS_EVT_WRITE, such
+ *        as a long write, to the data handler.
+ *
+ * @details The data handler gets it in pieces of up to @ref BLE_NUS_MAX_DATA_LEN bytes, as if
+ *          they had been written one after the other.
+ *
+ * @param[in] p_nus        Pointer to the Nordic UART Service structure.
+ * @param[in] conn_handle  Connection of the peer.
+ * @param[in] p_data       Data.
+ * @param[in] length       Length of the data.
+ */
+void ble_nus_data_put(ble_nus_t * p_nus, uint16_t conn_handle, uint8_t * p_data, uint16_t length);
+
+/**@brief Function for checking whether a peer has enabled notifications.
+ *
+ * @param[in] p_nus        Pointer to the Nordic UART Service structure.
+ * @param[in] conn_handle  Connection of the peer.
+ */
+bool ble_nus_is_notification_enabled(ble_nus_t const * p_nus, uint16_t conn_handle);
+
+/**@brief Function for setting the ATT MTU of a peer, after an exchange of it.
+ *
+ * @param[in] p_nus        Pointer to the Nordic UART Service structure.
+ * @param[in] conn_handle  Connection of the peer.
+ * @param[in] att_mtu      Effective ATT MTU.
+ *
+ * @retval NRF_SUCCESS        If the notifications to the peer now take up to att_mtu - 3 bytes.
+ * @retval NRF_ERROR_NOT_FOUND If the peer is not connected.
+ */
+uint32_t ble_nus_att_mtu_set(ble_nus_t * p_nus, uint16_t conn_handle, uint16_t att_mtu);
+
+/**@brief Function for getting the longest notification a peer takes.
+ *
+ * @param[in] p_nus        Pointer to the Nordic UART Service structure.
+ * @param[in] conn_handle  Connection of the peer.
+ *
+ * @return Length in bytes, @ref BLE_NUS_DEFAULT_DATA_LEN for an unknown peer.
+ */
+uint16_t ble_nus_data_len_get(ble_nus_t const * p_nus, uint16_t conn_handle);
+
 
 #ifdef __cplusplus
 }
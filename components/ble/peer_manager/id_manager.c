@@ -29,6 +29,20 @@
 #define IM_ADDR_CLEARTEXT_LENGTH        (3)
 #define IM_ADDR_CIPHERTEXT_LENGTH       (3)
 
+#ifndef PM_ID_CACHE_PEERS
+#define PM_ID_CACHE_PEERS               (0)
+#endif
+
+#if (PM_ID_CACHE_PEERS != 0)
+#if ((PM_ID_CACHE_PEERS & (PM_ID_CACHE_PEERS - 1)) != 0) || (PM_ID_CACHE_PEERS > 64)
+#error "PM_ID_CACHE_PEERS must be a power of two, no more than 64."
+#endif
+// Two addresses per peer, at most half of the slots used.
+#define IM_CACHE_SLOTS                  (4 * PM_ID_CACHE_PEERS)
+#define IM_CACHE_SLOT_EMPTY             (0xFF)
+#define IM_CACHE_RESOLVE_BATCH          (8)
+#endif
+
 // The number of registered event handlers.
 #define IM_EVENT_HANDLERS_CNT           (sizeof(m_evt_handlers) / sizeof(m_evt_handlers[0]))
 
@@ -64,6 +78,31 @@ static pm_peer_id_t                     m_wlisted_peers[BLE_GAP_WHITELIST_ADDR_M
     static ble_gap_addr_t               m_current_id_addr;
 #endif
 
+#if (PM_ID_CACHE_PEERS != 0)
+typedef struct
+{
+    pm_peer_id_t   peer_id;
+    ble_gap_addr_t id_addr;
+    ble_gap_addr_t rpa;         /**< The resolvable address the peer last connected with. */
+    bool           has_rpa;
+    bool           has_irk;
+    soc_ecb_key_t  ecb_key;     /**< The IRK, byte reversed for the ECB. */
+} im_cache_entry_t;
+
+/**@brief The bonded peers, so a connection is matched without a walk of the bonding data in flash.
+ */
+typedef struct
+{
+    im_cache_entry_t entries[PM_ID_CACHE_PEERS];
+    uint8_t          slots[IM_CACHE_SLOTS];    /**< Index into entries, by address hash. */
+    uint8_t          count;
+    bool             built;
+    bool             complete;                 /**< Every bonded peer is in entries. */
+} im_cache_t;
+
+static im_cache_t                       m_cache;
+#endif
+
 
 static void internal_state_reset()
 {
@@ -73,6 +112,10 @@ static void internal_state_reset()
     {
         m_connections[i].conn_handle = BLE_CONN_HANDLE_INVALID;
     }
+
+#if (PM_ID_CACHE_PEERS != 0)
+    m_cache.built = false;
+#endif
 }
 
 
@@ -222,70 +265,384 @@ bool addr_compare(ble_gap_addr_t const * p_addr1, ble_gap_addr_t const * p_addr2
 }
 
 
-void im_ble_evt_handler(ble_evt_t * ble_evt)
+#if (PM_ID_CACHE_PEERS != 0)
+
+/**@brief Function for hashing an address into the slots of the cache.
+ */
+static uint32_t cache_slot_first(ble_gap_addr_t const * p_addr)
 {
-    ble_gap_evt_t gap_evt;
-    pm_peer_id_t  bonded_matching_peer_id;
+    uint32_t h = 2166136261UL ^ p_addr->addr_type;
 
-    NRF_PM_DEBUG_CHECK(m_module_initialized);
+    for (uint32_t i = 0; i < BLE_GAP_ADDR_LEN; i++)
+    {
+        h ^= p_addr->addr[i];
+        h *= 16777619UL;
+    }
+    return h & (IM_CACHE_SLOTS - 1);
+}
 
-    if (ble_evt->header.evt_id != BLE_GAP_EVT_CONNECTED)
+
+static void cache_slot_insert(ble_gap_addr_t const * p_addr, uint8_t index)
+{
+    uint32_t slot = cache_slot_first(p_addr);
+
+    // There are more slots than addresses, so there is always an empty one.
+    while (m_cache.slots[slot] != IM_CACHE_SLOT_EMPTY)
     {
-        // Nothing to do.
+        slot = (slot + 1) & (IM_CACHE_SLOTS - 1);
+    }
+    m_cache.slots[slot] = index;
+}
+
+
+/**@brief Function for indexing the identity address and the last resolvable address of each peer.
+ *
+ * @details Called whenever an entry changes. That is on bonding and on an address that is
+ *          resolved anew, both of which cost far more than this.
+ */
+static void cache_slots_rebuild(void)
+{
+    memset(m_cache.slots, IM_CACHE_SLOT_EMPTY, sizeof(m_cache.slots));
+
+    for (uint8_t i = 0; i < m_cache.count; i++)
+    {
+        cache_slot_insert(&m_cache.entries[i].id_addr, i);
+        if (m_cache.entries[i].has_rpa)
+        {
+            cache_slot_insert(&m_cache.entries[i].rpa, i);
+        }
+    }
+}
+
+
+static void cache_entry_set(im_cache_entry_t * p_entry,
+                            pm_peer_id_t peer_id,
+                            pm_peer_data_bonding_t const * p_bonding_data)
+{
+    ble_gap_irk_t const * p_irk = &p_bonding_data->peer_ble_id.id_info;
+
+    p_entry->peer_id = peer_id;
+    p_entry->id_addr = p_bonding_data->peer_ble_id.id_addr_info;
+    p_entry->has_rpa = false;
+    p_entry->has_irk = is_valid_irk(p_irk);
+
+    // The ECB takes the key most significant byte first.
+    for (uint32_t i = 0; i < SOC_ECB_KEY_LENGTH; i++)
+    {
+        p_entry->ecb_key[i] = p_irk->irk[SOC_ECB_KEY_LENGTH - 1 - i];
+    }
+}
+
+
+/**@brief Function for filling the cache from flash, the first time it is needed.
+ */
+static void cache_build(void)
+{
+    pm_peer_id_t         peer_id;
+    pm_peer_data_flash_t peer_data;
+
+    m_cache.count    = 0;
+    m_cache.complete = true;
+
+    pds_peer_data_iterate_prepare();
+
+    while (pds_peer_data_iterate(PM_PEER_DATA_ID_BONDING, &peer_id, &peer_data))
+    {
+        if (m_cache.count == PM_ID_CACHE_PEERS)
+        {
+            m_cache.complete = false;
+            break;
+        }
+        cache_entry_set(&m_cache.entries[m_cache.count++], peer_id, peer_data.p_bonding_data);
+    }
+
+    cache_slots_rebuild();
+    m_cache.built = true;
+}
+
+
+static im_cache_entry_t * cache_entry_get(pm_peer_id_t peer_id)
+{
+    for (uint8_t i = 0; i < m_cache.count; i++)
+    {
+        if (m_cache.entries[i].peer_id == peer_id)
+        {
+            return &m_cache.entries[i];
+        }
+    }
+    return NULL;
+}
+
+
+/**@brief Function for taking new bonding data of a peer into the cache.
+ */
+static void cache_update(pm_peer_id_t peer_id)
+{
+    im_cache_entry_t *   p_entry = cache_entry_get(peer_id);
+    pm_peer_data_flash_t peer_data;
+
+    if (pdb_peer_data_ptr_get(peer_id, PM_PEER_DATA_ID_BONDING, &peer_data) != NRF_SUCCESS)
+    {
+        m_cache.built = false;
         return;
     }
 
-    gap_evt                 = ble_evt->evt.gap_evt;
-    bonded_matching_peer_id = PM_PEER_ID_INVALID;
+    if (p_entry == NULL)
+    {
+        if (m_cache.count == PM_ID_CACHE_PEERS)
+        {
+            m_cache.complete = false;
+            return;
+        }
+        p_entry = &m_cache.entries[m_cache.count++];
+    }
 
-    if (   gap_evt.params.connected.peer_addr.addr_type
-        != BLE_GAP_ADDR_TYPE_RANDOM_PRIVATE_NON_RESOLVABLE)
+    cache_entry_set(p_entry, peer_id, peer_data.p_bonding_data);
+    cache_slots_rebuild();
+}
+
+
+static void cache_remove(pm_peer_id_t peer_id)
+{
+    im_cache_entry_t * p_entry = cache_entry_get(peer_id);
+
+    if (p_entry != NULL)
     {
-        /* Search the database for bonding data matching the one that triggered the event.
-         * Public and static addresses can be matched on address alone, while resolvable
-         * random addresses can be resolved agains known IRKs. Non-resolvable random addresses
-         * are never matching because they are not longterm form of identification.
-         */
+        *p_entry = m_cache.entries[--m_cache.count];
+        cache_slots_rebuild();
+    }
+}
+
 
-        pm_peer_id_t         peer_id;
-        pm_peer_data_flash_t peer_data;
+/**@brief Function for keeping the cache in step with the bonding data in flash.
+ */
+static void cache_pdb_evt_handler(pdb_evt_t const * p_event)
+{
+    if (!m_cache.built)
+    {
+        // Built from flash when it is next needed.
+        return;
+    }
 
-        pds_peer_data_iterate_prepare();
+    switch (p_event->evt_id)
+    {
+        case PDB_EVT_WRITE_BUF_STORED:
+        case PDB_EVT_RAW_STORED:
+            if (p_event->data_id == PM_PEER_DATA_ID_BONDING)
+            {
+                cache_update(p_event->peer_id);
+            }
+            break;
 
-        switch (gap_evt.params.connected.peer_addr.addr_type)
+        case PDB_EVT_CLEARED:
+            if (p_event->data_id == PM_PEER_DATA_ID_BONDING)
+            {
+                cache_remove(p_event->peer_id);
+            }
+            break;
+
+        case PDB_EVT_PEER_FREED:
+            cache_remove(p_event->peer_id);
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+/**@brief Function for resolving an address against the IRKs of the cache, a batch of ECB blocks
+ *        at a time.
+ *
+ * @return The entry of the peer, with the address remembered, or NULL.
+ */
+static im_cache_entry_t * cache_resolve(ble_gap_addr_t const * p_addr)
+{
+    nrf_ecb_hal_data_block_t blocks[IM_CACHE_RESOLVE_BATCH];
+    soc_ecb_ciphertext_t     ciphertext[IM_CACHE_RESOLVE_BATCH];
+    uint8_t                  index[IM_CACHE_RESOLVE_BATCH];
+    soc_ecb_cleartext_t      cleartext;
+    uint8_t                  i = 0;
+
+    // prand, the upper half of the address, padded with zeros; see ah().
+    memset(cleartext, 0, sizeof(cleartext));
+    for (uint32_t j = 0; j < IM_ADDR_CLEARTEXT_LENGTH; j++)
+    {
+        cleartext[SOC_ECB_KEY_LENGTH - 1 - j] = p_addr->addr[IM_ADDR_CIPHERTEXT_LENGTH + j];
+    }
+
+    while (i < m_cache.count)
+    {
+        uint8_t n = 0;
+
+        for (; (i < m_cache.count) && (n < IM_CACHE_RESOLVE_BATCH); i++)
+        {
+            if (m_cache.entries[i].has_irk)
+            {
+                blocks[n].p_key        = &m_cache.entries[i].ecb_key;
+                blocks[n].p_cleartext  = &cleartext;
+                blocks[n].p_ciphertext = &ciphertext[n];
+                index[n++]             = i;
+            }
+        }
+
+        if (n == 0)
+        {
+            break;
+        }
+
+        // Can only return NRF_SUCCESS.
+        (void) sd_ecb_blocks_encrypt(n, blocks);
+
+        for (uint8_t k = 0; k < n; k++)
         {
-            case BLE_GAP_ADDR_TYPE_PUBLIC:
-            case BLE_GAP_ADDR_TYPE_RANDOM_STATIC:
+            uint32_t j;
+
+            for (j = 0; j < IM_ADDR_CIPHERTEXT_LENGTH; j++)
             {
-                while (pds_peer_data_iterate(PM_PEER_DATA_ID_BONDING, &peer_id, &peer_data))
+                if (ciphertext[k][SOC_ECB_KEY_LENGTH - 1 - j] != p_addr->addr[j])
                 {
-                    if (addr_compare(&gap_evt.params.connected.peer_addr,
-                                     &peer_data.p_bonding_data->peer_ble_id.id_addr_info))
-                    {
-                        bonded_matching_peer_id = peer_id;
-                        break;
-                    }
+                    break;
                 }
             }
+
+            if (j == IM_ADDR_CIPHERTEXT_LENGTH)
+            {
+                im_cache_entry_t * p_entry = &m_cache.entries[index[k]];
+
+                p_entry->rpa     = *p_addr;
+                p_entry->has_rpa = true;
+                cache_slots_rebuild();
+                return p_entry;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+
+/**@brief Function for finding a bonded peer by the address it connected with, in RAM.
+ *
+ * @details Identity addresses and the last resolvable address of each peer are looked up in the
+ *          slots. A resolvable address that is new, which happens when the peer rotates it, is
+ *          resolved against the IRKs of the cache.
+ *
+ * @return The peer, or PM_PEER_ID_INVALID if the cache does not hold it.
+ */
+static pm_peer_id_t cache_peer_find(ble_gap_addr_t const * p_addr)
+{
+    im_cache_entry_t * p_entry = NULL;
+    uint32_t           slot;
+
+    if (!m_cache.built)
+    {
+        cache_build();
+    }
+
+    slot = cache_slot_first(p_addr);
+    while (m_cache.slots[slot] != IM_CACHE_SLOT_EMPTY)
+    {
+        im_cache_entry_t * p_candidate = &m_cache.entries[m_cache.slots[slot]];
+
+        if (   addr_compare(p_addr, &p_candidate->id_addr)
+            || (p_candidate->has_rpa && addr_compare(p_addr, &p_candidate->rpa)))
+        {
+            p_entry = p_candidate;
             break;
+        }
+        slot = (slot + 1) & (IM_CACHE_SLOTS - 1);
+    }
+
+    if ((p_entry == NULL) && (p_addr->addr_type == BLE_GAP_ADDR_TYPE_RANDOM_PRIVATE_RESOLVABLE))
+    {
+        p_entry = cache_resolve(p_addr);
+    }
 
-            case BLE_GAP_ADDR_TYPE_RANDOM_PRIVATE_RESOLVABLE:
+    return (p_entry != NULL) ? p_entry->peer_id : PM_PEER_ID_INVALID;
+}
+
+#endif // PM_ID_CACHE_PEERS
+
+
+/**@brief Function for finding a bonded peer by the address it connected with, in flash.
+ *
+ * @details Public and static addresses can be matched on address alone, while resolvable
+ *          random addresses can be resolved agains known IRKs.
+ */
+static pm_peer_id_t flash_peer_find(ble_gap_addr_t const * p_addr)
+{
+    pm_peer_id_t         peer_id;
+    pm_peer_data_flash_t peer_data;
+
+    pds_peer_data_iterate_prepare();
+
+    switch (p_addr->addr_type)
+    {
+        case BLE_GAP_ADDR_TYPE_PUBLIC:
+        case BLE_GAP_ADDR_TYPE_RANDOM_STATIC:
+        {
+            while (pds_peer_data_iterate(PM_PEER_DATA_ID_BONDING, &peer_id, &peer_data))
             {
-                while (pds_peer_data_iterate(PM_PEER_DATA_ID_BONDING, &peer_id, &peer_data))
+                if (addr_compare(p_addr, &peer_data.p_bonding_data->peer_ble_id.id_addr_info))
                 {
-                    if (im_address_resolve(&gap_evt.params.connected.peer_addr,
-                                           &peer_data.p_bonding_data->peer_ble_id.id_info))
-                    {
-                        bonded_matching_peer_id = peer_id;
-                        break;
-                    }
+                    return peer_id;
                 }
             }
+        }
+        break;
+
+        case BLE_GAP_ADDR_TYPE_RANDOM_PRIVATE_RESOLVABLE:
+        {
+            while (pds_peer_data_iterate(PM_PEER_DATA_ID_BONDING, &peer_id, &peer_data))
+            {
+                if (im_address_resolve(p_addr, &peer_data.p_bonding_data->peer_ble_id.id_info))
+                {
+                    return peer_id;
+                }
+            }
+        }
+        break;
+
+        default:
+            NRF_PM_DEBUG_CHECK(false);
             break;
+    }
+
+    return PM_PEER_ID_INVALID;
+}
 
-            default:
-                NRF_PM_DEBUG_CHECK(false);
-                break;
+
+void im_ble_evt_handler(ble_evt_t * ble_evt)
+{
+    ble_gap_evt_t gap_evt;
+    pm_peer_id_t  bonded_matching_peer_id;
+
+    NRF_PM_DEBUG_CHECK(m_module_initialized);
+
+    if (ble_evt->header.evt_id != BLE_GAP_EVT_CONNECTED)
+    {
+        // Nothing to do.
+        return;
+    }
+
+    gap_evt                 = ble_evt->evt.gap_evt;
+    bonded_matching_peer_id = PM_PEER_ID_INVALID;
+
+    if (   gap_evt.params.connected.peer_addr.addr_type
+        != BLE_GAP_ADDR_TYPE_RANDOM_PRIVATE_NON_RESOLVABLE)
+    {
+        /* Search the database for bonding data matching the one that triggered the event.
+         * Non-resolvable random addresses are never matching because they are not longterm
+         * form of identification. Flash is only searched for peers the cache does not hold.
+         */
+#if (PM_ID_CACHE_PEERS != 0)
+        bonded_matching_peer_id = cache_peer_find(&gap_evt.params.connected.peer_addr);
+
+        if ((bonded_matching_peer_id == PM_PEER_ID_INVALID) && !m_cache.complete)
+#endif
+        {
+            bonded_matching_peer_id = flash_peer_find(&gap_evt.params.connected.peer_addr);
         }
     }
 
@@ -351,6 +708,10 @@ void im_pdb_evt_handler(pdb_evt_t const * p_event)
     NRF_PM_DEBUG_CHECK(m_module_initialized);
     NRF_PM_DEBUG_CHECK(p_event != NULL);
 
+#if (PM_ID_CACHE_PEERS != 0)
+    cache_pdb_evt_handler(p_event);
+#endif
+
     if ((p_event->evt_id  != PDB_EVT_WRITE_BUF_STORED) ||
         (p_event->data_id != PM_PEER_DATA_ID_BONDING))
     {
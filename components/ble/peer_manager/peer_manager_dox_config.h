@@ -12,5 +12,15 @@
  */
 #define PEER_MANAGER_ENABLED
 
+/** @brief Bonded peers the Identity Manager keeps in RAM
+ *
+ *  A connecting peer is matched by its address, or resolved against the IRKs of the cache in
+ *  batches of ECB blocks, instead of walking the bonding data in flash. Peers beyond the cache
+ *  are still found in flash. A power of two, 64 at most; 0 to disable.
+ *
+ * @note This is an NRF_CONFIG macro.
+ */
+#define PM_ID_CACHE_PEERS
+
 
 /** @} */
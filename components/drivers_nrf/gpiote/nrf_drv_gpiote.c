@@ -89,6 +89,7 @@ typedef struct
 } gpiote_control_block_t;
 
 static gpiote_control_block_t m_cb;
+static nrf_drv_gpiote_port_hook_t m_port_hook;
 
 __STATIC_INLINE bool pin_in_use(uint32_t pin)
 {
@@ -257,7 +258,8 @@ void nrf_drv_gpiote_uninit(void)
             nrf_drv_gpiote_in_uninit(i);
         }
     }
-    m_cb.state = NRF_DRV_STATE_UNINITIALIZED;
+    m_port_hook = NULL;
+    m_cb.state  = NRF_DRV_STATE_UNINITIALIZED;
     NRF_LOG_INFO("Uninitialized.\r\n");
 }
 
@@ -616,6 +618,14 @@ uint32_t nrf_drv_gpiote_in_event_addr_get(nrf_drv_gpiote_pin_t pin)
 }
 
 
+void nrf_drv_gpiote_port_hook_set(nrf_drv_gpiote_port_hook_t hook)
+{
+    ASSERT(m_cb.state == NRF_DRV_STATE_INITIALIZED);
+
+    m_port_hook = hook;
+}
+
+
 void GPIOTE_IRQHandler(void)
 {
     uint32_t status            = 0;
@@ -734,6 +744,11 @@ void GPIOTE_IRQHandler(void)
                 }
             }
 
+            if ((m_port_hook != NULL) && m_port_hook(input))
+            {
+                ++repeat;
+            }
+
             if (repeat)
             {
                 // When one of the pins in low-accuracy and toggle mode becomes active,
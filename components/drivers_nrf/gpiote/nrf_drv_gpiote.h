@@ -125,6 +125,19 @@ typedef uint32_t nrf_drv_gpiote_pin_t;
  */
 typedef void (*nrf_drv_gpiote_evt_handler_t)(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action);
 
+/**
+ * @brief PORT event hook prototype.
+ *
+ * @details Called on every pass over the pins of a PORT event, after the low-power inputs of the
+ *          driver, with the input state the pass worked on.
+ *
+ * @param p_input State of the GPIO ports, GPIO_COUNT words.
+ *
+ * @retval true  The hook changed the sense of a pin: the ports are read again and the pass repeated.
+ * @retval false Nothing was changed.
+ */
+typedef bool (*nrf_drv_gpiote_port_hook_t)(uint32_t const * p_input);
+
 /**
  * @brief Function for initializing the GPIOTE module.
  *
@@ -315,6 +328,18 @@ bool nrf_drv_gpiote_in_is_set(nrf_drv_gpiote_pin_t pin);
  */
 uint32_t nrf_drv_gpiote_in_event_addr_get(nrf_drv_gpiote_pin_t pin);
 
+/**
+ * @brief Function for setting the PORT event hook.
+ *
+ * @details The hook handles pins that sense without a low-power event slot of the driver. It has
+ *          to keep each of its pins sensing the level the pin is not at, otherwise the DETECT
+ *          signal stays high and no further PORT event comes, for its pins or the driver's.
+ *          Pins of the hook must not be configured through the driver.
+ *
+ * @param[in] hook      Hook, or NULL to remove it.
+ */
+void nrf_drv_gpiote_port_hook_set(nrf_drv_gpiote_port_hook_t hook);
+
 /**
  * @brief Function for forcing a specific state on the pin configured as task.
  *
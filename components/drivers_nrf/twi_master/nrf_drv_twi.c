@@ -550,7 +550,8 @@ static ret_code_t twi_tx_start_transfer(twi_control_block_t * p_cb,
 static ret_code_t twi_rx_start_transfer(twi_control_block_t * p_cb,
                                         NRF_TWI_Type *        p_twi,
                                         uint8_t const *       p_data,
-                                        uint8_t               length)
+                                        uint8_t               length,
+                                        bool                  hold)
 {
     ret_code_t ret_code = NRF_SUCCESS;
 
@@ -572,7 +573,10 @@ static ret_code_t twi_rx_start_transfer(twi_control_block_t * p_cb,
     }
     // In case TWI is suspended resume its operation.
     nrf_twi_task_trigger(p_twi, NRF_TWI_TASK_RESUME);
-    nrf_twi_task_trigger(p_twi, NRF_TWI_TASK_STARTRX);
+    if (!hold)
+    {
+        nrf_twi_task_trigger(p_twi, NRF_TWI_TASK_STARTRX);
+    }
 
     if (p_cb->handler)
     {
@@ -623,8 +627,12 @@ __STATIC_INLINE ret_code_t twi_xfer(twi_control_block_t           * p_cb,
         p_cb->busy = (NRF_DRV_TWI_FLAG_NO_XFER_EVT_HANDLER & flags) ? false : true;
     }
 
-    if (flags & NRF_DRV_TWI_FLAG_HOLD_XFER)
+    // Without EasyDMA the bytes are moved in the interrupt, so only a read with an event handler
+    // can be started externally.
+    if ((flags & NRF_DRV_TWI_FLAG_HOLD_XFER) &&
+        ((p_xfer_desc->type != NRF_DRV_TWI_XFER_RX) || (p_cb->handler == NULL)))
     {
+        p_cb->busy = false;
         err_code = NRF_ERROR_NOT_SUPPORTED;
         NRF_LOG_WARNING("Function: %s, error code: %s.\r\n", (uint32_t)__func__, (uint32_t)ERR_TO_STR(err_code));
         return err_code;
@@ -647,7 +655,8 @@ __STATIC_INLINE ret_code_t twi_xfer(twi_control_block_t           * p_cb,
     {
         p_cb->curr_no_stop = false;
 
-        err_code = twi_rx_start_transfer(p_cb, p_twi, p_xfer_desc->p_primary_buf, p_xfer_desc->primary_length);
+        err_code = twi_rx_start_transfer(p_cb, p_twi, p_xfer_desc->p_primary_buf, p_xfer_desc->primary_length,
+                                         (flags & NRF_DRV_TWI_FLAG_HOLD_XFER) != 0);
     }
     if (p_cb->handler == NULL)
     {
@@ -1042,7 +1051,7 @@ static void irq_handler_twi(NRF_TWI_Type * p_twi, twi_control_block_t * p_cb)
         }
         else
         {
-            (void)twi_rx_start_transfer(p_cb, p_twi, p_cb->p_curr_buf, p_cb->curr_length);
+            (void)twi_rx_start_transfer(p_cb, p_twi, p_cb->p_curr_buf, p_cb->curr_length, false);
         }
     }
     else
@@ -0,0 +1,387 @@
+/* Copyright (c) 2016 Nordic Semiconductor. All Rights Reserved.
+ *
+ * The information contained herein is property of Nordic Semiconductor ASA.
+ * Terms and conditions of usage are described in detail in NORDIC
+ * SEMICONDUCTOR STANDARD SOFTWARE LICENSE AGREEMENT.
+ *
+ * Licensees are granted free, non-transferable use of the information. NO
+ * WARRANTY of ANY KIND is provided. This heading must NOT be removed from
+ * the file.
+ *
+ */
+
+#include "nrf_dfu_decomp.h"
+#include <string.h>
+#include <stdbool.h>
+#include "nrf_dfu_types.h"
+#include "nrf_dfu_flash.h"
+#include "nrf_dfu_settings.h"
+#include "nrf_error.h"
+#include "app_util.h"
+#include "crc32.h"
+#include "nrf_log.h"
+
+#define DECOMP_IN_SIZE          (64)    /**< Received bytes the decoder can hold while flash is busy. */
+#define DECOMP_FLUSH_SIZE       (64)    /**< Decoded bytes collected before they go to the flash stream. */
+#define DECOMP_WINDOW_MASK      (NRF_DFU_DECOMP_WINDOW_SIZE - 1)
+#define DECOMP_COPY_ARGS_SIZE   (6)
+
+typedef enum
+{
+    DECOMP_STATE_HEADER,
+    DECOMP_STATE_TOKEN,
+    DECOMP_STATE_LITERAL,       //!< count literal bytes follow in the input.
+    DECOMP_STATE_REPEAT_ARGS,
+    DECOMP_STATE_REPEAT,        //!< count bytes from src bytes back.
+    DECOMP_STATE_COPY_ARGS,
+    DECOMP_STATE_COPY,          //!< count bytes from bank 0 at src.
+    DECOMP_STATE_ERROR,
+} decomp_state_t;
+
+static struct
+{
+    uint8_t         window[NRF_DFU_DECOMP_WINDOW_SIZE];  //!< Last decoded bytes, the newest before pos.
+    uint8_t         in[DECOMP_IN_SIZE];                  //!< Received bytes not decoded yet.
+    uint8_t         args[NRF_DFU_DECOMP_HEADER_SIZE];
+    uint8_t         args_len;
+    uint8_t         state;
+    bool            running;
+    uint16_t        in_head;
+    uint16_t        in_len;
+    uint16_t        pos;
+    uint16_t        pending;    //!< Decoded bytes before pos that the flash stream has not taken.
+    uint32_t        count;
+    uint32_t        src;
+    uint32_t        out_len;
+    uint32_t        out_size;
+    uint8_t const * p_base;
+    uint32_t        base_size;
+    uint32_t *      p_dest;
+    uint32_t        dest_size;  //!< Bytes free at p_dest.
+    uint32_t        in_crc;
+    uint32_t        in_offset;
+    uint32_t        result;     //!< Error of DECOMP_STATE_ERROR.
+} m_decomp;
+
+
+static void decomp_fail(uint32_t result)
+{
+    NRF_LOG_INFO("Decomp: failed at 0x%08x, out 0x%08x\r\n", m_decomp.in_offset, m_decomp.out_len);
+    m_decomp.state  = DECOMP_STATE_ERROR;
+    m_decomp.result = result;
+}
+
+
+static uint32_t decomp_word(uint8_t const * p_data)
+{
+    return p_data[0] | (p_data[1] << 8) | (p_data[2] << 16) | ((uint32_t)p_data[3] << 24);
+}
+
+
+static void decomp_header(void)
+{
+    uint32_t base_crc;
+
+    if (decomp_word(&m_decomp.args[0]) != NRF_DFU_DECOMP_MAGIC)
+    {
+        decomp_fail(NRF_ERROR_INVALID_DATA);
+        return;
+    }
+    m_decomp.out_size  = decomp_word(&m_decomp.args[4]);
+    base_crc           = decomp_word(&m_decomp.args[8]);
+    m_decomp.base_size = decomp_word(&m_decomp.args[12]);
+    m_decomp.p_base    = NULL;
+
+    // The size comes from the peer: anything past the area would land on the bootloader.
+    if (m_decomp.out_size > m_decomp.dest_size)
+    {
+        NRF_LOG_INFO("Decomp: image does not fit\r\n");
+        decomp_fail(NRF_ERROR_INVALID_DATA);
+        return;
+    }
+
+    if (m_decomp.base_size != 0)
+    {
+        uint32_t base = CODE_REGION_1_START;
+        uint32_t dest = (uint32_t)m_decomp.p_dest;
+
+        // The patch is made against one build, any other bank 0 would decode into garbage.
+        if ((s_dfu_settings.bank_0.bank_code  != NRF_DFU_BANK_VALID_APP) ||
+            (s_dfu_settings.bank_0.image_crc  != base_crc)               ||
+            (s_dfu_settings.bank_0.image_size != m_decomp.base_size))
+        {
+            NRF_LOG_INFO("Decomp: bank 0 is not the base of the patch\r\n");
+            decomp_fail(NRF_ERROR_INVALID_STATE);
+            return;
+        }
+        // Bank 0 is read while the new image is written, so it has to be dual bank. Both ends
+        // are distances from the lower start, which cannot wrap.
+        if ((dest >= base) ? (dest - base < m_decomp.base_size) : (base - dest < m_decomp.dest_size))
+        {
+            NRF_LOG_INFO("Decomp: patch would overwrite its base\r\n");
+            decomp_fail(NRF_ERROR_INVALID_STATE);
+            return;
+        }
+        m_decomp.p_base = (uint8_t const *)base;
+    }
+
+    m_decomp.state = DECOMP_STATE_TOKEN;
+}
+
+
+static void decomp_put(uint8_t data)
+{
+    if (m_decomp.out_len == m_decomp.out_size)
+    {
+        decomp_fail(NRF_ERROR_INVALID_DATA);
+        return;
+    }
+    m_decomp.window[m_decomp.pos] = data;
+    m_decomp.pos = (m_decomp.pos + 1) & DECOMP_WINDOW_MASK;
+    m_decomp.pending++;
+    m_decomp.out_len++;
+}
+
+
+static void decomp_byte(uint8_t data)
+{
+    switch (m_decomp.state)
+    {
+        case DECOMP_STATE_HEADER:
+            m_decomp.args[m_decomp.args_len++] = data;
+            if (m_decomp.args_len == NRF_DFU_DECOMP_HEADER_SIZE)
+            {
+                decomp_header();
+            }
+            break;
+
+        case DECOMP_STATE_TOKEN:
+            m_decomp.args[0]  = data;
+            m_decomp.args_len = 1;
+            if ((data & 0x80) == 0)
+            {
+                m_decomp.count = data + 1;
+                m_decomp.state = DECOMP_STATE_LITERAL;
+            }
+            else
+            {
+                m_decomp.state = ((data & 0x40) == 0) ? DECOMP_STATE_REPEAT_ARGS : DECOMP_STATE_COPY_ARGS;
+            }
+            break;
+
+        case DECOMP_STATE_LITERAL:
+            decomp_put(data);
+            if ((--m_decomp.count == 0) && (m_decomp.state == DECOMP_STATE_LITERAL))
+            {
+                m_decomp.state = DECOMP_STATE_TOKEN;
+            }
+            break;
+
+        case DECOMP_STATE_REPEAT_ARGS:
+            m_decomp.count = ((m_decomp.args[0] >> 2) & 0x0F) + 3;
+            m_decomp.src   = (((m_decomp.args[0] & 0x03) << 8) | data) + 1;
+            if (m_decomp.src > m_decomp.out_len)
+            {
+                decomp_fail(NRF_ERROR_INVALID_DATA);
+                break;
+            }
+            m_decomp.state = DECOMP_STATE_REPEAT;
+            break;
+
+        case DECOMP_STATE_COPY_ARGS:
+            m_decomp.args[m_decomp.args_len++] = data;
+            if (m_decomp.args_len < DECOMP_COPY_ARGS_SIZE)
+            {
+                break;
+            }
+            m_decomp.count = (((m_decomp.args[0] & 0x3F) << 16) | m_decomp.args[1] | (m_decomp.args[2] << 8)) + 1;
+            m_decomp.src   = m_decomp.args[3] | (m_decomp.args[4] << 8) | (m_decomp.args[5] << 16);
+            if ((m_decomp.p_base == NULL) ||
+                (m_decomp.src > m_decomp.base_size) || (m_decomp.count > m_decomp.base_size - m_decomp.src))
+            {
+                decomp_fail(NRF_ERROR_INVALID_DATA);
+                break;
+            }
+            m_decomp.state = DECOMP_STATE_COPY;
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+/**@brief Give the pending decoded bytes to the flash stream.
+ *
+ * @return True if none are left.
+ */
+static bool decomp_flush(void)
+{
+    while (m_decomp.pending != 0)
+    {
+        uint16_t start = (m_decomp.pos - m_decomp.pending) & DECOMP_WINDOW_MASK;
+        uint16_t len   = MIN(m_decomp.pending, NRF_DFU_DECOMP_WINDOW_SIZE - start);
+        fs_ret_t ret   = nrf_dfu_flash_stream_write(&m_decomp.window[start], len);
+
+        if (ret == FS_ERR_QUEUE_FULL)
+        {
+            // Picked up again from decomp_on_ready.
+            return false;
+        }
+        if (ret != FS_SUCCESS)
+        {
+            decomp_fail(NRF_ERROR_INTERNAL);
+            return false;
+        }
+        m_decomp.pending -= len;
+    }
+    return true;
+}
+
+
+/**@brief Decode until the input runs out or the flash stream is full. */
+static void decomp_run(void)
+{
+    // Without SoftDevice the flash stream calls back from inside nrf_dfu_flash_stream_write.
+    if (m_decomp.running)
+    {
+        return;
+    }
+    m_decomp.running = true;
+
+    while (m_decomp.state != DECOMP_STATE_ERROR)
+    {
+        if ((m_decomp.pending >= DECOMP_FLUSH_SIZE) && !decomp_flush())
+        {
+            break;
+        }
+
+        if (m_decomp.state == DECOMP_STATE_REPEAT)
+        {
+            decomp_put(m_decomp.window[(m_decomp.pos - m_decomp.src) & DECOMP_WINDOW_MASK]);
+        }
+        else if (m_decomp.state == DECOMP_STATE_COPY)
+        {
+            decomp_put(m_decomp.p_base[m_decomp.src++]);
+        }
+        else if (m_decomp.in_len != 0)
+        {
+            uint8_t data = m_decomp.in[m_decomp.in_head];
+
+            m_decomp.in_head = (m_decomp.in_head + 1) % DECOMP_IN_SIZE;
+            m_decomp.in_len--;
+            decomp_byte(data);
+            continue;
+        }
+        else
+        {
+            break;
+        }
+
+        if ((--m_decomp.count == 0) && (m_decomp.state != DECOMP_STATE_ERROR))
+        {
+            m_decomp.state = DECOMP_STATE_TOKEN;
+        }
+    }
+
+    m_decomp.running = false;
+}
+
+
+static void decomp_on_ready(void)
+{
+    decomp_run();
+}
+
+
+uint32_t nrf_dfu_decomp_start(uint32_t * p_dest, uint32_t size)
+{
+    fs_ret_t ret;
+
+    if (((((uint32_t)p_dest | size) & 0x03) != 0) || (size > UINT32_MAX - (uint32_t)p_dest))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    // The decoder state is in RAM only, an interrupted image starts over.
+    ret = nrf_dfu_flash_stream_start(p_dest, (uint32_t const *)((uint32_t)p_dest + size), 0, 0, decomp_on_ready);
+    if (ret != FS_SUCCESS)
+    {
+        return (ret == FS_ERR_QUEUE_FULL) ? NRF_ERROR_BUSY : NRF_ERROR_INVALID_PARAM;
+    }
+
+    memset(&m_decomp, 0, sizeof(m_decomp));
+    m_decomp.p_dest    = p_dest;
+    m_decomp.dest_size = size;
+    m_decomp.state     = DECOMP_STATE_HEADER;
+    return NRF_SUCCESS;
+}
+
+
+uint32_t nrf_dfu_decomp_write(void const * p_data, uint32_t len)
+{
+    uint8_t const * p_in = p_data;
+    uint16_t        tail;
+
+    if (m_decomp.state == DECOMP_STATE_ERROR)
+    {
+        return m_decomp.result;
+    }
+    if (len > DECOMP_IN_SIZE - m_decomp.in_len)
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    tail = (m_decomp.in_head + m_decomp.in_len) % DECOMP_IN_SIZE;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        m_decomp.in[tail] = p_in[i];
+        tail = (tail + 1) % DECOMP_IN_SIZE;
+    }
+    m_decomp.in_len    += len;
+    m_decomp.in_crc     = crc32_compute(p_in, len, &m_decomp.in_crc);
+    m_decomp.in_offset += len;
+
+    decomp_run();
+    return (m_decomp.state == DECOMP_STATE_ERROR) ? m_decomp.result : NRF_SUCCESS;
+}
+
+
+uint32_t nrf_dfu_decomp_finish(uint32_t * p_size, uint32_t * p_crc)
+{
+    decomp_run();
+    if (m_decomp.state == DECOMP_STATE_ERROR)
+    {
+        return m_decomp.result;
+    }
+    if ((m_decomp.in_len != 0) || (m_decomp.state == DECOMP_STATE_REPEAT) || (m_decomp.state == DECOMP_STATE_COPY))
+    {
+        return NRF_ERROR_BUSY;
+    }
+    if ((m_decomp.state != DECOMP_STATE_TOKEN) || (m_decomp.out_len != m_decomp.out_size))
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+    if (!decomp_flush())
+    {
+        return (m_decomp.state == DECOMP_STATE_ERROR) ? m_decomp.result : NRF_ERROR_BUSY;
+    }
+    if (nrf_dfu_flash_stream_flush() != FS_SUCCESS)
+    {
+        return NRF_ERROR_INTERNAL;
+    }
+
+    *p_size = m_decomp.out_len;
+    *p_crc  = nrf_dfu_flash_stream_crc(NULL);
+    return NRF_SUCCESS;
+}
+
+
+uint32_t nrf_dfu_decomp_crc(uint32_t * p_offset)
+{
+    if (p_offset != NULL)
+    {
+        *p_offset = m_decomp.in_offset;
+    }
+    return m_decomp.in_crc;
+}
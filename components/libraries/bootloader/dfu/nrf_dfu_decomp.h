@@ -0,0 +1,117 @@
+/* Copyright (c) 2016 Nordic Semiconductor. All Rights Reserved.
+ *
+ * The information contained herein is property of Nordic Semiconductor ASA.
+ * Terms and conditions of usage are described in detail in NORDIC
+ * SEMICONDUCTOR STANDARD SOFTWARE LICENSE AGREEMENT.
+ *
+ * Licensees are granted free, non-transferable use of the information. NO
+ * WARRANTY of ANY KIND is provided. This heading must NOT be removed from
+ * the file.
+ *
+ */
+
+/**@file
+ *
+ * @defgroup sdk_nrf_dfu_decomp Compressed and delta images
+ * @{
+ * @ingroup  sdk_nrf_dfu
+ *
+ * @brief Streaming decoder for compressed firmware images and delta patches against bank 0.
+ *
+ * @details The image starts with a 16-byte header of four little-endian words:
+ *          @ref NRF_DFU_DECOMP_MAGIC, the size of the decoded image, and the CRC32 and size of
+ *          the bank 0 image the patch was made against (both 0 for an image that is only
+ *          compressed). A sequence of tokens follows:
+ *          - @c 0LLLLLLL: L + 1 literal bytes follow.
+ *          - @c 10LLLLOO @c OOOOOOOO: repeat L + 3 bytes from O + 1 bytes back in the decoded
+ *            image, at most @ref NRF_DFU_DECOMP_WINDOW_SIZE.
+ *          - @c 11LLLLLL followed by a 16-bit length and a 24-bit offset: copy
+ *            (L << 16 | length) + 1 bytes from that offset in the bank 0 image.
+ *
+ *          Decoding runs as data arrives and as flash buffers free up, see
+ *          @ref nrf_dfu_flash_stream_start, so it never waits for flash.
+ */
+
+#ifndef NRF_DFU_DECOMP_H__
+#define NRF_DFU_DECOMP_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NRF_DFU_DECOMP_MAGIC        (0x315A444E)    /**< "NDZ1", first word of the image. */
+#define NRF_DFU_DECOMP_HEADER_SIZE  (16)            /**< Size of the image header. */
+#define NRF_DFU_DECOMP_WINDOW_SIZE  (1024)          /**< Distance a repeat can reach back. */
+
+
+/**@brief Function for starting to decode an image into flash.
+ *
+ * @param[in]  p_dest    Word-aligned, erased flash address for the decoded image.
+ * @param[in]  size      Bytes free at @p p_dest, a multiple of 4. Nothing is written past them.
+ *
+ * @retval NRF_SUCCESS             If the decoder was started.
+ * @retval NRF_ERROR_BUSY          If flash writes of the last image are still in progress.
+ * @retval NRF_ERROR_INVALID_PARAM If @p p_dest or @p size is not word-aligned, or the area
+ *                                 wraps around the address space.
+ */
+uint32_t nrf_dfu_decomp_start(uint32_t * p_dest, uint32_t size);
+
+
+/**@brief Function for passing received image data to the decoder.
+ *
+ * The data is copied before the function returns. The header is checked once it is complete:
+ * the decoded image has to fit in the size given to @ref nrf_dfu_decomp_start, and a delta
+ * patch is only accepted if bank 0 holds a valid image with the CRC and size it names and
+ * that area does not overlap it.
+ *
+ * @param[in]  p_data    Received data.
+ * @param[in]  len       Length in bytes.
+ *
+ * @retval NRF_SUCCESS             If the data was accepted.
+ * @retval NRF_ERROR_BUSY          If the decoder still holds data waiting for flash. Nothing
+ *                                 was accepted; try again after the next flash event.
+ * @retval NRF_ERROR_INVALID_DATA  If the image is malformed, decodes past its size or does
+ *                                 not fit.
+ * @retval NRF_ERROR_INVALID_STATE If the bank 0 image does not match the delta patch.
+ * @retval NRF_ERROR_INTERNAL      If a flash write failed.
+ */
+uint32_t nrf_dfu_decomp_write(void const * p_data, uint32_t len);
+
+
+/**@brief Function for finishing the decoded image.
+ *
+ * Programs what is left of the decoded image. On success, @p p_size and @p p_crc are what
+ * goes into the bank of the new image, for the CRC checks of @ref nrf_dfu_utils.
+ * Call @ref nrf_dfu_flash_wait before activating it.
+ *
+ * @param[out] p_size    Size of the decoded image.
+ * @param[out] p_crc     CRC32 of the decoded image.
+ *
+ * @retval NRF_SUCCESS             If the whole image is decoded.
+ * @retval NRF_ERROR_BUSY          If decoded data is still waiting for flash, call again later.
+ * @retval NRF_ERROR_INVALID_DATA  If the image ended early.
+ * @retval NRF_ERROR_INTERNAL      If a flash write failed.
+ */
+uint32_t nrf_dfu_decomp_finish(uint32_t * p_size, uint32_t * p_crc);
+
+
+/**@brief Function for getting the CRC32 of the received, still encoded, data.
+ *
+ * This is the CRC the peer asks for while it transfers the image.
+ *
+ * @param[out] p_offset  Bytes received. Can be NULL.
+ *
+ * @return CRC32 of the bytes up to @p p_offset.
+ */
+uint32_t nrf_dfu_decomp_crc(uint32_t * p_offset);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NRF_DFU_DECOMP_H__
+
+/** @} */
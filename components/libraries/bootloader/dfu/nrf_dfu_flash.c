@@ -15,6 +15,8 @@
 #include "softdevice_handler.h"
 #include "nrf_nvmc.h"
 #include "nrf_log.h"
+#include "crc32.h"
+#include <string.h>
 
 #ifdef SOFTDEVICE_PRESENT
 // Only include fstorage if SD interaction is required
@@ -26,8 +28,25 @@
 #define FLASH_FLAG_FAILURE_SINCE_LAST   (1<<1)
 #define FLASH_FLAG_SD_ENABLED           (1<<2)
 
+#define STREAM_BUF_COUNT                (2)
+#define STREAM_BUF_WORDS                (CODE_PAGE_SIZE / sizeof(uint32_t))
+
 static uint32_t m_flags;
 
+/**@brief Data received by nrf_dfu_flash_stream_write, one buffer fills while the others program. */
+static struct
+{
+    uint32_t   buf[STREAM_BUF_COUNT][STREAM_BUF_WORDS];
+    uint32_t * p_dest;      //!< Flash address of the buffer that fills.
+    uint32_t const * p_end; //!< Flash address after the area of the stream.
+    uint32_t   fill;        //!< Bytes in the buffer that fills.
+    uint32_t   offset;      //!< Bytes accepted since nrf_dfu_flash_stream_start.
+    uint32_t   crc;         //!< CRC32 of the accepted bytes.
+    nrf_dfu_flash_stream_ready_t ready; //!< Called when a buffer is free again.
+    uint8_t    head;        //!< Buffer that fills.
+    volatile uint8_t busy;  //!< Buffers being programmed, the ones before head.
+} m_stream;
+
 #ifdef BLE_STACK_SUPPORT_REQD
 
 // Function prototypes
@@ -258,6 +277,137 @@ fs_ret_t nrf_dfu_flash_erase(uint32_t const * p_dest, uint32_t num_pages, dfu_fl
 }
 
 
+static void stream_evt_handler(fs_evt_t const * const evt, fs_ret_t result)
+{
+    // fstorage completes in order, so this is the oldest buffer in flight. A failure is kept
+    // by fs_evt_handler and returned by the next store.
+    UNUSED_PARAMETER(evt);
+    UNUSED_PARAMETER(result);
+    m_stream.busy--;
+    if (m_stream.ready != NULL)
+    {
+        m_stream.ready();
+    }
+}
+
+
+/**@brief Program the buffer that fills and move on to the next one. */
+static fs_ret_t stream_buf_store(void)
+{
+    fs_ret_t   ret_val;
+    uint32_t   len_words = (m_stream.fill + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+    uint32_t * p_buf     = m_stream.buf[m_stream.head];
+
+    // Pad the last word with the erased value.
+    memset((uint8_t *)p_buf + m_stream.fill, 0xFF, len_words * sizeof(uint32_t) - m_stream.fill);
+
+    // Without SoftDevice the callback runs before the store returns.
+    m_stream.busy++;
+    ret_val = nrf_dfu_flash_store(m_stream.p_dest, p_buf, len_words, stream_evt_handler);
+    if (ret_val != FS_SUCCESS)
+    {
+        m_stream.busy--;
+        return ret_val;
+    }
+
+    m_stream.p_dest += len_words;
+    m_stream.fill    = 0;
+    m_stream.head    = (m_stream.head + 1) % STREAM_BUF_COUNT;
+    return FS_SUCCESS;
+}
+
+
+fs_ret_t nrf_dfu_flash_stream_start(uint32_t *                   p_dest,
+                                    uint32_t const *             p_end,
+                                    uint32_t                     offset,
+                                    uint32_t                     crc,
+                                    nrf_dfu_flash_stream_ready_t ready)
+{
+    if (m_stream.busy != 0)
+    {
+        return FS_ERR_QUEUE_FULL;
+    }
+    if ((((uint32_t)p_dest & 0x03) != 0) || (((uint32_t)p_end & 0x03) != 0))
+    {
+        return FS_ERR_UNALIGNED_ADDR;
+    }
+    if (p_end < p_dest)
+    {
+        return FS_ERR_INVALID_ADDR;
+    }
+
+    m_stream.p_dest = p_dest;
+    m_stream.p_end  = p_end;
+    m_stream.fill   = 0;
+    m_stream.offset = offset;
+    m_stream.crc    = crc;
+    m_stream.ready  = ready;
+    return FS_SUCCESS;
+}
+
+
+fs_ret_t nrf_dfu_flash_stream_write(void const * p_data, uint32_t len)
+{
+    uint32_t room  = sizeof(m_stream.buf[0]) - m_stream.fill;
+    uint32_t first = MIN(len, room);
+
+    if (len > sizeof(m_stream.buf[0]))
+    {
+        return FS_ERR_INVALID_ARG;
+    }
+    // p_dest + fill never passes p_end, so the room left cannot wrap.
+    if (len > (uint32_t)m_stream.p_end - (uint32_t)m_stream.p_dest - m_stream.fill)
+    {
+        return FS_ERR_INVALID_ADDR;
+    }
+    // The data would go into a buffer that is still being programmed.
+    if ((m_stream.busy == STREAM_BUF_COUNT) || ((len > room) && (m_stream.busy == STREAM_BUF_COUNT - 1)))
+    {
+        return FS_ERR_QUEUE_FULL;
+    }
+
+    memcpy((uint8_t *)m_stream.buf[m_stream.head] + m_stream.fill, p_data, first);
+    m_stream.fill += first;
+    if (m_stream.fill == sizeof(m_stream.buf[0]))
+    {
+        fs_ret_t ret_val = stream_buf_store();
+        if (ret_val != FS_SUCCESS)
+        {
+            m_stream.fill -= first;
+            return ret_val;
+        }
+        memcpy(m_stream.buf[m_stream.head], (uint8_t const *)p_data + first, len - first);
+        m_stream.fill = len - first;
+    }
+
+    // Per packet rather than per buffer, so the CRC is ready at any offset the peer asks for.
+    m_stream.crc     = crc32_compute(p_data, len, &m_stream.crc);
+    m_stream.offset += len;
+    return FS_SUCCESS;
+}
+
+
+fs_ret_t nrf_dfu_flash_stream_flush(void)
+{
+    // A buffer with data in it is never in flight.
+    if (m_stream.fill == 0)
+    {
+        return FS_SUCCESS;
+    }
+    return stream_buf_store();
+}
+
+
+uint32_t nrf_dfu_flash_stream_crc(uint32_t * p_offset)
+{
+    if (p_offset != NULL)
+    {
+        *p_offset = m_stream.offset;
+    }
+    return m_stream.crc;
+}
+
+
 void nrf_dfu_flash_error_clear(void)
 {
     m_flags &= ~FLASH_FLAG_FAILURE_SINCE_LAST;
@@ -271,7 +421,7 @@ fs_ret_t nrf_dfu_flash_wait(void)
 #ifdef BLE_STACK_SUPPORT_REQD
     if ((m_flags & FLASH_FLAG_SD_ENABLED) != 0)
     {
-        while ((m_flags & FLASH_FLAG_OPER) != 0)
+        while (((m_flags & FLASH_FLAG_OPER) != 0) || (m_stream.busy != 0))
         {
             (void)sd_app_evt_wait();
         }
@@ -38,6 +38,12 @@ extern "C" {
  */
 typedef fs_cb_t dfu_flash_callback_t;
 
+
+/**@brief   Function called when a buffer of the flash stream has been programmed, see
+ *          @ref nrf_dfu_flash_stream_start.
+ */
+typedef void (*nrf_dfu_flash_stream_ready_t)(void);
+
 /**@brief Function for initializing the flash module.
  *
  * You can use this module with or without a SoftDevice:
@@ -120,6 +126,66 @@ void nrf_dfu_flash_error_clear(void);
 fs_ret_t nrf_dfu_flash_wait(void);
 
 
+/**@brief Function for starting a stream of received data to flash.
+ *
+ * The stream collects the data in two page-sized RAM buffers. A full buffer is programmed while
+ * the next one fills, so receiving and flash writes overlap. The CRC32 of the data is kept up to
+ * date as it arrives and does not have to be computed over flash afterwards.
+ *
+ * @param[in]  p_dest    Word-aligned flash address of the first byte. The area must be erased.
+ * @param[in]  p_end     Word-aligned flash address after the area. Writes past it are refused.
+ * @param[in]  offset    Bytes of the object already received, counted on by the stream.
+ * @param[in]  crc       CRC32 of those bytes, 0 to start a new object.
+ * @param[in]  ready     Called each time a buffer has been programmed and the stream takes
+ *                       data again. Can be NULL.
+ *
+ * @retval  FS_SUCCESS              If the stream was started.
+ * @retval  FS_ERR_QUEUE_FULL       If buffers of the last stream are still being programmed.
+ * @retval  FS_ERR_UNALIGNED_ADDR   If @p p_dest or @p p_end is not word-aligned.
+ * @retval  FS_ERR_INVALID_ADDR     If @p p_end is below @p p_dest.
+ */
+fs_ret_t nrf_dfu_flash_stream_start(uint32_t *                   p_dest,
+                                    uint32_t const *             p_end,
+                                    uint32_t                     offset,
+                                    uint32_t                     crc,
+                                    nrf_dfu_flash_stream_ready_t ready);
+
+
+/**@brief Function for adding received data to the stream.
+ *
+ * @param[in]  p_data    Data, copied before the function returns.
+ * @param[in]  len       Length in bytes, at most one flash page.
+ *
+ * @retval  FS_SUCCESS              If the data was accepted.
+ * @retval  FS_ERR_QUEUE_FULL       If the data needs a buffer that is still being programmed.
+ *                                  Nothing was accepted; try again after the next flash event.
+ * @retval  FS_ERR_INVALID_ARG      If @p len is larger than a flash page.
+ * @retval  FS_ERR_INVALID_ADDR     If the data would go past the end of the area. Nothing was
+ *                                  accepted.
+ * @retval  FS_ERR_FAILURE_SINCE_LAST If programming an earlier buffer failed.
+ */
+fs_ret_t nrf_dfu_flash_stream_write(void const * p_data, uint32_t len);
+
+
+/**@brief Function for programming the data left in the stream buffer.
+ *
+ * The last word is padded with 0xFF. Call @ref nrf_dfu_flash_wait to wait until all buffers
+ * of the stream are in flash.
+ *
+ * @return Result of @ref nrf_dfu_flash_store, FS_SUCCESS if the buffer was empty.
+ */
+fs_ret_t nrf_dfu_flash_stream_flush(void);
+
+
+/**@brief Function for getting the CRC32 of the data accepted by the stream.
+ *
+ * @param[out] p_offset  Bytes accepted, including the offset the stream started with. Can be NULL.
+ *
+ * @return CRC32 of the bytes up to @p p_offset.
+ */
+uint32_t nrf_dfu_flash_stream_crc(uint32_t * p_offset);
+
+
 #ifdef __cplusplus
 }
 #endif
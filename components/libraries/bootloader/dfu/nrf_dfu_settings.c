@@ -17,6 +17,7 @@
 #include <string.h>
 #include "app_scheduler.h"
 #include "nrf_delay.h"
+#include "app_util.h"
 
 /** @brief  This variable reserves a codepage for bootloader specific settings,
  *          to ensure the compiler doesn't locate any code or variables at his location.
@@ -92,6 +93,8 @@
 
 nrf_dfu_settings_t s_dfu_settings;
 
+STATIC_ASSERT(sizeof(nrf_dfu_settings_t) <= NRF_DFU_VALIDATED_OFFSET);
+
 //lint -save -esym(551, flash_operation_pending)
 static bool flash_operation_pending; // barrier for reading flash
 //lint -restore
@@ -230,3 +233,59 @@ ret_code_t nrf_dfu_settings_write(dfu_flash_callback_t callback)
     return NRF_SUCCESS;
 }
 
+
+bool nrf_dfu_settings_validated_get(void)
+{
+    nrf_dfu_validated_t const * p_record =
+        (nrf_dfu_validated_t const *)&m_dfu_settings_buffer[NRF_DFU_VALIDATED_OFFSET];
+
+    return (p_record->magic      == NRF_DFU_VALIDATED_MAGIC)         &&
+           (p_record->generation == s_dfu_settings.crc)              &&
+           (p_record->image_size == s_dfu_settings.bank_0.image_size) &&
+           (p_record->image_crc  == s_dfu_settings.bank_0.image_crc);
+}
+
+
+ret_code_t nrf_dfu_settings_validated_set(void)
+{
+    ret_code_t err_code;
+    uint32_t const * p_dest = (uint32_t const *)&m_dfu_settings_buffer[NRF_DFU_VALIDATED_OFFSET];
+
+    // The settings write erases the page: the record has to come after it.
+    wait_for_pending();
+
+    for (uint32_t i = 0; i < sizeof(nrf_dfu_validated_t) / 4; i++)
+    {
+        if (p_dest[i] != 0xFFFFFFFF)
+        {
+            return NRF_ERROR_INVALID_STATE;
+        }
+    }
+
+    static nrf_dfu_validated_t record;
+    record.magic      = NRF_DFU_VALIDATED_MAGIC;
+    record.generation = s_dfu_settings.crc;
+    record.image_size = s_dfu_settings.bank_0.image_size;
+    record.image_crc  = s_dfu_settings.bank_0.image_crc;
+
+    NRF_LOG_INFO("Recording bank 0 as checked\r\n");
+
+    do
+    {
+        wait_for_queue();
+
+        err_code = nrf_dfu_flash_store(p_dest,
+                                       (uint32_t*)&record,
+                                       sizeof(nrf_dfu_validated_t)/4,
+                                       NULL);
+
+    } while (err_code == FS_ERR_QUEUE_FULL);
+
+    if (err_code != FS_SUCCESS)
+    {
+        NRF_LOG_ERROR("Storing to flash memory failed.\r\n");
+        return NRF_ERROR_INTERNAL;
+    }
+    return NRF_SUCCESS;
+}
+
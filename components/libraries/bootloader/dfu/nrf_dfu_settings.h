@@ -52,6 +52,28 @@ ret_code_t nrf_dfu_settings_write(dfu_flash_callback_t callback);
 void nrf_dfu_settings_init(void);
 
 
+/** @brief Function for checking whether bank 0, as the settings describe it, passed its CRC check
+ *         before, see @ref nrf_dfu_validated_t.
+ *
+ * @retval  true    The record in flash matches the settings and bank 0.
+ * @retval  false   No record, or one for other settings or another image.
+ */
+bool nrf_dfu_settings_validated_get(void);
+
+
+/** @brief Function for recording that bank 0 passed its CRC check.
+ *
+ * @details Call only after the CRC of bank 0 matched. The record goes into the erased end of the
+ *          settings page; a settings write still pending is waited for first, since it erases the page.
+ *
+ * @retval  NRF_SUCCESS             If the record was written or queued.
+ * @retval  NRF_ERROR_INVALID_STATE If the end of the page is not erased; the record comes back
+ *                                  with the next settings write.
+ * @retval  NRF_ERROR_INTERNAL      If a flash error occurred.
+ */
+ret_code_t nrf_dfu_settings_validated_set(void);
+
+
 #ifdef __cplusplus
 }
 #endif
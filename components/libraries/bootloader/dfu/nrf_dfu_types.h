@@ -197,8 +197,27 @@ typedef struct
     uint32_t            enter_buttonless_dfu;
     uint8_t             init_command[INIT_COMMAND_MAX_SIZE];  /**< Buffer for storing the init command. */
 } nrf_dfu_settings_t;
+
+
+#define NRF_DFU_VALIDATED_MAGIC     (0x4C415642UL)  /**< "BVAL", the record holds a checked bank 0. */
+
+/**@brief Bank 0 that passed its CRC check, kept at the end of the settings page.
+ *
+ * The record is written once into the erased end of the page, so it costs no erase. Every settings
+ * write erases the page and the record with it, and the record names the settings it was checked
+ * against, so an update or any other settings change brings the full CRC back once.
+ */
+typedef struct
+{
+    uint32_t            magic;              /**< @ref NRF_DFU_VALIDATED_MAGIC. */
+    uint32_t            generation;         /**< CRC of the settings the image was checked against. */
+    uint32_t            image_size;         /**< Size of the checked image. */
+    uint32_t            image_crc;          /**< CRC of the checked image. */
+} nrf_dfu_validated_t;
 #pragma pack() // revert pack settings
 
+#define NRF_DFU_VALIDATED_OFFSET    (CODE_PAGE_SIZE - sizeof(nrf_dfu_validated_t))  /**< Offset of the record in the settings page. */
+
 
 #ifdef __cplusplus
 }
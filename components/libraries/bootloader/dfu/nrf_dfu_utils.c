@@ -441,7 +441,9 @@ bool nrf_dfu_app_is_valid(void)
     }
 
     // If CRC == 0, this means CRC check is skipped.
-    if (s_dfu_settings.bank_0.image_crc != 0)
+    // A bank 0 checked before under the same settings is not read again: only the first boot
+    // after an update or a settings change pays for the CRC over the whole image.
+    if ((s_dfu_settings.bank_0.image_crc != 0) && !nrf_dfu_settings_validated_get())
     {
         uint32_t crc = crc32_compute((uint8_t*) CODE_REGION_1_START,
                                      s_dfu_settings.bank_0.image_size,
@@ -453,6 +455,9 @@ bool nrf_dfu_app_is_valid(void)
             NRF_LOG_INFO("Return false in CRC\r\n");
             return  false;
         }
+
+        // Not recorded: the next boot checks the image again, nothing worse.
+        (void)nrf_dfu_settings_validated_set();
     }
 
     NRF_LOG_INFO("Return true. App was valid\r\n");
@@ -44,6 +44,35 @@ extern "C" {
 uint16_t crc16_compute(uint8_t const * p_data, uint32_t size, uint16_t const * p_crc);
 
 
+/**@brief Running CRC-16 of a stream that arrives in pieces. */
+typedef struct
+{
+    uint16_t crc;  /**< CRC-16 of the bytes fed so far. */
+} crc16_ctx_t;
+
+/**@brief Function for starting a CRC-16 calculation over a stream.
+ *
+ * @param[out] p_ctx Context to start.
+ */
+void crc16_init(crc16_ctx_t * p_ctx);
+
+/**@brief Function for feeding the next block of a stream into its CRC-16.
+ *
+ * @param[in,out] p_ctx  Context started with @ref crc16_init.
+ * @param[in]     p_data The input data block for computation.
+ * @param[in]     size   The size of the input data block in bytes.
+ */
+void crc16_update(crc16_ctx_t * p_ctx, uint8_t const * p_data, uint32_t size);
+
+/**@brief Function for getting the CRC-16 of all the blocks fed so far.
+ *
+ * @param[in] p_ctx Context started with @ref crc16_init.
+ *
+ * @return The CRC-16 value, the same as @ref crc16_compute over the whole stream.
+ */
+uint16_t crc16_final(crc16_ctx_t const * p_ctx);
+
+
 #ifdef __cplusplus
 }
 #endif
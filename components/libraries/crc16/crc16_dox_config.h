@@ -12,5 +12,13 @@
  */
 #define CRC16_ENABLED
 
+/** @brief Use a 512-byte lookup table instead of the shift and XOR formulation
+ *
+ *  Set to 1 to activate.
+ *
+ * @note This is an NRF_CONFIG macro.
+ */
+#define CRC16_CONFIG_TABLE
+
 
 /** @} */
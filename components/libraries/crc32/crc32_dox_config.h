@@ -12,5 +12,17 @@
  */
 #define CRC32_ENABLED
 
+/** @brief Calculation method
+ *
+ *  Following options are available:
+ * - 0 - Bitwise, no table
+ * - 1 - Nibble table (64 bytes)
+ * - 2 - Byte table (1 KB)
+ * - 3 - Slice-by-4 (4 KB)
+ *
+ * @note This is an NRF_CONFIG macro.
+ */
+#define CRC32_CONFIG_METHOD
+
 
 /** @} */
@@ -0,0 +1,422 @@
+/* Copyright (c) 2016 Nordic Semiconductor. All Rights Reserved.
+ *
+ * The information contained herein is property of Nordic Semiconductor ASA.
+ * Terms and conditions of usage are described in detail in NORDIC
+ * SEMICONDUCTOR STANDARD SOFTWARE LICENSE AGREEMENT.
+ *
+ * Licensees are granted free, non-transferable use of the information. NO
+ * WARRANTY of ANY KIND is provided. This heading must NOT be removed from
+ * the file.
+ *
+ */
+
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(NRF_CRYPTO_AES)
+#include "nrf_crypto_aes.h"
+#include "nrf_ecb.h"
+#include "aes.h"
+#ifdef SOFTDEVICE_PRESENT
+#include "nrf_soc.h"
+#include "softdevice_handler.h"
+#endif
+
+#define BLOCK_SIZE      NRF_CRYPTO_AES_BLOCK_SIZE
+#define CMAC_RB         0x87    //!< Constant of the subkey derivation for a 128-bit block.
+#define CCM_AAD_MAX     0xFF00  //!< Longer AAD needs a 6-byte length encoding.
+
+
+ret_code_t nrf_crypto_aes_init(void)
+{
+    UNUSED_RETURN_VALUE(nrf_ecb_init());
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t nrf_crypto_aes_ecb_encrypt(uint8_t const * p_key, uint8_t const * p_in, uint8_t * p_out)
+{
+#ifdef SOFTDEVICE_PRESENT
+    if (softdevice_handler_is_enabled())
+    {
+        // The SoftDevice owns the ECB peripheral, it runs the block between radio events.
+        nrf_ecb_hal_data_t ecb_data;
+
+        memcpy(ecb_data.key, p_key, BLOCK_SIZE);
+        memcpy(ecb_data.cleartext, p_in, BLOCK_SIZE);
+        if (sd_ecb_block_encrypt(&ecb_data) != NRF_SUCCESS)
+        {
+            return NRF_ERROR_INTERNAL;
+        }
+        memcpy(p_out, ecb_data.ciphertext, BLOCK_SIZE);
+        return NRF_SUCCESS;
+    }
+#endif
+
+    nrf_ecb_set_key(p_key);
+    return nrf_ecb_crypt(p_out, p_in) ? NRF_SUCCESS : NRF_ERROR_INTERNAL;
+}
+
+
+ret_code_t nrf_crypto_aes_ecb_decrypt(uint8_t const * p_key, uint8_t const * p_in, uint8_t * p_out)
+{
+    uint8_t in[BLOCK_SIZE];
+
+    // tiny-AES128 takes a non-const input.
+    memcpy(in, p_in, BLOCK_SIZE);
+    AES128_ECB_decrypt(in, p_key, p_out);
+
+    return NRF_SUCCESS;
+}
+
+
+static void block_xor(uint8_t * p_dst, uint8_t const * p_src, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        p_dst[i] ^= p_src[i];
+    }
+}
+
+
+/**@brief Increment the last @p len bytes of a block as a big-endian number. */
+static void counter_increment(uint8_t * p_block, uint32_t len)
+{
+    for (uint32_t i = BLOCK_SIZE; i > BLOCK_SIZE - len; i--)
+    {
+        if (++p_block[i - 1] != 0)
+        {
+            return;
+        }
+    }
+}
+
+
+/**@brief CTR with a counter in the last @p counter_len bytes of the counter block. */
+static ret_code_t ctr_crypt(uint8_t const * p_key,
+                            uint8_t       * p_counter,
+                            uint32_t        counter_len,
+                            uint8_t const * p_in,
+                            uint8_t       * p_out,
+                            uint32_t        len)
+{
+    uint8_t stream[BLOCK_SIZE];
+
+    while (len > 0)
+    {
+        const uint32_t chunk = MIN(len, BLOCK_SIZE);
+
+        ret_code_t err_code = nrf_crypto_aes_ecb_encrypt(p_key, p_counter, stream);
+        VERIFY_SUCCESS(err_code);
+        counter_increment(p_counter, counter_len);
+
+        for (uint32_t i = 0; i < chunk; i++)
+        {
+            p_out[i] = p_in[i] ^ stream[i];
+        }
+        p_in  += chunk;
+        p_out += chunk;
+        len   -= chunk;
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t nrf_crypto_aes_ctr(uint8_t const * p_key,
+                              uint8_t       * p_counter,
+                              uint8_t const * p_in,
+                              uint8_t       * p_out,
+                              uint32_t        len)
+{
+    return ctr_crypt(p_key, p_counter, BLOCK_SIZE, p_in, p_out, len);
+}
+
+
+/**@brief Shift a block left by one bit, adding the CMAC constant when a bit falls out. */
+static void cmac_subkey(uint8_t * p_block)
+{
+    const uint8_t carry = p_block[0] >> 7;
+
+    for (uint32_t i = 0; i < BLOCK_SIZE - 1; i++)
+    {
+        p_block[i] = (uint8_t)((p_block[i] << 1) | (p_block[i + 1] >> 7));
+    }
+    p_block[BLOCK_SIZE - 1] = (uint8_t)((p_block[BLOCK_SIZE - 1] << 1) ^ (carry ? CMAC_RB : 0));
+}
+
+
+ret_code_t nrf_crypto_aes_cmac_subkeys(uint8_t const * p_key, uint8_t * p_k1, uint8_t * p_k2)
+{
+    uint8_t    zero[BLOCK_SIZE] = {0};
+    ret_code_t err_code;
+
+    err_code = nrf_crypto_aes_ecb_encrypt(p_key, zero, p_k1);
+    VERIFY_SUCCESS(err_code);
+
+    cmac_subkey(p_k1);
+    memcpy(p_k2, p_k1, BLOCK_SIZE);
+    cmac_subkey(p_k2);
+
+    return NRF_SUCCESS;
+}
+
+
+void nrf_crypto_aes_cmac_init(nrf_crypto_aes_cmac_ctx_t * p_ctx,
+                              uint8_t const             * p_key,
+                              uint8_t const             * p_iv)
+{
+    memcpy(p_ctx->key, p_key, BLOCK_SIZE);
+    if (p_iv != NULL)
+    {
+        memcpy(p_ctx->mac, p_iv, BLOCK_SIZE);
+    }
+    else
+    {
+        memset(p_ctx->mac, 0, BLOCK_SIZE);
+    }
+    p_ctx->len = 0;
+}
+
+
+ret_code_t nrf_crypto_aes_cmac_update(nrf_crypto_aes_cmac_ctx_t * p_ctx,
+                                      uint8_t const             * p_data,
+                                      uint32_t                    len)
+{
+    while (len > 0)
+    {
+        // A full block is only processed once more data shows it is not the last one.
+        if (p_ctx->len == BLOCK_SIZE)
+        {
+            ret_code_t err_code = nrf_crypto_aes_ecb_encrypt(p_ctx->key, p_ctx->mac, p_ctx->mac);
+            VERIFY_SUCCESS(err_code);
+            p_ctx->len = 0;
+        }
+
+        const uint32_t chunk = MIN(len, BLOCK_SIZE - p_ctx->len);
+
+        block_xor(&p_ctx->mac[p_ctx->len], p_data, chunk);
+        p_ctx->len += chunk;
+        p_data     += chunk;
+        len        -= chunk;
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t nrf_crypto_aes_cmac_finish(nrf_crypto_aes_cmac_ctx_t * p_ctx, uint8_t * p_mac)
+{
+    uint8_t    subkey[BLOCK_SIZE] = {0};
+    ret_code_t err_code;
+
+    err_code = nrf_crypto_aes_ecb_encrypt(p_ctx->key, subkey, subkey);
+    VERIFY_SUCCESS(err_code);
+
+    // K1 for a complete last block, K2 for a padded one.
+    cmac_subkey(subkey);
+    if (p_ctx->len < BLOCK_SIZE)
+    {
+        cmac_subkey(subkey);
+        p_ctx->mac[p_ctx->len] ^= 0x80;
+    }
+    block_xor(p_ctx->mac, subkey, BLOCK_SIZE);
+
+    return nrf_crypto_aes_ecb_encrypt(p_ctx->key, p_ctx->mac, p_mac);
+}
+
+
+ret_code_t nrf_crypto_aes_cmac(uint8_t const * p_key,
+                               uint8_t const * p_data,
+                               uint32_t        len,
+                               uint8_t       * p_mac)
+{
+    nrf_crypto_aes_cmac_ctx_t ctx;
+    ret_code_t                err_code;
+
+    nrf_crypto_aes_cmac_init(&ctx, p_key, NULL);
+    err_code = nrf_crypto_aes_cmac_update(&ctx, p_data, len);
+    VERIFY_SUCCESS(err_code);
+
+    return nrf_crypto_aes_cmac_finish(&ctx, p_mac);
+}
+
+
+static bool ccm_lengths_valid(uint8_t nonce_len, uint16_t aad_len, uint32_t len, uint8_t tag_len)
+{
+    const uint32_t len_size = BLOCK_SIZE - 1 - nonce_len;
+
+    if ((nonce_len < NRF_CRYPTO_AES_CCM_NONCE_MIN) || (nonce_len > NRF_CRYPTO_AES_CCM_NONCE_MAX))
+    {
+        return false;
+    }
+    if ((tag_len < 4) || (tag_len > BLOCK_SIZE) || ((tag_len & 1) != 0) || (aad_len >= CCM_AAD_MAX))
+    {
+        return false;
+    }
+    // The message length must fit the length field left by the nonce.
+    return (len_size >= sizeof(len)) || ((len >> (8 * len_size)) == 0);
+}
+
+
+/**@brief First block of the CCM counter (@p flags 0) or of the CBC-MAC, without the count. */
+static void ccm_block(uint8_t * p_block, uint8_t flags, uint8_t const * p_nonce, uint8_t nonce_len)
+{
+    memset(p_block, 0, BLOCK_SIZE);
+    p_block[0] = flags | (uint8_t)(BLOCK_SIZE - 2 - nonce_len);
+    memcpy(&p_block[1], p_nonce, nonce_len);
+}
+
+
+/**@brief CBC-MAC over data padded with zeros to whole blocks, the first block starting at
+ *        @p offset.
+ */
+static ret_code_t cbc_mac_padded(uint8_t const * p_key,
+                                 uint8_t       * p_mac,
+                                 uint32_t        offset,
+                                 uint8_t const * p_data,
+                                 uint32_t        len)
+{
+    while (len > 0)
+    {
+        const uint32_t chunk = MIN(len, BLOCK_SIZE - offset);
+
+        block_xor(&p_mac[offset], p_data, chunk);
+        p_data += chunk;
+        len    -= chunk;
+        offset  = 0;
+
+        ret_code_t err_code = nrf_crypto_aes_ecb_encrypt(p_key, p_mac, p_mac);
+        VERIFY_SUCCESS(err_code);
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+/**@brief Unencrypted CCM tag of the cleartext. */
+static ret_code_t ccm_mac(uint8_t const * p_key,
+                          uint8_t const * p_nonce,
+                          uint8_t         nonce_len,
+                          uint8_t const * p_aad,
+                          uint16_t        aad_len,
+                          uint8_t const * p_data,
+                          uint32_t        len,
+                          uint8_t         tag_len,
+                          uint8_t       * p_mac)
+{
+    ret_code_t err_code;
+    uint32_t   len_field = len;
+
+    ccm_block(p_mac, (uint8_t)(((aad_len != 0) ? 0x40 : 0) | (((tag_len - 2) / 2) << 3)),
+              p_nonce, nonce_len);
+    for (uint32_t i = BLOCK_SIZE - 1; (i > nonce_len) && (len_field != 0); i--)
+    {
+        p_mac[i]    = (uint8_t)len_field;
+        len_field >>= 8;
+    }
+    err_code = nrf_crypto_aes_ecb_encrypt(p_key, p_mac, p_mac);
+    VERIFY_SUCCESS(err_code);
+
+    if (aad_len != 0)
+    {
+        // Two length bytes, then the AAD, padded together to whole blocks.
+        p_mac[0] ^= (uint8_t)(aad_len >> 8);
+        p_mac[1] ^= (uint8_t)aad_len;
+        err_code = cbc_mac_padded(p_key, p_mac, 2, p_aad, aad_len);
+        VERIFY_SUCCESS(err_code);
+    }
+
+    return cbc_mac_padded(p_key, p_mac, 0, p_data, len);
+}
+
+
+ret_code_t nrf_crypto_aes_ccm_encrypt(uint8_t const * p_key,
+                                      uint8_t const * p_nonce,
+                                      uint8_t         nonce_len,
+                                      uint8_t const * p_aad,
+                                      uint16_t        aad_len,
+                                      uint8_t const * p_in,
+                                      uint8_t       * p_out,
+                                      uint32_t        len,
+                                      uint8_t       * p_tag,
+                                      uint8_t         tag_len)
+{
+    uint8_t    mac[BLOCK_SIZE];
+    uint8_t    counter[BLOCK_SIZE];
+    uint8_t    stream[BLOCK_SIZE];
+    ret_code_t err_code;
+
+    if (!ccm_lengths_valid(nonce_len, aad_len, len, tag_len))
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    // The MAC goes first, p_out may be p_in.
+    err_code = ccm_mac(p_key, p_nonce, nonce_len, p_aad, aad_len, p_in, len, tag_len, mac);
+    VERIFY_SUCCESS(err_code);
+
+    ccm_block(counter, 0, p_nonce, nonce_len);
+    err_code = nrf_crypto_aes_ecb_encrypt(p_key, counter, stream);
+    VERIFY_SUCCESS(err_code);
+    counter_increment(counter, BLOCK_SIZE - 1 - nonce_len);
+
+    err_code = ctr_crypt(p_key, counter, BLOCK_SIZE - 1 - nonce_len, p_in, p_out, len);
+    VERIFY_SUCCESS(err_code);
+
+    for (uint32_t i = 0; i < tag_len; i++)
+    {
+        p_tag[i] = mac[i] ^ stream[i];
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t nrf_crypto_aes_ccm_decrypt(uint8_t const * p_key,
+                                      uint8_t const * p_nonce,
+                                      uint8_t         nonce_len,
+                                      uint8_t const * p_aad,
+                                      uint16_t        aad_len,
+                                      uint8_t const * p_in,
+                                      uint8_t       * p_out,
+                                      uint32_t        len,
+                                      uint8_t const * p_tag,
+                                      uint8_t         tag_len)
+{
+    uint8_t    mac[BLOCK_SIZE];
+    uint8_t    counter[BLOCK_SIZE];
+    uint8_t    stream[BLOCK_SIZE];
+    uint8_t    diff = 0;
+    ret_code_t err_code;
+
+    if (!ccm_lengths_valid(nonce_len, aad_len, len, tag_len))
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    ccm_block(counter, 0, p_nonce, nonce_len);
+    err_code = nrf_crypto_aes_ecb_encrypt(p_key, counter, stream);
+    VERIFY_SUCCESS(err_code);
+    counter_increment(counter, BLOCK_SIZE - 1 - nonce_len);
+
+    err_code = ctr_crypt(p_key, counter, BLOCK_SIZE - 1 - nonce_len, p_in, p_out, len);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = ccm_mac(p_key, p_nonce, nonce_len, p_aad, aad_len, p_out, len, tag_len, mac);
+    VERIFY_SUCCESS(err_code);
+
+    // Compare all of the tag so the time taken does not show where it differs.
+    for (uint32_t i = 0; i < tag_len; i++)
+    {
+        diff |= (uint8_t)(mac[i] ^ stream[i] ^ p_tag[i]);
+    }
+    if (diff != 0)
+    {
+        memset(p_out, 0, len);
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    return NRF_SUCCESS;
+}
+
+#endif // NRF_MODULE_ENABLED(NRF_CRYPTO_AES)
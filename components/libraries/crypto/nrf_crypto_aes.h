@@ -0,0 +1,241 @@
+/* Copyright (c) 2016 Nordic Semiconductor. All Rights Reserved.
+ *
+ * The information contained herein is property of Nordic Semiconductor ASA.
+ * Terms and conditions of usage are described in detail in NORDIC
+ * SEMICONDUCTOR STANDARD SOFTWARE LICENSE AGREEMENT.
+ *
+ * Licensees are granted free, non-transferable use of the information. NO
+ * WARRANTY of ANY KIND is provided. This heading must NOT be removed from
+ * the file.
+ *
+ */
+
+#ifndef NRF_CRYPTO_AES_H__
+#define NRF_CRYPTO_AES_H__
+
+/** @file
+ *
+ * @defgroup nrf_crypto_aes AES-128 modes on the ECB peripheral
+ * @{
+ * @ingroup nrf_crypto
+ *
+ * @brief   AES-128 CTR, CMAC and CCM with the block cipher of the ECB peripheral.
+ *
+ * @details Each block is encrypted by @c sd_ecb_block_encrypt while the SoftDevice is enabled,
+ *          and by @ref nrf_ecb otherwise. Either way a block takes a few microseconds instead of
+ *          the software AES of tiny-AES128. Keys, nonces and data are in the byte order of the
+ *          standards (RFC 4493, RFC 3610), so the peer can use any AES library. The peripheral
+ *          only encrypts; @ref nrf_crypto_aes_ecb_decrypt is the one function that runs in
+ *          software.
+ *
+ *          The functions block until they are done and must not be called from more than one
+ *          interrupt priority at a time.
+ */
+
+#include <stdint.h>
+#include "sdk_errors.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NRF_CRYPTO_AES_BLOCK_SIZE       16  //!< AES block and key size.
+#define NRF_CRYPTO_AES_CCM_NONCE_MIN    7   //!< Shortest CCM nonce, leaves 8 bytes for the length.
+#define NRF_CRYPTO_AES_CCM_NONCE_MAX    13  //!< Longest CCM nonce, leaves 2 bytes for the length.
+
+
+/**@brief State of a CMAC computed over data that arrives in parts. */
+typedef struct
+{
+    uint8_t key[NRF_CRYPTO_AES_BLOCK_SIZE];     //!< Key.
+    uint8_t mac[NRF_CRYPTO_AES_BLOCK_SIZE];     //!< Chaining value with the pending block added.
+    uint8_t len;                                //!< Bytes of the pending block.
+} nrf_crypto_aes_cmac_ctx_t;
+
+
+/**@brief Function for initializing the AES modes.
+ *
+ * @details Powers the ECB peripheral for use without the SoftDevice. Can be called before or
+ *          after the SoftDevice is enabled.
+ *
+ * @retval NRF_SUCCESS If the ECB peripheral is ready.
+ */
+ret_code_t nrf_crypto_aes_init(void);
+
+
+/**@brief Function for encrypting one block.
+ *
+ * @param[in]  p_key  Key, @ref NRF_CRYPTO_AES_BLOCK_SIZE bytes.
+ * @param[in]  p_in   Cleartext block.
+ * @param[out] p_out  Ciphertext block. Can be @p p_in.
+ *
+ * @retval NRF_SUCCESS        If the block was encrypted.
+ * @retval NRF_ERROR_INTERNAL If the ECB peripheral did not finish.
+ */
+ret_code_t nrf_crypto_aes_ecb_encrypt(uint8_t const * p_key, uint8_t const * p_in, uint8_t * p_out);
+
+
+/**@brief Function for decrypting one block.
+ *
+ * @details Runs in software (tiny-AES128), the ECB peripheral has no inverse cipher. Protocols
+ *          that only need to check a decryption can encrypt the expected value instead.
+ *
+ * @param[in]  p_key  Key, @ref NRF_CRYPTO_AES_BLOCK_SIZE bytes.
+ * @param[in]  p_in   Ciphertext block.
+ * @param[out] p_out  Cleartext block. Can be @p p_in.
+ *
+ * @retval NRF_SUCCESS If the block was decrypted.
+ */
+ret_code_t nrf_crypto_aes_ecb_decrypt(uint8_t const * p_key, uint8_t const * p_in, uint8_t * p_out);
+
+
+/**@brief Function for encrypting or decrypting in counter mode.
+ *
+ * @details The counter block is incremented as a 128-bit big-endian number for each block and
+ *          is left at the next unused value. A call that continues the data of another call
+ *          must follow one whose length was a multiple of the block size.
+ *
+ * @param[in]     p_key      Key, @ref NRF_CRYPTO_AES_BLOCK_SIZE bytes.
+ * @param[in,out] p_counter  Counter block, @ref NRF_CRYPTO_AES_BLOCK_SIZE bytes.
+ * @param[in]     p_in       Data to encrypt or decrypt.
+ * @param[out]    p_out      Result. Can be @p p_in.
+ * @param[in]     len        Length of the data.
+ *
+ * @retval NRF_SUCCESS        If the data was processed.
+ * @retval NRF_ERROR_INTERNAL If the ECB peripheral did not finish.
+ */
+ret_code_t nrf_crypto_aes_ctr(uint8_t const * p_key,
+                              uint8_t       * p_counter,
+                              uint8_t const * p_in,
+                              uint8_t       * p_out,
+                              uint32_t        len);
+
+
+/**@brief Function for computing the AES-CMAC of data (RFC 4493).
+ *
+ * @param[in]  p_key   Key, @ref NRF_CRYPTO_AES_BLOCK_SIZE bytes.
+ * @param[in]  p_data  Data to authenticate.
+ * @param[in]  len     Length of the data, can be 0.
+ * @param[out] p_mac   MAC, @ref NRF_CRYPTO_AES_BLOCK_SIZE bytes. Use its first bytes for a
+ *                     shorter tag.
+ *
+ * @retval NRF_SUCCESS        If the MAC was computed.
+ * @retval NRF_ERROR_INTERNAL If the ECB peripheral did not finish.
+ */
+ret_code_t nrf_crypto_aes_cmac(uint8_t const * p_key,
+                               uint8_t const * p_data,
+                               uint32_t        len,
+                               uint8_t       * p_mac);
+
+
+/**@brief Function for computing the CMAC subkeys of a key (RFC 4493, 2.3).
+ *
+ * @details For protocols that CMAC many short inputs under one key, such as key
+ *          diversification: with the subkeys kept, a MAC costs only its data blocks.
+ *
+ * @param[in]  p_key  Key, @ref NRF_CRYPTO_AES_BLOCK_SIZE bytes.
+ * @param[out] p_k1   K1, for a complete last block.
+ * @param[out] p_k2   K2, for a padded last block.
+ *
+ * @retval NRF_SUCCESS        If the subkeys were computed.
+ * @retval NRF_ERROR_INTERNAL If the ECB peripheral did not finish.
+ */
+ret_code_t nrf_crypto_aes_cmac_subkeys(uint8_t const * p_key, uint8_t * p_k1, uint8_t * p_k2);
+
+
+/**@brief Function for starting a CMAC over data passed in parts.
+ *
+ * @param[out] p_ctx  CMAC state.
+ * @param[in]  p_key  Key, @ref NRF_CRYPTO_AES_BLOCK_SIZE bytes.
+ * @param[in]  p_iv   Initial chaining value, NULL for the zero block of RFC 4493. Protocols
+ *                    such as DESFire EV1 chain the MAC of one message into the next this way.
+ */
+void nrf_crypto_aes_cmac_init(nrf_crypto_aes_cmac_ctx_t * p_ctx,
+                              uint8_t const             * p_key,
+                              uint8_t const             * p_iv);
+
+
+/**@brief Function for adding data to a CMAC.
+ *
+ * @param[in,out] p_ctx   CMAC state.
+ * @param[in]     p_data  Next part of the data.
+ * @param[in]     len     Length of the part.
+ *
+ * @retval NRF_SUCCESS        If the data was added.
+ * @retval NRF_ERROR_INTERNAL If the ECB peripheral did not finish.
+ */
+ret_code_t nrf_crypto_aes_cmac_update(nrf_crypto_aes_cmac_ctx_t * p_ctx,
+                                      uint8_t const             * p_data,
+                                      uint32_t                    len);
+
+
+/**@brief Function for getting the CMAC of the data added.
+ *
+ * @param[in,out] p_ctx  CMAC state, to be started again before further use.
+ * @param[out]    p_mac  MAC, @ref NRF_CRYPTO_AES_BLOCK_SIZE bytes.
+ *
+ * @retval NRF_SUCCESS        If the MAC was computed.
+ * @retval NRF_ERROR_INTERNAL If the ECB peripheral did not finish.
+ */
+ret_code_t nrf_crypto_aes_cmac_finish(nrf_crypto_aes_cmac_ctx_t * p_ctx, uint8_t * p_mac);
+
+
+/**@brief Function for encrypting and authenticating data in CCM mode (RFC 3610).
+ *
+ * @param[in]  p_key      Key, @ref NRF_CRYPTO_AES_BLOCK_SIZE bytes.
+ * @param[in]  p_nonce    Nonce. Must never repeat for a key.
+ * @param[in]  nonce_len  @ref NRF_CRYPTO_AES_CCM_NONCE_MIN to @ref NRF_CRYPTO_AES_CCM_NONCE_MAX.
+ * @param[in]  p_aad      Data that is authenticated but not encrypted. Can be NULL if
+ *                        @p aad_len is 0.
+ * @param[in]  aad_len    Length of @p p_aad, less than 0xFF00.
+ * @param[in]  p_in       Cleartext.
+ * @param[out] p_out      Ciphertext, @p len bytes. Can be @p p_in.
+ * @param[in]  len        Length of the cleartext.
+ * @param[out] p_tag      Authentication tag.
+ * @param[in]  tag_len    Even length of the tag, 4 to 16.
+ *
+ * @retval NRF_SUCCESS              If the data was encrypted.
+ * @retval NRF_ERROR_INVALID_LENGTH If a length is not allowed.
+ * @retval NRF_ERROR_INTERNAL       If the ECB peripheral did not finish.
+ */
+ret_code_t nrf_crypto_aes_ccm_encrypt(uint8_t const * p_key,
+                                      uint8_t const * p_nonce,
+                                      uint8_t         nonce_len,
+                                      uint8_t const * p_aad,
+                                      uint16_t        aad_len,
+                                      uint8_t const * p_in,
+                                      uint8_t       * p_out,
+                                      uint32_t        len,
+                                      uint8_t       * p_tag,
+                                      uint8_t         tag_len);
+
+
+/**@brief Function for decrypting and verifying data in CCM mode (RFC 3610).
+ *
+ * @details Parameters as for @ref nrf_crypto_aes_ccm_encrypt, with @p p_in the ciphertext and
+ *          @p p_tag the received tag. If the tag does not match, @p p_out is cleared.
+ *
+ * @retval NRF_SUCCESS              If the tag matched.
+ * @retval NRF_ERROR_INVALID_DATA   If the tag did not match.
+ * @retval NRF_ERROR_INVALID_LENGTH If a length is not allowed.
+ * @retval NRF_ERROR_INTERNAL       If the ECB peripheral did not finish.
+ */
+ret_code_t nrf_crypto_aes_ccm_decrypt(uint8_t const * p_key,
+                                      uint8_t const * p_nonce,
+                                      uint8_t         nonce_len,
+                                      uint8_t const * p_aad,
+                                      uint16_t        aad_len,
+                                      uint8_t const * p_in,
+                                      uint8_t       * p_out,
+                                      uint32_t        len,
+                                      uint8_t const * p_tag,
+                                      uint8_t         tag_len);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif // NRF_CRYPTO_AES_H__
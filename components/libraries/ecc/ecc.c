@@ -23,6 +23,7 @@
 #include "ecc.h"
 
 #include "uECC.h"
+#include "uECC_vli.h"
 
 
 static int ecc_rng(uint8_t *dest, unsigned size)
@@ -174,3 +175,265 @@ ret_code_t ecc_p256_verify(uint8_t const *p_le_pk, uint8_t const * p_le_hash, ui
 }
 
 
+/* secp128r1 (SEC 2), a = -3. Least significant word first. */
+#define ECC_P128_WORDS      (ECC_P128_SK_LEN / sizeof(uECC_word_t))
+
+STATIC_ASSERT(sizeof(uECC_word_t) == sizeof(uint32_t));
+
+static const uECC_word_t m_p128_p[ECC_P128_WORDS] = {0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFD};
+static const uECC_word_t m_p128_b[ECC_P128_WORDS] = {0x2CEE5ED3, 0xD824993C, 0x1079F43D, 0xE87579C1};
+static const uECC_word_t m_p128_n[ECC_P128_WORDS] = {0x9038A115, 0x75A30D1B, 0x00000000, 0xFFFFFFFE};
+static const uECC_word_t m_p128_g[2 * ECC_P128_WORDS] =
+{
+    0xA52C5B86, 0x0C28607C, 0x8B899B2D, 0x161FF752,
+    0xDDED7A83, 0xC02DA292, 0x5BAFEB13, 0xCF5AC839,
+};
+
+/* Point in Jacobian coordinates, x = X / Z^2, y = Y / Z^3. Z = 0 is the point at infinity. */
+typedef struct
+{
+    uECC_word_t x[ECC_P128_WORDS];
+    uECC_word_t y[ECC_P128_WORDS];
+    uECC_word_t z[ECC_P128_WORDS];
+} ecc_p128_jacobian_t;
+
+
+static void p128_mult(uECC_word_t * p_r, uECC_word_t const * p_a, uECC_word_t const * p_b)
+{
+    uECC_vli_modMult(p_r, p_a, p_b, m_p128_p, ECC_P128_WORDS);
+}
+
+
+static void p128_add(uECC_word_t * p_r, uECC_word_t const * p_a, uECC_word_t const * p_b)
+{
+    uECC_vli_modAdd(p_r, p_a, p_b, m_p128_p, ECC_P128_WORDS);
+}
+
+
+static void p128_sub(uECC_word_t * p_r, uECC_word_t const * p_a, uECC_word_t const * p_b)
+{
+    uECC_vli_modSub(p_r, p_a, p_b, m_p128_p, ECC_P128_WORDS);
+}
+
+
+/* y^2 == x^3 - 3x + b, x and y below p. */
+static bool p128_on_curve(uECC_word_t const * p_a)
+{
+    uECC_word_t const * p_y   = p_a + ECC_P128_WORDS;
+    uECC_word_t const   three[ECC_P128_WORDS] = {3};
+    uECC_word_t         l[ECC_P128_WORDS];
+    uECC_word_t         r[ECC_P128_WORDS];
+
+    if (uECC_vli_cmp(m_p128_p, p_a, ECC_P128_WORDS) != 1 ||
+        uECC_vli_cmp(m_p128_p, p_y, ECC_P128_WORDS) != 1)
+    {
+        return false;
+    }
+
+    p128_mult(l, p_y, p_y);
+    p128_mult(r, p_a, p_a);
+    p128_sub(r, r, three);
+    p128_mult(r, r, p_a);
+    p128_add(r, r, m_p128_b);
+
+    return uECC_vli_equal(l, r, ECC_P128_WORDS);
+}
+
+
+/* R = 2R (dbl-2001-b, a = -3). */
+static void p128_double(ecc_p128_jacobian_t * p_r)
+{
+    uECC_word_t delta[ECC_P128_WORDS];
+    uECC_word_t gamma[ECC_P128_WORDS];
+    uECC_word_t beta[ECC_P128_WORDS];
+    uECC_word_t alpha[ECC_P128_WORDS];
+    uECC_word_t t[ECC_P128_WORDS];
+
+    if (uECC_vli_isZero(p_r->z, ECC_P128_WORDS))
+    {
+        return;
+    }
+
+    p128_mult(delta, p_r->z, p_r->z);
+    p128_mult(gamma, p_r->y, p_r->y);
+    p128_mult(beta, p_r->x, gamma);
+
+    p128_sub(t, p_r->x, delta);
+    p128_add(alpha, p_r->x, delta);
+    p128_mult(alpha, alpha, t);
+    p128_add(t, alpha, alpha);
+    p128_add(alpha, alpha, t);
+
+    p128_mult(p_r->z, p_r->y, p_r->z);
+    p128_add(p_r->z, p_r->z, p_r->z);
+
+    p128_add(beta, beta, beta);
+    p128_add(beta, beta, beta);
+    p128_mult(p_r->x, alpha, alpha);
+    p128_sub(p_r->x, p_r->x, beta);
+    p128_sub(p_r->x, p_r->x, beta);
+
+    p128_sub(t, beta, p_r->x);
+    p128_mult(t, alpha, t);
+    p128_mult(gamma, gamma, gamma);
+    p128_add(gamma, gamma, gamma);
+    p128_add(gamma, gamma, gamma);
+    p128_add(gamma, gamma, gamma);
+    p128_sub(p_r->y, t, gamma);
+}
+
+
+/* R = R + A, A affine X then Y (madd-2004-hmv). */
+static void p128_add_affine(ecc_p128_jacobian_t * p_r, uECC_word_t const * p_a)
+{
+    uECC_word_t h[ECC_P128_WORDS];
+    uECC_word_t r[ECC_P128_WORDS];
+    uECC_word_t hh[ECC_P128_WORDS];
+    uECC_word_t t[ECC_P128_WORDS];
+
+    if (uECC_vli_isZero(p_r->z, ECC_P128_WORDS))
+    {
+        uECC_vli_set(p_r->x, p_a, ECC_P128_WORDS);
+        uECC_vli_set(p_r->y, p_a + ECC_P128_WORDS, ECC_P128_WORDS);
+        uECC_vli_clear(p_r->z, ECC_P128_WORDS);
+        p_r->z[0] = 1;
+        return;
+    }
+
+    p128_mult(t, p_r->z, p_r->z);
+    p128_mult(h, p_a, t);
+    p128_sub(h, h, p_r->x);
+    p128_mult(t, t, p_r->z);
+    p128_mult(r, p_a + ECC_P128_WORDS, t);
+    p128_sub(r, r, p_r->y);
+
+    if (uECC_vli_isZero(h, ECC_P128_WORDS))
+    {
+        if (uECC_vli_isZero(r, ECC_P128_WORDS))
+        {
+            p128_double(p_r);
+        }
+        else
+        {
+            uECC_vli_clear(p_r->z, ECC_P128_WORDS);
+        }
+        return;
+    }
+
+    p128_mult(p_r->z, p_r->z, h);
+    p128_mult(hh, h, h);
+    p128_mult(t, hh, h);
+    p128_mult(h, p_r->x, hh);
+
+    p128_mult(p_r->x, r, r);
+    p128_sub(p_r->x, p_r->x, t);
+    p128_sub(p_r->x, p_r->x, h);
+    p128_sub(p_r->x, p_r->x, h);
+
+    p128_mult(t, p_r->y, t);
+    p128_sub(h, h, p_r->x);
+    p128_mult(h, r, h);
+    p128_sub(p_r->y, h, t);
+}
+
+
+/* Affine X then Y of R, which must not be the point at infinity. */
+static void p128_to_affine(ecc_p128_jacobian_t const * p_r, uECC_word_t * p_a)
+{
+    uECC_word_t z_inv[ECC_P128_WORDS];
+    uECC_word_t t[ECC_P128_WORDS];
+
+    uECC_vli_modInv(z_inv, p_r->z, m_p128_p, ECC_P128_WORDS);
+    p128_mult(t, z_inv, z_inv);
+    p128_mult(p_a, p_r->x, t);
+    p128_mult(t, t, z_inv);
+    p128_mult(p_a + ECC_P128_WORDS, p_r->y, t);
+}
+
+
+ret_code_t ecc_p128_verify(uint8_t const *p_le_pk, uint8_t const * p_le_hash, uint32_t hlen, uint8_t const *p_le_sig)
+{
+    uECC_word_t const * p_q = (uECC_word_t const *) p_le_pk;
+    uECC_word_t         r[ECC_P128_WORDS];
+    uECC_word_t         s[ECC_P128_WORDS];
+    uECC_word_t         u1[ECC_P128_WORDS];
+    uECC_word_t         u2[ECC_P128_WORDS];
+    uECC_word_t         gq[2 * ECC_P128_WORDS];
+    ecc_p128_jacobian_t sum;
+
+    if (!p_le_pk || !p_le_hash || !p_le_sig)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    if (!is_word_aligned(p_le_pk) || !is_word_aligned(p_le_hash) || !is_word_aligned(p_le_sig))
+    {
+        return NRF_ERROR_INVALID_ADDR;
+    }
+
+    if (hlen > ECC_P128_SK_LEN)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    if (!p128_on_curve(p_q))
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    uECC_vli_set(r, (uECC_word_t const *) p_le_sig, ECC_P128_WORDS);
+    uECC_vli_set(s, (uECC_word_t const *) (p_le_sig + ECC_P128_SK_LEN), ECC_P128_WORDS);
+    if (uECC_vli_isZero(r, ECC_P128_WORDS) || uECC_vli_isZero(s, ECC_P128_WORDS) ||
+        uECC_vli_cmp(m_p128_n, r, ECC_P128_WORDS) != 1 || uECC_vli_cmp(m_p128_n, s, ECC_P128_WORDS) != 1)
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    // u1 = e / s, u2 = r / s (mod n), e the hash as a number below n.
+    uECC_vli_clear(u1, ECC_P128_WORDS);
+    memcpy(u1, p_le_hash, hlen);
+    if (uECC_vli_cmp(m_p128_n, u1, ECC_P128_WORDS) != 1)
+    {
+        uECC_vli_sub(u1, u1, m_p128_n, ECC_P128_WORDS);
+    }
+    uECC_vli_modInv(s, s, m_p128_n, ECC_P128_WORDS);
+    uECC_vli_modMult(u1, u1, s, m_p128_n, ECC_P128_WORDS);
+    uECC_vli_modMult(u2, r, s, m_p128_n, ECC_P128_WORDS);
+
+    // G + Q, for the bits set in both scalars.
+    uECC_vli_clear(sum.z, ECC_P128_WORDS);
+    p128_add_affine(&sum, m_p128_g);
+    p128_add_affine(&sum, p_q);
+    if (uECC_vli_isZero(sum.z, ECC_P128_WORDS))
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+    p128_to_affine(&sum, gq);
+
+    uECC_vli_clear(sum.z, ECC_P128_WORDS);
+    for (int32_t bit = 8 * ECC_P128_SK_LEN - 1; bit >= 0; bit--)
+    {
+        bool g = uECC_vli_testBit(u1, (bitcount_t) bit) != 0;
+        bool q = uECC_vli_testBit(u2, (bitcount_t) bit) != 0;
+
+        p128_double(&sum);
+        if (g || q)
+        {
+            p128_add_affine(&sum, (g && q) ? gq : (g ? m_p128_g : p_q));
+        }
+    }
+
+    if (uECC_vli_isZero(sum.z, ECC_P128_WORDS))
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    // x mod n == r; x < p < n < 2n, so one conditional subtraction reduces x.
+    p128_to_affine(&sum, gq);
+    if (uECC_vli_cmp(m_p128_n, gq, ECC_P128_WORDS) != 1)
+    {
+        uECC_vli_sub(gq, gq, m_p128_n, ECC_P128_WORDS);
+    }
+
+    return uECC_vli_equal(gq, r, ECC_P128_WORDS) ? NRF_SUCCESS : NRF_ERROR_INVALID_DATA;
+}
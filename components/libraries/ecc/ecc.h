@@ -27,6 +27,8 @@ extern "C" {
 
 #define ECC_P256_SK_LEN 32
 #define ECC_P256_PK_LEN 64
+#define ECC_P128_SK_LEN 16
+#define ECC_P128_PK_LEN 32
 
 /**@brief Initialize the ECC module.
  *
@@ -101,6 +103,27 @@ ret_code_t ecc_p256_sign(uint8_t const *p_le_sk, uint8_t const * p_le_hash, uint
  */
 ret_code_t ecc_p256_verify(uint8_t const *p_le_pk, uint8_t const * p_le_hash, uint32_t hlen, uint8_t const *p_le_sig);
 
+/**@brief Verify a secp128r1 signature using a public key.
+ *
+ * @details For the originality signatures of NXP tags, which sign their UID on this curve.
+ *          micro-ecc has no secp128r1, so this runs on its VLI functions with 4 words: a plain
+ *          double-and-add of u1 * G + u2 * Q over 128 doublings, G + Q added in one step.
+ *
+ * @param[in]   p_le_pk   Public key. Pointer must be aligned to a 4-byte boundary.
+ * @param[in]   p_le_hash Hash, or the message itself if it is not longer. Pointer must be
+ *                        aligned to a 4-byte boundary.
+ * @param[in]   hlen      Hash length in bytes, at most 16.
+ * @param[in]   p_le_sig  Signature. Pointer must be aligned to a 4-byte boundary.
+ *
+ * @retval     NRF_SUCCESS              Signature verified.
+ * @retval     NRF_ERROR_INVALID_DATA   Signature failed verification, or the public key is not a
+ *                                      point of the curve.
+ * @retval     NRF_ERROR_INVALID_LENGTH Hash longer than 16 bytes.
+ * @retval     NRF_ERROR_NULL           NULL pointer provided.
+ * @retval     NRF_ERROR_INVALID_ADDR   Unaligned pointer provided.
+ */
+ret_code_t ecc_p128_verify(uint8_t const *p_le_pk, uint8_t const * p_le_hash, uint32_t hlen, uint8_t const *p_le_sig);
+
 
 #ifdef __cplusplus
 }
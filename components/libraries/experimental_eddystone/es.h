@@ -73,6 +73,9 @@
 #define ES_TLM_ADV_CNT_LENGTH            (4)         //!< Length of a TLM frame ADV count field.
 #define ES_TLM_SEC_CNT_LENGTH            (4)         //!< Length of a TLM frame seconds field.
 
+#define ES_TLM_READER_LENGTH             (16)        //!< Length of a reader TLM frame.
+#define ES_TLM_READER_RATE_LENGTH        (2)         //!< Length of a reader TLM frame rate or latency field.
+
 #define ES_EID_LENGTH                    (10)        //!< Length of an EID frame.
 #define ES_EID_ID_LENGTH                 (8)         //!< Length of an EID frame ephemeral ID field.
 #define ES_EID_GATTS_READ_LENGTH         (14)
@@ -103,7 +106,8 @@ typedef enum
 typedef enum
 {
     ES_TLM_VERSION_TLM = 0x00, /**< TLM. */
-    ES_TLM_VERSION_ETLM = 0x01 /**< Encrypted TLM (eTLM). */
+    ES_TLM_VERSION_ETLM = 0x01, /**< Encrypted TLM (eTLM). */
+    ES_TLM_VERSION_READER = 0x80 /**< Reader health, vendor extension; scanners that only know 0x00 and 0x01 skip it. */
 } es_tlm_version_t;
 
 /** @brief UID frame data representation. 
@@ -144,6 +148,25 @@ typedef PACKED_STRUCT
     int8_t           sec_cnt[ES_TLM_SEC_CNT_LENGTH];        //!< Time since power-on or reboot.
 } es_tlm_frame_t;
 
+
+/** @brief Reader TLM frame data representation, @ref ES_TLM_VERSION_READER. Big endian, like TLM.
+ *
+ * @details The rates cover the time since the previous reader TLM frame.
+ * @note This is a packed structure. Therefore, you should not change it.
+ */
+typedef PACKED_STRUCT
+{
+    es_frame_type_t  frame_type;                            //!< Frame type, @ref ES_FRAME_TYPE_TLM.
+    es_tlm_version_t version;                               //!< @ref ES_TLM_VERSION_READER.
+    uint8_t          vbatt[ES_TLM_VBATT_LENGTH];            //!< Battery voltage (in 1 mV units), 0 if not measured.
+    uint8_t          taps[ES_TLM_READER_RATE_LENGTH];       //!< Taps per minute, in 0.01 units.
+    uint8_t          latency[ES_TLM_READER_RATE_LENGTH];    //!< Average tap-to-result latency, in ms.
+    uint8_t          rf_errors[ES_TLM_READER_RATE_LENGTH];  //!< Card operations that failed, per 1000.
+    uint8_t          journal_fill;                          //!< Journal fill level, in percent.
+    uint8_t          sec_cnt[ES_TLM_SEC_CNT_LENGTH];        //!< Time since power-on or reboot, in 0.1 s.
+    uint8_t          diag;                                  //!< Flags of the last PN532 self test, 0 if it passed.
+} es_tlm_reader_frame_t;
+
 /** @brief EID frame data representation. 
  * @note This is a packed structure. Therefore, you should not change it.
 */
@@ -15,15 +15,20 @@
 #include "fds_internal_defs.h"
 
 #include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdbool.h>
 #include "fstorage.h"
 #include "nrf_error.h"
 
-#if defined(FDS_CRC_ENABLED)
+#if defined(FDS_CRC_ENABLED) || (FDS_INDEX_SNAPSHOT != 0)
     #include "crc16.h"
 #endif
 
+#if (FDS_INDEX_SNAPSHOT != 0) && !NRF_MODULE_ENABLED(CRC16)
+    #error "FDS_INDEX_SNAPSHOT requires CRC16."
+#endif
+
 
 static void fs_event_handler(fs_evt_t const * const evt, fs_ret_t result);
 
@@ -37,6 +42,23 @@ FS_REGISTER_CFG(fs_config_t fs_config) =
     .priority  = 0xFF
 };
 
+#if (FDS_INDEX_SNAPSHOT != 0)
+static void snapshot_fs_event_handler(fs_evt_t const * const evt, fs_ret_t result);
+
+// A virtual page of its own for the index snapshots.
+FS_REGISTER_CFG(fs_config_t m_snapshot_fs_config) =
+{
+    .callback  = snapshot_fs_event_handler,
+    .num_pages = FDS_PHY_PAGES_IN_VPAGE,
+    .priority  = FDS_INDEX_SNAPSHOT_FS_PRIORITY
+};
+
+STATIC_ASSERT(FDS_SNAPSHOT_SIZE <= FDS_PAGE_SIZE);
+
+// Written over the live and mark words of a snapshot entry.
+static uint32_t const m_snapshot_zero = 0;
+#endif
+
 // Used to flag a record as dirty, i.e. ready for garbage collection.
 static fds_tl_t const m_fds_tl_dirty =
 {
@@ -65,6 +87,16 @@ static fds_swap_page_t      m_swap_page;
 // Garbage collection data.
 static fds_gc_data_t        m_gc;
 
+#if (FDS_INDEX_SIZE != 0)
+// Record key index.
+static fds_index_t          m_index;
+#endif
+
+#if (FDS_INDEX_SNAPSHOT != 0)
+// The snapshot of the pages and the index in flash.
+static fds_snapshot_t       m_snapshot;
+#endif
+
 
 static void flag_set(fds_flags_t flag)
 {
@@ -140,6 +172,16 @@ static void event_prepare(fds_op_t const * const p_op, fds_evt_t * const p_evt)
             p_evt->id = FDS_EVT_GC;
             break;
 
+        case FDS_OP_WRITE_BATCH:
+            p_evt->id                    = FDS_EVT_WRITE_BATCH;
+            p_evt->batch.first_record_id = p_op->batch.first_id;
+            p_evt->batch.count           = p_op->batch.count;
+            break;
+
+        case FDS_OP_INDEX_SAVE:
+            p_evt->id = FDS_EVT_INDEX_SAVE;
+            break;
+
         default:
             // Should not happen.
             break;
@@ -176,6 +218,20 @@ static bool chunk_is_aligned(fds_record_chunk_t const * const p_chunk, uint32_t
 }
 
 
+// The length of the record data, in 4-byte words.
+static uint16_t record_length(fds_record_t const * const p_record)
+{
+    uint16_t length_words = 0;
+
+    for (uint32_t i = 0; i < p_record->data.num_chunks; i++)
+    {
+        length_words += p_record->data.p_chunks[i].length_words;
+    }
+
+    return length_words;
+}
+
+
 // Reads a page tag, and determines if the page is used to store data or as swap.
 static fds_page_type_t page_identify(uint32_t const * const p_page_addr)
 {
@@ -389,59 +445,568 @@ static bool record_find_next(uint16_t page, uint32_t const ** p_record)
     {
         p_header = (fds_header_t*)p_next_rec;
 
-        if (header_is_valid(p_header))
+        if (header_is_valid(p_header))
+        {
+            *p_record = p_next_rec;
+            return true;
+        }
+        else
+        {
+            // The record is not valid, jump to the next.
+            p_next_rec += (FDS_HEADER_SIZE + (p_header->tl.length_words));
+        }
+    }
+
+    // No more valid records on this page.
+    return false;
+}
+
+
+// Find a record given its descriptor and retrive the page in which the record is stored.
+// NOTE: Do not pass NULL as an argument for p_page.
+static bool record_find_by_desc(fds_record_desc_t * const p_desc, uint16_t * const p_page)
+{
+    // If the gc_run_count field in the descriptor matches our counter, then the record has
+    // not been moved. If the address is valid, and the record ID matches, there is no need
+    // to find the record again. Only lookup the page in which the record is stored.
+
+    if ((address_is_valid(p_desc->p_record))     &&
+        (p_desc->gc_run_count == m_gc.run_count) &&
+        (p_desc->record_id    == ((fds_header_t*)p_desc->p_record)->record_id))
+    {
+        return (page_from_record(p_page, p_desc->p_record) == FDS_SUCCESS);
+    }
+
+    // Otherwise, find the record in flash.
+    for (*p_page = 0; *p_page < FDS_MAX_PAGES; (*p_page)++)
+    {
+        // Set p_record to NULL to make record_find_next() search from the beginning of the page.
+        uint32_t const * p_record = NULL;
+
+        while (record_find_next(*p_page, &p_record))
+        {
+            fds_header_t const * const p_header = (fds_header_t*)p_record;
+            if (p_header->record_id == p_desc->record_id)
+            {
+                p_desc->p_record     = p_record;
+                p_desc->gc_run_count = m_gc.run_count;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+
+#if (FDS_INDEX_SIZE != 0)
+
+static uint16_t index_hash(uint16_t record_key)
+{
+    return (uint16_t)(((uint32_t)record_key * 2654435761UL) >> 16) & (FDS_INDEX_SIZE - 1);
+}
+
+
+static uint32_t const * index_record(fds_index_slot_t const * const p_slot)
+{
+    return m_pages[p_slot->page].p_addr + p_slot->offset;
+}
+
+
+// Add a record to the index, without checking whether the index is valid or full.
+static void index_put(uint16_t page, uint32_t const * const p_record)
+{
+    uint16_t const key   = ((fds_header_t*)p_record)->tl.record_key;
+    uint16_t const start = index_hash(key);
+
+    for (uint16_t i = 0; i < FDS_INDEX_SIZE; i++)
+    {
+        fds_index_slot_t * const p_slot = &m_index.slot[(start + i) & (FDS_INDEX_SIZE - 1)];
+
+        if ((p_slot->page == FDS_INDEX_SLOT_EMPTY) || (p_slot->page == FDS_INDEX_SLOT_DELETED))
+        {
+            if (p_slot->page == FDS_INDEX_SLOT_EMPTY)
+            {
+                m_index.used++;
+            }
+            p_slot->page   = page;
+            p_slot->offset = (uint16_t)(p_record - m_pages[page].p_addr);
+            return;
+        }
+    }
+}
+
+
+// Build the index from the records in flash. If they do not fit, the index stays invalid
+// and records are searched for in flash until the next build.
+static void index_build(void)
+{
+    CRITICAL_SECTION_ENTER();
+    m_index.valid = false;
+    CRITICAL_SECTION_EXIT();
+
+    memset(m_index.slot, 0xFF, sizeof(m_index.slot));
+    m_index.used = 0;
+
+    for (uint16_t page = 0; page < FDS_MAX_PAGES; page++)
+    {
+        uint32_t const * p_record = NULL;
+
+        if (m_pages[page].page_type != FDS_PAGE_DATA)
+        {
+            continue;
+        }
+
+        while (record_find_next(page, &p_record))
+        {
+            if (m_index.used >= FDS_INDEX_LOAD_MAX)
+            {
+                return;
+            }
+            index_put(page, p_record);
+        }
+    }
+
+    CRITICAL_SECTION_ENTER();
+    m_index.valid = true;
+    CRITICAL_SECTION_EXIT();
+}
+
+
+// Add a record which has just been written. The record must already be valid in flash.
+static void index_insert(uint16_t page, uint32_t const * const p_record)
+{
+    if (!m_index.valid)
+    {
+        return;
+    }
+
+    if (m_index.used >= FDS_INDEX_LOAD_MAX)
+    {
+        // Rebuilding drops the deleted slots; the new record is found in flash.
+        index_build();
+        return;
+    }
+
+    CRITICAL_SECTION_ENTER();
+    index_put(page, p_record);
+    CRITICAL_SECTION_EXIT();
+}
+
+
+// Remove a record which is about to be flagged as dirty.
+static void index_remove(uint16_t page, uint32_t const * const p_record)
+{
+    uint16_t const key    = ((fds_header_t*)p_record)->tl.record_key;
+    uint16_t const start  = index_hash(key);
+    uint16_t const offset = (uint16_t)(p_record - m_pages[page].p_addr);
+
+    CRITICAL_SECTION_ENTER();
+    for (uint16_t i = 0; (i < FDS_INDEX_SIZE) && m_index.valid; i++)
+    {
+        fds_index_slot_t * const p_slot = &m_index.slot[(start + i) & (FDS_INDEX_SIZE - 1)];
+
+        if (p_slot->page == FDS_INDEX_SLOT_EMPTY)
+        {
+            break;
+        }
+        if ((p_slot->page == page) && (p_slot->offset == offset))
+        {
+            p_slot->page = FDS_INDEX_SLOT_DELETED;
+            break;
+        }
+    }
+    CRITICAL_SECTION_EXIT();
+}
+
+
+// Find the next record with the given key (and file ID, if not NULL) after the one in the
+// token, in the same order as the flash search in record_find().
+// Returns false if the index is not valid and the flash has to be searched instead.
+static bool index_find(uint16_t          const * const p_file_id,
+                       uint16_t                        record_key,
+                       fds_record_desc_t       * const p_desc,
+                       fds_find_token_t        * const p_token,
+                       ret_code_t              * const p_ret)
+{
+    fds_index_slot_t const * p_found   = NULL;
+    uint16_t         const   start     = index_hash(record_key);
+    uint16_t                 tok_offset = 0;
+    bool                     valid;
+
+    if (p_token->page >= FDS_MAX_PAGES)
+    {
+        *p_ret = FDS_ERR_NOT_FOUND;
+        return true;
+    }
+    if (p_token->p_addr != NULL)
+    {
+        tok_offset = (uint16_t)(p_token->p_addr - m_pages[p_token->page].p_addr);
+    }
+
+    CRITICAL_SECTION_ENTER();
+    valid = m_index.valid;
+    for (uint16_t i = 0; (i < FDS_INDEX_SIZE) && valid; i++)
+    {
+        fds_index_slot_t const * const p_slot = &m_index.slot[(start + i) & (FDS_INDEX_SIZE - 1)];
+        fds_header_t     const *       p_header;
+
+        if (p_slot->page == FDS_INDEX_SLOT_EMPTY)
+        {
+            break;
+        }
+        if (p_slot->page == FDS_INDEX_SLOT_DELETED)
+        {
+            continue;
+        }
+
+        p_header = (fds_header_t*)index_record(p_slot);
+        if ((!header_is_valid(p_header))                                        ||
+            (p_header->tl.record_key != record_key)                             ||
+            ((p_file_id != NULL) && (p_header->ic.file_id != *p_file_id)))
+        {
+            continue;
+        }
+
+        // Only records past the token, and of those the first one in flash.
+        if ((p_slot->page < p_token->page) ||
+            ((p_slot->page == p_token->page) && (p_slot->offset <= tok_offset)))
+        {
+            continue;
+        }
+        if ((p_found == NULL)                ||
+            (p_slot->page < p_found->page)   ||
+            ((p_slot->page == p_found->page) && (p_slot->offset < p_found->offset)))
+        {
+            p_found = p_slot;
+        }
+    }
+
+    if (valid && (p_found != NULL))
+    {
+        p_token->page        = p_found->page;
+        p_token->p_addr      = index_record(p_found);
+        p_desc->record_id    = ((fds_header_t*)p_token->p_addr)->record_id;
+        p_desc->p_record     = p_token->p_addr;
+        p_desc->gc_run_count = m_gc.run_count;
+        *p_ret               = FDS_SUCCESS;
+    }
+    else if (valid)
+    {
+        // The same end state as a search which ran through all pages.
+        p_token->page   = FDS_MAX_PAGES;
+        p_token->p_addr = NULL;
+        *p_ret          = FDS_ERR_NOT_FOUND;
+    }
+    CRITICAL_SECTION_EXIT();
+
+    return valid;
+}
+
+#endif // FDS_INDEX_SIZE
+
+
+#if (FDS_INDEX_SNAPSHOT != 0)
+
+static uint32_t const * snapshot_word(uint16_t offset)
+{
+    return (uint32_t const *)m_snapshot.p_entry + offset;
+}
+
+
+static uint16_t snapshot_crc(fds_snapshot_head_t const * const p_head,
+                             void                const * const p_slots)
+{
+    uint16_t crc;
+
+    crc = crc16_compute((uint8_t*)&p_head->index_used,
+                        sizeof(fds_snapshot_head_t) - offsetof(fds_snapshot_head_t, index_used),
+                        NULL);
+    crc = crc16_compute((uint8_t*)p_slots, FDS_INDEX_SIZE * sizeof(fds_index_slot_t), &crc);
+
+    return crc;
+}
+
+
+// Whether an entry is complete, has not been dropped, and finds the pages and the swap as it
+// left them. A swap which is not empty means GC was under way.
+static bool snapshot_entry_valid(fds_snapshot_head_t const * const p_head)
+{
+    uint32_t const * const p_words = (uint32_t const *)p_head;
+
+    if ((p_head->index_used > FDS_INDEX_SIZE)                      ||
+        (p_words[FDS_SNAPSHOT_OFFSET_LIVE] != FDS_ERASED_WORD)     ||
+        (p_head->crc != snapshot_crc(p_head, p_words + FDS_SNAPSHOT_OFFSET_SLOTS)))
+    {
+        return false;
+    }
+
+    if ((!address_is_valid(p_head->p_swap))                       ||
+        (page_identify(p_head->p_swap) != FDS_PAGE_SWAP)           ||
+        (p_head->p_swap[FDS_PAGE_TAG_SIZE] != FDS_ERASED_WORD))
+    {
+        return false;
+    }
+
+    for (uint16_t i = 0; i < FDS_MAX_PAGES; i++)
+    {
+        uint32_t const * const p_addr = p_head->page[i].p_addr;
+
+        if ((p_addr != NULL) &&
+            ((!address_is_valid(p_addr)) || (page_identify(p_addr) != FDS_PAGE_DATA)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// Find the latest entry and where the next one goes. Only the last entry in the page counts,
+// so an entry which was cut short by a reset voids the ones before it.
+static void snapshot_find(void)
+{
+    uint32_t const *       p_addr = m_snapshot_fs_config.p_start_addr;
+    uint32_t const * const p_end  = m_snapshot_fs_config.p_end_addr;
+
+    m_snapshot.p_entry = NULL;
+    m_snapshot.marked  = 0;
+
+    while ((p_addr + FDS_SNAPSHOT_SIZE <= p_end) && (*p_addr == FDS_SNAPSHOT_MAGIC))
+    {
+        fds_snapshot_head_t const * const p_head = (fds_snapshot_head_t*)p_addr;
+
+        m_snapshot.p_entry = snapshot_entry_valid(p_head) ? p_head : NULL;
+        p_addr += FDS_SNAPSHOT_SIZE;
+    }
+
+    // Anything but an erased word is not ours; the page is erased before the next entry.
+    m_snapshot.p_free = ((p_addr < p_end) && (*p_addr == FDS_ERASED_WORD)) ? p_addr : p_end;
+
+    if (m_snapshot.p_entry == NULL)
+    {
+        return;
+    }
+
+    m_latest_rec_id = m_snapshot.p_entry->latest_rec_id;
+    for (uint16_t i = 0; i < FDS_MAX_PAGES; i++)
+    {
+        if (*snapshot_word(FDS_SNAPSHOT_OFFSET_MARKS + i) != FDS_ERASED_WORD)
+        {
+            m_snapshot.marked |= (1UL << i);
+        }
+    }
+}
+
+
+// The page of the latest entry at the given address, or FDS_MAX_PAGES.
+static uint16_t snapshot_page_find(uint32_t const * const p_page_addr)
+{
+    for (uint16_t i = 0; (m_snapshot.p_entry != NULL) && (i < FDS_MAX_PAGES); i++)
+    {
+        if (m_snapshot.p_entry->page[i].p_addr == p_page_addr)
+        {
+            return i;
+        }
+    }
+
+    return FDS_MAX_PAGES;
+}
+
+
+// The page of the latest entry at the given address, if the page is as the entry describes it:
+// no record flagged as dirty and none written past its offset. FDS_MAX_PAGES otherwise.
+static uint16_t snapshot_page_get(uint32_t const * const p_page_addr)
+{
+    uint16_t const i = snapshot_page_find(p_page_addr);
+    uint16_t       offset;
+
+    if ((i == FDS_MAX_PAGES) || (m_snapshot.marked & (1UL << i)))
+    {
+        return FDS_MAX_PAGES;
+    }
+
+    offset = m_snapshot.p_entry->page[i].write_offset;
+    if ((offset < FDS_PAGE_TAG_SIZE) ||
+        (offset > FDS_PAGE_SIZE)     ||
+        ((offset < FDS_PAGE_SIZE) && (p_page_addr[offset] != FDS_ERASED_WORD)))
+    {
+        return FDS_MAX_PAGES;
+    }
+
+    return i;
+}
+
+
+// Set the write offset of a data page from the snapshot, instead of scanning the page.
+// Returns false if the page has to be scanned.
+static bool snapshot_page_restore(fds_page_t * const p_page)
+{
+    uint16_t const i = snapshot_page_get(p_page->p_addr);
+
+    if (i == FDS_MAX_PAGES)
+    {
+        return false;
+    }
+
+    p_page->write_offset = m_snapshot.p_entry->page[i].write_offset;
+    p_page->can_gc       = (m_snapshot.p_entry->page[i].can_gc != 0);
+
+    return true;
+}
+
+
+// Take the index from the snapshot, then add the records of the pages which were scanned.
+static void index_load(void)
+{
+    fds_index_slot_t const * p_slots;
+    uint16_t                 map[FDS_MAX_PAGES];    // From the pages of the entry to m_pages.
+    bool                     scan[FDS_MAX_PAGES];
+
+    if (m_snapshot.p_entry == NULL)
+    {
+        index_build();
+        return;
+    }
+
+    CRITICAL_SECTION_ENTER();
+    m_index.valid = false;
+    CRITICAL_SECTION_EXIT();
+
+    for (uint16_t i = 0; i < FDS_MAX_PAGES; i++)
+    {
+        map[i] = FDS_INDEX_SLOT_DELETED;
+    }
+
+    for (uint16_t page = 0; page < FDS_MAX_PAGES; page++)
+    {
+        uint16_t i = FDS_MAX_PAGES;
+
+        if (m_pages[page].page_type == FDS_PAGE_DATA)
+        {
+            i = snapshot_page_get(m_pages[page].p_addr);
+            if (i != FDS_MAX_PAGES)
+            {
+                map[i] = page;
+            }
+        }
+        scan[page] = (m_pages[page].page_type == FDS_PAGE_DATA) && (i == FDS_MAX_PAGES);
+    }
+
+    // Slots of the pages which are scanned again are freed, and their records put back below.
+    p_slots = (fds_index_slot_t const *)snapshot_word(FDS_SNAPSHOT_OFFSET_SLOTS);
+    for (uint16_t s = 0; s < FDS_INDEX_SIZE; s++)
+    {
+        m_index.slot[s] = p_slots[s];
+        if (p_slots[s].page < FDS_MAX_PAGES)
+        {
+            m_index.slot[s].page = map[p_slots[s].page];
+        }
+    }
+    m_index.used = m_snapshot.p_entry->index_used;
+
+    for (uint16_t page = 0; page < FDS_MAX_PAGES; page++)
+    {
+        uint32_t const * p_record = NULL;
+
+        while (scan[page] && record_find_next(page, &p_record))
+        {
+            if (m_index.used >= FDS_INDEX_LOAD_MAX)
+            {
+                index_build();
+                return;
+            }
+            index_put(page, p_record);
+        }
+    }
+
+    CRITICAL_SECTION_ENTER();
+    m_index.valid = true;
+    CRITICAL_SECTION_EXIT();
+}
+
+
+// Whether the latest entry still describes the pages: none marked and none written since.
+static bool snapshot_is_current(void)
+{
+    if ((m_snapshot.p_entry == NULL) || (m_snapshot.marked != 0))
+    {
+        return false;
+    }
+
+    for (uint16_t page = 0; page < FDS_MAX_PAGES; page++)
+    {
+        uint16_t i;
+
+        if (m_pages[page].page_type != FDS_PAGE_DATA)
+        {
+            continue;
+        }
+
+        i = snapshot_page_find(m_pages[page].p_addr);
+        if ((i == FDS_MAX_PAGES) ||
+            (m_snapshot.p_entry->page[i].write_offset != m_pages[page].write_offset))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// Mark the page of a record in the latest entry, before the record is flagged as dirty.
+// fstorage runs its queue in order, so the mark is in flash first.
+static ret_code_t snapshot_mark(uint32_t const * const p_record)
+{
+    for (uint16_t i = 0; (m_snapshot.p_entry != NULL) && (i < FDS_MAX_PAGES); i++)
+    {
+        uint32_t const * const p_addr = m_snapshot.p_entry->page[i].p_addr;
+
+        if ((p_addr == NULL) || (p_record <= p_addr) || (p_record >= p_addr + FDS_PAGE_SIZE))
         {
-            *p_record = p_next_rec;
-            return true;
+            continue;
         }
-        else
+
+        if (!(m_snapshot.marked & (1UL << i)))
         {
-            // The record is not valid, jump to the next.
-            p_next_rec += (FDS_HEADER_SIZE + (p_header->tl.length_words));
+            if (fs_store(&m_snapshot_fs_config, snapshot_word(FDS_SNAPSHOT_OFFSET_MARKS + i),
+                         &m_snapshot_zero, 1, NULL) != FS_SUCCESS)
+            {
+                return FDS_ERR_BUSY;
+            }
+            m_snapshot.marked |= (1UL << i);
         }
+        break;
     }
 
-    // No more valid records on this page.
-    return false;
+    return FDS_SUCCESS;
 }
 
 
-// Find a record given its descriptor and retrive the page in which the record is stored.
-// NOTE: Do not pass NULL as an argument for p_page.
-static bool record_find_by_desc(fds_record_desc_t * const p_desc, uint16_t * const p_page)
+// Drop the latest entry, before a page it describes is erased.
+static ret_code_t snapshot_drop(void)
 {
-    // If the gc_run_count field in the descriptor matches our counter, then the record has
-    // not been moved. If the address is valid, and the record ID matches, there is no need
-    // to find the record again. Only lookup the page in which the record is stored.
-
-    if ((address_is_valid(p_desc->p_record))     &&
-        (p_desc->gc_run_count == m_gc.run_count) &&
-        (p_desc->record_id    == ((fds_header_t*)p_desc->p_record)->record_id))
+    if (m_snapshot.p_entry == NULL)
     {
-        return (page_from_record(p_page, p_desc->p_record) == FDS_SUCCESS);
+        return FDS_SUCCESS;
     }
 
-    // Otherwise, find the record in flash.
-    for (*p_page = 0; *p_page < FDS_MAX_PAGES; (*p_page)++)
+    if (fs_store(&m_snapshot_fs_config, snapshot_word(FDS_SNAPSHOT_OFFSET_LIVE),
+                 &m_snapshot_zero, 1, NULL) != FS_SUCCESS)
     {
-        // Set p_record to NULL to make record_find_next() search from the beginning of the page.
-        uint32_t const * p_record = NULL;
-
-        while (record_find_next(*p_page, &p_record))
-        {
-            fds_header_t const * const p_header = (fds_header_t*)p_record;
-            if (p_header->record_id == p_desc->record_id)
-            {
-                p_desc->p_record     = p_record;
-                p_desc->gc_run_count = m_gc.run_count;
-                return true;
-            }
-        }
+        return FDS_ERR_BUSY;
     }
 
-    return false;
+    m_snapshot.p_entry = NULL;
+    m_snapshot.marked  = 0;
+
+    return FDS_SUCCESS;
 }
 
+#endif // FDS_INDEX_SNAPSHOT
+
 
 // Search for a record and return its descriptor.
 // If p_file_id is NULL, only the record key will be used for matching.
@@ -462,6 +1027,18 @@ static ret_code_t record_find(uint16_t          const * const p_file_id,
         return FDS_ERR_NULL_ARG;
     }
 
+#if (FDS_INDEX_SIZE != 0)
+    if (p_record_key != NULL)
+    {
+        ret_code_t ret;
+
+        if (index_find(p_file_id, *p_record_key, p_desc, p_token, &ret))
+        {
+            return ret;
+        }
+    }
+#endif
+
     // Begin (or resume) searching for a record.
     for (; p_token->page < FDS_MAX_PAGES; p_token->page++)
     {
@@ -531,6 +1108,17 @@ static void dirty_records_stat(uint16_t         page,
 }
 
 
+// Note that a record on the page given is about to be flagged as dirty. If GC stopped half-way
+// through that page, the copy of the record may already be in the swap.
+static void gc_page_changed(uint16_t page)
+{
+    if ((m_gc.state != GC_BEGIN) && (page == m_gc.cur_page))
+    {
+        m_gc.page_changed = true;
+    }
+}
+
+
 // Advances one position in the queue.
 // Returns true if the queue is not empty.
 static bool queue_advance(void)
@@ -629,6 +1217,125 @@ static bool op_enqueue(fds_op_t           const * const p_op,
 }
 
 
+#if (FDS_INDEX_SNAPSHOT != 0)
+
+// Queue a snapshot, unless the latest one is current or there is no index to save.
+static bool snapshot_enqueue(void)
+{
+    fds_op_t op;
+
+    if (snapshot_is_current() || !m_index.valid)
+    {
+        return false;
+    }
+
+    op.op_code   = FDS_OP_INDEX_SAVE;
+    op.save.step = FDS_OP_SAVE_BEGIN;
+
+    return op_enqueue(&op, 0, NULL);
+}
+
+
+static void snapshot_head_prepare(void)
+{
+    fds_snapshot_head_t * const p_head = &m_snapshot.head;
+
+    memset(p_head, 0x00, sizeof(fds_snapshot_head_t));
+
+    p_head->magic         = FDS_SNAPSHOT_MAGIC;
+    p_head->index_used    = m_index.used;
+    p_head->latest_rec_id = m_latest_rec_id;
+    p_head->p_swap        = m_swap_page.p_addr;
+
+    for (uint16_t i = 0; i < FDS_MAX_PAGES; i++)
+    {
+        if (m_pages[i].page_type == FDS_PAGE_DATA)
+        {
+            p_head->page[i].p_addr       = m_pages[i].p_addr;
+            p_head->page[i].write_offset = m_pages[i].write_offset;
+            p_head->page[i].can_gc       = m_pages[i].can_gc;
+        }
+    }
+
+    p_head->crc = snapshot_crc(p_head, m_index.slot);
+}
+
+
+// Write a snapshot entry. Operations run one at a time, so neither the pages nor the index
+// change while it is written from them.
+static ret_code_t index_save_execute(uint32_t prev_ret, fds_op_t * const p_op)
+{
+    fs_ret_t ret = FS_ERR_INTERNAL;
+
+    if (prev_ret != FS_SUCCESS)
+    {
+        return FDS_ERR_OPERATION_TIMEOUT;
+    }
+
+    switch (p_op->save.step)
+    {
+        case FDS_OP_SAVE_BEGIN:
+            if (snapshot_is_current())
+            {
+                return FDS_OP_COMPLETED;
+            }
+            if (!m_index.valid)
+            {
+                // GC is running, or there are more records than the index holds.
+                return FDS_ERR_BUSY;
+            }
+            if (m_snapshot.p_free + FDS_SNAPSHOT_SIZE > m_snapshot_fs_config.p_end_addr)
+            {
+                // The page is full. Drop the latest entry first, in case the erase fails.
+                if (snapshot_drop() != FDS_SUCCESS)
+                {
+                    return FDS_ERR_BUSY;
+                }
+                p_op->save.step = FDS_OP_SAVE_HEAD;
+                ret = fs_erase(&m_snapshot_fs_config, m_snapshot_fs_config.p_start_addr,
+                               FDS_PHY_PAGES_IN_VPAGE, &m_snapshot);
+                break;
+            }
+            // Fall through.
+
+        case FDS_OP_SAVE_HEAD:
+            if (m_snapshot.p_free + FDS_SNAPSHOT_SIZE > m_snapshot_fs_config.p_end_addr)
+            {
+                // The page has just been erased.
+                m_snapshot.p_free = m_snapshot_fs_config.p_start_addr;
+            }
+
+            // Whether or not the write gets through, the next entry goes after this one.
+            // Once the head is in flash, the entries before it no longer count.
+            snapshot_head_prepare();
+            m_snapshot.p_free += FDS_SNAPSHOT_SIZE;
+            p_op->save.step    = FDS_OP_SAVE_SLOTS;
+            ret = fs_store(&m_snapshot_fs_config, m_snapshot.p_free - FDS_SNAPSHOT_SIZE,
+                           (uint32_t*)&m_snapshot.head, FDS_SNAPSHOT_HEAD_SIZE, &m_snapshot);
+            break;
+
+        case FDS_OP_SAVE_SLOTS:
+            p_op->save.step = FDS_OP_SAVE_DONE;
+            ret = fs_store(&m_snapshot_fs_config,
+                           m_snapshot.p_free - FDS_SNAPSHOT_SIZE + FDS_SNAPSHOT_OFFSET_SLOTS,
+                           (uint32_t*)m_index.slot, FDS_INDEX_SIZE, &m_snapshot);
+            break;
+
+        case FDS_OP_SAVE_DONE:
+            m_snapshot.p_entry = (fds_snapshot_head_t*)(m_snapshot.p_free - FDS_SNAPSHOT_SIZE);
+            m_snapshot.marked  = 0;
+            return FDS_OP_COMPLETED;
+
+        default:
+            break;
+    }
+
+    return (ret == FS_SUCCESS) ? FDS_OP_EXECUTING : FDS_ERR_BUSY;
+}
+
+#endif // FDS_INDEX_SNAPSHOT
+
+
 // This function is called during initialization to setup the page structure (m_pages) and
 // provide additional information regarding eventual further initialization steps.
 static fds_init_opts_t pages_init()
@@ -681,6 +1388,15 @@ static fds_init_opts_t pages_init()
             case FDS_PAGE_DATA:
                 m_pages[page].page_type = FDS_PAGE_DATA;
                 m_pages[page].p_addr    = p_page_addr;
+#if (FDS_INDEX_SNAPSHOT != 0)
+                // Pages which did not change since the snapshot need not be scanned.
+                if (snapshot_page_restore(&m_pages[page]))
+                {
+                    ret |= PAGE_DATA;
+                    page++;
+                    break;
+                }
+#endif
                 // Scan the page to compute its write offset and determine whether or not the page
                 // can be garbage collected. Additionally, update the latest kwown record ID.
                 page_scan(p_page_addr, &m_pages[page].write_offset, &m_pages[page].can_gc);
@@ -765,6 +1481,13 @@ static ret_code_t record_header_write_finalize(fds_op_t * const p_op, uint32_t *
 
 static ret_code_t record_header_flag_dirty(uint32_t * const p_record)
 {
+#if (FDS_INDEX_SNAPSHOT != 0)
+    if (snapshot_mark(p_record) != FDS_SUCCESS)
+    {
+        return FDS_ERR_BUSY;
+    }
+#endif
+
     // Flag the record as dirty.
     fs_ret_t ret = fs_store(&fs_config, p_record,
                             (uint32_t*)&m_fds_tl_dirty, FDS_HEADER_SIZE_TL, NULL);
@@ -793,6 +1516,11 @@ static ret_code_t record_find_and_delete(fds_op_t * const p_op)
         p_op->del.file_id    = p_header->ic.file_id;
         p_op->del.record_key = p_header->tl.record_key;
 
+#if (FDS_INDEX_SIZE != 0)
+        index_remove(page, desc.p_record);
+#endif
+        gc_page_changed(page);
+
         // Flag the record as dirty.
         ret = record_header_flag_dirty((uint32_t*)desc.p_record);
 
@@ -823,6 +1551,10 @@ static ret_code_t file_find_and_delete(fds_op_t * const p_op)
 
     if (ret == FDS_SUCCESS)
     {
+#if (FDS_INDEX_SIZE != 0)
+        index_remove(tok.page, desc.p_record);
+#endif
+        gc_page_changed(tok.page);
          // A record was found: flag it as dirty.
         ret = record_header_flag_dirty((uint32_t*)desc.p_record);
 
@@ -889,14 +1621,44 @@ static bool crc_verify_success(uint16_t crc, uint16_t len_words, uint32_t const
     return (computed_crc == crc);
 }
 
+
+// Computes the CRC of a record from its header and its data chunks.
+static uint16_t record_crc(fds_header_t const * const p_header, fds_record_t const * const p_record)
+{
+    uint16_t crc;
+
+    // First, compute the CRC for the first 6 bytes of the header which contain the
+    // record key, length and file ID, then, compute the CRC of the record ID (4 bytes).
+    crc = crc16_compute((uint8_t*)p_header,             6, NULL);
+    crc = crc16_compute((uint8_t*)&p_header->record_id, 4, &crc);
+
+    for (uint32_t i = 0; i < p_record->data.num_chunks; i++)
+    {
+        // Compute the CRC for the record data.
+        crc = crc16_compute((uint8_t*)p_record->data.p_chunks[i].p_data,
+                            p_record->data.p_chunks[i].length_words * sizeof(uint32_t), &crc);
+    }
+
+    return crc;
+}
+
 #endif
 
 
 static void gc_init(void)
 {
+#if (FDS_INDEX_SIZE != 0)
+    // Records move while GC runs; search for them in flash until it is over.
+    CRITICAL_SECTION_ENTER();
+    m_index.valid = false;
+    CRITICAL_SECTION_EXIT();
+#endif
+
     m_gc.run_count++;
-    m_gc.cur_page = 0;
-    m_gc.resume   = false;
+    m_gc.cur_page       = 0;
+    m_gc.resume         = false;
+    m_gc.page_changed   = false;
+    m_gc.records_copied = 0;
 
     // Setup which pages to GC. Defer checking for open records and the can_gc flag,
     // as other operations might change those while GC is running.
@@ -952,6 +1714,13 @@ static ret_code_t gc_page_erase(void)
 
     if (m_pages[gc].records_open == 0)
     {
+#if (FDS_INDEX_SNAPSHOT != 0)
+        // The page may come back at the same address with other records on it.
+        if (snapshot_drop() != FDS_SUCCESS)
+        {
+            return FDS_ERR_BUSY;
+        }
+#endif
         ret = fs_erase(&fs_config, m_pages[gc].p_addr, FDS_PHY_PAGES_IN_VPAGE, NULL);
         m_gc.state = GC_ERASE_PAGE;
     }
@@ -1019,6 +1788,8 @@ static ret_code_t gc_tag_new_swap(void)
 
 static ret_code_t gc_next_page(void)
 {
+    m_gc.page_changed = false;
+
     if (!gc_page_next(&m_gc.cur_page))
     {
         // No pages left to GC; GC has terminated. Reset the state.
@@ -1026,6 +1797,13 @@ static ret_code_t gc_next_page(void)
         m_gc.cur_page     = 0;
         m_gc.p_record_src = NULL;
 
+#if (FDS_INDEX_SIZE != 0)
+        index_build();
+#endif
+#if (FDS_INDEX_SNAPSHOT != 0)
+        UNUSED_RETURN_VALUE(snapshot_enqueue());
+#endif
+
         return FDS_OP_COMPLETED;
     }
 
@@ -1070,6 +1848,7 @@ static void gc_state_advance(void)
         // A record was successfully copied.
         case GC_COPY_RECORD:
             gc_update_swap_offset();
+            m_gc.records_copied++;
             m_gc.state = GC_FIND_NEXT_RECORD;
             break;
 
@@ -1134,6 +1913,12 @@ static ret_code_t init_execute(uint32_t prev_ret, fds_op_t * const p_op)
             }
             if (!write_reqd)
             {
+#if (FDS_INDEX_SIZE != 0)
+                index_build();
+#endif
+#if (FDS_INDEX_SNAPSHOT != 0)
+                UNUSED_RETURN_VALUE(snapshot_enqueue());
+#endif
                 flag_set(FDS_FLAG_INITIALIZED);
                 flag_clear(FDS_FLAG_INITIALIZING);
                 return FDS_OP_COMPLETED;
@@ -1218,63 +2003,244 @@ static ret_code_t write_execute(uint32_t prev_ret, fds_op_t * const p_op)
             desc.p_record  = NULL;
             desc.record_id = p_op->write.record_to_delete;
 
-            if (!record_find_by_desc(&desc, &page))
+            if (!record_find_by_desc(&desc, &page))
+            {
+                return FDS_ERR_NOT_FOUND;
+            }
+            // Setting the step is redundant since we are falling through.
+        }
+        // Fallthrough to FDS_OP_WRITE_HEADER_BEGIN.
+
+        case FDS_OP_WRITE_HEADER_BEGIN:
+            ret = record_header_write_begin(p_op, p_write_addr);
+            break;
+
+        case FDS_OP_WRITE_RECORD_ID:
+            ret = record_header_write_id(p_op, p_write_addr);
+            break;
+
+        case FDS_OP_WRITE_CHUNKS:
+            ret = record_write_chunk(p_op, p_write_addr);
+            break;
+
+        case FDS_OP_WRITE_HEADER_FINALIZE:
+            ret = record_header_write_finalize(p_op, p_write_addr);
+            break;
+
+        case FDS_OP_WRITE_FLAG_DIRTY:
+            {
+                uint16_t page;
+
+#if (FDS_INDEX_SIZE != 0)
+                // The new copy is complete in flash; swap the copies in the index.
+                index_insert(p_op->write.page, p_write_addr);
+#endif
+                if (page_from_record(&page, desc.p_record) == FDS_SUCCESS)
+                {
+#if (FDS_INDEX_SIZE != 0)
+                    index_remove(page, desc.p_record);
+#endif
+                    gc_page_changed(page);
+                }
+            }
+            ret = record_header_flag_dirty((uint32_t*)desc.p_record);
+            p_op->write.step = FDS_OP_WRITE_DONE;
+            break;
+
+        case FDS_OP_WRITE_DONE:
+            ret = FDS_OP_COMPLETED;
+
+#if (FDS_INDEX_SIZE != 0)
+            if (p_op->op_code == FDS_OP_WRITE)
+            {
+                index_insert(p_op->write.page, p_write_addr);
+            }
+#endif
+
+#if defined(FDS_CRC_ENABLED)
+            if (flag_is_set(FDS_FLAG_VERIFY_CRC))
+            {
+                if (!crc_verify_success(p_op->write.header.ic.crc16,
+                                        p_op->write.header.tl.length_words,
+                                        p_write_addr))
+                {
+                    ret = FDS_ERR_CRC_CHECK_FAILED;
+                }
+            }
+#endif
+            break;
+
+        default:
+            ret = FDS_ERR_INTERNAL;
+            break;
+    }
+
+    // An operation has either completed or failed. It may have failed because fstorage
+    // ran out of memory, or because the user tried to delete a record which did not exist.
+    if (ret != FDS_OP_EXECUTING)
+    {
+        // There won't be another callback for this operation, so update the page offset now.
+        page_offsets_update(p_page, p_op->write.header.tl.length_words);
+    }
+
+    return ret;
+}
+
+
+// Move on to the next record of a batch. After the last record has been written,
+// start over from the first one to commit them, and after that, finish.
+static void batch_record_next(fds_op_t * const p_op)
+{
+    fds_record_t const * const p_record = &p_op->batch.p_records[p_op->batch.index];
+
+    p_op->batch.offset += FDS_HEADER_SIZE + record_length(p_record);
+    p_op->batch.index++;
+
+    if (p_op->batch.index == p_op->batch.count)
+    {
+        p_op->batch.index  = 0;
+        p_op->batch.offset = 0;
+        p_op->batch.step   = (p_op->batch.step == FDS_OP_BATCH_COMMIT) ? FDS_OP_BATCH_DONE :
+                                                                         FDS_OP_BATCH_COMMIT;
+    }
+    else if (p_op->batch.step != FDS_OP_BATCH_COMMIT)
+    {
+        p_op->batch.step = FDS_OP_BATCH_HEADER;
+    }
+}
+
+
+// Executes batch write operations.
+static ret_code_t batch_execute(uint32_t prev_ret, fds_op_t * const p_op)
+{
+    uint32_t                     ret;
+    fds_page_t           * const p_page   = &m_pages[p_op->batch.page];
+    fds_record_t const   *       p_record = &p_op->batch.p_records[p_op->batch.index];
+    uint32_t             *       p_addr;
+
+    if (prev_ret != FS_SUCCESS)
+    {
+        // The previous operation has timed out.
+        ret = FDS_ERR_OPERATION_TIMEOUT;
+    }
+    else
+    {
+        // Compute the address of the current record.
+        p_addr = (uint32_t*)(p_page->p_addr + p_page->write_offset + p_op->batch.offset);
+
+        switch (p_op->batch.step)
+        {
+            case FDS_OP_BATCH_HEADER:
+                // Leave the file ID and CRC erased, the record is not valid yet.
+                p_op->batch.header.tl.record_key   = p_record->key;
+                p_op->batch.header.tl.length_words = record_length(p_record);
+                p_op->batch.header.ic.file_id      = FDS_FILE_ID_INVALID;
+                p_op->batch.header.ic.crc16        = 0xFFFF;
+                p_op->batch.header.record_id       = p_op->batch.first_id + p_op->batch.index;
+
+                ret = fs_store(&fs_config, p_addr,
+                               (uint32_t*)&p_op->batch.header, FDS_HEADER_SIZE, NULL);
+                if (ret == FS_SUCCESS)
+                {
+                    p_op->batch.written = p_op->batch.offset + FDS_HEADER_SIZE +
+                                          p_op->batch.header.tl.length_words;
+                }
+
+                p_op->batch.chunk        = 0;
+                p_op->batch.chunk_offset = FDS_OFFSET_DATA;
+                if (p_record->data.num_chunks != 0)
+                {
+                    p_op->batch.step = FDS_OP_BATCH_CHUNKS;
+                }
+                else
+                {
+                    batch_record_next(p_op);
+                }
+                break;
+
+            case FDS_OP_BATCH_CHUNKS:
             {
-                return FDS_ERR_NOT_FOUND;
-            }
-            // Setting the step is redundant since we are falling through.
-        }
-        // Fallthrough to FDS_OP_WRITE_HEADER_BEGIN.
+                fds_record_chunk_t const * const p_chunk =
+                    &p_record->data.p_chunks[p_op->batch.chunk];
 
-        case FDS_OP_WRITE_HEADER_BEGIN:
-            ret = record_header_write_begin(p_op, p_write_addr);
-            break;
+                ret = fs_store(&fs_config, p_addr + p_op->batch.chunk_offset,
+                               p_chunk->p_data, p_chunk->length_words, NULL);
 
-        case FDS_OP_WRITE_RECORD_ID:
-            ret = record_header_write_id(p_op, p_write_addr);
+                p_op->batch.chunk_offset += p_chunk->length_words;
+                p_op->batch.chunk++;
+                if (p_op->batch.chunk == p_record->data.num_chunks)
+                {
+                    batch_record_next(p_op);
+                }
+            }
             break;
 
-        case FDS_OP_WRITE_CHUNKS:
-            ret = record_write_chunk(p_op, p_write_addr);
-            break;
+            case FDS_OP_BATCH_COMMIT:
+                // The whole header is rebuilt, the CRC covers the key and the record ID.
+                p_op->batch.header.tl.record_key   = p_record->key;
+                p_op->batch.header.tl.length_words = record_length(p_record);
+                p_op->batch.header.ic.file_id      = p_record->file_id;
+                p_op->batch.header.record_id       = p_op->batch.first_id + p_op->batch.index;
+                p_op->batch.header.ic.crc16        = 0;
+#if defined(FDS_CRC_ENABLED)
+                p_op->batch.header.ic.crc16        = record_crc(&p_op->batch.header, p_record);
+#endif
+                ret = fs_store(&fs_config, p_addr + FDS_OFFSET_IC,
+                               (uint32_t*)&p_op->batch.header.ic, FDS_HEADER_SIZE_IC, NULL);
 
-        case FDS_OP_WRITE_HEADER_FINALIZE:
-            ret = record_header_write_finalize(p_op, p_write_addr);
-            break;
+                batch_record_next(p_op);
+                break;
 
-        case FDS_OP_WRITE_FLAG_DIRTY:
-            ret = record_header_flag_dirty((uint32_t*)desc.p_record);
-            p_op->write.step = FDS_OP_WRITE_DONE;
-            break;
+            case FDS_OP_BATCH_DONE:
+                ret = FDS_OP_COMPLETED;
 
-        case FDS_OP_WRITE_DONE:
-            ret = FDS_OP_COMPLETED;
+                for (uint16_t i = 0; i < p_op->batch.count; i++)
+                {
+                    fds_header_t const * const p_header = (fds_header_t*)p_addr;
 
+#if (FDS_INDEX_SIZE != 0)
+                    index_insert(p_op->batch.page, p_addr);
+#endif
 #if defined(FDS_CRC_ENABLED)
-            if (flag_is_set(FDS_FLAG_VERIFY_CRC))
-            {
-                if (!crc_verify_success(p_op->write.header.ic.crc16,
-                                        p_op->write.header.tl.length_words,
-                                        p_write_addr))
-                {
-                    ret = FDS_ERR_CRC_CHECK_FAILED;
-                }
-            }
+                    if (flag_is_set(FDS_FLAG_VERIFY_CRC))
+                    {
+                        if (!crc_verify_success(p_header->ic.crc16,
+                                                p_header->tl.length_words,
+                                                p_addr))
+                        {
+                            ret = FDS_ERR_CRC_CHECK_FAILED;
+                        }
+                    }
 #endif
-            break;
+                    p_addr += FDS_HEADER_SIZE + p_header->tl.length_words;
+                }
+                break;
 
-        default:
-            ret = FDS_ERR_INTERNAL;
-            break;
+            default:
+                ret = FDS_ERR_INTERNAL;
+                break;
+        }
+
+        if (ret == FS_SUCCESS)
+        {
+            return FDS_OP_EXECUTING;
+        }
+        if (ret != FDS_OP_COMPLETED)
+        {
+            ret = (ret == FDS_ERR_CRC_CHECK_FAILED) ? FDS_ERR_CRC_CHECK_FAILED : FDS_ERR_BUSY;
+        }
     }
 
-    // An operation has either completed or failed. It may have failed because fstorage
-    // ran out of memory, or because the user tried to delete a record which did not exist.
-    if (ret != FDS_OP_EXECUTING)
+    // The operation has completed or failed. Keep the records with a header in flash, so that
+    // they can be skipped, and free the rest of the space.
+    if ((ret != FDS_OP_COMPLETED) && (p_op->batch.written != 0))
     {
-        // There won't be another callback for this operation, so update the page offset now.
-        page_offsets_update(p_page, p_op->write.header.tl.length_words);
+        p_page->can_gc = true;
     }
+    CRITICAL_SECTION_ENTER();
+    p_page->write_offset   += p_op->batch.written;
+    p_page->words_reserved -= p_op->batch.length_words;
+    CRITICAL_SECTION_EXIT();
 
     return ret;
 }
@@ -1323,6 +2289,8 @@ static ret_code_t gc_execute(uint32_t prev_ret)
 {
     ret_code_t ret;
 
+    m_gc.paused = false;
+
     if (prev_ret != FS_SUCCESS)
     {
         return FDS_ERR_OPERATION_TIMEOUT;
@@ -1337,6 +2305,26 @@ static ret_code_t gc_execute(uint32_t prev_ret)
         gc_state_advance();
     }
 
+    if (m_gc.page_changed &&
+        ((m_gc.state == GC_FIND_NEXT_RECORD) || (m_gc.state == GC_COPY_RECORD)))
+    {
+        // The swap may hold copies of records deleted while GC was paused.
+        // Discard it and leave this page for the next run.
+        m_gc.page_changed = false;
+        return gc_swap_erase();
+    }
+
+    if ((m_gc.state == GC_FIND_NEXT_RECORD) || (m_gc.state == GC_NEXT_PAGE))
+    {
+        // Stop between two records, and let the other operations in the queue run.
+        if (m_gc.hold ||
+            ((FDS_GC_STEP_RECORDS != 0) && (m_gc.records_copied >= FDS_GC_STEP_RECORDS)))
+        {
+            m_gc.records_copied = 0;
+            return FDS_OP_PAUSED;
+        }
+    }
+
     switch (m_gc.state)
     {
         case GC_NEXT_PAGE:
@@ -1374,6 +2362,61 @@ static ret_code_t gc_execute(uint32_t prev_ret)
 }
 
 
+static bool gc_enqueue(void)
+{
+    fds_op_t op;
+
+    op.op_code = FDS_OP_GC;
+
+    if (!op_enqueue(&op, 0, NULL))
+    {
+        return false;
+    }
+
+    m_gc.queued = true;
+    return true;
+}
+
+
+// Queue the rest of a GC which paused, unless it is on hold or already queued.
+static bool gc_continue(void)
+{
+    if (m_gc.paused && !m_gc.hold && !m_gc.queued)
+    {
+        return gc_enqueue();
+    }
+
+    return false;
+}
+
+
+#if (FDS_GC_AUTO_WORDS != 0)
+
+// Start GC when deleted records take up FDS_GC_AUTO_WORDS words, as fds_stat() counts them.
+static void gc_auto(void)
+{
+    uint16_t dirty_records = 0;
+    uint16_t freeable      = 0;
+
+    if (m_gc.hold || m_gc.queued || (m_gc.state != GC_BEGIN))
+    {
+        return;
+    }
+
+    for (uint16_t i = 0; i < FDS_MAX_PAGES; i++)
+    {
+        dirty_records_stat(i, &dirty_records, &freeable);
+    }
+
+    if (freeable >= FDS_GC_AUTO_WORDS)
+    {
+        UNUSED_RETURN_VALUE(gc_enqueue());
+    }
+}
+
+#endif
+
+
 static void queue_process(fs_ret_t result)
 {
     ret_code_t         ret;
@@ -1399,15 +2442,40 @@ static void queue_process(fs_ret_t result)
             ret = gc_execute(result);
             break;
 
+        case FDS_OP_WRITE_BATCH:
+            ret = batch_execute(result, p_op);
+            break;
+
+#if (FDS_INDEX_SNAPSHOT != 0)
+        case FDS_OP_INDEX_SAVE:
+            ret = index_save_execute(result, p_op);
+            break;
+#endif
+
         default:
             ret = FDS_ERR_INTERNAL;
             break;
     }
 
-    if (ret != FDS_OP_EXECUTING)
+    if (ret == FDS_OP_PAUSED)
+    {
+        // GC is not over yet: run the step it stopped at from the back of the queue, or
+        // after fds_gc_hold() if it is on hold. The event is sent when GC is over.
+        m_gc.queued = false;
+        m_gc.resume = true;
+        m_gc.paused = true;
+    }
+    else if (ret != FDS_OP_EXECUTING)
     {
         fds_evt_t evt;
 
+        if (p_op->op_code == FDS_OP_GC)
+        {
+            // After an error, the step which failed is retried by the next fds_gc().
+            m_gc.queued = false;
+            m_gc.resume = (m_gc.state != GC_BEGIN);
+        }
+
         if (ret == FDS_OP_COMPLETED)
         {
             evt.result = FDS_SUCCESS;
@@ -1425,6 +2493,21 @@ static void queue_process(fs_ret_t result)
         event_prepare(p_op, &evt);
         event_send(&evt);
 
+#if (FDS_GC_AUTO_WORDS != 0)
+        if ((p_op->op_code == FDS_OP_UPDATE)     ||
+            (p_op->op_code == FDS_OP_DEL_RECORD) ||
+            (p_op->op_code == FDS_OP_DEL_FILE))
+        {
+            gc_auto();
+        }
+#endif
+    }
+
+    if (ret != FDS_OP_EXECUTING)
+    {
+        // Also covers a GC that could not be queued again when it paused on a full queue.
+        UNUSED_RETURN_VALUE(gc_continue());
+
         // Advance the queue, and if there are any queued operations, process them.
         if (queue_advance())
         {
@@ -1456,6 +2539,20 @@ static void fs_event_handler(fs_evt_t const * const p_evt, fs_ret_t result)
 }
 
 
+#if (FDS_INDEX_SNAPSHOT != 0)
+
+static void snapshot_fs_event_handler(fs_evt_t const * const p_evt, fs_ret_t result)
+{
+    // Marks and drops are written without a context, outside of the queue.
+    if (p_evt->p_context != NULL)
+    {
+        queue_process(result);
+    }
+}
+
+#endif
+
+
 // Enqueues write and update operations.
 static ret_code_t write_enqueue(fds_record_desc_t         * const p_desc,
                                 fds_record_t        const * const p_record,
@@ -1534,17 +2631,7 @@ static ret_code_t write_enqueue(fds_record_desc_t         * const p_desc,
     }
 
 #if defined (FDS_CRC_ENABLED)
-    // First, compute the CRC for the first 6 bytes of the header which contain the
-    // record key, length and file ID, then, compute the CRC of the record ID (4 bytes).
-    crc = crc16_compute((uint8_t*)&op.write.header,           6, NULL);
-    crc = crc16_compute((uint8_t*)&op.write.header.record_id, 4, &crc);
-
-    for (uint32_t i = 0; i < p_record->data.num_chunks; i++)
-    {
-        // Compute the CRC for the record data.
-        crc = crc16_compute((uint8_t*)p_record->data.p_chunks[i].p_data,
-                            p_record->data.p_chunks[i].length_words * sizeof(uint32_t), &crc);
-    }
+    crc = record_crc(&op.write.header, p_record);
 #endif
 
     op.write.header.ic.crc16 = crc;
@@ -1619,6 +2706,10 @@ ret_code_t fds_init(void)
 
     (void)fs_init();
 
+#if (FDS_INDEX_SNAPSHOT != 0)
+    snapshot_find();
+#endif
+
     // Initialize the page structure (m_pages), and determine which
     // initialization steps are required given the current state of the filesystem.
     fds_init_opts_t init_opts = pages_init();
@@ -1631,10 +2722,23 @@ ret_code_t fds_init(void)
     if (init_opts == ALREADY_INSTALLED)
     {
         // No initialization is necessary. Notify the application immediately.
+#if (FDS_INDEX_SNAPSHOT != 0)
+        index_load();
+#elif (FDS_INDEX_SIZE != 0)
+        index_build();
+#endif
         flag_set(FDS_FLAG_INITIALIZED);
         flag_clear(FDS_FLAG_INITIALIZING);
 
         event_send(&evt_success);
+
+#if (FDS_INDEX_SNAPSHOT != 0)
+        // Save what was scanned, so that the next boot does not have to.
+        if (snapshot_enqueue())
+        {
+            queue_start();
+        }
+#endif
         return FDS_SUCCESS;
     }
 
@@ -1862,6 +2966,100 @@ ret_code_t fds_record_update(fds_record_desc_t       * const p_desc,
 }
 
 
+ret_code_t fds_record_write_batch(fds_record_desc_t       * const p_descs,
+                                  fds_record_t      const * const p_records,
+                                  uint16_t                        count)
+{
+    ret_code_t ret;
+    fds_op_t   op;
+    uint16_t   page;
+    uint32_t   length_words = 0;
+
+    if (!flag_is_set(FDS_FLAG_INITIALIZED))
+    {
+        return FDS_ERR_NOT_INITIALIZED;
+    }
+
+    if ((p_records == NULL) || (count == 0))
+    {
+        return FDS_ERR_NULL_ARG;
+    }
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if ((p_records[i].file_id == FDS_FILE_ID_INVALID) ||
+            (p_records[i].key     == FDS_RECORD_KEY_DIRTY))
+        {
+            return FDS_ERR_INVALID_ARG;
+        }
+
+        if (!chunk_is_aligned(p_records[i].data.p_chunks,
+                              p_records[i].data.num_chunks))
+        {
+            return FDS_ERR_UNALIGNED_ADDR;
+        }
+
+        length_words += FDS_HEADER_SIZE + record_length(&p_records[i]);
+    }
+
+    if (length_words >= FDS_PAGE_SIZE - FDS_PAGE_TAG_SIZE)
+    {
+        return FDS_ERR_RECORD_TOO_LARGE;
+    }
+
+    // Reserve space for all records at once; write_space_reserve() adds one header itself.
+    ret = write_space_reserve(length_words - FDS_HEADER_SIZE, &page);
+
+    if (ret != FDS_SUCCESS)
+    {
+        return ret;
+    }
+
+    // Initialize the operation.
+    op.op_code            = FDS_OP_WRITE_BATCH;
+    op.batch.step         = FDS_OP_BATCH_HEADER;
+    op.batch.p_records    = p_records;
+    op.batch.page         = page;
+    op.batch.length_words = length_words;
+    op.batch.offset       = 0;
+    op.batch.written      = 0;
+    op.batch.count        = count;
+    op.batch.index        = 0;
+
+    // The records get consecutive IDs.
+    CRITICAL_SECTION_ENTER();
+    op.batch.first_id  = m_latest_rec_id + 1;
+    m_latest_rec_id   += count;
+    CRITICAL_SECTION_EXIT();
+
+    if (!op_enqueue(&op, 0, NULL))
+    {
+        // No space available in the queue. Cancel the reservation of flash space.
+        CRITICAL_SECTION_ENTER();
+        write_space_free(length_words - FDS_HEADER_SIZE, page);
+        CRITICAL_SECTION_EXIT();
+
+        return FDS_ERR_NO_SPACE_IN_QUEUES;
+    }
+
+    if (p_descs != NULL)
+    {
+        for (uint16_t i = 0; i < count; i++)
+        {
+            p_descs[i].p_record       = NULL;
+            p_descs[i].record_id      = op.batch.first_id + i;
+            p_descs[i].record_is_open = false;
+            p_descs[i].gc_run_count   = m_gc.run_count;
+        }
+    }
+
+    // Start processing the queue, if necessary.
+    queue_start();
+
+    return FDS_SUCCESS;
+}
+
+
 ret_code_t fds_record_delete(fds_record_desc_t * const p_desc)
 {
     fds_op_t op;
@@ -1919,6 +3117,48 @@ ret_code_t fds_file_delete(uint16_t file_id)
 
 
 ret_code_t fds_gc(void)
+{
+    if (!flag_is_set(FDS_FLAG_INITIALIZED))
+    {
+        return FDS_ERR_NOT_INITIALIZED;
+    }
+
+    if (gc_enqueue())
+    {
+        queue_start();
+        return FDS_SUCCESS;
+    }
+
+    return FDS_ERR_NO_SPACE_IN_QUEUES;
+}
+
+
+ret_code_t fds_gc_hold(bool hold)
+{
+    bool resume;
+
+    if (!flag_is_set(FDS_FLAG_INITIALIZED))
+    {
+        return FDS_ERR_NOT_INITIALIZED;
+    }
+
+    CRITICAL_SECTION_ENTER();
+    m_gc.hold = hold;
+    resume    = gc_continue();
+    CRITICAL_SECTION_EXIT();
+
+    if (resume)
+    {
+        queue_start();
+    }
+
+    return FDS_SUCCESS;
+}
+
+
+#if (FDS_INDEX_SNAPSHOT != 0)
+
+ret_code_t fds_index_save(void)
 {
     fds_op_t op;
 
@@ -1927,16 +3167,11 @@ ret_code_t fds_gc(void)
         return FDS_ERR_NOT_INITIALIZED;
     }
 
-    op.op_code = FDS_OP_GC;
+    op.op_code   = FDS_OP_INDEX_SAVE;
+    op.save.step = FDS_OP_SAVE_BEGIN;
 
     if (op_enqueue(&op, 0, NULL))
     {
-        if (m_gc.state != GC_BEGIN)
-        {
-            // Resume GC by retrying the last step.
-            m_gc.resume = true;
-        }
-
         queue_start();
         return FDS_SUCCESS;
     }
@@ -1944,6 +3179,8 @@ ret_code_t fds_gc(void)
     return FDS_ERR_NO_SPACE_IN_QUEUES;
 }
 
+#endif
+
 
 ret_code_t fds_record_iterate(fds_record_desc_t * const p_desc,
                               fds_find_token_t  * const p_token)
@@ -200,7 +200,9 @@ typedef enum
     FDS_EVT_UPDATE,     //!< Event for @ref fds_record_update.
     FDS_EVT_DEL_RECORD, //!< Event for @ref fds_record_delete.
     FDS_EVT_DEL_FILE,   //!< Event for @ref fds_file_delete.
-    FDS_EVT_GC          //!< Event for @ref fds_gc.
+    FDS_EVT_GC,         //!< Event for @ref fds_gc.
+    FDS_EVT_WRITE_BATCH,//!< Event for @ref fds_record_write_batch.
+    FDS_EVT_INDEX_SAVE  //!< Event for @ref fds_index_save, and for the snapshots FDS saves itself.
 } fds_evt_id_t;
 
 
@@ -239,6 +241,11 @@ typedef struct
             uint16_t pages_skipped;
             uint16_t space_reclaimed;
         } gc;
+        struct
+        {
+            uint32_t first_record_id;   //!< IDs of the records follow on from this one.
+            uint16_t count;             //!< Number of records in the batch.
+        } batch; //!< Information for @ref FDS_EVT_WRITE_BATCH events.
     };
 } fds_evt_t;
 
@@ -505,6 +512,40 @@ ret_code_t fds_record_update(fds_record_desc_t       * const p_desc,
                              fds_record_t      const * const p_record);
 
 
+/**@brief   Function for writing several records at once.
+ *
+ * Space for all records is reserved on one virtual page and the records are written back to
+ * back as a single operation. Each record is first written without its file ID; the file IDs,
+ * which make the records valid, are written last, one after the other, once all the data is
+ * in flash. If the operation fails before then, none of the records is valid. A power loss
+ * while the file IDs are written can still leave only the first records of the batch valid.
+ *
+ * The records follow the rules of @ref fds_record_write. The records and their chunks are not
+ * buffered internally: @p p_records, the chunks and the data must be kept in memory until the
+ * @ref FDS_EVT_WRITE_BATCH event has been received. They do not use the chunk queue.
+ *
+ * This function is asynchronous. Completion is reported through a single event that is sent
+ * to the registered event handler function.
+ *
+ * @param[out]  p_descs     Array of @p count descriptors of the records written. Pass NULL if
+ *                          you do not need the descriptors.
+ * @param[in]   p_records   Array of @p count records to be written to flash.
+ * @param[in]   count       Number of records.
+ *
+ * @retval  FDS_SUCCESS                 If the operation was queued successfully.
+ * @retval  FDS_ERR_NOT_INITIALIZED     If the module is not initialized.
+ * @retval  FDS_ERR_NULL_ARG            If @p p_records is NULL or @p count is zero.
+ * @retval  FDS_ERR_INVALID_ARG         If a file ID or a record key is invalid.
+ * @retval  FDS_ERR_UNALIGNED_ADDR      If record data is not aligned to a 4 byte boundary.
+ * @retval  FDS_ERR_RECORD_TOO_LARGE    If the records do not fit together in a virtual page.
+ * @retval  FDS_ERR_NO_SPACE_IN_QUEUES  If the operation queue is full.
+ * @retval  FDS_ERR_NO_SPACE_IN_FLASH   If there is not enough free space on any virtual page.
+ */
+ret_code_t fds_record_write_batch(fds_record_desc_t       * const p_descs,
+                                  fds_record_t      const * const p_records,
+                                  uint16_t                        count);
+
+
 /**@brief   Function for iterating through all records in flash.
  *
  * To search for the next record, call the function again and supply the same @ref fds_find_token_t
@@ -641,6 +682,13 @@ ret_code_t fds_record_close(fds_record_desc_t * const p_desc);
  * This function is asynchronous. Completion is reported through an event that is sent to the
  * registered event handler function.
  *
+ * If FDS_GC_STEP_RECORDS is not zero, garbage collection copies at most that many records
+ * at a time, then goes to the back of the queue so that the operations queued meanwhile
+ * run first. The event is sent once, when garbage collection is over.
+ *
+ * If FDS_GC_AUTO_WORDS is not zero, garbage collection also starts by itself after an update
+ * or a delete leaves that many freeable words (see @ref fds_stat_t::freeable_words).
+ *
  * @retval  FDS_SUCCESS                 If the operation was queued successfully.
  * @retval  FDS_ERR_NOT_INITIALIZED     If the module is not initialized.
  * @retval  FDS_ERR_NO_SPACE_IN_QUEUES  If the operation queue is full.
@@ -648,6 +696,40 @@ ret_code_t fds_record_close(fds_record_desc_t * const p_desc);
 ret_code_t fds_gc(void);
 
 
+/**@brief   Function for pausing and resuming garbage collection.
+ *
+ * While on hold, garbage collection stops at the next record it would copy and does not
+ * start by itself. A call to @ref fds_gc while on hold is queued, but waits for the hold to
+ * end like the garbage collection already running. Holds do not nest.
+ *
+ * @param[in]   hold    True to pause garbage collection, false to let it run again.
+ *
+ * @retval  FDS_SUCCESS                 If the hold was set or cleared.
+ * @retval  FDS_ERR_NOT_INITIALIZED     If the module is not initialized.
+ */
+ret_code_t fds_gc_hold(bool hold);
+
+
+/**@brief   Function for saving a snapshot of the pages and the record index to flash.
+ *
+ * Only available if FDS_INDEX_SNAPSHOT is enabled. With a snapshot, @ref fds_init takes the
+ * write offsets of the pages and the index from flash, and only scans the pages which changed
+ * since: a record was written to them, or flagged as dirty. FDS saves a snapshot itself after
+ * garbage collection, and after an @ref fds_init which had to scan pages; this function saves
+ * one at any other point, for example before a long sleep.
+ *
+ * This function is asynchronous. Completion is reported through an event that is sent to the
+ * registered event handler function. Nothing is written if the latest snapshot is current.
+ * The result is FDS_ERR_BUSY if garbage collection is running or the index is full, since the
+ * index is then not in use.
+ *
+ * @retval  FDS_SUCCESS                 If the operation was queued successfully.
+ * @retval  FDS_ERR_NOT_INITIALIZED     If the module is not initialized.
+ * @retval  FDS_ERR_NO_SPACE_IN_QUEUES  If the operation queue is full.
+ */
+ret_code_t fds_index_save(void);
+
+
 /**@brief   Function for obtaining a descriptor from a record ID.
  *
  * This function can be used to reconstruct a descriptor from a record ID, like the one that is
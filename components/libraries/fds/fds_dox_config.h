@@ -66,6 +66,55 @@
  */
 #define FDS_VIRTUAL_PAGE_SIZE
 
+/** @brief Number of slots of the RAM index of record keys.
+ *
+ * With the index, records are looked up by key in RAM instead of in flash.
+ * Each slot takes 4 bytes. The index holds up to 3/4 of its slots; while there
+ * are more records, or while garbage collection runs, records are searched for
+ * in flash. Must be 0 (no index) or a power of two.
+ *
+ * @note This is an NRF_CONFIG macro.
+ */
+#define FDS_INDEX_SIZE
+
+/** @brief Number of records garbage collection copies at a time.
+ *
+ * After copying this many records, garbage collection lets the operations
+ * queued meanwhile run before it carries on. Set to 0 to run it in one go.
+ *
+ * @note This is an NRF_CONFIG macro.
+ */
+#define FDS_GC_STEP_RECORDS
+
+/** @brief Freeable words at which garbage collection starts by itself.
+ *
+ * Checked after each update and delete. Set to 0 to run garbage collection
+ * only through fds_gc.
+ *
+ * @note This is an NRF_CONFIG macro.
+ */
+#define FDS_GC_AUTO_WORDS
+
+/** @brief Keep a snapshot of the pages and the record index in flash.
+ *
+ * With the snapshot, fds_init only scans the pages which changed since it was
+ * saved, and takes the index of the others from flash. Snapshots are saved
+ * after garbage collection, after an fds_init which had to scan pages, and by
+ * fds_index_save. Requires FDS_INDEX_SIZE and CRC16, and one more virtual page
+ * of flash.
+ *
+ * @note This is an NRF_CONFIG macro.
+ */
+#define FDS_INDEX_SNAPSHOT
+
+/** @brief fstorage priority of the snapshot page.
+ *
+ * Must be unique among the fstorage users.
+ *
+ * @note This is an NRF_CONFIG macro.
+ */
+#define FDS_INDEX_SNAPSHOT_FS_PRIORITY
+
 
 
 /** @} */
@@ -48,6 +48,7 @@ extern "C" {
 
 #define FDS_OP_EXECUTING        (FS_SUCCESS)
 #define FDS_OP_COMPLETED        (0x1D1D)
+#define FDS_OP_PAUSED           (0x1D1E)    // GC stopped between two records.
 
 // The size of a physical page, in 4-byte words.
 #if     defined(NRF51)
@@ -77,6 +78,43 @@ extern "C" {
     #error "FDS requires at least two virtual pages."
 #endif
 
+// The number of slots of the record key index. Zero disables the index.
+#ifndef FDS_INDEX_SIZE
+    #define FDS_INDEX_SIZE          (0)
+#endif
+
+#if (FDS_INDEX_SIZE != 0) && ((FDS_INDEX_SIZE & (FDS_INDEX_SIZE - 1)) != 0)
+    #error "FDS_INDEX_SIZE must be zero or a power of two."
+#endif
+
+// The number of records GC copies before it lets other operations run. Zero runs GC in one go.
+#ifndef FDS_GC_STEP_RECORDS
+    #define FDS_GC_STEP_RECORDS     (0)
+#endif
+
+// The number of freeable words at which GC starts by itself. Zero disables automatic GC.
+#ifndef FDS_GC_AUTO_WORDS
+    #define FDS_GC_AUTO_WORDS       (0)
+#endif
+
+// Whether a snapshot of the pages and the index is kept in flash, so that fds_init() does not
+// have to scan the pages which did not change since.
+#ifndef FDS_INDEX_SNAPSHOT
+    #define FDS_INDEX_SNAPSHOT      (0)
+#endif
+
+#ifndef FDS_INDEX_SNAPSHOT_FS_PRIORITY
+    #define FDS_INDEX_SNAPSHOT_FS_PRIORITY  (0xFD)
+#endif
+
+#if (FDS_INDEX_SNAPSHOT != 0) && (FDS_INDEX_SIZE == 0)
+    #error "FDS_INDEX_SNAPSHOT requires the index (FDS_INDEX_SIZE)."
+#endif
+
+#if (FDS_INDEX_SNAPSHOT != 0) && (FDS_MAX_PAGES > 32)
+    #error "FDS_INDEX_SNAPSHOT supports up to 32 data pages (FDS_VIRTUAL_PAGES - 1)."
+#endif
+
 
 // FDS internal status flags.
 typedef enum
@@ -125,7 +163,9 @@ typedef enum
     FDS_OP_UPDATE,      // Update a record.
     FDS_OP_DEL_RECORD,  // Delete a record.
     FDS_OP_DEL_FILE,    // Delete a file.
-    FDS_OP_GC           // Run garbage collection.
+    FDS_OP_GC,          // Run garbage collection.
+    FDS_OP_WRITE_BATCH, // Write several records, which become valid together.
+    FDS_OP_INDEX_SAVE   // Write a snapshot of the pages and the index.
 } fds_op_code_t;
 
 
@@ -150,6 +190,24 @@ typedef enum
 } fds_write_step_t;
 
 
+typedef enum
+{
+    FDS_OP_BATCH_HEADER,            // Write the header of a record, without the file ID and CRC.
+    FDS_OP_BATCH_CHUNKS,            // Write the data of a record.
+    FDS_OP_BATCH_COMMIT,            // Write the file ID and CRC of a record.
+    FDS_OP_BATCH_DONE,
+} fds_batch_step_t;
+
+
+typedef enum
+{
+    FDS_OP_SAVE_BEGIN,              // Erase the snapshot page if the entry does not fit.
+    FDS_OP_SAVE_HEAD,               // Write the head of the entry.
+    FDS_OP_SAVE_SLOTS,              // Write the index slots.
+    FDS_OP_SAVE_DONE,
+} fds_save_step_t;
+
+
 typedef enum
 {
     FDS_OP_DEL_RECORD_FLAG_DIRTY,   // Flag a record as dirty.
@@ -192,6 +250,25 @@ typedef struct
             uint16_t          record_key;
             uint32_t          record_to_delete;
         } del;
+        struct
+        {
+            fds_header_t         header;        // Header of the record being written or committed.
+            fds_record_t const * p_records;     // The records, kept by the caller until the event.
+            uint32_t             first_id;      // The record ID of the first record.
+            uint16_t             page;          // The page the flash space was reserved on.
+            uint16_t             length_words;  // The space reserved, headers included.
+            uint16_t             offset;        // Offset of the current record from the first one.
+            uint16_t             written;       // Words with a header written to flash.
+            uint16_t             count;         // Number of records.
+            uint16_t             index;         // The current record.
+            uint16_t             chunk_offset;  // Offset used for writing record chunks.
+            uint8_t              chunk;         // The next chunk of the current record.
+            fds_batch_step_t     step;          // The current step the operation is at.
+        } batch;
+        struct
+        {
+            fds_save_step_t step;               // The current step the operation is at.
+        } save;
     };
 } fds_op_t;
 
@@ -288,9 +365,86 @@ typedef struct
     uint16_t         run_count;                 // Total number of times GC was run.
     bool             do_gc_page[FDS_MAX_PAGES]; // Controls which pages to garbage collect.
     bool             resume;                    // Whether or not GC should be resumed.
+    bool             page_changed;              // A record on cur_page was deleted while GC was paused.
+    bool             hold;                      // Do not run GC steps, see fds_gc_hold().
+    bool             paused;                    // GC stopped between two records.
+    bool             queued;                    // A GC operation is in the queue.
+    uint16_t         records_copied;            // Records copied since GC last paused.
 } fds_gc_data_t;
 
 
+#if (FDS_INDEX_SIZE != 0)
+
+// Index slot values which are not a page number.
+#define FDS_INDEX_SLOT_EMPTY        (0xFFFF)    // Never used, ends a lookup.
+#define FDS_INDEX_SLOT_DELETED      (0xFFFE)    // Freed; lookups have to probe past it.
+
+// The index is filled up to 3/4, so that lookups always hit an empty slot.
+#define FDS_INDEX_LOAD_MAX          (FDS_INDEX_SIZE - FDS_INDEX_SIZE / 4)
+
+// Location of a valid record, in the page order used when searching for records.
+typedef struct
+{
+    uint16_t page;                              // Index in m_pages, or a FDS_INDEX_SLOT_ value.
+    uint16_t offset;                            // Offset of the record header in the page, in words.
+} fds_index_slot_t;
+
+
+// Open addressing hash table from record key to record location.
+typedef struct
+{
+    fds_index_slot_t slot[FDS_INDEX_SIZE];
+    uint16_t         used;                      // Slots which are not empty, deleted ones included.
+    bool             valid;                     // If false, records are searched for in flash.
+} fds_index_t;
+
+#endif // FDS_INDEX_SIZE
+
+
+#if (FDS_INDEX_SNAPSHOT != 0)
+
+// Snapshot entries follow each other in the snapshot page, and only the last one counts:
+// a head, the index slots, a word which stays erased while the entry holds, and a word for
+// each page, written when a record on that page is flagged as dirty after the snapshot.
+#define FDS_SNAPSHOT_MAGIC          (0xF11E5A5E)
+
+#define FDS_SNAPSHOT_HEAD_SIZE      (sizeof(fds_snapshot_head_t) / sizeof(uint32_t))
+#define FDS_SNAPSHOT_OFFSET_SLOTS   (FDS_SNAPSHOT_HEAD_SIZE)
+#define FDS_SNAPSHOT_OFFSET_LIVE    (FDS_SNAPSHOT_OFFSET_SLOTS + FDS_INDEX_SIZE)
+#define FDS_SNAPSHOT_OFFSET_MARKS   (FDS_SNAPSHOT_OFFSET_LIVE + 1)
+#define FDS_SNAPSHOT_SIZE           (FDS_SNAPSHOT_OFFSET_MARKS + FDS_MAX_PAGES)
+
+// A data page, as it was when the snapshot was taken.
+typedef struct
+{
+    uint32_t const * p_addr;                    // NULL if the page was not a data page.
+    uint16_t         write_offset;
+    uint16_t         can_gc;
+} fds_snapshot_page_t;
+
+
+typedef struct
+{
+    uint32_t            magic;
+    uint16_t            crc;                    // CRC16 of the rest of the head and of the slots.
+    uint16_t            index_used;
+    uint32_t            latest_rec_id;
+    uint32_t    const * p_swap;
+    fds_snapshot_page_t page[FDS_MAX_PAGES];    // In the order of m_pages; index slots refer to it.
+} fds_snapshot_head_t;
+
+
+typedef struct
+{
+    fds_snapshot_head_t const * p_entry;        // The entry in flash, NULL if none holds.
+    uint32_t            const * p_free;         // Where the next entry goes.
+    uint32_t                    marked;         // Pages marked in p_entry, one bit each.
+    fds_snapshot_head_t         head;           // Source of the head being written.
+} fds_snapshot_t;
+
+#endif // FDS_INDEX_SNAPSHOT
+
+
 // Macros to enable and disable application interrupts.
 #if defined (FDS_THREADS)
 
@@ -144,6 +144,61 @@ uint32_t app_fifo_read(app_fifo_t * p_fifo, uint8_t * p_byte_array, uint32_t * p
  */
 uint32_t app_fifo_write(app_fifo_t * p_fifo, uint8_t const * p_byte_array, uint32_t * p_size);
 
+/**@brief Function for getting the contiguous span of bytes that can be read from the FIFO.
+ *
+ * The span starts at the read position and ends at the write position or at the end of the
+ * buffer, whichever comes first; a FIFO that wraps around gives the rest with the next span.
+ * The bytes can be read, or handed to EasyDMA, in place. The read position is only moved by
+ * @ref app_fifo_read_span_release.
+ *
+ * @param[in]  p_fifo   Pointer to the FIFO. Must not be NULL.
+ * @param[out] pp_data  Start of the span in the FIFO buffer.
+ * @param[out] p_size   Number of bytes in the span, 0 if the FIFO is empty.
+ *
+ * @retval     NRF_SUCCESS          If the span holds at least one byte.
+ * @retval     NRF_ERROR_NULL       If a NULL parameter was passed.
+ * @retval     NRF_ERROR_NOT_FOUND  If the FIFO is empty.
+ */
+uint32_t app_fifo_read_span_get(app_fifo_t * p_fifo, uint8_t ** pp_data, uint32_t * p_size);
+
+/**@brief Function for consuming bytes read in place from a span.
+ *
+ * @param[in]  p_fifo   Pointer to the FIFO. Must not be NULL.
+ * @param[in]  size     Number of bytes consumed, at most the size of the span.
+ *
+ * @retval     NRF_SUCCESS              If the read position was moved.
+ * @retval     NRF_ERROR_NULL           If a NULL parameter was passed.
+ * @retval     NRF_ERROR_INVALID_LENGTH If @p size is more than the FIFO holds.
+ */
+uint32_t app_fifo_read_span_release(app_fifo_t * p_fifo, uint32_t size);
+
+/**@brief Function for getting the contiguous span of free bytes that can be written to the FIFO.
+ *
+ * The span starts at the write position and ends at the read position or at the end of the
+ * buffer, whichever comes first. The bytes can be filled, or received by EasyDMA, in place.
+ * They become readable with @ref app_fifo_write_span_commit.
+ *
+ * @param[in]  p_fifo   Pointer to the FIFO. Must not be NULL.
+ * @param[out] pp_data  Start of the span in the FIFO buffer.
+ * @param[out] p_size   Number of free bytes in the span, 0 if the FIFO is full.
+ *
+ * @retval     NRF_SUCCESS       If the span has room for at least one byte.
+ * @retval     NRF_ERROR_NULL    If a NULL parameter was passed.
+ * @retval     NRF_ERROR_NO_MEM  If the FIFO is full.
+ */
+uint32_t app_fifo_write_span_get(app_fifo_t * p_fifo, uint8_t ** pp_data, uint32_t * p_size);
+
+/**@brief Function for making bytes written in place into a span readable.
+ *
+ * @param[in]  p_fifo   Pointer to the FIFO. Must not be NULL.
+ * @param[in]  size     Number of bytes written, at most the size of the span.
+ *
+ * @retval     NRF_SUCCESS              If the write position was moved.
+ * @retval     NRF_ERROR_NULL           If a NULL parameter was passed.
+ * @retval     NRF_ERROR_INVALID_LENGTH If @p size is more than the free room in the FIFO.
+ */
+uint32_t app_fifo_write_span_commit(app_fifo_t * p_fifo, uint32_t size);
+
 
 #ifdef __cplusplus
 }
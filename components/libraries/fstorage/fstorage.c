@@ -24,6 +24,12 @@
 static uint8_t       m_flags;       // fstorage status flags.
 static fs_op_queue_t m_queue;       // Queue of requested operations.
 static uint8_t       m_retry_count; // Number of times the last flash operation was retried.
+static uint16_t      m_chunk_len;   // Length of the last write, in words.
+static uint8_t       m_merged;      // Number of queued stores the last write also covered.
+
+#if (FS_COALESCE_WORDS != 0)
+static uint32_t      m_coalesce_buf[FS_COALESCE_WORDS]; // Data of merged stores.
+#endif
 
 // Sends events to the application.
 static void send_event(fs_op_t const * const p_op, fs_ret_t result)
@@ -73,23 +79,83 @@ static bool check_config(fs_config_t const * const config)
 }
 
 
+// Extends the write of the last chunk of a store over the stores queued after it, as long as
+// they continue at the next flash address and the whole fits in one write. The data of stores
+// which are not back to back in memory is gathered in a buffer. Returns the source to write.
+static uint32_t const * store_merge(fs_op_t const * const p_op)
+{
+    uint32_t const * p_src     = p_op->store.p_src  + p_op->store.offset;
+    uint32_t const * p_src_end = p_src + m_chunk_len;
+    uint32_t const * p_end     = p_op->store.p_dest + p_op->store.length_words;
+    bool             copied    = false;
+
+    for (uint32_t i = 1; i < m_queue.count; i++)
+    {
+        uint32_t  const         idx    = (m_queue.rp + i) % FS_QUEUE_SIZE;
+        fs_op_t   const * const p_next = &m_queue.op[idx];
+        uint16_t  const         len    = p_next->store.length_words;
+
+        if ((p_next->op_code != FS_OP_STORE) ||
+            (p_next->store.p_dest != p_end)  ||
+            (m_chunk_len + len > FS_MAX_WRITE_SIZE_WORDS))
+        {
+            break;
+        }
+
+        if (copied || (p_next->store.p_src != p_src_end))
+        {
+#if (FS_COALESCE_WORDS != 0)
+            if (m_chunk_len + len > FS_COALESCE_WORDS)
+            {
+                break;
+            }
+            if (!copied)
+            {
+                memcpy(m_coalesce_buf, p_src, m_chunk_len * sizeof(uint32_t));
+                copied = true;
+            }
+            memcpy(&m_coalesce_buf[m_chunk_len], p_next->store.p_src, len * sizeof(uint32_t));
+#else
+            break;
+#endif
+        }
+
+        m_chunk_len += len;
+        p_end       += len;
+        p_src_end    = p_next->store.p_src + len;
+        m_merged++;
+    }
+
+#if (FS_COALESCE_WORDS != 0)
+    if (copied)
+    {
+        return m_coalesce_buf;
+    }
+#endif
+    return p_src;
+}
+
+
 // Executes a store operation.
 static uint32_t store_execute(fs_op_t const * const p_op)
 {
-    uint16_t chunk_len;
+    uint32_t const * p_src = p_op->store.p_src + p_op->store.offset;
+
+    m_merged = 0;
 
     if ((p_op->store.length_words - p_op->store.offset) < FS_MAX_WRITE_SIZE_WORDS)
     {
-        chunk_len = p_op->store.length_words - p_op->store.offset;
+        m_chunk_len = p_op->store.length_words - p_op->store.offset;
+        p_src       = store_merge(p_op);
     }
     else
     {
-        chunk_len = FS_MAX_WRITE_SIZE_WORDS;
+        m_chunk_len = FS_MAX_WRITE_SIZE_WORDS;
     }
 
     return sd_flash_write((uint32_t*)p_op->store.p_dest + p_op->store.offset,
-                          (uint32_t*)p_op->store.p_src  + p_op->store.offset,
-                          chunk_len);
+                          (uint32_t*)p_src,
+                          m_chunk_len);
 }
 
 
@@ -100,6 +166,26 @@ static uint32_t erase_execute(fs_op_t const * const p_op)
 }
 
 
+#if (FS_ERASE_SKIP_BLANK)
+
+static bool page_is_blank(uint16_t page)
+{
+    uint32_t const * const p_page = (uint32_t*)((uint32_t)page * FS_PAGE_SIZE);
+
+    for (uint32_t i = 0; i < FS_PAGE_SIZE_WORDS; i++)
+    {
+        if (p_page[i] != FS_ERASED_WORD)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#endif
+
+
 // Advances the queue, wrapping around if necessary.
 // If no elements are left in the queue, clears the FS_FLAG_PROCESSING flag.
 static void queue_advance(void)
@@ -116,11 +202,27 @@ static void queue_advance(void)
 }
 
 
+static void on_operation_success(fs_op_t * const p_op);
+
+
 // Processes the current element in the queue. If the queue is empty, does nothing.
-static void queue_process(void)
+// In the context of a flash event, pages which are already erased are skipped: their erase
+// completes right away in the same way as if the SoftDevice had reported it.
+static void queue_process(bool flash_evt)
 {
-    uint32_t         ret;
-    fs_op_t  * const p_op = &m_queue.op[m_queue.rp];
+    uint32_t  ret;
+    fs_op_t * p_op = &m_queue.op[m_queue.rp];
+
+#if (FS_ERASE_SKIP_BLANK)
+    while (flash_evt && (m_queue.count > 0) && (m_flags & FS_FLAG_PROCESSING) &&
+           (p_op->op_code == FS_OP_ERASE) && page_is_blank(p_op->erase.page))
+    {
+        on_operation_success(p_op);
+        p_op = &m_queue.op[m_queue.rp];
+    }
+#else
+    UNUSED_PARAMETER(flash_evt);
+#endif
 
     if (m_queue.count > 0)
     {
@@ -167,7 +269,7 @@ static void queue_start(void)
         !(m_flags & FS_FLAG_FLASH_REQ_PENDING))
     {
         m_flags |= FS_FLAG_PROCESSING;
-        queue_process();
+        queue_process(false);
     }
 }
 
@@ -182,24 +284,32 @@ static void on_operation_success(fs_op_t * const p_op)
     {
         case FS_OP_STORE:
         {
-            uint16_t chunk_len;
+            uint8_t const merged = m_merged;
 
-            if ((p_op->store.length_words - p_op->store.offset) < FS_MAX_WRITE_SIZE_WORDS)
+            if (merged == 0)
             {
-                chunk_len = p_op->store.length_words - p_op->store.offset;
+                p_op->store.offset += m_chunk_len;
             }
             else
             {
-                chunk_len = FS_MAX_WRITE_SIZE_WORDS;
+                // The write went on over the next stores in the queue; all of them are done.
+                p_op->store.offset = p_op->store.length_words;
             }
 
-            p_op->store.offset += chunk_len;
-
             if (p_op->store.offset == p_op->store.length_words)
             {
                 // The operation has finished.
                 send_event(p_op, FS_SUCCESS);
                 queue_advance();
+
+                for (uint8_t i = 0; i < merged; i++)
+                {
+                    fs_op_t * const p_next = &m_queue.op[m_queue.rp];
+
+                    p_next->store.offset = p_next->store.length_words;
+                    send_event(p_next, FS_SUCCESS);
+                    queue_advance();
+                }
             }
         }
         break;
@@ -517,7 +627,7 @@ void fs_sys_event_handler(uint32_t sys_evt)
     }
 
     // Resume processing the queue, if necessary.
-    queue_process();
+    queue_process(true);
 }
 
 bool fs_queue_is_full(void)
@@ -49,5 +49,25 @@
 #define FS_MAX_WRITE_SIZE_WORDS
 
 
+/** @brief Size of the buffer which merges stores to adjacent addresses, in words.
+ *
+ * Stores queued back to back are written with one call to @ref sd_flash_write,
+ * up to @ref FS_MAX_WRITE_SIZE_WORDS. If their data is not back to back in memory
+ * as well, it is gathered in a buffer of this size. Set to 0 to save the RAM.
+ *
+ * @note This is an NRF_CONFIG macro.
+ */
+#define FS_COALESCE_WORDS
+
+
+/** @brief Do not erase pages which already read as erased.
+ *
+ * Erases queued after another operation complete right away if the page is blank.
+ *
+ * @note This is an NRF_CONFIG macro.
+ */
+#define FS_ERASE_SKIP_BLANK
+
+
 
 /** @} */
@@ -27,6 +27,17 @@ extern "C" {
 
 #define FS_ERASED_WORD              (0xFFFFFFFF)
 
+// Size of the buffer in which stores to adjacent addresses are gathered, in words.
+// Zero only merges stores whose data also lies back to back in memory.
+#ifndef FS_COALESCE_WORDS
+    #define FS_COALESCE_WORDS       (0)
+#endif
+
+// Do not erase pages which already read as erased.
+#ifndef FS_ERASE_SKIP_BLANK
+    #define FS_ERASE_SKIP_BLANK     (0)
+#endif
+
 // Helper macros for section variables.
 #define FS_SECTION_VARS_GET(i)          NRF_SECTION_VARS_GET((i), fs_config_t, fs_data)
 #define FS_SECTION_VARS_COUNT           NRF_SECTION_VARS_COUNT(fs_config_t, fs_data)
@@ -59,5 +59,46 @@ nrf_log_hexdump_handler_t nrf_log_backend_hexdump_handler_get(void);
  * @return Byte.
  */
 uint8_t nrf_log_backend_getchar(void);
+
+#if NRF_LOG_BACKEND_SERIAL_BINARY
+/**@brief Smallest buffer a standard entry is encoded into whole, strings in RAM aside. */
+#define NRF_LOG_BACKEND_BINARY_STD_MIN  (3 + 4 + 4 + 6 * 4)
+
+/**
+ * @brief Function for encoding a standard entry as a binary frame, for a backend of its own.
+ *
+ * @param[out] p_buf  Frame, at least @ref NRF_LOG_BACKEND_BINARY_STD_MIN bytes; %s arguments
+ *                    in RAM are cut to fit @p size.
+ *
+ * @return Length of the frame.
+ */
+uint32_t nrf_log_backend_binary_std_encode(uint8_t                severity_level,
+                                           const uint32_t * const p_timestamp,
+                                           const char * const     p_str,
+                                           uint32_t             * p_args,
+                                           uint32_t               nargs,
+                                           uint8_t              * p_buf,
+                                           uint32_t               size);
+
+/**
+ * @brief Function for encoding the next chunk of a hexdump as a binary frame.
+ *
+ * @param[out] p_buf    Frame, more than 16 bytes.
+ * @param[out] p_count  Bytes of the dump in the frame, from @p offset on.
+ *
+ * @return Length of the frame.
+ */
+uint32_t nrf_log_backend_binary_hexdump_encode(uint8_t                severity_level,
+                                               const uint32_t * const p_timestamp,
+                                               const char * const     p_str,
+                                               uint32_t               offset,
+                                               const uint8_t * const  p_buf0,
+                                               uint32_t               buf0_length,
+                                               const uint8_t * const  p_buf1,
+                                               uint32_t               buf1_length,
+                                               uint8_t              * p_buf,
+                                               uint32_t               size,
+                                               uint32_t             * p_count);
+#endif // NRF_LOG_BACKEND_SERIAL_BINARY
 #endif // NRF_LOG_BACKEND_H__
 /** @} */
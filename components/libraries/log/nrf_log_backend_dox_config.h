@@ -24,6 +24,18 @@
 #define NRF_LOG_TIMESTAMP_DIGITS
 
 
+/** @brief Send binary frames instead of text
+ *
+ * Only the format string address and the arguments go out, formatting is done on the
+ * host by nrf_log_decode.py from the ELF file.
+ *
+ *  Set to 1 to activate.
+ *
+ * @note This is an NRF_CONFIG macro.
+ */
+#define NRF_LOG_BACKEND_SERIAL_BINARY
+
+
 /** @brief If enabled data is printed over UART
  *
  *  Set to 1 to activate.
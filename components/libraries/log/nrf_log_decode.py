@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""Print the binary frames of nrf_log (NRF_LOG_BACKEND_SERIAL_BINARY) as text.
+
+The target sends the address of each format string instead of the string, the
+strings are read from the ELF file (.axf, .elf) of the same build.
+
+    nrf_log_decode.py app.axf capture.bin
+    nrf_log_decode.py app.axf --port COM5 --baud 115200    (needs pyserial)
+    nrf_log_decode.py app.axf < /dev/ttyACM0
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SYNC              = 0xA5
+FLAG_HEXDUMP      = 0x40
+FLAG_TIMESTAMP    = 0x80
+NARGS_MASK        = 0x07
+RAM_START         = 0x20000000
+TIMESTAMP_DIGITS  = 8
+HEXDUMP_PER_LINE  = 16
+
+CONVERSION = re.compile(r'%([-+ #0]*)(\d*)(?:\.(\d*))?(?:hh|h|ll|l|j|z|t|L)?([diouxXcsp%])')
+
+
+class Image(object):
+    """Loadable segments of an ELF file."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            data = f.read()
+        if data[:4] != b'\x7fELF':
+            raise ValueError('%s is not an ELF file' % path)
+        if data[4] == 1:
+            header = struct.unpack_from('<16sHHIIIIIHHHHHH', data)
+        else:
+            header = struct.unpack_from('<16sHHIQQQIHHHHHH', data)
+        phoff, phentsize, phnum = header[5], header[9], header[10]
+        self.segments = []
+        for i in range(phnum):
+            if data[4] == 1:
+                p_type, p_offset, p_vaddr, p_paddr, p_filesz = \
+                    struct.unpack_from('<IIIIIIII', data, phoff + i * phentsize)[0:5]
+            else:
+                p_type, _, p_offset, p_vaddr, p_paddr, p_filesz = \
+                    struct.unpack_from('<IIQQQQQQ', data, phoff + i * phentsize)[0:6]
+            if p_type == 1 and p_filesz:
+                self.segments.append((p_vaddr, data[p_offset:p_offset + p_filesz]))
+                if p_paddr != p_vaddr:
+                    self.segments.append((p_paddr, data[p_offset:p_offset + p_filesz]))
+
+    def string(self, addr):
+        """Zero terminated string at addr, None if the address is not in the file."""
+        for start, seg in self.segments:
+            if start <= addr < start + len(seg):
+                end = seg.find(b'\0', addr - start)
+                if end < 0:
+                    end = len(seg)
+                return seg[addr - start:end].decode('latin-1')
+        return None
+
+
+def signed(value):
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def format_args(image, fmt, args, inline):
+    """printf() of the target for 32-bit arguments."""
+    out, pos, arg = [], 0, 0
+    for m in CONVERSION.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, conv = m.groups()
+        if conv == '%':
+            out.append('%')
+            continue
+        value = args[arg] if arg < len(args) else 0
+        arg += 1
+        spec = '%' + flags + width + ('.' + prec if prec is not None else '')
+        if conv == 's':
+            if value >= RAM_START:
+                text = inline.pop(0) if inline else '<0x%08X>' % value
+            else:
+                text = image.string(value)
+                text = '<0x%08X>' % value if text is None else text
+            out.append((spec + 's') % text)
+        elif conv == 'c':
+            out.append((spec + 'c') % chr(value & 0xFF))
+        elif conv in 'di':
+            out.append((spec + 'd') % signed(value))
+        elif conv == 'p':
+            out.append('0x%08x' % value)
+        else:
+            out.append((spec + ('d' if conv == 'u' else conv)) % value)
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+
+class Decoder(object):
+    def __init__(self, image, out):
+        self.image = image
+        self.out = out
+        self.buf = bytearray()
+        self.hexdump = bytearray()
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            start = self.buf.find(bytes([SYNC]))
+            if start < 0:
+                del self.buf[:]
+                return
+            del self.buf[:start]
+            used = self.frame()
+            if used == 0:
+                return
+            del self.buf[:used]
+
+    def frame(self):
+        """Length of the frame at the start of buf, 0 if incomplete. Bad frames skip the sync."""
+        buf = self.buf
+        if len(buf) < 3:
+            return 0
+        flags, pos = buf[1], 3
+        stamp = None
+        if flags & FLAG_TIMESTAMP:
+            if len(buf) < pos + 4:
+                return 0
+            stamp = struct.unpack_from('<I', buf, pos)[0]
+            pos += 4
+        if len(buf) < pos + 4:
+            return 0
+        fmt = self.image.string(struct.unpack_from('<I', buf, pos)[0])
+        pos += 4
+        if fmt is None or (flags & 0x38):
+            return 1
+
+        prefix = '[%0*d]' % (TIMESTAMP_DIGITS, stamp) if stamp is not None else ''
+        if flags & FLAG_HEXDUMP:
+            if len(buf) < pos + 5:
+                return 0
+            offset, total, count = struct.unpack_from('<HHB', buf, pos)
+            pos += 5
+            if len(buf) < pos + count:
+                return 0
+            if offset == 0:
+                self.hexdump = bytearray()
+            self.hexdump += buf[pos:pos + count]
+            if offset + count >= total:
+                self.print_hexdump(prefix, fmt)
+            return pos + count
+
+        nargs = flags & NARGS_MASK
+        if len(buf) < pos + 4 * nargs:
+            return 0
+        args = list(struct.unpack_from('<%dI' % nargs, buf, pos))
+        pos += 4 * nargs
+        inline = []
+        strings = [m.group(4) for m in CONVERSION.finditer(fmt) if m.group(4) != '%']
+        for conv, value in zip(strings, args):
+            if conv == 's' and value >= RAM_START:
+                end = buf.find(b'\0', pos)
+                if end < 0:
+                    return 0
+                inline.append(bytes(buf[pos:end]).decode('latin-1'))
+                pos = end + 1
+        self.out.write(prefix + format_args(self.image, fmt, args, inline))
+        self.out.flush()
+        return pos
+
+    def print_hexdump(self, prefix, fmt):
+        self.out.write(prefix + fmt)
+        pad = ' ' * len(prefix)
+        for i in range(0, len(self.hexdump), HEXDUMP_PER_LINE):
+            line = self.hexdump[i:i + HEXDUMP_PER_LINE]
+            hexpart = ''.join('%02X ' % c for c in line).ljust(3 * HEXDUMP_PER_LINE)
+            text = ''.join(chr(c) if 32 <= c < 127 else '.' for c in line)
+            self.out.write('%s%s %s\r\n' % (pad, hexpart, text))
+        self.out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode binary nrf_log output.')
+    parser.add_argument('elf', help='ELF file of the running firmware')
+    parser.add_argument('capture', nargs='?', help='captured log bytes, stdin if left out')
+    parser.add_argument('--port', help='serial port to read from')
+    parser.add_argument('--baud', type=int, default=115200)
+    args = parser.parse_args()
+
+    decoder = Decoder(Image(args.elf), sys.stdout)
+    if args.port:
+        import serial
+        source = serial.Serial(args.port, args.baud, timeout=0.1)
+    elif args.capture:
+        source = open(args.capture, 'rb')
+    else:
+        source = getattr(sys.stdin, 'buffer', sys.stdin)
+
+    try:
+        while True:
+            data = source.read(256)
+            if not data:
+                if not args.port:
+                    break
+                continue
+            decoder.feed(bytearray(data))
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
@@ -12,6 +12,7 @@
 #include "sdk_common.h"
 #if NRF_MODULE_ENABLED(NRF_LOG)
 #include "nrf_log_backend.h"
+#include "nrf_log_internal.h"
 #include "nrf_error.h"
 #include <stdarg.h>
 #include <string.h>
@@ -41,7 +42,12 @@ static nrf_drv_uart_t m_uart = NRF_DRV_UART_INSTANCE(NRF_LOG_BACKEND_UART_INSTAN
 #define HEXDUMP_HEXBYTE_AREA                 3 // Two bytes for hexbyte and space to separate
 #define TIMESTAMP_STR(val) "[%0" NUM_TO_STR(val) "d]"
 
-#define RTT_RETRY_COUNTER 10 //Number of retries before skipping processing
+#define RTT_LOG_BUFFER    0  //Up-buffer written by the logger
+
+#define BINARY_SYNC             0xA5 // First byte of every binary frame
+#define BINARY_FLAG_HEXDUMP     0x40 // Frame carries a hexdump chunk instead of arguments
+#define BINARY_FLAG_TIMESTAMP   0x80 // Frame carries a timestamp
+#define BINARY_IN_RAM(addr)     ((uint32_t)(addr) >= 0x20000000) // The host can not read it from the ELF file
 
 #define HEXDUMP_MAX_STR_LEN (NRF_LOG_BACKEND_MAX_STRING_LENGTH -          \
                             (HEXDUMP_HEXBYTE_AREA*HEXDUMP_BYTES_PER_LINE +\
@@ -51,12 +57,19 @@ static nrf_drv_uart_t m_uart = NRF_DRV_UART_INSTANCE(NRF_LOG_BACKEND_UART_INSTAN
 
 static bool m_initialized   = false;
 static bool m_blocking_mode = false;
+#if !NRF_LOG_BACKEND_SERIAL_BINARY
 static const char m_default_color[] = "\x1B[0m";
+#endif
 
 #if (NRF_LOG_BACKEND_SERIAL_USES_UART)
 static volatile bool m_rx_done = false;
 #endif
 
+#if (NRF_LOG_BACKEND_SERIAL_USES_RTT)
+static uint32_t   m_rtt_dropped;    // Writes skipped since the last drop marker went out
+static const char m_rtt_drop_info[] = NRF_LOG_ERROR_COLOR_CODE "RTT:%d dropped\r\n";
+#endif
+
 #if (NRF_LOG_BACKEND_SERIAL_USES_UART)
 static void uart_event_handler(nrf_drv_uart_event_t * p_event, void * p_context)
 {
@@ -78,6 +91,10 @@ ret_code_t nrf_log_backend_init(bool blocking)
     }
 #if (NRF_LOG_BACKEND_SERIAL_USES_RTT)
     SEGGER_RTT_Init();
+    // Never wait for the debugger: a write that does not fit is skipped and counted.
+    UNUSED_RETURN_VALUE(SEGGER_RTT_ConfigUpBuffer(RTT_LOG_BUFFER, NULL, NULL, 0,
+                                                  SEGGER_RTT_MODE_NO_BLOCK_SKIP));
+    m_rtt_dropped = 0;
 #endif
     
 #if (NRF_LOG_BACKEND_SERIAL_USES_UART)
@@ -122,6 +139,77 @@ static bool serial_is_busy(void)
 }
 
 
+#if NRF_LOG_BACKEND_SERIAL_BINARY
+/* Binary frames, little endian:
+ *    sync, flags, severity, [timestamp (4)], string address (4), then
+ *    - flags bits 0..2 arguments of 4 bytes, followed by a zero terminated copy of
+ *      every %s argument that points into RAM, or
+ *    - with BINARY_FLAG_HEXDUMP: offset (2), total length (2), count (1), count data bytes.
+ * The host looks the format strings up in the ELF file (nrf_log_decode.py).
+ */
+static uint32_t binary_header_encode(uint8_t                flags,
+                                     uint8_t                severity_level,
+                                     const uint32_t * const p_timestamp,
+                                     const char * const     p_str,
+                                     uint8_t              * p_buf)
+{
+    uint32_t len = 0;
+
+    p_buf[len++] = BINARY_SYNC;
+    p_buf[len++] = flags | (p_timestamp ? BINARY_FLAG_TIMESTAMP : 0);
+    p_buf[len++] = severity_level;
+    if (p_timestamp)
+    {
+        len += uint32_encode(*p_timestamp, &p_buf[len]);
+    }
+    len += uint32_encode((uint32_t)p_str, &p_buf[len]);
+
+    return len;
+}
+#endif // NRF_LOG_BACKEND_SERIAL_BINARY
+
+
+#if NRF_LOG_BACKEND_SERIAL_USES_RTT
+static uint32_t rtt_drop_marker_encode(uint8_t * p_buf, uint32_t size)
+{
+#if NRF_LOG_BACKEND_SERIAL_BINARY
+    UNUSED_PARAMETER(size);
+    uint32_t len = binary_header_encode(1, NRF_LOG_LEVEL_INTERNAL, NULL, m_rtt_drop_info, p_buf);
+    return len + uint32_encode(m_rtt_dropped, &p_buf[len]);
+#else
+    int32_t len = snprintf((char *)p_buf, size, m_rtt_drop_info, (int)m_rtt_dropped);
+    return (len > 0) ? MIN((uint32_t)len, size - 1) : 0;
+#endif
+}
+
+
+/**@brief Function for writing to RTT without waiting for the host.
+ *
+ * The up-buffer is in skip mode, so a write either fits whole or is dropped. After drops, a
+ * marker with their count goes out ahead of the next write that fits.
+ */
+static void rtt_tx(uint8_t const * p_buf, uint32_t len)
+{
+    if (m_rtt_dropped != 0)
+    {
+        uint8_t marker[32];
+
+        if (SEGGER_RTT_WriteNoLock(RTT_LOG_BUFFER, marker,
+                                   rtt_drop_marker_encode(marker, sizeof(marker))) == 0)
+        {
+            m_rtt_dropped++;
+            return;
+        }
+        m_rtt_dropped = 0;
+    }
+    if (SEGGER_RTT_WriteNoLock(RTT_LOG_BUFFER, p_buf, len) == 0)
+    {
+        m_rtt_dropped++;
+    }
+}
+#endif //NRF_LOG_BACKEND_SERIAL_USES_RTT
+
+
 static bool serial_tx(uint8_t * p_buf, uint32_t len)
 {
     bool ret = true;
@@ -136,25 +224,7 @@ static bool serial_tx(uint8_t * p_buf, uint32_t len)
 #endif //NRF_LOG_BACKEND_SERIAL_USES_UART
 
 #if NRF_LOG_BACKEND_SERIAL_USES_RTT
-    uint32_t idx    = 0;
-    uint32_t length = len;
-    uint32_t processed;
-    uint32_t watchdog_counter = RTT_RETRY_COUNTER;
-    do
-    {
-        processed = SEGGER_RTT_WriteNoLock(0, &p_buf[idx], length);
-        idx += processed;
-        length -= processed;
-        if (processed == 0)
-        {
-            // If RTT is not connected then ensure that logger does not block
-            watchdog_counter--;
-            if (watchdog_counter == 0)
-            {
-                break;
-            }
-        }
-    } while (length);
+    rtt_tx(p_buf, len);
 #endif //NRF_LOG_BACKEND_SERIAL_USES_RTT
     return ret;
 }
@@ -181,6 +251,7 @@ static uint8_t serial_get_byte(void)
 }
 
 
+#if !NRF_LOG_BACKEND_SERIAL_BINARY
 static bool buf_len_update(uint32_t * p_buf_len, int32_t new_len)
 {
     bool ret;
@@ -446,17 +517,190 @@ static uint32_t nrf_log_backend_serial_hexdump_handler(
     while (byte_cnt < length);
     return byte_cnt;
 }
+#endif // !NRF_LOG_BACKEND_SERIAL_BINARY
+
+
+#if NRF_LOG_BACKEND_SERIAL_BINARY
+/**@brief Function for finding the arguments of a format string that are strings.
+ *
+ * @return Bit n set if argument n is converted by %s.
+ */
+static uint32_t string_args_get(const char * p_str)
+{
+    uint32_t strings = 0;
+    uint32_t arg     = 0;
+
+    while (*p_str != '\0')
+    {
+        if (*p_str++ != '%')
+        {
+            continue;
+        }
+        if (*p_str == '%')
+        {
+            p_str++;
+            continue;
+        }
+        while ((*p_str != '\0') && (strchr("-+ #0123456789.hlzjtL", *p_str) != NULL))
+        {
+            p_str++;
+        }
+        if (*p_str == '\0')
+        {
+            break;
+        }
+        if (*p_str == 's')
+        {
+            strings |= (1UL << arg);
+        }
+        arg++;
+        p_str++;
+    }
+
+    return strings;
+}
+
+
+uint32_t nrf_log_backend_binary_std_encode(uint8_t                severity_level,
+                                           const uint32_t * const p_timestamp,
+                                           const char * const     p_str,
+                                           uint32_t             * p_args,
+                                           uint32_t               nargs,
+                                           uint8_t              * p_buf,
+                                           uint32_t               size)
+{
+    uint32_t len;
+    uint32_t strings;
+    uint32_t i;
+
+    len = binary_header_encode(nargs, severity_level, p_timestamp, p_str, p_buf);
+    for (i = 0; i < nargs; i++)
+    {
+        len += uint32_encode(p_args[i], &p_buf[len]);
+    }
+
+    // Strings in flash are in the ELF file, pushed and other RAM strings travel in the frame.
+    strings = (nargs != 0) ? string_args_get(p_str) : 0;
+    for (i = 0; i < nargs; i++)
+    {
+        if ((strings & (1UL << i)) && BINARY_IN_RAM(p_args[i]) && (len < size))
+        {
+            const char * p_arg = (const char *)p_args[i];
+
+            while ((*p_arg != '\0') && (len < size - 1))
+            {
+                p_buf[len++] = (uint8_t)*p_arg++;
+            }
+            p_buf[len++] = '\0';
+        }
+    }
+
+    return len;
+}
+
+
+uint32_t nrf_log_backend_binary_hexdump_encode(uint8_t                severity_level,
+                                               const uint32_t * const p_timestamp,
+                                               const char * const     p_str,
+                                               uint32_t               offset,
+                                               const uint8_t * const  p_buf0,
+                                               uint32_t               buf0_length,
+                                               const uint8_t * const  p_buf1,
+                                               uint32_t               buf1_length,
+                                               uint8_t              * p_buf,
+                                               uint32_t               size,
+                                               uint32_t             * p_count)
+{
+    uint32_t len;
+    uint32_t count;
+    uint32_t length = buf0_length + buf1_length;
+
+    len = binary_header_encode(BINARY_FLAG_HEXDUMP, severity_level, p_timestamp, p_str, p_buf);
+    len += uint16_encode(offset, &p_buf[len]);
+    len += uint16_encode(length, &p_buf[len]);
+
+    count = MIN(length - offset, size - len - 1);
+    count = MIN(count, UINT8_MAX);
+    p_buf[len++] = count;
+    for (uint32_t i = offset; i < offset + count; i++)
+    {
+        p_buf[len++] = (i < buf0_length) ? p_buf0[i] : p_buf1[i - buf0_length];
+    }
+
+    *p_count = count;
+    return len;
+}
+
+
+static bool nrf_log_backend_serial_binary_std_handler(
+    uint8_t                severity_level,
+    const uint32_t * const p_timestamp,
+    const char * const     p_str,
+    uint32_t             * p_args,
+    uint32_t               nargs)
+{
+    uint8_t  buf[NRF_LOG_BACKEND_MAX_STRING_LENGTH];
+    uint32_t len;
+
+    if (serial_is_busy())
+    {
+        return false;
+    }
+
+    len = nrf_log_backend_binary_std_encode(severity_level, p_timestamp, p_str, p_args, nargs,
+                                            buf, sizeof(buf));
+    return serial_tx(buf, len);
+}
+
+
+static uint32_t nrf_log_backend_serial_binary_hexdump_handler(
+    uint8_t                severity_level,
+    const uint32_t * const p_timestamp,
+    const char * const     p_str,
+    uint32_t               offset,
+    const uint8_t * const  p_buf0,
+    uint32_t               buf0_length,
+    const uint8_t * const  p_buf1,
+    uint32_t               buf1_length)
+{
+    uint8_t  buf[NRF_LOG_BACKEND_MAX_STRING_LENGTH];
+    uint32_t len;
+    uint32_t count;
+
+    if (serial_is_busy())
+    {
+        return offset;
+    }
+
+    len = nrf_log_backend_binary_hexdump_encode(severity_level, p_timestamp, p_str, offset,
+                                                p_buf0, buf0_length, p_buf1, buf1_length,
+                                                buf, sizeof(buf), &count);
+    if (!serial_tx(buf, len))
+    {
+        return offset;
+    }
+    return offset + count;
+}
+#endif // NRF_LOG_BACKEND_SERIAL_BINARY
 
 
 nrf_log_std_handler_t nrf_log_backend_std_handler_get(void)
 {
+#if NRF_LOG_BACKEND_SERIAL_BINARY
+    return nrf_log_backend_serial_binary_std_handler;
+#else
     return nrf_log_backend_serial_std_handler;
+#endif
 }
 
 
 nrf_log_hexdump_handler_t nrf_log_backend_hexdump_handler_get(void)
 {
+#if NRF_LOG_BACKEND_SERIAL_BINARY
+    return nrf_log_backend_serial_binary_hexdump_handler;
+#else
     return nrf_log_backend_serial_hexdump_handler;
+#endif
 }
 
 
@@ -42,11 +42,12 @@ typedef struct
     nrf_log_timestamp_func_t  timestamp_func;  // A pointer to function that returns timestamp
     nrf_log_std_handler_t     std_handler;     // A handler used for processing standard log calls
     nrf_log_hexdump_handler_t hexdump_handler; // A handler for processing hex dumps
+    uint32_t                  dropped;         // Entries lost since the last overflow entry was processed
 } log_data_t;
 
 static log_data_t   m_log_data;
 #if (NRF_LOG_DEFERRED == 1)
-static const char * m_overflow_info = NRF_LOG_ERROR_COLOR_CODE "Overflow\r\n";
+static const char * m_overflow_info = NRF_LOG_ERROR_COLOR_CODE "Overflow, %d dropped\r\n";
 #endif //(NRF_LOG_DEFERRED == 1)
 
 /**
@@ -261,9 +262,10 @@ void nrf_log_frontend_init(nrf_log_std_handler_t     std_handler,
                            nrf_log_timestamp_func_t  timestamp_func)
 {
 #if NRF_LOG_DEFERRED
-    m_log_data.mask   = NRF_LOG_DEFERRED_BUFSIZE - 1;
-    m_log_data.wr_idx = 0;
-    m_log_data.rd_idx = 0;
+    m_log_data.mask    = NRF_LOG_DEFERRED_BUFSIZE - 1;
+    m_log_data.wr_idx  = 0;
+    m_log_data.rd_idx  = 0;
+    m_log_data.dropped = 0;
 #endif //NRF_LOG_DEFERRED
 #if NRF_LOG_USES_TIMESTAMP
     m_log_data.timestamp_func = timestamp_func;
@@ -314,6 +316,7 @@ static inline bool buf_prealloc(uint32_t nargs, uint32_t * p_wr_idx)
 #endif //NRF_LOG_USES_TIMESTAMP
         }
         // overflow case
+        m_log_data.dropped++;
         ret = false;
     }
     else
@@ -371,6 +374,10 @@ static inline uint32_t * cont_buf_prealloc(uint32_t len32,
     {
         p_buf = NULL;
     }
+    if (p_buf == NULL)
+    {
+        m_log_data.dropped++;
+    }
     CRITICAL_REGION_EXIT();
 
     return p_buf;
@@ -778,9 +785,30 @@ bool nrf_log_frontend_dequeue(void)
             p_arg++;
         }
 
-        ret = m_log_data.std_handler(header.std.severity,
-                                     p_timestamp,
-                                     p_str, args, nargs);
+#if (NRF_LOG_DEFERRED == 1)
+        if (p_str == m_overflow_info)
+        {
+            // The first overflow entry out reports every entry lost until then, the rest
+            // of that burst is skipped.
+            args[0] = m_log_data.dropped;
+            nargs   = 1;
+            ret     = (args[0] == 0) || m_log_data.std_handler(header.std.severity,
+                                                                 p_timestamp,
+                                                                 p_str, args, nargs);
+            if (ret)
+            {
+                CRITICAL_REGION_ENTER();
+                m_log_data.dropped -= args[0];
+                CRITICAL_REGION_EXIT();
+            }
+        }
+        else
+#endif //(NRF_LOG_DEFERRED == 1)
+        {
+            ret = m_log_data.std_handler(header.std.severity,
+                                         p_timestamp,
+                                         p_str, args, nargs);
+        }
     }
     if (ret)
     {
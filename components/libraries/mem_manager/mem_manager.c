@@ -13,6 +13,7 @@
 #if NRF_MODULE_ENABLED(MEM_MANAGER)
 #include "mem_manager.h"
 #include "nrf_assert.h"
+#include "app_util_platform.h"
 #define NRF_LOG_MODULE_NAME "MEM_MNGR"
 #include "nrf_log.h"
 
@@ -21,6 +22,8 @@
  *
  * @details Macros used to lock and unlock modules. Currently the SDK does not use mutexes but
  *          framework is provided in case need arises to use an alternative architecture.
+ *          Reserving and freeing a block does not take the mutex, the bitmap is updated one block
+ *          at a time in a critical region so that both can also be used from interrupts.
  * @{
  */
 #define MM_MUTEX_LOCK()   SDK_MUTEX_LOCK(m_mm_mutex)                                                /**< Lock module using mutex. */
@@ -494,6 +497,12 @@ static uint32_t m_block_count[BLOCK_CAT_COUNT] =
 
 #endif // MEM_MANAGER_ENABLE_DIAGNOSTICS
 
+#if MEM_MANAGER_PROFILING_ENABLED
+STATIC_ASSERT(NRF_MEM_BLOCK_CAT_COUNT == BLOCK_CAT_COUNT);
+
+static nrf_mem_profile_t m_profile[BLOCK_CAT_COUNT];                                                /**< Requests and use of each block category since init or the last reset. */
+#endif // MEM_MANAGER_PROFILING_ENABLED
+
 SDK_MUTEX_DEFINE(m_mm_mutex)                                                                        /**< Mutex variable. Currently unused, this declaration does not occupy any space in RAM. */
 #if (MEM_MANAGER_DISABLE_API_PARAM_CHECK == 0)
 static bool     m_module_initialized = false;                                                       /**< State indicating if module is initialized or not. */
@@ -567,6 +576,7 @@ static __INLINE uint32_t get_block_size(uint32_t block_index)
 }
 
 
+#ifdef MEM_MANAGER_ENABLE_DIAGNOSTICS
 /**@brief Function to free the block identified by block number 'block_index'. */
 static bool is_block_free(uint32_t block_index)
 {
@@ -579,20 +589,82 @@ static bool is_block_free(uint32_t block_index)
 
     return IS_SET(m_mem_pool[x], y);
 }
+#endif // MEM_MANAGER_ENABLE_DIAGNOSTICS
 
 
-/**@brief Function to allocate the block identified by block number 'block_index'. */
-static void block_allocate(uint32_t block_index)
+/**@brief Function to allocate the block identified by block number 'block_index' if it is free.
+ *
+ * @details The test and the update of the bitmap word happen in one critical region, an
+ *          interrupt reserving or freeing a block in the same word cannot come in between.
+ *
+ * @retval true  If the block was free and is now allocated.
+ * @retval false If the block is in use.
+ */
+static bool block_allocate(uint32_t block_index)
 {
     uint32_t x;
     uint32_t y;
+    bool     allocated = false;
 
     // Determine position of the block in the bitmap.
     // X determines relevant word for the block. Y determines the actual bit in the word.
     get_block_coordinates(block_index, &x, &y);
 
-    CLR_BIT(m_mem_pool[x], y);
+    CRITICAL_REGION_ENTER();
+    if (IS_SET(m_mem_pool[x], y))
+    {
+        CLR_BIT(m_mem_pool[x], y);
+        allocated = true;
+
+        #if MEM_MANAGER_PROFILING_ENABLED
+            nrf_mem_profile_t * p_profile = &m_profile[get_block_cat(0, block_index)];
+            p_profile->in_use++;
+            p_profile->max_in_use = MAX(p_profile->max_in_use, p_profile->in_use);
+        #endif // MEM_MANAGER_PROFILING_ENABLED
+    }
+    CRITICAL_REGION_EXIT();
+
+    return allocated;
+}
+
+
+/**@brief Function to free the block identified by block number 'block_index'. */
+static void block_release(uint32_t block_index)
+{
+    uint32_t x;
+    uint32_t y;
+
+    get_block_coordinates(block_index, &x, &y);
+
+    CRITICAL_REGION_ENTER();
+    #if MEM_MANAGER_PROFILING_ENABLED
+        if (!IS_SET(m_mem_pool[x], y))
+        {
+            m_profile[get_block_cat(0, block_index)].in_use--;
+        }
+    #endif // MEM_MANAGER_PROFILING_ENABLED
+    SET_BIT(m_mem_pool[x], y);
+    CRITICAL_REGION_EXIT();
+}
+
+
+#if MEM_MANAGER_PROFILING_ENABLED
+/**@brief Function to count a request of 'size' bytes for the category 'block_cat'. */
+static void profile_request(uint32_t block_cat, uint32_t size, bool success)
+{
+    nrf_mem_profile_t * p_profile = &m_profile[block_cat];
+    const uint32_t      bucket    = ((size - 1) * NRF_MEM_PROFILE_BUCKETS) / m_block_size[block_cat];
+
+    CRITICAL_REGION_ENTER();
+    p_profile->requests++;
+    p_profile->histogram[MIN(bucket, NRF_MEM_PROFILE_BUCKETS - 1)]++;
+    if (!success)
+    {
+        p_profile->failed++;
+    }
+    CRITICAL_REGION_EXIT();
 }
+#endif // MEM_MANAGER_PROFILING_ENABLED
 
 
 uint32_t nrf_mem_init(void)
@@ -610,6 +682,10 @@ uint32_t nrf_mem_init(void)
         block_init(block_index);
     }
 
+#if MEM_MANAGER_PROFILING_ENABLED
+    memset(m_profile, 0, sizeof(m_profile));
+#endif // MEM_MANAGER_PROFILING_ENABLED
+
 #if (MEM_MANAGER_DISABLE_API_PARAM_CHECK == 0)
     m_module_initialized = true;
 #endif // MEM_MANAGER_DISABLE_API_PARAM_CHECK
@@ -638,8 +714,6 @@ uint32_t nrf_mem_reserve(uint8_t ** pp_buffer, uint32_t * p_size)
 
     NRF_LOG_DEBUG("[MM]: >> nrf_mem_reserve, size 0x%04lX.\r\n", requested_size);
 
-    MM_MUTEX_LOCK();
-
     const uint32_t block_cat    = get_block_cat(requested_size, TOTAL_BLOCK_COUNT);
     uint32_t       block_index  = m_block_start[block_cat];
     uint32_t       memory_index = m_block_mem_start[block_cat];
@@ -653,16 +727,13 @@ uint32_t nrf_mem_reserve(uint8_t ** pp_buffer, uint32_t * p_size)
     {
         uint32_t block_size = get_block_size(block_index);
 
-        if (is_block_free(block_index) == true)
+        if (block_allocate(block_index) == true)
         {
-            NRF_LOG_DEBUG("[MM]: Reserving block 0x%08lX\r\n", block_index);
+            NRF_LOG_DEBUG("[MM]: Reserved block 0x%08lX\r\n", block_index);
 
             // Search succeeded, found free block.
             err_code     = NRF_SUCCESS;
 
-            // Allocate block.
-            block_allocate(block_index);
-
             (*pp_buffer) = &m_memory[memory_index];
             (*p_size)    = block_size;
 
@@ -687,7 +758,9 @@ uint32_t nrf_mem_reserve(uint8_t ** pp_buffer, uint32_t * p_size)
         #endif // MEM_MANAGER_ENABLE_DIAGNOSTICS
     }
 
-    MM_MUTEX_UNLOCK();
+    #if MEM_MANAGER_PROFILING_ENABLED
+        profile_request(block_cat, requested_size, (err_code == NRF_SUCCESS));
+    #endif // MEM_MANAGER_PROFILING_ENABLED
 
     NRF_LOG_DEBUG("[MM]: << nrf_mem_reserve %p, result 0x%08lX.\r\n",
                  (uint32_t)(*pp_buffer), err_code);
@@ -742,8 +815,6 @@ void nrf_free(void * p_mem)
 
     NRF_LOG_DEBUG("[MM]: >> nrf_free %p.\r\n", (uint32_t)p_mem);
 
-    MM_MUTEX_LOCK();
-
     uint32_t index;
     uint32_t memory_index = 0;
 
@@ -753,14 +824,12 @@ void nrf_free(void * p_mem)
         {
             // Found a free block of memory, assign.
             NRF_LOG_DEBUG("[MM]: << Freeing block %d.\r\n", index);
-            block_init(index);
+            block_release(index);
             break;
         }
         memory_index += get_block_size(index);
     }
 
-    MM_MUTEX_UNLOCK();
-
     NRF_LOG_DEBUG("[MM]: << nrf_free.\r\n");
     return;
 }
@@ -772,6 +841,46 @@ void * nrf_realloc(void * p_mem, uint32_t size)
 }
 
 
+#if MEM_MANAGER_PROFILING_ENABLED
+
+uint32_t nrf_mem_profile_get(uint32_t block_cat, nrf_mem_profile_t * p_profile)
+{
+    NULL_PARAM_CHECK(p_profile);
+
+    if (block_cat >= BLOCK_CAT_COUNT)
+    {
+        return (NRF_ERROR_INVALID_PARAM | NRF_ERROR_MEMORY_MANAGER_ERR_BASE);
+    }
+
+    CRITICAL_REGION_ENTER();
+    (*p_profile) = m_profile[block_cat];
+    CRITICAL_REGION_EXIT();
+
+    p_profile->block_size  = m_block_size[block_cat];
+    p_profile->block_count = m_block_end[block_cat] - m_block_start[block_cat];
+
+    return NRF_SUCCESS;
+}
+
+
+void nrf_mem_profile_reset(void)
+{
+    CRITICAL_REGION_ENTER();
+    for (uint32_t block_cat = 0; block_cat < BLOCK_CAT_COUNT; block_cat++)
+    {
+        nrf_mem_profile_t * p_profile = &m_profile[block_cat];
+
+        p_profile->requests   = 0;
+        p_profile->failed     = 0;
+        p_profile->max_in_use = p_profile->in_use;
+        memset(p_profile->histogram, 0, sizeof(p_profile->histogram));
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+#endif // MEM_MANAGER_PROFILING_ENABLED
+
+
 #ifdef MEM_MANAGER_ENABLE_DIAGNOSTICS
 
 /**@brief Function to format and print information with respect to each block.
@@ -139,6 +139,49 @@ void nrf_mem_diagnose(void);
 
 #endif // MEM_MANAGER_ENABLE_DIAGNOSTICS
 
+#if MEM_MANAGER_PROFILING_ENABLED
+
+#define NRF_MEM_BLOCK_CAT_COUNT 7   /**< Number of block categories, xxsmall (0) to xxlarge (6). */
+#define NRF_MEM_PROFILE_BUCKETS 4   /**< Requests of a category are counted by quarters of its block size. */
+
+/**@brief Requests and use of one block category. */
+typedef struct
+{
+    uint32_t block_size;                            /**< Size of a block of the category. */
+    uint32_t block_count;                           /**< Blocks in the category. */
+    uint32_t requests;                              /**< Requests whose size makes them start in this category. */
+    uint32_t failed;                                /**< Of these, requests that found no free block in this or a larger category. */
+    uint32_t histogram[NRF_MEM_PROFILE_BUCKETS];    /**< Requests by size: up to 1/4, 2/4, 3/4 and all of the block size. */
+    uint16_t in_use;                                /**< Blocks of the category in use now. */
+    uint16_t max_in_use;                            /**< Most blocks of the category in use at the same time. */
+} nrf_mem_profile_t;
+
+
+/**@brief Function to get the request statistics of a block category.
+ *
+ * @details Requests are counted in the smallest category that fits them, blocks in use in the
+ *          category they were taken from. A category with requests but no blocks in use had its
+ *          requests served from larger categories. Together with the histogram this shows which
+ *          sizes and counts to configure for the application.
+ *
+ * @param[in]  block_cat  Block category, 0 for xxsmall to @ref NRF_MEM_BLOCK_CAT_COUNT - 1 for xxlarge.
+ * @param[out] p_profile  Statistics of the category.
+ *
+ * @retval NRF_SUCCESS             If the statistics were copied.
+ * @retval NRF_ERROR_INVALID_PARAM If the category does not exist.
+ */
+uint32_t nrf_mem_profile_get(uint32_t block_cat, nrf_mem_profile_t * p_profile);
+
+
+/**@brief Function to start a new measurement.
+ *
+ * @details Clears the request counts and histograms and sets the high-water marks to the blocks
+ *          in use now.
+ */
+void nrf_mem_profile_reset(void);
+
+#endif // MEM_MANAGER_PROFILING_ENABLED
+
 
 #ifdef __cplusplus
 }
@@ -89,6 +89,14 @@
  */
 #define MEM_MANAGER_DISABLE_API_PARAM_CHECK
 
+/** @brief Count requests and blocks in use per block category.
+ *
+ *  Read with nrf_mem_profile_get() to size the block categories from measured use.
+ *
+ * @note This is an NRF_CONFIG macro.
+ */
+#define MEM_MANAGER_PROFILING_ENABLED
+
 
 
 /** @} */
@@ -15,6 +15,20 @@
 #include "nrf_queue.h"
 #include "app_util_platform.h"
 
+#if NRF_QUEUE_CONFIG_SPSC
+/* One producer and one consumer per queue: back is only moved by the producer and front only
+ * by the consumer, each after the elements it covers (QUEUE_PUBLISH), so the other side never
+ * sees an index ahead of the data and no critical region is needed. */
+#define QUEUE_ENTER()   {
+#define QUEUE_EXIT()    }
+#else
+#define QUEUE_ENTER()   CRITICAL_REGION_ENTER()
+#define QUEUE_EXIT()    CRITICAL_REGION_EXIT()
+#endif
+
+/**@brief Order the element accesses before the index update that hands them over. */
+#define QUEUE_PUBLISH() __DMB()
+
 /**@brief Get next element index.
  *
  * @param[in]   p_queue     Pointer to the queue instance.
@@ -41,6 +55,33 @@ __STATIC_INLINE size_t queue_utilization_get(nrf_queue_t const * p_queue)
            (p_queue->size + 1 - p_queue->p_cb->front + p_queue->p_cb->back);
 }
 
+/**@brief Record the utilization after elements were added.
+ *
+ * @param[in]   p_queue     Pointer to the queue instance.
+ */
+__STATIC_INLINE void queue_max_utilization_update(nrf_queue_t const * p_queue)
+{
+    size_t utilization = queue_utilization_get(p_queue);
+    if (p_queue->p_cb->max_utilization < utilization)
+    {
+        p_queue->p_cb->max_utilization = utilization;
+    }
+}
+
+/**@brief Move an index forward by a number of elements, wrapping at the end of the buffer.
+ *
+ * @param[in]   p_queue     Pointer to the queue instance.
+ * @param[in]   idx         Current index.
+ * @param[in]   count       Number of elements, at most the queue size.
+ *
+ * @return      New index.
+ */
+__STATIC_INLINE size_t queue_idx_add(nrf_queue_t const * p_queue, size_t idx, size_t count)
+{
+    idx += count;
+    return (idx <= p_queue->size) ? idx : (idx - (p_queue->size + 1));
+}
+
 bool nrf_queue_is_full(nrf_queue_t const * p_queue)
 {
     ASSERT(p_queue != NULL);
@@ -53,15 +94,18 @@ ret_code_t nrf_queue_push(nrf_queue_t const * p_queue, void const * p_element)
 
     ASSERT(p_queue != NULL);
     ASSERT(p_element != NULL);
+#if NRF_QUEUE_CONFIG_SPSC
+    // Overwriting the oldest element would move front from the producer.
+    ASSERT(p_queue->mode != NRF_QUEUE_MODE_OVERFLOW);
+#endif
 
-    CRITICAL_REGION_ENTER();
+    QUEUE_ENTER();
     bool is_full = nrf_queue_is_full(p_queue);
 
     if (!is_full || (p_queue->mode == NRF_QUEUE_MODE_OVERFLOW))
     {
         // Get write position.
         size_t write_pos = p_queue->p_cb->back;
-        p_queue->p_cb->back = nrf_queue_next_idx(p_queue, p_queue->p_cb->back);
         if (is_full)
         {
             // Overwrite the oldest element.
@@ -94,19 +138,19 @@ ret_code_t nrf_queue_push(nrf_queue_t const * p_queue, void const * p_element)
                 break;
         }
 
+        // Hand the element over.
+        QUEUE_PUBLISH();
+        p_queue->p_cb->back = nrf_queue_next_idx(p_queue, write_pos);
+
         // Update utilization.
-        size_t utilization = queue_utilization_get(p_queue);
-        if (p_queue->p_cb->max_utilization < utilization)
-        {
-            p_queue->p_cb->max_utilization = utilization;
-        }
+        queue_max_utilization_update(p_queue);
     }
     else
     {
         status = NRF_ERROR_NO_MEM;
     }
 
-    CRITICAL_REGION_EXIT();
+    QUEUE_EXIT();
 
     return status;
 }
@@ -120,19 +164,13 @@ ret_code_t nrf_queue_generic_pop(nrf_queue_t const * p_queue,
     ASSERT(p_queue != NULL);
     ASSERT(p_element != NULL);
 
-    CRITICAL_REGION_ENTER();
+    QUEUE_ENTER();
 
     if (!nrf_queue_is_empty(p_queue))
     {
         // Get read position.
         size_t read_pos = p_queue->p_cb->front;
 
-        // Update next read position.
-        if (!just_peek)
-        {
-            p_queue->p_cb->front = nrf_queue_next_idx(p_queue, p_queue->p_cb->front);
-        }
-
         // Read element.
         switch (p_queue->element_size)
         {
@@ -158,13 +196,20 @@ ret_code_t nrf_queue_generic_pop(nrf_queue_t const * p_queue,
                        p_queue->element_size);
                 break;
         }
+
+        // Update next read position, once the element is out.
+        if (!just_peek)
+        {
+            QUEUE_PUBLISH();
+            p_queue->p_cb->front = nrf_queue_next_idx(p_queue, read_pos);
+        }
     }
     else
     {
         status = NRF_ERROR_NOT_FOUND;
     }
 
-    CRITICAL_REGION_EXIT();
+    QUEUE_EXIT();
 
     return status;
 }
@@ -178,6 +223,10 @@ ret_code_t nrf_queue_generic_pop(nrf_queue_t const * p_queue,
  */
 static void queue_write(nrf_queue_t const * p_queue, void const * p_data, uint32_t element_count)
 {
+#if NRF_QUEUE_CONFIG_SPSC
+    // Overwriting the oldest elements would move front from the producer.
+    ASSERT(p_queue->mode != NRF_QUEUE_MODE_OVERFLOW);
+#endif
     size_t prev_available = nrf_queue_available_get(p_queue);
     size_t continuous     = p_queue->size + 1 - p_queue->p_cb->back;
     void * p_write_ptr    = (void *)((size_t)p_queue->p_buffer
@@ -188,6 +237,7 @@ static void queue_write(nrf_queue_t const * p_queue, void const * p_data, uint32
                p_data,
                element_count * p_queue->element_size);
 
+        QUEUE_PUBLISH();
         p_queue->p_cb->back = ((p_queue->p_cb->back + element_count) <= p_queue->size)
                             ? (p_queue->p_cb->back + element_count)
                             : 0;
@@ -204,6 +254,7 @@ static void queue_write(nrf_queue_t const * p_queue, void const * p_data, uint32
                (void const *)((size_t)p_data + first_write_length),
                elements_left * p_queue->element_size);
 
+        QUEUE_PUBLISH();
         p_queue->p_cb->back = elements_left;
         if (prev_available < element_count)
         {
@@ -213,11 +264,7 @@ static void queue_write(nrf_queue_t const * p_queue, void const * p_data, uint32
     }
 
     // Update utilization.
-    size_t utilization = queue_utilization_get(p_queue);
-    if (p_queue->p_cb->max_utilization < utilization)
-    {
-        p_queue->p_cb->max_utilization = utilization;
-    }
+    queue_max_utilization_update(p_queue);
 }
 
 ret_code_t nrf_queue_write(nrf_queue_t const * p_queue,
@@ -235,7 +282,7 @@ ret_code_t nrf_queue_write(nrf_queue_t const * p_queue,
         return NRF_SUCCESS;
     }
 
-    CRITICAL_REGION_ENTER();
+    QUEUE_ENTER();
 
     if ((nrf_queue_available_get(p_queue) >= element_count)
      || (p_queue->mode == NRF_QUEUE_MODE_OVERFLOW))
@@ -247,7 +294,7 @@ ret_code_t nrf_queue_write(nrf_queue_t const * p_queue,
         status = NRF_ERROR_NO_MEM;
     }
 
-    CRITICAL_REGION_EXIT();
+    QUEUE_EXIT();
 
     return status;
 }
@@ -265,7 +312,7 @@ size_t nrf_queue_in(nrf_queue_t const * p_queue,
         return 0;
     }
 
-    CRITICAL_REGION_ENTER();
+    QUEUE_ENTER();
 
     if (p_queue->mode == NRF_QUEUE_MODE_OVERFLOW)
     {
@@ -279,7 +326,7 @@ size_t nrf_queue_in(nrf_queue_t const * p_queue,
 
     queue_write(p_queue, p_data, element_count);
 
-    CRITICAL_REGION_EXIT();
+    QUEUE_EXIT();
 
     return element_count;
 }
@@ -305,6 +352,7 @@ static void queue_read(nrf_queue_t const * p_queue, void * p_data, uint32_t elem
                p_read_ptr,
                element_count * p_queue->element_size);
 
+        QUEUE_PUBLISH();
         p_queue->p_cb->front = ((p_queue->p_cb->front + element_count) <= p_queue->size)
                              ? (p_queue->p_cb->front + element_count)
                              : 0;
@@ -321,6 +369,7 @@ static void queue_read(nrf_queue_t const * p_queue, void * p_data, uint32_t elem
                p_queue->p_buffer,
                elements_left * p_queue->element_size);
 
+        QUEUE_PUBLISH();
         p_queue->p_cb->front = elements_left;
     }
 }
@@ -339,7 +388,7 @@ ret_code_t nrf_queue_read(nrf_queue_t const * p_queue,
         return NRF_SUCCESS;
     }
 
-    CRITICAL_REGION_ENTER();
+    QUEUE_ENTER();
 
     if (element_count <= queue_utilization_get(p_queue))
     {
@@ -350,7 +399,7 @@ ret_code_t nrf_queue_read(nrf_queue_t const * p_queue,
         status = NRF_ERROR_NOT_FOUND;
     }
 
-    CRITICAL_REGION_EXIT();
+    QUEUE_EXIT();
 
     return status;
 }
@@ -367,27 +416,132 @@ size_t nrf_queue_out(nrf_queue_t const * p_queue,
         return 0;
     }
 
-    CRITICAL_REGION_ENTER();
+    QUEUE_ENTER();
 
     size_t utilization = queue_utilization_get(p_queue);
     element_count      = MIN(element_count, utilization);
 
     queue_read(p_queue, p_data, element_count);
 
-    CRITICAL_REGION_EXIT();
+    QUEUE_EXIT();
 
     return element_count;
 }
 
+ret_code_t nrf_queue_front_get(nrf_queue_t const * p_queue,
+                               void             ** pp_elements,
+                               size_t            * p_count)
+{
+    ret_code_t status = NRF_SUCCESS;
+
+    ASSERT(p_queue != NULL);
+    ASSERT(pp_elements != NULL);
+    ASSERT(p_count != NULL);
+
+    QUEUE_ENTER();
+
+    size_t front = p_queue->p_cb->front;
+    size_t back  = p_queue->p_cb->back;
+
+    *pp_elements = (void *)((size_t)p_queue->p_buffer + front * p_queue->element_size);
+    *p_count     = (front <= back) ? (back - front) : (p_queue->size + 1 - front);
+    if (*p_count == 0)
+    {
+        status = NRF_ERROR_NOT_FOUND;
+    }
+
+    QUEUE_EXIT();
+
+    return status;
+}
+
+ret_code_t nrf_queue_consume(nrf_queue_t const * p_queue, size_t element_count)
+{
+    ret_code_t status = NRF_SUCCESS;
+
+    ASSERT(p_queue != NULL);
+
+    QUEUE_ENTER();
+
+    if (element_count <= queue_utilization_get(p_queue))
+    {
+        // The elements were read in place, before the producer may reuse them.
+        QUEUE_PUBLISH();
+        p_queue->p_cb->front = queue_idx_add(p_queue, p_queue->p_cb->front, element_count);
+    }
+    else
+    {
+        status = NRF_ERROR_NOT_FOUND;
+    }
+
+    QUEUE_EXIT();
+
+    return status;
+}
+
+ret_code_t nrf_queue_back_get(nrf_queue_t const * p_queue,
+                              void             ** pp_elements,
+                              size_t            * p_count)
+{
+    ret_code_t status = NRF_SUCCESS;
+
+    ASSERT(p_queue != NULL);
+    ASSERT(pp_elements != NULL);
+    ASSERT(p_count != NULL);
+
+    QUEUE_ENTER();
+
+    size_t front = p_queue->p_cb->front;
+    size_t back  = p_queue->p_cb->back;
+
+    // One element always stays free, so that a full queue differs from an empty one.
+    *pp_elements = (void *)((size_t)p_queue->p_buffer + back * p_queue->element_size);
+    *p_count     = (back >= front) ? (p_queue->size + 1 - back - ((front == 0) ? 1 : 0))
+                                   : (front - back - 1);
+    if (*p_count == 0)
+    {
+        status = NRF_ERROR_NO_MEM;
+    }
+
+    QUEUE_EXIT();
+
+    return status;
+}
+
+ret_code_t nrf_queue_commit(nrf_queue_t const * p_queue, size_t element_count)
+{
+    ret_code_t status = NRF_SUCCESS;
+
+    ASSERT(p_queue != NULL);
+
+    QUEUE_ENTER();
+
+    if (element_count <= p_queue->size - queue_utilization_get(p_queue))
+    {
+        // The elements were written in place, before the consumer may see them.
+        QUEUE_PUBLISH();
+        p_queue->p_cb->back = queue_idx_add(p_queue, p_queue->p_cb->back, element_count);
+        queue_max_utilization_update(p_queue);
+    }
+    else
+    {
+        status = NRF_ERROR_NO_MEM;
+    }
+
+    QUEUE_EXIT();
+
+    return status;
+}
+
 void nrf_queue_reset(nrf_queue_t const * p_queue)
 {
     ASSERT(p_queue != NULL);
 
-    CRITICAL_REGION_ENTER();
+    QUEUE_ENTER();
 
     memset(p_queue->p_cb, 0, sizeof(nrf_queue_cb_t));
 
-    CRITICAL_REGION_EXIT();
+    QUEUE_EXIT();
 }
 
 size_t nrf_queue_utilization_get(nrf_queue_t const * p_queue)
@@ -395,11 +549,11 @@ size_t nrf_queue_utilization_get(nrf_queue_t const * p_queue)
     size_t utilization;
     ASSERT(p_queue != NULL);
 
-    CRITICAL_REGION_ENTER();
+    QUEUE_ENTER();
 
     utilization = queue_utilization_get(p_queue);
 
-    CRITICAL_REGION_EXIT();
+    QUEUE_EXIT();
 
     return utilization;
 }
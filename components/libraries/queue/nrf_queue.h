@@ -298,6 +298,62 @@ size_t nrf_queue_out(nrf_queue_t const * p_queue,
                     void               * p_data,
                     size_t               element_count);
 
+/**@brief Function for getting the elements at the front of the queue in place, without copying.
+ *
+ * The elements can be read where they are, up to the end of the queue buffer; further elements
+ * follow from the start of the buffer with the next call. They stay in the queue until
+ * @ref nrf_queue_consume.
+ *
+ * @note  In @ref NRF_QUEUE_MODE_OVERFLOW a push into the full queue overwrites the oldest
+ *        element, also while it is being read in place.
+ *
+ * @param[in]   p_queue             Pointer to the nrf_queue_t instance.
+ * @param[out]  pp_elements         Pointer to the front element in the queue buffer.
+ * @param[out]  p_count             Number of contiguous elements from there, 0 if the queue is empty.
+ *
+ * @return      NRF_SUCCESS         If at least one element is available.
+ * @return      NRF_ERROR_NOT_FOUND If the queue is empty.
+ */
+ret_code_t nrf_queue_front_get(nrf_queue_t const * p_queue,
+                               void             ** pp_elements,
+                               size_t            * p_count);
+
+/**@brief Function for removing elements from the front of the queue without copying them.
+ *
+ * @param[in]   p_queue             Pointer to the nrf_queue_t instance.
+ * @param[in]   element_count       Number of elements to remove.
+ *
+ * @return      NRF_SUCCESS         If the elements were removed.
+ * @return      NRF_ERROR_NOT_FOUND There are not enough elements in the queue. None was removed.
+ */
+ret_code_t nrf_queue_consume(nrf_queue_t const * p_queue, size_t element_count);
+
+/**@brief Function for getting the free elements at the back of the queue, to fill in place.
+ *
+ * The elements can be written where they are, up to the end of the queue buffer or the front
+ * of the queue. They are added to the queue by @ref nrf_queue_commit.
+ *
+ * @param[in]   p_queue             Pointer to the nrf_queue_t instance.
+ * @param[out]  pp_elements         Pointer to the first free element in the queue buffer.
+ * @param[out]  p_count             Number of contiguous free elements from there, 0 if the queue is full.
+ *
+ * @return      NRF_SUCCESS         If at least one element is free.
+ * @return      NRF_ERROR_NO_MEM    If the queue is full.
+ */
+ret_code_t nrf_queue_back_get(nrf_queue_t const * p_queue,
+                              void             ** pp_elements,
+                              size_t            * p_count);
+
+/**@brief Function for adding elements filled in place to the back of the queue.
+ *
+ * @param[in]   p_queue             Pointer to the nrf_queue_t instance.
+ * @param[in]   element_count       Number of elements to add.
+ *
+ * @return      NRF_SUCCESS         If the elements were added.
+ * @return      NRF_ERROR_NO_MEM    There is not enough space in the queue. No element was added.
+ */
+ret_code_t nrf_queue_commit(nrf_queue_t const * p_queue, size_t element_count);
+
 /**@brief Function for checking if the queue is full. 
  *
  * @param[in]   p_queue     Pointer to the queue instance.
@@ -39,6 +39,12 @@ static uint16_t         m_queue_size;           /**< Number of queue entries. */
 static uint16_t m_max_queue_utilization;    /**< Maximum observed queue utilization. */
 #endif
 
+#if APP_SCHEDULER_HIGH_QUEUE_SIZE
+static app_sched_event_handler_t m_high_queue[APP_SCHEDULER_HIGH_QUEUE_SIZE + 1];  /**< Handlers of the high priority events. */
+static volatile uint8_t          m_high_start_index;                               /**< Index of the next high priority event. */
+static volatile uint8_t          m_high_end_index;                                 /**< Index past the last high priority event. */
+#endif
+
 #if APP_SCHEDULER_WITH_PAUSE
 static uint32_t m_scheduler_paused_counter = 0; /**< Counter storing the difference between pausing
                                                      and resuming the scheduler. */
@@ -97,6 +103,10 @@ uint32_t app_sched_init(uint16_t event_size, uint16_t queue_size, void * p_event
 #if APP_SCHEDULER_WITH_PROFILER
     m_max_queue_utilization = 0;
 #endif
+#if APP_SCHEDULER_HIGH_QUEUE_SIZE
+    m_high_start_index = 0;
+    m_high_end_index   = 0;
+#endif
 
     return NRF_SUCCESS;
 }
@@ -177,6 +187,9 @@ uint32_t app_sched_event_put(void                    * p_event_data,
             }
 
             err_code = NRF_SUCCESS;
+        #if APP_SCHEDULER_WITH_NOTIFY
+            app_sched_notify();
+        #endif
         }
         else
         {
@@ -192,6 +205,53 @@ uint32_t app_sched_event_put(void                    * p_event_data,
 }
 
 
+#if APP_SCHEDULER_HIGH_QUEUE_SIZE
+static __INLINE uint8_t high_next_index(uint8_t index)
+{
+    return (index < APP_SCHEDULER_HIGH_QUEUE_SIZE) ? (index + 1) : 0;
+}
+
+
+uint32_t app_sched_event_put_high(app_sched_event_handler_t handler)
+{
+    uint32_t err_code = NRF_ERROR_NO_MEM;
+
+    CRITICAL_REGION_ENTER();
+
+    if (high_next_index(m_high_end_index) != m_high_start_index)
+    {
+        m_high_queue[m_high_end_index] = handler;
+        m_high_end_index               = high_next_index(m_high_end_index);
+        err_code                       = NRF_SUCCESS;
+    }
+
+    CRITICAL_REGION_EXIT();
+
+#if APP_SCHEDULER_WITH_NOTIFY
+    if (err_code == NRF_SUCCESS)
+    {
+        app_sched_notify();
+    }
+#endif
+    return err_code;
+}
+
+
+/**@brief Function for running the queued high priority events. */
+static void high_events_execute(void)
+{
+    while (m_high_start_index != m_high_end_index)
+    {
+        app_sched_event_handler_t event_handler = m_high_queue[m_high_start_index];
+
+        // Only the main loop moves the start index, the entry is free once it has moved.
+        m_high_start_index = high_next_index(m_high_start_index);
+        event_handler(NULL, 0);
+    }
+}
+#endif // APP_SCHEDULER_HIGH_QUEUE_SIZE
+
+
 #if APP_SCHEDULER_WITH_PAUSE
 void app_sched_pause(void)
 {
@@ -234,8 +294,20 @@ static __INLINE bool is_app_sched_paused(void)
 
 void app_sched_execute(void)
 {
-    while (!is_app_sched_paused() && !APP_SCHED_QUEUE_EMPTY())
+    for (;;)
     {
+        if (is_app_sched_paused())
+        {
+            break;
+        }
+#if APP_SCHEDULER_HIGH_QUEUE_SIZE
+        high_events_execute();
+#endif
+        if (APP_SCHED_QUEUE_EMPTY())
+        {
+            break;
+        }
+
         // Since this function is only called from the main loop, there is no
         // need for a critical region here, however a special care must be taken
         // regarding update of the queue start index (see the end of the loop).
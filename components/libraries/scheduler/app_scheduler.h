@@ -137,6 +137,42 @@ uint32_t app_sched_event_put(void *                    p_event_data,
                              uint16_t                  event_size,
                              app_sched_event_handler_t handler);
 
+#if APP_SCHEDULER_HIGH_QUEUE_SIZE || defined(__SDK_DOXYGEN__)
+/**@brief Function for scheduling an event ahead of the normal queue.
+ *
+ * @details High priority events carry no data, the handler is called with NULL and 0 and
+ *          fetches what it needs from its own module. app_sched_execute() runs every queued
+ *          high priority event before the next normal one, so a burst of normal events cannot
+ *          hold them back. The queue has @ref APP_SCHEDULER_HIGH_QUEUE_SIZE entries; without it
+ *          the event goes to the normal queue.
+ *
+ * @param[in]   handler        Event handler to receive the event.
+ *
+ * @retval      NRF_SUCCESS      Event queued.
+ * @retval      NRF_ERROR_NO_MEM High priority queue full.
+ */
+uint32_t app_sched_event_put_high(app_sched_event_handler_t handler);
+#else
+__STATIC_INLINE uint32_t app_sched_event_put_high(app_sched_event_handler_t handler)
+{
+    return app_sched_event_put(NULL, 0, handler);
+}
+#endif
+
+#if APP_SCHEDULER_WITH_NOTIFY || defined(__SDK_DOXYGEN__)
+/**@brief Function called after each event put, provided by the application.
+ *
+ * @details Lets an RTOS block the task running app_sched_execute() until there is work,
+ *          instead of the main loop polling. Called from the context of the caller of
+ *          app_sched_event_put(), interrupts included, with the event already in the queue.
+ *
+ * @note A task putting events must not be preempted by the task running app_sched_execute()
+ *       between reserving and filling the queue entry: it either runs at a higher priority,
+ *       or holds a lock that task takes around app_sched_execute().
+ */
+void app_sched_notify(void);
+#endif
+
 /**@brief Function for getting the maximum observed queue utilization.
  *
  * Function for tuning the module and determining QUEUE_SIZE value and thus module RAM usage.
@@ -30,5 +30,14 @@
 #define APP_SCHEDULER_WITH_PROFILER
 
 
+/** @brief Size of the high priority queue
+ *
+ *  Entries for app_sched_event_put_high(), 0 sends those events to the normal queue.
+ *
+ * @note This is an NRF_CONFIG macro.
+ */
+#define APP_SCHEDULER_HIGH_QUEUE_SIZE
+
+
 
 /** @} */
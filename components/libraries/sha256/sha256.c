@@ -21,8 +21,9 @@
 #define ROTLEFT(a,b) (((a) << (b)) | ((a) >> (32 - (b))))
 #define ROTRIGHT(a,b) (((a) >> (b)) | ((a) << (32 - (b))))
 
-#define CH(x,y,z) (((x) & (y)) ^ (~(x) & (z)))
-#define MAJ(x,y,z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+// Same functions with fewer operations: CH picks bits of y or z, MAJ is the bitwise majority.
+#define CH(x,y,z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MAJ(x,y,z) (((x) & (y)) | ((z) & ((x) | (y))))
 #define EP0(x) (ROTRIGHT(x,2) ^ ROTRIGHT(x,13) ^ ROTRIGHT(x,22))
 #define EP1(x) (ROTRIGHT(x,6) ^ ROTRIGHT(x,11) ^ ROTRIGHT(x,25))
 #define SIG0(x) (ROTRIGHT(x,7) ^ ROTRIGHT(x,18) ^ ((x) >> 3))
@@ -41,19 +42,46 @@ static const uint32_t k[64] = {
 };
 
 
+// Message schedule word i of a block, kept in a ring of 16 words.
+#define M(i) m[(i) & 15]
+#define MSCHED(i) (M(i) += SIG1(M((i) - 2)) + M((i) - 7) + SIG0(M((i) - 15)))
+
+// One round. The working variables are renamed from round to round instead of being moved.
+#define ROUND(a,b,c,d,e,f,g,h,i,w)                                                          \
+    do {                                                                                    \
+        uint32_t t1 = (h) + EP1(e) + CH(e,f,g) + k[i] + (w);                                \
+        (d) += t1;                                                                          \
+        (h)  = t1 + EP0(a) + MAJ(a,b,c);                                                    \
+    } while (0)
+
+#define ROUNDS_8(i, W)                                                                      \
+    do {                                                                                    \
+        ROUND(a, b, c, d, e, f, g, h, (i) + 0, W((i) + 0));                                 \
+        ROUND(h, a, b, c, d, e, f, g, (i) + 1, W((i) + 1));                                 \
+        ROUND(g, h, a, b, c, d, e, f, (i) + 2, W((i) + 2));                                 \
+        ROUND(f, g, h, a, b, c, d, e, (i) + 3, W((i) + 3));                                 \
+        ROUND(e, f, g, h, a, b, c, d, (i) + 4, W((i) + 4));                                 \
+        ROUND(d, e, f, g, h, a, b, c, (i) + 5, W((i) + 5));                                 \
+        ROUND(c, d, e, f, g, h, a, b, (i) + 6, W((i) + 6));                                 \
+        ROUND(b, c, d, e, f, g, h, a, (i) + 7, W((i) + 7));                                 \
+    } while (0)
+
+
 /**@brief Function for calculating the hash of a 64-byte section of data.
+ *
+ * @details Eight rounds are unrolled so that the working variables rotate by renaming, and
+ *          the message schedule is computed in a 16-word ring as it is used (64 bytes of stack
+ *          instead of 256).
  *
  * @param[in,out] ctx   Hash instance.
  * @param[in]     data  Aray with data to be hashed. Assumed to be 64 bytes long.
  */
 void sha256_transform(sha256_context_t *ctx, const uint8_t * data)
 {
-    uint32_t a, b, c, d, e, f, g, h, i, j, t1, t2, m[64];
+    uint32_t a, b, c, d, e, f, g, h, i, m[16];
 
-    for (i = 0, j = 0; i < 16; ++i, j += 4)
-        m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
-    for ( ; i < 64; ++i)
-        m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
+    for (i = 0; i < 16; ++i, data += 4)
+        m[i] = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
 
     a = ctx->state[0];
     b = ctx->state[1];
@@ -64,17 +92,10 @@ void sha256_transform(sha256_context_t *ctx, const uint8_t * data)
     g = ctx->state[6];
     h = ctx->state[7];
 
-    for (i = 0; i < 64; ++i) {
-        t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[i];
-        t2 = EP0(a) + MAJ(a,b,c);
-        h = g;
-        g = f;
-        f = e;
-        e = d + t1;
-        d = c;
-        c = b;
-        b = a;
-        a = t1 + t2;
+    ROUNDS_8(0, M);
+    ROUNDS_8(8, M);
+    for (i = 16; i < 64; i += 8) {
+        ROUNDS_8(i, MSCHED);
     }
 
     ctx->state[0] += a;
@@ -115,11 +136,22 @@ ret_code_t sha256_update(sha256_context_t *ctx, const uint8_t * data, size_t len
         return NRF_ERROR_NULL;
     }
 
-    uint32_t i;
+    // Top up a partial block, then hash whole blocks straight from the data.
+    while (len > 0) {
+        if ((ctx->datalen == 0) && (len >= 64)) {
+            sha256_transform(ctx, data);
+            ctx->bitlen += 512;
+            data += 64;
+            len  -= 64;
+            continue;
+        }
+
+        size_t chunk = MIN(len, 64 - ctx->datalen);
 
-    for (i = 0; i < len; ++i) {
-        ctx->data[ctx->datalen] = data[i];
-        ctx->datalen++;
+        memcpy(&ctx->data[ctx->datalen], data, chunk);
+        ctx->datalen += chunk;
+        data += chunk;
+        len  -= chunk;
         if (ctx->datalen == 64) {
             sha256_transform(ctx, ctx->data);
             ctx->bitlen += 512;
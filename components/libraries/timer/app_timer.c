@@ -38,6 +38,14 @@ STATIC_ASSERT(RTC1_IRQ_PRI == SWI_IRQ_PRI);
 
 #define MODULE_INITIALIZED (m_op_queue.p_user_op_queue != NULL) /**< Macro designating whether the module has been initialized properly. */
 
+#ifndef APP_TIMER_HEAP_SIZE
+#define APP_TIMER_HEAP_SIZE     0                                           /**< Timers kept in a binary heap instead of the sorted list, 0 for the list. */
+#endif
+
+#if APP_TIMER_HEAP_SIZE > 255
+#error "APP_TIMER_HEAP_SIZE must fit the 8-bit heap index"
+#endif
+
 /**@brief Timer node type. The nodes will be used form a linked list of running timers. */
 typedef struct
 {
@@ -49,7 +57,7 @@ typedef struct
     app_timer_mode_t            mode;                                       /**< Timer mode. */
     app_timer_timeout_handler_t p_timeout_handler;                          /**< Pointer to function to be executed when the timer expires. */
     void *                      p_context;                                  /**< General purpose pointer. Will be passed to the timeout handler when the timer expires. */
-    void *                      next;                                       /**< Pointer to the next node. */
+    void *                      next;                                       /**< Pointer to the next node. With APP_TIMER_HEAP_SIZE, the index in the heap while the timer is in it. */
 } timer_node_t;
 
 STATIC_ASSERT(sizeof(timer_node_t) == APP_TIMER_NODE_SIZE);
@@ -117,6 +125,15 @@ static bool                          m_rtc1_reset;
 static uint8_t                       m_max_user_op_queue_utilization;           /**< Maximum observed timer user operations queue utilization. */
 #endif
 
+#if APP_TIMER_HEAP_SIZE
+/* In the heap, ticks_to_expire is the expiry tick counted from m_ticks_total, so nothing has to be
+ * rewritten when time moves on; mp_timer_id_head is m_heap[0]. */
+static timer_node_t *                m_heap[APP_TIMER_HEAP_SIZE];               /**< Running timers, a binary min-heap on the expiry tick. */
+static uint8_t                       m_heap_count;                              /**< Timers in m_heap. */
+static uint8_t                       m_timers_created;                          /**< Timers created, each may need a place in m_heap. */
+static uint32_t                      m_ticks_total;                             /**< Ticks consumed by expired_timers_handler since init. */
+#endif
+
 /**@brief Function for initializing the RTC1 counter.
  *
  * @param[in] prescaler   Value of the RTC1 PRESCALER register. Set to 0 for no prescaling.
@@ -196,6 +213,131 @@ static __INLINE void rtc1_compare0_set(uint32_t value)
 }
 
 
+#if APP_TIMER_HEAP_SIZE
+/**@brief Ticks from m_ticks_total to the expiry of a timer in the heap. */
+static __INLINE uint32_t heap_key(timer_node_t const * p_timer)
+{
+    return p_timer->ticks_to_expire - m_ticks_total;
+}
+
+
+static __INLINE void heap_set(uint8_t index, timer_node_t * p_timer)
+{
+    m_heap[index] = p_timer;
+    p_timer->next = (void *)(uint32_t)index;
+}
+
+
+static void heap_sift_up(uint8_t index)
+{
+    timer_node_t * p_timer = m_heap[index];
+    uint32_t       key     = heap_key(p_timer);
+
+    while (index > 0)
+    {
+        uint8_t parent = (index - 1) / 2;
+
+        if (heap_key(m_heap[parent]) <= key)
+        {
+            break;
+        }
+        heap_set(index, m_heap[parent]);
+        index = parent;
+    }
+    heap_set(index, p_timer);
+}
+
+
+static void heap_sift_down(uint8_t index)
+{
+    timer_node_t * p_timer = m_heap[index];
+    uint32_t       key     = heap_key(p_timer);
+
+    for (;;)
+    {
+        uint8_t child = 2 * index + 1;
+
+        if (child >= m_heap_count)
+        {
+            break;
+        }
+        if ((child + 1 < m_heap_count) && (heap_key(m_heap[child + 1]) < heap_key(m_heap[child])))
+        {
+            child++;
+        }
+        if (key <= heap_key(m_heap[child]))
+        {
+            break;
+        }
+        heap_set(index, m_heap[child]);
+        index = child;
+    }
+    heap_set(index, p_timer);
+}
+
+
+/**@brief Function for taking a timer out of the heap.
+ *
+ * @param[in]  index   Index of the timer in the heap.
+ */
+static void heap_remove(uint8_t index)
+{
+    timer_node_t * p_last = m_heap[--m_heap_count];
+
+    if (index < m_heap_count)
+    {
+        heap_set(index, p_last);
+        if ((index > 0) && (heap_key(p_last) < heap_key(m_heap[(index - 1) / 2])))
+        {
+            heap_sift_up(index);
+        }
+        else
+        {
+            heap_sift_down(index);
+        }
+    }
+    mp_timer_id_head = (m_heap_count != 0) ? m_heap[0] : NULL;
+}
+
+
+/**@brief Function for inserting a timer in the timer heap.
+ *
+ * @param[in]  p_timer   Timer to insert, ticks_to_expire counted from m_ticks_total.
+ */
+static void timer_list_insert(timer_node_t * p_timer)
+{
+    p_timer->ticks_to_expire += m_ticks_total;
+    m_heap[m_heap_count] = p_timer;
+    heap_sift_up(m_heap_count++);
+    mp_timer_id_head = m_heap[0];
+}
+
+
+/**@brief Function for removing a timer from the timer heap.
+ *
+ * @param[in]  p_timer   Timer to remove.
+ */
+static void timer_list_remove(timer_node_t * p_timer)
+{
+    uint32_t index = (uint32_t)p_timer->next;
+
+    // Timer not in the heap.
+    if ((index >= m_heap_count) || (m_heap[index] != p_timer))
+    {
+        return;
+    }
+
+    heap_remove((uint8_t)index);
+
+    // No more timers in the heap. Reset RTC1 in case Start timer operations are present in the queue.
+    if (m_heap_count == 0)
+    {
+        NRF_RTC1->TASKS_CLEAR = 1;
+        m_ticks_latest        = 0;
+        m_rtc1_reset          = true;
+    }
+}
+#else
 /**@brief Function for inserting a timer in the timer list.
  *
  * @param[in]  timer_id   Id of timer to insert.
@@ -302,6 +444,7 @@ static void timer_list_remove(timer_node_t * p_timer)
         p_current->ticks_to_expire += timeout;
     }
 }
+#endif // APP_TIMER_HEAP_SIZE
 
 
 /**@brief Function for scheduling a check for timeouts by generating a RTC1 interrupt.
@@ -346,8 +489,6 @@ static void timer_timeouts_check(void)
     // Handle expired of timer
     if (mp_timer_id_head != NULL)
     {
-        timer_node_t *  p_timer;
-        timer_node_t *  p_previous_timer;
         uint32_t        ticks_elapsed;
         uint32_t        ticks_expired;
 
@@ -357,6 +498,40 @@ static void timer_timeouts_check(void)
         // ticks_elapsed is collected here, job will use it.
         ticks_elapsed = ticks_diff_get(rtc1_counter_get(), m_ticks_latest);
 
+#if APP_TIMER_HEAP_SIZE
+        // The heap is only reordered by timer_list_handler. Run the handlers in expiry order,
+        // a few timers expire at once at most.
+        for (;;)
+        {
+            timer_node_t * p_next = NULL;
+
+            for (uint8_t i = 0; i < m_heap_count; i++)
+            {
+                timer_node_t * p_timer = m_heap[i];
+                uint32_t       key     = heap_key(p_timer);
+
+                if (key > ticks_elapsed)
+                {
+                    continue;
+                }
+                ticks_expired = MAX(ticks_expired, key);
+                if (p_timer->is_running && ((p_next == NULL) || (key < heap_key(p_next))))
+                {
+                    p_next = p_timer;
+                }
+            }
+
+            if (p_next == NULL)
+            {
+                break;
+            }
+            p_next->is_running = false;
+            timeout_handler_exec(p_next);
+        }
+#else
+        timer_node_t *  p_timer;
+        timer_node_t *  p_previous_timer;
+
         // Auto variable containing the head of timers expiring.
         p_timer = mp_timer_id_head;
 
@@ -384,6 +559,7 @@ static void timer_timeouts_check(void)
                 timeout_handler_exec(p_previous_timer);
             }
         }
+#endif // APP_TIMER_HEAP_SIZE
 
         // Prepare to queue the ticks expired in the m_ticks_elapsed queue.
         if (m_ticks_elapsed_q_read_ind == m_ticks_elapsed_q_write_ind)
@@ -475,6 +651,13 @@ static bool list_deletions_handler(void)
 
             case TIMER_USER_OP_TYPE_STOP_ALL:
                 // Delete list of running timers, and mark all timers as not running.
+#if APP_TIMER_HEAP_SIZE
+                while (m_heap_count != 0)
+                {
+                    m_heap[--m_heap_count]->is_running = false;
+                }
+                mp_timer_id_head = NULL;
+#else
                 while (mp_timer_id_head != NULL)
                 {
                     timer_node_t * p_head = mp_timer_id_head;
@@ -482,6 +665,7 @@ static bool list_deletions_handler(void)
                     p_head->is_running = false;
                     mp_timer_id_head    = p_head->next;
                 }
+#endif
                 break;
 
             default:
@@ -507,6 +691,33 @@ static void expired_timers_handler(uint32_t         ticks_elapsed,
 {
     uint32_t ticks_expired = 0;
 
+#if APP_TIMER_HEAP_SIZE
+    while (m_heap_count != 0)
+    {
+        timer_node_t * p_timer = m_heap[0];
+
+        // Do nothing if timer did not expire
+        if (ticks_elapsed < heap_key(p_timer))
+        {
+            break;
+        }
+
+        ticks_expired = heap_key(p_timer);
+        heap_remove(0);
+
+        // Timer will be restarted if periodic.
+        if (p_timer->ticks_periodic_interval != 0)
+        {
+            p_timer->ticks_at_start       = (ticks_previous + ticks_expired) & MAX_RTC_COUNTER_VAL;
+            p_timer->ticks_first_interval = p_timer->ticks_periodic_interval;
+            p_timer->next                 = *p_restart_list_head;
+            *p_restart_list_head          = p_timer;
+        }
+    }
+
+    // The keys of the timers left stay put, only the base moves.
+    m_ticks_total += ticks_elapsed;
+#else
     while (mp_timer_id_head != NULL)
     {
         timer_node_t * p_timer;
@@ -542,6 +753,7 @@ static void expired_timers_handler(uint32_t         ticks_elapsed,
             *p_restart_list_head          = p_timer_expired;
         }
     }
+#endif // APP_TIMER_HEAP_SIZE
 }
 
 
@@ -641,7 +853,11 @@ static void compare_reg_update(timer_node_t * p_timer_id_head_old)
     // Setup the timeout for timers on the head of the list
     if (mp_timer_id_head != NULL)
     {
+#if APP_TIMER_HEAP_SIZE
+        uint32_t ticks_to_expire = heap_key(mp_timer_id_head);
+#else
         uint32_t ticks_to_expire = mp_timer_id_head->ticks_to_expire;
+#endif
         uint32_t pre_counter_val = rtc1_counter_get();
         uint32_t cc              = m_ticks_latest;
         uint32_t ticks_elapsed   = ticks_diff_get(pre_counter_val, cc) + RTC_COMPARE_OFFSET_MIN;
@@ -702,7 +918,7 @@ static void timer_list_handler(void)
         uint8_t size = m_op_queue.size;
         uint8_t first = m_op_queue.first;
         uint8_t last = m_op_queue.last;
-        uint8_t utilization = (first <= last) ? (last - first) : (size + 1 - first + last);
+        uint8_t utilization = (first <= last) ? (last - first) : (size - first + last);
 
         if (utilization > m_max_user_op_queue_utilization)
         {
@@ -924,6 +1140,10 @@ uint32_t app_timer_init(uint32_t                      prescaler,
     m_op_queue.p_user_op_queue = p_buffer;
 
     mp_timer_id_head            = NULL;
+#if APP_TIMER_HEAP_SIZE
+    m_heap_count                = 0;
+    m_ticks_total               = 0;
+#endif
     m_ticks_elapsed_q_read_ind  = 0;
     m_ticks_elapsed_q_write_ind = 0;
 
@@ -964,6 +1184,20 @@ uint32_t app_timer_create(app_timer_id_t const *      p_timer_id,
     }
 
     timer_node_t * p_node     = (timer_node_t *)*p_timer_id;
+
+#if APP_TIMER_HEAP_SIZE
+    // A timer that was never created has no handler yet. Counting here means a start
+    // never finds the heap full.
+    if (p_node->p_timeout_handler == NULL)
+    {
+        if (m_timers_created == APP_TIMER_HEAP_SIZE)
+        {
+            return NRF_ERROR_NO_MEM;
+        }
+        m_timers_created++;
+    }
+#endif
+
     p_node->is_running        = false;
     p_node->mode              = mode;
     p_node->p_timeout_handler = timeout_handler;
@@ -1041,6 +1275,23 @@ uint32_t app_timer_cnt_diff_compute(uint32_t   ticks_to,
     return NRF_SUCCESS;
 }
 
+
+uint32_t app_timer_ticks_to_expiry_get(void)
+{
+    uint32_t ticks = MAX_RTC_COUNTER_VAL;
+
+    CRITICAL_REGION_ENTER();
+    if ((mp_timer_id_head != NULL) && m_rtc1_running)
+    {
+        // CC[0] holds the expiry of the first timer, see compare_reg_update().
+        ticks = (NRF_RTC1->EVENTS_COMPARE[0] != 0) ? 0 :
+                ticks_diff_get(NRF_RTC1->CC[0], rtc1_counter_get());
+    }
+    CRITICAL_REGION_EXIT();
+
+    return ticks;
+}
+
 #if APP_TIMER_WITH_PROFILER
 uint8_t app_timer_op_queue_utilization_get(void)
 {
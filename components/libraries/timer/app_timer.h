@@ -201,6 +201,7 @@ uint32_t app_timer_init(uint32_t                      prescaler,
  * @retval     NRF_ERROR_INVALID_PARAM   If a parameter was invalid.
  * @retval     NRF_ERROR_INVALID_STATE   If the application timer module has not been initialized or
  *                                       the timer is running.
+ * @retval     NRF_ERROR_NO_MEM          If APP_TIMER_HEAP_SIZE timers have been created already.
  *
  * @note This function does the timer allocation in the caller's context. It is also not protected
  *       by a critical region. Therefore care must be taken not to call it from several interrupt
@@ -274,6 +275,15 @@ uint32_t app_timer_cnt_diff_compute(uint32_t   ticks_to,
                                     uint32_t   ticks_from,
                                     uint32_t * p_ticks_diff);
 
+/**@brief Function for getting the time left until the first running timer expires.
+ *
+ * @details Operations still in the queue are not taken into account; their interrupt is
+ *          pending, so sleeping ends at once anyway.
+ *
+ * @return    RTC1 ticks to the next expiry, 0 if it is due, or 0xFFFFFF when no timer runs.
+ */
+uint32_t app_timer_ticks_to_expiry_get(void);
+
 
 /**@brief Function for getting the maximum observed operation queue utilization.
  *
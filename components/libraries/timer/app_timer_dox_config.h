@@ -32,6 +32,19 @@
  */
 #define APP_TIMER_KEEPS_RTC_ACTIVE
 
+/** @brief Timers kept in a binary heap
+ *
+ * 0 keeps the running timers in a sorted list, where each start walks the list.
+ * Otherwise starts and expiries cost O(log n), and at most this many timers
+ * can be created; app_timer_create returns NRF_ERROR_NO_MEM beyond that.
+ *
+ *  Minimum value: 0
+ *  Maximum value: 255
+ *
+ * @note This is an NRF_CONFIG macro.
+ */
+#define APP_TIMER_HEAP_SIZE
+
 
 
 /** @} */
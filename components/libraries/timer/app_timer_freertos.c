@@ -37,6 +37,8 @@
  */
 #define APP_TIMER_WAIT_FOR_QUEUE 2
 
+#define MAX_RTC_COUNTER_VAL     0x00FFFFFF  /**< Counter values wrap like the RTC1 of app_timer. */
+
 /**@brief This structure keeps information about osTimer.*/
 typedef struct
 {
@@ -210,7 +212,7 @@ uint32_t app_timer_stop(app_timer_id_t timer_id)
     if (__get_IPSR() != 0)
     {
         BaseType_t yieldReq = pdFALSE;
-        if (xTimerStopFromISR(timer_id, &yieldReq) != pdPASS)
+        if (xTimerStopFromISR(hTimer, &yieldReq) != pdPASS)
         {
             return NRF_ERROR_NO_MEM;
         }
@@ -218,7 +220,7 @@ uint32_t app_timer_stop(app_timer_id_t timer_id)
     }
     else
     {
-        if (xTimerStop(timer_id, APP_TIMER_WAIT_FOR_QUEUE) != pdPASS)
+        if (xTimerStop(hTimer, APP_TIMER_WAIT_FOR_QUEUE) != pdPASS)
         {
             return NRF_ERROR_NO_MEM;
         }
@@ -227,4 +229,33 @@ uint32_t app_timer_stop(app_timer_id_t timer_id)
     pinfo->active = false;
     return NRF_SUCCESS;
 }
+
+
+uint32_t app_timer_cnt_get(void)
+{
+    uint32_t   rtc_prescaler = portNRF_RTC_REG->PRESCALER + 1;
+    TickType_t ticks;
+
+    if (__get_IPSR() != 0)
+    {
+        ticks = xTaskGetTickCountFromISR();
+    }
+    else
+    {
+        ticks = xTaskGetTickCount();
+    }
+
+    /* The system tick in the units of the prescaler set by the user, so the resolution is
+     * that of configTICK_RATE_HZ. */
+    return (uint32_t)(((uint64_t)ticks * rtc_prescaler) / m_prescaler) & MAX_RTC_COUNTER_VAL;
+}
+
+
+uint32_t app_timer_cnt_diff_compute(uint32_t   ticks_to,
+                                    uint32_t   ticks_from,
+                                    uint32_t * p_ticks_diff)
+{
+    *p_ticks_diff = ((ticks_to - ticks_from) & MAX_RTC_COUNTER_VAL);
+    return NRF_SUCCESS;
+}
 #endif //NRF_MODULE_ENABLED(APP_TIMER)
@@ -15,6 +15,7 @@
 #include "app_fifo.h"
 #include "nrf_drv_uart.h"
 #include "nrf_assert.h"
+#include "app_util_platform.h"
 
 static nrf_drv_uart_t app_uart_inst = NRF_DRV_UART_INSTANCE(APP_UART_DRIVER_INSTANCE);
 
@@ -28,13 +29,29 @@ static __INLINE uint32_t fifo_length(app_fifo_t * const fifo)
 
 
 static app_uart_event_handler_t   m_event_handler;            /**< Event handler function. */
-static uint8_t tx_buffer[1];
 static uint8_t rx_buffer[1];
 static bool m_rx_ovf;
 
 static app_fifo_t                  m_rx_fifo;                               /**< RX FIFO buffer for storing data received on the UART until the application fetches them using app_uart_get(). */
 static app_fifo_t                  m_tx_fifo;                               /**< TX FIFO buffer for storing data to be transmitted on the UART when TXD is ready. Data is put to the buffer on using app_uart_put(). */
 
+/**@brief Start sending the next contiguous span of the TX FIFO, in place.
+ *
+ * @details The bytes stay in the FIFO until the TX_DONE event releases them.
+ */
+static uint32_t tx_span_start(void)
+{
+    uint8_t * p_span;
+    uint32_t  len;
+
+    if (app_fifo_read_span_get(&m_tx_fifo, &p_span, &len) != NRF_SUCCESS)
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+    return nrf_drv_uart_tx(&app_uart_inst, p_span, (uint8_t)MIN(len, UINT8_MAX));
+}
+
+
 static void uart_event_handler(nrf_drv_uart_event_t * p_event, void* p_context)
 {
     app_uart_evt_t app_uart_event;
@@ -79,12 +96,9 @@ static void uart_event_handler(nrf_drv_uart_event_t * p_event, void* p_context)
             break;
 
         case NRF_DRV_UART_EVT_TX_DONE:
-            // Get next byte from FIFO.
-            if (app_fifo_get(&m_tx_fifo, tx_buffer) == NRF_SUCCESS)
-            {
-                (void)nrf_drv_uart_tx(&app_uart_inst, tx_buffer, 1);
-            }
-            else
+            // Release the bytes sent and go on with the next span of the FIFO.
+            (void)app_fifo_read_span_release(&m_tx_fifo, p_event->data.rxtx.bytes);
+            if (tx_span_start() != NRF_SUCCESS)
             {
                 // Last byte from FIFO transmitted, notify the application.
                 app_uart_event.evt_type = APP_UART_TX_EMPTY;
@@ -198,18 +212,20 @@ uint32_t app_uart_put(uint8_t byte)
         // The new byte has been added to FIFO. It will be picked up from there
         // (in 'uart_event_handler') when all preceding bytes are transmitted.
         // But if UART is not transmitting anything at the moment, we must start
-        // a new transmission here.
+        // a new transmission here. The check and the start go together, so that
+        // a TX_DONE in between does not send the same span twice.
+        CRITICAL_REGION_ENTER();
         if (!nrf_drv_uart_tx_in_progress(&app_uart_inst))
         {
-            // This operation should be almost always successful, since we've
-            // just added a byte to FIFO, but if some bigger delay occurred
-            // (some heavy interrupt handler routine has been executed) since
-            // that time, FIFO might be empty already.
-            if (app_fifo_get(&m_tx_fifo, tx_buffer) == NRF_SUCCESS)
+            uint32_t tx_err_code = tx_span_start();
+
+            // The FIFO may be empty already if the TX_DONE came first.
+            if (tx_err_code != NRF_ERROR_NOT_FOUND)
             {
-                err_code = nrf_drv_uart_tx(&app_uart_inst, tx_buffer, 1);
+                err_code = tx_err_code;
             }
         }
+        CRITICAL_REGION_EXIT();
     }
     return err_code;
 }
@@ -135,7 +135,17 @@ void app_util_critical_region_exit (uint8_t nested);
  *       CRITICAL_REGION_EXIT() for each call to CRITICAL_REGION_ENTER(), and they must be located
  *       in the same scope.
  */
-#ifdef SOFTDEVICE_PRESENT
+#if defined(SOFTDEVICE_PRESENT) && defined(CRIT_PROF_ENABLED) && CRIT_PROF_ENABLED && !defined(CRIT_PROF_SKIP)
+/* Timed per call site, see crit_prof.h. */
+#include "crit_prof.h"
+#define CRITICAL_REGION_ENTER()                                                             \
+    {                                                                                       \
+        static uint8_t __CR_SLOT;                                                           \
+        uint8_t        __CR_NESTED = 0;                                                     \
+        uint32_t       __CR_START;                                                          \
+        app_util_critical_region_enter(&__CR_NESTED);                                       \
+        __CR_START = crit_prof_enter();
+#elif defined(SOFTDEVICE_PRESENT)
 #define CRITICAL_REGION_ENTER()                                                             \
     {                                                                                       \
         uint8_t __CR_NESTED = 0;                                                            \
@@ -150,7 +160,12 @@ void app_util_critical_region_exit (uint8_t nested);
  *       CRITICAL_REGION_EXIT() for each call to CRITICAL_REGION_ENTER(), and they must be located
  *       in the same scope.
  */
-#ifdef SOFTDEVICE_PRESENT
+#if defined(SOFTDEVICE_PRESENT) && defined(CRIT_PROF_ENABLED) && CRIT_PROF_ENABLED && !defined(CRIT_PROF_SKIP)
+#define CRITICAL_REGION_EXIT()                                                              \
+        crit_prof_exit(&__CR_SLOT, __FILE__, __LINE__, __CR_START, __CR_NESTED);            \
+        app_util_critical_region_exit(__CR_NESTED);                                         \
+    }
+#elif defined(SOFTDEVICE_PRESENT)
 #define CRITICAL_REGION_EXIT()                                                              \
         app_util_critical_region_exit(__CR_NESTED);                                         \
     }
@@ -149,6 +149,109 @@ ret_code_t nfc_ndef_msg_record_add(nfc_ndef_msg_desc_t    * const p_msg,
  */
 #define NFC_NDEF_NESTED_NDEF_MSG_RECORD(NAME) (NAME##_ndef_record_nested_desc)
 
+/**
+ * @defgroup nfc_ndef_const_msg Constant NDEF messages
+ * @{
+ *
+ * @brief Macros for laying out a fixed NDEF message at compile time, as constant data.
+ *
+ * A message whose records never change does not need descriptors and payload constructors.
+ * Each record is a structure of bytes, already encoded, and the message is a structure of
+ * records:
+ *
+ * @code
+ * static const struct
+ * {
+ *     NFC_NDEF_CONST_URI_REC_T(URL)  uri;
+ *     NFC_NDEF_CONST_AAR_REC_T(PKG)  aar;
+ * } m_msg =
+ * {
+ *     NFC_NDEF_CONST_URI_REC(NDEF_FIRST_RECORD, NFC_URI_HTTPS, URL),
+ *     NFC_NDEF_CONST_AAR_REC(NDEF_LAST_RECORD, PKG),
+ * };
+ * @endcode
+ *
+ * The bytes of m_msg, sizeof(m_msg) of them, are the encoded message, without the NLEN field of
+ * Type 4 Tags. All members are bytes, so the structures have no padding. The string arguments
+ * must be string literals; their terminating NUL is not part of the record. Records are short
+ * records, so each payload must stay below 256 bytes.
+ */
+
+/**@brief Flags byte of a short record without ID. */
+#define NFC_NDEF_CONST_REC_FLAGS(LOCATION, TNF)  ((uint8_t)((LOCATION) | NDEF_RECORD_SR_MASK | (TNF)))
+
+/**@brief Type of a URI record of @p URI, without its prefix. */
+#define NFC_NDEF_CONST_URI_REC_T(URI)            \
+    struct                                       \
+    {                                            \
+        uint8_t hdr[4];                          \
+        uint8_t uri_id;                          \
+        char    uri[sizeof(URI) - 1];            \
+    }
+
+/**@brief Initializer of a URI record.
+ *
+ * @param[in] LOCATION  @ref nfc_ndef_record_location_t of the record in the message.
+ * @param[in] URI_ID    Prefix code, @ref nfc_uri_id_t.
+ * @param[in] URI       The rest of the URI.
+ */
+#define NFC_NDEF_CONST_URI_REC(LOCATION, URI_ID, URI)                              \
+    {                                                                              \
+        { NFC_NDEF_CONST_REC_FLAGS(LOCATION, TNF_WELL_KNOWN), 1, sizeof(URI), 'U' }, \
+        (URI_ID),                                                                  \
+        URI                                                                        \
+    }
+
+/**@brief Type of a UTF-8 Text record of @p TEXT in language @p LANG. */
+#define NFC_NDEF_CONST_TEXT_REC_T(LANG, TEXT)    \
+    struct                                       \
+    {                                            \
+        uint8_t hdr[4];                          \
+        uint8_t status;                          \
+        char    lang[sizeof(LANG) - 1];          \
+        char    text[sizeof(TEXT) - 1];          \
+    }
+
+/**@brief Initializer of a UTF-8 Text record.
+ *
+ * @param[in] LOCATION  @ref nfc_ndef_record_location_t of the record in the message.
+ * @param[in] LANG      IANA language code, e.g. "en".
+ * @param[in] TEXT      The text.
+ */
+#define NFC_NDEF_CONST_TEXT_REC(LOCATION, LANG, TEXT)                                  \
+    {                                                                                  \
+        { NFC_NDEF_CONST_REC_FLAGS(LOCATION, TNF_WELL_KNOWN), 1,                       \
+          sizeof(LANG) + sizeof(TEXT) - 1, 'T' },                                      \
+        (uint8_t)(sizeof(LANG) - 1),                                                   \
+        LANG,                                                                          \
+        TEXT                                                                           \
+    }
+
+/**@brief Type of an Android Application Record of package @p PKG. */
+#define NFC_NDEF_CONST_AAR_REC_T(PKG)            \
+    struct                                       \
+    {                                            \
+        uint8_t hdr[3];                          \
+        char    type[15];                        \
+        char    pkg[sizeof(PKG) - 1];            \
+    }
+
+/**@brief Initializer of an Android Application Record.
+ *
+ * @param[in] LOCATION  @ref nfc_ndef_record_location_t of the record in the message.
+ * @param[in] PKG       Android package name.
+ */
+#define NFC_NDEF_CONST_AAR_REC(LOCATION, PKG)                                      \
+    {                                                                              \
+        { NFC_NDEF_CONST_REC_FLAGS(LOCATION, TNF_EXTERNAL_TYPE), 15, sizeof(PKG) - 1 }, \
+        "android.com:pkg",                                                         \
+        PKG                                                                        \
+    }
+
+/**
+ * @}
+ */
+
 /**
  * @}
  */
@@ -586,6 +586,287 @@ ret_code_t type_2_tag_parse(type_2_tag_t * p_type_2_tag, uint8_t * p_raw_data)
 }
 
 
+/**
+ * @brief Function for checking if the value of a TLV block is kept by the incremental parser.
+ *
+ * @param[in]     tag  Tag field of the TLV block.
+ *
+ * @retval        TRUE   If the value is copied into the value buffer.
+ * @retval        FALSE  If the value is skipped.
+ *
+ */
+static bool type_2_tag_stream_is_value_kept(uint8_t tag)
+{
+    return (tag == TLV_NDEF_MESSAGE) || (tag == TLV_LOCK_CONTROL) || (tag == TLV_MEMORY_CONTROL);
+}
+
+
+/**
+ * @brief Function for handling a complete length field in the incremental parser.
+ *
+ * This function checks the length, reserves room for the value field or skips it, and inserts
+ * the block once nothing more has to be copied.
+ *
+ * @param[in,out] p_stream  Parser instance, with the offset pointing at the value field.
+ *
+ * @retval        NRF_SUCCESS  If the length is correct. Otherwise, an error code is returned.
+ *
+ */
+static ret_code_t type_2_tag_stream_length_done(type_2_tag_stream_t * p_stream)
+{
+    tlv_block_t * p_block = &p_stream->block;
+
+    if (!tlv_block_is_data_length_correct(p_block))
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    p_stream->state = T2T_STREAM_TLV_TAG;
+
+    if (p_block->length == 0)
+    {
+        return type_2_tag_tlv_block_insert(p_stream->p_type_2_tag, p_block);
+    }
+
+    if (!type_2_tag_is_field_within_data_range(p_stream->p_type_2_tag,
+                                               p_stream->offset,
+                                               p_block->length))
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    if (!type_2_tag_stream_is_value_kept(p_block->tag))
+    {
+        // Skip the value, the reader does not have to fetch it.
+        p_stream->offset += p_block->length;
+        return type_2_tag_tlv_block_insert(p_stream->p_type_2_tag, p_block);
+    }
+
+    if (p_block->length > p_stream->value_buf_size - p_stream->value_buf_used)
+    {
+        NRF_LOG_WARNING("Warning! Not enough memory to store the TLV value!\r\n");
+        return NRF_ERROR_NO_MEM;
+    }
+
+    p_block->p_value          = p_stream->p_value_buf + p_stream->value_buf_used;
+    p_stream->value_buf_used += p_block->length;
+    p_stream->value_left      = p_block->length;
+    p_stream->state           = T2T_STREAM_TLV_VALUE;
+
+    return NRF_SUCCESS;
+}
+
+
+/**
+ * @brief Function for consuming raw data in the current state of the incremental parser.
+ *
+ * @param[in,out] p_stream    Parser instance.
+ * @param[in]     p_data      Raw data starting at the parser offset.
+ * @param[in]     available   Number of bytes in @p p_data, at least 1.
+ * @param[out]    p_consumed  Number of bytes consumed from @p p_data.
+ *
+ * @retval        NRF_SUCCESS  If the data was consumed. Otherwise, an error code is returned.
+ *
+ */
+static ret_code_t type_2_tag_stream_step(type_2_tag_stream_t * p_stream,
+                                         uint8_t const       * p_data,
+                                         uint16_t              available,
+                                         uint16_t            * p_consumed)
+{
+    ret_code_t    err_code = NRF_SUCCESS;
+    tlv_block_t * p_block  = &p_stream->block;
+    uint16_t      n        = 1;
+
+    switch (p_stream->state)
+    {
+        case T2T_STREAM_HEADER:
+            n = MIN(available, T2T_FIRST_DATA_BLOCK_OFFSET - p_stream->offset);
+            memcpy(&p_stream->header[p_stream->offset], p_data, n);
+            if (p_stream->offset + n < T2T_FIRST_DATA_BLOCK_OFFSET)
+            {
+                break;
+            }
+
+            err_code = type_2_tag_internal_parse(p_stream->p_type_2_tag, p_stream->header);
+            if (err_code != NRF_SUCCESS)
+            {
+                break;
+            }
+            err_code = type_2_tag_cc_parse(p_stream->p_type_2_tag, p_stream->header);
+            if (err_code != NRF_SUCCESS)
+            {
+                break;
+            }
+            if (!type_2_tag_is_version_supported(p_stream->p_type_2_tag))
+            {
+                err_code = NRF_ERROR_NOT_SUPPORTED;
+                break;
+            }
+            p_stream->state = T2T_STREAM_TLV_TAG;
+            break;
+
+        case T2T_STREAM_TLV_TAG:
+            if (!type_2_tag_is_field_within_data_range(p_stream->p_type_2_tag,
+                                                       p_stream->offset,
+                                                       TLV_T_LENGTH))
+            {
+                err_code = NRF_ERROR_INVALID_DATA;
+                break;
+            }
+            memset(p_block, 0, sizeof(tlv_block_t));
+            p_block->tag = p_data[0];
+
+            if (p_block->tag == TLV_TERMINATOR)
+            {
+                p_stream->state = T2T_STREAM_DONE;
+            }
+            else if (p_block->tag != TLV_NULL)
+            {
+                p_stream->state = T2T_STREAM_TLV_LENGTH;
+            }
+            break;
+
+        case T2T_STREAM_TLV_LENGTH:
+            if (!type_2_tag_is_field_within_data_range(p_stream->p_type_2_tag,
+                                                       p_stream->offset,
+                                                       TLV_L_SHORT_LENGTH))
+            {
+                err_code = NRF_ERROR_INVALID_DATA;
+                break;
+            }
+            if (p_data[0] == TLV_L_FORMAT_FLAG)
+            {
+                p_stream->length_bytes = 0;
+                p_stream->state        = T2T_STREAM_TLV_LENGTH_EXT;
+                break;
+            }
+            p_block->length   = p_data[0];
+            p_stream->offset += n;
+            n                 = 0;
+            err_code          = type_2_tag_stream_length_done(p_stream);
+            break;
+
+        case T2T_STREAM_TLV_LENGTH_EXT:
+            if (!type_2_tag_is_field_within_data_range(p_stream->p_type_2_tag,
+                                                       p_stream->offset,
+                                                       TLV_L_SHORT_LENGTH))
+            {
+                err_code = NRF_ERROR_INVALID_DATA;
+                break;
+            }
+            p_block->length = (p_block->length << 8) | p_data[0];
+            if (++p_stream->length_bytes < TLV_L_LONG_LENGTH - 1)
+            {
+                break;
+            }
+
+            // Long length value cannot be lower than 0xFF.
+            if (p_block->length < 0xFF)
+            {
+                err_code = NRF_ERROR_INVALID_DATA;
+                break;
+            }
+            p_stream->offset += n;
+            n                 = 0;
+            err_code          = type_2_tag_stream_length_done(p_stream);
+            break;
+
+        case T2T_STREAM_TLV_VALUE:
+            n = MIN(available, p_stream->value_left);
+            memcpy(p_block->p_value + (p_block->length - p_stream->value_left), p_data, n);
+            p_stream->value_left -= n;
+            if (p_stream->value_left == 0)
+            {
+                p_stream->state = T2T_STREAM_TLV_TAG;
+                err_code        = type_2_tag_tlv_block_insert(p_stream->p_type_2_tag, p_block);
+            }
+            break;
+
+        default:
+            n = available;
+            break;
+    }
+
+    *p_consumed = n;
+    return err_code;
+}
+
+
+void type_2_tag_stream_init(type_2_tag_stream_t * p_stream,
+                            type_2_tag_t        * p_type_2_tag,
+                            uint8_t             * p_value_buf,
+                            uint16_t              value_buf_size)
+{
+    memset(p_stream, 0, sizeof(type_2_tag_stream_t));
+
+    p_stream->p_type_2_tag   = p_type_2_tag;
+    p_stream->p_value_buf    = p_value_buf;
+    p_stream->value_buf_size = value_buf_size;
+    p_stream->state          = T2T_STREAM_HEADER;
+
+    type_2_tag_clear(p_type_2_tag);
+}
+
+
+ret_code_t type_2_tag_stream_feed(type_2_tag_stream_t * p_stream,
+                                  uint16_t              offset,
+                                  uint8_t const       * p_data,
+                                  uint16_t              length)
+{
+    ret_code_t err_code;
+    uint32_t   end = (uint32_t)offset + length;
+
+    if (offset > p_stream->offset)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    while ((p_stream->state != T2T_STREAM_DONE) && (p_stream->offset < end))
+    {
+        uint16_t consumed;
+
+        // Check if end of tag is reached (no terminator block was present).
+        if ((p_stream->state == T2T_STREAM_TLV_TAG) &&
+            type_2_tag_is_end_reached(p_stream->p_type_2_tag, p_stream->offset))
+        {
+            NRF_LOG_DEBUG("No terminator block was found in the tag!\r\n");
+            p_stream->state = T2T_STREAM_DONE;
+            break;
+        }
+
+        err_code = type_2_tag_stream_step(p_stream,
+                                          &p_data[p_stream->offset - offset],
+                                          end - p_stream->offset,
+                                          &consumed);
+        if (err_code != NRF_SUCCESS)
+        {
+            return err_code;
+        }
+        p_stream->offset += consumed;
+    }
+
+    if ((p_stream->state == T2T_STREAM_TLV_TAG) &&
+        type_2_tag_is_end_reached(p_stream->p_type_2_tag, p_stream->offset))
+    {
+        p_stream->state = T2T_STREAM_DONE;
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+bool type_2_tag_stream_is_done(type_2_tag_stream_t const * p_stream)
+{
+    return p_stream->state == T2T_STREAM_DONE;
+}
+
+
+uint16_t type_2_tag_stream_offset(type_2_tag_stream_t const * p_stream)
+{
+    return p_stream->offset;
+}
+
+
 void type_2_tag_printout(type_2_tag_t * p_type_2_tag)
 {
     uint32_t i;
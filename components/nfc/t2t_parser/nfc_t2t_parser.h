@@ -14,6 +14,7 @@
 #define NFC_TYPE_2_TAG_PARSER_H__
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "nfc_tlv_block.h"
 #include "sdk_errors.h"
 
@@ -148,6 +149,91 @@ void type_2_tag_clear(type_2_tag_t * p_type_2_tag);
  */
 ret_code_t type_2_tag_parse(type_2_tag_t * p_type_2_tag, uint8_t * p_raw_data);
 
+/**
+ * @brief States of the incremental Type 2 Tag parser.
+ */
+typedef enum
+{
+    T2T_STREAM_HEADER,          ///< Collecting the internal and Capability Container blocks.
+    T2T_STREAM_TLV_TAG,         ///< Expecting the tag field of a TLV block.
+    T2T_STREAM_TLV_LENGTH,      ///< Expecting the first byte of a length field.
+    T2T_STREAM_TLV_LENGTH_EXT,  ///< Expecting the two bytes of an extended length field.
+    T2T_STREAM_TLV_VALUE,       ///< Copying the value field.
+    T2T_STREAM_DONE             ///< Terminator or end of the data area reached.
+} type_2_tag_stream_state_t;
+
+/**
+ * @brief Incremental Type 2 Tag parser instance.
+ *
+ * Only the first 16 bytes of the tag and the values of NDEF Message, Lock Control and
+ * Memory Control TLV blocks are kept. Members are internal, use the functions below.
+ */
+typedef struct
+{
+    type_2_tag_t            * p_type_2_tag;     ///< Descriptor receiving the parsed data.
+    uint8_t                 * p_value_buf;      ///< Buffer receiving the kept TLV values.
+    uint16_t                  value_buf_size;   ///< Size of the value buffer.
+    uint16_t                  value_buf_used;   ///< Bytes of the value buffer in use.
+    uint16_t                  offset;           ///< Tag offset of the next byte the parser needs.
+    uint16_t                  value_left;       ///< Bytes of the current value field still to copy.
+    type_2_tag_stream_state_t state;            ///< Parser state.
+    tlv_block_t               block;            ///< TLV block being parsed.
+    uint8_t                   length_bytes;     ///< Bytes of an extended length field seen so far.
+    uint8_t                   header[T2T_FIRST_DATA_BLOCK_OFFSET]; ///< Internal and CC blocks.
+} type_2_tag_stream_t;
+
+/**
+ * @brief Function for starting an incremental parse of a Type 2 Tag.
+ *
+ * @param[out] p_stream         Parser instance.
+ * @param[out] p_type_2_tag     Pointer to the structure that will be filled with parsed data.
+ *                              It is cleared here.
+ * @param[in]  p_value_buf      Buffer for the TLV values that are kept. TLV block descriptors
+ *                              point into this buffer.
+ * @param[in]  value_buf_size   Size of @p p_value_buf.
+ */
+void type_2_tag_stream_init(type_2_tag_stream_t * p_stream,
+                            type_2_tag_t        * p_type_2_tag,
+                            uint8_t             * p_value_buf,
+                            uint16_t              value_buf_size);
+
+/**
+ * @brief Function for feeding raw tag data to the incremental parser.
+ *
+ * Data may be fed in chunks of any size, for example the 16 bytes returned by one READ
+ * command. Bytes before @ref type_2_tag_stream_offset are ignored, so overlapping chunks are
+ * fine. Values of TLV blocks that are not kept are skipped: the next offset jumps past them and
+ * the block is stored with its length and a NULL value pointer.
+ *
+ * @param[in,out] p_stream  Parser instance.
+ * @param[in]     offset    Tag byte offset of the first byte in @p p_data.
+ * @param[in]     p_data    Raw tag data.
+ * @param[in]     length    Number of bytes in @p p_data.
+ *
+ * @retval NRF_SUCCESS              If the data was consumed. Check @ref type_2_tag_stream_is_done.
+ * @retval NRF_ERROR_INVALID_PARAM  If the chunk starts after the next offset the parser needs.
+ * @retval NRF_ERROR_NOT_SUPPORTED  If the tag version is not supported.
+ * @retval NRF_ERROR_NO_MEM         If the TLV blocks or the kept values do not fit.
+ * @retval NRF_ERROR_INVALID_DATA   If the tag contents are malformed.
+ */
+ret_code_t type_2_tag_stream_feed(type_2_tag_stream_t * p_stream,
+                                  uint16_t              offset,
+                                  uint8_t const       * p_data,
+                                  uint16_t              length);
+
+/**
+ * @brief Function for checking whether the incremental parser has seen the whole TLV area.
+ *
+ * @retval TRUE   If a Terminator TLV or the end of the data area was reached.
+ * @retval FALSE  If more data is needed.
+ */
+bool type_2_tag_stream_is_done(type_2_tag_stream_t const * p_stream);
+
+/**
+ * @brief Function for getting the tag byte offset of the next byte the parser needs.
+ */
+uint16_t type_2_tag_stream_offset(type_2_tag_stream_t const * p_stream);
+
 /**
  * @brief Function for printing parsed contents of the Type 2 Tag.
  *
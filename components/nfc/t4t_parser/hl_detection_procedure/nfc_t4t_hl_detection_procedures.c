@@ -14,7 +14,11 @@
 
 #include "nfc_t4t_hl_detection_procedures.h"
 #include "nfc_t4t_apdu.h"
+#if PN532_ISODEP_ENABLED
+#include "pn532_isodep.h"
+#else
 #include "adafruit_pn532.h"
+#endif
 #include "sdk_macros.h"
 #include "nordic_common.h"
 
@@ -33,9 +37,15 @@
 #define NDEF_FILE_NLEN_FIELD_SIZE 2      ///< Size of NLEN field in NDEF file.
 #define NDEF_APP_PROC_RESP_LEN    256    ///< Maximal size of RAPDU data in the NDEF Tag Application Select Procedure.
 
+#if PN532_ISODEP_ENABLED
+// PN532 ISO-DEP transport limitations. C-APDUs are chained, so only the APDU buffer limits them.
+#define MAX_ADAFRUIT_RAPDU_SIZE   PN532_ISODEP_MAX_RAPDU_DATA  ///< Maximal value of RAPDU data field size
+#define MAX_ADAFRUIT_CAPDU_SIZE   (APDU_BUFF_SIZE - 6)         ///< Maximal value of CAPDU data field size (header, Lc and Le excluded)
+#else
 // Adafruit library limitations.
 #define MAX_ADAFRUIT_RAPDU_SIZE   242    ///< Maximal value of RAPDU data field size
 #define MAX_ADAFRUIT_CAPDU_SIZE   56     ///< Maximal value of CAPDU data field size
+#endif
 
 static uint8_t       m_file_id[FILE_ID_SIZE];                                                       ///< Buffer for selected EF ID storage.
 static const uint8_t m_nfc_t4t_select_ndef_app_data[] = {0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01}; ///< NDEF Tag Application name.
@@ -60,8 +70,16 @@ static ret_code_t nfc_t4t_apdu_exchange(nfc_t4t_comm_apdu_t * const p_capdu,
                                                         &apdu_buff_len);
     VERIFY_SUCCESS(err_code);
 
+#if PN532_ISODEP_ENABLED
+    uint16_t rapdu_len = resp_len;
+
+    err_code = pn532_isodep_transceive(p_apdu_buff, apdu_buff_len, p_apdu_buff, &rapdu_len);
+    VERIFY_SUCCESS(err_code);
+    resp_len = (uint8_t)rapdu_len;
+#else
     err_code = adafruit_pn532_in_data_exchange(p_apdu_buff, apdu_buff_len, p_apdu_buff, &resp_len);
     VERIFY_SUCCESS(err_code);
+#endif
 
     err_code = nfc_t4t_resp_apdu_decode(p_rapdu, p_apdu_buff, resp_len);
     VERIFY_SUCCESS(err_code);
@@ -31,8 +31,11 @@
 #include "ble_conn_params.h"
 #include "softdevice_handler.h"
 #include "app_timer.h"
+#include "app_scheduler.h"
+#include "nrf_pwr_mgmt.h"
 #include "app_button.h"
 #include "ble_nus.h"
+#include "fstorage.h"
 #include "app_uart.h"
 #include "app_util_platform.h"
 #include "bsp.h"
@@ -46,137 +49,2046 @@
 #include "nrf_drv_timer.h"
 #include "flash_io.h"
 #include "lock_gpio.h"
+#include "lock_moto.h"
+#include "lock_state.h"
+#include "lock_acl.h"
+#include "lock_acl_mph.h"
+#include "lock_journal.h"
+#include "pwr_idle.h"
+#include "wdt_sup.h"
+#include "batt_mon.h"
+#include "prox_wake.h"
+#include "ir_prox.h"
+#include "post_mortem.h"
+#include "keep_ram.h"
+#include "load_gen.h"
+#include "nus_bench.h"
+#include "pn532_duty.h"
+#include "mx25_async.h"
+#include "pn532_scan.h"
+#include "pn532_tune.h"
+#include "pn532_diag.h"
+#include "twi_bus.h"
+#include "nus_tx.h"
+#include "journal_sync.h"
+#include "dev_cfg.h"
+#include "nus_cmd.h"
+#include "cmd_ring.h"
+#include "frame_pool.h"
+#include "lat_trace.h"
+#include "nrf_ble_gatt.h"
+#include "nus_qwr.h"
+#include "conn_policy.h"
+#include "hid_wedge.h"
+#include "burst_link.h"
+#include "tap_beacon.h"
+#include "adv_sched.h"
+#include "peer_bond.h"
+#include "gw_push.h"
+#include "radio_gap.h"
+#include "nfc_pair.h"
+#include "uart_frame.h"
+#include "stream_frame.h"
+#include "usb_service.h"
+#include "sd_log.h"
+#include "app_rtos.h"
+#include "nrf_crypto_aes.h"
+#include "rand_pool.h"
+#include "boot_seq.h"
+#include "link_stats.h"
+#include "log_nus.h"
+#include "nus_rx.h"
+#include "reader_tlm.h"
+#include "bench.h"
+#include "crit_prof.h"
+#include "host_spis.h"
+#include "wall_clock.h"
+#include "passback.h"
+#include "hf_clock.h"
+#include "energy.h"
+#include "cmd_reg.h"
+#include "ram_budget.h"
+#include "ram_power.h"
+
+#if NRF_MODULE_ENABLED(PEER_BOND)
+#define IS_SRVC_CHANGED_CHARACT_PRESENT 1                                           /**< Include the service_changed characteristic. Bonded phones cache the GATT table. */
+#else
+#define IS_SRVC_CHANGED_CHARACT_PRESENT 0                                           /**< Include the service_changed characteristic. If not enabled, the server's database cannot be changed for the lifetime of the device. */
+#endif
+
+#define APP_FEATURE_NOT_SUPPORTED       BLE_GATT_STATUS_ATTERR_APP_BEGIN + 2        /**< Reply when unsupported features are requested. */
+
+#if NRF_MODULE_ENABLED(GW_PUSH)
+#define CENTRAL_LINK_COUNT              1                                           /**< Number of central links used by the application. When changing this number remember to adjust the RAM settings*/
+#else
+#define CENTRAL_LINK_COUNT              0                                           /**< Number of central links used by the application. When changing this number remember to adjust the RAM settings*/
+#endif
+#define PERIPHERAL_LINK_COUNT           BLE_NUS_LINK_COUNT                          /**< Number of peripheral links used by the application. When changing this number remember to adjust the RAM settings*/
+
+#define DEVICE_NAME                     "BLUE_SSH"                               /**< Name of device. Will be included in the advertising data. */
+#define NUS_SERVICE_UUID_TYPE           BLE_UUID_TYPE_VENDOR_BEGIN                  /**< UUID type for the Nordic UART Service (vendor specific). */
+
+#define APP_ADV_INTERVAL                64                                          /**64< The advertising interval (in units of 0.625 ms. This value corresponds to 40 ms). */
+#define APP_ADV_TIMEOUT_IN_SECONDS      180                                          /**180< The advertising timeout (in units of seconds). */
+
+#define APP_TIMER_PRESCALER             APP_TIMER_CONFIG_PRESCALER                  /**< Value of the RTC1 PRESCALER register. */
+//#define APP_TIMER_OP_QUEUE_SIZE         4                                           /**< Size of timer operation queues. */
+
+#define MIN_CONN_INTERVAL               MSEC_TO_UNITS(20, UNIT_1_25_MS)             /**< Minimum acceptable connection interval (20 ms), Connection interval uses 1.25 ms units. */
+#define MAX_CONN_INTERVAL               MSEC_TO_UNITS(75, UNIT_1_25_MS)             /**< Maximum acceptable connection interval (75 ms), Connection interval uses 1.25 ms units. */
+#define SLAVE_LATENCY                   0                                           /**< Slave latency. */
+#define CONN_SUP_TIMEOUT                MSEC_TO_UNITS(4000, UNIT_10_MS)             /**< Connection supervisory timeout (4 seconds), Supervision Timeout uses 10 ms units. */
+#define FIRST_CONN_PARAMS_UPDATE_DELAY  APP_TIMER_TICKS(5000, APP_TIMER_PRESCALER)  /**< Time from initiating event (connect or start of notification) to first time sd_ble_gap_conn_param_update is called (5 seconds). */
+#define NEXT_CONN_PARAMS_UPDATE_DELAY   APP_TIMER_TICKS(30000, APP_TIMER_PRESCALER) /**< Time between each call to sd_ble_gap_conn_param_update after the first call (30 seconds). */
+#define MAX_CONN_PARAMS_UPDATE_COUNT    3                                           /**< Number of attempts before giving up the connection parameter negotiation. */
+
+#define DEAD_BEEF                       0xDEADBEEF                                  /**< Value used as error code on stack dump, can be used to identify stack location on stack unwind. */
+
+#define UART_TX_BUF_SIZE                256                                         /**< UART TX buffer size. */
+#define UART_RX_BUF_SIZE                256                                         /**< UART RX buffer size. */
+
+#define APP_TIMER_OP_QUEUE_SIZE         6                                           //!< Size of timer operation queues. */
+
+#define SECURITY_REQUEST_DELAY          APP_TIMER_TICKS(1000, APP_TIMER_PRESCALER)  //!< Delay after connection until Security Request is sent, if necessary (ticks). */
+
+#define SCHED_MAX_EVENT_DATA_SIZE       (8 + BLE_NUS_MAX_DATA_LEN)                  /**< Maximum size of scheduler events: a NUS write with its link. */
+#define SCHED_QUEUE_SIZE                10                                          /**< Maximum number of events in the scheduler queue. */
+
+#define NUS_RING_SIZE                   128                                         /**< Raw NUS commands waiting for the main loop (bytes). */
+#define UART_RING_SIZE                  64                                          /**< UART command lines waiting for the main loop (bytes). */
+
+
+ble_nus_t                               m_nus;                                      /**< Structure to identify the Nordic UART Service. */
+static uint16_t                         m_conn_handle = BLE_CONN_HANDLE_INVALID;    /**< Handle of the last connection. */
+#if PERIPHERAL_LINK_COUNT > 1
+static uint8_t                          m_link_count;                               /**< Peripheral links in use. */
+#endif
+
+#if NRF_BLE_GATT_ENABLED
+static nrf_ble_gatt_t                   m_gatt;                                     /**< ATT MTU of each link. */
+#endif
+
+static ble_uuid_t                       m_adv_uuids[] =                                   /**< Universally unique service identifier. */
+{
+    {BLE_UUID_NUS_SERVICE, NUS_SERVICE_UUID_TYPE},
+#if NRF_MODULE_ENABLED(HID_WEDGE)
+    {BLE_UUID_HUMAN_INTERFACE_DEVICE_SERVICE, BLE_UUID_TYPE_BLE},
+#endif
+};
+
+APP_TIMER_DEF(m_sec_req_timer_id);    
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**@brief Function for assert macro callback.
+ *
+ * @details This function will be called in case of an assert in the SoftDevice.
+ *
+ * @warning This handler is an example only and does not fit a final product. You need to analyse
+ *          how your product is supposed to react in case of Assert.
+ * @warning On assert from the SoftDevice, the system can only recover on reset.
+ *
+ * @param[in] line_num    Line number of the failing ASSERT call.
+ * @param[in] p_file_name File name of the failing ASSERT call.
+ */
+void assert_nrf_callback(uint16_t line_num, const uint8_t * p_file_name)
+{
+    app_error_handler(DEAD_BEEF, line_num, p_file_name);
+}
+
+
+#if NRF_MODULE_ENABLED(DEV_CFG)
+/**@brief Site settings of the build, in use until the phone stores others. */
+static dev_cfg_t const m_cfg_defaults =
+{
+    .adv_interval      = APP_ADV_INTERVAL,
+    .conn_min_interval = MIN_CONN_INTERVAL,
+    .conn_max_interval = MAX_CONN_INTERVAL,
+    .slave_latency     = SLAVE_LATENCY,
+    .conn_sup_timeout  = CONN_SUP_TIMEOUT,
+#if NRF_MODULE_ENABLED(LOCK_MOTO)
+    .lock_hold_ms      = LOCK_MOTO_HOLD_MS,
+#endif
+#if NRF_MODULE_ENABLED(PN532_RETRY)
+    .retry_max         = PN532_RETRY_MAX,
+    .retry_backoff_ms  = PN532_RETRY_BACKOFF_MS,
+#endif
+    .fb_time_pct       = 100,
+};
+#endif
+
+
+/**@brief Function for the GAP initialization.
+ *
+ * @details This function will set up all the necessary GAP (Generic Access Profile) parameters of
+ *          the device. It also sets the permissions and appearance.
+ */
+static void gap_params_init(void)
+{
+    uint32_t                err_code;
+    ble_gap_conn_params_t   gap_conn_params;
+    ble_gap_conn_sec_mode_t sec_mode;
+
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&sec_mode);
+
+    err_code = sd_ble_gap_device_name_set(&sec_mode,
+                                          (const uint8_t *) DEVICE_NAME,
+                                          strlen(DEVICE_NAME));
+    APP_ERROR_CHECK(err_code);
+
+    memset(&gap_conn_params, 0, sizeof(gap_conn_params));
+
+    gap_conn_params.min_conn_interval = DEV_CFG_GET(conn_min_interval, MIN_CONN_INTERVAL);
+    gap_conn_params.max_conn_interval = DEV_CFG_GET(conn_max_interval, MAX_CONN_INTERVAL);
+    gap_conn_params.slave_latency     = DEV_CFG_GET(slave_latency, SLAVE_LATENCY);
+    gap_conn_params.conn_sup_timeout  = DEV_CFG_GET(conn_sup_timeout, CONN_SUP_TIMEOUT);
+
+    err_code = sd_ble_gap_ppcp_set(&gap_conn_params);
+    APP_ERROR_CHECK(err_code);
+}
+
+
+#if NRF_BLE_GATT_ENABLED
+/**@brief Function for handling an ATT MTU exchange: the NUS notifications of the link grow
+ *        with it, up to BLE_NUS_MAX_DATA_LEN.
+ */
+static void gatt_evt_handler(nrf_ble_gatt_t * p_gatt, nrf_ble_gatt_evt_t * p_evt)
+{
+    UNUSED_PARAMETER(p_gatt);
+
+    UNUSED_RETURN_VALUE(ble_nus_att_mtu_set(&m_nus, p_evt->conn_handle, p_evt->att_mtu_effective));
+}
+
+
+/**@brief Function for initializing the GATT module, which exchanges the ATT MTU. */
+static void gatt_init(void)
+{
+    ret_code_t err_code = nrf_ble_gatt_init(&m_gatt, gatt_evt_handler);
+    APP_ERROR_CHECK(err_code);
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(STREAM_FRAME)
+#if STREAM_FRAME_MAX_LEN > BLE_NUS_MAX_DATA_LEN
+#error "STREAM_FRAME_MAX_LEN must not exceed BLE_NUS_MAX_DATA_LEN"
+#endif
+
+/**@brief SLIP stream of one NUS link. */
+typedef struct
+{
+    uint16_t           conn_handle;     /**< BLE_CONN_HANDLE_INVALID when the entry is free. */
+    bool               framed;          /**< The peer has sent a frame, so replies are framed. */
+    stream_frame_dec_t dec;
+    uint8_t            buf[STREAM_FRAME_BUF_SIZE(STREAM_FRAME_MAX_LEN)];
+} nus_stream_t;
+
+static nus_stream_t m_nus_stream[BLE_NUS_LINK_COUNT];
+
+
+/**@brief Stream of a link, or a free entry for BLE_CONN_HANDLE_INVALID; NULL if none. */
+static nus_stream_t * nus_stream_find(uint16_t conn_handle)
+{
+    for (uint32_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        if (m_nus_stream[i].conn_handle == conn_handle)
+        {
+            return &m_nus_stream[i];
+        }
+    }
+    return NULL;
+}
+
+
+/**@brief Free the stream of a link, at start and on disconnect. */
+static void nus_stream_reset(nus_stream_t * p_link)
+{
+    p_link->conn_handle = BLE_CONN_HANDLE_INVALID;
+    p_link->framed      = false;
+    stream_frame_dec_init(&p_link->dec, p_link->buf, sizeof(p_link->buf));
+}
+#endif
+
+
+/**@brief Send a command reply in a notification of its own. */
+static void nus_reply(uint8_t * p_data, uint16_t length)
+{
+#if NRF_MODULE_ENABLED(STREAM_FRAME) && NRF_MODULE_ENABLED(NUS_TX)
+    nus_stream_t * p_link = nus_stream_find(nus_tx_target_get());
+
+    if ((p_link != NULL) && p_link->framed)
+    {
+        uint8_t  frame[STREAM_FRAME_ENC_MAX(BLE_NUS_MAX_DATA_LEN)];
+        uint16_t frame_len = stream_frame_encode(p_data, MIN(length, BLE_NUS_MAX_DATA_LEN),
+                                                 frame, sizeof(frame));
+
+        UNUSED_RETURN_VALUE(nus_tx_send(frame, frame_len));
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(NUS_CMD)
+    if (nus_cmd_active())
+    {
+        UNUSED_RETURN_VALUE(nus_cmd_data(p_data, length));
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(NUS_TX)
+    UNUSED_RETURN_VALUE(nus_tx_send(p_data, length));
+#else
+    UNUSED_RETURN_VALUE(ble_nus_string_send(&m_nus, p_data, length));
+#endif
+}
+
+
+/**@brief Function for handling the data from the Nordic UART Service.
+ *
+ * @details This function will process the data received from the Nordic UART BLE Service and send
+ *          it to the UART module.
+ *
+ * @param[in] p_nus    Nordic UART Service structure.
+ * @param[in] p_data   Data to be send to UART module.
+ * @param[in] length   Length of the data.
+ */
+#if NRF_MODULE_ENABLED(LOCK_ACL)
+#define ACL_LOAD_BEGIN  0  /**< ACL_LOAD, ACL_LOAD_BEGIN. */
+#define ACL_LOAD_DATA   1  /**< ACL_LOAD, ACL_LOAD_DATA, up to 18 image bytes. */
+#define ACL_LOAD_END    2  /**< ACL_LOAD, ACL_LOAD_END, CRC32 of the image and optionally its
+                                version (little endian). */
+
+/**@brief Whitelist upload step: ACL_LOAD, op, arguments. */
+static ret_code_t acl_load_run(uint8_t * p_cmd, uint16_t event_size)
+{
+    ret_code_t err_code = NRF_ERROR_INVALID_LENGTH;
+
+    if (event_size < 2)
+    {
+        return err_code;
+    }
+    switch (p_cmd[1])
+    {
+        case ACL_LOAD_BEGIN:
+            err_code = lock_acl_load_begin();
+            break;
+
+        case ACL_LOAD_DATA:
+            err_code = lock_acl_load_append(&p_cmd[2], event_size - 2);
+            break;
+
+        case ACL_LOAD_END:
+            if (event_size == 6)
+            {
+                err_code = lock_acl_load_end(uint32_decode(&p_cmd[2]), 0);
+            }
+            else if (event_size == 10)
+            {
+                err_code = lock_acl_load_end(uint32_decode(&p_cmd[2]), uint32_decode(&p_cmd[6]));
+            }
+            break;
+
+        default:
+            err_code = NRF_ERROR_NOT_SUPPORTED;
+            break;
+    }
+#if NRF_MODULE_ENABLED(CONN_POLICY)
+    // A fast link from the start of the upload to its end or first error.
+    conn_policy_busy(CONN_POLICY_UPLOAD, (err_code == NRF_SUCCESS) && (p_cmd[1] != ACL_LOAD_END));
+#endif
+
+    return err_code;
+}
+
+
+/**@brief Raw whitelist upload step, run from the scheduler since it erases and programs flash.
+ *
+ * @details Every request is answered with ACL_LOAD, op, result (an NRF_ERROR code, 0 on success);
+ *          the phone sends the next request after the answer.
+ */
+static void acl_load_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t * p_cmd = p_event_data;
+    uint8_t   reply[3];
+
+    if (event_size < 2)
+    {
+        return;
+    }
+
+    reply[0] = ACL_LOAD;
+    reply[1] = p_cmd[1];
+    reply[2] = (uint8_t)acl_load_run(p_cmd, event_size);
+    nus_reply(reply, sizeof(reply));
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(LOCK_ACL_MPH)
+#define ACL_TABLE_BEGIN  0  /**< ACL_TABLE, ACL_TABLE_BEGIN. */
+#define ACL_TABLE_DATA   1  /**< ACL_TABLE, ACL_TABLE_DATA, up to 18 table image bytes. */
+#define ACL_TABLE_END    2  /**< ACL_TABLE, ACL_TABLE_END, CRC32 of the image and its version
+                                 (little endian). */
+
+/**@brief Internal flash table upload step: ACL_TABLE, op, arguments.
+ *
+ * @details NRF_ERROR_BUSY means that fstorage has not caught up; the phone sends the same
+ *          request again.
+ */
+static ret_code_t acl_table_run(uint8_t * p_cmd, uint16_t event_size)
+{
+    ret_code_t err_code = NRF_ERROR_INVALID_LENGTH;
+
+    if (event_size < 2)
+    {
+        return err_code;
+    }
+    switch (p_cmd[1])
+    {
+        case ACL_TABLE_BEGIN:
+            err_code = lock_acl_mph_load_begin();
+            break;
+
+        case ACL_TABLE_DATA:
+            err_code = lock_acl_mph_load_append(&p_cmd[2], event_size - 2);
+            break;
+
+        case ACL_TABLE_END:
+            if (event_size == 10)
+            {
+                err_code = lock_acl_mph_load_end(uint32_decode(&p_cmd[2]), uint32_decode(&p_cmd[6]));
+            }
+            break;
+
+        default:
+            err_code = NRF_ERROR_NOT_SUPPORTED;
+            break;
+    }
+#if NRF_MODULE_ENABLED(CONN_POLICY)
+    conn_policy_busy(CONN_POLICY_UPLOAD, ((err_code == NRF_SUCCESS) || (err_code == NRF_ERROR_BUSY)) &&
+                     (p_cmd[1] != ACL_TABLE_END));
+#endif
+
+    return err_code;
+}
+
+
+/**@brief Raw table upload step, answered with ACL_TABLE, op, result like acl_load_handler(). */
+static void acl_table_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t * p_cmd = p_event_data;
+    uint8_t   reply[3];
+
+    if (event_size < 2)
+    {
+        return;
+    }
+
+    reply[0] = ACL_TABLE;
+    reply[1] = p_cmd[1];
+    reply[2] = (uint8_t)acl_table_run(p_cmd, event_size);
+    nus_reply(reply, sizeof(reply));
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(LOCK_ACL_DELTA)
+#ifndef LOCK_ACL_SITE_KEY
+#error "Define LOCK_ACL_SITE_KEY, the AES-128 key whitelist deltas are signed with, as {0x.., ...}"
+#endif
+
+#define ACL_DELTA_BEGIN    0  /**< ACL_DELTA, ACL_DELTA_BEGIN. */
+#define ACL_DELTA_DATA     1  /**< ACL_DELTA, ACL_DELTA_DATA, up to 18 delta bytes. */
+#define ACL_DELTA_END      2  /**< ACL_DELTA, ACL_DELTA_END, 16-byte AES-CMAC of the delta. */
+#define ACL_DELTA_VERSION  3  /**< ACL_DELTA, ACL_DELTA_VERSION; the answer adds the list version. */
+
+static uint8_t const m_acl_site_key[16] = LOCK_ACL_SITE_KEY;
+
+/**@brief Whitelist delta step: ACL_DELTA, op, arguments. */
+static ret_code_t acl_delta_run(uint8_t * p_cmd, uint16_t event_size)
+{
+    ret_code_t err_code = NRF_ERROR_INVALID_LENGTH;
+
+    if (event_size < 2)
+    {
+        return err_code;
+    }
+    switch (p_cmd[1])
+    {
+        case ACL_DELTA_BEGIN:
+            err_code = lock_acl_delta_begin();
+            break;
+
+        case ACL_DELTA_DATA:
+            err_code = lock_acl_delta_append(&p_cmd[2], event_size - 2);
+            break;
+
+        case ACL_DELTA_END:
+            if (event_size == 2 + sizeof(m_acl_site_key))
+            {
+                err_code = lock_acl_delta_end(&p_cmd[2]);
+            }
+            break;
+
+        case ACL_DELTA_VERSION:
+            err_code = NRF_SUCCESS;
+            break;
+
+        default:
+            err_code = NRF_ERROR_NOT_SUPPORTED;
+            break;
+    }
+#if NRF_MODULE_ENABLED(CONN_POLICY)
+    conn_policy_busy(CONN_POLICY_UPLOAD, (err_code == NRF_SUCCESS) &&
+                     ((p_cmd[1] == ACL_DELTA_BEGIN) || (p_cmd[1] == ACL_DELTA_DATA)));
+#endif
+
+    return err_code;
+}
+
+
+/**@brief Raw whitelist delta step, run from the scheduler like acl_load_handler().
+ *
+ * @details Answered with ACL_DELTA, op, result, followed by the list version (little endian) for
+ *          ACL_DELTA_END and ACL_DELTA_VERSION, so the phone knows which delta to send next.
+ */
+static void acl_delta_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t * p_cmd = p_event_data;
+    uint8_t   reply[3 + sizeof(uint32_t)];
+    uint16_t  len   = 3;
+
+    if (event_size < 2)
+    {
+        return;
+    }
+
+    reply[0] = ACL_DELTA;
+    reply[1] = p_cmd[1];
+    reply[2] = (uint8_t)acl_delta_run(p_cmd, event_size);
+    if ((p_cmd[1] == ACL_DELTA_END) || (p_cmd[1] == ACL_DELTA_VERSION))
+    {
+        len += uint32_encode(lock_acl_version(), &reply[len]);
+    }
+    nus_reply(reply, len);
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(LOCK_ACL_ENROLL)
+/**@brief Raw enrollment request, run from the scheduler since ending it programs flash.
+ *
+ * @details Answered with ACL_ENROLL, op, result; the cards and the summaries follow as reports.
+ */
+static void acl_enroll_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t * p_cmd = p_event_data;
+    uint8_t   reply[3];
+
+    if (event_size < 2)
+    {
+        return;
+    }
+
+    reply[0] = ACL_ENROLL;
+    reply[1] = p_cmd[1];
+    reply[2] = (uint8_t)pn532_enroll_request(&p_cmd[1], event_size - 1);
+    nus_reply(reply, sizeof(reply));
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(LOCK_JOURNAL)
+/**@brief Journal query: JOURNAL_READ gives oldest, head (little endian), JOURNAL_READ, seq
+ *        gives the entry.
+ */
+static ret_code_t journal_read_run(uint8_t * p_cmd, uint16_t event_size,
+                                   uint8_t * p_out, uint16_t * p_len)
+{
+    lock_journal_entry_t entry;
+    ret_code_t           err_code;
+
+    *p_len = 0;
+    if (event_size == 1)
+    {
+        err_code = NRF_SUCCESS;
+        *p_len += uint32_encode(lock_journal_oldest(), &p_out[*p_len]);
+        *p_len += uint32_encode(lock_journal_head(), &p_out[*p_len]);
+    }
+    else if (event_size == 5)
+    {
+        err_code = lock_journal_read(uint32_decode(&p_cmd[1]), &entry);
+        if (err_code == NRF_SUCCESS)
+        {
+            memcpy(p_out, &entry, sizeof(entry));
+            *p_len = sizeof(entry);
+        }
+    }
+    else
+    {
+        err_code = NRF_ERROR_INVALID_LENGTH;
+    }
+
+    return err_code;
+}
+
+
+/**@brief Raw journal query, run from the scheduler since it reads the SPI flash.
+ *
+ * @details Answered with JOURNAL_READ, result, data.
+ */
+static void journal_read_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t  reply[2 + sizeof(lock_journal_entry_t)];
+    uint16_t len;
+
+    reply[0] = JOURNAL_READ;
+    reply[1] = (uint8_t)journal_read_run(p_event_data, event_size, &reply[2], &len);
+    nus_reply(reply, 2 + len);
+}
+
+
+/**@brief Journal search: JOURNAL_FIND, seq, from, to (LE seconds) [, UID] gives the first
+ *        entry from seq on in the time range, with the UID if one is given. The next search
+ *        goes on from the seq of the entry plus one; NRF_ERROR_NOT_FOUND comes with the
+ *        head instead.
+ */
+static ret_code_t journal_find_run(uint8_t * p_cmd, uint16_t event_size,
+                                   uint8_t * p_out, uint16_t * p_len)
+{
+    lock_journal_filter_t filter;
+    lock_journal_entry_t  entry;
+    uint32_t              seq;
+    ret_code_t            err_code;
+
+    *p_len = 0;
+    if ((event_size < 13) || (event_size > 13 + LOCK_JOURNAL_DATA_LEN))
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    seq              = uint32_decode(&p_cmd[1]);
+    filter.from_time = uint32_decode(&p_cmd[5]);
+    filter.to_time   = uint32_decode(&p_cmd[9]);
+    filter.uid_len   = (uint8_t)(event_size - 13);
+    memcpy(filter.uid, &p_cmd[13], filter.uid_len);
+
+    err_code = lock_journal_find(&filter, &seq, &entry);
+    if (err_code == NRF_SUCCESS)
+    {
+        memcpy(p_out, &entry, sizeof(entry));
+        *p_len = sizeof(entry);
+    }
+    else
+    {
+        *p_len = uint32_encode(seq, p_out);
+    }
+    return err_code;
+}
+
+
+/**@brief Raw journal search, from the scheduler. Answered with JOURNAL_FIND, result, data. */
+static void journal_find_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t  reply[2 + sizeof(lock_journal_entry_t)];
+    uint16_t len;
+
+    reply[0] = JOURNAL_FIND;
+    reply[1] = (uint8_t)journal_find_run(p_event_data, event_size, &reply[2], &len);
+    nus_reply(reply, 2 + len);
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(JOURNAL_SYNC)
+/**@brief Journal sync from the scheduler: JOURNAL_SYNC, JOURNAL_SYNC_START, cursor (LE) is
+ *        answered with JOURNAL_SYNC, result, first seq sent, head (LE) before the data;
+ *        JOURNAL_SYNC, JOURNAL_SYNC_ACK, seq (LE) only when the ack is refused.
+ */
+static void journal_sync_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t const * p_cmd = p_event_data;
+    uint8_t         reply[2 + 2 * sizeof(uint32_t)];
+    uint16_t        len      = 2;
+    uint32_t        from;
+    ret_code_t      err_code = NRF_ERROR_INVALID_LENGTH;
+
+    if ((event_size == 6) && (p_cmd[1] == JOURNAL_SYNC_START))
+    {
+        err_code = journal_sync_start(nus_tx_target_get(), uint32_decode(&p_cmd[2]), &from);
+        if (err_code == NRF_SUCCESS)
+        {
+            len += uint32_encode(from, &reply[len]);
+            len += uint32_encode(lock_journal_head(), &reply[len]);
+        }
+    }
+#if NRF_MODULE_ENABLED(BURST_LINK)
+    else if ((event_size == 6) && (p_cmd[1] == JOURNAL_SYNC_RADIO))
+    {
+        err_code = burst_link_start(uint32_decode(&p_cmd[2]), &from);
+        if (err_code == NRF_SUCCESS)
+        {
+            len += uint32_encode(from, &reply[len]);
+            len += uint32_encode(lock_journal_head(), &reply[len]);
+        }
+    }
+#endif
+    else if ((event_size == 6) && (p_cmd[1] == JOURNAL_SYNC_ACK))
+    {
+        err_code = journal_sync_ack(nus_tx_target_get(), uint32_decode(&p_cmd[2]));
+        if (err_code == NRF_SUCCESS)
+        {
+            return;
+        }
+    }
+    else if (event_size == 6)
+    {
+        err_code = NRF_ERROR_NOT_SUPPORTED;
+    }
+
+    reply[0] = JOURNAL_SYNC;
+    reply[1] = (uint8_t)err_code;
+    nus_reply(reply, len);
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(WALL_CLOCK)
+/**@brief Clock query and sync: TIME_SET reads the time, TIME_SET, time (LE seconds) [,
+ *        1/256 s] sets it. Answered with the time after the request (LE).
+ */
+static ret_code_t time_set_run(uint8_t * p_cmd, uint16_t event_size, uint8_t * p_out, uint16_t * p_len)
+{
+    ret_code_t err_code = NRF_SUCCESS;
+
+    if ((event_size == 5) || (event_size == 6))
+    {
+        wall_clock_set(uint32_decode(&p_cmd[1]), (event_size == 6) ? p_cmd[5] : 0);
+    }
+    else if (event_size != 1)
+    {
+        err_code = NRF_ERROR_INVALID_LENGTH;
+    }
+
+    *p_len = uint32_encode(wall_clock_now(), p_out);
+    return err_code;
+}
+
+
+/**@brief Raw clock request, answered with TIME_SET, result, time. */
+static void time_set_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t  reply[2 + sizeof(uint32_t)];
+    uint16_t len;
+
+    reply[0] = TIME_SET;
+    reply[1] = (uint8_t)time_set_run(p_event_data, event_size, &reply[2], &len);
+    nus_reply(reply, 2 + len);
+}
+
+
+/**@brief The clock was set: journalled, so entries before it can be placed in time. */
+static void wall_clock_handler(uint32_t old_time, uint32_t new_time)
+{
+#if NRF_MODULE_ENABLED(LOCK_JOURNAL)
+    uint8_t data[sizeof(uint32_t)];
+
+    // The entry is stamped with the new time.
+    if (old_time == new_time)
+    {
+        return;
+    }
+    UNUSED_RETURN_VALUE(uint32_encode(old_time, data));
+#if NRF_MODULE_ENABLED(APP_RTOS)
+    UNUSED_RETURN_VALUE(app_rtos_journal_put(LOCK_JOURNAL_EVT_TIME, data, sizeof(data)));
+#else
+    UNUSED_RETURN_VALUE(lock_journal_append(LOCK_JOURNAL_EVT_TIME, data, sizeof(data)));
+#endif
+#else
+    UNUSED_PARAMETER(old_time);
+    UNUSED_PARAMETER(new_time);
+#endif
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(LAT_TRACE)
+#define TRACE_READ_STATS    0  /**< TRACE_READ (, TRACE_READ_STATS): stage statistics. */
+#define TRACE_READ_RECORDS  1  /**< TRACE_READ, TRACE_READ_RECORDS: the recorded stages. */
+#define TRACE_READ_RESET    2  /**< TRACE_READ, TRACE_READ_RESET: clear both. */
+#define TRACE_READ_TIMERS   3  /**< TRACE_READ, TRACE_READ_TIMERS: app_timer operation queue use. */
+#define TRACE_READ_KEPT     4  /**< TRACE_READ, TRACE_READ_KEPT: counters and last fault kept over resets. */
+
+/**@brief Latency trace query.
+ *
+ * @details Statistics go out as TRACE_READ, TRACE_READ_STATS, stage, count (16 bit), min, avg,
+ *          max (32 bit, us), one reply per stage with records. Records go out oldest first as
+ *          TRACE_READ, TRACE_READ_RECORDS, stage, duration (us), start (RTC1 ticks). All
+ *          numbers are little endian. TRACE_READ_TIMERS answers with the most app_timer
+ *          operations seen queued at once, against APP_TIMER_OP_QUEUE_SIZE. TRACE_READ_KEPT
+ *          answers TRACE_READ, TRACE_READ_KEPT, counter, value (32 bit) for each keep_ram_cnt_t,
+ *          then TRACE_READ, TRACE_READ_KEPT, 0xFF, id, pc, info (32 bit), line (16 bit) for
+ *          the last fault.
+ */
+static ret_code_t trace_read_run(uint8_t * p_cmd, uint16_t event_size)
+{
+    uint8_t           op = (event_size > 1) ? p_cmd[1] : TRACE_READ_STATS;
+    uint8_t           reply[3 + 2 + 3 * sizeof(uint32_t)];
+    uint16_t          len;
+    lat_trace_stats_t stats;
+    lat_trace_rec_t   rec;
+
+    reply[0] = TRACE_READ;
+    reply[1] = op;
+    switch (op)
+    {
+        case TRACE_READ_STATS:
+            for (uint8_t i = 0; i < LAT_STAGE_COUNT; i++)
+            {
+                if (lat_trace_stats_get((lat_stage_t)i, &stats) != NRF_SUCCESS)
+                {
+                    continue;
+                }
+                len  = 2;
+                reply[len++] = i;
+                len += uint16_encode(MIN(stats.count, UINT16_MAX), &reply[len]);
+                len += uint32_encode(stats.min_us, &reply[len]);
+                len += uint32_encode(stats.avg_us, &reply[len]);
+                len += uint32_encode(stats.max_us, &reply[len]);
+                nus_reply(reply, len);
+            }
+            return NRF_SUCCESS;
+
+        case TRACE_READ_RECORDS:
+            for (uint16_t i = 0; lat_trace_rec_get(i, &rec); i++)
+            {
+                len  = 2;
+                reply[len++] = rec.stage;
+                len += uint32_encode(lat_trace_ticks_to_us(rec.ticks), &reply[len]);
+                len += uint32_encode(rec.stamp, &reply[len]);
+                nus_reply(reply, len);
+            }
+            return NRF_SUCCESS;
+
+        case TRACE_READ_RESET:
+            lat_trace_reset();
+            return NRF_SUCCESS;
+
+#if APP_TIMER_WITH_PROFILER
+        case TRACE_READ_TIMERS:
+            reply[2] = app_timer_op_queue_utilization_get();
+            reply[3] = APP_TIMER_OP_QUEUE_SIZE;
+            nus_reply(reply, 4);
+            return NRF_SUCCESS;
+#endif
+
+#if NRF_MODULE_ENABLED(KEEP_RAM)
+        case TRACE_READ_KEPT:
+        {
+            keep_ram_body_t const * p_keep = keep_ram_get();
+
+            for (uint8_t i = 0; i < KEEP_RAM_CNT_COUNT; i++)
+            {
+                len  = 2;
+                reply[len++] = i;
+                len += uint32_encode(p_keep->counters[i], &reply[len]);
+                nus_reply(reply, len);
+            }
+            len  = 2;
+            reply[len++] = 0xFF;
+            len += uint32_encode(p_keep->fault.id, &reply[len]);
+            len += uint32_encode(p_keep->fault.pc, &reply[len]);
+            len += uint32_encode(p_keep->fault.info, &reply[len]);
+            len += uint16_encode(MIN(p_keep->fault.line, UINT16_MAX), &reply[len]);
+            nus_reply(reply, len);
+            return NRF_SUCCESS;
+        }
+#endif
+
+        default:
+            return NRF_ERROR_NOT_SUPPORTED;
+    }
+}
+
+
+/**@brief Raw latency trace query, run from the scheduler; ends with TRACE_READ, op, result. */
+static void trace_read_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t * p_cmd = p_event_data;
+    uint8_t   reply[3];
+
+    reply[0] = TRACE_READ;
+    reply[1] = (event_size > 1) ? p_cmd[1] : TRACE_READ_STATS;
+    reply[2] = (uint8_t)trace_read_run(p_cmd, event_size);
+    nus_reply(reply, sizeof(reply));
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(PN532_TUNE)
+#define RF_TUNE_GET         0  /**< RF_TUNE, RF_TUNE_GET, family: profile and settings in use. */
+#define RF_TUNE_SELECT      1  /**< RF_TUNE, RF_TUNE_SELECT, profile: use a built-in profile. */
+#define RF_TUNE_CALIBRATE   2  /**< RF_TUNE, RF_TUNE_CALIBRATE, family: calibrate on a card held at range. */
+
+/**@brief RF profile query or change.
+ *
+ * @details RF_TUNE_GET gives the profile, then RFCfg, GsNOn, CWGsP, ModGsP and RxThreshold.
+ *          RF_TUNE_CALIBRATE gives the polls out of PN532_TUNE_POLLS that found the card at
+ *          the best step, and blocks for seconds.
+ */
+static ret_code_t rf_tune_run(uint8_t * p_cmd, uint16_t event_size, uint8_t * p_out, uint16_t * p_len)
+{
+    pn532_tune_rf_t const * p_rf;
+    ret_code_t              err_code;
 
-#define IS_SRVC_CHANGED_CHARACT_PRESENT 0                                           /**< Include the service_changed characteristic. If not enabled, the server's database cannot be changed for the lifetime of the device. */
+    *p_len = 0;
+    if (event_size != 3)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
 
-#if (NRF_SD_BLE_API_VERSION == 3)
-#define NRF_BLE_MAX_MTU_SIZE            GATT_MTU_SIZE_DEFAULT                       /**< MTU size used in the softdevice enabling and to reply to a BLE_GATTS_EVT_EXCHANGE_MTU_REQUEST event. */
+    switch (p_cmd[1])
+    {
+        case RF_TUNE_GET:
+            if (p_cmd[2] >= PN532_TUNE_FAMILIES)
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+            p_rf = pn532_tune_rf_get((pn532_tune_family_t)p_cmd[2]);
+            p_out[(*p_len)++] = (uint8_t)pn532_tune_profile_get((pn532_tune_family_t)p_cmd[2]);
+            p_out[(*p_len)++] = p_rf->rf_cfg;
+            p_out[(*p_len)++] = p_rf->gs_n_on;
+            p_out[(*p_len)++] = p_rf->cw_gs_p;
+            p_out[(*p_len)++] = p_rf->mod_gs_p;
+            p_out[(*p_len)++] = p_rf->rx_threshold;
+            return NRF_SUCCESS;
+
+        case RF_TUNE_SELECT:
+            return pn532_tune_select((pn532_tune_profile_t)p_cmd[2]);
+
+        case RF_TUNE_CALIBRATE:
+            err_code = pn532_tune_calibrate((pn532_tune_family_t)p_cmd[2], &p_out[0]);
+            *p_len   = 1;
+            printf("rf tune %u: %s, %u/%u\r\n", p_cmd[2], (err_code == NRF_SUCCESS) ? "ok" : "failed",
+                   p_out[0], PN532_TUNE_POLLS);
+            return err_code;
+
+        default:
+            return NRF_ERROR_NOT_SUPPORTED;
+    }
+}
+
+
+/**@brief Raw RF profile command, run from the scheduler; answered with RF_TUNE, op, result, data. */
+static void rf_tune_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t * p_cmd = p_event_data;
+    uint8_t   reply[3 + 6];
+    uint16_t  len;
+
+    if (event_size < 2)
+    {
+        return;
+    }
+
+    reply[0] = RF_TUNE;
+    reply[1] = p_cmd[1];
+    reply[2] = (uint8_t)rf_tune_run(p_cmd, event_size, &reply[3], &len);
+    nus_reply(reply, 3 + len);
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(PN532_DIAG)
+#if NRF_MODULE_ENABLED(TWI_BUS)
+#define READER_DIAG_LEN     17
+#else
+#define READER_DIAG_LEN     11
+#endif
+
+/**@brief PN532 self test now: flags, antenna status, last error, then the runs, line, antenna
+ *        and external field counts since boot (LE). With twi_bus, the bus timeouts, stuck SDA
+ *        and recoveries follow.
+ */
+static ret_code_t reader_diag_run(uint8_t * p_out, uint16_t * p_len)
+{
+    pn532_diag_result_t result;
+    ret_code_t          err_code = pn532_diag_run();
+
+    pn532_diag_result_get(&result);
+    *p_len = 0;
+    p_out[(*p_len)++] = result.flags;
+    p_out[(*p_len)++] = result.antenna_status;
+    p_out[(*p_len)++] = result.last_err;
+    *p_len += uint16_encode(result.runs, &p_out[*p_len]);
+    *p_len += uint16_encode(result.line_fails, &p_out[*p_len]);
+    *p_len += uint16_encode(result.antenna_fails, &p_out[*p_len]);
+    *p_len += uint16_encode(result.ext_fields, &p_out[*p_len]);
+#if NRF_MODULE_ENABLED(TWI_BUS)
+    {
+        twi_bus_stats_t stats;
+
+        twi_bus_stats_get(&stats);
+        *p_len += uint16_encode(stats.timeouts, &p_out[*p_len]);
+        *p_len += uint16_encode(stats.stuck, &p_out[*p_len]);
+        *p_len += uint16_encode(stats.recoveries, &p_out[*p_len]);
+    }
+#endif
+    return err_code;
+}
+
+
+/**@brief Raw self test, run from the scheduler; answered with READER_DIAG, result, data. */
+static void reader_diag_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t  reply[2 + READER_DIAG_LEN];
+    uint16_t len;
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    reply[0] = READER_DIAG;
+    reply[1] = (uint8_t)reader_diag_run(&reply[2], &len);
+    nus_reply(reply, 2 + len);
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(ENERGY)
+#define ENERGY_SUMMARY      0  /**< ENERGY, ENERGY_SUMMARY: uptime in s, taps, nAh per tap, nAh per idle hour. */
+#define ENERGY_SUB          1  /**< ENERGY, ENERGY_SUB, subsystem: its nAh and its on-time in s. */
+#define ENERGY_RESET        2  /**< ENERGY, ENERGY_RESET: count from zero again. */
+
+/**@brief Charge estimate query; values are 32-bit LE. */
+static ret_code_t energy_run(uint8_t * p_cmd, uint16_t event_size, uint8_t * p_out, uint16_t * p_len)
+{
+    energy_summary_t summary;
+    uint32_t         nah;
+    uint32_t         on_s;
+
+    *p_len = 0;
+    if (event_size < 2)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    switch (p_cmd[1])
+    {
+        case ENERGY_SUMMARY:
+            energy_summary_get(&summary);
+            *p_len += uint32_encode(summary.uptime_s, &p_out[*p_len]);
+            *p_len += uint32_encode(summary.taps, &p_out[*p_len]);
+            *p_len += uint32_encode(summary.tap_nah, &p_out[*p_len]);
+            *p_len += uint32_encode(summary.idle_nah_h, &p_out[*p_len]);
+            return NRF_SUCCESS;
+
+        case ENERGY_SUB:
+            if (event_size != 3)
+            {
+                return NRF_ERROR_INVALID_LENGTH;
+            }
+            if (p_cmd[2] >= ENERGY_SUB_COUNT)
+            {
+                return NRF_ERROR_NOT_FOUND;
+            }
+            energy_sub_get((energy_sub_t)p_cmd[2], &nah, &on_s);
+            *p_len += uint32_encode(nah, &p_out[*p_len]);
+            *p_len += uint32_encode(on_s, &p_out[*p_len]);
+            return NRF_SUCCESS;
+
+        case ENERGY_RESET:
+            energy_reset();
+            return NRF_SUCCESS;
+
+        default:
+            return NRF_ERROR_NOT_SUPPORTED;
+    }
+}
+
+
+/**@brief Raw charge estimate query, run from the scheduler; answered with ENERGY, op, result, data. */
+static void energy_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t * p_cmd = p_event_data;
+    uint8_t   reply[3 + 16];
+    uint16_t  len;
+
+    if (event_size < 2)
+    {
+        return;
+    }
+
+    reply[0] = ENERGY;
+    reply[1] = p_cmd[1];
+    reply[2] = (uint8_t)energy_run(p_cmd, event_size, &reply[3], &len);
+    nus_reply(reply, 3 + len);
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(RAM_BUDGET)
+#define RAM_BUDGET_LAYOUT   0  /**< RAM_BUDGET, RAM_BUDGET_LAYOUT: RAM start (32 bit), data, bss, stack, stack used, unused[, sections off]. */
+#define RAM_BUDGET_BUFFER   1  /**< RAM_BUDGET, RAM_BUDGET_BUFFER, index: size, peak or 0xFFFF, name. */
+
+#if APP_SCHEDULER_WITH_PROFILER
+static uint16_t sched_peak_get(void)
+{
+    return app_sched_queue_utilization_get() * (SCHED_MAX_EVENT_DATA_SIZE + APP_SCHED_EVENT_HEADER_SIZE);
+}
+RAM_BUDGET_REGISTER(m_sched_budget, "sched",
+                    APP_SCHED_BUF_SIZE(SCHED_MAX_EVENT_DATA_SIZE, SCHED_QUEUE_SIZE), sched_peak_get);
+#else
+RAM_BUDGET_REGISTER(m_sched_budget, "sched",
+                    APP_SCHED_BUF_SIZE(SCHED_MAX_EVENT_DATA_SIZE, SCHED_QUEUE_SIZE), NULL);
+#endif
+
+/**@brief RAM use query; 16-bit values LE. */
+static ret_code_t ram_budget_run(uint8_t * p_cmd, uint16_t event_size, uint8_t * p_out, uint16_t * p_len)
+{
+    ram_budget_layout_t        layout;
+    ram_budget_entry_t const * p_entry;
+    uint8_t                    name_len;
+
+    *p_len = 0;
+    if (event_size < 2)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    switch (p_cmd[1])
+    {
+        case RAM_BUDGET_LAYOUT:
+            ram_budget_layout_get(&layout);
+            *p_len += uint32_encode(layout.ram_start, &p_out[*p_len]);
+            *p_len += uint16_encode(layout.data, &p_out[*p_len]);
+            *p_len += uint16_encode(layout.bss, &p_out[*p_len]);
+            *p_len += uint16_encode(layout.stack, &p_out[*p_len]);
+            *p_len += uint16_encode(layout.stack_used, &p_out[*p_len]);
+            *p_len += uint16_encode(layout.unused, &p_out[*p_len]);
+#if NRF_MODULE_ENABLED(RAM_POWER)
+            p_out[(*p_len)++] = ram_power_released();
+#endif
+            return NRF_SUCCESS;
+
+        case RAM_BUDGET_BUFFER:
+            if (event_size != 3)
+            {
+                return NRF_ERROR_INVALID_LENGTH;
+            }
+            p_entry = ram_budget_entry_get(p_cmd[2]);
+            if (p_entry == NULL)
+            {
+                return NRF_ERROR_NOT_FOUND;
+            }
+            *p_len += uint16_encode(p_entry->size, &p_out[*p_len]);
+            *p_len += uint16_encode((p_entry->peak != NULL) ? p_entry->peak() : UINT16_MAX,
+                                    &p_out[*p_len]);
+            name_len = (uint8_t)MIN(strlen(p_entry->p_name), RAM_BUDGET_NAME_LEN);
+            memcpy(&p_out[*p_len], p_entry->p_name, name_len);
+            *p_len += name_len;
+            return NRF_SUCCESS;
+
+        default:
+            return NRF_ERROR_NOT_SUPPORTED;
+    }
+}
+
+
+/**@brief Raw RAM use query, run from the scheduler; answered with RAM_BUDGET, op, result, data. */
+static void ram_budget_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t * p_cmd = p_event_data;
+    uint8_t   reply[3 + 15];
+    uint16_t  len;
+
+    if (event_size < 2)
+    {
+        return;
+    }
+
+    reply[0] = RAM_BUDGET;
+    reply[1] = p_cmd[1];
+    reply[2] = (uint8_t)ram_budget_run(p_cmd, event_size, &reply[3], &len);
+    nus_reply(reply, 3 + len);
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(LOAD_GEN)
+#define LOAD_GEN_RUN        0  /**< LOAD_GEN, LOAD_GEN_RUN [, taps (32 bit)]: start synthetic taps, no count for no end. */
+#define LOAD_GEN_HALT       1  /**< LOAD_GEN, LOAD_GEN_HALT: stop them. */
+#define LOAD_GEN_REPORT     2  /**< LOAD_GEN, LOAD_GEN_REPORT: placed, decided, missed, then p50, p90, p99, max in ms. */
+
+/**@brief Synthetic tap run; values are 16-bit LE, saturated. */
+static ret_code_t load_gen_run(uint8_t * p_cmd, uint16_t event_size, uint8_t * p_out, uint16_t * p_len)
+{
+    load_gen_report_t report;
+
+    *p_len = 0;
+    if (event_size < 2)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    switch (p_cmd[1])
+    {
+        case LOAD_GEN_RUN:
+            if ((event_size != 2) && (event_size != 6))
+            {
+                return NRF_ERROR_INVALID_LENGTH;
+            }
+            return load_gen_start((event_size == 6) ? uint32_decode(&p_cmd[2]) : 0);
+
+        case LOAD_GEN_HALT:
+            load_gen_stop();
+            return NRF_SUCCESS;
+
+        case LOAD_GEN_REPORT:
+            load_gen_report_get(&report);
+            *p_len += uint16_encode(MIN(report.placed, UINT16_MAX), &p_out[*p_len]);
+            *p_len += uint16_encode(MIN(report.decided, UINT16_MAX), &p_out[*p_len]);
+            *p_len += uint16_encode(MIN(report.missed, UINT16_MAX), &p_out[*p_len]);
+            *p_len += uint16_encode(MIN(report.p50_us / 1000, UINT16_MAX), &p_out[*p_len]);
+            *p_len += uint16_encode(MIN(report.p90_us / 1000, UINT16_MAX), &p_out[*p_len]);
+            *p_len += uint16_encode(MIN(report.p99_us / 1000, UINT16_MAX), &p_out[*p_len]);
+            *p_len += uint16_encode(MIN(report.max_us / 1000, UINT16_MAX), &p_out[*p_len]);
+            return NRF_SUCCESS;
+
+        default:
+            return NRF_ERROR_NOT_SUPPORTED;
+    }
+}
+
+
+/**@brief Raw synthetic tap command, run from the scheduler; answered with LOAD_GEN, op, result, data. */
+static void load_gen_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t * p_cmd = p_event_data;
+    uint8_t   reply[3 + 14];
+    uint16_t  len;
+
+    if (event_size < 2)
+    {
+        return;
+    }
+
+    reply[0] = LOAD_GEN;
+    reply[1] = p_cmd[1];
+    reply[2] = (uint8_t)load_gen_run(p_cmd, event_size, &reply[3], &len);
+    nus_reply(reply, 3 + len);
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(NUS_BENCH)
+#define NUS_BENCH_TX        0  /**< NUS_BENCH, NUS_BENCH_TX, kB (16 bit) [, length, TX buffers [, interval (16 bit)]]: stream to this link; 0 for what the link has. */
+#define NUS_BENCH_RX        1  /**< NUS_BENCH, NUS_BENCH_RX, bytes (32 bit): count the next writes of this link instead of running them. */
+#define NUS_BENCH_STOP      2  /**< NUS_BENCH, NUS_BENCH_STOP: end the run. */
+#define NUS_BENCH_REPORT    3  /**< NUS_BENCH, NUS_BENCH_REPORT: ms, bytes (32 bit), packets, events, refused; BUSY while it runs. */
+#define NUS_BENCH_LINK      4  /**< NUS_BENCH, NUS_BENCH_LINK: interval, length, TX buffers, most per event, most in flight, stalls, longest stall in ms. */
+
+/**@brief NUS throughput run; values are 16-bit LE unless noted. */
+static ret_code_t nus_bench_run(uint8_t * p_cmd, uint16_t event_size, uint8_t * p_out, uint16_t * p_len)
+{
+    nus_bench_report_t report;
+
+    *p_len = 0;
+    if (event_size < 2)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    switch (p_cmd[1])
+    {
+        case NUS_BENCH_TX:
+            if ((event_size != 4) && (event_size != 6) && (event_size != 8))
+            {
+                return NRF_ERROR_INVALID_LENGTH;
+            }
+            return nus_bench_tx_start(nus_tx_target_get(),
+                                      uint16_decode(&p_cmd[2]),
+                                      (event_size >= 6) ? p_cmd[4] : 0,
+                                      (event_size >= 6) ? p_cmd[5] : 0,
+                                      (event_size == 8) ? uint16_decode(&p_cmd[6]) : 0);
+
+        case NUS_BENCH_RX:
+            if (event_size != 6)
+            {
+                return NRF_ERROR_INVALID_LENGTH;
+            }
+            return nus_bench_rx_start(nus_tx_target_get(), uint32_decode(&p_cmd[2]));
+
+        case NUS_BENCH_STOP:
+            nus_bench_stop();
+            return NRF_SUCCESS;
+
+        case NUS_BENCH_REPORT:
+            nus_bench_report_get(&report);
+            *p_len += uint32_encode(report.ms, &p_out[*p_len]);
+            *p_len += uint32_encode(report.bytes, &p_out[*p_len]);
+            *p_len += uint16_encode(report.packets, &p_out[*p_len]);
+            *p_len += uint16_encode(report.events, &p_out[*p_len]);
+            *p_len += uint16_encode(report.refused, &p_out[*p_len]);
+            return nus_bench_is_active() ? NRF_ERROR_BUSY : NRF_SUCCESS;
+
+        case NUS_BENCH_LINK:
+            nus_bench_report_get(&report);
+            *p_len += uint16_encode(report.interval, &p_out[*p_len]);
+            p_out[(*p_len)++] = report.len;
+            p_out[(*p_len)++] = report.tx_bufs;
+            p_out[(*p_len)++] = report.per_event_max;
+            p_out[(*p_len)++] = report.in_flight_max;
+            *p_len += uint16_encode(report.stalls, &p_out[*p_len]);
+            *p_len += uint16_encode(report.stall_ms_max, &p_out[*p_len]);
+            return nus_bench_is_active() ? NRF_ERROR_BUSY : NRF_SUCCESS;
+
+        default:
+            return NRF_ERROR_NOT_SUPPORTED;
+    }
+}
+
+
+/**@brief Raw NUS throughput command, run from the scheduler; answered with NUS_BENCH, op, result, data. */
+static void nus_bench_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t * p_cmd = p_event_data;
+    uint8_t   reply[3 + 14];
+    uint16_t  len;
+
+    if (event_size < 2)
+    {
+        return;
+    }
+
+    reply[0] = NUS_BENCH;
+    reply[1] = p_cmd[1];
+    reply[2] = (uint8_t)nus_bench_run(p_cmd, event_size, &reply[3], &len);
+    nus_reply(reply, 3 + len);
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(DEV_CFG)
+#define DEV_CONFIG_GET      0  /**< DEV_CONFIG, DEV_CONFIG_GET, item: the item and its value. */
+#define DEV_CONFIG_SET      1  /**< DEV_CONFIG, DEV_CONFIG_SET, item, value (LE) [, item, value ...]. */
+#define DEV_CONFIG_RESET    2  /**< DEV_CONFIG, DEV_CONFIG_RESET: back to the values of the build. */
+
+/**@brief Site settings query or change; values are LE in the size of their item. */
+static ret_code_t dev_config_run(uint8_t * p_cmd, uint16_t event_size, uint8_t * p_out, uint16_t * p_len)
+{
+    uint8_t size;
+
+    *p_len = 0;
+    if (event_size < 2)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    switch (p_cmd[1])
+    {
+        case DEV_CONFIG_GET:
+            if (event_size != 3)
+            {
+                return NRF_ERROR_INVALID_LENGTH;
+            }
+            size = dev_cfg_size((dev_cfg_item_t)p_cmd[2]);
+            if (size == 0)
+            {
+                return NRF_ERROR_NOT_FOUND;
+            }
+            p_out[(*p_len)++] = p_cmd[2];
+            if (size == sizeof(uint8_t))
+            {
+                p_out[(*p_len)++] = (uint8_t)dev_cfg_value((dev_cfg_item_t)p_cmd[2]);
+            }
+            else
+            {
+                *p_len += uint16_encode(dev_cfg_value((dev_cfg_item_t)p_cmd[2]), &p_out[*p_len]);
+            }
+            return NRF_SUCCESS;
+
+        case DEV_CONFIG_SET:
+            return dev_cfg_write(&p_cmd[2], event_size - 2);
+
+        case DEV_CONFIG_RESET:
+            dev_cfg_reset();
+            return NRF_SUCCESS;
+
+        default:
+            return NRF_ERROR_NOT_SUPPORTED;
+    }
+}
+
+
+/**@brief Raw settings command, run from the scheduler; answered with DEV_CONFIG, op, result, data. */
+static void dev_config_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t * p_cmd = p_event_data;
+    uint8_t   reply[3 + 3];
+    uint16_t  len;
+
+    if (event_size < 2)
+    {
+        return;
+    }
+
+    reply[0] = DEV_CONFIG;
+    reply[1] = p_cmd[1];
+    reply[2] = (uint8_t)dev_config_run(p_cmd, event_size, &reply[3], &len);
+    nus_reply(reply, 3 + len);
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(POST_MORTEM)
+/**@brief Send the kept fault snapshots again; ends with POST_MORTEM, POST_MORTEM_DONE, result. */
+static void post_mortem_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t reply[3];
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    reply[0] = POST_MORTEM;
+    reply[1] = POST_MORTEM_DONE;
+    reply[2] = (uint8_t)post_mortem_send_all(nus_tx_target_get());
+    nus_reply(reply, sizeof(reply));
+}
+#endif
+
+
+/**@brief Run a raw card command from NUS or the UART.
+ *
+ * @details The PN532 transaction blocks for tens of milliseconds, so it never runs in the BLE
+ *          or UART event handlers; both queue the command and the main loop serves them one at
+ *          a time.
+ */
+static void command_run(uint8_t const * p_data, uint16_t length)
+{
+    uint8_t cmd[24] = {0};
+
+    memcpy(cmd, p_data, MIN(length, sizeof(cmd)));
+    if (cmd[0] == 0x00)
+    {
+        return;
+    }
+#if NRF_MODULE_ENABLED(LAT_TRACE)
+    if (cmd[0] == TRACE_READ)
+    {
+        // Typed on the UART console; NUS queries are answered by trace_read_handler.
+        lat_trace_print();
+        return;
+    }
+#endif
+    LAT_TRACE_START(t);
+    // No beep up front: the card decision plays its own pattern, and one queued here would
+    // hold it back by the length of the beep.
+    if (cmd_reg_dispatch(cmd, MIN(length, sizeof(cmd))) == NRF_ERROR_NOT_SUPPORTED)
+    {
+        printf("no_card \r\n");
+    }
+    LAT_TRACE_STOP(LAT_STAGE_COMMAND, t);
+}
+
+
+#if NRF_MODULE_ENABLED(CMD_RING)
+// One ring per producer: the BLE event handler and the UART event handler.
+CMD_RING_DEF(m_nus_ring, NUS_RING_SIZE);
+CMD_RING_DEF(m_uart_ring, UART_RING_SIZE);
+
+static volatile bool m_ingress_pending;
+
+
+/**@brief Copy of a NUS write to the UART log; dropped when the UART FIFO is full. */
+static void uart_echo(uint8_t const * p_data, uint16_t length)
+{
+    for (uint16_t i = 0; i < length; i++)
+    {
+        if (app_uart_put(p_data[i]) != NRF_SUCCESS)
+        {
+            return;
+        }
+    }
+    UNUSED_RETURN_VALUE(app_uart_put('\r'));
+    UNUSED_RETURN_VALUE(app_uart_put('\n'));
+}
+
+
+/**@brief Main loop worker: serve the queued commands in place. */
+static void ingress_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t const * p_cmd;
+    uint16_t        length;
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    // Cleared first, so a command queued while draining posts a new event.
+    m_ingress_pending = false;
+
+    // NUS records start with the handle of the link, which gets the replies.
+    while ((p_cmd = cmd_ring_peek(&m_nus_ring, &length)) != NULL)
+    {
+#if NRF_MODULE_ENABLED(NUS_TX)
+        nus_tx_target_set(uint16_decode(p_cmd));
+#endif
+        uart_echo(&p_cmd[2], length - 2);
+        command_run(&p_cmd[2], length - 2);
+        cmd_ring_release(&m_nus_ring);
+    }
+#if NRF_MODULE_ENABLED(NUS_TX)
+    nus_tx_target_set(BLE_CONN_HANDLE_ALL);
+#endif
+    while ((p_cmd = cmd_ring_peek(&m_uart_ring, &length)) != NULL)
+    {
+        command_run(p_cmd, length);
+        cmd_ring_release(&m_uart_ring);
+    }
+}
+
+
+static void ingress_put(cmd_ring_t * p_ring, uint8_t const * p_data, uint16_t length)
+{
+    if (cmd_ring_put(p_ring, p_data, length) != NRF_SUCCESS)
+    {
+        return;
+    }
+    if (!m_ingress_pending)
+    {
+        m_ingress_pending = true;
+        if (app_sched_event_put(NULL, 0, ingress_handler) != NRF_SUCCESS)
+        {
+            m_ingress_pending = false;
+        }
+    }
+}
+
+
+static void nus_ingress_put(uint16_t conn_handle, uint8_t const * p_data, uint16_t length)
+{
+    uint8_t record[2 + BLE_NUS_MAX_DATA_LEN];
+
+    length = MIN(length, BLE_NUS_MAX_DATA_LEN);
+    UNUSED_RETURN_VALUE(uint16_encode(conn_handle, record));
+    memcpy(&record[2], p_data, length);
+    ingress_put(&m_nus_ring, record, 2 + length);
+}
+#else
+static void command_handler(void * p_event_data, uint16_t event_size)
+{
+    command_run(p_event_data, event_size);
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(LOCK_MOTO)
+static ret_code_t unlock_door(void)
+{
+#if NRF_MODULE_ENABLED(LOCK_STATE)
+    ret_code_t err_code = lock_state_unlock();
+#else
+    ret_code_t err_code = lock_moto_unlock();
+#endif
+
+    if (err_code != NRF_ERROR_INVALID_STATE)
+    {
+        lock_feedback_play(LOCK_FB_SUCCESS);
+    }
+    else
+    {
+        lock_feedback_play(LOCK_FB_FAIL);
+    }
+    return err_code;
+}
 #endif
 
-#define APP_FEATURE_NOT_SUPPORTED       BLE_GATT_STATUS_ATTERR_APP_BEGIN + 2        /**< Reply when unsupported features are requested. */
 
-#define CENTRAL_LINK_COUNT              0                                           /**< Number of central links used by the application. When changing this number remember to adjust the RAM settings*/
-#define PERIPHERAL_LINK_COUNT           1                                           /**< Number of peripheral links used by the application. When changing this number remember to adjust the RAM settings*/
+#if NRF_MODULE_ENABLED(NUS_CMD)
+/**@brief Framed request, run from the scheduler: same commands as the raw protocol.
+ *
+ * @details Replies of the raw protocol go out as data frames of the request; card data from
+ *          pn532_apply.c too.
+ */
+static ret_code_t nus_cmd_handler(uint8_t cmd, uint8_t * p_payload, uint8_t len)
+{
+    uint8_t raw[1 + NUS_CMD_PAYLOAD_MAX] = {0};
+
+    raw[0] = cmd;
+    memcpy(&raw[1], p_payload, len);
+
+    switch (cmd)
+    {
+#if NRF_MODULE_ENABLED(LOCK_MOTO)
+        case UNLOCK_DOOR:
+            return unlock_door();
+#endif
+#if NRF_MODULE_ENABLED(LOCK_ACL)
+        case ACL_LOAD:
+            return acl_load_run(raw, 1 + len);
+#endif
+#if NRF_MODULE_ENABLED(LOCK_ACL_MPH)
+        case ACL_TABLE:
+            return acl_table_run(raw, 1 + len);
+#endif
+#if NRF_MODULE_ENABLED(LOCK_ACL_DELTA)
+        case ACL_DELTA:
+        {
+            uint8_t    out[sizeof(uint32_t)];
+            ret_code_t err_code = acl_delta_run(raw, 1 + len);
 
-#define DEVICE_NAME                     "BLUE_SSH"                               /**< Name of device. Will be included in the advertising data. */
-#define NUS_SERVICE_UUID_TYPE           BLE_UUID_TYPE_VENDOR_BEGIN                  /**< UUID type for the Nordic UART Service (vendor specific). */
+            UNUSED_RETURN_VALUE(nus_cmd_data(out, uint32_encode(lock_acl_version(), out)));
+            return err_code;
+        }
+#endif
+#if NRF_MODULE_ENABLED(LOCK_ACL_ENROLL)
+        case ACL_ENROLL:
+            return pn532_enroll_request(p_payload, len);
+#endif
+#if NRF_MODULE_ENABLED(LOCK_JOURNAL)
+        case JOURNAL_READ:
+        {
+            uint8_t    out[sizeof(lock_journal_entry_t)];
+            uint16_t   out_len;
+            ret_code_t err_code = journal_read_run(raw, 1 + len, out, &out_len);
 
-#define APP_ADV_INTERVAL                64                                          /**64< The advertising interval (in units of 0.625 ms. This value corresponds to 40 ms). */
-#define APP_ADV_TIMEOUT_IN_SECONDS      180                                          /**180< The advertising timeout (in units of seconds). */
+            UNUSED_RETURN_VALUE(nus_cmd_data(out, out_len));
+            return err_code;
+        }
 
-#define APP_TIMER_PRESCALER             0                                           /**< Value of the RTC1 PRESCALER register. */
-//#define APP_TIMER_OP_QUEUE_SIZE         4                                           /**< Size of timer operation queues. */
+        case JOURNAL_FIND:
+        {
+            uint8_t    out[sizeof(lock_journal_entry_t)];
+            uint16_t   out_len;
+            ret_code_t err_code = journal_find_run(raw, 1 + len, out, &out_len);
 
-#define MIN_CONN_INTERVAL               MSEC_TO_UNITS(20, UNIT_1_25_MS)             /**< Minimum acceptable connection interval (20 ms), Connection interval uses 1.25 ms units. */
-#define MAX_CONN_INTERVAL               MSEC_TO_UNITS(75, UNIT_1_25_MS)             /**< Maximum acceptable connection interval (75 ms), Connection interval uses 1.25 ms units. */
-#define SLAVE_LATENCY                   0                                           /**< Slave latency. */
-#define CONN_SUP_TIMEOUT                MSEC_TO_UNITS(4000, UNIT_10_MS)             /**< Connection supervisory timeout (4 seconds), Supervision Timeout uses 10 ms units. */
-#define FIRST_CONN_PARAMS_UPDATE_DELAY  APP_TIMER_TICKS(5000, APP_TIMER_PRESCALER)  /**< Time from initiating event (connect or start of notification) to first time sd_ble_gap_conn_param_update is called (5 seconds). */
-#define NEXT_CONN_PARAMS_UPDATE_DELAY   APP_TIMER_TICKS(30000, APP_TIMER_PRESCALER) /**< Time between each call to sd_ble_gap_conn_param_update after the first call (30 seconds). */
-#define MAX_CONN_PARAMS_UPDATE_COUNT    3                                           /**< Number of attempts before giving up the connection parameter negotiation. */
+            UNUSED_RETURN_VALUE(nus_cmd_data(out, out_len));
+            return err_code;
+        }
+#endif
+#if NRF_MODULE_ENABLED(LAT_TRACE)
+        case TRACE_READ:
+            return trace_read_run(raw, 1 + len);
+#endif
+#if NRF_MODULE_ENABLED(WALL_CLOCK)
+        case TIME_SET:
+        {
+            uint8_t    out[sizeof(uint32_t)];
+            uint16_t   out_len;
+            ret_code_t err_code = time_set_run(raw, 1 + len, out, &out_len);
 
-#define DEAD_BEEF                       0xDEADBEEF                                  /**< Value used as error code on stack dump, can be used to identify stack location on stack unwind. */
+            UNUSED_RETURN_VALUE(nus_cmd_data(out, out_len));
+            return err_code;
+        }
+#endif
+#if NRF_MODULE_ENABLED(PN532_TUNE)
+        case RF_TUNE:
+        {
+            uint8_t    out[6];
+            uint16_t   out_len;
+            ret_code_t err_code = rf_tune_run(raw, 1 + len, out, &out_len);
 
-#define UART_TX_BUF_SIZE                256                                         /**< UART TX buffer size. */
-#define UART_RX_BUF_SIZE                256                                         /**< UART RX buffer size. */
+            UNUSED_RETURN_VALUE(nus_cmd_data(out, out_len));
+            return err_code;
+        }
+#endif
+#if NRF_MODULE_ENABLED(PN532_DIAG)
+        case READER_DIAG:
+        {
+            uint8_t    out[READER_DIAG_LEN];
+            uint16_t   out_len;
+            ret_code_t err_code = reader_diag_run(out, &out_len);
 
-#define APP_TIMER_PRESCALER             0                                           //!< Value of the RTC1 PRESCALER register. */
-#define APP_TIMER_OP_QUEUE_SIZE         6                                           //!< Size of timer operation queues. */
+            UNUSED_RETURN_VALUE(nus_cmd_data(out, out_len));
+            return err_code;
+        }
+#endif
+#if NRF_MODULE_ENABLED(ENERGY)
+        case ENERGY:
+        {
+            uint8_t    out[16];
+            uint16_t   out_len;
+            ret_code_t err_code = energy_run(raw, 1 + len, out, &out_len);
 
-#define SECURITY_REQUEST_DELAY          APP_TIMER_TICKS(1000, APP_TIMER_PRESCALER)  //!< Delay after connection until Security Request is sent, if necessary (ticks). */
+            UNUSED_RETURN_VALUE(nus_cmd_data(out, out_len));
+            return err_code;
+        }
+#endif
+#if NRF_MODULE_ENABLED(RAM_BUDGET)
+        case RAM_BUDGET:
+        {
+            uint8_t    out[15];
+            uint16_t   out_len;
+            ret_code_t err_code = ram_budget_run(raw, 1 + len, out, &out_len);
 
+            UNUSED_RETURN_VALUE(nus_cmd_data(out, out_len));
+            return err_code;
+        }
+#endif
+#if NRF_MODULE_ENABLED(LOAD_GEN)
+        case LOAD_GEN:
+        {
+            uint8_t    out[14];
+            uint16_t   out_len;
+            ret_code_t err_code = load_gen_run(raw, 1 + len, out, &out_len);
 
-ble_nus_t                               m_nus;                                      /**< Structure to identify the Nordic UART Service. */
-static uint16_t                         m_conn_handle = BLE_CONN_HANDLE_INVALID;    /**< Handle of the current connection. */
+            UNUSED_RETURN_VALUE(nus_cmd_data(out, out_len));
+            return err_code;
+        }
+#endif
+#if NRF_MODULE_ENABLED(NUS_BENCH)
+        case NUS_BENCH:
+        {
+            uint8_t    out[14];
+            uint16_t   out_len;
+            ret_code_t err_code = nus_bench_run(raw, 1 + len, out, &out_len);
 
-static ble_uuid_t                       m_adv_uuids[] = {{BLE_UUID_NUS_SERVICE, NUS_SERVICE_UUID_TYPE}};  /**< Universally unique service identifier. */
+            UNUSED_RETURN_VALUE(nus_cmd_data(out, out_len));
+            return err_code;
+        }
+#endif
+#if NRF_MODULE_ENABLED(DEV_CFG)
+        case DEV_CONFIG:
+        {
+            uint8_t    out[3];
+            uint16_t   out_len;
+            ret_code_t err_code = dev_config_run(raw, 1 + len, out, &out_len);
 
-APP_TIMER_DEF(m_sec_req_timer_id);    
+            UNUSED_RETURN_VALUE(nus_cmd_data(out, out_len));
+            return err_code;
+        }
+#endif
+#if NRF_MODULE_ENABLED(CARD_SCRIPT)
+        case CARD_SCRIPT:
+            return pn532_script_request(p_payload, len);
+#endif
+        case LINK_ADMIN:
+            return nus_tx_admin_set(nus_tx_target_get(), (len > 0) && (p_payload[0] != 0));
 
-uint8_t recv_data[24] ={0};
+        default:
+            // The card commands and whatever else the modules registered.
+            return cmd_reg_dispatch(raw, 1 + len);
+    }
+}
+#endif
 
 
+#if NRF_MODULE_ENABLED(NUS_TX)
+/**@brief NUS write queued for the scheduler, with the link that gets the replies. */
+typedef struct
+{
+    app_sched_event_handler_t handler;
+    uint16_t                  conn_handle;
+    uint16_t                  length;
+    uint8_t                   data[BLE_NUS_MAX_DATA_LEN];
+} nus_link_evt_t;
 
+STATIC_ASSERT(sizeof(nus_link_evt_t) <= SCHED_MAX_EVENT_DATA_SIZE);
 
 
+static void nus_link_handler(void * p_event_data, uint16_t event_size)
+{
+    nus_link_evt_t * p_evt = p_event_data;
 
+    UNUSED_PARAMETER(event_size);
 
+    nus_tx_target_set(p_evt->conn_handle);
+    p_evt->handler(p_evt->data, p_evt->length);
+    nus_tx_target_set(BLE_CONN_HANDLE_ALL);
+}
+#endif
 
 
+/**@brief Queue a NUS write for the scheduler; its replies go back to the writing link. */
+static void nus_sched_put(uint16_t                  conn_handle,
+                          uint8_t const           * p_data,
+                          uint16_t                  length,
+                          app_sched_event_handler_t handler)
+{
+#if NRF_MODULE_ENABLED(NUS_TX)
+    nus_link_evt_t evt;
+
+    evt.handler     = handler;
+    evt.conn_handle = conn_handle;
+    evt.length      = MIN(length, sizeof(evt.data));
+    memcpy(evt.data, p_data, evt.length);
+#if NRF_MODULE_ENABLED(NUS_RX)
+    // A pooled write is already in the main loop, and its credit waits for it: no second queue.
+    if (current_int_priority_get() == APP_IRQ_PRIORITY_THREAD)
+    {
+        nus_link_handler(&evt, sizeof(evt));
+        return;
+    }
+#endif
+    UNUSED_RETURN_VALUE(app_sched_event_put(&evt, sizeof(evt), nus_link_handler));
+#else
+    UNUSED_PARAMETER(conn_handle);
+#if NRF_MODULE_ENABLED(NUS_RX)
+    if (current_int_priority_get() == APP_IRQ_PRIORITY_THREAD)
+    {
+        handler((void *)p_data, MIN(length, BLE_NUS_MAX_DATA_LEN));
+        return;
+    }
+#endif
+    UNUSED_RETURN_VALUE(app_sched_event_put((void *)p_data, MIN(length, BLE_NUS_MAX_DATA_LEN),
+                                            handler));
+#endif
+}
 
 
+/**@brief Run or queue a raw command from a NUS write or a NUS frame. */
+static void nus_command_dispatch(uint16_t conn_handle, uint8_t * p_data, uint16_t length)
+{
+#if NRF_MODULE_ENABLED(NUS_TX)
+    // Answered right away with LINK_ADMIN, result: admin links get a copy of every card result.
+    if ((length == 2) && (p_data[0] == LINK_ADMIN))
+    {
+        uint8_t reply[2];
 
+        reply[0] = LINK_ADMIN;
+        reply[1] = (uint8_t)nus_tx_admin_set(conn_handle, p_data[1] != 0);
+        UNUSED_RETURN_VALUE(nus_tx_put(conn_handle, reply, sizeof(reply), 0));
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(LOCK_MOTO)
+    // Start the motor from the BLE event itself; going through the main loop would
+    // put the PN532 polling in front of it.
+    if ((length > 0) && (p_data[0] == UNLOCK_DOOR))
+    {
+        UNUSED_RETURN_VALUE(unlock_door());
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(LOCK_ACL)
+    if ((length > 0) && (p_data[0] == ACL_LOAD))
+    {
+        nus_sched_put(conn_handle, p_data, length, acl_load_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(LOCK_ACL_MPH)
+    if ((length > 0) && (p_data[0] == ACL_TABLE))
+    {
+        nus_sched_put(conn_handle, p_data, length, acl_table_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(LOCK_ACL_DELTA)
+    if ((length > 0) && (p_data[0] == ACL_DELTA))
+    {
+        nus_sched_put(conn_handle, p_data, length, acl_delta_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(LOCK_ACL_ENROLL)
+    if ((length > 0) && (p_data[0] == ACL_ENROLL))
+    {
+        nus_sched_put(conn_handle, p_data, length, acl_enroll_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(LOCK_JOURNAL)
+    if ((length > 0) && (p_data[0] == JOURNAL_READ))
+    {
+        nus_sched_put(conn_handle, p_data, length, journal_read_handler);
+        return;
+    }
+    if ((length > 0) && (p_data[0] == JOURNAL_FIND))
+    {
+        nus_sched_put(conn_handle, p_data, length, journal_find_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(JOURNAL_SYNC)
+    if ((length > 0) && (p_data[0] == JOURNAL_SYNC))
+    {
+        nus_sched_put(conn_handle, p_data, length, journal_sync_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(WALL_CLOCK)
+    if ((length > 0) && (p_data[0] == TIME_SET))
+    {
+        nus_sched_put(conn_handle, p_data, length, time_set_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(LAT_TRACE)
+    if ((length > 0) && (p_data[0] == TRACE_READ))
+    {
+        nus_sched_put(conn_handle, p_data, length, trace_read_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(PN532_TUNE)
+    if ((length > 0) && (p_data[0] == RF_TUNE))
+    {
+        nus_sched_put(conn_handle, p_data, length, rf_tune_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(PN532_DIAG)
+    if ((length > 0) && (p_data[0] == READER_DIAG))
+    {
+        nus_sched_put(conn_handle, p_data, length, reader_diag_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(ENERGY)
+    if ((length > 0) && (p_data[0] == ENERGY))
+    {
+        nus_sched_put(conn_handle, p_data, length, energy_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(RAM_BUDGET)
+    if ((length > 0) && (p_data[0] == RAM_BUDGET))
+    {
+        nus_sched_put(conn_handle, p_data, length, ram_budget_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(LOAD_GEN)
+    if ((length > 0) && (p_data[0] == LOAD_GEN))
+    {
+        nus_sched_put(conn_handle, p_data, length, load_gen_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(NUS_BENCH)
+    if ((length > 0) && (p_data[0] == NUS_BENCH))
+    {
+        nus_sched_put(conn_handle, p_data, length, nus_bench_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(DEV_CFG)
+    if ((length > 0) && (p_data[0] == DEV_CONFIG))
+    {
+        nus_sched_put(conn_handle, p_data, length, dev_config_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(POST_MORTEM)
+    if ((length > 0) && (p_data[0] == POST_MORTEM))
+    {
+        nus_sched_put(conn_handle, p_data, length, post_mortem_handler);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(CMD_RING)
+    // Echoed to the UART from the main loop, so a slow UART never holds up the BLE events.
+    nus_ingress_put(conn_handle, p_data, length);
+#else
+    for (uint32_t i = 0; i < length; i++)
+    {
+        while (app_uart_put(p_data[i]) != NRF_SUCCESS);
+    }
+    while (app_uart_put('\r') != NRF_SUCCESS);
+    while (app_uart_put('\n') != NRF_SUCCESS);
 
+    nus_sched_put(conn_handle, p_data, length, command_handler);
+#endif
+}
 
 
-/**@brief Function for assert macro callback.
- *
- * @details This function will be called in case of an assert in the SoftDevice.
- *
- * @warning This handler is an example only and does not fit a final product. You need to analyse
- *          how your product is supposed to react in case of Assert.
- * @warning On assert from the SoftDevice, the system can only recover on reset.
- *
- * @param[in] line_num    Line number of the failing ASSERT call.
- * @param[in] p_file_name File name of the failing ASSERT call.
- */
-void assert_nrf_callback(uint16_t line_num, const uint8_t * p_file_name)
+#if NRF_MODULE_ENABLED(STREAM_FRAME)
+static void nus_stream_handler(void * p_context, uint8_t * p_data, uint16_t len)
 {
-    app_error_handler(DEAD_BEEF, line_num, p_file_name);
+    nus_stream_t * p_link = p_context;
+
+    p_link->framed = true;
+    nus_command_dispatch(p_link->conn_handle, p_data, len);
 }
 
 
-/**@brief Function for the GAP initialization.
+/**@brief Feed a NUS write to the stream of its link.
  *
- * @details This function will set up all the necessary GAP (Generic Access Profile) parameters of
- *          the device. It also sets the permissions and appearance.
+ * @return false if the write is not framed (no frame in progress and the first byte is not
+ *         STREAM_FRAME_END), so it is a raw command.
  */
-static void gap_params_init(void)
+static bool nus_stream_on_data(uint16_t conn_handle, uint8_t const * p_data, uint16_t length)
 {
-    uint32_t                err_code;
-    ble_gap_conn_params_t   gap_conn_params;
-    ble_gap_conn_sec_mode_t sec_mode;
-
-    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&sec_mode);
+    nus_stream_t * p_link = nus_stream_find(conn_handle);
 
-    err_code = sd_ble_gap_device_name_set(&sec_mode,
-                                          (const uint8_t *) DEVICE_NAME,
-                                          strlen(DEVICE_NAME));
-    APP_ERROR_CHECK(err_code);
+    if ((p_link == NULL) || !stream_frame_dec_busy(&p_link->dec))
+    {
+        if ((length == 0) || (p_data[0] != STREAM_FRAME_END))
+        {
+            return false;
+        }
+        if (p_link == NULL)
+        {
+            p_link = nus_stream_find(BLE_CONN_HANDLE_INVALID);
+            if (p_link == NULL)
+            {
+                return false;
+            }
+            p_link->conn_handle = conn_handle;
+        }
+    }
 
-    memset(&gap_conn_params, 0, sizeof(gap_conn_params));
+    stream_frame_feed(&p_link->dec, p_data, length, nus_stream_handler, p_link);
+    return true;
+}
+#endif
 
-    gap_conn_params.min_conn_interval = MIN_CONN_INTERVAL;
-    gap_conn_params.max_conn_interval = MAX_CONN_INTERVAL;
-    gap_conn_params.slave_latency     = SLAVE_LATENCY;
-    gap_conn_params.conn_sup_timeout  = CONN_SUP_TIMEOUT;
 
-    err_code = sd_ble_gap_ppcp_set(&gap_conn_params);
-    APP_ERROR_CHECK(err_code);
+/**@brief Hand a NUS write to framed commands, a stream or the raw commands. */
+static void nus_data_dispatch(uint16_t conn_handle, uint8_t * p_data, uint16_t length)
+{
+#if NRF_MODULE_ENABLED(NUS_CMD)
+    if (nus_cmd_on_data(conn_handle, p_data, length))
+    {
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(STREAM_FRAME)
+    if (nus_stream_on_data(conn_handle, p_data, length))
+    {
+        return;
+    }
+#endif
+    nus_command_dispatch(conn_handle, p_data, length);
 }
 
 
-/**@brief Function for handling the data from the Nordic UART Service.
- *
- * @details This function will process the data received from the Nordic UART BLE Service and send
- *          it to the UART module.
- *
- * @param[in] p_nus    Nordic UART Service structure.
- * @param[in] p_data   Data to be send to UART module.
- * @param[in] length   Length of the data.
- */
+CRIT_PROF_SITE_DEF(m_nus_data_site, "nus_data");
+
 /**@snippet [Handling the data received over BLE] */
 static void nus_data_handler(ble_nus_t * p_nus, uint8_t * p_data, uint16_t length)
 {
-    for (uint32_t i = 0; i < length; i++)
+    CRIT_PROF_BEGIN(start);
+
+#if NRF_MODULE_ENABLED(NUS_BENCH)
+    // An upload being measured: counted here, never run.
+    if (nus_bench_on_data(p_nus->conn_handle, p_data, length))
     {
-        while (app_uart_put(p_data[i]) != NRF_SUCCESS);
-			  recv_data[i] = p_data[i];
+        CRIT_PROF_END(m_nus_data_site, start);
+        return;
     }
-    while (app_uart_put('\r') != NRF_SUCCESS);
-    while (app_uart_put('\n') != NRF_SUCCESS);
-		
-		
+#endif
+#if NRF_MODULE_ENABLED(NUS_RX)
+    // Links in credit mode: into the pool, for nus_rx_process() in the main loop.
+    if (nus_rx_on_data(p_nus->conn_handle, p_data, length))
+    {
+        CRIT_PROF_END(m_nus_data_site, start);
+        return;
+    }
+#endif
+    nus_data_dispatch(p_nus->conn_handle, p_data, length);
+    CRIT_PROF_END(m_nus_data_site, start);
 }
 /**@snippet [Handling the data received over BLE] */
 
@@ -191,9 +2103,57 @@ static void services_init(void)
     memset(&nus_init, 0, sizeof(nus_init));
 
     nus_init.data_handler = nus_data_handler;
+#if NRF_MODULE_ENABLED(NUS_QWR)
+    nus_init.long_write   = true;
+#endif
 
     err_code = ble_nus_init(&m_nus, &nus_init);
     APP_ERROR_CHECK(err_code);
+#if NRF_MODULE_ENABLED(NUS_QWR)
+    err_code = nus_qwr_init(&m_nus);
+    APP_ERROR_CHECK(err_code);
+#endif
+#if NRF_MODULE_ENABLED(NUS_TX)
+    nus_tx_init(&m_nus);
+#endif
+#if NRF_MODULE_ENABLED(JOURNAL_SYNC)
+    err_code = journal_sync_init(&m_nus);
+    APP_ERROR_CHECK(err_code);
+#endif
+#if NRF_MODULE_ENABLED(BURST_LINK)
+    err_code = burst_link_init();
+    APP_ERROR_CHECK(err_code);
+#endif
+#if NRF_MODULE_ENABLED(LINK_STATS)
+    link_stats_init();
+    err_code = link_stats_service_init(m_nus.uuid_type);
+    APP_ERROR_CHECK(err_code);
+#endif
+#if NRF_MODULE_ENABLED(NUS_BENCH)
+    err_code = nus_bench_init(&m_nus);
+    APP_ERROR_CHECK(err_code);
+#endif
+#if NRF_MODULE_ENABLED(LOG_NUS)
+    err_code = log_nus_service_init(m_nus.uuid_type);
+    APP_ERROR_CHECK(err_code);
+#endif
+#if NRF_MODULE_ENABLED(NUS_RX)
+    err_code = nus_rx_init(m_nus.uuid_type, nus_data_dispatch);
+    APP_ERROR_CHECK(err_code);
+#endif
+#if NRF_MODULE_ENABLED(NUS_CMD)
+    nus_cmd_init(nus_cmd_handler);
+#endif
+#if NRF_MODULE_ENABLED(HID_WEDGE)
+    err_code = hid_wedge_init();
+    APP_ERROR_CHECK(err_code);
+#endif
+#if NRF_MODULE_ENABLED(STREAM_FRAME)
+    for (uint32_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        nus_stream_reset(&m_nus_stream[i]);
+    }
+#endif
 }
 
 
@@ -210,12 +2170,14 @@ static void services_init(void)
  */
 static void on_conn_params_evt(ble_conn_params_evt_t * p_evt)
 {
-    uint32_t err_code;
-
     if (p_evt->evt_type == BLE_CONN_PARAMS_EVT_FAILED)
     {
-        err_code = sd_ble_gap_disconnect(m_conn_handle, BLE_HCI_CONN_INTERVAL_UNACCEPTABLE);
+#if NRF_MODULE_ENABLED(CONN_POLICY)
+        // The central refused a profile of conn_policy and keeps its own parameters.
+#else
+        uint32_t err_code = sd_ble_gap_disconnect(m_conn_handle, BLE_HCI_CONN_INTERVAL_UNACCEPTABLE);
         APP_ERROR_CHECK(err_code);
+#endif
     }
 }
 
@@ -265,6 +2227,9 @@ static void sleep_mode_enter(void)
     // Prepare wakeup buttons.
     err_code = bsp_btn_ble_sleep_mode_prepare();
     APP_ERROR_CHECK(err_code);
+#if NRF_MODULE_ENABLED(ADV_SCHED)
+    adv_sched_sleep_prepare();
+#endif
 
     // Go to system-off mode (this function will not return; wakeup will cause a reset).
     err_code = sd_power_system_off();
@@ -272,6 +2237,17 @@ static void sleep_mode_enter(void)
 }
 
 
+#if NRF_MODULE_ENABLED(ADV_SCHED)
+static void sleep_handler(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    sleep_mode_enter();
+}
+#endif
+
+
 /**@brief Function for handling advertising events.
  *
  * @details This function will be called for advertising events which are passed to the application.
@@ -289,11 +2265,22 @@ static void on_adv_evt(ble_adv_evt_t ble_adv_evt)
             APP_ERROR_CHECK(err_code);
             break;
         case BLE_ADV_EVT_IDLE:
+#if NRF_MODULE_ENABLED(ADV_SCHED)
+            // The PN532 is put to sleep over the bus, which the main loop may be using.
+            UNUSED_RETURN_VALUE(app_sched_event_put(NULL, 0, sleep_handler));
+#else
             sleep_mode_enter();
+#endif
             break;
         default:
             break;
     }
+#if NRF_MODULE_ENABLED(ADV_SCHED)
+    adv_sched_on_adv_evt(ble_adv_evt);
+#endif
+#if NRF_MODULE_ENABLED(PEER_BOND)
+    peer_bond_on_adv_evt(ble_adv_evt);
+#endif
 }
 
 
@@ -311,25 +2298,63 @@ static void on_ble_evt(ble_evt_t * p_ble_evt)
             err_code = bsp_indication_set(BSP_INDICATE_CONNECTED);
             APP_ERROR_CHECK(err_code);
             m_conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+            keep_ram_count(KEEP_RAM_CNT_CONNECTS);
+#if PERIPHERAL_LINK_COUNT > 1
+            // The SoftDevice stops advertising on every connection; keep taking peers.
+            if (++m_link_count < PERIPHERAL_LINK_COUNT)
+            {
+                err_code = ble_advertising_start(BLE_ADV_MODE_FAST);
+                APP_ERROR_CHECK(err_code);
+            }
+#endif
             break; // BLE_GAP_EVT_CONNECTED
 
         case BLE_GAP_EVT_DISCONNECTED:
             err_code = bsp_indication_set(BSP_INDICATE_IDLE);
             APP_ERROR_CHECK(err_code);
-            m_conn_handle = BLE_CONN_HANDLE_INVALID;
+            if (m_conn_handle == p_ble_evt->evt.gap_evt.conn_handle)
+            {
+                m_conn_handle = BLE_CONN_HANDLE_INVALID;
+            }
+#if PERIPHERAL_LINK_COUNT > 1
+            // The advertising module only restarts for the last link that connected.
+            if (m_link_count-- == PERIPHERAL_LINK_COUNT)
+            {
+                err_code = ble_advertising_start(BLE_ADV_MODE_FAST);
+                if (err_code != NRF_ERROR_INVALID_STATE)
+                {
+                    APP_ERROR_CHECK(err_code);
+                }
+            }
+#endif
+#if NRF_MODULE_ENABLED(NUS_CMD)
+            nus_cmd_reset(p_ble_evt->evt.gap_evt.conn_handle);
+#endif
+#if NRF_MODULE_ENABLED(STREAM_FRAME)
+            {
+                nus_stream_t * p_link = nus_stream_find(p_ble_evt->evt.gap_evt.conn_handle);
+
+                if (p_link != NULL)
+                {
+                    nus_stream_reset(p_link);
+                }
+            }
+#endif
             break; // BLE_GAP_EVT_DISCONNECTED
 
+#if !NRF_MODULE_ENABLED(PEER_BOND)
         case BLE_GAP_EVT_SEC_PARAMS_REQUEST:
             // Pairing not supported
-            err_code = sd_ble_gap_sec_params_reply(m_conn_handle, BLE_GAP_SEC_STATUS_PAIRING_NOT_SUPP, NULL, NULL);
+            err_code = sd_ble_gap_sec_params_reply(p_ble_evt->evt.gap_evt.conn_handle, BLE_GAP_SEC_STATUS_PAIRING_NOT_SUPP, NULL, NULL);
             APP_ERROR_CHECK(err_code);
             break; // BLE_GAP_EVT_SEC_PARAMS_REQUEST
 
         case BLE_GATTS_EVT_SYS_ATTR_MISSING:
             // No system attributes have been stored.
-            err_code = sd_ble_gatts_sys_attr_set(m_conn_handle, NULL, 0, 0);
+            err_code = sd_ble_gatts_sys_attr_set(p_ble_evt->evt.gatts_evt.conn_handle, NULL, 0, 0);
             APP_ERROR_CHECK(err_code);
             break; // BLE_GATTS_EVT_SYS_ATTR_MISSING
+#endif
 
         case BLE_GATTC_EVT_TIMEOUT:
             // Disconnect on GATT Client timeout event.
@@ -345,6 +2370,8 @@ static void on_ble_evt(ble_evt_t * p_ble_evt)
             APP_ERROR_CHECK(err_code);
             break; // BLE_GATTS_EVT_TIMEOUT
 
+#if !NRF_MODULE_ENABLED(NUS_QWR)
+        // Otherwise nus_qwr takes the queued writes, and ble_nus the Write Requests.
         case BLE_EVT_USER_MEM_REQUEST:
             err_code = sd_ble_user_mem_reply(p_ble_evt->evt.gattc_evt.conn_handle, NULL);
             APP_ERROR_CHECK(err_code);
@@ -357,20 +2384,14 @@ static void on_ble_evt(ble_evt_t * p_ble_evt)
 
             req = p_ble_evt->evt.gatts_evt.params.authorize_request;
 
-            if (req.type != BLE_GATTS_AUTHORIZE_TYPE_INVALID)
+            // Reads are answered by the service that asked for them; only the op of a write is valid.
+            if (req.type == BLE_GATTS_AUTHORIZE_TYPE_WRITE)
             {
                 if ((req.request.write.op == BLE_GATTS_OP_PREP_WRITE_REQ)     ||
                     (req.request.write.op == BLE_GATTS_OP_EXEC_WRITE_REQ_NOW) ||
                     (req.request.write.op == BLE_GATTS_OP_EXEC_WRITE_REQ_CANCEL))
                 {
-                    if (req.type == BLE_GATTS_AUTHORIZE_TYPE_WRITE)
-                    {
-                        auth_reply.type = BLE_GATTS_AUTHORIZE_TYPE_WRITE;
-                    }
-                    else
-                    {
-                        auth_reply.type = BLE_GATTS_AUTHORIZE_TYPE_READ;
-                    }
+                    auth_reply.type = BLE_GATTS_AUTHORIZE_TYPE_WRITE;
                     auth_reply.params.write.gatt_status = APP_FEATURE_NOT_SUPPORTED;
                     err_code = sd_ble_gatts_rw_authorize_reply(p_ble_evt->evt.gatts_evt.conn_handle,
                                                                &auth_reply);
@@ -378,13 +2399,6 @@ static void on_ble_evt(ble_evt_t * p_ble_evt)
                 }
             }
         } break; // BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST
-
-#if (NRF_SD_BLE_API_VERSION == 3)
-        case BLE_GATTS_EVT_EXCHANGE_MTU_REQUEST:
-            err_code = sd_ble_gatts_exchange_mtu_reply(p_ble_evt->evt.gatts_evt.conn_handle,
-                                                       NRF_BLE_MAX_MTU_SIZE);
-            APP_ERROR_CHECK(err_code);
-            break; // BLE_GATTS_EVT_EXCHANGE_MTU_REQUEST
 #endif
 
         default:
@@ -394,6 +2408,9 @@ static void on_ble_evt(ble_evt_t * p_ble_evt)
 }
 
 
+CRIT_PROF_SITE_DEF(m_ble_evt_site, "ble_evt");
+CRIT_PROF_SITE_DEF(m_sys_evt_site, "sys_evt");
+
 /**@brief Function for dispatching a SoftDevice event to all modules with a SoftDevice
  *        event handler.
  *
@@ -404,12 +2421,94 @@ static void on_ble_evt(ble_evt_t * p_ble_evt)
  */
 static void ble_evt_dispatch(ble_evt_t * p_ble_evt)
 {
+    CRIT_PROF_BEGIN(start);
+
+#if NRF_MODULE_ENABLED(GW_PUSH)
+    if (gw_push_on_ble_evt(p_ble_evt))
+    {
+        // The gateway link: nothing below is meant for it.
+        CRIT_PROF_END(m_ble_evt_site, start);
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(PEER_BOND)
+    peer_bond_on_ble_evt(p_ble_evt);
+#endif
+#if NRF_MODULE_ENABLED(WALL_CLOCK)
+    wall_clock_on_ble_evt(p_ble_evt);
+#endif
+#if NRF_MODULE_ENABLED(PASSBACK)
+    passback_on_ble_evt(p_ble_evt);
+#endif
+#if NRF_MODULE_ENABLED(NFC_PAIR)
+    nfc_pair_on_ble_evt(p_ble_evt);
+#endif
+#if NRF_BLE_GATT_ENABLED
+    nrf_ble_gatt_on_ble_evt(&m_gatt, p_ble_evt);
+#endif
     ble_conn_params_on_ble_evt(p_ble_evt);  /*Ӳ*/
+#if NRF_MODULE_ENABLED(CONN_POLICY)
+    conn_policy_on_ble_evt(p_ble_evt);
+#endif
+#if NRF_MODULE_ENABLED(HID_WEDGE)
+    hid_wedge_on_ble_evt(p_ble_evt);
+#endif
+#if NRF_MODULE_ENABLED(NUS_QWR)
+    nus_qwr_on_ble_evt(p_ble_evt);
+#endif
     ble_nus_on_ble_evt(&m_nus, p_ble_evt);   
+#if NRF_MODULE_ENABLED(LINK_STATS)
+    // Before nus_tx, which refills the buffers an acknowledgement frees.
+    link_stats_on_ble_evt(p_ble_evt);
+#endif
+#if NRF_MODULE_ENABLED(NUS_TX)
+    nus_tx_on_ble_evt(p_ble_evt);
+#endif
+#if NRF_MODULE_ENABLED(JOURNAL_SYNC)
+    // After nus_tx, so a TX complete has freed the buffers the sync fills.
+    journal_sync_on_ble_evt(p_ble_evt);
+#endif
+#if NRF_MODULE_ENABLED(NUS_BENCH)
+    // After nus_tx, so replies get the buffers an acknowledgement frees before the stream.
+    nus_bench_on_ble_evt(p_ble_evt);
+#endif
+#if NRF_MODULE_ENABLED(LOG_NUS)
+    log_nus_on_ble_evt(p_ble_evt);
+#endif
+#if NRF_MODULE_ENABLED(NUS_RX)
+    nus_rx_on_ble_evt(p_ble_evt);
+#endif
+#if NRF_MODULE_ENABLED(POST_MORTEM)
+    post_mortem_on_ble_evt(p_ble_evt);
+#endif
     on_ble_evt(p_ble_evt);                /*ͨ¼*/
     ble_advertising_on_ble_evt(p_ble_evt); /*㲥¼*/
     bsp_btn_ble_on_ble_evt(p_ble_evt);  /*弫¼*/
+    CRIT_PROF_END(m_ble_evt_site, start);
+}
+
+
+/**@brief Function for dispatching a system event to interested modules.
+ *
+ * @details This function is called from the System event interrupt handler after a system
+ *          event has been received.
+ *
+ * @param[in] sys_evt  System stack event.
+ */
+static void sys_evt_dispatch(uint32_t sys_evt)
+{
+    CRIT_PROF_BEGIN(start);
 
+    fs_sys_event_handler(sys_evt);
+    // Restarts advertising that was held back while flash was being written.
+    ble_advertising_on_sys_evt(sys_evt);
+#if NRF_MODULE_ENABLED(BURST_LINK)
+    burst_link_on_sys_evt(sys_evt);
+#endif
+#if NRF_MODULE_ENABLED(KEEP_RAM)
+    keep_ram_on_sys_evt(sys_evt);
+#endif
+    CRIT_PROF_END(m_sys_evt_site, start);
 }
 
 
@@ -424,7 +2523,11 @@ static void ble_stack_init(void)
     nrf_clock_lf_cfg_t clock_lf_cfg = NRF_CLOCK_LFCLKSRC;
 
     // Initialize SoftDevice.
+#if NRF_MODULE_ENABLED(APP_RTOS)
+    SOFTDEVICE_HANDLER_INIT(&clock_lf_cfg, app_rtos_sd_evt_notify);
+#else
     SOFTDEVICE_HANDLER_INIT(&clock_lf_cfg, NULL);
+#endif
 
     ble_enable_params_t ble_enable_params;
     err_code = softdevice_enable_get_default_config(CENTRAL_LINK_COUNT,
@@ -437,14 +2540,30 @@ static void ble_stack_init(void)
 
     // Enable BLE stack.
 #if (NRF_SD_BLE_API_VERSION == 3)
-    ble_enable_params.gatt_enable_params.att_mtu = NRF_BLE_MAX_MTU_SIZE;
+    ble_enable_params.gatt_enable_params.att_mtu = NRF_BLE_GATT_MAX_MTU_SIZE;
 #endif
     err_code = softdevice_enable(&ble_enable_params);
     APP_ERROR_CHECK(err_code);
 
+#if (NRF_SD_BLE_API_VERSION == 3) && (NRF_BLE_GATT_MAX_MTU_SIZE > GATT_MTU_SIZE_DEFAULT)
+    {
+        // Link layer packets that carry a whole notification: ATT MTU plus the L2CAP header.
+        ble_opt_t opt;
+
+        memset(&opt, 0, sizeof(opt));
+        opt.gap_opt.ext_len.rxtx_max_pdu_payload_size = MIN(NRF_BLE_GATT_MAX_MTU_SIZE + 4, 251);
+        err_code = sd_ble_opt_set(BLE_GAP_OPT_EXT_LEN, &opt);
+        APP_ERROR_CHECK(err_code);
+    }
+#endif
+
     // Subscribe for BLE events.
     err_code = softdevice_ble_evt_handler_set(ble_evt_dispatch);
     APP_ERROR_CHECK(err_code);
+
+    // Register with the SoftDevice handler module for system events (flash operations).
+    err_code = softdevice_sys_evt_handler_set(sys_evt_dispatch);
+    APP_ERROR_CHECK(err_code);
 }
 
 
@@ -487,6 +2606,62 @@ void bsp_event_handler(bsp_event_t event)
 }
 
 
+/**@brief Queue a command that came in on the UART; copied out, so the buffer can be reused. */
+static void uart_command_put(uint8_t const * p_data, uint16_t length)
+{
+#if NRF_MODULE_ENABLED(CMD_RING)
+    ingress_put(&m_uart_ring, p_data, length);
+#else
+    UNUSED_RETURN_VALUE(app_sched_event_put((void *)p_data, length, command_handler));
+#endif
+}
+
+
+#if NRF_MODULE_ENABLED(STREAM_FRAME)
+static stream_frame_dec_t m_uart_dec;
+static uint8_t            m_uart_dec_buf[STREAM_FRAME_BUF_SIZE(STREAM_FRAME_MAX_LEN)];
+
+
+static void uart_stream_handler(void * p_context, uint8_t * p_data, uint16_t len)
+{
+    UNUSED_PARAMETER(p_context);
+
+    uart_command_put(p_data, len);
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(UART_FRAME)
+#if UART_FRAME_MAX_LEN > BLE_NUS_MAX_DATA_LEN
+#error "UART_FRAME_MAX_LEN must not exceed BLE_NUS_MAX_DATA_LEN"
+#endif
+
+/**@brief   Function for handling the frames of the command link.
+ *
+ * @details A frame is one command, delimited by the idle line instead of a '\n'; with
+ *          STREAM_FRAME the frames are only chunks of the SLIP stream.
+ */
+static void uart_frame_handler(uart_frame_evt_t const * p_evt)
+{
+    switch (p_evt->type)
+    {
+        case UART_FRAME_EVT_RX:
+#if NRF_MODULE_ENABLED(STREAM_FRAME)
+            stream_frame_feed(&m_uart_dec, p_evt->params.rx.p_data, p_evt->params.rx.len,
+                              uart_stream_handler, NULL);
+#else
+            uart_command_put(p_evt->params.rx.p_data, p_evt->params.rx.len);
+#endif
+            break;
+
+        default:
+            // A damaged or lost frame is not answered; the controller sends it again.
+            break;
+    }
+}
+#endif
+
+
 /**@brief   Function for handling app_uart events.
  *
  * @details This function will receive a single character from the app_uart module and append it to
@@ -494,29 +2669,37 @@ void bsp_event_handler(bsp_event_t event)
  *          'new line' i.e '\r\n' (hex 0x0D) or if the string has reached a length of
  *          @ref NUS_MAX_DATA_LENGTH.
  */
+CRIT_PROF_SITE_DEF(m_uart_evt_site, "uart_evt");
+
 /**@snippet [Handling the data received over UART] */
 void uart_event_handle(app_uart_evt_t * p_event)
 {
     static uint8_t data_array[BLE_NUS_MAX_DATA_LEN];
     static uint8_t index = 0;
-    uint32_t       err_code;
+    CRIT_PROF_BEGIN(start);
 
     switch (p_event->evt_type)
     {
         case APP_UART_DATA_READY:
+#if NRF_MODULE_ENABLED(STREAM_FRAME)
+            // Everything in the FIFO in one go; the decoder does not care about the cut.
+            while ((index < sizeof(data_array)) && (app_uart_get(&data_array[index]) == NRF_SUCCESS))
+            {
+                index++;
+            }
+            stream_frame_feed(&m_uart_dec, data_array, index, uart_stream_handler, NULL);
+            index = 0;
+#else
             UNUSED_VARIABLE(app_uart_get(&data_array[index]));
             index++;
 
             if ((data_array[index - 1] == '\n') || (index >= (BLE_NUS_MAX_DATA_LEN)))
             {
-							  pn532_appliction(data_array);
-                if (err_code != NRF_ERROR_INVALID_STATE)
-                {
-                    APP_ERROR_CHECK(err_code);
-                }
-
+                // Copied out, so data_array can take the next line.
+                uart_command_put(data_array, index);
                 index = 0;
             }
+#endif
             break;
 
         case APP_UART_COMMUNICATION_ERROR:
@@ -530,6 +2713,7 @@ void uart_event_handle(app_uart_evt_t * p_event)
         default:
             break;
     }
+    CRIT_PROF_END(m_uart_evt_site, start);
 }
 /**@snippet [Handling the data received over UART] */
 
@@ -540,6 +2724,25 @@ void uart_event_handle(app_uart_evt_t * p_event)
 static void uart_init(void)
 {
     uint32_t                     err_code;
+
+#if NRF_MODULE_ENABLED(STREAM_FRAME)
+    stream_frame_dec_init(&m_uart_dec, m_uart_dec_buf, sizeof(m_uart_dec_buf));
+#endif
+#if NRF_MODULE_ENABLED(UART_FRAME)
+    // 1 Mbaud outruns the nRF51 RX FIFO during SoftDevice events without RTS.
+    const app_uart_comm_params_t comm_params =
+    {
+        RX_PIN_NUMBER,
+        TX_PIN_NUMBER,
+        RTS_PIN_NUMBER,
+        CTS_PIN_NUMBER,
+        APP_UART_FLOW_CONTROL_ENABLED,
+        false,
+        UART_BAUDRATE_BAUDRATE_Baud1M
+    };
+
+    err_code = uart_frame_init(&comm_params, uart_frame_handler);
+#else
     const app_uart_comm_params_t comm_params =
     {
         RX_PIN_NUMBER,
@@ -557,11 +2760,42 @@ static void uart_init(void)
                        uart_event_handle,
                        APP_IRQ_PRIORITY_LOWEST,
                        err_code);
+#endif
     APP_ERROR_CHECK(err_code);
 }
 /**@snippet [UART Initialization] */
 
 
+#if NRF_MODULE_ENABLED(USB_SERVICE)
+#if NRF_MODULE_ENABLED(STREAM_FRAME)
+static stream_frame_dec_t m_usb_dec;
+static uint8_t            m_usb_dec_buf[STREAM_FRAME_BUF_SIZE(STREAM_FRAME_MAX_LEN)];
+#endif
+
+/**@brief Commands on the USB CDC ACM port, framed like the UART; raw, one per packet. */
+static void usb_rx_handler(uint8_t const * p_data, uint16_t len)
+{
+#if NRF_MODULE_ENABLED(STREAM_FRAME)
+    stream_frame_feed(&m_usb_dec, p_data, len, uart_stream_handler, NULL);
+#else
+    if (len <= BLE_NUS_MAX_DATA_LEN)
+    {
+        uart_command_put(p_data, len);
+    }
+#endif
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(PASSBACK)
+#ifndef PASSBACK_KEY
+#error "Define PASSBACK_KEY, the AES-128 key the anti-passback frames of the site are signed with, as {0x.., ...}"
+#endif
+
+static uint8_t const m_passback_key[16] = PASSBACK_KEY;
+#endif
+
+
 /**@brief Function for initializing the Advertising functionality.
  */
 static void advertising_init(void)
@@ -583,11 +2817,37 @@ static void advertising_init(void)
 
     memset(&options, 0, sizeof(options));
     options.ble_adv_fast_enabled  = true;
-    options.ble_adv_fast_interval = APP_ADV_INTERVAL;
+    options.ble_adv_fast_interval = DEV_CFG_GET(adv_interval, APP_ADV_INTERVAL);
     options.ble_adv_fast_timeout  = APP_ADV_TIMEOUT_IN_SECONDS;
+#if NRF_MODULE_ENABLED(ADV_SCHED)
+    adv_sched_config(&options);
+#endif
+#if NRF_MODULE_ENABLED(PEER_BOND)
+    peer_bond_adv_config(&options);
+#endif
 
     err_code = ble_advertising_init(&advdata, &scanrsp, &options, on_adv_evt, NULL);
     APP_ERROR_CHECK(err_code);
+#if NRF_MODULE_ENABLED(TAP_BEACON)
+    err_code = tap_beacon_init(&advdata, &scanrsp);
+    APP_ERROR_CHECK(err_code);
+#endif
+#if NRF_MODULE_ENABLED(READER_TLM)
+#if NRF_MODULE_ENABLED(TAP_BEACON)
+    err_code = reader_tlm_init(&advdata, &scanrsp, tap_beacon_refresh);
+#else
+    err_code = reader_tlm_init(&advdata, &scanrsp, NULL);
+#endif
+    APP_ERROR_CHECK(err_code);
+#endif
+#if NRF_MODULE_ENABLED(PASSBACK)
+#if NRF_MODULE_ENABLED(TAP_BEACON)
+    err_code = passback_init(m_passback_key, &advdata, &scanrsp, tap_beacon_refresh);
+#else
+    err_code = passback_init(m_passback_key, &advdata, &scanrsp, NULL);
+#endif
+    APP_ERROR_CHECK(err_code);
+#endif
 }
 
 
@@ -615,8 +2875,13 @@ static void buttons_leds_init(bool * p_erase_bonds)
  */
 static void power_manage(void)
 {
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+    // Puts the idle parts down first, as deep as the next timer allows.
+    pwr_idle_run();
+#else
     uint32_t err_code = sd_app_evt_wait();
     APP_ERROR_CHECK(err_code);
+#endif
 }
 
 
@@ -653,6 +2918,266 @@ static void timers_init(void)
 
 
 
+#if NRF_MODULE_ENABLED(BATT_MON) || NRF_MODULE_ENABLED(LOCK_STATE)
+static bool m_batt_low;
+static bool m_door_open;
+
+
+/**@brief Advertise in the slow stage while the battery is low or the door stands open. */
+static void adv_save_update(void)
+{
+#if NRF_MODULE_ENABLED(ADV_SCHED)
+    adv_sched_save(m_batt_low || m_door_open);
+#endif
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(BATT_MON)
+/**@brief Low battery: poll for cards and advertise less often, to last longer before cut-off. */
+static void batt_handler(bool low, uint16_t mv)
+{
+    UNUSED_PARAMETER(mv);
+
+#if NRF_MODULE_ENABLED(PN532_DUTY)
+    pn532_duty_save(low);
+#endif
+    m_batt_low = low;
+    adv_save_update();
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(LOCK_STATE)
+/**@brief Door open: nobody taps a card or looks for the lock from outside, so stop polling. */
+static void lock_state_handler(lock_state_t state)
+{
+    m_door_open = (state == LOCK_STATE_OPEN);
+#if NRF_MODULE_ENABLED(PN532_DUTY)
+    pn532_duty_pause(m_door_open);
+#endif
+    adv_save_update();
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(WDT_SUP)
+/**@brief Tell what the supervisor saw before the reset that started this boot, if anything. */
+static void crash_report(void)
+{
+    wdt_sup_crash_t crash;
+
+    if (!wdt_sup_crash_get(&crash))
+    {
+        return;
+    }
+    printf("reset %u by wdt_sup: part %u reason %u busy 0x%02x, stuck %u ms\r\n",
+           (unsigned)crash.resets, crash.part, crash.reason, crash.busy,
+           (unsigned)crash.age_ms[crash.part]);
+}
+#endif
+
+/* Peripheral bring-up, one function per stage. Without BOOT_SEQ main() calls them in this order
+   before advertising; with it they run as stages of boot_seq after advertising has started. */
+static ret_code_t boot_lock(void)
+{
+    qk_lock_init();
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t boot_pn532(void)
+{
+#if NRF_MODULE_ENABLED(FRAME_POOL)
+    APP_ERROR_CHECK(frame_pool_init());
+#endif
+    device_pn532_init();
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t boot_flash(void)
+{
+    device_mx25l16mb_init();
+#if NRF_MODULE_ENABLED(MX25_ASYNC)
+    APP_ERROR_CHECK(mx25_async_init());
+#endif
+#if NRF_MODULE_ENABLED(POST_MORTEM)
+    APP_ERROR_CHECK(post_mortem_init());
+    if (post_mortem_pending() > 0)
+    {
+        printf("%u fault snapshots for the next connection\r\n", post_mortem_pending());
+    }
+#endif
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t boot_crypto(void)
+{
+#if NRF_MODULE_ENABLED(NRF_CRYPTO_AES)
+    APP_ERROR_CHECK(nrf_crypto_aes_init());
+#endif
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t boot_acl(void)
+{
+    ret_code_t err_code = NRF_SUCCESS;
+
+#if NRF_MODULE_ENABLED(LOCK_ACL)
+    err_code = lock_acl_init();
+    if (err_code != NRF_SUCCESS)
+    {
+        printf("acl index failed\r\n");
+    }
+#endif
+#if NRF_MODULE_ENABLED(LOCK_ACL_DELTA)
+    lock_acl_delta_key_set(m_acl_site_key);
+#endif
+#if NRF_MODULE_ENABLED(LOCK_ACL_MPH)
+    if (lock_acl_mph_init() != NRF_SUCCESS)
+    {
+        printf("acl table init failed\r\n");
+    }
+#endif
+    return err_code;
+}
+
+
+static ret_code_t boot_journal(void)
+{
+    ret_code_t err_code = NRF_SUCCESS;
+
+#if NRF_MODULE_ENABLED(LOCK_JOURNAL)
+    err_code = lock_journal_init();
+    if (err_code != NRF_SUCCESS)
+    {
+        printf("journal init failed\r\n");
+    }
+#endif
+    return err_code;
+}
+
+
+static ret_code_t boot_services(void)
+{
+#if NRF_MODULE_ENABLED(USB_SERVICE)
+#if NRF_MODULE_ENABLED(STREAM_FRAME)
+    stream_frame_dec_init(&m_usb_dec, m_usb_dec_buf, sizeof(m_usb_dec_buf));
+#endif
+    APP_ERROR_CHECK(usb_service_init(usb_rx_handler));
+#endif
+#if NRF_MODULE_ENABLED(HOST_SPIS)
+    // Same raw commands as the UART, at the SPI clock of the host.
+    APP_ERROR_CHECK(host_spis_init(command_run));
+#endif
+#if NRF_MODULE_ENABLED(SD_LOG)
+    APP_ERROR_CHECK(sd_log_init());
+#endif
+#if NRF_MODULE_ENABLED(GW_PUSH)
+    APP_ERROR_CHECK(gw_push_init());
+#endif
+#if NRF_MODULE_ENABLED(BATT_MON)
+    APP_ERROR_CHECK(batt_mon_init(batt_handler));
+#endif
+#if NRF_MODULE_ENABLED(LOCK_STATE)
+    APP_ERROR_CHECK(lock_state_init(lock_state_handler));
+#endif
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t boot_prox(void)
+{
+#if NRF_MODULE_ENABLED(PROX_WAKE)
+    APP_ERROR_CHECK(prox_wake_init());
+#endif
+#if NRF_MODULE_ENABLED(IR_PROX)
+    APP_ERROR_CHECK(ir_prox_init());
+#endif
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t boot_scan(void)
+{
+#if NRF_MODULE_ENABLED(PN532_SCAN) || NRF_MODULE_ENABLED(PN532_DUTY)
+    uint32_t local_count = 0;
+
+#if NRF_MODULE_ENABLED(LOCK_ACL)
+    local_count += lock_acl_count();
+#endif
+#if NRF_MODULE_ENABLED(LOCK_ACL_MPH)
+    local_count += lock_acl_mph_count();
+#endif
+    // With a local list the lock works without a phone, so poll for cards from the start.
+    if (local_count > 0)
+    {
+        scan_card_start();
+    }
+#endif
+    return NRF_SUCCESS;
+}
+
+
+#if NRF_MODULE_ENABLED(BOOT_SEQ)
+enum
+{
+    BOOT_LOCK,
+    BOOT_PN532,
+    BOOT_FLASH,
+    BOOT_CRYPTO,
+    BOOT_ACL,
+    BOOT_JOURNAL,
+    BOOT_SERVICES,
+    BOOT_PN532_PROBE,
+    BOOT_PROX,
+    BOOT_SCAN,
+    BOOT_STAGE_COUNT
+};
+
+#define BOOT_AFTER(stage)   (1UL << (stage))
+
+
+static ret_code_t boot_pn532_probe(void)
+{
+    return device_pn532_probe() ? NRF_SUCCESS : NRF_ERROR_NOT_FOUND;
+}
+
+
+/* The PN532 needs its boot time before the probe; the flash, the stores and the services come
+   up meanwhile. No reader: no proximity wake-up and no card scan, the phone still opens. */
+static boot_seq_stage_t const m_boot_stages[BOOT_STAGE_COUNT] =
+{
+    [BOOT_LOCK]        = {boot_lock,        0,                                                   0,                      "lock"},
+    [BOOT_PN532]       = {boot_pn532,       0,                                                   0,                      "pn532"},
+    [BOOT_FLASH]       = {boot_flash,       0,                                                   0,                      "flash"},
+    [BOOT_CRYPTO]      = {boot_crypto,      0,                                                   0,                      "crypto"},
+    [BOOT_ACL]         = {boot_acl,         BOOT_AFTER(BOOT_FLASH) | BOOT_AFTER(BOOT_CRYPTO),    0,                      "acl"},
+    [BOOT_JOURNAL]     = {boot_journal,     BOOT_AFTER(BOOT_FLASH),                              0,                      "journal"},
+    [BOOT_SERVICES]    = {boot_services,    BOOT_AFTER(BOOT_LOCK) | BOOT_AFTER(BOOT_PN532),      0,                      "services"},
+    [BOOT_PN532_PROBE] = {boot_pn532_probe, BOOT_AFTER(BOOT_PN532),                              BOOT_SEQ_PN532_BOOT_MS, "pn532 probe"},
+    [BOOT_PROX]        = {boot_prox,        BOOT_AFTER(BOOT_PN532_PROBE),                        0,                      "prox"},
+    [BOOT_SCAN]        = {boot_scan,        BOOT_AFTER(BOOT_PN532_PROBE) | BOOT_AFTER(BOOT_ACL), 0,                      "scan"},
+};
+
+
+static void boot_handler(uint32_t failed, uint32_t elapsed_ms)
+{
+    for (uint8_t i = 0; i < BOOT_STAGE_COUNT; i++)
+    {
+        if (failed & BOOT_AFTER(i))
+        {
+            printf("boot: %s failed or skipped\r\n", m_boot_stages[i].p_name);
+        }
+    }
+    printf("boot: up in %u ms\r\n", (unsigned)elapsed_ms);
+}
+#endif
+
+
 /**@brief Application main function.
  */
 int main(void)
@@ -663,36 +3188,133 @@ int main(void)
     uint8_t a1[12];
 
     // Initialize.
+#if NRF_MODULE_ENABLED(RAM_POWER)
+    // While POWER is ours: the SoftDevice takes it.
+    APP_ERROR_CHECK(ram_power_init());
+#endif
+#if NRF_MODULE_ENABLED(RAM_BUDGET)
+    // Before the stack has been deep.
+    ram_budget_paint();
+#endif
+#if NRF_MODULE_ENABLED(KEEP_RAM)
+    // Before anything counts or records into the region.
+    keep_ram_init();
+#endif
+#if NRF_MODULE_ENABLED(APP_RTOS)
+    APP_ERROR_CHECK(app_rtos_init());
+#endif
+    APP_SCHED_INIT(SCHED_MAX_EVENT_DATA_SIZE, SCHED_QUEUE_SIZE);
 		timers_init();
+#if NRF_MODULE_ENABLED(LOG_NUS)
+    log_nus_init();
+#endif
+#if NRF_MODULE_ENABLED(WDT_SUP)
+    APP_ERROR_CHECK(wdt_sup_init());
+#endif
+#if NRF_MODULE_ENABLED(BENCH)
+    APP_ERROR_CHECK(bench_init());
+#endif
+#if NRF_MODULE_ENABLED(CRIT_PROF)
+    APP_ERROR_CHECK(crit_prof_init());
+#endif
+    // Before the UART and NUS can bring a command.
+    APP_ERROR_CHECK(cmd_reg_init());
 	  uart_init();
+#if NRF_MODULE_ENABLED(WDT_SUP)
+    crash_report();
+#endif
 //  buttons_leds_init(&erase_bonds);
     ble_stack_init();   /*Эջʼ*/
+#if NRF_MODULE_ENABLED(HF_CLOCK)
+    // Before the PN532 wakes: its UART asks for the crystal through the SoftDevice.
+    APP_ERROR_CHECK(hf_clock_init());
+#endif
+#if NRF_MODULE_ENABLED(RAND_POOL)
+    APP_ERROR_CHECK(rand_pool_init());
+#endif
+#if NRF_MODULE_ENABLED(WALL_CLOCK)
+    APP_ERROR_CHECK(wall_clock_init(wall_clock_handler));
+#endif
+#if NRF_MODULE_ENABLED(ENERGY)
+    // Before the PN532, the flash and the radio notification of radio_gap come up.
+    APP_ERROR_CHECK(energy_init());
+#endif
+#if NRF_MODULE_ENABLED(PEER_BOND)
+    APP_ERROR_CHECK(peer_bond_init());
+#endif
+#if NRF_MODULE_ENABLED(DEV_CFG)
+    // Before the modules that read it; with fds up since peer_bond_init() it loads at once.
+    APP_ERROR_CHECK(dev_cfg_init(&m_cfg_defaults));
+#endif
+#if NRF_MODULE_ENABLED(KEEP_RAM)
+    APP_ERROR_CHECK(keep_ram_start());
+#endif
     gap_params_init();
+#if NRF_BLE_GATT_ENABLED
+    gatt_init();
+#endif
     services_init();
     advertising_init();
+#if NRF_MODULE_ENABLED(NFC_PAIR)
+    APP_ERROR_CHECK(nfc_pair_init());
+#endif
     conn_params_init();
+#if NRF_MODULE_ENABLED(CONN_POLICY)
+    conn_policy_init();
+#endif
+#if NRF_MODULE_ENABLED(RADIO_GAP)
+    APP_ERROR_CHECK(radio_gap_init());
+#endif
 	
-	  qk_lock_init();
-    device_pn532_init();  //pn532ʼ
-//    device_mx25l16mb_init(); 
+#if NRF_MODULE_ENABLED(BOOT_SEQ)
+    // Connectable first; the peripherals come up behind it from the main loop.
+    err_code = ble_advertising_start(BLE_ADV_MODE_FAST);
+    APP_ERROR_CHECK(err_code);
+    APP_ERROR_CHECK(boot_seq_start(m_boot_stages, BOOT_STAGE_COUNT, boot_handler));
+#else
+    UNUSED_RETURN_VALUE(boot_lock());
+    UNUSED_RETURN_VALUE(boot_pn532());
+    UNUSED_RETURN_VALUE(boot_flash());
+    UNUSED_RETURN_VALUE(boot_crypto());
+    UNUSED_RETURN_VALUE(boot_acl());
+    UNUSED_RETURN_VALUE(boot_journal());
+    UNUSED_RETURN_VALUE(boot_services());
+    UNUSED_RETURN_VALUE(boot_prox());
+    UNUSED_RETURN_VALUE(boot_scan());
 //	  read_mx25_test();
 //      test_uid();	
 		err_code = ble_advertising_start(BLE_ADV_MODE_FAST);
     APP_ERROR_CHECK(err_code);	
+#endif
+#if NRF_MODULE_ENABLED(BENCH)
+    bench_cases_add();
+    APP_ERROR_CHECK(bench_run(BENCH_START_MS));
+#endif
 
+#if NRF_MODULE_ENABLED(NRF_PWR_MGMT)
+    APP_ERROR_CHECK(nrf_pwr_mgmt_init(APP_TIMER_TICKS(1000, APP_TIMER_PRESCALER)));
+#endif
+#if NRF_MODULE_ENABLED(APP_RTOS)
+    app_rtos_start();
+#endif
 
     for (;;)
     {
-
+        app_sched_execute();
+#if NRF_MODULE_ENABLED(LOG_NUS)
+        log_nus_process();
+#endif
+#if NRF_MODULE_ENABLED(NUS_RX)
+        nus_rx_process();
+#endif
+#if NRF_MODULE_ENABLED(WDT_SUP)
+        wdt_sup_end(WDT_SUP_MAIN);
+#endif
         power_manage();
+#if NRF_MODULE_ENABLED(WDT_SUP)
+        wdt_sup_begin(WDT_SUP_MAIN);
+#endif
 
-				if(recv_data[0] != 0X00)
-				{	
-					 beep_test();
-				   pn532_appliction(recv_data);
-					 my_memset(recv_data,0,24);
-				}
-			
 //					{
 //						uint8_t a1[4]={0x01,0x00,0x00,0x00};   //pn532
 //						pn532_appliction(a1);
@@ -16,6 +16,43 @@
 #define BLE_ADVERTISING_ENABLED 1
 #endif
 
+// <e> BLE_DB_DISCOVERY_ENABLED - ble_db_discovery - Database discovery module
+//==========================================================
+#ifndef BLE_DB_DISCOVERY_ENABLED
+#define BLE_DB_DISCOVERY_ENABLED 0
+#endif
+#if  BLE_DB_DISCOVERY_ENABLED
+// <e> BLE_DB_DISCOVERY_CACHE_ENABLED - Cache the discovered services of each peer in FDS
+// <i> Connections started with ble_db_discovery_cached_start() skip discovery for a peer
+// <i> found in the cache. Takes one service registration, for the GATT Service.
+//==========================================================
+#ifndef BLE_DB_DISCOVERY_CACHE_ENABLED
+#define BLE_DB_DISCOVERY_CACHE_ENABLED 1
+#endif
+#if  BLE_DB_DISCOVERY_CACHE_ENABLED
+// <o> BLE_DB_DISCOVERY_CACHE_PEERS - Peers kept in the cache 
+// <i> The first stored is given up for a new one.
+#ifndef BLE_DB_DISCOVERY_CACHE_PEERS
+#define BLE_DB_DISCOVERY_CACHE_PEERS 4
+#endif
+
+// <o> BLE_DB_DISCOVERY_CACHE_MAX_SRV - Registered services a peer entry holds <1-5> 
+// <i> Each takes 100 bytes of RAM, and of flash per peer.
+#ifndef BLE_DB_DISCOVERY_CACHE_MAX_SRV
+#define BLE_DB_DISCOVERY_CACHE_MAX_SRV 2
+#endif
+
+// <o> BLE_DB_DISCOVERY_CACHE_FILE_ID - FDS file ID of the cache entries 
+#ifndef BLE_DB_DISCOVERY_CACHE_FILE_ID
+#define BLE_DB_DISCOVERY_CACHE_FILE_ID 0x4444
+#endif
+
+#endif //BLE_DB_DISCOVERY_CACHE_ENABLED
+// </e>
+
+#endif //BLE_DB_DISCOVERY_ENABLED
+// </e>
+
 // <q> BLE_DTM_ENABLED  - ble_dtm - Module for testing RF/PHY using DTM commands
  
 
@@ -30,19 +67,47 @@
 #define BLE_RACP_ENABLED 0
 #endif
 
+// <e> NRF_BLE_GATT_ENABLED - nrf_ble_gatt - GATT module
+//==========================================================
+#ifndef NRF_BLE_GATT_ENABLED
+#define NRF_BLE_GATT_ENABLED 1
+#endif
+#if  NRF_BLE_GATT_ENABLED
+// <o> NRF_BLE_GATT_MAX_MTU_SIZE - Largest ATT MTU the application negotiates <23-247>
+// <i> Also sizes the NUS buffers: BLE_NUS_MAX_DATA_LEN is 3 less. Above 23 only with
+// <i> S132/S332; S130 keeps the default. The RAM start must grow with it.
+
+#ifndef NRF_BLE_GATT_MAX_MTU_SIZE
+#define NRF_BLE_GATT_MAX_MTU_SIZE 23
+#endif
+
+#endif //NRF_BLE_GATT_ENABLED
+// </e>
+
 // <q> NRF_BLE_QWR_ENABLED  - nrf_ble_qwr - Queued writes support module (prepare/execute write)
  
 
 #ifndef NRF_BLE_QWR_ENABLED
-#define NRF_BLE_QWR_ENABLED 0
+#define NRF_BLE_QWR_ENABLED 1
 #endif
 
-// <q> PEER_MANAGER_ENABLED  - peer_manager - Peer Manager
- 
-
+// <e> PEER_MANAGER_ENABLED - peer_manager - Peer Manager
+//==========================================================
 #ifndef PEER_MANAGER_ENABLED
-#define PEER_MANAGER_ENABLED 0
+#define PEER_MANAGER_ENABLED 1
 #endif
+#if  PEER_MANAGER_ENABLED
+// <o> PM_ID_CACHE_PEERS - Bonded peers the Identity Manager keeps in RAM
+// <i> A connecting peer is matched in RAM, by address or by its IRK in batches of ECB blocks,
+// <i> instead of a walk of the bonding data in flash with one AES per peer. Power of two, 64 at
+// <i> most, about 44 bytes per peer; peers beyond it are still found in flash. 0 to disable.
+
+#ifndef PM_ID_CACHE_PEERS
+#define PM_ID_CACHE_PEERS 0
+#endif
+
+#endif //PEER_MANAGER_ENABLED
+// </e>
 
 // </h> 
 //==========================================================
@@ -183,12 +248,23 @@
 #define BLE_NUS_C_ENABLED 0
 #endif
 
-// <q> BLE_NUS_ENABLED  - ble_nus - Nordic UART Service
- 
-
+// <e> BLE_NUS_ENABLED - ble_nus - Nordic UART Service
+//==========================================================
 #ifndef BLE_NUS_ENABLED
 #define BLE_NUS_ENABLED 1
 #endif
+#if  BLE_NUS_ENABLED
+// <o> BLE_NUS_LINK_COUNT - Peripheral links served at once <1-8>
+// <i> Each link has its own notification state and TX queue (NUS_TX_QUEUE_SIZE notifications).
+// <i> S130 on the nRF51 accepts a single peripheral link; values above 1 need a SoftDevice
+// <i> with more peripheral links and more RAM for the stack.
+
+#ifndef BLE_NUS_LINK_COUNT
+#define BLE_NUS_LINK_COUNT 1
+#endif
+
+#endif //BLE_NUS_ENABLED
+// </e>
 
 // <q> BLE_RSCS_C_ENABLED  - ble_rscs_c - Running Speed and Cadence Client
  
@@ -220,7 +296,7 @@
 // <e> ADC_ENABLED - nrf_drv_adc - Driver for ADC peripheral (nRF51)
 //==========================================================
 #ifndef ADC_ENABLED
-#define ADC_ENABLED 0
+#define ADC_ENABLED 1
 #endif
 #if  ADC_ENABLED
 // <o> ADC_CONFIG_IRQ_PRIORITY  - Interrupt priority
@@ -1651,7 +1727,7 @@
  
 
 #ifndef RNG_CONFIG_ERROR_CORRECTION
-#define RNG_CONFIG_ERROR_CORRECTION 0
+#define RNG_CONFIG_ERROR_CORRECTION 1
 #endif
 
 // <o> RNG_CONFIG_POOL_SIZE - Pool size 
@@ -2829,7 +2905,7 @@
 // <e> WDT_ENABLED - nrf_drv_wdt - WDT peripheral driver
 //==========================================================
 #ifndef WDT_ENABLED
-#define WDT_ENABLED 0
+#define WDT_ENABLED 1
 #endif
 #if  WDT_ENABLED
 // <o> WDT_CONFIG_BEHAVIOUR  - WDT behavior in CPU SLEEP or HALT mode
@@ -2860,7 +2936,7 @@
 // <3=> 3 
 
 #ifndef WDT_CONFIG_IRQ_PRIORITY
-#define WDT_CONFIG_IRQ_PRIORITY 3
+#define WDT_CONFIG_IRQ_PRIORITY 1
 #endif
 
 // <e> WDT_CONFIG_LOG_ENABLED - Enables logging in the module.
@@ -2949,7 +3025,7 @@
 // <e> APP_SCHEDULER_ENABLED - app_scheduler - Events scheduler
 //==========================================================
 #ifndef APP_SCHEDULER_ENABLED
-#define APP_SCHEDULER_ENABLED 0
+#define APP_SCHEDULER_ENABLED 1
 #endif
 #if  APP_SCHEDULER_ENABLED
 // <q> APP_SCHEDULER_WITH_PAUSE  - Enabling pause feature
@@ -2966,9 +3042,71 @@
 #define APP_SCHEDULER_WITH_PROFILER 0
 #endif
 
+// <o> APP_SCHEDULER_HIGH_QUEUE_SIZE - Entries of the high priority queue, 0 to disable <0-255>
+// <i> Events without data that app_sched_execute() runs ahead of the normal queue.
+
+#ifndef APP_SCHEDULER_HIGH_QUEUE_SIZE
+#define APP_SCHEDULER_HIGH_QUEUE_SIZE 4
+#endif
+
+// <q> APP_SCHEDULER_WITH_NOTIFY  - Call app_sched_notify() for each event put
+ 
+// <i> For an RTOS: the application provides app_sched_notify() to wake the task that runs app_sched_execute().
+
+#ifndef APP_SCHEDULER_WITH_NOTIFY
+#define APP_SCHEDULER_WITH_NOTIFY 0
+#endif
+
 #endif //APP_SCHEDULER_ENABLED
 // </e>
 
+// <e> APP_SDCARD_ENABLED - app_sdcard - SD/MMC card support using SPI
+//==========================================================
+#ifndef APP_SDCARD_ENABLED
+#define APP_SDCARD_ENABLED 0
+#endif
+#if  APP_SDCARD_ENABLED
+// <o> APP_SDCARD_SPI_INSTANCE  - SPI instance used
+ 
+// <0=> 0 
+// <1=> 1 
+// <2=> 2 
+
+#ifndef APP_SDCARD_SPI_INSTANCE
+#define APP_SDCARD_SPI_INSTANCE 1
+#endif
+
+// <o> APP_SDCARD_FREQ_INIT  - SPI frequency
+ 
+// <33554432=> 125 kHz 
+// <67108864=> 250 kHz 
+// <134217728=> 500 kHz 
+// <268435456=> 1 MHz 
+// <536870912=> 2 MHz 
+// <1073741824=> 4 MHz 
+// <2147483648=> 8 MHz 
+
+#ifndef APP_SDCARD_FREQ_INIT
+#define APP_SDCARD_FREQ_INIT 67108864
+#endif
+
+// <o> APP_SDCARD_FREQ_DATA  - SPI frequency
+ 
+// <33554432=> 125 kHz 
+// <67108864=> 250 kHz 
+// <134217728=> 500 kHz 
+// <268435456=> 1 MHz 
+// <536870912=> 2 MHz 
+// <1073741824=> 4 MHz 
+// <2147483648=> 8 MHz 
+
+#ifndef APP_SDCARD_FREQ_DATA
+#define APP_SDCARD_FREQ_DATA 1073741824
+#endif
+
+#endif //APP_SDCARD_ENABLED
+// </e>
+
 // <e> APP_TIMER_ENABLED - app_timer - Application timer functionality
 //==========================================================
 #ifndef APP_TIMER_ENABLED
@@ -2979,7 +3117,7 @@
  
 
 #ifndef APP_TIMER_WITH_PROFILER
-#define APP_TIMER_WITH_PROFILER 0
+#define APP_TIMER_WITH_PROFILER 1
 #endif
 
 // <q> APP_TIMER_KEEPS_RTC_ACTIVE  - Enable RTC always on
@@ -2992,6 +3130,21 @@
 #define APP_TIMER_KEEPS_RTC_ACTIVE 0
 #endif
 
+// <o> APP_TIMER_HEAP_SIZE - Timers kept in a binary heap <0-255>
+// <i> 0 keeps the running timers in a sorted list, where each start walks the list.
+// <i> Otherwise starts and expiries cost O(log n), and at most this many timers
+// <i> can be created; app_timer_create returns NRF_ERROR_NO_MEM beyond that.
+
+#ifndef APP_TIMER_HEAP_SIZE
+#define APP_TIMER_HEAP_SIZE 20
+#endif
+
+// <o> APP_TIMER_CONFIG_PRESCALER - Value of the RTC1 PRESCALER register, as passed to APP_TIMER_INIT 
+// <i> main.c and every module that turns milliseconds into app_timer ticks use this one value.
+#ifndef APP_TIMER_CONFIG_PRESCALER
+#define APP_TIMER_CONFIG_PRESCALER 0
+#endif
+
 #endif //APP_TIMER_ENABLED
 // </e>
 
@@ -3061,20 +3214,44 @@
 #define BUTTON_ENABLED 1
 #endif
 
-// <q> CRC16_ENABLED  - crc16 - CRC16 calculation routines
+// <e> CRC16_ENABLED - crc16 - CRC16 calculation routines
+//==========================================================
+#ifndef CRC16_ENABLED
+#define CRC16_ENABLED 1
+#endif
+#if  CRC16_ENABLED
+// <q> CRC16_CONFIG_TABLE  - Use a 512-byte lookup table instead of the shift and XOR formulation
  
 
-#ifndef CRC16_ENABLED
-#define CRC16_ENABLED 0
+#ifndef CRC16_CONFIG_TABLE
+#define CRC16_CONFIG_TABLE 1
 #endif
 
-// <q> CRC32_ENABLED  - crc32 - CRC32 calculation routines
- 
+#endif //CRC16_ENABLED
+// </e>
 
+// <e> CRC32_ENABLED - crc32 - CRC32 calculation routines
+//==========================================================
 #ifndef CRC32_ENABLED
-#define CRC32_ENABLED 0
+#define CRC32_ENABLED 1
+#endif
+#if  CRC32_ENABLED
+// <o> CRC32_CONFIG_METHOD  - Calculation method
+ 
+// <i> Speed against flash: a byte table lookup replaces the 8 shifts per byte of the bitwise loop,
+// <i> slice-by-4 about twice as fast again and meant for the nRF52.
+// <0=> Bitwise, no table 
+// <1=> Nibble table (64 bytes) 
+// <2=> Byte table (1 KB) 
+// <3=> Slice-by-4 (4 KB) 
+
+#ifndef CRC32_CONFIG_METHOD
+#define CRC32_CONFIG_METHOD 2
 #endif
 
+#endif //CRC32_ENABLED
+// </e>
+
 // <q> ECC_ENABLED  - ecc - Elliptic Curve Cryptography Library
  
 
@@ -3085,7 +3262,7 @@
 // <e> FDS_ENABLED - fds - Flash data storage module
 //==========================================================
 #ifndef FDS_ENABLED
-#define FDS_ENABLED 0
+#define FDS_ENABLED 1
 #endif
 #if  FDS_ENABLED
 // <o> FDS_OP_QUEUE_SIZE - Size of the internal queue. 
@@ -3127,6 +3304,52 @@
 #define FDS_VIRTUAL_PAGE_SIZE 256
 #endif
 
+// <o> FDS_INDEX_SIZE - Number of slots of the RAM index of record keys. 
+// <i> With the index, fds_record_find and fds_record_find_by_key look up a record
+// <i> in RAM instead of reading every record header in flash. Each slot takes 4 bytes.
+// <i> The index holds up to 3/4 of its slots; while there are more records, or while
+// <i> garbage collection runs, records are searched for in flash. Set to 0 to disable.
+// <0=> 0 
+// <16=> 16 
+// <32=> 32 
+// <64=> 64 
+// <128=> 128 
+// <256=> 256 
+
+#ifndef FDS_INDEX_SIZE
+#define FDS_INDEX_SIZE 64
+#endif
+
+// <o> FDS_GC_STEP_RECORDS - Number of records garbage collection copies at a time. 
+// <i> After copying this many records, garbage collection lets the operations
+// <i> queued meanwhile run before it carries on. Set to 0 to run it in one go.
+
+#ifndef FDS_GC_STEP_RECORDS
+#define FDS_GC_STEP_RECORDS 4
+#endif
+
+// <o> FDS_GC_AUTO_WORDS - Freeable words at which garbage collection starts by itself. 
+// <i> Checked after each update and delete. Set to 0 to run garbage collection
+// <i> only through fds_gc.
+
+#ifndef FDS_GC_AUTO_WORDS
+#define FDS_GC_AUTO_WORDS 128
+#endif
+
+// <q> FDS_INDEX_SNAPSHOT  - Keep a snapshot of the pages and the record index in flash.
+// <i> fds_init then only scans the pages written to or deleted from since the snapshot,
+// <i> and takes the index of the others from flash. Saved after garbage collection, after
+// <i> a boot which had to scan pages, and by fds_index_save. Takes one more virtual page.
+
+#ifndef FDS_INDEX_SNAPSHOT
+#define FDS_INDEX_SNAPSHOT 0
+#endif
+
+// <o> FDS_INDEX_SNAPSHOT_FS_PRIORITY - fstorage priority of the snapshot page, unique among fstorage users.  
+#ifndef FDS_INDEX_SNAPSHOT_FS_PRIORITY
+#define FDS_INDEX_SNAPSHOT_FS_PRIORITY 0xFD
+#endif
+
 #endif //FDS_ENABLED
 // </e>
 
@@ -3164,6 +3387,24 @@
 #define FS_MAX_WRITE_SIZE_WORDS 256
 #endif
 
+// <o> FS_COALESCE_WORDS - Size of the buffer which merges stores to adjacent addresses, in words. 
+// <i> Stores queued back to back are written with one call to @ref sd_flash_write,
+// <i> up to @ref FS_MAX_WRITE_SIZE_WORDS. If their data is not back to back in memory
+// <i> as well, it is gathered in a buffer of this size. Set to 0 to save the RAM.
+
+#ifndef FS_COALESCE_WORDS
+#define FS_COALESCE_WORDS 16
+#endif
+
+// <q> FS_ERASE_SKIP_BLANK  - Do not erase pages which already read as erased.
+ 
+
+// <i> Erases queued after another operation complete right away if the page is blank.
+
+#ifndef FS_ERASE_SKIP_BLANK
+#define FS_ERASE_SKIP_BLANK 1
+#endif
+
 #endif //FSTORAGE_ENABLED
 // </e>
 
@@ -3171,7 +3412,7 @@
  
 
 #ifndef HARDFAULT_HANDLER_ENABLED
-#define HARDFAULT_HANDLER_ENABLED 0
+#define HARDFAULT_HANDLER_ENABLED 1
 #endif
 
 // <e> HCI_MEM_POOL_ENABLED - hci_mem_pool - memory pool implementation used by HCI
@@ -3349,9 +3590,79 @@
 #define MEM_MANAGER_DISABLE_API_PARAM_CHECK 0
 #endif
 
+// <q> MEM_MANAGER_PROFILING_ENABLED  - Count requests and blocks in use per block category.
+// <i> Read with nrf_mem_profile_get() to size the block categories from measured use.
+
+#ifndef MEM_MANAGER_PROFILING_ENABLED
+#define MEM_MANAGER_PROFILING_ENABLED 0
+#endif
+
 #endif //MEM_MANAGER_ENABLED
 // </e>
 
+// <e> NRF_BALLOC_ENABLED - nrf_balloc - Block allocator module
+//==========================================================
+#ifndef NRF_BALLOC_ENABLED
+#define NRF_BALLOC_ENABLED 1
+#endif
+#if  NRF_BALLOC_ENABLED
+// <q> NRF_BALLOC_CONFIG_LOG_ENABLED  - Enables logging in the module.
+ 
+
+#ifndef NRF_BALLOC_CONFIG_LOG_ENABLED
+#define NRF_BALLOC_CONFIG_LOG_ENABLED 0
+#endif
+
+// <e> NRF_BALLOC_CONFIG_DEBUG_ENABLED - Enables debug mode in the module.
+//==========================================================
+#ifndef NRF_BALLOC_CONFIG_DEBUG_ENABLED
+#define NRF_BALLOC_CONFIG_DEBUG_ENABLED 0
+#endif
+#if  NRF_BALLOC_CONFIG_DEBUG_ENABLED
+// <o> NRF_BALLOC_CONFIG_HEAD_GUARD_WORDS - Number of words used as head guard.  <0-255> 
+#ifndef NRF_BALLOC_CONFIG_HEAD_GUARD_WORDS
+#define NRF_BALLOC_CONFIG_HEAD_GUARD_WORDS 1
+#endif
+
+// <o> NRF_BALLOC_CONFIG_TAIL_WORDS - Number of words used as tail guard.  <0-255> 
+#ifndef NRF_BALLOC_CONFIG_TAIL_WORDS
+#define NRF_BALLOC_CONFIG_TAIL_WORDS 1
+#endif
+
+// <q> NRF_BALLOC_CONFIG_BASIC_CHECKS_ENABLED  - Enables basic checks in this module.
+ 
+
+#ifndef NRF_BALLOC_CONFIG_BASIC_CHECKS_ENABLED
+#define NRF_BALLOC_CONFIG_BASIC_CHECKS_ENABLED 0
+#endif
+
+// <q> NRF_BALLOC_CONFIG_DOUBLE_FREE_CHECK_ENABLED  - Enables double memory free check in this module.
+ 
+
+#ifndef NRF_BALLOC_CONFIG_DOUBLE_FREE_CHECK_ENABLED
+#define NRF_BALLOC_CONFIG_DOUBLE_FREE_CHECK_ENABLED 0
+#endif
+
+// <q> NRF_BALLOC_CONFIG_DATA_TRASHING_CHECK_ENABLED  - Enables free memory corruption check in this module.
+ 
+
+#ifndef NRF_BALLOC_CONFIG_DATA_TRASHING_CHECK_ENABLED
+#define NRF_BALLOC_CONFIG_DATA_TRASHING_CHECK_ENABLED 0
+#endif
+
+#endif //NRF_BALLOC_CONFIG_DEBUG_ENABLED
+// </e>
+
+#endif //NRF_BALLOC_ENABLED
+// </e>
+
+// <q> NRF_CRYPTO_AES_ENABLED  - nrf_crypto_aes - AES-128 CTR, CMAC and CCM on the ECB peripheral
+ 
+
+#ifndef NRF_CRYPTO_AES_ENABLED
+#define NRF_CRYPTO_AES_ENABLED 0
+#endif
+
 // <e> NRF_CSENSE_ENABLED - nrf_csense - nrf_csense module
 //==========================================================
 #ifndef NRF_CSENSE_ENABLED
@@ -3396,7 +3707,7 @@
 // <e> NRF_DRV_CSENSE_ENABLED - nrf_drv_csense - Capacitive sensor module
 //==========================================================
 #ifndef NRF_DRV_CSENSE_ENABLED
-#define NRF_DRV_CSENSE_ENABLED 0
+#define NRF_DRV_CSENSE_ENABLED 1
 #endif
 #if  NRF_DRV_CSENSE_ENABLED
 // <o> TIMER0_FOR_CSENSE - First TIMER instance used by the driver (except nRF51) 
@@ -3419,13 +3730,147 @@
 #endif //NRF_DRV_CSENSE_ENABLED
 // </e>
 
-// <q> NRF_QUEUE_ENABLED  - nrf_queue - Queue module
+// <e> NRF_PWR_MGMT_ENABLED - nrf_pwr_mgmt - Power management module
+//==========================================================
+#ifndef NRF_PWR_MGMT_ENABLED
+#define NRF_PWR_MGMT_ENABLED 1
+#endif
+#if  NRF_PWR_MGMT_ENABLED
+// <e> NRF_PWR_MGMT_CONFIG_DEBUG_PIN_ENABLED - Enables pin debug in the module.
+// <i> Selected pin will be set when CPU is in sleep mode.
+//==========================================================
+#ifndef NRF_PWR_MGMT_CONFIG_DEBUG_PIN_ENABLED
+#define NRF_PWR_MGMT_CONFIG_DEBUG_PIN_ENABLED 0
+#endif
+#if  NRF_PWR_MGMT_CONFIG_DEBUG_PIN_ENABLED
+// <o> NRF_PWR_MGMT_SLEEP_DEBUG_PIN - Pin number  <0-31> 
+#ifndef NRF_PWR_MGMT_SLEEP_DEBUG_PIN
+#define NRF_PWR_MGMT_SLEEP_DEBUG_PIN 31
+#endif
+
+#endif //NRF_PWR_MGMT_CONFIG_DEBUG_PIN_ENABLED
+// </e>
+
+// <q> NRF_PWR_MGMT_CONFIG_CPU_USAGE_MONITOR_ENABLED  - Enables CPU usage monitor.
+ 
+// <i> Module will trace percentage of CPU usage in one second intervals.
+
+#ifndef NRF_PWR_MGMT_CONFIG_CPU_USAGE_MONITOR_ENABLED
+#define NRF_PWR_MGMT_CONFIG_CPU_USAGE_MONITOR_ENABLED 0
+#endif
+
+// <e> NRF_PWR_MGMT_CONFIG_STANDBY_TIMEOUT_ENABLED - Enable standby timeout.
+//==========================================================
+#ifndef NRF_PWR_MGMT_CONFIG_STANDBY_TIMEOUT_ENABLED
+#define NRF_PWR_MGMT_CONFIG_STANDBY_TIMEOUT_ENABLED 0
+#endif
+#if  NRF_PWR_MGMT_CONFIG_STANDBY_TIMEOUT_ENABLED
+// <o> NRF_PWR_MGMT_CONFIG_STANDBY_TIMEOUT_S - Standby timeout (in seconds). 
+// <i> Shutdown procedure will begin no earlier than after this number of seconds.
+
+#ifndef NRF_PWR_MGMT_CONFIG_STANDBY_TIMEOUT_S
+#define NRF_PWR_MGMT_CONFIG_STANDBY_TIMEOUT_S 3
+#endif
+
+#endif //NRF_PWR_MGMT_CONFIG_STANDBY_TIMEOUT_ENABLED
+// </e>
+
+// <q> NRF_PWR_MGMT_CONFIG_FPU_SUPPORT_ENABLED  - Enables FPU event cleaning.
+ 
+
+#ifndef NRF_PWR_MGMT_CONFIG_FPU_SUPPORT_ENABLED
+#define NRF_PWR_MGMT_CONFIG_FPU_SUPPORT_ENABLED 0
+#endif
+
+// <q> NRF_PWR_MGMT_CONFIG_AUTO_SHUTDOWN_RETRY  - Blocked shutdown procedure will be retried every second.
+ 
+
+#ifndef NRF_PWR_MGMT_CONFIG_AUTO_SHUTDOWN_RETRY
+#define NRF_PWR_MGMT_CONFIG_AUTO_SHUTDOWN_RETRY 0
+#endif
+
+// <q> NRF_PWR_MGMT_CONFIG_USE_SCHEDULER  - Module will use @ref app_scheduler.
+ 
+
+#ifndef NRF_PWR_MGMT_CONFIG_USE_SCHEDULER
+#define NRF_PWR_MGMT_CONFIG_USE_SCHEDULER 0
+#endif
+
+// <e> NRF_PWR_MGMT_CONFIG_LOG_ENABLED - Enables logging in the module.
+//==========================================================
+#ifndef NRF_PWR_MGMT_CONFIG_LOG_ENABLED
+#define NRF_PWR_MGMT_CONFIG_LOG_ENABLED 0
+#endif
+#if  NRF_PWR_MGMT_CONFIG_LOG_ENABLED
+// <o> NRF_PWR_MGMT_CONFIG_LOG_LEVEL  - Default Severity level
+ 
+// <0=> Off 
+// <1=> Error 
+// <2=> Warning 
+// <3=> Info 
+// <4=> Debug 
+
+#ifndef NRF_PWR_MGMT_CONFIG_LOG_LEVEL
+#define NRF_PWR_MGMT_CONFIG_LOG_LEVEL 3
+#endif
+
+// <o> NRF_PWR_MGMT_CONFIG_INFO_COLOR  - ANSI escape code prefix.
+ 
+// <0=> Default 
+// <1=> Black 
+// <2=> Red 
+// <3=> Green 
+// <4=> Yellow 
+// <5=> Blue 
+// <6=> Magenta 
+// <7=> Cyan 
+// <8=> White 
+
+#ifndef NRF_PWR_MGMT_CONFIG_INFO_COLOR
+#define NRF_PWR_MGMT_CONFIG_INFO_COLOR 0
+#endif
+
+// <o> NRF_PWR_MGMT_CONFIG_DEBUG_COLOR  - ANSI escape code prefix.
  
+// <0=> Default 
+// <1=> Black 
+// <2=> Red 
+// <3=> Green 
+// <4=> Yellow 
+// <5=> Blue 
+// <6=> Magenta 
+// <7=> Cyan 
+// <8=> White 
+
+#ifndef NRF_PWR_MGMT_CONFIG_DEBUG_COLOR
+#define NRF_PWR_MGMT_CONFIG_DEBUG_COLOR 0
+#endif
+
+#endif //NRF_PWR_MGMT_CONFIG_LOG_ENABLED
+// </e>
+
+#endif //NRF_PWR_MGMT_ENABLED
+// </e>
 
+// <e> NRF_QUEUE_ENABLED - nrf_queue - Queue module
+//==========================================================
 #ifndef NRF_QUEUE_ENABLED
-#define NRF_QUEUE_ENABLED 0
+#define NRF_QUEUE_ENABLED 1
+#endif
+#if  NRF_QUEUE_ENABLED
+// <q> NRF_QUEUE_CONFIG_SPSC  - Lock-free queues, no critical region per call
+// <i> Only if every queue has one pushing and one popping context, and none uses
+// <i> NRF_QUEUE_MODE_OVERFLOW or is reset while in use. Off, as it changes every queue of
+// <i> the build and none here contends for the regions it removes: pn532_async pushes and
+// <i> pops only from app_scheduler handlers, and lock_gpio locks its own feedback queue.
+
+#ifndef NRF_QUEUE_CONFIG_SPSC
+#define NRF_QUEUE_CONFIG_SPSC 0
 #endif
 
+#endif //NRF_QUEUE_ENABLED
+// </e>
+
 // <q> RETARGET_ENABLED  - retarget - Retargeting stdio functions
  
 
@@ -3608,6 +4053,14 @@
 #define NRF_LOG_TIMESTAMP_DIGITS 8
 #endif
 
+// <q> NRF_LOG_BACKEND_SERIAL_BINARY  - Send binary frames instead of text
+// <i> Only the format string address and the arguments go out, nrf_log_decode.py
+// <i> prints them on the host from the ELF file.
+
+#ifndef NRF_LOG_BACKEND_SERIAL_BINARY
+#define NRF_LOG_BACKEND_SERIAL_BINARY 0
+#endif
+
 // <e> NRF_LOG_BACKEND_SERIAL_USES_UART - If enabled data is printed over UART
 //==========================================================
 #ifndef NRF_LOG_BACKEND_SERIAL_USES_UART
@@ -3701,35 +4154,2977 @@
 // </h> 
 //==========================================================
 
-// <h> nRF_Segger_RTT 
+// <h> nRF_NFC 
 
 //==========================================================
-// <h> segger_rtt - SEGGER RTT
-
+// <e> NFC_NDEF_MSG_ENABLED - nfc_ndef_msg - NFC NDEF Message generator module
 //==========================================================
-// <o> SEGGER_RTT_CONFIG_BUFFER_SIZE_UP - Size of upstream buffer. 
-#ifndef SEGGER_RTT_CONFIG_BUFFER_SIZE_UP
-#define SEGGER_RTT_CONFIG_BUFFER_SIZE_UP 64
+#ifndef NFC_NDEF_MSG_ENABLED
+#define NFC_NDEF_MSG_ENABLED 1
 #endif
+#if  NFC_NDEF_MSG_ENABLED
+// <o> NFC_NDEF_MSG_TAG_TYPE  - NFC Tag Type
+ 
+// <2=> Type 2 Tag 
+// <4=> Type 4 Tag 
 
-// <o> SEGGER_RTT_CONFIG_MAX_NUM_UP_BUFFERS - Size of upstream buffer. 
-#ifndef SEGGER_RTT_CONFIG_MAX_NUM_UP_BUFFERS
-#define SEGGER_RTT_CONFIG_MAX_NUM_UP_BUFFERS 2
+#ifndef NFC_NDEF_MSG_TAG_TYPE
+#define NFC_NDEF_MSG_TAG_TYPE 2
 #endif
 
-// <o> SEGGER_RTT_CONFIG_BUFFER_SIZE_DOWN - Size of upstream buffer. 
-#ifndef SEGGER_RTT_CONFIG_BUFFER_SIZE_DOWN
-#define SEGGER_RTT_CONFIG_BUFFER_SIZE_DOWN 16
+#endif //NFC_NDEF_MSG_ENABLED
+// </e>
+
+// <e> NFC_NDEF_MSG_PARSER_ENABLED - nfc_ndef_msg_parser - NFC NDEF message parser
+//==========================================================
+#ifndef NFC_NDEF_MSG_PARSER_ENABLED
+#define NFC_NDEF_MSG_PARSER_ENABLED 1
+#endif
+#if  NFC_NDEF_MSG_PARSER_ENABLED
+// <e> NFC_NDEF_MSG_PARSER_LOG_ENABLED - Enables logging in the module.
+//==========================================================
+#ifndef NFC_NDEF_MSG_PARSER_LOG_ENABLED
+#define NFC_NDEF_MSG_PARSER_LOG_ENABLED 0
 #endif
+#if  NFC_NDEF_MSG_PARSER_LOG_ENABLED
+// <o> NFC_NDEF_MSG_PARSER_LOG_LEVEL  - Default Severity level
+ 
+// <0=> Off 
+// <1=> Error 
+// <2=> Warning 
+// <3=> Info 
+// <4=> Debug 
 
-// <o> SEGGER_RTT_CONFIG_MAX_NUM_DOWN_BUFFERS - Size of upstream buffer. 
-#ifndef SEGGER_RTT_CONFIG_MAX_NUM_DOWN_BUFFERS
-#define SEGGER_RTT_CONFIG_MAX_NUM_DOWN_BUFFERS 2
+#ifndef NFC_NDEF_MSG_PARSER_LOG_LEVEL
+#define NFC_NDEF_MSG_PARSER_LOG_LEVEL 3
 #endif
 
+// <o> NFC_NDEF_MSG_PARSER_INFO_COLOR  - ANSI escape code prefix.
+ 
+// <0=> Default 
+// <1=> Black 
+// <2=> Red 
+// <3=> Green 
+// <4=> Yellow 
+// <5=> Blue 
+// <6=> Magenta 
+// <7=> Cyan 
+// <8=> White 
+
+#ifndef NFC_NDEF_MSG_PARSER_INFO_COLOR
+#define NFC_NDEF_MSG_PARSER_INFO_COLOR 0
+#endif
+
+#endif //NFC_NDEF_MSG_PARSER_LOG_ENABLED
+// </e>
+
+#endif //NFC_NDEF_MSG_PARSER_ENABLED
+// </e>
+
+// <e> NFC_NDEF_RECORD_PARSER_ENABLED - nfc_ndef_record_parser - Parser for NFC NDEF Records
+//==========================================================
+#ifndef NFC_NDEF_RECORD_PARSER_ENABLED
+#define NFC_NDEF_RECORD_PARSER_ENABLED 1
+#endif
+#if  NFC_NDEF_RECORD_PARSER_ENABLED
+// <e> NFC_NDEF_RECORD_PARSER_LOG_ENABLED - Enables logging in the module.
+//==========================================================
+#ifndef NFC_NDEF_RECORD_PARSER_LOG_ENABLED
+#define NFC_NDEF_RECORD_PARSER_LOG_ENABLED 0
+#endif
+#if  NFC_NDEF_RECORD_PARSER_LOG_ENABLED
+// <o> NFC_NDEF_RECORD_PARSER_LOG_LEVEL  - Default Severity level
+ 
+// <0=> Off 
+// <1=> Error 
+// <2=> Warning 
+// <3=> Info 
+// <4=> Debug 
+
+#ifndef NFC_NDEF_RECORD_PARSER_LOG_LEVEL
+#define NFC_NDEF_RECORD_PARSER_LOG_LEVEL 3
+#endif
+
+// <o> NFC_NDEF_RECORD_PARSER_INFO_COLOR  - ANSI escape code prefix.
+ 
+// <0=> Default 
+// <1=> Black 
+// <2=> Red 
+// <3=> Green 
+// <4=> Yellow 
+// <5=> Blue 
+// <6=> Magenta 
+// <7=> Cyan 
+// <8=> White 
+
+#ifndef NFC_NDEF_RECORD_PARSER_INFO_COLOR
+#define NFC_NDEF_RECORD_PARSER_INFO_COLOR 0
+#endif
+
+#endif //NFC_NDEF_RECORD_PARSER_LOG_ENABLED
+// </e>
+
+#endif //NFC_NDEF_RECORD_PARSER_ENABLED
+// </e>
+
+// <e> NFC_T2T_PARSER_ENABLED - nfc_type_2_tag_parser - Parser for decoding Type 2 Tag data
+//==========================================================
+#ifndef NFC_T2T_PARSER_ENABLED
+#define NFC_T2T_PARSER_ENABLED 1
+#endif
+#if  NFC_T2T_PARSER_ENABLED
+// <e> NFC_T2T_PARSER_LOG_ENABLED - Enables logging in the module.
+//==========================================================
+#ifndef NFC_T2T_PARSER_LOG_ENABLED
+#define NFC_T2T_PARSER_LOG_ENABLED 0
+#endif
+#if  NFC_T2T_PARSER_LOG_ENABLED
+// <o> NFC_T2T_PARSER_LOG_LEVEL  - Default Severity level
+ 
+// <0=> Off 
+// <1=> Error 
+// <2=> Warning 
+// <3=> Info 
+// <4=> Debug 
+
+#ifndef NFC_T2T_PARSER_LOG_LEVEL
+#define NFC_T2T_PARSER_LOG_LEVEL 3
+#endif
+
+// <o> NFC_T2T_PARSER_INFO_COLOR  - ANSI escape code prefix.
+ 
+// <0=> Default 
+// <1=> Black 
+// <2=> Red 
+// <3=> Green 
+// <4=> Yellow 
+// <5=> Blue 
+// <6=> Magenta 
+// <7=> Cyan 
+// <8=> White 
+
+#ifndef NFC_T2T_PARSER_INFO_COLOR
+#define NFC_T2T_PARSER_INFO_COLOR 0
+#endif
+
+#endif //NFC_T2T_PARSER_LOG_ENABLED
+// </e>
+
+#endif //NFC_T2T_PARSER_ENABLED
+// </e>
+
+// <e> NFC_T4T_APDU_ENABLED - nfc_t4t_apdu - APDU encoder/decoder for Type 4 Tag
+//==========================================================
+#ifndef NFC_T4T_APDU_ENABLED
+#define NFC_T4T_APDU_ENABLED 1
+#endif
+#if  NFC_T4T_APDU_ENABLED
+// <e> NFC_T4T_APDU_LOG_ENABLED - Enables logging in the module.
+//==========================================================
+#ifndef NFC_T4T_APDU_LOG_ENABLED
+#define NFC_T4T_APDU_LOG_ENABLED 0
+#endif
+#if  NFC_T4T_APDU_LOG_ENABLED
+// <o> NFC_T4T_APDU_LOG_LEVEL  - Default Severity level
+ 
+// <0=> Off 
+// <1=> Error 
+// <2=> Warning 
+// <3=> Info 
+// <4=> Debug 
+
+#ifndef NFC_T4T_APDU_LOG_LEVEL
+#define NFC_T4T_APDU_LOG_LEVEL 3
+#endif
+
+// <o> NFC_T4T_APDU_LOG_COLOR  - ANSI escape code prefix.
+ 
+// <0=> Default 
+// <1=> Black 
+// <2=> Red 
+// <3=> Green 
+// <4=> Yellow 
+// <5=> Blue 
+// <6=> Magenta 
+// <7=> Cyan 
+// <8=> White 
+
+#ifndef NFC_T4T_APDU_LOG_COLOR
+#define NFC_T4T_APDU_LOG_COLOR 0
+#endif
+
+#endif //NFC_T4T_APDU_LOG_ENABLED
+// </e>
+
+#endif //NFC_T4T_APDU_ENABLED
+// </e>
+
+// <e> NFC_T4T_CC_FILE_PARSER_ENABLED - nfc_t4t_cc_file - Capability Container file for Type 4 Tag
+//==========================================================
+#ifndef NFC_T4T_CC_FILE_PARSER_ENABLED
+#define NFC_T4T_CC_FILE_PARSER_ENABLED 1
+#endif
+#if  NFC_T4T_CC_FILE_PARSER_ENABLED
+// <e> NFC_T4T_CC_FILE_PARSER_LOG_ENABLED - Enables logging in the module.
+//==========================================================
+#ifndef NFC_T4T_CC_FILE_PARSER_LOG_ENABLED
+#define NFC_T4T_CC_FILE_PARSER_LOG_ENABLED 0
+#endif
+#if  NFC_T4T_CC_FILE_PARSER_LOG_ENABLED
+// <o> NFC_T4T_CC_FILE_PARSER_LOG_LEVEL  - Default Severity level
+ 
+// <0=> Off 
+// <1=> Error 
+// <2=> Warning 
+// <3=> Info 
+// <4=> Debug 
+
+#ifndef NFC_T4T_CC_FILE_PARSER_LOG_LEVEL
+#define NFC_T4T_CC_FILE_PARSER_LOG_LEVEL 3
+#endif
+
+// <o> NFC_T4T_CC_FILE_PARSER_INFO_COLOR  - ANSI escape code prefix.
+ 
+// <0=> Default 
+// <1=> Black 
+// <2=> Red 
+// <3=> Green 
+// <4=> Yellow 
+// <5=> Blue 
+// <6=> Magenta 
+// <7=> Cyan 
+// <8=> White 
+
+#ifndef NFC_T4T_CC_FILE_PARSER_INFO_COLOR
+#define NFC_T4T_CC_FILE_PARSER_INFO_COLOR 0
+#endif
+
+#endif //NFC_T4T_CC_FILE_PARSER_LOG_ENABLED
+// </e>
+
+#endif //NFC_T4T_CC_FILE_PARSER_ENABLED
+// </e>
+
+// <e> NFC_T4T_HL_DETECTION_PROCEDURES_ENABLED - nfc_t4t_hl_detection_procedures - NDEF Detection Procedure for Type 4 Tag
+//==========================================================
+#ifndef NFC_T4T_HL_DETECTION_PROCEDURES_ENABLED
+#define NFC_T4T_HL_DETECTION_PROCEDURES_ENABLED 1
+#endif
+#if  NFC_T4T_HL_DETECTION_PROCEDURES_ENABLED
+// <o> APDU_BUFF_SIZE - Size of the buffer used for APDU storage. 
+#ifndef APDU_BUFF_SIZE
+#define APDU_BUFF_SIZE 250
+#endif
+
+// <o> CC_STORAGE_BUFF_SIZE - Size of the buffer used for Capability Container storage. 
+#ifndef CC_STORAGE_BUFF_SIZE
+#define CC_STORAGE_BUFF_SIZE 64
+#endif
+
+// <e> NFC_T4T_HL_DETECTION_PROCEDURES_LOG_ENABLED - Enables logging in the module.
+//==========================================================
+#ifndef NFC_T4T_HL_DETECTION_PROCEDURES_LOG_ENABLED
+#define NFC_T4T_HL_DETECTION_PROCEDURES_LOG_ENABLED 0
+#endif
+#if  NFC_T4T_HL_DETECTION_PROCEDURES_LOG_ENABLED
+// <o> NFC_T4T_HL_DETECTION_PROCEDURES_LOG_LEVEL  - Default Severity level
+ 
+// <0=> Off 
+// <1=> Error 
+// <2=> Warning 
+// <3=> Info 
+// <4=> Debug 
+
+#ifndef NFC_T4T_HL_DETECTION_PROCEDURES_LOG_LEVEL
+#define NFC_T4T_HL_DETECTION_PROCEDURES_LOG_LEVEL 3
+#endif
+
+// <o> NFC_T4T_HL_DETECTION_PROCEDURES_INFO_COLOR  - ANSI escape code prefix.
+ 
+// <0=> Default 
+// <1=> Black 
+// <2=> Red 
+// <3=> Green 
+// <4=> Yellow 
+// <5=> Blue 
+// <6=> Magenta 
+// <7=> Cyan 
+// <8=> White 
+
+#ifndef NFC_T4T_HL_DETECTION_PROCEDURES_INFO_COLOR
+#define NFC_T4T_HL_DETECTION_PROCEDURES_INFO_COLOR 0
+#endif
+
+#endif //NFC_T4T_HL_DETECTION_PROCEDURES_LOG_ENABLED
+// </e>
+
+#endif //NFC_T4T_HL_DETECTION_PROCEDURES_ENABLED
+// </e>
+
+// <e> NFC_T4T_TLV_BLOCK_PARSER_ENABLED - nfc_t4t_tlv_block - TLV block for Type 4 Tag
+//==========================================================
+#ifndef NFC_T4T_TLV_BLOCK_PARSER_ENABLED
+#define NFC_T4T_TLV_BLOCK_PARSER_ENABLED 1
+#endif
+#if  NFC_T4T_TLV_BLOCK_PARSER_ENABLED
+// <e> NFC_T4T_TLV_BLOCK_PARSER_LOG_ENABLED - Enables logging in the module.
+//==========================================================
+#ifndef NFC_T4T_TLV_BLOCK_PARSER_LOG_ENABLED
+#define NFC_T4T_TLV_BLOCK_PARSER_LOG_ENABLED 0
+#endif
+#if  NFC_T4T_TLV_BLOCK_PARSER_LOG_ENABLED
+// <o> NFC_T4T_TLV_BLOCK_PARSER_LOG_LEVEL  - Default Severity level
+ 
+// <0=> Off 
+// <1=> Error 
+// <2=> Warning 
+// <3=> Info 
+// <4=> Debug 
+
+#ifndef NFC_T4T_TLV_BLOCK_PARSER_LOG_LEVEL
+#define NFC_T4T_TLV_BLOCK_PARSER_LOG_LEVEL 3
+#endif
+
+// <o> NFC_T4T_TLV_BLOCK_PARSER_INFO_COLOR  - ANSI escape code prefix.
+ 
+// <0=> Default 
+// <1=> Black 
+// <2=> Red 
+// <3=> Green 
+// <4=> Yellow 
+// <5=> Blue 
+// <6=> Magenta 
+// <7=> Cyan 
+// <8=> White 
+
+#ifndef NFC_T4T_TLV_BLOCK_PARSER_INFO_COLOR
+#define NFC_T4T_TLV_BLOCK_PARSER_INFO_COLOR 0
+#endif
+
+#endif //NFC_T4T_TLV_BLOCK_PARSER_LOG_ENABLED
+// </e>
+
+#endif //NFC_T4T_TLV_BLOCK_PARSER_ENABLED
+// </e>
+
+// </h> 
+//==========================================================
+
+// <h> nRF_Segger_RTT 
+
+//==========================================================
+// <h> segger_rtt - SEGGER RTT
+
+//==========================================================
+// <o> SEGGER_RTT_CONFIG_BUFFER_SIZE_UP - Size of upstream buffer. 
+#ifndef SEGGER_RTT_CONFIG_BUFFER_SIZE_UP
+#define SEGGER_RTT_CONFIG_BUFFER_SIZE_UP 64
+#endif
+
+// <o> SEGGER_RTT_CONFIG_MAX_NUM_UP_BUFFERS - Size of upstream buffer. 
+#ifndef SEGGER_RTT_CONFIG_MAX_NUM_UP_BUFFERS
+#define SEGGER_RTT_CONFIG_MAX_NUM_UP_BUFFERS 2
+#endif
+
+// <o> SEGGER_RTT_CONFIG_BUFFER_SIZE_DOWN - Size of upstream buffer. 
+#ifndef SEGGER_RTT_CONFIG_BUFFER_SIZE_DOWN
+#define SEGGER_RTT_CONFIG_BUFFER_SIZE_DOWN 16
+#endif
+
+// <o> SEGGER_RTT_CONFIG_MAX_NUM_DOWN_BUFFERS - Size of upstream buffer. 
+#ifndef SEGGER_RTT_CONFIG_MAX_NUM_DOWN_BUFFERS
+#define SEGGER_RTT_CONFIG_MAX_NUM_DOWN_BUFFERS 2
+#endif
+
+// </h> 
+//==========================================================
+
 // </h> 
 //==========================================================
 
+// <h> my_dervice - Lock reader application modules
+
+//==========================================================
+// <o> PN532_PACKET_BUFFER_SIZE - Size of the PN532 command/response buffer <64-254> 
+// <i> Largest frame handled through pn532_packetbuffer. Reads into a caller
+// <i> buffer (pn532_frame_read) are limited by the TWI transfer size only.
+#ifndef PN532_PACKET_BUFFER_SIZE
+#define PN532_PACKET_BUFFER_SIZE 128
+#endif
+
+// <o> PN532_TRANSPORT  - Host interface of the PN532
+ 
+// <i> Only the selected backend is built. SPI runs on SPI1 at 4 MHz and needs
+// <i> SPI1_ENABLED with TWI1 disabled; HSU takes the only UART and needs APP_UART disabled.
+// <0=> I2C 
+// <1=> SPI 
+// <2=> HSU 
+
+#ifndef PN532_TRANSPORT
+#define PN532_TRANSPORT 0
+#endif
+
+// <o> PN532_SAM_MODE  - What SAMConfiguration puts the PN532 in after power up
+ 
+// <i> Virtual and dual card need a SAM on the S2C pins, read through the antenna by an outside
+// <i> reader. pn532_sam takes wired card mode for each exchange of its own with the SAM.
+// <1=> Normal 
+// <2=> Virtual card 
+// <4=> Dual card 
+
+#ifndef PN532_SAM_MODE
+#define PN532_SAM_MODE 1
+#endif
+
+// <o> PN532_SAM_TIMEOUT - Virtual card timeout, in 50 ms units, 0 for none <0-255> 
+#ifndef PN532_SAM_TIMEOUT
+#define PN532_SAM_TIMEOUT 20
+#endif
+
+// <e> TWI_BUS_ENABLED - twi_bus - TWI1 shared by the PN532 and other I2C parts through a transaction queue
+// <i> The PN532 (I2C transport) goes in the high priority queue. Excludes PN532_PPI_RX.
+//==========================================================
+#ifndef TWI_BUS_ENABLED
+#define TWI_BUS_ENABLED 1
+#endif
+#if  TWI_BUS_ENABLED
+// <o> TWI_BUS_SCL_PIN - SCL pin. 
+#ifndef TWI_BUS_SCL_PIN
+#define TWI_BUS_SCL_PIN 11
+#endif
+
+// <o> TWI_BUS_SDA_PIN - SDA pin. 
+#ifndef TWI_BUS_SDA_PIN
+#define TWI_BUS_SDA_PIN 10
+#endif
+
+// <o> TWI_BUS_IRQ_PRIORITY  - Priority of the TWI interrupt and the transaction callbacks
+ 
+// <i> Blocking transfers may be run from interrupts below this priority.
+// <1=> 1 
+// <3=> 3 
+
+#ifndef TWI_BUS_IRQ_PRIORITY
+#define TWI_BUS_IRQ_PRIORITY 1
+#endif
+
+// <o> TWI_BUS_TIMEOUT_MS - Time a transfer may take before the bus is recovered <5-1000> 
+// <i> A transfer is given up between one and two of these. The longest, 255 bytes at 100 kHz, takes 23 ms.
+#ifndef TWI_BUS_TIMEOUT_MS
+#define TWI_BUS_TIMEOUT_MS 25
+#endif
+
+#endif //TWI_BUS_ENABLED
+// </e>
+
+// <e> SPI_BUS_ENABLED - spi_bus - SPI0 shared by the MX25 and other SPI parts, with queued commands and chip select sequencing
+// <i> flash_io runs all MX25 commands through it.
+//==========================================================
+#ifndef SPI_BUS_ENABLED
+#define SPI_BUS_ENABLED 1
+#endif
+#if  SPI_BUS_ENABLED
+// <o> SPI_BUS_SCK_PIN - SCK pin. 
+#ifndef SPI_BUS_SCK_PIN
+#define SPI_BUS_SCK_PIN 24
+#endif
+
+// <o> SPI_BUS_MOSI_PIN - MOSI pin. 
+#ifndef SPI_BUS_MOSI_PIN
+#define SPI_BUS_MOSI_PIN 25
+#endif
+
+// <o> SPI_BUS_MISO_PIN - MISO pin. 
+#ifndef SPI_BUS_MISO_PIN
+#define SPI_BUS_MISO_PIN 29
+#endif
+
+// <o> SPI_BUS_IRQ_PRIORITY  - Priority of the SPI interrupt and the command callbacks
+ 
+// <1=> 1 
+// <3=> 3 
+
+#ifndef SPI_BUS_IRQ_PRIORITY
+#define SPI_BUS_IRQ_PRIORITY 3
+#endif
+
+#endif //SPI_BUS_ENABLED
+// </e>
+
+// <e> UART_FRAME_ENABLED - uart_frame - Command link received as idle-delimited frames instead of bytes
+// <i> Replaces app_uart on UART0: needs PPI_ENABLED, and APP_UART_ENABLED, UART0_ENABLED and TIMER2_ENABLED at 0.
+//==========================================================
+#ifndef UART_FRAME_ENABLED
+#define UART_FRAME_ENABLED 0
+#endif
+#if  UART_FRAME_ENABLED
+// <o> UART_FRAME_MAX_LEN - Longest frame. 
+// <i> A longer run of bytes is cut into frames of this size. At most BLE_NUS_MAX_DATA_LEN.
+#ifndef UART_FRAME_MAX_LEN
+#define UART_FRAME_MAX_LEN 20
+#endif
+
+// <o> UART_FRAME_IDLE_US - Idle line that ends a frame, in microseconds. 
+// <i> Three byte times at 1 Mbaud.
+#ifndef UART_FRAME_IDLE_US
+#define UART_FRAME_IDLE_US 30
+#endif
+
+// <o> UART_FRAME_TX_BUF_SIZE - Size of the transmit FIFO (power of 2). 
+#ifndef UART_FRAME_TX_BUF_SIZE
+#define UART_FRAME_TX_BUF_SIZE 256
+#endif
+
+// <o> UART_FRAME_IRQ_PRIORITY  - Priority of the frame handler
+ 
+// <1=> 1 
+// <3=> 3 
+
+#ifndef UART_FRAME_IRQ_PRIORITY
+#define UART_FRAME_IRQ_PRIORITY 3
+#endif
+
+#endif //UART_FRAME_ENABLED
+// </e>
+
+// <e> STREAM_FRAME_ENABLED - stream_frame - SLIP framing with CRC16 for the commands on the UART and NUS
+// <i> The UART takes framed commands only; a NUS write starting with END (0xC0) is framed, other writes stay raw.
+// <i> Replies to a link that sent a frame are framed too.
+//==========================================================
+#ifndef STREAM_FRAME_ENABLED
+#define STREAM_FRAME_ENABLED 0
+#endif
+#if  STREAM_FRAME_ENABLED
+// <o> STREAM_FRAME_MAX_LEN - Longest command payload, without the CRC. 
+// <i> At most BLE_NUS_MAX_DATA_LEN.
+#ifndef STREAM_FRAME_MAX_LEN
+#define STREAM_FRAME_MAX_LEN 20
+#endif
+
+#endif //STREAM_FRAME_ENABLED
+// </e>
+
+// <e> HOST_SPIS_ENABLED - host_spis - Raw commands from a host MCU over SPI, with an IRQ line for the replies
+// <i> Needs CMD_RING_ENABLED and SPIS_ENABLED with the instance enabled.
+//==========================================================
+#ifndef HOST_SPIS_ENABLED
+#define HOST_SPIS_ENABLED 0
+#endif
+#if  HOST_SPIS_ENABLED
+// <o> HOST_SPIS_INSTANCE - SPIS instance  <0-2> 
+#ifndef HOST_SPIS_INSTANCE
+#define HOST_SPIS_INSTANCE 1
+#endif
+
+// <o> HOST_SPIS_MODE - SPI mode  <0-3> 
+#ifndef HOST_SPIS_MODE
+#define HOST_SPIS_MODE 0
+#endif
+
+// <o> HOST_SPIS_SCK_PIN - SCK pin  <0-31> 
+#ifndef HOST_SPIS_SCK_PIN
+#define HOST_SPIS_SCK_PIN 28
+#endif
+
+// <o> HOST_SPIS_MOSI_PIN - MOSI pin  <0-31> 
+#ifndef HOST_SPIS_MOSI_PIN
+#define HOST_SPIS_MOSI_PIN 29
+#endif
+
+// <o> HOST_SPIS_MISO_PIN - MISO pin  <0-31> 
+#ifndef HOST_SPIS_MISO_PIN
+#define HOST_SPIS_MISO_PIN 30
+#endif
+
+// <o> HOST_SPIS_CSN_PIN - CSN pin  <0-31> 
+#ifndef HOST_SPIS_CSN_PIN
+#define HOST_SPIS_CSN_PIN 31
+#endif
+
+// <o> HOST_SPIS_IRQ_PIN - IRQ output to the host, low while a reply is waiting  <0-31> 
+#ifndef HOST_SPIS_IRQ_PIN
+#define HOST_SPIS_IRQ_PIN 27
+#endif
+
+// <o> HOST_SPIS_XFER_LEN - Longest transaction, status and length bytes included  <3-255> 
+#ifndef HOST_SPIS_XFER_LEN
+#define HOST_SPIS_XFER_LEN 66
+#endif
+
+// <o> HOST_SPIS_CMD_RING_SIZE - Bytes of the command queue 
+#ifndef HOST_SPIS_CMD_RING_SIZE
+#define HOST_SPIS_CMD_RING_SIZE 128
+#endif
+
+// <o> HOST_SPIS_REPLY_RING_SIZE - Bytes of the reply queue 
+#ifndef HOST_SPIS_REPLY_RING_SIZE
+#define HOST_SPIS_REPLY_RING_SIZE 512
+#endif
+
+// <o> HOST_SPIS_REPLY_WAIT_MS - Longest wait for room in the reply queue 
+#ifndef HOST_SPIS_REPLY_WAIT_MS
+#define HOST_SPIS_REPLY_WAIT_MS 100
+#endif
+
+#endif //HOST_SPIS_ENABLED
+// </e>
+
+// <e> FRAME_POOL_ENABLED - frame_pool - Shared 256-byte frame buffers from nrf_balloc (needs NRF_BALLOC, used by pn532_scan, pn532_isodep and flash_io)
+//==========================================================
+#ifndef FRAME_POOL_ENABLED
+#define FRAME_POOL_ENABLED 1
+#endif
+#if  FRAME_POOL_ENABLED
+// <o> FRAME_POOL_SIZE - Number of frame buffers. 
+// <i> Two let a card exchange run from a scan handler while the poll frame is still held.
+#ifndef FRAME_POOL_SIZE
+#define FRAME_POOL_SIZE 2
+#endif
+
+#endif //FRAME_POOL_ENABLED
+// </e>
+
+// <e> PN532_ASYNC_ENABLED - pn532_async - Interrupt driven PN532 command engine
+//==========================================================
+#ifndef PN532_ASYNC_ENABLED
+#define PN532_ASYNC_ENABLED 1
+#endif
+#if  PN532_ASYNC_ENABLED
+// <o> PN532_ASYNC_QUEUE_SIZE - Number of commands that can wait behind the one in flight. 
+// <i> Each entry holds a prebuilt frame (about 80 bytes of RAM).
+#ifndef PN532_ASYNC_QUEUE_SIZE
+#define PN532_ASYNC_QUEUE_SIZE 3
+#endif
+
+// <q> PN532_PPI_RX_ENABLED  - Start the ACK and response reads from the IRQ edge through PPI (I2C only, needs PPI_ENABLED)
+ 
+// <i> Takes the main loop and the interrupt latency out of the ready-to-read path. Uses a GPIOTE channel per IRQ line.
+
+#ifndef PN532_PPI_RX_ENABLED
+#define PN532_PPI_RX_ENABLED 0
+#endif
+
+#endif //PN532_ASYNC_ENABLED
+// </e>
+
+// <e> PN532_DEADLINE_ENABLED - pn532_deadline - Response timeouts learned per command from the latencies seen
+//==========================================================
+#ifndef PN532_DEADLINE_ENABLED
+#define PN532_DEADLINE_ENABLED 1
+#endif
+#if  PN532_DEADLINE_ENABLED
+// <o> PN532_DEADLINE_KEYS - Commands with an estimate of their own. 
+#ifndef PN532_DEADLINE_KEYS
+#define PN532_DEADLINE_KEYS 12
+#endif
+
+// <o> PN532_DEADLINE_SAMPLES - Responses seen before the estimate replaces the caller's timeout. <1-255> 
+#ifndef PN532_DEADLINE_SAMPLES
+#define PN532_DEADLINE_SAMPLES 8
+#endif
+
+// <o> PN532_DEADLINE_K - Mean deviations above the mean the deadline is. 
+// <i> 4 leaves out well under 1 in 100 responses of a card that is there.
+#ifndef PN532_DEADLINE_K
+#define PN532_DEADLINE_K 4
+#endif
+
+// <o> PN532_DEADLINE_MIN_MS - Shortest deadline. 
+#ifndef PN532_DEADLINE_MIN_MS
+#define PN532_DEADLINE_MIN_MS 3
+#endif
+
+// <o> PN532_DEADLINE_MAX_MS - Longest caller timeout that is learned. 
+// <i> Longer waits are on purpose, e.g. ISO-DEP exchanges that allow for waiting time extensions.
+#ifndef PN532_DEADLINE_MAX_MS
+#define PN532_DEADLINE_MAX_MS 1000
+#endif
+
+#endif //PN532_DEADLINE_ENABLED
+// </e>
+
+// <e> PN532_RETRY_ENABLED - pn532_retry - Retries failed card exchanges after a reselect instead of giving up
+//==========================================================
+#ifndef PN532_RETRY_ENABLED
+#define PN532_RETRY_ENABLED 1
+#endif
+#if  PN532_RETRY_ENABLED
+// <o> PN532_RETRY_MAX - Reselects per failed exchange. <1-8> 
+#ifndef PN532_RETRY_MAX
+#define PN532_RETRY_MAX 3
+#endif
+
+// <o> PN532_RETRY_BACKOFF_MS - Wait before the second reselect, doubled for each one after. 
+// <i> The first reselect is right away.
+#ifndef PN532_RETRY_BACKOFF_MS
+#define PN532_RETRY_BACKOFF_MS 5
+#endif
+
+#endif //PN532_RETRY_ENABLED
+// </e>
+
+// <q> PN532_SCAN_ENABLED  - pn532_scan - InAutoPoll background scanning (needs PN532_ASYNC)
+ 
+
+#ifndef PN532_SCAN_ENABLED
+#define PN532_SCAN_ENABLED 1
+#endif
+
+// <q> PN532_PT_ENABLED  - pn532_pt - Multi-command sequences as protothreads run from the main loop (needs PN532_ASYNC)
+ 
+
+#ifndef PN532_PT_ENABLED
+#define PN532_PT_ENABLED 1
+#endif
+
+// <e> PN532_DUTY_ENABLED - pn532_duty - Duty-cycled card detection with the PN532 in PowerDown between bursts (replaces pn532_scan for scan_card_start)
+//==========================================================
+#ifndef PN532_DUTY_ENABLED
+#define PN532_DUTY_ENABLED 1
+#endif
+#if  PN532_DUTY_ENABLED
+// <o> PN532_DUTY_FAST_MS - Burst interval after a card or a command, in ms. 
+#ifndef PN532_DUTY_FAST_MS
+#define PN532_DUTY_FAST_MS 250
+#endif
+
+// <o> PN532_DUTY_SLOW_MS - Longest burst interval when idle, in ms. 
+// <i> The interval doubles after every empty burst up to this value.
+#ifndef PN532_DUTY_SLOW_MS
+#define PN532_DUTY_SLOW_MS 2000
+#endif
+
+// <o> PN532_DUTY_SAVE_MS - Longest burst interval in power save (pn532_duty_save), in ms. 
+// <i> In power save the burst interval after a card is PN532_DUTY_SLOW_MS.
+#ifndef PN532_DUTY_SAVE_MS
+#define PN532_DUTY_SAVE_MS 8000
+#endif
+
+// <o> PN532_DUTY_IDLE_MS - Longest burst interval with nobody near the reader (pn532_duty_idle), in ms. 
+#ifndef PN532_DUTY_IDLE_MS
+#define PN532_DUTY_IDLE_MS 30000
+#endif
+
+// <o> PN532_DUTY_BURST_MS - Response deadline of one InListPassiveTarget burst, in ms. 
+#ifndef PN532_DUTY_BURST_MS
+#define PN532_DUTY_BURST_MS 50
+#endif
+
+// <o> PN532_DUTY_RETRIES - MxRtyPassiveActivation during a burst. 
+// <i> Each retry keeps the field on for a few more ms.
+#ifndef PN532_DUTY_RETRIES
+#define PN532_DUTY_RETRIES 1
+#endif
+
+#endif //PN532_DUTY_ENABLED
+// </e>
+
+// <e> RADIO_GAP_ENABLED - radio_gap - PN532 bursts and MX25 background work started between radio events
+// <i> Uses the radio notification of the SoftDevice, on SWI1.
+//==========================================================
+#ifndef RADIO_GAP_ENABLED
+#define RADIO_GAP_ENABLED 1
+#endif
+#if  RADIO_GAP_ENABLED
+// <o> RADIO_GAP_DISTANCE  - Notice of a radio event
+ 
+// <1=> 800 us 
+// <2=> 1740 us 
+// <3=> 2680 us 
+// <4=> 3620 us 
+// <5=> 4560 us 
+// <6=> 5500 us 
+
+#ifndef RADIO_GAP_DISTANCE
+#define RADIO_GAP_DISTANCE 2
+#endif
+
+// <o> RADIO_GAP_IRQ_PRIORITY  - Priority of the radio notification interrupt
+ 
+// <1=> 1 
+// <3=> 3 
+
+#ifndef RADIO_GAP_IRQ_PRIORITY
+#define RADIO_GAP_IRQ_PRIORITY 3
+#endif
+
+// <o> RADIO_GAP_QUEUE_SIZE - Handlers of one class waiting for a gap. 
+#ifndef RADIO_GAP_QUEUE_SIZE
+#define RADIO_GAP_QUEUE_SIZE 4
+#endif
+
+// <o> RADIO_GAP_TAP_MAX_MS - Longest a tap holds up MX25 work, in ms. 
+#ifndef RADIO_GAP_TAP_MAX_MS
+#define RADIO_GAP_TAP_MAX_MS 500
+#endif
+
+#endif //RADIO_GAP_ENABLED
+// </e>
+
+// <q> NFC_PAIR_ENABLED  - nfc_pair - BLE OOB pairing message in a Type 2 Tag emulated by the NFCT
+// <i> nRF52 only, with nfc_t2t_lib and ble_pair_msg; holds the PN532 bursts off while a phone is in the field.
+ 
+
+#ifndef NFC_PAIR_ENABLED
+#define NFC_PAIR_ENABLED 0
+#endif
+
+// <e> PN532_READER_ENABLED - pn532_reader - Several PN532s on the shared host interface, polled together
+//==========================================================
+#ifndef PN532_READER_ENABLED
+#define PN532_READER_ENABLED 0
+#endif
+#if  PN532_READER_ENABLED
+// <o> PN532_READER_COUNT - Number of readers, 1 or 2. 
+// <i> I2C: a bus switch on pin 5 selects the reader. SPI: each reader has its own NSS.
+#ifndef PN532_READER_COUNT
+#define PN532_READER_COUNT 2
+#endif
+
+#endif //PN532_READER_ENABLED
+// </e>
+
+// <q> PN532_T2T_ENABLED  - pn532_t2t - Type 2 Tag reader feeding nfc_t2t_parser page by page (needs NFC_T2T_PARSER)
+ 
+
+#ifndef PN532_T2T_ENABLED
+#define PN532_T2T_ENABLED 1
+#endif
+
+// <q> PN532_T1T_ENABLED  - pn532_t1t - Type 1 Tag (Jewel, Topaz) reader feeding nfc_t2t_parser with RALL and READ8 (needs NFC_T2T_PARSER)
+ 
+
+#ifndef PN532_T1T_ENABLED
+#define PN532_T1T_ENABLED 1
+#endif
+
+// <e> PN532_T4T_ENABLED - pn532_t4t - Type 4 Tag NDEF read in MLe chunks, capability containers cached per card profile (needs PN532_ISODEP, NFC_T4T_CC_FILE_PARSER)
+//==========================================================
+#ifndef PN532_T4T_ENABLED
+#define PN532_T4T_ENABLED 1
+#endif
+#if  PN532_T4T_ENABLED
+// <o> PN532_T4T_CACHE_SIZE - Number of card profiles (ATQA, SAK, ATS) whose CC is remembered. 
+#ifndef PN532_T4T_CACHE_SIZE
+#define PN532_T4T_CACHE_SIZE 4
+#endif
+
+#endif //PN532_T4T_ENABLED
+// </e>
+
+// <q> PN532_PRESENCE_ENABLED  - pn532_presence - Card presence tracking, reselects a card still in the field without anticollision
+ 
+
+#ifndef PN532_PRESENCE_ENABLED
+#define PN532_PRESENCE_ENABLED 1
+#endif
+
+// <e> PN532_PROFILE_ENABLED - pn532_profile - Card family from ATQA, SAK, ATS and GET_VERSION, cached per UID
+//==========================================================
+#ifndef PN532_PROFILE_ENABLED
+#define PN532_PROFILE_ENABLED 1
+#endif
+#if  PN532_PROFILE_ENABLED
+// <o> PN532_PROFILE_CACHE_SIZE - Number of cards remembered. 
+// <i> Only SAK 0x00 cards cost a GET_VERSION; the cache saves it on every later tap.
+#ifndef PN532_PROFILE_CACHE_SIZE
+#define PN532_PROFILE_CACHE_SIZE 8
+#endif
+
+#endif //PN532_PROFILE_ENABLED
+// </e>
+
+// <e> PN532_TUNE_ENABLED - pn532_tune - RF analog profiles per card family, kept in flash, with RxGain/CWGsP calibration (needs FDS)
+//==========================================================
+#ifndef PN532_TUNE_ENABLED
+#define PN532_TUNE_ENABLED 1
+#endif
+#if  PN532_TUNE_ENABLED
+// <o> PN532_TUNE_POLLS - Polls of the reference card per calibration step. <1-16> 
+// <i> A step is scored by the polls that found the card; 32 steps are tried at most.
+#ifndef PN532_TUNE_POLLS
+#define PN532_TUNE_POLLS 4
+#endif
+
+// <o> PN532_TUNE_POLL_MS - Time one calibration poll waits for the card. 
+#ifndef PN532_TUNE_POLL_MS
+#define PN532_TUNE_POLL_MS 50
+#endif
+
+// <o> PN532_TUNE_FILE_ID - FDS file ID of the profile record <0x0000-0xBFFF> 
+#ifndef PN532_TUNE_FILE_ID
+#define PN532_TUNE_FILE_ID 0x5254
+#endif
+
+// <o> PN532_TUNE_RECORD_KEY - FDS record key of the profile record <0x0001-0xBFFF> 
+#ifndef PN532_TUNE_RECORD_KEY
+#define PN532_TUNE_RECORD_KEY 0x0001
+#endif
+
+#endif //PN532_TUNE_ENABLED
+// </e>
+
+// <e> PN532_DIAG_ENABLED - pn532_diag - Periodic PN532 self test: line, antenna and field status (Diagnose, GetGeneralStatus)
+//==========================================================
+#ifndef PN532_DIAG_ENABLED
+#define PN532_DIAG_ENABLED 1
+#endif
+#if  PN532_DIAG_ENABLED
+// <o> PN532_DIAG_PERIOD_MIN - Minutes between self tests. <1-1440> 
+#ifndef PN532_DIAG_PERIOD_MIN
+#define PN532_DIAG_PERIOD_MIN 15
+#endif
+
+// <o> PN532_DIAG_ANTENNA_THRESHOLD - Threshold byte of the antenna self test. 
+// <i> Low and high current limits of the antenna detector and its enable bit, PN532 User Manual 7.2.1.
+#ifndef PN532_DIAG_ANTENNA_THRESHOLD
+#define PN532_DIAG_ANTENNA_THRESHOLD 0x29
+#endif
+
+#endif //PN532_DIAG_ENABLED
+// </e>
+
+// <e> PN532_HCE_ENABLED - pn532_hce - Phone credentials over NFC, the PN532 emulating an ISO-DEP card (TgInitAsTarget)
+// <i> Needs NRF_CRYPTO_AES_ENABLED, RAND_POOL_ENABLED and PN532_DUTY_ENABLED. The application defines PN532_HCE_KEY,
+// <i> the AES-128 key the phone credentials are signed with.
+//==========================================================
+#ifndef PN532_HCE_ENABLED
+#define PN532_HCE_ENABLED 0
+#endif
+#if  PN532_HCE_ENABLED
+// <o> PN532_HCE_LISTEN_MS - Listen window for a phone after a burst that found no card, in ms. 
+#ifndef PN532_HCE_LISTEN_MS
+#define PN532_HCE_LISTEN_MS 100
+#endif
+
+// <o> PN532_HCE_APDU_MS - Time the emulated card waits for the next APDU of the phone, in ms. 
+#ifndef PN532_HCE_APDU_MS
+#define PN532_HCE_APDU_MS 500
+#endif
+
+#endif //PN532_HCE_ENABLED
+// </e>
+
+// <e> PN532_SNEP_ENABLED - pn532_snep - NDEF push from a phone in peer to peer mode, NFC-DEP initiator with LLCP and SNEP
+// <i> Needs PN532_DUTY_ENABLED and PN532_NDEF_ENABLED; polled after a burst that found no card.
+//==========================================================
+#ifndef PN532_SNEP_ENABLED
+#define PN532_SNEP_ENABLED 0
+#endif
+#if  PN532_SNEP_ENABLED
+// <o> PN532_SNEP_BITRATE  - Passive bit rate of the poll
+ 
+// <0=> 106 kbps 
+// <1=> 212 kbps 
+// <2=> 424 kbps 
+
+#ifndef PN532_SNEP_BITRATE
+#define PN532_SNEP_BITRATE 2
+#endif
+
+// <o> PN532_SNEP_POLL_MS - Time a poll waits for a phone, in ms. 
+#ifndef PN532_SNEP_POLL_MS
+#define PN532_SNEP_POLL_MS 100
+#endif
+
+// <o> PN532_SNEP_SESSION_MS - Longest session with a phone, in ms. 
+#ifndef PN532_SNEP_SESSION_MS
+#define PN532_SNEP_SESSION_MS 1500
+#endif
+
+// <o> PN532_SNEP_MAX_MSG_LEN - Longest NDEF message taken from a phone, in bytes. 
+#ifndef PN532_SNEP_MAX_MSG_LEN
+#define PN532_SNEP_MAX_MSG_LEN 256
+#endif
+
+// <o> PN532_SNEP_RW - Receive window, I-PDUs the phone may send unacknowledged  <1-15> 
+#ifndef PN532_SNEP_RW
+#define PN532_SNEP_RW 4
+#endif
+
+#endif //PN532_SNEP_ENABLED
+// </e>
+
+// <e> PN532_SIM_ENABLED - pn532_sim - PN532 emulator in place of the bus backend, runs the driver benchmarks at start up (no reader needed)
+//==========================================================
+#ifndef PN532_SIM_ENABLED
+#define PN532_SIM_ENABLED 0
+#endif
+#if  PN532_SIM_ENABLED
+// <e> PN532_SIM_FAULTS_ENABLED - Inject errors from start up, rates in per mille
+//==========================================================
+#ifndef PN532_SIM_FAULTS_ENABLED
+#define PN532_SIM_FAULTS_ENABLED 0
+#endif
+#if  PN532_SIM_FAULTS_ENABLED
+// <o> PN532_SIM_FAULT_RF_TIMEOUT - Card exchanges answered with an RF timeout  <0-1000> 
+#ifndef PN532_SIM_FAULT_RF_TIMEOUT
+#define PN532_SIM_FAULT_RF_TIMEOUT 10
+#endif
+
+// <o> PN532_SIM_FAULT_RF_CRC - Card exchanges answered with a CRC error  <0-1000> 
+#ifndef PN532_SIM_FAULT_RF_CRC
+#define PN532_SIM_FAULT_RF_CRC 10
+#endif
+
+// <o> PN532_SIM_FAULT_NO_ACK - Commands lost, neither ACK nor response  <0-1000> 
+#ifndef PN532_SIM_FAULT_NO_ACK
+#define PN532_SIM_FAULT_NO_ACK 2
+#endif
+
+// <o> PN532_SIM_FAULT_BAD_DCS - Responses with a wrong data checksum  <0-1000> 
+#ifndef PN532_SIM_FAULT_BAD_DCS
+#define PN532_SIM_FAULT_BAD_DCS 2
+#endif
+
+// <o> PN532_SIM_FAULT_JITTER - Latency spread, in percent either way  <0-100> 
+#ifndef PN532_SIM_FAULT_JITTER
+#define PN532_SIM_FAULT_JITTER 20
+#endif
+
+// <o> PN532_SIM_FAULT_SEED - Seed of the pseudo random sequence 
+#ifndef PN532_SIM_FAULT_SEED
+#define PN532_SIM_FAULT_SEED 1
+#endif
+
+#endif //PN532_SIM_FAULTS_ENABLED
+// </e>
+
+#endif //PN532_SIM_ENABLED
+// </e>
+
+// <e> LOAD_GEN_ENABLED - load_gen - Synthetic taps on the PN532 emulator for soak runs, with latency percentiles
+// <i> Needs PN532_SIM and a card scan. Run with LOAD_GEN, read with LOAD_GEN, LOAD_GEN_REPORT.
+//==========================================================
+#ifndef LOAD_GEN_ENABLED
+#define LOAD_GEN_ENABLED 0
+#endif
+#if  LOAD_GEN_ENABLED
+// <o> LOAD_GEN_RATE_MIN - Lowest rate, in taps per minute <1-600> 
+#ifndef LOAD_GEN_RATE_MIN
+#define LOAD_GEN_RATE_MIN 30
+#endif
+
+// <o> LOAD_GEN_RATE_MAX - Highest rate, in taps per minute <1-600> 
+// <i> The rate sweeps from the lowest to the highest and back; the same value holds it.
+#ifndef LOAD_GEN_RATE_MAX
+#define LOAD_GEN_RATE_MAX 30
+#endif
+
+// <o> LOAD_GEN_RATE_STEP - Change of the rate per tap, in taps per minute 
+#ifndef LOAD_GEN_RATE_STEP
+#define LOAD_GEN_RATE_STEP 1
+#endif
+
+// <o> LOAD_GEN_JITTER_PCT - Spread of the gap between taps, in percent either way <0-100> 
+#ifndef LOAD_GEN_JITTER_PCT
+#define LOAD_GEN_JITTER_PCT 30
+#endif
+
+// <o> LOAD_GEN_DWELL_MS - Time a card stays in the field, in ms 
+#ifndef LOAD_GEN_DWELL_MS
+#define LOAD_GEN_DWELL_MS 800
+#endif
+
+// <o> LOAD_GEN_UIDS - Cards the taps are drawn from 
+#ifndef LOAD_GEN_UIDS
+#define LOAD_GEN_UIDS 200
+#endif
+
+// <o> LOAD_GEN_HOT_PCT - Taps of the first eighth of the cards, in percent <0-100> 
+#ifndef LOAD_GEN_HOT_PCT
+#define LOAD_GEN_HOT_PCT 60
+#endif
+
+// <o> LOAD_GEN_MIX_MFC1K - Weight of MIFARE Classic 1K cards 
+#ifndef LOAD_GEN_MIX_MFC1K
+#define LOAD_GEN_MIX_MFC1K 3
+#endif
+
+// <o> LOAD_GEN_MIX_NTAG213 - Weight of NTAG213 cards 
+#ifndef LOAD_GEN_MIX_NTAG213
+#define LOAD_GEN_MIX_NTAG213 1
+#endif
+
+// <o> LOAD_GEN_MIX_TYPE_B - Weight of ISO14443-3B cards 
+// <i> Only found by a scan that polls type B.
+#ifndef LOAD_GEN_MIX_TYPE_B
+#define LOAD_GEN_MIX_TYPE_B 0
+#endif
+
+// <o> LOAD_GEN_MIX_TOPAZ - Weight of Topaz 512 cards 
+// <i> Only found by a scan that polls Jewel.
+#ifndef LOAD_GEN_MIX_TOPAZ
+#define LOAD_GEN_MIX_TOPAZ 0
+#endif
+
+// <o> LOAD_GEN_SAMPLES - Latencies the percentiles are taken over <1-255> 
+#ifndef LOAD_GEN_SAMPLES
+#define LOAD_GEN_SAMPLES 64
+#endif
+
+// <o> LOAD_GEN_REPORT_TAPS - Taps between two report lines over the UART, 0 for none 
+#ifndef LOAD_GEN_REPORT_TAPS
+#define LOAD_GEN_REPORT_TAPS 100
+#endif
+
+// <o> LOAD_GEN_SEED - Seed of the taps and the cards 
+#ifndef LOAD_GEN_SEED
+#define LOAD_GEN_SEED 1
+#endif
+
+#endif //LOAD_GEN_ENABLED
+// </e>
+
+// <e> NUS_BENCH_ENABLED - nus_bench - NUS throughput runs with their stalls and connection events
+// <i> Needs LINK_STATS. Run with NUS_BENCH, NUS_BENCH_TX or NUS_BENCH_RX, read with NUS_BENCH_REPORT and NUS_BENCH_LINK.
+//==========================================================
+#ifndef NUS_BENCH_ENABLED
+#define NUS_BENCH_ENABLED 0
+#endif
+#if  NUS_BENCH_ENABLED
+// <o> NUS_BENCH_PARAM_WAIT_MS - Wait for the central to answer a connection interval, in ms 
+// <i> The stream starts with the parameters the link has when no answer comes.
+#ifndef NUS_BENCH_PARAM_WAIT_MS
+#define NUS_BENCH_PARAM_WAIT_MS 3000
+#endif
+
+#endif //NUS_BENCH_ENABLED
+// </e>
+
+// <e> PN532_TWIS_ENABLED - pn532_twis - The PN532 emulator behind a TWI slave, for a host on a real bus (nRF52 only, needs PN532_SIM and TWIS)
+//==========================================================
+#ifndef PN532_TWIS_ENABLED
+#define PN532_TWIS_ENABLED 0
+#endif
+#if  PN532_TWIS_ENABLED
+// <o> PN532_TWIS_INSTANCE - TWIS instance  <0-1> 
+#ifndef PN532_TWIS_INSTANCE
+#define PN532_TWIS_INSTANCE 0
+#endif
+
+// <o> PN532_TWIS_SCL_PIN - SCL pin  <0-31> 
+#ifndef PN532_TWIS_SCL_PIN
+#define PN532_TWIS_SCL_PIN 27
+#endif
+
+// <o> PN532_TWIS_SDA_PIN - SDA pin  <0-31> 
+#ifndef PN532_TWIS_SDA_PIN
+#define PN532_TWIS_SDA_PIN 26
+#endif
+
+// <o> PN532_TWIS_IRQ_PIN - IRQ output pin, low while a frame is waiting  <0-31> 
+#ifndef PN532_TWIS_IRQ_PIN
+#define PN532_TWIS_IRQ_PIN 25
+#endif
+
+// <o> PN532_TWIS_ACK_US - Delay of the ACK after a command, in us 
+#ifndef PN532_TWIS_ACK_US
+#define PN532_TWIS_ACK_US 500
+#endif
+
+#endif //PN532_TWIS_ENABLED
+// </e>
+
+// <e> UID_FILTER_ENABLED - uid_filter - Merges repeated detections of a card into one UID event
+// <i> Needs WALL_CLOCK_ENABLED.
+//==========================================================
+#ifndef UID_FILTER_ENABLED
+#define UID_FILTER_ENABLED 1
+#endif
+#if  UID_FILTER_ENABLED
+// <o> UID_FILTER_HOLDOFF_MS - Time a card must be away before it is reported again. 
+#ifndef UID_FILTER_HOLDOFF_MS
+#define UID_FILTER_HOLDOFF_MS 2000
+#endif
+
+// <o> UID_FILTER_TABLE_SIZE - Number of cards remembered, power of two. 
+#ifndef UID_FILTER_TABLE_SIZE
+#define UID_FILTER_TABLE_SIZE 8
+#endif
+
+#endif //UID_FILTER_ENABLED
+// </e>
+
+// <e> CARD_CACHE_ENABLED - card_cache - Classic blocks read in a tap session, repeated reads answered from RAM
+// <i> Needs WALL_CLOCK_ENABLED.
+//==========================================================
+#ifndef CARD_CACHE_ENABLED
+#define CARD_CACHE_ENABLED 1
+#endif
+#if  CARD_CACHE_ENABLED
+// <o> CARD_CACHE_BLOCKS - Number of 16 byte blocks kept. 
+// <i> A Classic 1K card has 47 data blocks.
+#ifndef CARD_CACHE_BLOCKS
+#define CARD_CACHE_BLOCKS 24
+#endif
+
+// <o> CARD_CACHE_SESSION_MS - Time after the card was last selected that its blocks are kept. 
+// <i> Card contents changed by another reader in this time are not seen.
+#ifndef CARD_CACHE_SESSION_MS
+#define CARD_CACHE_SESSION_MS 1500
+#endif
+
+#endif //CARD_CACHE_ENABLED
+// </e>
+
+// <e> CARD_SCRIPT_ENABLED - card_script - Card operation scripts run on the lock, one request per transaction
+// <i> Needs NUS_CMD_ENABLED.
+//==========================================================
+#ifndef CARD_SCRIPT_ENABLED
+#define CARD_SCRIPT_ENABLED 1
+#endif
+#if  CARD_SCRIPT_ENABLED
+// <o> CARD_SCRIPT_SIZE - Longest script in bytes, over all its parts <1-255> 
+#ifndef CARD_SCRIPT_SIZE
+#define CARD_SCRIPT_SIZE 128
+#endif
+
+// <o> CARD_SCRIPT_OUT_MAX - Longest result in bytes. 
+#ifndef CARD_SCRIPT_OUT_MAX
+#define CARD_SCRIPT_OUT_MAX 64
+#endif
+
+#endif //CARD_SCRIPT_ENABLED
+// </e>
+
+// <e> PN532_ISODEP_ENABLED - pn532_isodep - ISO-DEP APDU transport over InDataExchange (used by NFC_T4T_HL_DETECTION_PROCEDURES)
+//==========================================================
+#ifndef PN532_ISODEP_ENABLED
+#define PN532_ISODEP_ENABLED 1
+#endif
+#if  PN532_ISODEP_ENABLED
+// <o> PN532_ISODEP_TIMEOUT_MS - Response deadline in ms for one exchange. 
+// <i> Covers the frame waiting time extensions (S(WTX)) a card may request.
+#ifndef PN532_ISODEP_TIMEOUT_MS
+#define PN532_ISODEP_TIMEOUT_MS 5000
+#endif
+
+// <o> PN532_ISODEP_MAX_BITRATE  - Highest bit rate negotiated from the ATS with InPSL
+// <0=> 106 kbps 
+// <1=> 212 kbps 
+// <2=> 424 kbps 
+// <3=> 848 kbps 
+// <i> An exchange that fails above 106 kbps activates the card again and stays at 106 kbps.
+#ifndef PN532_ISODEP_MAX_BITRATE
+#define PN532_ISODEP_MAX_BITRATE 2
+#endif
+
+#endif //PN532_ISODEP_ENABLED
+// </e>
+
+// <q> PN532_DESFIRE_ENABLED  - pn532_desfire - MIFARE DESFire EV1 commands with AES authentication and CMAC secure messaging (needs PN532_ISODEP, NRF_CRYPTO_AES and RAND_POOL)
+ 
+
+#ifndef PN532_DESFIRE_ENABLED
+#define PN532_DESFIRE_ENABLED 0
+#endif
+
+// <q> PN532_SAM_ENABLED  - pn532_sam - APDUs to a MIFARE SAM AV2/AV3 on the S2C pins, DESFire authentication with its keys (needs PN532_ISODEP)
+ 
+
+#ifndef PN532_SAM_ENABLED
+#define PN532_SAM_ENABLED 0
+#endif
+
+// <e> PN532_NDEF_ENABLED - pn532_ndef - NDEF read and write pipeline for Type 2 Tags and MIFARE Classic (needs PN532_T2T, the NDEF parsers and encoders)
+//==========================================================
+#ifndef PN532_NDEF_ENABLED
+#define PN532_NDEF_ENABLED 1
+#endif
+#if  PN532_NDEF_ENABLED
+// <o> PN532_NDEF_MAX_MSG_LEN - Largest NDEF message read from or written to a tag. 
+// <i> Size of the static buffer that record descriptors point into; the writer encodes its TLV stream here too.
+#ifndef PN532_NDEF_MAX_MSG_LEN
+#define PN532_NDEF_MAX_MSG_LEN 256
+#endif
+
+// <o> PN532_NDEF_MAX_RECORDS - Maximum number of records in a message. 
+#ifndef PN532_NDEF_MAX_RECORDS
+#define PN532_NDEF_MAX_RECORDS 4
+#endif
+
+#endif //PN532_NDEF_ENABLED
+// </e>
+
+// <e> MFC_KEYS_ENABLED - mfc_keys - MIFARE Classic key dictionary with per-card key cache (needs FDS)
+//==========================================================
+#ifndef MFC_KEYS_ENABLED
+#define MFC_KEYS_ENABLED 1
+#endif
+#if  MFC_KEYS_ENABLED
+// <o> MFC_KEYS_DICT_SIZE - Maximum number of keys, site keys plus the 4 built-in keys. <4-254> 
+#ifndef MFC_KEYS_DICT_SIZE
+#define MFC_KEYS_DICT_SIZE 16
+#endif
+
+// <o> MFC_KEYS_CACHE_SIZE - Number of cards whose working keys are remembered. 
+// <i> Each card takes 8 bytes plus three bytes per tracked sector (key and access bits), in RAM and in flash.
+#ifndef MFC_KEYS_CACHE_SIZE
+#define MFC_KEYS_CACHE_SIZE 8
+#endif
+
+// <o> MFC_KEYS_SECTOR_COUNT - Sectors tracked per card, must be a multiple of 4. 
+// <i> 16 covers a Classic 1K. Sectors beyond this are authenticated from the dictionary each time.
+#ifndef MFC_KEYS_SECTOR_COUNT
+#define MFC_KEYS_SECTOR_COUNT 16
+#endif
+
+// <o> MFC_KEYS_FILE_ID - FDS file ID of the key cache record <0x0000-0xBFFF> 
+#ifndef MFC_KEYS_FILE_ID
+#define MFC_KEYS_FILE_ID 0x4D4B
+#endif
+
+// <o> MFC_KEYS_RECORD_KEY - FDS record key of the key cache record <0x0001-0xBFFF> 
+#ifndef MFC_KEYS_RECORD_KEY
+#define MFC_KEYS_RECORD_KEY 0x0001
+#endif
+
+#endif //MFC_KEYS_ENABLED
+// </e>
+
+// <q> MFC_KDF_ENABLED  - mfc_kdf - MIFARE keys diversified from a site master key and the UID (AN10922 AES-128)
+// <i> Needs NRF_CRYPTO_AES_ENABLED and MFC_KEYS_ENABLED. The application defines MFC_KDF_MASTER_KEY, the AES-128
+// <i> master key, MFC_KDF_SYSTEM_ID, the system identifier of the site, and MFC_KDF_KEY_TYPE, 0 for key A or 1 for key B.
+ 
+
+#ifndef MFC_KDF_ENABLED
+#define MFC_KDF_ENABLED 0
+#endif
+
+// <e> NTAG_AUTH_ENABLED - ntag_auth - NTAG21x originality signature and PWD_AUTH before access
+// <i> Needs ECC_ENABLED, built with the micro-ecc library; the passwords need MFC_KDF_ENABLED.
+//==========================================================
+#ifndef NTAG_AUTH_ENABLED
+#define NTAG_AUTH_ENABLED 0
+#endif
+#if  NTAG_AUTH_ENABLED
+// <o> NTAG_AUTH_CACHE_SIZE - UIDs whose signature check is remembered <1-64> 
+// <i> 8 bytes of RAM each; the least recently seen one is dropped.
+#ifndef NTAG_AUTH_CACHE_SIZE
+#define NTAG_AUTH_CACHE_SIZE 16
+#endif
+
+#endif //NTAG_AUTH_ENABLED
+// </e>
+
+// <e> NUS_TX_ENABLED - nus_tx - Queued and packed NUS notifications
+//==========================================================
+#ifndef NUS_TX_ENABLED
+#define NUS_TX_ENABLED 1
+#endif
+#if  NUS_TX_ENABLED
+// <o> NUS_TX_QUEUE_SIZE - Notifications held while the SoftDevice TX buffers are full. <2-255>  
+// <i> Costs 21 bytes of RAM each; 24 slots take a 12-block card read batch with room to spare.
+#ifndef NUS_TX_QUEUE_SIZE
+#define NUS_TX_QUEUE_SIZE 24
+#endif
+#endif //NUS_TX_ENABLED
+// </e>
+
+// <e> LINK_STATS_ENABLED - link_stats - Per-link TX buffer, queue and retransmit counters
+// <i> nus_tx feeds the counters; link_stats_get() reads them.
+//==========================================================
+#ifndef LINK_STATS_ENABLED
+#define LINK_STATS_ENABLED 1
+#endif
+#if  LINK_STATS_ENABLED
+// <q> LINK_STATS_GATT  - Diagnostic service on the NUS base, UUID 0x0010, record characteristic 0x0011
+ 
+
+#ifndef LINK_STATS_GATT
+#define LINK_STATS_GATT 1
+#endif
+
+// <o> LINK_STATS_STALL_INTERVALS - Connection intervals an acknowledgement may take before it counts as a stall <1-16> 
+// <i> A packet the peer missed goes again in the next connection event; 2 leaves room for one.
+#ifndef LINK_STATS_STALL_INTERVALS
+#define LINK_STATS_STALL_INTERVALS 2
+#endif
+
+#endif //LINK_STATS_ENABLED
+// </e>
+
+// <e> LOG_NUS_ENABLED - log_nus - nrf_log streamed over BLE with credits and per-module filters
+// <i> Service 0x0012 on the NUS base. Needs NRF_LOG_ENABLED, NRF_LOG_DEFERRED and NRF_LOG_BACKEND_SERIAL_BINARY.
+//==========================================================
+#ifndef LOG_NUS_ENABLED
+#define LOG_NUS_ENABLED 0
+#endif
+#if  LOG_NUS_ENABLED
+// <o> LOG_NUS_BUF_SIZE - Frames waiting for credits, in bytes <128=> 128 <256=> 256 <512=> 512 
+#ifndef LOG_NUS_BUF_SIZE
+#define LOG_NUS_BUF_SIZE 256
+#endif
+
+// <o> LOG_NUS_KEEP_LEVEL - Least severe level that waits for room instead of being dropped
+ 
+// <1=> Error 
+// <2=> Warning 
+// <3=> Info 
+// <4=> Debug 
+
+#ifndef LOG_NUS_KEEP_LEVEL
+#define LOG_NUS_KEEP_LEVEL 2
+#endif
+
+// <o> LOG_NUS_DEFAULT_LEVEL - Level streamed for modules without a filter, until the host sets it
+ 
+// <0=> Off 
+// <1=> Error 
+// <2=> Warning 
+// <3=> Info 
+// <4=> Debug 
+
+#ifndef LOG_NUS_DEFAULT_LEVEL
+#define LOG_NUS_DEFAULT_LEVEL 3
+#endif
+
+// <o> LOG_NUS_FILTERS - Modules with a filter of their own <1-16> 
+#ifndef LOG_NUS_FILTERS
+#define LOG_NUS_FILTERS 4
+#endif
+
+// <o> LOG_NUS_BATCH - Entries turned into frames per pass of the main loop <1-32> 
+#ifndef LOG_NUS_BATCH
+#define LOG_NUS_BATCH 8
+#endif
+
+#endif //LOG_NUS_ENABLED
+// </e>
+
+// <e> NUS_RX_ENABLED - nus_rx - Credit based flow control of NUS writes
+// <i> Service 0x0015 on the NUS base. Writes of links that subscribe to its credits are pooled and run from the main loop.
+//==========================================================
+#ifndef NUS_RX_ENABLED
+#define NUS_RX_ENABLED 0
+#endif
+#if  NUS_RX_ENABLED
+// <o> NUS_RX_BUFS - Buffers of the pool, shared by the links <4=> 4 <8=> 8 <16=> 16 <32=> 32 
+#ifndef NUS_RX_BUFS
+#define NUS_RX_BUFS 8
+#endif
+
+// <o> NUS_RX_LINK_CREDITS - Writes a link may have in the pool <1-16> 
+// <i> Times BLE_NUS_LINK_COUNT, at most NUS_RX_BUFS.
+#ifndef NUS_RX_LINK_CREDITS
+#define NUS_RX_LINK_CREDITS 4
+#endif
+
+// <o> NUS_RX_BATCH - Writes handled per pass of the main loop <1-32> 
+#ifndef NUS_RX_BATCH
+#define NUS_RX_BATCH 4
+#endif
+
+#endif //NUS_RX_ENABLED
+// </e>
+
+// <e> NUS_CMD_ENABLED - nus_cmd - Framed NUS commands with request ids (needs NUS_TX)
+//==========================================================
+#ifndef NUS_CMD_ENABLED
+#define NUS_CMD_ENABLED 1
+#endif
+#if  NUS_CMD_ENABLED
+// <o> NUS_CMD_QUEUE_SIZE - Requests the phone can have in flight.  
+// <i> Costs 35 bytes of RAM each.
+#ifndef NUS_CMD_QUEUE_SIZE
+#define NUS_CMD_QUEUE_SIZE 4
+#endif
+
+#endif //NUS_CMD_ENABLED
+// </e>
+
+// <q> NUS_PB_ENABLED  - nus_pb - Card answers as length-delimited nanopb records (needs NUS_TX)
+// <i> Replaces the raw UID and block bytes with NusResponse records (nus_response.proto).
+ 
+
+#ifndef NUS_PB_ENABLED
+#define NUS_PB_ENABLED 0
+#endif
+
+// <e> NUS_QWR_ENABLED - nus_qwr - Long writes of the NUS characteristic (needs NRF_BLE_QWR)
+//==========================================================
+#ifndef NUS_QWR_ENABLED
+#define NUS_QWR_ENABLED 1
+#endif
+#if  NUS_QWR_ENABLED
+// <o> NUS_QWR_MEM_SIZE - Prepared writes buffer of each link, in bytes <64-2048>
+// <i> Each prepared write takes 6 bytes over its data: with a 23 byte ATT MTU, 512 bytes
+// <i> hold 21 writes of 18 bytes, a long write of 378 bytes.
+#ifndef NUS_QWR_MEM_SIZE
+#define NUS_QWR_MEM_SIZE 512
+#endif
+
+#endif //NUS_QWR_ENABLED
+// </e>
+
+// <e> CONN_POLICY_ENABLED - conn_policy - Fast connection interval during transfers, slave latency when idle
+//==========================================================
+#ifndef CONN_POLICY_ENABLED
+#define CONN_POLICY_ENABLED 1
+#endif
+#if  CONN_POLICY_ENABLED
+// <o> CONN_POLICY_FAST_MIN_INTERVAL - Minimum interval while busy (1.25 ms units) <6-3200>
+#ifndef CONN_POLICY_FAST_MIN_INTERVAL
+#define CONN_POLICY_FAST_MIN_INTERVAL 6
+#endif
+
+// <o> CONN_POLICY_FAST_MAX_INTERVAL - Maximum interval while busy (1.25 ms units) <6-3200>
+// <i> iOS centrals want a range of 15 ms and more; they keep their interval otherwise.
+#ifndef CONN_POLICY_FAST_MAX_INTERVAL
+#define CONN_POLICY_FAST_MAX_INTERVAL 12
+#endif
+
+// <o> CONN_POLICY_IDLE_MIN_INTERVAL - Minimum interval when idle (1.25 ms units) <6-3200>
+// <i> Above CONN_POLICY_FAST_MAX_INTERVAL, so ble_conn_params renegotiates.
+#ifndef CONN_POLICY_IDLE_MIN_INTERVAL
+#define CONN_POLICY_IDLE_MIN_INTERVAL 60
+#endif
+
+// <o> CONN_POLICY_IDLE_MAX_INTERVAL - Maximum interval when idle (1.25 ms units) <6-3200>
+#ifndef CONN_POLICY_IDLE_MAX_INTERVAL
+#define CONN_POLICY_IDLE_MAX_INTERVAL 80
+#endif
+
+// <o> CONN_POLICY_IDLE_LATENCY - Connection events the peripheral may skip when idle <0-499>
+// <i> Keep (1 + latency) * max interval * 2 below the 4 s supervision timeout.
+#ifndef CONN_POLICY_IDLE_LATENCY
+#define CONN_POLICY_IDLE_LATENCY 4
+#endif
+
+// <o> CONN_POLICY_IDLE_DELAY_MS - Time after connecting or the last transfer before going idle
+#ifndef CONN_POLICY_IDLE_DELAY_MS
+#define CONN_POLICY_IDLE_DELAY_MS 2000
+#endif
+
+#endif //CONN_POLICY_ENABLED
+// </e>
+
+// <e> HID_WEDGE_ENABLED - hid_wedge - BLE keyboard that types the UID or NDEF text of each tap (needs BLE_HIDS, PEER_BOND)
+// <i> The HID service takes about 30 attributes of the GATT table next to NUS.
+//==========================================================
+#ifndef HID_WEDGE_ENABLED
+#define HID_WEDGE_ENABLED 0
+#endif
+#if  HID_WEDGE_ENABLED
+// <o> HID_WEDGE_QUEUE_SIZE - Keys waiting to be typed, a power of two <16-256>
+#ifndef HID_WEDGE_QUEUE_SIZE
+#define HID_WEDGE_QUEUE_SIZE 64
+#endif
+
+// <q> HID_WEDGE_ENTER  - Press Enter after each UID or text
+ 
+
+#ifndef HID_WEDGE_ENTER
+#define HID_WEDGE_ENTER 1
+#endif
+
+// <q> HID_WEDGE_NDEF_TEXT  - Type the first Text record of a Type 2 Tag in place of its UID
+// <i> Costs the reads of the NDEF message on every tap of such a tag.
+
+#ifndef HID_WEDGE_NDEF_TEXT
+#define HID_WEDGE_NDEF_TEXT 0
+#endif
+
+#endif //HID_WEDGE_ENABLED
+// </e>
+
+// <e> ADV_SCHED_ENABLED - adv_sched - Fast advertising after a tap or disconnect, slow otherwise
+//==========================================================
+#ifndef ADV_SCHED_ENABLED
+#define ADV_SCHED_ENABLED 1
+#endif
+#if  ADV_SCHED_ENABLED
+// <o> ADV_SCHED_FAST_TIMEOUT - Seconds of fast advertising (APP_ADV_INTERVAL) <1-180>
+#ifndef ADV_SCHED_FAST_TIMEOUT
+#define ADV_SCHED_FAST_TIMEOUT 30
+#endif
+
+// <o> ADV_SCHED_SLOW_INTERVAL - Advertising interval after that (0.625 ms units) <32-16384>
+// <i> 874 is 546.25 ms, one of the intervals iOS recommends.
+#ifndef ADV_SCHED_SLOW_INTERVAL
+#define ADV_SCHED_SLOW_INTERVAL 874
+#endif
+
+// <o> ADV_SCHED_SLOW_TIMEOUT - Seconds of slow advertising before system off
+// <i> 0 for mains-powered units: never system off.
+#ifndef ADV_SCHED_SLOW_TIMEOUT
+#define ADV_SCHED_SLOW_TIMEOUT 0
+#endif
+
+// <q> ADV_SCHED_NFC_WAKE  - Wake from system off on the field of a phone at the PN532
+// <i> Puts the PN532 in PowerDown with its RF level detector; cards have no field of their own.
+
+#ifndef ADV_SCHED_NFC_WAKE
+#define ADV_SCHED_NFC_WAKE 1
+#endif
+
+#endif //ADV_SCHED_ENABLED
+// </e>
+
+// <e> TAP_BEACON_ENABLED - tap_beacon - Last taps in the manufacturer specific advertising data
+// <i> Scanners see the taps while the lock advertises: use ADV_SCHED with ADV_SCHED_SLOW_TIMEOUT 0.
+//==========================================================
+#ifndef TAP_BEACON_ENABLED
+#define TAP_BEACON_ENABLED 0
+#endif
+#if  TAP_BEACON_ENABLED
+// <o> TAP_BEACON_EVENTS - Taps advertised <1-3>
+// <i> Three fit next to the flags and an 8-character name.
+#ifndef TAP_BEACON_EVENTS
+#define TAP_BEACON_EVENTS 3
+#endif
+
+// <o> TAP_BEACON_COMPANY_ID - Company identifier of the manufacturer specific data
+// <i> 0xFFFF is reserved for tests; products use their own identifier.
+#ifndef TAP_BEACON_COMPANY_ID
+#define TAP_BEACON_COMPANY_ID 0xFFFF
+#endif
+
+// <o> TAP_BEACON_REFRESH_S - Seconds between updates of the tap ages <1-255>
+#ifndef TAP_BEACON_REFRESH_S
+#define TAP_BEACON_REFRESH_S 5
+#endif
+
+#endif //TAP_BEACON_ENABLED
+// </e>
+
+// <e> READER_TLM_ENABLED - reader_tlm - Reader health in an Eddystone TLM frame, interleaved with the advertising data
+// <i> Frame version 0x80: battery, taps per minute, tap latency, RF error rate, journal fill, uptime.
+//==========================================================
+#ifndef READER_TLM_ENABLED
+#define READER_TLM_ENABLED 1
+#endif
+#if  READER_TLM_ENABLED
+// <o> READER_TLM_PERIOD_S - Seconds from one frame to the next, which the rates cover <10-255>
+#ifndef READER_TLM_PERIOD_S
+#define READER_TLM_PERIOD_S 60
+#endif
+
+// <o> READER_TLM_SHOW_MS - Time the frame replaces the advertising data, in ms 
+// <i> At least two advertising intervals of the slow mode, ADV_SCHED_SLOW_INTERVAL.
+#ifndef READER_TLM_SHOW_MS
+#define READER_TLM_SHOW_MS 1200
+#endif
+
+#endif //READER_TLM_ENABLED
+// </e>
+
+// <e> PASSBACK_ENABLED - passback - Anti-passback shared between the readers of a site in signed advertising frames
+// <i> Needs NRF_CRYPTO_AES_ENABLED and WALL_CLOCK_ENABLED, and a whitelist to decide with. The application
+// <i> defines PASSBACK_KEY, the AES-128 key the frames of the site are signed with.
+//==========================================================
+#ifndef PASSBACK_ENABLED
+#define PASSBACK_ENABLED 0
+#endif
+#if  PASSBACK_ENABLED
+// <o> PASSBACK_DIRECTION - What a grant at this reader means
+// <0=> Entry 
+// <1=> Exit 
+#ifndef PASSBACK_DIRECTION
+#define PASSBACK_DIRECTION 0
+#endif
+
+// <o> PASSBACK_SITE_ID - Site of the reader; frames of other sites are ignored <0-255> 
+#ifndef PASSBACK_SITE_ID
+#define PASSBACK_SITE_ID 0
+#endif
+
+// <o> PASSBACK_COMPANY_ID - Company identifier of the manufacturer specific data
+// <i> 0xFFFF is reserved for tests; products use their own identifier.
+#ifndef PASSBACK_COMPANY_ID
+#define PASSBACK_COMPANY_ID 0xFFFF
+#endif
+
+// <o> PASSBACK_TABLE_SIZE - Cards whose state is kept <1-255> 
+// <i> 12 bytes of RAM each; the least recently changed one is dropped.
+#ifndef PASSBACK_TABLE_SIZE
+#define PASSBACK_TABLE_SIZE 32
+#endif
+
+// <o> PASSBACK_PEERS - Readers whose last frame is remembered <1-32> 
+#ifndef PASSBACK_PEERS
+#define PASSBACK_PEERS 8
+#endif
+
+// <o> PASSBACK_FORGET_MIN - Minutes after which a state no longer refuses a card 
+#ifndef PASSBACK_FORGET_MIN
+#define PASSBACK_FORGET_MIN 720
+#endif
+
+// <o> PASSBACK_MAX_SKEW_S - Largest difference between the clocks of two readers, in s 
+// <i> Frames further off are dropped, so an old frame sent again is too.
+#ifndef PASSBACK_MAX_SKEW_S
+#define PASSBACK_MAX_SKEW_S 120
+#endif
+
+// <o> PASSBACK_SHOW_MS - Time a frame replaces the advertising data, in ms 
+// <i> At least two advertising intervals of the slow mode, ADV_SCHED_SLOW_INTERVAL.
+#ifndef PASSBACK_SHOW_MS
+#define PASSBACK_SHOW_MS 1500
+#endif
+
+// <o> PASSBACK_SCAN_INTERVAL_MS - Scan interval, in ms <3-10240> 
+#ifndef PASSBACK_SCAN_INTERVAL_MS
+#define PASSBACK_SCAN_INTERVAL_MS 500
+#endif
+
+// <o> PASSBACK_SCAN_WINDOW_MS - Scan window, in ms <3-10240> 
+// <i> The radio listens this long every interval: the main cost of the module.
+#ifndef PASSBACK_SCAN_WINDOW_MS
+#define PASSBACK_SCAN_WINDOW_MS 50
+#endif
+
+// <o> PASSBACK_SCAN_RETRY_S - Seconds between attempts to start the scan again <1-255> 
+// <i> After a connection of gw_push, which the SoftDevice cannot make while scanning.
+#ifndef PASSBACK_SCAN_RETRY_S
+#define PASSBACK_SCAN_RETRY_S 10
+#endif
+
+#endif //PASSBACK_ENABLED
+// </e>
+
+// <e> PEER_BOND_ENABLED - peer_bond - Bonding and directed advertising through the Peer Manager
+// <i> Needs PEER_MANAGER_ENABLED; the bonds are stored in FDS.
+//==========================================================
+#ifndef PEER_BOND_ENABLED
+#define PEER_BOND_ENABLED 1
+#endif
+#if  PEER_BOND_ENABLED
+// <q> PEER_BOND_SEC_REQUEST  - Ask the phone to secure the link when it connects
+ 
+
+#ifndef PEER_BOND_SEC_REQUEST
+#define PEER_BOND_SEC_REQUEST 1
+#endif
+
+// <q> PEER_BOND_WHITELIST  - Only bonded phones connect once there are any
+// <i> A new phone then needs ble_advertising_restart_without_whitelist(); this board has no button for it.
+
+#ifndef PEER_BOND_WHITELIST
+#define PEER_BOND_WHITELIST 0
+#endif
+
+#endif //PEER_BOND_ENABLED
+// </e>
+
+// <e> GW_PUSH_ENABLED - gw_push - Journal pushed to a fixed gateway over a central link
+// <i> Needs LOCK_JOURNAL_ENABLED, BLE_DB_DISCOVERY_ENABLED and BLE_NUS_C_ENABLED, and the RAM of a central link.
+//==========================================================
+#ifndef GW_PUSH_ENABLED
+#define GW_PUSH_ENABLED 0
+#endif
+#if  GW_PUSH_ENABLED
+// <o> GW_PUSH_ADDR_TYPE  - Gateway address type
+ 
+// <0=> Public 
+// <1=> Random static 
+
+#ifndef GW_PUSH_ADDR_TYPE
+#define GW_PUSH_ADDR_TYPE 1
+#endif
+
+// <o> GW_PUSH_ADDR_HIGH - Gateway address, upper two bytes  
+// <i> A random static address has the two top bits set.
+#ifndef GW_PUSH_ADDR_HIGH
+#define GW_PUSH_ADDR_HIGH 0xC000
+#endif
+
+// <o> GW_PUSH_ADDR_LOW - Gateway address, lower four bytes  
+#ifndef GW_PUSH_ADDR_LOW
+#define GW_PUSH_ADDR_LOW 0x00000001
+#endif
+
+// <o> GW_PUSH_INTERVAL_S - Seconds between pushes of the new entries <1-3600>
+// <i> Entries collected in an interval go out in one connection.
+#ifndef GW_PUSH_INTERVAL_S
+#define GW_PUSH_INTERVAL_S 60
+#endif
+
+// <o> GW_PUSH_SCAN_TIMEOUT_S - Seconds to look for the gateway <1-60>
+#ifndef GW_PUSH_SCAN_TIMEOUT_S
+#define GW_PUSH_SCAN_TIMEOUT_S 5
+#endif
+
+// <o> GW_PUSH_LINK_TIMEOUT_MS - Gateway link dropped after this long without progress, in ms  
+#ifndef GW_PUSH_LINK_TIMEOUT_MS
+#define GW_PUSH_LINK_TIMEOUT_MS 3000
+#endif
+
+// <o> GW_PUSH_FILE_ID - FDS file ID of the gateway record <0x0000-0xBFFF> 
+#ifndef GW_PUSH_FILE_ID
+#define GW_PUSH_FILE_ID 0x4757
+#endif
+
+// <o> GW_PUSH_RECORD_KEY - FDS record key of the gateway record <0x0001-0xBFFF> 
+#ifndef GW_PUSH_RECORD_KEY
+#define GW_PUSH_RECORD_KEY 0x0001
+#endif
+
+#endif //GW_PUSH_ENABLED
+// </e>
+
+// <q> CMD_RING_ENABLED  - cmd_ring - Lock-free ring handing raw NUS/UART commands to the main loop
+ 
+
+#ifndef CMD_RING_ENABLED
+#define CMD_RING_ENABLED 1
+#endif
+
+// <e> LAT_TRACE_ENABLED - lat_trace - Per-stage latency trace of the card commands, read with TRACE_READ
+//==========================================================
+#ifndef LAT_TRACE_ENABLED
+#define LAT_TRACE_ENABLED 1
+#endif
+#if  LAT_TRACE_ENABLED
+// <o> LAT_TRACE_RING_SIZE - Number of stage records kept. 
+// <i> Each record takes 8 bytes of RAM.
+#ifndef LAT_TRACE_RING_SIZE
+#define LAT_TRACE_RING_SIZE 32
+#endif
+
+#endif //LAT_TRACE_ENABLED
+// </e>
+
+// <e> LOCK_MOTO_ENABLED - lock_moto - Timed lock motor driver (MOTO_EN1/EN2/NSLEEP/NFAULT)
+//==========================================================
+#ifndef LOCK_MOTO_ENABLED
+#define LOCK_MOTO_ENABLED 1
+#endif
+#if  LOCK_MOTO_ENABLED
+// <o> LOCK_MOTO_WAKE_MS - Driver wake-up time after NSLEEP goes high, added to the drive time.  
+#ifndef LOCK_MOTO_WAKE_MS
+#define LOCK_MOTO_WAKE_MS 1
+#endif
+
+// <o> LOCK_MOTO_DRIVE_MS - Time the motor is driven to move the bolt.  
+#ifndef LOCK_MOTO_DRIVE_MS
+#define LOCK_MOTO_DRIVE_MS 150
+#endif
+
+// <o> LOCK_MOTO_BRAKE_MS - Time the motor is shorted after driving.  
+#ifndef LOCK_MOTO_BRAKE_MS
+#define LOCK_MOTO_BRAKE_MS 30
+#endif
+
+// <o> LOCK_MOTO_COAST_MS - Time with the outputs floating before the driver sleeps.  
+#ifndef LOCK_MOTO_COAST_MS
+#define LOCK_MOTO_COAST_MS 20
+#endif
+
+// <o> LOCK_MOTO_HOLD_MS - Time the lock stays open.  
+#ifndef LOCK_MOTO_HOLD_MS
+#define LOCK_MOTO_HOLD_MS 3000
+#endif
+
+// <o> LOCK_MOTO_RELOCK_MS - Time from lock_moto_hold(false) to the bolt being driven back.  
+// <i> Lets a door that was pushed shut settle on its strike first.
+#ifndef LOCK_MOTO_RELOCK_MS
+#define LOCK_MOTO_RELOCK_MS 1000
+#endif
+
+#endif //LOCK_MOTO_ENABLED
+// </e>
+
+// <e> MOTO_SENSE_ENABLED - moto_sense - End of travel of the lock motor from its stall current
+// <i> Needs LOCK_MOTO_ENABLED. nRF51: runs LPCOMP, LPCOMP_ENABLED must be 0. nRF52: runs SAADC and TIMER3
+// <i> over PPI, SAADC_ENABLED and TIMER3_ENABLED must be 0 and PPI_ENABLED 1.
+//==========================================================
+#ifndef MOTO_SENSE_ENABLED
+#define MOTO_SENSE_ENABLED 0
+#endif
+#if  MOTO_SENSE_ENABLED
+// <o> MOTO_SENSE_AIN - Analog input of the shunt of the bridge <0-7> 
+// <i> AIN0..AIN7 are P0.26, P0.27, P0.01..P0.06 on the nRF51. AIN6 is the pad of PROX_WAKE on boards that have one.
+#ifndef MOTO_SENSE_AIN
+#define MOTO_SENSE_AIN 6
+#endif
+
+// <o> MOTO_SENSE_LPCOMP_REF - Stall level on the nRF51, of VDD
+ 
+// <0=> 1/8 
+// <1=> 2/8 
+// <2=> 3/8 
+// <3=> 4/8 
+// <4=> 5/8 
+// <5=> 6/8 
+// <6=> 7/8 
+
+#ifndef MOTO_SENSE_LPCOMP_REF
+#define MOTO_SENSE_LPCOMP_REF 0
+#endif
+
+// <o> MOTO_SENSE_STALL_MV - Stall level on the nRF52, in mV on the shunt <10-3000> 
+#ifndef MOTO_SENSE_STALL_MV
+#define MOTO_SENSE_STALL_MV 300
+#endif
+
+// <o> MOTO_SENSE_RATE_HZ - Samples per second on the nRF52 <100-10000> 
+#ifndef MOTO_SENSE_RATE_HZ
+#define MOTO_SENSE_RATE_HZ 2000
+#endif
+
+// <o> MOTO_SENSE_BLANK_MS - Time after the start of a drive the inrush is not taken for a stall 
+#ifndef MOTO_SENSE_BLANK_MS
+#define MOTO_SENSE_BLANK_MS 30
+#endif
+
+#endif //MOTO_SENSE_ENABLED
+// </e>
+
+// <q> LOCK_STATE_ENABLED  - lock_state - Locked, unlocking, open, relocking from the bolt and the INPUT_SR door contact
+ 
+// <i> Needs LOCK_MOTO_ENABLED and PORT_SENSE_ENABLED. While the door stands open the bolt is held back,
+// <i> pn532_duty is paused and adv_sched stays in the slow stage.
+
+#ifndef LOCK_STATE_ENABLED
+#define LOCK_STATE_ENABLED 1
+#endif
+
+// <e> MX25_CACHE_ENABLED - MX25L16 read cache - LRU cache of flash pages in RAM
+//==========================================================
+#ifndef MX25_CACHE_ENABLED
+#define MX25_CACHE_ENABLED 1
+#endif
+#if  MX25_CACHE_ENABLED
+// <o> MX25_CACHE_PAGES - Number of cached pages.  
+// <i> Costs MX25_CACHE_PAGE_SIZE bytes of RAM per page.
+#ifndef MX25_CACHE_PAGES
+#define MX25_CACHE_PAGES 4
+#endif
+
+// <o> MX25_CACHE_PAGE_SIZE - Cached page size, a power of two.  
+#ifndef MX25_CACHE_PAGE_SIZE
+#define MX25_CACHE_PAGE_SIZE 256
+#endif
+#endif //MX25_CACHE_ENABLED
+// </e>
+
+// <e> MX25_POWER_ENABLED - MX25L16 idle deep power-down, woken on the next access
+//==========================================================
+#ifndef MX25_POWER_ENABLED
+#define MX25_POWER_ENABLED 1
+#endif
+#if  MX25_POWER_ENABLED
+// <o> MX25_POWER_IDLE_MS - Time without access after which the chip enters deep power-down.  
+#ifndef MX25_POWER_IDLE_MS
+#define MX25_POWER_IDLE_MS 50
+#endif
+
+#endif //MX25_POWER_ENABLED
+// </e>
+
+// <e> MX25_QSPI_ENABLED - flash_io - MX25 on the QSPI of the nRF52840 instead of spi_bus
+// <i> Quad reads and programs, erases left running, reads in place for mx25lxx_read_page_cached(). Needs QSPI_ENABLED.
+//==========================================================
+#ifndef MX25_QSPI_ENABLED
+#define MX25_QSPI_ENABLED 0
+#endif
+#if  MX25_QSPI_ENABLED
+// <o> MX25_QSPI_SCK_PIN - SCK pin. 
+#ifndef MX25_QSPI_SCK_PIN
+#define MX25_QSPI_SCK_PIN 19
+#endif
+
+// <o> MX25_QSPI_CSN_PIN - CSN pin. 
+#ifndef MX25_QSPI_CSN_PIN
+#define MX25_QSPI_CSN_PIN 17
+#endif
+
+// <o> MX25_QSPI_IO0_PIN - IO0 pin. 
+#ifndef MX25_QSPI_IO0_PIN
+#define MX25_QSPI_IO0_PIN 20
+#endif
+
+// <o> MX25_QSPI_IO1_PIN - IO1 pin. 
+#ifndef MX25_QSPI_IO1_PIN
+#define MX25_QSPI_IO1_PIN 21
+#endif
+
+// <o> MX25_QSPI_IO2_PIN - IO2 pin. 
+#ifndef MX25_QSPI_IO2_PIN
+#define MX25_QSPI_IO2_PIN 22
+#endif
+
+// <o> MX25_QSPI_IO3_PIN - IO3 pin. 
+#ifndef MX25_QSPI_IO3_PIN
+#define MX25_QSPI_IO3_PIN 23
+#endif
+
+// <o> MX25_QSPI_FREQUENCY  - SCK frequency
+ 
+// <0=> 32 MHz 
+// <1=> 16 MHz 
+// <3=> 8 MHz 
+
+#ifndef MX25_QSPI_FREQUENCY
+#define MX25_QSPI_FREQUENCY 1
+#endif
+
+// <o> MX25_QSPI_IRQ_PRIORITY  - Priority of the QSPI interrupt and the read callbacks
+ 
+// <1=> 1 
+// <3=> 3 
+
+#ifndef MX25_QSPI_IRQ_PRIORITY
+#define MX25_QSPI_IRQ_PRIORITY 3
+#endif
+
+#endif //MX25_QSPI_ENABLED
+// </e>
+
+// <e> MX25_ASYNC_ENABLED - mx25_async - Queued MX25L16 erase/program with app_timer status polling
+//==========================================================
+#ifndef MX25_ASYNC_ENABLED
+#define MX25_ASYNC_ENABLED 1
+#endif
+#if  MX25_ASYNC_ENABLED
+// <o> MX25_ASYNC_QUEUE_SIZE - Erase and program jobs that can be queued.  
+#ifndef MX25_ASYNC_QUEUE_SIZE
+#define MX25_ASYNC_QUEUE_SIZE 6
+#endif
+
+// <o> MX25_ASYNC_ERASE_POLL_MS - Status poll interval while a sector erase runs.  
+#ifndef MX25_ASYNC_ERASE_POLL_MS
+#define MX25_ASYNC_ERASE_POLL_MS 10
+#endif
+
+// <o> MX25_ASYNC_PROGRAM_POLL_MS - Status poll interval while a page program runs.  
+#ifndef MX25_ASYNC_PROGRAM_POLL_MS
+#define MX25_ASYNC_PROGRAM_POLL_MS 1
+#endif
+
+// <o> MX25_ASYNC_TIMEOUT_MS - Time after which a job that keeps the chip busy fails.  
+#ifndef MX25_ASYNC_TIMEOUT_MS
+#define MX25_ASYNC_TIMEOUT_MS 1000
+#endif
+
+#endif //MX25_ASYNC_ENABLED
+// </e>
+
+// <e> MX25_HASH_ENABLED - mx25_hash - SHA-256 of MX25L16 regions with double buffered background reads
+//==========================================================
+#ifndef MX25_HASH_ENABLED
+#define MX25_HASH_ENABLED 0
+#endif
+#if  MX25_HASH_ENABLED
+// <o> MX25_HASH_CHUNK_SIZE - Bytes read per part, a multiple of 64.  
+// <i> Costs twice this much RAM.
+#ifndef MX25_HASH_CHUNK_SIZE
+#define MX25_HASH_CHUNK_SIZE 256
+#endif
+#endif //MX25_HASH_ENABLED
+// </e>
+
+// <e> HF_CLOCK_ENABLED - hf_clock - 16 MHz crystal only while a PN532 on HSU is awake or a bench runs
+// <i> Needs CLOCK_ENABLED. With the PN532 on TWI or SPI only the bench asks for the crystal.
+//==========================================================
+#ifndef HF_CLOCK_ENABLED
+#define HF_CLOCK_ENABLED 0
+#endif
+#if  HF_CLOCK_ENABLED
+// <o> HF_CLOCK_LINGER_MS - Time the crystal keeps running after the last release, in ms 
+// <i> Longer than the gaps of a burst, shorter than the sleep between bursts.
+#ifndef HF_CLOCK_LINGER_MS
+#define HF_CLOCK_LINGER_MS 20
+#endif
+
+#endif //HF_CLOCK_ENABLED
+// </e>
+
+// <e> WALL_CLOCK_ENABLED - wall_clock - Wall-clock time from RTC1, set by the phone (TIME_SET or CTS)
+//==========================================================
+#ifndef WALL_CLOCK_ENABLED
+#define WALL_CLOCK_ENABLED 1
+#endif
+#if  WALL_CLOCK_ENABLED
+// <o> WALL_CLOCK_FOLD_S - Interval of the timer that extends the 24-bit RTC counter, in seconds. 
+// <i> Below half the counter period: 256 s at prescaler 0.
+#ifndef WALL_CLOCK_FOLD_S
+#define WALL_CLOCK_FOLD_S 128
+#endif
+
+// <o> WALL_CLOCK_DRIFT_MIN_S - Shortest time between two syncs that updates the drift estimate, in seconds. 
+#ifndef WALL_CLOCK_DRIFT_MIN_S
+#define WALL_CLOCK_DRIFT_MIN_S 3600
+#endif
+
+// <o> WALL_CLOCK_DRIFT_MAX_STEP_S - Largest step taken as drift; larger ones are a new time. 
+#ifndef WALL_CLOCK_DRIFT_MAX_STEP_S
+#define WALL_CLOCK_DRIFT_MAX_STEP_S 60
+#endif
+
+// <o> WALL_CLOCK_DRIFT_MAX_PPM - Largest drift corrected, in ppm. 
+// <i> The 32 kHz crystal is specified to 20 ppm, the RC oscillator to 250 ppm.
+#ifndef WALL_CLOCK_DRIFT_MAX_PPM
+#define WALL_CLOCK_DRIFT_MAX_PPM 300
+#endif
+
+// <q> WALL_CLOCK_CTS_ENABLED  - Read the Current Time Service of the phone on connection
+// <i> Needs BLE_CTS_C_ENABLED and BLE_DB_DISCOVERY_ENABLED, and excludes GW_PUSH_ENABLED.
+#ifndef WALL_CLOCK_CTS_ENABLED
+#define WALL_CLOCK_CTS_ENABLED 0
+#endif
+
+#endif //WALL_CLOCK_ENABLED
+// </e>
+
+// <e> ENERGY_ENABLED - energy - Charge estimate per tap, per idle hour and per subsystem, from the time each part is on
+// <i> Needs WALL_CLOCK_ENABLED. Read with the ENERGY command over NUS. The currents are per board, at 3 V.
+//==========================================================
+#ifndef ENERGY_ENABLED
+#define ENERGY_ENABLED 0
+#endif
+#if  ENERGY_ENABLED
+// <o> ENERGY_UA_SLEEP - Current of the board asleep, in uA 
+// <i> System ON with the RTC, the regulators and the PN532 and flash powered down.
+#ifndef ENERGY_UA_SLEEP
+#define ENERGY_UA_SLEEP 8
+#endif
+
+// <o> ENERGY_UA_PN532 - Current of the PN532 awake, in uA 
+// <i> Between the field off and on; the field draws most of it.
+#ifndef ENERGY_UA_PN532
+#define ENERGY_UA_PN532 40000
+#endif
+
+// <o> ENERGY_UA_TWI - Current of a TWI transaction, in uA 
+#ifndef ENERGY_UA_TWI
+#define ENERGY_UA_TWI 2500
+#endif
+
+// <o> ENERGY_UA_SPI - Current of an SPI command, in uA 
+#ifndef ENERGY_UA_SPI
+#define ENERGY_UA_SPI 3500
+#endif
+
+// <o> ENERGY_UA_FLASH_PROG - Current of an MX25 page program, in uA 
+#ifndef ENERGY_UA_FLASH_PROG
+#define ENERGY_UA_FLASH_PROG 15000
+#endif
+
+// <o> ENERGY_UA_FLASH_ERASE - Current of an MX25 erase, in uA 
+#ifndef ENERGY_UA_FLASH_ERASE
+#define ENERGY_UA_FLASH_ERASE 15000
+#endif
+
+// <o> ENERGY_UA_BUZZER - Current of the buzzer sounding, in uA 
+#ifndef ENERGY_UA_BUZZER
+#define ENERGY_UA_BUZZER 20000
+#endif
+
+// <o> ENERGY_UA_MOTOR - Mean current of the H-bridge awake, drive, brake and coast, in uA 
+#ifndef ENERGY_UA_MOTOR
+#define ENERGY_UA_MOTOR 150000
+#endif
+
+// <o> ENERGY_UA_RADIO - Mean current of a radio event, in uA 
+// <i> Counted from the radio notification, which comes up to 800 us before the radio starts.
+#ifndef ENERGY_UA_RADIO
+#define ENERGY_UA_RADIO 8000
+#endif
+
+// <o> ENERGY_TAP_WINDOW_MS - Time after a tap that is charged to it, in ms 
+// <i> Covers the motor, the beep, the journal write and the notification.
+#ifndef ENERGY_TAP_WINDOW_MS
+#define ENERGY_TAP_WINDOW_MS 3000
+#endif
+
+// <o> ENERGY_IRQ_PRIORITY  - Priority of the radio notification interrupt without RADIO_GAP_ENABLED
+ 
+// <1=> 1 
+// <3=> 3 
+
+#ifndef ENERGY_IRQ_PRIORITY
+#define ENERGY_IRQ_PRIORITY 3
+#endif
+
+#endif //ENERGY_ENABLED
+// </e>
+
+// <e> DEV_CFG_ENABLED - dev_cfg - Site settings in an FDS record, set over NUS, read from RAM (needs FDS)
+//==========================================================
+#ifndef DEV_CFG_ENABLED
+#define DEV_CFG_ENABLED 1
+#endif
+#if  DEV_CFG_ENABLED
+// <o> DEV_CFG_FILE_ID - FDS file ID of the settings record <0x0000-0xBFFF> 
+#ifndef DEV_CFG_FILE_ID
+#define DEV_CFG_FILE_ID 0x4346
+#endif
+
+// <o> DEV_CFG_RECORD_KEY - FDS record key of the settings record <0x0001-0xBFFF> 
+#ifndef DEV_CFG_RECORD_KEY
+#define DEV_CFG_RECORD_KEY 0x0001
+#endif
+
+#endif //DEV_CFG_ENABLED
+// </e>
+
+// <e> LOCK_ACL_ENABLED - lock_acl - Local UID whitelist on the MX25L16
+//==========================================================
+#ifndef LOCK_ACL_ENABLED
+#define LOCK_ACL_ENABLED 1
+#endif
+#if  LOCK_ACL_ENABLED
+// <o> LOCK_ACL_FLASH_ADDR - MX25L16 address of the whitelist, sector aligned.  
+// <i> One header sector followed by the entry pages.
+#ifndef LOCK_ACL_FLASH_ADDR
+#define LOCK_ACL_FLASH_ADDR 0x100000
+#endif
+
+// <o> LOCK_ACL_MAX_PAGES - Maximum number of 256-byte entry pages (32 UIDs each).  
+// <i> Costs 4 bytes of RAM per page for the index.
+#ifndef LOCK_ACL_MAX_PAGES
+#define LOCK_ACL_MAX_PAGES 384
+#endif
+
+// <e> LOCK_ACL_DELTA_ENABLED - Signed, versioned add/remove updates of the list
+// <i> Needs NRF_CRYPTO_AES_ENABLED and nanopb (pb_decode.c, pb_common.c). The application
+// <i> defines LOCK_ACL_SITE_KEY, the AES-128 key the deltas are signed with. Every lock of
+// <i> the site holds it, so reading it out of one lock allows forging deltas for all of them.
+//==========================================================
+#ifndef LOCK_ACL_DELTA_ENABLED
+#define LOCK_ACL_DELTA_ENABLED 0
+#endif
+#if  LOCK_ACL_DELTA_ENABLED
+// <o> LOCK_ACL_DELTA_SIZE - Flash staging area for a received delta, a multiple of 4096.  
+// <i> Placed after the entry pages. A delta op takes 4 to 13 bytes.
+#ifndef LOCK_ACL_DELTA_SIZE
+#define LOCK_ACL_DELTA_SIZE 8192
+#endif
+
+// <e> LOCK_ACL_ENROLL_ENABLED - Enroll the cards tapped on the reader into the list
+// <i> Started with ACL_ENROLL and a CMAC under the site key. Needs PN532_DUTY_ENABLED.
+//==========================================================
+#ifndef LOCK_ACL_ENROLL_ENABLED
+#define LOCK_ACL_ENROLL_ENABLED 0
+#endif
+#if  LOCK_ACL_ENROLL_ENABLED
+// <o> LOCK_ACL_ENROLL_BATCH - UIDs collected in RAM before they are written <1-255> 
+// <i> 8 bytes of RAM each. A commit rewrites each page it touches once.
+#ifndef LOCK_ACL_ENROLL_BATCH
+#define LOCK_ACL_ENROLL_BATCH 32
+#endif
+
+// <o> LOCK_ACL_ENROLL_COMMIT_MS - A pause this long after a new card commits the batch 
+#ifndef LOCK_ACL_ENROLL_COMMIT_MS
+#define LOCK_ACL_ENROLL_COMMIT_MS 2000
+#endif
+
+// <o> LOCK_ACL_ENROLL_IDLE_S - Enrollment ends this long after the last card 
+#ifndef LOCK_ACL_ENROLL_IDLE_S
+#define LOCK_ACL_ENROLL_IDLE_S 60
+#endif
+
+#endif //LOCK_ACL_ENROLL_ENABLED
+// </e>
+
+#endif //LOCK_ACL_DELTA_ENABLED
+// </e>
+
+#endif //LOCK_ACL_ENABLED
+// </e>
+
+// <e> LOCK_ACL_MPH_ENABLED - lock_acl_mph - UID whitelist in internal flash with a perfect hash, no MX25L16 needed
+// <i> Checked before lock_acl. The table is generated offline and sent with ACL_TABLE.
+//==========================================================
+#ifndef LOCK_ACL_MPH_ENABLED
+#define LOCK_ACL_MPH_ENABLED 0
+#endif
+#if  LOCK_ACL_MPH_ENABLED
+// <o> LOCK_ACL_MPH_PAGES - Flash pages per bank; two banks are taken.  
+// <i> A table of n UIDs with n buckets takes 10 n + 32 bytes: 20 pages of 1 kB hold 2000.
+#ifndef LOCK_ACL_MPH_PAGES
+#define LOCK_ACL_MPH_PAGES 20
+#endif
+
+// <o> LOCK_ACL_MPH_CHUNK - Bytes programmed per fstorage write, a multiple of 4.  
+// <i> Costs twice this much RAM.
+#ifndef LOCK_ACL_MPH_CHUNK
+#define LOCK_ACL_MPH_CHUNK 128
+#endif
+
+// <o> LOCK_ACL_MPH_FS_PRIORITY - fstorage priority of the banks, unique among fstorage users.  
+// <i> fds takes 0xFF, the highest pages.
+#ifndef LOCK_ACL_MPH_FS_PRIORITY
+#define LOCK_ACL_MPH_FS_PRIORITY 0xFE
+#endif
+
+#endif //LOCK_ACL_MPH_ENABLED
+// </e>
+
+// <e> ACL_SCHED_ENABLED - acl_sched - Weekly access schedules of the lock_acl_mph table (needs WALL_CLOCK)
+// <i> Cards of schedule group 1 to 31 are granted only in the 15-minute slots their group allows.
+//==========================================================
+#ifndef ACL_SCHED_ENABLED
+#define ACL_SCHED_ENABLED 0
+#endif
+#if  ACL_SCHED_ENABLED
+// <q> ACL_SCHED_UNSYNCED_ALLOW  - Grant scheduled cards while the clock has not been set since boot
+// <i> Otherwise only cards of group 0 open until the phone sets the time.
+#ifndef ACL_SCHED_UNSYNCED_ALLOW
+#define ACL_SCHED_UNSYNCED_ALLOW 1
+#endif
+
+#endif //ACL_SCHED_ENABLED
+// </e>
+
+// <e> LOCK_JOURNAL_ENABLED - lock_journal - Append-only access event log on the MX25L16 (needs MX25_ASYNC)
+//==========================================================
+#ifndef LOCK_JOURNAL_ENABLED
+#define LOCK_JOURNAL_ENABLED 1
+#endif
+#if  LOCK_JOURNAL_ENABLED
+// <o> LOCK_JOURNAL_FLASH_ADDR - MX25L16 address of the journal, sector aligned.  
+#ifndef LOCK_JOURNAL_FLASH_ADDR
+#define LOCK_JOURNAL_FLASH_ADDR 0x180000
+#endif
+
+// <o> LOCK_JOURNAL_SECTORS - Number of 4 KB sectors, 370 to 1000 entries each. <2-128>  
+// <i> One sector is always kept erased, so LOCK_JOURNAL_SECTORS - 1 sectors of events are held.
+#ifndef LOCK_JOURNAL_SECTORS
+#define LOCK_JOURNAL_SECTORS 64
+#endif
+
+// <o> LOCK_JOURNAL_DICT_SIZE - UIDs per sector written once and referenced after. <1-255>  
+// <i> Costs 10 bytes of RAM each.
+#ifndef LOCK_JOURNAL_DICT_SIZE
+#define LOCK_JOURNAL_DICT_SIZE 32
+#endif
+#endif //LOCK_JOURNAL_ENABLED
+// </e>
+
+// <e> JOURNAL_SYNC_ENABLED - journal_sync - Resumable journal sync over NUS with acknowledged windows (needs LOCK_JOURNAL, NUS_TX)
+//==========================================================
+#ifndef JOURNAL_SYNC_ENABLED
+#define JOURNAL_SYNC_ENABLED 1
+#endif
+#if  JOURNAL_SYNC_ENABLED
+// <o> JOURNAL_SYNC_WINDOW - Entries sent past the last acknowledged one. <1-65535>  
+#ifndef JOURNAL_SYNC_WINDOW
+#define JOURNAL_SYNC_WINDOW 256
+#endif
+
+// <o> JOURNAL_SYNC_BURST - Notifications queued per TX complete event, below NUS_TX_QUEUE_SIZE. <1-255>  
+// <i> Each costs a few journal reads in the main loop.
+#ifndef JOURNAL_SYNC_BURST
+#define JOURNAL_SYNC_BURST 4
+#endif
+#endif //JOURNAL_SYNC_ENABLED
+// </e>
+
+// <e> BURST_LINK_ENABLED - burst_link - Journal offload to the gateway over a proprietary radio link in timeslots (needs JOURNAL_SYNC)
+//==========================================================
+#ifndef BURST_LINK_ENABLED
+#define BURST_LINK_ENABLED 0
+#endif
+#if  BURST_LINK_ENABLED
+// <o> BURST_LINK_FREQUENCY - Channel, MHz above 2400 <0-100>
+// <i> The gateway listens on the same; keep it off the advertising channels 2, 26 and 80.
+#ifndef BURST_LINK_FREQUENCY
+#define BURST_LINK_FREQUENCY 72
+#endif
+
+// <o> BURST_LINK_BASE_ADDR - Base address of the link
+#ifndef BURST_LINK_BASE_ADDR
+#define BURST_LINK_BASE_ADDR 0x4C4F434B
+#endif
+
+// <o> BURST_LINK_PREFIX - Address prefix of the link <0-255>
+#ifndef BURST_LINK_PREFIX
+#define BURST_LINK_PREFIX 0xB7
+#endif
+
+// <o> BURST_LINK_PAYLOAD - Bytes per packet <20-255>
+#ifndef BURST_LINK_PAYLOAD
+#define BURST_LINK_PAYLOAD 200
+#endif
+
+// <o> BURST_LINK_QUEUE_SIZE - Packets built ahead, a power of two <2-128>
+#ifndef BURST_LINK_QUEUE_SIZE
+#define BURST_LINK_QUEUE_SIZE 8
+#endif
+
+// <o> BURST_LINK_SLOT_US - Length of a timeslot in microseconds <5000-100000>
+#ifndef BURST_LINK_SLOT_US
+#define BURST_LINK_SLOT_US 15000
+#endif
+
+// <o> BURST_LINK_DISTANCE_US - Start of one timeslot to the next in microseconds
+// <i> Leaves the time between for the connection events of the phone.
+#ifndef BURST_LINK_DISTANCE_US
+#define BURST_LINK_DISTANCE_US 30000
+#endif
+
+// <o> BURST_LINK_ACK_TIMEOUT_US - Wait for the answer of the gateway, after the receiver is up
+#ifndef BURST_LINK_ACK_TIMEOUT_US
+#define BURST_LINK_ACK_TIMEOUT_US 300
+#endif
+
+// <o> BURST_LINK_GIVE_UP - Timeslots in a row without an answer before the offload stops <1-255>
+#ifndef BURST_LINK_GIVE_UP
+#define BURST_LINK_GIVE_UP 20
+#endif
+
+#endif //BURST_LINK_ENABLED
+// </e>
+
+// <q> NRF_BLOCK_DEV_MX25_ENABLED  - nrf_block_dev_mx25 - Block device backend on the MX25L16 (needs MX25_ASYNC)
+ 
+
+#ifndef NRF_BLOCK_DEV_MX25_ENABLED
+#define NRF_BLOCK_DEV_MX25_ENABLED 1
+#endif
+
+// <q> NRF_BLOCK_DEV_JOURNAL_ENABLED  - nrf_block_dev_journal - The journal as a read-only FAT12 volume with one file (needs LOCK_JOURNAL)
+ 
+
+#ifndef NRF_BLOCK_DEV_JOURNAL_ENABLED
+#define NRF_BLOCK_DEV_JOURNAL_ENABLED 0
+#endif
+
+// <q> USB_SERVICE_ENABLED  - usb_service - CDC ACM command port and journal drive, nRF52840 only
+ 
+// <i> Needs NRF_BLOCK_DEV_JOURNAL_ENABLED, APP_USBD_ENABLED, APP_USBD_CLASS_CDC_ACM_ENABLED and APP_USBD_CLASS_MSC_ENABLED.
+
+#ifndef USB_SERVICE_ENABLED
+#define USB_SERVICE_ENABLED 0
+#endif
+
+// <e> SD_LOG_ENABLED - sd_log - Journal entries copied to a file on an SD card in whole sectors
+// <i> Needs LOCK_JOURNAL_ENABLED and APP_SDCARD_ENABLED on an SPI instance of its own, and FatFs.
+//==========================================================
+#ifndef SD_LOG_ENABLED
+#define SD_LOG_ENABLED 0
+#endif
+#if  SD_LOG_ENABLED
+// <o> SD_LOG_SCK_PIN - Card SCK pin  <0-31> 
+#ifndef SD_LOG_SCK_PIN
+#define SD_LOG_SCK_PIN 12
+#endif
+
+// <o> SD_LOG_MOSI_PIN - Card MOSI pin  <0-31> 
+#ifndef SD_LOG_MOSI_PIN
+#define SD_LOG_MOSI_PIN 13
+#endif
+
+// <o> SD_LOG_MISO_PIN - Card MISO pin  <0-31> 
+#ifndef SD_LOG_MISO_PIN
+#define SD_LOG_MISO_PIN 14
+#endif
+
+// <o> SD_LOG_CS_PIN - Card chip select pin  <0-31> 
+#ifndef SD_LOG_CS_PIN
+#define SD_LOG_CS_PIN 15
+#endif
+
+// <o> SD_LOG_BUF_SECTORS - Sectors buffered in RAM per write, 32 entries each  <1-16> 
+// <i> Written with one f_write(), a multi-block write on the card.
+#ifndef SD_LOG_BUF_SECTORS
+#define SD_LOG_BUF_SECTORS 4
+#endif
+
+// <o> SD_LOG_SYNC_S - Seconds between f_sync() calls, within the 24-bit app_timer range  <1-500> 
+// <i> A sector still filling up is padded and written at the same time.
+#ifndef SD_LOG_SYNC_S
+#define SD_LOG_SYNC_S 10
+#endif
+
+#endif //SD_LOG_ENABLED
+// </e>
+
+// <e> APP_RTOS_ENABLED - app_rtos - FreeRTOS tasks in place of the main loop
+// <i> Set by the ble_app_uart_freertos project only, with APP_SCHEDULER_WITH_NOTIFY, NRF_PWR_MGMT_ENABLED and app_timer_freertos.c.
+//==========================================================
+#ifndef APP_RTOS_ENABLED
+#define APP_RTOS_ENABLED 0
+#endif
+#if  APP_RTOS_ENABLED
+// <o> APP_RTOS_BLE_STACK_SIZE - Stack of the BLE task, in words <64-1024> 
+#ifndef APP_RTOS_BLE_STACK_SIZE
+#define APP_RTOS_BLE_STACK_SIZE 192
+#endif
+
+// <o> APP_RTOS_RF_STACK_SIZE - Stack of the reader task running app_scheduler, in words <64-1024> 
+#ifndef APP_RTOS_RF_STACK_SIZE
+#define APP_RTOS_RF_STACK_SIZE 256
+#endif
+
+// <o> APP_RTOS_STORAGE_STACK_SIZE - Stack of the storage task, in words <64-1024> 
+#ifndef APP_RTOS_STORAGE_STACK_SIZE
+#define APP_RTOS_STORAGE_STACK_SIZE 160
+#endif
+
+// <o> APP_RTOS_JOURNAL_QUEUE_SIZE - Journal entries waiting for the storage task <1-32> 
+#ifndef APP_RTOS_JOURNAL_QUEUE_SIZE
+#define APP_RTOS_JOURNAL_QUEUE_SIZE 8
+#endif
+
+#endif //APP_RTOS_ENABLED
+// </e>
+
+// <e> PWR_IDLE_ENABLED - pwr_idle - Idle hooks of the SPI and TWI buses, the MX25 and the PN532 run before the main loop sleeps
+// <i> Needs NRF_PWR_MGMT_ENABLED. Not with APP_RTOS_ENABLED, the idle task sleeps there.
+//==========================================================
+#ifndef PWR_IDLE_ENABLED
+#define PWR_IDLE_ENABLED 1
+#endif
+#if  PWR_IDLE_ENABLED
+// <o> PWR_IDLE_HOOKS_MAX - Parts that can register a hook <1-16> 
+#ifndef PWR_IDLE_HOOKS_MAX
+#define PWR_IDLE_HOOKS_MAX 6
+#endif
+
+// <o> PWR_IDLE_BREAK_EVEN - Times the wake time of a part must fit into the time to the next timer <1-1000> 
+// <i> A part that would be woken again almost at once costs more than it saves.
+#ifndef PWR_IDLE_BREAK_EVEN
+#define PWR_IDLE_BREAK_EVEN 10
+#endif
+
+#endif //PWR_IDLE_ENABLED
+// </e>
+
+// <e> BATT_MON_ENABLED - batt_mon - Battery voltage from one ADC burst on the VOL_EN divider; poll and advertise less when low
+// <i> Needs ADC_ENABLED.
+//==========================================================
+#ifndef BATT_MON_ENABLED
+#define BATT_MON_ENABLED 1
+#endif
+#if  BATT_MON_ENABLED
+// <o> BATT_MON_AIN - Analog input of the divider tap <0-7> 
+// <i> AIN0..AIN7 are P0.26, P0.27, P0.01..P0.06 on the nRF51.
+#ifndef BATT_MON_AIN
+#define BATT_MON_AIN 4
+#endif
+
+// <o> BATT_MON_EN_ACTIVE_STATE - VOL_EN level that turns the divider on <0-1> 
+#ifndef BATT_MON_EN_ACTIVE_STATE
+#define BATT_MON_EN_ACTIVE_STATE 1
+#endif
+
+// <o> BATT_MON_FULL_SCALE_MV - Battery voltage that reads 1023, in mV 
+// <i> 3600 mV at the pin with the 1/3 input prescaler and the 1.2 V band gap, times the divider ratio.
+#ifndef BATT_MON_FULL_SCALE_MV
+#define BATT_MON_FULL_SCALE_MV 7200
+#endif
+
+// <o> BATT_MON_SAMPLES - Conversions averaged per burst <1-16> 
+#ifndef BATT_MON_SAMPLES
+#define BATT_MON_SAMPLES 8
+#endif
+
+// <o> BATT_MON_SETTLE_US - Wait between VOL_EN and the burst, in us <0-1000> 
+#ifndef BATT_MON_SETTLE_US
+#define BATT_MON_SETTLE_US 100
+#endif
+
+// <o> BATT_MON_INTERVAL_S - Seconds between bursts <10-300> 
+#ifndef BATT_MON_INTERVAL_S
+#define BATT_MON_INTERVAL_S 60
+#endif
+
+// <o> BATT_MON_LOW_MV - Below this the battery is low, in mV 
+#ifndef BATT_MON_LOW_MV
+#define BATT_MON_LOW_MV 4600
+#endif
+
+// <o> BATT_MON_HYST_MV - Rise above BATT_MON_LOW_MV needed to leave the low level, in mV 
+#ifndef BATT_MON_HYST_MV
+#define BATT_MON_HYST_MV 200
+#endif
+
+#endif //BATT_MON_ENABLED
+// </e>
+
+// <e> PROX_WAKE_ENABLED - prox_wake - Capacitive pad behind the antenna: PN532 bursts at once when a hand comes near, slow when nobody does
+// <i> Needs NRF_DRV_CSENSE_ENABLED and PN532_DUTY_ENABLED. Shares the ADC with batt_mon.
+//==========================================================
+#ifndef PROX_WAKE_ENABLED
+#define PROX_WAKE_ENABLED 1
+#endif
+#if  PROX_WAKE_ENABLED
+// <o> PROX_WAKE_AIN - Analog input of the pad <0-7> 
+// <i> AIN0..AIN7 are P0.26, P0.27, P0.01..P0.06 on the nRF51.
+#ifndef PROX_WAKE_AIN
+#define PROX_WAKE_AIN 6
+#endif
+
+// <o> PROX_WAKE_OUTPUT_PIN - Pin charging the pad through its resistor <0-31> 
+#ifndef PROX_WAKE_OUTPUT_PIN
+#define PROX_WAKE_OUTPUT_PIN 22
+#endif
+
+// <o> PROX_WAKE_PERIOD_MS - Sample interval, in ms <50-2000> 
+#ifndef PROX_WAKE_PERIOD_MS
+#define PROX_WAKE_PERIOD_MS 250
+#endif
+
+// <o> PROX_WAKE_THRESHOLD_MV - Rise above the baseline that counts as near, in mV <5-1000> 
+#ifndef PROX_WAKE_THRESHOLD_MV
+#define PROX_WAKE_THRESHOLD_MV 40
+#endif
+
+// <o> PROX_WAKE_BASELINE_SHIFT - Baseline steps 1/2^shift of the way to each empty sample <1-10> 
+#ifndef PROX_WAKE_BASELINE_SHIFT
+#define PROX_WAKE_BASELINE_SHIFT 5
+#endif
+
+// <o> PROX_WAKE_IDLE_S - Seconds with nobody near before the bursts back off to PN532_DUTY_IDLE_MS 
+#ifndef PROX_WAKE_IDLE_S
+#define PROX_WAKE_IDLE_S 20
+#endif
+
+// <o> PROX_WAKE_RECAL_S - Seconds near after which the pad is taken as empty again 
+#ifndef PROX_WAKE_RECAL_S
+#define PROX_WAKE_RECAL_S 60
+#endif
+
+#endif //PROX_WAKE_ENABLED
+// </e>
+
+// <e> IR_PROX_ENABLED - ir_prox - IR reflection on IRDA_PUT/IRDA_IN gating the PN532 bursts, for boards without the csense pad
+// <i> Needs PPI_ENABLED and PN532_DUTY_ENABLED; takes TIMER1 and TIMER2, so TIMER1_ENABLED, TIMER2_ENABLED,
+// <i> UART_FRAME_ENABLED and PROX_WAKE_ENABLED must be 0.
+//==========================================================
+#ifndef IR_PROX_ENABLED
+#define IR_PROX_ENABLED 0
+#endif
+#if  IR_PROX_ENABLED
+// <o> IR_PROX_PERIOD_MS - Pulse interval, in ms <10-2000> 
+#ifndef IR_PROX_PERIOD_MS
+#define IR_PROX_PERIOD_MS 100
+#endif
+
+// <o> IR_PROX_PULSE_US - Emitter on time, echo window, in us <32-2000> 
+// <i> In steps of 32 us.
+#ifndef IR_PROX_PULSE_US
+#define IR_PROX_PULSE_US 192
+#endif
+
+// <o> IR_PROX_HITS - Echoes that count as near <1-100> 
+#ifndef IR_PROX_HITS
+#define IR_PROX_HITS 2
+#endif
+
+// <o> IR_PROX_MISSES - Pulses in a row without an echo that count as gone <1-100> 
+#ifndef IR_PROX_MISSES
+#define IR_PROX_MISSES 5
+#endif
+
+// <q> IR_PROX_EMITTER_ACTIVE_STATE  - IRDA_PUT level that lights the emitter
+#ifndef IR_PROX_EMITTER_ACTIVE_STATE
+#define IR_PROX_EMITTER_ACTIVE_STATE 1
+#endif
+
+// <q> IR_PROX_RECEIVER_ACTIVE_STATE  - IRDA_IN level while the receiver sees IR
+#ifndef IR_PROX_RECEIVER_ACTIVE_STATE
+#define IR_PROX_RECEIVER_ACTIVE_STATE 0
+#endif
+
+// <o> IR_PROX_IDLE_S - Seconds with nothing near before the bursts back off to PN532_DUTY_IDLE_MS 
+#ifndef IR_PROX_IDLE_S
+#define IR_PROX_IDLE_S 20
+#endif
+
+// <o> IR_PROX_IRQ_PRIORITY  - Priority of the TIMER2 interrupt that flips the state
+ 
+// <1=> 1 
+// <3=> 3 
+
+#ifndef IR_PROX_IRQ_PRIORITY
+#define IR_PROX_IRQ_PRIORITY 3
+#endif
+
+#endif //IR_PROX_ENABLED
+// </e>
+
+// <e> BEEP_PWM_ENABLED - beep_pwm - Buzzer tone from TIMER, GPIOTE and PPI (nRF51) or PWM (nRF52) instead of low_power_pwm
+// <i> Same pitch and duty cycle as the app_timer tone, with no interrupt while it plays.
+// <i> The nRF51 needs PPI_ENABLED; the timer keeps the 16 MHz clock requested during a beep only.
+//==========================================================
+#ifndef BEEP_PWM_ENABLED
+#define BEEP_PWM_ENABLED 0
+#endif
+#if  BEEP_PWM_ENABLED
+// <o> BEEP_PWM_TIMER_INSTANCE  - TIMER of the tone (nRF51)
+ 
+// <1=> TIMER1 
+// <2=> TIMER2 
+
+#ifndef BEEP_PWM_TIMER_INSTANCE
+#define BEEP_PWM_TIMER_INSTANCE 1
+#endif
+
+// <o> BEEP_PWM_PWM_INSTANCE - PWM instance of the tone (nRF52)  <0-2> 
+#ifndef BEEP_PWM_PWM_INSTANCE
+#define BEEP_PWM_PWM_INSTANCE 0
+#endif
+
+#endif //BEEP_PWM_ENABLED
+// </e>
+
+// <e> PORT_SENSE_ENABLED - port_sense - Slow inputs on the one low-power PORT event: NFAULT, the PN532 IRQ, the door contact
+// <i> Each pin senses the level it is not at, both edges come in through PORT, no GPIOTE channel or slot is taken.
+// <i> PN532_PPI_RX keeps its IN channel for the PN532 IRQ, PPI needs an event of its own.
+//==========================================================
+#ifndef PORT_SENSE_ENABLED
+#define PORT_SENSE_ENABLED 1
+#endif
+#if  PORT_SENSE_ENABLED
+// <o> PORT_SENSE_PINS_MAX - Pins that can be sensed <1-32> 
+#ifndef PORT_SENSE_PINS_MAX
+#define PORT_SENSE_PINS_MAX 6
+#endif
+
+// <o> PORT_SENSE_DEBOUNCE_MS - Time a debounced input has to be quiet before its level counts 
+#ifndef PORT_SENSE_DEBOUNCE_MS
+#define PORT_SENSE_DEBOUNCE_MS 30
+#endif
+
+#endif //PORT_SENSE_ENABLED
+// </e>
+
+// <e> RAND_POOL_ENABLED - rand_pool - Random bytes kept ready for nonces and keys, refilled in the background
+// <i> Needs RNG_ENABLED with RNG_CONFIG_ERROR_CORRECTION. PN532_HCE and PN532_DESFIRE take their nonces from it.
+//==========================================================
+#ifndef RAND_POOL_ENABLED
+#define RAND_POOL_ENABLED 0
+#endif
+#if  RAND_POOL_ENABLED
+// <o> RAND_POOL_SIZE - Bytes kept ready <16-255> 
+#ifndef RAND_POOL_SIZE
+#define RAND_POOL_SIZE 64
+#endif
+
+// <o> RAND_POOL_LOW - Level below which the refill starts 
+#ifndef RAND_POOL_LOW
+#define RAND_POOL_LOW 32
+#endif
+
+// <o> RAND_POOL_REFILL_MS - Interval of the refill while the pool is not full 
+// <i> With the bias correction the RNG makes a byte in well under a ms; a few ms per step is plenty.
+#ifndef RAND_POOL_REFILL_MS
+#define RAND_POOL_REFILL_MS 5
+#endif
+
+#endif //RAND_POOL_ENABLED
+// </e>
+
+// <e> WDT_SUP_ENABLED - wdt_sup - Watchdog fed only while every busy part shows progress, crash record over the reset
+// <i> Needs WDT_ENABLED. WDT_CONFIG_IRQ_PRIORITY 1 lets the WDT interrupt write the record over a hang at
+// <i> priority 3. The Keil projects keep RAM from KEEP_RAM_ADDR to the top out of IRAM1, NoInit.
+//==========================================================
+#ifndef WDT_SUP_ENABLED
+#define WDT_SUP_ENABLED 1
+#endif
+#if  WDT_SUP_ENABLED
+// <o> WDT_SUP_CHECK_MS - Interval of the check that feeds the watchdog, in ms <100-10000> 
+// <i> Below WDT_CONFIG_RELOAD_VALUE.
+#ifndef WDT_SUP_CHECK_MS
+#define WDT_SUP_CHECK_MS 1000
+#endif
+
+// <o> WDT_SUP_MAIN_MS - Limit of one pass of the main loop, in ms 
+#ifndef WDT_SUP_MAIN_MS
+#define WDT_SUP_MAIN_MS 10000
+#endif
+
+// <o> WDT_SUP_RF_MS - Limit of one wait for the PN532, in ms 
+// <i> Above the longest timeout passed to the PN532 commands, PN532_ISODEP_TIMEOUT_MS among them.
+#ifndef WDT_SUP_RF_MS
+#define WDT_SUP_RF_MS 6000
+#endif
+
+// <o> WDT_SUP_STORAGE_MS - Limit of one wait for the MX25, in ms 
+// <i> Above the chip erase time of the MX25L16.
+#ifndef WDT_SUP_STORAGE_MS
+#define WDT_SUP_STORAGE_MS 30000
+#endif
+
+// <o> WDT_SUP_BLE_TX_MS - Limit of one wait for room in the NUS queue, in ms 
+#ifndef WDT_SUP_BLE_TX_MS
+#define WDT_SUP_BLE_TX_MS 5000
+#endif
+
+// <o> WDT_SUP_CRASH_ADDR - Address of the 32 byte crash record 
+// <i> Must match the NoInit IRAM2 of the Keil project.
+#ifndef WDT_SUP_CRASH_ADDR
+#define WDT_SUP_CRASH_ADDR 0x20007FE0
+#endif
+
+#endif //WDT_SUP_ENABLED
+// </e>
+
+// <e> POST_MORTEM_ENABLED - post_mortem - Fault snapshots kept on the MX25L16 and uploaded over NUS
+// <i> Needs HARDFAULT_HANDLER_ENABLED and NUS_TX_ENABLED. Takes over HardFault_process() and
+// <i> app_error_fault_handler().
+//==========================================================
+#ifndef POST_MORTEM_ENABLED
+#define POST_MORTEM_ENABLED 1
+#endif
+#if  POST_MORTEM_ENABLED
+// <o> POST_MORTEM_RAM_ADDR - Address of the 460 byte snapshot 
+// <i> Must match the NoInit IRAM2 of the Keil project, below WDT_SUP_CRASH_ADDR.
+#ifndef POST_MORTEM_RAM_ADDR
+#define POST_MORTEM_RAM_ADDR 0x20007E00
+#endif
+
+// <o> POST_MORTEM_FLASH_ADDR - MX25L16 address of the snapshot sector, sector aligned.  
+// <i> The sector after the journal.
+#ifndef POST_MORTEM_FLASH_ADDR
+#define POST_MORTEM_FLASH_ADDR 0x1C0000
+#endif
+
+// <o> POST_MORTEM_POLL_MS - Interval of the checks for notifications after a connection, in ms <100-10000> 
+#ifndef POST_MORTEM_POLL_MS
+#define POST_MORTEM_POLL_MS 1000
+#endif
+
+// <o> POST_MORTEM_POLL_TRIES - Checks before the link is given up on <1-255> 
+#ifndef POST_MORTEM_POLL_TRIES
+#define POST_MORTEM_POLL_TRIES 30
+#endif
+
+#endif //POST_MORTEM_ENABLED
+// </e>
+
+// <e> KEEP_RAM_ENABLED - keep_ram - Counters, last fault and latency trace kept in RAM over resets
+// <i> Flushed to FDS now and then and on the power failure warning, to come back after power loss.
+//==========================================================
+#ifndef KEEP_RAM_ENABLED
+#define KEEP_RAM_ENABLED 1
+#endif
+#if  KEEP_RAM_ENABLED
+// <o> KEEP_RAM_ADDR - Address of the region 
+// <i> Must match the NoInit IRAM2 of the Keil project, below POST_MORTEM_RAM_ADDR.
+#ifndef KEEP_RAM_ADDR
+#define KEEP_RAM_ADDR 0x20007B00
+#endif
+
+// <o> KEEP_RAM_FLUSH_MIN - Minutes between flushes to FDS of a changed region <1-10080> 
+#ifndef KEEP_RAM_FLUSH_MIN
+#define KEEP_RAM_FLUSH_MIN 240
+#endif
+
+// <o> KEEP_RAM_POF_THRESHOLD  - Supply level of the power failure warning
+ 
+// <0=> 2.1 V 
+// <1=> 2.3 V 
+// <2=> 2.5 V 
+// <3=> 2.7 V 
+
+#ifndef KEEP_RAM_POF_THRESHOLD
+#define KEEP_RAM_POF_THRESHOLD 3
+#endif
+
+// <o> KEEP_RAM_FILE_ID - FDS file ID of the region record <0x0000-0xBFFF> 
+#ifndef KEEP_RAM_FILE_ID
+#define KEEP_RAM_FILE_ID 0x4B52
+#endif
+
+// <o> KEEP_RAM_RECORD_KEY - FDS record key of the region record <0x0001-0xBFFF> 
+#ifndef KEEP_RAM_RECORD_KEY
+#define KEEP_RAM_RECORD_KEY 0x0001
+#endif
+
+#endif //KEEP_RAM_ENABLED
+// </e>
+
+// <e> BOOT_SEQ_ENABLED - boot_seq - Peripherals brought up as stages after advertising has started
+// <i> Off: main.c brings everything up in order before advertising, as before.
+//==========================================================
+#ifndef BOOT_SEQ_ENABLED
+#define BOOT_SEQ_ENABLED 1
+#endif
+#if  BOOT_SEQ_ENABLED
+// <o> BOOT_SEQ_STAGES_MAX - Stages at most <1-32> 
+#ifndef BOOT_SEQ_STAGES_MAX
+#define BOOT_SEQ_STAGES_MAX 12
+#endif
+
+// <o> BOOT_SEQ_PN532_BOOT_MS - Time the PN532 takes after power-up before it answers, in ms 
+// <i> The firmware probe waits that long after the reader init; the other stages run meanwhile.
+#ifndef BOOT_SEQ_PN532_BOOT_MS
+#define BOOT_SEQ_PN532_BOOT_MS 100
+#endif
+
+#endif //BOOT_SEQ_ENABLED
+// </e>
+
+// <e> BENCH_ENABLED - bench - 16 MHz stopwatch, cycle probes and the benchmark cases, reported over RTT
+// <i> For measuring builds: the counter interrupt runs every 4.1 ms and keeps the HFCLK on.
+//==========================================================
+#ifndef BENCH_ENABLED
+#define BENCH_ENABLED 0
+#endif
+#if  BENCH_ENABLED
+// <o> BENCH_TIMER_INSTANCE  - TIMER of the stopwatch
+ 
+// <1=> TIMER1 
+// <2=> TIMER2 
+
+#ifndef BENCH_TIMER_INSTANCE
+#define BENCH_TIMER_INSTANCE 1
+#endif
+
+// <o> BENCH_CASES_MAX - Cases registered at most 
+#ifndef BENCH_CASES_MAX
+#define BENCH_CASES_MAX 12
+#endif
+
+// <o> BENCH_START_MS - Time after start up before the cases run, in ms 
+// <i> Lets boot_seq and fds finish first. Results go to RTT up buffer 0; raise
+// <i> SEGGER_RTT_CONFIG_BUFFER_SIZE_UP if lines go missing without a host attached early.
+#ifndef BENCH_START_MS
+#define BENCH_START_MS 3000
+#endif
+
+#endif //BENCH_ENABLED
+// </e>
+
+// <e> CRIT_PROF_ENABLED - crit_prof - Time of the critical regions and the event handlers, per place, reported over RTT
+// <i> For measuring builds, with BENCH: every outermost CRITICAL_REGION costs two reads of its counter.
+//==========================================================
+#ifndef CRIT_PROF_ENABLED
+#define CRIT_PROF_ENABLED 0
+#endif
+#if  CRIT_PROF_ENABLED
+// <o> CRIT_PROF_SITES - Places with a slot of their own 
+// <i> Regions and handlers, in the order they are first hit; later ones are only counted.
+#ifndef CRIT_PROF_SITES
+#define CRIT_PROF_SITES 24
+#endif
+
+// <o> CRIT_PROF_REPORT_S - Time between reports, in s 
+#ifndef CRIT_PROF_REPORT_S
+#define CRIT_PROF_REPORT_S 60
+#endif
+
+#endif //CRIT_PROF_ENABLED
+// </e>
+
+// <q> RAM_BUDGET_ENABLED  - ram_budget - Stack high water mark and RAM per module, read with RAM_BUDGET
+ 
+
+#ifndef RAM_BUDGET_ENABLED
+#define RAM_BUDGET_ENABLED 0
+#endif
+
+// <e> RAM_POWER_ENABLED - ram_power - RAM sections the image does not use switched off, nRF52 only
+//==========================================================
+#ifndef RAM_POWER_ENABLED
+#define RAM_POWER_ENABLED 0
+#endif
+#if  RAM_POWER_ENABLED
+// <o> RAM_POWER_KEEP_ADDR - Start of the no-init areas, kept on and retained in System OFF 
+// <i> The lowest of KEEP_RAM_ADDR, POST_MORTEM_RAM_ADDR and WDT_SUP_CRASH_ADDR.
+#ifndef RAM_POWER_KEEP_ADDR
+#define RAM_POWER_KEEP_ADDR 0x2000FB00
+#endif
+
+#endif //RAM_POWER_ENABLED
+// </e>
 // </h> 
 //==========================================================
 
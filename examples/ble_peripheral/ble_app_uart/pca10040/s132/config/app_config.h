@@ -0,0 +1,43 @@
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+/* The nRF52832 (pca10040, S132) build shares sdk_config.h with the nRF51 one in
+ * pca10028/s130/config; what differs on the nRF52 is set here, ahead of its defaults. Pins of
+ * the lock and the PN532 are in lock_board.h. */
+
+// TWIM and SPIM: a transfer is one EasyDMA job instead of an interrupt per byte.
+#define TWI1_USE_EASY_DMA 1
+#define SPI0_USE_EASY_DMA 1
+#define SPI1_USE_EASY_DMA 1
+
+#define TWI_BUS_SCL_PIN 27
+#define TWI_BUS_SDA_PIN 26
+
+#define SPI_BUS_SCK_PIN 31
+#define SPI_BUS_MOSI_PIN 30
+#define SPI_BUS_MISO_PIN 29
+
+// The ADC driver is nRF51 only, and csense runs on COMP with TIMER1 and TIMER2 on the nRF52:
+// battery and proximity wake stay off until they are ported to SAADC and COMP.
+#define ADC_ENABLED 0
+#define BATT_MON_ENABLED 0
+#define NRF_DRV_CSENSE_ENABLED 0
+#define PROX_WAKE_ENABLED 0
+
+// The shunt of the motor bridge: AIN3 is P0.05, the RTS of boards.h, free with flow control off.
+#define MOTO_SENSE_AIN 3
+
+// A virtual FDS page must span whole 4 kB flash pages: FDS_VIRTUAL_PAGES of them take the top
+// 12 kB of the 512 kB, below the bootloader if there is one.
+#define FDS_VIRTUAL_PAGE_SIZE 1024
+
+// The no-init areas at the top of the 64 kB of RAM, as IRAM2 of the Keil project.
+#define KEEP_RAM_ADDR 0x2000FB00
+#define POST_MORTEM_RAM_ADDR 0x2000FE00
+#define WDT_SUP_CRASH_ADDR 0x2000FFE0
+
+// Power down the sections between the end of the image and the no-init areas.
+#define RAM_POWER_ENABLED 1
+#define RAM_POWER_KEEP_ADDR KEEP_RAM_ADDR
+
+#endif //APP_CONFIG_H
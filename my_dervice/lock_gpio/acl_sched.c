@@ -0,0 +1,104 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(ACL_SCHED)
+#include "acl_sched.h"
+#include "lock_acl_mph.h"
+#include "wall_clock.h"
+
+#if !NRF_MODULE_ENABLED(LOCK_ACL_MPH) || !NRF_MODULE_ENABLED(WALL_CLOCK)
+#error "ACL_SCHED_ENABLED needs LOCK_ACL_MPH_ENABLED and WALL_CLOCK_ENABLED"
+#endif
+
+#define DAY_S            86400UL
+#define HOLIDAY_ROW      7
+#define ROW_SIZE         (LOCK_ACL_MPH_SCHED_SLOTS / 8)
+
+STATIC_ASSERT(LOCK_ACL_MPH_MAX_GROUPS < 32);
+
+static uint32_t m_allowed = 1;           /**< Bit g set if group g may open in the slot below. */
+static uint32_t m_valid_from;
+static uint32_t m_valid_until;           /**< 0 until the first evaluation. */
+static uint32_t m_sequence;              /**< Table the bits were gathered from. */
+
+
+static bool holiday_is(uint16_t const * p_holidays, uint8_t count, uint16_t day)
+{
+    uint32_t lo = 0;
+    uint32_t hi = count;
+
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) / 2;
+
+        if (p_holidays[mid] == day)
+        {
+            return true;
+        }
+        if (p_holidays[mid] < day)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return false;
+}
+
+
+/**@brief Gather the bit of every group for the slot of @p now. */
+static void evaluate(lock_acl_mph_sched_t const * p_sched, uint32_t now)
+{
+    uint32_t days = now / DAY_S;
+    uint32_t slot = (now % DAY_S) / LOCK_ACL_MPH_SLOT_S;
+    uint32_t row;
+    uint32_t offset;
+
+    // 1970-01-01 was a Thursday; rows start on Monday.
+    row    = holiday_is(p_sched->p_holidays, p_sched->holiday_count, (uint16_t)days) ?
+             HOLIDAY_ROW : (days + 3) % 7;
+    offset = row * ROW_SIZE + slot / 8;
+
+    m_allowed = 1;
+    for (uint32_t g = 1; g <= p_sched->group_count; g++)
+    {
+        uint8_t const * p_group = p_sched->p_groups + (g - 1) * LOCK_ACL_MPH_SCHED_SIZE;
+
+        if (p_group[offset] & (1 << (slot % 8)))
+        {
+            m_allowed |= 1UL << g;
+        }
+    }
+
+    m_valid_from  = days * DAY_S + slot * LOCK_ACL_MPH_SLOT_S;
+    m_valid_until = m_valid_from + LOCK_ACL_MPH_SLOT_S;
+    m_sequence    = p_sched->sequence;
+}
+
+
+bool acl_sched_allowed(uint8_t group)
+{
+    lock_acl_mph_sched_t sched;
+    uint32_t             now;
+
+    if (group == 0)
+    {
+        return true;
+    }
+    if (!wall_clock_synced())
+    {
+        return ACL_SCHED_UNSYNCED_ALLOW;
+    }
+
+    now = wall_clock_now();
+    lock_acl_mph_sched_get(&sched);
+    // A sync can set the clock back into an earlier slot, hence the lower bound.
+    if ((now >= m_valid_until) || (now < m_valid_from) || (sched.sequence != m_sequence))
+    {
+        evaluate(&sched, now);
+    }
+
+    return (group < 32) && ((m_allowed >> group) & 1);
+}
+
+#endif //ACL_SCHED
@@ -0,0 +1,19 @@
+#ifndef _ACL_SCHED_H_
+#define _ACL_SCHED_H_
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Weekly access schedules of the lock_acl_mph table, against wall_clock_now().
+ *
+ * A schedule is one bit per 15-minute slot for each day of the week and for holidays, so the
+ * check for a slot is a bit test. The bits of all groups for the current slot are gathered
+ * into one word when the slot changes or a new table is committed; until then a card costs a
+ * compare of the time and one AND.
+ *
+ * Group 0 is always allowed. A group the table does not have is never allowed.
+ */
+
+/**@brief Whether a card of schedule group @p group may open now. Main context. */
+bool acl_sched_allowed(uint8_t group);
+
+#endif
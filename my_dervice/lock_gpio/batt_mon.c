@@ -0,0 +1,171 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(BATT_MON)
+#include "batt_mon.h"
+#include "lock_gpio.h"
+#include "nrf_drv_adc.h"
+#include "nrf_gpio.h"
+#include "nrf_delay.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+
+#if !ADC_ENABLED
+#error "batt_mon needs ADC_ENABLED"
+#endif
+
+#define BATT_MON_TICKS(ms)  APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+#define ADC_MAX             1023    /**< 10 bit result at full scale. */
+
+APP_TIMER_DEF(m_timer);
+
+// One channel per sample: the driver starts the next channel of a buffer conversion from its
+// interrupt, which makes the burst run without the main loop.
+static nrf_drv_adc_channel_t m_channels[BATT_MON_SAMPLES];
+static nrf_adc_value_t       m_buf[BATT_MON_SAMPLES];
+static batt_mon_handler_t    m_handler;
+static volatile bool         m_busy;
+static uint16_t              m_mv;
+static bool                  m_low;
+static bool                  m_reported;
+
+
+static void divider_enable(bool enable)
+{
+    nrf_gpio_pin_write(VOL_EN, enable ? BATT_MON_EN_ACTIVE_STATE : !BATT_MON_EN_ACTIVE_STATE);
+}
+
+
+static void level_update(void * p_event_data, uint16_t event_size)
+{
+    uint32_t sum = 0;
+    bool     low;
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    for (uint8_t i = 0; i < BATT_MON_SAMPLES; i++)
+    {
+        sum += (uint16_t)m_buf[i];
+    }
+    m_busy = false;
+    m_mv   = (uint16_t)((sum * BATT_MON_FULL_SCALE_MV) / (ADC_MAX * BATT_MON_SAMPLES));
+
+    low = m_low ? (m_mv <= BATT_MON_LOW_MV + BATT_MON_HYST_MV) : (m_mv < BATT_MON_LOW_MV);
+    if ((low != m_low) || !m_reported)
+    {
+        m_low      = low;
+        m_reported = true;
+        if (m_handler != NULL)
+        {
+            m_handler(m_low, m_mv);
+        }
+    }
+}
+
+
+static void adc_evt_handler(nrf_drv_adc_evt_t const * p_event)
+{
+    if (p_event->type != NRF_DRV_ADC_EVT_DONE)
+    {
+        return;
+    }
+
+    divider_enable(false);
+    // Free the ADC for the next user, prox_wake for one; m_buf stays as it is.
+    nrf_drv_adc_uninit();
+    if (app_sched_event_put(NULL, 0, level_update) != NRF_SUCCESS)
+    {
+        // Measured again at the next interval.
+        m_busy = false;
+    }
+}
+
+
+/**@brief Divider on, settle, burst; the settle wait is short enough for the main loop.
+ *
+ * @details The ADC driver is only held for the burst. It is taken and freed in the main loop
+ *          and in its interrupt, so a burst that finds it in use waits for the next interval.
+ */
+static void burst_start(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    if (nrf_drv_adc_init(NULL, adc_evt_handler) != NRF_SUCCESS)
+    {
+        m_busy = false;
+        return;
+    }
+    for (uint8_t i = 0; i < BATT_MON_SAMPLES; i++)
+    {
+        nrf_drv_adc_channel_enable(&m_channels[i]);
+    }
+
+    divider_enable(true);
+    nrf_delay_us(BATT_MON_SETTLE_US);
+
+    if (nrf_drv_adc_buffer_convert(m_buf, BATT_MON_SAMPLES) != NRF_SUCCESS)
+    {
+        divider_enable(false);
+        nrf_drv_adc_uninit();
+        m_busy = false;
+        return;
+    }
+    nrf_drv_adc_sample();
+}
+
+
+static void timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    // A burst still running covers this interval.
+    if (m_busy)
+    {
+        return;
+    }
+    m_busy = true;
+    if (app_sched_event_put(NULL, 0, burst_start) != NRF_SUCCESS)
+    {
+        m_busy = false;
+    }
+}
+
+
+ret_code_t batt_mon_init(batt_mon_handler_t handler)
+{
+    ret_code_t err_code;
+
+    m_handler = handler;
+
+    divider_enable(false);
+    nrf_gpio_cfg_output(VOL_EN);
+
+    for (uint8_t i = 0; i < BATT_MON_SAMPLES; i++)
+    {
+        m_channels[i] = (nrf_drv_adc_channel_t)NRF_DRV_ADC_DEFAULT_CHANNEL(
+                            (nrf_adc_config_input_t)(1 << BATT_MON_AIN));
+        m_channels[i].config.config.input = NRF_ADC_CONFIG_SCALING_INPUT_ONE_THIRD;
+    }
+
+    err_code = app_timer_create(&m_timer, APP_TIMER_MODE_REPEATED, timer_handler);
+    VERIFY_SUCCESS(err_code);
+    err_code = app_timer_start(m_timer, BATT_MON_TICKS(BATT_MON_INTERVAL_S * 1000), NULL);
+    VERIFY_SUCCESS(err_code);
+
+    timer_handler(NULL);
+    return NRF_SUCCESS;
+}
+
+
+uint16_t batt_mon_mv_get(void)
+{
+    return m_mv;
+}
+
+
+bool batt_mon_is_low(void)
+{
+    return m_low;
+}
+
+#endif //NRF_MODULE_ENABLED(BATT_MON)
@@ -0,0 +1,40 @@
+#ifndef _BATT_MON_H_
+#define _BATT_MON_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* Battery monitor, on the divider switched by VOL_EN:
+ *
+ *   window    every BATT_MON_INTERVAL_S seconds VOL_EN turns the divider on, it settles for
+ *             BATT_MON_SETTLE_US, then one burst of BATT_MON_SAMPLES conversions runs in the
+ *             ADC interrupt, back to back; VOL_EN goes off with the last one, so the divider
+ *             draws current for well under a millisecond
+ *   average   the burst is summed and divided once, in the main loop; BATT_MON_FULL_SCALE_MV
+ *             is the battery voltage that reads 1023, divider and ADC prescaler together
+ *   levels    low below BATT_MON_LOW_MV, normal again above BATT_MON_LOW_MV plus
+ *             BATT_MON_HYST_MV, so a motor run that pulls the battery down for a moment
+ *             does not flip the level back and forth
+ *
+ * The handler gets the level on every change, and once after the first burst. */
+
+/**@brief Called from the main loop when the battery level changes.
+ *
+ * @param[in] low  Battery below BATT_MON_LOW_MV.
+ * @param[in] mv   Battery voltage of the burst.
+ */
+typedef void (* batt_mon_handler_t)(bool low, uint16_t mv);
+
+/**@brief Set up VOL_EN and the ADC, and start with a burst right away.
+ *
+ * @details Call after app_timer and app_scheduler.
+ */
+ret_code_t batt_mon_init(batt_mon_handler_t handler);
+
+/**@brief Battery voltage of the last burst, in mV; 0 before the first one. */
+uint16_t batt_mon_mv_get(void);
+
+/**@brief Whether the battery is at the low level. */
+bool batt_mon_is_low(void);
+
+#endif
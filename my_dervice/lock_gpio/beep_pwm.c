@@ -0,0 +1,262 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(BEEP_PWM)
+#include "beep_pwm.h"
+#include "lock_gpio.h"
+#include "nrf_gpio.h"
+#include "app_timer.h"
+#if NRF_MODULE_ENABLED(ENERGY)
+#include "energy.h"
+#endif
+#if defined(NRF51)
+#include "nrf_timer.h"
+#include "nrf_drv_gpiote.h"
+#include "nrf_drv_ppi.h"
+#else
+#include "nrf_drv_pwm.h"
+#endif
+
+#if defined(NRF51)
+#if !NRF_MODULE_ENABLED(PPI) || !NRF_MODULE_ENABLED(GPIOTE)
+#error "beep_pwm needs PPI_ENABLED and GPIOTE_ENABLED on the nRF51"
+#endif
+#if (BEEP_PWM_TIMER_INSTANCE != 1) && (BEEP_PWM_TIMER_INSTANCE != 2)
+#error "BEEP_PWM_TIMER_INSTANCE has to be 1 or 2, TIMER0 is the SoftDevice's"
+#endif
+#if NRF_MODULE_ENABLED(IR_PROX)
+#error "ir_prox runs TIMER1 and TIMER2 itself, beep_pwm needs one of them"
+#endif
+#if NRF_MODULE_ENABLED(BENCH) && (BENCH_TIMER_INSTANCE == BEEP_PWM_TIMER_INSTANCE)
+#error "bench and beep_pwm need a TIMER each"
+#endif
+#if (BEEP_PWM_TIMER_INSTANCE == 1) && TIMER1_ENABLED
+#error "beep_pwm runs TIMER1 itself, set TIMER1_ENABLED to 0"
+#endif
+#if (BEEP_PWM_TIMER_INSTANCE == 2) && (TIMER2_ENABLED || NRF_MODULE_ENABLED(UART_FRAME))
+#error "beep_pwm runs TIMER2 itself, set TIMER2_ENABLED and UART_FRAME_ENABLED to 0, or use TIMER1"
+#endif
+
+#define BEEP_TIMER  CONCAT_2(NRF_TIMER, BEEP_PWM_TIMER_INSTANCE)
+#else
+#if !PWM_ENABLED || !CONCAT_3(PWM, BEEP_PWM_PWM_INSTANCE, _ENABLED)
+#error "beep_pwm needs PWM_ENABLED and its instance on the nRF52"
+#endif
+#endif
+
+/**@brief Microseconds of @p ticks of app_timer. */
+#define TICKS_US(ticks)  ((uint32_t)ROUNDED_DIV((uint64_t)(ticks) * 1000000 * (APP_TIMER_CONFIG_PRESCALER + 1), \
+                                                APP_TIMER_CLOCK_FREQ))
+
+#if defined(NRF51)
+static nrf_ppi_channel_t m_ppi_active;  /**< CC0: end of the active time. */
+static nrf_ppi_channel_t m_ppi_period;  /**< CC1: end of the period. */
+#else
+static nrf_drv_pwm_t const m_pwm = NRF_DRV_PWM_INSTANCE(BEEP_PWM_PWM_INSTANCE);
+static nrf_pwm_values_common_t m_seq_value;
+static nrf_pwm_sequence_t const m_seq =
+{
+    .values.p_common = &m_seq_value,
+    .length          = 1,
+    .repeats         = 0,
+    .end_delay       = 0,
+};
+#endif
+
+
+/**@brief Active and inactive time of a low_power_pwm period, in us. */
+static void times_get(beep_pwm_t const * p_beep, uint32_t * p_active_us, uint32_t * p_period_us)
+{
+    uint32_t active   = ((p_beep->duty_cycle * p_beep->period) >> 8) + APP_TIMER_MIN_TIMEOUT_TICKS;
+    uint32_t inactive = (((p_beep->period - p_beep->duty_cycle) * p_beep->period) >> 8) +
+                        APP_TIMER_MIN_TIMEOUT_TICKS;
+
+    *p_active_us = TICKS_US(active);
+    *p_period_us = TICKS_US(active + inactive);
+}
+
+
+static void pin_idle(beep_pwm_t const * p_beep)
+{
+    nrf_gpio_pin_write(p_beep->pin, !p_beep->active_high);
+}
+
+
+/**@brief Start the tone, or hold the pin for 0 % and 100 %. */
+static void tone_start(beep_pwm_t * p_beep)
+{
+    uint32_t active_us;
+    uint32_t period_us;
+
+    if ((p_beep->duty_cycle == 0) || (p_beep->duty_cycle == p_beep->period))
+    {
+        nrf_gpio_pin_write(p_beep->pin, (p_beep->duty_cycle != 0) == p_beep->active_high);
+        return;
+    }
+    times_get(p_beep, &active_us, &period_us);
+
+#if defined(NRF51)
+    nrf_timer_task_trigger(BEEP_TIMER, NRF_TIMER_TASK_CLEAR);
+    nrf_timer_cc_write(BEEP_TIMER, NRF_TIMER_CC_CHANNEL0, active_us);
+    nrf_timer_cc_write(BEEP_TIMER, NRF_TIMER_CC_CHANNEL1, period_us);
+    // Enabling the task puts the pin to the initial level, active: in step with CC0.
+    nrf_drv_gpiote_out_task_enable(p_beep->pin);
+    nrf_timer_task_trigger(BEEP_TIMER, NRF_TIMER_TASK_START);
+#else
+    // Polarity bit clear: the period starts high and falls at the compare.
+    m_seq_value = (uint16_t)active_us | (p_beep->active_high ? 0 : 0x8000);
+    nrf_pwm_configure(m_pwm.p_registers, NRF_PWM_CLK_1MHz, NRF_PWM_MODE_UP, (uint16_t)period_us);
+    nrf_drv_pwm_simple_playback(&m_pwm, &m_seq, 1, NRF_DRV_PWM_FLAG_LOOP);
+#endif
+}
+
+
+static void tone_stop(beep_pwm_t * p_beep)
+{
+#if defined(NRF51)
+    nrf_timer_task_trigger(BEEP_TIMER, NRF_TIMER_TASK_STOP);
+    nrf_drv_gpiote_out_task_disable(p_beep->pin);
+#else
+    UNUSED_RETURN_VALUE(nrf_drv_pwm_stop(&m_pwm, true));
+#endif
+    pin_idle(p_beep);
+}
+
+
+#if defined(NRF51)
+static ret_code_t hw_init(beep_pwm_t * p_beep)
+{
+    ret_code_t                  err_code;
+    nrf_drv_gpiote_out_config_t out_config = GPIOTE_CONFIG_OUT_TASK_TOGGLE(p_beep->active_high);
+    uint32_t                    toggle;
+
+    if (!nrf_drv_gpiote_is_init())
+    {
+        err_code = nrf_drv_gpiote_init();
+        VERIFY_SUCCESS(err_code);
+    }
+    err_code = nrf_drv_gpiote_out_init(p_beep->pin, &out_config);
+    VERIFY_SUCCESS(err_code);
+    // Held by the GPIO latch until the first tone.
+    nrf_drv_gpiote_out_task_disable(p_beep->pin);
+    toggle = nrf_drv_gpiote_out_task_addr_get(p_beep->pin);
+
+    err_code = nrf_drv_ppi_init();
+    if ((err_code != NRF_SUCCESS) && (err_code != NRF_ERROR_MODULE_ALREADY_INITIALIZED))
+    {
+        return err_code;
+    }
+    err_code = nrf_drv_ppi_channel_alloc(&m_ppi_active);
+    VERIFY_SUCCESS(err_code);
+    err_code = nrf_drv_ppi_channel_assign(m_ppi_active,
+                   (uint32_t)nrf_timer_event_address_get(BEEP_TIMER, NRF_TIMER_EVENT_COMPARE0), toggle);
+    VERIFY_SUCCESS(err_code);
+    err_code = nrf_drv_ppi_channel_enable(m_ppi_active);
+    VERIFY_SUCCESS(err_code);
+    err_code = nrf_drv_ppi_channel_alloc(&m_ppi_period);
+    VERIFY_SUCCESS(err_code);
+    err_code = nrf_drv_ppi_channel_assign(m_ppi_period,
+                   (uint32_t)nrf_timer_event_address_get(BEEP_TIMER, NRF_TIMER_EVENT_COMPARE1), toggle);
+    VERIFY_SUCCESS(err_code);
+    err_code = nrf_drv_ppi_channel_enable(m_ppi_period);
+    VERIFY_SUCCESS(err_code);
+
+    nrf_timer_mode_set(BEEP_TIMER, NRF_TIMER_MODE_TIMER);
+    nrf_timer_bit_width_set(BEEP_TIMER, NRF_TIMER_BIT_WIDTH_16);
+    nrf_timer_frequency_set(BEEP_TIMER, NRF_TIMER_FREQ_1MHz);
+    nrf_timer_shorts_enable(BEEP_TIMER, NRF_TIMER_SHORT_COMPARE1_CLEAR_MASK);
+    return NRF_SUCCESS;
+}
+#else
+static ret_code_t hw_init(beep_pwm_t * p_beep)
+{
+    nrf_drv_pwm_config_t config = NRF_DRV_PWM_DEFAULT_CONFIG;
+
+    // Inverted for active low: the pin idles high between tones.
+    config.output_pins[0] = (uint8_t)p_beep->pin | (p_beep->active_high ? 0 : NRF_DRV_PWM_PIN_INVERTED);
+    config.output_pins[1] = NRF_DRV_PWM_PIN_NOT_USED;
+    config.output_pins[2] = NRF_DRV_PWM_PIN_NOT_USED;
+    config.output_pins[3] = NRF_DRV_PWM_PIN_NOT_USED;
+    config.base_clock     = NRF_PWM_CLK_1MHz;
+    config.count_mode     = NRF_PWM_MODE_UP;
+    config.load_mode      = NRF_PWM_LOAD_COMMON;
+    config.step_mode      = NRF_PWM_STEP_AUTO;
+    return nrf_drv_pwm_init(&m_pwm, &config, NULL);
+}
+#endif
+
+
+ret_code_t beep_pwm_init(beep_pwm_t * p_beep, low_power_pwm_config_t const * p_config,
+                         app_timer_timeout_handler_t handler)
+{
+    uint32_t mask = p_config->bit_mask;
+
+    UNUSED_PARAMETER(handler);
+    if ((mask == 0) || ((mask & (mask - 1)) != 0) || (p_config->period == 0))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    p_beep->active_high = p_config->active_high;
+    p_beep->running     = false;
+    p_beep->period      = p_config->period;
+    p_beep->duty_cycle  = 0;
+    p_beep->bit_mask    = mask;
+    for (p_beep->pin = 0; (mask & 1) == 0; mask >>= 1)
+    {
+        p_beep->pin++;
+    }
+
+    pin_idle(p_beep);
+    nrf_gpio_cfg_output(p_beep->pin);
+    return hw_init(p_beep);
+}
+
+
+ret_code_t beep_pwm_start(beep_pwm_t * p_beep, uint32_t pin_bit_mask)
+{
+    if (pin_bit_mask != p_beep->bit_mask)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if (p_beep->running)
+    {
+        return NRF_SUCCESS;
+    }
+    p_beep->running = true;
+    tone_start(p_beep);
+#if NRF_MODULE_ENABLED(ENERGY)
+    energy_on(ENERGY_BUZZER);
+#endif
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t beep_pwm_stop(beep_pwm_t * p_beep)
+{
+    if (p_beep->running)
+    {
+        p_beep->running = false;
+        tone_stop(p_beep);
+#if NRF_MODULE_ENABLED(ENERGY)
+        energy_off(ENERGY_BUZZER);
+#endif
+    }
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t beep_pwm_duty_set(beep_pwm_t * p_beep, uint8_t duty_cycle)
+{
+    if (duty_cycle > p_beep->period)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    p_beep->duty_cycle = duty_cycle;
+    if (p_beep->running)
+    {
+        tone_stop(p_beep);
+        tone_start(p_beep);
+    }
+    return NRF_SUCCESS;
+}
+
+#endif //NRF_MODULE_ENABLED(BEEP_PWM)
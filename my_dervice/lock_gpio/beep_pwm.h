@@ -0,0 +1,49 @@
+#ifndef _BEEP_PWM_H_
+#define _BEEP_PWM_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "low_power_pwm.h"
+
+/* The buzzer tone from hardware, behind the calls of low_power_pwm:
+ *
+ *   nRF51     BEEP_PWM_TIMER_INSTANCE at 1 MHz, CC0 at the end of the active time and CC1 at
+ *             the end of the period, which clears the timer; both toggle the pin through a
+ *             GPIOTE task and PPI
+ *   nRF52     the PWM peripheral, one channel looping a one value sequence
+ *   timing    period and duty cycle mean what they do for low_power_pwm: the active and
+ *             inactive times of its app_timer single shots, so a tone set up for it keeps its
+ *             pitch; only now no interrupt runs while it plays
+ *
+ * One instance, one pin. The handler of low_power_pwm_init has no events to be called for. */
+
+/**@brief A buzzer, configured like a low_power_pwm_t. */
+typedef struct
+{
+    bool     active_high;
+    bool     running;
+    uint8_t  period;
+    uint8_t  duty_cycle;
+    uint32_t bit_mask;      /**< The pin, as a mask. */
+    uint32_t pin;
+} beep_pwm_t;
+
+/**@brief As low_power_pwm_init; p_port and p_timer_id are not used.
+ *
+ * @retval NRF_SUCCESS              Ready, stopped.
+ * @retval NRF_ERROR_INVALID_PARAM  Not exactly one pin in bit_mask, or a zero period.
+ * @return Any error from nrf_drv_gpiote or nrf_drv_ppi (nRF51), or nrf_drv_pwm (nRF52).
+ */
+ret_code_t beep_pwm_init(beep_pwm_t * p_beep, low_power_pwm_config_t const * p_config,
+                         app_timer_timeout_handler_t handler);
+
+/**@brief As low_power_pwm_start; @p pin_bit_mask must be the pin of the instance. */
+ret_code_t beep_pwm_start(beep_pwm_t * p_beep, uint32_t pin_bit_mask);
+
+/**@brief As low_power_pwm_stop: the pin is left inactive. */
+ret_code_t beep_pwm_stop(beep_pwm_t * p_beep);
+
+/**@brief As low_power_pwm_duty_set, also while playing. */
+ret_code_t beep_pwm_duty_set(beep_pwm_t * p_beep, uint8_t duty_cycle);
+
+#endif
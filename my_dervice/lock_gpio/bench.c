@@ -0,0 +1,355 @@
+// Its clock is what crit_prof reads: keep the plain critical regions here.
+#define CRIT_PROF_SKIP
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(BENCH)
+#include "bench.h"
+#include "nrf_timer.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "app_util_platform.h"
+#include "SEGGER_RTT.h"
+#if NRF_MODULE_ENABLED(HF_CLOCK)
+#include "hf_clock.h"
+#endif
+
+#if (BENCH_TIMER_INSTANCE != 1) && (BENCH_TIMER_INSTANCE != 2)
+#error "BENCH_TIMER_INSTANCE has to be 1 or 2, TIMER0 is the SoftDevice's"
+#endif
+#if NRF_MODULE_ENABLED(IR_PROX)
+#error "ir_prox runs TIMER1 and TIMER2 itself, bench needs one of them"
+#endif
+#if (BENCH_TIMER_INSTANCE == 1) && TIMER1_ENABLED
+#error "bench runs TIMER1 itself, set TIMER1_ENABLED to 0"
+#endif
+#if (BENCH_TIMER_INSTANCE == 2) && (TIMER2_ENABLED || NRF_MODULE_ENABLED(UART_FRAME))
+#error "bench runs TIMER2 itself, set TIMER2_ENABLED and UART_FRAME_ENABLED to 0, or use TIMER1"
+#endif
+
+#define BENCH_TIMER         CONCAT_2(NRF_TIMER, BENCH_TIMER_INSTANCE)
+#define BENCH_IRQn          CONCAT_3(TIMER, BENCH_TIMER_INSTANCE, _IRQn)
+#define BENCH_IRQHandler    CONCAT_3(TIMER, BENCH_TIMER_INSTANCE, _IRQHandler)
+#define TICKS_PER_US        16
+
+#if defined(NRF51)
+#define TIMER_WIDEN         1       /**< TIMER1 and TIMER2 count 16 bits at most. */
+#else
+#define TIMER_WIDEN         0
+#endif
+
+#if defined(__CORTEX_M) && (__CORTEX_M >= 0x03)
+#define CYCLES_DWT          1
+#else
+#define CYCLES_DWT          0
+#endif
+
+#define OVERHEAD_RUNS       8
+
+APP_TIMER_DEF(m_delay_timer);
+
+static bench_case_t const * m_cases[BENCH_CASES_MAX];
+static uint8_t              m_case_count;
+static uint8_t              m_next;             /**< Case the next event runs. */
+static bool                 m_running;
+static bool                 m_timer_created;
+static uint32_t             m_overhead;         /**< Cycles of two back to back bench_cycles(). */
+static bench_probe_t      * mp_probes;
+#if TIMER_WIDEN
+static volatile uint32_t    m_overflows;
+#endif
+
+
+#if TIMER_WIDEN
+/**@brief Counter wrapped. At the highest application priority, so nothing that reads the
+ *        counter runs between the event cleared and the overflow counted. */
+void BENCH_IRQHandler(void)
+{
+    if (nrf_timer_event_check(BENCH_TIMER, NRF_TIMER_EVENT_COMPARE3))
+    {
+        nrf_timer_event_clear(BENCH_TIMER, NRF_TIMER_EVENT_COMPARE3);
+        m_overflows++;
+    }
+}
+#endif
+
+
+uint32_t bench_ticks(void)
+{
+    uint32_t ticks;
+
+    CRITICAL_REGION_ENTER();
+    nrf_timer_task_trigger(BENCH_TIMER, NRF_TIMER_TASK_CAPTURE0);
+    ticks = nrf_timer_cc_read(BENCH_TIMER, NRF_TIMER_CC_CHANNEL0);
+#if TIMER_WIDEN
+    {
+        uint32_t overflows = m_overflows;
+
+        // Wrapped, and the interrupt waits for the critical region: a low count is after it.
+        if (nrf_timer_event_check(BENCH_TIMER, NRF_TIMER_EVENT_COMPARE3) && (ticks < 0x8000))
+        {
+            overflows++;
+        }
+        ticks |= overflows << 16;
+    }
+#endif
+    CRITICAL_REGION_EXIT();
+
+    return ticks;
+}
+
+
+uint32_t bench_cycles(void)
+{
+#if CYCLES_DWT
+    return DWT->CYCCNT;
+#else
+    return bench_ticks();
+#endif
+}
+
+
+uint32_t bench_cycles_to_us(uint32_t cycles)
+{
+#if CYCLES_DWT
+    return (uint32_t)(((uint64_t)cycles * 1000000) / SystemCoreClock);
+#else
+    return cycles / TICKS_PER_US;
+#endif
+}
+
+
+static uint32_t cycles_net(uint32_t cycles)
+{
+    return (cycles > m_overhead) ? (cycles - m_overhead) : 0;
+}
+
+
+ret_code_t bench_init(void)
+{
+    nrf_timer_task_trigger(BENCH_TIMER, NRF_TIMER_TASK_STOP);
+    nrf_timer_task_trigger(BENCH_TIMER, NRF_TIMER_TASK_CLEAR);
+    nrf_timer_mode_set(BENCH_TIMER, NRF_TIMER_MODE_TIMER);
+    nrf_timer_frequency_set(BENCH_TIMER, NRF_TIMER_FREQ_16MHz);
+#if TIMER_WIDEN
+    nrf_timer_bit_width_set(BENCH_TIMER, NRF_TIMER_BIT_WIDTH_16);
+    // Matches when the counter wraps to 0.
+    nrf_timer_cc_write(BENCH_TIMER, NRF_TIMER_CC_CHANNEL3, 0);
+    nrf_timer_event_clear(BENCH_TIMER, NRF_TIMER_EVENT_COMPARE3);
+    nrf_timer_int_enable(BENCH_TIMER, NRF_TIMER_INT_COMPARE3_MASK);
+    m_overflows = 0;
+    NVIC_ClearPendingIRQ(BENCH_IRQn);
+    NVIC_SetPriority(BENCH_IRQn, APP_IRQ_PRIORITY_HIGH);
+    NVIC_EnableIRQ(BENCH_IRQn);
+#else
+    nrf_timer_bit_width_set(BENCH_TIMER, NRF_TIMER_BIT_WIDTH_32);
+#endif
+#if CYCLES_DWT
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT       = 0;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    nrf_timer_task_trigger(BENCH_TIMER, NRF_TIMER_TASK_START);
+
+    m_overhead = UINT32_MAX;
+    for (uint8_t i = 0; i < OVERHEAD_RUNS; i++)
+    {
+        uint32_t start = bench_cycles();
+
+        m_overhead = MIN(m_overhead, bench_cycles() - start);
+    }
+    return NRF_SUCCESS;
+}
+
+
+void bench_sw_start(bench_sw_t * p_sw)
+{
+    p_sw->start = bench_ticks();
+}
+
+
+uint32_t bench_sw_stop(bench_sw_t * p_sw)
+{
+    uint32_t lap = bench_ticks() - p_sw->start;
+
+    p_sw->total += lap;
+    p_sw->laps++;
+    return lap;
+}
+
+
+void bench_probe_add(bench_probe_t * p_probe, uint32_t cycles)
+{
+    cycles = cycles_net(cycles);
+
+    CRITICAL_REGION_ENTER();
+    if (!p_probe->listed)
+    {
+        p_probe->listed = true;
+        p_probe->p_next = mp_probes;
+        mp_probes       = p_probe;
+    }
+    p_probe->count++;
+    p_probe->total += cycles;
+    p_probe->min    = MIN(p_probe->min, cycles);
+    p_probe->max    = MAX(p_probe->max, cycles);
+    CRITICAL_REGION_EXIT();
+}
+
+
+void bench_probes_report(void)
+{
+    for (bench_probe_t * p_probe = mp_probes; p_probe != NULL; p_probe = p_probe->p_next)
+    {
+        bench_probe_t probe;
+
+        CRITICAL_REGION_ENTER();
+        probe            = *p_probe;
+        p_probe->count   = 0;
+        p_probe->total   = 0;
+        p_probe->min     = UINT32_MAX;
+        p_probe->max     = 0;
+        CRITICAL_REGION_EXIT();
+
+        if (probe.count != 0)
+        {
+            SEGGER_RTT_printf(0, "probe %s: %u hits, min %u avg %u max %u\r\n",
+                              probe.p_name, probe.count, probe.min,
+                              (unsigned)(probe.total / probe.count), probe.max);
+        }
+    }
+}
+
+
+ret_code_t bench_case_add(bench_case_t const * p_case)
+{
+    if (m_running)
+    {
+        return NRF_ERROR_BUSY;
+    }
+    if (m_case_count >= BENCH_CASES_MAX)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+    m_cases[m_case_count++] = p_case;
+    return NRF_SUCCESS;
+}
+
+
+/**@brief The run has ended, done or not. */
+static void run_end(void)
+{
+    m_running = false;
+#if NRF_MODULE_ENABLED(HF_CLOCK)
+    hf_clock_release(HF_CLOCK_USER_BENCH);
+#endif
+}
+
+
+static void case_run(void * p_event_data, uint16_t event_size)
+{
+    bench_case_t const * p_case;
+    uint16_t             runs;
+    uint32_t             min   = UINT32_MAX;
+    uint32_t             max   = 0;
+    uint64_t             total = 0;
+    bool                 ok;
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    if (m_next >= m_case_count)
+    {
+        bench_probes_report();
+        SEGGER_RTT_printf(0, "bench: done\r\n");
+        run_end();
+        return;
+    }
+    if (m_next == 0)
+    {
+        SEGGER_RTT_printf(0, "bench: %u cases, cycles, %u taken off each\r\n",
+                          m_case_count, m_overhead);
+    }
+
+    p_case = m_cases[m_next++];
+    runs   = MAX(p_case->iterations, 1);
+
+    // State set up on first use and the first flash reads are not counted.
+    ok = p_case->run(p_case->p_context);
+    for (uint16_t i = 0; ok && (i < runs); i++)
+    {
+        uint32_t start = bench_cycles();
+        uint32_t cycles;
+
+        ok     = p_case->run(p_case->p_context);
+        cycles = cycles_net(bench_cycles() - start);
+        total += cycles;
+        min    = MIN(min, cycles);
+        max    = MAX(max, cycles);
+    }
+
+    if (ok)
+    {
+        SEGGER_RTT_printf(0, "bench %s: %u runs, min %u avg %u max %u, %u us\r\n",
+                          p_case->p_name, runs, min, (unsigned)(total / runs), max,
+                          bench_cycles_to_us(min));
+    }
+    else
+    {
+        SEGGER_RTT_printf(0, "bench %s: FAIL\r\n", p_case->p_name);
+    }
+
+    // Each case in an event of its own, so the BLE events and the watchdog get their turn.
+    if (app_sched_event_put(NULL, 0, case_run) != NRF_SUCCESS)
+    {
+        run_end();
+    }
+}
+
+
+static void delay_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    if (app_sched_event_put(NULL, 0, case_run) != NRF_SUCCESS)
+    {
+        run_end();
+    }
+}
+
+
+ret_code_t bench_run(uint32_t delay_ms)
+{
+    ret_code_t err_code;
+
+    if (m_running)
+    {
+        return NRF_ERROR_BUSY;
+    }
+    if (!m_timer_created)
+    {
+        err_code = app_timer_create(&m_delay_timer, APP_TIMER_MODE_SINGLE_SHOT, delay_timer_handler);
+        VERIFY_SUCCESS(err_code);
+        m_timer_created = true;
+    }
+
+    m_next    = 0;
+    m_running = true;
+#if NRF_MODULE_ENABLED(HF_CLOCK)
+    // TIMER counts the RC oscillator otherwise, a few percent off.
+    hf_clock_request(HF_CLOCK_USER_BENCH);
+#endif
+    if (delay_ms == 0)
+    {
+        err_code = app_sched_event_put(NULL, 0, case_run);
+    }
+    else
+    {
+        err_code = app_timer_start(m_delay_timer, APP_TIMER_TICKS(delay_ms, APP_TIMER_CONFIG_PRESCALER), NULL);
+    }
+    if (err_code != NRF_SUCCESS)
+    {
+        run_end();
+    }
+    return err_code;
+}
+
+#endif //NRF_MODULE_ENABLED(BENCH)
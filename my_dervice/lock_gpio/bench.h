@@ -0,0 +1,117 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_common.h"
+
+/* Timing with numbers that can be reproduced, for the before and after of optimizations:
+ *
+ *   stopwatch  BENCH_TIMER_INSTANCE at 16 MHz; the 16-bit TIMER1/TIMER2 of the nRF51 are
+ *              widened to 32 bits in software by their overflow interrupt, every 4.1 ms
+ *   cycles     the DWT cycle counter on Cortex-M3/M4; on the nRF51 the CPU runs from the
+ *              same 16 MHz, so the stopwatch counts cycles
+ *   probes     cycles spent in a piece of code, with BENCH_PROBE_START/BENCH_PROBE_STOP:
+ *              count, min, max and total since the last report; the cost of reading the
+ *              counter is taken off, here and in the runner
+ *   runner     registered cases, one per app_scheduler event, each run once to warm up and
+ *              then as often as it asks; min, average and max over RTT, one line each
+ *
+ * Interrupts stay on, the SoftDevice among them: the max shows what it took, the min is the
+ * number to compare between builds. */
+
+/**@brief Cycles spent in a piece of code. Define with @ref BENCH_PROBE_DEF. */
+typedef struct bench_probe_s
+{
+    char const           * p_name;
+    struct bench_probe_s * p_next;      /**< In the list of reported probes, once hit. */
+    uint32_t               count;
+    uint32_t               min;
+    uint32_t               max;
+    uint64_t               total;
+    bool                   listed;
+} bench_probe_t;
+
+/**@brief A benchmark case.
+ *
+ * @details @p run does the work once and tells whether it came out right; a wrong result is
+ *          reported as FAIL, so a broken optimization is not taken for a fast one.
+ */
+typedef struct
+{
+    char const * p_name;
+    bool      (* run)(void * p_context);
+    void       * p_context;
+    uint16_t     iterations;            /**< Timed runs after the warm-up, 0 for one. */
+} bench_case_t;
+
+/**@brief Stopwatch of @ref bench_sw_start and @ref bench_sw_stop. */
+typedef struct
+{
+    uint32_t start;
+    uint32_t total;                     /**< Stopwatch ticks of all laps. */
+    uint32_t laps;
+} bench_sw_t;
+
+#if NRF_MODULE_ENABLED(BENCH)
+/**@brief Define a probe; at file scope. */
+#define BENCH_PROBE_DEF(probe, name)    static bench_probe_t probe = {.p_name = (name), .min = UINT32_MAX}
+/**@brief Take the cycle count into a new local @p t. */
+#define BENCH_PROBE_START(t)            uint32_t t = bench_cycles()
+/**@brief Add the cycles since @ref BENCH_PROBE_START to a probe. */
+#define BENCH_PROBE_STOP(probe, t)      bench_probe_add(&(probe), bench_cycles() - (t))
+#else
+#define BENCH_PROBE_DEF(probe, name)    extern bench_probe_t probe
+#define BENCH_PROBE_START(t)
+#define BENCH_PROBE_STOP(probe, t)
+#endif
+
+/**@brief Start the stopwatch timer and the cycle counter, and measure what reading it costs. */
+ret_code_t bench_init(void);
+
+/**@brief Stopwatch ticks at 16 MHz since @ref bench_init; wraps after 268 s. Safe from interrupts. */
+uint32_t bench_ticks(void);
+
+/**@brief Cycle count; wraps. Safe from interrupts. */
+uint32_t bench_cycles(void);
+
+/**@brief Microseconds of a number of cycles. */
+uint32_t bench_cycles_to_us(uint32_t cycles);
+
+/**@brief Start a lap; clear @p p_sw before the first. */
+void bench_sw_start(bench_sw_t * p_sw);
+
+/**@brief End a lap.
+ *
+ * @return Stopwatch ticks since @ref bench_sw_start.
+ */
+uint32_t bench_sw_stop(bench_sw_t * p_sw);
+
+/**@brief Add a measurement to a probe; used by @ref BENCH_PROBE_STOP. Safe from interrupts. */
+void bench_probe_add(bench_probe_t * p_probe, uint32_t cycles);
+
+/**@brief Register a case; @p p_case must stay valid.
+ *
+ * @retval NRF_SUCCESS       Registered.
+ * @retval NRF_ERROR_NO_MEM  BENCH_CASES_MAX cases registered already.
+ * @retval NRF_ERROR_BUSY    The cases are running.
+ */
+ret_code_t bench_case_add(bench_case_t const * p_case);
+
+/**@brief Register the cases of the modules that are built: CRC16, CRC32, SHA-256, the stream
+ *        frame codec, an fds record lookup and, with PN532_SIM, a UID read from the emulator.
+ */
+void bench_cases_add(void);
+
+/**@brief Run the cases after @p delay_ms, then report the probes.
+ *
+ * @details From the main loop, one case per app_scheduler event.
+ *
+ * @retval NRF_ERROR_BUSY  Running already.
+ */
+ret_code_t bench_run(uint32_t delay_ms);
+
+/**@brief Report the probes that have been hit over RTT and start them over. */
+void bench_probes_report(void);
+
+#endif
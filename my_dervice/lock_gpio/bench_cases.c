@@ -0,0 +1,445 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(BENCH)
+#include "bench.h"
+#include "crc16.h"
+#include "crc32.h"
+#include "sha256.h"
+#include "stream_frame.h"
+#include "fds.h"
+#include "pn532_sim.h"
+#include "pn532_i2c.h"
+#include "nfc_ndef_msg_parser.h"
+#include "nfc_t2t_parser.h"
+#include "nfc_t4t_cc_file.h"
+#include <string.h>
+
+/* Inputs and results are fixed, so the numbers of two builds compare; the expected values are
+ * those of the reference implementations. */
+
+#define DATA_LEN            256
+#define CODEC_LEN           128
+#define FDS_FILE_ID         0xBE00  /**< Nobody writes it: each lookup walks all the pages. */
+#define FDS_RECORD_KEY      0xBE01
+#define NFC_RECORDS         4
+#define NFC_TLVS            4
+#define NFC_T2T_READ_LEN    16      /**< Bytes of one READ, as pn532_t2t fetches them. */
+#define NFC_FUZZ_INPUTS     32      /**< Mutated inputs per parser and run of nfc_fuzz. */
+#define NFC_FUZZ_SEED       0x1F2E3D4C
+
+#define NFC_PARSERS         (NRF_MODULE_ENABLED(NFC_NDEF_MSG_PARSER) || NRF_MODULE_ENABLED(NFC_T2T_PARSER) || \
+                             NRF_MODULE_ENABLED(NFC_T4T_CC_FILE_PARSER))
+
+static uint8_t m_data[DATA_LEN];    /**< (i * 31 + 7) & 0xFF. */
+
+
+#if NRF_MODULE_ENABLED(CRC16)
+static bool crc16_run(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+    return crc16_compute(m_data, DATA_LEN, NULL) == 0xB075;
+}
+
+static bench_case_t const m_crc16_case = {"crc16", crc16_run, NULL, 32};
+#endif
+
+
+#if NRF_MODULE_ENABLED(CRC32)
+static bool crc32_run(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+    return crc32_compute(m_data, DATA_LEN, NULL) == 0x0CE9D363;
+}
+
+static bench_case_t const m_crc32_case = {"crc32", crc32_run, NULL, 32};
+#endif
+
+
+static bool sha256_run(void * p_context)
+{
+    static uint8_t const expected[32] =
+    {
+        0xC8, 0xC6, 0xE0, 0x2D, 0x59, 0x7F, 0xA6, 0xC4, 0x07, 0xA5, 0xFE, 0xC3, 0x0C, 0x98, 0x1C, 0x7B,
+        0xBA, 0xD0, 0x89, 0x72, 0x24, 0x0E, 0xEA, 0x89, 0x84, 0x1B, 0x8F, 0x37, 0xE2, 0xFB, 0xF3, 0x2C
+    };
+    sha256_context_t ctx;
+    uint8_t          hash[32];
+
+    UNUSED_PARAMETER(p_context);
+    return (sha256_init(&ctx) == NRF_SUCCESS) &&
+           (sha256_update(&ctx, m_data, DATA_LEN) == NRF_SUCCESS) &&
+           (sha256_final(&ctx, hash, 0) == NRF_SUCCESS) &&
+           (memcmp(hash, expected, sizeof(hash)) == 0);
+}
+
+static bench_case_t const m_sha256_case = {"sha256", sha256_run, NULL, 16};
+
+
+#if NRF_MODULE_ENABLED(STREAM_FRAME)
+static bool m_codec_ok;
+
+static void codec_handler(void * p_context, uint8_t * p_data, uint16_t len)
+{
+    UNUSED_PARAMETER(p_context);
+    m_codec_ok = (len == CODEC_LEN) && (memcmp(p_data, m_data, CODEC_LEN) == 0);
+}
+
+/**@brief One payload framed and decoded again. */
+static bool codec_run(void * p_context)
+{
+    static uint8_t     frame[STREAM_FRAME_ENC_MAX(CODEC_LEN)];
+    static uint8_t     buf[STREAM_FRAME_BUF_SIZE(CODEC_LEN)];
+    stream_frame_dec_t dec;
+    uint16_t           len;
+
+    UNUSED_PARAMETER(p_context);
+
+    len = stream_frame_encode(m_data, CODEC_LEN, frame, sizeof(frame));
+    stream_frame_dec_init(&dec, buf, sizeof(buf));
+    m_codec_ok = false;
+    stream_frame_feed(&dec, frame, len, codec_handler, NULL);
+    return (len != 0) && m_codec_ok;
+}
+
+static bench_case_t const m_codec_case = {"frame", codec_run, NULL, 32};
+#endif
+
+
+#if NRF_MODULE_ENABLED(FDS)
+static bool fds_find_run(void * p_context)
+{
+    fds_record_desc_t desc;
+    fds_find_token_t  token;
+
+    UNUSED_PARAMETER(p_context);
+
+    memset(&token, 0, sizeof(token));
+    // Any other answer is fds not up yet.
+    return fds_record_find(FDS_FILE_ID, FDS_RECORD_KEY, &desc, &token) == FDS_ERR_NOT_FOUND;
+}
+
+static bench_case_t const m_fds_case = {"fds_find", fds_find_run, NULL, 16};
+#endif
+
+
+#if NRF_MODULE_ENABLED(PN532_SIM)
+/**@brief InListPassiveTarget against the emulator, bus transfers and frame codec included. */
+static bool pn532_sim_run(void * p_context)
+{
+    uint8_t uid[PN532_UID_MAX_LEN];
+    uint8_t uid_len;
+
+    UNUSED_PARAMETER(p_context);
+    return pn532_sim_is_active() && readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uid_len, 1000);
+}
+
+static bench_case_t const m_pn532_sim_case = {"pn532_uid", pn532_sim_run, NULL, 8};
+#endif
+
+
+#if NFC_PARSERS
+/* The parsers of what a card sends, over dumps of real tags: an NTAG213 as a phone writes it, a
+ * URI and a text record in an NDEF TLV; the message on its own; the CC file of a Type 4 Tag
+ * with its NDEF file at E104h. nfc_fuzz runs the same parsers over mutations of the dumps, as
+ * a malicious or half-read tag would send them, and fails on a result pointing out of the
+ * input or a tag read that does not move on. */
+
+static uint8_t m_ndef_msg[] =
+{
+    0x91, 0x01, 0x0B, 'U', 0x04, 'n', 'o', 'r', 'd', 'i', 'c', '.', 'c', 'o', 'm',
+    0x51, 0x01, 0x08, 'T', 0x02, 'e', 'n', 'l', 'o', 'c', 'k', '!'
+};
+
+static uint8_t m_t2t_dump[T2T_FIRST_DATA_BLOCK_OFFSET + 0x12 * 8] =
+{
+    0x04, 0x6F, 0xD5, 0x36, 0x6A, 0x90, 0x42, 0x80, 0x38, 0x48, 0x00, 0x00, 0xE1, 0x10, 0x12, 0x00,
+    0x03, 0x1B,
+    0x91, 0x01, 0x0B, 'U', 0x04, 'n', 'o', 'r', 'd', 'i', 'c', '.', 'c', 'o', 'm',
+    0x51, 0x01, 0x08, 'T', 0x02, 'e', 'n', 'l', 'o', 'c', 'k', '!',
+    0xFE
+};
+
+static uint8_t m_t4t_cc[] =
+{
+    0x00, 0x0F, 0x20, 0x00, 0x3B, 0x00, 0x34, 0x04, 0x06, 0xE1, 0x04, 0x00, 0x32, 0x00, 0x00
+};
+
+
+/**@brief [p_field, p_field + len) lies in [p_start, p_end). */
+static bool field_is_in(uint8_t const * p_field, uint32_t len, uint8_t const * p_start, uint8_t const * p_end)
+{
+    return (len == 0) || ((p_field >= p_start) && (p_field <= p_end) && (len <= (uint32_t)(p_end - p_field)));
+}
+#endif
+
+
+#if NRF_MODULE_ENABLED(NFC_NDEF_MSG_PARSER)
+__ALIGN(4) static uint8_t m_ndef_desc[NFC_NDEF_PARSER_REQIRED_MEMO_SIZE_CALC(NFC_RECORDS)];
+
+static ret_code_t ndef_parse(uint8_t * p_msg, uint32_t * p_len)
+{
+    uint32_t desc_len = sizeof(m_ndef_desc);
+
+    return ndef_msg_parser(m_ndef_desc, &desc_len, p_msg, p_len);
+}
+
+/**@brief Types, IDs and payloads of the parsed records lie in the message. */
+static bool ndef_is_in(uint8_t const * p_msg, uint32_t len)
+{
+    nfc_ndef_msg_desc_t const * p_desc = (nfc_ndef_msg_desc_t const *)m_ndef_desc;
+
+    if (p_desc->record_count > NFC_RECORDS)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < p_desc->record_count; i++)
+    {
+        nfc_ndef_record_desc_t const      * p_record  = p_desc->pp_record[i];
+        nfc_ndef_bin_payload_desc_t const * p_payload = p_record->p_payload_descriptor;
+
+        if (!field_is_in(p_record->p_type, p_record->type_length, p_msg, p_msg + len) ||
+            !field_is_in(p_record->p_id, p_record->id_length, p_msg, p_msg + len) ||
+            !field_is_in(p_payload->p_payload, p_payload->payload_length, p_msg, p_msg + len))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool ndef_run(void * p_context)
+{
+    nfc_ndef_msg_desc_t const * p_desc = (nfc_ndef_msg_desc_t const *)m_ndef_desc;
+    uint32_t                    len    = sizeof(m_ndef_msg);
+
+    UNUSED_PARAMETER(p_context);
+    return (ndef_parse(m_ndef_msg, &len) == NRF_SUCCESS) && (len == sizeof(m_ndef_msg)) &&
+           (p_desc->record_count == 2) && ndef_is_in(m_ndef_msg, len);
+}
+
+static bench_case_t const m_ndef_case = {"ndef_msg", ndef_run, NULL, 32};
+#endif
+
+
+#if NRF_MODULE_ENABLED(NFC_T2T_PARSER)
+NFC_TYPE_2_TAG_DESC_DEF(m_t2t, NFC_TLVS);
+static uint8_t m_t2t_values[64];
+
+/**@brief Parse a dump as pn532_t2t_read() reads a tag, four pages at a time.
+ *
+ * @retval NRF_ERROR_TIMEOUT   The dump ends before the parser is done, as a tag taken away.
+ * @retval NRF_ERROR_INTERNAL  A READ that did not move the parser on: the reader would ask for
+ *                             the same pages for as long as the tag stays.
+ * @return Otherwise as for type_2_tag_stream_feed().
+ */
+static ret_code_t t2t_parse(uint8_t const * p_dump, uint16_t len)
+{
+    type_2_tag_stream_t stream;
+    ret_code_t          err_code;
+
+    type_2_tag_stream_init(&stream, &NFC_TYPE_2_TAG_DESC(m_t2t), m_t2t_values, sizeof(m_t2t_values));
+
+    while (!type_2_tag_stream_is_done(&stream))
+    {
+        uint16_t next   = type_2_tag_stream_offset(&stream);
+        uint16_t offset = next & ~(T2T_BLOCK_SIZE - 1);
+
+        if (next >= len)
+        {
+            return NRF_ERROR_TIMEOUT;
+        }
+
+        err_code = type_2_tag_stream_feed(&stream, offset, &p_dump[offset], MIN(len - offset, NFC_T2T_READ_LEN));
+        VERIFY_SUCCESS(err_code);
+
+        if (!type_2_tag_stream_is_done(&stream) && (type_2_tag_stream_offset(&stream) <= next))
+        {
+            return NRF_ERROR_INTERNAL;
+        }
+    }
+    return NRF_SUCCESS;
+}
+
+/**@brief The kept values of the TLV blocks lie in the value buffer. */
+static bool t2t_is_in(void)
+{
+    type_2_tag_t const * p_t2t = &NFC_TYPE_2_TAG_DESC(m_t2t);
+
+    if (p_t2t->tlv_count > NFC_TLVS)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < p_t2t->tlv_count; i++)
+    {
+        tlv_block_t const * p_tlv = &p_t2t->p_tlv_block_array[i];
+
+        if ((p_tlv->p_value != NULL) &&
+            !field_is_in(p_tlv->p_value, p_tlv->length, m_t2t_values, m_t2t_values + sizeof(m_t2t_values)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool t2t_run(void * p_context)
+{
+    tlv_block_t const * p_tlv = &NFC_TYPE_2_TAG_DESC(m_t2t).p_tlv_block_array[0];
+
+    UNUSED_PARAMETER(p_context);
+    return (t2t_parse(m_t2t_dump, sizeof(m_t2t_dump)) == NRF_SUCCESS) && t2t_is_in() &&
+           (p_tlv->tag == TLV_NDEF_MESSAGE) && (p_tlv->length == sizeof(m_ndef_msg)) &&
+           (p_tlv->p_value != NULL) && (memcmp(p_tlv->p_value, m_ndef_msg, sizeof(m_ndef_msg)) == 0);
+}
+
+static bench_case_t const m_t2t_case = {"t2t_parse", t2t_run, NULL, 16};
+#endif
+
+
+#if NRF_MODULE_ENABLED(NFC_T4T_CC_FILE_PARSER)
+NFC_T4T_CC_DESC_DEF(m_t4t_cc_desc, NFC_TLVS);
+
+static bool t4t_cc_run(void * p_context)
+{
+    nfc_t4t_capability_container_t * p_cc = &NFC_T4T_CC_DESC(m_t4t_cc_desc);
+
+    UNUSED_PARAMETER(p_context);
+    return (nfc_t4t_cc_file_parse(p_cc, m_t4t_cc, sizeof(m_t4t_cc)) == NRF_SUCCESS) &&
+           (p_cc->max_rapdu_size == 0x3B) && (p_cc->tlv_count == 1) &&
+           (nfc_t4t_file_content_get(p_cc, 0xE104) != NULL);
+}
+
+static bench_case_t const m_t4t_cc_case = {"t4t_cc", t4t_cc_run, NULL, 32};
+#endif
+
+
+#if NFC_PARSERS
+static uint32_t m_fuzz_state;
+static uint8_t  m_fuzz_buf[sizeof(m_t2t_dump)];
+
+static uint32_t fuzz_rand(void)
+{
+    m_fuzz_state ^= m_fuzz_state << 13;
+    m_fuzz_state ^= m_fuzz_state >> 17;
+    m_fuzz_state ^= m_fuzz_state << 5;
+    return m_fuzz_state;
+}
+
+/**@brief Copy a dump to m_fuzz_buf with one to four bytes changed.
+ *
+ * @return Length to parse: the dump, or one time in four a cut short read.
+ */
+static uint16_t fuzz_mutate(uint8_t const * p_dump, uint16_t len)
+{
+    // TLV tags, the marker of a three byte length, record header flags, and the lengths around them.
+    static uint8_t const special[] = {0x00, 0x01, 0x03, 0x7F, 0x80, 0xFE, 0xFF};
+
+    memcpy(m_fuzz_buf, p_dump, len);
+    for (uint32_t n = 1 + (fuzz_rand() & 3); n > 0; n--)
+    {
+        uint16_t i = fuzz_rand() % len;
+
+        switch (fuzz_rand() % 3)
+        {
+            case 0:
+                m_fuzz_buf[i] ^= (uint8_t)(1 << (fuzz_rand() & 7));
+                break;
+
+            case 1:
+                m_fuzz_buf[i] = (uint8_t)fuzz_rand();
+                break;
+
+            default:
+                m_fuzz_buf[i] = special[fuzz_rand() % sizeof(special)];
+                break;
+        }
+    }
+    return ((fuzz_rand() & 3) == 0) ? (uint16_t)(fuzz_rand() % (len + 1)) : len;
+}
+
+/**@brief The same mutations every run, so the timings of two builds compare. */
+static bool nfc_fuzz_run(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    m_fuzz_state = NFC_FUZZ_SEED;
+    for (uint32_t i = 0; i < NFC_FUZZ_INPUTS; i++)
+    {
+#if NRF_MODULE_ENABLED(NFC_NDEF_MSG_PARSER)
+        {
+            uint16_t len     = fuzz_mutate(m_ndef_msg, sizeof(m_ndef_msg));
+            uint32_t msg_len = len;
+
+            if ((ndef_parse(m_fuzz_buf, &msg_len) == NRF_SUCCESS) &&
+                ((msg_len > len) || !ndef_is_in(m_fuzz_buf, msg_len)))
+            {
+                return false;
+            }
+        }
+#endif
+#if NRF_MODULE_ENABLED(NFC_T2T_PARSER)
+        {
+            ret_code_t err_code = t2t_parse(m_fuzz_buf, fuzz_mutate(m_t2t_dump, sizeof(m_t2t_dump)));
+
+            if ((err_code == NRF_ERROR_INTERNAL) || ((err_code == NRF_SUCCESS) && !t2t_is_in()))
+            {
+                return false;
+            }
+        }
+#endif
+#if NRF_MODULE_ENABLED(NFC_T4T_CC_FILE_PARSER)
+        {
+            nfc_t4t_capability_container_t * p_cc = &NFC_T4T_CC_DESC(m_t4t_cc_desc);
+
+            UNUSED_RETURN_VALUE(nfc_t4t_cc_file_parse(p_cc, m_fuzz_buf, fuzz_mutate(m_t4t_cc, sizeof(m_t4t_cc))));
+            if (p_cc->tlv_count > NFC_TLVS)
+            {
+                return false;
+            }
+        }
+#endif
+    }
+    return true;
+}
+
+static bench_case_t const m_nfc_fuzz_case = {"nfc_fuzz", nfc_fuzz_run, NULL, 4};
+#endif
+
+
+void bench_cases_add(void)
+{
+    for (uint16_t i = 0; i < DATA_LEN; i++)
+    {
+        m_data[i] = (uint8_t)(i * 31 + 7);
+    }
+
+#if NRF_MODULE_ENABLED(CRC16)
+    UNUSED_RETURN_VALUE(bench_case_add(&m_crc16_case));
+#endif
+#if NRF_MODULE_ENABLED(CRC32)
+    UNUSED_RETURN_VALUE(bench_case_add(&m_crc32_case));
+#endif
+    UNUSED_RETURN_VALUE(bench_case_add(&m_sha256_case));
+#if NRF_MODULE_ENABLED(STREAM_FRAME)
+    UNUSED_RETURN_VALUE(bench_case_add(&m_codec_case));
+#endif
+#if NRF_MODULE_ENABLED(FDS)
+    UNUSED_RETURN_VALUE(bench_case_add(&m_fds_case));
+#endif
+#if NRF_MODULE_ENABLED(PN532_SIM)
+    UNUSED_RETURN_VALUE(bench_case_add(&m_pn532_sim_case));
+#endif
+#if NRF_MODULE_ENABLED(NFC_NDEF_MSG_PARSER)
+    UNUSED_RETURN_VALUE(bench_case_add(&m_ndef_case));
+#endif
+#if NRF_MODULE_ENABLED(NFC_T2T_PARSER)
+    UNUSED_RETURN_VALUE(bench_case_add(&m_t2t_case));
+#endif
+#if NRF_MODULE_ENABLED(NFC_T4T_CC_FILE_PARSER)
+    UNUSED_RETURN_VALUE(bench_case_add(&m_t4t_cc_case));
+#endif
+#if NFC_PARSERS
+    UNUSED_RETURN_VALUE(bench_case_add(&m_nfc_fuzz_case));
+#endif
+}
+
+#endif //NRF_MODULE_ENABLED(BENCH)
@@ -0,0 +1,206 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(BOOT_SEQ)
+#include "boot_seq.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "app_util_platform.h"
+
+#if BOOT_SEQ_STAGES_MAX > 32
+#error "boot_seq keeps the stages in 32-bit masks"
+#endif
+
+#define STAGE_BIT(stage)    (1UL << (stage))
+
+APP_TIMER_DEF(m_wait_timer);
+
+static boot_seq_stage_t const * mp_stages;
+static uint8_t                  m_count;
+static boot_seq_handler_t       m_handler;
+static uint32_t                 m_all;
+static uint32_t                 m_started;
+static uint32_t                 m_ready_mask;                   /**< Dependencies done, wait counting. */
+static uint32_t                 m_ready_tick[BOOT_SEQ_STAGES_MAX];
+static volatile uint32_t        m_done;
+static volatile uint32_t        m_failed;
+static uint32_t                 m_start_tick;
+static bool                     m_timer_created;
+static bool                     m_waiting;
+static bool                     m_finished;
+
+
+static uint32_t ms_since(uint32_t tick)
+{
+    uint32_t ticks;
+
+    UNUSED_RETURN_VALUE(app_timer_cnt_diff_compute(app_timer_cnt_get(), tick, &ticks));
+    return (uint32_t)(((uint64_t)ticks * 1000 * (APP_TIMER_CONFIG_PRESCALER + 1)) / APP_TIMER_CLOCK_FREQ);
+}
+
+
+static void pass_run(void * p_event_data, uint16_t event_size);
+
+
+static void pass_queue(void)
+{
+    // A full queue only delays the stages: the next stage done or the wait timer queues again.
+    UNUSED_RETURN_VALUE(app_sched_event_put(NULL, 0, pass_run));
+}
+
+
+static void stage_finish(uint8_t stage, ret_code_t err_code)
+{
+    CRITICAL_REGION_ENTER();
+    m_done |= STAGE_BIT(stage);
+    if (err_code != NRF_SUCCESS)
+    {
+        m_failed |= STAGE_BIT(stage);
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+
+/**@brief Run the next stage that can go, or arm the timer for the first one that waits. */
+static void pass_run(void * p_event_data, uint16_t event_size)
+{
+    uint32_t next_ms = UINT32_MAX;
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    if ((m_count == 0) || m_finished)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < m_count; i++)
+    {
+        boot_seq_stage_t const * p_stage = &mp_stages[i];
+        ret_code_t               err_code;
+
+        if ((m_started & STAGE_BIT(i)) || ((p_stage->after & ~m_done) != 0))
+        {
+            continue;
+        }
+
+        if (p_stage->after & m_failed)
+        {
+            // Skipped, and the ones after it with it.
+            m_started |= STAGE_BIT(i);
+            CRITICAL_REGION_ENTER();
+            m_done   |= STAGE_BIT(i);
+            m_failed |= STAGE_BIT(i);
+            CRITICAL_REGION_EXIT();
+            pass_queue();
+            return;
+        }
+
+        if (p_stage->wait_ms != 0)
+        {
+            uint32_t waited;
+
+            if (!(m_ready_mask & STAGE_BIT(i)))
+            {
+                m_ready_mask   |= STAGE_BIT(i);
+                m_ready_tick[i] = app_timer_cnt_get();
+            }
+            waited = ms_since(m_ready_tick[i]);
+            if (waited < p_stage->wait_ms)
+            {
+                next_ms = MIN(next_ms, p_stage->wait_ms - waited);
+                continue;
+            }
+        }
+
+        m_started |= STAGE_BIT(i);
+        err_code   = p_stage->run();
+        if (err_code != NRF_ERROR_BUSY)
+        {
+            stage_finish(i, err_code);
+        }
+        pass_queue();
+        return;
+    }
+
+    if ((next_ms != UINT32_MAX) && !m_waiting)
+    {
+        m_waiting = (app_timer_start(m_wait_timer,
+                                     APP_TIMER_TICKS(MAX(next_ms, 1), APP_TIMER_CONFIG_PRESCALER),
+                                     NULL) == NRF_SUCCESS);
+    }
+
+    if (m_done == m_all)
+    {
+        m_finished = true;
+        if (m_handler != NULL)
+        {
+            m_handler(m_failed, ms_since(m_start_tick));
+        }
+    }
+}
+
+
+static void wait_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    m_waiting = false;
+    pass_queue();
+}
+
+
+ret_code_t boot_seq_start(boot_seq_stage_t const * p_stages, uint8_t count, boot_seq_handler_t handler)
+{
+    ret_code_t err_code;
+
+    if (count > BOOT_SEQ_STAGES_MAX)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    for (uint8_t i = 0; i < count; i++)
+    {
+        // Stages wait on earlier ones only, so there is no cycle.
+        if (p_stages[i].after & ~(STAGE_BIT(i) - 1))
+        {
+            return NRF_ERROR_INVALID_PARAM;
+        }
+    }
+
+    if (!m_timer_created)
+    {
+        err_code = app_timer_create(&m_wait_timer, APP_TIMER_MODE_SINGLE_SHOT, wait_timer_handler);
+        VERIFY_SUCCESS(err_code);
+        m_timer_created = true;
+    }
+
+    mp_stages    = p_stages;
+    m_count      = count;
+    m_handler    = handler;
+    m_all        = (count == 32) ? UINT32_MAX : (STAGE_BIT(count) - 1);
+    m_started    = 0;
+    m_ready_mask = 0;
+    m_done       = 0;
+    m_failed     = 0;
+    m_finished   = false;
+    m_start_tick = app_timer_cnt_get();
+
+    return app_sched_event_put(NULL, 0, pass_run);
+}
+
+
+void boot_seq_done(uint8_t stage, ret_code_t err_code)
+{
+    if ((stage >= m_count) || (m_done & STAGE_BIT(stage)))
+    {
+        return;
+    }
+    stage_finish(stage, err_code);
+    pass_queue();
+}
+
+
+bool boot_seq_is_ready(uint8_t stage)
+{
+    return (stage < m_count) && ((m_done & ~m_failed) & STAGE_BIT(stage));
+}
+
+#endif //NRF_MODULE_ENABLED(BOOT_SEQ)
@@ -0,0 +1,62 @@
+#ifndef _BOOT_SEQ_H_
+#define _BOOT_SEQ_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* Bring-up of the peripherals after advertising has started, as stages with dependencies:
+ *
+ *   order     a stage runs once every stage in its @p after mask is done, one stage per
+ *             scheduler event, so BLE events and commands are served in between
+ *   waits     a stage with @p wait_ms runs that long after its dependencies are done, from
+ *             the timer of boot_seq; the stages that do not wait run meanwhile, e.g. the MX25
+ *             and the stores while the PN532 boots
+ *   async     a stage that returns NRF_ERROR_BUSY finishes later, with boot_seq_done()
+ *   failures  a stage that fails is done as well, but the stages after it are skipped and count
+ *             as failed: no card scan without a reader
+ *
+ * The handler gets the masks of the stages that failed and the time from boot_seq_start(). */
+
+/**@brief Run a stage. NRF_SUCCESS when done, NRF_ERROR_BUSY to finish with boot_seq_done(). */
+typedef ret_code_t (*boot_seq_run_t)(void);
+
+/**@brief One stage. Stage n is bit n of the masks. */
+typedef struct
+{
+    boot_seq_run_t run;
+    uint32_t       after;       /**< Stages that have to be done first. */
+    uint16_t       wait_ms;     /**< Time after those before this one runs. */
+    char const *   p_name;      /**< Name for the console. */
+} boot_seq_stage_t;
+
+/**@brief Called from the main loop once every stage is done.
+ *
+ * @param[in] failed   Stages that failed or were skipped.
+ * @param[in] elapsed  Milliseconds from boot_seq_start().
+ */
+typedef void (*boot_seq_handler_t)(uint32_t failed, uint32_t elapsed_ms);
+
+/**@brief Start the stages.
+ *
+ * @param[in] p_stages  Stages, kept by reference; at most BOOT_SEQ_STAGES_MAX.
+ * @param[in] count     Number of stages.
+ * @param[in] handler   End handler, may be NULL.
+ *
+ * @note Requires app_timer and app_scheduler.
+ *
+ * @retval NRF_SUCCESS             The first pass is queued.
+ * @retval NRF_ERROR_INVALID_PARAM Too many stages, or one waits on one that comes after it.
+ */
+ret_code_t boot_seq_start(boot_seq_stage_t const * p_stages, uint8_t count, boot_seq_handler_t handler);
+
+/**@brief Finish a stage that returned NRF_ERROR_BUSY. Any context.
+ *
+ * @param[in] stage     Index of the stage.
+ * @param[in] err_code  NRF_SUCCESS, or what failed.
+ */
+void boot_seq_done(uint8_t stage, ret_code_t err_code);
+
+/**@brief Whether a stage is done and did not fail. */
+bool boot_seq_is_ready(uint8_t stage);
+
+#endif
@@ -0,0 +1,205 @@
+// The regions here and in bench are those of the profiler itself.
+#define CRIT_PROF_SKIP
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(CRIT_PROF)
+#include "crit_prof.h"
+#include "bench.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "app_util_platform.h"
+#include "SEGGER_RTT.h"
+
+#if !NRF_MODULE_ENABLED(BENCH)
+#error "crit_prof times with the cycle counter of bench, it needs BENCH_ENABLED"
+#endif
+#if !defined(SOFTDEVICE_PRESENT)
+#error "crit_prof hooks the CRITICAL_REGION macros of the SoftDevice build"
+#endif
+
+#define SLOT_FULL       0xFF        /**< No slot left for the place. */
+#define OVERHEAD_RUNS   8
+
+STATIC_ASSERT(CRIT_PROF_SITES < SLOT_FULL);
+
+typedef struct
+{
+    char const * p_file;            /**< Or the name of a handler. */
+    uint16_t     line;              /**< 0 for a handler. */
+    uint16_t     hist[CRIT_PROF_BUCKETS];   /**< Saturated. */
+    uint32_t     count;
+    uint32_t     max;               /**< Cycles. */
+} entry_t;
+
+APP_TIMER_DEF(m_report_timer);
+
+static entry_t         m_entries[CRIT_PROF_SITES];
+static uint8_t         m_used;
+static uint32_t        m_unlisted;      /**< Hits of places without a slot. */
+static uint32_t        m_overhead;      /**< Cycles of two back to back reads. */
+static volatile bool   m_on;
+
+
+/**@brief Bucket of a duration: below 2, 8, 32, 128, 512 us, 2, 8 ms and the rest. */
+static uint8_t bucket_get(uint32_t us)
+{
+    uint8_t  bucket = 0;
+    uint32_t limit  = 2;
+
+    while ((bucket < CRIT_PROF_BUCKETS - 1) && (us >= limit))
+    {
+        bucket++;
+        limit <<= 2;
+    }
+    return bucket;
+}
+
+
+/**@brief Add a duration to its place. With the application interrupts off. */
+static void record(uint8_t * p_slot, char const * p_file, uint16_t line, uint32_t cycles)
+{
+    entry_t * p_entry;
+    uint8_t   bucket;
+
+    if (*p_slot == 0)
+    {
+        if (m_used >= CRIT_PROF_SITES)
+        {
+            *p_slot = SLOT_FULL;
+        }
+        else
+        {
+            *p_slot = ++m_used;
+            m_entries[*p_slot - 1].p_file = p_file;
+            m_entries[*p_slot - 1].line   = line;
+        }
+    }
+    if (*p_slot == SLOT_FULL)
+    {
+        m_unlisted++;
+        return;
+    }
+
+    cycles  = (cycles > m_overhead) ? (cycles - m_overhead) : 0;
+    p_entry = &m_entries[*p_slot - 1];
+    bucket  = bucket_get(bench_cycles_to_us(cycles));
+    p_entry->count++;
+    p_entry->max = MAX(p_entry->max, cycles);
+    if (p_entry->hist[bucket] < UINT16_MAX)
+    {
+        p_entry->hist[bucket]++;
+    }
+}
+
+
+uint32_t crit_prof_enter(void)
+{
+    return m_on ? bench_cycles() : 0;
+}
+
+
+void crit_prof_exit(uint8_t * p_slot, char const * p_file, uint16_t line, uint32_t start, uint8_t nested)
+{
+    if (m_on && !nested && (start != 0))
+    {
+        record(p_slot, p_file, line, bench_cycles() - start);
+    }
+}
+
+
+void crit_prof_handler_exit(crit_prof_site_t * p_site, uint32_t start)
+{
+    uint32_t cycles;
+    uint8_t  nested = 0;
+
+    if (!m_on || (start == 0))
+    {
+        return;
+    }
+    cycles = bench_cycles() - start;
+
+    app_util_critical_region_enter(&nested);
+    record(&p_site->slot, p_site->p_name, 0, cycles);
+    app_util_critical_region_exit(nested);
+}
+
+
+void crit_prof_report(void)
+{
+    static bool reported[CRIT_PROF_SITES];
+    uint8_t     used = m_used;
+
+    for (uint8_t i = 0; i < used; i++)
+    {
+        reported[i] = false;
+    }
+
+    // A handful of places: one pass for each, picking the worst one left.
+    for (uint8_t n = 0; n < used; n++)
+    {
+        entry_t entry;
+        uint8_t worst = 0;
+        uint8_t nested = 0;
+
+        for (uint8_t i = 0; i < used; i++)
+        {
+            if (!reported[i] && (reported[worst] || (m_entries[i].max > m_entries[worst].max)))
+            {
+                worst = i;
+            }
+        }
+        reported[worst] = true;
+
+        app_util_critical_region_enter(&nested);
+        entry = m_entries[worst];
+        app_util_critical_region_exit(nested);
+
+        SEGGER_RTT_printf(0, "crit %s:%u: %u hits, max %u us, <2us %u <8 %u <32 %u <128 %u <512 %u <2ms %u <8 %u more %u\r\n",
+                          entry.p_file, entry.line, entry.count, bench_cycles_to_us(entry.max),
+                          entry.hist[0], entry.hist[1], entry.hist[2], entry.hist[3],
+                          entry.hist[4], entry.hist[5], entry.hist[6], entry.hist[7]);
+    }
+    if (m_unlisted != 0)
+    {
+        SEGGER_RTT_printf(0, "crit: %u hits in places without a slot\r\n", m_unlisted);
+    }
+}
+
+
+static void report_handler(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    crit_prof_report();
+}
+
+
+static void timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+    UNUSED_RETURN_VALUE(app_sched_event_put(NULL, 0, report_handler));
+}
+
+
+ret_code_t crit_prof_init(void)
+{
+    ret_code_t err_code;
+
+    m_overhead = UINT32_MAX;
+    for (uint8_t i = 0; i < OVERHEAD_RUNS; i++)
+    {
+        uint32_t start = bench_cycles();
+
+        m_overhead = MIN(m_overhead, bench_cycles() - start);
+    }
+
+    err_code = app_timer_create(&m_report_timer, APP_TIMER_MODE_REPEATED, timer_handler);
+    VERIFY_SUCCESS(err_code);
+
+    m_on = true;
+    return app_timer_start(m_report_timer,
+                           APP_TIMER_TICKS(CRIT_PROF_REPORT_S * 1000UL, APP_TIMER_CONFIG_PRESCALER),
+                           NULL);
+}
+
+#endif //NRF_MODULE_ENABLED(CRIT_PROF)
@@ -0,0 +1,66 @@
+#ifndef _CRIT_PROF_H_
+#define _CRIT_PROF_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* How long the application holds off its own interrupts, per place in the code:
+ *
+ *   regions   with CRIT_PROF enabled, CRITICAL_REGION_ENTER/EXIT of app_util_platform time
+ *             every outermost critical region, by its file and line; nested ones are in the
+ *             time of the outer one
+ *   handlers  CRIT_PROF_BEGIN/CRIT_PROF_END around the event handlers that run in interrupts,
+ *             under a name: what they take is what an interrupt of the same or lower priority
+ *             waits, a BLE event or a UART byte among them
+ *   numbers   count, max and a histogram in powers of four of microseconds, from 2 us up to
+ *             8 ms and more, on the cycle counter of bench; since boot, as the worst case is
+ *             what matters. Every CRIT_PROF_REPORT_S they go to RTT, worst first
+ *
+ * The first CRIT_PROF_SITES places hit get a slot; later ones are only counted. A profiled
+ * region costs two reads of the counter, some 2 us on the nRF51, so the numbers are for
+ * finding the long ones, not for taking off the short ones. Files that include app_util_platform.h
+ * before sdk_config.h keep the plain macros. For measuring builds, with BENCH. */
+
+#define CRIT_PROF_BUCKETS   8
+
+/**@brief A named place, for @ref CRIT_PROF_END. Define with @ref CRIT_PROF_SITE_DEF. */
+typedef struct
+{
+    char const * p_name;
+    uint8_t      slot;      /**< 0 until the first hit. */
+} crit_prof_site_t;
+
+#if defined(CRIT_PROF_ENABLED) && CRIT_PROF_ENABLED
+/**@brief Define a named place; at file scope. */
+#define CRIT_PROF_SITE_DEF(site, name)  static crit_prof_site_t site = {.p_name = (name)}
+/**@brief Take the counter into a new local @p t. */
+#define CRIT_PROF_BEGIN(t)              uint32_t t = crit_prof_enter()
+/**@brief Add the time since @ref CRIT_PROF_BEGIN to a named place. */
+#define CRIT_PROF_END(site, t)          crit_prof_handler_exit(&(site), (t))
+#else
+#define CRIT_PROF_SITE_DEF(site, name)
+#define CRIT_PROF_BEGIN(t)
+#define CRIT_PROF_END(site, t)
+#endif
+
+/**@brief Start profiling, after bench_init(), and the report timer. */
+ret_code_t crit_prof_init(void);
+
+/**@brief Counter at the start of a region or handler; 0 before @ref crit_prof_init. */
+uint32_t crit_prof_enter(void);
+
+/**@brief End of a critical region; from CRITICAL_REGION_EXIT, still inside the region.
+ *
+ * @param[in,out] p_slot  Of the call site, 0 until it has one.
+ * @param[in]     nested  Of app_util_critical_region_enter: an inner region is not counted.
+ */
+void crit_prof_exit(uint8_t * p_slot, char const * p_file, uint16_t line, uint32_t start, uint8_t nested);
+
+/**@brief End of a handler; any context. */
+void crit_prof_handler_exit(crit_prof_site_t * p_site, uint32_t start);
+
+/**@brief Print the places over RTT, the longest max first. Main loop. */
+void crit_prof_report(void);
+
+#endif
@@ -0,0 +1,288 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(DEV_CFG)
+#include "dev_cfg.h"
+#include "fds.h"
+#include "ble_gap.h"
+#include <stddef.h>
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(FDS)
+#error "dev_cfg needs FDS"
+#endif
+
+STATIC_ASSERT(sizeof(dev_cfg_t) % sizeof(uint32_t) == 0);
+
+/**@brief Where an item is in the struct, and the values it takes. */
+typedef struct
+{
+    uint8_t  offset;
+    uint8_t  size;
+    uint16_t min;
+    uint16_t max;
+} item_t;
+
+#define ITEM(field, lo, hi)  {offsetof(dev_cfg_t, field), sizeof(((dev_cfg_t *)0)->field), (lo), (hi)}
+
+static item_t const m_items[DEV_CFG_ITEMS] =
+{
+    [DEV_CFG_ADV_INTERVAL]      = ITEM(adv_interval,      BLE_GAP_ADV_INTERVAL_MIN,        BLE_GAP_ADV_INTERVAL_MAX),
+    [DEV_CFG_CONN_MIN_INTERVAL] = ITEM(conn_min_interval, BLE_GAP_CP_MIN_CONN_INTVL_MIN,   BLE_GAP_CP_MIN_CONN_INTVL_MAX),
+    [DEV_CFG_CONN_MAX_INTERVAL] = ITEM(conn_max_interval, BLE_GAP_CP_MAX_CONN_INTVL_MIN,   BLE_GAP_CP_MAX_CONN_INTVL_MAX),
+    [DEV_CFG_SLAVE_LATENCY]     = ITEM(slave_latency,     0,                               BLE_GAP_CP_SLAVE_LATENCY_MAX),
+    [DEV_CFG_CONN_SUP_TIMEOUT]  = ITEM(conn_sup_timeout,  BLE_GAP_CP_CONN_SUP_TIMEOUT_MIN, BLE_GAP_CP_CONN_SUP_TIMEOUT_MAX),
+    [DEV_CFG_LOCK_HOLD_MS]      = ITEM(lock_hold_ms,      500,                             60000),
+    [DEV_CFG_RETRY_MAX]         = ITEM(retry_max,         0,                               8),
+    [DEV_CFG_RETRY_BACKOFF_MS]  = ITEM(retry_backoff_ms,  0,                               100),
+    [DEV_CFG_FB_TIME_PCT]       = ITEM(fb_time_pct,       25,                              250),
+};
+
+__ALIGN(4) static dev_cfg_t m_cfg;
+static dev_cfg_t            m_defaults;
+
+dev_cfg_t const * const dev_cfg_current = &m_cfg;
+
+static fds_record_desc_t m_desc;
+static bool              m_loaded;
+static bool              m_record_found;
+static bool              m_dirty;
+static bool              m_write_pending;
+
+
+static uint16_t item_get(dev_cfg_t const * p_cfg, dev_cfg_item_t item)
+{
+    uint8_t const * p_field = (uint8_t const *)p_cfg + m_items[item].offset;
+
+    return (m_items[item].size == sizeof(uint8_t)) ? *p_field : uint16_decode(p_field);
+}
+
+
+static void item_set(dev_cfg_t * p_cfg, dev_cfg_item_t item, uint16_t value)
+{
+    uint8_t * p_field = (uint8_t *)p_cfg + m_items[item].offset;
+
+    if (m_items[item].size == sizeof(uint8_t))
+    {
+        *p_field = (uint8_t)value;
+    }
+    else
+    {
+        UNUSED_RETURN_VALUE(uint16_encode(value, p_field));
+    }
+}
+
+
+/**@brief Whether the connection items make a set the SoftDevice takes: the supervision
+ *        timeout has to outlast two of the longest intervals a latency can skip.
+ */
+static bool conn_valid(dev_cfg_t const * p_cfg)
+{
+    return (p_cfg->conn_min_interval <= p_cfg->conn_max_interval) &&
+           ((uint32_t)p_cfg->conn_sup_timeout * 4 >
+            (uint32_t)(1 + p_cfg->slave_latency) * p_cfg->conn_max_interval);
+}
+
+
+static void save_load(void)
+{
+    fds_find_token_t   token = {0};
+    fds_flash_record_t record;
+    dev_cfg_t          stored = m_defaults;
+
+    if (fds_record_find(DEV_CFG_FILE_ID, DEV_CFG_RECORD_KEY, &m_desc, &token) != FDS_SUCCESS)
+    {
+        return;
+    }
+    m_record_found = true;
+
+    if (fds_record_open(&m_desc, &record) != FDS_SUCCESS)
+    {
+        return;
+    }
+    memcpy(&stored, record.p_data,
+           MIN(record.p_header->tl.length_words * sizeof(uint32_t), sizeof(stored)));
+    (void)fds_record_close(&m_desc);
+
+    for (uint8_t i = 0; i < DEV_CFG_ITEMS; i++)
+    {
+        uint16_t value = item_get(&stored, (dev_cfg_item_t)i);
+
+        if ((value < m_items[i].min) || (value > m_items[i].max))
+        {
+            item_set(&stored, (dev_cfg_item_t)i, item_get(&m_defaults, (dev_cfg_item_t)i));
+        }
+    }
+    if (!conn_valid(&stored))
+    {
+        stored.conn_min_interval = m_defaults.conn_min_interval;
+        stored.conn_max_interval = m_defaults.conn_max_interval;
+        stored.slave_latency     = m_defaults.slave_latency;
+        stored.conn_sup_timeout  = m_defaults.conn_sup_timeout;
+    }
+    m_cfg = stored;
+}
+
+
+static void save_store(void)
+{
+    fds_record_chunk_t chunk;
+    fds_record_t       record;
+    ret_code_t         err_code;
+
+    if (m_write_pending)
+    {
+        // Written again once the write in flight is done.
+        m_dirty = true;
+        return;
+    }
+
+    chunk.p_data       = &m_cfg;
+    chunk.length_words = BYTES_TO_WORDS(sizeof(m_cfg));
+
+    record.file_id         = DEV_CFG_FILE_ID;
+    record.key             = DEV_CFG_RECORD_KEY;
+    record.data.p_chunks   = &chunk;
+    record.data.num_chunks = 1;
+
+    m_dirty = false;
+    if (m_record_found)
+    {
+        err_code = fds_record_update(&m_desc, &record);
+    }
+    else
+    {
+        err_code = fds_record_write(&m_desc, &record);
+    }
+
+    if (err_code == FDS_SUCCESS)
+    {
+        m_write_pending = true;
+    }
+    else if (err_code == FDS_ERR_NO_SPACE_IN_FLASH)
+    {
+        // Old copies of the record fill the pages; reclaim them and retry once gc is done.
+        m_dirty         = true;
+        m_write_pending = (fds_gc() == FDS_SUCCESS);
+    }
+    else
+    {
+        m_dirty = true;
+    }
+}
+
+
+static void fds_evt_handler(fds_evt_t const * const p_evt)
+{
+    switch (p_evt->id)
+    {
+        case FDS_EVT_INIT:
+            // Every fds_init() of another module comes here too; the RAM copy is newer by then.
+            if ((p_evt->result == FDS_SUCCESS) && !m_loaded)
+            {
+                m_loaded = true;
+                save_load();
+            }
+            break;
+
+        case FDS_EVT_WRITE:
+        case FDS_EVT_UPDATE:
+            if ((p_evt->write.file_id != DEV_CFG_FILE_ID) ||
+                (p_evt->write.record_key != DEV_CFG_RECORD_KEY))
+            {
+                break;
+            }
+            m_write_pending = false;
+            if (p_evt->result == FDS_SUCCESS)
+            {
+                m_record_found = true;
+            }
+            if (m_dirty)
+            {
+                save_store();
+            }
+            break;
+
+        case FDS_EVT_GC:
+            if (m_write_pending && m_dirty)
+            {
+                m_write_pending = false;
+                save_store();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+ret_code_t dev_cfg_init(dev_cfg_t const * p_defaults)
+{
+    ret_code_t err_code;
+
+    m_defaults = *p_defaults;
+    m_cfg      = m_defaults;
+
+    err_code = fds_register(fds_evt_handler);
+    VERIFY_SUCCESS(err_code);
+
+    return fds_init();
+}
+
+
+uint8_t dev_cfg_size(dev_cfg_item_t item)
+{
+    return (item < DEV_CFG_ITEMS) ? m_items[item].size : 0;
+}
+
+
+uint16_t dev_cfg_value(dev_cfg_item_t item)
+{
+    return (item < DEV_CFG_ITEMS) ? item_get(&m_cfg, item) : 0;
+}
+
+
+ret_code_t dev_cfg_write(uint8_t const * p_data, uint16_t len)
+{
+    dev_cfg_t next = m_cfg;
+    uint16_t  pos  = 0;
+
+    while (pos < len)
+    {
+        dev_cfg_item_t item = (dev_cfg_item_t)p_data[pos++];
+        uint16_t       value;
+
+        if (item >= DEV_CFG_ITEMS)
+        {
+            return NRF_ERROR_NOT_FOUND;
+        }
+        if (len - pos < m_items[item].size)
+        {
+            return NRF_ERROR_INVALID_LENGTH;
+        }
+        value = (m_items[item].size == sizeof(uint8_t)) ? p_data[pos] : uint16_decode(&p_data[pos]);
+        pos  += m_items[item].size;
+
+        if ((value < m_items[item].min) || (value > m_items[item].max))
+        {
+            return NRF_ERROR_INVALID_PARAM;
+        }
+        item_set(&next, item, value);
+    }
+    if (!conn_valid(&next))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    m_cfg = next;
+    save_store();
+    return NRF_SUCCESS;
+}
+
+
+void dev_cfg_reset(void)
+{
+    m_cfg = m_defaults;
+    save_store();
+}
+
+#endif //NRF_MODULE_ENABLED(DEV_CFG)
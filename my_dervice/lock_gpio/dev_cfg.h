@@ -0,0 +1,90 @@
+#ifndef _DEV_CFG_H_
+#define _DEV_CFG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_common.h"
+
+/* Site settings that used to need a reflash, as a registry of typed items kept in one FDS record:
+ *
+ *   RAM       the record is loaded once, after fds is initialized and before the modules that
+ *             read it start; DEV_CFG_GET() is then a load from the struct, with no FDS call
+ *   write     a partial write over NUS sets any items at once, each checked against the range
+ *             of its item and the connection items against each other; one bad item and
+ *             nothing is set. The record is written in the background
+ *   record    the struct as it is; a record shorter than the struct, from an older build,
+ *             leaves the items past it at their built-in values, and an item out of range
+ *             in flash does the same for itself
+ *
+ * The advertising and connection items are taken by ble_advertising and ble_conn_params at
+ * boot and apply from the next one; the others apply from their next use. Pins and keys are
+ * not here: the pins are wired per board, and the keys have their own store in mfc_keys. */
+
+/**@brief Items, in the order of the struct. */
+typedef enum
+{
+    DEV_CFG_ADV_INTERVAL,       /**< Fast advertising interval, 0.625 ms units. */
+    DEV_CFG_CONN_MIN_INTERVAL,  /**< Preferred connection interval, 1.25 ms units. */
+    DEV_CFG_CONN_MAX_INTERVAL,
+    DEV_CFG_SLAVE_LATENCY,
+    DEV_CFG_CONN_SUP_TIMEOUT,   /**< Supervision timeout, 10 ms units. */
+    DEV_CFG_LOCK_HOLD_MS,       /**< Time the lock stays open. */
+    DEV_CFG_RETRY_MAX,          /**< PN532 reselects per failed exchange. */
+    DEV_CFG_RETRY_BACKOFF_MS,   /**< Wait before the second reselect. */
+    DEV_CFG_FB_TIME_PCT,        /**< Length of the beep and LED patterns, percent. */
+    DEV_CFG_ITEMS
+} dev_cfg_item_t;
+
+typedef struct
+{
+    uint16_t adv_interval;
+    uint16_t conn_min_interval;
+    uint16_t conn_max_interval;
+    uint16_t slave_latency;
+    uint16_t conn_sup_timeout;
+    uint16_t lock_hold_ms;
+    uint8_t  retry_max;
+    uint8_t  retry_backoff_ms;
+    uint8_t  fb_time_pct;
+    uint8_t  rfu;
+} dev_cfg_t;
+
+#if NRF_MODULE_ENABLED(DEV_CFG)
+/**@brief Settings in use. Written by dev_cfg only. */
+extern dev_cfg_t const * const dev_cfg_current;
+
+#define DEV_CFG_GET(field, build)   (dev_cfg_current->field)
+#else
+#define DEV_CFG_GET(field, build)   (build)
+#endif
+
+/**@brief Take the built-in values and load the record over them.
+ *
+ * @details Call once fds can be initialized; with fds already up, as after peer_bond_init(), the
+ *          record is loaded before this returns.
+ *
+ * @param[in] p_defaults  Values of the build.
+ */
+ret_code_t dev_cfg_init(dev_cfg_t const * p_defaults);
+
+/**@brief Size of an item in bytes, 0 for no such item. */
+uint8_t dev_cfg_size(dev_cfg_item_t item);
+
+/**@brief Value of an item. */
+uint16_t dev_cfg_value(dev_cfg_item_t item);
+
+/**@brief Set items and store them. Main loop.
+ *
+ * @param[in] p_data  Pairs of item and value, the value LE in the size of the item.
+ * @param[in] len     Length of the pairs.
+ *
+ * @retval NRF_SUCCESS              Set; the record is written in the background.
+ * @retval NRF_ERROR_INVALID_LENGTH A pair is cut short.
+ * @retval NRF_ERROR_NOT_FOUND      No such item.
+ * @retval NRF_ERROR_INVALID_PARAM  A value is out of range; nothing was set.
+ */
+ret_code_t dev_cfg_write(uint8_t const * p_data, uint16_t len);
+
+/**@brief Go back to the built-in values, and store them. Main loop. */
+void dev_cfg_reset(void);
+
+#endif
@@ -0,0 +1,239 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(ENERGY)
+#include "energy.h"
+#include "wall_clock.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#if !NRF_MODULE_ENABLED(RADIO_GAP)
+#include "ble_radio_notification.h"
+#endif
+
+#if !NRF_MODULE_ENABLED(WALL_CLOCK)
+#error "energy times the subsystems with wall_clock_ticks(), set WALL_CLOCK_ENABLED"
+#endif
+
+#define ENERGY_TICK_HZ    (APP_TIMER_CLOCK_FREQ / (APP_TIMER_CONFIG_PRESCALER + 1))
+#define ENERGY_TICKS(ms)  APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+
+/**@brief nAh of @p q uA ticks. */
+#define NAH(q)            ((q) * 1000 / ((uint64_t)ENERGY_TICK_HZ * 3600))
+
+STATIC_ASSERT(ENERGY_SUB_COUNT <= 16);
+
+APP_TIMER_DEF(m_window_timer);
+
+static uint32_t const m_ua[ENERGY_SUB_COUNT] =
+{
+    [ENERGY_PN532]       = ENERGY_UA_PN532,
+    [ENERGY_TWI]         = ENERGY_UA_TWI,
+    [ENERGY_SPI]         = ENERGY_UA_SPI,
+    [ENERGY_FLASH_PROG]  = ENERGY_UA_FLASH_PROG,
+    [ENERGY_FLASH_ERASE] = ENERGY_UA_FLASH_ERASE,
+    [ENERGY_BUZZER]      = ENERGY_UA_BUZZER,
+    [ENERGY_MOTOR]       = ENERGY_UA_MOTOR,
+    [ENERGY_RADIO]       = ENERGY_UA_RADIO,
+};
+
+static bool              m_started;
+static uint64_t          m_epoch;                       /**< Ticks at the start of the count. */
+static volatile uint16_t m_on;                          /**< Subsystems drawing now. */
+static uint64_t          m_since[ENERGY_SUB_COUNT];     /**< Ticks at the last energy_on(). */
+static uint64_t          m_on_ticks[ENERGY_SUB_COUNT];  /**< On-time before it. */
+
+static bool              m_window;                      /**< A tap window is open. */
+static uint64_t          m_window_tick;
+static uint64_t          m_window_q;                    /**< Charge when it opened. */
+static uint64_t          m_tap_ticks;                   /**< Length of the closed windows. */
+static uint64_t          m_tap_q;                       /**< Charge in them, uA ticks. */
+static uint32_t          m_taps;
+
+
+/**@brief On-time of @p sub up to @p now. In a critical region. */
+static uint64_t on_ticks(energy_sub_t sub, uint64_t now)
+{
+    uint64_t ticks = m_on_ticks[sub];
+
+    if (m_on & (1UL << sub))
+    {
+        ticks += now - m_since[sub];
+    }
+    return ticks;
+}
+
+
+/**@brief Charge since the epoch up to @p now, in uA ticks. In a critical region. */
+static uint64_t charge(uint64_t now)
+{
+    uint64_t q = (uint64_t)ENERGY_UA_SLEEP * (now - m_epoch);
+
+    for (uint8_t i = 0; i < ENERGY_SUB_COUNT; i++)
+    {
+        q += (uint64_t)m_ua[i] * on_ticks((energy_sub_t)i, now);
+    }
+    return q;
+}
+
+
+static void window_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    CRITICAL_REGION_ENTER();
+    if (m_window)
+    {
+        uint64_t now = wall_clock_ticks();
+
+        m_tap_ticks += now - m_window_tick;
+        m_tap_q     += charge(now) - m_window_q;
+        m_window     = false;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+
+#if !NRF_MODULE_ENABLED(RADIO_GAP)
+static void radio_evt_handler(bool radio_active)
+{
+    if (radio_active)
+    {
+        energy_on(ENERGY_RADIO);
+    }
+    else
+    {
+        energy_off(ENERGY_RADIO);
+    }
+}
+#endif
+
+
+ret_code_t energy_init(void)
+{
+    ret_code_t err_code;
+
+    err_code = app_timer_create(&m_window_timer, APP_TIMER_MODE_SINGLE_SHOT, window_timer_handler);
+    VERIFY_SUCCESS(err_code);
+
+    m_epoch   = wall_clock_ticks();
+    m_started = true;
+
+#if NRF_MODULE_ENABLED(RADIO_GAP)
+    // radio_gap owns the notification and passes the edges on.
+    return NRF_SUCCESS;
+#else
+    return ble_radio_notification_init(ENERGY_IRQ_PRIORITY, NRF_RADIO_NOTIFICATION_DISTANCE_800US,
+                                       radio_evt_handler);
+#endif
+}
+
+
+void energy_on(energy_sub_t sub)
+{
+    if (!m_started)
+    {
+        return;
+    }
+
+    CRITICAL_REGION_ENTER();
+    if ((m_on & (1UL << sub)) == 0)
+    {
+        m_since[sub] = wall_clock_ticks();
+        m_on        |= (uint16_t)(1UL << sub);
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+
+void energy_off(energy_sub_t sub)
+{
+    CRITICAL_REGION_ENTER();
+    if (m_on & (1UL << sub))
+    {
+        m_on_ticks[sub] += wall_clock_ticks() - m_since[sub];
+        m_on            &= (uint16_t)~(1UL << sub);
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+
+void energy_tap(void)
+{
+    if (!m_started)
+    {
+        return;
+    }
+
+    CRITICAL_REGION_ENTER();
+    m_taps++;
+    if (!m_window)
+    {
+        m_window_tick = wall_clock_ticks();
+        m_window_q    = charge(m_window_tick);
+        m_window      = true;
+    }
+    CRITICAL_REGION_EXIT();
+
+    UNUSED_RETURN_VALUE(app_timer_stop(m_window_timer));
+    UNUSED_RETURN_VALUE(app_timer_start(m_window_timer, ENERGY_TICKS(ENERGY_TAP_WINDOW_MS), NULL));
+}
+
+
+void energy_summary_get(energy_summary_t * p_summary)
+{
+    uint64_t now;
+    uint64_t q;
+    uint64_t tap_q;
+    uint64_t tap_ticks;
+    uint32_t taps;
+
+    CRITICAL_REGION_ENTER();
+    now       = wall_clock_ticks();
+    q         = charge(now);
+    tap_q     = m_tap_q + (m_window ? (q - m_window_q) : 0);
+    tap_ticks = m_tap_ticks + (m_window ? (now - m_window_tick) : 0);
+    taps      = m_taps;
+    now      -= m_epoch;
+    CRITICAL_REGION_EXIT();
+
+    p_summary->uptime_s   = (uint32_t)(now / ENERGY_TICK_HZ);
+    p_summary->taps       = taps;
+    p_summary->tap_nah    = (taps != 0) ? (uint32_t)(NAH(tap_q) / taps) : 0;
+    // nAh per hour is the mean current in nA.
+    p_summary->idle_nah_h = (now > tap_ticks) ? (uint32_t)((q - tap_q) * 1000 / (now - tap_ticks)) : 0;
+}
+
+
+void energy_sub_get(energy_sub_t sub, uint32_t * p_nah, uint32_t * p_on_s)
+{
+    uint64_t ticks = 0;
+
+    if (sub < ENERGY_SUB_COUNT)
+    {
+        CRITICAL_REGION_ENTER();
+        ticks = on_ticks(sub, wall_clock_ticks());
+        CRITICAL_REGION_EXIT();
+    }
+
+    *p_nah  = (sub < ENERGY_SUB_COUNT) ? (uint32_t)NAH(ticks * m_ua[sub]) : 0;
+    *p_on_s = (uint32_t)(ticks / ENERGY_TICK_HZ);
+}
+
+
+void energy_reset(void)
+{
+    UNUSED_RETURN_VALUE(app_timer_stop(m_window_timer));
+
+    CRITICAL_REGION_ENTER();
+    m_epoch = wall_clock_ticks();
+    for (uint8_t i = 0; i < ENERGY_SUB_COUNT; i++)
+    {
+        m_on_ticks[i] = 0;
+        m_since[i]    = m_epoch;
+    }
+    m_window    = false;
+    m_tap_ticks = 0;
+    m_tap_q     = 0;
+    m_taps      = 0;
+    CRITICAL_REGION_EXIT();
+}
+
+#endif //NRF_MODULE_ENABLED(ENERGY)
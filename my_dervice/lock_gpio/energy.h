@@ -0,0 +1,70 @@
+#ifndef __ENERGY_H__
+#define __ENERGY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* Charge estimate of the lock, from the time each part spends on:
+ *
+ *   time      RTC1 ticks of wall_clock_ticks() between energy_on() and energy_off() of each
+ *             subsystem; the drivers mark their own edges, an edge that repeats is ignored
+ *   charge    the on-time of each subsystem times its current from ENERGY_UA_*, plus
+ *             ENERGY_UA_SLEEP for all of the uptime: what the chip draws asleep, the
+ *             regulators and the leakage
+ *   tap       energy_tap() opens a window of ENERGY_TAP_WINDOW_MS, a tap in the window makes it
+ *             longer: the charge in the windows is the cost of the taps in them, the motor,
+ *             the beep, the journal and the notification; the polling that found the card is not
+ *   idle      the charge outside the windows, per hour outside them
+ *
+ * The currents are those of the data sheets at 3 V, set per board; the result is as good as
+ * they are, and for an estimate of the battery life good enough. */
+
+/**@brief Subsystems with a current of their own. */
+typedef enum
+{
+    ENERGY_PN532,        /**< PN532 awake, from pn532_wake_up() to PowerDown. */
+    ENERGY_TWI,          /**< A transaction on twi_bus. */
+    ENERGY_SPI,          /**< A command on spi_bus. */
+    ENERGY_FLASH_PROG,   /**< MX25 page program, until the status shows it done. */
+    ENERGY_FLASH_ERASE,  /**< MX25 sector or chip erase, the same. */
+    ENERGY_BUZZER,       /**< beep_pwm sounding. */
+    ENERGY_MOTOR,        /**< The H-bridge awake. */
+    ENERGY_RADIO,        /**< A radio event, from the SoftDevice's radio notification. */
+    ENERGY_SUB_COUNT
+} energy_sub_t;
+
+/**@brief Totals since boot or energy_reset(). */
+typedef struct
+{
+    uint32_t uptime_s;      /**< Seconds counted. */
+    uint32_t taps;          /**< energy_tap() calls. */
+    uint32_t tap_nah;       /**< Charge per tap, nAh. */
+    uint32_t idle_nah_h;    /**< Charge per hour outside the tap windows, nAh. */
+} energy_summary_t;
+
+/**@brief Start counting; with RADIO_GAP disabled, take the radio notification as well.
+ *
+ * @note Call after ble_stack_init() and wall_clock_init(), before radio_gap_init().
+ */
+ret_code_t energy_init(void);
+
+/**@brief @p sub starts drawing its current. Any context. */
+void energy_on(energy_sub_t sub);
+
+/**@brief @p sub stops drawing its current. Any context. */
+void energy_off(energy_sub_t sub);
+
+/**@brief A card has been decided on. Thread mode or app_timer priority. */
+void energy_tap(void);
+
+/**@brief Fill in @p p_summary. */
+void energy_summary_get(energy_summary_t * p_summary);
+
+/**@brief Charge of @p sub in nAh, and its on-time in seconds. */
+void energy_sub_get(energy_sub_t sub, uint32_t * p_nah, uint32_t * p_on_s);
+
+/**@brief Start again from zero. */
+void energy_reset(void);
+
+#endif
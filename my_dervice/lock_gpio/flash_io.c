@@ -6,130 +6,685 @@
 #include "nrf_assert.h"
 #include "app_util_platform.h"
 #include "sdk_common.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "mx25_async.h"
+#include "spi_bus.h"
+#include "frame_pool.h"
+#if NRF_MODULE_ENABLED(MX25_QSPI)
+#include "nrf_drv_qspi.h"
+#endif
+#ifdef SOFTDEVICE_PRESENT
+#include "softdevice_handler.h"
+#endif
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+#include "pwr_idle.h"
+#include "wdt_sup.h"
+#endif
+#if NRF_MODULE_ENABLED(ENERGY)
+#include "energy.h"
+#endif
 
 
 #define TEST_STRING "Nordic"
-#define  TRANS_LENGTH  4096
-static uint8_t       m_tx_buf[TRANS_LENGTH];           /**< TX buffer. */
-static uint8_t       m_rx_buf[TRANS_LENGTH];           /**< RX buffer. */
-static const uint16_t m_length ;               /**< Transfer length. */
-uint8_t MX25_BUFF[4096];
+static uint8_t MX25_BUFF[4096];   /**< Sector copy for write_mx25l16_buf(), the erase takes all of it. */
 
 #define  RANDOM_SEED   106
 #define  FLASH_TARGET_ADDR  0x000000
 
 
-#define SPI_INSTANCE  0 /**< SPI instance index. */
-static const nrf_drv_spi_t spi = NRF_DRV_SPI_INSTANCE(SPI_INSTANCE);  /**< SPI instance. */
+#if NRF_MODULE_ENABLED(MX25_QSPI)
+#ifndef NRF52840_XXAA
+#error "MX25_QSPI needs the QSPI peripheral of the nRF52840"
+#endif
+#if !QSPI_ENABLED
+#error "MX25_QSPI runs its commands through nrf_drv_qspi, set QSPI_ENABLED"
+#endif
+#elif !NRF_MODULE_ENABLED(SPI_BUS)
+#error "flash_io runs its commands through spi_bus, set SPI_BUS_ENABLED"
+#endif
 
-void spi_event_handler(nrf_drv_spi_evt_t const * p_event)
+#if !NRF_MODULE_ENABLED(MX25_QSPI)
+static const spi_bus_dev_t m_mx25_dev =
 {
-//    spi_xfer_done = true;
-//    NRF_LOG_INFO("Transfer completed.\r\n");
-//    if (m_rx_buf[0] != 0)
-//    {
-//        NRF_LOG_INFO(" Received: \r\n");
-//        NRF_LOG_HEXDUMP_INFO(m_rx_buf, strlen((const char *)m_rx_buf));
-//    }
+    .ss_pin    = SPI_SS_PIN,
+    .frequency = MX25_SPI_FREQUENCY,
+    .mode      = NRF_DRV_SPI_MODE_0,
+    .bit_order = NRF_DRV_SPI_BIT_ORDER_MSB_FIRST,
+};
+#endif
+
+static void cpu_wait(void)
+{
+#ifdef SOFTDEVICE_PRESENT
+    if (softdevice_handler_is_enabled())
+    {
+        UNUSED_RETURN_VALUE(sd_app_evt_wait());
+        return;
+    }
+#endif
+    __WFE();
+    __SEV();
+    __WFE();
 }
 
 
-void init_mx25l16mb_spi(void)
+/**@brief Read run by the SPI interrupt, see mx25lxx_read_start(). */
+static spi_bus_cmd_t       m_read_cmd;
+static mx25_read_handler_t m_read_handler;
+
+
+static void read_done(ret_code_t result, void * p_context)
+{
+    UNUSED_PARAMETER(result);
+
+    if (m_read_handler != NULL)
+    {
+        m_read_handler(p_context);
+    }
+}
+
+
+#if NRF_MODULE_ENABLED(MX25_QSPI)
+/* The same commands on the QSPI of the nRF52840, described by the same spi_bus_cmd_t:
+ *
+ *   read       FAST READ becomes READ4IO (0xEB), address and data on four lines
+ *   program    PP becomes PP4IO (0x38); the peripheral sends WREN itself, the one from
+ *              mx25lxx_write_enable() does no harm
+ *   erase      SE and CE are started and left running: the next command, or
+ *              mx25lxx_is_busy(), waits for the peripheral before it looks at WIP
+ *   others     custom instructions, opcode and up to QSPI_CINSTR_MAX bytes
+ *
+ * EasyDMA moves words: buffers, addresses and lengths that are not word aligned go through
+ * m_bounce, a page at a time. Reads need the QE bit of the status register, set once in
+ * device_mx25l16mb_init(). */
+#define QSPI_XIP_BASE        0x12000000UL   /**< Where the QSPI maps the flash for execute in place. */
+#define QSPI_CINSTR_MAX      8              /**< Data bytes of a custom instruction. */
+#define QSPI_ALIGNED(x)      (((uint32_t)(x) & 3) == 0)
+#define MX25_SR_QE           0x40           /**< Quad enable, non-volatile. */
+
+__ALIGN(4) static uint8_t       m_bounce[256];
+static volatile bool            m_qspi_busy;   /**< A read, program or erase task is running. */
+static spi_bus_cmd_t * volatile m_qspi_read;   /**< Background read to finish on its DONE event. */
+
+
+static void qspi_handler(nrf_drv_qspi_evt_t event, void * p_context)
+{
+    spi_bus_cmd_t * p_cmd = m_qspi_read;
+
+    UNUSED_PARAMETER(event);
+    UNUSED_PARAMETER(p_context);
+
+    m_qspi_read = NULL;
+    m_qspi_busy = false;
+    if (p_cmd != NULL)
+    {
+        p_cmd->queued = false;
+        if (p_cmd->callback != NULL)
+        {
+            p_cmd->callback(NRF_SUCCESS, p_cmd->p_context);
+        }
+    }
+}
+
+
+static void qspi_wait(void)
+{
+    while (m_qspi_busy)
+    {
+        cpu_wait();
+    }
+}
+
+
+/**@brief Wait for the task before and claim the peripheral for the next one. */
+static void qspi_begin(void)
+{
+    qspi_wait();
+    m_qspi_busy = true;
+}
+
+
+static void qspi_check(ret_code_t err_code)
+{
+    if (err_code != NRF_SUCCESS)
+    {
+        m_qspi_busy = false;
+        m_qspi_read = NULL;
+    }
+    APP_ERROR_CHECK(err_code);
+}
+
+
+static bool qspi_direct(void const * p_buf, uint32_t addr, uint16_t len)
+{
+    return QSPI_ALIGNED(p_buf) && QSPI_ALIGNED(addr) && QSPI_ALIGNED(len) && nrf_drv_is_in_RAM(p_buf);
+}
+
+
+static void qspi_read(uint8_t * p_rx, uint32_t addr, uint16_t len)
+{
+    if (qspi_direct(p_rx, addr, len))
+    {
+        qspi_begin();
+        qspi_check(nrf_drv_qspi_read(p_rx, len, addr));
+        qspi_wait();
+        return;
+    }
+
+    while (len > 0)
+    {
+        uint32_t base  = addr & ~3UL;
+        uint16_t skip  = addr - base;
+        uint16_t chunk = MIN(len, sizeof(m_bounce) - skip);
+
+        qspi_begin();
+        qspi_check(nrf_drv_qspi_read(m_bounce, ALIGN_NUM(4, skip + chunk), base));
+        qspi_wait();
+        memcpy(p_rx, &m_bounce[skip], chunk);
+
+        p_rx += chunk;
+        addr += chunk;
+        len  -= chunk;
+    }
+}
+
+
+/**@brief Program up to one page. Returns once the data has left RAM, while the chip still
+ *        programs it. Bytes around an unaligned start or end go out as 0xFF, which leaves
+ *        them as they are.
+ */
+static void qspi_program(uint8_t const * p_tx, uint32_t addr, uint16_t len)
+{
+    uint32_t base = addr & ~3UL;
+    uint16_t skip = addr - base;
+
+    qspi_begin();
+    if (qspi_direct(p_tx, addr, len))
+    {
+        qspi_check(nrf_drv_qspi_write(p_tx, len, addr));
+    }
+    else
+    {
+        ASSERT(skip + len <= sizeof(m_bounce));
+        memset(m_bounce, 0xFF, sizeof(m_bounce));
+        memcpy(&m_bounce[skip], p_tx, len);
+        qspi_check(nrf_drv_qspi_write(m_bounce, ALIGN_NUM(4, skip + len), base));
+    }
+    qspi_wait();
+}
+
+
+static void qspi_cinstr(spi_bus_cmd_t * p_cmd)
+{
+    uint8_t                data[QSPI_CINSTR_MAX] = {0};
+    nrf_qspi_cinstr_conf_t config =
+        NRF_DRV_QSPI_DEFAULT_CINSTR(p_cmd->opcode,
+                                    (nrf_qspi_cinstr_len_t)(NRF_QSPI_CINSTR_LEN_1B + p_cmd->tx_len + p_cmd->rx_len));
+
+    ASSERT((p_cmd->addr_len == 0) && (p_cmd->tx_len + p_cmd->rx_len <= QSPI_CINSTR_MAX));
+    if (p_cmd->tx_len > 0)
+    {
+        memcpy(data, p_cmd->p_tx, p_cmd->tx_len);
+    }
+
+    // Custom instructions are refused while a task runs.
+    qspi_wait();
+    APP_ERROR_CHECK(nrf_drv_qspi_cinstr_xfer(&config, data, data));
+
+    if (p_cmd->rx_len > 0)
+    {
+        memcpy(p_cmd->p_rx, &data[p_cmd->tx_len], p_cmd->rx_len);
+    }
+}
+
+
+/**@brief Run one command; erases are left running. Thread mode only. */
+static void cmd_run(spi_bus_cmd_t * p_cmd)
+{
+    switch (p_cmd->opcode)
+    {
+        case FLASH_CMD_FASTREAD:
+            qspi_read(p_cmd->p_rx, p_cmd->addr, p_cmd->rx_len);
+            break;
+
+        case FLASH_CMD_PP:
+            qspi_program(p_cmd->p_tx, p_cmd->addr, p_cmd->tx_len);
+            break;
+
+        case FLASH_CMD_SE:
+            qspi_begin();
+            qspi_check(nrf_drv_qspi_erase(NRF_QSPI_ERASE_LEN_4KB, p_cmd->addr));
+            break;
+
+        case FLASH_CMD_CE:
+            qspi_begin();
+            qspi_check(nrf_drv_qspi_chip_erase());
+            break;
+
+        default:
+            qspi_cinstr(p_cmd);
+            break;
+    }
+}
+
+
+/**@brief Start the background read of mx25lxx_read_start(). A read the EasyDMA cannot take
+ *        directly is done through m_bounce before the return, its callback with it.
+ */
+static void read_schedule(spi_bus_cmd_t * p_cmd)
+{
+    if (!qspi_direct(p_cmd->p_rx, p_cmd->addr, p_cmd->rx_len))
+    {
+        qspi_read(p_cmd->p_rx, p_cmd->addr, p_cmd->rx_len);
+        p_cmd->callback(NRF_SUCCESS, p_cmd->p_context);
+        return;
+    }
+
+    qspi_begin();
+    p_cmd->queued = true;
+    m_qspi_read   = p_cmd;
+    qspi_check(nrf_drv_qspi_read(p_cmd->p_rx, p_cmd->rx_len, p_cmd->addr));
+}
+
+#define flash_bus_idle()  (!m_qspi_busy)
+#else
+/**@brief Run one command and sleep until it is done, behind a background read that still
+ *        holds the bus. Thread mode only.
+ */
+static void cmd_run(spi_bus_cmd_t * p_cmd)
+{
+    p_cmd->p_dev = &m_mx25_dev;
+    APP_ERROR_CHECK(spi_bus_perform(p_cmd));
+}
+
+
+static void read_schedule(spi_bus_cmd_t * p_cmd)
+{
+    p_cmd->p_dev = &m_mx25_dev;
+    APP_ERROR_CHECK(spi_bus_schedule(p_cmd));
+}
+
+#define flash_bus_idle()  spi_bus_idle()
+#endif
+
+
+#if NRF_MODULE_ENABLED(MX25_POWER)
+#define IDLE_TICKS  APP_TIMER_TICKS(MX25_POWER_IDLE_MS, APP_TIMER_CONFIG_PRESCALER)
+
+APP_TIMER_DEF(m_idle_timer);
+
+static bool          m_asleep;
+static volatile bool m_idle_timer_running;
+static uint32_t      m_last_access;   /**< app_timer_cnt_get() at the last chip select. */
+
+
+static void idle_timer_arm(uint32_t ticks)
+{
+    if (app_timer_start(m_idle_timer, MAX(ticks, APP_TIMER_MIN_TIMEOUT_TICKS), NULL) == NRF_SUCCESS)
+    {
+        m_idle_timer_running = true;
+    }
+}
+
+
+/**@brief Put the chip into deep power-down once it has been left alone for MX25_POWER_IDLE_MS. */
+static void idle_check(void * p_event_data, uint16_t event_size)
+{
+    uint32_t idle;
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    m_idle_timer_running = false;
+    if (m_asleep)
+    {
+        return;
+    }
+
+    UNUSED_RETURN_VALUE(app_timer_cnt_diff_compute(app_timer_cnt_get(), m_last_access, &idle));
+    if (idle < IDLE_TICKS)
+    {
+        idle_timer_arm(IDLE_TICKS - idle);
+        return;
+    }
+#if NRF_MODULE_ENABLED(MX25_ASYNC)
+    if (mx25_async_busy())
+    {
+        idle_timer_arm(IDLE_TICKS);
+        return;
+    }
+#endif
+    mx25lxx_powerdown();
+}
+
+
+/**@brief DP and RDP go over SPI, which only runs in thread mode. */
+static void idle_timer_handler(void * p_context)
 {
-	  ret_code_t err_code;
+    UNUSED_PARAMETER(p_context);
 
-	nrf_drv_spi_config_t spi_config =  
-    {  
-        .ss_pin       = NRF_DRV_SPI_PIN_NOT_USED,
-				.miso_pin     = SPI_MISO_PIN,
-				.mosi_pin     = SPI_MOSI_PIN,
-				.sck_pin      = SPI_SCK_PIN,			
-        .irq_priority = APP_IRQ_PRIORITY_LOW,  
-        .orc          = 0xCC,  
-        .frequency    = SPI_FREQUENCY_FREQUENCY_M1,  
-        .mode         = NRF_DRV_SPI_MODE_0,  
-        .bit_order    = NRF_DRV_SPI_BIT_ORDER_MSB_FIRST,  
-    };
-    APP_ERROR_CHECK(nrf_drv_spi_init(&spi, &spi_config, NULL));
-		nrf_gpio_cfg_output(SPI_SS_PIN);
+    if (app_sched_event_put(NULL, 0, idle_check) != NRF_SUCCESS)
+    {
+        m_idle_timer_running = false;
+    }
+}
+
+
+/**@brief Before a command: wake the chip if it is powered down, restart the idle time. */
+static void mx25_access(void)
+{
+    if (m_asleep)
+    {
+        mx25lxx_wakeup();
+    }
+    m_last_access = app_timer_cnt_get();
+    if (!m_idle_timer_running)
+    {
+        idle_timer_arm(IDLE_TICKS);
+    }
+}
+
+
+void mx25lxx_idle_sleep(void)
+{
+#if NRF_MODULE_ENABLED(MX25_ASYNC)
+    if (mx25_async_busy())
+    {
+        return;
+    }
+#endif
+    if (!m_asleep)
+    {
+        mx25lxx_powerdown();
+    }
+}
+
+
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+/**@brief pwr_idle hook: deep power-down without waiting for the idle time; the next command
+ *        wakes the chip in mx25_access(). */
+static bool mx25_idle(void)
+{
+    if (m_asleep || mx25lxx_read_active() || !flash_bus_idle())
+    {
+        return false;
+    }
+#if NRF_MODULE_ENABLED(MX25_ASYNC)
+    if (mx25_async_busy())
+    {
+        return false;
+    }
+#endif
+    mx25lxx_powerdown();
+    return true;
+}
+
+
+static const pwr_idle_hook_t m_idle_hook =
+{
+    .idle    = mx25_idle,
+    .wake_us = MX25_WAKE_US,
+};
+#endif
+#else
+#define mx25_access()
+#endif
+
+
+static void mx25_cmd(spi_bus_cmd_t * p_cmd)
+{
+    mx25_access();
+    cmd_run(p_cmd);
+}
+
+
+void init_mx25l16mb_spi(void)
+{
+#if NRF_MODULE_ENABLED(MX25_QSPI)
+	nrf_drv_qspi_config_t config =
+	{
+		.pins =
+		{
+			.sck_pin = MX25_QSPI_SCK_PIN,
+			.csn_pin = MX25_QSPI_CSN_PIN,
+			.io0_pin = MX25_QSPI_IO0_PIN,
+			.io1_pin = MX25_QSPI_IO1_PIN,
+			.io2_pin = MX25_QSPI_IO2_PIN,
+			.io3_pin = MX25_QSPI_IO3_PIN,
+		},
+		.prot_if =
+		{
+			.readoc    = NRF_QSPI_READOC_READ4IO,
+			.writeoc   = NRF_QSPI_WRITEOC_PP4IO,
+			.addrmode  = NRF_QSPI_ADDRMODE_24BIT,
+			.dpmconfig = false,
+		},
+		.phy_if =
+		{
+			.sck_freq  = (nrf_qspi_frequency_t)MX25_QSPI_FREQUENCY,
+			.sck_delay = 1,
+			.spi_mode  = NRF_QSPI_MODE_0,
+			.dpmen     = false,
+		},
+		.irq_priority = MX25_QSPI_IRQ_PRIORITY,
+	};
+
+	APP_ERROR_CHECK(nrf_drv_qspi_init(&config, qspi_handler, NULL));
+#else
+	APP_ERROR_CHECK(spi_bus_init());
+	spi_bus_dev_init(&m_mx25_dev);
+#endif
 }
 
 void device_mx25l16mb_init() 
 {
 	init_mx25l16mb_spi();
-	
-	
+#if NRF_MODULE_ENABLED(MX25_POWER)
+	APP_ERROR_CHECK(app_timer_create(&m_idle_timer, APP_TIMER_MODE_SINGLE_SHOT, idle_timer_handler));
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+	APP_ERROR_CHECK(pwr_idle_register(&m_idle_hook));
+#endif
+#endif
+	// The chip stays in deep power-down across an nRF51 reset.
+	mx25lxx_wakeup();
+#if NRF_MODULE_ENABLED(MX25_QSPI)
+	if ((mx25lxx_readsr() & MX25_SR_QE) == 0)
+	{
+		mx25lxx_write_enable();
+		mx25lxx_writesr(mx25lxx_readsr() | MX25_SR_QE);
+		mx25lxx_wait_busy();
+	}
+#endif
 }
 
 void read_mx25l16_id(void)
 {
-	  m_tx_buf[0] = FLASH_CMD_RDID;
-	
+	uint8_t       id[3];
+	spi_bus_cmd_t cmd = {.opcode = FLASH_CMD_RDID, .p_rx = id, .rx_len = sizeof(id)};
 
-		nrf_gpio_pin_clear(SPI_SS_PIN);  
-		APP_ERROR_CHECK(nrf_drv_spi_transfer(&spi, m_tx_buf, 1, m_rx_buf, 4));
-		nrf_gpio_pin_set(SPI_SS_PIN); 
-		memset(m_rx_buf, 0, m_length);
+	mx25_cmd(&cmd);
+}
+
+void read_mx25l16_buf(uint8_t *read_buf, uint32_t flash_address, uint16_t byte_length)
+{
+	// FAST READ: one dummy byte after the address, no clock limit at MX25_SPI_FREQUENCY.
+	// DREAD needs a second data line, which the nRF51 SPI does not have.
+	spi_bus_cmd_t cmd =
+	{
+		.opcode    = FLASH_CMD_FASTREAD,
+		.addr_len  = 3,
+		.addr      = flash_address,
+		.dummy_len = 1,
+		.p_rx      = read_buf,
+		.rx_len    = byte_length,
+	};
+
+	// Array reads are not possible while a program or erase is running.
+	mx25lxx_wait_busy();
+	mx25_cmd(&cmd);
+}
+
+void mx25lxx_read_start(uint8_t *           read_buf,
+                        uint32_t            flash_address,
+                        uint16_t            byte_length,
+                        mx25_read_handler_t handler,
+                        void *              p_context)
+{
+	// Wait for the read before, which the bus would refuse to queue twice.
+	while (m_read_cmd.queued)
+	{
+		cpu_wait();
+	}
+	mx25lxx_wait_busy();
+	mx25_access();
+
+	m_read_handler       = handler;
+	m_read_cmd.opcode    = FLASH_CMD_FASTREAD;
+	m_read_cmd.addr_len  = 3;
+	m_read_cmd.addr      = flash_address;
+	m_read_cmd.dummy_len = 1;
+	m_read_cmd.p_rx      = read_buf;
+	m_read_cmd.rx_len    = byte_length;
+	m_read_cmd.callback  = read_done;
+	m_read_cmd.p_context = p_context;
+	read_schedule(&m_read_cmd);
 }
 
-uint8_t read_mx25l16_byte(void)
-{	  
-	
-	  APP_ERROR_CHECK(nrf_drv_spi_transfer(&spi, NULL, 0, m_rx_buf, 1));
 
-    return m_rx_buf[0];	
+bool mx25lxx_read_active(void)
+{
+	return m_read_cmd.queued;
 }
 
-void write_mx25l16_byte(uint8_t data)
+#if NRF_MODULE_ENABLED(MX25_QSPI)
+/**@brief XIP reads may come from the CPU cache, disabling it drops what it holds. */
+static void cache_invalidate(uint32_t flash_address, uint32_t byte_length)
 {
+    uint32_t icachecnf = NRF_NVMC->ICACHECNF;
 
-		APP_ERROR_CHECK(nrf_drv_spi_transfer(&spi, &data, 1, NULL, 0));
+    UNUSED_PARAMETER(flash_address);
+    UNUSED_PARAMETER(byte_length);
 
-	  
+    NRF_NVMC->ICACHECNF = 0;
+    NRF_NVMC->ICACHECNF = icachecnf;
 }
 
-void read_mx25l16_buf(uint8_t *read_buf, uint32_t flash_address, uint16_t byte_length)
+
+uint8_t const * mx25lxx_read_page_cached(uint32_t page_address)
 {
-	uint8_t temp[4] = {0};
-	
-	{
-		temp[0] = FLASH_CMD_READ;
-		temp[1] = (flash_address>> 16);
-		temp[2] = (flash_address>> 8);
-		temp[3] = (flash_address);
-		
-		nrf_gpio_pin_clear(SPI_SS_PIN); 
+    // The flash is mapped with READ4IO, no copy is needed once nothing is programmed or erased.
+    mx25lxx_wait_busy();
+    return (uint8_t const *)(QSPI_XIP_BASE + page_address);
+}
 
-		APP_ERROR_CHECK(nrf_drv_spi_transfer(&spi, temp, 4, NULL, 0));
-		APP_ERROR_CHECK(nrf_drv_spi_transfer(&spi, NULL, 0, read_buf, 128));
-		APP_ERROR_CHECK(nrf_drv_spi_transfer(&spi, NULL, 0, (read_buf+128), 128));
-		nrf_gpio_pin_set(SPI_SS_PIN);
 
-	}
-	
-	memset(m_rx_buf, 0, m_length);
+void mx25lxx_cache_flush(void)
+{
+    cache_invalidate(0, 0);
+}
+#elif NRF_MODULE_ENABLED(MX25_CACHE)
+#define CACHE_NO_PAGE  0xFFFFFFFF
+
+typedef struct
+{
+    uint32_t addr;   /**< Flash address of the cached page, CACHE_NO_PAGE if unused. */
+    uint32_t used;   /**< Value of m_cache_clock at the last hit. */
+} cache_tag_t;
+
+static cache_tag_t m_cache_tags[MX25_CACHE_PAGES];
+__ALIGN(4) static uint8_t m_cache_data[MX25_CACHE_PAGES][MX25_CACHE_PAGE_SIZE];
+static uint32_t    m_cache_clock;
+static bool        m_cache_ready;
+
+
+static void cache_invalidate(uint32_t flash_address, uint32_t byte_length)
+{
+    uint32_t first = flash_address & ~(MX25_CACHE_PAGE_SIZE - 1);
+
+    for (uint8_t n = 0; n < MX25_CACHE_PAGES; n++)
+    {
+        if ((m_cache_tags[n].addr != CACHE_NO_PAGE) &&
+            (m_cache_tags[n].addr >= first) && (m_cache_tags[n].addr < flash_address + byte_length))
+        {
+            m_cache_tags[n].addr = CACHE_NO_PAGE;
+        }
+    }
+}
+
+
+uint8_t const * mx25lxx_read_page_cached(uint32_t page_address)
+{
+    uint8_t lru = 0;
+
+    if (!m_cache_ready)
+    {
+        for (uint8_t n = 0; n < MX25_CACHE_PAGES; n++)
+        {
+            m_cache_tags[n].addr = CACHE_NO_PAGE;
+        }
+        m_cache_ready = true;
+    }
+
+    page_address &= ~(MX25_CACHE_PAGE_SIZE - 1);
+    m_cache_clock++;
+
+    for (uint8_t n = 0; n < MX25_CACHE_PAGES; n++)
+    {
+        if (m_cache_tags[n].addr == page_address)
+        {
+            m_cache_tags[n].used = m_cache_clock;
+            return m_cache_data[n];
+        }
+        if ((m_cache_tags[n].addr == CACHE_NO_PAGE) ||
+            ((m_cache_tags[lru].addr != CACHE_NO_PAGE) && (m_cache_tags[n].used < m_cache_tags[lru].used)))
+        {
+            lru = n;
+        }
+    }
+
+    read_mx25l16_buf(m_cache_data[lru], page_address, MX25_CACHE_PAGE_SIZE);
+    m_cache_tags[lru].addr = page_address;
+    m_cache_tags[lru].used = m_cache_clock;
+
+    return m_cache_data[lru];
+}
+
+
+void mx25lxx_cache_flush(void)
+{
+    m_cache_ready = false;
 }
+#else
+#define cache_invalidate(flash_address, byte_length)
+#endif
 
 	uint16_t i;
-void write_mx25lxx_page(uint8_t* write_buff, uint32_t flash_address, uint16_t byte_length)
+void mx25lxx_program_start(uint8_t const * write_buff, uint32_t flash_address, uint16_t byte_length)
 {
 
-	uint8_t temp[4] = {0};
-		
-	temp[0] = FLASH_CMD_PP ;           //FLASH_CMD_PP;
-	temp[1] = (flash_address>> 16);
-	temp[2] = (flash_address>> 8);
-	temp[3] = (flash_address);
-	
+	spi_bus_cmd_t cmd =
+	{
+		.opcode   = FLASH_CMD_PP,
+		.addr_len = 3,
+		.addr     = flash_address,
+		.p_tx     = write_buff,
+		.tx_len   = byte_length,
+	};
+
+	// WREN is ignored while an earlier program or erase is still running.
+	mx25lxx_wait_busy();
 	mx25lxx_write_enable();
-	nrf_gpio_pin_clear(SPI_SS_PIN);
-
-	APP_ERROR_CHECK(nrf_drv_spi_transfer(&spi, temp, 4, NULL, 0));
+	mx25_cmd(&cmd);
+#if NRF_MODULE_ENABLED(ENERGY)
+	energy_on(ENERGY_FLASH_PROG);
+#endif
+	cache_invalidate(flash_address, byte_length);
+}
 
-	APP_ERROR_CHECK(nrf_drv_spi_transfer(&spi, write_buff, 128, NULL, 0));
-	APP_ERROR_CHECK(nrf_drv_spi_transfer(&spi, (write_buff+128), 128, NULL, 0));
-	
-	nrf_gpio_pin_set(SPI_SS_PIN);
+void write_mx25lxx_page(uint8_t* write_buff, uint32_t flash_address, uint16_t byte_length)
+{
+	mx25lxx_program_start(write_buff, flash_address, byte_length);
 	mx25lxx_wait_busy();
 }
 
@@ -153,7 +708,7 @@ void write_mx25l16_buf(uint8_t *write_buf, uint32_t flash_address, uint16_t byte
 	
 	while(1)
 	{
-		read_mx25l16_buf(MX25_BUFF,(secpos*4096),256);
+		read_mx25l16_buf(MX25_BUFF,(secpos*4096),4096);
 		for(i=0; i<secrenum; i++)
 		{
 			if(MX25_BUFF[secoff+i]!=0xFF)
@@ -163,7 +718,7 @@ void write_mx25l16_buf(uint8_t *write_buf, uint32_t flash_address, uint16_t byte
 		}
 		if(i<secrenum)
 		{
-			mx25lxx_erase_sector(secpos);
+			mx25lxx_erase_sector(secpos*4096);
 			for(i=0; i<secrenum; i++)
 			{
 				MX25_BUFF[i+secoff]=write_buf[i];
@@ -240,25 +795,18 @@ void write_mx25lxx_nocheck(uint8_t* write_buff, uint32_t flash_address, uint16_t
 
 uint8_t mx25lxx_readsr(void)
 {
-		uint8_t  temp;
-	
-		nrf_gpio_pin_clear(SPI_SS_PIN);
-		write_mx25l16_byte(FLASH_CMD_RDSR);
-		temp = read_mx25l16_byte();
-		nrf_gpio_pin_set(SPI_SS_PIN);
-	  return temp;
+		uint8_t       temp;
+		spi_bus_cmd_t cmd = {.opcode = FLASH_CMD_RDSR, .p_rx = &temp, .rx_len = 1};
+
+		mx25_cmd(&cmd);
+		return temp;
 }
 
 void mx25lxx_writesr(uint8_t data)
 {
-		uint8_t  temp[2] = {0};
-	
-		temp[0] = FLASH_CMD_WRSR;
-		temp[1] = data;
-		
-		nrf_gpio_pin_clear(SPI_SS_PIN); 		
-		APP_ERROR_CHECK(nrf_drv_spi_transfer(&spi, temp, 2, NULL, 0));
-		nrf_gpio_pin_set(SPI_SS_PIN);
+		spi_bus_cmd_t cmd = {.opcode = FLASH_CMD_WRSR, .p_tx = &data, .tx_len = 1};
+
+		mx25_cmd(&cmd);
 
 }
 
@@ -266,69 +814,112 @@ void mx25lxx_writesr(uint8_t data)
 void mx25lxx_write_enable(void)
 {
 
-	  nrf_gpio_pin_clear(SPI_SS_PIN); 
-		write_mx25l16_byte(FLASH_CMD_WREN); 
-		nrf_gpio_pin_set(SPI_SS_PIN);
+		spi_bus_cmd_t cmd = {.opcode = FLASH_CMD_WREN};
+
+		mx25_cmd(&cmd);
 }
 
 void mx25lxx_write_disable(void)
 {
 
-	  nrf_gpio_pin_clear(SPI_SS_PIN); 
-	 	write_mx25l16_byte(FLASH_CMD_WRDI); 	
-		nrf_gpio_pin_set(SPI_SS_PIN);
+		spi_bus_cmd_t cmd = {.opcode = FLASH_CMD_WRDI};
+
+		mx25_cmd(&cmd);
 }
 
 void mx25lxx_powerdown(void)
 {
 
-	  nrf_gpio_pin_clear(SPI_SS_PIN);  
-	 	write_mx25l16_byte(FLASH_CMD_DP); 
-		nrf_gpio_pin_set(SPI_SS_PIN);
+		spi_bus_cmd_t cmd = {.opcode = FLASH_CMD_DP};
+
+		cmd_run(&cmd);
+#if NRF_MODULE_ENABLED(MX25_POWER)
+		m_asleep = true;
+#endif
 }
 
 
 void mx25lxx_wakeup(void)	
 {
-	  nrf_gpio_pin_clear(SPI_SS_PIN);
-   	write_mx25l16_byte(FLASH_CMD_RDP); 
-		nrf_gpio_pin_set(SPI_SS_PIN);
+		spi_bus_cmd_t cmd = {.opcode = FLASH_CMD_RDP};
+
+		cmd_run(&cmd);
+		nrf_delay_us(MX25_WAKE_US);
+#if NRF_MODULE_ENABLED(MX25_POWER)
+		m_asleep = false;
+#endif
 }
 
 void mx25lxx_wait_busy(void)
 {
+#if NRF_MODULE_ENABLED(WDT_SUP)
+	// No way out of a program or erase that never ends; the supervisor records it and resets.
+	wdt_sup_begin(WDT_SUP_STORAGE);
+#endif
 	 while((mx25lxx_readsr()&0x01) == 0x01);
+#if NRF_MODULE_ENABLED(WDT_SUP)
+	wdt_sup_end(WDT_SUP_STORAGE);
+#endif
+#if NRF_MODULE_ENABLED(ENERGY)
+	energy_off(ENERGY_FLASH_PROG);
+	energy_off(ENERGY_FLASH_ERASE);
+#endif
 }
 
 
-void mx25lxx_erase_sector(uint32_t data_addr)	
+bool mx25lxx_is_busy(void)
 {
-	uint8_t  temp[4] = {0};
-	
-	temp[0] = FLASH_CMD_SE;
-	temp[1] = (data_addr>> 16);
-	temp[2] = (data_addr>> 8);
-	temp[3] = (data_addr);
+#if NRF_MODULE_ENABLED(MX25_QSPI)
+	if (m_qspi_busy)
+	{
+		return true;
+	}
+#endif
+	bool busy = ((mx25lxx_readsr() & 0x01) == 0x01);
+#if NRF_MODULE_ENABLED(ENERGY)
+	// The program or erase is over once the status shows it.
+	if (!busy)
+	{
+		energy_off(ENERGY_FLASH_PROG);
+		energy_off(ENERGY_FLASH_ERASE);
+	}
+#endif
+	return busy;
+}
+
+void mx25lxx_erase_sector_start(uint32_t data_addr)	
+{
+	spi_bus_cmd_t cmd = {.opcode = FLASH_CMD_SE, .addr_len = 3, .addr = data_addr};
 
-	mx25lxx_write_enable();
 	mx25lxx_wait_busy();
-	nrf_gpio_pin_clear(SPI_SS_PIN); 
-	APP_ERROR_CHECK(nrf_drv_spi_transfer(&spi, temp, 4, NULL, 0));
-	nrf_gpio_pin_set(SPI_SS_PIN);
+	mx25lxx_write_enable();
+	mx25_cmd(&cmd);
+#if NRF_MODULE_ENABLED(ENERGY)
+	energy_on(ENERGY_FLASH_ERASE);
+#endif
+	cache_invalidate(data_addr & ~0xFFFUL, 4096);
+}
+
+void mx25lxx_erase_sector(uint32_t data_addr)	
+{
+	mx25lxx_erase_sector_start(data_addr);
 	mx25lxx_wait_busy();
 }
 
 void mx25lxx_erase_chip(void)
 {
-	uint8_t temp1;
-	
-	temp1 = FLASH_CMD_CE;
-	mx25lxx_write_enable();
+	spi_bus_cmd_t cmd = {.opcode = FLASH_CMD_CE};
+
 	mx25lxx_wait_busy();
-	nrf_gpio_pin_clear(SPI_SS_PIN); 
-	write_mx25l16_byte(FLASH_CMD_CE);		
-	nrf_gpio_pin_set(SPI_SS_PIN);
+	mx25lxx_write_enable();
+	mx25_cmd(&cmd);
+#if NRF_MODULE_ENABLED(ENERGY)
+	energy_on(ENERGY_FLASH_ERASE);
+#endif
 	mx25lxx_wait_busy();
+#if NRF_MODULE_ENABLED(MX25_CACHE) || NRF_MODULE_ENABLED(MX25_QSPI)
+	mx25lxx_cache_flush();
+#endif
 }
 
 
@@ -355,20 +946,14 @@ void read_mx25_test(void)
   0xf00----0xfff   16	
 *********/
 //	  read_mx25l16_id();
-
-		for(uint16_t i = 0; i < TRANS_LENGTH; i++)
-		{
-			 m_tx_buf[i] = 0xaa;
-		}
-//	 write_mx25l16_buf(m_tx_buf,FLASH_TARGET_ADDR+0x800,256);
-	  read_mx25l16_buf(m_rx_buf,FLASH_TARGET_ADDR+0x800,256);
-	
-		memset(m_rx_buf, 0, m_length);
-		
-
-		    /* Erase 4K sector of flash memory
-       Note: It needs to erase dirty sector before program */
-		memset(m_rx_buf, 0, m_length);
+	  uint8_t * p_buf = frame_pool_alloc();
+
+	  if (p_buf == NULL)
+	  {
+	      return;
+	  }
+	  read_mx25l16_buf(p_buf,FLASH_TARGET_ADDR+0x800,256);
+	  frame_pool_free(p_buf);
 }
 
 
@@ -8,6 +8,7 @@
 #include "nrf_drv_spi.h"
 #include "nrf_gpio.h"
 #include "boards.h"
+#include "lock_board.h"
 #include "app_util_platform.h"
 #include "app_error.h"
 #include "nrf_delay.h"
@@ -57,10 +58,8 @@
 #endif
 
 
-#define SPI_SS_PIN         28  //!< Slave SCL pin
-#define SPI_MISO_PIN       29//!< Slave SDA pin
-#define SPI_MOSI_PIN       25   //irq
-#define SPI_SCK_PIN        24
+#define MX25_SPI_FREQUENCY  NRF_DRV_SPI_FREQ_8M   //nRF51 SPI maximum
+#define MX25_WAKE_US        30                    //tRES1, deep power-down to standby
 
 typedef uint8_t boolean;
 void device_mx25l16mb_init(void);
@@ -75,11 +74,60 @@ void mx25lxx_writesr(uint8_t data);
 uint8_t mx25lxx_readsr(void);
 uint8_t cmd_rdsr(uint8_t *StatusReg);
 void mx25lxx_wait_busy(void);
+bool mx25lxx_is_busy(void);
+void mx25lxx_erase_sector_start(uint32_t data_addr);
+void mx25lxx_program_start(uint8_t const * write_buff, uint32_t flash_address, uint16_t byte_length);
 void write_mx25l16_buf(uint8_t *write_buf, uint32_t flash_address, uint16_t byte_length);
 void read_mx25l16_buf(uint8_t *read_buf, uint32_t flash_address,  uint16_t byte_length);
+
+/**@brief Background read completion handler, called from the SPI (or QSPI) interrupt. */
+typedef void (*mx25_read_handler_t)(void * p_context);
+
+/**@brief Start a FAST READ that the SPI interrupt finishes while the caller goes on.
+ *
+ * @details Waits for a running program or erase, sends the command and returns; the data
+ *          arrives in @p read_buf from the SPI interrupt, then @p handler is called. Other
+ *          functions of this file wait until the read is done. The nRF51 SPI has no EasyDMA,
+ *          so the interrupt still takes a few cycles per byte, but the CPU is free between
+ *          bytes. Thread mode only.
+ *
+ *          With MX25_QSPI the EasyDMA of the QSPI does the whole read; one whose buffer,
+ *          address or length is not word aligned is done before the return instead, and
+ *          @p handler is called from it.
+ */
+void mx25lxx_read_start(uint8_t *           read_buf,
+                        uint32_t            flash_address,
+                        uint16_t            byte_length,
+                        mx25_read_handler_t handler,
+                        void *              p_context);
+
+/**@brief Whether a read started by mx25lxx_read_start() is still running. */
+bool mx25lxx_read_active(void);
 void write_mx25lxx_page(uint8_t* write_buff, uint32_t flash_address, uint16_t byte_length);
 void write_mx25lxx_nocheck(uint8_t* write_buff, uint32_t flash_address, uint16_t byte_length);
 
+/**@brief Map a flash page through the RAM page cache (MX25_CACHE).
+ *
+ * @details Returns a copy of the MX25_CACHE_PAGE_SIZE-aligned page that contains @p page_address,
+ *          read with FAST READ on a miss; the least recently used page is replaced. Programs and
+ *          erases done through this file keep the cache coherent. The pointer is valid until the
+ *          next call.
+ *
+ *          With MX25_QSPI the pointer is to @p page_address in the execute in place window of
+ *          the QSPI instead, no copy and no RAM, valid until the next program or erase.
+ */
+uint8_t const * mx25lxx_read_page_cached(uint32_t page_address);
+
+/**@brief Drop every cached page. */
+void mx25lxx_cache_flush(void);
+
+/**@brief Enter deep power-down now instead of after MX25_POWER_IDLE_MS (MX25_POWER).
+ *
+ * @details Does nothing while erase or program jobs are queued. The chip wakes up by itself
+ *          on the next access.
+ */
+void mx25lxx_idle_sleep(void);
+
 
 
 
@@ -0,0 +1,113 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(HF_CLOCK)
+#include "hf_clock.h"
+#include "nrf_drv_clock.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+
+#if !CLOCK_ENABLED
+#error "hf_clock needs CLOCK_ENABLED, nrf_drv_clock counts the requests"
+#endif
+
+#define HF_TICKS(ms)    APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+
+STATIC_ASSERT(HF_CLOCK_USER_COUNT <= 8);
+
+APP_TIMER_DEF(m_linger_timer);
+
+static volatile uint8_t m_held;         /**< Users holding the crystal. */
+static volatile uint8_t m_lingering;    /**< Users let go, until the timer. */
+
+
+/**@brief The crystal for @p bit, which nobody held before. */
+static void hold(uint8_t bit)
+{
+    bool start;
+
+    CRITICAL_REGION_ENTER();
+    start        = ((m_held | m_lingering) == 0);
+    m_held      |= bit;
+    m_lingering &= (uint8_t)~bit;
+    CRITICAL_REGION_EXIT();
+
+    // nrf_drv_clock counts, so a linger timer that stops it in between is harmless.
+    if (start)
+    {
+        nrf_drv_clock_hfclk_request(NULL);
+    }
+}
+
+
+/**@brief Let go of the crystal for @p bit, after the linger. */
+static void let_go(uint8_t bit)
+{
+    bool held;
+
+    CRITICAL_REGION_ENTER();
+    held = ((m_held & bit) != 0);
+    if (held)
+    {
+        m_held      &= (uint8_t)~bit;
+        m_lingering |= bit;
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (held)
+    {
+        UNUSED_RETURN_VALUE(app_timer_stop(m_linger_timer));
+        UNUSED_RETURN_VALUE(app_timer_start(m_linger_timer, HF_TICKS(HF_CLOCK_LINGER_MS), NULL));
+    }
+}
+
+
+static void linger_timer_handler(void * p_context)
+{
+    bool stop;
+
+    UNUSED_PARAMETER(p_context);
+
+    CRITICAL_REGION_ENTER();
+    stop        = (m_lingering != 0) && (m_held == 0);
+    m_lingering = 0;
+    CRITICAL_REGION_EXIT();
+
+    if (stop)
+    {
+        nrf_drv_clock_hfclk_release();
+    }
+}
+
+
+ret_code_t hf_clock_init(void)
+{
+    ret_code_t err_code = nrf_drv_clock_init();
+
+    if ((err_code != NRF_SUCCESS) && (err_code != NRF_ERROR_MODULE_ALREADY_INITIALIZED))
+    {
+        return err_code;
+    }
+    return app_timer_create(&m_linger_timer, APP_TIMER_MODE_SINGLE_SHOT, linger_timer_handler);
+}
+
+
+void hf_clock_request(hf_clock_user_t user)
+{
+    if ((m_held & (1UL << user)) == 0)
+    {
+        hold((uint8_t)(1UL << user));
+    }
+}
+
+
+void hf_clock_release(hf_clock_user_t user)
+{
+    let_go((uint8_t)(1UL << user));
+}
+
+
+bool hf_clock_is_running(void)
+{
+    return nrf_drv_clock_hfclk_is_running();
+}
+
+#endif //NRF_MODULE_ENABLED(HF_CLOCK)
@@ -0,0 +1,44 @@
+#ifndef __HF_CLOCK_H__
+#define __HF_CLOCK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* The 16 MHz crystal, on only while a user needs its accuracy:
+ *
+ *   users     each user holds the crystal at most once, so an extra request or release does not
+ *             unbalance the count of nrf_drv_clock, which asks the SoftDevice for it
+ *   linger    a release keeps the crystal for HF_CLOCK_LINGER_MS, so a burst of transfers pays
+ *             the start-up once; the crystal stops from the app_timer interrupt
+ *
+ * The radio gets the crystal from the SoftDevice whatever this module does. TWI, SPI and the
+ * GPIO run from the RC oscillator as well; the UART at 115200 baud and the 16 MHz TIMER that
+ * measures do not run well without the crystal. */
+
+/**@brief Users of the crystal. */
+typedef enum
+{
+    HF_CLOCK_USER_PN532,    /**< A PN532 on HSU is awake, from the wake-up to PowerDown. */
+    HF_CLOCK_USER_BENCH,    /**< A bench run, timed on TIMER1 or TIMER2. */
+    HF_CLOCK_USER_COUNT
+} hf_clock_user_t;
+
+/**@brief Set up nrf_drv_clock, if nobody did, and the linger timer. After ble_stack_init(). */
+ret_code_t hf_clock_init(void);
+
+/**@brief Hold the crystal. Thread mode or APP_IRQ_PRIORITY_LOW: it may call the SoftDevice.
+ *
+ * @details The crystal takes about a millisecond to start; meanwhile the RC oscillator runs.
+ */
+void hf_clock_request(hf_clock_user_t user);
+
+/**@brief Let go of the crystal, which stops HF_CLOCK_LINGER_MS after the last user let go.
+ *        Any priority.
+ */
+void hf_clock_release(hf_clock_user_t user);
+
+/**@brief Whether the crystal has started. */
+bool hf_clock_is_running(void);
+
+#endif
@@ -0,0 +1,250 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(IR_PROX)
+#include "ir_prox.h"
+#include "lock_gpio.h"
+#include "pn532_duty.h"
+#include "nrf_drv_gpiote.h"
+#include "nrf_drv_ppi.h"
+#include "nrf_timer.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+
+#if !NRF_MODULE_ENABLED(PPI) || !NRF_MODULE_ENABLED(GPIOTE) || !NRF_MODULE_ENABLED(PN532_DUTY)
+#error "ir_prox needs PPI_ENABLED, GPIOTE_ENABLED and PN532_DUTY_ENABLED"
+#endif
+#if TIMER1_ENABLED || TIMER2_ENABLED || NRF_MODULE_ENABLED(UART_FRAME)
+#error "ir_prox runs TIMER1 and TIMER2 itself, set TIMER1_ENABLED, TIMER2_ENABLED and UART_FRAME_ENABLED to 0"
+#endif
+#if NRF_MODULE_ENABLED(PROX_WAKE)
+#error "ir_prox and prox_wake both gate pn532_duty, enable one of them"
+#endif
+
+#define PULSE_TIMER     NRF_TIMER1
+#define COUNT_TIMER     NRF_TIMER2
+#define TICK_HZ         31250UL
+#define PERIOD_TICKS    ((IR_PROX_PERIOD_MS * TICK_HZ) / 1000)
+#define PULSE_TICKS     MAX((IR_PROX_PULSE_US * TICK_HZ) / 1000000, 1)
+#define IR_TICKS(ms)    APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+
+STATIC_ASSERT(PERIOD_TICKS <= UINT16_MAX);
+STATIC_ASSERT(1 + PULSE_TICKS < PERIOD_TICKS);
+
+APP_TIMER_DEF(m_idle_timer);
+
+static nrf_ppi_channel_t       m_ppi_on;       /**< Pulse start: emitter on. */
+static nrf_ppi_channel_t       m_ppi_off;      /**< Pulse end: emitter off. */
+static nrf_ppi_channel_t       m_ppi_open;     /**< Pulse start: echo window open. */
+static nrf_ppi_channel_t       m_ppi_close;    /**< Pulse end: echo window closed. */
+static nrf_ppi_channel_t       m_ppi_echo;     /**< Echo in the window: count, or clear the misses. */
+static nrf_ppi_channel_t       m_ppi_miss;     /**< Pulse end: count a miss, near only. */
+static nrf_ppi_channel_group_t m_window;
+static volatile bool           m_near;
+
+
+/**@brief Turn the counting around for @p near. TIMER2 interrupt, and init. */
+static void counting_set(bool near)
+{
+    uint32_t count = (uint32_t)nrf_timer_task_address_get(COUNT_TIMER, NRF_TIMER_TASK_COUNT);
+    uint32_t clear = (uint32_t)nrf_timer_task_address_get(COUNT_TIMER, NRF_TIMER_TASK_CLEAR);
+
+    nrf_timer_task_trigger(COUNT_TIMER, NRF_TIMER_TASK_CLEAR);
+    if (near)
+    {
+        nrf_timer_cc_write(COUNT_TIMER, NRF_TIMER_CC_CHANNEL0, IR_PROX_MISSES);
+        UNUSED_RETURN_VALUE(nrf_drv_ppi_channel_assign(m_ppi_echo,
+                                nrf_drv_gpiote_in_event_addr_get(IRDA_IN), clear));
+        UNUSED_RETURN_VALUE(nrf_drv_ppi_channel_enable(m_ppi_miss));
+    }
+    else
+    {
+        UNUSED_RETURN_VALUE(nrf_drv_ppi_channel_disable(m_ppi_miss));
+        nrf_timer_cc_write(COUNT_TIMER, NRF_TIMER_CC_CHANNEL0, IR_PROX_HITS);
+        UNUSED_RETURN_VALUE(nrf_drv_ppi_channel_assign(m_ppi_echo,
+                                nrf_drv_gpiote_in_event_addr_get(IRDA_IN), count));
+    }
+}
+
+
+static void idle_set(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    if (!m_near)
+    {
+        pn532_duty_idle(true);
+    }
+}
+
+
+static void idle_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    UNUSED_RETURN_VALUE(app_sched_event_put(NULL, 0, idle_set));
+}
+
+
+static void state_process(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    if (m_near)
+    {
+        UNUSED_RETURN_VALUE(app_timer_stop(m_idle_timer));
+        pn532_duty_idle(false);
+        pn532_duty_kick();
+    }
+    else
+    {
+        UNUSED_RETURN_VALUE(app_timer_start(m_idle_timer, IR_TICKS(IR_PROX_IDLE_S * 1000), NULL));
+    }
+}
+
+
+void TIMER2_IRQHandler(void)
+{
+    if (nrf_timer_event_check(COUNT_TIMER, NRF_TIMER_EVENT_COMPARE0))
+    {
+        nrf_timer_event_clear(COUNT_TIMER, NRF_TIMER_EVENT_COMPARE0);
+
+        m_near = !m_near;
+        counting_set(m_near);
+        // A lost event is made up for by the next change; the PN532 keeps its last interval.
+        UNUSED_RETURN_VALUE(app_sched_event_put(NULL, 0, state_process));
+    }
+}
+
+
+/**@brief TIMER1 at 31250 Hz: pulse from tick 1 to 1 + PULSE_TICKS, cleared at the period. */
+static void pulse_timer_init(void)
+{
+    nrf_timer_mode_set(PULSE_TIMER, NRF_TIMER_MODE_TIMER);
+    nrf_timer_bit_width_set(PULSE_TIMER, NRF_TIMER_BIT_WIDTH_16);
+    nrf_timer_frequency_set(PULSE_TIMER, NRF_TIMER_FREQ_31250Hz);
+    // Starting at 0, the first compare turns the emitter on, so the toggles stay in step.
+    nrf_timer_cc_write(PULSE_TIMER, NRF_TIMER_CC_CHANNEL0, 1);
+    nrf_timer_cc_write(PULSE_TIMER, NRF_TIMER_CC_CHANNEL1, 1 + PULSE_TICKS);
+    nrf_timer_cc_write(PULSE_TIMER, NRF_TIMER_CC_CHANNEL2, PERIOD_TICKS);
+    nrf_timer_shorts_enable(PULSE_TIMER, NRF_TIMER_SHORT_COMPARE2_CLEAR_MASK);
+}
+
+
+static void count_timer_init(void)
+{
+    nrf_timer_mode_set(COUNT_TIMER, NRF_TIMER_MODE_COUNTER);
+    nrf_timer_bit_width_set(COUNT_TIMER, NRF_TIMER_BIT_WIDTH_16);
+    nrf_timer_event_clear(COUNT_TIMER, NRF_TIMER_EVENT_COMPARE0);
+    nrf_timer_int_enable(COUNT_TIMER, NRF_TIMER_INT_COMPARE0_MASK);
+    NVIC_ClearPendingIRQ(TIMER2_IRQn);
+    NVIC_SetPriority(TIMER2_IRQn, IR_PROX_IRQ_PRIORITY);
+    NVIC_EnableIRQ(TIMER2_IRQn);
+}
+
+
+static ret_code_t pins_init(void)
+{
+    ret_code_t                  err_code;
+    nrf_drv_gpiote_out_config_t out_config = GPIOTE_CONFIG_OUT_TASK_TOGGLE(!IR_PROX_EMITTER_ACTIVE_STATE);
+    nrf_drv_gpiote_in_config_t  in_config  = IR_PROX_RECEIVER_ACTIVE_STATE ?
+                                             (nrf_drv_gpiote_in_config_t)GPIOTE_CONFIG_IN_SENSE_LOTOHI(true) :
+                                             (nrf_drv_gpiote_in_config_t)GPIOTE_CONFIG_IN_SENSE_HITOLO(true);
+
+    in_config.pull = NRF_GPIO_PIN_NOPULL;
+
+    if (!nrf_drv_gpiote_is_init())
+    {
+        err_code = nrf_drv_gpiote_init();
+        VERIFY_SUCCESS(err_code);
+    }
+    err_code = nrf_drv_gpiote_out_init(IRDA_PUT, &out_config);
+    VERIFY_SUCCESS(err_code);
+    // Events only: the PPI takes them, the GPIOTE interrupt stays off.
+    err_code = nrf_drv_gpiote_in_init(IRDA_IN, &in_config, NULL);
+    VERIFY_SUCCESS(err_code);
+
+    nrf_drv_gpiote_out_task_enable(IRDA_PUT);
+    nrf_drv_gpiote_in_event_enable(IRDA_IN, false);
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t ppi_link(nrf_ppi_channel_t * p_channel, uint32_t eep, uint32_t tep)
+{
+    ret_code_t err_code;
+
+    err_code = nrf_drv_ppi_channel_alloc(p_channel);
+    VERIFY_SUCCESS(err_code);
+    err_code = nrf_drv_ppi_channel_assign(*p_channel, eep, tep);
+    VERIFY_SUCCESS(err_code);
+    return nrf_drv_ppi_channel_enable(*p_channel);
+}
+
+
+static ret_code_t ppi_init(void)
+{
+    ret_code_t err_code;
+    uint32_t   start  = (uint32_t)nrf_timer_event_address_get(PULSE_TIMER, NRF_TIMER_EVENT_COMPARE0);
+    uint32_t   end    = (uint32_t)nrf_timer_event_address_get(PULSE_TIMER, NRF_TIMER_EVENT_COMPARE1);
+    uint32_t   toggle = nrf_drv_gpiote_out_task_addr_get(IRDA_PUT);
+
+    err_code = nrf_drv_ppi_init();
+    if ((err_code != NRF_SUCCESS) && (err_code != NRF_ERROR_MODULE_ALREADY_INITIALIZED))
+    {
+        return err_code;
+    }
+    err_code = nrf_drv_ppi_group_alloc(&m_window);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = ppi_link(&m_ppi_on, start, toggle);
+    VERIFY_SUCCESS(err_code);
+    err_code = ppi_link(&m_ppi_off, end, toggle);
+    VERIFY_SUCCESS(err_code);
+    err_code = ppi_link(&m_ppi_open, start, nrf_drv_ppi_task_addr_group_enable_get(m_window));
+    VERIFY_SUCCESS(err_code);
+    err_code = ppi_link(&m_ppi_close, end, nrf_drv_ppi_task_addr_group_disable_get(m_window));
+    VERIFY_SUCCESS(err_code);
+
+    err_code = nrf_drv_ppi_channel_alloc(&m_ppi_echo);
+    VERIFY_SUCCESS(err_code);
+    err_code = nrf_drv_ppi_channel_include_in_group(m_ppi_echo, m_window);
+    VERIFY_SUCCESS(err_code);
+    err_code = nrf_drv_ppi_channel_alloc(&m_ppi_miss);
+    VERIFY_SUCCESS(err_code);
+    err_code = nrf_drv_ppi_channel_assign(m_ppi_miss, end,
+                   (uint32_t)nrf_timer_task_address_get(COUNT_TIMER, NRF_TIMER_TASK_COUNT));
+    VERIFY_SUCCESS(err_code);
+
+    // The group enables the echo channel with every pulse; it starts out closed.
+    return nrf_drv_ppi_group_disable(m_window);
+}
+
+
+ret_code_t ir_prox_init(void)
+{
+    ret_code_t err_code;
+
+    err_code = app_timer_create(&m_idle_timer, APP_TIMER_MODE_SINGLE_SHOT, idle_timer_handler);
+    VERIFY_SUCCESS(err_code);
+    err_code = pins_init();
+    VERIFY_SUCCESS(err_code);
+    err_code = ppi_init();
+    VERIFY_SUCCESS(err_code);
+
+    pulse_timer_init();
+    count_timer_init();
+    counting_set(false);
+
+    nrf_timer_task_trigger(COUNT_TIMER, NRF_TIMER_TASK_START);
+    nrf_timer_task_trigger(PULSE_TIMER, NRF_TIMER_TASK_START);
+    return app_timer_start(m_idle_timer, IR_TICKS(IR_PROX_IDLE_S * 1000), NULL);
+}
+
+
+bool ir_prox_is_near(void)
+{
+    return m_near;
+}
+
+#endif //NRF_MODULE_ENABLED(IR_PROX)
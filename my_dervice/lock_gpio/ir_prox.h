@@ -0,0 +1,31 @@
+#ifndef _IR_PROX_H_
+#define _IR_PROX_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* Reflective IR presence on IRDA_PUT / IRDA_IN, gating the bursts of pn532_duty on boards
+ * without the csense pad of prox_wake:
+ *
+ *   pulse     TIMER1 toggles IRDA_PUT through GPIOTE and PPI: IR_PROX_PULSE_US on, every
+ *             IR_PROX_PERIOD_MS; the receiver is a plain phototransistor, not a carrier
+ *             demodulator
+ *   window    the same two compares enable and disable a PPI group around the pulse, so only
+ *             an IRDA_IN edge to its active level while the emitter is on counts as an echo;
+ *             ambient light that switches outside the window is not seen
+ *   count     TIMER2 in counter mode: while far it counts echoes up to IR_PROX_HITS, while near
+ *             it counts pulses without one, an echo clearing it, up to IR_PROX_MISSES
+ *   state     its compare is the only interrupt; it flips near and far and turns the counting
+ *             around, so no sample costs CPU time, only a change of the state does
+ *   gating    coming near starts a burst at once and undoes the idle back-off; after
+ *             IR_PROX_IDLE_S far the bursts back off to PN532_DUTY_IDLE_MS
+ *
+ * The two timers keep the 16 MHz clock requested while the CPU sleeps. */
+
+/**@brief Start the pulses. Call after app_timer, app_scheduler and pn532_duty_init(). */
+ret_code_t ir_prox_init(void);
+
+/**@brief Whether something reflects the pulses. */
+bool ir_prox_is_near(void);
+
+#endif
@@ -0,0 +1,383 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(KEEP_RAM)
+#include "keep_ram.h"
+#include "fds.h"
+#include "crc32.h"
+#include "app_error.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "app_util_platform.h"
+#include "nrf_soc.h"
+#include "nrf.h"
+#include <string.h>
+
+#define KEEP_TICKS(ms)      APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+#define TICK_MS             60000           /**< The flush interval is counted in minutes. */
+#define MAGIC               0x4B454550UL    /**< Laid out by this firmware. */
+#define SEALED              0x5345414CUL    /**< The check holds: written by the fault path. */
+#define RESET_RETAINS       (POWER_RESETREAS_RESETPIN_Msk | POWER_RESETREAS_DOG_Msk | \
+                             POWER_RESETREAS_SREQ_Msk | POWER_RESETREAS_LOCKUP_Msk)
+
+typedef struct
+{
+    uint32_t        magic;
+    uint16_t        size;       /**< sizeof(keep_ram_t); another layout is not taken. */
+    uint16_t        rfu;
+    uint32_t        seal;       /**< SEALED while @ref check holds. */
+    uint32_t        check;      /**< crc32 of @ref body. */
+    keep_ram_body_t body;
+} keep_ram_t;
+
+// The Keil projects keep RAM from KEEP_RAM_ADDR up out of IRAM1, as the NoInit IRAM2.
+#if defined(__CC_ARM)
+static keep_ram_t m_keep __attribute__((at(KEEP_RAM_ADDR), zero_init));
+#else
+static keep_ram_t m_keep __attribute__((section(".noinit")));
+#endif
+
+STATIC_ASSERT((sizeof(keep_ram_body_t) % sizeof(uint32_t)) == 0);
+#if NRF_MODULE_ENABLED(POST_MORTEM)
+STATIC_ASSERT(KEEP_RAM_ADDR + sizeof(keep_ram_t) <= POST_MORTEM_RAM_ADDR);
+#elif NRF_MODULE_ENABLED(WDT_SUP)
+STATIC_ASSERT(KEEP_RAM_ADDR + sizeof(keep_ram_t) <= WDT_SUP_CRASH_ADDR);
+#endif
+
+APP_TIMER_DEF(m_timer);
+
+static uint32_t          m_reas;            /**< RESETREAS, counted once the region is settled. */
+static bool              m_restore;         /**< The region did not survive: take the FDS copy. */
+static uint16_t          m_minutes;
+static uint32_t          m_flushed;         /**< Check of the body in FDS. */
+static fds_record_desc_t m_desc;
+static bool              m_record_found;
+static bool              m_write_pending;
+static volatile bool     m_flush_queued;
+
+
+static uint32_t body_check(void)
+{
+    return crc32_compute((uint8_t const *)&m_keep.body, sizeof(m_keep.body), NULL);
+}
+
+
+/**@brief Whether an unsealed body can be used: nothing in it would make lat_trace misbehave. */
+static bool body_consistent(keep_ram_body_t const * p_body)
+{
+#if NRF_MODULE_ENABLED(LAT_TRACE)
+    lat_trace_keep_t const * p_trace = &p_body->trace;
+
+    if ((p_trace->next >= LAT_TRACE_RING_SIZE) || (p_trace->count > LAT_TRACE_RING_SIZE))
+    {
+        return false;
+    }
+    for (uint16_t i = 0; i < p_trace->count; i++)
+    {
+        if (p_trace->ring[(p_trace->next + LAT_TRACE_RING_SIZE - 1 - i) % LAT_TRACE_RING_SIZE].stage >= LAT_STAGE_COUNT)
+        {
+            return false;
+        }
+    }
+    for (uint8_t i = 0; i < LAT_STAGE_COUNT; i++)
+    {
+        if ((p_trace->stats[i].count > 0) && (p_trace->stats[i].min > p_trace->stats[i].max))
+        {
+            return false;
+        }
+    }
+#else
+    UNUSED_PARAMETER(p_body);
+#endif
+    return true;
+}
+
+
+/**@brief Count the reset that brought the region to its present state. */
+static void reset_count(void)
+{
+    keep_ram_cnt_t cnt = KEEP_RAM_CNT_POWER_ON;
+
+    if ((m_reas & POWER_RESETREAS_DOG_Msk) != 0)
+    {
+        cnt = KEEP_RAM_CNT_WATCHDOG;
+    }
+    else if ((m_reas & POWER_RESETREAS_LOCKUP_Msk) != 0)
+    {
+        cnt = KEEP_RAM_CNT_LOCKUP;
+    }
+    else if ((m_reas & POWER_RESETREAS_SREQ_Msk) != 0)
+    {
+        cnt = KEEP_RAM_CNT_SOFT_RESET;
+    }
+    else if ((m_reas & POWER_RESETREAS_RESETPIN_Msk) != 0)
+    {
+        cnt = KEEP_RAM_CNT_PIN_RESET;
+    }
+    keep_ram_count(cnt);
+}
+
+
+void keep_ram_init(void)
+{
+    bool kept = false;
+
+    m_reas = NRF_POWER->RESETREAS;
+    // The bits add up until cleared; the SoftDevice is not up yet to restrict the register.
+    NRF_POWER->RESETREAS = m_reas;
+
+    if (((m_reas & RESET_RETAINS) != 0) && (m_keep.magic == MAGIC) && (m_keep.size == sizeof(m_keep)))
+    {
+        if ((m_keep.seal == SEALED) && (m_keep.check == body_check()))
+        {
+            kept = true;
+        }
+        else if (((m_reas & (POWER_RESETREAS_DOG_Msk | POWER_RESETREAS_LOCKUP_Msk)) != 0) &&
+                 body_consistent(&m_keep.body))
+        {
+            // Nobody could seal it, but the chip kept RAM.
+            kept = true;
+            keep_ram_count(KEEP_RAM_CNT_UNSEALED);
+        }
+    }
+    m_keep.seal = 0;
+
+    if (!kept)
+    {
+        memset(&m_keep, 0, sizeof(m_keep));
+        m_keep.magic = MAGIC;
+        m_keep.size  = sizeof(m_keep);
+        m_restore    = true;
+        return;
+    }
+    reset_count();
+}
+
+
+keep_ram_body_t * keep_ram_get(void)
+{
+    return &m_keep.body;
+}
+
+
+void keep_ram_count(keep_ram_cnt_t cnt)
+{
+    CRITICAL_REGION_ENTER();
+    m_keep.body.counters[cnt]++;
+    CRITICAL_REGION_EXIT();
+}
+
+
+void keep_ram_fault(uint32_t id, uint32_t pc, uint32_t info)
+{
+    keep_ram_fault_t * p_fault = &m_keep.body.fault;
+
+    m_keep.body.counters[KEEP_RAM_CNT_FAULTS]++;
+    p_fault->stamp = app_timer_cnt_get();
+    p_fault->id    = id;
+    p_fault->pc    = pc;
+    p_fault->info  = info;
+    p_fault->line  = 0;
+    if (id == NRF_FAULT_ID_SDK_ERROR)
+    {
+        p_fault->info = ((error_info_t const *)info)->err_code;
+        p_fault->line = ((error_info_t const *)info)->line_num;
+    }
+    else if (id == NRF_FAULT_ID_SDK_ASSERT)
+    {
+        p_fault->line = ((assert_info_t const *)info)->line_num;
+    }
+
+    m_keep.check = body_check();
+    m_keep.seal  = SEALED;
+}
+
+
+static void record_load(void)
+{
+    fds_find_token_t   token = {0};
+    fds_flash_record_t record;
+
+    if (fds_record_find(KEEP_RAM_FILE_ID, KEEP_RAM_RECORD_KEY, &m_desc, &token) != FDS_SUCCESS)
+    {
+        return;
+    }
+    m_record_found = true;
+
+    if (!m_restore || (fds_record_open(&m_desc, &record) != FDS_SUCCESS))
+    {
+        return;
+    }
+    if (record.p_header->tl.length_words == BYTES_TO_WORDS(sizeof(m_keep.body)))
+    {
+        CRITICAL_REGION_ENTER();
+        memcpy(&m_keep.body, record.p_data, sizeof(m_keep.body));
+#if NRF_MODULE_ENABLED(LAT_TRACE)
+        if (!body_consistent(&m_keep.body))
+        {
+            // Written while a stage was being recorded; the counters are good all the same.
+            memset(&m_keep.body.trace, 0, sizeof(m_keep.body.trace));
+        }
+#endif
+        CRITICAL_REGION_EXIT();
+        m_flushed = body_check();
+    }
+    (void)fds_record_close(&m_desc);
+}
+
+
+/**@brief Write the region as it is. It changes meanwhile; a copy that does not match its
+ *        layout any more is fixed on the way back by body_consistent().
+ */
+static void record_store(void)
+{
+    fds_record_chunk_t chunk;
+    fds_record_t       record;
+    uint32_t           check = body_check();
+    ret_code_t         err_code;
+
+    if (m_write_pending || (check == m_flushed))
+    {
+        return;
+    }
+
+    chunk.p_data       = &m_keep.body;
+    chunk.length_words = BYTES_TO_WORDS(sizeof(m_keep.body));
+
+    record.file_id         = KEEP_RAM_FILE_ID;
+    record.key             = KEEP_RAM_RECORD_KEY;
+    record.data.p_chunks   = &chunk;
+    record.data.num_chunks = 1;
+
+    if (m_record_found)
+    {
+        err_code = fds_record_update(&m_desc, &record);
+    }
+    else
+    {
+        err_code = fds_record_write(&m_desc, &record);
+    }
+
+    if (err_code == FDS_SUCCESS)
+    {
+        m_write_pending = true;
+        m_flushed       = check;
+    }
+    else if (err_code == FDS_ERR_NO_SPACE_IN_FLASH)
+    {
+        m_write_pending = (fds_gc() == FDS_SUCCESS);
+    }
+}
+
+
+static void flush(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    m_flush_queued = false;
+    record_store();
+}
+
+
+static void flush_schedule(void)
+{
+    if (!m_flush_queued)
+    {
+        m_flush_queued = (app_sched_event_put(NULL, 0, flush) == NRF_SUCCESS);
+    }
+}
+
+
+static void fds_evt_handler(fds_evt_t const * const p_evt)
+{
+    switch (p_evt->id)
+    {
+        case FDS_EVT_INIT:
+            if (p_evt->result == FDS_SUCCESS)
+            {
+                record_load();
+            }
+            if (m_restore)
+            {
+                m_restore = false;
+                reset_count();
+            }
+            break;
+
+        case FDS_EVT_WRITE:
+        case FDS_EVT_UPDATE:
+            if ((p_evt->write.file_id != KEEP_RAM_FILE_ID) ||
+                (p_evt->write.record_key != KEEP_RAM_RECORD_KEY))
+            {
+                break;
+            }
+            m_write_pending = false;
+            if (p_evt->result == FDS_SUCCESS)
+            {
+                m_record_found = true;
+            }
+            else
+            {
+                m_flushed = 0;
+            }
+            break;
+
+        case FDS_EVT_GC:
+            if (m_write_pending)
+            {
+                m_write_pending = false;
+                m_flushed       = 0;
+                record_store();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+static void timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    if (++m_minutes >= KEEP_RAM_FLUSH_MIN)
+    {
+        m_minutes = 0;
+        flush_schedule();
+    }
+}
+
+
+ret_code_t keep_ram_start(void)
+{
+    ret_code_t err_code;
+
+    err_code = app_timer_create(&m_timer, APP_TIMER_MODE_REPEATED, timer_handler);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = fds_register(fds_evt_handler);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = fds_init();
+    VERIFY_SUCCESS(err_code);
+
+    err_code = sd_power_pof_threshold_set(KEEP_RAM_POF_THRESHOLD);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = sd_power_pof_enable(1);
+    VERIFY_SUCCESS(err_code);
+
+    return app_timer_start(m_timer, KEEP_TICKS(TICK_MS), NULL);
+}
+
+
+void keep_ram_on_sys_evt(uint32_t sys_evt)
+{
+    if (sys_evt == NRF_EVT_POWER_FAILURE_WARNING)
+    {
+        // The supply is going; RAM will not outlive it.
+        flush_schedule();
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(KEEP_RAM)
@@ -0,0 +1,100 @@
+#ifndef __KEEP_RAM_H__
+#define __KEEP_RAM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_common.h"
+#include "lat_trace.h"
+
+/* Diagnostics kept in RAM over soft resets, and now and then in FDS over power loss:
+ *
+ *   region    counters, the last fault and the latency trace ring and statistics, at
+ *             KEEP_RAM_ADDR in RAM that the startup code leaves alone. Updates are plain
+ *             stores; nothing is written to flash on an event
+ *   seal      the fault path checksums the region right before the reset. At boot a sealed
+ *             region with the right check is kept as it is. After a watchdog or lockup reset,
+ *             which the chip also survives with RAM, an unsealed region is kept if it is
+ *             consistent, and counted in KEEP_RAM_CNT_UNSEALED. After power on or brown-out
+ *             the region is taken from the last FDS copy
+ *   flush     the region goes to FDS every KEEP_RAM_FLUSH_MIN minutes when it changed, and at once on
+ *             the power failure warning, when RAM is about to be lost
+ *
+ * keep_ram_init() runs first in main(), before anything records. */
+
+/**@brief Counters kept over resets. */
+typedef enum
+{
+    KEEP_RAM_CNT_POWER_ON,      /**< Power on and brown-out resets: the region came from FDS. */
+    KEEP_RAM_CNT_SOFT_RESET,    /**< NVIC_SystemReset(), from the fault handlers among others. */
+    KEEP_RAM_CNT_WATCHDOG,      /**< Watchdog resets. */
+    KEEP_RAM_CNT_LOCKUP,        /**< CPU lockup resets. */
+    KEEP_RAM_CNT_PIN_RESET,     /**< Reset pin. */
+    KEEP_RAM_CNT_UNSEALED,      /**< Resets after which the region was kept without a seal. */
+    KEEP_RAM_CNT_FAULTS,        /**< Faults that reached post_mortem. */
+    KEEP_RAM_CNT_TAPS,          /**< Cards reported. */
+    KEEP_RAM_CNT_DENIED,        /**< Of those, the ones refused. */
+    KEEP_RAM_CNT_CONNECTS,      /**< BLE connections. */
+    KEEP_RAM_CNT_COUNT
+} keep_ram_cnt_t;
+
+/**@brief The last fault. */
+typedef struct
+{
+    uint32_t stamp;             /**< app_timer_cnt_get() at the fault. */
+    uint32_t id;                /**< NRF_FAULT_ID_*, POST_MORTEM_ID_*. */
+    uint32_t pc;
+    uint32_t info;              /**< NRF_FAULT_ID_SDK_ERROR: the error; otherwise as app_error passed it. */
+    uint32_t line;              /**< NRF_FAULT_ID_SDK_ERROR and _ASSERT: the line. */
+} keep_ram_fault_t;
+
+/**@brief What is kept; also the FDS record. */
+typedef struct
+{
+    uint32_t         counters[KEEP_RAM_CNT_COUNT];
+    keep_ram_fault_t fault;     /**< id 0 if there has been none. */
+#if NRF_MODULE_ENABLED(LAT_TRACE)
+    lat_trace_keep_t trace;
+#endif
+} keep_ram_body_t;
+
+#if NRF_MODULE_ENABLED(KEEP_RAM)
+
+/**@brief Check the region against the reset reason; clear it if it did not survive.
+ *
+ * @details First thing in main(): no SoftDevice, timers or FDS needed.
+ */
+void keep_ram_init(void);
+
+/**@brief Take the FDS copy after a power on and start the flush timer and the power failure
+ *        warning.
+ *
+ * @details Call after ble_stack_init(), with app_timer and app_scheduler initialized.
+ */
+ret_code_t keep_ram_start(void);
+
+/**@brief The region. */
+keep_ram_body_t * keep_ram_get(void);
+
+/**@brief Count an event. Any context. */
+void keep_ram_count(keep_ram_cnt_t cnt);
+
+/**@brief Record a fault and seal the region before the reset. Fault context: no locks, no
+ *        SoftDevice calls.
+ *
+ * @param[in] info  As app_error_fault_handler() has it.
+ */
+void keep_ram_fault(uint32_t id, uint32_t pc, uint32_t info);
+
+/**@brief Flush on the power failure warning. Call from the sys_evt dispatch. */
+void keep_ram_on_sys_evt(uint32_t sys_evt);
+
+#else
+
+__STATIC_INLINE void keep_ram_count(keep_ram_cnt_t cnt)
+{
+    UNUSED_PARAMETER(cnt);
+}
+
+#endif
+
+#endif
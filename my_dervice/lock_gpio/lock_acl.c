@@ -0,0 +1,998 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(LOCK_ACL)
+#include "lock_acl.h"
+#include "flash_io.h"
+#include "crc32.h"
+#include <string.h>
+#if NRF_MODULE_ENABLED(LOCK_ACL_DELTA)
+#include "nrf_crypto_aes.h"
+#include "pb_decode.h"
+#include "lock_acl_delta.pb.h"
+
+#if !NRF_MODULE_ENABLED(NRF_CRYPTO_AES)
+#error "lock_acl delta sync needs NRF_CRYPTO_AES_ENABLED"
+#endif
+#endif
+
+#define ACL_MAGIC_V1      0x314C4341  /**< "ACL1", fences taken from the pages. */
+#define ACL_MAGIC         0x324C4341  /**< "ACL2", fences stored after the header. */
+#define ACL_SECTOR_SIZE   4096
+#define ACL_ENTRIES_ADDR  (LOCK_ACL_FLASH_ADDR + ACL_SECTOR_SIZE)   /**< The header has a sector of its own. */
+#define ACL_FENCES_ADDR   (LOCK_ACL_FLASH_ADDR + 32)
+#define ACL_PAGE_ENTRIES  (LOCK_ACL_PAGE_SIZE / LOCK_ACL_ENTRY_SIZE)
+#define ACL_PAD           0xFF
+#define ACL_NO_PAGE       0xFFFFFFFF
+
+/**@brief First bytes of the header sector, followed by the fences at ACL_FENCES_ADDR.
+ *        Written last, after the image has been checked or the delta applied.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t entry_count;
+    uint32_t page_count;
+    uint32_t crc;
+    uint32_t version;
+} acl_header_t;
+
+typedef struct
+{
+    uint8_t uid_len;                       /**< ACL_PAD for an unused slot. */
+    uint8_t uid[LOCK_ACL_UID_MAX_LEN];
+} acl_entry_t;
+
+STATIC_ASSERT(sizeof(acl_entry_t) == LOCK_ACL_ENTRY_SIZE);
+STATIC_ASSERT(sizeof(acl_header_t) <= ACL_FENCES_ADDR - LOCK_ACL_FLASH_ADDR);
+STATIC_ASSERT(ACL_FENCES_ADDR + LOCK_ACL_MAX_PAGES * sizeof(uint32_t) <= ACL_ENTRIES_ADDR);
+#if NRF_MODULE_ENABLED(MX25_CACHE)
+STATIC_ASSERT(MX25_CACHE_PAGE_SIZE == LOCK_ACL_PAGE_SIZE);
+#endif
+
+#if NRF_MODULE_ENABLED(LOCK_ACL_ENROLL)
+#if !NRF_MODULE_ENABLED(LOCK_ACL_DELTA)
+#error "lock_acl enrollment needs LOCK_ACL_DELTA_ENABLED, for the site key and the page edits"
+#endif
+#define ACL_ENROLL_TAG    0x4C524E45  /**< "ENRL", signed with the list version to start enrolling. */
+STATIC_ASSERT(LOCK_ACL_ENROLL_BATCH <= UINT8_MAX);
+#endif
+
+#if NRF_MODULE_ENABLED(LOCK_ACL_DELTA)
+#define ACL_CARRY_MAX     4   /**< Entries of one hash that a delta can move on to the next page. */
+#define ACL_DELTA_ADDR    (ACL_ENTRIES_ADDR + CEIL_DIV(LOCK_ACL_MAX_PAGES * LOCK_ACL_PAGE_SIZE, ACL_SECTOR_SIZE) * ACL_SECTOR_SIZE)
+#define ACL_WORK_ENTRIES  (ACL_PAGE_ENTRIES + ACL_CARRY_MAX)
+STATIC_ASSERT((LOCK_ACL_DELTA_SIZE % ACL_SECTOR_SIZE) == 0);
+STATIC_ASSERT(sizeof(((AclDeltaOp *)0)->uid.bytes) == LOCK_ACL_UID_MAX_LEN);
+#else
+#define ACL_WORK_ENTRIES  ACL_PAGE_ENTRIES
+#endif
+
+/* Fences: no entry of page p hashes below m_fences[p], or to m_fences[p + 1] and above. A full
+ * image sets them to the first hash of each page; deltas may leave them lower, pages empty. */
+static uint32_t m_fences[LOCK_ACL_MAX_PAGES];
+static uint32_t m_page_count;                   /**< 0 when no list is active. */
+static uint32_t m_entry_count;
+static uint32_t m_version;
+
+/**@brief Lookup buffer, page assembly while loading. A delta edits a page here, with room for
+ *        the entries that move on to the next page.
+ */
+__ALIGN(4) static uint8_t m_page[ACL_WORK_ENTRIES * LOCK_ACL_ENTRY_SIZE];
+
+static bool     m_loading;
+static uint16_t m_fill;
+static uint32_t m_load_pages;
+static uint32_t m_load_bytes;
+static uint32_t m_load_crc;
+
+#if NRF_MODULE_ENABLED(LOCK_ACL_DELTA)
+static uint8_t const *           mp_delta_key;
+static bool                      m_delta_loading;
+static uint32_t                  m_delta_bytes;     /**< Bytes received. */
+static uint32_t                  m_delta_staged;    /**< Bytes programmed to the staging area. */
+static uint16_t                  m_delta_fill;
+static uint32_t                  m_stage_page;      /**< Staging page in m_delta_page when reading back. */
+static nrf_crypto_aes_cmac_ctx_t m_delta_mac;
+static uint32_t                  m_work_page;       /**< List page in m_page while applying. */
+static bool                      m_work_dirty;
+
+__ALIGN(4) static uint8_t m_delta_page[LOCK_ACL_PAGE_SIZE];   /**< Staging page assembly and read-back. */
+#endif
+
+#if NRF_MODULE_ENABLED(LOCK_ACL_ENROLL)
+static bool        m_enrolling;
+static uint8_t     m_enroll_count;
+static acl_entry_t m_enroll[LOCK_ACL_ENROLL_BATCH];      /**< UIDs not on the pages yet, in hash order. */
+#endif
+
+
+/**@brief FNV-1a, the order key of the image. */
+static uint32_t uid_hash(uint8_t const * uid, uint8_t len)
+{
+    uint32_t h = 2166136261UL;
+
+    for (uint8_t i = 0; i < len; i++)
+    {
+        h ^= uid[i];
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+
+static uint32_t page_addr(uint32_t page)
+{
+    return ACL_ENTRIES_ADDR + page * LOCK_ACL_PAGE_SIZE;
+}
+
+
+/**@brief Number of pages whose fence is not above @p h; the UID is on the page before. */
+static uint32_t page_find(uint32_t h)
+{
+    uint32_t lo = 0;
+    uint32_t hi = m_page_count;
+
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) / 2;
+
+        if (m_fences[mid] <= h)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+
+/**@brief Write the header sector for the list in RAM, making it the active one. */
+static void header_write(uint32_t crc)
+{
+    acl_header_t header;
+
+    header.magic       = ACL_MAGIC;
+    header.entry_count = m_entry_count;
+    header.page_count  = m_page_count;
+    header.crc         = crc;
+    header.version     = m_version;
+
+    mx25lxx_erase_sector(LOCK_ACL_FLASH_ADDR);
+    write_mx25lxx_nocheck((uint8_t *)m_fences, ACL_FENCES_ADDR, m_page_count * sizeof(uint32_t));
+    write_mx25lxx_page((uint8_t *)&header, LOCK_ACL_FLASH_ADDR, sizeof(header));
+}
+
+
+static bool entry_valid(acl_entry_t const * p_entry)
+{
+    return (p_entry->uid_len > 0) && (p_entry->uid_len <= LOCK_ACL_UID_MAX_LEN);
+}
+
+
+static void page_program(void)
+{
+    uint32_t addr = page_addr(m_load_pages);
+
+    if ((addr % ACL_SECTOR_SIZE) == 0)
+    {
+        mx25lxx_erase_sector(addr);
+    }
+    write_mx25lxx_page(m_page, addr, LOCK_ACL_PAGE_SIZE);
+
+    m_load_pages++;
+    m_fill = 0;
+}
+
+
+/**@brief Read the programmed image back, check its CRC and order, and rebuild the index.
+ *
+ * @return Number of entries, 0 if the image is not usable.
+ */
+static uint32_t image_validate(uint32_t crc)
+{
+    uint32_t count     = 0;
+    uint32_t remaining = m_load_bytes;
+    uint32_t last_hash = 0;
+    uint32_t read_crc  = 0;
+
+    for (uint32_t p = 0; p < m_load_pages; p++)
+    {
+        acl_entry_t const * p_entries = (acl_entry_t const *)m_page;
+        uint16_t            len       = (remaining > LOCK_ACL_PAGE_SIZE) ? LOCK_ACL_PAGE_SIZE : remaining;
+        bool                padding   = false;
+
+        read_mx25l16_buf(m_page, page_addr(p), LOCK_ACL_PAGE_SIZE);
+        read_crc   = crc32_compute(m_page, len, (p == 0) ? NULL : &read_crc);
+        remaining -= len;
+
+        for (uint8_t i = 0; i < ACL_PAGE_ENTRIES; i++)
+        {
+            uint32_t h;
+
+            if (p_entries[i].uid_len == ACL_PAD)
+            {
+                padding = true;
+                continue;
+            }
+            if (padding || !entry_valid(&p_entries[i]))
+            {
+                return 0;
+            }
+
+            h = uid_hash(p_entries[i].uid, p_entries[i].uid_len);
+            if (i == 0)
+            {
+                // Strictly above the previous page, so a lookup never needs two pages.
+                if ((p > 0) && (h <= last_hash))
+                {
+                    return 0;
+                }
+                m_fences[p] = h;
+            }
+            else if (h < last_hash)
+            {
+                return 0;
+            }
+            last_hash = h;
+            count++;
+        }
+
+        if (p_entries[0].uid_len == ACL_PAD)
+        {
+            return 0;
+        }
+    }
+
+    return (read_crc == crc) ? count : 0;
+}
+
+
+ret_code_t lock_acl_init(void)
+{
+    acl_header_t header;
+    acl_entry_t  first;
+
+    m_page_count  = 0;
+    m_entry_count = 0;
+    m_version     = 0;
+
+    mx25lxx_wakeup();
+    read_mx25l16_buf((uint8_t *)&header, LOCK_ACL_FLASH_ADDR, sizeof(header));
+    if (((header.magic != ACL_MAGIC) && (header.magic != ACL_MAGIC_V1)) ||
+        (header.page_count == 0) || (header.page_count > LOCK_ACL_MAX_PAGES) ||
+        (header.entry_count > header.page_count * ACL_PAGE_ENTRIES))
+    {
+        return NRF_SUCCESS;
+    }
+
+    // The image was checked before its header was written, only the fences are needed.
+    if (header.magic == ACL_MAGIC)
+    {
+        read_mx25l16_buf((uint8_t *)m_fences, ACL_FENCES_ADDR, header.page_count * sizeof(uint32_t));
+        m_version = header.version;
+    }
+    else
+    {
+        for (uint32_t p = 0; p < header.page_count; p++)
+        {
+            read_mx25l16_buf((uint8_t *)&first, page_addr(p), sizeof(first));
+            if (!entry_valid(&first))
+            {
+                return NRF_ERROR_INVALID_DATA;
+            }
+            m_fences[p] = uid_hash(first.uid, first.uid_len);
+        }
+    }
+
+    m_page_count  = header.page_count;
+    m_entry_count = header.entry_count;
+
+    return NRF_SUCCESS;
+}
+
+
+lock_acl_result_t lock_acl_check(uint8_t const * uid, uint8_t uid_len)
+{
+    acl_entry_t const * p_entries = (acl_entry_t const *)m_page;
+    uint32_t            lo;
+
+    if (m_page_count == 0)
+    {
+        return LOCK_ACL_NO_LIST;
+    }
+    if ((uid_len == 0) || (uid_len > LOCK_ACL_UID_MAX_LEN))
+    {
+        return LOCK_ACL_DENIED;
+    }
+
+    // Last page whose fence is not above the UID hash.
+    lo = page_find(uid_hash(uid, uid_len));
+    if (lo == 0)
+    {
+        return LOCK_ACL_DENIED;
+    }
+
+#if NRF_MODULE_ENABLED(MX25_CACHE) || NRF_MODULE_ENABLED(MX25_QSPI)
+    // Cards tapped again soon, and neighbours on the same page, are served from RAM, or read
+    // in place through the QSPI.
+    p_entries = (acl_entry_t const *)mx25lxx_read_page_cached(page_addr(lo - 1));
+#else
+    read_mx25l16_buf(m_page, page_addr(lo - 1), LOCK_ACL_PAGE_SIZE);
+#endif
+    for (uint8_t i = 0; i < ACL_PAGE_ENTRIES; i++)
+    {
+        if (p_entries[i].uid_len == ACL_PAD)
+        {
+            break;
+        }
+        if ((p_entries[i].uid_len == uid_len) && (memcmp(p_entries[i].uid, uid, uid_len) == 0))
+        {
+            return LOCK_ACL_GRANTED;
+        }
+    }
+
+    return LOCK_ACL_DENIED;
+}
+
+
+uint32_t lock_acl_count(void)
+{
+    return m_entry_count;
+}
+
+
+uint32_t lock_acl_version(void)
+{
+    return m_version;
+}
+
+
+ret_code_t lock_acl_load_begin(void)
+{
+    m_page_count  = 0;
+    m_entry_count = 0;
+#if NRF_MODULE_ENABLED(LOCK_ACL_DELTA)
+    m_delta_loading = false;
+#endif
+#if NRF_MODULE_ENABLED(LOCK_ACL_ENROLL)
+    // The UIDs not committed yet are lost with the list they were meant for.
+    m_enrolling     = false;
+    m_enroll_count  = 0;
+#endif
+
+    // Without a header the old pages are unreachable, even if the load never finishes.
+    mx25lxx_erase_sector(LOCK_ACL_FLASH_ADDR);
+
+    m_loading    = true;
+    m_fill       = 0;
+    m_load_pages = 0;
+    m_load_bytes = 0;
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t lock_acl_load_append(uint8_t const * p_data, uint16_t len)
+{
+    uint32_t crc;
+
+    if (!m_loading)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if ((m_load_bytes + len) > (LOCK_ACL_MAX_PAGES * LOCK_ACL_PAGE_SIZE))
+    {
+        m_loading = false;
+        return NRF_ERROR_NO_MEM;
+    }
+
+    crc          = crc32_compute(p_data, len, (m_load_bytes == 0) ? NULL : &m_load_crc);
+    m_load_crc   = crc;
+    m_load_bytes += len;
+
+    while (len > 0)
+    {
+        uint16_t chunk = MIN(len, LOCK_ACL_PAGE_SIZE - m_fill);
+
+        memcpy(&m_page[m_fill], p_data, chunk);
+        m_fill += chunk;
+        p_data += chunk;
+        len    -= chunk;
+
+        if (m_fill == LOCK_ACL_PAGE_SIZE)
+        {
+            page_program();
+        }
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t lock_acl_load_end(uint32_t crc, uint32_t version)
+{
+    uint32_t count;
+
+    if (!m_loading)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    m_loading = false;
+
+    if ((m_load_bytes == 0) || ((m_load_bytes % LOCK_ACL_ENTRY_SIZE) != 0) || (m_load_crc != crc))
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+    if (m_fill > 0)
+    {
+        memset(&m_page[m_fill], ACL_PAD, LOCK_ACL_PAGE_SIZE - m_fill);
+        page_program();
+    }
+
+    count = image_validate(crc);
+    if (count == 0)
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    m_page_count  = m_load_pages;
+    m_entry_count = count;
+    m_version     = version;
+    header_write(crc);
+
+    return NRF_SUCCESS;
+}
+
+
+#if NRF_MODULE_ENABLED(LOCK_ACL_DELTA)
+static uint32_t entry_hash(acl_entry_t const * p_entry)
+{
+    return uid_hash(p_entry->uid, p_entry->uid_len);
+}
+
+
+/**@brief Number of entries on the page in m_page. */
+static uint8_t work_count(void)
+{
+    acl_entry_t const * p_work = (acl_entry_t const *)m_page;
+    uint8_t             n      = 0;
+
+    while ((n < ACL_WORK_ENTRIES) && (p_work[n].uid_len != ACL_PAD))
+    {
+        n++;
+    }
+    return n;
+}
+
+
+static void work_flush(void)
+{
+    if (m_work_dirty)
+    {
+        // Rewrites the sector around the page; only the edited page changes.
+        write_mx25l16_buf(m_page, page_addr(m_work_page), LOCK_ACL_PAGE_SIZE);
+        m_work_dirty = false;
+    }
+}
+
+
+/**@brief Bring a list page into m_page, writing back the one there. */
+static void work_load(uint32_t page, bool fresh)
+{
+    if (page == m_work_page)
+    {
+        return;
+    }
+    work_flush();
+
+    memset(m_page, ACL_PAD, sizeof(m_page));
+    if (!fresh)
+    {
+        read_mx25l16_buf(m_page, page_addr(page), LOCK_ACL_PAGE_SIZE);
+    }
+    m_work_page = page;
+}
+
+
+static int8_t work_find(acl_entry_t const * p_entry, uint8_t n)
+{
+    acl_entry_t const * p_work = (acl_entry_t const *)m_page;
+
+    for (uint8_t i = 0; i < n; i++)
+    {
+        if ((p_work[i].uid_len == p_entry->uid_len) &&
+            (memcmp(p_work[i].uid, p_entry->uid, p_entry->uid_len) == 0))
+        {
+            return (int8_t)i;
+        }
+    }
+    return -1;
+}
+
+
+/**@brief Add a UID to its page, if it is not there yet.
+ *
+ * @details A full page hands its entries of the highest hash on to the front of the next page,
+ *          lowering that fence, and so on; past the last page a new one is started.
+ */
+static ret_code_t entry_add(acl_entry_t const * p_entry)
+{
+    acl_entry_t * p_work = (acl_entry_t *)m_page;
+    uint32_t      h      = entry_hash(p_entry);
+    uint32_t      page   = page_find(h);
+    uint8_t       n;
+    uint8_t       i;
+
+    page = (page > 0) ? (page - 1) : 0;
+    work_load(page, false);
+    n = work_count();
+    if (work_find(p_entry, n) >= 0)
+    {
+        return NRF_SUCCESS;
+    }
+
+    for (i = 0; (i < n) && (entry_hash(&p_work[i]) <= h); i++)
+    {
+    }
+    memmove(&p_work[i + 1], &p_work[i], (n - i) * sizeof(acl_entry_t));
+    p_work[i] = *p_entry;
+    n++;
+    m_work_dirty = true;
+    m_entry_count++;
+    if (h < m_fences[page])
+    {
+        m_fences[page] = h;     // Below the first page.
+    }
+
+    while (n > ACL_PAGE_ENTRIES)
+    {
+        acl_entry_t carry[ACL_CARRY_MAX];
+        uint32_t    top = entry_hash(&p_work[ACL_PAGE_ENTRIES]);
+        uint8_t     r   = ACL_PAGE_ENTRIES;
+        uint8_t     k;
+        bool        fresh;
+
+        // Entries of one hash stay on one page.
+        while ((r > 0) && (entry_hash(&p_work[r - 1]) == top))
+        {
+            r--;
+        }
+        k     = n - r;
+        page += 1;
+        fresh = (page == m_page_count);
+        if ((r == 0) || (k > ACL_CARRY_MAX) || (page == LOCK_ACL_MAX_PAGES))
+        {
+            return NRF_ERROR_NO_MEM;
+        }
+
+        memcpy(carry, &p_work[r], k * sizeof(acl_entry_t));
+        memset(&p_work[r], ACL_PAD, k * sizeof(acl_entry_t));
+        if (fresh)
+        {
+            m_page_count++;
+        }
+        m_fences[page] = entry_hash(&carry[0]);
+
+        work_load(page, fresh);
+        n = work_count();
+        memmove(&p_work[k], &p_work[0], n * sizeof(acl_entry_t));
+        memcpy(&p_work[0], carry, k * sizeof(acl_entry_t));
+        n += k;
+        m_work_dirty = true;
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+/**@brief Remove a UID from its page, if it is there. The fence stays, the page may empty. */
+static void entry_remove(acl_entry_t const * p_entry)
+{
+    acl_entry_t * p_work = (acl_entry_t *)m_page;
+    uint32_t      page   = page_find(entry_hash(p_entry));
+    uint8_t       n;
+    int8_t        i;
+
+    if (page == 0)
+    {
+        return;
+    }
+    work_load(page - 1, false);
+    n = work_count();
+    i = work_find(p_entry, n);
+    if (i < 0)
+    {
+        return;
+    }
+
+    memmove(&p_work[i], &p_work[i + 1], (n - i - 1) * sizeof(acl_entry_t));
+    memset(&p_work[n - 1], ACL_PAD, sizeof(acl_entry_t));
+    m_work_dirty = true;
+    m_entry_count--;
+}
+
+
+static void stage_program(void)
+{
+    uint32_t addr = ACL_DELTA_ADDR + m_delta_staged;
+
+    if ((addr % ACL_SECTOR_SIZE) == 0)
+    {
+        mx25lxx_erase_sector(addr);
+    }
+    write_mx25lxx_page(m_delta_page, addr, m_delta_fill);
+
+    m_delta_staged += m_delta_fill;
+    m_delta_fill    = 0;
+}
+
+
+/**@brief nanopb input stream over the staged delta, a page at a time. */
+static bool stage_read(pb_istream_t * p_stream, pb_byte_t * p_buf, size_t count)
+{
+    uint32_t * p_offset = p_stream->state;
+
+    while (count > 0)
+    {
+        uint32_t page   = *p_offset / LOCK_ACL_PAGE_SIZE;
+        uint32_t in_pos = *p_offset % LOCK_ACL_PAGE_SIZE;
+        uint32_t chunk  = MIN(count, LOCK_ACL_PAGE_SIZE - in_pos);
+
+        if (page != m_stage_page)
+        {
+            read_mx25l16_buf(m_delta_page, ACL_DELTA_ADDR + page * LOCK_ACL_PAGE_SIZE, LOCK_ACL_PAGE_SIZE);
+            m_stage_page = page;
+        }
+        memcpy(p_buf, &m_delta_page[in_pos], chunk);
+        p_buf     += chunk;
+        count     -= chunk;
+        *p_offset += chunk;
+    }
+    return true;
+}
+
+
+/**@brief Decode the staged delta, checking it or applying it.
+ *
+ * @retval NRF_SUCCESS             Decoded (and applied).
+ * @retval NRF_ERROR_INVALID_DATA  Not a header and op_count ops that use up the delta.
+ * @retval NRF_ERROR_INVALID_STATE The delta is not for the version of the list.
+ * @retval NRF_ERROR_NO_MEM        A page could not take its entries.
+ */
+static ret_code_t delta_run(bool apply, AclDeltaHeader * p_header)
+{
+    uint32_t     offset = 0;
+    pb_istream_t stream = {.callback = stage_read, .state = &offset, .bytes_left = m_delta_bytes};
+    AclDeltaOp   op;
+
+    m_stage_page = ACL_NO_PAGE;
+    if (!pb_decode_delimited(&stream, AclDeltaHeader_fields, p_header))
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+    if ((p_header->base_version != m_version) || (p_header->version <= p_header->base_version))
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    for (uint32_t i = 0; i < p_header->op_count; i++)
+    {
+        acl_entry_t entry;
+
+        if (!pb_decode_delimited(&stream, AclDeltaOp_fields, &op) || (op.uid.size == 0))
+        {
+            return NRF_ERROR_INVALID_DATA;
+        }
+        if (!apply)
+        {
+            continue;
+        }
+
+        memset(&entry, 0, sizeof(entry));
+        entry.uid_len = (uint8_t)op.uid.size;
+        memcpy(entry.uid, op.uid.bytes, op.uid.size);
+        if (op.add)
+        {
+            ret_code_t err_code = entry_add(&entry);
+            VERIFY_SUCCESS(err_code);
+        }
+        else
+        {
+            entry_remove(&entry);
+        }
+    }
+
+    return (stream.bytes_left == 0) ? NRF_SUCCESS : NRF_ERROR_INVALID_DATA;
+}
+
+
+void lock_acl_delta_key_set(uint8_t const * p_key)
+{
+    mp_delta_key = p_key;
+}
+
+
+ret_code_t lock_acl_delta_begin(void)
+{
+    if (mp_delta_key == NULL)
+    {
+        return NRF_ERROR_FORBIDDEN;
+    }
+    if ((m_page_count == 0) || m_loading)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+#if NRF_MODULE_ENABLED(LOCK_ACL_ENROLL)
+    if (m_enrolling)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+#endif
+
+    nrf_crypto_aes_cmac_init(&m_delta_mac, mp_delta_key, NULL);
+    m_delta_loading = true;
+    m_delta_bytes   = 0;
+    m_delta_staged  = 0;
+    m_delta_fill    = 0;
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t lock_acl_delta_append(uint8_t const * p_data, uint16_t len)
+{
+    ret_code_t err_code;
+
+    if (!m_delta_loading)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if ((m_delta_bytes + len) > LOCK_ACL_DELTA_SIZE)
+    {
+        m_delta_loading = false;
+        return NRF_ERROR_NO_MEM;
+    }
+
+    err_code = nrf_crypto_aes_cmac_update(&m_delta_mac, p_data, len);
+    if (err_code != NRF_SUCCESS)
+    {
+        m_delta_loading = false;
+        return err_code;
+    }
+    m_delta_bytes += len;
+
+    while (len > 0)
+    {
+        uint16_t chunk = MIN(len, LOCK_ACL_PAGE_SIZE - m_delta_fill);
+
+        memcpy(&m_delta_page[m_delta_fill], p_data, chunk);
+        m_delta_fill += chunk;
+        p_data       += chunk;
+        len          -= chunk;
+
+        if (m_delta_fill == LOCK_ACL_PAGE_SIZE)
+        {
+            stage_program();
+        }
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t lock_acl_delta_end(uint8_t const * p_mac)
+{
+    AclDeltaHeader header;
+    uint8_t        mac[NRF_CRYPTO_AES_BLOCK_SIZE];
+    uint8_t        diff = 0;
+    ret_code_t     err_code;
+
+    if (!m_delta_loading)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    m_delta_loading = false;
+
+    if (m_delta_fill > 0)
+    {
+        stage_program();
+    }
+    err_code = nrf_crypto_aes_cmac_finish(&m_delta_mac, mac);
+    VERIFY_SUCCESS(err_code);
+    for (uint8_t i = 0; i < sizeof(mac); i++)
+    {
+        diff |= mac[i] ^ p_mac[i];
+    }
+    if (diff != 0)
+    {
+        return NRF_ERROR_FORBIDDEN;
+    }
+
+    // Check the whole delta before the first page changes.
+    err_code = delta_run(false, &header);
+    VERIFY_SUCCESS(err_code);
+
+    // Without a header the list is inactive while pages change, so a reset meanwhile leaves
+    // no list rather than a half updated one.
+    mx25lxx_erase_sector(LOCK_ACL_FLASH_ADDR);
+    m_work_page  = ACL_NO_PAGE;
+    m_work_dirty = false;
+    err_code     = delta_run(true, &header);
+    work_flush();
+    if (err_code != NRF_SUCCESS)
+    {
+        m_page_count  = 0;
+        m_entry_count = 0;
+        return err_code;
+    }
+
+    m_version = header.version;
+    header_write(0);
+
+    return NRF_SUCCESS;
+}
+#endif //NRF_MODULE_ENABLED(LOCK_ACL_DELTA)
+
+
+#if NRF_MODULE_ENABLED(LOCK_ACL_ENROLL)
+ret_code_t lock_acl_enroll_begin(uint8_t const * p_mac)
+{
+    uint8_t    msg[2 * sizeof(uint32_t)];
+    uint8_t    mac[NRF_CRYPTO_AES_BLOCK_SIZE];
+    uint8_t    diff = 0;
+    ret_code_t err_code;
+
+    if (mp_delta_key == NULL)
+    {
+        return NRF_ERROR_FORBIDDEN;
+    }
+    if (m_loading || m_delta_loading || m_enrolling)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    UNUSED_RETURN_VALUE(uint32_encode(ACL_ENROLL_TAG, msg));
+    UNUSED_RETURN_VALUE(uint32_encode(m_version, &msg[sizeof(uint32_t)]));
+    err_code = nrf_crypto_aes_cmac(mp_delta_key, msg, sizeof(msg), mac);
+    VERIFY_SUCCESS(err_code);
+    for (uint8_t i = 0; i < sizeof(mac); i++)
+    {
+        diff |= mac[i] ^ p_mac[i];
+    }
+    if (diff != 0)
+    {
+        return NRF_ERROR_FORBIDDEN;
+    }
+
+    // The version moves on at once, so the same request does not start another session.
+    if (m_page_count > 0)
+    {
+        m_version++;
+        header_write(0);
+    }
+    m_enrolling    = true;
+    m_enroll_count = 0;
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t lock_acl_enroll_add(uint8_t const * uid, uint8_t uid_len, bool * p_added)
+{
+    acl_entry_t entry;
+    uint32_t    h;
+    uint8_t     i;
+
+    *p_added = false;
+    if (!m_enrolling)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if ((uid_len == 0) || (uid_len > LOCK_ACL_UID_MAX_LEN))
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+    if (lock_acl_check(uid, uid_len) == LOCK_ACL_GRANTED)
+    {
+        return NRF_SUCCESS;
+    }
+
+    memset(&entry, 0, sizeof(entry));
+    entry.uid_len = uid_len;
+    memcpy(entry.uid, uid, uid_len);
+    h = entry_hash(&entry);
+
+    // A UID tapped twice has the same hash, so it is among the pending ones before @p i.
+    for (i = 0; (i < m_enroll_count) && (entry_hash(&m_enroll[i]) <= h); i++)
+    {
+        if (memcmp(&m_enroll[i], &entry, sizeof(entry)) == 0)
+        {
+            return NRF_SUCCESS;
+        }
+    }
+    if (m_enroll_count == LOCK_ACL_ENROLL_BATCH)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    memmove(&m_enroll[i + 1], &m_enroll[i], (m_enroll_count - i) * sizeof(acl_entry_t));
+    m_enroll[i] = entry;
+    m_enroll_count++;
+    *p_added = true;
+
+    return NRF_SUCCESS;
+}
+
+
+uint8_t lock_acl_enroll_pending(void)
+{
+    return m_enroll_count;
+}
+
+
+ret_code_t lock_acl_enroll_commit(void)
+{
+    ret_code_t err_code = NRF_SUCCESS;
+
+    if (!m_enrolling)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if (m_enroll_count == 0)
+    {
+        return NRF_SUCCESS;
+    }
+
+    // As for a delta: no header while the pages change.
+    mx25lxx_erase_sector(LOCK_ACL_FLASH_ADDR);
+    m_work_page  = ACL_NO_PAGE;
+    m_work_dirty = false;
+    if (m_page_count == 0)
+    {
+        // The first UIDs of a site without a list.
+        m_page_count  = 1;
+        m_entry_count = 0;
+        m_fences[0]   = 0;
+        work_load(0, true);
+    }
+
+    // In hash order, the UIDs of one page come one after the other and share its write.
+    for (uint8_t i = 0; (i < m_enroll_count) && (err_code == NRF_SUCCESS); i++)
+    {
+        err_code = entry_add(&m_enroll[i]);
+    }
+    work_flush();
+    m_enroll_count = 0;
+    if (err_code != NRF_SUCCESS)
+    {
+        m_page_count  = 0;
+        m_entry_count = 0;
+        m_enrolling   = false;
+        return err_code;
+    }
+
+    m_version++;
+    header_write(0);
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t lock_acl_enroll_end(void)
+{
+    ret_code_t err_code = lock_acl_enroll_commit();
+
+    m_enrolling = false;
+    return err_code;
+}
+
+
+bool lock_acl_enroll_is_active(void)
+{
+    return m_enrolling;
+}
+#endif //NRF_MODULE_ENABLED(LOCK_ACL_ENROLL)
+
+#endif //NRF_MODULE_ENABLED(LOCK_ACL)
@@ -0,0 +1,185 @@
+#ifndef _LOCK_ACL_H_
+#define _LOCK_ACL_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* Whitelist image, as sent to lock_acl_load_append():
+ *
+ *   8-byte entries {uid_len, uid[7]}, unused UID bytes zero, sorted by the FNV-1a hash
+ *   of uid[0..uid_len-1]. Entries are grouped in 256-byte pages (32 entries). A page may
+ *   end early, the rest filled with 0xFF, but entries with the same hash must not be
+ *   split over two pages and no page may be empty.
+ *
+ * Only the first UID hash of each page is kept in RAM, so a lookup is a binary search
+ * in RAM followed by a single page read from the MX25L16. These fences are stored with
+ * the header; after a delta they may be below the first hash of a page, and pages may
+ * be empty.
+ *
+ * Delta, as sent to lock_acl_delta_append() (lock_acl_delta.proto):
+ *
+ *   A length-delimited AclDeltaHeader {base_version, version, op_count}, followed by
+ *   op_count length-delimited AclDeltaOp {add, uid}. The AES-CMAC of all bytes under the
+ *   site key is sent to lock_acl_delta_end().
+ *
+ * The CMAC authenticates a delta, it does not sign it: the site key is symmetric and every
+ * lock of the site holds the same one. Whoever reads it out of one lock can forge deltas for
+ * all of them, so the key must be per site and rotated when a lock is lost. A P-256 signature
+ * (ecc.c) would leave only a public key on the lock, but the micro-ecc sources it builds on
+ * are not in this tree.
+ *
+ * Adding a UID changes its page, and the pages after it only while they overflow.
+ *
+ * Enrollment, lock_acl_enroll_begin() to lock_acl_enroll_end(), adds the UIDs of the cards
+ * tapped on the reader itself. They are kept in RAM, in hash order, and committed to the pages
+ * LOCK_ACL_ENROLL_BATCH at a time like the adds of a delta: UIDs of one page share its write.
+ * Every commit and every begin moves the version on by one; the phone learns the UIDs and the
+ * version from the reports and can send deltas again from there.
+ */
+#define LOCK_ACL_ENTRY_SIZE      8
+#define LOCK_ACL_PAGE_SIZE       256
+#define LOCK_ACL_UID_MAX_LEN     7
+
+/**@brief Result of a whitelist lookup. */
+typedef enum
+{
+    LOCK_ACL_GRANTED,      /**< The UID is on the list. */
+    LOCK_ACL_DENIED,       /**< A list is loaded and the UID is not on it. */
+    LOCK_ACL_NO_LIST,      /**< No valid list in flash; the decision is left to the phone. */
+    LOCK_ACL_OFF_SCHEDULE, /**< On the list, outside the hours of its schedule group. */
+} lock_acl_result_t;
+
+/**@brief Read the list header and build the page index.
+ *
+ * @note The MX25L16 SPI bus must be initialized (device_mx25l16mb_init()).
+ */
+ret_code_t lock_acl_init(void);
+
+/**@brief Look up a card.
+ *
+ * @param[in] uid      UID as returned by readPassiveTargetID().
+ * @param[in] uid_len  UID length. UIDs longer than LOCK_ACL_UID_MAX_LEN are never granted.
+ */
+lock_acl_result_t lock_acl_check(uint8_t const * uid, uint8_t uid_len);
+
+/**@brief Number of entries in the loaded list, 0 if there is none. */
+uint32_t lock_acl_count(void);
+
+/**@brief Version of the loaded list, as given with the image or by the last delta. */
+uint32_t lock_acl_version(void);
+
+/**@brief Drop the current list and start receiving a new image.
+ *
+ * @details Until lock_acl_load_end() succeeds, lookups return LOCK_ACL_NO_LIST.
+ */
+ret_code_t lock_acl_load_begin(void);
+
+/**@brief Append image bytes. Sectors are erased and pages programmed as they fill.
+ *
+ * @retval NRF_SUCCESS             Bytes taken.
+ * @retval NRF_ERROR_INVALID_STATE No load in progress.
+ * @retval NRF_ERROR_NO_MEM        The image exceeds LOCK_ACL_MAX_PAGES.
+ */
+ret_code_t lock_acl_load_append(uint8_t const * p_data, uint16_t len);
+
+/**@brief Finish a load: check the image against @p crc, validate its order and activate it.
+ *
+ * @param[in] crc      CRC32 (crc32_compute()) of all bytes sent with lock_acl_load_append().
+ * @param[in] version  Version of the list, the base for the next delta.
+ *
+ * @retval NRF_SUCCESS             New list active.
+ * @retval NRF_ERROR_INVALID_STATE No load in progress.
+ * @retval NRF_ERROR_INVALID_DATA  CRC mismatch, read-back error or bad ordering. No list is active.
+ */
+ret_code_t lock_acl_load_end(uint32_t crc, uint32_t version);
+
+/**@brief Set the site key that deltas are authenticated with.
+ *
+ * @param[in] p_key  AES-128 key, 16 bytes, shared by every lock of the site. Kept by reference,
+ *                   must stay valid.
+ */
+void lock_acl_delta_key_set(uint8_t const * p_key);
+
+/**@brief Start receiving a delta. The current list stays active meanwhile.
+ *
+ * @retval NRF_SUCCESS             Ready for lock_acl_delta_append().
+ * @retval NRF_ERROR_FORBIDDEN     No site key set.
+ * @retval NRF_ERROR_INVALID_STATE No list to apply it to, or an image load in progress.
+ */
+ret_code_t lock_acl_delta_begin(void);
+
+/**@brief Append delta bytes. They are staged in flash after the list pages.
+ *
+ * @retval NRF_SUCCESS             Bytes taken.
+ * @retval NRF_ERROR_INVALID_STATE No delta in progress.
+ * @retval NRF_ERROR_NO_MEM        The delta exceeds LOCK_ACL_DELTA_SIZE.
+ */
+ret_code_t lock_acl_delta_append(uint8_t const * p_data, uint16_t len);
+
+/**@brief Finish a delta: check its CMAC and version, then apply it to the pages.
+ *
+ * @details Nothing changes unless the whole delta decodes. The header is rewritten last; if
+ *          applying is interrupted or a page fills up, no list is active and the phone must
+ *          send a full image.
+ *
+ * @param[in] p_mac  AES-CMAC of the delta, 16 bytes.
+ *
+ * @retval NRF_SUCCESS             Applied, lock_acl_version() is the new version.
+ * @retval NRF_ERROR_INVALID_STATE No delta in progress, or it is not for the loaded version.
+ *                                 The list is unchanged.
+ * @retval NRF_ERROR_FORBIDDEN     Wrong CMAC. The list is unchanged.
+ * @retval NRF_ERROR_INVALID_DATA  The delta does not decode. The list is unchanged.
+ * @retval NRF_ERROR_NO_MEM        Out of pages, or too many UIDs of one hash. No list is active.
+ */
+ret_code_t lock_acl_delta_end(uint8_t const * p_mac);
+
+/**@brief Start enrolling cards. The current list stays active meanwhile.
+ *
+ * @details With a list, its version moves on, so the same request cannot start a second
+ *          session. Without one, the first commit starts one.
+ *
+ * @param[in] p_mac  AES-CMAC under the site key of "ENRL" and the list version (little endian),
+ *                   16 bytes.
+ *
+ * @retval NRF_SUCCESS             Enrolling.
+ * @retval NRF_ERROR_FORBIDDEN     No site key set, or a wrong CMAC.
+ * @retval NRF_ERROR_INVALID_STATE An image, a delta or an enrollment is in progress.
+ */
+ret_code_t lock_acl_enroll_begin(uint8_t const * p_mac);
+
+/**@brief Add the UID of a tapped card, unless the list or the batch has it already.
+ *
+ * @param[in]  uid       UID.
+ * @param[in]  uid_len   UID length.
+ * @param[out] p_added   Whether it is new.
+ *
+ * @retval NRF_SUCCESS              Added to the batch, or already known.
+ * @retval NRF_ERROR_INVALID_STATE  Not enrolling.
+ * @retval NRF_ERROR_INVALID_LENGTH UID length out of range.
+ * @retval NRF_ERROR_NO_MEM         The batch is full; commit it first.
+ */
+ret_code_t lock_acl_enroll_add(uint8_t const * uid, uint8_t uid_len, bool * p_added);
+
+/**@brief Number of UIDs in the batch. */
+uint8_t lock_acl_enroll_pending(void);
+
+/**@brief Write the batch to the pages.
+ *
+ * @retval NRF_SUCCESS             Written, or nothing to write.
+ * @retval NRF_ERROR_INVALID_STATE Not enrolling.
+ * @retval NRF_ERROR_NO_MEM        Out of pages, or too many UIDs of one hash. No list is active
+ *                                 and enrollment has ended.
+ */
+ret_code_t lock_acl_enroll_commit(void);
+
+/**@brief Commit the batch and stop enrolling.
+ *
+ * @return As @ref lock_acl_enroll_commit.
+ */
+ret_code_t lock_acl_enroll_end(void);
+
+/**@brief Whether cards are being enrolled. */
+bool lock_acl_enroll_is_active(void);
+
+
+#endif
@@ -0,0 +1,27 @@
+/* Automatically generated nanopb constant definitions */
+/* Generated by nanopb-0.3.6-dev */
+
+#include "lock_acl_delta.pb.h"
+
+/* @@protoc_insertion_point(includes) */
+#if PB_PROTO_HEADER_VERSION != 30
+#error Regenerate this file with the current version of nanopb generator.
+#endif
+
+
+
+const pb_field_t AclDeltaHeader_fields[4] = {
+    PB_FIELD(  1, UINT32  , REQUIRED, STATIC  , FIRST, AclDeltaHeader, base_version, base_version, 0),
+    PB_FIELD(  2, UINT32  , REQUIRED, STATIC  , OTHER, AclDeltaHeader, version, base_version, 0),
+    PB_FIELD(  3, UINT32  , REQUIRED, STATIC  , OTHER, AclDeltaHeader, op_count, version, 0),
+    PB_LAST_FIELD
+};
+
+const pb_field_t AclDeltaOp_fields[3] = {
+    PB_FIELD(  1, BOOL    , REQUIRED, STATIC  , FIRST, AclDeltaOp, add, add, 0),
+    PB_FIELD(  2, BYTES   , REQUIRED, STATIC  , OTHER, AclDeltaOp, uid, add, 0),
+    PB_LAST_FIELD
+};
+
+
+/* @@protoc_insertion_point(eof) */
@@ -0,0 +1,68 @@
+/* Automatically generated nanopb header */
+/* Generated by nanopb-0.3.6-dev */
+
+#ifndef PB_LOCK_ACL_DELTA_PB_H_INCLUDED
+#define PB_LOCK_ACL_DELTA_PB_H_INCLUDED
+#include <pb.h>
+
+/* @@protoc_insertion_point(includes) */
+#if PB_PROTO_HEADER_VERSION != 30
+#error Regenerate this file with the current version of nanopb generator.
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Struct definitions */
+typedef struct _AclDeltaHeader {
+    uint32_t base_version;
+    uint32_t version;
+    uint32_t op_count;
+/* @@protoc_insertion_point(struct:AclDeltaHeader) */
+} AclDeltaHeader;
+
+typedef PB_BYTES_ARRAY_T(7) AclDeltaOp_uid_t;
+typedef struct _AclDeltaOp {
+    bool add;
+    AclDeltaOp_uid_t uid;
+/* @@protoc_insertion_point(struct:AclDeltaOp) */
+} AclDeltaOp;
+
+/* Default values for struct fields */
+
+/* Initializer values for message structs */
+#define AclDeltaHeader_init_default              {0, 0, 0}
+#define AclDeltaOp_init_default                  {0, {0, {0}}}
+#define AclDeltaHeader_init_zero                 {0, 0, 0}
+#define AclDeltaOp_init_zero                     {0, {0, {0}}}
+
+/* Field tags (for use in manual encoding/decoding) */
+#define AclDeltaHeader_base_version_tag          1
+#define AclDeltaHeader_version_tag               2
+#define AclDeltaHeader_op_count_tag              3
+#define AclDeltaOp_add_tag                       1
+#define AclDeltaOp_uid_tag                       2
+
+/* Struct field encoding specification for nanopb */
+extern const pb_field_t AclDeltaHeader_fields[4];
+extern const pb_field_t AclDeltaOp_fields[3];
+
+/* Maximum encoded size of messages (where known) */
+#define AclDeltaHeader_size                      18
+#define AclDeltaOp_size                          11
+
+/* Message IDs (where set with "msgid" option) */
+#ifdef PB_MSGID
+
+#define LOCK_ACL_DELTA_MESSAGES \
+
+
+#endif
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+/* @@protoc_insertion_point(eof) */
+
+#endif
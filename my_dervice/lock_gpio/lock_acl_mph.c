@@ -0,0 +1,542 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(LOCK_ACL_MPH)
+#include "lock_acl_mph.h"
+#include "fstorage.h"
+#include "crc32.h"
+#include "app_util_platform.h"
+#include <stddef.h>
+#include <string.h>
+
+#define MPH_IMAGE_MAGIC   0x3148504D  /**< "MPH1", no schedules. */
+#define MPH_IMAGE_MAGIC2  0x3248504D  /**< "MPH2", schedules after the entries. */
+#define MPH_LEN_MASK      0x07        /**< UID length in the first entry byte, the group above it. */
+#define MPH_GROUP_SHIFT   3
+#define MPH_BANK_MAGIC    0x544C4341  /**< "ACLT", programmed last. */
+#define MPH_DIRECT        0x8000      /**< Displacement is the slot itself. */
+#if defined(NRF51)
+#define MPH_PAGE_WORDS    256         /**< fstorage hands out whole flash pages. */
+#else
+#define MPH_PAGE_WORDS    1024
+#endif
+#define MPH_BANK_WORDS    (LOCK_ACL_MPH_PAGES * MPH_PAGE_WORDS)
+#define MPH_NO_BANK       0xFF
+
+STATIC_ASSERT((LOCK_ACL_MPH_CHUNK % sizeof(uint32_t)) == 0);
+
+/**@brief Start of a bank, programmed after the image it describes has been checked. */
+typedef struct
+{
+    uint32_t sequence;
+    uint32_t version;
+    uint32_t length;       /**< Image bytes. */
+    uint32_t crc;
+    uint32_t magic;        /**< Last, so a header cut short is not taken. */
+} mph_bank_t;
+
+/**@brief Start of the image, as generated. An "MPH1" image ends before @p group_count. */
+typedef struct
+{
+    uint32_t magic;
+    uint16_t entry_count;
+    uint16_t bucket_count;
+    uint32_t seed;
+    uint8_t  group_count;
+    uint8_t  holiday_count;
+    uint16_t reserved;
+} mph_image_t;
+
+#define MPH_IMAGE_V1_SIZE  offsetof(mph_image_t, group_count)
+
+typedef struct
+{
+    uint8_t len_group;     /**< UID length, group << MPH_GROUP_SHIFT. */
+    uint8_t uid[LOCK_ACL_UID_MAX_LEN];
+} mph_entry_t;
+
+STATIC_ASSERT(sizeof(mph_entry_t) == LOCK_ACL_ENTRY_SIZE);
+STATIC_ASSERT((sizeof(mph_bank_t) % sizeof(uint32_t)) == 0);
+
+/**@brief Active table, resolved to flash pointers once. */
+typedef struct
+{
+    mph_entry_t const * p_entries;
+    uint16_t const *    p_buckets;
+    uint8_t const *     p_groups;
+    uint16_t const *    p_holidays;
+    uint32_t            seed;
+    uint16_t            entry_count;
+    uint16_t            bucket_count;
+    uint8_t             group_count;
+    uint8_t             holiday_count;
+    uint32_t            version;
+    uint32_t            sequence;
+} mph_table_t;
+
+static void fs_evt_handler(fs_evt_t const * const evt, fs_ret_t result);
+
+FS_REGISTER_CFG(fs_config_t m_fs_config) =
+{
+    .callback  = fs_evt_handler,
+    .num_pages = 2 * LOCK_ACL_MPH_PAGES,
+    .priority  = LOCK_ACL_MPH_FS_PRIORITY,
+};
+
+static mph_table_t m_table;                 /**< entry_count 0 when no table is active. */
+static mph_table_t m_next;                  /**< Table being committed. */
+static uint8_t     m_active = MPH_NO_BANK;
+static uint8_t     m_target;                /**< Bank being loaded. */
+
+static bool              m_loading;
+static volatile bool     m_committing;
+static volatile uint8_t  m_pending;         /**< fstorage operations queued by the load. */
+static volatile bool     m_write_failed;
+static uint32_t          m_load_bytes;
+static uint32_t          m_load_crc;
+static uint32_t          m_load_words;      /**< Words of the image submitted to fstorage. */
+static uint8_t           m_buf_idx;
+static uint16_t          m_fill;
+static volatile bool     m_buf_busy[2];     /**< Buffer handed to fstorage, not yet written. */
+static bool              m_buf_full;        /**< The other buffer is full, not yet taken by fstorage. */
+static mph_bank_t        m_bank_hdr;
+
+__ALIGN(4) static uint8_t m_buf[2][LOCK_ACL_MPH_CHUNK];
+
+
+/**@brief FNV-1a with the seed XORed into the offset basis. */
+static uint32_t uid_hash(uint32_t seed, uint8_t const * uid, uint8_t len)
+{
+    uint32_t h = 2166136261UL ^ seed;
+
+    for (uint8_t i = 0; i < len; i++)
+    {
+        h ^= uid[i];
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+
+static uint32_t const * bank_addr(uint8_t bank)
+{
+    return m_fs_config.p_start_addr + bank * MPH_BANK_WORDS;
+}
+
+
+static uint32_t slot_find(mph_table_t const * p_table, uint8_t const * uid, uint8_t uid_len)
+{
+    uint16_t d = p_table->p_buckets[uid_hash(p_table->seed, uid, uid_len) % p_table->bucket_count];
+
+    if (d & MPH_DIRECT)
+    {
+        return d & ~MPH_DIRECT;
+    }
+    return uid_hash(d, uid, uid_len) % p_table->entry_count;
+}
+
+
+/**@brief Resolve the image at @p p_image of @p length bytes, without looking at the entries. */
+static bool table_open(mph_table_t * p_table, uint8_t const * p_image, uint32_t length)
+{
+    mph_image_t const * p_hdr = (mph_image_t const *)p_image;
+    uint32_t            hdr_size;
+    uint32_t            buckets_size;
+    uint32_t            entries_size;
+    uint32_t            sched_size = 0;
+
+    if (length < MPH_IMAGE_V1_SIZE)
+    {
+        return false;
+    }
+    if (p_hdr->magic == MPH_IMAGE_MAGIC)
+    {
+        hdr_size               = MPH_IMAGE_V1_SIZE;
+        p_table->group_count   = 0;
+        p_table->holiday_count = 0;
+    }
+    else if ((p_hdr->magic == MPH_IMAGE_MAGIC2) && (length >= sizeof(mph_image_t)))
+    {
+        hdr_size               = sizeof(mph_image_t);
+        p_table->group_count   = p_hdr->group_count;
+        p_table->holiday_count = p_hdr->holiday_count;
+        sched_size             = ALIGN_NUM(sizeof(uint32_t),
+                                           p_hdr->group_count * LOCK_ACL_MPH_SCHED_SIZE +
+                                           p_hdr->holiday_count * sizeof(uint16_t));
+    }
+    else
+    {
+        return false;
+    }
+    if ((p_hdr->entry_count == 0) || (p_hdr->entry_count > LOCK_ACL_MPH_MAX_ENTRIES) ||
+        (p_hdr->bucket_count == 0) || (p_table->group_count > LOCK_ACL_MPH_MAX_GROUPS))
+    {
+        return false;
+    }
+
+    buckets_size = ALIGN_NUM(sizeof(uint32_t), p_hdr->bucket_count * sizeof(uint16_t));
+    entries_size = p_hdr->entry_count * sizeof(mph_entry_t);
+    if (length != hdr_size + buckets_size + entries_size + sched_size)
+    {
+        return false;
+    }
+
+    p_table->p_buckets    = (uint16_t const *)(p_image + hdr_size);
+    p_table->p_entries    = (mph_entry_t const *)(p_image + hdr_size + buckets_size);
+    p_table->p_groups     = p_image + hdr_size + buckets_size + entries_size;
+    p_table->p_holidays   = (uint16_t const *)(p_table->p_groups + p_table->group_count * LOCK_ACL_MPH_SCHED_SIZE);
+    p_table->seed         = p_hdr->seed;
+    p_table->entry_count  = p_hdr->entry_count;
+    p_table->bucket_count = p_hdr->bucket_count;
+    return true;
+}
+
+
+/**@brief Every entry valid, of a known group and found at its own slot, which catches a
+ *        generator hashing otherwise; holidays in ascending order.
+ */
+static bool table_verify(mph_table_t const * p_table)
+{
+    for (uint32_t i = 0; i < p_table->entry_count; i++)
+    {
+        mph_entry_t const * p_entry = &p_table->p_entries[i];
+        uint8_t             len     = p_entry->len_group & MPH_LEN_MASK;
+
+        if ((len == 0) || ((p_entry->len_group >> MPH_GROUP_SHIFT) > p_table->group_count) ||
+            (slot_find(p_table, p_entry->uid, len) != i))
+        {
+            return false;
+        }
+    }
+    for (uint32_t i = 1; i < p_table->holiday_count; i++)
+    {
+        if (p_table->p_holidays[i] <= p_table->p_holidays[i - 1])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**@brief Open the bank if its header is complete. */
+static bool bank_open(uint8_t bank, mph_table_t * p_table)
+{
+    mph_bank_t const * p_bank = (mph_bank_t const *)bank_addr(bank);
+
+    if ((p_bank->magic != MPH_BANK_MAGIC) ||
+        (p_bank->length > (MPH_BANK_WORDS * sizeof(uint32_t)) - sizeof(mph_bank_t)))
+    {
+        return false;
+    }
+    if (!table_open(p_table, (uint8_t const *)(p_bank + 1), p_bank->length))
+    {
+        return false;
+    }
+    p_table->version  = p_bank->version;
+    p_table->sequence = p_bank->sequence;
+    return true;
+}
+
+
+static void fs_evt_handler(fs_evt_t const * const evt, fs_ret_t result)
+{
+    if (evt->p_context == &m_bank_hdr)
+    {
+        // The header decides which bank is newest, whatever was active before.
+        if (result == FS_SUCCESS)
+        {
+            m_table  = m_next;
+            m_active = m_target;
+        }
+        m_committing = false;
+        return;
+    }
+
+    if (result != FS_SUCCESS)
+    {
+        m_write_failed = true;
+    }
+    if (evt->p_context != NULL)
+    {
+        *(volatile bool *)evt->p_context = false;
+    }
+    m_pending--;
+}
+
+
+static void pending_add(int8_t n)
+{
+    CRITICAL_REGION_ENTER();
+    m_pending += n;
+    CRITICAL_REGION_EXIT();
+}
+
+
+/**@brief Hand the first @p fill bytes of buffer @p idx to fstorage, after the image so far. */
+static bool chunk_submit(uint8_t idx, uint16_t fill)
+{
+    uint32_t const * p_dest = bank_addr(m_target) + (sizeof(mph_bank_t) / sizeof(uint32_t)) + m_load_words;
+    uint16_t         words  = CEIL_DIV(fill, sizeof(uint32_t));
+
+    memset(&m_buf[idx][fill], 0xFF, words * sizeof(uint32_t) - fill);
+
+    m_buf_busy[idx] = true;
+    pending_add(1);
+    if (fs_store(&m_fs_config, p_dest, (uint32_t const *)m_buf[idx], words,
+                 (void *)&m_buf_busy[idx]) != FS_SUCCESS)
+    {
+        m_buf_busy[idx] = false;
+        pending_add(-1);
+        return false;
+    }
+
+    m_load_words += words;
+    return true;
+}
+
+
+ret_code_t lock_acl_mph_init(void)
+{
+    mph_table_t table;
+
+    if (fs_init() != FS_SUCCESS)
+    {
+        return NRF_ERROR_INTERNAL;
+    }
+
+    m_table.entry_count = 0;
+    m_active            = MPH_NO_BANK;
+
+    for (uint8_t bank = 0; bank < 2; bank++)
+    {
+        if (bank_open(bank, &table) &&
+            ((m_active == MPH_NO_BANK) || ((int32_t)(table.sequence - m_table.sequence) > 0)))
+        {
+            m_table  = table;
+            m_active = bank;
+        }
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+lock_acl_result_t lock_acl_mph_check(uint8_t const * uid, uint8_t uid_len, uint8_t * p_group)
+{
+    mph_table_t         table;
+    mph_entry_t const * p_entry;
+    uint32_t            slot;
+
+    // Switched by the fstorage event of a commit.
+    CRITICAL_REGION_ENTER();
+    table = m_table;
+    CRITICAL_REGION_EXIT();
+
+    if (table.entry_count == 0)
+    {
+        return LOCK_ACL_NO_LIST;
+    }
+    if ((uid_len == 0) || (uid_len > LOCK_ACL_UID_MAX_LEN))
+    {
+        return LOCK_ACL_DENIED;
+    }
+
+    slot = slot_find(&table, uid, uid_len);
+    if (slot >= table.entry_count)
+    {
+        return LOCK_ACL_DENIED;
+    }
+
+    p_entry = &table.p_entries[slot];
+    if (((p_entry->len_group & MPH_LEN_MASK) == uid_len) && (memcmp(p_entry->uid, uid, uid_len) == 0))
+    {
+        if (p_group != NULL)
+        {
+            *p_group = p_entry->len_group >> MPH_GROUP_SHIFT;
+        }
+        return LOCK_ACL_GRANTED;
+    }
+    return LOCK_ACL_DENIED;
+}
+
+
+uint32_t lock_acl_mph_count(void)
+{
+    return m_table.entry_count;
+}
+
+
+uint32_t lock_acl_mph_version(void)
+{
+    return (m_table.entry_count > 0) ? m_table.version : 0;
+}
+
+
+void lock_acl_mph_sched_get(lock_acl_mph_sched_t * p_sched)
+{
+    CRITICAL_REGION_ENTER();
+    p_sched->p_groups      = m_table.p_groups;
+    p_sched->p_holidays    = m_table.p_holidays;
+    p_sched->group_count   = (m_table.entry_count > 0) ? m_table.group_count : 0;
+    p_sched->holiday_count = (m_table.entry_count > 0) ? m_table.holiday_count : 0;
+    p_sched->sequence      = m_table.sequence;
+    CRITICAL_REGION_EXIT();
+}
+
+
+ret_code_t lock_acl_mph_load_begin(void)
+{
+    uint8_t target;
+
+    if (m_committing || (m_pending > 0))
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    target = (m_active == 0) ? 1 : 0;
+    pending_add(1);
+    if (fs_erase(&m_fs_config, bank_addr(target), LOCK_ACL_MPH_PAGES, NULL) != FS_SUCCESS)
+    {
+        pending_add(-1);
+        return NRF_ERROR_BUSY;
+    }
+
+    m_target       = target;
+    m_loading      = true;
+    m_write_failed = false;
+    m_load_bytes   = 0;
+    m_load_words   = 0;
+    m_fill         = 0;
+    m_buf_idx      = 0;
+    m_buf_full     = false;
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t lock_acl_mph_load_append(uint8_t const * p_data, uint16_t len)
+{
+    if (!m_loading)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if (len > LOCK_ACL_MPH_CHUNK)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+    if ((m_load_bytes + len) > (MPH_BANK_WORDS * sizeof(uint32_t)) - sizeof(mph_bank_t))
+    {
+        m_loading = false;
+        return NRF_ERROR_NO_MEM;
+    }
+    // A full chunk that fstorage had no room for goes first; the new bytes wait for a free buffer.
+    if (m_buf_full)
+    {
+        if (!chunk_submit(m_buf_idx ^ 1, LOCK_ACL_MPH_CHUNK))
+        {
+            return NRF_ERROR_BUSY;
+        }
+        m_buf_full = false;
+    }
+    if (m_buf_busy[m_buf_idx] || ((len > LOCK_ACL_MPH_CHUNK - m_fill) && m_buf_busy[m_buf_idx ^ 1]))
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    m_load_crc    = crc32_compute(p_data, len, (m_load_bytes == 0) ? NULL : &m_load_crc);
+    m_load_bytes += len;
+
+    while (len > 0)
+    {
+        uint16_t chunk = MIN(len, LOCK_ACL_MPH_CHUNK - m_fill);
+
+        memcpy(&m_buf[m_buf_idx][m_fill], p_data, chunk);
+        m_fill += chunk;
+        p_data += chunk;
+        len    -= chunk;
+
+        if (m_fill == LOCK_ACL_MPH_CHUNK)
+        {
+            m_buf_full = true;
+            m_buf_idx ^= 1;
+            m_fill     = 0;
+        }
+    }
+    // Not taken now: retried by the next append or by the end.
+    if (m_buf_full && chunk_submit(m_buf_idx ^ 1, LOCK_ACL_MPH_CHUNK))
+    {
+        m_buf_full = false;
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t lock_acl_mph_load_end(uint32_t crc, uint32_t version)
+{
+    mph_bank_t const * p_bank;
+    uint32_t           image_crc;
+
+    if (!m_loading)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if (m_buf_full)
+    {
+        if (!chunk_submit(m_buf_idx ^ 1, LOCK_ACL_MPH_CHUNK))
+        {
+            return NRF_ERROR_BUSY;
+        }
+        m_buf_full = false;
+    }
+    if (m_fill > 0)
+    {
+        if (m_buf_busy[m_buf_idx] || !chunk_submit(m_buf_idx, m_fill))
+        {
+            return NRF_ERROR_BUSY;
+        }
+        m_fill = 0;
+    }
+    if (m_pending > 0)
+    {
+        return NRF_ERROR_BUSY;
+    }
+    m_loading = false;
+
+    if (m_write_failed || (m_load_bytes == 0) || (m_load_crc != crc))
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    // Read back through the address map: what the lookups will see.
+    p_bank    = (mph_bank_t const *)bank_addr(m_target);
+    image_crc = crc32_compute((uint8_t const *)(p_bank + 1), m_load_bytes, NULL);
+    if ((image_crc != crc) ||
+        !table_open(&m_next, (uint8_t const *)(p_bank + 1), m_load_bytes) ||
+        !table_verify(&m_next))
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    m_next.version      = version;
+    m_next.sequence     = (m_active == MPH_NO_BANK) ? 1 : (m_table.sequence + 1);
+
+    m_bank_hdr.sequence = m_next.sequence;
+    m_bank_hdr.version  = version;
+    m_bank_hdr.length   = m_load_bytes;
+    m_bank_hdr.crc      = crc;
+    m_bank_hdr.magic    = MPH_BANK_MAGIC;
+
+    m_committing = true;
+    if (fs_store(&m_fs_config, bank_addr(m_target), (uint32_t const *)&m_bank_hdr,
+                 sizeof(m_bank_hdr) / sizeof(uint32_t), &m_bank_hdr) != FS_SUCCESS)
+    {
+        // The image is in place; the phone sends the end again.
+        m_committing = false;
+        m_loading    = true;
+        return NRF_ERROR_BUSY;
+    }
+
+    return NRF_SUCCESS;
+}
+
+#endif //LOCK_ACL_MPH
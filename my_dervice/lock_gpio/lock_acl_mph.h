@@ -0,0 +1,106 @@
+#ifndef _LOCK_ACL_MPH_H_
+#define _LOCK_ACL_MPH_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "lock_acl.h"
+
+/* UID whitelist in internal flash, for sites small enough to do without the MX25L16. The
+ * table is read in place through the flash address map, a lookup costs two flash reads.
+ *
+ * Table image, as sent to lock_acl_mph_load_append(), little endian, generated offline:
+ *
+ *   header     magic "MPH2" (u32), entry_count n (u16), bucket_count m (u16), seed (u32),
+ *              group_count g (u8), holiday_count h (u8), reserved (u16)
+ *   buckets    m u16 displacements, padded to a multiple of 4 bytes
+ *   entries    n 8-byte entries {uid_len | group << 3, uid[7]}, unused UID bytes zero, no
+ *              empty slot; group 0 has no schedule, groups 1 to g use the schedules below
+ *   schedules  g schedules of LOCK_ACL_MPH_SCHED_SIZE bytes: rows Monday to Sunday, then one
+ *              for holidays, each LOCK_ACL_MPH_SCHED_SLOTS bits (bit i of byte i / 8) of
+ *              which slot s is set if access is allowed from s to s + 1 slot after midnight
+ *   holidays   h u16 days since 1970-01-01, ascending, then padding to a multiple of 4 bytes
+ *
+ * An "MPH1" image has the header up to the seed and ends after the entries, all in group 0.
+ *
+ * A UID is looked up with FNV-1a seeded by XOR into the offset basis:
+ *
+ *   d = buckets[fnv(seed, uid) % m]
+ *   slot = (d & 0x8000) ? (d & 0x7FFF) : (fnv(d, uid) % n)
+ *
+ * so the generator picks, bucket by bucket from the fullest, a displacement seed that sends
+ * its UIDs to free slots, or places a bucket of one UID directly. Every entry is checked to
+ * be found at its own slot before the table is taken.
+ *
+ * Two banks of LOCK_ACL_MPH_PAGES flash pages are registered with fstorage. A new table is
+ * written to the bank not in use; a bank header with a higher sequence number is programmed
+ * last and switches lookups over, so a load that is cut short leaves the old table active.
+ */
+#define LOCK_ACL_MPH_MAX_ENTRIES  0x8000
+#define LOCK_ACL_MPH_MAX_GROUPS   31
+#define LOCK_ACL_MPH_SLOT_S       900                           /**< Schedule slot, 15 minutes. */
+#define LOCK_ACL_MPH_SCHED_SLOTS  (86400 / LOCK_ACL_MPH_SLOT_S) /**< Slots per day. */
+#define LOCK_ACL_MPH_SCHED_ROWS   8                             /**< Monday to Sunday, holidays. */
+#define LOCK_ACL_MPH_SCHED_SIZE   (LOCK_ACL_MPH_SCHED_ROWS * LOCK_ACL_MPH_SCHED_SLOTS / 8)
+
+/**@brief Schedules of the active table, read in place. */
+typedef struct
+{
+    uint8_t const *  p_groups;       /**< group_count schedules of LOCK_ACL_MPH_SCHED_SIZE bytes. */
+    uint16_t const * p_holidays;
+    uint8_t          group_count;
+    uint8_t          holiday_count;
+    uint32_t         sequence;       /**< Changes with every table committed. */
+} lock_acl_mph_sched_t;
+
+/**@brief Find the newest complete table. fstorage is initialized here if it is not yet. */
+ret_code_t lock_acl_mph_init(void);
+
+/**@brief Look up a card. Any context; the table is read in place.
+ *
+ * @param[out] p_group  Group of a granted card, 0 for no schedule. May be NULL.
+ */
+lock_acl_result_t lock_acl_mph_check(uint8_t const * uid, uint8_t uid_len, uint8_t * p_group);
+
+/**@brief Number of entries in the active table, 0 if there is none. */
+uint32_t lock_acl_mph_count(void);
+
+/**@brief Version of the active table. */
+uint32_t lock_acl_mph_version(void);
+
+/**@brief Schedules of the active table; none without a table. */
+void lock_acl_mph_sched_get(lock_acl_mph_sched_t * p_sched);
+
+/**@brief Start receiving a table into the free bank. The active table stays in use.
+ *
+ * @retval NRF_SUCCESS     Erase of the free bank queued.
+ * @retval NRF_ERROR_BUSY  fstorage queue full, or the last table is still being committed.
+ */
+ret_code_t lock_acl_mph_load_begin(void);
+
+/**@brief Append image bytes. They are programmed in chunks of LOCK_ACL_MPH_CHUNK bytes.
+ *
+ * @retval NRF_SUCCESS             Bytes taken.
+ * @retval NRF_ERROR_BUSY          Both chunk buffers are still being programmed. Nothing was
+ *                                 taken; send the same bytes again.
+ * @retval NRF_ERROR_INVALID_STATE No load in progress.
+ * @retval NRF_ERROR_NO_MEM        The image exceeds the bank. The load is dropped.
+ */
+ret_code_t lock_acl_mph_load_append(uint8_t const * p_data, uint16_t len);
+
+/**@brief Finish a load: check the programmed image and commit it.
+ *
+ * @details The new table is used for lookups once its bank header is programmed, shortly after
+ *          this returns.
+ *
+ * @param[in] crc      CRC32 (crc32_compute()) of all bytes sent with lock_acl_mph_load_append().
+ * @param[in] version  Version of the table.
+ *
+ * @retval NRF_SUCCESS             Checked, commit queued.
+ * @retval NRF_ERROR_BUSY          Chunks are still being programmed; send the same request again.
+ * @retval NRF_ERROR_INVALID_STATE No load in progress.
+ * @retval NRF_ERROR_INVALID_DATA  CRC mismatch, failed write or an image that does not hash
+ *                                 every entry to its slot. The old table stays active.
+ */
+ret_code_t lock_acl_mph_load_end(uint32_t crc, uint32_t version);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef _LOCK_BOARD_H_
+#define _LOCK_BOARD_H_
+
+/* Pins of the lock, per build: BOARD_PCA10028 is the nRF51422 board the product ships on,
+ * BOARD_PCA10040 the nRF52832 build. The pins of the nRF52 board keep off P0.00/01 (32 kHz
+ * crystal), P0.09/10 (NFC), P0.21 (reset) and the UART of boards.h. Pins of the bus modules
+ * (TWI_BUS, SPI_BUS, ...) are in sdk_config.h; the nRF52 ones in its app_config.h. */
+
+#if defined(BOARD_PCA10040)
+
+#define LED1                17
+#define LED2                18
+#define MOTO_NSLEEP         22
+#define MOTO_NFAULT         23
+#define MOTO_EN1            24
+#define MOTO_EN2            25
+#define QK_BEEP             11
+#define INPUT_SR            13
+#define IRDA_PUT            12
+#define IRDA_IN             14
+#define VOL_EN              15
+
+#define PN532_CONFIG_SCL    27  //!< Slave SCL pin
+#define PN532_CONFIG_SDA    26  //!< Slave SDA pin
+#define PN532_IRQ           2   //irq
+#define PN532_CONFIG_SCK    27  //!< SPI SCK pin
+#define PN532_CONFIG_MOSI   26  //!< SPI MOSI pin
+#define PN532_CONFIG_MISO   4   //!< SPI MISO pin
+#define PN532_CONFIG_NSS    3   //!< SPI NSS pin, driven by hand
+#define PN532_CONFIG_TXD    26  //!< HSU pin to the PN532 RX
+#define PN532_CONFIG_RXD    27  //!< HSU pin from the PN532 TX
+
+#define SPI_SS_PIN          28
+#define SPI_MISO_PIN        29
+#define SPI_MOSI_PIN        30
+#define SPI_SCK_PIN         31
+
+#else
+
+#define LED1                4
+#define LED2                0
+#define MOTO_NSLEEP         14
+#define MOTO_NFAULT         15
+#define MOTO_EN1            8
+#define MOTO_EN2            6
+#define QK_BEEP             30
+#define INPUT_SR            12
+#define IRDA_PUT            7
+#define IRDA_IN             9
+#define VOL_EN              1
+
+#define PN532_CONFIG_SCL    11  //!< Slave SCL pin
+#define PN532_CONFIG_SDA    10  //!< Slave SDA pin
+#define PN532_IRQ           2   //irq
+#define PN532_CONFIG_SCK    11  //!< SPI SCK pin
+#define PN532_CONFIG_MOSI   10  //!< SPI MOSI pin
+#define PN532_CONFIG_MISO   12  //!< SPI MISO pin
+#define PN532_CONFIG_NSS    13  //!< SPI NSS pin, driven by hand
+#define PN532_CONFIG_TXD    10  //!< HSU pin to the PN532 RX
+#define PN532_CONFIG_RXD    11  //!< HSU pin from the PN532 TX
+
+#define SPI_SS_PIN          28
+#define SPI_MISO_PIN        29
+#define SPI_MOSI_PIN        25
+#define SPI_SCK_PIN         24
+
+#endif
+
+#endif
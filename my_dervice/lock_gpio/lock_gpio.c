@@ -1,12 +1,58 @@
+#include "sdk_common.h"
 #include "lock_gpio.h"
 #include "nrf_gpio.h"
-#include "pca10028.h"
 #include "low_power_pwm.h"
+#include "beep_pwm.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#include "nrf_queue.h"
+#include "app_error.h"
+#include "lock_moto.h"
+#include "port_sense.h"
+#include "lock_state.h"
+#include "lat_trace.h"
+#include "dev_cfg.h"
 
 
+#define FB_BEEP         0x01  /**< Step output: buzzer. */
+#define FB_LED1         0x02  /**< Step output: LED1. */
+#define FB_LED2         0x04  /**< Step output: LED2. */
+#define FB_STEPS_MAX    4
+#define FB_MS(ms)       ((uint32_t)(ms) * DEV_CFG_GET(fb_time_pct, 100) / 100)
 
+/**@brief One step of a pattern: outputs held for a time. A zero time ends the pattern. */
+typedef struct
+{
+    uint8_t  outputs;
+    uint16_t ms;
+} fb_step_t;
+
+static fb_step_t const m_patterns[LOCK_FB_COUNT][FB_STEPS_MAX] =
+{
+    [LOCK_FB_BOOT]    = {{FB_BEEP | FB_LED1 | FB_LED2, 600}},
+    [LOCK_FB_BEEP]    = {{FB_BEEP, 300}},
+    [LOCK_FB_SUCCESS] = {{FB_BEEP | FB_LED1, 100}, {FB_LED1, 200}},
+    [LOCK_FB_FAIL]    = {{FB_BEEP | FB_LED2, 100}, {FB_LED2, 80}, {FB_BEEP | FB_LED2, 100}, {FB_LED2, 120}},
+    [LOCK_FB_DENIED]  = {{FB_BEEP | FB_LED2, 400}},
+};
+
+NRF_QUEUE_DEF(uint8_t, m_fb_queue, LOCK_FB_QUEUE_SIZE, NRF_QUEUE_MODE_NO_OVERFLOW);
+APP_TIMER_DEF(m_fb_timer);
 
-static low_power_pwm_t low_power_pwm_0;
+#if NRF_MODULE_ENABLED(BEEP_PWM)
+// Same calls, with the tone from TIMER and PPI or the PWM peripheral instead of app_timer.
+#define BEEP_PWM(fn)    beep_pwm_##fn
+typedef beep_pwm_t      beep_t;
+#else
+#define BEEP_PWM(fn)    low_power_pwm_##fn
+typedef low_power_pwm_t beep_t;
+#endif
+
+static beep_t  low_power_pwm_0;
+static bool    m_fb_playing;
+static uint8_t m_fb_pattern;   /**< Pattern being played. */
+static uint8_t m_fb_index;     /**< Step being played. */
+static uint8_t m_fb_outputs;
 
 
 static void pwm_handler(void * p_context)
@@ -14,6 +60,100 @@ static void pwm_handler(void * p_context)
 	
 }
 
+
+static void led_write(uint32_t pin, bool on)
+{
+    nrf_gpio_pin_write(pin, on ? LOCK_LED_ACTIVE_STATE : !LOCK_LED_ACTIVE_STATE);
+}
+
+
+static void fb_outputs_set(uint8_t outputs)
+{
+    if ((outputs ^ m_fb_outputs) & FB_BEEP)
+    {
+        if (outputs & FB_BEEP)
+        {
+            UNUSED_RETURN_VALUE(BEEP_PWM(start)(&low_power_pwm_0, low_power_pwm_0.bit_mask));
+        }
+        else
+        {
+            UNUSED_RETURN_VALUE(BEEP_PWM(stop)(&low_power_pwm_0));
+        }
+    }
+    led_write(LED1, (outputs & FB_LED1) != 0);
+    led_write(LED2, (outputs & FB_LED2) != 0);
+    m_fb_outputs = outputs;
+}
+
+
+/**@brief Play the next step, the first step of the next queued pattern, or go idle. */
+static void fb_advance(void)
+{
+    fb_step_t const * p_step = NULL;
+
+    if (m_fb_playing && (++m_fb_index < FB_STEPS_MAX) && (m_patterns[m_fb_pattern][m_fb_index].ms != 0))
+    {
+        p_step = &m_patterns[m_fb_pattern][m_fb_index];
+    }
+    else if (nrf_queue_pop(&m_fb_queue, &m_fb_pattern) == NRF_SUCCESS)
+    {
+        m_fb_index = 0;
+        p_step     = &m_patterns[m_fb_pattern][0];
+    }
+
+    if (p_step == NULL)
+    {
+        m_fb_playing = false;
+        fb_outputs_set(0);
+        return;
+    }
+
+    m_fb_playing = true;
+    fb_outputs_set(p_step->outputs);
+    APP_ERROR_CHECK(app_timer_start(m_fb_timer,
+                                    APP_TIMER_TICKS(FB_MS(p_step->ms), APP_TIMER_CONFIG_PRESCALER),
+                                    NULL));
+}
+
+
+static void fb_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    CRITICAL_REGION_ENTER();
+    fb_advance();
+    CRITICAL_REGION_EXIT();
+}
+
+
+/**@brief Queue a feedback pattern and return at once.
+ *
+ * @details Patterns play one after the other from the app_timer interrupt. A pattern that does
+ *          not fit in the queue is dropped.
+ */
+void lock_feedback_play(lock_fb_pattern_t pattern)
+{
+    uint8_t p = (uint8_t)pattern;
+
+    if (pattern >= LOCK_FB_COUNT)
+    {
+        return;
+    }
+
+    LAT_TRACE_START(t);
+    CRITICAL_REGION_ENTER();
+    if (nrf_queue_push(&m_fb_queue, &p) == NRF_SUCCESS)
+    {
+        if (!m_fb_playing)
+        {
+            fb_advance();
+        }
+    }
+    CRITICAL_REGION_EXIT();
+    LAT_TRACE_STOP(LAT_STAGE_BEEP, t);
+}
+
+
 void  beep_gpio_init(void)
 {
 	  uint32_t err_code;
@@ -26,45 +166,97 @@ void  beep_gpio_init(void)
     low_power_pwm_config.p_timer_id     = &lpp_timer_0;
     low_power_pwm_config.p_port         = NRF_GPIO;
 
-    err_code = low_power_pwm_init((&low_power_pwm_0), &low_power_pwm_config, pwm_handler);
+    err_code = BEEP_PWM(init)((&low_power_pwm_0), &low_power_pwm_config, pwm_handler);
     APP_ERROR_CHECK(err_code);
-    err_code = low_power_pwm_duty_set(&low_power_pwm_0, 20);
+    err_code = BEEP_PWM(duty_set)(&low_power_pwm_0, 20);
     APP_ERROR_CHECK(err_code);
 
-    err_code = low_power_pwm_start((&low_power_pwm_0), low_power_pwm_0.bit_mask);
+    err_code = app_timer_create(&m_fb_timer, APP_TIMER_MODE_SINGLE_SHOT, fb_timer_handler);
     APP_ERROR_CHECK(err_code);
-		nrf_delay_ms(600);
-	  low_power_pwm_stop((&low_power_pwm_0));
+
+    lock_feedback_play(LOCK_FB_BOOT);
 }
 
 
-//void moto_gpio_init(void)
-//{
-//	
-//}
+#if NRF_MODULE_ENABLED(LOCK_MOTO)
+static void moto_evt_handler(lock_moto_evt_t evt)
+{
+    if (evt == LOCK_MOTO_EVT_FAULT)
+    {
+        lock_feedback_play(LOCK_FB_FAIL);
+    }
+#if NRF_MODULE_ENABLED(LOCK_STATE)
+    lock_state_on_moto_evt(evt);
+#endif
+}
+#endif
+
+
+void moto_gpio_init(void)
+{
+#if NRF_MODULE_ENABLED(LOCK_MOTO)
+    APP_ERROR_CHECK(lock_moto_init(moto_evt_handler));
+#endif
+}
 
 //void irda_gpio_init(void)
 //{
 //	
 //}
 
-//void  led_gpio_init(void)
-//{
-//	nrf_gpio_cfg_output(LED1,GPIO_PIN_CNF_PULL_Pullup); //pwm
-//}
+void  led_gpio_init(void)
+{
+    led_write(LED1, false);
+    led_write(LED2, false);
+    nrf_gpio_cfg_output(LED1);
+    nrf_gpio_cfg_output(LED2);
+}
 
 
-void qk_lock_init(void)
+#if NRF_MODULE_ENABLED(LOCK_STATE)
+static void door_handler(uint8_t pin, bool level)
+{
+    UNUSED_PARAMETER(pin);
+    lock_state_on_door(level == LOCK_DOOR_CLOSED_STATE);
+}
+#else
+#define door_handler NULL
+#endif
+
+
+static void door_gpio_init(void)
+{
+#if NRF_MODULE_ENABLED(PORT_SENSE)
+    APP_ERROR_CHECK(port_sense_init());
+    // A contact bounces: read debounced, on the PORT event with the other slow inputs.
+    APP_ERROR_CHECK(port_sense_pin_add(INPUT_SR, NRF_GPIO_PIN_PULLUP, true, door_handler));
+#else
+    nrf_gpio_cfg_input(INPUT_SR, NRF_GPIO_PIN_PULLUP);
+#endif
+}
+
+
+bool lock_door_is_closed(void)
 {
+#if NRF_MODULE_ENABLED(PORT_SENSE)
+    return port_sense_level_get(INPUT_SR) == LOCK_DOOR_CLOSED_STATE;
+#else
+    return nrf_gpio_pin_read(INPUT_SR) == LOCK_DOOR_CLOSED_STATE;
+#endif
+}
 
+
+void qk_lock_init(void)
+{
+	led_gpio_init();
 	beep_gpio_init();
+	moto_gpio_init();
+	door_gpio_init();
 }
 
 uint8_t   new_duty_cycle= 10;
 
 void beep_test(void)
 {
-    low_power_pwm_start((&low_power_pwm_0), low_power_pwm_0.bit_mask);
-		nrf_delay_ms(300);
-	  low_power_pwm_stop((&low_power_pwm_0));
+    lock_feedback_play(LOCK_FB_BEEP);
 }
@@ -1,26 +1,31 @@
 #ifndef _LOCK_GPIO_H_
 #define _LOCK_GPIO_H_
 #include <stdint.h>
+#include <stdbool.h>
 #include "nrf_delay.h"
+#include "lock_board.h"
 
-#define LED1 		4            //
-#define LED2 		0
-#define MOTO_NSLEEP		14
-#define MOTO_NFAULT		15
-#define MOTO_EN1      8
-#define MOTO_EN2      6
-#define QK_BEEP          30
-#define INPUT_SR      12
+#define LOCK_LED_ACTIVE_STATE    0   // LED1/LED2 light when the pin is low
+#define LOCK_DOOR_CLOSED_STATE   0   // The contact on INPUT_SR pulls it low while the door is shut
+#define LOCK_FB_QUEUE_SIZE       4   // Patterns that can wait behind the one playing
 
-#define IRDA_PUT      7
-#define IRDA_IN       9
-
-#define VOL_EN        1
+/**@brief Feedback patterns played by lock_feedback_play(). */
+typedef enum
+{
+    LOCK_FB_BOOT,     /**< Power up: long beep, both LEDs. */
+    LOCK_FB_BEEP,     /**< Plain 300 ms beep (beep_test). */
+    LOCK_FB_SUCCESS,  /**< Short beep, LED1. */
+    LOCK_FB_FAIL,     /**< Two short beeps, LED2. */
+    LOCK_FB_DENIED,   /**< Long beep, LED2. */
+    LOCK_FB_COUNT
+} lock_fb_pattern_t;
 
 void  beep_gpio_init(void);
 void  moto_gpio_init(void);
 void  irda_gpio_init(void);
 void  led_gpio_init(void);
 void qk_lock_init(void);
+bool lock_door_is_closed(void);
 void beep_test(void);
+void lock_feedback_play(lock_fb_pattern_t pattern);
 #endif
\ No newline at end of file
@@ -0,0 +1,903 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(LOCK_JOURNAL)
+#include "lock_journal.h"
+#include "flash_io.h"
+#include "crc16.h"
+#include "mx25_async.h"
+#if NRF_MODULE_ENABLED(WALL_CLOCK)
+#include "wall_clock.h"
+#endif
+#include <stddef.h>
+#include <string.h>
+
+#define JOURNAL_SECTOR_SIZE  4096
+#define JOURNAL_PAGE_SIZE    256
+#define JOURNAL_HDR_SIZE     sizeof(journal_sector_t)
+#define JOURNAL_SUM_SIZE     sizeof(journal_summary_t)
+#define JOURNAL_REC_END      (JOURNAL_SECTOR_SIZE - JOURNAL_SUM_SIZE)   /**< Records end, the summary starts. */
+#define JOURNAL_PAYLOAD      (JOURNAL_REC_END - JOURNAL_HDR_SIZE)
+#define JOURNAL_HDR_CRC_LEN  offsetof(journal_sector_t, crc)
+#define JOURNAL_SUM_CRC_LEN  offsetof(journal_summary_t, crc)
+#define JOURNAL_MAGIC        0x4A4C       /**< "LJ" */
+#define JOURNAL_SUM_MAGIC    0x534A       /**< "JS" */
+#define JOURNAL_BLOOM_BYTES  64
+#define JOURNAL_BLOOM_BITS   (JOURNAL_BLOOM_BYTES * 8)
+#define JOURNAL_REC_MAX      (1 + 5 + LOCK_JOURNAL_DATA_LEN + 1)
+#define JOURNAL_NO_SECTOR    0xFFFFFFFF
+#define JOURNAL_PENDING      4            /**< Entries that can wait for their program job. */
+
+/* First byte of a record. Form 3 is never written, so neither is 0xFF. */
+#define REC_TYPE_MASK        0x07
+#define REC_FORM_POS         3
+#define REC_FORM_MASK        0x03
+#define REC_LEN_POS          5
+#define REC_RAW              0            /**< Data as it is. */
+#define REC_NEW              1            /**< UID, taking the next dictionary slot. */
+#define REC_REF              2            /**< Dictionary slot of a UID. */
+
+STATIC_ASSERT(sizeof(lock_journal_entry_t) == 16);
+STATIC_ASSERT(LOCK_JOURNAL_SECTORS >= 2);
+STATIC_ASSERT(LOCK_JOURNAL_DATA_LEN <= 7);
+STATIC_ASSERT(LOCK_JOURNAL_DICT_SIZE <= 255);
+
+#if !NRF_MODULE_ENABLED(MX25_ASYNC)
+#error "lock_journal needs MX25_ASYNC"
+#endif
+
+/**@brief Start of a sector, programmed when the head enters it. */
+typedef struct
+{
+    uint32_t number;       /**< Sectors opened before this one; it lives in number % LOCK_JOURNAL_SECTORS. */
+    uint32_t base_seq;     /**< Sequence number of the first record. */
+    uint32_t base_time;    /**< The first record is timed from here. */
+    uint16_t magic;
+    uint16_t crc;          /**< CRC16 of the fields above. */
+} journal_sector_t;
+
+/**@brief End of a sector, programmed when the head leaves it: what a query needs to pass it by. */
+typedef struct
+{
+    uint32_t end_seq;      /**< Sequence number after the last record. */
+    uint32_t min_time;
+    uint32_t max_time;
+    uint8_t  bloom[JOURNAL_BLOOM_BYTES];   /**< Three bits per entry data, see bloom_bits(). */
+    uint16_t magic;
+    uint16_t crc;          /**< CRC16 of the fields above. */
+} journal_summary_t;
+
+STATIC_ASSERT(JOURNAL_SUM_SIZE <= JOURNAL_PAGE_SIZE);
+
+/**@brief Position in a sector being decoded. */
+typedef struct
+{
+    uint32_t number;       /**< Sector, JOURNAL_NO_SECTOR for none. */
+    uint32_t seq;          /**< Sequence number of the record at @p off. */
+    uint32_t time;         /**< Time of the record before @p off. */
+    uint16_t off;
+    bool     torn;         /**< Stopped at a record that failed its check. */
+    uint8_t  dict_count;
+    uint16_t dict_off[LOCK_JOURNAL_DICT_SIZE];   /**< Sector offsets of the dictionary UIDs. */
+} journal_cursor_t;
+
+typedef struct
+{
+    uint8_t len;
+    uint8_t data[LOCK_JOURNAL_DATA_LEN];
+} journal_uid_t;
+
+/**@brief An entry until its record is programmed. */
+typedef struct
+{
+    lock_journal_entry_t entry;
+    uint8_t              rec[JOURNAL_REC_MAX];
+    uint8_t              rec_len;
+} journal_pending_t;
+
+/* Sector n of the log lives in flash sector n % LOCK_JOURNAL_SECTORS. The sector after the
+   head sector is kept erased; it is the one given up when the log wraps. Erases and programs
+   go through mx25_async, so appending never waits for the chip. */
+static uint32_t m_head_seq;
+static uint32_t m_head_number;    /**< Sector the head is in. */
+static uint32_t m_head_base;      /**< Its first sequence number. */
+static uint16_t m_head_off;       /**< Its first free byte, JOURNAL_SECTOR_SIZE once closed. */
+static uint32_t m_prev_time;      /**< Time of the last record. */
+static bool     m_has_sector;     /**< Some sector has been opened. */
+static bool     m_spare_queued;   /**< The erase of the sector after the head sector is queued or done. */
+static bool     m_ready;
+static uint32_t m_oldest_seq;
+static bool     m_oldest_stale;   /**< Read again from the sector headers when next asked. */
+static bool     m_sealed;         /**< The summary of the head sector is queued. */
+
+static journal_uid_t    m_dict[LOCK_JOURNAL_DICT_SIZE];   /**< Dictionary of the head sector. */
+static uint8_t          m_dict_count;
+static journal_sector_t m_hdr;                            /**< Header being programmed. */
+static journal_summary_t m_sum;                           /**< Summary of the head sector, kept up. */
+static journal_summary_t m_seal;                          /**< Summary being programmed. */
+static journal_cursor_t m_read;                           /**< Where the last read left off. */
+
+static journal_pending_t m_pending[JOURNAL_PENDING];      /**< Entries head - count .. head - 1. */
+static uint8_t           m_pending_first;
+static uint8_t           m_pending_count;
+
+
+static uint32_t journal_now(void)
+{
+#if NRF_MODULE_ENABLED(WALL_CLOCK)
+    return wall_clock_now();
+#else
+    return 0;
+#endif
+}
+
+
+static uint32_t sector_addr(uint32_t number)
+{
+    return LOCK_JOURNAL_FLASH_ADDR + (number % LOCK_JOURNAL_SECTORS) * JOURNAL_SECTOR_SIZE;
+}
+
+
+/**@brief First sector still held: the head sector plus the full sectors before it, the spare excluded. */
+static uint32_t oldest_number(void)
+{
+    return (m_head_number < LOCK_JOURNAL_SECTORS - 2) ? 0 : m_head_number - (LOCK_JOURNAL_SECTORS - 2);
+}
+
+
+static uint8_t crc8(uint8_t const * p_data, uint32_t len)
+{
+    uint8_t crc = 0;
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        crc ^= p_data[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+
+static uint8_t varint_put(uint8_t * p_out, int32_t delta)
+{
+    uint32_t value = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+    uint8_t  len   = 0;
+
+    while (value >= 0x80)
+    {
+        p_out[len++] = (uint8_t)(value | 0x80);
+        value      >>= 7;
+    }
+    p_out[len++] = (uint8_t)value;
+    return len;
+}
+
+
+/**@return Bytes taken, 0 if the varint does not end within @p avail bytes. */
+static uint8_t varint_get(uint8_t const * p_in, uint8_t avail, int32_t * p_delta)
+{
+    uint32_t value = 0;
+
+    for (uint8_t i = 0; (i < 5) && (i < avail); i++)
+    {
+        value |= (uint32_t)(p_in[i] & 0x7F) << (7 * i);
+        if ((p_in[i] & 0x80) == 0)
+        {
+            *p_delta = (int32_t)((value >> 1) ^ (0U - (value & 1)));
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+
+static bool header_valid(journal_sector_t const * p_hdr)
+{
+    return (p_hdr->magic == JOURNAL_MAGIC) &&
+           (crc16_compute((uint8_t const *)p_hdr, JOURNAL_HDR_CRC_LEN, NULL) == p_hdr->crc);
+}
+
+
+static bool header_read(uint32_t number, journal_sector_t * p_hdr)
+{
+    read_mx25l16_buf((uint8_t *)p_hdr, sector_addr(number), sizeof(*p_hdr));
+    return header_valid(p_hdr) && (p_hdr->number == number);
+}
+
+
+static void cursor_start(journal_cursor_t * p_cur, journal_sector_t const * p_hdr)
+{
+    p_cur->number     = p_hdr->number;
+    p_cur->seq        = p_hdr->base_seq;
+    p_cur->time       = p_hdr->base_time;
+    p_cur->off        = JOURNAL_HDR_SIZE;
+    p_cur->torn       = false;
+    p_cur->dict_count = 0;
+}
+
+
+/**@brief Decode the record at the cursor and step past it.
+ *
+ * @retval NRF_SUCCESS             Entry decoded.
+ * @retval NRF_ERROR_NOT_FOUND     No record there yet.
+ * @retval NRF_ERROR_INVALID_DATA  A torn record; nothing after it in the sector is read.
+ */
+static ret_code_t cursor_next(journal_cursor_t * p_cur, lock_journal_entry_t * p_entry, uint8_t * p_form)
+{
+    uint32_t addr = sector_addr(p_cur->number);
+    uint8_t  rec[JOURNAL_REC_MAX];
+    uint8_t  avail;
+    uint8_t  pos = 1;
+    uint8_t  form;
+    uint8_t  len;
+    int32_t  delta;
+
+    if (p_cur->torn)
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+    if (p_cur->off >= JOURNAL_REC_END)
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    avail = (uint8_t)MIN(JOURNAL_REC_MAX, JOURNAL_REC_END - p_cur->off);
+    read_mx25l16_buf(rec, addr + p_cur->off, avail);
+    if (rec[0] == 0xFF)
+    {
+        // The end, or the erased tail of a page a record did not fit in.
+        uint16_t next = (p_cur->off + JOURNAL_PAGE_SIZE) & ~(JOURNAL_PAGE_SIZE - 1);
+
+        if (((p_cur->off % JOURNAL_PAGE_SIZE) == 0) || (next >= JOURNAL_REC_END))
+        {
+            return NRF_ERROR_NOT_FOUND;
+        }
+        avail = (uint8_t)MIN(JOURNAL_REC_MAX, JOURNAL_REC_END - next);
+        read_mx25l16_buf(rec, addr + next, avail);
+        if (rec[0] == 0xFF)
+        {
+            return NRF_ERROR_NOT_FOUND;
+        }
+        p_cur->off = next;
+    }
+
+    form = (rec[0] >> REC_FORM_POS) & REC_FORM_MASK;
+    len  = rec[0] >> REC_LEN_POS;
+    memset(p_entry->data, 0xFF, sizeof(p_entry->data));
+
+    if (((rec[0] & REC_TYPE_MASK) == 0) || (form > REC_REF) || (len > LOCK_JOURNAL_DATA_LEN))
+    {
+        p_cur->torn = true;
+        return NRF_ERROR_INVALID_DATA;
+    }
+    pos += varint_get(&rec[pos], avail - pos, &delta);
+    if ((pos == 1) || (pos + ((form == REC_REF) ? 1 : len) >= avail))
+    {
+        p_cur->torn = true;
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    if (form == REC_REF)
+    {
+        uint8_t slot = rec[pos++];
+
+        if (slot >= p_cur->dict_count)
+        {
+            p_cur->torn = true;
+            return NRF_ERROR_INVALID_DATA;
+        }
+        read_mx25l16_buf(p_entry->data, addr + p_cur->dict_off[slot], len);
+    }
+    else
+    {
+        memcpy(p_entry->data, &rec[pos], len);
+        pos += len;
+    }
+
+    if ((crc8(rec, pos) != rec[pos]) ||
+        ((form == REC_NEW) && (p_cur->dict_count == LOCK_JOURNAL_DICT_SIZE)))
+    {
+        p_cur->torn = true;
+        return NRF_ERROR_INVALID_DATA;
+    }
+    if (form == REC_NEW)
+    {
+        p_cur->dict_off[p_cur->dict_count++] = p_cur->off + pos - len;
+    }
+
+    p_entry->seq  = p_cur->seq++;
+    p_entry->time = p_cur->time + (uint32_t)delta;
+    p_entry->type = rec[0] & REC_TYPE_MASK;
+    p_entry->len  = len;
+    p_cur->time   = p_entry->time;
+    p_cur->off   += pos + 1;
+    if (p_form != NULL)
+    {
+        *p_form = form;
+    }
+    return NRF_SUCCESS;
+}
+
+
+/**@brief Move the cursor to the next sector with a valid header, up to the head sector. */
+static bool cursor_advance(journal_cursor_t * p_cur)
+{
+    journal_sector_t hdr;
+
+    for (uint32_t number = p_cur->number + 1; number <= m_head_number; number++)
+    {
+        if (header_read(number, &hdr))
+        {
+            cursor_start(p_cur, &hdr);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/**@brief Start the cursor in the newest sector that begins at or before @p seq. */
+static bool cursor_locate(journal_cursor_t * p_cur, uint32_t seq)
+{
+    journal_sector_t hdr;
+    uint32_t         oldest = oldest_number();
+
+    for (uint32_t number = m_head_number + 1; number-- > oldest; )
+    {
+        if (header_read(number, &hdr) && (hdr.base_seq <= seq))
+        {
+            cursor_start(p_cur, &hdr);
+            return true;
+        }
+    }
+    p_cur->number = JOURNAL_NO_SECTOR;
+    return false;
+}
+
+
+static uint8_t dict_find(uint8_t const * p_data, uint8_t len)
+{
+    for (uint8_t i = 0; i < m_dict_count; i++)
+    {
+        if ((m_dict[i].len == len) && (memcmp(m_dict[i].data, p_data, len) == 0))
+        {
+            return i;
+        }
+    }
+    return m_dict_count;
+}
+
+
+/**@brief Encode a record against the head sector. Data of two bytes and more goes through the dictionary. */
+static uint8_t record_encode(uint8_t * p_rec, uint8_t type, uint8_t const * p_data, uint8_t len,
+                             uint32_t time, uint8_t * p_form)
+{
+    uint8_t slot = m_dict_count;
+    uint8_t form = REC_RAW;
+    uint8_t pos  = 1;
+
+    if (len >= 2)
+    {
+        slot = dict_find(p_data, len);
+        if (slot < m_dict_count)
+        {
+            form = REC_REF;
+        }
+        else if (m_dict_count < LOCK_JOURNAL_DICT_SIZE)
+        {
+            form = REC_NEW;
+        }
+    }
+
+    p_rec[0] = (uint8_t)(type | (form << REC_FORM_POS) | (len << REC_LEN_POS));
+    pos     += varint_put(&p_rec[pos], (int32_t)(time - m_prev_time));
+    if (form == REC_REF)
+    {
+        p_rec[pos++] = slot;
+    }
+    else
+    {
+        memcpy(&p_rec[pos], p_data, len);
+        pos += len;
+    }
+    p_rec[pos] = crc8(p_rec, pos);
+
+    *p_form = form;
+    return pos + 1;
+}
+
+
+/**@brief Offset for a record in the head sector, past the page if it would cross one.
+ *
+ * @return JOURNAL_SECTOR_SIZE if it does not fit.
+ */
+static uint16_t record_place(uint8_t len)
+{
+    uint16_t off = m_head_off;
+
+    if (!m_has_sector)
+    {
+        return JOURNAL_SECTOR_SIZE;
+    }
+    if ((off % JOURNAL_PAGE_SIZE) + len > JOURNAL_PAGE_SIZE)
+    {
+        off = (off + JOURNAL_PAGE_SIZE) & ~(JOURNAL_PAGE_SIZE - 1);
+    }
+    return (off + len > JOURNAL_REC_END) ? JOURNAL_SECTOR_SIZE : off;
+}
+
+
+/**@brief Bloom filter bits of entry data: three 9-bit slices of its FNV-1a hash. */
+static void bloom_bits(uint8_t const * p_data, uint8_t len, uint16_t * p_bits)
+{
+    uint32_t hash = 2166136261UL;
+
+    for (uint8_t i = 0; i < len; i++)
+    {
+        hash = (hash ^ p_data[i]) * 16777619UL;
+    }
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        p_bits[i] = (uint16_t)((hash >> (9 * i)) % JOURNAL_BLOOM_BITS);
+    }
+}
+
+
+static void summary_reset(void)
+{
+    memset(&m_sum, 0, sizeof(m_sum));
+    m_sum.min_time = UINT32_MAX;
+    m_sealed       = false;
+}
+
+
+static void summary_add(lock_journal_entry_t const * p_entry)
+{
+    uint16_t bits[3];
+
+    m_sum.min_time = MIN(m_sum.min_time, p_entry->time);
+    m_sum.max_time = MAX(m_sum.max_time, p_entry->time);
+    if (p_entry->len > 0)
+    {
+        bloom_bits(p_entry->data, p_entry->len, bits);
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            m_sum.bloom[bits[i] / 8] |= 1 << (bits[i] % 8);
+        }
+    }
+}
+
+
+static bool summary_read(uint32_t number, journal_summary_t * p_sum)
+{
+    read_mx25l16_buf((uint8_t *)p_sum, sector_addr(number) + JOURNAL_REC_END, sizeof(*p_sum));
+    return (p_sum->magic == JOURNAL_SUM_MAGIC) &&
+           (crc16_compute((uint8_t const *)p_sum, JOURNAL_SUM_CRC_LEN, NULL) == p_sum->crc);
+}
+
+
+/**@brief Whether a sector may hold entries the filter takes. */
+static bool summary_match(journal_summary_t const * p_sum, lock_journal_filter_t const * p_filter)
+{
+    uint16_t bits[3];
+
+    if ((p_sum->max_time < p_filter->from_time) || (p_sum->min_time > p_filter->to_time))
+    {
+        return false;
+    }
+    if (p_filter->uid_len > 0)
+    {
+        bloom_bits(p_filter->uid, p_filter->uid_len, bits);
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            if ((p_sum->bloom[bits[i] / 8] & (1 << (bits[i] % 8))) == 0)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+static bool entry_match(lock_journal_entry_t const * p_entry, lock_journal_filter_t const * p_filter)
+{
+    return (p_entry->time >= p_filter->from_time) && (p_entry->time <= p_filter->to_time) &&
+           ((p_filter->uid_len == 0) ||
+            ((p_entry->len == p_filter->uid_len) && (memcmp(p_entry->data, p_filter->uid, p_entry->len) == 0)));
+}
+
+
+static void erase_done(ret_code_t result, void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    if (result != NRF_SUCCESS)
+    {
+        // Erase it again when the head gets there.
+        m_spare_queued = false;
+    }
+}
+
+
+/**@brief Queue the erase of the sector after the head sector. */
+static void spare_erase(void)
+{
+    m_spare_queued = (mx25_erase_start(sector_addr(m_head_number + 1), erase_done, NULL) == NRF_SUCCESS);
+}
+
+
+static void header_done(ret_code_t result, void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    if (result != NRF_SUCCESS)
+    {
+        // Records behind a bad header cannot be found; start over in the next sector.
+        m_head_off = JOURNAL_SECTOR_SIZE;
+    }
+}
+
+
+static void program_done(ret_code_t result, void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    if (result != NRF_SUCCESS)
+    {
+        // Whatever got programmed fails its CRC and ends the sector for the readers.
+        m_head_off = JOURNAL_SECTOR_SIZE;
+    }
+
+    // Programs complete in queue order, so this is the oldest pending entry.
+    m_pending_first = (m_pending_first + 1) % JOURNAL_PENDING;
+    m_pending_count--;
+}
+
+
+static void summary_done(ret_code_t result, void * p_context)
+{
+    // Without its summary a sector is only decoded by the queries, not skipped.
+    UNUSED_PARAMETER(result);
+    UNUSED_PARAMETER(p_context);
+}
+
+
+/**@brief Move the head into the next sector: seal the head sector, erase the next one if that
+ *        is not queued yet, program its header.
+ */
+static ret_code_t sector_open(uint32_t time)
+{
+    uint32_t number = m_has_sector ? m_head_number + 1 : 0;
+
+    if (m_has_sector && !m_sealed)
+    {
+        m_seal         = m_sum;
+        m_seal.end_seq = m_head_seq;
+        m_seal.magic   = JOURNAL_SUM_MAGIC;
+        m_seal.crc     = crc16_compute((uint8_t const *)&m_seal, JOURNAL_SUM_CRC_LEN, NULL);
+        if (mx25_program_start((uint8_t const *)&m_seal, sector_addr(m_head_number) + JOURNAL_REC_END,
+                               sizeof(m_seal), summary_done, NULL) != NRF_SUCCESS)
+        {
+            return NRF_ERROR_BUSY;
+        }
+        m_sealed = true;
+    }
+    if (!m_spare_queued &&
+        (mx25_erase_start(sector_addr(number), erase_done, NULL) != NRF_SUCCESS))
+    {
+        return NRF_ERROR_BUSY;
+    }
+    // Until the head is in it, the flag covers this sector.
+    m_spare_queued = true;
+
+    m_hdr.number    = number;
+    m_hdr.base_seq  = m_head_seq;
+    m_hdr.base_time = time;
+    m_hdr.magic     = JOURNAL_MAGIC;
+    m_hdr.crc       = crc16_compute((uint8_t const *)&m_hdr, JOURNAL_HDR_CRC_LEN, NULL);
+    if (mx25_program_start((uint8_t const *)&m_hdr, sector_addr(number), sizeof(m_hdr),
+                           header_done, NULL) != NRF_SUCCESS)
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    m_has_sector    = true;
+    m_head_number   = number;
+    m_head_base     = m_head_seq;
+    m_head_off      = JOURNAL_HDR_SIZE;
+    m_prev_time     = time;
+    m_dict_count    = 0;
+    m_spare_queued  = false;
+    summary_reset();
+    // Not read here: the flash is busy with the erase.
+    m_oldest_stale  = true;
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t lock_journal_init(void)
+{
+    journal_sector_t     hdr;
+    journal_sector_t     head_hdr;
+    lock_journal_entry_t entry;
+    uint8_t              form;
+    ret_code_t           err_code;
+
+    mx25lxx_wakeup();
+
+    m_has_sector = false;
+    for (uint32_t sector = 0; sector < LOCK_JOURNAL_SECTORS; sector++)
+    {
+        read_mx25l16_buf((uint8_t *)&hdr, LOCK_JOURNAL_FLASH_ADDR + sector * JOURNAL_SECTOR_SIZE, sizeof(hdr));
+        if (header_valid(&hdr) && ((hdr.number % LOCK_JOURNAL_SECTORS) == sector) &&
+            (!m_has_sector || (hdr.number > head_hdr.number)))
+        {
+            head_hdr     = hdr;
+            m_has_sector = true;
+        }
+    }
+
+    // Nothing is known to be erased; a sector is erased before its header is written.
+    m_spare_queued = false;
+    m_oldest_stale = true;
+    m_read.number  = JOURNAL_NO_SECTOR;
+    m_dict_count   = 0;
+    summary_reset();
+    if (!m_has_sector)
+    {
+        m_head_seq    = 0;
+        m_head_number = 0;
+    }
+    else
+    {
+        // Replayed to the end for the head, the time, the dictionary and the summary.
+        cursor_start(&m_read, &head_hdr);
+        while ((err_code = cursor_next(&m_read, &entry, &form)) == NRF_SUCCESS)
+        {
+            summary_add(&entry);
+            if (form == REC_NEW)
+            {
+                m_dict[m_dict_count].len = entry.len;
+                memcpy(m_dict[m_dict_count].data, entry.data, entry.len);
+                m_dict_count++;
+            }
+        }
+        m_head_number = head_hdr.number;
+        m_head_base   = head_hdr.base_seq;
+        m_head_seq    = m_read.seq;
+        m_prev_time   = m_read.time;
+        // A record torn by the reset ends the sector.
+        m_head_off    = (err_code == NRF_ERROR_INVALID_DATA) ? JOURNAL_SECTOR_SIZE : m_read.off;
+    }
+
+    m_ready = true;
+
+    if (m_has_sector)
+    {
+        spare_erase();
+    }
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t lock_journal_append(uint8_t type, uint8_t const * p_data, uint8_t len)
+{
+    journal_pending_t * p_pend;
+    uint32_t            now;
+    uint16_t            off;
+    uint8_t             form;
+    ret_code_t          err_code;
+
+    if (!m_ready)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if (len > LOCK_JOURNAL_DATA_LEN)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+    if ((type == 0) || (type > LOCK_JOURNAL_TYPE_MAX))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if (m_pending_count == JOURNAL_PENDING)
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    now    = journal_now();
+    p_pend = &m_pending[(m_pending_first + m_pending_count) % JOURNAL_PENDING];
+
+    p_pend->rec_len = record_encode(p_pend->rec, type, p_data, len, now, &form);
+    off             = record_place(p_pend->rec_len);
+    if (off == JOURNAL_SECTOR_SIZE)
+    {
+        err_code = sector_open(now);
+        VERIFY_SUCCESS(err_code);
+
+        // Again, against the empty dictionary.
+        p_pend->rec_len = record_encode(p_pend->rec, type, p_data, len, now, &form);
+        off             = record_place(p_pend->rec_len);
+    }
+
+    if (mx25_program_start(p_pend->rec, sector_addr(m_head_number) + off, p_pend->rec_len,
+                           program_done, NULL) != NRF_SUCCESS)
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    if (form == REC_NEW)
+    {
+        m_dict[m_dict_count].len = len;
+        memcpy(m_dict[m_dict_count].data, p_data, len);
+        m_dict_count++;
+    }
+
+    memset(&p_pend->entry, 0xFF, sizeof(p_pend->entry));
+    p_pend->entry.seq  = m_head_seq;
+    p_pend->entry.time = now;
+    p_pend->entry.type = type;
+    p_pend->entry.len  = len;
+    memcpy(p_pend->entry.data, p_data, len);
+    summary_add(&p_pend->entry);
+
+    m_pending_count++;
+    m_head_seq++;
+    m_head_off  = off + p_pend->rec_len;
+    m_prev_time = now;
+
+    // Queued behind the record, so the first entry of a sector does not wait for the erase.
+    if (!m_spare_queued)
+    {
+        spare_erase();
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t lock_journal_read(uint32_t seq, lock_journal_entry_t * p_entry)
+{
+    ret_code_t err_code;
+
+    if ((seq >= m_head_seq) || (seq < lock_journal_oldest()))
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    // Not programmed yet: answer from RAM.
+    if (seq >= m_head_seq - m_pending_count)
+    {
+        *p_entry = m_pending[(m_pending_first + (seq - (m_head_seq - m_pending_count))) % JOURNAL_PENDING].entry;
+        return NRF_SUCCESS;
+    }
+
+    if ((m_read.number == JOURNAL_NO_SECTOR) || (m_read.number < oldest_number()) || (seq < m_read.seq))
+    {
+        if (!cursor_locate(&m_read, seq))
+        {
+            return NRF_ERROR_INVALID_DATA;
+        }
+    }
+
+    while (m_read.seq <= seq)
+    {
+        err_code = cursor_next(&m_read, p_entry, NULL);
+        if (err_code == NRF_SUCCESS)
+        {
+            if (p_entry->seq == seq)
+            {
+                return NRF_SUCCESS;
+            }
+            continue;
+        }
+
+        // The rest of the sector is torn or was never written; go on from the next one.
+        if (!cursor_advance(&m_read))
+        {
+            m_read.number = JOURNAL_NO_SECTOR;
+            return NRF_ERROR_INVALID_DATA;
+        }
+        if (seq < m_read.seq)
+        {
+            return NRF_ERROR_INVALID_DATA;
+        }
+    }
+    return NRF_ERROR_INVALID_DATA;
+}
+
+
+ret_code_t lock_journal_find(lock_journal_filter_t const * p_filter, uint32_t * p_seq,
+                             lock_journal_entry_t * p_entry)
+{
+    journal_summary_t sum;
+    ret_code_t        err_code;
+    uint32_t          seq     = MAX(*p_seq, lock_journal_oldest());
+    uint32_t          checked = JOURNAL_NO_SECTOR;
+
+    while (seq < m_head_seq)
+    {
+        err_code = lock_journal_read(seq, p_entry);
+
+        // A sealed sector is looked at once, when the first entry read from it is decoded.
+        if ((seq < m_head_seq - m_pending_count) && (m_read.number != JOURNAL_NO_SECTOR) &&
+            (m_read.number != m_head_number) && (m_read.number != checked))
+        {
+            checked = m_read.number;
+            if (summary_read(checked, &sum) && !summary_match(&sum, p_filter))
+            {
+                seq = MAX(sum.end_seq, seq + 1);
+                if (cursor_advance(&m_read))
+                {
+                    seq = MAX(seq, m_read.seq);
+                }
+                else
+                {
+                    m_read.number = JOURNAL_NO_SECTOR;
+                }
+                continue;
+            }
+        }
+
+        seq++;
+        if ((err_code == NRF_SUCCESS) && entry_match(p_entry, p_filter))
+        {
+            *p_seq = seq;
+            return NRF_SUCCESS;
+        }
+    }
+
+    *p_seq = seq;
+    return NRF_ERROR_NOT_FOUND;
+}
+
+
+uint32_t lock_journal_head(void)
+{
+    return m_head_seq;
+}
+
+
+uint32_t lock_journal_oldest(void)
+{
+    journal_sector_t hdr;
+
+    if (!m_has_sector)
+    {
+        return 0;
+    }
+    if (m_oldest_stale)
+    {
+        // A sector with a torn header holds nothing that can be read.
+        m_oldest_seq = m_head_base;
+        for (uint32_t number = oldest_number(); number < m_head_number; number++)
+        {
+            if (header_read(number, &hdr))
+            {
+                m_oldest_seq = hdr.base_seq;
+                break;
+            }
+        }
+        m_oldest_stale = false;
+    }
+    return m_oldest_seq;
+}
+
+
+uint32_t lock_journal_capacity(void)
+{
+    uint32_t total = (LOCK_JOURNAL_SECTORS - 1) * JOURNAL_PAYLOAD;
+    uint32_t held  = m_head_seq - lock_journal_oldest();
+    uint32_t used;
+
+    if (!m_has_sector || (held == 0))
+    {
+        return total / JOURNAL_REC_MAX;
+    }
+    used = (m_head_number - oldest_number()) * JOURNAL_PAYLOAD + (MIN(m_head_off, JOURNAL_REC_END) - JOURNAL_HDR_SIZE);
+    return (uint32_t)(((uint64_t)held * total) / MAX(used, 1));
+}
+
+#endif //NRF_MODULE_ENABLED(LOCK_JOURNAL)
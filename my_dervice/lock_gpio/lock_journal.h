@@ -0,0 +1,120 @@
+#ifndef _LOCK_JOURNAL_H_
+#define _LOCK_JOURNAL_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+#define LOCK_JOURNAL_DATA_LEN  7   /**< Payload bytes per entry, enough for a 7-byte UID. */
+#define LOCK_JOURNAL_TYPE_MAX  7   /**< Types are stored in three bits. */
+
+/* Entries are stored compressed, as records of varying length packed into the 4 KB sectors:
+ *
+ *   sector    a 16-byte header: sector number, sequence number and time of its first
+ *             record, CRC16; records follow, none crossing a 256-byte program page; the
+ *             last 80 bytes take the summary once the head has moved on
+ *   summary   sequence number after the last record, earliest and latest time, a 512-bit
+ *             Bloom filter of the entry data, CRC16: a query passes a sector by on it
+ *   record    one byte of type (3 bits), form (2 bits) and data length (3 bits), the time
+ *             since the record before as a zigzag varint, the data, a CRC8
+ *   forms     data as it is; a UID new to the sector, which takes the next of the
+ *             LOCK_JOURNAL_DICT_SIZE dictionary slots of that sector; or a reference, one
+ *             byte for the dictionary slot of a UID seen earlier in the sector
+ *
+ * A card tapped again within the sector costs 4 or 5 bytes instead of 16. Sequence numbers
+ * are implicit: a record is found by decoding its sector from the start, which the reads do
+ * once for entries read in order. The time is wall_clock_now(), from boot until the clock is
+ * first set. */
+
+/**@brief Event types written by the application. */
+typedef enum
+{
+    LOCK_JOURNAL_EVT_GRANTED  = 1, /**< Card on the whitelist, lock opened. Data: UID. */
+    LOCK_JOURNAL_EVT_DENIED   = 2, /**< Card not on the whitelist. Data: UID. */
+    LOCK_JOURNAL_EVT_TAP      = 3, /**< Card seen without a whitelist, phone decides. Data: UID. */
+    LOCK_JOURNAL_EVT_TIME     = 4, /**< Clock set, to the entry time. Data: time before (LE seconds). */
+    LOCK_JOURNAL_EVT_SCHEDULE = 5, /**< Card on the whitelist outside its schedule. Data: UID. */
+    LOCK_JOURNAL_EVT_PASSBACK = 6, /**< Card on the whitelist already through in this direction. Data: UID. */
+} lock_journal_type_t;
+
+/**@brief One journal entry, decoded. */
+typedef struct
+{
+    uint32_t seq;                           /**< Sequence number. */
+    uint32_t time;                          /**< wall_clock_now() at the append, seconds. */
+    uint8_t  type : 4;                      /**< lock_journal_type_t. */
+    uint8_t  len  : 4;                      /**< Used bytes of @p data. */
+    uint8_t  data[LOCK_JOURNAL_DATA_LEN];   /**< Payload, unused bytes 0xFF. */
+} lock_journal_entry_t;
+
+/**@brief What lock_journal_find() looks for. */
+typedef struct
+{
+    uint32_t from_time;                     /**< Earliest entry time taken. */
+    uint32_t to_time;                       /**< Latest entry time taken. */
+    uint8_t  uid_len;                       /**< 0 for entries of any data. */
+    uint8_t  uid[LOCK_JOURNAL_DATA_LEN];    /**< Data the entry must have, a UID for card events. */
+} lock_journal_filter_t;
+
+/**@brief Find the head of the journal.
+ *
+ * @details Reads the header of each sector to find the newest one, then decodes that sector
+ *          to the end for the head, the time and the UID dictionary: up to LOCK_JOURNAL_SECTORS
+ *          plus a few hundred small reads.
+ *
+ * @note The MX25L16 SPI bus must be initialized (device_mx25l16mb_init()). The spare sector
+ *       is erased through app_scheduler.
+ */
+ret_code_t lock_journal_init(void);
+
+/**@brief Append an entry, stamped with the current time.
+ *
+ * @details Programs one record, no erase. When the head enters a new sector, the sector
+ *          after it is erased later from the scheduler, dropping the oldest entries.
+ *          Call from the main loop only: it shares the SPI bus with the whitelist.
+ *
+ * @retval NRF_SUCCESS               Entry queued for programming.
+ * @retval NRF_ERROR_INVALID_STATE   lock_journal_init() has not been called.
+ * @retval NRF_ERROR_INVALID_LENGTH  @p len above LOCK_JOURNAL_DATA_LEN.
+ * @retval NRF_ERROR_INVALID_PARAM   @p type 0 or above LOCK_JOURNAL_TYPE_MAX.
+ * @retval NRF_ERROR_BUSY            The flash job queue is full.
+ */
+ret_code_t lock_journal_append(uint8_t type, uint8_t const * p_data, uint8_t len);
+
+/**@brief Read an entry by sequence number.
+ *
+ * @details Cheap for the entry after the one read last; otherwise its sector is found from
+ *          the sector headers and decoded up to it.
+ *
+ * @retval NRF_SUCCESS             Entry read and checked.
+ * @retval NRF_ERROR_NOT_FOUND     @p seq is not in [lock_journal_oldest(), lock_journal_head()).
+ * @retval NRF_ERROR_INVALID_DATA  The record was torn by a reset while being written, or
+ *                                 follows a torn one in its sector.
+ */
+ret_code_t lock_journal_read(uint32_t seq, lock_journal_entry_t * p_entry);
+
+/**@brief Find the next entry a filter takes.
+ *
+ * @details Entries are decoded from @p *p_seq on, but a sealed sector whose summary rules the
+ *          filter out is passed by without decoding it: one read of its summary.
+ *
+ * @param[in]    p_filter  Time range and data.
+ * @param[inout] p_seq     Where to start. On return, where to go on from: after the entry
+ *                         found, or lock_journal_head() if there was none.
+ * @param[out]   p_entry   Entry found.
+ *
+ * @retval NRF_SUCCESS          Entry found.
+ * @retval NRF_ERROR_NOT_FOUND  No more entries the filter takes.
+ */
+ret_code_t lock_journal_find(lock_journal_filter_t const * p_filter, uint32_t * p_seq,
+                             lock_journal_entry_t * p_entry);
+
+/**@brief Sequence number the next entry will get. */
+uint32_t lock_journal_head(void);
+
+/**@brief Oldest sequence number still held. */
+uint32_t lock_journal_oldest(void);
+
+/**@brief Entries held once the journal has wrapped, at the mean record size so far. */
+uint32_t lock_journal_capacity(void);
+
+#endif
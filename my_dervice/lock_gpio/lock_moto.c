@@ -0,0 +1,376 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(LOCK_MOTO)
+#include "lock_moto.h"
+#include "lock_gpio.h"
+#include "nrf_gpio.h"
+#if NRF_MODULE_ENABLED(PORT_SENSE)
+#include "port_sense.h"
+#else
+#include "nrf_drv_gpiote.h"
+#endif
+#include "app_timer.h"
+#include "app_util_platform.h"
+#include "dev_cfg.h"
+#if NRF_MODULE_ENABLED(ENERGY)
+#include "energy.h"
+#endif
+#if NRF_MODULE_ENABLED(MOTO_SENSE)
+#include "moto_sense.h"
+#endif
+
+#define MOTO_TICKS(ms)  APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+
+/**@brief Phases of one unlock. */
+typedef enum
+{
+    MOTO_SLEEP,        /**< Bridge asleep, lock closed. */
+    MOTO_OPEN_DRIVE,
+    MOTO_OPEN_BRAKE,
+    MOTO_OPEN_COAST,
+    MOTO_HOLD,         /**< Bridge asleep, lock open. */
+    MOTO_CLOSE_DRIVE,
+    MOTO_CLOSE_BRAKE,
+    MOTO_CLOSE_COAST,
+    MOTO_FAULT,        /**< Bridge asleep until lock_moto_fault_clear(). */
+} moto_state_t;
+
+/**@brief Inputs of the H-bridge. */
+typedef enum
+{
+    BRIDGE_COAST,    /**< Both low: outputs floating. */
+    BRIDGE_FORWARD,  /**< EN1 high: opening direction. */
+    BRIDGE_REVERSE,  /**< EN2 high: closing direction. */
+    BRIDGE_BRAKE,    /**< Both high: motor shorted. */
+} bridge_t;
+
+APP_TIMER_DEF(m_moto_timer);
+
+static volatile moto_state_t   m_state = MOTO_SLEEP;
+static lock_moto_evt_handler_t m_handler;
+static volatile bool           m_hold;      /**< The hold phase does not end on its own. */
+static uint32_t                m_drive_start;
+static lock_moto_travel_t      m_travel;
+
+
+static void bridge_set(bridge_t mode)
+{
+    nrf_gpio_pin_write(MOTO_EN1, (mode == BRIDGE_FORWARD) || (mode == BRIDGE_BRAKE));
+    nrf_gpio_pin_write(MOTO_EN2, (mode == BRIDGE_REVERSE) || (mode == BRIDGE_BRAKE));
+}
+
+
+static void bridge_sleep(bool sleep)
+{
+    if (sleep)
+    {
+        bridge_set(BRIDGE_COAST);
+        nrf_gpio_pin_clear(MOTO_NSLEEP);
+#if NRF_MODULE_ENABLED(ENERGY)
+        energy_off(ENERGY_MOTOR);
+#endif
+    }
+    else
+    {
+        nrf_gpio_pin_set(MOTO_NSLEEP);
+#if NRF_MODULE_ENABLED(ENERGY)
+        energy_on(ENERGY_MOTOR);
+#endif
+    }
+}
+
+
+static void evt_send(lock_moto_evt_t evt)
+{
+    if (m_handler != NULL)
+    {
+        m_handler(evt);
+    }
+}
+
+
+/**@brief Enter a phase: set the bridge and arm the timer for its end. */
+static void state_enter(moto_state_t state)
+{
+    uint32_t ms = 0;
+
+    m_state = state;
+    switch (state)
+    {
+        case MOTO_OPEN_DRIVE:
+        case MOTO_CLOSE_DRIVE:
+            bridge_sleep(false);
+            bridge_set((state == MOTO_OPEN_DRIVE) ? BRIDGE_FORWARD : BRIDGE_REVERSE);
+            m_drive_start = app_timer_cnt_get();
+#if NRF_MODULE_ENABLED(MOTO_SENSE)
+            // The drive time stays, as the backstop for a stall that is not seen.
+            moto_sense_start();
+#endif
+            ms = LOCK_MOTO_WAKE_MS + LOCK_MOTO_DRIVE_MS;
+            break;
+
+        case MOTO_OPEN_BRAKE:
+        case MOTO_CLOSE_BRAKE:
+#if NRF_MODULE_ENABLED(MOTO_SENSE)
+            moto_sense_stop();
+#endif
+            bridge_set(BRIDGE_BRAKE);
+            ms = LOCK_MOTO_BRAKE_MS;
+            break;
+
+        case MOTO_OPEN_COAST:
+        case MOTO_CLOSE_COAST:
+            bridge_set(BRIDGE_COAST);
+            ms = LOCK_MOTO_COAST_MS;
+            break;
+
+        case MOTO_HOLD:
+            bridge_sleep(true);
+            ms = m_hold ? 0 : DEV_CFG_GET(lock_hold_ms, LOCK_MOTO_HOLD_MS);
+            evt_send(LOCK_MOTO_EVT_OPENED);
+            break;
+
+        case MOTO_SLEEP:
+            bridge_sleep(true);
+            evt_send(LOCK_MOTO_EVT_CLOSED);
+            break;
+
+        case MOTO_FAULT:
+        default:
+#if NRF_MODULE_ENABLED(MOTO_SENSE)
+            moto_sense_stop();
+#endif
+            bridge_sleep(true);
+            break;
+    }
+
+    if (ms != 0)
+    {
+        UNUSED_RETURN_VALUE(app_timer_start(m_moto_timer, MOTO_TICKS(ms), NULL));
+    }
+}
+
+
+/**@brief The bolt has stopped moving, at its end when @p stalled, else at the drive time. */
+static void travel_end(bool stalled)
+{
+    uint32_t ticks = 0;
+    uint16_t ms;
+
+    UNUSED_RETURN_VALUE(app_timer_cnt_diff_compute(app_timer_cnt_get(), m_drive_start, &ticks));
+    ms = (uint16_t)MIN(((uint64_t)ticks * 1000 * (APP_TIMER_CONFIG_PRESCALER + 1)) / APP_TIMER_CLOCK_FREQ,
+                       UINT16_MAX);
+    if (m_state == MOTO_OPEN_DRIVE)
+    {
+        m_travel.open_ms = ms;
+    }
+    else
+    {
+        m_travel.close_ms = ms;
+    }
+    if (stalled)
+    {
+        m_travel.stalls++;
+    }
+    else
+    {
+        m_travel.backstops++;
+    }
+}
+
+
+#if NRF_MODULE_ENABLED(MOTO_SENSE)
+/**@brief End of travel: brake now instead of at the end of the drive time. */
+static void stall_handler(void)
+{
+    if ((m_state != MOTO_OPEN_DRIVE) && (m_state != MOTO_CLOSE_DRIVE))
+    {
+        return;
+    }
+    UNUSED_RETURN_VALUE(app_timer_stop(m_moto_timer));
+    travel_end(true);
+    state_enter((m_state == MOTO_OPEN_DRIVE) ? MOTO_OPEN_BRAKE : MOTO_CLOSE_BRAKE);
+}
+#endif
+
+
+static void moto_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    if ((m_state == MOTO_OPEN_DRIVE) || (m_state == MOTO_CLOSE_DRIVE))
+    {
+        travel_end(false);
+    }
+
+    switch (m_state)
+    {
+        case MOTO_OPEN_DRIVE:  state_enter(MOTO_OPEN_BRAKE);  break;
+        case MOTO_OPEN_BRAKE:  state_enter(MOTO_OPEN_COAST);  break;
+        case MOTO_OPEN_COAST:  state_enter(MOTO_HOLD);        break;
+        case MOTO_HOLD:        state_enter(MOTO_CLOSE_DRIVE); break;
+        case MOTO_CLOSE_DRIVE: state_enter(MOTO_CLOSE_BRAKE); break;
+        case MOTO_CLOSE_BRAKE: state_enter(MOTO_CLOSE_COAST); break;
+        case MOTO_CLOSE_COAST: state_enter(MOTO_SLEEP);       break;
+        default:                                              break;
+    }
+}
+
+
+#if NRF_MODULE_ENABLED(PORT_SENSE)
+static void nfault_handler(uint8_t pin, bool level)
+{
+    UNUSED_PARAMETER(pin);
+
+    if (level)
+    {
+        // The bridge let go of NFAULT; the fault stays until lock_moto_fault_clear().
+        return;
+    }
+#else
+static void nfault_handler(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action)
+{
+    UNUSED_PARAMETER(pin);
+    UNUSED_PARAMETER(action);
+#endif
+
+    // NFAULT is only meaningful while the bridge is awake.
+    if ((m_state == MOTO_SLEEP) || (m_state == MOTO_HOLD) || (m_state == MOTO_FAULT))
+    {
+        return;
+    }
+    UNUSED_RETURN_VALUE(app_timer_stop(m_moto_timer));
+    state_enter(MOTO_FAULT);
+    evt_send(LOCK_MOTO_EVT_FAULT);
+}
+
+
+ret_code_t lock_moto_init(lock_moto_evt_handler_t handler)
+{
+#if !NRF_MODULE_ENABLED(PORT_SENSE)
+    nrf_drv_gpiote_in_config_t fault_config = GPIOTE_CONFIG_IN_SENSE_HITOLO(false);
+#endif
+    ret_code_t                 err_code;
+
+    m_handler = handler;
+
+    nrf_gpio_pin_clear(MOTO_EN1);
+    nrf_gpio_pin_clear(MOTO_EN2);
+    nrf_gpio_pin_clear(MOTO_NSLEEP);
+    nrf_gpio_cfg_output(MOTO_EN1);
+    nrf_gpio_cfg_output(MOTO_EN2);
+    nrf_gpio_cfg_output(MOTO_NSLEEP);
+
+    err_code = app_timer_create(&m_moto_timer, APP_TIMER_MODE_SINGLE_SHOT, moto_timer_handler);
+    VERIFY_SUCCESS(err_code);
+#if NRF_MODULE_ENABLED(MOTO_SENSE)
+    err_code = moto_sense_init(stall_handler);
+    VERIFY_SUCCESS(err_code);
+#endif
+
+#if NRF_MODULE_ENABLED(PORT_SENSE)
+    err_code = port_sense_init();
+    VERIFY_SUCCESS(err_code);
+
+    // NFAULT is open drain, low from the bridge itself: no debounce.
+    return port_sense_pin_add(MOTO_NFAULT, NRF_GPIO_PIN_PULLUP, false, nfault_handler);
+#else
+    if (!nrf_drv_gpiote_is_init())
+    {
+        err_code = nrf_drv_gpiote_init();
+        VERIFY_SUCCESS(err_code);
+    }
+
+    // NFAULT is open drain.
+    fault_config.pull = NRF_GPIO_PIN_PULLUP;
+    err_code = nrf_drv_gpiote_in_init(MOTO_NFAULT, &fault_config, nfault_handler);
+    VERIFY_SUCCESS(err_code);
+    nrf_drv_gpiote_in_event_enable(MOTO_NFAULT, true);
+
+    return NRF_SUCCESS;
+#endif
+}
+
+
+ret_code_t lock_moto_unlock(void)
+{
+    ret_code_t err_code = NRF_SUCCESS;
+
+    CRITICAL_REGION_ENTER();
+    switch (m_state)
+    {
+        case MOTO_SLEEP:
+            state_enter(MOTO_OPEN_DRIVE);
+            break;
+
+        case MOTO_HOLD:
+            if (!m_hold)
+            {
+                UNUSED_RETURN_VALUE(app_timer_stop(m_moto_timer));
+                UNUSED_RETURN_VALUE(app_timer_start(m_moto_timer, MOTO_TICKS(DEV_CFG_GET(lock_hold_ms, LOCK_MOTO_HOLD_MS)), NULL));
+            }
+            break;
+
+        case MOTO_FAULT:
+            err_code = NRF_ERROR_INVALID_STATE;
+            break;
+
+        default:
+            err_code = NRF_ERROR_BUSY;
+            break;
+    }
+    CRITICAL_REGION_EXIT();
+
+    return err_code;
+}
+
+
+void lock_moto_hold(bool hold)
+{
+    CRITICAL_REGION_ENTER();
+    if (hold != m_hold)
+    {
+        m_hold = hold;
+        if (m_state == MOTO_HOLD)
+        {
+            UNUSED_RETURN_VALUE(app_timer_stop(m_moto_timer));
+            if (!hold)
+            {
+                UNUSED_RETURN_VALUE(app_timer_start(m_moto_timer, MOTO_TICKS(LOCK_MOTO_RELOCK_MS), NULL));
+            }
+        }
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+
+bool lock_moto_is_closed(void)
+{
+    return (m_state == MOTO_SLEEP);
+}
+
+
+void lock_moto_travel_get(lock_moto_travel_t * p_travel)
+{
+    CRITICAL_REGION_ENTER();
+    *p_travel = m_travel;
+    CRITICAL_REGION_EXIT();
+}
+
+
+bool lock_moto_fault_get(void)
+{
+    return (m_state == MOTO_FAULT);
+}
+
+
+void lock_moto_fault_clear(void)
+{
+    CRITICAL_REGION_ENTER();
+    if (m_state == MOTO_FAULT)
+    {
+        m_state = MOTO_SLEEP;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+#endif //NRF_MODULE_ENABLED(LOCK_MOTO)
@@ -0,0 +1,67 @@
+#ifndef _LOCK_MOTO_H_
+#define _LOCK_MOTO_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/**@brief Motor driver events. */
+typedef enum
+{
+    LOCK_MOTO_EVT_OPENED,  /**< The bolt has been driven open; the hold time starts. */
+    LOCK_MOTO_EVT_CLOSED,  /**< The bolt has been driven back and the driver sleeps. */
+    LOCK_MOTO_EVT_FAULT,   /**< NFAULT went low: the bridge has been switched off. */
+} lock_moto_evt_t;
+
+/**@brief How the bolt moved, since boot. */
+typedef struct
+{
+    uint16_t open_ms;      /**< Drive time of the last opening. */
+    uint16_t close_ms;     /**< Drive time of the last closing. */
+    uint16_t stalls;       /**< Drives ended at the end of travel, by moto_sense. */
+    uint16_t backstops;    /**< Drives ended by LOCK_MOTO_DRIVE_MS. */
+} lock_moto_travel_t;
+
+/**@brief Event handler, called from the app_timer, GPIOTE or motor sense interrupt. */
+typedef void (*lock_moto_evt_handler_t)(lock_moto_evt_t evt);
+
+/**@brief Configure the bridge pins, put the driver to sleep and arm the fault input.
+ *
+ * @note Requires app_timer to be initialized.
+ */
+ret_code_t lock_moto_init(lock_moto_evt_handler_t handler);
+
+/**@brief Open the lock, hold it open for LOCK_MOTO_HOLD_MS and close it again.
+ *
+ * @details Returns at once. The bridge is woken and driven in the same call, so the bolt moves
+ *          after the driver wake-up time only. The phases after that (drive, brake and coast
+ *          for opening, hold, then the same for closing) are timed by app_timer; with
+ *          MOTO_SENSE a drive ends early at the stall current of the end of travel, and the
+ *          driver sleeps through the hold. Another unlock during the hold restarts the hold.
+ *          Safe to call from interrupt context.
+ *
+ * @retval NRF_SUCCESS             Unlock started or hold extended.
+ * @retval NRF_ERROR_BUSY          The bolt is moving.
+ * @retval NRF_ERROR_INVALID_STATE The driver reported a fault; call lock_moto_fault_clear().
+ */
+ret_code_t lock_moto_unlock(void);
+
+/**@brief Keep the lock open past LOCK_MOTO_HOLD_MS, e.g. while the door stands open. Any context.
+ *
+ * @details While held, the hold phase after an unlock does not end; an unlock started meanwhile
+ *          opens and stays open. On release the bolt is driven back LOCK_MOTO_RELOCK_MS later.
+ */
+void lock_moto_hold(bool hold);
+
+/**@brief Whether the bolt is closed and the driver asleep. */
+bool lock_moto_is_closed(void);
+
+/**@brief Drive times and how the drives ended. */
+void lock_moto_travel_get(lock_moto_travel_t * p_travel);
+
+/**@brief Whether a fault has stopped the motor. */
+bool lock_moto_fault_get(void);
+
+/**@brief Forget a fault once its cause has been dealt with. */
+void lock_moto_fault_clear(void);
+
+#endif
@@ -0,0 +1,147 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(LOCK_STATE)
+#include "lock_state.h"
+#include "lock_gpio.h"
+#include "app_scheduler.h"
+#include "app_util_platform.h"
+
+#if !NRF_MODULE_ENABLED(LOCK_MOTO)
+#error "lock_state needs LOCK_MOTO_ENABLED"
+#endif
+#if !NRF_MODULE_ENABLED(PORT_SENSE)
+#error "lock_state hears the door contact through PORT_SENSE_ENABLED"
+#endif
+
+static volatile lock_state_t m_state;
+static lock_state_handler_t  m_handler;
+static volatile bool         m_notify_queued;
+
+
+static void notify_run(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    // Changes that came meanwhile are in the state now; the handler gets the last one.
+    m_notify_queued = false;
+    if (m_handler != NULL)
+    {
+        m_handler(m_state);
+    }
+}
+
+
+/**@brief Enter a state; call with interrupts off. */
+static void state_set(lock_state_t state)
+{
+    if (state == m_state)
+    {
+        return;
+    }
+    m_state = state;
+    if (!m_notify_queued)
+    {
+        m_notify_queued = (app_sched_event_put(NULL, 0, notify_run) == NRF_SUCCESS);
+    }
+}
+
+
+ret_code_t lock_state_init(lock_state_handler_t handler)
+{
+    ret_code_t err_code;
+
+    m_handler = handler;
+
+    CRITICAL_REGION_ENTER();
+    if (!lock_door_is_closed())
+    {
+        m_state = LOCK_STATE_OPEN;
+        lock_moto_hold(true);
+    }
+    else
+    {
+        m_state = lock_moto_is_closed() ? LOCK_STATE_LOCKED : LOCK_STATE_UNLOCKING;
+    }
+    m_notify_queued = true;
+    CRITICAL_REGION_EXIT();
+
+    err_code = app_sched_event_put(NULL, 0, notify_run);
+    if (err_code != NRF_SUCCESS)
+    {
+        m_notify_queued = false;
+    }
+    return err_code;
+}
+
+
+ret_code_t lock_state_unlock(void)
+{
+    ret_code_t err_code = NRF_SUCCESS;
+
+    CRITICAL_REGION_ENTER();
+    // With the door open the bolt is held back already: nothing to drive.
+    if (m_state != LOCK_STATE_OPEN)
+    {
+        err_code = lock_moto_unlock();
+        if (err_code == NRF_SUCCESS)
+        {
+            state_set(LOCK_STATE_UNLOCKING);
+        }
+    }
+    CRITICAL_REGION_EXIT();
+
+    return err_code;
+}
+
+
+lock_state_t lock_state_get(void)
+{
+    return m_state;
+}
+
+
+void lock_state_on_moto_evt(lock_moto_evt_t evt)
+{
+    CRITICAL_REGION_ENTER();
+    switch (evt)
+    {
+        case LOCK_MOTO_EVT_OPENED:
+            // An unlock that did not come through lock_state_unlock().
+            if (m_state == LOCK_STATE_LOCKED)
+            {
+                state_set(LOCK_STATE_UNLOCKING);
+            }
+            break;
+
+        case LOCK_MOTO_EVT_CLOSED:
+            if ((m_state == LOCK_STATE_UNLOCKING) || (m_state == LOCK_STATE_RELOCKING))
+            {
+                state_set(LOCK_STATE_LOCKED);
+            }
+            break;
+
+        default:
+            // A fault leaves the bolt where it is; the door contact still tells open from shut.
+            break;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+
+void lock_state_on_door(bool closed)
+{
+    CRITICAL_REGION_ENTER();
+    if (!closed)
+    {
+        lock_moto_hold(true);
+        state_set(LOCK_STATE_OPEN);
+    }
+    else if (m_state == LOCK_STATE_OPEN)
+    {
+        lock_moto_hold(false);
+        state_set(lock_moto_is_closed() ? LOCK_STATE_LOCKED : LOCK_STATE_RELOCKING);
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+#endif //NRF_MODULE_ENABLED(LOCK_STATE)
@@ -0,0 +1,56 @@
+#ifndef _LOCK_STATE_H_
+#define _LOCK_STATE_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "lock_moto.h"
+
+/* State of the lock as a whole, from the bolt (lock_moto) and the door contact on INPUT_SR:
+ *
+ *   locked     door shut, bolt closed
+ *   unlocking  an unlock drove the bolt open; nobody has opened the door yet. The hold time of
+ *              lock_moto runs, and the bolt closes at its end if the door stays shut
+ *   open       the door stands open. The bolt is held open, so that it does not stick out
+ *              into the frame, and an unlock is granted without moving the motor
+ *   relocking  the door is shut again; the bolt is driven back LOCK_MOTO_RELOCK_MS later
+ *
+ * A door that opens in the locked state, forced or with a bolt that did not catch, is open as
+ * well. The handler gets every change in the main loop, to hold off what an open door makes
+ * useless: card polling and advertising for a phone at the door. */
+
+typedef enum
+{
+    LOCK_STATE_LOCKED,
+    LOCK_STATE_UNLOCKING,
+    LOCK_STATE_OPEN,
+    LOCK_STATE_RELOCKING,
+} lock_state_t;
+
+/**@brief Called from the main loop on a change of the state. */
+typedef void (*lock_state_handler_t)(lock_state_t state);
+
+/**@brief Start from the door contact and the bolt as they are.
+ *
+ * @details Call after qk_lock_init() and app_scheduler. The handler is called once with the
+ *          state to start from.
+ */
+ret_code_t lock_state_init(lock_state_handler_t handler);
+
+/**@brief Open, unless the door is open already.
+ *
+ * @retval NRF_SUCCESS             Bolt driven open or kept open, or the door is open.
+ * @retval NRF_ERROR_BUSY          The bolt is moving.
+ * @retval NRF_ERROR_INVALID_STATE The motor driver reported a fault.
+ */
+ret_code_t lock_state_unlock(void);
+
+/**@brief State now. */
+lock_state_t lock_state_get(void);
+
+/**@brief Pass the events of lock_moto, from its handler. */
+void lock_state_on_moto_evt(lock_moto_evt_t evt);
+
+/**@brief Pass the debounced changes of the door contact. */
+void lock_state_on_door(bool closed);
+
+#endif
@@ -0,0 +1,276 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(MOTO_SENSE)
+#include "moto_sense.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#if defined(NRF51)
+#include "nrf_lpcomp.h"
+#else
+#include "nrf_saadc.h"
+#include "nrf_timer.h"
+#include "nrf_drv_ppi.h"
+#endif
+
+#if defined(NRF51)
+#if NRF_MODULE_ENABLED(LPCOMP)
+#error "moto_sense runs LPCOMP itself, set LPCOMP_ENABLED to 0"
+#endif
+#else
+#if NRF_MODULE_ENABLED(SAADC) || TIMER3_ENABLED
+#error "moto_sense runs SAADC and TIMER3 itself, set SAADC_ENABLED and TIMER3_ENABLED to 0"
+#endif
+#if !NRF_MODULE_ENABLED(PPI)
+#error "moto_sense needs PPI_ENABLED"
+#endif
+#endif
+#if NRF_MODULE_ENABLED(PROX_WAKE) && (PROX_WAKE_AIN == MOTO_SENSE_AIN)
+#error "moto_sense and prox_wake are on the same analog input"
+#endif
+
+#define BLANK_TICKS       APP_TIMER_TICKS(MOTO_SENSE_BLANK_MS, APP_TIMER_CONFIG_PRESCALER)
+
+#if !defined(NRF51)
+#define SAMPLE_TIMER      NRF_TIMER3
+#define FULL_SCALE_MV     3600UL    /**< Gain 1/6 of the 0.6 V reference. */
+#define RAW_MAX           1024UL    /**< 10 bit. */
+#define STALL_RAW         ((MOTO_SENSE_STALL_MV * RAW_MAX) / FULL_SCALE_MV)
+#define BUF_LEN           8
+#define SAMPLE_US         (1000000UL / MOTO_SENSE_RATE_HZ)
+
+STATIC_ASSERT(STALL_RAW < RAW_MAX);
+STATIC_ASSERT(SAMPLE_US <= UINT16_MAX);
+#endif
+
+APP_TIMER_DEF(m_blank_timer);
+
+static moto_sense_stall_handler_t m_handler;
+static volatile bool              m_running;
+#if !defined(NRF51)
+static nrf_saadc_value_t          m_buf[BUF_LEN];
+static nrf_ppi_channel_t          m_ppi_sample;
+static nrf_ppi_channel_t          m_ppi_restart;
+static int16_t                    m_peak;
+#endif
+
+
+static void stall(void)
+{
+    moto_sense_stop();
+    m_handler();
+}
+
+
+#if defined(NRF51)
+static void sense_on(void)
+{
+    nrf_lpcomp_config_t config = {(nrf_lpcomp_ref_t)MOTO_SENSE_LPCOMP_REF, NRF_LPCOMP_DETECT_UP};
+
+    nrf_lpcomp_configure(&config);
+    nrf_lpcomp_input_select((nrf_lpcomp_input_t)MOTO_SENSE_AIN);
+    nrf_lpcomp_enable();
+    nrf_lpcomp_task_trigger(NRF_LPCOMP_TASK_START);
+}
+
+
+static void sense_off(void)
+{
+    nrf_lpcomp_int_disable(LPCOMP_INTENCLR_UP_Msk);
+    nrf_lpcomp_task_trigger(NRF_LPCOMP_TASK_STOP);
+    nrf_lpcomp_disable();
+}
+
+
+/**@brief Listen to the comparator; true if the current is above already. */
+static bool sense_arm(void)
+{
+    nrf_lpcomp_event_clear(NRF_LPCOMP_EVENT_UP);
+    nrf_lpcomp_int_enable(LPCOMP_INTENSET_UP_Msk);
+    nrf_lpcomp_task_trigger(NRF_LPCOMP_TASK_SAMPLE);
+    return (nrf_lpcomp_result_get() != 0);
+}
+
+
+void LPCOMP_IRQHandler(void)
+{
+    if (nrf_lpcomp_event_check(NRF_LPCOMP_EVENT_UP))
+    {
+        nrf_lpcomp_event_clear(NRF_LPCOMP_EVENT_UP);
+        if (m_running)
+        {
+            stall();
+        }
+    }
+}
+#else
+static void sense_on(void)
+{
+    m_peak = 0;
+
+    nrf_saadc_resolution_set(NRF_SAADC_RESOLUTION_10BIT);
+    nrf_saadc_oversample_set(NRF_SAADC_OVERSAMPLE_DISABLED);
+    NRF_SAADC->CH[0].CONFIG = (SAADC_CH_CONFIG_RESP_Bypass     << SAADC_CH_CONFIG_RESP_Pos)
+                            | (SAADC_CH_CONFIG_RESN_Bypass     << SAADC_CH_CONFIG_RESN_Pos)
+                            | (SAADC_CH_CONFIG_GAIN_Gain1_6    << SAADC_CH_CONFIG_GAIN_Pos)
+                            | (SAADC_CH_CONFIG_REFSEL_Internal << SAADC_CH_CONFIG_REFSEL_Pos)
+                            | (SAADC_CH_CONFIG_TACQ_10us       << SAADC_CH_CONFIG_TACQ_Pos)
+                            | (SAADC_CH_CONFIG_MODE_SE         << SAADC_CH_CONFIG_MODE_Pos);
+    nrf_saadc_channel_input_set(0, (nrf_saadc_input_t)(NRF_SAADC_INPUT_AIN0 + MOTO_SENSE_AIN),
+                                NRF_SAADC_INPUT_DISABLED);
+    nrf_saadc_channel_limits_set(0, -(int16_t)RAW_MAX, (int16_t)STALL_RAW);
+    nrf_saadc_buffer_init(m_buf, BUF_LEN);
+
+    nrf_saadc_event_clear(NRF_SAADC_EVENT_END);
+    nrf_saadc_event_clear(NRF_SAADC_EVENT_STOPPED);
+    nrf_saadc_event_clear(NRF_SAADC_EVENT_CH0_LIMITH);
+    nrf_saadc_int_enable(NRF_SAADC_INT_END | NRF_SAADC_INT_STOPPED);
+    nrf_saadc_enable();
+    nrf_saadc_task_trigger(NRF_SAADC_TASK_START);
+
+    nrf_timer_task_trigger(SAMPLE_TIMER, NRF_TIMER_TASK_CLEAR);
+    UNUSED_RETURN_VALUE(nrf_drv_ppi_channel_enable(m_ppi_sample));
+    UNUSED_RETURN_VALUE(nrf_drv_ppi_channel_enable(m_ppi_restart));
+    nrf_timer_task_trigger(SAMPLE_TIMER, NRF_TIMER_TASK_START);
+}
+
+
+static void sense_off(void)
+{
+    nrf_timer_task_trigger(SAMPLE_TIMER, NRF_TIMER_TASK_STOP);
+    UNUSED_RETURN_VALUE(nrf_drv_ppi_channel_disable(m_ppi_sample));
+    UNUSED_RETURN_VALUE(nrf_drv_ppi_channel_disable(m_ppi_restart));
+    nrf_saadc_int_disable(NRF_SAADC_INT_CH0LIMITH | NRF_SAADC_INT_END);
+    // Switched off on STOPPED.
+    nrf_saadc_task_trigger(NRF_SAADC_TASK_STOP);
+}
+
+
+static bool sense_arm(void)
+{
+    nrf_saadc_event_clear(NRF_SAADC_EVENT_CH0_LIMITH);
+    nrf_saadc_int_enable(NRF_SAADC_INT_CH0LIMITH);
+    // The next sample above the limit raises the event; no need to look at this one.
+    return false;
+}
+
+
+void SAADC_IRQHandler(void)
+{
+    if (nrf_saadc_event_check(NRF_SAADC_EVENT_END))
+    {
+        nrf_saadc_event_clear(NRF_SAADC_EVENT_END);
+        for (uint32_t i = 0; i < BUF_LEN; i++)
+        {
+            m_peak = MAX(m_peak, m_buf[i]);
+        }
+    }
+    if (nrf_saadc_event_check(NRF_SAADC_EVENT_CH0_LIMITH))
+    {
+        nrf_saadc_event_clear(NRF_SAADC_EVENT_CH0_LIMITH);
+        if (m_running && nrf_saadc_int_enable_check(NRF_SAADC_INT_CH0LIMITH))
+        {
+            stall();
+        }
+    }
+    if (nrf_saadc_event_check(NRF_SAADC_EVENT_STOPPED))
+    {
+        nrf_saadc_event_clear(NRF_SAADC_EVENT_STOPPED);
+        if (!m_running)
+        {
+            nrf_saadc_disable();
+        }
+    }
+}
+#endif
+
+
+static void blank_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    if (m_running && sense_arm())
+    {
+        stall();
+    }
+}
+
+
+ret_code_t moto_sense_init(moto_sense_stall_handler_t handler)
+{
+    ret_code_t err_code;
+
+    m_handler = handler;
+    err_code  = app_timer_create(&m_blank_timer, APP_TIMER_MODE_SINGLE_SHOT, blank_timer_handler);
+    VERIFY_SUCCESS(err_code);
+
+#if defined(NRF51)
+    NVIC_ClearPendingIRQ(LPCOMP_IRQn);
+    NVIC_SetPriority(LPCOMP_IRQn, APP_IRQ_PRIORITY_LOW);
+    NVIC_EnableIRQ(LPCOMP_IRQn);
+#else
+    nrf_timer_mode_set(SAMPLE_TIMER, NRF_TIMER_MODE_TIMER);
+    nrf_timer_bit_width_set(SAMPLE_TIMER, NRF_TIMER_BIT_WIDTH_16);
+    nrf_timer_frequency_set(SAMPLE_TIMER, NRF_TIMER_FREQ_1MHz);
+    nrf_timer_cc_write(SAMPLE_TIMER, NRF_TIMER_CC_CHANNEL0, SAMPLE_US);
+    nrf_timer_shorts_enable(SAMPLE_TIMER, NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK);
+
+    err_code = nrf_drv_ppi_init();
+    if ((err_code != NRF_SUCCESS) && (err_code != NRF_ERROR_MODULE_ALREADY_INITIALIZED))
+    {
+        return err_code;
+    }
+    err_code = nrf_drv_ppi_channel_alloc(&m_ppi_sample);
+    VERIFY_SUCCESS(err_code);
+    err_code = nrf_drv_ppi_channel_alloc(&m_ppi_restart);
+    VERIFY_SUCCESS(err_code);
+    err_code = nrf_drv_ppi_channel_assign(m_ppi_sample,
+                   nrf_timer_event_address_get(SAMPLE_TIMER, NRF_TIMER_EVENT_COMPARE0),
+                   nrf_saadc_task_address_get(NRF_SAADC_TASK_SAMPLE));
+    VERIFY_SUCCESS(err_code);
+    // A full buffer starts over on the same RAM: only the limit and the peak are of interest.
+    err_code = nrf_drv_ppi_channel_assign(m_ppi_restart,
+                   nrf_saadc_event_address_get(NRF_SAADC_EVENT_END),
+                   nrf_saadc_task_address_get(NRF_SAADC_TASK_START));
+    VERIFY_SUCCESS(err_code);
+
+    NVIC_ClearPendingIRQ(SAADC_IRQn);
+    NVIC_SetPriority(SAADC_IRQn, APP_IRQ_PRIORITY_LOW);
+    NVIC_EnableIRQ(SAADC_IRQn);
+#endif
+    return NRF_SUCCESS;
+}
+
+
+void moto_sense_start(void)
+{
+    if (m_running)
+    {
+        return;
+    }
+    m_running = true;
+    sense_on();
+    UNUSED_RETURN_VALUE(app_timer_start(m_blank_timer, BLANK_TICKS, NULL));
+}
+
+
+void moto_sense_stop(void)
+{
+    if (!m_running)
+    {
+        return;
+    }
+    m_running = false;
+    UNUSED_RETURN_VALUE(app_timer_stop(m_blank_timer));
+    sense_off();
+}
+
+
+uint16_t moto_sense_peak_mv(void)
+{
+#if defined(NRF51)
+    return 0;
+#else
+    return (uint16_t)((MAX(m_peak, 0) * FULL_SCALE_MV) / RAW_MAX);
+#endif
+}
+
+#endif //NRF_MODULE_ENABLED(MOTO_SENSE)
@@ -0,0 +1,42 @@
+#ifndef _MOTO_SENSE_H_
+#define _MOTO_SENSE_H_
+
+#include <stdint.h>
+#include "sdk_errors.h"
+
+/* End of travel of the lock motor from its current, so the drive stops when the bolt does
+ * instead of after the worst case LOCK_MOTO_DRIVE_MS. The shunt of the bridge is on
+ * MOTO_SENSE_AIN:
+ *
+ *   nRF52     SAADC at MOTO_SENSE_RATE_HZ, each sample started by TIMER3 over PPI and the buffer
+ *             restarted by its END, also over PPI; the high limit of the channel at
+ *             MOTO_SENSE_STALL_MV is the comparator, so the CPU only sees the stall
+ *   nRF51     LPCOMP against MOTO_SENSE_LPCOMP_REF eighths of VDD, with its UP event; the ADC
+ *             has no PPI sampling worth the current on this part
+ *
+ * The inrush of the motor is above the stall level too: for MOTO_SENSE_BLANK_MS after the start
+ * the comparator is not listened to, and a current that is still above at the end of it counts
+ * as a stall at once. lock_moto keeps its drive time as the backstop, and NFAULT as the one for
+ * a shorted motor. Only while the motor is driven is anything powered. */
+
+/**@brief The motor current reached the stall level, in the SAADC, LPCOMP or app_timer
+ *        interrupt, all at APP_IRQ_PRIORITY_LOW. Sensing has stopped.
+ */
+typedef void (*moto_sense_stall_handler_t)(void);
+
+/**@brief Set up, nothing powered.
+ *
+ * @note Requires app_timer to be initialized.
+ */
+ret_code_t moto_sense_init(moto_sense_stall_handler_t handler);
+
+/**@brief The bridge has started to drive. From lock_moto. */
+void moto_sense_start(void);
+
+/**@brief The drive has ended; idempotent. From lock_moto. */
+void moto_sense_stop(void);
+
+/**@brief Highest sample of the last drive in mV, 0 where there are no samples (nRF51). */
+uint16_t moto_sense_peak_mv(void);
+
+#endif
@@ -0,0 +1,187 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(MX25_ASYNC)
+#include "mx25_async.h"
+#include "flash_io.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "nrf_queue.h"
+#include "radio_gap.h"
+
+#define MX25_PAGE_SIZE  256
+
+typedef enum
+{
+    JOB_ERASE,
+    JOB_PROGRAM,
+} job_type_t;
+
+typedef struct
+{
+    uint8_t            type;
+    uint16_t           len;
+    uint32_t           addr;
+    uint8_t const *    p_data;
+    mx25_job_handler_t handler;
+    void *             p_context;
+} mx25_job_t;
+
+NRF_QUEUE_DEF(mx25_job_t, m_job_queue, MX25_ASYNC_QUEUE_SIZE, NRF_QUEUE_MODE_NO_OVERFLOW);
+APP_TIMER_DEF(m_poll_timer);
+
+static mx25_job_t        m_job;            /**< Job in progress. */
+static bool              m_active;
+static volatile bool     m_poll_pending;   /**< A poll is waiting in the scheduler queue. */
+static uint32_t          m_polls_left;
+
+
+static void job_done(ret_code_t result);
+
+
+static void job_next(void)
+{
+    uint32_t interval_ms;
+
+    if (m_active || (nrf_queue_pop(&m_job_queue, &m_job) != NRF_SUCCESS))
+    {
+        return;
+    }
+    m_active = true;
+
+    if (m_job.type == JOB_ERASE)
+    {
+        mx25lxx_erase_sector_start(m_job.addr);
+        interval_ms = MX25_ASYNC_ERASE_POLL_MS;
+    }
+    else
+    {
+        mx25lxx_program_start(m_job.p_data, m_job.addr, m_job.len);
+        interval_ms = MX25_ASYNC_PROGRAM_POLL_MS;
+    }
+
+    m_polls_left = MX25_ASYNC_TIMEOUT_MS / interval_ms + 1;
+    if (app_timer_start(m_poll_timer,
+                        APP_TIMER_TICKS(interval_ms, APP_TIMER_CONFIG_PRESCALER),
+                        NULL) != NRF_SUCCESS)
+    {
+        // No timer: finish the job the blocking way rather than stalling the queue.
+        mx25lxx_wait_busy();
+        job_done(NRF_SUCCESS);
+    }
+}
+
+
+static void job_done(ret_code_t result)
+{
+    mx25_job_t job = m_job;
+
+    UNUSED_RETURN_VALUE(app_timer_stop(m_poll_timer));
+    m_active = false;
+
+    if (job.handler != NULL)
+    {
+        job.handler(result, job.p_context);
+    }
+    job_next();
+}
+
+
+static void poll_handler(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    m_poll_pending = false;
+    if (!m_active)
+    {
+        return;
+    }
+
+    if (!mx25lxx_is_busy())
+    {
+        job_done(NRF_SUCCESS);
+    }
+    else if (--m_polls_left == 0)
+    {
+        job_done(NRF_ERROR_TIMEOUT);
+    }
+}
+
+
+/**@brief RDSR goes over SPI, which only runs in thread mode: hand the poll to the scheduler. */
+static void poll_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    if (!m_poll_pending)
+    {
+        m_poll_pending = true;
+        if (radio_gap_run(RADIO_GAP_MX25, poll_handler) != NRF_SUCCESS)
+        {
+            m_poll_pending = false;
+        }
+    }
+}
+
+
+static ret_code_t job_queue(mx25_job_t const * p_job)
+{
+    if (nrf_queue_push(&m_job_queue, p_job) != NRF_SUCCESS)
+    {
+        return NRF_ERROR_BUSY;
+    }
+    job_next();
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t mx25_async_init(void)
+{
+    return app_timer_create(&m_poll_timer, APP_TIMER_MODE_REPEATED, poll_timer_handler);
+}
+
+
+ret_code_t mx25_erase_start(uint32_t sector_addr, mx25_job_handler_t handler, void * p_context)
+{
+    mx25_job_t job =
+    {
+        .type      = JOB_ERASE,
+        .addr      = sector_addr,
+        .handler   = handler,
+        .p_context = p_context,
+    };
+
+    return job_queue(&job);
+}
+
+
+ret_code_t mx25_program_start(uint8_t const *     p_data,
+                              uint32_t            flash_addr,
+                              uint16_t            len,
+                              mx25_job_handler_t  handler,
+                              void *              p_context)
+{
+    mx25_job_t job =
+    {
+        .type      = JOB_PROGRAM,
+        .len       = len,
+        .addr      = flash_addr,
+        .p_data    = p_data,
+        .handler   = handler,
+        .p_context = p_context,
+    };
+
+    if ((len == 0) || ((flash_addr % MX25_PAGE_SIZE) + len > MX25_PAGE_SIZE))
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+    return job_queue(&job);
+}
+
+
+bool mx25_async_busy(void)
+{
+    return m_active || !nrf_queue_is_empty(&m_job_queue);
+}
+
+#endif //NRF_MODULE_ENABLED(MX25_ASYNC)
@@ -0,0 +1,53 @@
+#ifndef _MX25_ASYNC_H_
+#define _MX25_ASYNC_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/**@brief Flash job completion handler.
+ *
+ * @details Called from the main loop (app_scheduler context).
+ *
+ * @param[in] result     NRF_SUCCESS, or NRF_ERROR_TIMEOUT if the chip stayed busy for
+ *                       MX25_ASYNC_TIMEOUT_MS.
+ * @param[in] p_context  Context pointer given when the job was queued.
+ */
+typedef void (*mx25_job_handler_t)(ret_code_t result, void * p_context);
+
+/**@brief Create the status poll timer.
+ *
+ * @note Requires app_timer and app_scheduler.
+ */
+ret_code_t mx25_async_init(void);
+
+/**@brief Queue a 4 KB sector erase.
+ *
+ * @details Jobs run one at a time in queue order. The command is sent when the job starts;
+ *          completion is found by reading the status register from an app_timer driven poll,
+ *          so the application keeps running for the 40-200 ms of the erase. Synchronous
+ *          functions of flash_io.c called meanwhile wait for the chip first.
+ *          Thread mode only.
+ *
+ * @retval NRF_SUCCESS     Job queued.
+ * @retval NRF_ERROR_BUSY  The job queue is full.
+ */
+ret_code_t mx25_erase_start(uint32_t sector_addr, mx25_job_handler_t handler, void * p_context);
+
+/**@brief Queue a page program.
+ *
+ * @details @p p_data is not copied and must stay valid until @p handler is called.
+ *
+ * @retval NRF_SUCCESS               Job queued.
+ * @retval NRF_ERROR_BUSY            The job queue is full.
+ * @retval NRF_ERROR_INVALID_LENGTH  The data crosses a 256-byte program page.
+ */
+ret_code_t mx25_program_start(uint8_t const *     p_data,
+                              uint32_t            flash_addr,
+                              uint16_t            len,
+                              mx25_job_handler_t  handler,
+                              void *              p_context);
+
+/**@brief Whether a job is running or queued. */
+bool mx25_async_busy(void);
+
+#endif
@@ -0,0 +1,109 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(MX25_HASH)
+#include "mx25_hash.h"
+#include "flash_io.h"
+#include "app_scheduler.h"
+#include "radio_gap.h"
+
+STATIC_ASSERT((MX25_HASH_CHUNK_SIZE % 64) == 0);
+
+/* Parts of 64 bytes are hashed straight from the buffers, without a copy into the context. */
+__ALIGN(4) static uint8_t m_buf[2][MX25_HASH_CHUNK_SIZE];
+
+static bool                m_active;
+static uint8_t             m_read_buf;    /**< Buffer of the read in flight. */
+static uint16_t            m_read_len;    /**< Length of the read in flight. */
+static uint32_t            m_next_addr;   /**< Address of the next read. */
+static uint32_t            m_read_left;   /**< Bytes not yet asked for. */
+static uint32_t            m_hash_left;   /**< Bytes not yet hashed. */
+static sha256_context_t *  mp_ctx;
+static mx25_hash_handler_t m_handler;
+static void *              mp_context;
+
+
+static void read_done(void * p_context);
+
+
+static void read_next(void)
+{
+    m_read_len   = (uint16_t) MIN(m_read_left, MX25_HASH_CHUNK_SIZE);
+    m_read_left -= m_read_len;
+    mx25lxx_read_start(m_buf[m_read_buf], m_next_addr, m_read_len, read_done, NULL);
+    m_next_addr += m_read_len;
+}
+
+
+/**@brief Start reading the next part into the other buffer, then hash the one that arrived. */
+static void chunk_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t const * p_data = m_buf[m_read_buf];
+    uint16_t        len    = m_read_len;
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    if (m_read_left > 0)
+    {
+        m_read_buf ^= 1;
+        read_next();
+    }
+
+    // Only fails for a NULL context, which mx25_hash_start() does not take.
+    UNUSED_RETURN_VALUE(sha256_update(mp_ctx, p_data, len));
+    m_hash_left -= len;
+
+    if (m_hash_left == 0)
+    {
+        m_active = false;
+        m_handler(NRF_SUCCESS, mp_context);
+    }
+}
+
+
+/**@brief SPI interrupt: hand the part to the main loop. */
+static void read_done(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    APP_ERROR_CHECK(radio_gap_run(RADIO_GAP_MX25, chunk_handler));
+}
+
+
+ret_code_t mx25_hash_start(uint32_t             flash_addr,
+                           uint32_t             len,
+                           sha256_context_t *   p_ctx,
+                           mx25_hash_handler_t  handler,
+                           void *               p_context)
+{
+    VERIFY_PARAM_NOT_NULL(p_ctx);
+    VERIFY_PARAM_NOT_NULL(handler);
+
+    if (len == 0)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+    if (m_active)
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    m_active    = true;
+    mp_ctx      = p_ctx;
+    m_handler   = handler;
+    mp_context  = p_context;
+    m_next_addr = flash_addr;
+    m_read_left = len;
+    m_hash_left = len;
+    m_read_buf  = 0;
+    read_next();
+
+    return NRF_SUCCESS;
+}
+
+
+bool mx25_hash_busy(void)
+{
+    return m_active;
+}
+
+#endif //NRF_MODULE_ENABLED(MX25_HASH)
@@ -0,0 +1,50 @@
+#ifndef __MX25_HASH_H__
+#define __MX25_HASH_H__
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "sha256.h"
+
+/**@brief SHA-256 of a region of the MX25L16, for checking signed data kept there.
+ *
+ * @details The region is read in MX25_HASH_CHUNK_SIZE parts into two buffers: while the SPI
+ *          interrupt fills one, the main loop hashes the other, one part per app_scheduler
+ *          event, so other events run in between. The digest goes into a context of the caller,
+ *          who can hash a header first and finishes with sha256_final(), e.g. for
+ *          ecc_p256_verify().
+ */
+
+/**@brief Hash completion handler, called from the main loop (app_scheduler context).
+ *
+ * @param[in] result     NRF_SUCCESS, the whole region was added to the hash.
+ * @param[in] p_context  Context pointer given to @ref mx25_hash_start.
+ */
+typedef void (*mx25_hash_handler_t)(ret_code_t result, void * p_context);
+
+/**@brief Start hashing a region.
+ *
+ * @details Thread mode only. Synchronous functions of flash_io.c called meanwhile wait for the
+ *          part being read.
+ *
+ * @param[in]     flash_addr  First byte of the region.
+ * @param[in]     len         Length of the region, not 0.
+ * @param[in,out] p_ctx       Hash started with sha256_init(); must stay valid until
+ *                            @p handler is called.
+ * @param[in]     handler     Called when done.
+ * @param[in]     p_context   Passed to @p handler.
+ *
+ * @retval NRF_SUCCESS               Started.
+ * @retval NRF_ERROR_BUSY            Another region is being hashed.
+ * @retval NRF_ERROR_NULL            @p p_ctx or @p handler is NULL.
+ * @retval NRF_ERROR_INVALID_LENGTH  @p len is 0.
+ */
+ret_code_t mx25_hash_start(uint32_t             flash_addr,
+                           uint32_t             len,
+                           sha256_context_t *   p_ctx,
+                           mx25_hash_handler_t  handler,
+                           void *               p_context);
+
+/**@brief Whether a region is being hashed. */
+bool mx25_hash_busy(void);
+
+#endif
@@ -0,0 +1,374 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(NRF_BLOCK_DEV_JOURNAL)
+#include "nrf_block_dev_journal.h"
+#include "flash_io.h"
+#include "app_scheduler.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(LOCK_JOURNAL)
+#error "nrf_block_dev_journal needs LOCK_JOURNAL_ENABLED"
+#endif
+
+#define JBD_BLOCK_SIZE          NRF_BLOCK_DEV_JOURNAL_BLOCK_SIZE
+#define JBD_CLUSTER_SIZE        4096        /**< One journal sector. */
+#define JBD_BLOCKS_PER_CLUSTER  (JBD_CLUSTER_SIZE / JBD_BLOCK_SIZE)
+#define JBD_FILE_SIZE           (LOCK_JOURNAL_SECTORS * JBD_CLUSTER_SIZE)
+
+#define JBD_BOOT_BLOCK          0
+#define JBD_FAT_BLOCK           1
+#define JBD_ROOT_BLOCK          2
+#define JBD_DATA_BLOCK          3           /**< First block of cluster 2, the file. */
+#define JBD_BLOCK_COUNT         (JBD_DATA_BLOCK + JBD_FILE_SIZE / JBD_BLOCK_SIZE)
+#define JBD_ROOT_ENTRIES        (JBD_BLOCK_SIZE / 32)
+#define JBD_READ_CHUNK          JBD_CLUSTER_SIZE
+
+#define FAT12_EOC               0xFFF
+#define FAT_DATE_1980_01_01     0x0021
+#define FAT_ATTR_READ_ONLY      0x01
+#define FAT_ATTR_VOLUME_ID      0x08
+
+// Two reserved entries and the chain of the file in the one FAT block.
+STATIC_ASSERT((2 + LOCK_JOURNAL_SECTORS) * 3 / 2 + 1 < JBD_BLOCK_SIZE);
+
+static const char m_label[11] = {'L','O','C','K',' ','J','R','N','L',' ',' '};
+static const char m_name[11]  = {'J','O','U','R','N','A','L',' ','B','I','N'};
+
+
+static void boot_fill(uint8_t * p_blk)
+{
+    static const uint8_t jump[3] = {0xEB, 0x3C, 0x90};
+
+    memcpy(&p_blk[0], jump, sizeof(jump));
+    memcpy(&p_blk[3], "LOCKJRNL", 8);
+    UNUSED_RETURN_VALUE(uint16_encode(JBD_BLOCK_SIZE, &p_blk[11]));
+    p_blk[13] = JBD_BLOCKS_PER_CLUSTER;
+    UNUSED_RETURN_VALUE(uint16_encode(JBD_FAT_BLOCK, &p_blk[14]));     // reserved blocks
+    p_blk[16] = 1;                                                      // FAT copies
+    UNUSED_RETURN_VALUE(uint16_encode(JBD_ROOT_ENTRIES, &p_blk[17]));
+    UNUSED_RETURN_VALUE(uint16_encode(JBD_BLOCK_COUNT, &p_blk[19]));
+    p_blk[21] = 0xF8;                                                   // fixed medium
+    UNUSED_RETURN_VALUE(uint16_encode(JBD_ROOT_BLOCK - JBD_FAT_BLOCK, &p_blk[22]));
+    UNUSED_RETURN_VALUE(uint16_encode(32, &p_blk[24]));                 // sectors per track
+    UNUSED_RETURN_VALUE(uint16_encode(1, &p_blk[26]));                  // heads
+    p_blk[36] = 0x80;
+    p_blk[38] = 0x29;                                                   // label and type follow
+    UNUSED_RETURN_VALUE(uint32_encode(LOCK_JOURNAL_FLASH_ADDR, &p_blk[39]));
+    memcpy(&p_blk[43], m_label, sizeof(m_label));
+    memcpy(&p_blk[54], "FAT12   ", 8);
+    p_blk[510] = 0x55;
+    p_blk[511] = 0xAA;
+}
+
+
+static void fat12_set(uint8_t * p_fat, uint32_t cluster, uint16_t value)
+{
+    uint8_t * p = &p_fat[cluster * 3 / 2];
+
+    if (cluster & 1)
+    {
+        p[0] = (p[0] & 0x0F) | (uint8_t)(value << 4);
+        p[1] = (uint8_t)(value >> 4);
+    }
+    else
+    {
+        p[0] = (uint8_t)value;
+        p[1] = (p[1] & 0xF0) | (uint8_t)(value >> 8);
+    }
+}
+
+
+static void fat_fill(uint8_t * p_blk)
+{
+    uint32_t last = 2 + LOCK_JOURNAL_SECTORS - 1;
+
+    fat12_set(p_blk, 0, 0xF00 | 0xF8);
+    fat12_set(p_blk, 1, FAT12_EOC);
+    for (uint32_t cluster = 2; cluster < last; cluster++)
+    {
+        fat12_set(p_blk, cluster, cluster + 1);
+    }
+    fat12_set(p_blk, last, FAT12_EOC);
+}
+
+
+static void root_fill(uint8_t * p_blk)
+{
+    uint8_t * p_file = &p_blk[32];
+
+    memcpy(&p_blk[0], m_label, sizeof(m_label));
+    p_blk[11] = FAT_ATTR_VOLUME_ID;
+
+    memcpy(&p_file[0], m_name, sizeof(m_name));
+    p_file[11] = FAT_ATTR_READ_ONLY;
+    UNUSED_RETURN_VALUE(uint16_encode(FAT_DATE_1980_01_01, &p_file[16]));  // created
+    UNUSED_RETURN_VALUE(uint16_encode(FAT_DATE_1980_01_01, &p_file[18]));  // accessed
+    UNUSED_RETURN_VALUE(uint16_encode(FAT_DATE_1980_01_01, &p_file[24]));  // written
+    UNUSED_RETURN_VALUE(uint16_encode(2, &p_file[26]));                    // first cluster
+    UNUSED_RETURN_VALUE(uint32_encode(JBD_FILE_SIZE, &p_file[28]));
+}
+
+
+static void meta_fill(uint32_t blk_id, uint8_t * p_blk)
+{
+    memset(p_blk, 0, JBD_BLOCK_SIZE);
+    switch (blk_id)
+    {
+        case JBD_BOOT_BLOCK:
+            boot_fill(p_blk);
+            break;
+
+        case JBD_FAT_BLOCK:
+            fat_fill(p_blk);
+            break;
+
+        default:
+            root_fill(p_blk);
+            break;
+    }
+}
+
+
+static void event_send(nrf_block_dev_journal_t const * p_jdev, nrf_block_dev_event_type_t type)
+{
+    nrf_block_dev_journal_work_t * p_work = p_jdev->p_work;
+
+    if (p_work->ev_handler)
+    {
+        const nrf_block_dev_event_t ev = {
+                type,
+                NRF_BLOCK_DEV_RESULT_SUCCESS,
+                (type == NRF_BLOCK_DEV_EVT_BLK_READ_DONE) ? &p_work->req : NULL,
+                p_work->p_context
+        };
+
+        p_work->ev_handler(&p_jdev->block_dev, &ev);
+    }
+}
+
+
+/**@brief Made-up blocks at the head of the request, then at most one flash chunk.
+ *
+ * @return Length of the chunk left to read at @p p_addr into @p pp_dst, 0 once done.
+ */
+static uint32_t read_next(nrf_block_dev_journal_work_t * p_work, uint8_t ** pp_dst, uint32_t * p_addr)
+{
+    nrf_block_req_t const * p_blk = &p_work->req;
+    uint32_t                blk;
+    uint32_t                count;
+
+    while ((p_work->blk_done < p_blk->blk_count) &&
+           (p_blk->blk_id + p_work->blk_done < JBD_DATA_BLOCK))
+    {
+        blk = p_blk->blk_id + p_work->blk_done;
+        meta_fill(blk, (uint8_t *)p_blk->p_buff + p_work->blk_done * JBD_BLOCK_SIZE);
+        p_work->blk_done++;
+    }
+
+    count = MIN(p_blk->blk_count - p_work->blk_done, JBD_READ_CHUNK / JBD_BLOCK_SIZE);
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    blk      = p_blk->blk_id + p_work->blk_done;
+    *pp_dst  = (uint8_t *)p_blk->p_buff + p_work->blk_done * JBD_BLOCK_SIZE;
+    *p_addr  = LOCK_JOURNAL_FLASH_ADDR + (blk - JBD_DATA_BLOCK) * JBD_BLOCK_SIZE;
+    p_work->blk_done += count;
+    return count * JBD_BLOCK_SIZE;
+}
+
+
+static void read_sched_handler(void * p_event_data, uint16_t event_size);
+
+
+static void read_spi_done(void * p_context)
+{
+    nrf_block_dev_journal_t const * p_jdev = p_context;
+
+    // The next chunk is started and the event sent in thread mode.
+    APP_ERROR_CHECK(app_sched_event_put(&p_jdev, sizeof(p_jdev), read_sched_handler));
+}
+
+
+static void read_sched_handler(void * p_event_data, uint16_t event_size)
+{
+    nrf_block_dev_journal_t const * p_jdev = *(nrf_block_dev_journal_t const **)p_event_data;
+    nrf_block_dev_journal_work_t *  p_work = p_jdev->p_work;
+    uint8_t *                       p_dst;
+    uint32_t                        addr;
+    uint32_t                        len;
+
+    UNUSED_PARAMETER(event_size);
+
+    len = read_next(p_work, &p_dst, &addr);
+    if (len != 0)
+    {
+        mx25lxx_read_start(p_dst, addr, len, read_spi_done, (void *)p_jdev);
+        return;
+    }
+
+    p_work->state = NRF_BLOCK_DEV_JOURNAL_STATE_IDLE;
+    event_send(p_jdev, NRF_BLOCK_DEV_EVT_BLK_READ_DONE);
+}
+
+
+static ret_code_t block_dev_journal_init(nrf_block_dev_t const * p_blk_dev,
+                                         nrf_block_dev_ev_handler ev_handler,
+                                         void const * p_context)
+{
+    ASSERT(p_blk_dev);
+    nrf_block_dev_journal_t const * p_jdev =
+                                    CONTAINER_OF(p_blk_dev, nrf_block_dev_journal_t, block_dev);
+    nrf_block_dev_journal_work_t *  p_work = p_jdev->p_work;
+
+    if (p_work->state != NRF_BLOCK_DEV_JOURNAL_STATE_DISABLED)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    p_work->geometry.blk_size  = JBD_BLOCK_SIZE;
+    p_work->geometry.blk_count = JBD_BLOCK_COUNT;
+    p_work->p_context  = p_context;
+    p_work->ev_handler = ev_handler;
+    p_work->state      = NRF_BLOCK_DEV_JOURNAL_STATE_IDLE;
+
+    event_send(p_jdev, NRF_BLOCK_DEV_EVT_INIT);
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t block_dev_journal_uninit(nrf_block_dev_t const * p_blk_dev)
+{
+    ASSERT(p_blk_dev);
+    nrf_block_dev_journal_t const * p_jdev =
+                                    CONTAINER_OF(p_blk_dev, nrf_block_dev_journal_t, block_dev);
+    nrf_block_dev_journal_work_t *  p_work = p_jdev->p_work;
+
+    if (p_work->state == NRF_BLOCK_DEV_JOURNAL_STATE_READ_EXEC)
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    event_send(p_jdev, NRF_BLOCK_DEV_EVT_UNINIT);
+    memset(p_work, 0, sizeof(nrf_block_dev_journal_work_t));
+    p_work->state = NRF_BLOCK_DEV_JOURNAL_STATE_DISABLED;
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t block_dev_journal_read_req(nrf_block_dev_t const * p_blk_dev,
+                                             nrf_block_req_t const * p_blk)
+{
+    ASSERT(p_blk_dev);
+    ASSERT(p_blk);
+    nrf_block_dev_journal_t const * p_jdev =
+                                    CONTAINER_OF(p_blk_dev, nrf_block_dev_journal_t, block_dev);
+    nrf_block_dev_journal_work_t *  p_work = p_jdev->p_work;
+    uint8_t *                       p_dst;
+    uint32_t                        addr;
+    uint32_t                        len;
+
+    if (p_work->state != NRF_BLOCK_DEV_JOURNAL_STATE_IDLE)
+    {
+        /* Previous asynchronous operation in progress*/
+        return NRF_ERROR_BUSY;
+    }
+
+    if ((p_blk->blk_count == 0) || (p_blk->blk_id >= JBD_BLOCK_COUNT) ||
+        (p_blk->blk_count > JBD_BLOCK_COUNT - p_blk->blk_id))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    p_work->req      = *p_blk;
+    p_work->blk_done = 0;
+
+    if (p_work->ev_handler)
+    {
+        // Called from the USB interrupt by the MSC class; the flash is read in thread mode.
+        p_work->state = NRF_BLOCK_DEV_JOURNAL_STATE_READ_EXEC;
+        if (app_sched_event_put(&p_jdev, sizeof(p_jdev), read_sched_handler) != NRF_SUCCESS)
+        {
+            p_work->state = NRF_BLOCK_DEV_JOURNAL_STATE_IDLE;
+            return NRF_ERROR_NO_MEM;
+        }
+        return NRF_SUCCESS;
+    }
+
+    while ((len = read_next(p_work, &p_dst, &addr)) != 0)
+    {
+        read_mx25l16_buf(p_dst, addr, len);
+    }
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t block_dev_journal_write_req(nrf_block_dev_t const * p_blk_dev,
+                                              nrf_block_req_t const * p_blk)
+{
+    UNUSED_PARAMETER(p_blk_dev);
+    UNUSED_PARAMETER(p_blk);
+
+    // The journal is written by lock_journal only.
+    return NRF_ERROR_FORBIDDEN;
+}
+
+
+static ret_code_t block_dev_journal_ioctl(nrf_block_dev_t const * p_blk_dev,
+                                          nrf_block_dev_ioctl_req_t req,
+                                          void * p_data)
+{
+    ASSERT(p_blk_dev);
+    nrf_block_dev_journal_t const * p_jdev =
+                                    CONTAINER_OF(p_blk_dev, nrf_block_dev_journal_t, block_dev);
+
+    switch (req)
+    {
+        case NRF_BLOCK_DEV_IOCTL_REQ_CACHE_FLUSH:
+        {
+            bool * p_flushing = p_data;
+            if (p_flushing)
+            {
+                *p_flushing = false;
+            }
+            return NRF_SUCCESS;
+        }
+        case NRF_BLOCK_DEV_IOCTL_REQ_INFO_STRINGS:
+        {
+            if (p_data == NULL)
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+
+            nrf_block_dev_info_strings_t const * * pp_strings = p_data;
+            *pp_strings = &p_jdev->info_strings;
+            return NRF_SUCCESS;
+        }
+        default:
+            break;
+    }
+
+    return NRF_ERROR_NOT_SUPPORTED;
+}
+
+
+static nrf_block_dev_geometry_t const * block_dev_journal_geometry(nrf_block_dev_t const * p_blk_dev)
+{
+    ASSERT(p_blk_dev);
+    nrf_block_dev_journal_t const * p_jdev =
+                                    CONTAINER_OF(p_blk_dev, nrf_block_dev_journal_t, block_dev);
+
+    return &p_jdev->p_work->geometry;
+}
+
+
+const nrf_block_dev_ops_t nrf_block_device_journal_ops = {
+        .init = block_dev_journal_init,
+        .uninit = block_dev_journal_uninit,
+        .read_req = block_dev_journal_read_req,
+        .write_req = block_dev_journal_write_req,
+        .ioctl = block_dev_journal_ioctl,
+        .geometry = block_dev_journal_geometry,
+};
+
+#endif //NRF_MODULE_ENABLED(NRF_BLOCK_DEV_JOURNAL)
@@ -0,0 +1,80 @@
+#ifndef _NRF_BLOCK_DEV_JOURNAL_H_
+#define _NRF_BLOCK_DEV_JOURNAL_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "nrf_block_dev.h"
+
+/**@file
+ *
+ * @defgroup nrf_block_dev_journal Journal as a read-only FAT12 volume
+ * @ingroup nrf_block_dev
+ * @{
+ *
+ * @brief Block device that shows the lock_journal area of the MX25L16 as one file,
+ *        JOURNAL.BIN, on a FAT12 volume, for USB mass storage.
+ *
+ * @details The boot sector, the FAT and the root directory are made up on the fly; the file
+ *          is the journal window itself, one 4 KB cluster per journal sector, so reads of
+ *          its blocks go from the flash straight into the buffer of the request. The file
+ *          holds the raw ring: each sector starts with its number and the sequence number
+ *          and time of its first record, the records are compressed as lock_journal.h
+ *          describes, and the oldest sector follows the one with the head.
+ *
+ *          With an event handler, reads start from the app_scheduler and the data comes in
+ *          from the SPI interrupt (mx25lxx_read_start()); NRF_BLOCK_DEV_EVT_BLK_READ_DONE is
+ *          sent from the app_scheduler. Without one, reads block. Writes are refused.
+ */
+
+/**@brief Journal volume operations. */
+extern const nrf_block_dev_ops_t nrf_block_device_journal_ops;
+
+#define NRF_BLOCK_DEV_JOURNAL_BLOCK_SIZE  512
+
+/**@brief Internal block device state. */
+typedef enum {
+    NRF_BLOCK_DEV_JOURNAL_STATE_DISABLED = 0,   /**< Not initialized. */
+    NRF_BLOCK_DEV_JOURNAL_STATE_IDLE,           /**< Ready for a request. */
+    NRF_BLOCK_DEV_JOURNAL_STATE_READ_EXEC,      /**< Read queued or on the bus. */
+} nrf_block_dev_journal_state_t;
+
+/**@brief Work structure of the journal volume. */
+typedef struct {
+    volatile nrf_block_dev_journal_state_t state;   //!< Block device state
+
+    nrf_block_dev_geometry_t geometry;              //!< Block device geometry
+    nrf_block_dev_ev_handler ev_handler;            //!< Block device event handler
+    void const *             p_context;             //!< Context handle passed to event handler
+    nrf_block_req_t          req;                   //!< Block READ request being served
+    uint32_t                 blk_done;              //!< Blocks of the request already read
+} nrf_block_dev_journal_work_t;
+
+/**@brief Journal volume. */
+typedef struct {
+    nrf_block_dev_t                block_dev;       //!< Block device
+    nrf_block_dev_info_strings_t   info_strings;    //!< Block device information strings
+    nrf_block_dev_journal_work_t * p_work;          //!< Block device work structure
+} nrf_block_dev_journal_t;
+
+/**@brief Defines the journal volume, LOCK_JOURNAL_SECTORS at LOCK_JOURNAL_FLASH_ADDR.
+ *
+ * @param name    Instance name
+ * @param info    Info strings @ref NFR_BLOCK_DEV_INFO_CONFIG
+ */
+#define NRF_BLOCK_DEV_JOURNAL_DEFINE(name, info)                     \
+    static nrf_block_dev_journal_work_t CONCAT_2(name, _work);       \
+    static const nrf_block_dev_journal_t name = {                    \
+            .block_dev = { .p_ops = &nrf_block_device_journal_ops }, \
+            .info_strings = BRACKET_EXTRACT(info),                   \
+            .p_work = &CONCAT_2(name, _work),                        \
+    }
+
+/**@brief Returns block device API handle from the journal volume. */
+static inline nrf_block_dev_t const *
+nrf_block_dev_journal_ops_get(nrf_block_dev_journal_t const * p_blk_journal)
+{
+    return &p_blk_journal->block_dev;
+}
+
+/** @} */
+
+#endif
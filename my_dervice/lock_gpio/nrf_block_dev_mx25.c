@@ -0,0 +1,548 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(NRF_BLOCK_DEV_MX25)
+#include "nrf_block_dev_mx25.h"
+#include "flash_io.h"
+#include "mx25_async.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(MX25_ASYNC)
+#error "nrf_block_dev_mx25 needs MX25_ASYNC_ENABLED"
+#endif
+
+#define MX25_FLASH_SIZE            0x200000   /**< MX25L16: 2 MB. */
+#define BD_PAGES_PER_ERASEUNIT     (NRF_BLOCK_DEV_MX25_ERASE_UNIT_SIZE / NRF_BLOCK_DEV_MX25_PAGE_SIZE)
+#define BD_ERASE_UNIT_INVALID_ID   0xFFFFFFFF /**< Invalid erase unit number*/
+#define BD_READ_CHUNK              NRF_BLOCK_DEV_MX25_ERASE_UNIT_SIZE
+
+STATIC_ASSERT(BD_PAGES_PER_ERASEUNIT <= 16);
+
+#define BD_BLOCK_TO_ERASEUNIT(blk_id, blk_size)   \
+    (((blk_id) * (blk_size)) / NRF_BLOCK_DEV_MX25_ERASE_UNIT_SIZE)
+
+#define BD_BLOCKS_PER_ERASEUNIT(blk_size)         \
+    (NRF_BLOCK_DEV_MX25_ERASE_UNIT_SIZE / (blk_size))
+
+
+static uint32_t eunit_addr(nrf_block_dev_mx25_t const * p_mx25_dev)
+{
+    return p_mx25_dev->mx25_bdev_config.flash_addr +
+           p_mx25_dev->p_work->erase_unit_idx * NRF_BLOCK_DEV_MX25_ERASE_UNIT_SIZE;
+}
+
+
+static bool page_blank(uint8_t const * p_page)
+{
+    for (uint16_t i = 0; i < NRF_BLOCK_DEV_MX25_PAGE_SIZE; i++)
+    {
+        if (p_page[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**@brief Copy new data into the erase unit buffer and note what it takes to write it.
+ *
+ * @details A page that changes is marked dirty. Programming can only clear bits, so the unit
+ *          needs an erase only if some new byte has a 1 where the old one has a 0.
+ */
+static void eunit_update(nrf_block_dev_mx25_work_t * p_work,
+                         size_t                      off,
+                         uint8_t const *             p_src,
+                         size_t                      len)
+{
+    uint8_t * p_dst = p_work->p_erase_unit_buff + off;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (p_dst[i] != p_src[i])
+        {
+            if ((p_dst[i] & p_src[i]) != p_src[i])
+            {
+                p_work->erase_required = true;
+            }
+            p_work->dirty_pages |= 1u << ((off + i) / NRF_BLOCK_DEV_MX25_PAGE_SIZE);
+            p_dst[i] = p_src[i];
+        }
+    }
+}
+
+
+/**@brief Move the blocks of the request that fall in the buffered erase unit into the buffer. */
+static void eunit_fill(nrf_block_dev_mx25_work_t * p_work)
+{
+    nrf_block_req_t * p_blk_left = &p_work->left_req;
+    uint32_t          blk_size   = p_work->geometry.blk_size;
+
+    size_t blk = p_blk_left->blk_id % BD_BLOCKS_PER_ERASEUNIT(blk_size);
+    size_t cnt = BD_BLOCKS_PER_ERASEUNIT(blk_size) - blk;
+
+    if (cnt > p_blk_left->blk_count)
+    {
+        cnt = p_blk_left->blk_count;
+    }
+
+    eunit_update(p_work, blk * blk_size, p_blk_left->p_buff, cnt * blk_size);
+
+    p_blk_left->blk_count -= cnt;
+    p_blk_left->blk_id += cnt;
+    p_blk_left->p_buff = (uint8_t *)p_blk_left->p_buff + cnt * blk_size;
+}
+
+
+static void job_handler(ret_code_t result, void * p_context);
+
+
+/**@brief Start the next erase or page program of the buffered erase unit.
+ *
+ * @param[in]  blocking  Run the operation to completion instead of queueing a job.
+ * @param[out] p_queued  Set when a job was queued and the caller must wait for its handler.
+ */
+static ret_code_t eunit_program_step(nrf_block_dev_mx25_t const * p_mx25_dev,
+                                     bool                         blocking,
+                                     bool *                       p_queued)
+{
+    nrf_block_dev_mx25_work_t * p_work = p_mx25_dev->p_work;
+    uint32_t                    addr   = eunit_addr(p_mx25_dev);
+
+    *p_queued = false;
+
+    if (p_work->erase_required)
+    {
+        // After the erase only pages holding data have to be programmed.
+        p_work->erase_required = false;
+        p_work->dirty_pages    = 0;
+        for (uint8_t page = 0; page < BD_PAGES_PER_ERASEUNIT; page++)
+        {
+            if (!page_blank(p_work->p_erase_unit_buff + page * NRF_BLOCK_DEV_MX25_PAGE_SIZE))
+            {
+                p_work->dirty_pages |= 1u << page;
+            }
+        }
+
+        if (blocking)
+        {
+            mx25lxx_erase_sector(addr);
+            return NRF_SUCCESS;
+        }
+        *p_queued = true;
+        return mx25_erase_start(addr, job_handler, (void *)p_mx25_dev);
+    }
+
+    uint32_t        page   = __CLZ(__RBIT(p_work->dirty_pages));
+    uint8_t const * p_page = p_work->p_erase_unit_buff + page * NRF_BLOCK_DEV_MX25_PAGE_SIZE;
+
+    p_work->dirty_pages &= ~(1u << page);
+    addr += page * NRF_BLOCK_DEV_MX25_PAGE_SIZE;
+
+    if (blocking)
+    {
+        mx25lxx_program_start(p_page, addr, NRF_BLOCK_DEV_MX25_PAGE_SIZE);
+        mx25lxx_wait_busy();
+        return NRF_SUCCESS;
+    }
+    *p_queued = true;
+    return mx25_program_start(p_page, addr, NRF_BLOCK_DEV_MX25_PAGE_SIZE,
+                              job_handler, (void *)p_mx25_dev);
+}
+
+
+static bool eunit_dirty(nrf_block_dev_mx25_work_t const * p_work)
+{
+    return p_work->erase_required || (p_work->dirty_pages != 0);
+}
+
+
+/**@brief Write the buffered erase unit back with blocking flash_io calls. */
+static void eunit_flush(nrf_block_dev_mx25_t const * p_mx25_dev)
+{
+    bool queued;
+
+    while (eunit_dirty(p_mx25_dev->p_work))
+    {
+        UNUSED_RETURN_VALUE(eunit_program_step(p_mx25_dev, true, &queued));
+    }
+}
+
+
+/**@brief Drop the buffered erase unit after a failed write; it no longer matches the flash. */
+static void eunit_discard(nrf_block_dev_mx25_work_t * p_work)
+{
+    p_work->erase_unit_idx = BD_ERASE_UNIT_INVALID_ID;
+    p_work->erase_required = false;
+    p_work->dirty_pages    = 0;
+}
+
+
+static void write_done(nrf_block_dev_mx25_t const * p_mx25_dev, nrf_block_dev_result_t result)
+{
+    nrf_block_dev_mx25_work_t * p_work = p_mx25_dev->p_work;
+
+    if (result != NRF_BLOCK_DEV_RESULT_SUCCESS)
+    {
+        eunit_discard(p_work);
+    }
+
+    p_work->state = NRF_BLOCK_DEV_MX25_STATE_IDLE;
+    if (p_work->ev_handler)
+    {
+        const nrf_block_dev_event_t ev = {
+                NRF_BLOCK_DEV_EVT_BLK_WRITE_DONE,
+                result,
+                &p_work->req,
+                p_work->p_context
+        };
+
+        p_work->ev_handler(&p_mx25_dev->block_dev, &ev);
+    }
+}
+
+
+/**@brief Advance a write request until a job has to be waited for or the request is done.
+ *
+ * @details In write-back mode the buffered unit is only written when the request moves on to
+ *          another erase unit, so repeated writes to the same blocks (FAT, directory) cost
+ *          flash cycles only once.
+ *
+ * @retval NRF_SUCCESS  Job queued, or request complete and WRITE_DONE sent.
+ */
+static ret_code_t write_continue(nrf_block_dev_mx25_t const * p_mx25_dev)
+{
+    nrf_block_dev_mx25_work_t * p_work     = p_mx25_dev->p_work;
+    nrf_block_req_t *           p_blk_left = &p_work->left_req;
+    bool                        blocking   = (p_work->ev_handler == NULL);
+
+    for (;;)
+    {
+        uint32_t eunit = BD_BLOCK_TO_ERASEUNIT(p_blk_left->blk_id, p_work->geometry.blk_size);
+        bool     switch_unit = (p_blk_left->blk_count != 0) && (eunit != p_work->erase_unit_idx);
+
+        if (eunit_dirty(p_work) && (!p_work->writeback_mode || switch_unit))
+        {
+            bool       queued;
+            ret_code_t ret = eunit_program_step(p_mx25_dev, blocking, &queued);
+
+            if (ret != NRF_SUCCESS)
+            {
+                eunit_discard(p_work);
+                return ret;
+            }
+            if (queued)
+            {
+                return NRF_SUCCESS;
+            }
+            continue;
+        }
+
+        if (p_blk_left->blk_count == 0)
+        {
+            write_done(p_mx25_dev, NRF_BLOCK_DEV_RESULT_SUCCESS);
+            return NRF_SUCCESS;
+        }
+
+        if (switch_unit)
+        {
+            p_work->erase_unit_idx = eunit;
+            read_mx25l16_buf(p_work->p_erase_unit_buff,
+                             eunit_addr(p_mx25_dev),
+                             NRF_BLOCK_DEV_MX25_ERASE_UNIT_SIZE);
+        }
+
+        eunit_fill(p_work);
+    }
+}
+
+
+static void job_handler(ret_code_t result, void * p_context)
+{
+    nrf_block_dev_mx25_t const * p_mx25_dev = p_context;
+
+    if (p_mx25_dev->p_work->state != NRF_BLOCK_DEV_MX25_STATE_WRITE_EXEC)
+    {
+        return;
+    }
+
+    if (result != NRF_SUCCESS)
+    {
+        write_done(p_mx25_dev, (result == NRF_ERROR_TIMEOUT) ? NRF_BLOCK_DEV_RESULT_TIMEOUT :
+                                                              NRF_BLOCK_DEV_RESULT_IO_ERROR);
+        return;
+    }
+
+    if (write_continue(p_mx25_dev) != NRF_SUCCESS)
+    {
+        write_done(p_mx25_dev, NRF_BLOCK_DEV_RESULT_IO_ERROR);
+    }
+}
+
+
+static bool request_valid(nrf_block_dev_mx25_work_t const * p_work, nrf_block_req_t const * p_blk)
+{
+    return (p_blk->blk_count != 0) &&
+           (p_blk->blk_id < p_work->geometry.blk_count) &&
+           (p_blk->blk_count <= p_work->geometry.blk_count - p_blk->blk_id);
+}
+
+
+static ret_code_t block_dev_mx25_init(nrf_block_dev_t const * p_blk_dev,
+                                      nrf_block_dev_ev_handler ev_handler,
+                                      void const * p_context)
+{
+    ASSERT(p_blk_dev);
+    nrf_block_dev_mx25_t const *        p_mx25_dev =
+                                        CONTAINER_OF(p_blk_dev, nrf_block_dev_mx25_t, block_dev);
+    nrf_block_dev_mx25_work_t *         p_work = p_mx25_dev->p_work;
+    nrf_block_dev_mx25_config_t const * p_cfg  = &p_mx25_dev->mx25_bdev_config;
+
+    if ((p_cfg->block_size % NRF_BLOCK_DEV_MX25_PAGE_SIZE) ||
+        (NRF_BLOCK_DEV_MX25_ERASE_UNIT_SIZE % p_cfg->block_size))
+    {
+        /*Unsupported block size*/
+        return NRF_ERROR_NOT_SUPPORTED;
+    }
+
+    if ((p_cfg->flash_addr % NRF_BLOCK_DEV_MX25_ERASE_UNIT_SIZE) ||
+        (p_cfg->flash_size % NRF_BLOCK_DEV_MX25_ERASE_UNIT_SIZE) ||
+        (p_cfg->flash_size == 0) ||
+        (p_cfg->flash_addr + p_cfg->flash_size > MX25_FLASH_SIZE))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    if (p_work->state != NRF_BLOCK_DEV_MX25_STATE_DISABLED)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    p_work->geometry.blk_size  = p_cfg->block_size;
+    p_work->geometry.blk_count = p_cfg->flash_size / p_cfg->block_size;
+    p_work->p_context  = p_context;
+    p_work->ev_handler = ev_handler;
+
+    eunit_discard(p_work);
+    p_work->writeback_mode = (p_cfg->flags & NRF_BLOCK_DEV_MX25_FLAG_CACHE_WRITEBACK) != 0;
+    p_work->state = NRF_BLOCK_DEV_MX25_STATE_IDLE;
+
+    if (p_work->ev_handler)
+    {
+        const nrf_block_dev_event_t ev = {
+                NRF_BLOCK_DEV_EVT_INIT,
+                NRF_BLOCK_DEV_RESULT_SUCCESS,
+                NULL,
+                p_work->p_context
+        };
+
+        p_work->ev_handler(p_blk_dev, &ev);
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t block_dev_mx25_uninit(nrf_block_dev_t const * p_blk_dev)
+{
+    ASSERT(p_blk_dev);
+    nrf_block_dev_mx25_t const * p_mx25_dev =
+                                 CONTAINER_OF(p_blk_dev, nrf_block_dev_mx25_t, block_dev);
+    nrf_block_dev_mx25_work_t *  p_work = p_mx25_dev->p_work;
+
+    if (p_work->state != NRF_BLOCK_DEV_MX25_STATE_IDLE)
+    {
+        /* Previous asynchronous operation in progress*/
+        return NRF_ERROR_BUSY;
+    }
+
+    eunit_flush(p_mx25_dev);
+
+    if (p_work->ev_handler)
+    {
+        const nrf_block_dev_event_t ev = {
+                NRF_BLOCK_DEV_EVT_UNINIT,
+                NRF_BLOCK_DEV_RESULT_SUCCESS,
+                NULL,
+                p_work->p_context
+        };
+
+        p_work->ev_handler(p_blk_dev, &ev);
+    }
+
+    memset(p_work, 0, sizeof(nrf_block_dev_mx25_work_t));
+    p_work->state = NRF_BLOCK_DEV_MX25_STATE_DISABLED;
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t block_dev_mx25_read_req(nrf_block_dev_t const * p_blk_dev,
+                                          nrf_block_req_t const * p_blk)
+{
+    ASSERT(p_blk_dev);
+    ASSERT(p_blk);
+    nrf_block_dev_mx25_t const * p_mx25_dev =
+                                 CONTAINER_OF(p_blk_dev, nrf_block_dev_mx25_t, block_dev);
+    nrf_block_dev_mx25_work_t *  p_work = p_mx25_dev->p_work;
+    uint32_t                     blk_size = p_work->geometry.blk_size;
+
+    if (p_work->state != NRF_BLOCK_DEV_MX25_STATE_IDLE)
+    {
+        /* Previous asynchronous operation in progress*/
+        return NRF_ERROR_BUSY;
+    }
+
+    if (!request_valid(p_work, p_blk))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    p_work->req = *p_blk;
+
+    uint8_t * p_dst = p_blk->p_buff;
+    uint32_t  addr  = p_mx25_dev->mx25_bdev_config.flash_addr + p_blk->blk_id * blk_size;
+    uint32_t  left  = p_blk->blk_count * blk_size;
+
+    while (left)
+    {
+        uint32_t chunk = MIN(left, BD_READ_CHUNK);
+
+        read_mx25l16_buf(p_dst, addr, chunk);
+        p_dst += chunk;
+        addr  += chunk;
+        left  -= chunk;
+    }
+
+    /*In write-back mode the buffered erase unit may be newer than the flash*/
+    if (eunit_dirty(p_work))
+    {
+        for (uint32_t n = 0; n < p_blk->blk_count; n++)
+        {
+            uint32_t blk = p_blk->blk_id + n;
+
+            if (BD_BLOCK_TO_ERASEUNIT(blk, blk_size) == p_work->erase_unit_idx)
+            {
+                memcpy((uint8_t *)p_blk->p_buff + n * blk_size,
+                       p_work->p_erase_unit_buff +
+                       (blk % BD_BLOCKS_PER_ERASEUNIT(blk_size)) * blk_size,
+                       blk_size);
+            }
+        }
+    }
+
+    if (p_work->ev_handler)
+    {
+        const nrf_block_dev_event_t ev = {
+                NRF_BLOCK_DEV_EVT_BLK_READ_DONE,
+                NRF_BLOCK_DEV_RESULT_SUCCESS,
+                &p_work->req,
+                p_work->p_context
+        };
+
+        p_work->ev_handler(p_blk_dev, &ev);
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t block_dev_mx25_write_req(nrf_block_dev_t const * p_blk_dev,
+                                           nrf_block_req_t const * p_blk)
+{
+    ASSERT(p_blk_dev);
+    ASSERT(p_blk);
+    nrf_block_dev_mx25_t const * p_mx25_dev =
+                                 CONTAINER_OF(p_blk_dev, nrf_block_dev_mx25_t, block_dev);
+    nrf_block_dev_mx25_work_t *  p_work = p_mx25_dev->p_work;
+
+    if (p_work->state != NRF_BLOCK_DEV_MX25_STATE_IDLE)
+    {
+        /* Previous asynchronous operation in progress*/
+        return NRF_ERROR_BUSY;
+    }
+
+    if (!request_valid(p_work, p_blk))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    p_work->req      = *p_blk;
+    p_work->left_req = *p_blk;
+    p_work->state    = NRF_BLOCK_DEV_MX25_STATE_WRITE_EXEC;
+
+    ret_code_t ret = write_continue(p_mx25_dev);
+    if (ret != NRF_SUCCESS)
+    {
+        p_work->state = NRF_BLOCK_DEV_MX25_STATE_IDLE;
+    }
+
+    return ret;
+}
+
+
+static ret_code_t block_dev_mx25_ioctl(nrf_block_dev_t const * p_blk_dev,
+                                       nrf_block_dev_ioctl_req_t req,
+                                       void * p_data)
+{
+    ASSERT(p_blk_dev);
+    nrf_block_dev_mx25_t const * p_mx25_dev =
+                                 CONTAINER_OF(p_blk_dev, nrf_block_dev_mx25_t, block_dev);
+    nrf_block_dev_mx25_work_t *  p_work = p_mx25_dev->p_work;
+
+    switch (req)
+    {
+        case NRF_BLOCK_DEV_IOCTL_REQ_CACHE_FLUSH:
+        {
+            bool * p_flushing = p_data;
+            if (p_work->state != NRF_BLOCK_DEV_MX25_STATE_IDLE)
+            {
+                return NRF_ERROR_BUSY;
+            }
+
+            /* Blocking, so callers that spin on p_flushing (diskio CTRL_SYNC) never wait on
+             * scheduler events. */
+            eunit_flush(p_mx25_dev);
+            if (p_flushing)
+            {
+                *p_flushing = false;
+            }
+
+            return NRF_SUCCESS;
+        }
+        case NRF_BLOCK_DEV_IOCTL_REQ_INFO_STRINGS:
+        {
+            if (p_data == NULL)
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+
+            nrf_block_dev_info_strings_t const * * pp_strings = p_data;
+            *pp_strings = &p_mx25_dev->info_strings;
+            return NRF_SUCCESS;
+        }
+        default:
+            break;
+    }
+
+    return NRF_ERROR_NOT_SUPPORTED;
+}
+
+
+static nrf_block_dev_geometry_t const * block_dev_mx25_geometry(nrf_block_dev_t const * p_blk_dev)
+{
+    ASSERT(p_blk_dev);
+    nrf_block_dev_mx25_t const * p_mx25_dev =
+                                 CONTAINER_OF(p_blk_dev, nrf_block_dev_mx25_t, block_dev);
+
+    return &p_mx25_dev->p_work->geometry;
+}
+
+
+const nrf_block_dev_ops_t nrf_block_device_mx25_ops = {
+        .init = block_dev_mx25_init,
+        .uninit = block_dev_mx25_uninit,
+        .read_req = block_dev_mx25_read_req,
+        .write_req = block_dev_mx25_write_req,
+        .ioctl = block_dev_mx25_ioctl,
+        .geometry = block_dev_mx25_geometry,
+};
+
+#endif //NRF_MODULE_ENABLED(NRF_BLOCK_DEV_MX25)
@@ -0,0 +1,121 @@
+#ifndef _NRF_BLOCK_DEV_MX25_H_
+#define _NRF_BLOCK_DEV_MX25_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "nrf_block_dev.h"
+
+/**@file
+ *
+ * @defgroup nrf_block_dev_mx25 MX25L16 SPI NOR implementation
+ * @ingroup nrf_block_dev
+ * @{
+ *
+ * @brief Block device on a window of the MX25L16, through flash_io.c and mx25_async.c.
+ *
+ * @details Writes go through one 4 KB erase unit buffer. A sector is only erased when the new
+ *          data needs a 0 bit turned back into 1; otherwise the changed 256-byte pages are
+ *          programmed over the old contents. Pages left all 0xFF after an erase are skipped.
+ *
+ *          With an event handler, erases and programs run as mx25_async jobs and the
+ *          NRF_BLOCK_DEV_EVT_BLK_WRITE_DONE event is sent from the app_scheduler, so a caller
+ *          that waits for it (diskio_blkdev) must run app_sched_execute() in its wait function.
+ *          Reads are short SPI transfers and complete before nrf_blk_dev_read_req() returns.
+ *          Without an event handler every request blocks.
+ *
+ *          NRF_BLOCK_DEV_IOCTL_REQ_CACHE_FLUSH and nrf_blk_dev_uninit() write the buffered
+ *          erase unit back before returning, in both modes.
+ */
+
+/**@brief MX25L16 block device operations. */
+extern const nrf_block_dev_ops_t nrf_block_device_mx25_ops;
+
+#define NRF_BLOCK_DEV_MX25_ERASE_UNIT_SIZE  4096 /**< Sector erase size. */
+#define NRF_BLOCK_DEV_MX25_PAGE_SIZE        256  /**< Page program size, the smallest block. */
+
+/**@brief Internal block device state. */
+typedef enum {
+    NRF_BLOCK_DEV_MX25_STATE_DISABLED = 0,  /**< Not initialized. */
+    NRF_BLOCK_DEV_MX25_STATE_IDLE,          /**< Ready for a request. */
+    NRF_BLOCK_DEV_MX25_STATE_WRITE_EXEC,    /**< Erase or page program job queued. */
+} nrf_block_dev_mx25_state_t;
+
+/**@brief Work structure of the MX25L16 block device. */
+typedef struct {
+    volatile nrf_block_dev_mx25_state_t state;        //!< Block device state
+
+    nrf_block_dev_geometry_t geometry;                //!< Block device geometry
+    nrf_block_dev_ev_handler ev_handler;              //!< Block device event handler
+    void const *             p_context;               //!< Context handle passed to event handler
+    nrf_block_req_t          req;                     //!< Block WRITE request: original value
+    nrf_block_req_t          left_req;                //!< Block WRITE request: blocks not yet buffered
+
+    bool     writeback_mode;                                        //!< Write-back mode flag
+    bool     erase_required;                                        //!< Buffered unit needs an erase
+    uint16_t dirty_pages;                                           //!< Pages of the unit to program
+    uint32_t erase_unit_idx;                                        //!< Buffered erase unit index
+    uint8_t  p_erase_unit_buff[NRF_BLOCK_DEV_MX25_ERASE_UNIT_SIZE]; //!< Erase unit buffer
+} nrf_block_dev_mx25_work_t;
+
+/**@brief MX25L16 block device flags. */
+typedef enum {
+    NRF_BLOCK_DEV_MX25_FLAG_CACHE_WRITEBACK = (1u << 0)  //!< Keep the last written erase unit in RAM until another one is written
+} nrf_block_dev_mx25_flag_t;
+
+/**@brief MX25L16 block device config initializer (@ref nrf_block_dev_mx25_config_t).
+ *
+ * @param blk_size    Block size: 256, 512, 1024, 2048 or 4096.
+ * @param blk_flags   Block device flags, @ref nrf_block_dev_mx25_flag_t.
+ * @param addr        First flash address of the window, sector aligned.
+ * @param len         Window size in bytes, a multiple of 4 KB.
+ */
+#define NRF_BLOCK_DEV_MX25_CONFIG(blk_size, blk_flags, addr, len)  {   \
+        .block_size = (blk_size),                                    \
+        .flags = (blk_flags),                                        \
+        .flash_addr = (addr),                                        \
+        .flash_size = (len),                                         \
+}
+
+/**@brief MX25L16 block device config. */
+typedef struct {
+    uint32_t block_size;    //!< Desired block size
+    uint32_t flags;         //!< Block device flags
+    uint32_t flash_addr;    //!< First flash address of the window
+    uint32_t flash_size;    //!< Window size in bytes
+} nrf_block_dev_mx25_config_t;
+
+/**@brief MX25L16 block device. */
+typedef struct {
+    nrf_block_dev_t              block_dev;          //!< Block device
+    nrf_block_dev_info_strings_t info_strings;       //!< Block device information strings
+    nrf_block_dev_mx25_config_t  mx25_bdev_config;   //!< Block device config
+    nrf_block_dev_mx25_work_t *  p_work;             //!< Block device work structure
+} nrf_block_dev_mx25_t;
+
+/**@brief Defines an MX25L16 block device.
+ *
+ * @details The window must not overlap the areas used by lock_acl and lock_journal.
+ *          Costs 4 KB of RAM for the erase unit buffer.
+ *
+ * @param name    Instance name
+ * @param config  Configuration @ref nrf_block_dev_mx25_config_t
+ * @param info    Info strings @ref NFR_BLOCK_DEV_INFO_CONFIG
+ */
+#define NRF_BLOCK_DEV_MX25_DEFINE(name, config, info)                \
+    static nrf_block_dev_mx25_work_t CONCAT_2(name, _work);          \
+    static const nrf_block_dev_mx25_t name = {                       \
+            .block_dev = { .p_ops = &nrf_block_device_mx25_ops },    \
+            .info_strings = BRACKET_EXTRACT(info),                   \
+            .mx25_bdev_config = config,                              \
+            .p_work = &CONCAT_2(name, _work),                        \
+    }
+
+/**@brief Returns block device API handle from an MX25L16 block device. */
+static inline nrf_block_dev_t const *
+nrf_block_dev_mx25_ops_get(nrf_block_dev_mx25_t const * p_blk_mx25)
+{
+    return &p_blk_mx25->block_dev;
+}
+
+/** @} */
+
+#endif
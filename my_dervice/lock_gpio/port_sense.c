@@ -0,0 +1,184 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PORT_SENSE)
+#include "port_sense.h"
+#include "nrf_drv_gpiote.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+
+#if !GPIOTE_ENABLED
+#error "port_sense needs GPIOTE_ENABLED"
+#endif
+#if GPIO_COUNT != 1
+#error "port_sense keeps one word per pin state, for one GPIO port"
+#endif
+
+#define PIN_BIT(pin)    (1UL << (pin))
+
+typedef struct
+{
+    port_sense_handler_t handler;
+    uint8_t              pin;
+} sense_pin_t;
+
+APP_TIMER_DEF(m_debounce_timer);
+
+static sense_pin_t       m_pins[PORT_SENSE_PINS_MAX];
+static uint8_t           m_pin_count;
+static uint32_t          m_mask;            /**< Pins sensed. */
+static uint32_t          m_debounce_mask;   /**< Pins handed out after the debounce time. */
+static volatile uint32_t m_last_pins_state; /**< Level of each pin, as the sense is set for. */
+static volatile uint32_t m_reported;        /**< Levels of the debounced pins handed out last. */
+static bool              m_initialized;
+
+
+static void changes_report(uint32_t changed, uint32_t levels)
+{
+    for (uint8_t i = 0; i < m_pin_count; i++)
+    {
+        uint8_t pin = m_pins[i].pin;
+
+        if ((changed & PIN_BIT(pin)) && (m_pins[i].handler != NULL))
+        {
+            m_pins[i].handler(pin, (levels & PIN_BIT(pin)) != 0);
+        }
+    }
+}
+
+
+static void sense_arm(uint8_t pin, uint32_t levels)
+{
+    nrf_gpio_cfg_sense_set(pin, (levels & PIN_BIT(pin)) ? NRF_GPIO_PIN_SENSE_LOW :
+                                                          NRF_GPIO_PIN_SENSE_HIGH);
+}
+
+
+/**@brief Pass of the GPIOTE interrupt over a PORT event. */
+static bool port_hook(uint32_t const * p_input)
+{
+    uint32_t changed = (p_input[0] ^ m_last_pins_state) & m_mask;
+    uint32_t levels;
+
+    if (changed == 0)
+    {
+        return false;
+    }
+
+    levels            = m_last_pins_state ^ changed;
+    m_last_pins_state = levels;
+    for (uint8_t i = 0; i < m_pin_count; i++)
+    {
+        if (changed & PIN_BIT(m_pins[i].pin))
+        {
+            sense_arm(m_pins[i].pin, levels);
+        }
+    }
+
+    if (changed & m_debounce_mask)
+    {
+        // Restarted by every bounce, so it runs out once the contact is quiet.
+        UNUSED_RETURN_VALUE(app_timer_stop(m_debounce_timer));
+        UNUSED_RETURN_VALUE(app_timer_start(m_debounce_timer,
+                                            APP_TIMER_TICKS(PORT_SENSE_DEBOUNCE_MS,
+                                                            APP_TIMER_CONFIG_PRESCALER),
+                                            NULL));
+    }
+    changes_report(changed & ~m_debounce_mask, levels);
+
+    // The driver reads the inputs again: a pin that moved meanwhile is in the next pass.
+    return true;
+}
+
+
+static void debounce_timer_handler(void * p_context)
+{
+    uint32_t levels;
+    uint32_t changed;
+
+    UNUSED_PARAMETER(p_context);
+
+    CRITICAL_REGION_ENTER();
+    levels      = m_last_pins_state;
+    changed     = (levels ^ m_reported) & m_debounce_mask;
+    m_reported ^= changed;
+    CRITICAL_REGION_EXIT();
+
+    changes_report(changed, levels);
+}
+
+
+ret_code_t port_sense_init(void)
+{
+    ret_code_t err_code;
+
+    if (m_initialized)
+    {
+        return NRF_SUCCESS;
+    }
+
+    err_code = app_timer_create(&m_debounce_timer, APP_TIMER_MODE_SINGLE_SHOT, debounce_timer_handler);
+    VERIFY_SUCCESS(err_code);
+
+    if (!nrf_drv_gpiote_is_init())
+    {
+        err_code = nrf_drv_gpiote_init();
+        VERIFY_SUCCESS(err_code);
+    }
+    nrf_drv_gpiote_port_hook_set(port_hook);
+    m_initialized = true;
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t port_sense_pin_add(uint8_t              pin,
+                              nrf_gpio_pin_pull_t  pull,
+                              bool                 debounce,
+                              port_sense_handler_t handler)
+{
+    uint32_t levels;
+
+    if (!m_initialized)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if ((pin >= NUMBER_OF_PINS) || (m_mask & PIN_BIT(pin)))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if (m_pin_count >= PORT_SENSE_PINS_MAX)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    nrf_gpio_cfg_input(pin, pull);
+
+    CRITICAL_REGION_ENTER();
+    levels = nrf_gpio_port_in_read(NRF_GPIO);
+
+    m_pins[m_pin_count].pin     = pin;
+    m_pins[m_pin_count].handler = handler;
+    m_pin_count++;
+
+    m_last_pins_state = (m_last_pins_state & ~PIN_BIT(pin)) | (levels & PIN_BIT(pin));
+    m_reported        = (m_reported & ~PIN_BIT(pin)) | (levels & PIN_BIT(pin));
+    if (debounce)
+    {
+        m_debounce_mask |= PIN_BIT(pin);
+    }
+    m_mask |= PIN_BIT(pin);
+    // Armed last: the hook sees the pin with its level known.
+    sense_arm(pin, levels);
+    CRITICAL_REGION_EXIT();
+
+    return NRF_SUCCESS;
+}
+
+
+bool port_sense_level_get(uint8_t pin)
+{
+    uint32_t levels = (m_debounce_mask & PIN_BIT(pin)) ? m_reported : m_last_pins_state;
+
+    return (levels & PIN_BIT(pin)) != 0;
+}
+
+#endif //NRF_MODULE_ENABLED(PORT_SENSE)
@@ -0,0 +1,55 @@
+#ifndef _PORT_SENSE_H_
+#define _PORT_SENSE_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "nrf_gpio.h"
+
+/* Slow inputs on the one low-power PORT event of GPIOTE, without a channel or a driver slot each:
+ *
+ *   sense     every pin senses the level it is not at, so the DETECT signal only rises on a
+ *             change; the PORT event costs no current while the CPU sleeps, where an IN channel
+ *             in high-accuracy mode keeps the 16 MHz clock running
+ *   latch     the last level of each pin is one word; on a PORT event the hook of nrf_drv_gpiote
+ *             compares the inputs to it, turns the sense of the pins that changed around and
+ *             hands each change to the handler of its pin: both edges, from one event
+ *   debounce  contacts are handed out PORT_SENSE_DEBOUNCE_MS after their last change, from one
+ *             app_timer for all of them, and only if the level differs from the one handed out
+ *             last; lines driven by a chip are handed out at once
+ *
+ * Pins taken here are not configured through nrf_drv_gpiote. A pulse shorter than the time the
+ * interrupt takes to read the inputs is not seen. */
+
+/**@brief Level change of a pin, from the GPIOTE interrupt, or from app_timer if debounced. */
+typedef void (*port_sense_handler_t)(uint8_t pin, bool level);
+
+/**@brief Hook into the PORT event of nrf_drv_gpiote; it is initialized if it has not been.
+ *
+ * @details Each user calls it before adding its pins; the calls after the first do nothing.
+ *
+ * @note Requires app_timer to be initialized.
+ */
+ret_code_t port_sense_init(void);
+
+/**@brief Sense a pin, both edges.
+ *
+ * @param[in] pin       Pin.
+ * @param[in] pull      Pull of the input.
+ * @param[in] debounce  Hand out levels that held for PORT_SENSE_DEBOUNCE_MS only.
+ * @param[in] handler   Handler of the changes, or NULL for a pin read with port_sense_level_get().
+ *
+ * @retval NRF_SUCCESS             The pin is sensed; the handler gets the changes from its
+ *                                 level now on.
+ * @retval NRF_ERROR_INVALID_STATE Not initialized.
+ * @retval NRF_ERROR_INVALID_PARAM No such pin, or it is sensed already.
+ * @retval NRF_ERROR_NO_MEM        PORT_SENSE_PINS_MAX pins are sensed.
+ */
+ret_code_t port_sense_pin_add(uint8_t              pin,
+                              nrf_gpio_pin_pull_t  pull,
+                              bool                 debounce,
+                              port_sense_handler_t handler);
+
+/**@brief Level of a sensed pin, the debounced one for a debounced pin. */
+bool port_sense_level_get(uint8_t pin);
+
+#endif
@@ -0,0 +1,376 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(POST_MORTEM)
+#include "post_mortem.h"
+#include "hardfault.h"
+#include "flash_io.h"
+#include "nus_tx.h"
+#include "pn532_apply.h"
+#include "keep_ram.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "nrf.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(HARDFAULT_HANDLER) || !NRF_MODULE_ENABLED(NUS_TX)
+#error "post_mortem needs HARDFAULT_HANDLER_ENABLED and NUS_TX_ENABLED"
+#endif
+
+#define POST_MORTEM_TICKS(ms)   APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+#define MAGIC_NEW               0x504D5452UL    /**< Taken before the reset, not stored yet. */
+#define MAGIC_SEEN              0x504D5453UL    /**< Stored, or none taken; keeps the fault count. */
+#define SECTOR_SIZE             4096
+#define SLOT_SIZE               (SECTOR_SIZE / POST_MORTEM_SLOTS)
+#define SLOT_ADDR(slot)         (POST_MORTEM_FLASH_ADDR + (slot) * SLOT_SIZE)
+#define STATE_SENT              0UL             /**< Programmed over the erased state word of a slot. */
+#define RAM_START               0x20000000UL
+#if NRF_MODULE_ENABLED(WDT_SUP)
+#define RAM_END                 WDT_SUP_CRASH_ADDR
+#else
+#define RAM_END                 (RAM_START + 0x8000)
+#endif
+
+// A slot is the state word followed by the record.
+STATIC_ASSERT(sizeof(uint32_t) + sizeof(post_mortem_rec_t) <= SLOT_SIZE);
+STATIC_ASSERT(sizeof(post_mortem_rec_t) / POST_MORTEM_CHUNK < POST_MORTEM_DONE);
+STATIC_ASSERT(POST_MORTEM_RAM_ADDR + sizeof(post_mortem_rec_t) <= RAM_END);
+STATIC_ASSERT((POST_MORTEM_FLASH_ADDR % SECTOR_SIZE) == 0);
+#if NRF_MODULE_ENABLED(LOCK_JOURNAL)
+STATIC_ASSERT((POST_MORTEM_FLASH_ADDR >= LOCK_JOURNAL_FLASH_ADDR + LOCK_JOURNAL_SECTORS * SECTOR_SIZE) ||
+              (POST_MORTEM_FLASH_ADDR + SECTOR_SIZE <= LOCK_JOURNAL_FLASH_ADDR));
+#endif
+
+// The Keil projects keep RAM from POST_MORTEM_RAM_ADDR up out of IRAM1, as the NoInit IRAM2.
+#if defined(__CC_ARM)
+static post_mortem_rec_t m_rec __attribute__((at(POST_MORTEM_RAM_ADDR), zero_init));
+#else
+static post_mortem_rec_t m_rec __attribute__((section(".noinit")));
+#endif
+
+APP_TIMER_DEF(m_timer);
+
+static uint8_t           m_used;                                /**< Slots holding a record, one bit each. */
+static uint8_t           m_pending;                             /**< Of those, the ones not sent yet. */
+static uint8_t           m_next;                                /**< Next blank slot, POST_MORTEM_SLOTS if none. */
+static uint8_t           m_tries;
+static volatile uint16_t m_conn_handle = BLE_CONN_HANDLE_INVALID;  /**< Link the upload waits for. */
+
+
+static uint32_t rec_check(post_mortem_rec_t const * p_rec)
+{
+    uint32_t const * p_word = (uint32_t const *)p_rec;
+    uint32_t         check  = UINT32_MAX;
+
+    for (uint8_t i = 0; i < offsetof(post_mortem_rec_t, check) / sizeof(uint32_t); i++)
+    {
+        check ^= p_word[i];
+    }
+    return check;
+}
+
+
+/**@brief Fill the RAM snapshot. Fault context: no locks, no SoftDevice calls, no flash. */
+static void capture(uint32_t id, uint32_t pc, uint32_t info, uint32_t const * p_regs, uint32_t sp)
+{
+    uint32_t faults = 0;
+
+#if NRF_MODULE_ENABLED(KEEP_RAM)
+    keep_ram_fault(id, pc, info);
+#endif
+    if (rec_check(&m_rec) == m_rec.check)
+    {
+        if (m_rec.magic == MAGIC_NEW)
+        {
+            // Not stored yet: the first fault explains the ones after it.
+            return;
+        }
+        faults = m_rec.faults;
+    }
+
+    memset(&m_rec, 0, sizeof(m_rec));
+    m_rec.faults = faults + 1;
+    m_rec.stamp  = app_timer_cnt_get();
+    m_rec.id     = id;
+    m_rec.pc     = pc;
+    m_rec.info   = info;
+    if (id == NRF_FAULT_ID_SDK_ERROR)
+    {
+        m_rec.err_code = ((error_info_t const *)info)->err_code;
+        m_rec.line     = ((error_info_t const *)info)->line_num;
+    }
+    else if (id == NRF_FAULT_ID_SDK_ASSERT)
+    {
+        m_rec.line = ((assert_info_t const *)info)->line_num;
+    }
+    if (p_regs != NULL)
+    {
+        memcpy(m_rec.regs, p_regs, sizeof(m_rec.regs));
+    }
+    // A stack pointer gone out of RAM would fault again on the copy.
+    if ((sp >= RAM_START) && (sp < POST_MORTEM_RAM_ADDR) && ((sp % sizeof(uint32_t)) == 0))
+    {
+        m_rec.sp          = sp;
+        m_rec.stack_words = (uint16_t)MIN(POST_MORTEM_STACK_WORDS,
+                                          (POST_MORTEM_RAM_ADDR - sp) / sizeof(uint32_t));
+        memcpy(m_rec.stack, (void const *)sp, m_rec.stack_words * sizeof(uint32_t));
+    }
+#if NRF_MODULE_ENABLED(LAT_TRACE)
+    m_rec.trace_count = (uint8_t)lat_trace_copy(m_rec.trace, POST_MORTEM_TRACE_RECS);
+#endif
+    m_rec.magic = MAGIC_NEW;
+    m_rec.check = rec_check(&m_rec);
+}
+
+
+static uint32_t sp_get(void)
+{
+    // app_rtos runs its tasks on the PSP; handlers are always on the MSP.
+    if ((__get_IPSR() == 0) && ((__get_CONTROL() & CONTROL_SPSEL_Msk) != 0))
+    {
+        return __get_PSP();
+    }
+    return __get_MSP();
+}
+
+
+void HardFault_process(HardFault_stack_t * p_stack)
+{
+    if (p_stack == NULL)
+    {
+        // Stack overrun: the handler moved the stack pointer back to the top, the frame is lost.
+        capture(POST_MORTEM_ID_HARDFAULT, 0, 0, NULL, 0);
+    }
+    else
+    {
+        capture(POST_MORTEM_ID_HARDFAULT, p_stack->pc, 0, (uint32_t const *)p_stack,
+                (uint32_t)p_stack + sizeof(HardFault_stack_t));
+    }
+    NVIC_SystemReset();
+}
+
+
+void app_error_fault_handler(uint32_t id, uint32_t pc, uint32_t info)
+{
+    capture(id, pc, info, NULL, sp_get());
+#ifndef DEBUG
+    NVIC_SystemReset();
+#else
+    app_error_save_and_stop(id, pc, info);
+#endif // DEBUG
+}
+
+
+void post_mortem_save(uint32_t id, uint32_t info)
+{
+    capture(id, 0, info, NULL, sp_get());
+}
+
+
+/**@brief Find the used, pending and blank slots; they fill up in order. */
+static void slots_scan(void)
+{
+    uint32_t head[2];   /**< State word, record magic. */
+
+    m_used    = 0;
+    m_pending = 0;
+    m_next    = POST_MORTEM_SLOTS;
+    for (uint8_t slot = 0; slot < POST_MORTEM_SLOTS; slot++)
+    {
+        read_mx25l16_buf((uint8_t *)head, SLOT_ADDR(slot), sizeof(head));
+        if (head[1] == UINT32_MAX)
+        {
+            m_next = slot;
+            break;
+        }
+        if (head[1] == MAGIC_NEW)
+        {
+            m_used |= (uint8_t)(1 << slot);
+            if (head[0] == UINT32_MAX)
+            {
+                m_pending |= (uint8_t)(1 << slot);
+            }
+        }
+    }
+}
+
+
+static void rec_store(void)
+{
+    if (m_next >= POST_MORTEM_SLOTS)
+    {
+        mx25lxx_erase_sector(POST_MORTEM_FLASH_ADDR);
+        m_used    = 0;
+        m_pending = 0;
+        m_next    = 0;
+    }
+    // The state word is left erased: not sent.
+    write_mx25lxx_nocheck((uint8_t *)&m_rec, SLOT_ADDR(m_next) + sizeof(uint32_t), sizeof(m_rec));
+    m_used    |= (uint8_t)(1 << m_next);
+    m_pending |= (uint8_t)(1 << m_next);
+    m_next++;
+}
+
+
+static void slot_sent(uint8_t slot)
+{
+    uint32_t state = STATE_SENT;
+
+    if (m_pending & (1 << slot))
+    {
+        write_mx25lxx_page((uint8_t *)&state, SLOT_ADDR(slot), sizeof(state));
+        m_pending &= (uint8_t)~(1 << slot);
+    }
+}
+
+
+/**@brief Queue the record of @p slot, read from flash one message at a time. */
+static ret_code_t slot_send(uint16_t conn_handle, uint8_t slot)
+{
+    uint8_t    msg[3 + POST_MORTEM_CHUNK];
+    uint32_t   addr = SLOT_ADDR(slot) + sizeof(uint32_t);
+    ret_code_t err_code;
+
+    msg[0] = POST_MORTEM;
+    msg[1] = slot;
+    for (uint16_t offset = 0; offset < sizeof(post_mortem_rec_t); offset += POST_MORTEM_CHUNK)
+    {
+        uint16_t len = (uint16_t)MIN(POST_MORTEM_CHUNK, sizeof(post_mortem_rec_t) - offset);
+
+        msg[2] = (uint8_t)(offset / POST_MORTEM_CHUNK);
+        read_mx25l16_buf(&msg[3], addr + offset, len);
+        err_code = nus_tx_put(conn_handle, msg, 3 + len, 0);
+        VERIFY_SUCCESS(err_code);
+    }
+    msg[2] = POST_MORTEM_DONE;
+    return nus_tx_put(conn_handle, msg, 3, 0);
+}
+
+
+static void upload_stop(void)
+{
+    UNUSED_RETURN_VALUE(app_timer_stop(m_timer));
+    m_conn_handle = BLE_CONN_HANDLE_INVALID;
+}
+
+
+static void upload_run(void * p_event_data, uint16_t event_size)
+{
+    uint16_t conn_handle = m_conn_handle;
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    if (conn_handle == BLE_CONN_HANDLE_INVALID)
+    {
+        return;
+    }
+    for (uint8_t slot = 0; slot < POST_MORTEM_SLOTS; slot++)
+    {
+        ret_code_t err_code;
+
+        if ((m_pending & (1 << slot)) == 0)
+        {
+            continue;
+        }
+        err_code = slot_send(conn_handle, slot);
+        if ((err_code == NRF_ERROR_INVALID_STATE) && (++m_tries < POST_MORTEM_POLL_TRIES))
+        {
+            // Notifications not on yet, or turned off: from the start of the record next poll.
+            return;
+        }
+        if (err_code != NRF_SUCCESS)
+        {
+            break;
+        }
+        slot_sent(slot);
+    }
+    upload_stop();
+}
+
+
+static void poll_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    UNUSED_RETURN_VALUE(app_sched_event_put(NULL, 0, upload_run));
+}
+
+
+ret_code_t post_mortem_init(void)
+{
+    slots_scan();
+
+    if (rec_check(&m_rec) != m_rec.check)
+    {
+        // Power on: RAM holds noise.
+        memset(&m_rec, 0, sizeof(m_rec));
+    }
+    else if (m_rec.magic == MAGIC_NEW)
+    {
+        rec_store();
+    }
+    m_rec.magic = MAGIC_SEEN;
+    m_rec.check = rec_check(&m_rec);
+
+    return app_timer_create(&m_timer, APP_TIMER_MODE_REPEATED, poll_handler);
+}
+
+
+uint8_t post_mortem_pending(void)
+{
+    uint8_t count = 0;
+
+    for (uint8_t slot = 0; slot < POST_MORTEM_SLOTS; slot++)
+    {
+        count += (m_pending >> slot) & 1;
+    }
+    return count;
+}
+
+
+ret_code_t post_mortem_send_all(uint16_t conn_handle)
+{
+    for (uint8_t slot = 0; slot < POST_MORTEM_SLOTS; slot++)
+    {
+        ret_code_t err_code;
+
+        if ((m_used & (1 << slot)) == 0)
+        {
+            continue;
+        }
+        err_code = slot_send(conn_handle, slot);
+        VERIFY_SUCCESS(err_code);
+        slot_sent(slot);
+    }
+    return NRF_SUCCESS;
+}
+
+
+void post_mortem_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    uint16_t conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            // One link at a time; the next one to connect gets what this one did not take.
+            if ((m_pending != 0) && (m_conn_handle == BLE_CONN_HANDLE_INVALID))
+            {
+                m_tries       = 0;
+                m_conn_handle = conn_handle;
+                UNUSED_RETURN_VALUE(app_timer_start(m_timer, POST_MORTEM_TICKS(POST_MORTEM_POLL_MS), NULL));
+            }
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            if (conn_handle == m_conn_handle)
+            {
+                upload_stop();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(POST_MORTEM)
@@ -0,0 +1,84 @@
+#ifndef _POST_MORTEM_H_
+#define _POST_MORTEM_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "app_error.h"
+#include "nrf_sdm.h"
+#include "ble.h"
+#include "lat_trace.h"
+
+/* Fault snapshots, kept over the reset and uploaded over NUS on the next connection:
+ *
+ *   capture   HardFault_process() and app_error_fault_handler() write the snapshot to RAM
+ *             that the startup code leaves alone, at POST_MORTEM_RAM_ADDR, and reset: the
+ *             registers of the exception frame, the stack above it and the newest records
+ *             of the latency trace. wdt_sup does the same for a part it finds stuck, from its
+ *             own stack, before it stops feeding the watchdog. No flash is written from a
+ *             fault; the SPI may be the thing that hung
+ *   store     after the reset, post_mortem_init() programs the snapshot into the next blank
+ *             slot of the MX25 sector at POST_MORTEM_FLASH_ADDR, erasing the sector, and the
+ *             older snapshots with it, when all POST_MORTEM_SLOTS are used
+ *   upload    a peer that connects while snapshots wait gets them once its notifications are
+ *             on, polled every POST_MORTEM_POLL_MS: POST_MORTEM, slot, chunk, 16 bytes of the
+ *             record, then POST_MORTEM, slot, POST_MORTEM_DONE. A snapshot queued as a whole
+ *             is marked sent in its slot; one cut short by a disconnect is sent again
+ *
+ * The POST_MORTEM command sends every snapshot still in the sector again, the same way, and
+ * ends with POST_MORTEM, POST_MORTEM_DONE, result. */
+
+#define POST_MORTEM_ID_HARDFAULT    (NRF_FAULT_ID_APP_RANGE_START + 1)  /**< HardFault exception. */
+#define POST_MORTEM_ID_STALL        (NRF_FAULT_ID_APP_RANGE_START + 2)  /**< wdt_sup: info is part | reason << 8. */
+
+#define POST_MORTEM_STACK_WORDS     64      /**< Stack words kept, from the faulting stack pointer up. */
+#define POST_MORTEM_TRACE_RECS      16      /**< Newest latency trace records kept. */
+#define POST_MORTEM_SLOTS           8       /**< Slots of 512 bytes in the flash sector. */
+#define POST_MORTEM_CHUNK           16      /**< Record bytes per upload message. */
+#define POST_MORTEM_DONE            0xFF    /**< Chunk number that ends a record. */
+
+/**@brief Snapshot, as kept in RAM and in flash and as uploaded. Little endian. */
+typedef struct
+{
+    uint32_t        magic;
+    uint32_t        faults;                             /**< Snapshots taken since power on. */
+    uint32_t        stamp;                              /**< app_timer_cnt_get() at the fault. */
+    uint32_t        id;                                 /**< NRF_FAULT_ID_*, POST_MORTEM_ID_*. */
+    uint32_t        pc;                                 /**< As app_error passed it, or the frame PC. */
+    uint32_t        info;                               /**< As app_error passed it; see the ids. */
+    uint32_t        err_code;                           /**< NRF_FAULT_ID_SDK_ERROR: the error. */
+    uint32_t        line;                               /**< NRF_FAULT_ID_SDK_ERROR: its line. */
+    uint32_t        regs[8];                            /**< HardFault: r0-r3, r12, lr, pc, psr. */
+    uint32_t        sp;                                 /**< First word of @ref stack. */
+    uint16_t        stack_words;
+    uint8_t         trace_count;
+    uint8_t         rfu;
+    uint32_t        stack[POST_MORTEM_STACK_WORDS];
+    lat_trace_rec_t trace[POST_MORTEM_TRACE_RECS];      /**< Oldest first. */
+    uint32_t        check;
+} post_mortem_rec_t;
+
+/**@brief Store the snapshot of the last reset, if any, and find the ones not sent yet.
+ *
+ * @details Call after device_mx25l16mb_init(), app_timer and app_scheduler.
+ */
+ret_code_t post_mortem_init(void);
+
+/**@brief Take a snapshot from the current stack. Any context; does not reset.
+ *
+ * @details The first snapshot after a reset wins; later ones are dropped.
+ */
+void post_mortem_save(uint32_t id, uint32_t info);
+
+/**@brief Number of snapshots in flash not sent yet. */
+uint8_t post_mortem_pending(void);
+
+/**@brief Send every snapshot still in flash to @p conn_handle. Main loop.
+ *
+ * @return Same as @ref nus_tx_put.
+ */
+ret_code_t post_mortem_send_all(uint16_t conn_handle);
+
+/**@brief Start and stop the upload with the connections. Call in the BLE event dispatch. */
+void post_mortem_on_ble_evt(ble_evt_t * p_ble_evt);
+
+#endif
@@ -0,0 +1,100 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+#include "pwr_idle.h"
+#include "nrf_pwr_mgmt.h"
+#include "app_timer.h"
+#include "nrf.h"
+
+#if !NRF_MODULE_ENABLED(NRF_PWR_MGMT)
+#error "pwr_idle needs NRF_PWR_MGMT_ENABLED"
+#endif
+#if NRF_MODULE_ENABLED(APP_RTOS)
+#error "pwr_idle runs from the main loop, app_rtos sleeps in its idle task"
+#endif
+
+static pwr_idle_hook_t const * m_hooks[PWR_IDLE_HOOKS_MAX];    /**< Shortest wake time first. */
+static uint8_t                 m_count;
+
+
+/**@brief Time the main loop may sleep, in us. */
+static uint32_t budget_get(void)
+{
+    uint64_t us;
+
+    // Interrupts the SoftDevice keeps pending, the BLE event one among them, end the sleep.
+    if (NVIC->ISPR[0] != 0)
+    {
+        return 0;
+    }
+
+    us = ((uint64_t)app_timer_ticks_to_expiry_get() * 1000000 * (APP_TIMER_CONFIG_PRESCALER + 1)) /
+         APP_TIMER_CLOCK_FREQ;
+    return (uint32_t)MIN(us, UINT32_MAX);
+}
+
+
+/**@brief Put down the parts that wake up fast enough for @p budget_us, deepest first.
+ *
+ * @return Whether a part went down.
+ */
+static bool parts_down(uint32_t budget_us)
+{
+    uint8_t n    = 0;
+    bool    down = false;
+
+    while ((n < m_count) && ((uint64_t)m_hooks[n]->wake_us * PWR_IDLE_BREAK_EVEN < budget_us))
+    {
+        n++;
+    }
+    while (n-- != 0)
+    {
+        if (m_hooks[n]->idle())
+        {
+            down = true;
+        }
+    }
+    return down;
+}
+
+
+ret_code_t pwr_idle_register(pwr_idle_hook_t const * p_hook)
+{
+    uint8_t i;
+
+    if (m_count == PWR_IDLE_HOOKS_MAX)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    for (i = m_count; (i > 0) && (m_hooks[i - 1]->wake_us > p_hook->wake_us); i--)
+    {
+        m_hooks[i] = m_hooks[i - 1];
+    }
+    m_hooks[i] = p_hook;
+    m_count++;
+    return NRF_SUCCESS;
+}
+
+
+void pwr_idle_run(void)
+{
+    if (parts_down(budget_get()))
+    {
+        // The hooks waited for bus commands; what came in meanwhile runs before the sleep.
+        return;
+    }
+    nrf_pwr_mgmt_run();
+}
+
+
+static bool shutdown_handler(nrf_pwr_mgmt_evt_t event)
+{
+    UNUSED_PARAMETER(event);
+
+    UNUSED_RETURN_VALUE(parts_down(UINT32_MAX));
+    return true;
+}
+
+NRF_PWR_MGMT_REGISTER_HANDLER(m_shutdown_handler) = shutdown_handler;
+
+#endif //NRF_MODULE_ENABLED(PWR_IDLE)
@@ -0,0 +1,42 @@
+#ifndef _PWR_IDLE_H_
+#define _PWR_IDLE_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* Idle power of the main loop, on top of nrf_pwr_mgmt:
+ *
+ *   hook      a driver registers how to put its part in a low power state and how much longer
+ *             the next use takes after that; the part wakes up by itself on that next use
+ *   deadline  the next app_timer expiry; a pending interrupt, such as a BLE event, means now
+ *   depth     only parts whose wake time fits PWR_IDLE_BREAK_EVEN times into the time to the
+ *             deadline are put down, deepest first, so a part that needs a bus to go to sleep
+ *             is done before the bus; the shallower states are taken when the next timer is
+ *             close, none when it is due
+ *   sleep     nrf_pwr_mgmt_run(), sd_app_evt_wait() with the SoftDevice
+ *
+ * A pass that put a part down returns without sleeping, so events the hooks let in are run
+ * by the main loop first. Before System OFF through nrf_pwr_mgmt_shutdown() every part is put
+ * down. */
+
+/**@brief A part that can be put in a low power state while the main loop sleeps. */
+typedef struct
+{
+    bool     (* idle)(void);    /**< Enter the low power state. Main loop. Returns true if the
+                                     part went down now, false if busy or already down. */
+    uint32_t wake_us;           /**< Extra time the next use takes after idle(). */
+} pwr_idle_hook_t;
+
+/**@brief Add a part, from the init of its driver.
+ *
+ * @retval NRF_SUCCESS       Hook added; it must stay valid.
+ * @retval NRF_ERROR_NO_MEM  PWR_IDLE_HOOKS_MAX hooks already registered.
+ */
+ret_code_t pwr_idle_register(pwr_idle_hook_t const * p_hook);
+
+/**@brief Put down what the next deadline allows, then sleep. Call from the main loop in place
+ *        of sd_app_evt_wait(), after nrf_pwr_mgmt_init().
+ */
+void pwr_idle_run(void);
+
+#endif
@@ -0,0 +1,102 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(RAM_BUDGET)
+#include "ram_budget.h"
+#include "nrf.h"
+
+#define PAINT         0xC5C5C5C5UL
+#define PAINT_MARGIN  64    /**< Left below the stack pointer of ram_budget_paint(), for what it calls. */
+
+// Create section "ram_budget_data".
+//lint -esym(526, ram_budget_dataBase) -esym(526, ram_budget_dataLimit)
+NRF_SECTION_VARS_CREATE_SECTION(ram_budget_data, ram_budget_entry_t const);
+
+#define RAM_BUDGET_GET(i)   NRF_SECTION_VARS_GET((i), ram_budget_entry_t const, ram_budget_data)
+#define RAM_BUDGET_COUNT    NRF_SECTION_VARS_COUNT(ram_budget_entry_t, ram_budget_data)
+
+// STACK_BASE and STACK_TOP of app_util.h bound the main stack.
+#define STACK_FIRST  ((uint32_t *)STACK_BASE)
+#define STACK_END    ((uint32_t *)STACK_TOP)
+
+#if defined(__CC_ARM)
+extern uint8_t  Image$$RW_IRAM1$$Base[];
+extern uint8_t  Image$$RW_IRAM1$$RW$$Length[];
+extern uint8_t  Image$$RW_IRAM1$$ZI$$Length[];
+extern uint8_t  Image$$RW_IRAM1$$ZI$$Limit[];
+#elif defined(__GNUC__)
+extern uint8_t  __data_start__[];
+extern uint8_t  __data_end__[];
+extern uint8_t  __bss_start__[];
+extern uint8_t  __bss_end__[];
+#else
+#error "ram_budget takes the layout from the linker symbols of ARMCC or GCC"
+#endif
+
+
+void ram_budget_paint(void)
+{
+    uint32_t * p_word = STACK_FIRST;
+    uint32_t * p_end  = (uint32_t *)(__get_MSP() - PAINT_MARGIN);
+
+    while (p_word < p_end)
+    {
+        *p_word++ = PAINT;
+    }
+}
+
+
+static uint16_t stack_used_get(void)
+{
+    uint32_t const * p_word = STACK_FIRST;
+
+    // Painted from the bottom up: the first word that changed is the deepest the stack went.
+    while ((p_word < STACK_END) && (*p_word == PAINT))
+    {
+        p_word++;
+    }
+    return (uint16_t)((uint32_t)STACK_END - (uint32_t)p_word);
+}
+
+
+#if defined(__CC_ARM)
+static uint32_t ram_end_get(void)
+{
+#if defined(NRF51)
+    return 0x20000000UL + NRF_FICR->NUMRAMBLOCK * NRF_FICR->SIZERAMBLOCKS;
+#else
+    return 0x20000000UL + NRF_FICR->INFO.RAM * 1024UL;
+#endif
+}
+#endif
+
+
+void ram_budget_layout_get(ram_budget_layout_t * p_layout)
+{
+    uint32_t stack = (uint32_t)STACK_END - (uint32_t)STACK_FIRST;
+
+#if defined(__CC_ARM)
+    // The stack, and the heap of the startup file, are no-init areas of the zeroed region.
+    p_layout->ram_start = (uint32_t)Image$$RW_IRAM1$$Base;
+    p_layout->data      = (uint16_t)(uint32_t)Image$$RW_IRAM1$$RW$$Length;
+    p_layout->bss       = (uint16_t)((uint32_t)Image$$RW_IRAM1$$ZI$$Length - stack);
+    p_layout->unused    = (uint16_t)(ram_end_get() - (uint32_t)Image$$RW_IRAM1$$ZI$$Limit);
+#else
+    p_layout->ram_start = (uint32_t)__data_start__;
+    p_layout->data      = (uint16_t)(__data_end__ - __data_start__);
+    p_layout->bss       = (uint16_t)(__bss_end__ - __bss_start__);
+    p_layout->unused    = (uint16_t)((uint32_t)STACK_FIRST - (uint32_t)__bss_end__);
+#endif
+    p_layout->stack      = (uint16_t)stack;
+    p_layout->stack_used = stack_used_get();
+}
+
+
+ram_budget_entry_t const * ram_budget_entry_get(uint32_t index)
+{
+    if (index >= RAM_BUDGET_COUNT)
+    {
+        return NULL;
+    }
+    return RAM_BUDGET_GET(index);
+}
+
+#endif //NRF_MODULE_ENABLED(RAM_BUDGET)
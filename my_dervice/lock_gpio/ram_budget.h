@@ -0,0 +1,69 @@
+#ifndef _RAM_BUDGET_H_
+#define _RAM_BUDGET_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "section_vars.h"
+
+/* Where the RAM of the application goes, measured on the device, to size caches and queues
+ * against:
+ *
+ *   stack     ram_budget_paint(), first thing in main(), fills the free part of the main stack
+ *             with a pattern; the words the pattern is gone from are the most the stack has held
+ *             since boot, the PN532 frames in wiresendcommand()/wirereaddata() and every
+ *             interrupt on top included. With APP_RTOS the main stack is the interrupt stack
+ *   layout    initialized and zeroed statics, the stack and the RAM after the image, from the
+ *             symbols of the linker
+ *   buffers   the large buffers of the modules, with the most of them in use at once where
+ *             the module keeps count, each placed by RAM_BUDGET_REGISTER() in the linker
+ *             section ram_budget_data next to the buffer
+ *
+ * The numbers are since boot and go out with the RAM_BUDGET command. */
+
+/**@brief Bytes of a buffer that were in use at most at once, since boot. */
+typedef uint16_t (*ram_budget_peak_t)(void);
+
+typedef struct
+{
+    char const *      p_name;
+    uint16_t          size;
+    ram_budget_peak_t peak;     /**< NULL when the module does not count. */
+} ram_budget_entry_t;
+
+typedef struct
+{
+    uint32_t ram_start;         /**< First address of the application, after the SoftDevice. */
+    uint16_t data;              /**< Initialized statics. */
+    uint16_t bss;               /**< Zeroed and no-init statics, the stack left out. */
+    uint16_t stack;             /**< Size of the main stack. */
+    uint16_t stack_used;        /**< Most of it used since boot. */
+    uint16_t unused;            /**< After the image, to the end of RAM; the heap with GCC. */
+} ram_budget_layout_t;
+
+#if defined(RAM_BUDGET_ENABLED) && RAM_BUDGET_ENABLED
+/**@brief Register a buffer of @p size bytes; at file scope, in the module of the buffer.
+ *
+ * @param[in] id    Name of the entry, unique in the image.
+ * @param[in] name  Short name for the report, up to RAM_BUDGET_NAME_LEN characters are sent.
+ * @param[in] size  Bytes of the buffer.
+ * @param[in] peak  ram_budget_peak_t, or NULL.
+ */
+#define RAM_BUDGET_REGISTER(id, name, size, peak)                                        \
+            NRF_SECTION_VARS_REGISTER_VAR(ram_budget_data, ram_budget_entry_t const id) = \
+            {(name), (uint16_t)(size), (peak)}
+#else
+#define RAM_BUDGET_REGISTER(id, name, size, peak)
+#endif
+
+#define RAM_BUDGET_NAME_LEN  8
+
+/**@brief Paint the free part of the main stack. First thing in main(), before interrupts. */
+void ram_budget_paint(void);
+
+/**@brief The layout, with the stack high water mark as of now. */
+void ram_budget_layout_get(ram_budget_layout_t * p_layout);
+
+/**@brief Registered buffer @p index, NULL past the last one. */
+ram_budget_entry_t const * ram_budget_entry_get(uint32_t index);
+
+#endif
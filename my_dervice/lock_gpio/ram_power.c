@@ -0,0 +1,81 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(RAM_POWER)
+#include "ram_power.h"
+#include "nrf_power.h"
+#include "nrf_sdm.h"
+
+#if !NRF_POWER_HAS_RAMPOWER_REGS
+#error "ram_power switches the sections of the nRF52 RAM blocks"
+#endif
+
+#define RAM_START         0x20000000UL
+#define SECTION_SIZE      4096UL
+#define BLOCK_SECTIONS    2
+
+#if defined(__CC_ARM)
+extern uint8_t Image$$RW_IRAM1$$ZI$$Limit[];
+#define IMAGE_END         ((uint32_t)Image$$RW_IRAM1$$ZI$$Limit)
+#elif defined(__GNUC__)
+// The stack is at the top of RAM with GCC: the heap is the last the image uses from the bottom.
+extern uint8_t __HeapLimit[];
+#define IMAGE_END         ((uint32_t)__HeapLimit)
+#else
+#error "ram_power takes the end of the image from the linker symbols of ARMCC or GCC"
+#endif
+
+static uint8_t m_released;
+
+
+ret_code_t ram_power_init(void)
+{
+    uint32_t ram_end    = RAM_START + NRF_FICR->INFO.RAM * 1024UL;
+    uint32_t keep_start = RAM_POWER_KEEP_ADDR;
+    uint8_t  enabled;
+
+    VERIFY_SUCCESS(sd_softdevice_is_enabled(&enabled));
+    if (enabled)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+#if defined(__GNUC__) && !defined(__CC_ARM)
+    keep_start = MIN(keep_start, (uint32_t)STACK_BASE);
+#endif
+
+    m_released = 0;
+    for (uint32_t addr = RAM_START; addr < ram_end; addr += SECTION_SIZE)
+    {
+        uint32_t section   = (addr - RAM_START) / SECTION_SIZE;
+        uint8_t  block     = (uint8_t)(section / BLOCK_SECTIONS);
+        uint32_t power     = NRF_POWER_RAMPOWER_S0POWER_MASK << (section % BLOCK_SECTIONS);
+        uint32_t retention = NRF_POWER_RAMPOWER_S0RETENTION_MASK << (section % BLOCK_SECTIONS);
+        bool     keep      = (addr + SECTION_SIZE > keep_start);
+
+        if ((addr < IMAGE_END) || keep)
+        {
+            nrf_power_rampower_mask_on(block, power);
+        }
+        else
+        {
+            nrf_power_rampower_mask_off(block, power);
+            m_released++;
+        }
+
+        if (keep)
+        {
+            nrf_power_rampower_mask_on(block, retention);
+        }
+        else
+        {
+            nrf_power_rampower_mask_off(block, retention);
+        }
+    }
+    return NRF_SUCCESS;
+}
+
+
+uint8_t ram_power_released(void)
+{
+    return m_released;
+}
+
+#endif //NRF_MODULE_ENABLED(RAM_POWER)
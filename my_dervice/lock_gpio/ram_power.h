@@ -0,0 +1,32 @@
+#ifndef _RAM_POWER_H_
+#define _RAM_POWER_H_
+
+#include <stdint.h>
+#include "sdk_errors.h"
+
+/* RAM sections the image does not use switched off, nRF52 only. The 64 kB are eight blocks of
+ * two 4 kB sections, each with a switch of its own and a retention bit for when it is off:
+ *
+ *   on        the sections of the SoftDevice and of the image, from the start of RAM to the
+ *             end of its zeroed statics (the stack is one of them in the Keil layout), and the
+ *             sections from RAM_POWER_KEEP_ADDR to the end of RAM
+ *   off       the sections in between, with their retention
+ *   retained  in System OFF, only the sections from RAM_POWER_KEEP_ADDR up, where keep_ram,
+ *             post_mortem and the crash record of wdt_sup are
+ *
+ * Every section is set at each boot, so an image that grew finds its RAM on again. An off
+ * section holds nothing and draws nothing; each one released takes some 20 nA off the sleep
+ * current. The count goes out with RAM_BUDGET. */
+
+/**@brief Switch the unused sections off. Before the SoftDevice is enabled: POWER is its own
+ *        afterwards.
+ *
+ * @retval NRF_SUCCESS              Done.
+ * @retval NRF_ERROR_INVALID_STATE  The SoftDevice is enabled.
+ */
+ret_code_t ram_power_init(void);
+
+/**@brief Sections switched off by ram_power_init(). */
+uint8_t ram_power_released(void);
+
+#endif
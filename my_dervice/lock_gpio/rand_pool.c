@@ -0,0 +1,139 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(RAND_POOL)
+#include "rand_pool.h"
+#include "nrf_drv_rng.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(RNG)
+#error "rand_pool needs RNG_ENABLED"
+#endif
+#if !RNG_CONFIG_ERROR_CORRECTION
+#error "rand_pool hands out keys and nonces: set RNG_CONFIG_ERROR_CORRECTION"
+#endif
+#if (RAND_POOL_LOW >= RAND_POOL_SIZE) || (RAND_POOL_SIZE > UINT8_MAX)
+#error "RAND_POOL_LOW has to be below RAND_POOL_SIZE, at most 255"
+#endif
+
+#define REFILL_TICKS    APP_TIMER_TICKS(RAND_POOL_REFILL_MS, APP_TIMER_CONFIG_PRESCALER)
+
+APP_TIMER_DEF(m_refill_timer);
+
+static uint8_t          m_pool[RAND_POOL_SIZE];
+static volatile uint8_t m_level;
+static volatile bool    m_refilling;
+static uint32_t         m_misses;
+
+
+static void refill_start(void)
+{
+    CRITICAL_REGION_ENTER();
+    if (!m_refilling)
+    {
+        m_refilling = (app_timer_start(m_refill_timer, REFILL_TICKS, NULL) == NRF_SUCCESS);
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+
+/**@brief Take what the source has, up to a full pool; true once the pool is full. */
+static bool refill(void)
+{
+    uint8_t buf[RAND_POOL_SIZE];
+    uint8_t available;
+    uint8_t len;
+    bool    full;
+
+    nrf_drv_rng_bytes_available(&available);
+    len = MIN(available, (uint8_t)(RAND_POOL_SIZE - m_level));
+    if ((len == 0) || (nrf_drv_rng_rand(buf, len) != NRF_SUCCESS))
+    {
+        return (m_level == RAND_POOL_SIZE);
+    }
+
+    // Read outside the region, the SoftDevice call may take a while.
+    CRITICAL_REGION_ENTER();
+    len = MIN(len, (uint8_t)(RAND_POOL_SIZE - m_level));
+    memcpy(&m_pool[m_level], buf, len);
+    m_level += len;
+    full     = (m_level == RAND_POOL_SIZE);
+    CRITICAL_REGION_EXIT();
+
+    memset(buf, 0, sizeof(buf));
+    return full;
+}
+
+
+static void refill_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    m_refilling = false;
+    if (!refill())
+    {
+        refill_start();
+    }
+}
+
+
+ret_code_t rand_pool_init(void)
+{
+    nrf_drv_rng_config_t config = NRF_DRV_RNG_DEFAULT_CONFIG;
+    ret_code_t           err_code;
+
+    err_code = nrf_drv_rng_init(&config);
+    if ((err_code != NRF_SUCCESS) && (err_code != NRF_ERROR_MODULE_ALREADY_INITIALIZED))
+    {
+        return err_code;
+    }
+    err_code = app_timer_create(&m_refill_timer, APP_TIMER_MODE_SINGLE_SHOT, refill_timer_handler);
+    VERIFY_SUCCESS(err_code);
+
+    // What the source has now; the rest comes from the timer.
+    if (!refill())
+    {
+        refill_start();
+    }
+    return NRF_SUCCESS;
+}
+
+
+void rand_pool_get(uint8_t * p_buf, uint8_t len)
+{
+    uint8_t taken;
+    bool    low;
+
+    CRITICAL_REGION_ENTER();
+    taken    = MIN(len, m_level);
+    m_level -= taken;
+    memcpy(p_buf, &m_pool[m_level], taken);
+    memset(&m_pool[m_level], 0, taken);
+    low      = (m_level < RAND_POOL_LOW);
+    CRITICAL_REGION_EXIT();
+
+    if (taken < len)
+    {
+        // Run dry: nonces keep coming, a little later.
+        m_misses++;
+        nrf_drv_rng_block_rand(&p_buf[taken], len - taken);
+    }
+    if (low)
+    {
+        refill_start();
+    }
+}
+
+
+uint8_t rand_pool_level(void)
+{
+    return m_level;
+}
+
+
+uint32_t rand_pool_misses(void)
+{
+    return m_misses;
+}
+
+#endif //NRF_MODULE_ENABLED(RAND_POOL)
@@ -0,0 +1,35 @@
+#ifndef _RAND_POOL_H_
+#define _RAND_POOL_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* Random bytes kept ready for nonces, challenges and diversified keys:
+ *
+ *   pool      RAND_POOL_SIZE bytes in RAM, handed out from the top; a byte handed out is
+ *             wiped from the pool at once
+ *   source    nrf_drv_rng, with the bias correction of the RNG on; the SoftDevice pool while
+ *             it is enabled, the RNG interrupt otherwise
+ *   refill    once the pool is below RAND_POOL_LOW, an app_timer takes whatever the source has
+ *             every RAND_POOL_REFILL_MS, until the pool is full again
+ *
+ * rand_pool_get() does not fail and does not wait while the pool holds enough; only a pool run
+ * dry waits for the source, and counts as a miss. */
+
+/**@brief Start the source and fill the pool. Call after app_timer and the SoftDevice. */
+ret_code_t rand_pool_init(void);
+
+/**@brief Random bytes, any context.
+ *
+ * @param[out] p_buf  Buffer.
+ * @param[in]  len    Bytes, at most RAND_POOL_SIZE to be served from the pool alone.
+ */
+void rand_pool_get(uint8_t * p_buf, uint8_t len);
+
+/**@brief Bytes in the pool. */
+uint8_t rand_pool_level(void);
+
+/**@brief Calls of rand_pool_get() that had to wait for the source. */
+uint32_t rand_pool_misses(void);
+
+#endif
@@ -0,0 +1,261 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(SD_LOG)
+#include "sd_log.h"
+#include "lock_journal.h"
+#include "nrf_block_dev_sdc.h"
+#include "diskio_blkdev.h"
+#include "ff.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include <string.h>
+#ifdef SOFTDEVICE_PRESENT
+#include "softdevice_handler.h"
+#endif
+
+#if !NRF_MODULE_ENABLED(LOCK_JOURNAL) || !NRF_MODULE_ENABLED(APP_SDCARD)
+#error "sd_log needs LOCK_JOURNAL_ENABLED and APP_SDCARD_ENABLED"
+#endif
+#if NRF_MODULE_ENABLED(SPI_BUS) && (APP_SDCARD_SPI_INSTANCE == 0)
+#error "SPI0 belongs to spi_bus, give app_sdcard another SPI instance"
+#endif
+#if NRF_MODULE_ENABLED(TWI_BUS) && (APP_SDCARD_SPI_INSTANCE == 1)
+#error "SPI1 shares its peripheral with the TWI1 of twi_bus"
+#endif
+
+#define SD_LOG_TICKS(ms)        APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+#define SD_LOG_SECTOR_SIZE      512
+#define SD_LOG_PER_SECTOR       (SD_LOG_SECTOR_SIZE / sizeof(lock_journal_entry_t))
+#define SD_LOG_BUF_ENTRIES      (SD_LOG_BUF_SECTORS * SD_LOG_PER_SECTOR)
+
+STATIC_ASSERT(SD_LOG_SECTOR_SIZE % sizeof(lock_journal_entry_t) == 0);
+
+NRF_BLOCK_DEV_SDC_DEFINE(
+        m_block_dev_sdc,
+        NRF_BLOCK_DEV_SDC_CONFIG(SD_LOG_SECTOR_SIZE,
+                                 APP_SDCARD_CONFIG(SD_LOG_MOSI_PIN, SD_LOG_MISO_PIN,
+                                                   SD_LOG_SCK_PIN, SD_LOG_CS_PIN)),
+        NFR_BLOCK_DEV_INFO_CONFIG("Lock", "SD log", "1.00"));
+
+APP_TIMER_DEF(m_sync_timer);
+
+static FATFS                m_fs;
+static FIL                  m_file;
+static bool                 m_open;
+static bool                 m_dirty;        /**< Written since the last f_sync(). */
+static uint32_t             m_next;         /**< Next journal entry to copy. */
+static uint16_t             m_count;        /**< Entries in m_buf. */
+static volatile bool        m_pump_queued;
+static lock_journal_entry_t m_buf[SD_LOG_BUF_ENTRIES];
+
+
+static void cpu_wait(void)
+{
+#ifdef SOFTDEVICE_PRESENT
+    if (softdevice_handler_is_enabled())
+    {
+        UNUSED_RETURN_VALUE(sd_app_evt_wait());
+        return;
+    }
+#endif
+    __WFE();
+    __SEV();
+    __WFE();
+}
+
+
+static void card_close(void)
+{
+    UNUSED_RETURN_VALUE(f_close(&m_file));
+    UNUSED_RETURN_VALUE(f_mount(NULL, "", 0));
+    UNUSED_RETURN_VALUE(disk_uninitialize(0));
+    m_open  = false;
+    m_dirty = false;
+    m_count = 0;        // still in the journal, read again after the next mount
+}
+
+
+/**@brief First entry not in the file, from its last sector in m_buf. */
+static uint32_t resume_seq(uint32_t default_seq)
+{
+    for (uint32_t i = SD_LOG_PER_SECTOR; i > 0; i--)
+    {
+        if (m_buf[i - 1].seq != SD_LOG_SEQ_PAD)
+        {
+            return m_buf[i - 1].seq + 1;
+        }
+    }
+    return default_seq;
+}
+
+
+static bool card_open(void)
+{
+    FSIZE_t size;
+    UINT    len;
+
+    if (disk_initialize(0) != 0)
+    {
+        UNUSED_RETURN_VALUE(disk_uninitialize(0));
+        return false;
+    }
+    if ((f_mount(&m_fs, "", 1) != FR_OK) ||
+        (f_open(&m_file, SD_LOG_FILE_NAME, FA_OPEN_ALWAYS | FA_READ | FA_WRITE) != FR_OK))
+    {
+        UNUSED_RETURN_VALUE(f_mount(NULL, "", 0));
+        UNUSED_RETURN_VALUE(disk_uninitialize(0));
+        return false;
+    }
+    m_open = true;
+
+    // Only whole sectors are written; a tail from elsewhere is written over.
+    size   = f_size(&m_file) & ~(FSIZE_t)(SD_LOG_SECTOR_SIZE - 1);
+    m_next = lock_journal_oldest();
+    if (size != 0)
+    {
+        if ((f_lseek(&m_file, size - SD_LOG_SECTOR_SIZE) != FR_OK) ||
+            (f_read(&m_file, m_buf, SD_LOG_SECTOR_SIZE, &len) != FR_OK) ||
+            (len != SD_LOG_SECTOR_SIZE))
+        {
+            card_close();
+            return false;
+        }
+        m_next = resume_seq(m_next);
+    }
+    if (f_lseek(&m_file, size) != FR_OK)
+    {
+        card_close();
+        return false;
+    }
+
+    // Entries dropped by the journal are gone; a file ahead of the journal waits for it.
+    m_next  = MAX(m_next, lock_journal_oldest());
+    m_next  = MIN(m_next, lock_journal_head());
+    m_count = 0;
+    return true;
+}
+
+
+/**@brief Write the sectors of m_buf, the last one padded. */
+static void buf_flush(void)
+{
+    uint32_t sectors = (m_count + SD_LOG_PER_SECTOR - 1) / SD_LOG_PER_SECTOR;
+    UINT     len;
+
+    if (m_count == 0)
+    {
+        return;
+    }
+    memset(&m_buf[m_count], 0xFF, (sectors * SD_LOG_PER_SECTOR - m_count) * sizeof(m_buf[0]));
+
+    if ((f_write(&m_file, m_buf, sectors * SD_LOG_SECTOR_SIZE, &len) != FR_OK) ||
+        (len != sectors * SD_LOG_SECTOR_SIZE))
+    {
+        card_close();
+        return;
+    }
+    m_count = 0;
+    m_dirty = true;
+}
+
+
+/**@brief Copy the new journal entries to m_buf, writing it out each time it is full. */
+static void pump(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    m_pump_queued = false;
+
+    while (m_open && (m_next != lock_journal_head()))
+    {
+        if (m_next < lock_journal_oldest())
+        {
+            m_next = lock_journal_oldest();
+            continue;
+        }
+
+        // A slot torn by a reset is skipped.
+        if (lock_journal_read(m_next, &m_buf[m_count]) == NRF_SUCCESS)
+        {
+            m_count++;
+        }
+        m_next++;
+
+        if (m_count == SD_LOG_BUF_ENTRIES)
+        {
+            buf_flush();
+        }
+    }
+}
+
+
+static void sync_handler(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    if (!m_open)
+    {
+        if (!card_open())
+        {
+            return;
+        }
+        pump(NULL, 0);
+    }
+
+    buf_flush();
+    if (m_open && m_dirty)
+    {
+        if (f_sync(&m_file) != FR_OK)
+        {
+            card_close();
+            return;
+        }
+        m_dirty = false;
+    }
+}
+
+
+static void sync_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+    UNUSED_RETURN_VALUE(app_sched_event_put(NULL, 0, sync_handler));
+}
+
+
+void sd_log_kick(void)
+{
+    if (m_pump_queued)
+    {
+        return;
+    }
+    m_pump_queued = true;
+    if (app_sched_event_put(NULL, 0, pump) != NRF_SUCCESS)
+    {
+        // The sync tick picks the entries up.
+        m_pump_queued = false;
+    }
+}
+
+
+ret_code_t sd_log_init(void)
+{
+    static diskio_blkdev_t drives[] =
+    {
+        DISKIO_BLOCKDEV_CONFIG(NRF_BLOCKDEV_BASE_ADDR(m_block_dev_sdc, block_dev), cpu_wait)
+    };
+    ret_code_t err_code;
+
+    diskio_blockdev_register(drives, ARRAY_SIZE(drives));
+
+    err_code = app_timer_create(&m_sync_timer, APP_TIMER_MODE_REPEATED, sync_timer_handler);
+    VERIFY_SUCCESS(err_code);
+
+    if (card_open())
+    {
+        sd_log_kick();
+    }
+    return app_timer_start(m_sync_timer, SD_LOG_TICKS(SD_LOG_SYNC_S * 1000), NULL);
+}
+
+#endif //NRF_MODULE_ENABLED(SD_LOG)
@@ -0,0 +1,36 @@
+#ifndef _SD_LOG_H_
+#define _SD_LOG_H_
+#include <stdint.h>
+#include "sdk_errors.h"
+
+/* Journal entries copied to an SD card for bulk export, for gates that log more than the
+ * MX25 journal holds:
+ *
+ *   file      SD_LOG_FILE_NAME in the root of a FAT card: the lock_journal_entry_t records
+ *             as the journal decodes them (seq, time, type and len, data), 32 to a sector,
+ *             so the file is read back with one fixed-size struct per 16 bytes
+ *   batching  entries are read from the journal into SD_LOG_BUF_SECTORS sectors of RAM and
+ *             written with one f_write() once full, a multi-block write on the card
+ *   sync      every SD_LOG_SYNC_S seconds, and only if something was written: a sector still
+ *             filling up is padded with 0xFF records (seq 0xFFFFFFFF) and written, then
+ *             f_sync(); never per entry
+ *   resume    the journal stays the source, so entries in RAM are not lost on a reset: the
+ *             sink starts after the last record found in the file; a card that fails or is
+ *             pulled is mounted again at the next sync */
+
+#define SD_LOG_FILE_NAME    "EVENTS.BIN"
+#define SD_LOG_SEQ_PAD      0xFFFFFFFF      /**< Seq of a padding record. */
+
+/**@brief Register the card with FatFs, mount it and find where to resume.
+ *
+ * @details Call after lock_journal_init() and app_timer. A missing card is not an error, it
+ *          is looked for again at each sync.
+ */
+ret_code_t sd_log_init(void);
+
+/**@brief Tell the sink the journal has new entries. Any context; the copy runs from
+ *        app_scheduler.
+ */
+void sd_log_kick(void);
+
+#endif
@@ -0,0 +1,402 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(SPI_BUS)
+#include "spi_bus.h"
+#include "nrf_gpio.h"
+#include "nrf_drv_common.h"
+#include "app_error.h"
+#include "app_util_platform.h"
+#include "nrf_assert.h"
+#include <string.h>
+#ifdef SOFTDEVICE_PRESENT
+#include "softdevice_handler.h"
+#endif
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+#include "pwr_idle.h"
+#endif
+#if NRF_MODULE_ENABLED(ENERGY)
+#include "energy.h"
+#endif
+
+#if !SPI0_ENABLED
+#error "spi_bus runs on SPI0, set SPI0_ENABLED"
+#endif
+
+typedef enum
+{
+    PHASE_HDR,      /**< Opcode, address and dummy bytes. */
+    PHASE_TX,
+    PHASE_RX,
+    PHASE_END,
+} phase_t;
+
+typedef struct
+{
+    volatile bool       done;
+    volatile ret_code_t result;
+} perform_ctx_t;
+
+static const nrf_drv_spi_t m_spi = NRF_DRV_SPI_INSTANCE(0);
+
+static bool                     m_initialized;
+static spi_bus_cmd_t *          mp_head;
+static spi_bus_cmd_t *          mp_tail;
+static spi_bus_cmd_t * volatile mp_current;     /**< Holds CS low, or NULL. */
+static spi_bus_dev_t const *    mp_config;      /**< Part the peripheral is set up for. */
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+static bool                     m_suspended;    /**< Peripheral disabled between commands. */
+#endif
+#ifdef SPIM_PRESENT
+static uint8_t                  m_dma_buf[SPI_BUS_XFER_MAX];    /**< Data out from flash, for EasyDMA. */
+#endif
+
+
+static void cpu_wait(void)
+{
+#ifdef SOFTDEVICE_PRESENT
+    if (softdevice_handler_is_enabled())
+    {
+        UNUSED_RETURN_VALUE(sd_app_evt_wait());
+        return;
+    }
+#endif
+    __WFE();
+    __SEV();
+    __WFE();
+}
+
+
+/**@brief Clock, mode and bit order of the next part; only between commands. */
+static void dev_configure(spi_bus_dev_t const * p_dev)
+{
+    if (p_dev == mp_config)
+    {
+        return;
+    }
+    mp_config = p_dev;
+
+#ifdef SPIM_PRESENT
+    if (m_spi.use_easy_dma)
+    {
+        nrf_spim_frequency_set((NRF_SPIM_Type *)m_spi.p_registers, (nrf_spim_frequency_t)p_dev->frequency);
+        nrf_spim_configure((NRF_SPIM_Type *)m_spi.p_registers,
+                           (nrf_spim_mode_t)p_dev->mode,
+                           (nrf_spim_bit_order_t)p_dev->bit_order);
+        return;
+    }
+#endif
+    nrf_spi_frequency_set((NRF_SPI_Type *)m_spi.p_registers, (nrf_spi_frequency_t)p_dev->frequency);
+    nrf_spi_configure((NRF_SPI_Type *)m_spi.p_registers,
+                      (nrf_spi_mode_t)p_dev->mode,
+                      (nrf_spi_bit_order_t)p_dev->bit_order);
+}
+
+
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+static void periph_enable(bool enable)
+{
+#ifdef SPIM_PRESENT
+    if (m_spi.use_easy_dma)
+    {
+        if (enable)
+        {
+            nrf_spim_enable((NRF_SPIM_Type *)m_spi.p_registers);
+        }
+        else
+        {
+            nrf_spim_disable((NRF_SPIM_Type *)m_spi.p_registers);
+        }
+        return;
+    }
+#endif
+    if (enable)
+    {
+        nrf_spi_enable((NRF_SPI_Type *)m_spi.p_registers);
+    }
+    else
+    {
+        nrf_spi_disable((NRF_SPI_Type *)m_spi.p_registers);
+    }
+}
+
+
+/**@brief pwr_idle hook: disable SPI0 while no command is queued; next_start() enables it. */
+static bool bus_idle(void)
+{
+    bool down = false;
+
+    CRITICAL_REGION_ENTER();
+    if (!m_suspended && (mp_current == NULL) && (mp_head == NULL))
+    {
+        periph_enable(false);
+        m_suspended = true;
+        down        = true;
+    }
+    CRITICAL_REGION_EXIT();
+    return down;
+}
+
+
+static const pwr_idle_hook_t m_idle_hook =
+{
+    .idle    = bus_idle,
+    .wake_us = 1,
+};
+#endif
+
+
+/**@brief Start the next part of the command.
+ *
+ * @return false when every phase is done.
+ */
+static bool phase_step(spi_bus_cmd_t * p_cmd)
+{
+    while (p_cmd->phase < PHASE_END)
+    {
+        uint8_t const * p_tx = NULL;
+        uint8_t *       p_rx = NULL;
+        uint16_t        len;
+
+        switch (p_cmd->phase)
+        {
+            case PHASE_HDR:
+                p_tx = p_cmd->hdr;
+                len  = 1 + p_cmd->addr_len + p_cmd->dummy_len;
+                break;
+
+            case PHASE_TX:
+                p_tx = p_cmd->p_tx;
+                len  = (p_tx != NULL) ? p_cmd->tx_len : 0;
+                break;
+
+            default:
+                p_rx = p_cmd->p_rx;
+                len  = (p_rx != NULL) ? p_cmd->rx_len : 0;
+                break;
+        }
+
+        if (p_cmd->done < len)
+        {
+            uint8_t  chunk = MIN(len - p_cmd->done, SPI_BUS_XFER_MAX);
+            uint16_t pos   = p_cmd->done;
+
+            if (p_tx != NULL)
+            {
+                p_tx = &p_tx[pos];
+            }
+#ifdef SPIM_PRESENT
+            // SPIM reads RAM only; data out from flash goes through the copy, a part at a time.
+            if (m_spi.use_easy_dma && (p_tx != NULL) && !nrf_drv_is_in_RAM(p_tx))
+            {
+                memcpy(m_dma_buf, p_tx, chunk);
+                p_tx = m_dma_buf;
+            }
+#endif
+            p_cmd->done += chunk;
+            APP_ERROR_CHECK(nrf_drv_spi_transfer(&m_spi,
+                                                 p_tx,
+                                                 (p_tx != NULL) ? chunk : 0,
+                                                 (p_rx != NULL) ? &p_rx[pos] : NULL,
+                                                 (p_rx != NULL) ? chunk : 0));
+            return true;
+        }
+
+        p_cmd->phase++;
+        p_cmd->done = 0;
+    }
+    return false;
+}
+
+
+/**@brief Start the first queued command if no command holds the bus. */
+static void next_start(void)
+{
+    spi_bus_cmd_t * p_cmd = NULL;
+
+    CRITICAL_REGION_ENTER();
+    if ((mp_current == NULL) && (mp_head != NULL))
+    {
+        p_cmd   = mp_head;
+        mp_head = p_cmd->p_next;
+        if (mp_head == NULL)
+        {
+            mp_tail = NULL;
+        }
+        mp_current = p_cmd;
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+        if (m_suspended)
+        {
+            periph_enable(true);
+            m_suspended = false;
+        }
+#endif
+    }
+#if NRF_MODULE_ENABLED(ENERGY)
+    if (mp_current != NULL)
+    {
+        energy_on(ENERGY_SPI);
+    }
+    else
+    {
+        energy_off(ENERGY_SPI);
+    }
+#endif
+    CRITICAL_REGION_EXIT();
+
+    if (p_cmd == NULL)
+    {
+        return;
+    }
+
+    dev_configure(p_cmd->p_dev);
+    p_cmd->phase = PHASE_HDR;
+    p_cmd->done  = 0;
+    nrf_gpio_pin_clear(p_cmd->p_dev->ss_pin);
+    // The header is never empty, so the first step starts a transfer.
+    UNUSED_RETURN_VALUE(phase_step(p_cmd));
+}
+
+
+static void spi_evt_handler(nrf_drv_spi_evt_t const * p_event)
+{
+    spi_bus_cmd_t * p_cmd = mp_current;
+
+    UNUSED_PARAMETER(p_event);
+
+    if ((p_cmd == NULL) || phase_step(p_cmd))
+    {
+        return;
+    }
+
+    nrf_gpio_pin_set(p_cmd->p_dev->ss_pin);
+    mp_current    = NULL;
+    p_cmd->queued = false;
+
+    // The callback may queue the command again.
+    if (p_cmd->callback != NULL)
+    {
+        p_cmd->callback(NRF_SUCCESS, p_cmd->p_context);
+    }
+    next_start();
+}
+
+
+ret_code_t spi_bus_init(void)
+{
+    ret_code_t           err_code;
+    nrf_drv_spi_config_t config = NRF_DRV_SPI_DEFAULT_CONFIG;
+
+    if (m_initialized)
+    {
+        return NRF_SUCCESS;
+    }
+
+    // Chip selects are driven here, one per part.
+    config.ss_pin       = NRF_DRV_SPI_PIN_NOT_USED;
+    config.sck_pin      = SPI_BUS_SCK_PIN;
+    config.mosi_pin     = SPI_BUS_MOSI_PIN;
+    config.miso_pin     = SPI_BUS_MISO_PIN;
+    config.irq_priority = SPI_BUS_IRQ_PRIORITY;
+    config.orc          = 0xCC;
+
+    err_code = nrf_drv_spi_init(&m_spi, &config, spi_evt_handler);
+    VERIFY_SUCCESS(err_code);
+
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+    err_code = pwr_idle_register(&m_idle_hook);
+    VERIFY_SUCCESS(err_code);
+#endif
+
+    m_initialized = true;
+    return NRF_SUCCESS;
+}
+
+
+void spi_bus_dev_init(spi_bus_dev_t const * p_dev)
+{
+    nrf_gpio_pin_set(p_dev->ss_pin);
+    nrf_gpio_cfg_output(p_dev->ss_pin);
+}
+
+
+ret_code_t spi_bus_schedule(spi_bus_cmd_t * p_cmd)
+{
+    ret_code_t err_code = NRF_SUCCESS;
+
+    if ((p_cmd->addr_len > SPI_BUS_ADDR_MAX) || (p_cmd->dummy_len > SPI_BUS_DUMMY_MAX))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    CRITICAL_REGION_ENTER();
+    if (p_cmd->queued)
+    {
+        err_code = NRF_ERROR_BUSY;
+    }
+    else
+    {
+        p_cmd->queued = true;
+    }
+    CRITICAL_REGION_EXIT();
+    VERIFY_SUCCESS(err_code);
+
+    // Not on the queue yet: the header can be laid out without the bus.
+    p_cmd->hdr[0] = p_cmd->opcode;
+    for (uint8_t i = 0; i < p_cmd->addr_len; i++)
+    {
+        p_cmd->hdr[1 + i] = (uint8_t)(p_cmd->addr >> (8 * (p_cmd->addr_len - 1 - i)));
+    }
+    memset(&p_cmd->hdr[1 + p_cmd->addr_len], 0, p_cmd->dummy_len);
+
+    CRITICAL_REGION_ENTER();
+    p_cmd->p_next = NULL;
+    if (mp_tail == NULL)
+    {
+        mp_head = p_cmd;
+    }
+    else
+    {
+        mp_tail->p_next = p_cmd;
+    }
+    mp_tail = p_cmd;
+    CRITICAL_REGION_EXIT();
+
+    next_start();
+    return NRF_SUCCESS;
+}
+
+
+static void perform_done(ret_code_t result, void * p_context)
+{
+    perform_ctx_t * p_ctx = (perform_ctx_t *)p_context;
+
+    p_ctx->result = result;
+    p_ctx->done   = true;
+}
+
+
+ret_code_t spi_bus_perform(spi_bus_cmd_t * p_cmd)
+{
+    perform_ctx_t ctx = {.done = false};
+    ret_code_t    err_code;
+
+    ASSERT(current_int_priority_get() == APP_IRQ_PRIORITY_THREAD);
+
+    p_cmd->callback  = perform_done;
+    p_cmd->p_context = &ctx;
+    err_code = spi_bus_schedule(p_cmd);
+    VERIFY_SUCCESS(err_code);
+
+    while (!ctx.done)
+    {
+        cpu_wait();
+    }
+    return ctx.result;
+}
+
+
+bool spi_bus_idle(void)
+{
+    return (mp_current == NULL) && (mp_head == NULL);
+}
+
+#endif //NRF_MODULE_ENABLED(SPI_BUS)
@@ -0,0 +1,88 @@
+#ifndef __SPI_BUS_H__
+#define __SPI_BUS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "nrf_drv_spi.h"
+
+/* SPI0 shared by the MX25 and other SPI parts, one queued command at a time:
+ *
+ *   device     chip select pin, clock, mode and bit order of one part; set before each of its
+ *              commands, so parts with other settings share the bus
+ *   command    the phases of one chip select: opcode, address, dummy bytes, then data out
+ *              and data in; the bus pulls CS low before the opcode and lets it go after the
+ *              last phase, and chains the phases and the SPI_BUS_XFER_MAX byte parts of
+ *              longer data from the SPI interrupt
+ *   queue      commands are owned by the caller and queued by pointer, run in order
+ *   callback   from the SPI interrupt, at SPI_BUS_IRQ_PRIORITY, after CS has gone high
+ *
+ * spi_bus_perform() runs a command and sleeps until it is done, for thread mode callers. */
+
+#define SPI_BUS_ADDR_MAX   4        /**< Address bytes of a command. */
+#define SPI_BUS_DUMMY_MAX  3        /**< Dummy bytes of a command. */
+#define SPI_BUS_XFER_MAX   255      /**< Longest transfer of one nrf_drv_spi_transfer() call. */
+
+/**@brief One part on the bus. */
+typedef struct
+{
+    uint8_t                   ss_pin;
+    nrf_drv_spi_frequency_t   frequency;
+    nrf_drv_spi_mode_t        mode;
+    nrf_drv_spi_bit_order_t   bit_order;
+} spi_bus_dev_t;
+
+typedef void (*spi_bus_callback_t)(ret_code_t result, void * p_context);
+
+/**@brief A command. Fill in the members up to p_context; the rest belong to the bus. The
+ *        command and its buffers must stay valid until the callback.
+ */
+typedef struct spi_bus_cmd_s
+{
+    spi_bus_dev_t const * p_dev;
+    uint8_t               opcode;
+    uint8_t               addr_len;     /**< 0 to SPI_BUS_ADDR_MAX, sent MSB first. */
+    uint32_t              addr;
+    uint8_t               dummy_len;    /**< 0 to SPI_BUS_DUMMY_MAX, sent as 0. */
+    uint8_t const *       p_tx;         /**< Data out after the dummy bytes, or NULL. */
+    uint16_t              tx_len;
+    uint8_t *             p_rx;         /**< Data in after the data out, or NULL. */
+    uint16_t              rx_len;
+    spi_bus_callback_t    callback;     /**< May be NULL. */
+    void *                p_context;
+
+    struct spi_bus_cmd_s * p_next;
+    uint8_t                hdr[1 + SPI_BUS_ADDR_MAX + SPI_BUS_DUMMY_MAX];
+    uint8_t                phase;
+    uint16_t               done;        /**< Bytes of the phase already moved. */
+    volatile bool          queued;
+} spi_bus_cmd_t;
+
+/**@brief Initialize SPI0, once. Later calls return NRF_SUCCESS, so each driver on the bus
+ *        may call it.
+ */
+ret_code_t spi_bus_init(void);
+
+/**@brief Drive the chip select of a part high, before the first command to any part. */
+void spi_bus_dev_init(spi_bus_dev_t const * p_dev);
+
+/**@brief Queue a command and start it if the bus is free. Any context.
+ *
+ * @retval NRF_SUCCESS              Queued; the callback reports the result.
+ * @retval NRF_ERROR_INVALID_PARAM  Address or dummy phase too long.
+ * @retval NRF_ERROR_BUSY           The command is still queued or running.
+ */
+ret_code_t spi_bus_schedule(spi_bus_cmd_t * p_cmd);
+
+/**@brief Run a command behind the queued ones and sleep until it has finished.
+ *
+ * @details The callback and p_context of @p p_cmd are taken for the wait.
+ *
+ * @note Thread mode only: the SPI interrupt has to be able to run.
+ */
+ret_code_t spi_bus_perform(spi_bus_cmd_t * p_cmd);
+
+/**@brief Whether no command is queued or running. */
+bool spi_bus_idle(void);
+
+#endif
@@ -0,0 +1,221 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(USB_SERVICE)
+#include "usb_service.h"
+#include "nrf_block_dev_journal.h"
+#include "app_usbd.h"
+#include "app_usbd_cdc_acm.h"
+#include "app_usbd_msc.h"
+#include "app_error.h"
+#ifdef SOFTDEVICE_PRESENT
+#include "nrf_soc.h"
+#endif
+
+#ifndef USBD_PRESENT
+#error "usb_service needs the USBD of the nRF52840"
+#endif
+#if !NRF_MODULE_ENABLED(APP_USBD) || !NRF_MODULE_ENABLED(APP_USBD_CLASS_CDC_ACM) || \
+    !NRF_MODULE_ENABLED(APP_USBD_CLASS_MSC)
+#error "usb_service needs APP_USBD_ENABLED, APP_USBD_CLASS_CDC_ACM_ENABLED and APP_USBD_CLASS_MSC_ENABLED"
+#endif
+#if !NRF_MODULE_ENABLED(NRF_BLOCK_DEV_JOURNAL)
+#error "usb_service needs NRF_BLOCK_DEV_JOURNAL_ENABLED"
+#endif
+
+#define CDC_ACM_COMM_INTERFACE  0
+#define CDC_ACM_COMM_EPIN       NRF_DRV_USBD_EPIN2
+#define CDC_ACM_DATA_INTERFACE  1
+#define CDC_ACM_DATA_EPIN       NRF_DRV_USBD_EPIN1
+#define CDC_ACM_DATA_EPOUT      NRF_DRV_USBD_EPOUT1
+#define MSC_INTERFACE           2
+
+#define MSC_WORKBUFFER_SIZE     4096        /**< One journal sector per flash read. */
+
+static void cdc_acm_user_ev_handler(app_usbd_class_inst_t const * p_inst,
+                                    app_usbd_cdc_acm_user_event_t event);
+
+static const uint8_t m_cdc_acm_desc[] = {
+    APP_USBD_CDC_ACM_DEFAULT_DESC(CDC_ACM_COMM_INTERFACE,
+                                  CDC_ACM_COMM_EPIN,
+                                  CDC_ACM_DATA_INTERFACE,
+                                  CDC_ACM_DATA_EPIN,
+                                  CDC_ACM_DATA_EPOUT)
+};
+
+APP_USBD_CDC_ACM_GLOBAL_DEF(m_cdc_acm,
+                            APP_USBD_CDC_ACM_CONFIG(CDC_ACM_COMM_INTERFACE,
+                                                    CDC_ACM_COMM_EPIN,
+                                                    CDC_ACM_DATA_INTERFACE,
+                                                    CDC_ACM_DATA_EPIN,
+                                                    CDC_ACM_DATA_EPOUT),
+                            cdc_acm_user_ev_handler,
+                            m_cdc_acm_desc);
+
+NRF_BLOCK_DEV_JOURNAL_DEFINE(m_journal, NFR_BLOCK_DEV_INFO_CONFIG("Lock", "Journal", "1.00"));
+
+/* The MSC class takes block device events in the USB interrupt, where it calls the device;
+ * the journal sends them from app_scheduler. m_disk sits in between and sends them with the
+ * USB interrupt masked. */
+static ret_code_t disk_init(nrf_block_dev_t const * p_blk_dev,
+                            nrf_block_dev_ev_handler ev_handler,
+                            void const * p_context);
+static ret_code_t disk_uninit(nrf_block_dev_t const * p_blk_dev);
+static ret_code_t disk_read_req(nrf_block_dev_t const * p_blk_dev, nrf_block_req_t const * p_blk);
+static ret_code_t disk_write_req(nrf_block_dev_t const * p_blk_dev, nrf_block_req_t const * p_blk);
+static ret_code_t disk_ioctl(nrf_block_dev_t const * p_blk_dev,
+                             nrf_block_dev_ioctl_req_t req,
+                             void * p_data);
+static nrf_block_dev_geometry_t const * disk_geometry(nrf_block_dev_t const * p_blk_dev);
+
+static const nrf_block_dev_ops_t m_disk_ops = {
+        .init = disk_init,
+        .uninit = disk_uninit,
+        .read_req = disk_read_req,
+        .write_req = disk_write_req,
+        .ioctl = disk_ioctl,
+        .geometry = disk_geometry,
+};
+
+static const nrf_block_dev_t m_disk = { .p_ops = &m_disk_ops };
+
+APP_USBD_MSC_GLOBAL_DEF(m_msc,
+                        MSC_INTERFACE,
+                        NULL,
+                        APP_USBD_MSC_ENDPOINT_LIST(3, 3),
+                        (&m_disk),
+                        MSC_WORKBUFFER_SIZE);
+
+static nrf_block_dev_ev_handler m_msc_ev_handler;
+static usb_service_rx_handler_t m_rx_handler;
+static uint8_t                  m_rx_buf[NRF_DRV_USBD_EPSIZE];
+
+
+static nrf_block_dev_t const * journal_dev(void)
+{
+    return nrf_block_dev_journal_ops_get(&m_journal);
+}
+
+
+static void disk_ev_handler(nrf_block_dev_t const * p_blk_dev, nrf_block_dev_event_t const * p_event)
+{
+    uint32_t reg  = (uint32_t)USBD_IRQn >> 5;
+    uint32_t mask = 1UL << ((uint32_t)USBD_IRQn & 0x1F);
+    bool     was_enabled;
+
+    UNUSED_PARAMETER(p_blk_dev);
+
+    // Also called in the USB interrupt, from disk_init(), or before the USB is enabled.
+    was_enabled = (NVIC->ISER[reg] & mask) != 0;
+    NVIC_DisableIRQ(USBD_IRQn);
+    m_msc_ev_handler(&m_disk, p_event);
+    if (was_enabled)
+    {
+        NVIC_EnableIRQ(USBD_IRQn);
+    }
+}
+
+
+static ret_code_t disk_init(nrf_block_dev_t const * p_blk_dev,
+                            nrf_block_dev_ev_handler ev_handler,
+                            void const * p_context)
+{
+    UNUSED_PARAMETER(p_blk_dev);
+
+    m_msc_ev_handler = ev_handler;
+    return nrf_blk_dev_init(journal_dev(), (ev_handler != NULL) ? disk_ev_handler : NULL, p_context);
+}
+
+
+static ret_code_t disk_uninit(nrf_block_dev_t const * p_blk_dev)
+{
+    UNUSED_PARAMETER(p_blk_dev);
+    return nrf_blk_dev_uninit(journal_dev());
+}
+
+
+static ret_code_t disk_read_req(nrf_block_dev_t const * p_blk_dev, nrf_block_req_t const * p_blk)
+{
+    UNUSED_PARAMETER(p_blk_dev);
+    return nrf_blk_dev_read_req(journal_dev(), p_blk);
+}
+
+
+static ret_code_t disk_write_req(nrf_block_dev_t const * p_blk_dev, nrf_block_req_t const * p_blk)
+{
+    UNUSED_PARAMETER(p_blk_dev);
+    return nrf_blk_dev_write_req(journal_dev(), p_blk);
+}
+
+
+static ret_code_t disk_ioctl(nrf_block_dev_t const * p_blk_dev,
+                             nrf_block_dev_ioctl_req_t req,
+                             void * p_data)
+{
+    UNUSED_PARAMETER(p_blk_dev);
+    return nrf_blk_dev_ioctl(journal_dev(), req, p_data);
+}
+
+
+static nrf_block_dev_geometry_t const * disk_geometry(nrf_block_dev_t const * p_blk_dev)
+{
+    UNUSED_PARAMETER(p_blk_dev);
+    return nrf_blk_dev_geometry(journal_dev());
+}
+
+
+static void cdc_acm_user_ev_handler(app_usbd_class_inst_t const * p_inst,
+                                    app_usbd_cdc_acm_user_event_t event)
+{
+    app_usbd_cdc_acm_t const * p_cdc_acm = app_usbd_cdc_acm_class_get(p_inst);
+
+    switch (event)
+    {
+        case APP_USBD_CDC_ACM_USER_EVT_PORT_OPEN:
+            UNUSED_RETURN_VALUE(app_usbd_cdc_acm_read(p_cdc_acm, m_rx_buf, sizeof(m_rx_buf)));
+            break;
+
+        case APP_USBD_CDC_ACM_USER_EVT_RX_DONE:
+        {
+            size_t size = app_usbd_cdc_acm_rx_size(p_cdc_acm);
+
+            if ((size != 0) && (m_rx_handler != NULL))
+            {
+                m_rx_handler(m_rx_buf, (uint16_t)size);
+            }
+            // Fails once the port is closed; PORT_OPEN starts again.
+            UNUSED_RETURN_VALUE(app_usbd_cdc_acm_read(p_cdc_acm, m_rx_buf, sizeof(m_rx_buf)));
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+
+ret_code_t usb_service_init(usb_service_rx_handler_t rx_handler)
+{
+    ret_code_t err_code;
+
+    m_rx_handler = rx_handler;
+
+#ifdef SOFTDEVICE_PRESENT
+    err_code = sd_clock_hfclk_request();
+    VERIFY_SUCCESS(err_code);
+#else
+    NRF_CLOCK->TASKS_HFCLKSTART = 1;
+#endif
+
+    err_code = app_usbd_init();
+    VERIFY_SUCCESS(err_code);
+
+    err_code = app_usbd_class_append(app_usbd_cdc_acm_class_inst_get(&m_cdc_acm));
+    VERIFY_SUCCESS(err_code);
+
+    err_code = app_usbd_class_append(app_usbd_msc_class_inst_get(&m_msc));
+    VERIFY_SUCCESS(err_code);
+
+    app_usbd_enable();
+    app_usbd_start();
+    return NRF_SUCCESS;
+}
+
+#endif //NRF_MODULE_ENABLED(USB_SERVICE)
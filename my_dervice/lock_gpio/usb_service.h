@@ -0,0 +1,24 @@
+#ifndef _USB_SERVICE_H_
+#define _USB_SERVICE_H_
+#include <stdint.h>
+#include "sdk_errors.h"
+
+/**@brief Commands received on the CDC ACM port, called from the USB interrupt.
+ *
+ * @details Bytes come in the cut of the USB packets, up to 64 at a time, like the UART does
+ *          with no regard to command bounds.
+ */
+typedef void (*usb_service_rx_handler_t)(uint8_t const * p_data, uint16_t len);
+
+/**@brief Start the USB composite device of the nRF52840: a CDC ACM port for commands and a
+ *        mass storage drive with the access journal as JOURNAL.BIN (nrf_block_dev_journal).
+ *
+ * @details The drive is read-only and read in thread mode through app_scheduler, so the
+ *          scheduler must be running. Replies still go on the UART or NUS.
+ *
+ * @note lock_journal_init() must have been called, and the SoftDevice enabled if present:
+ *       the USB needs the HFXO, which is requested here.
+ */
+ret_code_t usb_service_init(usb_service_rx_handler_t rx_handler);
+
+#endif
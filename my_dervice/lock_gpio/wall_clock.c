@@ -0,0 +1,301 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(WALL_CLOCK)
+#include "wall_clock.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "app_util_platform.h"
+#include <string.h>
+#if WALL_CLOCK_CTS_ENABLED
+#include "ble_db_discovery.h"
+#include "ble_cts_c.h"
+
+#if !NRF_MODULE_ENABLED(BLE_CTS_C) || !NRF_MODULE_ENABLED(BLE_DB_DISCOVERY)
+#error "WALL_CLOCK_CTS_ENABLED needs BLE_CTS_C_ENABLED and BLE_DB_DISCOVERY_ENABLED"
+#endif
+#if NRF_MODULE_ENABLED(GW_PUSH)
+#error "ble_db_discovery takes one event handler: WALL_CLOCK_CTS_ENABLED and GW_PUSH_ENABLED exclude each other"
+#endif
+#endif
+
+#define TICK_HZ         (APP_TIMER_CLOCK_FREQ / (APP_TIMER_CONFIG_PRESCALER + 1))
+#define COUNTER_MASK    0x00FFFFFF
+#define FOLD_TICKS      APP_TIMER_TICKS(WALL_CLOCK_FOLD_S * 1000, APP_TIMER_CONFIG_PRESCALER)
+#define PPB             1000000000LL
+#define DRIFT_MAX_PPB   (WALL_CLOCK_DRIFT_MAX_PPM * 1000L)
+
+STATIC_ASSERT(WALL_CLOCK_FOLD_S * TICK_HZ < COUNTER_MASK / 2);
+
+/**@brief Time at the RTC counter value @p counter. Written with the interrupts off. */
+typedef struct
+{
+    uint64_t ticks;     /**< Raw ticks since init. */
+    uint32_t counter;
+    uint32_t time;      /**< Seconds. */
+    uint32_t frac;      /**< Ticks past @p time, below TICK_HZ. */
+} clock_base_t;
+
+APP_TIMER_DEF(m_fold_timer);
+
+static clock_base_t volatile m_base;
+static uint32_t volatile     m_gen;           /**< Odd while the base is being written. */
+static int32_t               m_drift_ppb;
+static int64_t               m_drift_rem;     /**< Correction below one tick, carried over. */
+static bool                  m_synced;
+static uint64_t              m_sync_ticks;    /**< m_base.ticks at the last sync. */
+static wall_clock_handler_t  m_handler;
+
+#if WALL_CLOCK_CTS_ENABLED
+static ble_db_discovery_t m_db_disc;
+static ble_cts_c_t        m_cts;
+#endif
+
+
+/**@brief Move the base to the counter now, with the drift correction. Interrupts off. */
+static void fold(void)
+{
+    uint32_t counter = app_timer_cnt_get();
+    uint32_t delta   = (counter - m_base.counter) & COUNTER_MASK;
+    int64_t  scaled  = (int64_t)delta * m_drift_ppb + m_drift_rem;
+    int64_t  corr    = scaled / PPB;
+    uint32_t frac;
+
+    m_drift_rem = scaled - corr * PPB;
+    frac        = (uint32_t)((int64_t)m_base.frac + delta + corr);
+
+    m_gen++;
+    m_base.ticks   += delta;
+    m_base.counter  = counter;
+    m_base.time    += frac / TICK_HZ;
+    m_base.frac     = frac % TICK_HZ;
+    m_gen++;
+}
+
+
+static void fold_timeout_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    CRITICAL_REGION_ENTER();
+    fold();
+    CRITICAL_REGION_EXIT();
+}
+
+
+typedef struct
+{
+    uint32_t old_time;
+    uint32_t new_time;
+} sync_evt_t;
+
+
+static void sync_handler(void * p_event_data, uint16_t event_size)
+{
+    sync_evt_t const * p_evt = p_event_data;
+
+    UNUSED_PARAMETER(event_size);
+    m_handler(p_evt->old_time, p_evt->new_time);
+}
+
+
+uint32_t wall_clock_now(void)
+{
+    uint32_t gen;
+    uint32_t time;
+    uint32_t frac;
+    uint32_t counter;
+    uint32_t now;
+
+    do
+    {
+        gen     = m_gen;
+        time    = m_base.time;
+        frac    = m_base.frac;
+        counter = m_base.counter;
+        now     = app_timer_cnt_get();
+    } while ((gen & 1) || (gen != m_gen));
+
+    return time + (frac + ((now - counter) & COUNTER_MASK)) / TICK_HZ;
+}
+
+
+uint64_t wall_clock_ticks(void)
+{
+    uint32_t gen;
+    uint64_t ticks;
+    uint32_t counter;
+    uint32_t now;
+
+    do
+    {
+        gen     = m_gen;
+        ticks   = m_base.ticks;
+        counter = m_base.counter;
+        now     = app_timer_cnt_get();
+    } while ((gen & 1) || (gen != m_gen));
+
+    return ticks + ((now - counter) & COUNTER_MASK);
+}
+
+
+bool wall_clock_synced(void)
+{
+    return m_synced;
+}
+
+
+int32_t wall_clock_drift_ppb(void)
+{
+    return m_drift_ppb;
+}
+
+
+void wall_clock_set(uint32_t time, uint8_t fractions256)
+{
+    uint32_t   frac = ((uint32_t)fractions256 * TICK_HZ) / 256;
+    sync_evt_t evt;
+    int64_t    error;
+    uint64_t   elapsed;
+
+    CRITICAL_REGION_ENTER();
+    fold();
+
+    evt.old_time = m_base.time;
+    evt.new_time = time;
+
+    // Ticks the clock was behind since the last sync, with the current correction applied.
+    error   = ((int64_t)time - m_base.time) * TICK_HZ + (int64_t)frac - m_base.frac;
+    elapsed = m_base.ticks - m_sync_ticks;
+    if (m_synced && (elapsed >= (uint64_t)WALL_CLOCK_DRIFT_MIN_S * TICK_HZ) &&
+        (error > -(int64_t)WALL_CLOCK_DRIFT_MAX_STEP_S * TICK_HZ) &&
+        (error <  (int64_t)WALL_CLOCK_DRIFT_MAX_STEP_S * TICK_HZ))
+    {
+        // Half of the residual rate error per sync, so one bad sync does not swing it.
+        int64_t drift = m_drift_ppb + ((error * PPB) / (int64_t)elapsed) / 2;
+
+        m_drift_ppb = (int32_t)MAX(MIN(drift, DRIFT_MAX_PPB), -DRIFT_MAX_PPB);
+    }
+
+    m_gen++;
+    m_base.time = time;
+    m_base.frac = frac;
+    m_gen++;
+
+    m_sync_ticks = m_base.ticks;
+    m_synced     = true;
+    CRITICAL_REGION_EXIT();
+
+    if (m_handler != NULL)
+    {
+        UNUSED_RETURN_VALUE(app_sched_event_put(&evt, sizeof(evt), sync_handler));
+    }
+}
+
+
+#if WALL_CLOCK_CTS_ENABLED
+/**@brief Days from 1970-01-01 to a date of the proleptic Gregorian calendar. */
+static int32_t days_from_civil(int32_t y, uint32_t m, uint32_t d)
+{
+    int32_t  era;
+    uint32_t yoe;
+    uint32_t doy;
+
+    y  -= (m <= 2);
+    era = (y >= 0 ? y : y - 399) / 400;
+    yoe = (uint32_t)(y - era * 400);
+    doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+
+    return era * 146097 + (int32_t)(yoe * 365 + yoe / 4 - yoe / 100 + doy) - 719468;
+}
+
+
+static void cts_handler(ble_cts_c_t * p_cts, ble_cts_c_evt_t * p_evt)
+{
+    switch (p_evt->evt_type)
+    {
+        case BLE_CTS_C_EVT_DISCOVERY_COMPLETE:
+            UNUSED_RETURN_VALUE(ble_cts_c_handles_assign(p_cts, p_evt->conn_handle,
+                                                         &p_evt->params.char_handles));
+            UNUSED_RETURN_VALUE(ble_cts_c_current_time_read(p_cts));
+            break;
+
+        case BLE_CTS_C_EVT_CURRENT_TIME:
+        {
+            ble_date_time_t const * p_dt = &p_evt->params.current_time.exact_time_256.day_date_time.date_time;
+
+            // Year 0 and month 0 mean "not known" in the characteristic.
+            if ((p_dt->year >= 1970) && (p_dt->month >= 1) && (p_dt->month <= 12) && (p_dt->day >= 1))
+            {
+                uint32_t days = (uint32_t)days_from_civil(p_dt->year, p_dt->month, p_dt->day);
+
+                wall_clock_set(days * 86400UL + p_dt->hours * 3600UL + p_dt->minutes * 60UL + p_dt->seconds,
+                               p_evt->params.current_time.exact_time_256.fractions256);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+
+static void cts_error_handler(uint32_t nrf_error)
+{
+    // A phone without CTS, or one that refuses the read: the time comes over NUS instead.
+    UNUSED_PARAMETER(nrf_error);
+}
+
+
+static void db_disc_handler(ble_db_discovery_evt_t * p_evt)
+{
+    ble_cts_c_on_db_disc_evt(&m_cts, p_evt);
+}
+#endif
+
+
+ret_code_t wall_clock_init(wall_clock_handler_t handler)
+{
+    ret_code_t err_code;
+
+    m_handler      = handler;
+    m_base.counter = app_timer_cnt_get();
+
+    err_code = app_timer_create(&m_fold_timer, APP_TIMER_MODE_REPEATED, fold_timeout_handler);
+    VERIFY_SUCCESS(err_code);
+    err_code = app_timer_start(m_fold_timer, FOLD_TICKS, NULL);
+    VERIFY_SUCCESS(err_code);
+
+#if WALL_CLOCK_CTS_ENABLED
+    {
+        ble_cts_c_init_t init;
+
+        err_code = ble_db_discovery_init(db_disc_handler);
+        VERIFY_SUCCESS(err_code);
+
+        init.evt_handler   = cts_handler;
+        init.error_handler = cts_error_handler;
+        err_code = ble_cts_c_init(&m_cts, &init);
+    }
+#endif
+    return err_code;
+}
+
+
+void wall_clock_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+#if WALL_CLOCK_CTS_ENABLED
+    if ((p_ble_evt->header.evt_id == BLE_GAP_EVT_CONNECTED) &&
+        (p_ble_evt->evt.gap_evt.params.connected.role == BLE_GAP_ROLE_PERIPH) &&
+        (m_cts.conn_handle == BLE_CONN_HANDLE_INVALID) && !m_db_disc.discovery_in_progress)
+    {
+        memset(&m_db_disc, 0, sizeof(m_db_disc));
+        UNUSED_RETURN_VALUE(ble_db_discovery_start(&m_db_disc, p_ble_evt->evt.gap_evt.conn_handle));
+    }
+    ble_db_discovery_on_ble_evt(&m_db_disc, p_ble_evt);
+    ble_cts_c_on_ble_evt(&m_cts, p_ble_evt);
+#else
+    UNUSED_PARAMETER(p_ble_evt);
+#endif
+}
+
+#endif //WALL_CLOCK
@@ -0,0 +1,58 @@
+#ifndef _WALL_CLOCK_H_
+#define _WALL_CLOCK_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "ble.h"
+
+/* Wall-clock time from RTC1, set by the phone:
+ *
+ *   counter   the 24-bit app_timer counter, extended to 64 bits by an app_timer that folds
+ *             the ticks since the last fold into the base every WALL_CLOCK_FOLD_S, well
+ *             before the counter wraps
+ *   time      seconds since 1970-01-01 00:00 in the time of the phone, as CTS gives it: local
+ *             time, so schedules compare against it as it is. Until the first sync it counts
+ *             from boot
+ *   sync      TIME_SET over NUS, or the Current Time Service of the phone with
+ *             WALL_CLOCK_CTS_ENABLED; each sets the time and steps the base
+ *   drift     two syncs at least WALL_CLOCK_DRIFT_MIN_S apart give the rate error of the
+ *             32 kHz clock; it is corrected at each fold, in parts per billion
+ *
+ * wall_clock_now() reads the base and the counter, retried only if a fold or a sync ran in
+ * between, and does not correct the drift since the last fold: at most WALL_CLOCK_FOLD_S
+ * times the drift off. */
+
+/**@brief Called from app_scheduler after each sync, with the time before and after it. */
+typedef void (*wall_clock_handler_t)(uint32_t old_time, uint32_t new_time);
+
+/**@brief Start the fold timer, and the CTS client if it is enabled.
+ *
+ * @details Call after app_timer and, for CTS, after ble_stack_init().
+ *
+ * @param[in] handler  Sync handler, or NULL.
+ */
+ret_code_t wall_clock_init(wall_clock_handler_t handler);
+
+/**@brief Current time in seconds. Any context. */
+uint32_t wall_clock_now(void);
+
+/**@brief RTC1 ticks since wall_clock_init(), not corrected, never set back. Any context. */
+uint64_t wall_clock_ticks(void);
+
+/**@brief Whether the time has been set since boot. */
+bool wall_clock_synced(void);
+
+/**@brief Set the time.
+ *
+ * @param[in] time          Seconds since 1970-01-01 00:00.
+ * @param[in] fractions256  1/256 s past @p time.
+ */
+void wall_clock_set(uint32_t time, uint8_t fractions256);
+
+/**@brief Correction applied to the RTC, in parts per billion; positive when it runs slow. */
+int32_t wall_clock_drift_ppb(void);
+
+/**@brief Handle a BLE event: CTS discovery and read on a phone link. */
+void wall_clock_on_ble_evt(ble_evt_t * p_ble_evt);
+
+#endif
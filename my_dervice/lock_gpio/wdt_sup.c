@@ -0,0 +1,281 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(WDT_SUP)
+#include "wdt_sup.h"
+#include "post_mortem.h"
+#include "nrf_drv_wdt.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "app_util_platform.h"
+#include "nrf.h"
+#include <string.h>
+
+#if !WDT_ENABLED
+#error "wdt_sup needs WDT_ENABLED"
+#endif
+#if WDT_CONFIG_RELOAD_VALUE <= WDT_SUP_CHECK_MS
+#error "WDT_CONFIG_RELOAD_VALUE has to leave room for WDT_SUP_CHECK_MS between feeds"
+#endif
+
+#define WDT_SUP_TICKS(ms)   APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+#define MAGIC_NEW           0x57445443UL    /**< Written before the reset, not read yet. */
+#define MAGIC_SEEN          0x57445453UL    /**< Read after the reset; keeps the reset count. */
+
+STATIC_ASSERT(sizeof(wdt_sup_crash_t) == 0x20);
+
+typedef struct
+{
+    volatile bool     busy;
+    volatile bool     tripped;
+    volatile uint32_t beat;         /**< app_timer_cnt_get() at the begin or the last beat. */
+} part_t;
+
+static const uint32_t m_limit_ms[WDT_SUP_PARTS] =
+{
+    WDT_SUP_MAIN_MS, WDT_SUP_RF_MS, WDT_SUP_STORAGE_MS, WDT_SUP_BLE_TX_MS,
+};
+
+// The Keil projects keep the top 0x20 bytes of RAM out of IRAM1, as the NoInit IRAM2.
+#if defined(__CC_ARM)
+static wdt_sup_crash_t m_crash __attribute__((at(WDT_SUP_CRASH_ADDR), zero_init));
+#else
+static wdt_sup_crash_t m_crash __attribute__((section(".noinit")));
+#endif
+
+APP_TIMER_DEF(m_timer);
+
+static part_t                 m_parts[WDT_SUP_PARTS];
+static wdt_sup_recover_t      m_recover[WDT_SUP_PARTS];
+static nrf_drv_wdt_channel_id m_channel;
+static wdt_sup_crash_t        m_last;
+static bool                   m_last_valid;
+static volatile bool          m_saved;      /**< Record written, the watchdog is left to fire. */
+
+
+static uint32_t crash_check(wdt_sup_crash_t const * p_crash)
+{
+    uint32_t const * p_word = (uint32_t const *)p_crash;
+    uint32_t         check  = UINT32_MAX;
+
+    for (uint8_t i = 0; i < offsetof(wdt_sup_crash_t, check) / sizeof(uint32_t); i++)
+    {
+        check ^= p_word[i];
+    }
+    return check;
+}
+
+
+static uint32_t age_ms(part_t const * p_part, uint32_t now)
+{
+    uint32_t ticks;
+
+    UNUSED_RETURN_VALUE(app_timer_cnt_diff_compute(now, p_part->beat, &ticks));
+    return (uint32_t)(((uint64_t)ticks * 1000 * (APP_TIMER_CONFIG_PRESCALER + 1)) / APP_TIMER_CLOCK_FREQ);
+}
+
+
+/**@brief Write the record and stop feeding. Any context; the first one to get here wins. */
+static void crash_save(wdt_sup_part_t part, wdt_sup_reason_t reason)
+{
+    uint32_t now = app_timer_cnt_get();
+
+    CRITICAL_REGION_ENTER();
+    if (!m_saved)
+    {
+        m_saved        = true;
+        m_crash.magic  = MAGIC_NEW;
+        m_crash.part   = (uint8_t)part;
+        m_crash.reason = (uint8_t)reason;
+        m_crash.busy   = 0;
+        m_crash.rfu    = 0;
+        for (uint8_t i = 0; i < WDT_SUP_PARTS; i++)
+        {
+            m_crash.age_ms[i] = 0;
+            if (m_parts[i].busy)
+            {
+                m_crash.busy     |= (uint8_t)(1 << i);
+                m_crash.age_ms[i] = age_ms(&m_parts[i], now);
+            }
+        }
+        m_crash.resets++;
+        m_crash.check = crash_check(&m_crash);
+#if NRF_MODULE_ENABLED(POST_MORTEM)
+        // From the WDT interrupt it may not finish in time; a cut short snapshot fails its check.
+        post_mortem_save(POST_MORTEM_ID_STALL, (uint32_t)part | ((uint32_t)reason << 8));
+#endif
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+
+static void recover_run(void * p_event_data, uint16_t event_size)
+{
+    uint8_t part = *(uint8_t *)p_event_data;
+
+    UNUSED_PARAMETER(event_size);
+
+    if (m_recover[part] != NULL)
+    {
+        m_recover[part]();
+    }
+}
+
+
+static void check_handler(void * p_context)
+{
+    uint32_t now    = app_timer_cnt_get();
+    bool     others = false;
+
+    UNUSED_PARAMETER(p_context);
+
+    for (uint8_t i = WDT_SUP_MAIN + 1; i < WDT_SUP_PARTS; i++)
+    {
+        others |= m_parts[i].busy;
+    }
+
+    for (uint8_t part = WDT_SUP_MAIN; part < WDT_SUP_PARTS; part++)
+    {
+        part_t * p_part = &m_parts[part];
+        uint32_t age;
+
+        // The RF, storage and TX waits block the main loop, with limits of their own.
+        if (!p_part->busy || ((part == WDT_SUP_MAIN) && others))
+        {
+            continue;
+        }
+        age = age_ms(p_part, now);
+        if (age >= 2 * m_limit_ms[part])
+        {
+            crash_save((wdt_sup_part_t)part, WDT_SUP_REASON_STUCK);
+        }
+        else if ((age >= m_limit_ms[part]) && !p_part->tripped)
+        {
+            p_part->tripped = true;
+            if (m_recover[part] != NULL)
+            {
+                UNUSED_RETURN_VALUE(app_sched_event_put(&part, sizeof(part), recover_run));
+            }
+        }
+    }
+
+    if (!m_saved)
+    {
+        nrf_drv_wdt_channel_feed(m_channel);
+    }
+}
+
+
+/**@brief Two cycles of 32 kHz before the reset: the supervisor did not feed, and did not say why. */
+static void wdt_event_handler(void)
+{
+    wdt_sup_part_t part = WDT_SUP_MAIN;
+
+    for (uint8_t i = WDT_SUP_PARTS; i-- > 0; )
+    {
+        if (m_parts[i].busy)
+        {
+            part = (wdt_sup_part_t)i;
+            break;
+        }
+    }
+    crash_save(part, WDT_SUP_REASON_WDT);
+}
+
+
+ret_code_t wdt_sup_init(void)
+{
+    ret_code_t           err_code;
+    nrf_drv_wdt_config_t config = NRF_DRV_WDT_DEAFULT_CONFIG;
+
+    if (crash_check(&m_crash) != m_crash.check)
+    {
+        // Power on: RAM holds noise.
+        memset(&m_crash, 0, sizeof(m_crash));
+    }
+    else if (m_crash.magic == MAGIC_NEW)
+    {
+        m_last       = m_crash;
+        m_last_valid = true;
+    }
+    m_crash.magic = MAGIC_SEEN;
+    m_crash.check = crash_check(&m_crash);
+
+    // The init up to the first pass of the main loop counts as the main loop.
+    wdt_sup_begin(WDT_SUP_MAIN);
+
+    err_code = app_timer_create(&m_timer, APP_TIMER_MODE_REPEATED, check_handler);
+    VERIFY_SUCCESS(err_code);
+    err_code = nrf_drv_wdt_init(&config, wdt_event_handler);
+    VERIFY_SUCCESS(err_code);
+    err_code = nrf_drv_wdt_channel_alloc(&m_channel);
+    VERIFY_SUCCESS(err_code);
+    nrf_drv_wdt_enable();
+
+    return app_timer_start(m_timer, WDT_SUP_TICKS(WDT_SUP_CHECK_MS), NULL);
+}
+
+
+void wdt_sup_recover_set(wdt_sup_part_t part, wdt_sup_recover_t handler)
+{
+    m_recover[part] = handler;
+}
+
+
+void wdt_sup_begin(wdt_sup_part_t part)
+{
+    part_t * p_part = &m_parts[part];
+
+    CRITICAL_REGION_ENTER();
+    if (!p_part->busy)
+    {
+        p_part->beat    = app_timer_cnt_get();
+        p_part->tripped = false;
+        p_part->busy    = true;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+
+void wdt_sup_beat(wdt_sup_part_t part)
+{
+    if (m_parts[part].busy)
+    {
+        m_parts[part].beat = app_timer_cnt_get();
+    }
+}
+
+
+void wdt_sup_end(wdt_sup_part_t part)
+{
+    m_parts[part].busy    = false;
+    m_parts[part].tripped = false;
+    if (part != WDT_SUP_MAIN)
+    {
+        // A wait that ended is progress of the loop it blocked.
+        wdt_sup_beat(WDT_SUP_MAIN);
+    }
+}
+
+
+bool wdt_sup_expired(wdt_sup_part_t part)
+{
+    return m_parts[part].busy && m_parts[part].tripped;
+}
+
+
+void wdt_sup_fail(wdt_sup_part_t part)
+{
+    crash_save(part, WDT_SUP_REASON_FAIL);
+    NVIC_SystemReset();
+}
+
+
+bool wdt_sup_crash_get(wdt_sup_crash_t * p_crash)
+{
+    if (m_last_valid)
+    {
+        *p_crash = m_last;
+    }
+    return m_last_valid;
+}
+
+#endif //NRF_MODULE_ENABLED(WDT_SUP)
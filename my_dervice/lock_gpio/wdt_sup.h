@@ -0,0 +1,91 @@
+#ifndef _WDT_SUP_H_
+#define _WDT_SUP_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* Hang supervision on top of nrf_drv_wdt:
+ *
+ *   part      a blocking path, or the main loop, marks itself busy with wdt_sup_begin() and
+ *             idle with wdt_sup_end(); in between wdt_sup_beat() shows progress. Idle parts
+ *             are never stuck, so a part that has nothing to do costs nothing
+ *   limit     a part busy for its WDT_SUP_<part>_MS since the last beat has tripped: its
+ *             wait loops see wdt_sup_expired() and give up, and its recovery handler, if
+ *             set, runs from the main loop, the PN532 one a soft reset of the chip
+ *   stuck     still busy at twice the limit, or failed with wdt_sup_fail(): the crash
+ *             record is written and the watchdog is no longer fed. The main loop only
+ *             counts while no other part is busy; the part that blocks it is the one stuck
+ *   record    kept in RAM that the startup code leaves alone, at WDT_SUP_CRASH_ADDR, so it
+ *             survives the watchdog reset; the WDT interrupt writes one too if the
+ *             supervisor itself did not get to run
+ *
+ * The check runs from app_timer every WDT_SUP_CHECK_MS and is the only place that feeds the
+ * watchdog, so a hang below the app_timer priority resets as well. */
+
+/**@brief Supervised parts. */
+typedef enum
+{
+    WDT_SUP_MAIN,       /**< Main loop, or the rf task with app_rtos: one pass of events. */
+    WDT_SUP_RF,         /**< PN532 waiting for the chip to get ready. */
+    WDT_SUP_STORAGE,    /**< MX25 waiting for a program or erase. */
+    WDT_SUP_BLE_TX,     /**< NUS waiting for room in a full TX queue. */
+    WDT_SUP_PARTS
+} wdt_sup_part_t;
+
+/**@brief Why the record was written. */
+typedef enum
+{
+    WDT_SUP_REASON_STUCK = 1,   /**< Busy for twice its limit. */
+    WDT_SUP_REASON_FAIL  = 2,   /**< wdt_sup_fail(). */
+    WDT_SUP_REASON_WDT   = 3,   /**< Watchdog timeout without the supervisor. */
+} wdt_sup_reason_t;
+
+/**@brief Crash record, as kept over the reset. */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t resets;                    /**< Resets by the supervisor since power on. */
+    uint8_t  part;                      /**< wdt_sup_part_t that was stuck. */
+    uint8_t  reason;                    /**< wdt_sup_reason_t. */
+    uint8_t  busy;                      /**< Parts busy at the time, one bit each. */
+    uint8_t  rfu;
+    uint32_t age_ms[WDT_SUP_PARTS];     /**< Time since the last beat of each busy part. */
+    uint32_t check;
+} wdt_sup_crash_t;
+
+/**@brief Called from the main loop when a part trips. */
+typedef void (* wdt_sup_recover_t)(void);
+
+/**@brief Take over the crash record of the last reset and start the watchdog.
+ *
+ * @details Call after app_timer and app_scheduler, as early as possible: the main loop counts
+ *          as busy from here to its first pass, which covers the rest of the init.
+ */
+ret_code_t wdt_sup_init(void);
+
+/**@brief Set the handler that recovers @p part after it tripped. Main loop. */
+void wdt_sup_recover_set(wdt_sup_part_t part, wdt_sup_recover_t handler);
+
+/**@brief The part starts waiting. Any context. A part already busy keeps its last beat. */
+void wdt_sup_begin(wdt_sup_part_t part);
+
+/**@brief The part made progress. Any context; no effect on an idle part. */
+void wdt_sup_beat(wdt_sup_part_t part);
+
+/**@brief The part is done waiting. Any context. */
+void wdt_sup_end(wdt_sup_part_t part);
+
+/**@brief Whether the part tripped in the wait it is in; its loop should give up. */
+bool wdt_sup_expired(wdt_sup_part_t part);
+
+/**@brief Record @p part as failed and let the watchdog reset. Does not return. */
+void wdt_sup_fail(wdt_sup_part_t part);
+
+/**@brief Crash record of the last reset.
+ *
+ * @retval true   The last reset came from the supervisor; *p_crash is filled in.
+ * @retval false  Power on, or a reset that did not go through the supervisor.
+ */
+bool wdt_sup_crash_get(wdt_sup_crash_t * p_crash);
+
+#endif
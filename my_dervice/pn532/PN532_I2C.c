@@ -1,43 +1,482 @@
+#include "sdk_common.h"
 #include "pn532_i2c.h"
+#include "pn532_async.h"
+#include "lat_trace.h"
+#include "pn532_sim.h"
 #include "nrf_delay.h"
 #include "nrf_drv_twi.h"
+#include "nrf_drv_common.h"
+#include "twi_bus.h"
 #include "app_util_platform.h"
+#include "wdt_sup.h"
+#include "pn532_tune.h"
+#include "pn532_deadline.h"
+#include "pn532_retry.h"
+#if NRF_MODULE_ENABLED(HF_CLOCK)
+#include "hf_clock.h"
+#endif
+#if NRF_MODULE_ENABLED(ENERGY)
+#include "energy.h"
+#endif
 
 
 
 uint8_t _irq, _reset;
-uint8_t _uid[7];  // ISO14443A uid
+uint8_t _uid[PN532_UID_MAX_LEN];  // ISO14443A uid
 uint8_t _uidLen;  // uid len
 uint8_t _key[6];  // Mifare Classic key
-uint8_t inListedTag; // Tg number of inlisted tag.
 	
 uint8_t pn532ack[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
 
 uint8_t pn532response_firmwarevers[] = {0x00, 0xFF, 0x06, 0xFA, 0xD5, 0x03};
 
-#define PN532_PACKBUFFSIZ 64
-
-uint8_t pn532_packetbuffer[PN532_PACKBUFFSIZ];
+#ifndef PN532_PACKET_BUFFER_SIZE
+#define PN532_PACKET_BUFFER_SIZE 64
+#endif
+#if PN532_PACKET_BUFFER_SIZE > PN532_TWI_MAX_READ
+#error "PN532_PACKET_BUFFER_SIZE larger than one bus read"
+#endif
+#define PN532_PACKBUFFSIZ PN532_PACKET_BUFFER_SIZE
+
+/* Pages per FAST_READ: frame, response code and status must fit the packet buffer */
+#define NTAG2XX_FAST_READ_MAX_PAGES ((PN532_PACKBUFFSIZ - PN532_FRAME_OVERHEAD - 2) / 4)
+
+/* Command/response buffer with headroom for the (extended) frame header
+   in front of pn532_packetbuffer and room for DCS/postamble behind it, so
+   frames are encoded and decoded in place. On receive the I2C status byte
+   lands in the last headroom byte and the frame starts at
+   pn532_packetbuffer[0]. */
+static uint8_t m_frame_buf[EXT_HEADER_SEQUENCE_LENGTH + PN532_PACKBUFFSIZ + CHECKSUM_SEQUENCE_LENGTH];
+uint8_t * const pn532_packetbuffer = &m_frame_buf[EXT_HEADER_SEQUENCE_LENGTH];
+
+/* Driver state of the reader the commands go to. With pn532_reader several PN532s each keep
+   their own copy and pn532_reader_select switches between them. */
+static pn532_reader_t   m_reader = {
+    .bus     = {.irq_pin = PN532_IRQ, .sel_pin = PN532_PIN_NOT_USED},
+    .rf_mode = PN532_RF_MODE_NONE,
+    .tg      = 1,
+};
+static pn532_reader_t * mp_reader = &m_reader;
+
+static uint8_t setParametersFlags(uint8_t flags);
+static uint16_t frame_read_sized(uint8_t* buf, uint16_t first, uint16_t max, uint16_t timeout);
+static uint16_t resp_size_get(uint16_t guess);
+static boolean deadline_wait(uint16_t key, uint16_t timeout, bool abort);
+static void deadline_count(bool ok);
+static boolean command_acked(uint16_t timeout);
+static uint16_t m_resp_key;
+static uint8_t  m_exchange_status = PN532_STATUS_NO_FRAME;
 static size_t m_addr = 0;
 //static uint8_t m_rxbuff[1 + EEPROM_SIM_SEQ_WRITE_MAX];
-static bool m_error_flag;
+static bool m_error_flag;         // the last frame did not get onto the bus
+
+/* The commands that never change, as complete frames in flash. */
+static uint8_t const m_frame_firmware[]   = PN532_CONST_FRAME(PN532_COMMAND_GETFIRMWAREVERSION);
+static uint8_t const m_frame_sam[]        = PN532_CONST_FRAME(PN532_COMMAND_SAMCONFIGURATION, PN532_SAM_MODE, PN532_SAM_TIMEOUT, 0x01);
+static uint8_t const m_frame_sam_wired[]  = PN532_CONST_FRAME(PN532_COMMAND_SAMCONFIGURATION, PN532_SAM_MODE_WIRED_CARD, 0x00, 0x01);
+static uint8_t const m_frame_params[]     = PN532_CONST_FRAME(PN532_COMMAND_SETPARAMETERS, 0x14);
+static uint8_t const m_frame_field_off[]  = PN532_CONST_FRAME(PN532_COMMAND_RFCONFIGURATION, 0x01, 0x00);
+static uint8_t const m_frame_field_on[]   = PN532_CONST_FRAME(PN532_COMMAND_RFCONFIGURATION, 0x01, 0x01);
+static uint8_t const m_frame_retries[]    = PN532_CONST_FRAME(PN532_COMMAND_RFCONFIGURATION, 0x05, 0xFF, 0xFF, 0xFF);
+static uint8_t const m_frame_list_a[]     = PN532_CONST_FRAME(PN532_COMMAND_INLISTPASSIVETARGET, 1, PN532_MIFARE_ISO14443A);
+static uint8_t const m_frame_list_jewel[] = PN532_CONST_FRAME(PN532_COMMAND_INLISTPASSIVETARGET, 1, PN532_MIFARE_ISOJEWEL);
 //static const nrf_drv_twis_t m_twi = NRF_DRV_TWIS_INSTANCE(EEPROM_SIM_TWIS_INST);
 
 
+#if (PN532_TRANSPORT == PN532_TRANSPORT_I2C) && !NRF_MODULE_ENABLED(PN532_SIM)
+#if NRF_MODULE_ENABLED(TWI_BUS)
+#if NRF_MODULE_ENABLED(PN532_PPI_RX)
+#error "PN532_PPI_RX starts TWI reads from PPI, outside the queue of twi_bus"
+#endif
+
+/* The PN532 shares TWI1 through twi_bus, in the high priority queue, so a sensor transaction
+   never waits in front of a frame. */
+static const twi_bus_dev_t m_pn532_dev =
+{
+    .address   = PN532_I2C_ADDRESS,
+    .frequency = NRF_TWI_FREQ_400K,
+    .prio      = TWI_BUS_PRIO_HIGH,
+};
+
+static twi_bus_xfer_t const m_ack_xfer = TWI_BUS_WRITE_XFER(pn532ack, sizeof(pn532ack), 0);
+static twi_bus_txn_t        m_ack_txn  = {.p_dev = &m_pn532_dev, .p_xfers = &m_ack_xfer, .count = 1};
+static uint16_t             m_recoveries;
+
+/* After the bus was recovered the chip may be halfway through a frame
+   of its own. An ACK frame aborts what it works on, so it hears the
+   next command; queued, from any context, ahead of that command. */
+static ret_code_t bus_checked(ret_code_t err_code)
+{
+    twi_bus_stats_t stats;
+
+    if (err_code == NRF_SUCCESS)
+    {
+        return err_code;
+    }
+    twi_bus_stats_get(&stats);
+    if (stats.recoveries != m_recoveries)
+    {
+        m_recoveries = stats.recoveries;
+        UNUSED_RETURN_VALUE(twi_bus_schedule(&m_ack_txn));
+    }
+    return err_code;
+}
+
+ret_code_t pn532_bus_init(void)
+{
+    return twi_bus_init();
+}
+
+ret_code_t pn532_bus_write(uint8_t const * p_data, uint8_t len)
+{
+    twi_bus_xfer_t const xfer = TWI_BUS_WRITE_XFER(p_data, len, 0);
+
+    return bus_checked(twi_bus_perform(&m_pn532_dev, &xfer, 1));
+}
+
+ret_code_t pn532_bus_read(uint8_t * p_buf, uint8_t len)
+{
+    twi_bus_xfer_t const xfer = TWI_BUS_READ_XFER(p_buf, len);
+
+    return bus_checked(twi_bus_perform(&m_pn532_dev, &xfer, 1));
+}
+
+ret_code_t pn532_bus_wake(void)
+{
+    // Wakeup procedure as specified in PN532 User Manual Rev. 02, p. 7.2.11, page 99.
+    uint8_t dummy_byte = PN532_WAKEUP;
+
+    return pn532_bus_write(&dummy_byte, 1);
+}
+
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+static twi_bus_xfer_t      m_xfer;
+static twi_bus_txn_t       m_txn = {.p_dev = &m_pn532_dev, .p_xfers = &m_xfer, .count = 1};
+static pn532_bus_handler_t m_xfer_handler;
+
+static void pn532_txn_done(ret_code_t result, void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    result = bus_checked(result);
+    if (m_xfer_handler != NULL)
+    {
+        m_xfer_handler(result);
+    }
+}
+
+static ret_code_t pn532_txn_start(uint8_t * p_data, uint8_t len, uint8_t flags, pn532_bus_handler_t handler)
+{
+    // One frame in flight, as with the driver of its own.
+    if (m_txn.queued)
+    {
+        return NRF_ERROR_BUSY;
+    }
+    m_xfer.p_data   = p_data;
+    m_xfer.length   = len;
+    m_xfer.flags    = flags;
+    m_xfer_handler  = handler;
+    m_txn.callback  = pn532_txn_done;
+    return twi_bus_schedule(&m_txn);
+}
+
+ret_code_t pn532_bus_write_async(uint8_t const * p_data, uint8_t len, pn532_bus_handler_t handler)
+{
+    return pn532_txn_start((uint8_t *)p_data, len, 0, handler);
+}
+
+ret_code_t pn532_bus_read_async(uint8_t * p_buf, uint8_t len, pn532_bus_handler_t handler)
+{
+    return pn532_txn_start(p_buf, len, TWI_BUS_READ, handler);
+}
+#endif //NRF_MODULE_ENABLED(PN532_ASYNC)
+
+void pn532_bus_select(pn532_bus_cfg_t const * p_cfg)
+{
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+    // The bus switch must not move under a frame of the reader before.
+    while (m_txn.queued)
+    {
+    }
+#endif
+    if (p_cfg->sel_pin != PN532_PIN_NOT_USED)
+    {
+        nrf_gpio_pin_write(p_cfg->sel_pin, p_cfg->sel_level);
+    }
+}
+
+#else
 nrf_drv_twi_t gtMpuTwi = NRF_DRV_TWI_INSTANCE(1);
 //APP_TIMER_DEF(gtMpuReadTimer);
 
- void init_pnc523_i2c(void)
+#ifdef TWIM_IN_USE
+/* TWIM reads RAM only. The ACK and NACK frames in flash go through this copy; const command
+   frames are copied into m_frame_buf by wiresendframe. */
+#define DMA_BUF_LEN 8
+static uint8_t m_dma_buf[DMA_BUF_LEN];
+#endif
+
+/**@brief The frame as TWIM can send it, or NULL when a frame in flash is too long to copy. */
+static uint8_t * tx_dma_get(uint8_t const * p_data, uint8_t len)
+{
+#ifdef TWIM_IN_USE
+    if (gtMpuTwi.use_easy_dma && !nrf_drv_is_in_RAM(p_data))
+    {
+        if (len > DMA_BUF_LEN)
+        {
+            return NULL;
+        }
+        memcpy(m_dma_buf, p_data, len);
+        return m_dma_buf;
+    }
+#endif
+    return (uint8_t *)p_data;
+}
+
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+static volatile bool           m_twi_xfer_done = true;
+static volatile ret_code_t     m_twi_xfer_result;
+static pn532_bus_handler_t     m_twi_xfer_handler;
+#if NRF_MODULE_ENABLED(PN532_PPI_RX)
+static volatile bool           m_twi_xfer_held;   /**< A held read is waiting for its start task. */
+#endif
+
+/**@brief TWI event handler. Runs at APP_IRQ_PRIORITY_HIGH so that blocking transfers issued from
+ *        lower priority interrupts still complete.
+ */
+static void pn532_twi_evt_handler(nrf_drv_twi_evt_t const * p_event, void * p_context)
+{
+    pn532_bus_handler_t handler = m_twi_xfer_handler;
+    ret_code_t          result;
+
+    UNUSED_PARAMETER(p_context);
+
+    switch (p_event->type)
+    {
+        case NRF_DRV_TWI_EVT_DONE:
+            result = NRF_SUCCESS;
+            break;
+
+        case NRF_DRV_TWI_EVT_ADDRESS_NACK:
+            result = NRF_ERROR_DRV_TWI_ERR_ANACK;
+            break;
+
+        default:
+            result = NRF_ERROR_DRV_TWI_ERR_DNACK;
+            break;
+    }
+
+    m_twi_xfer_handler = NULL;
+    m_twi_xfer_result  = result;
+#if NRF_MODULE_ENABLED(PN532_PPI_RX)
+    m_twi_xfer_held    = false;
+#endif
+    m_twi_xfer_done    = true;
+
+    if (handler != NULL)
+    {
+        handler(result);
+    }
+}
+#endif //NRF_MODULE_ENABLED(PN532_ASYNC)
+
+ret_code_t pn532_bus_init(void)
 {
+	ret_code_t err_code;
 	nrf_drv_twi_config_t ltMpuTwiCfg = NRF_DRV_TWI_DEFAULT_CONFIG;
 	ltMpuTwiCfg.scl = PN532_CONFIG_SCL;
 	ltMpuTwiCfg.sda = PN532_CONFIG_SDA;
 	ltMpuTwiCfg.frequency = TWI_FREQUENCY_FREQUENCY_K400;
 
-	nrf_drv_twi_init(&gtMpuTwi, &ltMpuTwiCfg, NULL, NULL);
-	nrf_drv_twi_enable(&gtMpuTwi);
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+	ltMpuTwiCfg.interrupt_priority = APP_IRQ_PRIORITY_HIGH;
+	err_code = nrf_drv_twi_init(&gtMpuTwi, &ltMpuTwiCfg, pn532_twi_evt_handler, NULL);
+#else
+	err_code = nrf_drv_twi_init(&gtMpuTwi, &ltMpuTwiCfg, NULL, NULL);
+#endif
+	if (err_code == NRF_SUCCESS)
+	{
+		nrf_drv_twi_enable(&gtMpuTwi);
+	}
+	return err_code;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Run one TWI transfer and return when it has finished.
+
+    @param  p_desc    Transfer descriptor (NRF_DRV_TWI_XFER_DESC_TX/RX)
+*/
+/**************************************************************************/
+static ret_code_t pn532_twi_xfer(nrf_drv_twi_xfer_desc_t * p_desc)
+{
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+    ret_code_t err_code;
+
+    // An asynchronous transfer may still own the bus.
+    while (!m_twi_xfer_done)
+    {
+    }
+
+    m_twi_xfer_done = false;
+    err_code = nrf_drv_twi_xfer(&gtMpuTwi, p_desc, 0);
+    if (err_code != NRF_SUCCESS)
+    {
+        m_twi_xfer_done = true;
+        return err_code;
+    }
+
+    while (!m_twi_xfer_done)
+    {
+    }
+    return m_twi_xfer_result;
+#else
+    return nrf_drv_twi_xfer(&gtMpuTwi, p_desc, 0);
+#endif
+}
+
+ret_code_t pn532_bus_write(uint8_t const * p_data, uint8_t len)
+{
+    uint8_t *               p_tx;
+    nrf_drv_twi_xfer_desc_t desc;
+
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+    // An asynchronous transfer may still own the bus, and the copy.
+    while (!m_twi_xfer_done)
+    {
+    }
+#endif
+    p_tx = tx_dma_get(p_data, len);
+    desc = (nrf_drv_twi_xfer_desc_t)NRF_DRV_TWI_XFER_DESC_TX(PN532_I2C_ADDRESS, p_tx, len);
+    if (p_tx == NULL)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+    return pn532_twi_xfer(&desc);
+}
+
+ret_code_t pn532_bus_read(uint8_t * p_buf, uint8_t len)
+{
+    nrf_drv_twi_xfer_desc_t desc = NRF_DRV_TWI_XFER_DESC_RX(PN532_I2C_ADDRESS, p_buf, len);
+
+    return pn532_twi_xfer(&desc);
+}
+
+ret_code_t pn532_bus_wake(void)
+{
+    // Wakeup procedure as specified in PN532 User Manual Rev. 02, p. 7.2.11, page 99.
+    uint8_t dummy_byte = PN532_WAKEUP;
+
+    return pn532_bus_write(&dummy_byte, 1);
+}
+
+void pn532_bus_select(pn532_bus_cfg_t const * p_cfg)
+{
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+    // The bus switch must not move under a running transfer.
+    while (!m_twi_xfer_done)
+    {
+    }
+#endif
+    if (p_cfg->sel_pin != PN532_PIN_NOT_USED)
+    {
+        nrf_gpio_pin_write(p_cfg->sel_pin, p_cfg->sel_level);
+    }
+}
+
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+/**************************************************************************/
+/*! 
+    @brief  Start one TWI transfer and return immediately.
+
+    @param  p_desc    Transfer descriptor, buffers must stay valid until
+                      @p handler is called
+    @param  flags     nrf_drv_twi_xfer flags
+    @param  handler   Called from the TWI interrupt when the transfer ends
+*/
+/**************************************************************************/
+static ret_code_t pn532_twi_xfer_async(nrf_drv_twi_xfer_desc_t * p_desc, uint32_t flags, pn532_bus_handler_t handler)
+{
+    ret_code_t err_code;
+
+    if (!m_twi_xfer_done)
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    m_twi_xfer_done    = false;
+    m_twi_xfer_handler = handler;
+    err_code = nrf_drv_twi_xfer(&gtMpuTwi, p_desc, flags);
+    if (err_code != NRF_SUCCESS)
+    {
+        m_twi_xfer_handler = NULL;
+        m_twi_xfer_done    = true;
+    }
+    return err_code;
+}
+
+ret_code_t pn532_bus_write_async(uint8_t const * p_data, uint8_t len, pn532_bus_handler_t handler)
+{
+    uint8_t *               p_tx;
+    nrf_drv_twi_xfer_desc_t desc;
+
+    if (!m_twi_xfer_done)
+    {
+        // Not over the copy of the transfer that runs.
+        return NRF_ERROR_BUSY;
+    }
+    p_tx = tx_dma_get(p_data, len);
+    desc = (nrf_drv_twi_xfer_desc_t)NRF_DRV_TWI_XFER_DESC_TX(PN532_I2C_ADDRESS, p_tx, len);
+    if (p_tx == NULL)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+    return pn532_twi_xfer_async(&desc, 0, handler);
+}
+
+ret_code_t pn532_bus_read_async(uint8_t * p_buf, uint8_t len, pn532_bus_handler_t handler)
+{
+    nrf_drv_twi_xfer_desc_t desc = NRF_DRV_TWI_XFER_DESC_RX(PN532_I2C_ADDRESS, p_buf, len);
+
+    return pn532_twi_xfer_async(&desc, 0, handler);
 }
 
+#if NRF_MODULE_ENABLED(PN532_PPI_RX)
+ret_code_t pn532_bus_read_hold(uint8_t * p_buf, uint8_t len, pn532_bus_handler_t handler)
+{
+    ret_code_t              err_code;
+    nrf_drv_twi_xfer_desc_t desc = NRF_DRV_TWI_XFER_DESC_RX(PN532_I2C_ADDRESS, p_buf, len);
+
+    err_code = pn532_twi_xfer_async(&desc, NRF_DRV_TWI_FLAG_HOLD_XFER, handler);
+    if (err_code == NRF_SUCCESS)
+    {
+        m_twi_xfer_held = true;
+    }
+    return err_code;
+}
+
+uint32_t pn532_bus_read_task(void)
+{
+    return nrf_drv_twi_start_task_get(&gtMpuTwi, NRF_DRV_TWI_XFER_RX);
+}
+
+void pn532_bus_read_release(void)
+{
+    CRITICAL_REGION_ENTER();
+    if (m_twi_xfer_held && !m_twi_xfer_done)
+    {
+        // Never triggered: run it now, the chip answers with a not-ready status byte and the
+        // handler frees the bus.
+        m_twi_xfer_held = false;
+        *(volatile uint32_t *)pn532_bus_read_task() = 1;
+    }
+    CRITICAL_REGION_EXIT();
+}
+#endif //NRF_MODULE_ENABLED(PN532_PPI_RX)
+#endif //NRF_MODULE_ENABLED(PN532_ASYNC)
+#endif //NRF_MODULE_ENABLED(TWI_BUS)
+#endif //PN532_TRANSPORT_I2C
+
 /******************************************************************************* 
  * ???? :   i2c_device_wirte_data                                                                  
  * ??     :   wang                                                      
@@ -54,12 +493,12 @@ void i2c_write_byte(uint8_t address, uint8_t data)
         uint8_t lau8Data[2] = {0};
 				lau8Data[0] = address;
 				lau8Data[1] = data;
-				nrf_drv_twi_tx(&gtMpuTwi, PN532_I2C_ADDRESS, lau8Data, 2, false); 
+				UNUSED_RETURN_VALUE(pn532_bus_write(lau8Data, 2));
 }  
 
-void i2c_write_buffer(uint8_t address, uint8_t *data,uint8_t len)
+ret_code_t i2c_write_buffer(uint8_t address, uint8_t *data,uint8_t len)
 {  
-		nrf_drv_twi_tx(&gtMpuTwi, PN532_I2C_ADDRESS, data, len, false); 
+		return pn532_bus_write(data, len);
 }  
 
 
@@ -69,21 +508,32 @@ uint8_t i2c_device_read_byte(uint8_t data)
 			lu8Data = data;
 
 //			nrf_drv_twi_tx(&gtMpuTwi, PN532_I2C_ADDRESS, &lu8Data, 1, true);
-			nrf_drv_twi_rx(&gtMpuTwi, PN532_I2C_ADDRESS, &lu8Data, 1);
+			if (pn532_bus_read(&lu8Data, 1) != NRF_SUCCESS)
+			{
+					// Not ready, rather than a status from before.
+					return 0;
+			}
 			return lu8Data;
 } 
 
-void i2c_device_read_buffer(uint8_t address, uint8_t* data, uint8_t data_Len)
+ret_code_t i2c_device_read_buffer(uint8_t address, uint8_t* data, uint8_t data_Len)
 {
 //	   nrf_drv_twi_tx(&gtMpuTwi, PN532_I2C_ADDRESS, &address, 1, false);
-	   nrf_drv_twi_rx(&gtMpuTwi, PN532_I2C_ADDRESS, data, data_Len);
+	   ret_code_t err_code = pn532_bus_read(data, data_Len);
+
+	   if (err_code != NRF_SUCCESS)
+	   {
+			   // A failed read leaves what was there; the status byte must not pass for ready.
+			   memset(data, 0, data_Len);
+	   }
+	   return err_code;
 }
 
 
 void pn532_gpio_init(void)
 {
 	//			nrf_gpio_cfg_output(ARDUINO_10_PIN);  //reset  24
-			    nrf_gpio_cfg_input(PN532_IRQ,GPIO_PIN_CNF_PULL_Disabled); //irq  25
+			    nrf_gpio_cfg_input(mp_reader->bus.irq_pin,GPIO_PIN_CNF_PULL_Disabled); //irq  25
 }
 
 /**************************************************************************/
@@ -113,16 +563,15 @@ uint32_t getFirmwareVersion(void)
 {
   uint32_t response;
 
-  pn532_packetbuffer[0] = PN532_COMMAND_GETFIRMWAREVERSION;
 //	printf("1read data packet\r\n");
-  if (! sendCommandCheckAck(pn532_packetbuffer, 1,1000)){
+  if (! sendFrameCheckAck(m_frame_firmware, sizeof(m_frame_firmware), 1000)){
 //			printf("1read data packet failed\r\n");
       return 0;
 	  }
-      nrf_delay_ms(2);
 			// read data packet
 //		 printf("read data packet ok\r\n");
-			wirereaddata(pn532_packetbuffer, 12);
+			if (!wirereadresponse(pn532_packetbuffer, 13, PN532_RESP_TIMEOUT_CONFIG))
+				return 0;
 //			printf("2read data packet\r\n");
 			// check some basic stuff
 			if (0 != strncmp((char *)pn532_packetbuffer, (char *)pn532response_firmwarevers, 6)) {
@@ -157,31 +606,65 @@ uint32_t getFirmwareVersion(void)
 // default timeout of one second
 boolean sendCommandCheckAck(uint8_t *cmd, uint8_t cmdlen, uint16_t timeout) 
 {
-  uint16_t timer = 0;
-  
+  // Any command after the activation closes the PPS window, see inPSL.
+  mp_reader->psl_open = false;
+  m_exchange_status   = PN532_STATUS_NO_FRAME;
   // write the command
 //	printf("%2x %2x %2x %2x\r\n",cmd[0],cmd[1],cmd[2],cmd[3]);
 //	printf("cmdlen = %2x \r\n",cmdlen);
   wiresendcommand(cmd, cmdlen);
 //  printf("write the command\r\n");
 
-  // Wait for chip to say its ready!
-  while (wirereadstatus() != PN532_I2C_READY) {
-    if (timeout != 0) {
-					timer+=1;
-					nrf_delay_us(100);
-					if (timer > timeout)  
-						return false;
-    }
+  return command_acked(timeout);
+}
 
-  }
+
+/**************************************************************************/
+/*! 
+    @brief  Sends a complete frame, a PN532_CONST_FRAME, and waits a
+            specified period for the ACK
+
+    @param  frame     Frame, preamble to postamble
+    @param  framelen  Its size in bytes
+    @param  timeout   timeout before giving up
+
+    @returns  1 if everything is OK, 0 if timeout occured before an
+              ACK was recieved
+*/
+/**************************************************************************/
+boolean sendFrameCheckAck(uint8_t const *frame, uint8_t framelen, uint16_t timeout)
+{
+  mp_reader->psl_open = false;
+  m_exchange_status   = PN532_STATUS_NO_FRAME;
+  wiresendframe(frame, framelen);
+
+  return command_acked(timeout);
+}
+
+
+/**************************************************************************/
+/*! 
+    @brief  Waits for the ACK of the command just written
+
+    @param  timeout   timeout before giving up
+*/
+/**************************************************************************/
+static boolean command_acked(uint16_t timeout)
+{
+  // No ACK comes for a frame the chip never got.
+  if (m_error_flag)
+    return false;
+  // Wait for chip to say its ready!
+  if (!deadline_wait(PN532_DEADLINE_ACK_KEY, timeout, false))
+    return false;
   // read acknowledgement
 //    printf("sendCommandCheckAck ok\r\n");
 //   nrf_delay_us(1000);
   if (!readackframe()) {
-    
+    deadline_count(false);
     return false;
   }
+  deadline_count(true);
 
   return true; // ack'd command
 }
@@ -264,132 +747,181 @@ uint8_t readGPIO(void)
   return pn532_packetbuffer[6];
 }
 
+/**************************************************************************/
+/*! 
+    @brief  Sends a configuration frame and reads the bare response
+
+    @param  frame     A PN532_CONST_FRAME
+    @param  framelen  Its size in bytes
+    @param  resp      Response code the chip answers with
+
+    @returns 1 if the chip answered with @p resp, 0 on error
+*/
+/**************************************************************************/
+static uint8_t config_frame_send(uint8_t const * frame, uint8_t framelen, uint8_t resp)
+{
+  if (!sendFrameCheckAck(frame, framelen, 1000))
+    return false;
+  if (!wirereadresponse(pn532_packetbuffer, 9, PN532_RESP_TIMEOUT_CONFIG))
+    return false;
+
+  return (pn532_packetbuffer[6] == resp);
+}
+
 /**************************************************************************/
 /*! 
     @brief  Configures the SAM (Secure Access Module)
 */
 /**************************************************************************/
 uint8_t SAMConfig(void) {
-  pn532_packetbuffer[0] = PN532_COMMAND_SAMCONFIGURATION;
-  pn532_packetbuffer[1] = 0x01; // normal mode;
-  pn532_packetbuffer[2] = 0x14; // timeout 50ms * 20 = 1 second
-  pn532_packetbuffer[3] = 0x01; // use IRQ pin!
-//	 printf("SAMConfig\r\n");
-  if (! sendCommandCheckAck(pn532_packetbuffer, 4, 1000))
-     return false;
-  // read data packet
-//	printf("SAMConfig read data packet \r\n");
-  wirereaddata(pn532_packetbuffer, 8);
-  
-  return  (pn532_packetbuffer[6] == 0x15);
+  // PN532_SAM_MODE (normal unless a SAM is fitted), PN532_SAM_TIMEOUT, use IRQ pin!
+  return config_frame_send(m_frame_sam, sizeof(m_frame_sam), PN532_COMMAND_SAMCONFIGURATION + 1);
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Switches between wired card mode, where InListPassiveTarget
+            and InDataExchange reach the SAM instead of a card, and the
+            mode of PN532_SAM_MODE
+
+    The way back sends the analog settings of pn532_tune again, as
+    pn532_rf_mode_set does after SAMConfiguration. The target numbers
+    and the RF mode the driver keeps are left as they are.
+
+    @param  wired     true for wired card mode
+
+    @returns 1 if the chip took the mode, 0 on error
+*/
+/**************************************************************************/
+uint8_t pn532_sam_wired(bool wired)
+{
+  if (wired)
+  {
+    return config_frame_send(m_frame_sam_wired, sizeof(m_frame_sam_wired), PN532_COMMAND_SAMCONFIGURATION + 1);
+  }
+  if (!SAMConfig())
+  {
+    return 0;
+  }
+#if NRF_MODULE_ENABLED(PN532_TUNE)
+  return pn532_tune_apply();
+#else
+  return 1;
+#endif
 }
 
 /***** ISO14443B Commands ******/
 
 uint8_t SetRFConfiguration(void)
 {
+  return config_frame_send(m_frame_params, sizeof(m_frame_params), PN532_COMMAND_SETPARAMETERS + 1) &&
+         config_frame_send(m_frame_field_off, sizeof(m_frame_field_off), PN532_COMMAND_RFCONFIGURATION + 1) &&
+         config_frame_send(m_frame_field_on, sizeof(m_frame_field_on), PN532_COMMAND_RFCONFIGURATION + 1) &&
+         config_frame_send(m_frame_retries, sizeof(m_frame_retries), PN532_COMMAND_RFCONFIGURATION + 1);
+}
+/**************************************************************************/
+/*! 
+    @brief  Sends one RFConfiguration item
 
-	
-	{
-			pn532_packetbuffer[0] = PN532_COMMAND_SETPARAMETERS;
-			pn532_packetbuffer[1] = 0x14; // normal mode;
+    @param  item      CfgItem
+    @param  p_data    ConfigurationData
+    @param  len       Bytes at p_data
 
-			//	 printf("SAMConfig\r\n");
-			if (! sendCommandCheckAck(pn532_packetbuffer, 2, 1000))
-			return false;
-			// read data packet
-			//	printf("SAMConfig read data packet \r\n");
-			nrf_delay_ms(150);
-			wirereaddata(pn532_packetbuffer, 8);
-			if(!(pn532_packetbuffer[6] == 0x13))
-			return false;
-	}
+    @returns 1 if the chip took the item, 0 on error
+*/
+/**************************************************************************/
+uint8_t pn532_rf_config(uint8_t item, uint8_t const * p_data, uint8_t len)
+{
+  if (len > PN532_PACKBUFFSIZ - PN532_FRAME_OVERHEAD - 2)
+    return false;
 
-	{
-		  pn532_packetbuffer[0] = PN532_COMMAND_RFCONFIGURATION;
-			pn532_packetbuffer[1] = 0x01; // normal mode;
-			pn532_packetbuffer[2] = 0x00; // timeout 50ms * 20 = 1 second
-			//	 printf("SAMConfig\r\n");
-			if (! sendCommandCheckAck(pn532_packetbuffer, 3, 1000))
-			return false;
-			// read data packet
-			//	printf("SAMConfig read data packet \r\n");
-			nrf_delay_ms(150);
-			wirereaddata(pn532_packetbuffer, 8);
+  pn532_packetbuffer[0] = PN532_COMMAND_RFCONFIGURATION;
+  pn532_packetbuffer[1] = item;
+  memcpy(&pn532_packetbuffer[2], p_data, len);
+  if (! sendCommandCheckAck(pn532_packetbuffer, 2 + len, 1000))
+    return false;
+  if (!wirereadresponse(pn532_packetbuffer, 9, PN532_RESP_TIMEOUT_CONFIG))
+    return false;
 
-			if(!(pn532_packetbuffer[6] == 0x33))
-			return false;
-	}
-//    //   my_memset(pn532_packetbuffer,0,64);
-	{
-		  pn532_packetbuffer[0] = PN532_COMMAND_RFCONFIGURATION;
-		 	pn532_packetbuffer[1] = 0x01; // normal mode;
-			pn532_packetbuffer[2] = 0x01; // timeout 50ms * 20 = 1 second
-			//	 printf("SAMConfig\r\n");
-			if (! sendCommandCheckAck(pn532_packetbuffer, 3, 1000))
-			return false;
-			// read data packet
-			//	printf("SAMConfig read data packet \r\n");
-			nrf_delay_ms(150);
-			wirereaddata(pn532_packetbuffer, 8);
+  return  (pn532_packetbuffer[6] == 0x33);
+}
 
-			if(!(pn532_packetbuffer[6] == 0x33))
-			return false;
-	}
-//	  //  my_memset(pn532_packetbuffer,0,64);
-	{
-		  pn532_packetbuffer[0] = PN532_COMMAND_RFCONFIGURATION;
-			pn532_packetbuffer[1] = 0x05; // normal mode;
-			pn532_packetbuffer[2] = 0xff; // timeout 50ms * 20 = 1 second
-		  pn532_packetbuffer[3] = 0xff; // normal mode;
-			pn532_packetbuffer[4] = 0xff; // timeout 50ms * 20 = 1 second
-			//	 printf("SAMConfig\r\n");
-			if (! sendCommandCheckAck(pn532_packetbuffer, 5, 1000))
-			return false;
-			// read data packet
-			//	printf("SAMConfig read data packet \r\n");
-			nrf_delay_ms(150);
-			wirereaddata(pn532_packetbuffer, 8);
+/* CIU set up for ISO14443B at 106 kbps, as captured from a working reader. */
+typedef struct
+{
+  uint16_t reg;
+  uint8_t  value;
+} ciu_write_t;
 
-			if(!(pn532_packetbuffer[6] == 0x33))
-			return false;
-	}
-	
-	
-}
-uint8_t CategoryBConfig(void)
+static ciu_write_t const m_typeb_ciu[] =
 {
-	/*******40****/
-	  my_memset(pn532_packetbuffer,0,64);
-	  pn532_packetbuffer[0] = PN532_COMMAND_WRITEREGISTER;
-		uint8_t config_b1[16]={0x63 ,0x01 ,0xff ,0x63 ,0x02 ,0x03 ,0x63 ,0x03 ,0x03 ,0x63 ,0x05 ,0x00 ,0x63 ,0x08 ,0x4d, 0x63};
-		uint8_t config_b2[16]={0x09 ,0x4d ,0x63 ,0x0d ,0x10 ,0x63 ,0x0e ,0x03 ,0x63 ,0x14 ,0x68 ,0x63 ,0x17 ,0xff ,0x63, 0x18};
-		uint8_t config_b3[7]={0x3f ,0x63 ,0x19 ,0x18 ,0x63 ,0x3c ,0x10};
-		uint8_t num_add = 1;
-		 for(uint8_t i = 0; i<16; i++)
-		 {
-			 pn532_packetbuffer[num_add] = config_b1[i];
-			 num_add++;
-		 }
-		 
-		 for(uint8_t i = 0; i<16; i++)
-		 {
-			 pn532_packetbuffer[num_add] = config_b2[i];
-			 num_add++;
-		 }
-		 
-		 for(uint8_t i = 0; i<9; i++)
-		 {
-			 pn532_packetbuffer[num_add] = config_b3[i];
-			 num_add++;
-		 }
-		 
-		 if (! sendCommandCheckAck(pn532_packetbuffer, 40, 1000))
-			 return false;
-		 nrf_delay_ms(100);
-    wirereaddata(pn532_packetbuffer, 8);
-  
-    return  (pn532_packetbuffer[6] == 0x09);
+  {0x6301, 0xFF},  // CIU_Mode: CRC preset FFFF
+  {0x6302, 0x03},  // CIU_TxMode: 106 kbps, Type B framing, no CRC
+  {0x6303, 0x03},  // CIU_RxMode: 106 kbps, Type B framing, no CRC
+  {0x6305, 0x00},  // CIU_TxAuto: no forced 100% ASK
+  {0x6309, 0x4D},  // CIU_Demod
+  {0x630D, 0x10},  // CIU_ManualRCV: no parity
+  {0x630E, 0x03},  // CIU_TypeB
+  {0x6314, 0x68},  // CIU_ModWidth
+  {0x633C, 0x10},  // CIU_Control: initiator
+};
+
+#define CIU_RX_THRESHOLD  0x6308
+#define CIU_RF_CFG        0x6316
+#define CIU_GS_N_ON       0x6317
+#define CIU_CW_GS_P       0x6318
+#define CIU_MOD_GS_P      0x6319
+
+/**************************************************************************/
+/*! 
+    @brief  Programs the CIU for ISO14443B with one WriteRegister
+
+    The analog registers come from the Type B settings of pn532_tune;
+    without it they keep the captured values and RFCfg is left alone.
+
+    @returns 1 if the chip took the registers, 0 on error
+*/
+/**************************************************************************/
+uint8_t CategoryBConfig(void)
+{
+#if NRF_MODULE_ENABLED(PN532_TUNE)
+  pn532_tune_rf_t const * p_rf = pn532_tune_rf_get(PN532_TUNE_FAMILY_B);
+#else
+  static pn532_tune_rf_t const captured = {.gs_n_on = 0xFF, .cw_gs_p = 0x3F, .mod_gs_p = 0x18, .rx_threshold = 0x4D};
+  pn532_tune_rf_t const * p_rf = &captured;
+#endif
+  ciu_write_t analog[] =
+  {
+    {CIU_RX_THRESHOLD, p_rf->rx_threshold},
+    {CIU_GS_N_ON,      p_rf->gs_n_on},
+    {CIU_CW_GS_P,      p_rf->cw_gs_p},
+    {CIU_MOD_GS_P,     p_rf->mod_gs_p},
+#if NRF_MODULE_ENABLED(PN532_TUNE)
+    {CIU_RF_CFG,       p_rf->rf_cfg},
+#endif
+  };
+  uint8_t len = 0;
+
+  pn532_packetbuffer[len++] = PN532_COMMAND_WRITEREGISTER;
+  for (uint8_t i = 0; i < ARRAY_SIZE(m_typeb_ciu); i++)
+  {
+    pn532_packetbuffer[len++] = MSB_16(m_typeb_ciu[i].reg);
+    pn532_packetbuffer[len++] = LSB_16(m_typeb_ciu[i].reg);
+    pn532_packetbuffer[len++] = m_typeb_ciu[i].value;
+  }
+  for (uint8_t i = 0; i < ARRAY_SIZE(analog); i++)
+  {
+    pn532_packetbuffer[len++] = MSB_16(analog[i].reg);
+    pn532_packetbuffer[len++] = LSB_16(analog[i].reg);
+    pn532_packetbuffer[len++] = analog[i].value;
+  }
+
+  if (! sendCommandCheckAck(pn532_packetbuffer, len, 1000))
+    return false;
+  if (!wirereadresponse(pn532_packetbuffer, 9, PN532_RESP_TIMEOUT_CONFIG))
+    return false;
+
+  return  (pn532_packetbuffer[6] == 0x09);
 }
 /*
 *
@@ -399,730 +931,3373 @@ behavior regarding different cases.
 *
 */
 uint8_t SetParameters(void) 
+{
+  return setParametersFlags(0x04);
+}
+
+static uint8_t setParametersFlags(uint8_t flags)
 	{
 	my_memset(pn532_packetbuffer,0,64);
   pn532_packetbuffer[0] = PN532_COMMAND_SETPARAMETERS;
-  pn532_packetbuffer[1] = 0x04; // normal mode;
+  pn532_packetbuffer[1] = flags;
 
 //	 printf("SAMConfig\r\n");
   if (! sendCommandCheckAck(pn532_packetbuffer, 2, 1000))
      return false;
   // read data packet
 //	printf("SAMConfig read data packet \r\n");
-	 nrf_delay_ms(100);
-  wirereaddata(pn532_packetbuffer, 8);
+  if (!wirereadresponse(pn532_packetbuffer, 9, PN532_RESP_TIMEOUT_CONFIG))
+     return false;
   
   return  (pn532_packetbuffer[6] == 0x13);
 }
 	
 
-uint8_t readTypeBuid(uint8_t cardbaudrate, uint8_t * uid, uint8_t * uidLength, uint16_t timeout) 
+/***** ISO14443-3B Commands ******/
+
+#define TYPEB_NO_CARD_MS       100   // A poll without answer costs the PN532 fRetryTimeout (102.4 ms)
+#define TYPEB_FRAME_MAX        64    // Longest frame pn532_typeb_transceive sends, CRC_B included
+
+
+/**************************************************************************/
+/*! 
+    @brief  Computes the ISO14443-3 CRC_B of a frame
+*/
+/**************************************************************************/
+uint16_t pn532_typeb_crc(uint8_t const * data, uint8_t len)
 {
-	my_memset(pn532_packetbuffer,0,64);
-	uint8_t read_config1[5] = {0x05, 0x00, 0x00, 0x71, 0xff};
-	uint8_t read_config2[11] = {0x1d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x01, 0x01, 0x32, 0x8d};
-	uint8_t read_config3[7] = {0x00, 0x36, 0x00, 0x00, 0x08, 0x57, 0x44};
-	{	
-		pn532_packetbuffer[0] = PN532_COMMAND_INCOMMUNICATETHRU;
-		for(uint8_t i = 0; i<5; i++)
-		{
-		pn532_packetbuffer[i+1] = read_config1[i];
-		}
-		if (! sendCommandCheckAck(pn532_packetbuffer, 6, 1000))
-		 return false;
-		// read data packet
-		nrf_delay_ms(100);
-		wirereaddata(pn532_packetbuffer, 20);
-		//my_memset(pn532_packetbuffer,0,64);
-	
-	}
-	{
-		pn532_packetbuffer[0] = PN532_COMMAND_INCOMMUNICATETHRU;
-		for(uint8_t i = 0; i<11; i++)
-		{
-		pn532_packetbuffer[i+1] = read_config2[i];
-		}
-		if (! sendCommandCheckAck(pn532_packetbuffer, 12, 1000))
-		 return false;
-		// read data packet
-		nrf_delay_ms(100);
-		wirereaddata(pn532_packetbuffer, 20);
-  }
-	//my_memset(pn532_packetbuffer,0,64);
-	{
-		pn532_packetbuffer[0] = PN532_COMMAND_INCOMMUNICATETHRU;
-		for(uint8_t i = 0; i<7; i++)
-		{
-			pn532_packetbuffer[i+1] = read_config3[i];
-		}
-		if (! sendCommandCheckAck(pn532_packetbuffer, 8, 1000))
-		 return false;
-		// read data packet
-		nrf_delay_ms(150);
-		wirereaddata(pn532_packetbuffer, 20);
-		
-		for(uint8_t i = 0; i < 9; i++)
-		{
-			uid[i] = pn532_packetbuffer[i+8];
-		}
-		
-		*uidLength = 8;
-		
-		//	printf("1111111111");
+  uint16_t crc = 0xFFFF;
+
+  while (len--)
+  {
+    uint8_t b = *data++ ^ (uint8_t)crc;
+    b   ^= (uint8_t)(b << 4);
+    crc  = (crc >> 8) ^ ((uint16_t)b << 8) ^ ((uint16_t)b << 3) ^ (b >> 4);
   }
-	
-	
-	
+  return (uint16_t)~crc;
 }
+
 /**************************************************************************/
 /*! 
-    Sets the MxRtyPassiveActivation uint8_t of the RFConfiguration register
-    
-    @param  maxRetries    0xFF to wait forever, 0x00..0xFE to timeout
-                          after mxRetries
-    
-    @returns 1 if everything executed properly, 0 for an error
+    @brief  Sends raw bytes with InCommunicateThru, like
+            inCommunicateThruInto but returning the PN532 status byte so
+            that a silent slot can be told apart from a collision
+
+    @returns The PN532 status byte, or PN532_STATUS_NO_FRAME on timeout or
+             a bad frame
 */
 /**************************************************************************/
-uint8_t setPassiveActivationRetries(uint8_t maxRetries) 
+uint8_t inCommunicateThruStatus(uint8_t const * send, uint8_t sendLength, uint8_t * rxbuf, uint16_t rxbufLen, pn532_frame_view_t * data, uint16_t timeout)
 {
-  pn532_packetbuffer[0] = PN532_COMMAND_RFCONFIGURATION;
-  pn532_packetbuffer[1] = 5;    // Config item 5 (MaxRetries)
-  pn532_packetbuffer[2] = 0xFF; // MxRtyATR (default = 0xFF)
-  pn532_packetbuffer[3] = 0x01; // MxRtyPSL (default = 0x01)
-  pn532_packetbuffer[4] = maxRetries;
-	
-  if (! sendCommandCheckAck(pn532_packetbuffer, 5, 1000))
-    return 0x0;  // no ACK
-  
-  return 1;
-}
+  pn532_frame_view_t view;
 
+  if (sendLength > PN532_PACKBUFFSIZ - 1) {
+    return PN532_STATUS_NO_FRAME;
+  }
 
-/***** ISO14443A Commands ******/
+  pn532_packetbuffer[0] = PN532_COMMAND_INCOMMUNICATETHRU;
+  memcpy(&pn532_packetbuffer[1], send, sendLength);
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, sendLength + 1, 1000)) {
+    return PN532_STATUS_NO_FRAME;
+  }
+  if (!pn532_frame_read(rxbuf, rxbufLen, &view, timeout)) {
+    return PN532_STATUS_NO_FRAME;
+  }
+  if ((view.len < 2) || (view.p_data[0] != PN532_RESPONSE_INCOMMUNICATETHRU)) {
+    return PN532_STATUS_NO_FRAME;
+  }
+
+  data->p_data = &view.p_data[2];
+  data->len    = view.len - 2;
+  return view.p_data[1];
+}
 
 /**************************************************************************/
 /*! 
-    Waits for an ISO14443A target to enter the field
-    
-    @param  cardBaudRate  Baud rate of the card
-    @param  uid           Pointer to the array that will be populated
-                          with the card's UID (up to 7 bytes)
-    @param  uidLength     Pointer to the variable that will hold the
-                          length of the card's UID.
-    
-    @returns 1 if everything executed properly, 0 for an error
+    @brief  Sends one Type B frame and checks the CRC_B of the answer.
+            The CIU runs with CRC generation off (CategoryBConfig), so
+            the CRC is added and stripped here.
+
+    @param  send       Frame without CRC_B
+    @param  sendLength Length of the frame (up to TYPEB_FRAME_MAX - 2)
+    @param  rxbuf      Receive buffer, see pn532_frame_read
+    @param  rxbufLen   Size of rxbuf
+    @param  data       Set to the answer inside rxbuf, CRC_B removed
+
+    @returns 1 on a valid answer, 0 if there was none,
+             PN532_TYPEB_GARBLED if something answered but the frame is
+             corrupt (in an anticollision slot: a collision)
 */
 /**************************************************************************/
-uint8_t readPassiveTargetID(uint8_t cardbaudrate, uint8_t * uid, uint8_t * uidLength, uint16_t timeout) 
+uint8_t pn532_typeb_transceive(uint8_t const * send, uint8_t sendLength, uint8_t * rxbuf, uint16_t rxbufLen, pn532_frame_view_t * data)
 {
-  pn532_packetbuffer[0] = PN532_COMMAND_INLISTPASSIVETARGET;
-  pn532_packetbuffer[1] = 1;  // max 1 cards at once (we can set this to 2 later)
-  pn532_packetbuffer[2] = cardbaudrate;
-//   printf("readPassiveTargetID\r\n");
-  if (! sendCommandCheckAck(pn532_packetbuffer, 3, 1000))
-  {
-//    printf("no cards read\r\n");
-    return 0x0;  // no cards read
+  uint8_t  frame[TYPEB_FRAME_MAX];
+  uint8_t  status;
+  uint16_t crc;
+
+  if (sendLength + TYPEB_CRC_LEN > sizeof(frame)) {
+    return 0;
   }
-//   printf("Wait for a card to enter the field   ");
-  // Wait for a card to enter the field
-//  uint8_t status = PN532_I2C_BUSY;
 
-  uint16_t timer = 0;
-	nrf_delay_ms(50);
-  while (wirereadstatus() != PN532_I2C_READY)
-  {
-    if (timeout != 0) {
-      timer+=1;
-			nrf_delay_us(100);
-      if (timer > timeout) {
+  memcpy(frame, send, sendLength);
+  crc = pn532_typeb_crc(frame, sendLength);
+  frame[sendLength]     = (uint8_t)crc;
+  frame[sendLength + 1] = (uint8_t)(crc >> 8);
 
-//				 printf("wirereadstatus() != PN532_I2C_READY \r\n");
-        return 0x0;
-      }
-    }
+  status = inCommunicateThruStatus(frame, sendLength + TYPEB_CRC_LEN, rxbuf, rxbufLen, data, PN532_RESP_TIMEOUT_CARD);
+  if ((status == PN532_STATUS_NO_FRAME) || ((status & PN532_STATUS_ERROR_MASK) == 0x01)) {
+    return 0;
+  }
+  if (((status & PN532_STATUS_ERROR_MASK) != 0) || (data->len < TYPEB_CRC_LEN + 1)) {
+    return PN532_TYPEB_GARBLED;
+  }
 
+  data->len -= TYPEB_CRC_LEN;
+  crc = pn532_typeb_crc(data->p_data, (uint8_t)data->len);
+  if ((data->p_data[data->len] != (uint8_t)crc) || (data->p_data[data->len + 1] != (uint8_t)(crc >> 8))) {
+    return PN532_TYPEB_GARBLED;
   }
+  return 1;
+}
 
-  // read data packet
-//	 printf("readPassiveTargetID read data packet \r\n");
+/**************************************************************************/
+/*! 
+    @brief  Programs the CIU TxMode/RxMode speed for Type B framing
 
-  wirereaddata(pn532_packetbuffer, 20);  
-  // check some basic stuff
-  /* ISO14443A card response should be in the following format:
-  
-    uint8_t            Description
-    -------------   ------------------------------------------
-    b0..6           Frame header and preamble
-    b7              Tags Found
-    b8              Tag Number (only one used in this example)
-    b9..10          SENS_RES
-    b11             SEL_RES
-    b12             NFCID Length
-    b13..NFCIDLen   NFCID                                      */
-  if (pn532_packetbuffer[7] != 1) 
-    return 0;
-    
-  uint16_t sens_res = pn532_packetbuffer[9];
-  sens_res <<= 8;
-  sens_res |= pn532_packetbuffer[10];
+    @param  dri   PCD to PICC divisor code (0 = 106 kbps ... 3 = 848 kbps)
+    @param  dsi   PICC to PCD divisor code
+*/
+/**************************************************************************/
+static uint8_t typeb_speed_set(uint8_t dri, uint8_t dsi)
+{
+  uint8_t speed = (uint8_t)((dri << 4) | dsi);
 
-  
-  /* Card appears to be Mifare Classic */
-  *uidLength = pn532_packetbuffer[12];
+  if (speed == mp_reader->typeb_speed) {
+    return 1;
+  }
 
-  for (uint8_t i=0; i < pn532_packetbuffer[12]; i++) 
-  {
-    uid[i] = pn532_packetbuffer[13+i];
+  // CIU_TxMode / CIU_RxMode: speed in bits 6..4, type B framing in bits 1..0.
+  pn532_packetbuffer[0] = PN532_COMMAND_WRITEREGISTER;
+  pn532_packetbuffer[1] = 0x63;
+  pn532_packetbuffer[2] = 0x02;
+  pn532_packetbuffer[3] = (uint8_t)((dri << 4) | 0x03);
+  pn532_packetbuffer[4] = 0x63;
+  pn532_packetbuffer[5] = 0x03;
+  pn532_packetbuffer[6] = (uint8_t)((dsi << 4) | 0x03);
 
+  if (!sendCommandCheckAck(pn532_packetbuffer, 7, 1000)) {
+    return 0;
+  }
+  if (!wirereadresponse(pn532_packetbuffer, 9, PN532_RESP_TIMEOUT_CONFIG) ||
+      (pn532_packetbuffer[6] != 0x09)) {
+    return 0;
   }
 
-
+  mp_reader->typeb_speed = speed;
   return 1;
 }
 
-/***** Mifare Classic Functions ******/
-
 /**************************************************************************/
 /*! 
-      Indicates whether the specified block number is the first block
-      in the sector (block 0 relative to the current sector)
+    @brief  Highest divisor code allowed by a Bit_Rate_capability field,
+            or by one half of TA(1) in an ATS
+
+    @param  caps   Bit rates supported in one direction, bit 0 = 212 kbps,
+                   bit 1 = 424 kbps, bit 2 = 848 kbps
+    @param  max    Highest divisor code wanted
 */
 /**************************************************************************/
-bool mifareclassic_IsFirstBlock (uint32_t uiBlock)
+static uint8_t typeb_divisor(uint8_t caps, uint8_t max)
 {
-  // Test if we are in the small or big sectors
-  if (uiBlock < 128)
-    return ((uiBlock) % 4 == 0);
-  else
-    return ((uiBlock) % 16 == 0);
-}
-
+  uint8_t d = 0;
 
-bool mifareclassic_IsTrailerBlock (uint32_t uiBlock)
-{
-  // Test if we are in the small or big sectors
-  if (uiBlock < 128)
-    return ((uiBlock + 1) % 4 == 0);
-  else
-    return ((uiBlock + 1) % 16 == 0);
+  for (uint8_t i = 1; i <= max; i++) {
+    if (caps & (1 << (i - 1))) {
+      d = i;
+    }
+  }
+  return d;
 }
 
 /**************************************************************************/
 /*! 
-    Tries to authenticate a block of memory on a MIFARE card using the
-    INDATAEXCHANGE command.  See section 7.3.8 of the PN532 User Manual
-    for more information on sending MIFARE and other commands.
+    @brief  Sends REQB/WUPB with the given number of slots and collects
+            the first valid ATQB, walking the other slots with
+            Slot-MARKER commands
 
-    @param  uid           Pointer to a uint8_t array containing the card UID
-    @param  uidLen        The length (in bytes) of the card's UID (Should
-                          be 4 for MIFARE Classic)
-    @param  blockNumber   The block number to authenticate.  (0..63 for
-                          1KB cards, and 0..255 for 4KB cards).
-    @param  keyNumber     Which key type to use during authentication
-                          (0 = MIFARE_CMD_AUTH_A, 1 = MIFARE_CMD_AUTH_B)
-    @param  keyData       Pointer to a uint8_t array containing the 6 uint8_t
-                          key value
-    
-    @returns 1 if everything executed properly, 0 for an error
+    @returns 1 if an ATQB was taken, 0 if no card answered,
+             PN532_TYPEB_GARBLED if cards answered but all collided
 */
 /**************************************************************************/
-uint8_t mifareclassic_AuthenticateBlock (uint8_t * uid, uint8_t uidLen, uint32_t blockNumber, uint8_t keyNumber, uint8_t * keyData)
+static uint8_t typeb_anticollision(uint8_t slotsCode, pn532_typeb_target_t * target)
 {
-  uint8_t len;
-  uint8_t i;
-  
-  // Hang on to the key and uid data
-	for(uint8_t i = 0; i < 6; i++)
-	{
-		 _key[i] =keyData[i];
-	}	
-	
-	for(uint8_t i = 0; i < 4; i++)
-	{
-		 _uid[i] =uid[i];
-	}	
-  _uidLen = uidLen;  
+  pn532_frame_view_t data;
+  uint8_t            rx[1 + PN532_FRAME_OVERHEAD + 2 + TYPEB_ATQB_LEN + 1 + TYPEB_CRC_LEN];
+  uint8_t            cmd[3];
+  uint8_t            slots     = (uint8_t)(1 << slotsCode);
+  uint8_t            collision = 0;
 
-  
-  
-  // Prepare the authentication command //
-  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;   /* Data Exchange Header */
-  pn532_packetbuffer[1] = 1;                              /* Max card numbers */
-  pn532_packetbuffer[2] = (keyNumber) ? MIFARE_CMD_AUTH_B : MIFARE_CMD_AUTH_A;
-  pn532_packetbuffer[3] = blockNumber;
-	
-  for(uint8_t i = 0; i < 6; i++)
-	{
-		 pn532_packetbuffer[4+i] =_key[i];
-	}		
-	/* Block Number (1K = 0..63, 4K = 0..255 */
+  cmd[0] = TYPEB_APF;
+  cmd[1] = 0x00;                          // AFI: all application families
+  cmd[2] = TYPEB_PARAM_WUPB | slotsCode;
 
-  for (i = 0; i < _uidLen; i++)
+  for (uint8_t slot = 1; slot <= slots; slot++)
   {
-    pn532_packetbuffer[10+i] = _uid[i];                /* 4 uint8_t card ID */
-  }
+    uint8_t res;
 
-  if (! sendCommandCheckAck(pn532_packetbuffer, 10+_uidLen, 1000))
-    return 0;
+    if (slot == 1) {
+      res = pn532_typeb_transceive(cmd, 3, rx, sizeof(rx), &data);
+    } else {
+      uint8_t marker = (uint8_t)(((slot - 1) << 4) | TYPEB_APF);
+      res = pn532_typeb_transceive(&marker, 1, rx, sizeof(rx), &data);
+    }
 
-  // Read the response packet
-//	 printf("Read the response packet\r\n");
-	nrf_delay_ms(10);
-  wirereaddata(pn532_packetbuffer, 12);
-//  printf("Read ok\r\n");
-  // Check if the response is valid and we are authenticated???
-  // for an auth success it should be bytes 5-7: 0xD5 0x41 0x00
-  // Mifare auth error is technically uint8_t 7: 0x14 but anything other and 0x00 is not good
-	
-  if (pn532_packetbuffer[7] != 0x00)
-  {
-    
-    return 0;
-  }  
-  
-  return 1;
-}
+    if ((res == 1) && (data.len >= TYPEB_ATQB_LEN) && (data.p_data[0] == TYPEB_ATQB)) {
+      memcpy(target->pupi,      &data.p_data[1], 4);
+      memcpy(target->app_data,  &data.p_data[5], 4);
+      memcpy(target->prot_info, &data.p_data[9], 3);
+      return 1;
+    }
+    if (res != 0) {
+      collision = 1;
+    }
+  }
 
+  return collision ? PN532_TYPEB_GARBLED : 0;
+}
 
 /**************************************************************************/
 /*! 
-    Tries to read an entire 16-uint8_t data block at the specified block
-    address.
-
-    @param  blockNumber   The block number to authenticate.  (0..63 for
-                          1KB cards, and 0..255 for 4KB cards).
-    @param  data          Pointer to the uint8_t array that will hold the
-                          retrieved data (if any)
+    Activates one ISO14443-3B card: WUPB with slot-marker anticollision,
+    then ATTRIB at the highest bit rate both sides support. The reader
+    must be in PN532_RF_MODE_ISO14443B.
     
-    @returns 1 if everything executed properly, 0 for an error
+    @param  maxBitRate  Highest bit rate to negotiate, PN532_TYPEB_BITRATE_x
+    @param  target      Filled with the ATQB fields and the negotiated
+                        parameters
+    @param  timeout     Keep polling for about this many ms until a card
+                        answers, 0 for a single poll
+    
+    @returns 1 if a card has been activated, 0 otherwise
 */
 /**************************************************************************/
-uint8_t mifareclassic_ReadDataBlock (uint8_t blockNumber, uint8_t * data)
+uint8_t pn532_typeb_select(uint8_t maxBitRate, pn532_typeb_target_t * target, uint16_t timeout)
 {
-  
-  
-  /* Prepare the command */
-  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
-  pn532_packetbuffer[1] = 1;                      /* Card number */
-  pn532_packetbuffer[2] = MIFARE_CMD_READ;        /* Mifare Read command = 0x30 */
-  pn532_packetbuffer[3] = blockNumber;            /* Block Number (0..63 for 1K, 0..255 for 4K) */
+  static uint8_t const slot_codes[] = {0, 2, 4};  // 1, 4 and 16 slots
+  pn532_frame_view_t   data;
+  uint8_t              rx[1 + PN532_FRAME_OVERHEAD + 2 + 1 + TYPEB_CRC_LEN + 8];
+  uint8_t              attrib[9];
+  uint8_t              found = 0;
+  uint32_t             waited = 0;
+
+  // REQB and ATTRIB always go out at 106 kbps.
+  if (!typeb_speed_set(0, 0)) {
+    return 0;
+  }
 
-  /* Send the command */
-  if (! sendCommandCheckAck(pn532_packetbuffer, 4, 1000))
+  do
   {
-    
+    for (uint8_t i = 0; i < ARRAY_SIZE(slot_codes); i++)
+    {
+      found = typeb_anticollision(slot_codes[i], target);
+      if (found != PN532_TYPEB_GARBLED) {
+        break;  // A card, or silence: more slots will not help.
+      }
+    }
+    waited += TYPEB_NO_CARD_MS;
+  } while ((found != 1) && (waited < timeout));
+
+  if (found != 1) {
     return 0;
   }
 
-  /* Read the response packet */
-	nrf_delay_ms(10);
-  wirereaddata(pn532_packetbuffer, 26);
+  /* ProtInfo: [0] Bit_Rate_capability, [1] FSCI | Protocol_Type,
+     [2] FWI | ADC | FO (bit 0: CID supported) */
+  uint8_t caps = target->prot_info[0];
+  if (maxBitRate > PN532_TYPEB_BITRATE_848) {
+    maxBitRate = PN532_TYPEB_BITRATE_848;
+  }
+  target->dri = typeb_divisor(caps & 0x07, maxBitRate);
+  target->dsi = typeb_divisor((caps >> 4) & 0x07, maxBitRate);
+  if (caps & 0x80) {
+    // Same bit rate in both directions only.
+    uint8_t d = MIN(target->dri, target->dsi);
+    while ((d > 0) && !((caps & (1 << (d - 1))) && (caps & (0x10 << (d - 1))))) {
+      d--;
+    }
+    target->dri = d;
+    target->dsi = d;
+  }
+  target->cid = (target->prot_info[2] & 0x01) ? 1 : 0;
 
-  /* If uint8_t 8 isn't 0x00 we probably have an error */
-  if (pn532_packetbuffer[7] != 0x00)
-  {
-    
+  attrib[0] = TYPEB_ATTRIB;
+  memcpy(&attrib[1], target->pupi, 4);
+  attrib[5] = 0x00;                                                  // Param 1: default TR0/TR1, SOF and EOF
+  attrib[6] = (uint8_t)((target->dsi << 6) | (target->dri << 4) | TYPEB_FSDI);
+  attrib[7] = target->prot_info[1] & 0x0F;                           // Param 3: protocol type echoed
+  attrib[8] = target->cid;                                           // Param 4: CID
+
+  if ((pn532_typeb_transceive(attrib, sizeof(attrib), rx, sizeof(rx), &data) != 1) ||
+      (data.len < 1) || ((data.p_data[0] & 0x0F) != target->cid)) {
     return 0;
   }
-    
-  /* Copy the 16 data bytes to the output buffer        */
-  /* Block content starts at uint8_t 9 of a valid response */
-  memcpy (data, pn532_packetbuffer+8, 16);
-
-  /* Display data for debug if requested */
-  
 
-  return 1;  
+  return typeb_speed_set(target->dri, target->dsi);
 }
 
-
 /**************************************************************************/
 /*! 
-    Tries to write an entire 16-uint8_t data block at the specified block
-    address.
+    Sends HLTB so the card stays quiet until the next WUPB
+*/
+/**************************************************************************/
+uint8_t pn532_typeb_halt(pn532_typeb_target_t const * target)
+{
+  pn532_frame_view_t data;
+  uint8_t            rx[1 + PN532_FRAME_OVERHEAD + 2 + 1 + TYPEB_CRC_LEN + 8];
+  uint8_t            hltb[5];
 
-    @param  blockNumber   The block number to authenticate.  (0..63 for
-                          1KB cards, and 0..255 for 4KB cards).
-    @param  data          The uint8_t array that contains the data to write.
+  hltb[0] = TYPEB_HLTB;
+  memcpy(&hltb[1], target->pupi, 4);
+
+  return (pn532_typeb_transceive(hltb, sizeof(hltb), rx, sizeof(rx), &data) == 1);
+}
+
+/**************************************************************************/
+/*! 
+    Reads the 8-byte UID of a Type B card with the GET UID command used
+    by ID cards (00 36 00 00 08), then halts the card
+    
+    @param  cardbaudrate  Highest bit rate to negotiate, PN532_TYPEB_BITRATE_x
+    @param  uid           Receives the 8-byte UID
+    @param  uidLength     Set to the UID length
+    @param  timeout       Polling time in ms, see pn532_typeb_select
     
     @returns 1 if everything executed properly, 0 for an error
 */
 /**************************************************************************/
-uint8_t mifareclassic_WriteDataBlock (uint8_t blockNumber, uint8_t * data)
+uint8_t readTypeBuid(uint8_t cardbaudrate, uint8_t * uid, uint8_t * uidLength, uint16_t timeout) 
 {
-  
-  
-  /* Prepare the first command */
-  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
-  pn532_packetbuffer[1] = 1;                      /* Card number */
-  pn532_packetbuffer[2] = MIFARE_CMD_WRITE;       /* Mifare Write command = 0xA0 */
-  pn532_packetbuffer[3] = blockNumber;            /* Block Number (0..63 for 1K, 0..255 for 4K) */
-  memcpy (pn532_packetbuffer+4, data, 16);          /* Data Payload */
+  static uint8_t const get_uid[] = {0x00, 0x36, 0x00, 0x00, 0x08};
+  pn532_typeb_target_t target;
+  pn532_frame_view_t   data;
+  uint8_t              rx[1 + PN532_FRAME_OVERHEAD + 2 + 8 + 2 + TYPEB_CRC_LEN + 4];
 
-  /* Send the command */
-  if (! sendCommandCheckAck(pn532_packetbuffer, 20, 1000))
-  {
-    
+  if (!pn532_typeb_select(cardbaudrate, &target, timeout)) {
     return 0;
-  }  
-  nrf_delay_ms(100);
-  
-  /* Read the response packet */
-  wirereaddata(pn532_packetbuffer, 26);
+  }
 
-  return 1;  
+  // Answer: UID, SW1 SW2.
+  if ((pn532_typeb_transceive(get_uid, sizeof(get_uid), rx, sizeof(rx), &data) != 1) ||
+      (data.len < 8 + 2) ||
+      (data.p_data[data.len - 2] != 0x90) || (data.p_data[data.len - 1] != 0x00)) {
+    return 0;
+  }
+
+  memcpy(uid, data.p_data, 8);
+  *uidLength = 8;
+
+  (void)pn532_typeb_halt(&target);
+  return 1;
 }
+/***** FeliCa Commands ******/
 
+#define FELICA_CMD_POLLING        0x00
+#define FELICA_CMD_READ_WO_ENC    0x06
+#define FELICA_RES_READ_WO_ENC    0x07
+#define FELICA_POL_RES_LEN        18    // POL_RES without the system code, its length byte included
+#define FELICA_READ_RES_LEN       13    // Read Without Encryption answer up to the block data
+#define FELICA_BLOCK_LEN          16
 
 /**************************************************************************/
 /*! 
-    Formats a Mifare Classic card to store NDEF Records 
-    
-    @returns 1 if everything executed properly, 0 for an error
+    Polls for one FeliCa card with InListPassiveTarget, which sends the
+    Polling command with the given system code for us
+
+    Only cards with a system matching @p systemCode answer, so a
+    reader looking for one transit system does not wake the others;
+    FELICA_SYSTEM_CODE_ANY matches every card. The card is the target of
+    the following felica_ReadWithoutEncryption calls. Call
+    pn532_rf_mode_set(PN532_RF_MODE_FELICA) first.
+
+    @param  cardbaudrate  PN532_FELICA_212 or PN532_FELICA_424
+    @param  systemCode    System code to poll for
+    @param  requestCode   FELICA_REQUEST_SYSTEM_CODE to get the system
+                          code of the card back, FELICA_REQUEST_NONE else
+    @param  target        Filled with IDm, PMm and, if requested, the
+                          system code
+    @param  timeout       Deadline in ms for the poll, 0 to wait forever
+
+    @returns 1 if a card answered, 0 for none or an error
 */
 /**************************************************************************/
-uint8_t mifareclassic_FormatNDEF (void)
+uint8_t felica_Polling(uint8_t cardbaudrate, uint16_t systemCode, uint8_t requestCode,
+                       pn532_felica_target_t * target, uint16_t timeout)
 {
-  uint8_t sectorbuffer1[16] = {0x14, 0x01, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1};
-  uint8_t sectorbuffer2[16] = {0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1};
-  uint8_t sectorbuffer3[16] = {0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0x78, 0x77, 0x88, 0xC1, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  pn532_frame_view_t view;
+  uint8_t            pol_len;
 
-  // Note 0xA0 0xA1 0xA2 0xA3 0xA4 0xA5 must be used for key A
-  // for the MAD sector in NDEF records (sector 0)
-  
-  // Write block 1 and 2 to the card
-  if (!(mifareclassic_WriteDataBlock (1, sectorbuffer1)))
+  pn532_packetbuffer[0] = PN532_COMMAND_INLISTPASSIVETARGET;
+  pn532_packetbuffer[1] = 1;
+  pn532_packetbuffer[2] = cardbaudrate;
+  pn532_packetbuffer[3] = FELICA_CMD_POLLING;
+  pn532_packetbuffer[4] = MSB_16(systemCode);
+  pn532_packetbuffer[5] = LSB_16(systemCode);
+  pn532_packetbuffer[6] = requestCode;
+  pn532_packetbuffer[7] = 0;  // one time slot: the first card wins
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, 8, 1000))
     return 0;
-  if (!(mifareclassic_WriteDataBlock (2, sectorbuffer2)))
+  if (!wirereadframe(&view, PN532_PACKBUFFSIZ, timeout))
     return 0;
-  // Write key A and access rights card
-  if (!(mifareclassic_WriteDataBlock (3, sectorbuffer3)))
+
+  /* view: response code, NbTg, Tg, POL_RES length, 01, IDm, PMm, system code */
+  if ((view.len < 4 + FELICA_POL_RES_LEN - 1) ||
+      (view.p_data[0] != PN532_RESPONSE_INLISTPASSIVETARGET) || (view.p_data[1] != 1))
     return 0;
 
-  // Seems that everything was OK (?!)
+  pol_len = view.p_data[3];
+  if ((pol_len < FELICA_POL_RES_LEN) || (view.len < 3 + pol_len))
+    return 0;
+
+  memcpy(target->idm, &view.p_data[5], sizeof(target->idm));
+  memcpy(target->pmm, &view.p_data[13], sizeof(target->pmm));
+  target->sys_code = (pol_len >= FELICA_POL_RES_LEN + 2) ?
+                     uint16_big_decode(&view.p_data[21]) : FELICA_SYSTEM_CODE_ANY;
+  pn532_target_select(view.p_data[2]);
   return 1;
 }
 
+/**************************************************************************/
+/*! 
+    Reads several blocks of a FeliCa card with one Read Without
+    Encryption command, straight into a caller buffer
+
+    The answer is larger than pn532_packetbuffer for more than two
+    blocks, so it is read like inDataExchangeInto does: @p rxbuf has to
+    take the whole frame, 13 + 16 bytes per block plus the frame
+    overhead, a frame_pool block for PN532_FELICA_READ_MAX_BLOCKS.
+
+    @param  target        Card found by felica_Polling
+    @param  serviceCount  Services in @p serviceCodes (1..16)
+    @param  serviceCodes  Service codes, of services without encryption
+    @param  blockCount    Blocks to read (1..PN532_FELICA_READ_MAX_BLOCKS)
+    @param  blockList     Blocks, FELICA_BLOCK(service index, block number)
+    @param  rxbuf         Receive buffer, see pn532_frame_read
+    @param  rxbufLen      Size of rxbuf
+    @param  data          Set to the block data inside rxbuf, 16 bytes a block
+
+    @returns 1 on success, 0 on timeout, bad frame or an error status
+             from the card
+*/
+/**************************************************************************/
+uint8_t felica_ReadWithoutEncryption(pn532_felica_target_t const * target, uint8_t serviceCount,
+                                     uint16_t const * serviceCodes, uint8_t blockCount,
+                                     uint16_t const * blockList, uint8_t * rxbuf, uint16_t rxbufLen,
+                                     pn532_frame_view_t * data)
+{
+  uint8_t            cmd[PN532_PACKBUFFSIZ - 2];
+  uint8_t            len = 1;
+  pn532_frame_view_t res;
+
+  if ((serviceCount == 0) || (serviceCount > 16) ||
+      (blockCount == 0) || (blockCount > PN532_FELICA_READ_MAX_BLOCKS) ||
+      (1 + 1 + 8 + 1 + 2 * serviceCount + 1 + 3 * blockCount > sizeof(cmd)))
+    return 0;
+
+  /* LEN, command, IDm, services (little endian), blocks: 2-byte elements
+     for blocks below 256, 3-byte ones above. */
+  cmd[len++] = FELICA_CMD_READ_WO_ENC;
+  memcpy(&cmd[len], target->idm, sizeof(target->idm));
+  len += sizeof(target->idm);
+  cmd[len++] = serviceCount;
+  for (uint8_t i = 0; i < serviceCount; i++)
+  {
+    len += uint16_encode(serviceCodes[i], &cmd[len]);
+  }
+  cmd[len++] = blockCount;
+  for (uint8_t i = 0; i < blockCount; i++)
+  {
+    uint8_t  service = (uint8_t)(blockList[i] >> 12);
+    uint16_t block   = blockList[i] & 0x0FFF;
+
+    if (block <= 0xFF)
+    {
+      cmd[len++] = 0x80 | service;
+      cmd[len++] = (uint8_t)block;
+    }
+    else
+    {
+      cmd[len++] = service;
+      len += uint16_encode(block, &cmd[len]);
+    }
+  }
+  cmd[0] = len;
+
+  if (!inDataExchangeInto(cmd, len, rxbuf, rxbufLen, &res))
+    return 0;
+
+  /* res: LEN, 07, IDm, status flag 1 and 2, block count, block data */
+  if ((res.len < FELICA_READ_RES_LEN - 1) || (res.p_data[0] != res.len) ||
+      (res.p_data[1] != FELICA_RES_READ_WO_ENC) ||
+      (memcmp(&res.p_data[2], target->idm, sizeof(target->idm)) != 0) ||
+      (res.p_data[10] != 0))
+    return 0;
+  if ((res.len != FELICA_READ_RES_LEN + blockCount * FELICA_BLOCK_LEN) || (res.p_data[12] != blockCount))
+    return 0;
+
+  data->p_data = &res.p_data[FELICA_READ_RES_LEN];
+  data->len    = blockCount * FELICA_BLOCK_LEN;
+  return 1;
+}
+/***** Innovision Jewel / Topaz (Type 1 Tag) Commands ******/
 
 /**************************************************************************/
-uint8_t mifareclassic_WriteNDEFURI (uint8_t sectorNumber, uint8_t uriIdentifier, const char * url)
+/*! 
+    Polls for one Jewel or Topaz tag with InListPassiveTarget (BrTy 4),
+    which runs REQA and RID for us. The tag is the target of the
+    following jewel_ReadAll and jewel_Read8 calls. Call
+    pn532_rf_mode_set(PN532_RF_MODE_JEWEL) first.
+
+    @param  target        Filled with SENS_RES and the JEWELID
+    @param  timeout       Deadline in ms for the poll, 0 to wait forever
+
+    @returns 1 if a tag answered, 0 for none or an error
+*/
+/**************************************************************************/
+uint8_t jewel_Poll(pn532_jewel_target_t * target, uint16_t timeout)
 {
-  // Figure out how long the string is
-  uint8_t len = strlen(url);
-  
-  // Make sure we're within a 1K limit for the sector number
-  if ((sectorNumber < 1) || (sectorNumber > 15))
+  pn532_frame_view_t view;
+
+  if (!sendFrameCheckAck(m_frame_list_jewel, sizeof(m_frame_list_jewel), 1000))
     return 0;
-  
-  // Make sure the URI payload is between 1 and 38 chars
-  if ((len < 1) || (len > 38))
+  if (!wirereadframe(&view, PN532_PACKBUFFSIZ, timeout))
     return 0;
-    
-  // Note 0xD3 0xF7 0xD3 0xF7 0xD3 0xF7 must be used for key A
-  // in NDEF records
-	
-  // Setup the sector buffer (w/pre-formatted TLV wrapper and NDEF message)
-  uint8_t sectorbuffer1[16] = {0x00, 0x00, 0x03, len+5, 0xD1, 0x01, len+1, 0x55, uriIdentifier, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-  uint8_t sectorbuffer2[16] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-  uint8_t sectorbuffer3[16] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-  uint8_t sectorbuffer4[16] = {0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7, 0x7F, 0x07, 0x88, 0x40, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-  if (len <= 6)
+
+  /* view: response code, NbTg, Tg, SENS_RES (2), JEWELID (4) */
+  if ((view.len < 5 + JEWEL_ID_LEN) ||
+      (view.p_data[0] != PN532_RESPONSE_INLISTPASSIVETARGET) || (view.p_data[1] != 1))
+    return 0;
+
+  target->sens_res = ((uint16_t)view.p_data[3] << 8) | view.p_data[4];
+  memcpy(target->id, &view.p_data[5], JEWEL_ID_LEN);
+  pn532_target_select(view.p_data[2]);
+  return 1;
+}
+
+/**************************************************************************/
+/*! 
+    Reads HR0, HR1 and the first 120 bytes (blocks 0x00..0x0E) of the
+    tag with one RALL, straight into a caller buffer
+
+    The answer does not fit pn532_packetbuffer, so @p rxbuf has to take
+    the whole frame, JEWEL_RALL_RXBUF_LEN bytes. On a static memory tag
+    (HR0 JEWEL_HR0_STATIC) this is all of it; a Topaz 512 continues
+    past block 0x0E, see jewel_Read8.
+
+    @param  target        Tag found by jewel_Poll
+    @param  rxbuf         Receive buffer, see pn532_frame_read
+    @param  rxbufLen      Size of rxbuf
+    @param  data          Set to HR0, HR1 and the 120 bytes inside rxbuf
+
+    @returns 1 on success, 0 on timeout, bad frame or card error
+*/
+/**************************************************************************/
+uint8_t jewel_ReadAll(pn532_jewel_target_t const * target, uint8_t * rxbuf, uint16_t rxbufLen,
+                      pn532_frame_view_t * data)
+{
+  uint8_t            cmd[3 + JEWEL_ID_LEN];
+  pn532_frame_view_t res;
+
+  cmd[0] = JEWEL_CMD_RALL;
+  cmd[1] = 0x00;
+  cmd[2] = 0x00;
+  memcpy(&cmd[3], target->id, JEWEL_ID_LEN);
+
+  if (!inDataExchangeInto(cmd, sizeof(cmd), rxbuf, rxbufLen, &res))
+    return 0;
+  if (res.len != JEWEL_RALL_LEN)
+    return 0;
+
+  *data = res;
+  return 1;
+}
+
+/**************************************************************************/
+/*! 
+    Reads one 8-byte block of a dynamic memory tag (Topaz 512) with
+    READ8. Blocks 0x0F and up are only reached this way.
+
+    @param  target        Tag found by jewel_Poll
+    @param  block         Block number (0x00..0x3F on a Topaz 512)
+    @param  buffer        Pointer to an 8 uint8_t array that will hold
+                          the block
+
+    @returns 1 on success, 0 on timeout, bad frame or card error
+*/
+/**************************************************************************/
+uint8_t jewel_Read8(pn532_jewel_target_t const * target, uint8_t block, uint8_t * buffer)
+{
+  pn532_frame_view_t view;
+
+  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
+  pn532_packetbuffer[1] = mp_reader->tg;
+  pn532_packetbuffer[2] = JEWEL_CMD_READ8;
+  pn532_packetbuffer[3] = block;
+  memset(&pn532_packetbuffer[4], 0, JEWEL_BLOCK_LEN);
+  memcpy(&pn532_packetbuffer[4 + JEWEL_BLOCK_LEN], target->id, JEWEL_ID_LEN);
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, 4 + JEWEL_BLOCK_LEN + JEWEL_ID_LEN, 1000))
+    return 0;
+  if (!wirereadframe(&view, 1 + JEWEL_BLOCK_LEN + PN532_FRAME_OVERHEAD + 2, PN532_RESP_TIMEOUT_CARD))
+    return 0;
+
+  /* view: response code, status, ADD8, block */
+  if ((view.len != 3 + JEWEL_BLOCK_LEN) || (view.p_data[0] != PN532_RESPONSE_INDATAEXCHANGE) ||
+      ((view.p_data[1] & 0x3f) != 0) || (view.p_data[2] != block))
+    return 0;
+
+  memcpy(buffer, &view.p_data[3], JEWEL_BLOCK_LEN);
+  return 1;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Brings the reader into the given RF mode, sending only the
+            commands that differ from the mode it is already in
+
+    SAMConfiguration is sent once after power up (or after
+    pn532_rf_mode_invalidate). Entering ISO14443B runs the Type B RF,
+    CIU register and parameter setup; leaving it only restores the
+    default SetParameters flags, because InListPassiveTarget reprograms
+    the CIU modulation for the A, FeliCa and Jewel baud rates itself.
+    The analog settings InListPassiveTarget loads for them are sent
+    along with SAMConfiguration (pn532_tune_apply).
+
+    @param  mode      Wanted RF mode
+
+    @returns  1 if the reader is in the requested mode, 0 on error
+*/
+/**************************************************************************/
+uint8_t pn532_rf_mode_set(pn532_rf_mode_t mode)
+{
+  if (!mp_reader->sam_configured)
   {
-    // Unlikely we'll get a url this short, but why not ...
-    memcpy (sectorbuffer1+9, url, len);
-    sectorbuffer1[len+9] = 0xFE;
+    LAT_TRACE_START(t);
+    if (!SAMConfig())
+    {
+      return 0;
+    }
+    LAT_TRACE_STOP(LAT_STAGE_SAM, t);
+#if NRF_MODULE_ENABLED(PN532_TUNE)
+    if (!pn532_tune_apply())
+    {
+      return 0;
+    }
+#endif
+    mp_reader->sam_configured = true;
   }
-  else if (len == 7)
+
+  if (mode == mp_reader->rf_mode)
   {
-    // 0xFE needs to be wrapped around to next block
-    memcpy (sectorbuffer1+9, url, len);
-    sectorbuffer2[0] = 0xFE;
+    return 1;
   }
-  else if ((len > 7) && (len <= 22))
+
+  // Until the switch completes the chip is in an unknown mix of settings.
+  pn532_rf_mode_t prev_mode = mp_reader->rf_mode;
+  mp_reader->rf_mode = PN532_RF_MODE_NONE;
+
+  if (mode == PN532_RF_MODE_ISO14443B)
   {
-    // Url fits in two blocks
-    memcpy (sectorbuffer1+9, url, 7);
-    memcpy (sectorbuffer2, url+7, len-7);
-    sectorbuffer2[len-7] = 0xFE;
+    if (!SetRFConfiguration() || !CategoryBConfig() || !SetParameters())
+    {
+      return 0;
+    }
+    mp_reader->typeb_speed = 0;  // CategoryBConfig leaves TxMode/RxMode at 106 kbps
   }
-  else if (len == 23)
+  else if ((prev_mode == PN532_RF_MODE_ISO14443B) || (prev_mode == PN532_RF_MODE_NONE))
   {
-    // 0xFE needs to be wrapped around to final block
-    memcpy (sectorbuffer1+9, url, 7);
-    memcpy (sectorbuffer2, url+7, len-7);
-    sectorbuffer3[0] = 0xFE;
+    // Default flags: fAutomaticRATS | fAutomaticATR_RES.
+    if (!setParametersFlags(0x14))
+    {
+      return 0;
+    }
   }
-  else
+
+  mp_reader->rf_mode = mode;
+  return 1;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Returns the RF mode the reader was last configured for
+*/
+/**************************************************************************/
+pn532_rf_mode_t pn532_rf_mode_get(void)
+{
+  return mp_reader->rf_mode;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Forgets the cached SAM and RF configuration, so that the next
+            pn532_rf_mode_set call sends the full setup again. Call this
+            when the chip may have lost its state (power down, reset).
+*/
+/**************************************************************************/
+void pn532_rf_mode_invalidate(void)
+{
+  mp_reader->sam_configured = false;
+  mp_reader->rf_mode        = PN532_RF_MODE_NONE;
+  mp_reader->typeb_speed    = 0;
+  mp_reader->psl_speed      = 0;
+  mp_reader->psl_open       = false;
+}
+
+/**************************************************************************/
+/*! 
+    Sets the MxRtyPassiveActivation uint8_t of the RFConfiguration register
+    
+    @param  maxRetries    0xFF to wait forever, 0x00..0xFE to timeout
+                          after mxRetries
+    
+    @returns 1 if everything executed properly, 0 for an error
+*/
+/**************************************************************************/
+uint8_t setPassiveActivationRetries(uint8_t maxRetries) 
+{
+  pn532_packetbuffer[0] = PN532_COMMAND_RFCONFIGURATION;
+  pn532_packetbuffer[1] = 5;    // Config item 5 (MaxRetries)
+  pn532_packetbuffer[2] = 0xFF; // MxRtyATR (default = 0xFF)
+  pn532_packetbuffer[3] = 0x01; // MxRtyPSL (default = 0x01)
+  pn532_packetbuffer[4] = maxRetries;
+	
+  if (! sendCommandCheckAck(pn532_packetbuffer, 5, 1000))
+    return 0x0;  // no ACK
+
+  // Read the reply, so that it is not taken for the ACK of the next command.
+  if (! wirereadresponse(pn532_packetbuffer, REPLY_RFCONFIGURATION_LENGTH, PN532_RESP_TIMEOUT_CONFIG))
+    return 0x0;
+
+  return 1;
+}
+
+/**************************************************************************/
+/*! 
+    Lists up to PN532_MAX_TARGETS ISO14443A targets in a single
+    InListPassiveTarget poll
+    
+    @param  cardbaudrate  Baud rate of the cards
+    @param  targets       Table filled with one entry per target found
+    @param  maxTargets    Size of the table (1..PN532_MAX_TARGETS)
+    @param  timeout       Deadline in ms for the poll, 0 to wait forever
+    
+    @returns Number of targets stored in the table, 0 if none was found
+*/
+/**************************************************************************/
+uint8_t readPassiveTargets(uint8_t cardbaudrate, pn532_target_t * targets, uint8_t maxTargets, uint16_t timeout)
+{
+  if (!readPassiveTargetsStart(cardbaudrate, maxTargets))
   {
-    // Url fits in three blocks
-    memcpy (sectorbuffer1+9, url, 7);
-    memcpy (sectorbuffer2, url+7, 16);
-    memcpy (sectorbuffer3, url+23, len-24);
-    sectorbuffer3[len-22] = 0xFE;
+    return 0;
   }
+  return readPassiveTargetsFinish(targets, maxTargets, timeout);
+}
+
+/**************************************************************************/
+/*! 
+    Sends InListPassiveTarget and returns once the PN532 has acknowledged
+    it, while the poll runs on the RF side. Other readers can be served
+    until readPassiveTargetsFinish collects the result.
+    
+    @param  cardbaudrate  Baud rate of the cards
+    @param  maxTargets    Targets to list (1..PN532_MAX_TARGETS)
+    
+    @returns 1 if the command was acknowledged, 0 for an error
+*/
+/**************************************************************************/
+uint8_t readPassiveTargetsStart(uint8_t cardbaudrate, uint8_t maxTargets)
+{
+  if (maxTargets > PN532_MAX_TARGETS)
+  {
+    maxTargets = PN532_MAX_TARGETS;
+  }
+  if (maxTargets == 0)
+  {
+    return 0;
+  }
+
+  if ((cardbaudrate == PN532_MIFARE_ISO14443A) && (maxTargets == 1))
+  {
+    // The poll of every cycle.
+    return sendFrameCheckAck(m_frame_list_a, sizeof(m_frame_list_a), 1000);
+  }
+
+  pn532_packetbuffer[0] = PN532_COMMAND_INLISTPASSIVETARGET;
+  pn532_packetbuffer[1] = maxTargets;
+  pn532_packetbuffer[2] = cardbaudrate;
+
+  return sendCommandCheckAck(pn532_packetbuffer, 3, 1000);
+}
+
+/**************************************************************************/
+/*! 
+    Reads the InListPassiveTarget response started by
+    readPassiveTargetsStart and fills the target table
+    
+    @param  targets       Table filled with one entry per target found
+    @param  maxTargets    Size of the table (1..PN532_MAX_TARGETS)
+    @param  timeout       Deadline in ms for the poll, 0 to wait forever
+    
+    @returns Number of targets stored in the table, 0 if none was found
+*/
+/**************************************************************************/
+uint8_t readPassiveTargetsFinish(pn532_target_t * targets, uint8_t maxTargets, uint16_t timeout)
+{
+  uint8_t found;
+  uint8_t pos;
+  uint8_t end;
+
+  if (maxTargets > PN532_MAX_TARGETS)
+  {
+    maxTargets = PN532_MAX_TARGETS;
+  }
+  if (!wirereadresponse(pn532_packetbuffer, PN532_PACKBUFFSIZ, timeout))
+  {
+    return 0;
+  }
+
+  /* b0..2 preamble, b3 LEN, b4 LCS, b5 TFI, b6 command, b7 NbTg, then
+     per target: Tg, SENS_RES (2), SEL_RES, NFCID length, NFCID and,
+     for ISO14443-4 cards (SEL_RES bit 5), the ATS starting with its
+     own length byte. */
+  if ((pn532_packetbuffer[5] != PN532_PN532TOHOST) ||
+      (pn532_packetbuffer[6] != PN532_RESPONSE_INLISTPASSIVETARGET))
+  {
+    return 0;
+  }
+
+  end = 5 + pn532_packetbuffer[3];
+  if (end > PN532_PACKBUFFSIZ - 2)
+  {
+    end = PN532_PACKBUFFSIZ - 2;
+  }
+
+  pos   = 8;
+  found = 0;
+  while ((found < pn532_packetbuffer[7]) && (found < maxTargets) && (pos + 5 <= end))
+  {
+    pn532_target_t * t = &targets[found];
+
+    t->tg       = pn532_packetbuffer[pos];
+    t->sens_res = ((uint16_t)pn532_packetbuffer[pos + 1] << 8) | pn532_packetbuffer[pos + 2];
+    t->sel_res  = pn532_packetbuffer[pos + 3];
+    t->uid_len  = pn532_packetbuffer[pos + 4];
+    pos += 5;
+
+    if ((t->uid_len > sizeof(t->uid)) || (pos + t->uid_len > end))
+    {
+      break;
+    }
+    memcpy(t->uid, &pn532_packetbuffer[pos], t->uid_len);
+    pos += t->uid_len;
+
+    t->ats_len = 0;
+    if (t->sel_res & 0x20)
+    {
+      // Keep the start of the ATS, its first byte counts itself.
+      if ((pos >= end) || (pn532_packetbuffer[pos] == 0))
+      {
+        break;
+      }
+      t->ats_len = pn532_packetbuffer[pos];
+      memcpy(t->ats, &pn532_packetbuffer[pos], MIN(MIN(t->ats_len, sizeof(t->ats)), end - pos));
+      pos += t->ats_len;
+    }
+
+    found++;
+  }
+
+  if (found > 0)
+  {
+    mp_reader->tg = targets[0].tg;
+    // Freshly activated at 106 kbps: the card takes a PPS until the first block.
+    mp_reader->psl_speed = 0;
+    mp_reader->psl_open  = true;
+  }
+
+  return found;
+}
+
+/**************************************************************************/
+/*! 
+    Selects the target addressed by inDataExchange and the Mifare
+    commands
+    
+    @param  tg    Logical target number as returned in pn532_target_t
+*/
+/**************************************************************************/
+void pn532_target_select(uint8_t tg)
+{
+  mp_reader->tg = tg;
+}
+
+/**************************************************************************/
+/*! 
+    Sends the following commands to another PN532: switches the driver
+    state (SAM/RF configuration, selected target) and the bus lines
+    
+    @param  p_reader  Reader context, kept by the caller
+*/
+/**************************************************************************/
+void pn532_reader_select(pn532_reader_t * p_reader)
+{
+  if (p_reader == mp_reader)
+  {
+    return;
+  }
+  mp_reader = p_reader;
+  pn532_bus_select(&p_reader->bus);
+}
+
+pn532_reader_t * pn532_reader_current(void)
+{
+  return mp_reader;
+}
+
+
+/***** ISO14443A Commands ******/
+
+/**************************************************************************/
+/*! 
+    Waits for an ISO14443A target to enter the field
+    
+    @param  cardBaudRate  Baud rate of the card
+    @param  uid           Pointer to the array that will be populated
+                          with the card's UID (PN532_UID_MAX_LEN bytes)
+    @param  uidLength     Pointer to the variable that will hold the
+                          length of the card's UID.
+    
+    @returns 1 if everything executed properly, 0 for an error
+*/
+/**************************************************************************/
+uint8_t readPassiveTargetID(uint8_t cardbaudrate, uint8_t * uid, uint8_t * uidLength, uint16_t timeout) 
+{
+  uint16_t len;
+  boolean  acked;
+
+  if (cardbaudrate == PN532_MIFARE_ISO14443A)
+  {
+    // The poll of every cycle.
+    acked = sendFrameCheckAck(m_frame_list_a, sizeof(m_frame_list_a), 1000);
+  }
+  else
+  {
+    pn532_packetbuffer[0] = PN532_COMMAND_INLISTPASSIVETARGET;
+    pn532_packetbuffer[1] = 1;  // max 1 cards at once (we can set this to 2 later)
+    pn532_packetbuffer[2] = cardbaudrate;
+    acked = sendCommandCheckAck(pn532_packetbuffer, 3, 1000);
+  }
+//   printf("readPassiveTargetID\r\n");
+  if (!acked)
+  {
+//    printf("no cards read\r\n");
+    return 0x0;  // no cards read
+  }
+//   printf("Wait for a card to enter the field   ");
+  // Wait for a card to enter the field
+//  uint8_t status = PN532_I2C_BUSY;
+
+  if (!waitUntilReady(timeout))
+  {
+//				 printf("wirereadstatus() != PN532_I2C_READY \r\n");
+    return 0x0;
+  }
+
+  // read data packet
+//	 printf("readPassiveTargetID read data packet \r\n");
+
+  // Whole, also for 10 byte UIDs; the indices below are of the raw frame.
+  len = frame_read_sized(pn532_packetbuffer - 1, resp_size_get(20), PN532_PACKBUFFSIZ, timeout);
+  if (len == 0)
+  {
+    return 0x0;
+  }
+  // check some basic stuff
+  /* ISO14443A card response should be in the following format:
+  
+    uint8_t            Description
+    -------------   ------------------------------------------
+    b0..6           Frame header and preamble
+    b7              Tags Found
+    b8              Tag Number (only one used in this example)
+    b9..10          SENS_RES
+    b11             SEL_RES
+    b12             NFCID Length
+    b13..NFCIDLen   NFCID                                      */
+  if (pn532_packetbuffer[7] != 1) 
+    return 0;
+    
+  uint16_t sens_res = pn532_packetbuffer[9];
+  sens_res <<= 8;
+  sens_res |= pn532_packetbuffer[10];
+
+  
+  mp_reader->tg = pn532_packetbuffer[8];
+
+  if ((pn532_packetbuffer[12] > PN532_UID_MAX_LEN) || (13 + pn532_packetbuffer[12] > len))
+  {
+    return 0x0;
+  }
+  *uidLength = pn532_packetbuffer[12];
+
+  for (uint8_t i=0; i < pn532_packetbuffer[12]; i++) 
+  {
+    uid[i] = pn532_packetbuffer[13+i];
+
+  }
+
+
+  return 1;
+}
+
+/***** Mifare Classic Functions ******/
+
+/**************************************************************************/
+/*! 
+      Indicates whether the specified block number is the first block
+      in the sector (block 0 relative to the current sector)
+*/
+/**************************************************************************/
+bool mifareclassic_IsFirstBlock (uint32_t uiBlock)
+{
+  // Test if we are in the small or big sectors
+  if (uiBlock < 128)
+    return ((uiBlock) % 4 == 0);
+  else
+    return ((uiBlock) % 16 == 0);
+}
+
+
+bool mifareclassic_IsTrailerBlock (uint32_t uiBlock)
+{
+  // Test if we are in the small or big sectors
+  if (uiBlock < 128)
+    return ((uiBlock + 1) % 4 == 0);
+  else
+    return ((uiBlock + 1) % 16 == 0);
+}
+
+/**************************************************************************/
+/*! 
+    Gives the group of access conditions a block falls under: the block
+    in a small sector, five blocks each in a big one, and
+    MIFARE_ACCESS_TRAILER for the trailer
+*/
+/**************************************************************************/
+uint8_t mifareclassic_AccessGroup (uint32_t uiBlock)
+{
+  if (uiBlock < 128)
+    return (uiBlock % 4);
+  else
+    return ((uiBlock % 16) / 5);
+}
+
+/**************************************************************************/
+/*! 
+    Decodes the access bits of a sector trailer
+
+    Bytes 6..8 hold C1, C2 and C3 of the four groups, each also
+    inverted; a trailer whose copies disagree blocks its sector for
+    good, and is reported as not valid.
+
+    @param  trailer       16 bytes of the trailer, or its bytes 6..8 at
+                          trailer + 6
+    @param  access        Receives C1 C2 C3 of group g at bits 3g+2,
+                          3g+1 and 3g, for mifareclassic_AccessOps
+
+    @returns 1 if the access bits are valid, 0 otherwise
+*/
+/**************************************************************************/
+uint8_t mifareclassic_AccessDecode (uint8_t const * trailer, uint16_t * access)
+{
+  uint8_t c1 = trailer[7] >> 4;
+  uint8_t c2 = trailer[8] & 0x0F;
+  uint8_t c3 = trailer[8] >> 4;
+
+  if (((trailer[6] & 0x0F) != (uint8_t)(~c1 & 0x0F)) ||
+      ((trailer[6] >> 4)   != (uint8_t)(~c2 & 0x0F)) ||
+      ((trailer[7] & 0x0F) != (uint8_t)(~c3 & 0x0F)))
+  {
+    return 0;
+  }
+
+  *access = 0;
+  for (uint8_t g = 0; g < 4; g++)
+  {
+    *access |= (uint16_t)((((c1 >> g) & 1) << 2) | (((c2 >> g) & 1) << 1) | ((c3 >> g) & 1)) << (3 * g);
+  }
+  return 1;
+}
+
+/**************************************************************************/
+/*! 
+    Tells what a key may do to a group of blocks
+
+    Key B gets nothing where the trailer conditions make it readable:
+    it is data then and does not authenticate.
+
+    @param  access        As from mifareclassic_AccessDecode
+    @param  group         0..2, or MIFARE_ACCESS_TRAILER
+    @param  keyNumber     0 for key A, 1 for key B
+
+    @returns MIFARE_ACCESS_* operations allowed after authenticating
+             with that key
+*/
+/**************************************************************************/
+uint8_t mifareclassic_AccessOps (uint16_t access, uint8_t group, uint8_t keyNumber)
+{
+  // By C1 C2 C3, key A then key B. Read, write, increment, decrement.
+  static const uint8_t data_ops[8][2] =
+  {
+    {0x0F, 0x0F}, {0x09, 0x09}, {0x01, 0x01}, {0x00, 0x03},
+    {0x01, 0x03}, {0x00, 0x01}, {0x09, 0x0F}, {0x00, 0x00},
+  };
+  // Access bits readable, whole trailer writable.
+  static const uint8_t trailer_ops[8][2] =
+  {
+    {0x01, 0x00}, {0x03, 0x00}, {0x01, 0x00}, {0x01, 0x03},
+    {0x01, 0x01}, {0x01, 0x01}, {0x01, 0x01}, {0x01, 0x01},
+  };
+  uint8_t trailer = (access >> (3 * MIFARE_ACCESS_TRAILER)) & 0x07;
+  uint8_t cond    = (access >> (3 * group)) & 0x07;
+
+  keyNumber &= 1;
+  if ((keyNumber == 1) && (trailer <= 2))
+  {
+    return 0;
+  }
+  return (group == MIFARE_ACCESS_TRAILER) ? trailer_ops[cond][keyNumber] : data_ops[cond][keyNumber];
+}
+
+/**************************************************************************/
+/*! 
+    Tries to authenticate a block of memory on a MIFARE card using the
+    INDATAEXCHANGE command.  See section 7.3.8 of the PN532 User Manual
+    for more information on sending MIFARE and other commands.
+
+    @param  uid           Pointer to a uint8_t array containing the card UID
+    @param  uidLen        The length (in bytes) of the card's UID: 4, 7
+                          or 10. The last 4 bytes are sent, as NXP AN10927
+                          has it for the double and triple size UIDs
+    @param  blockNumber   The block number to authenticate.  (0..63 for
+                          1KB cards, and 0..255 for 4KB cards).
+    @param  keyNumber     Which key type to use during authentication
+                          (0 = MIFARE_CMD_AUTH_A, 1 = MIFARE_CMD_AUTH_B)
+    @param  keyData       Pointer to a uint8_t array containing the 6 uint8_t
+                          key value
+    
+    @returns 1 if everything executed properly, 0 for an error
+*/
+/**************************************************************************/
+uint8_t mifareclassic_AuthenticateBlock (uint8_t * uid, uint8_t uidLen, uint32_t blockNumber, uint8_t keyNumber, uint8_t * keyData)
+{
+  uint8_t len;
+  uint8_t i;
+  
+  // Hang on to the key and uid data
+	for(uint8_t i = 0; i < 6; i++)
+	{
+		 _key[i] =keyData[i];
+	}	
+	
+	if ((uidLen < PN532_MFC_UID_LEN) || (uidLen > PN532_UID_MAX_LEN))
+	{
+		return 0;
+	}
+	memcpy(_uid, uid, uidLen);
+  _uidLen = uidLen;  
+
+  
+  
+  // Prepare the authentication command //
+  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;   /* Data Exchange Header */
+  pn532_packetbuffer[1] = mp_reader->tg;                    /* Card number */
+  pn532_packetbuffer[2] = (keyNumber) ? MIFARE_CMD_AUTH_B : MIFARE_CMD_AUTH_A;
+  pn532_packetbuffer[3] = blockNumber;
+	
+  for(uint8_t i = 0; i < 6; i++)
+	{
+		 pn532_packetbuffer[4+i] =_key[i];
+	}		
+	/* Block Number (1K = 0..63, 4K = 0..255 */
+
+  for (i = 0; i < PN532_MFC_UID_LEN; i++)
+  {
+    pn532_packetbuffer[10+i] = _uid[_uidLen - PN532_MFC_UID_LEN + i];  /* 4 uint8_t card ID */
+  }
+
+  if (! sendCommandCheckAck(pn532_packetbuffer, 10+PN532_MFC_UID_LEN, 1000))
+    return 0;
+
+  // Read the response packet
+//	 printf("Read the response packet\r\n");
+  if (!wirereadresponse(pn532_packetbuffer, 12, PN532_RESP_TIMEOUT_CARD))
+    return 0;
+//  printf("Read ok\r\n");
+  // Check if the response is valid and we are authenticated???
+  // for an auth success it should be bytes 5-7: 0xD5 0x41 0x00
+  // Mifare auth error is technically uint8_t 7: 0x14 but anything other and 0x00 is not good
+	
+  if (pn532_packetbuffer[7] != 0x00)
+  {
+    
+    return 0;
+  }  
+  
+  return 1;
+}
+
+
+/**************************************************************************/
+/*! 
+    Tries to read an entire 16-uint8_t data block at the specified block
+    address.
+
+    @param  blockNumber   The block number to authenticate.  (0..63 for
+                          1KB cards, and 0..255 for 4KB cards).
+    @param  data          Pointer to the uint8_t array that will hold the
+                          retrieved data (if any)
+    
+    @returns 1 if everything executed properly, 0 for an error
+*/
+/**************************************************************************/
+uint8_t mifareclassic_ReadDataBlock (uint8_t blockNumber, uint8_t * data)
+{
+  
+  
+  /* Prepare the command */
+  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
+  pn532_packetbuffer[1] = mp_reader->tg;            /* Card number */
+  pn532_packetbuffer[2] = MIFARE_CMD_READ;        /* Mifare Read command = 0x30 */
+  pn532_packetbuffer[3] = blockNumber;            /* Block Number (0..63 for 1K, 0..255 for 4K) */
+
+  /* Send the command */
+  if (! sendCommandCheckAck(pn532_packetbuffer, 4, 1000))
+  {
+    
+    return 0;
+  }
+
+  /* Read the response packet */
+  if (!wirereadresponse(pn532_packetbuffer, 26, PN532_RESP_TIMEOUT_CARD))
+  {
+    return 0;
+  }
+
+  /* If uint8_t 8 isn't 0x00 we probably have an error */
+  if (pn532_packetbuffer[7] != 0x00)
+  {
+    
+    return 0;
+  }
+    
+  /* Copy the 16 data bytes to the output buffer        */
+  /* Block content starts at uint8_t 9 of a valid response */
+  memcpy (data, pn532_packetbuffer+8, 16);
+
+  /* Display data for debug if requested */
+  
+
+  return 1;  
+}
+
+
+/**************************************************************************/
+/*! 
+    Tries to write an entire 16-uint8_t data block at the specified block
+    address.
+
+    @param  blockNumber   The block number to authenticate.  (0..63 for
+                          1KB cards, and 0..255 for 4KB cards).
+    @param  data          The uint8_t array that contains the data to write.
+    
+    @returns 1 if everything executed properly, 0 for an error
+*/
+/**************************************************************************/
+uint8_t mifareclassic_WriteDataBlock (uint8_t blockNumber, uint8_t * data)
+{
+  
+  
+  /* Prepare the first command */
+  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
+  pn532_packetbuffer[1] = mp_reader->tg;            /* Card number */
+  pn532_packetbuffer[2] = MIFARE_CMD_WRITE;       /* Mifare Write command = 0xA0 */
+  pn532_packetbuffer[3] = blockNumber;            /* Block Number (0..63 for 1K, 0..255 for 4K) */
+  memcpy (pn532_packetbuffer+4, data, 16);          /* Data Payload */
+
+  /* Send the command */
+  if (! sendCommandCheckAck(pn532_packetbuffer, 20, 1000))
+  {
+    
+    return 0;
+  }  
+  
+  /* Read the response packet */
+  if (!wirereadresponse(pn532_packetbuffer, 26, PN532_RESP_TIMEOUT_CARD))
+  {
+    return 0;
+  }
+
+  /* Status byte: a NAK from the card (access bits, lost auth) is reported here */
+  return (pn532_packetbuffer[7] == 0x00);
+}
+
+/**************************************************************************/
+/*! 
+    Builds a value block: the value three times (once inverted) and the
+    backup address four times (twice inverted)
+
+    @param  value         Signed 32-bit value
+    @param  addr          Block address kept for the backup management
+                          of the application, usually the block itself
+    @param  block         Receives the 16 bytes to write
+*/
+/**************************************************************************/
+void mifareclassic_ValueBlockEncode (int32_t value, uint8_t addr, uint8_t * block)
+{
+  uint32_t v = (uint32_t)value;
+
+  UNUSED_RETURN_VALUE(uint32_encode(v, &block[0]));
+  UNUSED_RETURN_VALUE(uint32_encode(~v, &block[4]));
+  UNUSED_RETURN_VALUE(uint32_encode(v, &block[8]));
+  block[12] = addr;
+  block[13] = (uint8_t)~addr;
+  block[14] = addr;
+  block[15] = (uint8_t)~addr;
+}
+
+/**************************************************************************/
+/*! 
+    Checks the value block format and extracts the value
+
+    @param  block         16 bytes as read from the card
+    @param  value         Receives the value (may be NULL)
+    @param  addr          Receives the backup address (may be NULL)
+
+    @returns 1 if the block is a valid value block, 0 otherwise
+*/
+/**************************************************************************/
+uint8_t mifareclassic_ValueBlockDecode (uint8_t const * block, int32_t * value, uint8_t * addr)
+{
+  uint32_t v = uint32_decode(&block[0]);
+
+  if ((uint32_decode(&block[4]) != ~v) || (uint32_decode(&block[8]) != v) ||
+      (block[13] != (uint8_t)~block[12]) || (block[14] != block[12]) || (block[15] != block[13]))
+  {
+    return 0;
+  }
+  if (value != NULL)
+  {
+    *value = (int32_t)v;
+  }
+  if (addr != NULL)
+  {
+    *addr = block[12];
+  }
+  return 1;
+}
+
+/**************************************************************************/
+/*! 
+    Runs one InDataExchange with a Mifare command and checks its status
+
+    @param  cmd           Command bytes, starting with the Mifare command
+    @param  len           Number of command bytes (at most 6)
+*/
+/**************************************************************************/
+static uint8_t mifareclassic_exchange (uint8_t const * cmd, uint8_t len)
+{
+  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
+  pn532_packetbuffer[1] = mp_reader->tg;
+  memcpy(pn532_packetbuffer + 2, cmd, len);
+
+  if (! sendCommandCheckAck(pn532_packetbuffer, 2 + len, 1000))
+  {
+    return 0;
+  }
+  if (!wirereadresponse(pn532_packetbuffer, 12, PN532_RESP_TIMEOUT_CARD))
+  {
+    return 0;
+  }
+  return (pn532_packetbuffer[7] == 0x00);
+}
+
+/**************************************************************************/
+/*! 
+    Increments, decrements or restores a value block and transfers the
+    result, in the sector authenticated last
+
+    The card keeps the result in its transfer buffer until TRANSFER
+    writes it, so the two commands go out back to back with no read in
+    between. Compared to reading the block and writing it back, the
+    value travels in four bytes instead of sixteen each way and the card
+    checks the block format itself.
+
+    @param  cmd           MIFARE_CMD_INCREMENT, MIFARE_CMD_DECREMENT or
+                          MIFARE_CMD_STORE (restore, delta ignored)
+    @param  block         Value block to operate on
+    @param  delta         Amount to add or subtract
+    @param  dest          Block that receives the result, usually block
+                          itself or its backup in the same sector
+
+    @returns 1 if both commands succeeded, 0 for an error (nothing is
+             written when the first command fails)
+*/
+/**************************************************************************/
+uint8_t mifareclassic_ValueOp (uint8_t cmd, uint8_t block, uint32_t delta, uint8_t dest)
+{
+  uint8_t const transfer[2] = {MIFARE_CMD_TRANSFER, dest};
+  uint8_t       op[6];
+
+  if ((cmd != MIFARE_CMD_INCREMENT) && (cmd != MIFARE_CMD_DECREMENT) && (cmd != MIFARE_CMD_STORE))
+  {
+    return 0;
+  }
+  if (mifareclassic_IsTrailerBlock(block) || mifareclassic_IsTrailerBlock(dest))
+  {
+    return 0;
+  }
+
+  /* The PN532 runs both parts of the two-part Mifare command itself */
+  op[0] = cmd;
+  op[1] = block;
+  UNUSED_RETURN_VALUE(uint32_encode((cmd == MIFARE_CMD_STORE) ? 0 : delta, &op[2]));
+
+  if (!mifareclassic_exchange(op, sizeof(op)))
+  {
+    return 0;
+  }
+  return mifareclassic_exchange(transfer, sizeof(transfer));
+}
+
+/* After a failed exchange of a range: whether the card is active again for another try,
+   its sector no longer authenticated. */
+static bool range_recover(uint8_t * p_tries)
+{
+#if NRF_MODULE_ENABLED(PN532_RETRY)
+  return pn532_retry_recover(p_tries);
+#else
+  UNUSED_PARAMETER(p_tries);
+  return false;
+#endif
+}
+
+/* Authenticates the sector of the block if it is not, then reads the block, reselecting the
+   card and starting over on a transient error. */
+static bool range_read(uint8_t * uid, uint8_t uidLen, uint16_t block, mifareclassic_auth_handler_t auth,
+                       void * context, bool * p_authenticated, uint8_t * data)
+{
+  uint8_t tries = 0;
+
+  for (;;)
+  {
+    if (!*p_authenticated)
+    {
+      LAT_TRACE_START(t_auth);
+      *p_authenticated = auth(uid, uidLen, block, context);
+      if (*p_authenticated)
+      {
+        LAT_TRACE_STOP(LAT_STAGE_AUTH, t_auth);
+      }
+    }
+    if (*p_authenticated)
+    {
+      LAT_TRACE_START(t_read);
+      if (mifareclassic_ReadDataBlock(block, data))
+      {
+        LAT_TRACE_STOP(LAT_STAGE_READ, t_read);
+        return true;
+      }
+    }
+    // Any error leaves a Classic card idle, its authentication lost.
+    *p_authenticated = false;
+    if (!range_recover(&tries))
+    {
+      return false;
+    }
+  }
+}
+
+/* Writes a block of the authenticated sector. Only a failed write is repeated after a
+   reselect, with the same data; the read back of mifareclassic_verify_sector checks it. */
+static bool range_write(uint8_t * uid, uint8_t uidLen, uint16_t block, mifareclassic_auth_handler_t auth,
+                        void * context, bool * p_authenticated, uint8_t const * data)
+{
+  uint8_t tries = 0;
+
+  for (;;)
+  {
+    if (*p_authenticated && mifareclassic_WriteDataBlock(block, (uint8_t *)data))
+    {
+      return true;
+    }
+    *p_authenticated = false;
+    if (!range_recover(&tries))
+    {
+      return false;
+    }
+    *p_authenticated = auth(uid, uidLen, block, context);
+  }
+}
+
+/**************************************************************************/
+/*! 
+    Reads a range of data blocks, authenticating once per sector
+
+    Sector trailers are skipped. The handler is called for every block
+    read and may issue further commands to blocks of the same sector
+    (for example mifareclassic_WriteDataBlock) while the sector is
+    still authenticated.
+
+    @param  uid           UID of the card
+    @param  uidLen        UID length (4 or 7)
+    @param  firstBlock    First block of the range
+    @param  lastBlock     Last block of the range (inclusive)
+    @param  auth          Authenticates the first block read in each
+                          sector, for example by trying several keys
+    @param  handler       Called with each block (may be NULL)
+    @param  context       Passed to auth and handler
+
+    @returns Number of data blocks read. Stops at the first failed
+             authentication or read that a reselect of the card (see
+             pn532_retry_recover) does not get through, the card is
+             halted after that.
+*/
+/**************************************************************************/
+uint8_t mifareclassic_ReadRange (uint8_t * uid, uint8_t uidLen, uint8_t firstBlock, uint8_t lastBlock,
+                                 mifareclassic_auth_handler_t auth,
+                                 mifareclassic_block_handler_t handler, void * context)
+{
+  uint8_t  data[16];
+  uint8_t  count = 0;
+  bool     authenticated = false;
+
+  for (uint16_t block = firstBlock; block <= lastBlock; block++)
+  {
+    if (mifareclassic_IsFirstBlock(block))
+    {
+      authenticated = false;
+    }
+    if (mifareclassic_IsTrailerBlock(block))
+    {
+      continue;
+    }
+    if (!range_read(uid, uidLen, block, auth, context, &authenticated, data))
+    {
+      break;
+    }
+    count++;
+    if (handler != NULL)
+    {
+      handler((uint8_t)block, data, context);
+    }
+  }
+
+  return count;
+}
+
+/**************************************************************************/
+/*! 
+    Reads back the blocks written in one sector and compares them
+
+    @param  base          First block of the sector
+    @param  written       Bit n set: block base + n was written
+    @param  source        Gives the expected contents
+
+    @returns Number of blocks that match, or 0xFF if one does not
+*/
+/**************************************************************************/
+static uint8_t mifareclassic_verify_sector (uint8_t base, uint16_t written,
+                                            mifareclassic_write_source_t source, void * context)
+{
+  uint8_t data[16];
+  uint8_t count = 0;
+
+  for (uint8_t n = 0; written != 0; n++, written >>= 1)
+  {
+    if ((written & 1) == 0)
+    {
+      continue;
+    }
+    if (!mifareclassic_ReadDataBlock(base + n, data) ||
+        (memcmp(data, source(base + n, context), 16) != 0))
+    {
+      return 0xFF;
+    }
+    count++;
+  }
+  return count;
+}
+
+/**************************************************************************/
+/*! 
+    Writes a range of data blocks, only where the contents change, and
+    verifies what was written
+
+    Each sector is authenticated once. Every block is read first and
+    handed to the handler (the old contents); blocks already holding
+    the new data are not written. The blocks that were written are read
+    back at the end of their sector, still under the same
+    authentication, before the next sector is authenticated.
+
+    @param  uid           UID of the card
+    @param  uidLen        UID length (4 or 7)
+    @param  firstBlock    First block of the range
+    @param  lastBlock     Last block of the range (inclusive)
+    @param  auth          Authenticates the first block in each sector
+    @param  source        Gives the 16 bytes for a block, NULL to leave
+                          it alone; called again for the verification
+    @param  handler       Called with the old contents of each block
+                          (may be NULL)
+    @param  context       Passed to auth, source and handler
+
+    @returns Number of data blocks that hold the new data, unchanged or
+             written and verified. Stops at the first failed
+             authentication, read, write or verification; transient
+             errors are retried after a reselect as in
+             mifareclassic_ReadRange.
+*/
+/**************************************************************************/
+uint8_t mifareclassic_WriteRange (uint8_t * uid, uint8_t uidLen, uint8_t firstBlock, uint8_t lastBlock,
+                                  mifareclassic_auth_handler_t auth,
+                                  mifareclassic_write_source_t source,
+                                  mifareclassic_block_handler_t handler, void * context)
+{
+  uint8_t         data[16];
+  uint8_t         count         = 0;
+  uint8_t         base          = firstBlock;
+  uint16_t        written       = 0;
+  bool            authenticated = false;
+  bool            failed        = false;
+  uint8_t const * p_new;
+
+  for (uint16_t block = firstBlock; (block <= lastBlock) && !failed; block++)
+  {
+    if (mifareclassic_IsFirstBlock(block))
+    {
+      if (written != 0)
+      {
+        uint8_t verified = mifareclassic_verify_sector(base, written, source, context);
+
+        if (verified == 0xFF)
+        {
+          return count;
+        }
+        count  += verified;
+        written = 0;
+      }
+      base          = (uint8_t)block;
+      authenticated = false;
+    }
+    if (mifareclassic_IsTrailerBlock(block))
+    {
+      continue;
+    }
+    if (!range_read(uid, uidLen, block, auth, context, &authenticated, data))
+    {
+      break;
+    }
+    if (handler != NULL)
+    {
+      handler((uint8_t)block, data, context);
+    }
+
+    p_new = source((uint8_t)block, context);
+    if ((p_new == NULL) || (memcmp(data, p_new, 16) == 0))
+    {
+      count += (p_new != NULL);
+      continue;
+    }
+
+    LAT_TRACE_START(t_write);
+    if (!range_write(uid, uidLen, block, auth, context, &authenticated, p_new))
+    {
+      failed = true;
+    }
+    LAT_TRACE_STOP(LAT_STAGE_WRITE, t_write);
+    written |= (1 << (block - base));
+  }
+
+  if ((written != 0) && !failed)
+  {
+    uint8_t verified = mifareclassic_verify_sector(base, written, source, context);
+
+    if (verified != 0xFF)
+    {
+      count += verified;
+    }
+  }
+  return count;
+}
+
+
+/**************************************************************************/
+/*! 
+    Formats a Mifare Classic card to store NDEF Records 
+    
+    @returns 1 if everything executed properly, 0 for an error
+*/
+/**************************************************************************/
+uint8_t mifareclassic_FormatNDEF (void)
+{
+  uint8_t sectorbuffer1[16] = {0x14, 0x01, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1};
+  uint8_t sectorbuffer2[16] = {0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1};
+  uint8_t sectorbuffer3[16] = {0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0x78, 0x77, 0x88, 0xC1, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+  // Note 0xA0 0xA1 0xA2 0xA3 0xA4 0xA5 must be used for key A
+  // for the MAD sector in NDEF records (sector 0)
+  
+  // Write block 1 and 2 to the card
+  if (!(mifareclassic_WriteDataBlock (1, sectorbuffer1)))
+    return 0;
+  if (!(mifareclassic_WriteDataBlock (2, sectorbuffer2)))
+    return 0;
+  // Write key A and access rights card
+  if (!(mifareclassic_WriteDataBlock (3, sectorbuffer3)))
+    return 0;
+
+  // Seems that everything was OK (?!)
+  return 1;
+}
+
+
+/**************************************************************************/
+uint8_t mifareclassic_WriteNDEFURI (uint8_t sectorNumber, uint8_t uriIdentifier, const char * url)
+{
+  // Figure out how long the string is
+  uint8_t len = strlen(url);
+  
+  // Make sure we're within a 1K limit for the sector number
+  if ((sectorNumber < 1) || (sectorNumber > 15))
+    return 0;
+  
+  // Make sure the URI payload is between 1 and 38 chars
+  if ((len < 1) || (len > 38))
+    return 0;
+    
+  // Note 0xD3 0xF7 0xD3 0xF7 0xD3 0xF7 must be used for key A
+  // in NDEF records
+	
+  // Setup the sector buffer (w/pre-formatted TLV wrapper and NDEF message)
+  uint8_t sectorbuffer1[16] = {0x00, 0x00, 0x03, len+5, 0xD1, 0x01, len+1, 0x55, uriIdentifier, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+  uint8_t sectorbuffer2[16] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+  uint8_t sectorbuffer3[16] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+  uint8_t sectorbuffer4[16] = {0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7, 0x7F, 0x07, 0x88, 0x40, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  if (len <= 6)
+  {
+    // Unlikely we'll get a url this short, but why not ...
+    memcpy (sectorbuffer1+9, url, len);
+    sectorbuffer1[len+9] = 0xFE;
+  }
+  else if (len == 7)
+  {
+    // 0xFE needs to be wrapped around to next block
+    memcpy (sectorbuffer1+9, url, len);
+    sectorbuffer2[0] = 0xFE;
+  }
+  else if ((len > 7) && (len <= 22))
+  {
+    // Url fits in two blocks
+    memcpy (sectorbuffer1+9, url, 7);
+    memcpy (sectorbuffer2, url+7, len-7);
+    sectorbuffer2[len-7] = 0xFE;
+  }
+  else if (len == 23)
+  {
+    // 0xFE needs to be wrapped around to final block
+    memcpy (sectorbuffer1+9, url, 7);
+    memcpy (sectorbuffer2, url+7, len-7);
+    sectorbuffer3[0] = 0xFE;
+  }
+  else
+  {
+    // Url fits in three blocks
+    memcpy (sectorbuffer1+9, url, 7);
+    memcpy (sectorbuffer2, url+7, 16);
+    memcpy (sectorbuffer3, url+23, len-24);
+    sectorbuffer3[len-22] = 0xFE;
+  }
+  
+  // Now write all three blocks back to the card
+  if (!(mifareclassic_WriteDataBlock (sectorNumber*4, sectorbuffer1)))
+    return 0;
+  if (!(mifareclassic_WriteDataBlock ((sectorNumber*4)+1, sectorbuffer2)))
+    return 0;
+  if (!(mifareclassic_WriteDataBlock ((sectorNumber*4)+2, sectorbuffer3)))
+    return 0;
+  if (!(mifareclassic_WriteDataBlock ((sectorNumber*4)+3, sectorbuffer4)))
+    return 0;
+
+  // Seems that everything was OK (?!)
+  return 1;
+}
+
+
+
+/***** Mifare Ultralight Functions ******/
+
+/**************************************************************************/
+/*! 
+    Tries to read an entire 4-uint8_t page at the specified address.
+
+    @param  page        The page number (0..63 on Ultralight, up to 230
+                        on NTAG216)
+    @param  buffer      Pointer to the uint8_t array that will hold the
+                        retrieved data (if any)
+*/
+/**************************************************************************/
+uint8_t mifareultralight_ReadPage (uint8_t page, uint8_t * buffer)
+{
+  uint8_t group[16];
+
+  if (!mifareultralight_ReadPages(page, group))
+  {
+    return 0;
+  }
+  memcpy(buffer, group, 4);
+  return 1;
+}
+
+
+/**************************************************************************/
+/*! 
+    Reads the four pages starting at the specified address with one
+    READ command, which always returns 16 bytes.
+
+    Reading past the last page wraps around to page 0 on the tag.
+
+    @param  page        The first page number
+    @param  buffer      Pointer to a 16 uint8_t array that will hold the
+                        retrieved data (if any)
+
+    @returns 1 if everything executed properly, 0 for an error
+*/
+/**************************************************************************/
+uint8_t mifareultralight_ReadPages (uint8_t page, uint8_t * buffer)
+{
+  /* Prepare the command */
+  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
+  pn532_packetbuffer[1] = mp_reader->tg;         /* Card number */
+  pn532_packetbuffer[2] = MIFARE_CMD_READ;     /* Mifare Read command = 0x30 */
+  pn532_packetbuffer[3] = page;                /* Page Number (0..63 in most cases) */
+
+  /* Send the command */
+  if (! sendCommandCheckAck(pn532_packetbuffer, 4, 1000))
+  {
+    return 0;
+  }
+  
+  /* Read the response packet */
+  if (!wirereadresponse(pn532_packetbuffer, 26, PN532_RESP_TIMEOUT_CARD))
+  {
+    return 0;
+  }
+  
+
+  /* If uint8_t 8 isn't 0x00 we probably have an error */
+  if (pn532_packetbuffer[7] == 0x00)
+  {
+    /* Block content starts at uint8_t 9 of a valid response */
+    memcpy (buffer, pn532_packetbuffer+8, 16);
+  }
+  else
+  {
+    
+    return 0;
+  }
+
+  /* Display data for debug if requested */
+
+  // Return OK signal
+  return 1;
+}
+
+
+/**************************************************************************/
+/*! 
+    Writes one 4-uint8_t page with the Type 2 WRITE command (Ultralight
+    and NTAG2xx). Pages 2 and 3 hold the static lock bytes and the
+    capability container, whose bits can only be set.
+
+    @param  page        The page number
+    @param  data        The 4 bytes to write
+
+    @returns 1 if the tag acknowledged the write, 0 for an error
+*/
+/**************************************************************************/
+uint8_t ntag2xx_WritePage (uint8_t page, uint8_t const * data)
+{
+  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
+  pn532_packetbuffer[1] = mp_reader->tg;                  /* Card number */
+  pn532_packetbuffer[2] = MIFARE_ULTRALIGHT_CMD_WRITE;  /* Write command = 0xA2 */
+  pn532_packetbuffer[3] = page;
+  memcpy(pn532_packetbuffer+4, data, 4);
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, 8, 1000))
+  {
+    return 0;
+  }
+  if (!wirereadresponse(pn532_packetbuffer, 26, PN532_RESP_TIMEOUT_CARD))
+  {
+    return 0;
+  }
+
+  /* The 4-bit ACK of the tag is reported as status 0x00, a NAK as an error */
+  return (pn532_packetbuffer[7] == 0x00);
+}
+
+
+/**************************************************************************/
+/*! 
+    Reads a range of pages from an NTAG21x with FAST_READ, as many pages
+    per exchange as fit in the packet buffer (NTAG2XX_FAST_READ_MAX_PAGES).
+
+    FAST_READ is sent with InCommunicateThru. Ultralight and other tags
+    without FAST_READ answer with a NAK and drop back to IDLE, so read
+    those with mifareultralight_ReadPages after selecting them again.
+
+    @param  startPage   First page to read
+    @param  endPage     Last page to read (inclusive)
+    @param  buffer      Receives (endPage - startPage + 1) * 4 bytes
+
+    @returns Number of bytes written to buffer, 0 for an error
+*/
+/**************************************************************************/
+uint16_t ntag2xx_FastRead (uint8_t startPage, uint8_t endPage, uint8_t * buffer)
+{
+  uint16_t total = 0;
+  uint16_t page  = startPage;
+
+  if (endPage < startPage)
+  {
+    return 0;
+  }
+
+  while (page <= endPage)
+  {
+    uint16_t last = page + NTAG2XX_FAST_READ_MAX_PAGES - 1;
+    uint16_t len;
+    pn532_frame_view_t view;
+
+    if (last > endPage)
+    {
+      last = endPage;
+    }
+    len = (last - page + 1) * 4;
+
+    pn532_packetbuffer[0] = PN532_COMMAND_INCOMMUNICATETHRU;
+    pn532_packetbuffer[1] = NTAG2XX_CMD_FAST_READ;
+    pn532_packetbuffer[2] = (uint8_t)page;
+    pn532_packetbuffer[3] = (uint8_t)last;
+
+    if (!sendCommandCheckAck(pn532_packetbuffer, 4, 1000))
+    {
+      return 0;
+    }
+    if (!wirereadframe(&view, len + PN532_FRAME_OVERHEAD + 2, PN532_RESP_TIMEOUT_CARD))
+    {
+      return 0;
+    }
+
+    /* view: response code, status, data (a 4-bit NAK is shorter) */
+    if ((view.len != len + 2) || (view.p_data[0] != PN532_RESPONSE_INCOMMUNICATETHRU) ||
+        ((view.p_data[1] & 0x3f) != 0))
+    {
+      return 0;
+    }
+
+    memcpy(&buffer[total], &view.p_data[2], len);
+    total += len;
+    page   = last + 1;
+  }
+
+  return total;
+}
+
+
+/**************************************************************************/
+/*! 
+    Runs an NTAG21x command through InCommunicateThru and takes an
+    answer of exactly len bytes
+
+    @returns 1 if the tag answered so, 0 for a NAK or an error
+*/
+/**************************************************************************/
+static uint8_t ntag2xx_exchange (uint8_t const * cmd, uint8_t cmdLen, uint8_t * answer, uint8_t len)
+{
+  pn532_frame_view_t view;
+
+  pn532_packetbuffer[0] = PN532_COMMAND_INCOMMUNICATETHRU;
+  memcpy(&pn532_packetbuffer[1], cmd, cmdLen);
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, cmdLen + 1, 1000))
+  {
+    return 0;
+  }
+  if (!wirereadframe(&view, len + PN532_FRAME_OVERHEAD + 2, PN532_RESP_TIMEOUT_CARD))
+  {
+    return 0;
+  }
+
+  /* view: response code, status, answer; a NAK is 4 bits, never len bytes */
+  if ((view.len != len + 2) || (view.p_data[0] != PN532_RESPONSE_INCOMMUNICATETHRU) ||
+      ((view.p_data[1] & 0x3f) != 0))
+  {
+    return 0;
+  }
+
+  memcpy(answer, &view.p_data[2], len);
+  return 1;
+}
+
+
+/**************************************************************************/
+/*! 
+    Reads the version of an NTAG21x or Ultralight EV1 with GET_VERSION:
+    fixed header, vendor, product type and subtype, major and minor
+    version, storage size and protocol type.
+
+    Tags without GET_VERSION (Ultralight, Ultralight C) answer with a
+    NAK and drop back to IDLE, they have to be selected again.
+
+    @param  version     Receives NTAG2XX_VERSION_LEN bytes
+
+    @returns 1 if the tag answered, 0 for a NAK or an error
+*/
+/**************************************************************************/
+uint8_t ntag2xx_GetVersion (uint8_t * version)
+{
+  uint8_t const cmd[] = {NTAG2XX_CMD_GET_VERSION};
+
+  return ntag2xx_exchange(cmd, sizeof(cmd), version, NTAG2XX_VERSION_LEN);
+}
+
+
+/**************************************************************************/
+/*! 
+    Reads the originality signature of an NTAG21x with READ_SIG: NXP's
+    ECDSA signature of the UID on secp128r1, written at production
+
+    @param  signature   Receives NTAG2XX_SIG_LEN bytes, r then s, both
+                        big-endian
+
+    @returns 1 if the tag answered, 0 for a NAK or an error
+*/
+/**************************************************************************/
+uint8_t ntag2xx_ReadSig (uint8_t * signature)
+{
+  uint8_t const cmd[] = {NTAG2XX_CMD_READ_SIG, 0x00};
+
+  return ntag2xx_exchange(cmd, sizeof(cmd), signature, NTAG2XX_SIG_LEN);
+}
+
+
+/**************************************************************************/
+/*! 
+    Authenticates to an NTAG21x with PWD_AUTH, which opens the pages
+    behind AUTH0 until the tag is deselected
+
+    A wrong password gets a NAK and leaves the tag HALTed; it has to be
+    selected again. With AUTHLIM set, the tag counts the failures.
+
+    @param  pwd         NTAG2XX_PWD_LEN bytes
+    @param  pack        Receives the NTAG2XX_PACK_LEN bytes of the answer,
+                        to be checked against the PACK the tag was
+                        given
+
+    @returns 1 if the tag accepted the password, 0 otherwise
+*/
+/**************************************************************************/
+uint8_t ntag2xx_PwdAuth (uint8_t const * pwd, uint8_t * pack)
+{
+  uint8_t cmd[1 + NTAG2XX_PWD_LEN];
+
+  cmd[0] = NTAG2XX_CMD_PWD_AUTH;
+  memcpy(&cmd[1], pwd, NTAG2XX_PWD_LEN);
+
+  return ntag2xx_exchange(cmd, sizeof(cmd), pack, NTAG2XX_PACK_LEN);
+}
+
+
+uint8_t readackframe(void) 
+{
+  // The command has been sent, the packet buffer is free for the ACK.
+  wirereaddata(pn532_packetbuffer, 6);
+	
+    
+  return (0 == memcmp(pn532_packetbuffer, pn532ack, 6));
+}
+
+
+/**************************************************************************/
+/*! 
+    @brief  Checks the IRQ pin to know if the PN532 is ready
+	
+	@returns 0 if the PN532 is busy, 1 if it is free
+*/
+/**************************************************************************/
+uint8_t wirereadstatus(void) 
+{
+#if NRF_MODULE_ENABLED(PN532_SIM)
+  if (pn532_sim_is_active())
+  {
+    return pn532_sim_ready() ? PN532_I2C_READY : PN532_I2C_BUSY;
+  }
+#endif
+  uint8_t x = nrf_gpio_pin_read(mp_reader->bus.irq_pin);    
+//  printf("read irq---> %d\r\n",x);
+
+  if (x == 1)
+    return PN532_I2C_BUSY;
+  else
+    return PN532_I2C_READY;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Reads n bytes of data from the PN532 via I2C
+
+    Reads into pn532_packetbuffer are done in place (the leading I2C
+    status byte goes to the headroom byte in front of it); other
+    buffers get one copy out of pn532_packetbuffer.
+
+    @param  buff      Pointer to the buffer where data will be written
+    @param  n         Number of bytes to be read
+*/
+/**************************************************************************/
+void wirereaddata(uint8_t* buff, uint16_t n) 
+{
+
+		 uint8_t address =PN532_I2C_ADDRESS;
+
+		 if (n > PN532_PACKBUFFSIZ)
+		 {
+				 n = PN532_PACKBUFFSIZ;
+		 }
+		 if (n > PN532_TWI_MAX_READ)
+		 {
+				 n = PN532_TWI_MAX_READ;
+		 }
+		 UNUSED_RETURN_VALUE(i2c_device_read_buffer(address,pn532_packetbuffer - 1,n+1));
+		 if (buff != pn532_packetbuffer)
+		 {
+				 memcpy(buff, pn532_packetbuffer, n);
+		 }
+}
+
+#if (PN532_TRANSPORT == PN532_TRANSPORT_HSU) && !NRF_MODULE_ENABLED(PN532_SIM)
+/* HSU reads end with the frame whatever length is asked for, so they are not sized. */
+#define FRAME_READ_SIZED 0
+#else
+#define FRAME_READ_SIZED 1
+#endif
+
+/* First read of a response whose length the caller does not know, without a size from
+   before: the header and a status byte or two. */
+#define FRAME_READ_FIRST    (PN532_FRAME_OVERHEAD + 2)
+#define RESP_SIZES          8
+
+/* Frame sizes of earlier responses, by command: the first read takes as many bytes as last
+   time rather than the guess of the caller, and only a longer frame costs a second one. */
+typedef struct
+{
+  uint16_t key;     // command code, then the parameter the length depends on
+  uint16_t size;    // frame bytes up to the DCS, 0 for a free entry
+} resp_size_t;
+
+static uint8_t const m_nack[] = {0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00};
+static resp_size_t   m_resp_sizes[RESP_SIZES];
+static uint8_t       m_resp_next;
+
+/* The response to InListPassiveTarget depends on the baud rate, the one to InDataExchange on
+   the card command. */
+static void resp_key_set(uint8_t const* cmd, uint16_t cmdlen)
+{
+  uint8_t sub = 0;
+
+  if ((cmdlen > 2) &&
+      ((cmd[0] == PN532_COMMAND_INLISTPASSIVETARGET) || (cmd[0] == PN532_COMMAND_INDATAEXCHANGE)))
+  {
+    sub = cmd[2];
+  }
+  m_resp_key = ((uint16_t)cmd[0] << 8) | sub;
+}
+
+static uint16_t resp_size_get(uint16_t guess)
+{
+  for (uint8_t i = 0; i < RESP_SIZES; i++)
+  {
+    if ((m_resp_sizes[i].size != 0) && (m_resp_sizes[i].key == m_resp_key))
+    {
+      return m_resp_sizes[i].size;
+    }
+  }
+  return guess;
+}
+
+static void resp_size_put(uint16_t size)
+{
+  resp_size_t* entry = NULL;
+
+  for (uint8_t i = 0; (entry == NULL) && (i < RESP_SIZES); i++)
+  {
+    if ((m_resp_sizes[i].size != 0) && (m_resp_sizes[i].key == m_resp_key))
+    {
+      entry = &m_resp_sizes[i];
+    }
+  }
+  if (entry == NULL)
+  {
+    entry        = &m_resp_sizes[m_resp_next];
+    m_resp_next  = (m_resp_next + 1) % RESP_SIZES;
+  }
+  entry->key  = m_resp_key;
+  entry->size = size;
+}
+
+/* Frame bytes up to the DCS from the header in raw, 0 if raw does not hold a valid header. */
+static uint16_t frame_size_get(uint8_t const* raw, uint16_t raw_len)
+{
+  if ((raw_len < HEADER_SEQUENCE_LENGTH - 1) ||
+      (raw[0] != PN532_PREAMBLE) || (raw[1] != PN532_STARTCODE1) || (raw[2] != PN532_STARTCODE2))
+  {
+    return 0;
+  }
+  if ((raw[3] == 0xFF) && (raw[4] == 0xFF))
+  {
+    if ((raw_len < EXT_HEADER_SEQUENCE_LENGTH - 1) || ((uint8_t)(raw[5] + raw[6] + raw[7]) != 0))
+    {
+      return 0;
+    }
+    return (EXT_HEADER_SEQUENCE_LENGTH - 1) + (((uint16_t)raw[5] << 8) | raw[6]) + 1;
+  }
+  if ((uint8_t)(raw[3] + raw[4]) != 0)
+  {
+    return 0;
+  }
+  return (HEADER_SEQUENCE_LENGTH - 1) + raw[3] + 1;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Reads a response frame that is ready, moving only its bytes
+
+    The first read takes first bytes. When the header in them shows a
+    longer frame, a NACK has the PN532 send the frame again from the
+    start and exactly all of it is read, up to max bytes; a frame that
+    fits buf is never cut short. The size is kept for the next response
+    to the same command.
+
+    @param  buf       Receive buffer: the status byte, then the frame
+    @param  first     Frame bytes of the first read
+    @param  max       Frame bytes that fit buf
+    @param  timeout   Deadline in ms for the frame sent again
+
+    @returns  Frame bytes in buf, 0 on a bus error or timeout
+*/
+/**************************************************************************/
+static uint16_t frame_read_sized(uint8_t* buf, uint16_t first, uint16_t max, uint16_t timeout)
+{
+  uint16_t size;
+
+  max = MIN(max, PN532_TWI_MAX_READ);
+#if FRAME_READ_SIZED
+  first = MIN(first, max);
+#else
+  first = max;
+#endif
+  if (pn532_bus_read(buf, (uint8_t)(first + 1)) != NRF_SUCCESS)
+  {
+    return 0;
+  }
+
+  size = frame_size_get(&buf[1], first);
+  if (size > first)
+  {
+    if (size > max)
+    {
+      // Longer than buf: the caller gets what fits and the decoder reports it short.
+      return first;
+    }
+    if ((pn532_bus_write(m_nack, sizeof(m_nack)) != NRF_SUCCESS) ||
+        !waitUntilReady(timeout) ||
+        (pn532_bus_read(buf, (uint8_t)(size + 1)) != NRF_SUCCESS))
+    {
+      return 0;
+    }
+    first = size;
+  }
+  if (size != 0)
+  {
+    resp_size_put(size);
+  }
+  return first;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Validates a PN532-to-host information frame and returns a
+            view of its payload without copying it
+
+    Handles normal and extended (LEN = 0xFF 0xFF, 16-bit length)
+    information frames. Checks the start code, LCS and TFI. The DCS is
+    checked when the whole frame is inside raw_len; a shorter read
+    yields the payload bytes that were read.
+
+    @param  raw       Frame as read from the chip (after the status byte)
+    @param  raw_len   Number of bytes in raw
+    @param  view      Set to the payload (response code first) and its length
+
+    @returns  NRF_SUCCESS, or NRF_ERROR_INVALID_DATA for a malformed frame
+*/
+/**************************************************************************/
+ret_code_t pn532_frame_decode(uint8_t const* raw, uint16_t raw_len, pn532_frame_view_t* view)
+{
+  uint16_t len;
+  uint16_t hdr;
+  uint8_t  sum;
+
+  if ((raw_len < HEADER_SEQUENCE_LENGTH) ||
+      (raw[0] != PN532_PREAMBLE) || (raw[1] != PN532_STARTCODE1) || (raw[2] != PN532_STARTCODE2))
+  {
+    return NRF_ERROR_INVALID_DATA;
+  }
+
+  if ((raw[3] == 0xFF) && (raw[4] == 0xFF))
+  {
+    // Extended frame: 00 00 FF FF FF LENM LENL LCS TFI ...
+    if (raw_len < EXT_HEADER_SEQUENCE_LENGTH)
+    {
+      return NRF_ERROR_INVALID_DATA;
+    }
+    len = ((uint16_t)raw[5] << 8) | raw[6];
+    if ((uint8_t)(raw[5] + raw[6] + raw[7]) != 0)
+    {
+      return NRF_ERROR_INVALID_DATA;
+    }
+    hdr = EXT_HEADER_SEQUENCE_LENGTH;
+  }
+  else
+  {
+    len = raw[3];
+    if ((uint8_t)(raw[3] + raw[4]) != 0)
+    {
+      return NRF_ERROR_INVALID_DATA;
+    }
+    hdr = HEADER_SEQUENCE_LENGTH;
+  }
+
+  if ((len == 0) || (raw[hdr - 1] != PN532_PN532TOHOST))
+  {
+    return NRF_ERROR_INVALID_DATA;
+  }
+
+  view->p_data = &raw[hdr];
+
+  if ((uint32_t)hdr + len > raw_len)
+  {
+    // Truncated read, DCS not available.
+    view->len = raw_len - hdr;
+    return NRF_SUCCESS;
+  }
+
+  // TFI + data + DCS sums to zero.
+  sum = 0;
+  for (uint16_t i = 0; i <= len; i++)
+  {
+    sum += raw[hdr - 1 + i];
+  }
+  if (sum != 0)
+  {
+    return NRF_ERROR_INVALID_DATA;
+  }
+
+  view->len = len - 1;
+  return NRF_SUCCESS;
+}
+
+#if NRF_MODULE_ENABLED(PN532_DEADLINE)
+static uint16_t m_wait_key;
+static uint32_t m_wait_us;        // of the wait that ended last, not counted yet
+static bool     m_wait_pending;
+#endif
+
+/* waitUntilReady with the deadline learned for the key. A response that
+   misses it is aborted with an ACK frame, so the chip hears the next
+   command; the ACK wait has nothing to abort. */
+static boolean deadline_wait(uint16_t key, uint16_t timeout, bool abort)
+{
+#if NRF_MODULE_ENABLED(PN532_DEADLINE)
+  uint16_t deadline;
+  uint32_t start;
+
+  m_wait_pending = false;
+  if (!pn532_deadline_learns(key, timeout))
+  {
+    return waitUntilReady(timeout);
+  }
+  deadline = pn532_deadline_get(key, timeout);
+  start    = pn532_deadline_now();
+  if (waitUntilReady(deadline))
+  {
+    m_wait_key     = key;
+    m_wait_us      = pn532_deadline_us_since(start);
+    m_wait_pending = true;
+    return true;
+  }
+  if (deadline < timeout)
+  {
+    pn532_deadline_miss(key);
+    if (abort)
+    {
+      UNUSED_RETURN_VALUE(pn532_bus_write(pn532ack, sizeof(pn532ack)));
+    }
+  }
+  return false;
+#else
+  UNUSED_PARAMETER(key);
+  UNUSED_PARAMETER(abort);
+  return waitUntilReady(timeout);
+#endif
+}
+
+/* The last wait ended with what was asked for: it counts for the deadline. */
+static void deadline_count(bool ok)
+{
+#if NRF_MODULE_ENABLED(PN532_DEADLINE)
+  if (m_wait_pending && ok)
+  {
+    pn532_deadline_put(m_wait_key, m_wait_us);
+  }
+  m_wait_pending = false;
+#else
+  UNUSED_PARAMETER(ok);
+#endif
+}
+
+/* Error of an exchange with the card, 0 if it answered: the PN532 reports its own RF
+   timeout or error in the status byte. Other responses have no status here. */
+static uint8_t resp_status(pn532_frame_view_t const* view)
+{
+  if ((view->len >= 2) &&
+      ((view->p_data[0] == PN532_RESPONSE_INDATAEXCHANGE) ||
+       (view->p_data[0] == PN532_RESPONSE_INCOMMUNICATETHRU)))
+  {
+    return view->p_data[1] & PN532_STATUS_ERROR_MASK;
+  }
+  return 0;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Status of the last command: the error the card exchange
+            reported, 0 for success or a response without a status
+
+    @returns The status byte without the MI and NAD bits, or
+             PN532_STATUS_NO_FRAME if no valid response was read
+*/
+/**************************************************************************/
+uint8_t pn532_exchange_status(void)
+{
+  return m_exchange_status;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Waits for the response, reads it into pn532_packetbuffer and
+            returns a validated view of its payload
+
+    @param  view      Set to the payload (response code first)
+    @param  n         Frame bytes expected until the command has been
+                      answered once, PN532_PACKBUFFSIZ if not known; a
+                      longer frame is read whole all the same
+    @param  timeout   Deadline in ms for the response to become ready
+
+    @returns  false on timeout or if the frame is malformed
+*/
+/**************************************************************************/
+boolean wirereadframe(pn532_frame_view_t* view, uint16_t n, uint16_t timeout)
+{
+  uint16_t len;
+  boolean  ok;
+
+  if (!deadline_wait(m_resp_key, timeout, true))
+  {
+    return false;
+  }
+  len = frame_read_sized(pn532_packetbuffer - 1,
+                         resp_size_get((n < PN532_PACKBUFFSIZ) ? n : FRAME_READ_FIRST),
+                         PN532_PACKBUFFSIZ, timeout);
+  ok = (len != 0) && (pn532_frame_decode(pn532_packetbuffer, len, view) == NRF_SUCCESS);
+  m_exchange_status = ok ? resp_status(view) : PN532_STATUS_NO_FRAME;
+  deadline_count(m_exchange_status == 0);
+  return ok;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Waits for the response and reads it straight into a caller
+            buffer, bypassing pn532_packetbuffer
+
+    @param  buf       Receive buffer; buf[0] gets the I2C status byte and
+                      the frame follows from buf[1]
+    @param  buf_len   Size of buf, at most PN532_TWI_MAX_READ + 1
+    @param  view      Set to the payload (response code first) inside buf
+    @param  timeout   Deadline in ms for the response to become ready
+
+    @returns  false on timeout, bus error or if the frame is malformed
+*/
+/**************************************************************************/
+boolean pn532_frame_read(uint8_t* buf, uint16_t buf_len, pn532_frame_view_t* view, uint16_t timeout)
+{
+  uint16_t len;
+  boolean  ok;
+
+  if ((buf_len < 2) || (buf_len > PN532_TWI_MAX_READ + 1))
+  {
+    return false;
+  }
+  if (!deadline_wait(m_resp_key, timeout, true))
+  {
+    return false;
+  }
+
+  len = frame_read_sized(buf, resp_size_get(FRAME_READ_FIRST), buf_len - 1, timeout);
+  ok  = (len != 0) && (pn532_frame_decode(&buf[1], len, view) == NRF_SUCCESS);
+  m_exchange_status = ok ? resp_status(view) : PN532_STATUS_NO_FRAME;
+  deadline_count(m_exchange_status == 0);
+  return ok;
+}
+/**************************************************************************/
+/*! 
+    @brief  Waits for the PN532 ready signal, then reads n bytes of the
+            response frame and checks its LCS/DCS
+
+    @param  buff      Pointer to the buffer where data will be written
+    @param  n         Number of bytes to be read
+    @param  timeout   Deadline in ms for the response to become ready
+
+    @returns  false if the deadline expired before the chip was ready
+              or the frame is malformed
+*/
+/**************************************************************************/
+boolean wirereadresponse(uint8_t* buff, uint16_t n, uint16_t timeout)
+{
+  pn532_frame_view_t view;
+
+  if (!wirereadframe(&view, n, timeout))
+  {
+    return false;
+  }
+  if (buff != pn532_packetbuffer)
+  {
+    memcpy(buff, pn532_packetbuffer, n);
+  }
+  return true;
+}
+/**************************************************************************/
+/*! 
+    @brief  Writes a command to the PN532, automatically inserting the
+            preamble and required frame details (checksum, len, etc.)
+
+    @param  cmd       Pointer to the command buffer
+    @param  cmdlen    Command length in bytes 
+*/
+/**************************************************************************/
+void wiresendcommand(uint8_t* cmd, uint16_t cmdlen) 
+{
+	uint16_t num;
+	uint8_t address = PN532_I2C_ADDRESS;
+
+	m_error_flag = true;
+	if (cmdlen > PN532_PACKBUFFSIZ)
+	{
+		return;
+	}
+	if (cmd != pn532_packetbuffer)
+	{
+		memmove(pn532_packetbuffer, cmd, cmdlen);
+	}
+	resp_key_set(pn532_packetbuffer, cmdlen);
+
+	num = pn532_frame_encode(pn532_packetbuffer, cmdlen);
+	if (num > 0xFF)
+	{
+		// One bus transfer carries at most 255 bytes.
+		return;
+	}
+	m_error_flag = (i2c_write_buffer(address,pn532_packetbuffer - PN532_FRAME_HEADER_LEN(cmdlen),(uint8_t)num) != NRF_SUCCESS);
+} 
+
+/**************************************************************************/
+/*! 
+    @brief  Writes a complete frame to the PN532 as it is, in one bus
+            transfer: no copy, no checksums
+
+    @param  frame     A PN532_CONST_FRAME
+    @param  framelen  Its size in bytes
+*/
+/**************************************************************************/
+void wiresendframe(uint8_t const* frame, uint8_t framelen)
+{
+  resp_key_set(&frame[PN532_DATA_OFFSET], framelen - PN532_FRAME_OVERHEAD);
+#ifndef NRF51
+  // EasyDMA reads RAM only; the frame is still sent without work on it.
+  if (!nrf_drv_is_in_RAM(frame))
+  {
+    memcpy(m_frame_buf, frame, framelen);
+    frame = m_frame_buf;
+  }
+#endif
+  m_error_flag = (pn532_bus_write(frame, framelen) != NRF_SUCCESS);
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Turns a command into a host-to-PN532 information frame in
+            place: preamble, LEN/LCS and TFI go into the
+            PN532_FRAME_HEADER_LEN(len) bytes in front of body, DCS and
+            postamble behind it. Commands of 254 bytes or more get an
+            extended frame.
+
+    @param  body      Command code followed by parameters; the caller
+                      reserves the headroom and two tail bytes
+    @param  len       Command length in bytes 
+
+    @returns  Frame length, the frame starts at body - PN532_FRAME_HEADER_LEN(len)
+*/
+/**************************************************************************/
+uint16_t pn532_frame_encode(uint8_t* body, uint16_t len)
+{
+  uint16_t  frame_len = len + 1;   // TFI + command
+  uint8_t * header    = body - PN532_FRAME_HEADER_LEN(len);
+  uint8_t   dcs       = PN532_HOSTTOPN532;
+
+  for (uint16_t i = 0; i < len; i++)
+  {
+    dcs += body[i];
+  }
+
+  header[0] = PN532_PREAMBLE;   // 00
+  header[1] = PN532_STARTCODE1; // 00
+  header[2] = PN532_STARTCODE2; // ff
+  if (PN532_FRAME_HEADER_LEN(len) == EXT_HEADER_SEQUENCE_LENGTH)
+  {
+    header[3] = 0xFF;
+    header[4] = 0xFF;
+    header[5] = (uint8_t)(frame_len >> 8);
+    header[6] = (uint8_t)frame_len;
+    header[7] = (uint8_t)(~(header[5] + header[6]) + 1);
+    header[8] = PN532_HOSTTOPN532;
+  }
+  else
+  {
+    header[3] = (uint8_t)frame_len;
+    header[4] = (uint8_t)(~frame_len + 1);
+    header[5] = PN532_HOSTTOPN532;
+  }
+
+  body[len]     = (uint8_t)(~dcs + 1);
+  body[len + 1] = PN532_POSTAMBLE;
+
+  return len + PN532_FRAME_HEADER_LEN(len) + CHECKSUM_SEQUENCE_LENGTH;
+}
+
+
+/**************************************************************************/
+/*! 
+    @brief  Waits until the PN532 is ready.
+
+    With the async engine enabled the CPU sleeps until the IRQ edge
+    instead of spinning on the pin. With wdt_sup the wait is the RF
+    part: it also gives up once that trips, 0 or not.
+
+    @param  timeout   Timeout in ms before giving up, 0 to wait forever
+*/
+/**************************************************************************/
+uint8_t waitUntilReady(uint16_t timeout) 
+{
+  uint8_t ready;
+
+#if NRF_MODULE_ENABLED(WDT_SUP)
+  wdt_sup_begin(WDT_SUP_RF);
+#endif
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+  ready = pn532_wait_ready(timeout);
+#else
+  uint32_t timer = 0;
+  ready = true;
+  while(wirereadstatus() != PN532_I2C_READY) {
+    if (timeout != 0) {
+      timer += 10;
+      if (timer > (uint32_t)timeout * 1000) {
+        ready = false;
+        break;
+      }
+    }
+#if NRF_MODULE_ENABLED(WDT_SUP)
+    if (wdt_sup_expired(WDT_SUP_RF)) {
+      ready = false;
+      break;
+    }
+#endif
+    nrf_delay_us(10);
+  }
+#endif
+#if NRF_MODULE_ENABLED(WDT_SUP)
+  wdt_sup_end(WDT_SUP_RF);
+#endif
+  return ready;
+}
+    
+/**************************************************************************/
+/*! 
+    @brief  Exchanges an APDU with the currently inlisted peer
+
+    @param  send            Pointer to data to send
+    @param  sendLength      Length of the data to send
+    @param  response        Pointer to response data
+    @param  responseLength  Pointer to the response data length
+*/
+/**************************************************************************/
+uint8_t inDataExchange(uint8_t * send, uint8_t sendLength, uint8_t * response, uint8_t * responseLength) 
+{
+  if (sendLength > PN532_PACKBUFFSIZ -2) {
+      return false;
+  }
+  uint8_t i;
   
-  // Now write all three blocks back to the card
-  if (!(mifareclassic_WriteDataBlock (sectorNumber*4, sectorbuffer1)))
+  pn532_packetbuffer[0] = 0x40; // PN532_COMMAND_INDATAEXCHANGE;
+  pn532_packetbuffer[1] = mp_reader->tg;
+  for (i=0; i<sendLength; ++i) {
+    pn532_packetbuffer[i+2] = send[i];
+  }
+  
+  if (!sendCommandCheckAck(pn532_packetbuffer,sendLength+2,1000)) {
+    
+    return false;
+  }
+
+  // Header, response code and status around the data.
+  pn532_frame_view_t view;
+  if (!wirereadframe(&view, *responseLength + PN532_FRAME_OVERHEAD + 2, 1000)) {
+    
+    return false;
+  }
+
+  /* view: response code, status, data */
+  if ((view.len < 2) || (view.p_data[0] != PN532_RESPONSE_INDATAEXCHANGE)) {
+    return false;
+  }
+  if ((view.p_data[1] & 0x3f)!=0) {
+    return false;
+  }
+  
+  uint8_t length = view.len - 2;
+  
+  if (length > *responseLength) {
+    length = *responseLength; // silent truncation...
+  }
+  
+  memcpy(response, &view.p_data[2], length);
+  *responseLength = length;
+  
+  return true;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Exchanges data with the selected target and reads the answer
+            straight into a caller buffer (no copy, up to
+            PN532_TWI_MAX_READ bytes regardless of PN532_PACKBUFFSIZ)
+
+    @param  send       Pointer to data to send
+    @param  sendLength Length of the data to send
+    @param  rxbuf      Receive buffer, see pn532_frame_read
+    @param  rxbufLen   Size of rxbuf
+    @param  data       Set to the card data inside rxbuf
+
+    @returns 1 on success, 0 on timeout, bad frame or card error
+*/
+/**************************************************************************/
+uint8_t inDataExchangeInto(uint8_t * send, uint8_t sendLength, uint8_t * rxbuf, uint16_t rxbufLen, pn532_frame_view_t * data)
+{
+  pn532_frame_view_t view;
+
+  if (sendLength > PN532_PACKBUFFSIZ - 2) {
+    return 0;
+  }
+
+  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
+  pn532_packetbuffer[1] = mp_reader->tg;
+  memcpy(&pn532_packetbuffer[2], send, sendLength);
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, sendLength + 2, 1000)) {
+    return 0;
+  }
+  if (!pn532_frame_read(rxbuf, rxbufLen, &view, PN532_RESP_TIMEOUT_CARD)) {
+    return 0;
+  }
+
+  /* view: response code, status, data */
+  if ((view.len < 2) || (view.p_data[0] != PN532_RESPONSE_INDATAEXCHANGE) ||
+      ((view.p_data[1] & 0x3f) != 0)) {
+    return 0;
+  }
+
+  data->p_data = &view.p_data[2];
+  data->len    = view.len - 2;
+  return 1;
+}
+
+
+/**************************************************************************/
+/*! 
+    @brief  Exchanges one chained block with the selected target, like
+            inDataExchangeInto but with the MI bit exposed in both
+            directions
+
+    @param  send       Pointer to data to send, may be NULL if sendLength is 0
+    @param  sendLength Length of the data to send
+    @param  more       Set MI in the Tg byte: more data follows in the next
+                       call and the PN532 answers with an empty frame once
+                       the card has taken this part
+    @param  rxbuf      Receive buffer, see pn532_frame_read
+    @param  rxbufLen   Size of rxbuf
+    @param  data       Set to the card data inside rxbuf
+    @param  timeout    Response deadline in ms
+
+    @returns The PN532 status byte (PN532_STATUS_MI set when the card
+             data continues), or PN532_STATUS_NO_FRAME on timeout or a
+             bad frame
+*/
+/**************************************************************************/
+uint8_t inDataExchangeStatus(uint8_t const * send, uint8_t sendLength, bool more, uint8_t * rxbuf, uint16_t rxbufLen, pn532_frame_view_t * data, uint16_t timeout)
+{
+  pn532_frame_view_t view;
+
+  if (sendLength > PN532_PACKBUFFSIZ - 2) {
+    return PN532_STATUS_NO_FRAME;
+  }
+
+  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
+  pn532_packetbuffer[1] = mp_reader->tg | (more ? PN532_STATUS_MI : 0);
+  if (sendLength > 0) {
+    memcpy(&pn532_packetbuffer[2], send, sendLength);
+  }
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, sendLength + 2, 1000)) {
+    return PN532_STATUS_NO_FRAME;
+  }
+  if (!pn532_frame_read(rxbuf, rxbufLen, &view, timeout)) {
+    return PN532_STATUS_NO_FRAME;
+  }
+
+  /* view: response code, status, data */
+  if ((view.len < 2) || (view.p_data[0] != PN532_RESPONSE_INDATAEXCHANGE)) {
+    return PN532_STATUS_NO_FRAME;
+  }
+
+  data->p_data = &view.p_data[2];
+  data->len    = view.len - 2;
+  return view.p_data[1];
+}
+
+
+/**************************************************************************/
+/*! 
+    @brief  Sends raw bytes to the selected target with InCommunicateThru
+            and reads the answer straight into a caller buffer, like
+            inDataExchangeInto
+
+    @param  send       Pointer to data to send
+    @param  sendLength Length of the data to send
+    @param  rxbuf      Receive buffer, see pn532_frame_read
+    @param  rxbufLen   Size of rxbuf
+    @param  data       Set to the card data inside rxbuf
+
+    @returns 1 on success, 0 on timeout, bad frame or card error
+*/
+/**************************************************************************/
+uint8_t inCommunicateThruInto(uint8_t * send, uint8_t sendLength, uint8_t * rxbuf, uint16_t rxbufLen, pn532_frame_view_t * data)
+{
+  pn532_frame_view_t view;
+
+  if (sendLength > PN532_PACKBUFFSIZ - 1) {
     return 0;
-  if (!(mifareclassic_WriteDataBlock ((sectorNumber*4)+1, sectorbuffer2)))
+  }
+
+  pn532_packetbuffer[0] = PN532_COMMAND_INCOMMUNICATETHRU;
+  memcpy(&pn532_packetbuffer[1], send, sendLength);
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, sendLength + 1, 1000)) {
     return 0;
-  if (!(mifareclassic_WriteDataBlock ((sectorNumber*4)+2, sectorbuffer3)))
+  }
+  if (!pn532_frame_read(rxbuf, rxbufLen, &view, PN532_RESP_TIMEOUT_CARD)) {
     return 0;
-  if (!(mifareclassic_WriteDataBlock ((sectorNumber*4)+3, sectorbuffer4)))
+  }
+
+  /* view: response code, status, data */
+  if ((view.len < 2) || (view.p_data[0] != PN532_RESPONSE_INCOMMUNICATETHRU) ||
+      ((view.p_data[1] & 0x3f) != 0)) {
     return 0;
+  }
 
-  // Seems that everything was OK (?!)
+  data->p_data = &view.p_data[2];
+  data->len    = view.len - 2;
   return 1;
 }
 
 
 
-/***** Mifare Ultralight Functions ******/
+/**************************************************************************/
+/*! 
+    @brief  Sends the command in pn532_packetbuffer and returns the status
+            byte of a "response code, status" answer
+
+    @returns The PN532 status byte, or PN532_STATUS_NO_FRAME on timeout or
+             a bad frame
+*/
+/**************************************************************************/
+static uint8_t statusCommand(uint8_t cmdlen)
+{
+  uint8_t cmd = pn532_packetbuffer[0];
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, cmdlen, 1000)) {
+    return PN532_STATUS_NO_FRAME;
+  }
+  if (!wirereadresponse(pn532_packetbuffer, PN532_FRAME_OVERHEAD + 2, PN532_RESP_TIMEOUT_CARD)) {
+    return PN532_STATUS_NO_FRAME;
+  }
+
+  /* b5 TFI, b6 response code, b7 status */
+  if (pn532_packetbuffer[6] != (uint8_t)(cmd + 1)) {
+    return PN532_STATUS_NO_FRAME;
+  }
+  return pn532_packetbuffer[7];
+}
 
 /**************************************************************************/
 /*! 
-    Tries to read an entire 4-uint8_t page at the specified address.
+    @brief  Selects a target listed before without a new anticollision
+            (InSelect). A halted ISO14443A card is woken with its known
+            UID.
 
-    @param  page        The page number (0..63 in most cases)
-    @param  buffer      Pointer to the uint8_t array that will hold the
-                        retrieved data (if any)
+    @param  tg    Logical target number
+
+    @returns The PN532 status byte, 0 if the target answered
 */
 /**************************************************************************/
-uint8_t mifareultralight_ReadPage (uint8_t page, uint8_t * buffer)
+uint8_t inSelect(uint8_t tg)
 {
-  if (page >= 64)
+  uint8_t status;
+
+  pn532_packetbuffer[0] = PN532_COMMAND_INSELECT;
+  pn532_packetbuffer[1] = tg;
+  status = statusCommand(2);
+  if (status == 0)
   {
+    // Activated again, RATS included, at 106 kbps.
+    mp_reader->psl_speed = 0;
+    mp_reader->psl_open  = true;
+  }
+  return status;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Raises the bit rate of the selected ISO14443-4 type A target
+            as far as its ATS allows (InPSL, which sends the PPS)
+
+    TA(1) of the ATS gives the divisors the card takes in each
+    direction, and whether it needs the same one both ways. A PPS is
+    only allowed between the ATS and the first block, so this has to
+    come right after readPassiveTargets or inSelect; the reader stays at
+    106 kbps otherwise, and when the card or the PN532 refuse.
+
+    @param  target      Target with its ATS, as readPassiveTargets fills it
+    @param  maxBitRate  Highest bit rate to negotiate, PN532_TYPEB_BITRATE_x
+
+    @returns 1 if the bit rate went up, 0 if it stays at 106 kbps
+*/
+/**************************************************************************/
+uint8_t inPSL(pn532_target_t const * target, uint8_t maxBitRate)
+{
+  uint8_t ta1;
+  uint8_t dri;
+  uint8_t dsi;
 
+  if (!mp_reader->psl_open || (target->tg != mp_reader->tg) ||
+      (target->ats_len < 3) || !(target->ats[1] & 0x10)) {
     return 0;
   }
-  /* Prepare the command */
-  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
-  pn532_packetbuffer[1] = 1;                   /* Card number */
-  pn532_packetbuffer[2] = MIFARE_CMD_READ;     /* Mifare Read command = 0x30 */
-  pn532_packetbuffer[3] = page;                /* Page Number (0..63 in most cases) */
 
-  /* Send the command */
-  if (! sendCommandCheckAck(pn532_packetbuffer, 4, 1000))
-  {
+  /* TA(1): b8 same divisor both ways, b7..b5 PICC to PCD (DS) and b3..b1
+     PCD to PICC (DR), 848/424/212 kbps; b4 is RFU and has to be 0. */
+  ta1 = target->ats[2];
+  if (ta1 & 0x08) {
     return 0;
   }
-  
-  /* Read the response packet */
-	nrf_delay_us(1000);
-  wirereaddata(pn532_packetbuffer, 26);
-  
-
-  /* If uint8_t 8 isn't 0x00 we probably have an error */
-  if (pn532_packetbuffer[7] == 0x00)
-  {
-    /* Copy the 4 data bytes to the output buffer         */
-    /* Block content starts at uint8_t 9 of a valid response */
-    /* Note that the command actually reads 16 uint8_t or 4  */
-    /* pages at a time ... we simply discard the last 12  */
-    /* bytes                                              */
-    memcpy (buffer, pn532_packetbuffer+8, 4);
+  dri = typeb_divisor(ta1 & 0x07, maxBitRate);
+  dsi = typeb_divisor((ta1 >> 4) & 0x07, maxBitRate);
+  if (ta1 & 0x80) {
+    dri = dsi = MIN(dri, dsi);
   }
-  else
-  {
-    
+  if ((dri == 0) && (dsi == 0)) {
     return 0;
   }
 
-  /* Display data for debug if requested */
+  pn532_packetbuffer[0] = PN532_COMMAND_INPSL;
+  pn532_packetbuffer[1] = mp_reader->tg;
+  pn532_packetbuffer[2] = dri;
+  pn532_packetbuffer[3] = dsi;
+  if (statusCommand(4) != 0) {
+    return 0;
+  }
 
-  // Return OK signal
+  mp_reader->psl_speed = (uint8_t)(dri | (dsi << 4));
   return 1;
 }
 
+/**************************************************************************/
+/*! 
+    @brief  Deselects a target (InDeselect), keeping it in the target
+            table; an ISO14443A card is halted
 
-uint8_t readackframe(void) 
+    @returns The PN532 status byte
+*/
+/**************************************************************************/
+uint8_t inDeselect(uint8_t tg)
 {
-  uint8_t ackbuff[6];
-  
-  wirereaddata(ackbuff, 6);
-	
-    
-  return (0 == strncmp((char *)ackbuff, (char *)pn532ack, 6));
+  pn532_packetbuffer[0] = PN532_COMMAND_INDESELECT;
+  pn532_packetbuffer[1] = tg;
+  return statusCommand(2);
 }
 
+/**************************************************************************/
+/*! 
+    @brief  Releases a target (InRelease), 0 releases all of them
+
+    @returns The PN532 status byte
+*/
+/**************************************************************************/
+uint8_t inRelease(uint8_t tg)
+{
+  pn532_packetbuffer[0] = PN532_COMMAND_INRELEASE;
+  pn532_packetbuffer[1] = tg;
+  return statusCommand(2);
+}
 
 /**************************************************************************/
 /*! 
-    @brief  Checks the IRQ pin to know if the PN532 is ready
-	
-	@returns 0 if the PN532 is busy, 1 if it is free
+    @brief  Activates an NFC-DEP target in passive mode (InJumpForDEP),
+            a phone in peer to peer mode
+
+    The PN532 polls, sends ATR_REQ with the general bytes given here and
+    selects the target; at 212 and 424 kbps the poll is a FeliCa
+    Polling. The frames that follow go with inDataExchange, the PN532
+    chaining the DEP blocks of one exchange itself. The RF mode is
+    dropped, so that the next pn532_rf_mode_set restores the reader
+    setup. Without a target in time the command is aborted with an ACK
+    frame.
+
+    @param  baudrate   PN532_DEP_106, PN532_DEP_212 or PN532_DEP_424
+    @param  gi         General bytes of ATR_REQ, the LLCP parameters
+    @param  giLen      Length of gi, at most PN532_DEP_GI_MAX
+    @param  target     Filled with NFCID3t, TO and the general bytes of
+                       ATR_RES
+    @param  timeout    Deadline in ms for the activation
+
+    @returns 1 once a target is activated, 0 for none or an error
 */
 /**************************************************************************/
-uint8_t wirereadstatus(void) 
+uint8_t inJumpForDEP(uint8_t baudrate, uint8_t const * gi, uint8_t giLen, pn532_dep_target_t * target, uint16_t timeout)
 {
-  uint8_t x = nrf_gpio_pin_read(PN532_IRQ);    
-//  printf("read irq---> %d\r\n",x);
+  static uint8_t const felica_poll[] = {0x00, 0xFF, 0xFF, 0x01, 0x00};
+  pn532_frame_view_t view;
+  uint8_t            len = 0;
 
-  if (x == 1)
-    return PN532_I2C_BUSY;
-  else
-    return PN532_I2C_READY;
+  if ((giLen > PN532_DEP_GI_MAX) || (baudrate > PN532_DEP_424)) {
+    return 0;
+  }
+  mp_reader->rf_mode = PN532_RF_MODE_NONE;
+
+  pn532_packetbuffer[len++] = PN532_COMMAND_INJUMPFORDEP;
+  pn532_packetbuffer[len++] = 0x00;                       // passive
+  pn532_packetbuffer[len++] = baudrate;
+  pn532_packetbuffer[len++] = ((baudrate != PN532_DEP_106) ? 0x01 : 0x00) | ((giLen != 0) ? 0x04 : 0x00);
+  if (baudrate != PN532_DEP_106) {
+    memcpy(&pn532_packetbuffer[len], felica_poll, sizeof(felica_poll));
+    len += sizeof(felica_poll);
+  }
+  memcpy(&pn532_packetbuffer[len], gi, giLen);
+  len += giLen;
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, len, 1000)) {
+    return 0;
+  }
+  if (!wirereadframe(&view, PN532_PACKBUFFSIZ, timeout)) {
+    UNUSED_RETURN_VALUE(pn532_bus_write(pn532ack, sizeof(pn532ack)));
+    return 0;
+  }
+
+  /* view: response code, status, Tg, NFCID3t, DIDt, BSt, BRt, TO, PPt, Gt */
+  if ((view.len < 3 + PN532_DEP_NFCID3_LEN + 5) || (view.p_data[0] != PN532_RESPONSE_INJUMPFORDEP) ||
+      ((view.p_data[1] & 0x3f) != 0)) {
+    return 0;
+  }
+
+  memcpy(target->nfcid3, &view.p_data[3], PN532_DEP_NFCID3_LEN);
+  target->br     = baudrate;
+  target->to     = view.p_data[3 + PN532_DEP_NFCID3_LEN + 3] & 0x0F;
+  target->gt_len = (uint8_t)MIN(view.len - (3 + PN532_DEP_NFCID3_LEN + 5), PN532_DEP_GT_MAX);
+  memcpy(target->gt, &view.p_data[3 + PN532_DEP_NFCID3_LEN + 5], target->gt_len);
+  pn532_target_select(view.p_data[2]);
+  return 1;
 }
 
 /**************************************************************************/
 /*! 
-    @brief  Reads n bytes of data from the PN532 via I2C
+    @brief  Checks that the ISO14443-4 target in use is still in the
+            field (Diagnose, Attention Request / card presence test).
+            The card keeps its state, no reselection takes place.
 
-    @param  buff      Pointer to the buffer where data will be written
-    @param  n         Number of bytes to be read
+    @returns The PN532 status byte, 0 if the card answered
 */
 /**************************************************************************/
-void wirereaddata(uint8_t* buff, uint8_t n) 
+uint8_t pn532_presence_test(void)
 {
-
-		 uint8_t address =PN532_I2C_ADDRESS;
-		 uint8_t buffer[64] = {0};
-
-		 i2c_device_read_buffer(address,buffer,n+2);
-		 for(uint8_t i = 0; i< n; i++)
-		 {
-				 buff[i] = buffer[i+1];
-				 
-		 }
+  pn532_packetbuffer[0] = PN532_COMMAND_DIAGNOSE;
+  pn532_packetbuffer[1] = 0x06;
+  return statusCommand(2);
 }
+
 /**************************************************************************/
 /*! 
-    @brief  Writes a command to the PN532, automatically inserting the
-            preamble and required frame details (checksum, len, etc.)
+    @brief  Communication line test (Diagnose, NumTst 0x00). The PN532
+            sends the parameters back as they came, which exercises the
+            host link and the frame handling of the chip, not the RF part
 
-    @param  cmd       Pointer to the command buffer
-    @param  cmdlen    Command length in bytes 
+    @returns 1 if the echo came back unchanged
 */
 /**************************************************************************/
-void wiresendcommand(uint8_t* cmd, uint8_t cmdlen) 
+uint8_t pn532_diag_line(void)
 {
-  uint8_t checksum = 0;
-	uint8_t buffer[64] ={0};//{0x00,0x00,0xff,0x01,0xff,0xd4,0x02,};
-  uint8_t num = 0;
-	uint8_t address = PN532_I2C_ADDRESS;
-	    
-	cmdlen++;
-	 checksum = PN532_PREAMBLE + PN532_PREAMBLE + PN532_STARTCODE2;
-	{
-  
-    buffer[num++] = PN532_I2C_ADDRESS; 
-		buffer[num++] = PN532_PREAMBLE;   // 00
-		buffer[num++] = PN532_STARTCODE1; // 00
-		buffer[num++] = PN532_STARTCODE2; // ff
-		buffer[num++] = cmdlen;           
-		buffer[num++] = (~cmdlen + 1);
-		buffer[num++] = PN532_HOSTTOPN532;
-		checksum += PN532_HOSTTOPN532;
-		for (uint8_t i=0; i<cmdlen-1; i++) {
-				
-					buffer[num++] = cmd[i];
-					checksum += cmd[i];
-		 }
-		
-		 buffer[num++] = (~checksum);
-		 buffer[num++] = PN532_POSTAMBLE; 
+  static uint8_t const pattern[] = {0x00, 0xFF, 0x55, 0xAA, 0x0F, 0xF0, 0x3C, 0xC3};
+  pn532_frame_view_t view;
+
+  pn532_packetbuffer[0] = PN532_COMMAND_DIAGNOSE;
+  pn532_packetbuffer[1] = 0x00;
+  memcpy(&pn532_packetbuffer[2], pattern, sizeof(pattern));
 
-	  i2c_write_buffer(address,buffer,num);
+  if (!sendCommandCheckAck(pn532_packetbuffer, 2 + sizeof(pattern), 1000)) {
+    return 0;
+  }
+  if (!wirereadframe(&view, 2 + sizeof(pattern) + PN532_FRAME_OVERHEAD + 2, PN532_RESP_TIMEOUT_CONFIG)) {
+    return 0;
+  }
 
-	 }
+  /* view: response code, NumTst, echo */
+  return (view.len == 2 + sizeof(pattern)) &&
+         (view.p_data[0] == PN532_COMMAND_DIAGNOSE + 1) && (view.p_data[1] == 0x00) &&
+         (memcmp(&view.p_data[2], pattern, sizeof(pattern)) == 0);
+}
 
-        
-} 
+/**************************************************************************/
+/*! 
+    @brief  Antenna self test (Diagnose, NumTst 0x07). The PN532 turns
+            the field on and checks the current of the antenna drivers
+            against the thresholds; an open or shorted antenna, or a
+            detuned one, draws a current out of range
 
+    @param  threshold  Low and high current thresholds and the enable bit,
+                       as in the PN532 User Manual, 7.2.1
+
+    @returns The PN532 status byte, 0 if the currents are in range
+*/
+/**************************************************************************/
+uint8_t pn532_diag_antenna(uint8_t threshold)
+{
+  pn532_packetbuffer[0] = PN532_COMMAND_DIAGNOSE;
+  pn532_packetbuffer[1] = 0x07;
+  pn532_packetbuffer[2] = threshold;
+  return statusCommand(3);
+}
 
 /**************************************************************************/
 /*! 
-    @brief  Waits until the PN532 is ready.
+    @brief  Reads the state of the chip (GetGeneralStatus): the status of
+            the last error, the external field and the targets it keeps
 
-    @param  timeout   Timeout before giving up
+    @returns 1 if the chip answered
 */
 /**************************************************************************/
-uint8_t waitUntilReady(uint16_t timeout) 
+uint8_t getGeneralStatus(pn532_general_status_t * status)
 {
-  uint16_t timer = 0;
-  while(wirereadstatus() != PN532_I2C_READY) {
-    if (timeout != 0) {
-      timer += 10;
-      if (timer > timeout) {
-        return false;
-      }
-    }
-    nrf_delay_us(10);
+  pn532_frame_view_t view;
+
+  pn532_packetbuffer[0] = PN532_COMMAND_GETGENERALSTATUS;
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, 1, 1000)) {
+    return 0;
   }
-  return true;
+  /* Two targets of 4 bytes at most, then the SAM status */
+  if (!wirereadframe(&view, 4 + 2 * 4 + 1 + PN532_FRAME_OVERHEAD + 2, PN532_RESP_TIMEOUT_CONFIG)) {
+    return 0;
+  }
+
+  /* view: response code, Err, Field, NbTg, targets, SAM status */
+  if ((view.len < 4) || (view.p_data[0] != PN532_COMMAND_GETGENERALSTATUS + 1)) {
+    return 0;
+  }
+  status->err     = view.p_data[1] & 0x3f;
+  status->field   = view.p_data[2];
+  status->targets = view.p_data[3];
+  return 1;
 }
-    
+
+
+/***** Target mode ******/
+
+#define TG_FELICA_PARAMS_LEN   18   // POL_RES data of TgInitAsTarget, unused in PICC mode
+#define TG_NFCID3_LEN          10   // NFCID3t of TgInitAsTarget, unused in PICC mode
+
 /**************************************************************************/
 /*! 
-    @brief  Exchanges an APDU with the currently inlisted peer
-
-    @param  send            Pointer to data to send
-    @param  sendLength      Length of the data to send
-    @param  response        Pointer to response data
-    @param  responseLength  Pointer to the response data length
+    @brief  Emulates an ISO14443-4 type A card (TgInitAsTarget, PICC only)
+            and waits for a reader to activate it
+
+    The PN532 answers the anticollision and the RATS itself with the
+    historical bytes given here; the C-APDUs come with tgGetData. The
+    SetParameters flags get fISO14443-4_PICC for the emulation and the
+    RF mode is dropped, so that the next pn532_rf_mode_set restores the
+    reader setup. Without a reader in time the command is aborted with an
+    ACK frame (PN532 User Manual Rev. 02, 6.2.1.3).
+
+    @param  nfcid1     Last 3 bytes of the emulated UID; the PN532 puts
+                       0x08, a random UID, in front
+    @param  hist       Historical bytes of the ATS
+    @param  histLen    Length of hist, at most PN532_TG_HIST_MAX
+    @param  timeout    Time to wait for a reader in ms, not 0
+
+    @returns 1 once a reader has activated the card, 0 on timeout, on a
+             DEP or plain type A activation, or if the chip did not take
+             the command
 */
 /**************************************************************************/
-uint8_t inDataExchange(uint8_t * send, uint8_t sendLength, uint8_t * response, uint8_t * responseLength) 
+uint8_t tgInitAsTarget(uint8_t const * nfcid1, uint8_t const * hist, uint8_t histLen, uint16_t timeout)
 {
-  if (sendLength > PN532_PACKBUFFSIZ -2) {
-      return false;
+  pn532_frame_view_t view;
+  uint8_t            len = 0;
+
+  if ((histLen > PN532_TG_HIST_MAX) || (timeout == 0)) {
+    return 0;
   }
-  uint8_t i;
-  
-  pn532_packetbuffer[0] = 0x40; // PN532_COMMAND_INDATAEXCHANGE;
-  pn532_packetbuffer[1] = inListedTag;
-  for (i=0; i<sendLength; ++i) {
-    pn532_packetbuffer[i+2] = send[i];
+  // fAutomaticRATS | fISO14443-4_PICC | fAutomaticATR_RES
+  mp_reader->rf_mode = PN532_RF_MODE_NONE;
+  if (!setParametersFlags(0x34)) {
+    return 0;
   }
-  
-  if (!sendCommandCheckAck(pn532_packetbuffer,sendLength+2,1000)) {
-    
-    return false;
+
+  pn532_packetbuffer[len++] = PN532_COMMAND_TGINITASTARGET;
+  pn532_packetbuffer[len++] = PN532_TG_MODE_PASSIVE_ONLY | PN532_TG_MODE_PICC_ONLY;
+  /* MIFARE params: SENS_RES, NFCID1t, SEL_RES with the ISO14443-4 bit */
+  pn532_packetbuffer[len++] = 0x04;
+  pn532_packetbuffer[len++] = 0x00;
+  memcpy(&pn532_packetbuffer[len], nfcid1, 3);
+  len += 3;
+  pn532_packetbuffer[len++] = 0x20;
+  memset(&pn532_packetbuffer[len], 0, TG_FELICA_PARAMS_LEN + TG_NFCID3_LEN);
+  len += TG_FELICA_PARAMS_LEN + TG_NFCID3_LEN;
+  pn532_packetbuffer[len++] = 0;          // no general bytes
+  pn532_packetbuffer[len++] = histLen;
+  memcpy(&pn532_packetbuffer[len], hist, histLen);
+  len += histLen;
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, len, 1000)) {
+    return 0;
+  }
+  if (!wirereadframe(&view, PN532_PACKBUFFSIZ, timeout)) {
+    UNUSED_RETURN_VALUE(pn532_bus_write(pn532ack, sizeof(pn532ack)));
+    return 0;
   }
 
-  if (!waitUntilReady(1000)) {
-    
-    return false;
+  /* view: response code, mode, initiator command (the RATS) */
+  return ((view.len >= 2) && (view.p_data[0] == PN532_RESPONSE_TGINITASTARGET) &&
+          (view.p_data[1] & PN532_TG_ACTIVATED_PICC));
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Waits for the next frame of the reader while emulating a card
+            (TgGetData) and reads it straight into a caller buffer, like
+            inDataExchangeInto
+
+    @param  rxbuf      Receive buffer, see pn532_frame_read
+    @param  rxbufLen   Size of rxbuf
+    @param  data       Set to the C-APDU inside rxbuf
+    @param  timeout    Response deadline in ms
+
+    @returns The PN532 status byte (PN532_STATUS_RELEASED once the reader
+             has released the card), or PN532_STATUS_NO_FRAME on timeout
+             or a bad frame
+*/
+/**************************************************************************/
+uint8_t tgGetData(uint8_t * rxbuf, uint16_t rxbufLen, pn532_frame_view_t * data, uint16_t timeout)
+{
+  pn532_frame_view_t view;
+
+  pn532_packetbuffer[0] = PN532_COMMAND_TGGETDATA;
+  if (!sendCommandCheckAck(pn532_packetbuffer, 1, 1000)) {
+    return PN532_STATUS_NO_FRAME;
+  }
+  if (!pn532_frame_read(rxbuf, rxbufLen, &view, timeout)) {
+    UNUSED_RETURN_VALUE(pn532_bus_write(pn532ack, sizeof(pn532ack)));
+    return PN532_STATUS_NO_FRAME;
   }
 
-  wirereaddata(pn532_packetbuffer,sizeof(pn532_packetbuffer));
-  
-  if (pn532_packetbuffer[0] == 0 && pn532_packetbuffer[1] == 0 && pn532_packetbuffer[2] == 0xff) {
-    uint8_t length = pn532_packetbuffer[3];
-    if (pn532_packetbuffer[4]!=(uint8_t)(~length+1)) {
-      return false;
-    }
-    if (pn532_packetbuffer[5]==PN532_PN532TOHOST && pn532_packetbuffer[6]==PN532_RESPONSE_INDATAEXCHANGE) {
-      if ((pn532_packetbuffer[7] & 0x3f)!=0) {
-        return false;
-      }
-      
-      length -= 3;
-      
-      if (length > *responseLength) {
-        length = *responseLength; // silent truncation...
-      }
-      
-      for (i=0; i<length; ++i) {
-        response[i] = pn532_packetbuffer[8+i];
-      }
-      *responseLength = length;
-      
-      return true;
-    } 
-    else {
-    
-      return false;
-    } 
-  } 
-  else {
-  
-    return false;
+  /* view: response code, status, data */
+  if ((view.len < 2) || (view.p_data[0] != PN532_RESPONSE_TGGETDATA)) {
+    return PN532_STATUS_NO_FRAME;
   }
+
+  data->p_data = &view.p_data[2];
+  data->len    = view.len - 2;
+  return view.p_data[1];
 }
 
+/**************************************************************************/
+/*! 
+    @brief  Sends the answer to the last frame of the reader while
+            emulating a card (TgSetData)
+
+    @param  send       R-APDU
+    @param  sendLength Length of send, at most PN532_PACKBUFFSIZ - 1
+
+    @returns The PN532 status byte, 0 if the reader took it
+*/
+/**************************************************************************/
+uint8_t tgSetData(uint8_t const * send, uint8_t sendLength)
+{
+  if (sendLength > PN532_PACKBUFFSIZ - 1) {
+    return PN532_STATUS_NO_FRAME;
+  }
+
+  pn532_packetbuffer[0] = PN532_COMMAND_TGSETDATA;
+  memcpy(&pn532_packetbuffer[1], send, sendLength);
+  return statusCommand(sendLength + 1);
+}
 
 
 /**************************************************************************/
@@ -1133,46 +4308,27 @@ uint8_t inDataExchange(uint8_t * send, uint8_t sendLength, uint8_t * response, u
 /**************************************************************************/
 uint8_t inListPassiveTarget() 
 {
-  pn532_packetbuffer[0] = PN532_COMMAND_INLISTPASSIVETARGET;
-  pn532_packetbuffer[1] = 1;
-  pn532_packetbuffer[2] = 0;
- 
-
-  if (!sendCommandCheckAck(pn532_packetbuffer,3,1000)) {
+  if (!sendFrameCheckAck(m_frame_list_a, sizeof(m_frame_list_a), 1000)) {
    
     return false;
   }
 
-  if (!waitUntilReady(30000)) {
+  pn532_frame_view_t view;
+  if (!wirereadframe(&view, 20, 30000)) {
     return false;
   }
 
-  wirereaddata(pn532_packetbuffer,sizeof(pn532_packetbuffer));
-  
-  if (pn532_packetbuffer[0] == 0 && pn532_packetbuffer[1] == 0 && pn532_packetbuffer[2] == 0xff) {
-    uint8_t length = pn532_packetbuffer[3];
-    if (pn532_packetbuffer[4]!=(uint8_t)(~length+1)) {
-      return false;
-    }
-    if (pn532_packetbuffer[5]==PN532_PN532TOHOST && pn532_packetbuffer[6]==PN532_RESPONSE_INLISTPASSIVETARGET) {
-      if (pn532_packetbuffer[7] != 1) {
-        
-        return false;
-      }
-      
-      inListedTag = pn532_packetbuffer[8];
-      
-      
-      return true;
-    } else {
- 
-      return false;
-    } 
-  } 
-  else {
+  /* view: response code, NbTg, Tg, ... */
+  if ((view.len < 3) || (view.p_data[0] != PN532_RESPONSE_INLISTPASSIVETARGET)) {
     return false;
   }
-
+  if (view.p_data[1] != 1) {
+    
+    return false;
+  }
+  
+  mp_reader->tg = view.p_data[2];
+  
   return true;
 }
 
@@ -1182,14 +4338,15 @@ uint8_t pn532_wake_up(void)
 {
 	uint8_t err_code;
 
-    // Wakeup procedure as specified in PN532 User Manual Rev. 02, p. 7.2.11, page 99.
-    uint8_t dummy_byte = 0x55;
-    err_code = nrf_drv_twi_tx(&gtMpuTwi, PN532_I2C_ADDRESS, &dummy_byte, 1, false);
+    err_code = pn532_bus_wake();
     if (err_code != NRF_SUCCESS)
     {
-        printf("Failed while calling twi tx, err_code = %d\r\n", err_code);
+        printf("Failed while waking the PN532, err_code = %d\r\n", err_code);
         return err_code;
     }
+#if NRF_MODULE_ENABLED(ENERGY)
+    energy_on(ENERGY_PN532);
+#endif
     // Wait specified time to ensure that the PN532 shield is fully operational
     // (PN532 data sheet, Rev. 3.2, page 209).
     nrf_delay_ms(2);
@@ -1198,23 +4355,51 @@ uint8_t pn532_wake_up(void)
 }
 
 
-uint8_t pn532_power_down(void)
+/**************************************************************************/
+/*! 
+    @brief  Gets a PN532 that stopped answering going again, without a
+            reset pin and without resetting the nRF
+
+    An ACK frame from the host aborts the command the chip is working on
+    (PN532 User Manual Rev. 02, 6.2.1.3), the wake-up brings it out of
+    PowerDown, and the cached SAM and RF setup is dropped so that the next
+    command sends it again.
+
+    @returns 1 if the chip answers GetFirmwareVersion afterwards
+*/
+/**************************************************************************/
+uint8_t pn532_soft_reset(void)
+{
+  pn532_rf_mode_invalidate();
+  UNUSED_RETURN_VALUE(pn532_bus_write(pn532ack, sizeof(pn532ack)));
+  UNUSED_RETURN_VALUE(pn532_wake_up());
+
+  return (getFirmwareVersion() != 0);
+}
+
+
+static uint8_t power_down(uint8_t wakeup_enable, bool generate_irq)
 {
-    printf("Powering down the PN532\r\n");
+    uint8_t len = COMMAND_POWERDOWN_BASE_LENGTH;
+
+    pn532_rf_mode_invalidate();
 
     pn532_packetbuffer[0] = PN532_COMMAND_POWERDOWN;
-    pn532_packetbuffer[1] = POWERDOWN_WAKEUP_IRQ;
+    pn532_packetbuffer[1] = wakeup_enable;
+    if (generate_irq)
+    {
+        // P70_IRQ goes low when the PN532 wakes up.
+        pn532_packetbuffer[len++] = 0x01;
+    }
 
-    uint8_t err_code = sendCommandCheckAck(pn532_packetbuffer,
-                                                  COMMAND_POWERDOWN_BASE_LENGTH,
-                                                  1000);
+    uint8_t err_code = sendCommandCheckAck(pn532_packetbuffer, len, 1000);
 //    if (err_code != NRF_SUCCESS)
 //    {
 //        printf("Failed while checking ACK! err_code = %d\r\n", err_code);
 //        return err_code;
 //    }
-    nrf_delay_ms(1);
-       wirereaddata(pn532_packetbuffer, REPLY_POWERDOWN_LENGTH);
+       UNUSED_RETURN_VALUE(wirereadresponse(pn532_packetbuffer, REPLY_POWERDOWN_LENGTH,
+                                            PN532_RESP_TIMEOUT_CONFIG));
 //    if (err_code != NRF_SUCCESS)
 //    {
 //        printf("Failed while reading data! err_code = %d\r\n", err_code);
@@ -1232,11 +4417,30 @@ uint8_t pn532_power_down(void)
     // From PN532 user manual: "The PN532 needs approximately 1 ms to get into Power Down mode,
     // after the command response." (Rev. 02, p. 7.2.11, page 98)
     nrf_delay_ms(1);
+#if NRF_MODULE_ENABLED(HF_CLOCK) && (PN532_TRANSPORT == PN532_TRANSPORT_HSU)
+    // Nothing comes over the UART until the next wake-up.
+    hf_clock_release(HF_CLOCK_USER_PN532);
+#endif
+#if NRF_MODULE_ENABLED(ENERGY)
+    energy_off(ENERGY_PN532);
+#endif
 
     return NRF_SUCCESS;
 }
 
 
+uint8_t pn532_power_down(void)
+{
+    return power_down(POWERDOWN_WAKEUP_IRQ, false);
+}
+
+
+uint8_t pn532_power_down_rf_wake(void)
+{
+    return power_down(POWERDOWN_WAKEUP_IRQ | POWERDOWN_WAKEUP_RF, true);
+}
+
+
 
 
 void *my_memset(void *s, char c, unsigned int n)
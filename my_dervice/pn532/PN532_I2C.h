@@ -10,6 +10,8 @@
 
 #include "nrf_gpio.h"
 #include "app_util_platform.h"
+#include "nrf_drv_twi.h"
+#include "lock_board.h"
 
 #define PN532_PREAMBLE                      (0x00)
 #define PN532_STARTCODE1                    (0x00)
@@ -53,8 +55,41 @@
 #define PN532_COMMAND_TGRESPONSETOINITIATOR (0x90)
 #define PN532_COMMAND_TGGETTARGETSTATUS     (0x8A)
 
+/* SAMConfiguration modes, for a secure access module on the S2C pins */
+#define PN532_SAM_MODE_NORMAL               (0x01) // No SAM
+#define PN532_SAM_MODE_VIRTUAL_CARD         (0x02) // PN532 and SAM are one card to an outside reader
+#define PN532_SAM_MODE_WIRED_CARD           (0x03) // The host reaches the SAM through the PN532
+#define PN532_SAM_MODE_DUAL_CARD            (0x04) // PN532 and SAM are two cards to an outside reader
+
+#ifndef PN532_SAM_MODE
+#define PN532_SAM_MODE                      PN532_SAM_MODE_NORMAL
+#endif
+#ifndef PN532_SAM_TIMEOUT
+#define PN532_SAM_TIMEOUT                   (0x14) // Virtual card mode, in 50 ms
+#endif
+
 #define PN532_RESPONSE_INDATAEXCHANGE       (0x41)
 #define PN532_RESPONSE_INLISTPASSIVETARGET  (0x4B)
+#define PN532_RESPONSE_INCOMMUNICATETHRU    (0x43)
+#define PN532_RESPONSE_INJUMPFORDEP         (0x57)
+#define PN532_RESPONSE_TGINITASTARGET       (0x8D)
+#define PN532_RESPONSE_TGGETDATA            (0x87)
+
+#define PN532_STATUS_TIMEOUT                (0x01) // The target has not answered
+#define PN532_STATUS_CRC                    (0x02) // CRC error on the air
+#define PN532_STATUS_PARITY                 (0x03) // Parity error on the air
+#define PN532_STATUS_BIT_COUNT              (0x04) // Wrong bit count during the anticollision
+#define PN532_STATUS_FRAMING                (0x05) // Mifare framing error
+#define PN532_STATUS_COLLISION              (0x06) // Abnormal bit collision
+#define PN532_STATUS_RF_OVERFLOW            (0x09) // RF buffer overflow
+#define PN532_STATUS_RF_PROTOCOL            (0x0B) // RF protocol error
+#define PN532_STATUS_AUTH                   (0x14) // Mifare authentication error
+#define PN532_STATUS_WRONG_CARD             (0x2A) // The UID does not match the card in the field
+#define PN532_STATUS_CARD_GONE              (0x2B) // The card disappeared
+#define PN532_STATUS_MI                     (0x40) // More Information: the data continues in the next frame
+#define PN532_STATUS_ERROR_MASK             (0x3F)
+#define PN532_STATUS_NO_FRAME               (0xFF) // No valid response frame, not a chip status
+#define PN532_STATUS_RELEASED               (0x29) // Target mode: the initiator released the target
 
 
 #define PN532_WAKEUP                        (0x55)
@@ -69,6 +104,8 @@
 #define PN532_I2C_BUSY                      (0x00)
 #define PN532_I2C_READY                     (0x01)
 #define PN532_I2C_READYTIMEOUT              (20)
+#define PN532_RESP_TIMEOUT_CONFIG           (50)  // ms, commands handled inside the chip
+#define PN532_RESP_TIMEOUT_CARD             (300) // ms, commands that exchange frames with a card
 
 /**********************************************
 - 0x00 : 106 kbps type A (ISO/IEC14443 Type A),
@@ -78,6 +115,8 @@
 - 0x04 : 106 kbps Innovision Jewel tag.
 ******************************************************/
 #define PN532_MIFARE_ISO14443A              (0x00) //106kps 
+#define PN532_FELICA_212                    (0x01)
+#define PN532_FELICA_424                    (0x02)
 #define PN532_MIFARE_ISO14443_3B            (0X03)
 #define PN532_MIFARE_ISOJEWEL               (0X04)
 
@@ -90,6 +129,34 @@
 #define MIFARE_CMD_DECREMENT                (0xC0)
 #define MIFARE_CMD_INCREMENT                (0xC1)
 #define MIFARE_CMD_STORE                    (0xC2)
+#define MIFARE_ULTRALIGHT_CMD_WRITE         (0xA2)
+
+// Mifare Classic access conditions (mifareclassic_AccessOps)
+#define MIFARE_ACCESS_READ                  (0x01)  // Trailer: the access bits
+#define MIFARE_ACCESS_WRITE                 (0x02)  // Trailer: keys and access bits together
+#define MIFARE_ACCESS_INCREMENT             (0x04)
+#define MIFARE_ACCESS_DECREMENT             (0x08)  // With transfer and restore
+#define MIFARE_ACCESS_TRAILER               (3)     // Group of the sector trailer
+
+// NTAG21x commands
+#define NTAG2XX_VERSION_LEN                 (8)
+#define NTAG2XX_CMD_GET_VERSION             (0x60)
+#define NTAG2XX_CMD_FAST_READ               (0x3A)
+#define NTAG2XX_CMD_READ_SIG                (0x3C)
+#define NTAG2XX_CMD_PWD_AUTH                (0x1B)
+#define NTAG2XX_SIG_LEN                     (32)    // ECC originality signature, r then s
+#define NTAG2XX_PWD_LEN                     (4)
+#define NTAG2XX_PACK_LEN                    (2)
+
+// Innovision Jewel / Topaz commands (NFC Forum Type 1 Tag)
+#define JEWEL_CMD_RALL                      (0x00)
+#define JEWEL_CMD_READ8                     (0x02)
+#define JEWEL_ID_LEN                        (4)     // UID0..3, sent with every command
+#define JEWEL_BLOCK_LEN                     (8)
+#define JEWEL_RALL_LEN                      (122)   // HR0, HR1 and blocks 0x00..0x0E
+#define JEWEL_RALL_RXBUF_LEN                (1 + PN532_FRAME_OVERHEAD + 2 + JEWEL_RALL_LEN)
+#define JEWEL_HR0_STATIC                    (0x11)  // Jewel, Topaz 96: 120 bytes, RALL only
+#define JEWEL_HR0_DYNAMIC                   (0x12)  // Topaz 512: READ8 past block 0x0E
 
 // Prefixes for NDEF Records (to identify record type)
 #define NDEF_URIPREFIX_NONE                 (0x00)
@@ -130,9 +197,14 @@
 #define NDEF_URIPREFIX_URN_NFC              (0x23)
 
 
-#define PN532_CONFIG_SCL         11  //!< Slave SCL pin
-#define PN532_CONFIG_SDA         10  //!< Slave SDA pin
-#define PN532_IRQ                2   //irq
+// Host interface, PN532_TRANSPORT in sdk_config.h; pins in lock_board.h. The SPI and HSU pins
+// take over the TWI lines.
+#define PN532_TRANSPORT_I2C      0
+#define PN532_TRANSPORT_SPI      1
+#define PN532_TRANSPORT_HSU      2
+
+#define PN532_SPI_FREQUENCY      NRF_DRV_SPI_FREQ_4M   //PN532 maximum is 5 MHz
+#define PN532_HSU_BAUDRATE       NRF_UART_BAUDRATE_115200   //PN532 power-on default
 typedef uint8_t boolean;
 
 
@@ -149,11 +221,17 @@ typedef uint8_t boolean;
 //#define PN532_CONFIG_SDA           30  //!< Slave SDA pin
 
 #define POWERDOWN_WAKEUP_IRQ                                  0x80
+#define POWERDOWN_WAKEUP_RF                                   0x08 // RF level detector: a reader's field.
 #define COMMAND_POWERDOWN_BASE_LENGTH                         2    // No GenerateIRQ parameter.
 #define HEADER_SEQUENCE_LENGTH   6
 #define CHECKSUM_SEQUENCE_LENGTH 2
 #define PN532_FRAME_OVERHEAD     (HEADER_SEQUENCE_LENGTH + CHECKSUM_SEQUENCE_LENGTH)
+#define EXT_HEADER_SEQUENCE_LENGTH 9   // 00 00 FF FF FF LENM LENL LCS TFI
+#define PN532_FRAME_HEADER_LEN(cmdlen) \
+        (((cmdlen) + 1 > 0xFE) ? EXT_HEADER_SEQUENCE_LENGTH : HEADER_SEQUENCE_LENGTH)
+#define PN532_TWI_MAX_READ       254   // one bus transfer moves at most 255 bytes, one is the status byte
 #define REPLY_POWERDOWN_LENGTH                                (2 + PN532_FRAME_OVERHEAD)
+#define REPLY_RFCONFIGURATION_LENGTH                          (2 + PN532_FRAME_OVERHEAD)
 #define PN532_PREAMBLE_OFFSET   0
 #define PN532_STARTCODE1_OFFSET 1
 #define PN532_STARTCODE2_OFFSET 2
@@ -162,13 +240,86 @@ typedef uint8_t boolean;
 #define PN532_TFI_OFFSET        5
 #define PN532_DATA_OFFSET       6
 
+/* Frame of a command whose bytes never change, complete at build time: LEN, LCS and DCS are
+   folded from the command bytes by the compiler, so the frame is sent from flash as it is with
+   sendFrameCheckAck(). Up to 8 command bytes, e.g.
+     static uint8_t const m_sam[] = PN532_CONST_FRAME(PN532_COMMAND_SAMCONFIGURATION, 0x01, 0x14, 0x01); */
+#define PN532_ARGC(...)                 PN532_ARGC_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define PN532_ARGC_(_1, _2, _3, _4, _5, _6, _7, _8, n, ...)  n
+#define PN532_SUM_1(a)                  (a)
+#define PN532_SUM_2(a, ...)             ((a) + PN532_SUM_1(__VA_ARGS__))
+#define PN532_SUM_3(a, ...)             ((a) + PN532_SUM_2(__VA_ARGS__))
+#define PN532_SUM_4(a, ...)             ((a) + PN532_SUM_3(__VA_ARGS__))
+#define PN532_SUM_5(a, ...)             ((a) + PN532_SUM_4(__VA_ARGS__))
+#define PN532_SUM_6(a, ...)             ((a) + PN532_SUM_5(__VA_ARGS__))
+#define PN532_SUM_7(a, ...)             ((a) + PN532_SUM_6(__VA_ARGS__))
+#define PN532_SUM_8(a, ...)             ((a) + PN532_SUM_7(__VA_ARGS__))
+#define PN532_SUM(...)                  CONCAT_2(PN532_SUM_, PN532_ARGC(__VA_ARGS__))(__VA_ARGS__)
+#define PN532_CONST_FRAME(...)                                                        \
+        {                                                                             \
+          PN532_PREAMBLE, PN532_STARTCODE1, PN532_STARTCODE2,                         \
+          (uint8_t)(PN532_ARGC(__VA_ARGS__) + 1),                                     \
+          (uint8_t)(0x100 - (PN532_ARGC(__VA_ARGS__) + 1)),                           \
+          PN532_HOSTTOPN532, __VA_ARGS__,                                             \
+          (uint8_t)(0x100 - ((PN532_HOSTTOPN532 + PN532_SUM(__VA_ARGS__)) & 0xFF)),   \
+          PN532_POSTAMBLE                                                             \
+        }
+
+/**@brief Payload of a validated PN532-to-host frame, pointing into the receive buffer. */
+typedef struct
+{
+    uint8_t const * p_data;  /**< Response code followed by the response parameters. */
+    uint16_t        len;     /**< Number of bytes at p_data. */
+} pn532_frame_view_t;
+
 //  void Adafruit_NFCShield_I2C(uint8_t irq, uint8_t reset);
   void begin(void);
   
   // Generic PN532 functions
   boolean SAMConfig(void);
+  uint8_t pn532_sam_wired(bool wired);
+
+/**@brief RF modes tracked by @ref pn532_rf_mode_set. */
+typedef enum
+{
+    PN532_RF_MODE_NONE,      /**< Unknown, next switch sends the full setup. */
+    PN532_RF_MODE_ISO14443A, /**< 106 kbps type A (Mifare). */
+    PN532_RF_MODE_ISO14443B, /**< 106 kbps type B. */
+    PN532_RF_MODE_FELICA,    /**< 212/424 kbps FeliCa. */
+    PN532_RF_MODE_JEWEL,     /**< 106 kbps Innovision Jewel. */
+} pn532_rf_mode_t;
+
+#define PN532_PIN_NOT_USED  0xFF
+
+/**@brief How one of several PN532s sharing the host interface is reached. */
+typedef struct
+{
+    uint8_t irq_pin;    /**< IRQ line of this reader. */
+    uint8_t sel_pin;    /**< SPI: NSS of this reader. I2C: bus switch output, or PN532_PIN_NOT_USED. */
+    uint8_t sel_level;  /**< I2C: sel_pin level that connects this reader. */
+} pn532_bus_cfg_t;
+
+/**@brief Driver state kept per reader. */
+typedef struct
+{
+    pn532_bus_cfg_t bus;
+    bool            sam_configured;
+    pn532_rf_mode_t rf_mode;
+    uint8_t         typeb_speed;     /**< TxMode/RxMode speed bits programmed after the last ATTRIB. */
+    uint8_t         tg;              /**< Target addressed by InDataExchange and the Mifare commands. */
+    uint8_t         psl_speed;       /**< BRit | BRti << 4 set by inPSL for the target, 0 at 106 kbps. */
+    bool            psl_open;        /**< Target activated and no command since: a PPS is allowed. */
+} pn532_reader_t;
+
+  void             pn532_reader_select(pn532_reader_t * p_reader);
+  pn532_reader_t * pn532_reader_current(void);
+
+  uint8_t         pn532_rf_mode_set(pn532_rf_mode_t mode);
+  pn532_rf_mode_t pn532_rf_mode_get(void);
+  void            pn532_rf_mode_invalidate(void);
   uint32_t getFirmwareVersion(void);
   boolean sendCommandCheckAck(uint8_t *cmd, uint8_t cmdlen, uint16_t timeout);  
+  boolean sendFrameCheckAck(uint8_t const *frame, uint8_t framelen, uint16_t timeout);
   boolean writeGPIO(uint8_t pinstate);
   uint8_t readGPIO(void);
   boolean setPassiveActivationRetries(uint8_t maxRetries);
@@ -177,19 +328,94 @@ typedef uint8_t boolean;
   boolean inListPassiveTarget();
   boolean readPassiveTargetID(uint8_t cardbaudrate, uint8_t * uid, uint8_t * uidLength, uint16_t timeout); //timeout 0 means no timeout - will block forever.
 
+#define PN532_MAX_TARGETS  2   // InListPassiveTarget MaxTg limit
+#define PN532_TARGET_ATS_LEN  8 // ATS bytes kept, enough for the interface bytes and the first historical bytes
+#define PN532_UID_MAX_LEN     10 // NFCID1 of three cascade levels: 4, 7 or 10 bytes
+#define PN532_MFC_UID_LEN     4  // UID bytes of a Classic authentication, the last ones of the NFCID1
+
+/**@brief One entry of the target table filled by readPassiveTargets. */
+typedef struct
+{
+    uint8_t  tg;        /**< Logical target number, used to address the card. */
+    uint16_t sens_res;  /**< SENS_RES (ATQA). */
+    uint8_t  sel_res;   /**< SEL_RES (SAK). */
+    uint8_t  uid_len;   /**< NFCID length. */
+    uint8_t  uid[PN532_UID_MAX_LEN];  /**< NFCID, up to triple size. */
+    uint8_t  ats_len;   /**< ATS length (its TL byte), 0 for cards without ISO14443-4. */
+    uint8_t  ats[PN532_TARGET_ATS_LEN];  /**< Start of the ATS, TL included. */
+} pn532_target_t;
+
+/**@brief Answer of GetGeneralStatus. */
+typedef struct
+{
+    uint8_t err;        /**< Status of the last command that failed, 0 if none did. */
+    uint8_t field;      /**< 1 if the PN532 detects an external RF field. */
+    uint8_t targets;    /**< Targets the PN532 keeps, NbTg. */
+} pn532_general_status_t;
+
+  uint8_t readPassiveTargets(uint8_t cardbaudrate, pn532_target_t * targets, uint8_t maxTargets, uint16_t timeout);
+  uint8_t readPassiveTargetsStart(uint8_t cardbaudrate, uint8_t maxTargets);
+  uint8_t readPassiveTargetsFinish(pn532_target_t * targets, uint8_t maxTargets, uint16_t timeout);
+  void    pn532_target_select(uint8_t tg);
+  uint8_t inSelect(uint8_t tg);
+  uint8_t inPSL(pn532_target_t const * target, uint8_t maxBitRate);
+  uint8_t inDeselect(uint8_t tg);
+  uint8_t inRelease(uint8_t tg);
+  uint8_t pn532_presence_test(void);
+  uint8_t pn532_diag_line(void);
+  uint8_t pn532_diag_antenna(uint8_t threshold);
+  uint8_t getGeneralStatus(pn532_general_status_t * status);
+
   boolean inDataExchange(uint8_t * send, uint8_t sendLength, uint8_t * response, uint8_t * responseLength);
+  uint8_t inDataExchangeInto(uint8_t * send, uint8_t sendLength, uint8_t * rxbuf, uint16_t rxbufLen, pn532_frame_view_t * data);
+  uint8_t inDataExchangeStatus(uint8_t const * send, uint8_t sendLength, bool more, uint8_t * rxbuf, uint16_t rxbufLen, pn532_frame_view_t * data, uint16_t timeout);
   
   // Mifare Classic functions
   bool mifareclassic_IsFirstBlock (uint32_t uiBlock);
   bool mifareclassic_IsTrailerBlock (uint32_t uiBlock);
+  uint8_t mifareclassic_AccessGroup (uint32_t uiBlock);
+  uint8_t mifareclassic_AccessDecode (uint8_t const * trailer, uint16_t * access);
+  uint8_t mifareclassic_AccessOps (uint16_t access, uint8_t group, uint8_t keyNumber);
   uint8_t mifareclassic_AuthenticateBlock (uint8_t * uid, uint8_t uidLen, uint32_t blockNumber, uint8_t keyNumber, uint8_t * keyData);
   uint8_t mifareclassic_ReadDataBlock (uint8_t blockNumber, uint8_t * data);
   uint8_t mifareclassic_WriteDataBlock (uint8_t blockNumber, uint8_t * data);
+
+  // Value blocks; the operations need the sector authenticated like the data block calls.
+  void    mifareclassic_ValueBlockEncode (int32_t value, uint8_t addr, uint8_t * block);
+  uint8_t mifareclassic_ValueBlockDecode (uint8_t const * block, int32_t * value, uint8_t * addr);
+  uint8_t mifareclassic_ValueOp (uint8_t cmd, uint8_t block, uint32_t delta, uint8_t dest);
+#define mifareclassic_Increment(block, delta)  mifareclassic_ValueOp(MIFARE_CMD_INCREMENT, (block), (delta), (block))
+#define mifareclassic_Decrement(block, delta)  mifareclassic_ValueOp(MIFARE_CMD_DECREMENT, (block), (delta), (block))
+#define mifareclassic_Restore(block, dest)     mifareclassic_ValueOp(MIFARE_CMD_STORE, (block), 0, (dest))
+
+  /**@brief Called by mifareclassic_ReadRange for every data block read. */
+  typedef void (*mifareclassic_block_handler_t)(uint8_t block, uint8_t * data, void * context);
+
+  /**@brief Called by mifareclassic_ReadRange to authenticate a sector, returns 1 on success. */
+  typedef uint8_t (*mifareclassic_auth_handler_t)(uint8_t * uid, uint8_t uidLen, uint32_t block, void * context);
+
+  uint8_t mifareclassic_ReadRange (uint8_t * uid, uint8_t uidLen, uint8_t firstBlock, uint8_t lastBlock,
+                                   mifareclassic_auth_handler_t auth,
+                                   mifareclassic_block_handler_t handler, void * context);
+  /**@brief Called by mifareclassic_WriteRange for the new contents of a block, NULL to skip it. */
+  typedef uint8_t const * (*mifareclassic_write_source_t)(uint8_t block, void * context);
+
+  uint8_t mifareclassic_WriteRange (uint8_t * uid, uint8_t uidLen, uint8_t firstBlock, uint8_t lastBlock,
+                                    mifareclassic_auth_handler_t auth,
+                                    mifareclassic_write_source_t source,
+                                    mifareclassic_block_handler_t handler, void * context);
   uint8_t mifareclassic_FormatNDEF (void);
   uint8_t mifareclassic_WriteNDEFURI (uint8_t sectorNumber, uint8_t uriIdentifier, const char * url);
   
   // Mifare Ultralight functions
   uint8_t mifareultralight_ReadPage (uint8_t page, uint8_t * buffer);
+  uint8_t mifareultralight_ReadPages (uint8_t page, uint8_t * buffer);
+  uint8_t ntag2xx_WritePage (uint8_t page, uint8_t const * data);
+  uint16_t ntag2xx_FastRead (uint8_t startPage, uint8_t endPage, uint8_t * buffer);
+  uint8_t ntag2xx_GetVersion (uint8_t * version);
+  uint8_t ntag2xx_ReadSig (uint8_t * signature);
+  uint8_t ntag2xx_PwdAuth (uint8_t const * pwd, uint8_t * pack);
+  uint8_t inCommunicateThruInto(uint8_t * send, uint8_t sendLength, uint8_t * rxbuf, uint16_t rxbufLen, pn532_frame_view_t * data);
   
   // Help functions to display formatted text
   static void PrintHex(const uint8_t * data, const uint32_t numBytes);
@@ -197,24 +423,148 @@ typedef uint8_t boolean;
 
   boolean  readackframe(void);
   uint8_t  wirereadstatus(void);
-  void     wirereaddata(uint8_t* buff, uint8_t n);
-  void     wiresendcommand(uint8_t* cmd, uint8_t cmdlen);
+  void     wirereaddata(uint8_t* buff, uint16_t n);
+  boolean  wirereadresponse(uint8_t* buff, uint16_t n, uint16_t timeout);
+  boolean  wirereadframe(pn532_frame_view_t* view, uint16_t n, uint16_t timeout);
+  boolean  pn532_frame_read(uint8_t* buf, uint16_t buf_len, pn532_frame_view_t* view, uint16_t timeout);
+  ret_code_t pn532_frame_decode(uint8_t const* raw, uint16_t raw_len, pn532_frame_view_t* view);
+  uint8_t  pn532_exchange_status(void);
+  void     wiresendcommand(uint8_t* cmd, uint16_t cmdlen);
+  void     wiresendframe(uint8_t const* frame, uint8_t framelen);
+  uint16_t pn532_frame_encode(uint8_t* body, uint16_t len);
   boolean  waitUntilReady(uint16_t timeout);
   ret_code_t pn532_simulator_init(void);
 
 	void i2c_write_byte(uint8_t address, uint8_t data);
-  void i2c_write_buffer(uint8_t address, uint8_t *data,uint8_t len);	
+  ret_code_t i2c_write_buffer(uint8_t address, uint8_t *data,uint8_t len);	
 	uint8_t i2c_device_read_byte(uint8_t data);  
-	void    i2c_device_read_buffer(uint8_t address, uint8_t* data, uint8_t data_Len);
+	ret_code_t i2c_device_read_buffer(uint8_t address, uint8_t* data, uint8_t data_Len);
 	uint8_t pn532_wake_up(void);
+	uint8_t pn532_soft_reset(void);
 	uint8_t pn532_power_down(void);
+	/**@brief PowerDown that also ends when an external RF field, such as that of a phone, is
+	 *        detected; P70_IRQ then goes low, which can wake the nRF51 from system off. */
+	uint8_t pn532_power_down_rf_wake(void);
 	void pn532_gpio_init(void);
-	void init_pnc523_i2c(void);
+
+	/* Host interface of the PN532. One backend is built, picked by PN532_TRANSPORT (or the
+	 * emulator with PN532_SIM), so the calls below go straight to its driver. Reads put the
+	 * frame at p_buf[1]; p_buf[0] gets the I2C status byte, the byte clocked in with the SPI
+	 * DATAREAD opcode, or nothing on HSU. Lengths count that byte. */
+
+	/**@brief Completion handler of the asynchronous transfers, called from the bus interrupt. */
+	typedef void (*pn532_bus_handler_t)(ret_code_t result);
+
+	ret_code_t pn532_bus_init(void);
+	ret_code_t pn532_bus_write(uint8_t const * p_data, uint8_t len);
+	ret_code_t pn532_bus_read(uint8_t * p_buf, uint8_t len);
+	ret_code_t pn532_bus_write_async(uint8_t const * p_data, uint8_t len, pn532_bus_handler_t handler);
+	ret_code_t pn532_bus_read_async(uint8_t * p_buf, uint8_t len, pn532_bus_handler_t handler);
+	/**@brief Set up a read without starting it; the start task of @ref pn532_bus_read_task does. I2C only. */
+	ret_code_t pn532_bus_read_hold(uint8_t * p_buf, uint8_t len, pn532_bus_handler_t handler);
+	/**@brief Address of the task that starts a held read, for PPI. */
+	uint32_t   pn532_bus_read_task(void);
+	/**@brief Start a held read that no trigger came for, so that the bus is free again. */
+	void       pn532_bus_read_release(void);
+	/**@brief Bus specific wake-up from PowerDown; the caller waits for the oscillator. */
+	ret_code_t pn532_bus_wake(void);
+	/**@brief Route the bus to another reader, called by @ref pn532_reader_select. */
+	void       pn532_bus_select(pn532_bus_cfg_t const * p_cfg);
 	/*----------------------------------------Category B------------------------------------*/
   uint8_t CategoryBConfig(void);
 	uint8_t SetParameters(void);
 	uint8_t readTypeBuid(uint8_t cardbaudrate, uint8_t * uid, uint8_t * uidLength, uint16_t timeout);
+
+#define PN532_TYPEB_BITRATE_106  0
+#define PN532_TYPEB_BITRATE_212  1
+#define PN532_TYPEB_BITRATE_424  2
+#define PN532_TYPEB_BITRATE_848  3
+#define PN532_TYPEB_GARBLED      2   // pn532_typeb_transceive: an answer with a bad frame or CRC_B
+
+#define TYPEB_APF              0x05  // Anticollision prefix byte of REQB/WUPB and Slot-MARKER
+#define TYPEB_PARAM_WUPB       0x08  // REQB PARAM: wake up halted cards too
+#define TYPEB_ATQB             0x50  // First byte of ATQB
+#define TYPEB_ATQB_LEN         12    // ATQB without CRC_B (no extended ATQB requested)
+#define TYPEB_ATTRIB           0x1D
+#define TYPEB_HLTB             0x50
+#define TYPEB_FSDI             7     // 128-byte frames, well within one TWI read
+#define TYPEB_CRC_LEN          2
+
+/**@brief ISO14443-3B card activated by pn532_typeb_select. */
+typedef struct
+{
+    uint8_t pupi[4];       /**< Pseudo-Unique PICC Identifier from the ATQB. */
+    uint8_t app_data[4];   /**< Application Data from the ATQB. */
+    uint8_t prot_info[3];  /**< Protocol Info from the ATQB. */
+    uint8_t dri;           /**< Negotiated PCD to PICC divisor code. */
+    uint8_t dsi;           /**< Negotiated PICC to PCD divisor code. */
+    uint8_t cid;           /**< CID assigned in ATTRIB, 0 if the card has no CID support. */
+} pn532_typeb_target_t;
+
+	uint8_t inCommunicateThruStatus(uint8_t const * send, uint8_t sendLength, uint8_t * rxbuf, uint16_t rxbufLen, pn532_frame_view_t * data, uint16_t timeout);
+	uint16_t pn532_typeb_crc(uint8_t const * data, uint8_t len);
+	uint8_t pn532_typeb_transceive(uint8_t const * send, uint8_t sendLength, uint8_t * rxbuf, uint16_t rxbufLen, pn532_frame_view_t * data);
+	uint8_t pn532_typeb_select(uint8_t maxBitRate, pn532_typeb_target_t * target, uint16_t timeout);
+	uint8_t pn532_typeb_halt(pn532_typeb_target_t const * target);
+	/*----------------------------------------FeliCa------------------------------------*/
+#define FELICA_SYSTEM_CODE_ANY       0xFFFF
+#define FELICA_REQUEST_NONE          0x00
+#define FELICA_REQUEST_SYSTEM_CODE   0x01
+#define FELICA_BLOCK(service, block) ((uint16_t)(((service) << 12) | ((block) & 0x0FFF)))
+#define PN532_FELICA_READ_MAX_BLOCKS 12   // 13 + 16 * 12 bytes of answer, in one bus read
+
+/**@brief FeliCa card found by felica_Polling. */
+typedef struct
+{
+    uint8_t  idm[8];     /**< Manufacture ID, addresses the card. */
+    uint8_t  pmm[8];     /**< Manufacture parameters, response times. */
+    uint16_t sys_code;   /**< System code, FELICA_SYSTEM_CODE_ANY if not requested. */
+} pn532_felica_target_t;
+
+	uint8_t felica_Polling(uint8_t cardbaudrate, uint16_t systemCode, uint8_t requestCode, pn532_felica_target_t * target, uint16_t timeout);
+	uint8_t felica_ReadWithoutEncryption(pn532_felica_target_t const * target, uint8_t serviceCount, uint16_t const * serviceCodes, uint8_t blockCount, uint16_t const * blockList, uint8_t * rxbuf, uint16_t rxbufLen, pn532_frame_view_t * data);
+	/*----------------------------------------NFC-DEP------------------------------------*/
+#define PN532_DEP_106                0x00
+#define PN532_DEP_212                0x01
+#define PN532_DEP_424                0x02
+#define PN532_DEP_NFCID3_LEN         10
+#define PN532_DEP_GI_MAX             48     // General bytes of ATR_REQ
+#define PN532_DEP_GT_MAX             48     // General bytes of ATR_RES kept, 47 at most
+
+/**@brief NFC-DEP target activated by inJumpForDEP. */
+typedef struct
+{
+    uint8_t nfcid3[PN532_DEP_NFCID3_LEN];
+    uint8_t br;                    /**< Bit rate of the activation, PN532_DEP_*. */
+    uint8_t to;                    /**< Response timeout of the target, RWT = 302 us * 2^TO. */
+    uint8_t gt_len;
+    uint8_t gt[PN532_DEP_GT_MAX];  /**< General bytes of ATR_RES, the LLCP parameters of a phone. */
+} pn532_dep_target_t;
+
+	uint8_t inJumpForDEP(uint8_t baudrate, uint8_t const * gi, uint8_t giLen, pn532_dep_target_t * target, uint16_t timeout);
+	/*----------------------------------------Jewel------------------------------------*/
+/**@brief Innovision Jewel or Topaz found by jewel_Poll. */
+typedef struct
+{
+    uint16_t sens_res;            /**< SENS_RES (ATQA), 0x0C00. */
+    uint8_t  id[JEWEL_ID_LEN];    /**< JEWELID, addresses the tag. */
+} pn532_jewel_target_t;
+
+	uint8_t jewel_Poll(pn532_jewel_target_t * target, uint16_t timeout);
+	uint8_t jewel_ReadAll(pn532_jewel_target_t const * target, uint8_t * rxbuf, uint16_t rxbufLen, pn532_frame_view_t * data);
+	uint8_t jewel_Read8(pn532_jewel_target_t const * target, uint8_t block, uint8_t * buffer);
+	/*----------------------------------------Target mode------------------------------------*/
+#define PN532_TG_MODE_PASSIVE_ONLY   0x01
+#define PN532_TG_MODE_DEP_ONLY       0x02
+#define PN532_TG_MODE_PICC_ONLY      0x04
+#define PN532_TG_ACTIVATED_PICC      0x08   // Mode byte of the TgInitAsTarget answer: ISO14443-4 PICC
+#define PN532_TG_HIST_MAX            15     // Historical bytes of the emulated ATS
+
+	uint8_t tgInitAsTarget(uint8_t const * nfcid1, uint8_t const * hist, uint8_t histLen, uint16_t timeout);
+	uint8_t tgGetData(uint8_t * rxbuf, uint16_t rxbufLen, pn532_frame_view_t * data, uint16_t timeout);
+	uint8_t tgSetData(uint8_t const * send, uint8_t sendLength);
 	uint8_t SetRFConfiguration(void);
+	uint8_t pn532_rf_config(uint8_t item, uint8_t const * p_data, uint8_t len);
   void *my_memset(void *s, char c, unsigned int n);
 
 	
@@ -0,0 +1,91 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(ADV_SCHED)
+#include "adv_sched.h"
+#include "pn532_i2c.h"
+#include "pn532_duty.h"
+#include "pn532_scan.h"
+#include "nrf_gpio.h"
+
+static bool m_save;     /**< Low battery: the fast stage is skipped. */
+static bool m_fast;     /**< Advertising at APP_ADV_INTERVAL. */
+
+
+static void slow_switch(void)
+{
+    if (sd_ble_gap_adv_stop() == NRF_SUCCESS)
+    {
+        UNUSED_RETURN_VALUE(ble_advertising_start(BLE_ADV_MODE_SLOW));
+    }
+}
+
+
+void adv_sched_config(ble_adv_modes_config_t * p_config)
+{
+    p_config->ble_adv_fast_enabled  = true;
+    p_config->ble_adv_fast_timeout  = ADV_SCHED_FAST_TIMEOUT;
+    p_config->ble_adv_slow_enabled  = true;
+    p_config->ble_adv_slow_interval = ADV_SCHED_SLOW_INTERVAL;
+    p_config->ble_adv_slow_timeout  = ADV_SCHED_SLOW_TIMEOUT;
+}
+
+
+void adv_sched_kick(void)
+{
+    if (m_save)
+    {
+        return;
+    }
+    // Fails while connected or while not advertising at all, and so does nothing then.
+    if (sd_ble_gap_adv_stop() == NRF_SUCCESS)
+    {
+        UNUSED_RETURN_VALUE(ble_advertising_start(BLE_ADV_MODE_FAST));
+    }
+}
+
+
+void adv_sched_on_adv_evt(ble_adv_evt_t ble_adv_evt)
+{
+    m_fast = (ble_adv_evt == BLE_ADV_EVT_FAST);
+
+    // ble_advertising starts in the fast mode after a disconnect; go on in the slow one.
+    if (m_fast && m_save)
+    {
+        slow_switch();
+    }
+}
+
+
+void adv_sched_save(bool save)
+{
+    m_save = save;
+    if (m_fast && m_save)
+    {
+        slow_switch();
+    }
+}
+
+
+void adv_sched_sleep_prepare(void)
+{
+#if ADV_SCHED_NFC_WAKE
+#if NRF_MODULE_ENABLED(PN532_DUTY)
+    if (pn532_duty_is_active())
+    {
+        pn532_duty_stop();
+    }
+#endif
+#if NRF_MODULE_ENABLED(PN532_SCAN)
+    if (pn532_scan_is_active())
+    {
+        pn532_scan_stop();
+    }
+#endif
+    // The PN532 may be in PowerDown already; the field detector is set with a new one.
+    if ((pn532_wake_up() == NRF_SUCCESS) && (pn532_power_down_rf_wake() == NRF_SUCCESS))
+    {
+        nrf_gpio_cfg_sense_input(PN532_IRQ, NRF_GPIO_PIN_NOPULL, NRF_GPIO_PIN_SENSE_LOW);
+    }
+#endif
+}
+
+#endif //NRF_MODULE_ENABLED(ADV_SCHED)
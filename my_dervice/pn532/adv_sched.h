@@ -0,0 +1,40 @@
+#ifndef __ADV_SCHED_H__
+#define __ADV_SCHED_H__
+
+#include "ble_advertising.h"
+
+/* Advertising in stages, on the modes of ble_advertising:
+ *
+ *   fast  APP_ADV_INTERVAL for ADV_SCHED_FAST_TIMEOUT s, after boot, a disconnect, a card tap
+ *   slow  ADV_SCHED_SLOW_INTERVAL for ADV_SCHED_SLOW_TIMEOUT s, or for good when that is 0
+ *
+ * A phone that comes back finds the lock within a fast interval while the tap or the
+ * disconnect is recent, and within a slow interval after that. Mains-powered units keep
+ * advertising slowly; battery units go to system off at the end of the slow stage, to be woken
+ * by a button or, with ADV_SCHED_NFC_WAKE, by the field of a phone held to the reader. */
+
+/**@brief Fill in the advertising modes.
+ *
+ * @param[in,out] p_config  Modes for ble_advertising_init(); the fast interval is kept.
+ */
+void adv_sched_config(ble_adv_modes_config_t * p_config);
+
+/**@brief Go back to the fast stage, for example after a card tap. No effect while connected.
+ *
+ * @details Call from the main loop.
+ */
+void adv_sched_kick(void);
+
+/**@brief Pass the events of ble_advertising, from its handler. */
+void adv_sched_on_adv_evt(ble_adv_evt_t ble_adv_evt);
+
+/**@brief Advertise in the slow stage only, e.g. on a low battery; adv_sched_kick() does
+ *        nothing meanwhile. Main loop.
+ */
+void adv_sched_save(bool save);
+
+/**@brief Arm the wake-up sources for system off. Call from the main loop, with the PN532 idle.
+ */
+void adv_sched_sleep_prepare(void);
+
+#endif
@@ -0,0 +1,190 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(APP_RTOS)
+#include "app_rtos.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "app_scheduler.h"
+#include "app_error.h"
+#include "softdevice_handler.h"
+#include "lock_journal.h"
+#include "sd_log.h"
+#include "wdt_sup.h"
+#include <string.h>
+
+#if !APP_SCHEDULER_WITH_NOTIFY
+#error "app_rtos needs APP_SCHEDULER_WITH_NOTIFY"
+#endif
+#if !NRF_MODULE_ENABLED(NRF_PWR_MGMT) || !configUSE_TICKLESS_IDLE
+#error "app_rtos needs NRF_PWR_MGMT_ENABLED and configUSE_TICKLESS_IDLE"
+#endif
+
+#define BLE_TASK_PRIORITY       (configTIMER_TASK_PRIORITY - 1)
+#define RF_TASK_PRIORITY        (configTIMER_TASK_PRIORITY - 2)
+#define STORAGE_TASK_PRIORITY   (configTIMER_TASK_PRIORITY - 3)
+
+STATIC_ASSERT(STORAGE_TASK_PRIORITY > tskIDLE_PRIORITY);
+
+/**@brief Journal entry waiting for the storage task. */
+typedef struct
+{
+    uint8_t type;
+    uint8_t len;
+    uint8_t data[LOCK_JOURNAL_DATA_LEN];
+} journal_req_t;
+
+static TaskHandle_t      m_ble_task;
+static TaskHandle_t      m_rf_task;
+static SemaphoreHandle_t m_main_lock;   /**< What the main loop owned: flash, journal, ACL. */
+static QueueHandle_t     m_journal_q;
+
+
+static void notify(TaskHandle_t task)
+{
+    if ((task == NULL) || (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED))
+    {
+        // The task looks at its work once it first runs.
+        return;
+    }
+
+    if (__get_IPSR() != 0)
+    {
+        BaseType_t yield = pdFALSE;
+
+        vTaskNotifyGiveFromISR(task, &yield);
+        portYIELD_FROM_ISR(yield);
+    }
+    else
+    {
+        UNUSED_RETURN_VALUE(xTaskNotifyGive(task));
+    }
+}
+
+
+void app_sched_notify(void)
+{
+    notify(m_rf_task);
+}
+
+
+uint32_t app_rtos_sd_evt_notify(void)
+{
+    notify(m_ble_task);
+    return NRF_SUCCESS;
+}
+
+
+static void ble_task(void * p_arg)
+{
+    UNUSED_PARAMETER(p_arg);
+
+    for (;;)
+    {
+        intern_softdevice_events_execute();
+        UNUSED_RETURN_VALUE(ulTaskNotifyTake(pdTRUE, portMAX_DELAY));
+    }
+}
+
+
+static void rf_task(void * p_arg)
+{
+    UNUSED_PARAMETER(p_arg);
+
+    for (;;)
+    {
+        UNUSED_RETURN_VALUE(xSemaphoreTake(m_main_lock, portMAX_DELAY));
+#if NRF_MODULE_ENABLED(WDT_SUP)
+        wdt_sup_begin(WDT_SUP_MAIN);
+#endif
+        app_sched_execute();
+#if NRF_MODULE_ENABLED(WDT_SUP)
+        wdt_sup_end(WDT_SUP_MAIN);
+#endif
+        UNUSED_RETURN_VALUE(xSemaphoreGive(m_main_lock));
+
+        // An event put while executing is kept in the count, so none is missed.
+        UNUSED_RETURN_VALUE(ulTaskNotifyTake(pdTRUE, portMAX_DELAY));
+    }
+}
+
+
+static void storage_task(void * p_arg)
+{
+    journal_req_t req;
+
+    UNUSED_PARAMETER(p_arg);
+
+    for (;;)
+    {
+        if (xQueueReceive(m_journal_q, &req, portMAX_DELAY) != pdPASS)
+        {
+            continue;
+        }
+
+        // Holding the lock also keeps the rf task from running the event sd_log_kick() puts
+        // before it is filled in.
+        UNUSED_RETURN_VALUE(xSemaphoreTake(m_main_lock, portMAX_DELAY));
+        UNUSED_RETURN_VALUE(lock_journal_append(req.type, req.data, req.len));
+#if NRF_MODULE_ENABLED(SD_LOG)
+        sd_log_kick();
+#endif
+        UNUSED_RETURN_VALUE(xSemaphoreGive(m_main_lock));
+    }
+}
+
+
+ret_code_t app_rtos_journal_put(uint8_t type, uint8_t const * p_data, uint8_t len)
+{
+    journal_req_t req;
+
+    if (len > LOCK_JOURNAL_DATA_LEN)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    req.type = type;
+    req.len  = len;
+    memcpy(req.data, p_data, len);
+    if (xQueueSend(m_journal_q, &req, 0) != pdPASS)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t app_rtos_init(void)
+{
+    m_main_lock = xSemaphoreCreateMutex();
+    m_journal_q = xQueueCreate(APP_RTOS_JOURNAL_QUEUE_SIZE, sizeof(journal_req_t));
+    if ((m_main_lock == NULL) || (m_journal_q == NULL))
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    if ((xTaskCreate(ble_task, "BLE", APP_RTOS_BLE_STACK_SIZE, NULL,
+                     BLE_TASK_PRIORITY, &m_ble_task) != pdPASS) ||
+        (xTaskCreate(rf_task, "RF", APP_RTOS_RF_STACK_SIZE, NULL,
+                     RF_TASK_PRIORITY, &m_rf_task) != pdPASS) ||
+        (xTaskCreate(storage_task, "STOR", APP_RTOS_STORAGE_STACK_SIZE, NULL,
+                     STORAGE_TASK_PRIORITY, NULL) != pdPASS))
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+    return NRF_SUCCESS;
+}
+
+
+void app_rtos_start(void)
+{
+    // The idle task sleeps with the interrupts masked; a pending one has to wake it.
+    SCB->SCR |= SCB_SCR_SEVONPEND_Msk;
+
+    vTaskStartScheduler();
+
+    // Only back here if the idle or timer task did not fit in the heap.
+    APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
+}
+
+#endif //NRF_MODULE_ENABLED(APP_RTOS)
@@ -0,0 +1,41 @@
+#ifndef __APP_RTOS_H__
+#define __APP_RTOS_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+
+/* FreeRTOS build of the reader, ble_app_uart_freertos: the contexts of the bare metal build
+ * become tasks, highest priority first:
+ *
+ *   timer    FreeRTOS timer task, in place of the RTC1 interrupt: app_timer handlers
+ *   ble      SoftDevice events, in place of the SWI2 interrupt: ble_evt and sys_evt handlers
+ *   rf       app_scheduler, in place of the main loop: the PN532 engine, commands, the ACL
+ *   storage  journal appends, off the card path; the entry goes in a queue and the reader
+ *            answers the next tap at once
+ *   idle     tickless, sleeps in nrf_pwr_mgmt_run() until the next timer or interrupt
+ *
+ * The rf task blocks until an event is put (APP_SCHEDULER_WITH_NOTIFY) instead of polling.
+ * The modules keep their main loop rule: rf and storage share one mutex, so the MX25 bus,
+ * the journal and the ACL are never used by both at once. */
+
+/**@brief Create the tasks, the mutex and the journal queue. Call first thing in main(). */
+ret_code_t app_rtos_init(void);
+
+/**@brief Start the scheduler in place of the main loop. Does not return. */
+void app_rtos_start(void);
+
+/**@brief softdevice_evt_schedule_func_t waking the ble task, for SOFTDEVICE_HANDLER_INIT(). */
+uint32_t app_rtos_sd_evt_notify(void);
+
+/**@brief Queue a journal entry for the storage task, which also kicks sd_log.
+ *
+ * @details Same arguments as lock_journal_append(). Call from the rf task. A full queue
+ *          drops the entry.
+ *
+ * @retval NRF_SUCCESS               Entry queued.
+ * @retval NRF_ERROR_NO_MEM          Queue full.
+ * @retval NRF_ERROR_INVALID_LENGTH  @p len above LOCK_JOURNAL_DATA_LEN.
+ */
+ret_code_t app_rtos_journal_put(uint8_t type, uint8_t const * p_data, uint8_t len);
+
+#endif
@@ -0,0 +1,482 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(BURST_LINK)
+#include "burst_link.h"
+#include "journal_sync.h"
+#include "lock_journal.h"
+#include "pn532_apply.h"
+#include "app_scheduler.h"
+#include "app_util_platform.h"
+#include "nrf_soc.h"
+#include "nrf.h"
+
+#if !NRF_MODULE_ENABLED(JOURNAL_SYNC)
+#error "burst_link needs JOURNAL_SYNC_ENABLED"
+#endif
+
+#if defined(NRF51)
+#define LINK_MODE          RADIO_MODE_MODE_Nrf_1Mbit
+#define LINK_US_PER_BYTE   8
+#else
+#define LINK_MODE          RADIO_MODE_MODE_Nrf_2Mbit
+#define LINK_US_PER_BYTE   4
+#endif
+
+#define LINK_OVERHEAD      (1 + 4 + 1 + 2)  /**< Preamble, address, length and CRC bytes. */
+#define LINK_RAMP_US       140              /**< TXEN or RXEN to READY, with some margin. */
+#define LINK_GUARD_US      200              /**< Left at the end of a slot to stop the radio. */
+#define ACK_LEN            (2 + 4)
+#define DONE_LEN           (2 + 4)
+
+#define Q_MASK             (BURST_LINK_QUEUE_SIZE - 1)
+
+STATIC_ASSERT((BURST_LINK_QUEUE_SIZE & Q_MASK) == 0);
+STATIC_ASSERT(BURST_LINK_QUEUE_SIZE <= 128);
+// journal_sync_pack() fits the first entry in a NUS packet; the length field takes up to 255.
+STATIC_ASSERT((BURST_LINK_PAYLOAD >= BLE_NUS_DEFAULT_DATA_LEN) && (BURST_LINK_PAYLOAD <= 255));
+STATIC_ASSERT(LINK_RAMP_US + (LINK_OVERHEAD + BURST_LINK_PAYLOAD) * LINK_US_PER_BYTE +
+              LINK_RAMP_US + BURST_LINK_ACK_TIMEOUT_US + LINK_GUARD_US < BURST_LINK_SLOT_US);
+
+typedef enum
+{
+    BURST_IDLE,
+    BURST_RUNNING,
+    BURST_CLOSING       /**< Over; the session is being closed. */
+} burst_state_t;
+
+typedef enum
+{
+    RADIO_IDLE,
+    RADIO_TX,
+    RADIO_RX
+} radio_state_t;
+
+typedef struct
+{
+    uint32_t next;                          /**< Seq after the last entry of the packet. */
+    bool     done;                          /**< JOURNAL_SYNC_DONE. */
+    uint8_t  pdu[1 + BURST_LINK_PAYLOAD];   /**< Length field, then the packet. */
+} burst_pkt_t;
+
+static burst_pkt_t                              m_queue[BURST_LINK_QUEUE_SIZE];
+static volatile uint8_t                         m_wr;           /**< Main loop. */
+static volatile uint8_t                         m_rd;           /**< Timeslot. */
+static uint32_t                                 m_packed;       /**< Next entry to pack. */
+static bool                                     m_done_queued;
+static volatile uint32_t                        m_acked;        /**< First entry the gateway does not have. */
+static uint32_t                                 m_resume;       /**< m_acked of the last offload. */
+static volatile burst_state_t                   m_state;
+static volatile bool                            m_fill_queued;
+
+// Timeslot state, touched only from the signal callback.
+static radio_state_t                            m_radio;
+static uint8_t                                  m_ack[1 + ACK_LEN];
+static uint8_t                                  m_slot_tries;
+static uint8_t                                  m_slot_acks;
+static uint8_t                                  m_dead;         /**< Slots in a row without an answer. */
+static volatile bool                            m_finished;
+static nrf_radio_signal_callback_return_param_t m_ret;
+static nrf_radio_request_t                      m_req_earliest;
+static nrf_radio_request_t                      m_req_next;
+
+
+/**@brief Build packets until the queue is full or everything is packed. Main loop. */
+static void fill(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    m_fill_queued = false;
+
+    while ((m_state == BURST_RUNNING) && ((uint8_t)(m_wr - m_rd) < BURST_LINK_QUEUE_SIZE) && !m_done_queued)
+    {
+        burst_pkt_t * p_pkt = &m_queue[m_wr & Q_MASK];
+        uint32_t      head  = lock_journal_head();
+
+        if (m_packed < lock_journal_oldest())
+        {
+            // Overwritten before they went out; the seq of the next packet shows the gap.
+            m_packed = lock_journal_oldest();
+        }
+
+        if (m_packed < head)
+        {
+            p_pkt->pdu[0] = (uint8_t)journal_sync_pack(m_packed, head, &p_pkt->pdu[1],
+                                                       BURST_LINK_PAYLOAD, &p_pkt->next);
+            p_pkt->done   = false;
+            m_packed      = p_pkt->next;
+        }
+        else if ((m_wr == m_rd) && (m_acked >= head))
+        {
+            p_pkt->pdu[0] = DONE_LEN;
+            p_pkt->pdu[1] = JOURNAL_SYNC;
+            p_pkt->pdu[2] = JOURNAL_SYNC_DONE;
+            UNUSED_RETURN_VALUE(uint32_encode(head, &p_pkt->pdu[3]));
+            p_pkt->next   = head;
+            p_pkt->done   = true;
+            m_done_queued = true;
+        }
+        else
+        {
+            break;
+        }
+        m_wr++;
+    }
+}
+
+
+/**@brief The timeslot has taken packets off the queue. */
+void SWI3_IRQHandler(void)
+{
+    if (!m_fill_queued)
+    {
+        m_fill_queued = (app_sched_event_put(NULL, 0, fill) == NRF_SUCCESS);
+    }
+}
+
+
+static uint32_t slot_time(void)
+{
+    NRF_TIMER0->TASKS_CAPTURE[2] = 1;
+    return NRF_TIMER0->CC[2];
+}
+
+
+static uint32_t pcnf1(uint8_t maxlen)
+{
+    return (RADIO_PCNF1_WHITEEN_Enabled << RADIO_PCNF1_WHITEEN_Pos) |
+           (RADIO_PCNF1_ENDIAN_Little   << RADIO_PCNF1_ENDIAN_Pos)  |
+           (4UL                         << RADIO_PCNF1_BALEN_Pos)   |
+           ((uint32_t)maxlen            << RADIO_PCNF1_MAXLEN_Pos);
+}
+
+
+static void radio_setup(void)
+{
+    NRF_RADIO->POWER       = 1;
+    NRF_RADIO->TXPOWER     = (RADIO_TXPOWER_TXPOWER_0dBm << RADIO_TXPOWER_TXPOWER_Pos);
+    NRF_RADIO->FREQUENCY   = BURST_LINK_FREQUENCY;
+    NRF_RADIO->MODE        = (LINK_MODE << RADIO_MODE_MODE_Pos);
+    NRF_RADIO->BASE0       = BURST_LINK_BASE_ADDR;
+    NRF_RADIO->PREFIX0     = BURST_LINK_PREFIX;
+    NRF_RADIO->TXADDRESS   = 0;
+    NRF_RADIO->RXADDRESSES = 1;
+    NRF_RADIO->PCNF0       = (8UL << RADIO_PCNF0_LFLEN_Pos);
+    NRF_RADIO->DATAWHITEIV = BURST_LINK_FREQUENCY & 0x3F;
+    NRF_RADIO->CRCCNF      = (RADIO_CRCCNF_LEN_Two << RADIO_CRCCNF_LEN_Pos);
+    NRF_RADIO->CRCINIT     = 0xFFFFUL;
+    NRF_RADIO->CRCPOLY     = 0x11021UL;
+
+    NRF_RADIO->EVENTS_DISABLED = 0;
+    NRF_RADIO->INTENCLR        = 0xFFFFFFFF;
+    NRF_RADIO->INTENSET        = RADIO_INTENSET_DISABLED_Msk;
+    NVIC_EnableIRQ(RADIO_IRQn);
+
+    // TIMER0 runs at 1 MHz from the start of the slot.
+    NRF_TIMER0->INTENCLR          = 0xFFFFFFFF;
+    NRF_TIMER0->EVENTS_COMPARE[0] = 0;
+    NRF_TIMER0->EVENTS_COMPARE[1] = 0;
+    NRF_TIMER0->CC[0]             = BURST_LINK_SLOT_US - LINK_GUARD_US;
+    NRF_TIMER0->INTENSET          = TIMER_INTENSET_COMPARE0_Msk;
+    NVIC_EnableIRQ(TIMER0_IRQn);
+}
+
+
+static void radio_stop(void)
+{
+    NRF_RADIO->SHORTS = 0;
+    if (NRF_RADIO->STATE != RADIO_STATE_STATE_Disabled)
+    {
+        NRF_RADIO->EVENTS_DISABLED = 0;
+        NRF_RADIO->TASKS_DISABLE   = 1;
+        while (NRF_RADIO->EVENTS_DISABLED == 0)
+        {
+            // A few microseconds.
+        }
+    }
+    NRF_RADIO->EVENTS_DISABLED = 0;
+    NVIC_ClearPendingIRQ(RADIO_IRQn);
+    NRF_TIMER0->INTENCLR = TIMER_INTENCLR_COMPARE1_Msk;
+    m_radio              = RADIO_IDLE;
+}
+
+
+/**@brief Send the packet at the tail of the queue, if its answer fits the slot. */
+static bool tx_next(void)
+{
+    burst_pkt_t const * p_pkt;
+
+    if (m_rd == m_wr)
+    {
+        return false;
+    }
+    p_pkt = &m_queue[m_rd & Q_MASK];
+    if (slot_time() + LINK_RAMP_US + (LINK_OVERHEAD + p_pkt->pdu[0]) * LINK_US_PER_BYTE +
+        LINK_RAMP_US + BURST_LINK_ACK_TIMEOUT_US + LINK_GUARD_US > BURST_LINK_SLOT_US)
+    {
+        return false;
+    }
+
+    m_radio = RADIO_TX;
+    m_slot_tries++;
+    NRF_RADIO->PCNF1           = pcnf1(BURST_LINK_PAYLOAD);
+    NRF_RADIO->PACKETPTR       = (uint32_t)p_pkt->pdu;
+    NRF_RADIO->SHORTS          = RADIO_SHORTS_READY_START_Msk | RADIO_SHORTS_END_DISABLE_Msk |
+                                 RADIO_SHORTS_DISABLED_RXEN_Msk;
+    NRF_RADIO->EVENTS_DISABLED = 0;
+    NRF_RADIO->TASKS_TXEN      = 1;
+    return true;
+}
+
+
+/**@brief The packet is out and the radio ramps up to receive: wait for the answer. */
+static void rx_start(void)
+{
+    m_radio                       = RADIO_RX;
+    NRF_RADIO->SHORTS             = RADIO_SHORTS_READY_START_Msk | RADIO_SHORTS_END_DISABLE_Msk;
+    NRF_RADIO->PCNF1              = pcnf1(ACK_LEN);
+    NRF_RADIO->PACKETPTR          = (uint32_t)m_ack;
+    NRF_TIMER0->EVENTS_COMPARE[1] = 0;
+    NRF_TIMER0->CC[1]             = slot_time() + LINK_RAMP_US + BURST_LINK_ACK_TIMEOUT_US;
+    NRF_TIMER0->INTENSET          = TIMER_INTENSET_COMPARE1_Msk;
+}
+
+
+/**@brief Drop the packets an acknowledgement covers. */
+static void ack_take(void)
+{
+    uint32_t seq;
+
+    if ((m_ack[0] != ACK_LEN) || (m_ack[1] != JOURNAL_SYNC) || (m_ack[2] != JOURNAL_SYNC_ACK))
+    {
+        return;
+    }
+    seq = uint32_decode(&m_ack[3]);
+    if ((seq < m_acked) || (seq > m_queue[(uint8_t)(m_wr - 1) & Q_MASK].next))
+    {
+        return;
+    }
+
+    m_slot_acks++;
+    m_acked = seq;
+    while ((m_rd != m_wr) && (m_queue[m_rd & Q_MASK].next <= seq))
+    {
+        m_finished = m_finished || m_queue[m_rd & Q_MASK].done;
+        m_rd++;
+    }
+    // The SoftDevice may not be called from here; SWI3 schedules the refill.
+    NVIC_SetPendingIRQ(SWI3_IRQn);
+}
+
+
+static void slot_end(void)
+{
+    radio_stop();
+    NRF_TIMER0->INTENCLR = 0xFFFFFFFF;
+
+    if (m_slot_acks > 0)
+    {
+        m_dead = 0;
+    }
+    else if (m_slot_tries > 0)
+    {
+        m_dead++;
+    }
+
+    if (m_finished || (m_dead >= BURST_LINK_GIVE_UP))
+    {
+        m_ret.callback_action = NRF_RADIO_SIGNAL_CALLBACK_ACTION_END;
+    }
+    else
+    {
+        m_ret.callback_action       = NRF_RADIO_SIGNAL_CALLBACK_ACTION_REQUEST_AND_END;
+        m_ret.params.request.p_next = &m_req_next;
+    }
+}
+
+
+static nrf_radio_signal_callback_return_param_t * radio_callback(uint8_t signal_type)
+{
+    m_ret.callback_action = NRF_RADIO_SIGNAL_CALLBACK_ACTION_NONE;
+
+    switch (signal_type)
+    {
+        case NRF_RADIO_CALLBACK_SIGNAL_TYPE_START:
+            radio_setup();
+            m_radio      = RADIO_IDLE;
+            m_slot_tries = 0;
+            m_slot_acks  = 0;
+            if (!tx_next())
+            {
+                slot_end();
+            }
+            break;
+
+        case NRF_RADIO_CALLBACK_SIGNAL_TYPE_TIMER0:
+            if (NRF_TIMER0->EVENTS_COMPARE[0] != 0)
+            {
+                NRF_TIMER0->EVENTS_COMPARE[0] = 0;
+                slot_end();
+            }
+            else if (NRF_TIMER0->EVENTS_COMPARE[1] != 0)
+            {
+                // No answer: send the packet again.
+                NRF_TIMER0->EVENTS_COMPARE[1] = 0;
+                radio_stop();
+                if (!tx_next())
+                {
+                    slot_end();
+                }
+            }
+            break;
+
+        case NRF_RADIO_CALLBACK_SIGNAL_TYPE_RADIO:
+            if (NRF_RADIO->EVENTS_DISABLED == 0)
+            {
+                break;
+            }
+            NRF_RADIO->EVENTS_DISABLED = 0;
+            if (m_radio == RADIO_TX)
+            {
+                rx_start();
+            }
+            else if (m_radio == RADIO_RX)
+            {
+                NRF_TIMER0->INTENCLR = TIMER_INTENCLR_COMPARE1_Msk;
+                m_radio              = RADIO_IDLE;
+                if (NRF_RADIO->CRCSTATUS == 1)
+                {
+                    ack_take();
+                }
+                if (!tx_next())
+                {
+                    slot_end();
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return &m_ret;
+}
+
+
+static void session_close(void)
+{
+    if (m_state == BURST_RUNNING)
+    {
+        m_state = BURST_CLOSING;
+        UNUSED_RETURN_VALUE(sd_radio_session_close());
+    }
+}
+
+
+ret_code_t burst_link_init(void)
+{
+    ret_code_t err_code;
+
+    m_req_earliest.request_type               = NRF_RADIO_REQ_TYPE_EARLIEST;
+    m_req_earliest.params.earliest.hfclk      = NRF_RADIO_HFCLK_CFG_XTAL_GUARANTEED;
+    m_req_earliest.params.earliest.priority   = NRF_RADIO_PRIORITY_NORMAL;
+    m_req_earliest.params.earliest.length_us  = BURST_LINK_SLOT_US;
+    m_req_earliest.params.earliest.timeout_us = NRF_RADIO_EARLIEST_TIMEOUT_MAX_US;
+
+    m_req_next.request_type                   = NRF_RADIO_REQ_TYPE_NORMAL;
+    m_req_next.params.normal.hfclk            = NRF_RADIO_HFCLK_CFG_XTAL_GUARANTEED;
+    m_req_next.params.normal.priority         = NRF_RADIO_PRIORITY_NORMAL;
+    m_req_next.params.normal.distance_us      = BURST_LINK_DISTANCE_US;
+    m_req_next.params.normal.length_us        = BURST_LINK_SLOT_US;
+
+    m_state  = BURST_IDLE;
+    m_resume = 0;
+
+    // Low enough to use the scheduler.
+    err_code = sd_nvic_ClearPendingIRQ(SWI3_IRQn);
+    VERIFY_SUCCESS(err_code);
+    err_code = sd_nvic_SetPriority(SWI3_IRQn, APP_IRQ_PRIORITY_LOW);
+    VERIFY_SUCCESS(err_code);
+    return sd_nvic_EnableIRQ(SWI3_IRQn);
+}
+
+
+ret_code_t burst_link_start(uint32_t cursor, uint32_t * p_from)
+{
+    ret_code_t err_code;
+
+    if (m_state != BURST_IDLE)
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    if (cursor == JOURNAL_SYNC_RESUME)
+    {
+        cursor = m_resume;
+    }
+    cursor = MAX(cursor, lock_journal_oldest());
+    cursor = MIN(cursor, lock_journal_head());
+
+    m_packed      = cursor;
+    m_acked       = cursor;
+    m_wr          = 0;
+    m_rd          = 0;
+    m_done_queued = false;
+    m_finished    = false;
+    m_dead        = 0;
+    *p_from       = cursor;
+
+    err_code = sd_radio_session_open(radio_callback);
+    VERIFY_SUCCESS(err_code);
+    m_state = BURST_RUNNING;
+    fill(NULL, 0);
+
+    err_code = sd_radio_request(&m_req_earliest);
+    if (err_code != NRF_SUCCESS)
+    {
+        session_close();
+    }
+    return err_code;
+}
+
+
+bool burst_link_is_active(void)
+{
+    return (m_state != BURST_IDLE);
+}
+
+
+void burst_link_on_sys_evt(uint32_t sys_evt)
+{
+    if (m_state == BURST_IDLE)
+    {
+        return;
+    }
+
+    switch (sys_evt)
+    {
+        case NRF_EVT_RADIO_BLOCKED:
+        case NRF_EVT_RADIO_CANCELED:
+            // The SoftDevice kept the slot for itself; take the next free one.
+            if ((m_state == BURST_RUNNING) && (sd_radio_request(&m_req_earliest) != NRF_SUCCESS))
+            {
+                session_close();
+            }
+            break;
+
+        case NRF_EVT_RADIO_SIGNAL_CALLBACK_INVALID_RETURN:
+        case NRF_EVT_RADIO_SESSION_IDLE:
+            // Done, or the gateway stopped answering.
+            session_close();
+            break;
+
+        case NRF_EVT_RADIO_SESSION_CLOSED:
+            m_resume = m_acked;
+            m_state  = BURST_IDLE;
+            break;
+
+        default:
+            break;
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(BURST_LINK)
@@ -0,0 +1,54 @@
+#ifndef __BURST_LINK_H__
+#define __BURST_LINK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* The journal offloaded to the gateway over a proprietary radio link, in SoftDevice timeslots
+ * between the BLE events:
+ *
+ *   radio     1 Mbit/s proprietary on the nRF51, 2 Mbit/s on the nRF52, on BURST_LINK_FREQUENCY
+ *             with BURST_LINK_BASE_ADDR and BURST_LINK_PREFIX, an 8-bit length field, whitening
+ *             and a 16-bit CRC
+ *   data      the packets of journal_sync, up to BURST_LINK_PAYLOAD bytes: JOURNAL_SYNC,
+ *             JOURNAL_SYNC_DATA, seq, time, entries; and JOURNAL_SYNC, JOURNAL_SYNC_DONE, head
+ *             once the gateway has everything
+ *   ack       the gateway answers each packet within BURST_LINK_ACK_TIMEOUT_US of its end with
+ *             JOURNAL_SYNC, JOURNAL_SYNC_ACK, seq (LE): it has every entry below seq. A packet
+ *             without an answer is sent again; the packets the ack covers are dropped
+ *   slots     BURST_LINK_SLOT_US long, BURST_LINK_DISTANCE_US apart, as many exchanges in each
+ *             as fit; the SoftDevice moves a slot that would hit a BLE event, so a link to the
+ *             phone goes on meanwhile. A packet is only sent when its answer fits the slot
+ *   queue     BURST_LINK_QUEUE_SIZE packets built ahead in the main loop, since the journal
+ *             shares the SPI bus; the timeslot hands emptied places back through SWI3
+ *
+ * After BURST_LINK_GIVE_UP slots in a row without an answer the gateway is taken to be out of
+ * range and the offload stops; a start resumes it from the last acknowledgement. Needs
+ * JOURNAL_SYNC. */
+
+/**@brief Enable the SWI3 interrupt the timeslot wakes the main loop with. */
+ret_code_t burst_link_init(void);
+
+/**@brief Start an offload. Main loop.
+ *
+ * @param[in]  cursor  First entry wanted, or JOURNAL_SYNC_RESUME for where the last offload
+ *                     since boot was acknowledged.
+ * @param[out] p_from  First entry that will be sent: the cursor, moved up to the oldest entry
+ *                     held and down to the head.
+ *
+ * @retval NRF_SUCCESS              The timeslot session is open and the first slot asked for.
+ * @retval NRF_ERROR_BUSY           An offload runs, or the last one has not closed its session.
+ * @return Any error from sd_radio_session_open() or sd_radio_request().
+ */
+ret_code_t burst_link_start(uint32_t cursor, uint32_t * p_from);
+
+/**@brief Whether an offload runs. */
+bool burst_link_is_active(void);
+
+/**@brief Handle a SoC event: ask again for a slot the SoftDevice could not give, close the
+ *        session when the offload is over. Call from the sys_evt dispatch.
+ */
+void burst_link_on_sys_evt(uint32_t sys_evt);
+
+#endif
@@ -0,0 +1,148 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(CARD_CACHE)
+#include "card_cache.h"
+#include "wall_clock.h"
+#include "app_timer.h"
+#include "ram_budget.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(WALL_CLOCK)
+#error "card_cache ages its session with wall_clock_ticks(), set WALL_CLOCK_ENABLED"
+#endif
+
+#define SESSION_TICKS  APP_TIMER_TICKS(CARD_CACHE_SESSION_MS, APP_TIMER_CONFIG_PRESCALER)
+#define BLOCK_SIZE     16
+
+STATIC_ASSERT(CARD_CACHE_BLOCKS <= UINT8_MAX);
+
+static uint8_t  m_uid[PN532_UID_MAX_LEN];
+static uint8_t  m_uid_len;                          /**< 0 for no session. */
+static uint64_t m_selected;                         /**< wall_clock_ticks() at the last select. */
+static uint8_t  m_count;
+static uint8_t  m_next;                             /**< Slot replaced next when full. */
+static uint8_t  m_block[CARD_CACHE_BLOCKS];
+static uint8_t  m_data[CARD_CACHE_BLOCKS][BLOCK_SIZE];
+
+RAM_BUDGET_REGISTER(m_cache_budget, "cards", sizeof(m_block) + sizeof(m_data), NULL);
+
+
+/**@brief Whether there is a session and it has not run out; one that has is cleared. */
+static bool session_live(void)
+{
+    if (m_uid_len == 0)
+    {
+        return false;
+    }
+    // Not the 24-bit counter: a session idle for a multiple of its wrap would read as live.
+    if (wall_clock_ticks() - m_selected >= SESSION_TICKS)
+    {
+        card_cache_clear();
+        return false;
+    }
+    return true;
+}
+
+
+static int16_t slot_find(uint8_t block)
+{
+    for (uint8_t i = 0; i < m_count; i++)
+    {
+        if (m_block[i] == block)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+void card_cache_clear(void)
+{
+    m_uid_len = 0;
+    m_count   = 0;
+    m_next    = 0;
+}
+
+
+void card_cache_session(uint8_t const * p_uid, uint8_t uid_len)
+{
+    uid_len = MIN(uid_len, PN532_UID_MAX_LEN);
+
+    if (!session_live() || (uid_len != m_uid_len) || (memcmp(p_uid, m_uid, uid_len) != 0))
+    {
+        card_cache_clear();
+        memcpy(m_uid, p_uid, uid_len);
+        m_uid_len = uid_len;
+    }
+    m_selected = wall_clock_ticks();
+}
+
+
+bool card_cache_uid_get(uint8_t * p_uid, uint8_t * p_uid_len)
+{
+    if (!session_live())
+    {
+        return false;
+    }
+    memcpy(p_uid, m_uid, m_uid_len);
+    *p_uid_len = m_uid_len;
+    return true;
+}
+
+
+void card_cache_put(uint8_t block, uint8_t const * p_data)
+{
+    int16_t slot;
+
+    if (m_uid_len == 0)
+    {
+        return;
+    }
+    slot = slot_find(block);
+    if (slot < 0)
+    {
+        if (m_count < CARD_CACHE_BLOCKS)
+        {
+            slot = m_count++;
+        }
+        else
+        {
+            slot   = m_next;
+            m_next = (m_next + 1) % CARD_CACHE_BLOCKS;
+        }
+        m_block[slot] = block;
+    }
+    memcpy(m_data[slot], p_data, BLOCK_SIZE);
+}
+
+
+uint8_t const * card_cache_get(uint8_t block)
+{
+    int16_t slot;
+
+    if (!session_live())
+    {
+        return NULL;
+    }
+    slot = slot_find(block);
+    return (slot < 0) ? NULL : m_data[slot];
+}
+
+
+bool card_cache_range_has(uint8_t first, uint8_t last)
+{
+    if (!session_live())
+    {
+        return false;
+    }
+    for (uint16_t block = first; block <= last; block++)
+    {
+        if (!mifareclassic_IsTrailerBlock(block) && (slot_find((uint8_t)block) < 0))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif //NRF_MODULE_ENABLED(CARD_CACHE)
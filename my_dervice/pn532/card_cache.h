@@ -0,0 +1,47 @@
+#ifndef __CARD_CACHE_H__
+#define __CARD_CACHE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pn532_i2c.h"
+
+/* Classic data blocks read during one tap session, so that the phone reading the same blocks
+ * again (header, then details, then verify) is answered from RAM:
+ *
+ *   session    one card at a time, from the card selected until CARD_CACHE_SESSION_MS after
+ *              the last time it was, or until it is reported removed; another card starts
+ *              a new session
+ *   blocks     CARD_CACHE_BLOCKS of 16 bytes, keyed by block number, the oldest replaced
+ *              when full
+ *   writes     drop the whole cache; the old contents a write reports are never kept
+ *
+ * A hit is not checked against the card: within the session a card that has been taken away
+ * and changed by another reader still reads as before. */
+
+/**@brief Forget the session and all blocks. */
+void card_cache_clear(void);
+
+/**@brief A card has been selected: the session is its own from now on.
+ *
+ * @details The same card as before keeps its blocks and has its session extended; any other
+ *          card starts empty.
+ */
+void card_cache_session(uint8_t const * p_uid, uint8_t uid_len);
+
+/**@brief The card of the session, if it is still running.
+ *
+ * @param[out] p_uid      Receives the UID, PN532_UID_MAX_LEN bytes.
+ * @param[out] p_uid_len  Receives the UID length.
+ */
+bool card_cache_uid_get(uint8_t * p_uid, uint8_t * p_uid_len);
+
+/**@brief Keep a block read from the card of the session. */
+void card_cache_put(uint8_t block, uint8_t const * p_data);
+
+/**@brief A block of the session, NULL if it has not been read. */
+uint8_t const * card_cache_get(uint8_t block);
+
+/**@brief Whether all data blocks from @p first to @p last are kept; trailers do not count. */
+bool card_cache_range_has(uint8_t first, uint8_t last);
+
+#endif
@@ -0,0 +1,273 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(CARD_SCRIPT)
+#include "card_script.h"
+#include <string.h>
+
+#define IMM_LEN  4
+
+/* Operand bytes per opcode; LOAD has its data after them. */
+static uint8_t const m_operands[] =
+{
+    [CARD_SCRIPT_OP_END]   = 0,
+    [CARD_SCRIPT_OP_AUTH]  = 2 + 6,
+    [CARD_SCRIPT_OP_AUTHK] = 1,
+    [CARD_SCRIPT_OP_READ]  = 1,
+    [CARD_SCRIPT_OP_WRITE] = 1,
+    [CARD_SCRIPT_OP_LOAD]  = 2,
+    [CARD_SCRIPT_OP_EMIT]  = 2,
+    [CARD_SCRIPT_OP_UID]   = 0,
+    [CARD_SCRIPT_OP_GET]   = 2,
+    [CARD_SCRIPT_OP_PUT]   = 2,
+    [CARD_SCRIPT_OP_VGET]  = 1,
+    [CARD_SCRIPT_OP_VPUT]  = 2,
+    [CARD_SCRIPT_OP_SET]   = 1 + IMM_LEN,
+    [CARD_SCRIPT_OP_ADD]   = 1 + IMM_LEN,
+    [CARD_SCRIPT_OP_INC]   = 2,
+    [CARD_SCRIPT_OP_DEC]   = 2,
+    [CARD_SCRIPT_OP_SKIP]  = 2 + IMM_LEN + 1,
+    [CARD_SCRIPT_OP_EMITR] = 1,
+    [CARD_SCRIPT_OP_FAIL]  = 1,
+};
+
+
+static bool cond_holds(uint8_t cond, int32_t a, int32_t b, bool * p_holds)
+{
+    switch (cond)
+    {
+        case CARD_SCRIPT_EQ: *p_holds = (a == b); return true;
+        case CARD_SCRIPT_NE: *p_holds = (a != b); return true;
+        case CARD_SCRIPT_LT: *p_holds = (a <  b); return true;
+        case CARD_SCRIPT_GE: *p_holds = (a >= b); return true;
+        case CARD_SCRIPT_GT: *p_holds = (a >  b); return true;
+        case CARD_SCRIPT_LE: *p_holds = (a <= b); return true;
+        default:             return false;
+    }
+}
+
+
+static ret_code_t out_put(card_script_t * p_script, uint8_t const * p_data, uint16_t len)
+{
+    if (len > p_script->out_max - p_script->out_len)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+    memcpy(&p_script->p_out[p_script->out_len], p_data, len);
+    p_script->out_len += len;
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t card_script_run(card_script_t * p_script, uint8_t const * p_code, uint16_t len)
+{
+    uint8_t  buf[CARD_SCRIPT_BUF_LEN] = {0};
+    int32_t  reg[CARD_SCRIPT_REGS]    = {0};
+    uint16_t pc = 0;
+
+    p_script->out_len = 0;
+
+    while (pc < len)
+    {
+        uint8_t         op = p_code[pc];
+        uint8_t const * a  = &p_code[pc + 1];
+        uint16_t        next;
+        ret_code_t      err_code = NRF_SUCCESS;
+
+        p_script->stop = pc;
+        if (op == CARD_SCRIPT_OP_END)
+        {
+            return NRF_SUCCESS;
+        }
+        if ((op >= ARRAY_SIZE(m_operands)) || (pc + 1 + m_operands[op] > len))
+        {
+            return NRF_ERROR_INVALID_DATA;
+        }
+        next = pc + 1 + m_operands[op];
+
+        // Operands are checked where they are used: registers, then buffer ranges.
+        switch (op)
+        {
+            case CARD_SCRIPT_OP_GET:
+            case CARD_SCRIPT_OP_PUT:
+            case CARD_SCRIPT_OP_VGET:
+            case CARD_SCRIPT_OP_VPUT:
+            case CARD_SCRIPT_OP_SET:
+            case CARD_SCRIPT_OP_ADD:
+            case CARD_SCRIPT_OP_EMITR:
+                if (a[0] >= CARD_SCRIPT_REGS)
+                {
+                    return NRF_ERROR_INVALID_DATA;
+                }
+                break;
+
+            case CARD_SCRIPT_OP_INC:
+            case CARD_SCRIPT_OP_DEC:
+            case CARD_SCRIPT_OP_SKIP:
+                if (a[1] >= CARD_SCRIPT_REGS)
+                {
+                    return NRF_ERROR_INVALID_DATA;
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        switch (op)
+        {
+            case CARD_SCRIPT_OP_AUTH:
+            {
+                uint8_t key[6];
+
+                memcpy(key, &a[2], sizeof(key));
+                if (!mifareclassic_AuthenticateBlock(p_script->p_uid, p_script->uid_len, a[1],
+                                                     (a[0] != 0) ? 1 : 0, key))
+                {
+                    err_code = NRF_ERROR_FORBIDDEN;
+                }
+                break;
+            }
+
+            case CARD_SCRIPT_OP_AUTHK:
+                if ((p_script->auth == NULL) ||
+                    !p_script->auth(p_script->p_uid, p_script->uid_len, a[0], p_script->p_context))
+                {
+                    err_code = NRF_ERROR_FORBIDDEN;
+                }
+                break;
+
+            case CARD_SCRIPT_OP_READ:
+                if (!mifareclassic_ReadDataBlock(a[0], buf))
+                {
+                    err_code = NRF_ERROR_INTERNAL;
+                }
+                break;
+
+            case CARD_SCRIPT_OP_WRITE:
+                if (!mifareclassic_WriteDataBlock(a[0], buf))
+                {
+                    err_code = NRF_ERROR_INTERNAL;
+                }
+                break;
+
+            case CARD_SCRIPT_OP_LOAD:
+                if ((a[0] + a[1] > sizeof(buf)) || (next + a[1] > len))
+                {
+                    return NRF_ERROR_INVALID_DATA;
+                }
+                memcpy(&buf[a[0]], &a[2], a[1]);
+                next += a[1];
+                break;
+
+            case CARD_SCRIPT_OP_EMIT:
+                if (a[0] + a[1] > sizeof(buf))
+                {
+                    return NRF_ERROR_INVALID_DATA;
+                }
+                err_code = out_put(p_script, &buf[a[0]], a[1]);
+                break;
+
+            case CARD_SCRIPT_OP_UID:
+                err_code = out_put(p_script, &p_script->uid_len, 1);
+                if (err_code == NRF_SUCCESS)
+                {
+                    err_code = out_put(p_script, p_script->p_uid, p_script->uid_len);
+                }
+                break;
+
+            case CARD_SCRIPT_OP_GET:
+                if (a[1] + IMM_LEN > sizeof(buf))
+                {
+                    return NRF_ERROR_INVALID_DATA;
+                }
+                reg[a[0]] = (int32_t)uint32_decode(&buf[a[1]]);
+                break;
+
+            case CARD_SCRIPT_OP_PUT:
+                if (a[1] + IMM_LEN > sizeof(buf))
+                {
+                    return NRF_ERROR_INVALID_DATA;
+                }
+                UNUSED_RETURN_VALUE(uint32_encode((uint32_t)reg[a[0]], &buf[a[1]]));
+                break;
+
+            case CARD_SCRIPT_OP_VGET:
+                if (!mifareclassic_ValueBlockDecode(buf, &reg[a[0]], NULL))
+                {
+                    err_code = NRF_ERROR_INVALID_STATE;
+                }
+                break;
+
+            case CARD_SCRIPT_OP_VPUT:
+                mifareclassic_ValueBlockEncode(reg[a[0]], a[1], buf);
+                break;
+
+            case CARD_SCRIPT_OP_SET:
+                reg[a[0]] = (int32_t)uint32_decode(&a[1]);
+                break;
+
+            case CARD_SCRIPT_OP_ADD:
+                reg[a[0]] = (int32_t)((uint32_t)reg[a[0]] + uint32_decode(&a[1]));
+                break;
+
+            case CARD_SCRIPT_OP_INC:
+                if (!mifareclassic_Increment(a[0], (uint32_t)reg[a[1]]))
+                {
+                    err_code = NRF_ERROR_INTERNAL;
+                }
+                break;
+
+            case CARD_SCRIPT_OP_DEC:
+                if (!mifareclassic_Decrement(a[0], (uint32_t)reg[a[1]]))
+                {
+                    err_code = NRF_ERROR_INTERNAL;
+                }
+                break;
+
+            case CARD_SCRIPT_OP_SKIP:
+            {
+                bool holds;
+
+                if (!cond_holds(a[0], reg[a[1]], (int32_t)uint32_decode(&a[2]), &holds))
+                {
+                    return NRF_ERROR_INVALID_DATA;
+                }
+                if (holds)
+                {
+                    // May land on the end of the code, which ends the script.
+                    if (next + a[2 + IMM_LEN] > len)
+                    {
+                        return NRF_ERROR_INVALID_DATA;
+                    }
+                    next += a[2 + IMM_LEN];
+                }
+                break;
+            }
+
+            case CARD_SCRIPT_OP_EMITR:
+            {
+                uint8_t value[IMM_LEN];
+
+                err_code = out_put(p_script, value, uint32_encode((uint32_t)reg[a[0]], value));
+                break;
+            }
+
+            case CARD_SCRIPT_OP_FAIL:
+                return (ret_code_t)a[0];
+
+            default:
+                return NRF_ERROR_INVALID_DATA;
+        }
+
+        if (err_code != NRF_SUCCESS)
+        {
+            return err_code;
+        }
+        pc = next;
+    }
+
+    // Ran off the end: an END implied.
+    p_script->stop = len;
+    return NRF_SUCCESS;
+}
+
+#endif //NRF_MODULE_ENABLED(CARD_SCRIPT)
@@ -0,0 +1,93 @@
+#ifndef __CARD_SCRIPT_H__
+#define __CARD_SCRIPT_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+#include "pn532_i2c.h"
+
+/* A sequence of card operations sent as one request and run against the selected card, so a
+ * transaction costs one BLE round trip instead of one per step:
+ *
+ *   code       one opcode byte, then its operands; block numbers, registers and lengths are
+ *              one byte, immediates four bytes little endian
+ *   state      a 16 byte block buffer and CARD_SCRIPT_REGS signed 32 bit registers, all zero
+ *              at the start
+ *   jumps      CARD_SCRIPT_OP_SKIP only goes forward, so every script ends within its length
+ *   result     bytes collected with the EMIT ops, sent as the data of the one response
+ *
+ * Example, take 5 off the purse in value block 8 if there is that much and log it in block 9:
+ *
+ *   AUTH 1 8 <key B>               sector 2 with key B
+ *   READ 8, VGET 0                 r0 = purse
+ *   SKIP GE 0 5 2, FAIL 0x80       not enough: stop with status 0x80
+ *   SET 1 5, DEC 8 1               purse -= 5, on the card
+ *   ADD 0 -5, PUT 0 0, WRITE 9     the new balance at the start of the log block
+ *   EMITR 0, END                   and in the response */
+
+#define CARD_SCRIPT_REGS     4
+#define CARD_SCRIPT_BUF_LEN  16
+
+/**@brief Opcodes, with their operands. */
+typedef enum
+{
+    CARD_SCRIPT_OP_END   = 0x00, /**< -                   Stop, success; also the end of the code. */
+    CARD_SCRIPT_OP_AUTH  = 0x01, /**< key_b block key[6]  Authenticate the sector of block, key A or B. */
+    CARD_SCRIPT_OP_AUTHK = 0x02, /**< block               Authenticate the sector with the keys the lock knows. */
+    CARD_SCRIPT_OP_READ  = 0x03, /**< block               Block into the buffer. */
+    CARD_SCRIPT_OP_WRITE = 0x04, /**< block               Buffer into the block. */
+    CARD_SCRIPT_OP_LOAD  = 0x05, /**< off len data[len]   Bytes into the buffer. */
+    CARD_SCRIPT_OP_EMIT  = 0x06, /**< off len             Buffer bytes to the result. */
+    CARD_SCRIPT_OP_UID   = 0x07, /**< -                   UID length and UID to the result. */
+    CARD_SCRIPT_OP_GET   = 0x08, /**< reg off             Register from 4 buffer bytes. */
+    CARD_SCRIPT_OP_PUT   = 0x09, /**< reg off             Register into 4 buffer bytes. */
+    CARD_SCRIPT_OP_VGET  = 0x0A, /**< reg                 Register from the buffer as a value block. */
+    CARD_SCRIPT_OP_VPUT  = 0x0B, /**< reg addr            Buffer is a value block of the register. */
+    CARD_SCRIPT_OP_SET   = 0x0C, /**< reg imm             Register = imm. */
+    CARD_SCRIPT_OP_ADD   = 0x0D, /**< reg imm             Register += imm. */
+    CARD_SCRIPT_OP_INC   = 0x0E, /**< block reg           Value block += register, on the card. */
+    CARD_SCRIPT_OP_DEC   = 0x0F, /**< block reg           Value block -= register, on the card. */
+    CARD_SCRIPT_OP_SKIP  = 0x10, /**< cond reg imm n      Skip the next n code bytes if register cond imm. */
+    CARD_SCRIPT_OP_EMITR = 0x11, /**< reg                 Register to the result, 4 bytes. */
+    CARD_SCRIPT_OP_FAIL  = 0x12, /**< status              Stop with this status. */
+} card_script_op_t;
+
+/**@brief Conditions of CARD_SCRIPT_OP_SKIP, signed. */
+typedef enum
+{
+    CARD_SCRIPT_EQ,
+    CARD_SCRIPT_NE,
+    CARD_SCRIPT_LT,
+    CARD_SCRIPT_GE,
+    CARD_SCRIPT_GT,
+    CARD_SCRIPT_LE,
+} card_script_cond_t;
+
+/**@brief A run: the card, where the result goes, and where the script stopped. */
+typedef struct
+{
+    uint8_t                    * p_uid;     /**< UID of the selected card. */
+    uint8_t                      uid_len;
+    mifareclassic_auth_handler_t auth;      /**< CARD_SCRIPT_OP_AUTHK, NULL if there is none. */
+    void                       * p_context; /**< Passed to @p auth. */
+    uint8_t                    * p_out;
+    uint16_t                     out_max;
+    uint16_t                     out_len;   /**< Result bytes, set by the run. */
+    uint16_t                     stop;      /**< Offset of the op the script ended at, set by the run. */
+} card_script_t;
+
+/**@brief Run a script against the selected card.
+ *
+ * @details Stops at the first operation that fails; the result keeps what was collected
+ *          before it.
+ *
+ * @retval NRF_SUCCESS             CARD_SCRIPT_OP_END reached.
+ * @retval NRF_ERROR_INVALID_DATA  Unknown opcode, an operand out of range or cut off.
+ * @retval NRF_ERROR_FORBIDDEN     Authentication failed.
+ * @retval NRF_ERROR_INTERNAL      The card did not do a read, write or value operation.
+ * @retval NRF_ERROR_INVALID_STATE CARD_SCRIPT_OP_VGET on a buffer that is no value block.
+ * @retval NRF_ERROR_NO_MEM        The result is full.
+ * @return The status of CARD_SCRIPT_OP_FAIL.
+ */
+ret_code_t card_script_run(card_script_t * p_script, uint8_t const * p_code, uint16_t len);
+
+#endif
@@ -0,0 +1,90 @@
+#include "cmd_reg.h"
+#include "sdk_common.h"
+#include "app_util_platform.h"
+#include <string.h>
+
+#define NO_ENTRY  0xFF
+
+// Create section "cmd_reg_data".
+//lint -esym(526, cmd_reg_dataBase) -esym(526, cmd_reg_dataLimit)
+NRF_SECTION_VARS_CREATE_SECTION(cmd_reg_data, cmd_reg_entry_t const);
+
+#define CMD_REG_GET(i)    NRF_SECTION_VARS_GET((i), cmd_reg_entry_t const, cmd_reg_data)
+#define CMD_REG_COUNT     NRF_SECTION_VARS_COUNT(cmd_reg_entry_t, cmd_reg_data)
+
+static uint8_t           m_index[256];    /**< Entry of each opcode, NO_ENTRY for none. */
+static bool              m_indexed;
+static volatile uint8_t  m_running;       /**< Classes with a handler running. */
+
+STATIC_ASSERT(CMD_REG_CLASS_COUNT <= 8);
+
+
+ret_code_t cmd_reg_init(void)
+{
+    uint32_t count = CMD_REG_COUNT;
+
+    memset(m_index, NO_ENTRY, sizeof(m_index));
+    m_indexed = false;
+    if (count >= NO_ENTRY)
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        cmd_reg_entry_t const * p_entry = CMD_REG_GET(i);
+
+        if ((m_index[p_entry->opcode] != NO_ENTRY) || (p_entry->cls >= CMD_REG_CLASS_COUNT))
+        {
+            return NRF_ERROR_INVALID_DATA;
+        }
+        m_index[p_entry->opcode] = (uint8_t)i;
+    }
+    m_indexed = true;
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t cmd_reg_dispatch(uint8_t * p_cmd, uint16_t len)
+{
+    cmd_reg_entry_t const * p_entry;
+    uint8_t                 bit = 0;
+    bool                    busy;
+    ret_code_t              err_code;
+
+    if ((len == 0) || !m_indexed || (m_index[p_cmd[0]] == NO_ENTRY))
+    {
+        return NRF_ERROR_NOT_SUPPORTED;
+    }
+    p_entry = CMD_REG_GET(m_index[p_cmd[0]]);
+    if (len < p_entry->min_len)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    if (p_entry->cls != CMD_REG_CLASS_NONE)
+    {
+        bit = (uint8_t)(1U << p_entry->cls);
+        CRITICAL_REGION_ENTER();
+        busy = ((m_running & bit) != 0);
+        m_running |= bit;
+        CRITICAL_REGION_EXIT();
+        if (busy)
+        {
+            return NRF_ERROR_BUSY;
+        }
+    }
+
+    err_code = p_entry->handler(p_cmd, len);
+
+    CRITICAL_REGION_ENTER();
+    m_running &= (uint8_t)~bit;
+    CRITICAL_REGION_EXIT();
+    return err_code;
+}
+
+
+bool cmd_reg_has(uint8_t opcode)
+{
+    return m_indexed && (m_index[opcode] != NO_ENTRY);
+}
@@ -0,0 +1,70 @@
+#ifndef __CMD_REG_H__
+#define __CMD_REG_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "section_vars.h"
+
+/* Commands registered by the modules that serve them, with no central switch:
+ *
+ *   entry     opcode, shortest request, class and handler, placed by CMD_REG_REGISTER() next
+ *             to the handler in the linker section cmd_reg_data; a new command is one macro
+ *   table     cmd_reg_init() indexes the section by opcode once, so a request finds its entry
+ *             with one lookup; two entries for one opcode fail the init
+ *   length    a request shorter than the shortest of its entry never reaches the handler
+ *   class     handlers of one class do not nest: a request of a class that is running, from
+ *             an interrupt or from a handler that calls back in, is refused with BUSY */
+
+/**@brief What a handler needs to itself. */
+typedef enum
+{
+    CMD_REG_CLASS_NONE,     /**< Nothing, it may run inside any other handler. */
+    CMD_REG_CLASS_FIELD,    /**< The PN532 and its field. */
+    CMD_REG_CLASS_FLASH,    /**< The MX25 or the FDS pages. */
+    CMD_REG_CLASS_COUNT
+} cmd_reg_class_t;
+
+/**@brief Handler of a request; p_cmd[0] is the opcode, @p len at least the registered minimum. */
+typedef ret_code_t (*cmd_reg_handler_t)(uint8_t * p_cmd, uint16_t len);
+
+typedef struct
+{
+    cmd_reg_handler_t handler;
+    uint8_t           opcode;
+    uint8_t           min_len;    /**< Opcode included. */
+    uint8_t           cls;        /**< cmd_reg_class_t. */
+} cmd_reg_entry_t;
+
+/**@brief Register @p handler for @p opcode; at file scope, in the module of the handler.
+ *
+ * @param[in] name     Name of the entry, unique in the image.
+ * @param[in] opcode   First byte of the request.
+ * @param[in] min_len  Shortest request, opcode included.
+ * @param[in] cls      cmd_reg_class_t.
+ * @param[in] handler  cmd_reg_handler_t.
+ */
+#define CMD_REG_REGISTER(name, opcode, min_len, cls, handler)                        \
+            NRF_SECTION_VARS_REGISTER_VAR(cmd_reg_data, cmd_reg_entry_t const name) = \
+            {(handler), (opcode), (min_len), (cls)}
+
+/**@brief Index the registered commands by opcode.
+ *
+ * @retval NRF_SUCCESS             Ready.
+ * @retval NRF_ERROR_INVALID_DATA  Two entries for one opcode, or more than 255 entries.
+ */
+ret_code_t cmd_reg_init(void);
+
+/**@brief Run the handler of the request in @p p_cmd.
+ *
+ * @retval NRF_ERROR_NOT_SUPPORTED   No command of this opcode.
+ * @retval NRF_ERROR_INVALID_LENGTH  Shorter than the command takes.
+ * @retval NRF_ERROR_BUSY            A handler of its class is running.
+ * @return Otherwise what the handler returned.
+ */
+ret_code_t cmd_reg_dispatch(uint8_t * p_cmd, uint16_t len);
+
+/**@brief Whether a command of @p opcode is registered. */
+bool cmd_reg_has(uint8_t opcode);
+
+#endif
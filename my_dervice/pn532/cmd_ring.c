@@ -0,0 +1,98 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(CMD_RING)
+#include "cmd_ring.h"
+#include <string.h>
+
+#define WRAP_MARK  0   /**< Length byte meaning "the next record starts at offset 0". */
+
+
+ret_code_t cmd_ring_put(cmd_ring_t * p_ring, uint8_t const * p_data, uint16_t len)
+{
+    uint16_t wr   = p_ring->wr;
+    uint16_t rd   = p_ring->rd;
+    uint16_t need = len + 1;
+    uint16_t pos;
+
+    if ((len == 0) || (len > UINT8_MAX))
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    // One byte always stays free so that wr == rd means empty.
+    if (wr >= rd)
+    {
+        uint16_t to_end = p_ring->size - wr;
+
+        if ((need < to_end) || ((need == to_end) && (rd != 0)))
+        {
+            pos = wr;
+        }
+        else if (need < rd)
+        {
+            p_ring->p_buf[wr] = WRAP_MARK;
+            pos = 0;
+        }
+        else
+        {
+            return NRF_ERROR_NO_MEM;
+        }
+    }
+    else if (need < rd - wr)
+    {
+        pos = wr;
+    }
+    else
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    p_ring->p_buf[pos] = (uint8_t)len;
+    memcpy(&p_ring->p_buf[pos + 1], p_data, len);
+
+    pos += need;
+    if (pos == p_ring->size)
+    {
+        pos = 0;
+    }
+    __DMB();
+    p_ring->wr = pos;
+
+    return NRF_SUCCESS;
+}
+
+
+uint8_t const * cmd_ring_peek(cmd_ring_t * p_ring, uint16_t * p_len)
+{
+    uint16_t rd = p_ring->rd;
+
+    if (rd == p_ring->wr)
+    {
+        return NULL;
+    }
+    __DMB();
+
+    if (p_ring->p_buf[rd] == WRAP_MARK)
+    {
+        rd         = 0;
+        p_ring->rd = 0;
+    }
+
+    *p_len = p_ring->p_buf[rd];
+    return &p_ring->p_buf[rd + 1];
+}
+
+
+void cmd_ring_release(cmd_ring_t * p_ring)
+{
+    uint16_t rd = p_ring->rd;
+
+    rd += p_ring->p_buf[rd] + 1;
+    if (rd == p_ring->size)
+    {
+        rd = 0;
+    }
+    __DMB();
+    p_ring->rd = rd;
+}
+
+#endif //NRF_MODULE_ENABLED(CMD_RING)
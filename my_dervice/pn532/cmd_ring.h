@@ -0,0 +1,54 @@
+#ifndef __CMD_RING_H__
+#define __CMD_RING_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "nordic_common.h"
+
+/**@brief Single-producer, single-consumer ring of byte records.
+ *
+ * @details The producer (an event handler) only moves wr and the consumer (the main loop) only
+ *          moves rd, so neither side locks interrupts; on the Cortex-M0 halfword loads and stores
+ *          are atomic. Records are kept contiguous, so the consumer works on them in place.
+ */
+typedef struct
+{
+    uint8_t *         p_buf;
+    uint16_t          size;
+    volatile uint16_t wr;   /**< Written by the producer only. */
+    volatile uint16_t rd;   /**< Written by the consumer only. */
+} cmd_ring_t;
+
+/**@brief Define a ring holding record data and one length byte per record.
+ *
+ * @param name  Ring instance name.
+ * @param bytes Buffer size, at most 65535.
+ */
+#define CMD_RING_DEF(name, bytes)                                       \
+    static uint8_t CONCAT_2(name, _buf)[bytes];                         \
+    static cmd_ring_t name = {                                          \
+        .p_buf = CONCAT_2(name, _buf),                                  \
+        .size  = (bytes),                                               \
+    }
+
+/**@brief Producer: append a record of 1 to 255 bytes.
+ *
+ * @retval NRF_SUCCESS               Record queued.
+ * @retval NRF_ERROR_NO_MEM          Not enough contiguous room; nothing was queued.
+ * @retval NRF_ERROR_INVALID_LENGTH  Empty or longer than 255 bytes.
+ */
+ret_code_t cmd_ring_put(cmd_ring_t * p_ring, uint8_t const * p_data, uint16_t len);
+
+/**@brief Consumer: oldest record, left in the ring until @ref cmd_ring_release.
+ *
+ * @param[out] p_len  Record length.
+ *
+ * @return Record data, or NULL if the ring is empty.
+ */
+uint8_t const * cmd_ring_peek(cmd_ring_t * p_ring, uint16_t * p_len);
+
+/**@brief Consumer: free the record returned by @ref cmd_ring_peek. */
+void cmd_ring_release(cmd_ring_t * p_ring);
+
+#endif
@@ -0,0 +1,157 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(CONN_POLICY)
+#include "conn_policy.h"
+#include "ble_conn_params.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+
+#define POLICY_TICKS(ms)  APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+#define SUP_TIMEOUT       MSEC_TO_UNITS(4000, UNIT_10_MS)
+
+typedef enum
+{
+    PROFILE_NONE,   /**< Whatever the central chose. */
+    PROFILE_FAST,
+    PROFILE_IDLE,
+} profile_t;
+
+static ble_gap_conn_params_t const m_profiles[] =
+{
+    [PROFILE_FAST] =
+    {
+        .min_conn_interval = CONN_POLICY_FAST_MIN_INTERVAL,
+        .max_conn_interval = CONN_POLICY_FAST_MAX_INTERVAL,
+        .slave_latency     = 0,
+        .conn_sup_timeout  = SUP_TIMEOUT,
+    },
+    [PROFILE_IDLE] =
+    {
+        .min_conn_interval = CONN_POLICY_IDLE_MIN_INTERVAL,
+        .max_conn_interval = CONN_POLICY_IDLE_MAX_INTERVAL,
+        .slave_latency     = CONN_POLICY_IDLE_LATENCY,
+        .conn_sup_timeout  = SUP_TIMEOUT,
+    },
+};
+
+STATIC_ASSERT(CONN_POLICY_FAST_MAX_INTERVAL < CONN_POLICY_IDLE_MIN_INTERVAL);
+
+APP_TIMER_DEF(m_policy_timer);
+
+static uint16_t         m_conn_handle = BLE_CONN_HANDLE_INVALID;
+static volatile uint8_t m_busy;     /**< CONN_POLICY_CARD, CONN_POLICY_UPLOAD. */
+static profile_t        m_wanted;
+static profile_t        m_asked;    /**< Profile ble_conn_params negotiates or got. */
+
+
+/**@brief Ask for the wanted profile unless it was asked for already. */
+static void profile_request(void)
+{
+    ble_gap_conn_params_t params;
+
+    if ((m_conn_handle == BLE_CONN_HANDLE_INVALID) || (m_wanted == PROFILE_NONE) ||
+        (m_wanted == m_asked))
+    {
+        return;
+    }
+
+    // Its retry timer would send an update request of its own while ours is running.
+    UNUSED_RETURN_VALUE(ble_conn_params_stop());
+
+    params = m_profiles[m_wanted];
+    if (ble_conn_params_change_conn_params(&params) == NRF_SUCCESS)
+    {
+        m_asked = m_wanted;
+    }
+    // Otherwise an update is running (NRF_ERROR_BUSY): asked again when it has finished.
+}
+
+
+/**@brief Profile changes run here, at the priority of the BLE events. */
+static void policy_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    m_wanted = (m_busy != 0) ? PROFILE_FAST : PROFILE_IDLE;
+    profile_request();
+}
+
+
+static void policy_timer_restart(uint32_t ticks)
+{
+    UNUSED_RETURN_VALUE(app_timer_stop(m_policy_timer));
+    UNUSED_RETURN_VALUE(app_timer_start(m_policy_timer, ticks, NULL));
+}
+
+
+void conn_policy_init(void)
+{
+    APP_ERROR_CHECK(app_timer_create(&m_policy_timer, APP_TIMER_MODE_SINGLE_SHOT, policy_timer_handler));
+}
+
+
+void conn_policy_busy(uint8_t source, bool busy)
+{
+    uint8_t before;
+
+    CRITICAL_REGION_ENTER();
+    before = m_busy;
+    m_busy = busy ? (before | source) : (before & ~source);
+    CRITICAL_REGION_EXIT();
+
+    if (m_conn_handle == BLE_CONN_HANDLE_INVALID)
+    {
+        return;
+    }
+    if ((before == 0) && busy)
+    {
+        policy_timer_restart(APP_TIMER_MIN_TIMEOUT_TICKS);
+    }
+    else if ((before != 0) && (m_busy == 0))
+    {
+        // Several requests of one transfer do not make the interval go back and forth.
+        policy_timer_restart(POLICY_TICKS(CONN_POLICY_IDLE_DELAY_MS));
+    }
+}
+
+
+void conn_policy_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    ble_gap_evt_t const * p_gap_evt = &p_ble_evt->evt.gap_evt;
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            if (p_gap_evt->params.connected.role != BLE_GAP_ROLE_PERIPH)
+            {
+                break;
+            }
+            // The central's parameters serve the service discovery.
+            m_conn_handle = p_gap_evt->conn_handle;
+            m_wanted      = PROFILE_NONE;
+            m_asked       = PROFILE_NONE;
+            policy_timer_restart(POLICY_TICKS(CONN_POLICY_IDLE_DELAY_MS));
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            if (p_gap_evt->conn_handle != m_conn_handle)
+            {
+                break;
+            }
+            m_conn_handle = BLE_CONN_HANDLE_INVALID;
+            m_busy        = 0;
+            UNUSED_RETURN_VALUE(app_timer_stop(m_policy_timer));
+            break;
+
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+            if (p_gap_evt->conn_handle == m_conn_handle)
+            {
+                profile_request();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(CONN_POLICY)
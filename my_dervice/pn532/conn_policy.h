@@ -0,0 +1,36 @@
+#ifndef __CONN_POLICY_H__
+#define __CONN_POLICY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ble.h"
+
+/* Connection parameters that follow the work on the link, on top of ble_conn_params.
+ *
+ * While any source is busy the peripheral asks for the fast profile (CONN_POLICY_FAST_*,
+ * 7.5 ms intervals, no slave latency). CONN_POLICY_IDLE_DELAY_MS after the last source is done,
+ * and as long after connecting, it asks for the idle profile (CONN_POLICY_IDLE_*), whose slave
+ * latency lets the radio skip connection events without holding up notifications.
+ *
+ * ble_conn_params only renegotiates when the interval is out of range, so both profiles have
+ * interval ranges of their own. A central that refuses a profile keeps its parameters, so
+ * BLE_CONN_PARAMS_EVT_FAILED must not end the link. */
+
+/**@brief Work that wants a fast link. */
+#define CONN_POLICY_CARD    0x01  /**< Card dump or write streaming to the phone. */
+#define CONN_POLICY_UPLOAD  0x02  /**< Whitelist upload from the phone. */
+#define CONN_POLICY_HID     0x04  /**< hid_wedge typing. */
+
+/**@brief Create the idle timer.
+ *
+ * @note Requires app_timer to be initialized.
+ */
+void conn_policy_init(void);
+
+/**@brief Mark a source busy or done. Call from the main loop or the BLE event handler. */
+void conn_policy_busy(uint8_t source, bool busy);
+
+/**@brief Follow the connection: call after ble_conn_params_on_ble_evt(). */
+void conn_policy_on_ble_evt(ble_evt_t * p_ble_evt);
+
+#endif
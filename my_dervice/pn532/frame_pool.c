@@ -0,0 +1,46 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(FRAME_POOL)
+#include "frame_pool.h"
+#include "nrf_balloc.h"
+#include "pn532_i2c.h"
+#include "ram_budget.h"
+
+STATIC_ASSERT(PN532_TWI_MAX_READ + 1 <= FRAME_POOL_BLOCK_SIZE);
+
+NRF_BALLOC_DEF(m_frame_pool, FRAME_POOL_BLOCK_SIZE, FRAME_POOL_SIZE);
+
+
+static uint16_t pool_peak_get(void)
+{
+    return nrf_balloc_max_utilization_get(&m_frame_pool) * FRAME_POOL_BLOCK_SIZE;
+}
+RAM_BUDGET_REGISTER(m_pool_budget, "frames", FRAME_POOL_SIZE * FRAME_POOL_BLOCK_SIZE, pool_peak_get);
+
+
+ret_code_t frame_pool_init(void)
+{
+    return nrf_balloc_init(&m_frame_pool);
+}
+
+
+uint8_t * frame_pool_alloc(void)
+{
+    return (uint8_t *)nrf_balloc_alloc(&m_frame_pool);
+}
+
+
+void frame_pool_free(uint8_t * p_frame)
+{
+    if (p_frame != NULL)
+    {
+        nrf_balloc_free(&m_frame_pool, p_frame);
+    }
+}
+
+
+uint8_t frame_pool_max_utilization_get(void)
+{
+    return nrf_balloc_max_utilization_get(&m_frame_pool);
+}
+
+#endif //NRF_MODULE_ENABLED(FRAME_POOL)
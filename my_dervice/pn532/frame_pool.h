@@ -0,0 +1,28 @@
+#ifndef __FRAME_POOL_H__
+#define __FRAME_POOL_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+
+#define FRAME_POOL_BLOCK_SIZE  256   /**< One full bus read (status byte and PN532_TWI_MAX_READ) rounded up. */
+
+/**@brief Set up the pool of FRAME_POOL_SIZE frame buffers. */
+ret_code_t frame_pool_init(void);
+
+/**@brief Take a frame buffer of FRAME_POOL_BLOCK_SIZE bytes.
+ *
+ * @details Frame buffers are only held for the length of one operation (a card exchange, a
+ *          poll, a flash read) and handed back with @ref frame_pool_free by whoever ends it, so
+ *          modules that are never busy at the same time share the same RAM. Interrupt safe.
+ *
+ * @return The buffer, NULL if all are held.
+ */
+uint8_t * frame_pool_alloc(void);
+
+/**@brief Hand a buffer from @ref frame_pool_alloc back. */
+void frame_pool_free(uint8_t * p_frame);
+
+/**@brief Most buffers held at once since frame_pool_init(), for sizing FRAME_POOL_SIZE. */
+uint8_t frame_pool_max_utilization_get(void);
+
+#endif
@@ -0,0 +1,525 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(GW_PUSH)
+#include "gw_push.h"
+#include "ble_db_discovery.h"
+#include "ble_nus_c.h"
+#include "ble_hci.h"
+#include "lock_journal.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "fds.h"
+#include "passback.h"
+#include <string.h>
+
+#define GW_TICKS(ms)         APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+#define GW_ENTRY_MAX_LEN     (4 + 4 + 1 + LOCK_JOURNAL_DATA_LEN)
+#define GW_ACK_LEN           4
+
+#define GW_SCAN_INTERVAL     0x00A0                             /**< 100 ms. */
+#define GW_SCAN_WINDOW       0x0050                             /**< 50 ms. */
+#define GW_MIN_CONN_INTERVAL MSEC_TO_UNITS(7.5, UNIT_1_25_MS)
+#define GW_MAX_CONN_INTERVAL MSEC_TO_UNITS(30, UNIT_1_25_MS)
+#define GW_SUP_TIMEOUT       MSEC_TO_UNITS(4000, UNIT_10_MS)
+
+#if !NRF_MODULE_ENABLED(LOCK_JOURNAL) || !NRF_MODULE_ENABLED(BLE_DB_DISCOVERY) || !NRF_MODULE_ENABLED(BLE_NUS_C)
+#error "gw_push needs LOCK_JOURNAL, BLE_DB_DISCOVERY and BLE_NUS_C"
+#endif
+
+STATIC_ASSERT(GW_ENTRY_MAX_LEN <= BLE_NUS_MAX_DATA_LEN);
+
+typedef enum
+{
+    GW_STATE_IDLE,
+    GW_STATE_CONNECTING,
+    GW_STATE_SETUP,         /**< Discovery or the CCCD write. */
+    GW_STATE_PUSHING,
+} gw_state_t;
+
+/**@brief What survives a reset, in one FDS record. */
+typedef struct
+{
+    uint32_t acked;     /**< First entry the gateway has not confirmed. */
+} gw_record_t;
+
+STATIC_ASSERT(sizeof(gw_record_t) % sizeof(uint32_t) == 0);
+
+APP_TIMER_DEF(m_interval_timer);
+APP_TIMER_DEF(m_link_timer);
+
+static ble_nus_c_t        m_nus_c;
+static ble_db_discovery_t m_db_disc;
+static ble_gap_addr_t     m_gw_addr;
+
+static volatile gw_state_t m_state = GW_STATE_IDLE;
+static uint16_t            m_conn_handle = BLE_CONN_HANDLE_INVALID;
+static uint32_t            m_sent;          /**< Next entry to write. */
+static uint32_t            m_wait;          /**< After the last entry written. */
+static volatile uint32_t   m_ack;           /**< Last confirmation of this connection. */
+static volatile bool       m_pump_queued;
+
+__ALIGN(4) static gw_record_t m_record;
+static fds_record_desc_t      m_desc;
+static bool                   m_record_found;
+static volatile bool          m_dirty;
+static bool                   m_write_pending;
+
+
+static void record_load(void)
+{
+    fds_find_token_t   token = {0};
+    fds_flash_record_t record;
+
+    if (fds_record_find(GW_PUSH_FILE_ID, GW_PUSH_RECORD_KEY, &m_desc, &token) != FDS_SUCCESS)
+    {
+        return;
+    }
+    m_record_found = true;
+
+    if (fds_record_open(&m_desc, &record) != FDS_SUCCESS)
+    {
+        return;
+    }
+    if (record.p_header->tl.length_words == BYTES_TO_WORDS(sizeof(m_record)))
+    {
+        memcpy(&m_record, record.p_data, sizeof(m_record));
+    }
+    (void)fds_record_close(&m_desc);
+}
+
+
+static void record_store(void)
+{
+    fds_record_chunk_t chunk;
+    fds_record_t       record;
+    ret_code_t         err_code;
+
+    chunk.p_data       = &m_record;
+    chunk.length_words = BYTES_TO_WORDS(sizeof(m_record));
+
+    record.file_id         = GW_PUSH_FILE_ID;
+    record.key             = GW_PUSH_RECORD_KEY;
+    record.data.p_chunks   = &chunk;
+    record.data.num_chunks = 1;
+
+    m_dirty = false;
+    if (m_record_found)
+    {
+        err_code = fds_record_update(&m_desc, &record);
+    }
+    else
+    {
+        err_code = fds_record_write(&m_desc, &record);
+    }
+
+    if (err_code == FDS_SUCCESS)
+    {
+        m_write_pending = true;
+    }
+    else if (err_code == FDS_ERR_NO_SPACE_IN_FLASH)
+    {
+        m_dirty         = true;
+        m_write_pending = (fds_gc() == FDS_SUCCESS);
+    }
+    else
+    {
+        m_dirty = true;
+    }
+}
+
+
+static void fds_evt_handler(fds_evt_t const * const p_evt)
+{
+    switch (p_evt->id)
+    {
+        case FDS_EVT_INIT:
+            if (p_evt->result == FDS_SUCCESS)
+            {
+                record_load();
+            }
+            break;
+
+        case FDS_EVT_WRITE:
+        case FDS_EVT_UPDATE:
+            if ((p_evt->write.file_id != GW_PUSH_FILE_ID) ||
+                (p_evt->write.record_key != GW_PUSH_RECORD_KEY))
+            {
+                break;
+            }
+            m_write_pending = false;
+            if (p_evt->result == FDS_SUCCESS)
+            {
+                m_record_found = true;
+            }
+            else
+            {
+                m_dirty = true;
+            }
+            break;
+
+        case FDS_EVT_GC:
+            if (m_write_pending && m_dirty)
+            {
+                m_write_pending = false;
+                record_store();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+static void link_timer_restart(void)
+{
+    UNUSED_RETURN_VALUE(app_timer_stop(m_link_timer));
+    UNUSED_RETURN_VALUE(app_timer_start(m_link_timer, GW_TICKS(GW_PUSH_LINK_TIMEOUT_MS), NULL));
+}
+
+
+static void disconnect(void)
+{
+    if (m_conn_handle != BLE_CONN_HANDLE_INVALID)
+    {
+        // NRF_ERROR_INVALID_STATE once the link is already going down.
+        UNUSED_RETURN_VALUE(sd_ble_gap_disconnect(m_conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION));
+    }
+}
+
+
+/**@brief Write the entries the link takes, in the main loop: the journal shares the SPI bus. */
+static void pump(void * p_event_data, uint16_t event_size)
+{
+    lock_journal_entry_t entry;
+    uint8_t              buf[GW_ENTRY_MAX_LEN];
+    uint8_t              len;
+    ret_code_t           err_code;
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    m_pump_queued = false;
+
+    while ((m_state == GW_STATE_PUSHING) && (m_sent != lock_journal_head()))
+    {
+        if (m_sent < lock_journal_oldest())
+        {
+            // Overwritten before the gateway got them.
+            m_sent = lock_journal_oldest();
+            continue;
+        }
+
+        err_code = lock_journal_read(m_sent, &entry);
+        if (err_code != NRF_SUCCESS)
+        {
+            // Torn by a reset; there is nothing to send for it.
+            m_sent++;
+            continue;
+        }
+
+        len  = uint32_encode(entry.seq, buf);
+        len += uint32_encode(entry.time, &buf[len]);
+        buf[len++] = entry.type;
+        memcpy(&buf[len], entry.data, entry.len);
+        len += entry.len;
+
+        if (ble_nus_c_string_send(&m_nus_c, buf, len) != NRF_SUCCESS)
+        {
+            // No buffers left: BLE_EVT_TX_COMPLETE runs this again.
+            break;
+        }
+        m_sent++;
+        m_wait = m_sent;
+    }
+
+    if ((m_state == GW_STATE_PUSHING) && (m_sent == lock_journal_head()) && (m_ack >= m_wait))
+    {
+        if (m_record.acked != m_sent)
+        {
+            m_record.acked = m_sent;
+            m_dirty        = true;
+        }
+        disconnect();
+    }
+
+    if ((m_state == GW_STATE_IDLE) && m_dirty && !m_write_pending)
+    {
+        record_store();
+    }
+}
+
+
+static void pump_schedule(void)
+{
+    if (!m_pump_queued)
+    {
+        m_pump_queued = (app_sched_event_put(NULL, 0, pump) == NRF_SUCCESS);
+    }
+}
+
+
+static void push_start(void)
+{
+    uint32_t head = lock_journal_head();
+
+    // A journal that was wiped starts again below the stored position.
+    if ((m_record.acked > head) || (m_record.acked < lock_journal_oldest()))
+    {
+        m_record.acked = lock_journal_oldest();
+    }
+
+    m_sent  = m_record.acked;
+    m_wait  = m_record.acked;
+    m_ack   = m_record.acked;
+    m_state = GW_STATE_PUSHING;
+    link_timer_restart();
+    pump_schedule();
+}
+
+
+static void interval_timer_handler(void * p_context)
+{
+    ble_gap_scan_params_t scan_params;
+    ble_gap_conn_params_t conn_params;
+
+    UNUSED_PARAMETER(p_context);
+
+    if ((m_state != GW_STATE_IDLE) || (lock_journal_head() == m_record.acked))
+    {
+        return;
+    }
+
+    memset(&scan_params, 0, sizeof(scan_params));
+    scan_params.interval = GW_SCAN_INTERVAL;
+    scan_params.window   = GW_SCAN_WINDOW;
+    scan_params.timeout  = GW_PUSH_SCAN_TIMEOUT_S;
+
+    conn_params.min_conn_interval = GW_MIN_CONN_INTERVAL;
+    conn_params.max_conn_interval = GW_MAX_CONN_INTERVAL;
+    conn_params.slave_latency     = 0;
+    conn_params.conn_sup_timeout  = GW_SUP_TIMEOUT;
+
+#if NRF_MODULE_ENABLED(PASSBACK)
+    // The SoftDevice connects only while it does not scan; passback scans again later.
+    passback_scan_yield();
+#endif
+    // Busy while the SoftDevice scans or connects for another reason: next interval.
+    m_state = GW_STATE_CONNECTING;
+    if (sd_ble_gap_connect(&m_gw_addr, &scan_params, &conn_params) != NRF_SUCCESS)
+    {
+        m_state = GW_STATE_IDLE;
+    }
+}
+
+
+static void link_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    if ((m_state == GW_STATE_SETUP) || (m_state == GW_STATE_PUSHING))
+    {
+        disconnect();
+    }
+}
+
+
+static void nus_c_evt_handler(ble_nus_c_t * p_nus_c, ble_nus_c_evt_t const * p_evt)
+{
+    switch (p_evt->evt_type)
+    {
+        case BLE_NUS_C_EVT_DISCOVERY_COMPLETE:
+            if ((p_evt->handles.nus_tx_handle == BLE_GATT_HANDLE_INVALID) ||
+                (p_evt->handles.nus_rx_cccd_handle == BLE_GATT_HANDLE_INVALID))
+            {
+                disconnect();
+                break;
+            }
+            UNUSED_RETURN_VALUE(ble_nus_c_handles_assign(p_nus_c, p_evt->conn_handle, &p_evt->handles));
+            if (ble_nus_c_rx_notif_enable(p_nus_c) != NRF_SUCCESS)
+            {
+                disconnect();
+            }
+            break;
+
+        case BLE_NUS_C_EVT_NUS_RX_EVT:
+            if ((p_evt->data_len == GW_ACK_LEN) && (m_state == GW_STATE_PUSHING))
+            {
+                uint32_t ack = uint32_decode(p_evt->p_data);
+
+                if ((ack > m_ack) && (ack <= m_sent))
+                {
+                    m_ack = ack;
+                    link_timer_restart();
+                    pump_schedule();
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+static void db_disc_handler(ble_db_discovery_evt_t * p_evt)
+{
+    if (p_evt->evt_type == BLE_DB_DISCOVERY_COMPLETE)
+    {
+        ble_nus_c_on_db_disc_evt(&m_nus_c, p_evt);
+    }
+    else if ((p_evt->evt_type == BLE_DB_DISCOVERY_SRV_NOT_FOUND) ||
+             (p_evt->evt_type == BLE_DB_DISCOVERY_ERROR))
+    {
+        disconnect();
+    }
+}
+
+
+/**@brief The CCCD write answers whether the handles are right, cached or discovered. */
+static void on_write_rsp(ble_gattc_evt_t const * p_gattc_evt)
+{
+    if ((m_state != GW_STATE_SETUP) ||
+        (p_gattc_evt->params.write_rsp.handle != m_nus_c.handles.nus_rx_cccd_handle))
+    {
+        return;
+    }
+
+    if (p_gattc_evt->gatt_status == BLE_GATT_STATUS_SUCCESS)
+    {
+        push_start();
+    }
+    else
+    {
+        // Handles of a table that has changed unannounced: discovered anew next interval.
+        UNUSED_RETURN_VALUE(ble_db_discovery_cache_drop(&m_gw_addr));
+        disconnect();
+    }
+}
+
+
+static void on_connected(ble_gap_evt_t const * p_gap_evt)
+{
+    m_conn_handle = p_gap_evt->conn_handle;
+    m_state       = GW_STATE_SETUP;
+    memset(&m_db_disc, 0, sizeof(m_db_disc));
+    link_timer_restart();
+
+    // Handles cached for the gateway come back at once, as a discovery would.
+    UNUSED_RETURN_VALUE(ble_nus_c_handles_assign(&m_nus_c, m_conn_handle, NULL));
+    if (ble_db_discovery_cached_start(&m_db_disc, m_conn_handle, &m_gw_addr) != NRF_SUCCESS)
+    {
+        disconnect();
+    }
+}
+
+
+/**@brief Whether an event belongs to the gateway link, or to its connection attempt. */
+static bool evt_is_gw(ble_evt_t const * p_ble_evt)
+{
+    ble_gap_evt_t const * p_gap_evt = &p_ble_evt->evt.gap_evt;
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            return (p_gap_evt->params.connected.role == BLE_GAP_ROLE_CENTRAL);
+
+        case BLE_GAP_EVT_TIMEOUT:
+            return (p_gap_evt->params.timeout.src == BLE_GAP_TIMEOUT_SRC_CONN);
+
+        default:
+            // The connection handle leads every event structure.
+            return (m_conn_handle != BLE_CONN_HANDLE_INVALID) &&
+                   (p_gap_evt->conn_handle == m_conn_handle);
+    }
+}
+
+
+ret_code_t gw_push_init(void)
+{
+    ble_nus_c_init_t nus_c_init;
+    ret_code_t       err_code;
+
+    m_gw_addr.addr_type = GW_PUSH_ADDR_TYPE;
+    UNUSED_RETURN_VALUE(uint32_encode(GW_PUSH_ADDR_LOW, &m_gw_addr.addr[0]));
+    UNUSED_RETURN_VALUE(uint16_encode(GW_PUSH_ADDR_HIGH, &m_gw_addr.addr[4]));
+
+    memset(&m_record, 0, sizeof(m_record));
+
+    err_code = ble_db_discovery_init(db_disc_handler);
+    VERIFY_SUCCESS(err_code);
+
+    nus_c_init.evt_handler = nus_c_evt_handler;
+    err_code = ble_nus_c_init(&m_nus_c, &nus_c_init);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = app_timer_create(&m_interval_timer, APP_TIMER_MODE_REPEATED, interval_timer_handler);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = app_timer_create(&m_link_timer, APP_TIMER_MODE_SINGLE_SHOT, link_timer_handler);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = fds_register(fds_evt_handler);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = fds_init();
+    VERIFY_SUCCESS(err_code);
+
+    return app_timer_start(m_interval_timer, GW_TICKS(GW_PUSH_INTERVAL_S * 1000), NULL);
+}
+
+
+bool gw_push_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    if (!evt_is_gw(p_ble_evt))
+    {
+        return false;
+    }
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            on_connected(&p_ble_evt->evt.gap_evt);
+            break;
+
+        case BLE_GAP_EVT_TIMEOUT:
+            m_state = GW_STATE_IDLE;
+            break;
+
+        case BLE_GATTC_EVT_WRITE_RSP:
+            on_write_rsp(&p_ble_evt->evt.gattc_evt);
+            break;
+
+        case BLE_EVT_TX_COMPLETE:
+            pump_schedule();
+            break;
+
+        case BLE_GATTC_EVT_TIMEOUT:
+            disconnect();
+            break;
+
+        default:
+            break;
+    }
+
+    ble_db_discovery_on_ble_evt(&m_db_disc, p_ble_evt);
+    ble_nus_c_on_ble_evt(&m_nus_c, p_ble_evt);
+
+    if (p_ble_evt->header.evt_id == BLE_GAP_EVT_DISCONNECTED)
+    {
+        UNUSED_RETURN_VALUE(app_timer_stop(m_link_timer));
+        if ((m_state == GW_STATE_PUSHING) && (m_ack > m_record.acked))
+        {
+            // Cut off early: keep what was confirmed so far.
+            m_record.acked = m_ack;
+            m_dirty        = true;
+        }
+        m_conn_handle = BLE_CONN_HANDLE_INVALID;
+        m_state       = GW_STATE_IDLE;
+        // Stores the record once the main loop gets here.
+        pump_schedule();
+    }
+
+    return true;
+}
+
+#endif //NRF_MODULE_ENABLED(GW_PUSH)
@@ -0,0 +1,36 @@
+#ifndef __GW_PUSH_H__
+#define __GW_PUSH_H__
+
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "ble.h"
+
+/* The journal pushed to a fixed gateway, the lock acting as a NUS client in the central role:
+ *
+ *   interval    every GW_PUSH_INTERVAL_S, with entries the gateway has not confirmed, the lock
+ *               connects to GW_PUSH_ADDR, scanning for up to GW_PUSH_SCAN_TIMEOUT_S
+ *   connect     ble_db_discovery_cached_start(): the NUS handles cached for the gateway are
+ *               used as they are, a first connection discovers them; a failed CCCD write
+ *               drops the cache entry for the next interval
+ *   push        one write command per entry, as many as the link takes per connection event:
+ *               seq (LE), time (LE seconds), type, data
+ *   confirm     the gateway notifies the sequence number after the last entry it stored (LE);
+ *               once all are confirmed the lock disconnects and stores the position in FDS
+ *
+ * Nothing is sent while the journal is empty of new entries, and phones are served as
+ * before: the gateway link is a second link, its events kept from the phone handlers. A link
+ * without progress for GW_PUSH_LINK_TIMEOUT_MS is dropped and retried at the next interval. */
+
+/**@brief Register the NUS client and start the interval timer.
+ *
+ * @details Call after ble_stack_init() and lock_journal_init().
+ */
+ret_code_t gw_push_init(void);
+
+/**@brief Handle a BLE event. Call first in the BLE event dispatch.
+ *
+ * @return true if the event belongs to the gateway link and is not for the phone handlers.
+ */
+bool gw_push_on_ble_evt(ble_evt_t * p_ble_evt);
+
+#endif
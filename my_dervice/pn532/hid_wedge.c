@@ -0,0 +1,385 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(HID_WEDGE)
+#include "hid_wedge.h"
+#include "ble_hids.h"
+#include "ble_srv_common.h"
+#include "app_util_platform.h"
+#include "conn_policy.h"
+#include "pn532_i2c.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(BLE_HIDS)
+#error "hid_wedge is a HID over GATT keyboard, set BLE_HIDS_ENABLED"
+#endif
+#if !NRF_MODULE_ENABLED(PEER_BOND)
+#error "hosts only take keyboard reports over an encrypted link, set PEER_BOND_ENABLED"
+#endif
+
+#define REPORT_LEN        8         /**< Modifiers, reserved, six keys: the boot keyboard report. */
+#define LED_REPORT_LEN    1
+#define KEY_SHIFT         0x80      /**< In a key of the queue: with left shift. */
+#define MOD_LEFT_SHIFT    0x02
+#define KEY_ENTER         0x28
+#define KEY_TAB           0x2B
+
+#define QUEUE_MASK        (HID_WEDGE_QUEUE_SIZE - 1)
+
+STATIC_ASSERT((HID_WEDGE_QUEUE_SIZE & QUEUE_MASK) == 0);
+STATIC_ASSERT(HID_WEDGE_QUEUE_SIZE <= 256);
+
+/**@brief Key of each printable ASCII character on the US layout, from the space on. */
+static uint8_t const m_ascii[] =
+{
+    0x2C, 0x9E, 0xB4, 0xA0, 0xA1, 0xA2, 0xA4, 0x34,   /*   ! " # $ % & ' */
+    0xA6, 0xA7, 0xA5, 0xAE, 0x36, 0x2D, 0x37, 0x38,   /* ( ) * + , - . / */
+    0x27, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24,   /* 0 1 2 3 4 5 6 7 */
+    0x25, 0x26, 0xB3, 0x33, 0xB6, 0x2E, 0xB7, 0xB8,   /* 8 9 : ; < = > ? */
+    0x9F, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A,   /* @ A B C D E F G */
+    0x8B, 0x8C, 0x8D, 0x8E, 0x8F, 0x90, 0x91, 0x92,   /* H I J K L M N O */
+    0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A,   /* P Q R S T U V W */
+    0x9B, 0x9C, 0x9D, 0x2F, 0x31, 0x30, 0xA3, 0xAD,   /* X Y Z [ \ ] ^ _ */
+    0x35, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A,   /* ` a b c d e f g */
+    0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12,   /* h i j k l m n o */
+    0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A,   /* p q r s t u v w */
+    0x1B, 0x1C, 0x1D, 0xAF, 0xB1, 0xB0, 0xB5,         /* x y z { | } ~ */
+};
+
+/**@brief The boot keyboard of the HID specification, appendix B.1. */
+static uint8_t m_report_map[] =
+{
+    0x05, 0x01,       // Usage Page (Generic Desktop)
+    0x09, 0x06,       // Usage (Keyboard)
+    0xA1, 0x01,       // Collection (Application)
+    0x05, 0x07,       //   Usage Page (Key Codes)
+    0x19, 0xE0,       //   Usage Minimum (224)
+    0x29, 0xE7,       //   Usage Maximum (231)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x25, 0x01,       //   Logical Maximum (1)
+    0x75, 0x01,       //   Report Size (1)
+    0x95, 0x08,       //   Report Count (8)
+    0x81, 0x02,       //   Input (Data, Variable, Absolute): modifiers
+    0x95, 0x01,       //   Report Count (1)
+    0x75, 0x08,       //   Report Size (8)
+    0x81, 0x01,       //   Input (Constant): reserved
+    0x95, 0x05,       //   Report Count (5)
+    0x75, 0x01,       //   Report Size (1)
+    0x05, 0x08,       //   Usage Page (LEDs)
+    0x19, 0x01,       //   Usage Minimum (1)
+    0x29, 0x05,       //   Usage Maximum (5)
+    0x91, 0x02,       //   Output (Data, Variable, Absolute): LEDs
+    0x95, 0x01,       //   Report Count (1)
+    0x75, 0x03,       //   Report Size (3)
+    0x91, 0x01,       //   Output (Constant): padding
+    0x95, 0x06,       //   Report Count (6)
+    0x75, 0x08,       //   Report Size (8)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x25, 0x65,       //   Logical Maximum (101)
+    0x05, 0x07,       //   Usage Page (Key Codes)
+    0x19, 0x00,       //   Usage Minimum (0)
+    0x29, 0x65,       //   Usage Maximum (101)
+    0x81, 0x00,       //   Input (Data, Array): keys
+    0xC0              // End Collection
+};
+
+static ble_hids_t m_hids;
+static bool       m_boot;                           /**< The host runs the boot protocol. */
+static uint8_t    m_held;                           /**< Key of the last report, 0 after a release. */
+static uint8_t    m_queue[HID_WEDGE_QUEUE_SIZE];    /**< Keys to type, KEY_SHIFT for shifted ones. */
+static uint8_t    m_head;
+static uint16_t   m_count;
+static bool       m_typing;                         /**< The fast profile is asked for. */
+
+
+static void hids_error_handler(uint32_t nrf_error)
+{
+    APP_ERROR_HANDLER(nrf_error);
+}
+
+
+static void hids_evt_handler(ble_hids_t * p_hids, ble_hids_evt_t * p_evt)
+{
+    UNUSED_PARAMETER(p_hids);
+
+    switch (p_evt->evt_type)
+    {
+        case BLE_HIDS_EVT_BOOT_MODE_ENTERED:
+            m_boot = true;
+            break;
+
+        case BLE_HIDS_EVT_REPORT_MODE_ENTERED:
+            m_boot = false;
+            break;
+
+        default:
+            // The LED report the host writes is not shown.
+            break;
+    }
+}
+
+
+static bool cccd_enabled(uint16_t cccd_handle)
+{
+    uint8_t           cccd[BLE_CCCD_VALUE_LEN];
+    ble_gatts_value_t value;
+
+    value.len     = sizeof(cccd);
+    value.offset  = 0;
+    value.p_value = cccd;
+    if ((m_hids.conn_handle == BLE_CONN_HANDLE_INVALID) ||
+        (sd_ble_gatts_value_get(m_hids.conn_handle, cccd_handle, &value) != NRF_SUCCESS))
+    {
+        return false;
+    }
+    return ble_srv_is_notification_enabled(cccd);
+}
+
+
+bool hid_wedge_is_ready(void)
+{
+    return cccd_enabled(m_boot ? m_hids.boot_kb_inp_rep_handles.cccd_handle
+                               : m_hids.inp_rep_array[0].char_handles.cccd_handle);
+}
+
+
+static uint32_t report_send(uint8_t key)
+{
+    uint8_t report[REPORT_LEN] = {0};
+
+    if (key != 0)
+    {
+        report[0] = (key & KEY_SHIFT) ? MOD_LEFT_SHIFT : 0;
+        report[2] = key & ~KEY_SHIFT;
+    }
+    if (m_boot)
+    {
+        return ble_hids_boot_kb_inp_rep_send(&m_hids, sizeof(report), report);
+    }
+    return ble_hids_inp_rep_send(&m_hids, 0, sizeof(report), report);
+}
+
+
+/**@brief Hand reports to the SoftDevice until it runs out of TX buffers or the queue is empty.
+ *
+ * @details Called with the queue locked, from the thread after queueing and from the BLE event on
+ *          BLE_EVT_TX_COMPLETE.
+ */
+static void queue_pump(void)
+{
+    while ((m_count != 0) || (m_held != 0))
+    {
+        uint8_t  key = (m_count != 0) ? m_queue[m_head] : 0;
+        uint32_t err_code;
+
+        // The same key again only counts as a new press after a release.
+        if ((m_held != 0) && ((key & ~KEY_SHIFT) == (m_held & ~KEY_SHIFT)))
+        {
+            key = 0;
+        }
+
+        err_code = report_send(key);
+        if (err_code == BLE_ERROR_NO_TX_PACKETS)
+        {
+            return;
+        }
+        if (err_code != NRF_SUCCESS)
+        {
+            // The host went away or turned the reports off: what it did not get is lost.
+            m_count = 0;
+            m_held  = 0;
+            break;
+        }
+
+        m_held = key;
+        if (key != 0)
+        {
+            m_head = (uint8_t)((m_head + 1) & QUEUE_MASK);
+            m_count--;
+        }
+    }
+
+    if (m_typing)
+    {
+        m_typing = false;
+#if NRF_MODULE_ENABLED(CONN_POLICY)
+        conn_policy_busy(CONN_POLICY_HID, false);
+#endif
+    }
+}
+
+
+/**@brief Queue @p len keys, all of them or none. */
+static ret_code_t keys_put(uint8_t const * p_keys, uint16_t len)
+{
+    ret_code_t err_code = NRF_SUCCESS;
+
+    if (!hid_wedge_is_ready())
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    CRITICAL_REGION_ENTER();
+    if (m_count + len > HID_WEDGE_QUEUE_SIZE)
+    {
+        err_code = NRF_ERROR_NO_MEM;
+    }
+    else
+    {
+        for (uint16_t i = 0; i < len; i++)
+        {
+            m_queue[(m_head + m_count + i) & QUEUE_MASK] = p_keys[i];
+        }
+        m_count += len;
+        if (!m_typing)
+        {
+            m_typing = true;
+#if NRF_MODULE_ENABLED(CONN_POLICY)
+            conn_policy_busy(CONN_POLICY_HID, true);
+#endif
+        }
+        queue_pump();
+    }
+    CRITICAL_REGION_EXIT();
+
+    return err_code;
+}
+
+
+ret_code_t hid_wedge_type_uid(uint8_t const * p_uid, uint8_t len)
+{
+    static char const hex[] = "0123456789ABCDEF";
+    uint8_t           keys[2 * PN532_UID_MAX_LEN + 1];
+    uint16_t          n = 0;
+
+    len = MIN(len, PN532_UID_MAX_LEN);
+    for (uint8_t i = 0; i < len; i++)
+    {
+        keys[n++] = m_ascii[hex[p_uid[i] >> 4] - ' '];
+        keys[n++] = m_ascii[hex[p_uid[i] & 0x0F] - ' '];
+    }
+#if HID_WEDGE_ENTER
+    keys[n++] = KEY_ENTER;
+#endif
+    return keys_put(keys, n);
+}
+
+
+ret_code_t hid_wedge_type_text(uint8_t const * p_text, uint16_t len)
+{
+    uint8_t  keys[HID_WEDGE_QUEUE_SIZE];
+    uint16_t n = 0;
+
+    for (uint16_t i = 0; (i < len) && (n < sizeof(keys)); i++)
+    {
+        if ((p_text[i] >= ' ') && (p_text[i] <= '~'))
+        {
+            keys[n++] = m_ascii[p_text[i] - ' '];
+        }
+        else if (p_text[i] == '\t')
+        {
+            keys[n++] = KEY_TAB;
+        }
+        else if (p_text[i] == '\n')
+        {
+            keys[n++] = KEY_ENTER;
+        }
+    }
+#if HID_WEDGE_ENTER
+    if (n == sizeof(keys))
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+    keys[n++] = KEY_ENTER;
+#endif
+    return keys_put(keys, n);
+}
+
+
+ret_code_t hid_wedge_init(void)
+{
+    ble_hids_init_t          hids_init;
+    ble_hids_inp_rep_init_t  inp_rep;
+    ble_hids_outp_rep_init_t outp_rep;
+    ret_code_t               err_code;
+
+    memset(&inp_rep, 0, sizeof(inp_rep));
+    inp_rep.max_len             = REPORT_LEN;
+    inp_rep.rep_ref.report_id   = 0;
+    inp_rep.rep_ref.report_type = BLE_HIDS_REP_TYPE_INPUT;
+    BLE_GAP_CONN_SEC_MODE_SET_ENC_NO_MITM(&inp_rep.security_mode.cccd_write_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_ENC_NO_MITM(&inp_rep.security_mode.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(&inp_rep.security_mode.write_perm);
+
+    memset(&outp_rep, 0, sizeof(outp_rep));
+    outp_rep.max_len             = LED_REPORT_LEN;
+    outp_rep.rep_ref.report_id   = 0;
+    outp_rep.rep_ref.report_type = BLE_HIDS_REP_TYPE_OUTPUT;
+    BLE_GAP_CONN_SEC_MODE_SET_ENC_NO_MITM(&outp_rep.security_mode.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_ENC_NO_MITM(&outp_rep.security_mode.write_perm);
+
+    memset(&hids_init, 0, sizeof(hids_init));
+    hids_init.evt_handler                 = hids_evt_handler;
+    hids_init.error_handler               = hids_error_handler;
+    hids_init.is_kb                       = true;
+    hids_init.is_mouse                    = false;
+    hids_init.inp_rep_count               = 1;
+    hids_init.p_inp_rep_array             = &inp_rep;
+    hids_init.outp_rep_count              = 1;
+    hids_init.p_outp_rep_array            = &outp_rep;
+    hids_init.rep_map.p_data              = m_report_map;
+    hids_init.rep_map.data_len            = sizeof(m_report_map);
+    hids_init.hid_information.bcd_hid     = 0x0101;
+    hids_init.hid_information.flags       = HID_INFO_FLAG_REMOTE_WAKE_MSK |
+                                            HID_INFO_FLAG_NORMALLY_CONNECTABLE_MSK;
+    BLE_GAP_CONN_SEC_MODE_SET_ENC_NO_MITM(&hids_init.rep_map.security_mode.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(&hids_init.rep_map.security_mode.write_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_ENC_NO_MITM(&hids_init.hid_information.security_mode.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(&hids_init.hid_information.security_mode.write_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_ENC_NO_MITM(&hids_init.security_mode_boot_kb_inp_rep.cccd_write_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_ENC_NO_MITM(&hids_init.security_mode_boot_kb_inp_rep.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_ENC_NO_MITM(&hids_init.security_mode_boot_kb_outp_rep.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_ENC_NO_MITM(&hids_init.security_mode_boot_kb_outp_rep.write_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_ENC_NO_MITM(&hids_init.security_mode_protocol.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_ENC_NO_MITM(&hids_init.security_mode_protocol.write_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(&hids_init.security_mode_ctrl_point.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_ENC_NO_MITM(&hids_init.security_mode_ctrl_point.write_perm);
+
+    err_code = ble_hids_init(&m_hids, &hids_init);
+    VERIFY_SUCCESS(err_code);
+
+    // Hosts list the lock with their keyboards.
+    return sd_ble_gap_appearance_set(BLE_APPEARANCE_HID_KEYBOARD);
+}
+
+
+void hid_wedge_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    ble_hids_on_ble_evt(&m_hids, p_ble_evt);
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            if (p_ble_evt->evt.gap_evt.conn_handle == m_hids.conn_handle)
+            {
+                // A host starts in report mode.
+                m_boot = false;
+            }
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+        case BLE_EVT_TX_COMPLETE:
+            CRITICAL_REGION_ENTER();
+            if (m_hids.conn_handle == BLE_CONN_HANDLE_INVALID)
+            {
+                m_count = 0;
+                m_held  = 0;
+            }
+            queue_pump();
+            CRITICAL_REGION_EXIT();
+            break;
+
+        default:
+            break;
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(HID_WEDGE)
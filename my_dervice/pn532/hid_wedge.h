@@ -0,0 +1,48 @@
+#ifndef __HID_WEDGE_H__
+#define __HID_WEDGE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "ble.h"
+
+/* The lock as a BLE keyboard that types what it reads, for hosts that expect a keyboard wedge:
+ *
+ *   keyboard  HID over GATT with the boot keyboard reports, so hosts that only speak the boot
+ *             protocol type along; in report mode the same 8-byte report goes out on the input
+ *             report. US layout, printable ASCII, tab and Enter
+ *   batching  a key is one report; a release goes out only before the same key again and after
+ *             the last one, since a report with another key releases the one before. Reports
+ *             are handed to the SoftDevice until it runs out of buffers and refilled on
+ *             BLE_EVT_TX_COMPLETE, so a connection event carries as many as the link buffers
+ *   interval  conn_policy's fast profile from the first key to the last release
+ *
+ * The host bonds first: the reports need an encrypted link, so this needs PEER_BOND. The NUS
+ * notifications go out as before. */
+
+/**@brief Add the HID service. Call from services_init(), after ble_stack_init(). */
+ret_code_t hid_wedge_init(void);
+
+/**@brief Handle a BLE event. Call after ble_conn_params_on_ble_evt(). */
+void hid_wedge_on_ble_evt(ble_evt_t * p_ble_evt);
+
+/**@brief Type a UID in upper case hex, and Enter with HID_WEDGE_ENTER. Call from the main loop.
+ *
+ * @retval NRF_SUCCESS             Queued.
+ * @retval NRF_ERROR_INVALID_STATE No host has the keyboard reports enabled.
+ * @retval NRF_ERROR_NO_MEM        Not enough room in the queue, nothing was queued.
+ */
+ret_code_t hid_wedge_type_uid(uint8_t const * p_uid, uint8_t len);
+
+/**@brief Type text, such as an NDEF Text record, and Enter with HID_WEDGE_ENTER.
+ *
+ * @details Characters without a key on the US layout are left out. Call from the main loop.
+ *
+ * @return As @ref hid_wedge_type_uid.
+ */
+ret_code_t hid_wedge_type_text(uint8_t const * p_text, uint16_t len);
+
+/**@brief Whether a host has the keyboard reports enabled. */
+bool hid_wedge_is_ready(void);
+
+#endif
@@ -0,0 +1,221 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(HOST_SPIS)
+#include "host_spis.h"
+#include "cmd_ring.h"
+#include "nrf_drv_spis.h"
+#include "nrf_gpio.h"
+#include "nrf_delay.h"
+#include "app_scheduler.h"
+#include "app_util_platform.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(CMD_RING)
+#error "HOST_SPIS needs CMD_RING"
+#endif
+#if HOST_SPIS_XFER_LEN > 255
+#error "HOST_SPIS_XFER_LEN must not exceed 255, the EasyDMA MAXCNT"
+#endif
+
+typedef struct
+{
+    uint8_t tx[HOST_SPIS_XFER_LEN];
+    uint8_t rx[HOST_SPIS_XFER_LEN];
+    uint8_t reply_len;      /**< Of the reply in tx, 0 for none. */
+} xfer_t;
+
+CMD_RING_DEF(m_cmd_ring, HOST_SPIS_CMD_RING_SIZE);
+CMD_RING_DEF(m_reply_ring, HOST_SPIS_REPLY_RING_SIZE);
+
+static nrf_drv_spis_t const    m_spis = NRF_DRV_SPIS_INSTANCE(HOST_SPIS_INSTANCE);
+static xfer_t                  m_xfer[2];
+static volatile uint8_t        m_held;          /**< Pair the SPIS holds. */
+static volatile bool           m_swap;          /**< A pair was handed over, not taken yet. */
+static volatile bool           m_overrun;
+static volatile bool           m_pending;       /**< The worker is scheduled. */
+static host_spis_cmd_handler_t m_handler;
+static bool                    m_active;
+
+
+/**@brief Put the oldest reply and the status into a pair. */
+static void xfer_fill(xfer_t * p_xfer)
+{
+    uint16_t        len    = 0;
+    uint8_t const * p_rep  = cmd_ring_peek(&m_reply_ring, &len);
+    uint8_t         status = 0;
+
+    if (p_rep != NULL)
+    {
+        status |= HOST_SPIS_STATUS_REPLY;
+        memcpy(&p_xfer->tx[2], p_rep, len);
+    }
+    if (m_pending || m_active)
+    {
+        status |= HOST_SPIS_STATUS_BUSY;
+    }
+    if (m_overrun)
+    {
+        status   |= HOST_SPIS_STATUS_OVERRUN;
+        m_overrun = false;
+    }
+    p_xfer->tx[0]     = status;
+    p_xfer->tx[1]     = (uint8_t)len;
+    p_xfer->reply_len = (uint8_t)len;
+}
+
+
+/**@brief Give the SPIS the other pair, filled with the next reply. */
+static void xfer_hand_over(void)
+{
+    xfer_t * p_next = &m_xfer[m_held ^ 1];
+
+    xfer_fill(p_next);
+    if (nrf_drv_spis_buffers_set(&m_spis, p_next->tx, sizeof(p_next->tx),
+                                 p_next->rx, sizeof(p_next->rx)) == NRF_SUCCESS)
+    {
+        m_swap = true;
+    }
+}
+
+
+static void worker(void * p_event_data, uint16_t event_size)
+{
+    uint8_t const * p_cmd;
+    uint16_t        len;
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    // Cleared first, so a command queued while draining posts a new event.
+    m_pending = false;
+    while ((p_cmd = cmd_ring_peek(&m_cmd_ring, &len)) != NULL)
+    {
+        m_active = true;
+        m_handler(p_cmd, len);
+        m_active = false;
+        cmd_ring_release(&m_cmd_ring);
+    }
+}
+
+
+/**@brief Queue the command of a finished transaction. */
+static void cmd_put(xfer_t const * p_xfer, uint32_t rx_amount)
+{
+    uint8_t len = p_xfer->rx[0];
+
+    if ((rx_amount == 0) || (len == 0) || (len > HOST_SPIS_CMD_MAX) || (rx_amount < 1u + len))
+    {
+        // A read only, or a command cut short; the host sends it again.
+        return;
+    }
+    if (cmd_ring_put(&m_cmd_ring, &p_xfer->rx[1], len) != NRF_SUCCESS)
+    {
+        m_overrun = true;
+        return;
+    }
+    if (!m_pending)
+    {
+        m_pending = true;
+        if (app_sched_event_put(NULL, 0, worker) != NRF_SUCCESS)
+        {
+            m_pending = false;
+        }
+    }
+}
+
+
+static void spis_evt_handler(nrf_drv_spis_event_t event)
+{
+    switch (event.evt_type)
+    {
+        case NRF_DRV_SPIS_BUFFERS_SET_DONE:
+            if (m_swap)
+            {
+                m_held ^= 1;
+                m_swap  = false;
+            }
+            nrf_gpio_pin_write(HOST_SPIS_IRQ_PIN, m_xfer[m_held].reply_len == 0);
+            break;
+
+        case NRF_DRV_SPIS_XFER_DONE:
+        {
+            xfer_t * p_done = &m_xfer[m_held];
+
+            if ((p_done->reply_len != 0) && (event.tx_amount >= 2u + p_done->reply_len))
+            {
+                cmd_ring_release(&m_reply_ring);
+            }
+            // A swap requested meanwhile is replaced: the same pair is filled again.
+            m_swap = false;
+            xfer_hand_over();
+            cmd_put(p_done, event.rx_amount);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+
+ret_code_t host_spis_init(host_spis_cmd_handler_t handler)
+{
+    nrf_drv_spis_config_t config = NRF_DRV_SPIS_DEFAULT_CONFIG;
+    ret_code_t            err_code;
+
+    VERIFY_PARAM_NOT_NULL(handler);
+    m_handler = handler;
+
+    nrf_gpio_pin_set(HOST_SPIS_IRQ_PIN);
+    nrf_gpio_cfg_output(HOST_SPIS_IRQ_PIN);
+
+    config.sck_pin  = HOST_SPIS_SCK_PIN;
+    config.mosi_pin = HOST_SPIS_MOSI_PIN;
+    config.miso_pin = HOST_SPIS_MISO_PIN;
+    config.csn_pin  = HOST_SPIS_CSN_PIN;
+    config.mode     = (nrf_drv_spis_mode_t)HOST_SPIS_MODE;
+    config.def      = 0x00;
+    config.orc      = 0x00;
+    err_code = nrf_drv_spis_init(&m_spis, &config, spis_evt_handler);
+    VERIFY_SUCCESS(err_code);
+
+    m_held = 1;
+    xfer_hand_over();
+    return NRF_SUCCESS;
+}
+
+
+bool host_spis_active(void)
+{
+    return m_active;
+}
+
+
+ret_code_t host_spis_reply(uint8_t const * p_data, uint16_t len)
+{
+    ret_code_t err_code;
+    uint16_t   waited = 0;
+
+    if ((len == 0) || (len > HOST_SPIS_REPLY_MAX))
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+    while ((err_code = cmd_ring_put(&m_reply_ring, p_data, len)) == NRF_ERROR_NO_MEM)
+    {
+        if (waited++ >= HOST_SPIS_REPLY_WAIT_MS)
+        {
+            return err_code;
+        }
+        nrf_delay_ms(1);
+    }
+
+    // The SPIS holds a pair without a reply: hand it the other one, which shows this one.
+    CRITICAL_REGION_ENTER();
+    if ((m_xfer[m_held].reply_len == 0) && !m_swap)
+    {
+        xfer_hand_over();
+    }
+    CRITICAL_REGION_EXIT();
+    return err_code;
+}
+
+#endif //NRF_MODULE_ENABLED(HOST_SPIS)
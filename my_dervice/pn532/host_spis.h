@@ -0,0 +1,61 @@
+#ifndef __HOST_SPIS_H__
+#define __HOST_SPIS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* Card commands from a host MCU over SPI, with this board as its NFC and BLE co-processor:
+ *
+ *   transaction  HOST_SPIS_XFER_LEN bytes at most, clocked by the host; MOSI carries a length
+ *                byte and a raw command (the bytes of a UART command line), 0 for none; MISO
+ *                carries a status byte, a length byte and the oldest reply, 0 for none
+ *   replies      a reply is taken once the host has clocked all of it; one cut short comes
+ *                again in the next transaction
+ *   IRQ          HOST_SPIS_IRQ_PIN is low while the next transaction carries a reply, so the
+ *                host reads when there is something to read and polls for nothing
+ *   buffers      two buffer pairs: while the host clocks one, the other is filled with the next
+ *                reply and handed to the SPIS as soon as the transaction ends, and the command
+ *                is read out of the finished pair only then, so the slave is back to the host
+ *                within the END interrupt; a reply that comes while the SPIS holds a pair with
+ *                none swaps the pairs at once
+ *   queue        commands run one at a time from the app_scheduler, in the order they came;
+ *                one that finds the queue full is dropped and flagged in the next status byte
+ *
+ * The EasyDMA lists of the nRF51 SPIS take 255 bytes at most. */
+
+#define HOST_SPIS_STATUS_REPLY    0x01  /**< A reply follows. */
+#define HOST_SPIS_STATUS_BUSY     0x02  /**< Commands are queued or running. */
+#define HOST_SPIS_STATUS_OVERRUN  0x80  /**< A command was dropped since the last status byte. */
+
+#define HOST_SPIS_CMD_MAX    (HOST_SPIS_XFER_LEN - 1)
+#define HOST_SPIS_REPLY_MAX  (HOST_SPIS_XFER_LEN - 2)
+
+/**@brief Command handler, run from the app_scheduler; replies go through @ref host_spis_reply. */
+typedef void (*host_spis_cmd_handler_t)(uint8_t const * p_cmd, uint16_t len);
+
+/**@brief Set the SPIS up and start serving the host.
+ *
+ * @retval NRF_SUCCESS              Serving.
+ * @retval NRF_ERROR_INVALID_PARAM  @p handler is NULL.
+ * @return Any error from nrf_drv_spis.
+ */
+ret_code_t host_spis_init(host_spis_cmd_handler_t handler);
+
+/**@brief Whether a command of the host is being handled, so replies go through
+ *        @ref host_spis_reply.
+ */
+bool host_spis_active(void);
+
+/**@brief Queue a reply for the host.
+ *
+ * @details Waits up to HOST_SPIS_REPLY_WAIT_MS for room while the host reads older replies,
+ *          as card reads wait for the NUS queue.
+ *
+ * @retval NRF_SUCCESS               Queued.
+ * @retval NRF_ERROR_INVALID_LENGTH  Empty or longer than HOST_SPIS_REPLY_MAX.
+ * @retval NRF_ERROR_NO_MEM          The host did not make room in time.
+ */
+ret_code_t host_spis_reply(uint8_t const * p_data, uint16_t len);
+
+#endif
@@ -0,0 +1,228 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(JOURNAL_SYNC)
+#include "journal_sync.h"
+#include "lock_journal.h"
+#include "nus_tx.h"
+#include "pn532_apply.h"
+#include "app_scheduler.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(LOCK_JOURNAL) || !NRF_MODULE_ENABLED(NUS_TX)
+#error "journal_sync needs LOCK_JOURNAL_ENABLED and NUS_TX_ENABLED"
+#endif
+
+#define SYNC_HDR_LEN       (2 + 4 + 4)
+#define SYNC_TORN          0x00          /**< Entry byte of an entry that could not be read. */
+
+STATIC_ASSERT(JOURNAL_SYNC_BURST < NUS_TX_QUEUE_SIZE);
+// The first entry of a packet, with its one byte zero delta, always fits.
+STATIC_ASSERT(SYNC_HDR_LEN + 1 + 1 + LOCK_JOURNAL_DATA_LEN <= BLE_NUS_DEFAULT_DATA_LEN);
+
+static ble_nus_t const * m_p_nus;
+static volatile uint16_t m_conn_handle = BLE_CONN_HANDLE_INVALID;
+static uint32_t          m_sent;          /**< Next entry to send. */
+static uint32_t          m_acked;         /**< First entry the phone does not have. */
+static uint32_t          m_resume;        /**< m_acked of the last sync, for JOURNAL_SYNC_RESUME. */
+static volatile bool     m_pump_queued;
+
+
+static uint8_t varint_put(uint8_t * p_out, int32_t delta)
+{
+    uint32_t value = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+    uint8_t  len   = 0;
+
+    while (value >= 0x80)
+    {
+        p_out[len++] = (uint8_t)(value | 0x80);
+        value      >>= 7;
+    }
+    p_out[len++] = (uint8_t)value;
+    return len;
+}
+
+
+uint16_t journal_sync_pack(uint32_t from, uint32_t end, uint8_t * p_pkt, uint16_t max, uint32_t * p_next)
+{
+    lock_journal_entry_t entry;
+    uint8_t              rec[1 + 5 + LOCK_JOURNAL_DATA_LEN];
+    uint8_t              rec_len;
+    uint32_t             time = 0;           // 0 in the header if the first entry is torn
+    uint32_t             seq  = from;
+    uint16_t             len  = 2;
+
+    p_pkt[0] = JOURNAL_SYNC;
+    p_pkt[1] = JOURNAL_SYNC_DATA;
+    len     += uint32_encode(seq, &p_pkt[len]);
+    len     += uint32_encode(time, &p_pkt[len]);
+
+    for (; seq < end; seq++)
+    {
+        if (lock_journal_read(seq, &entry) != NRF_SUCCESS)
+        {
+            rec[0]  = SYNC_TORN;
+            rec_len = 1;
+        }
+        else
+        {
+            if (seq == from)
+            {
+                time = entry.time;
+                UNUSED_RETURN_VALUE(uint32_encode(time, &p_pkt[6]));
+            }
+            rec[0]  = (uint8_t)(entry.type | (entry.len << 4));
+            rec_len = 1 + varint_put(&rec[1], (int32_t)(entry.time - time));
+            memcpy(&rec[rec_len], entry.data, entry.len);
+            rec_len += entry.len;
+            time     = entry.time;
+        }
+
+        if (len + rec_len > max)
+        {
+            break;
+        }
+        memcpy(&p_pkt[len], rec, rec_len);
+        len += rec_len;
+    }
+
+    *p_next = seq;
+    return len;
+}
+
+
+static void stop(void)
+{
+    m_resume      = m_acked;
+    m_conn_handle = BLE_CONN_HANDLE_INVALID;
+}
+
+
+/**@brief Send what the window allows, in the main loop: the journal shares the SPI bus. */
+static void pump(void * p_event_data, uint16_t event_size)
+{
+    uint8_t  pkt[BLE_NUS_MAX_DATA_LEN];
+    uint16_t max;
+    uint16_t len;
+    uint32_t next;
+    uint32_t end;
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    m_pump_queued = false;
+
+    for (uint8_t burst = 0; (burst < JOURNAL_SYNC_BURST) && (m_conn_handle != BLE_CONN_HANDLE_INVALID); burst++)
+    {
+        if (m_sent < lock_journal_oldest())
+        {
+            // Overwritten before they went out.
+            m_sent = lock_journal_oldest();
+        }
+        end = MIN(lock_journal_head(), m_acked + JOURNAL_SYNC_WINDOW);
+        if (m_sent >= end)
+        {
+            break;
+        }
+
+        max = MIN(ble_nus_data_len_get(m_p_nus, m_conn_handle), sizeof(pkt));
+        len = journal_sync_pack(m_sent, end, pkt, max, &next);
+        if (nus_tx_put(m_conn_handle, pkt, len, 0) != NRF_SUCCESS)
+        {
+            // Notifications turned off, or the link went away while it waited.
+            stop();
+            return;
+        }
+        m_sent = next;
+    }
+
+    if ((m_conn_handle != BLE_CONN_HANDLE_INVALID) && (m_acked >= lock_journal_head()))
+    {
+        len  = 2;
+        pkt[0] = JOURNAL_SYNC;
+        pkt[1] = JOURNAL_SYNC_DONE;
+        len += uint32_encode(m_acked, &pkt[len]);
+        UNUSED_RETURN_VALUE(nus_tx_put(m_conn_handle, pkt, len, 0));
+        stop();
+    }
+}
+
+
+static void pump_schedule(void)
+{
+    if (!m_pump_queued)
+    {
+        m_pump_queued = (app_sched_event_put(NULL, 0, pump) == NRF_SUCCESS);
+    }
+}
+
+
+ret_code_t journal_sync_init(ble_nus_t const * p_nus)
+{
+    m_p_nus       = p_nus;
+    m_conn_handle = BLE_CONN_HANDLE_INVALID;
+    m_resume      = 0;
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t journal_sync_start(uint16_t conn_handle, uint32_t cursor, uint32_t * p_from)
+{
+    if (cursor == JOURNAL_SYNC_RESUME)
+    {
+        cursor = (m_conn_handle != BLE_CONN_HANDLE_INVALID) ? m_acked : m_resume;
+    }
+    cursor = MAX(cursor, lock_journal_oldest());
+    cursor = MIN(cursor, lock_journal_head());
+
+    m_sent        = cursor;
+    m_acked       = cursor;
+    m_conn_handle = conn_handle;
+    *p_from       = cursor;
+
+    pump_schedule();
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t journal_sync_ack(uint16_t conn_handle, uint32_t seq)
+{
+    if ((m_conn_handle == BLE_CONN_HANDLE_INVALID) || (conn_handle != m_conn_handle))
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if (seq > m_sent)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if (seq > m_acked)
+    {
+        m_acked = seq;
+        pump_schedule();
+    }
+    return NRF_SUCCESS;
+}
+
+
+void journal_sync_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    if ((m_conn_handle == BLE_CONN_HANDLE_INVALID) ||
+        (p_ble_evt->evt.common_evt.conn_handle != m_conn_handle))
+    {
+        return;
+    }
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_EVT_TX_COMPLETE:
+            pump_schedule();
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            stop();
+            break;
+
+        default:
+            break;
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(JOURNAL_SYNC)
@@ -0,0 +1,72 @@
+#ifndef __JOURNAL_SYNC_H__
+#define __JOURNAL_SYNC_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+#include "ble.h"
+#include "ble_nus.h"
+
+/* The journal streamed to a phone over NUS, resumable from a sequence cursor:
+ *
+ *   start     JOURNAL_SYNC, JOURNAL_SYNC_START, cursor (LE): entries from the cursor on, or
+ *             with JOURNAL_SYNC_RESUME from where the last sync since boot was acknowledged
+ *   data      JOURNAL_SYNC, JOURNAL_SYNC_DATA, seq of the first entry, time of the first
+ *             entry (LE), then entries of consecutive seq packed up to the data length of the
+ *             link: type | len << 4, the time since the entry before as a zigzag varint, the
+ *             data; a 0 byte for an entry torn in flash
+ *   window    no more than JOURNAL_SYNC_WINDOW entries past the acknowledged one are sent,
+ *             JOURNAL_SYNC_BURST notifications at a time, more on BLE_EVT_TX_COMPLETE
+ *   ack       JOURNAL_SYNC, JOURNAL_SYNC_ACK, seq (LE): the phone has every entry below seq
+ *   done      JOURNAL_SYNC, JOURNAL_SYNC_DONE, head (LE) once everything is acknowledged
+ *   radio     JOURNAL_SYNC, JOURNAL_SYNC_RADIO, cursor (LE): the same packets to the gateway
+ *             over burst_link, answered like a start
+ *
+ * Entries overwritten before they were sent are skipped; the seq of the next packet shows
+ * the gap. A disconnect ends the sync, and only entries past the last acknowledgement are
+ * sent again. One link syncs at a time; a start from another link takes over. */
+
+#define JOURNAL_SYNC_START   0
+#define JOURNAL_SYNC_DATA    1
+#define JOURNAL_SYNC_ACK     2
+#define JOURNAL_SYNC_DONE    3
+#define JOURNAL_SYNC_RADIO   4           /**< Start of an offload over burst_link. */
+#define JOURNAL_SYNC_RESUME  0xFFFFFFFF  /**< Cursor of a start that resumes the last sync. */
+
+/**@brief Start with no sync.
+ *
+ * @param[in] p_nus  Service the notifications go out on.
+ */
+ret_code_t journal_sync_init(ble_nus_t const * p_nus);
+
+/**@brief Start a sync on a link. Main loop.
+ *
+ * @param[in]  conn_handle  Link of the phone.
+ * @param[in]  cursor       First entry wanted, or JOURNAL_SYNC_RESUME.
+ * @param[out] p_from       First entry that will be sent: the cursor, moved up to the oldest
+ *                          entry held and down to the head.
+ */
+ret_code_t journal_sync_start(uint16_t conn_handle, uint32_t cursor, uint32_t * p_from);
+
+/**@brief Take an acknowledgement from a link. Main loop.
+ *
+ * @retval NRF_SUCCESS              The window moved on, or the ack was old.
+ * @retval NRF_ERROR_INVALID_STATE  No sync on this link.
+ * @retval NRF_ERROR_INVALID_PARAM  The ack is past what was sent.
+ */
+ret_code_t journal_sync_ack(uint16_t conn_handle, uint32_t seq);
+
+/**@brief Pack entries from @p from on, below @p end, into a data packet of at most @p max
+ *        bytes, as they go out over NUS. Main loop: the journal shares the SPI bus.
+ *
+ * @details The first entry always fits a packet of BLE_NUS_DEFAULT_DATA_LEN bytes.
+ *
+ * @param[out] p_next  Seq after the last entry packed.
+ *
+ * @return Length of the packet.
+ */
+uint16_t journal_sync_pack(uint32_t from, uint32_t end, uint8_t * p_pkt, uint16_t max, uint32_t * p_next);
+
+/**@brief Send on BLE_EVT_TX_COMPLETE, stop on disconnect. */
+void journal_sync_on_ble_evt(ble_evt_t * p_ble_evt);
+
+#endif
@@ -0,0 +1,158 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(LAT_TRACE)
+#include "lat_trace.h"
+#include "app_util_platform.h"
+#if NRF_MODULE_ENABLED(KEEP_RAM)
+#include "keep_ram.h"
+#endif
+#include <stdio.h>
+#include <string.h>
+
+#define RTC_FREQUENCY  32768
+
+#if NRF_MODULE_ENABLED(KEEP_RAM)
+// The ring and the statistics go on over a reset.
+#define m_keep  (keep_ram_get()->trace)
+#else
+static lat_trace_keep_t m_keep;
+#endif
+
+static char const * const m_stage_names[LAT_STAGE_COUNT] =
+{
+    "wake", "sam", "select", "auth", "read", "notify", "beep", "command", "write", "dump", "tx_wait", "diag",
+    "decide"
+};
+
+
+void lat_trace_record(lat_stage_t stage, uint32_t start)
+{
+    uint32_t ticks;
+
+    if (stage >= LAT_STAGE_COUNT)
+    {
+        return;
+    }
+    UNUSED_RETURN_VALUE(app_timer_cnt_diff_compute(app_timer_cnt_get(), start, &ticks));
+
+    CRITICAL_REGION_ENTER();
+    lat_trace_rec_t * p_rec   = &m_keep.ring[m_keep.next];
+    lat_trace_acc_t * p_stats = &m_keep.stats[stage];
+
+    p_rec->stamp    = start;
+    p_rec->ticks    = MIN(ticks, UINT16_MAX);
+    p_rec->stage    = stage;
+    p_rec->reserved = 0;
+    m_keep.next = (m_keep.next + 1) % LAT_TRACE_RING_SIZE;
+    if (m_keep.count < LAT_TRACE_RING_SIZE)
+    {
+        m_keep.count++;
+    }
+
+    if ((p_stats->count == 0) || (ticks < p_stats->min))
+    {
+        p_stats->min = ticks;
+    }
+    if (ticks > p_stats->max)
+    {
+        p_stats->max = ticks;
+    }
+    p_stats->sum = (p_stats->sum > UINT32_MAX - ticks) ? UINT32_MAX : p_stats->sum + ticks;
+    p_stats->count++;
+    CRITICAL_REGION_EXIT();
+}
+
+
+uint32_t lat_trace_ticks_to_us(uint32_t ticks)
+{
+    return (uint32_t)(((uint64_t)ticks * (APP_TIMER_CONFIG_PRESCALER + 1) * 1000000) / RTC_FREQUENCY);
+}
+
+
+ret_code_t lat_trace_stats_get(lat_stage_t stage, lat_trace_stats_t * p_stats)
+{
+    lat_trace_acc_t stats;
+
+    if (stage >= LAT_STAGE_COUNT)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    CRITICAL_REGION_ENTER();
+    stats = m_keep.stats[stage];
+    CRITICAL_REGION_EXIT();
+
+    if (stats.count == 0)
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+    p_stats->count  = stats.count;
+    p_stats->min_us = lat_trace_ticks_to_us(stats.min);
+    p_stats->avg_us = lat_trace_ticks_to_us(stats.sum / stats.count);
+    p_stats->max_us = lat_trace_ticks_to_us(stats.max);
+
+    return NRF_SUCCESS;
+}
+
+
+bool lat_trace_rec_get(uint16_t index, lat_trace_rec_t * p_rec)
+{
+    bool found = false;
+
+    CRITICAL_REGION_ENTER();
+    if (index < m_keep.count)
+    {
+        *p_rec = m_keep.ring[(m_keep.next + LAT_TRACE_RING_SIZE - m_keep.count + index) % LAT_TRACE_RING_SIZE];
+        found  = true;
+    }
+    CRITICAL_REGION_EXIT();
+
+    return found;
+}
+
+
+uint16_t lat_trace_copy(lat_trace_rec_t * p_recs, uint16_t max)
+{
+    uint16_t count = MIN(max, m_keep.count);
+
+    // No critical region: this runs from the fault handlers, where nothing writes the ring.
+    for (uint16_t i = 0; i < count; i++)
+    {
+        p_recs[i] = m_keep.ring[(m_keep.next + LAT_TRACE_RING_SIZE - count + i) % LAT_TRACE_RING_SIZE];
+    }
+    return count;
+}
+
+
+void lat_trace_reset(void)
+{
+    CRITICAL_REGION_ENTER();
+    m_keep.next  = 0;
+    m_keep.count = 0;
+    memset(m_keep.stats, 0, sizeof(m_keep.stats));
+    CRITICAL_REGION_EXIT();
+}
+
+
+void lat_trace_print(void)
+{
+    lat_trace_stats_t stats;
+    lat_trace_rec_t   rec;
+
+    printf("stage     count   min_us   avg_us   max_us\r\n");
+    for (uint8_t i = 0; i < LAT_STAGE_COUNT; i++)
+    {
+        if (lat_trace_stats_get((lat_stage_t)i, &stats) == NRF_SUCCESS)
+        {
+            printf("%-8s %6lu %8lu %8lu %8lu\r\n", m_stage_names[i],
+                   (unsigned long)stats.count, (unsigned long)stats.min_us,
+                   (unsigned long)stats.avg_us, (unsigned long)stats.max_us);
+        }
+    }
+    for (uint16_t i = 0; lat_trace_rec_get(i, &rec); i++)
+    {
+        printf("%08lx %-8s %lu us\r\n", (unsigned long)rec.stamp, m_stage_names[rec.stage],
+               (unsigned long)lat_trace_ticks_to_us(rec.ticks));
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(LAT_TRACE)
@@ -0,0 +1,112 @@
+#ifndef __LAT_TRACE_H__
+#define __LAT_TRACE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_common.h"
+#include "app_timer.h"
+
+/**@brief Stages of a tap, from waking the reader to the beep. */
+typedef enum
+{
+    LAT_STAGE_WAKE,     /**< PN532 wake up from PowerDown. */
+    LAT_STAGE_SAM,      /**< SAMConfiguration after power up or wake up. */
+    LAT_STAGE_SELECT,   /**< Finding the card: presence check or anticollision. */
+    LAT_STAGE_AUTH,     /**< MIFARE Classic sector authentication. */
+    LAT_STAGE_READ,     /**< One block read. */
+    LAT_STAGE_NOTIFY,   /**< Queueing a NUS notification. */
+    LAT_STAGE_BEEP,     /**< Starting the feedback pattern. */
+    LAT_STAGE_COMMAND,  /**< A whole raw command, from the main loop picking it up to its end. */
+    LAT_STAGE_WRITE,    /**< One block write. */
+    LAT_STAGE_DUMP,     /**< A whole block range, from the first authentication to the last block queued. */
+    LAT_STAGE_TX_WAIT,  /**< The thread held by a full NUS TX queue: BLE is behind the card. */
+    LAT_STAGE_DIAG,     /**< A PN532 self test. */
+    LAT_STAGE_DECIDE,   /**< UID to lock action: whitelist, schedule, motor start, feedback. */
+    LAT_STAGE_COUNT
+} lat_stage_t;
+
+/**@brief One traced stage. */
+typedef struct
+{
+    uint32_t stamp;     /**< app_timer_cnt_get() at the start. */
+    uint16_t ticks;     /**< Duration in RTC1 ticks, saturated. */
+    uint8_t  stage;     /**< lat_stage_t. */
+    uint8_t  reserved;
+} lat_trace_rec_t;
+
+/**@brief Statistics of one stage since the last reset. */
+typedef struct
+{
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t avg_us;
+    uint32_t max_us;
+} lat_trace_stats_t;
+
+#if NRF_MODULE_ENABLED(LAT_TRACE)
+/**@brief Running statistics of one stage, in RTC1 ticks. */
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t sum;       /**< Saturated. */
+} lat_trace_acc_t;
+
+/**@brief Everything lat_trace records; kept over resets in keep_ram when that is enabled. */
+typedef struct
+{
+    lat_trace_rec_t ring[LAT_TRACE_RING_SIZE];
+    uint16_t        next;       /**< Slot of the next record. */
+    uint16_t        count;      /**< Records in the ring. */
+    lat_trace_acc_t stats[LAT_STAGE_COUNT];
+} lat_trace_keep_t;
+
+/**@brief Timestamp the start of a stage into a new local @p t. */
+#define LAT_TRACE_START(t)          uint32_t t = app_timer_cnt_get()
+/**@brief Record the stage started with @ref LAT_TRACE_START. */
+#define LAT_TRACE_STOP(stage, t)    lat_trace_record((stage), (t))
+#else
+#define LAT_TRACE_START(t)
+#define LAT_TRACE_STOP(stage, t)
+#endif
+
+/**@brief Record a stage that started at @p start (an app_timer_cnt_get() value) and ends now.
+ *
+ * @details Goes into the ring of the last LAT_TRACE_RING_SIZE records, overwriting the oldest,
+ *          and into the statistics of the stage. Safe to call from interrupts.
+ */
+void lat_trace_record(lat_stage_t stage, uint32_t start);
+
+/**@brief Statistics of a stage.
+ *
+ * @retval NRF_SUCCESS              @p p_stats filled.
+ * @retval NRF_ERROR_NOT_FOUND      Nothing recorded for the stage yet.
+ * @retval NRF_ERROR_INVALID_PARAM  Unknown stage.
+ */
+ret_code_t lat_trace_stats_get(lat_stage_t stage, lat_trace_stats_t * p_stats);
+
+/**@brief Record from the ring, 0 being the oldest.
+ *
+ * @return false if there is no record at @p index.
+ */
+bool lat_trace_rec_get(uint16_t index, lat_trace_rec_t * p_rec);
+
+/**@brief Copy the newest records, up to @p max, oldest first, without locking.
+ *
+ * @details For fault handlers, which must not depend on the interrupt state.
+ *
+ * @return Number of records copied.
+ */
+uint16_t lat_trace_copy(lat_trace_rec_t * p_recs, uint16_t max);
+
+/**@brief RTC1 ticks to microseconds. */
+uint32_t lat_trace_ticks_to_us(uint32_t ticks);
+
+/**@brief Clear the ring and the statistics. */
+void lat_trace_reset(void);
+
+/**@brief Print the statistics and the ring with printf (UART). */
+void lat_trace_print(void);
+
+#endif
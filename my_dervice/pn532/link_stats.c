@@ -0,0 +1,326 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(LINK_STATS)
+#include "link_stats.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#include <string.h>
+
+#define LINK_STATS_UUID_SERVICE     0x0010  /**< On the NUS base. */
+#define LINK_STATS_UUID_RECORD      0x0011
+
+#define UNITS_TO_MS(units)          (((uint32_t)(units) * 5) / 4)
+
+typedef struct
+{
+    link_stats_t stats;
+    uint32_t     progress_tick;     /**< Last hand-over into an empty SoftDevice, or acknowledgement. */
+} link_entry_t;
+
+static link_entry_t m_links[BLE_NUS_LINK_COUNT];
+#if LINK_STATS_GATT
+static uint16_t                 m_service_handle;
+static ble_gatts_char_handles_t m_record_handles;
+#endif
+
+
+static link_entry_t * link_find(uint16_t conn_handle)
+{
+    for (uint8_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        if ((conn_handle != BLE_CONN_HANDLE_INVALID) && (m_links[i].stats.conn_handle == conn_handle))
+        {
+            return &m_links[i];
+        }
+    }
+    return NULL;
+}
+
+
+static void sat_inc(uint16_t * p_count)
+{
+    if (*p_count != UINT16_MAX)
+    {
+        (*p_count)++;
+    }
+}
+
+
+static uint32_t ms_since(uint32_t tick)
+{
+    uint32_t ticks;
+
+    UNUSED_RETURN_VALUE(app_timer_cnt_diff_compute(app_timer_cnt_get(), tick, &ticks));
+    return (uint32_t)(((uint64_t)ticks * 1000 * (APP_TIMER_CONFIG_PRESCALER + 1)) / APP_TIMER_CLOCK_FREQ);
+}
+
+
+static void entry_clear(link_entry_t * p_entry, uint16_t conn_handle, uint16_t interval)
+{
+    memset(p_entry, 0, sizeof(*p_entry));
+    p_entry->stats.conn_handle = conn_handle;
+    p_entry->stats.interval    = interval;
+}
+
+
+static void on_tx_complete(link_entry_t * p_entry, uint8_t count)
+{
+    link_stats_t * p_stats = &p_entry->stats;
+
+    if (p_stats->in_flight != 0)
+    {
+        uint32_t waited = ms_since(p_entry->progress_tick);
+
+        // A packet the peer missed waits for the next connection event, at best.
+        if (waited > UNITS_TO_MS(p_stats->interval) * LINK_STATS_STALL_INTERVALS)
+        {
+            sat_inc(&p_stats->stalls);
+            p_stats->stall_ms_max = (uint16_t)MIN(MAX(waited, p_stats->stall_ms_max), UINT16_MAX);
+        }
+    }
+    p_stats->in_flight     = (count < p_stats->in_flight) ? (p_stats->in_flight - count) : 0;
+    p_entry->progress_tick = app_timer_cnt_get();
+}
+
+
+void link_stats_init(void)
+{
+    for (uint8_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        entry_clear(&m_links[i], BLE_CONN_HANDLE_INVALID, 0);
+    }
+}
+
+
+ret_code_t link_stats_service_init(uint8_t uuid_type)
+{
+#if LINK_STATS_GATT
+    ret_code_t          err_code;
+    ble_uuid_t          ble_uuid;
+    ble_gatts_char_md_t char_md;
+    ble_gatts_attr_md_t attr_md;
+    ble_gatts_attr_t    attr_char_value;
+
+    ble_uuid.type = uuid_type;
+    ble_uuid.uuid = LINK_STATS_UUID_SERVICE;
+    err_code = sd_ble_gatts_service_add(BLE_GATTS_SRVC_TYPE_PRIMARY, &ble_uuid, &m_service_handle);
+    VERIFY_SUCCESS(err_code);
+
+    memset(&char_md, 0, sizeof(char_md));
+    char_md.char_props.read = 1;
+
+    memset(&attr_md, 0, sizeof(attr_md));
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr_md.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(&attr_md.write_perm);
+    attr_md.vloc    = BLE_GATTS_VLOC_STACK;
+    // Filled on each read, with the counters of the link that reads.
+    attr_md.rd_auth = 1;
+
+    ble_uuid.uuid = LINK_STATS_UUID_RECORD;
+
+    memset(&attr_char_value, 0, sizeof(attr_char_value));
+    attr_char_value.p_uuid    = &ble_uuid;
+    attr_char_value.p_attr_md = &attr_md;
+    attr_char_value.init_len  = LINK_STATS_RECORD_SIZE;
+    attr_char_value.max_len   = LINK_STATS_RECORD_SIZE;
+
+    return sd_ble_gatts_characteristic_add(m_service_handle, &char_md, &attr_char_value,
+                                           &m_record_handles);
+#else
+    UNUSED_PARAMETER(uuid_type);
+    return NRF_SUCCESS;
+#endif
+}
+
+
+void link_stats_tx_sent(uint16_t conn_handle, uint16_t len)
+{
+    link_entry_t * p_entry = link_find(conn_handle);
+
+    if (p_entry == NULL)
+    {
+        return;
+    }
+    if (p_entry->stats.in_flight == 0)
+    {
+        // Waits count from here, not from the last acknowledgement of an idle link.
+        p_entry->progress_tick = app_timer_cnt_get();
+    }
+    if (p_entry->stats.in_flight != UINT8_MAX)
+    {
+        p_entry->stats.in_flight++;
+    }
+    p_entry->stats.in_flight_max = MAX(p_entry->stats.in_flight_max, p_entry->stats.in_flight);
+    p_entry->stats.notifications++;
+    p_entry->stats.bytes += len;
+}
+
+
+void link_stats_tx_refused(uint16_t conn_handle)
+{
+    link_entry_t * p_entry = link_find(conn_handle);
+
+    if (p_entry != NULL)
+    {
+        sat_inc(&p_entry->stats.refused);
+    }
+}
+
+
+void link_stats_queue_depth(uint16_t conn_handle, uint8_t depth)
+{
+    link_entry_t * p_entry = link_find(conn_handle);
+
+    if (p_entry != NULL)
+    {
+        p_entry->stats.queue_depth     = depth;
+        p_entry->stats.queue_depth_max = MAX(p_entry->stats.queue_depth_max, depth);
+    }
+}
+
+
+ret_code_t link_stats_get(uint16_t conn_handle, link_stats_t * p_stats)
+{
+    ret_code_t err_code = NRF_ERROR_NOT_FOUND;
+
+    CRITICAL_REGION_ENTER();
+    link_entry_t * p_entry = link_find(conn_handle);
+    if (p_entry != NULL)
+    {
+        *p_stats = p_entry->stats;
+        err_code = NRF_SUCCESS;
+    }
+    CRITICAL_REGION_EXIT();
+
+    return err_code;
+}
+
+
+void link_stats_reset(uint16_t conn_handle)
+{
+    CRITICAL_REGION_ENTER();
+    link_entry_t * p_entry = link_find(conn_handle);
+    if (p_entry != NULL)
+    {
+        link_stats_t stats = p_entry->stats;
+
+        // What is in flight and queued still is; the peaks and the totals start over.
+        entry_clear(p_entry, conn_handle, stats.interval);
+        p_entry->stats.in_flight       = stats.in_flight;
+        p_entry->stats.in_flight_max   = stats.in_flight;
+        p_entry->stats.queue_depth     = stats.queue_depth;
+        p_entry->stats.queue_depth_max = stats.queue_depth;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+
+#if LINK_STATS_GATT
+static void on_read_request(ble_evt_t * p_ble_evt)
+{
+    uint16_t                                     conn_handle = p_ble_evt->evt.gatts_evt.conn_handle;
+    ble_gatts_evt_rw_authorize_request_t const * p_req       = &p_ble_evt->evt.gatts_evt.params.authorize_request;
+    ble_gatts_rw_authorize_reply_params_t        auth_reply;
+    link_stats_t                                 stats;
+    uint8_t                                      record[LINK_STATS_RECORD_SIZE];
+    uint8_t                                      len = 0;
+
+    if ((p_req->type != BLE_GATTS_AUTHORIZE_TYPE_READ) ||
+        (p_req->request.read.handle != m_record_handles.value_handle))
+    {
+        return;
+    }
+
+    memset(&stats, 0, sizeof(stats));
+    UNUSED_RETURN_VALUE(link_stats_get(conn_handle, &stats));
+
+    len += uint16_encode(stats.interval, &record[len]);
+    record[len++] = stats.in_flight;
+    record[len++] = stats.in_flight_max;
+    record[len++] = stats.queue_depth;
+    record[len++] = stats.queue_depth_max;
+    len += uint32_encode(stats.notifications, &record[len]);
+    len += uint32_encode(stats.bytes, &record[len]);
+    len += uint16_encode(stats.refused, &record[len]);
+    len += uint16_encode(stats.stalls, &record[len]);
+    len += uint16_encode(stats.stall_ms_max, &record[len]);
+
+    memset(&auth_reply, 0, sizeof(auth_reply));
+
+    auth_reply.type                    = BLE_GATTS_AUTHORIZE_TYPE_READ;
+    auth_reply.params.read.gatt_status = BLE_GATT_STATUS_SUCCESS;
+    auth_reply.params.read.update      = 1;
+    auth_reply.params.read.offset      = 0;
+    auth_reply.params.read.len         = len;
+    auth_reply.params.read.p_data      = record;
+
+    UNUSED_RETURN_VALUE(sd_ble_gatts_rw_authorize_reply(conn_handle, &auth_reply));
+}
+#endif
+
+
+void link_stats_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    uint16_t       conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+    link_entry_t * p_entry;
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            p_entry = NULL;
+            for (uint8_t i = 0; (p_entry == NULL) && (i < BLE_NUS_LINK_COUNT); i++)
+            {
+                if (m_links[i].stats.conn_handle == BLE_CONN_HANDLE_INVALID)
+                {
+                    p_entry = &m_links[i];
+                }
+            }
+            if (p_entry != NULL)
+            {
+                CRITICAL_REGION_ENTER();
+                entry_clear(p_entry, conn_handle,
+                            p_ble_evt->evt.gap_evt.params.connected.conn_params.max_conn_interval);
+                CRITICAL_REGION_EXIT();
+            }
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            p_entry = link_find(conn_handle);
+            if (p_entry != NULL)
+            {
+                CRITICAL_REGION_ENTER();
+                entry_clear(p_entry, BLE_CONN_HANDLE_INVALID, 0);
+                CRITICAL_REGION_EXIT();
+            }
+            break;
+
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+            p_entry = link_find(conn_handle);
+            if (p_entry != NULL)
+            {
+                p_entry->stats.interval =
+                    p_ble_evt->evt.gap_evt.params.conn_param_update.conn_params.max_conn_interval;
+            }
+            break;
+
+        case BLE_EVT_TX_COMPLETE:
+            CRITICAL_REGION_ENTER();
+            p_entry = link_find(p_ble_evt->evt.common_evt.conn_handle);
+            if (p_entry != NULL)
+            {
+                on_tx_complete(p_entry, p_ble_evt->evt.common_evt.params.tx_complete.count);
+            }
+            CRITICAL_REGION_EXIT();
+            break;
+
+#if LINK_STATS_GATT
+        case BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST:
+            on_read_request(p_ble_evt);
+            break;
+#endif
+
+        default:
+            break;
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(LINK_STATS)
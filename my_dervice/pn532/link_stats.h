@@ -0,0 +1,74 @@
+#ifndef __LINK_STATS_H__
+#define __LINK_STATS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "ble.h"
+
+/* What each link does with its TX buffers, for tuning the NUS batching and the link scheduling:
+ *
+ *   in flight   notifications handed to the SoftDevice and not yet acknowledged, by
+ *               BLE_EVT_TX_COMPLETE, now and at most
+ *   queue       notifications nus_tx holds for the link, now and at most
+ *   sent        notifications and bytes handed over
+ *   refused     hand-overs refused with BLE_ERROR_NO_TX_PACKETS: every SoftDevice buffer taken
+ *   stalls      acknowledgements that came more than LINK_STATS_STALL_INTERVALS connection
+ *               intervals after the last progress, with buffers in flight: the peer missed
+ *               packets and the link layer sent them again; with the longest such wait
+ *
+ * The counters start over on connect. With LINK_STATS_GATT the peer reads the counters of its
+ * own link from a characteristic of a service of its own, @ref link_stats_record_t. */
+
+/**@brief Counters of one link. */
+typedef struct
+{
+    uint16_t conn_handle;       /**< BLE_CONN_HANDLE_INVALID for a free entry. */
+    uint16_t interval;          /**< Connection interval, in 1.25 ms units. */
+    uint8_t  in_flight;
+    uint8_t  in_flight_max;
+    uint8_t  queue_depth;
+    uint8_t  queue_depth_max;
+    uint32_t notifications;
+    uint32_t bytes;
+    uint16_t refused;           /**< Saturated. */
+    uint16_t stalls;            /**< Saturated. */
+    uint16_t stall_ms_max;      /**< Saturated. */
+} link_stats_t;
+
+/**@brief Characteristic value: the counters after @p conn_handle, little endian, packed. */
+#define LINK_STATS_RECORD_SIZE  20
+
+/**@brief Clear the table. */
+void link_stats_init(void);
+
+/**@brief Add the diagnostic service, when LINK_STATS_GATT is set.
+ *
+ * @param[in] uuid_type  Vendor UUID type of the NUS base, which the service and its
+ *                       characteristic use as well.
+ */
+ret_code_t link_stats_service_init(uint8_t uuid_type);
+
+/**@brief A notification handed to the SoftDevice. Call with the TX queues locked. */
+void link_stats_tx_sent(uint16_t conn_handle, uint16_t len);
+
+/**@brief A notification refused for lack of TX buffers. Call with the TX queues locked. */
+void link_stats_tx_refused(uint16_t conn_handle);
+
+/**@brief Notifications queued for a link, after a change. Call with the TX queues locked. */
+void link_stats_queue_depth(uint16_t conn_handle, uint8_t depth);
+
+/**@brief Counters of a link.
+ *
+ * @retval NRF_SUCCESS          @p p_stats filled.
+ * @retval NRF_ERROR_NOT_FOUND  The link is not connected.
+ */
+ret_code_t link_stats_get(uint16_t conn_handle, link_stats_t * p_stats);
+
+/**@brief Start the counters of a link over. */
+void link_stats_reset(uint16_t conn_handle);
+
+/**@brief Follow the links and the acknowledgements; answer reads of the characteristic. */
+void link_stats_on_ble_evt(ble_evt_t * p_ble_evt);
+
+#endif
@@ -0,0 +1,353 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(LOAD_GEN)
+#include "load_gen.h"
+#include "pn532_sim.h"
+#include "sensorsim.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "app_util_platform.h"
+#include <stdio.h>
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(PN532_SIM)
+#error "load_gen puts its cards in the field of the emulator, it needs PN532_SIM_ENABLED"
+#endif
+
+#define LOAD_GEN_TICKS(ms)  APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+#define MIX_TOTAL           (LOAD_GEN_MIX_MFC1K + LOAD_GEN_MIX_NTAG213 + LOAD_GEN_MIX_TYPE_B + LOAD_GEN_MIX_TOPAZ)
+#define HOT_UIDS            MAX(LOAD_GEN_UIDS / 8, 1)
+#define AWAY_MIN_MS         100     /**< Shortest empty field between two cards. */
+
+STATIC_ASSERT(MIX_TOTAL > 0);
+STATIC_ASSERT((LOAD_GEN_RATE_MIN > 0) && (LOAD_GEN_RATE_MIN <= LOAD_GEN_RATE_MAX));
+STATIC_ASSERT(LOAD_GEN_SAMPLES > 0);
+
+APP_TIMER_DEF(m_timer);
+
+static bool              m_timer_created;
+static volatile bool     m_active;
+static bool              m_in_field;        /**< What the timer ends: a card in the field or a gap. */
+static uint32_t          m_taps;            /**< Of the run, 0 for no end. */
+static uint32_t          m_rand;
+static sensorsim_cfg_t   m_rate_cfg;
+static sensorsim_state_t m_rate;
+static uint32_t          m_gap_ms;          /**< Of the tap in the field, its dwell included. */
+
+static uint8_t           m_uid[8];          /**< Of the card in the field. */
+static uint8_t           m_uid_len;
+static uint32_t          m_placed_at;       /**< app_timer_cnt_get() when it was put there. */
+static volatile bool     m_pending;         /**< Not decided on yet. */
+
+static load_gen_report_t m_report;
+static uint32_t          m_samples[LOAD_GEN_SAMPLES];   /**< Latencies in us, a ring. */
+static uint16_t          m_sample_next;
+static uint32_t          m_sorted[LOAD_GEN_SAMPLES];
+
+
+/**@brief xorshift32; also spreads the index of a card into its UID. */
+static uint32_t rand_step(uint32_t x)
+{
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+
+static uint32_t rand_next(void)
+{
+    m_rand = rand_step(m_rand);
+    return m_rand;
+}
+
+
+/**@brief Type and UID of card @p index, the same for every run with the same seed. */
+static pn532_sim_card_t card_make(uint32_t index, uint8_t * p_uid, uint8_t * p_len)
+{
+    uint32_t         x    = rand_step(LOAD_GEN_SEED ^ ((index + 1) * 0x9E3779B9UL));
+    uint32_t         pick = x % MIX_TOTAL;
+    pn532_sim_card_t card;
+
+    if (pick < LOAD_GEN_MIX_MFC1K)
+    {
+        card   = PN532_SIM_CARD_MIFARE_1K;
+        *p_len = 4;
+    }
+    else if (pick < LOAD_GEN_MIX_MFC1K + LOAD_GEN_MIX_NTAG213)
+    {
+        card   = PN532_SIM_CARD_NTAG213;
+        *p_len = 7;
+    }
+    else if (pick < LOAD_GEN_MIX_MFC1K + LOAD_GEN_MIX_NTAG213 + LOAD_GEN_MIX_TYPE_B)
+    {
+        card   = PN532_SIM_CARD_TYPE_B;
+        *p_len = 8;
+    }
+    else
+    {
+        card   = PN532_SIM_CARD_TOPAZ512;
+        *p_len = 4;
+    }
+
+    for (uint8_t i = 0; i < *p_len; i++)
+    {
+        x        = rand_step(x);
+        p_uid[i] = (uint8_t)x;
+    }
+    if (card == PN532_SIM_CARD_NTAG213)
+    {
+        p_uid[0] = 0x04;        // NXP
+    }
+    else if (p_uid[0] == 0x88)
+    {
+        p_uid[0] = 0x89;        // Not the cascade tag.
+    }
+    return card;
+}
+
+
+static uint32_t ticks_to_us(uint32_t ticks)
+{
+    return (uint32_t)(((uint64_t)ticks * 1000000UL * (APP_TIMER_CONFIG_PRESCALER + 1)) / 32768UL);
+}
+
+
+static void timer_start(uint32_t ms)
+{
+    APP_ERROR_CHECK(app_timer_start(m_timer, LOAD_GEN_TICKS(MAX(ms, 1)), NULL));
+}
+
+
+static void report_print(void)
+{
+    load_gen_report_t report;
+
+    load_gen_report_get(&report);
+    printf("load %3u/min placed %lu decided %lu missed %lu p50 %lu p90 %lu p99 %lu max %lu us\r\n",
+           report.rate, (unsigned long)report.placed, (unsigned long)report.decided,
+           (unsigned long)report.missed, (unsigned long)report.p50_us,
+           (unsigned long)report.p90_us, (unsigned long)report.p99_us,
+           (unsigned long)report.max_us);
+}
+
+
+/**@brief Put the next card in the field and pick the gap to the one after it. */
+static void card_in(void)
+{
+    uint32_t         index;
+    uint32_t         rate = sensorsim_measure(&m_rate, &m_rate_cfg);
+    uint32_t         spread;
+    pn532_sim_card_t card;
+
+    if ((rand_next() % 100) < LOAD_GEN_HOT_PCT)
+    {
+        index = rand_next() % HOT_UIDS;
+    }
+    else
+    {
+        index = rand_next() % LOAD_GEN_UIDS;
+    }
+    card = card_make(index, m_uid, &m_uid_len);
+
+    m_gap_ms = 60000 / rate;
+    spread   = m_gap_ms * LOAD_GEN_JITTER_PCT / 100;
+    if (spread > 0)
+    {
+        m_gap_ms = m_gap_ms - spread + rand_next() % (2 * spread + 1);
+    }
+    m_gap_ms = MAX(m_gap_ms, LOAD_GEN_DWELL_MS + AWAY_MIN_MS);
+
+    pn532_sim_card_set(card, m_uid);
+    CRITICAL_REGION_ENTER();
+    m_placed_at = app_timer_cnt_get();
+    m_pending   = true;
+    CRITICAL_REGION_EXIT();
+    m_report.placed++;
+    m_report.rate = (uint16_t)rate;
+
+    m_in_field = true;
+    timer_start(LOAD_GEN_DWELL_MS);
+}
+
+
+/**@brief Take the card away; the rest of the gap follows, or the end of the run. */
+static void card_out(void)
+{
+    pn532_sim_card_set(PN532_SIM_CARD_NONE, NULL);
+    CRITICAL_REGION_ENTER();
+    if (m_pending)
+    {
+        m_pending = false;
+        m_report.missed++;
+    }
+    CRITICAL_REGION_EXIT();
+
+    if ((LOAD_GEN_REPORT_TAPS > 0) && ((m_report.placed % LOAD_GEN_REPORT_TAPS) == 0))
+    {
+        report_print();
+    }
+    if ((m_taps > 0) && (m_report.placed >= m_taps))
+    {
+        m_active = false;
+        report_print();
+        return;
+    }
+
+    m_in_field = false;
+    timer_start(m_gap_ms - LOAD_GEN_DWELL_MS);
+}
+
+
+/**@brief The emulator belongs to the main loop, where the driver talks to it. */
+static void step_handler(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    if (!m_active)
+    {
+        return;
+    }
+    if (m_in_field)
+    {
+        card_out();
+    }
+    else
+    {
+        card_in();
+    }
+}
+
+
+static void timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+    APP_ERROR_CHECK(app_sched_event_put(NULL, 0, step_handler));
+}
+
+
+ret_code_t load_gen_start(uint32_t taps)
+{
+    ret_code_t err_code;
+
+    if (!pn532_sim_is_active())
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if (m_active)
+    {
+        return NRF_ERROR_BUSY;
+    }
+    if (!m_timer_created)
+    {
+        err_code = app_timer_create(&m_timer, APP_TIMER_MODE_SINGLE_SHOT, timer_handler);
+        VERIFY_SUCCESS(err_code);
+        m_timer_created = true;
+    }
+
+    memset(&m_report, 0, sizeof(m_report));
+    m_sample_next = 0;
+    m_taps        = taps;
+    m_rand        = LOAD_GEN_SEED | 1;
+    m_pending     = false;
+
+    m_rate_cfg.min          = LOAD_GEN_RATE_MIN;
+    m_rate_cfg.max          = LOAD_GEN_RATE_MAX;
+    m_rate_cfg.incr         = LOAD_GEN_RATE_STEP;
+    m_rate_cfg.start_at_max = false;
+    sensorsim_init(&m_rate, &m_rate_cfg);
+    m_report.rate = LOAD_GEN_RATE_MIN;
+
+    // The field starts empty, one gap before the first card.
+    pn532_sim_card_set(PN532_SIM_CARD_NONE, NULL);
+    m_in_field = false;
+    m_active   = true;
+    err_code   = app_timer_start(m_timer, LOAD_GEN_TICKS(60000 / LOAD_GEN_RATE_MIN), NULL);
+    if (err_code != NRF_SUCCESS)
+    {
+        m_active = false;
+    }
+    return err_code;
+}
+
+
+void load_gen_stop(void)
+{
+    if (!m_active)
+    {
+        return;
+    }
+    m_active  = false;
+    m_pending = false;
+    UNUSED_RETURN_VALUE(app_timer_stop(m_timer));
+    pn532_sim_card_set(PN532_SIM_CARD_NONE, NULL);
+}
+
+
+bool load_gen_is_active(void)
+{
+    return m_active;
+}
+
+
+static uint32_t percentile(uint16_t count, uint8_t pct)
+{
+    // Nearest rank.
+    uint16_t rank = (uint16_t)(((uint32_t)count * pct + 99) / 100);
+
+    return m_sorted[MAX(rank, 1) - 1];
+}
+
+
+void load_gen_report_get(load_gen_report_t * p_report)
+{
+    uint16_t count;
+
+    CRITICAL_REGION_ENTER();
+    *p_report = m_report;
+    count     = (uint16_t)MIN(m_report.decided, LOAD_GEN_SAMPLES);
+    memcpy(m_sorted, m_samples, count * sizeof(m_sorted[0]));
+    CRITICAL_REGION_EXIT();
+
+    // Insertion sort: a few dozen samples, once per report.
+    for (uint16_t i = 1; i < count; i++)
+    {
+        uint32_t value = m_sorted[i];
+        uint16_t j     = i;
+
+        for (; (j > 0) && (m_sorted[j - 1] > value); j--)
+        {
+            m_sorted[j] = m_sorted[j - 1];
+        }
+        m_sorted[j] = value;
+    }
+
+    p_report->samples = count;
+    if (count == 0)
+    {
+        return;
+    }
+    p_report->p50_us = percentile(count, 50);
+    p_report->p90_us = percentile(count, 90);
+    p_report->p99_us = percentile(count, 99);
+    p_report->max_us = m_sorted[count - 1];
+}
+
+
+void load_gen_decided(uint8_t const * p_uid, uint8_t len)
+{
+    uint32_t ticks;
+
+    CRITICAL_REGION_ENTER();
+    if (m_pending && (len == m_uid_len) && (memcmp(p_uid, m_uid, len) == 0))
+    {
+        m_pending = false;
+        UNUSED_RETURN_VALUE(app_timer_cnt_diff_compute(app_timer_cnt_get(), m_placed_at, &ticks));
+        m_samples[m_sample_next] = ticks_to_us(ticks);
+        m_sample_next = (m_sample_next + 1) % LOAD_GEN_SAMPLES;
+        m_report.decided++;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+#endif //NRF_MODULE_ENABLED(LOAD_GEN)
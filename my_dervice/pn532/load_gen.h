@@ -0,0 +1,72 @@
+#ifndef __LOAD_GEN_H__
+#define __LOAD_GEN_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_common.h"
+
+/* Synthetic taps for soak and throughput runs, cards put in the field of the PN532 emulator:
+ *
+ *   rate      taps per minute, swept between LOAD_GEN_RATE_MIN and LOAD_GEN_RATE_MAX as a
+ *             triangle by sensorsim, LOAD_GEN_RATE_STEP per tap; equal ends hold the rate.
+ *             Each gap is spread by up to LOAD_GEN_JITTER_PCT either way
+ *   cards     LOAD_GEN_UIDS cards, each with a type drawn from the LOAD_GEN_MIX_* weights and a
+ *             UID of its length. LOAD_GEN_HOT_PCT of the taps come from the first eighth of
+ *             them, the regulars at a door. A card stays LOAD_GEN_DWELL_MS in the field
+ *   latency   from the card put in the field to the lock decided on it in card_access(), the
+ *             wait for the next scan included; percentiles over the last LOAD_GEN_SAMPLES
+ *   missed    cards taken away again without a decision: not found by the scan, of a type it
+ *             does not poll, or a UID uid_filter still holds off
+ *
+ * The same LOAD_GEN_SEED gives the same taps, so runs compare between releases. The BLE link,
+ * the journal and its GC go on as with real cards. Needs PN532_SIM, and a scan running to find
+ * the cards. */
+
+/**@brief Counters of a run. */
+typedef struct
+{
+    uint32_t placed;        /**< Cards put in the field. */
+    uint32_t decided;       /**< Of those, the ones the lock decided on. */
+    uint32_t missed;        /**< Taken away without a decision. */
+    uint16_t rate;          /**< Taps per minute at present. */
+    uint16_t samples;       /**< Latencies the percentiles are over. */
+    uint32_t p50_us;
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} load_gen_report_t;
+
+#if NRF_MODULE_ENABLED(LOAD_GEN)
+
+/**@brief Start a run from the seed, counters cleared. Main loop.
+ *
+ * @param[in] taps  Taps to make, 0 until @ref load_gen_stop.
+ *
+ * @retval NRF_SUCCESS              The first card comes after one gap.
+ * @retval NRF_ERROR_INVALID_STATE  The driver does not talk to the emulator.
+ * @retval NRF_ERROR_BUSY           A run goes on.
+ */
+ret_code_t load_gen_start(uint32_t taps);
+
+/**@brief Stop the run and empty the field; the counters stay. */
+void load_gen_stop(void);
+
+bool load_gen_is_active(void);
+
+/**@brief Counters and latency percentiles of the last run. Main loop. */
+void load_gen_report_get(load_gen_report_t * p_report);
+
+/**@brief The lock decided on a card; any context. Ends the latency of the card in the field. */
+void load_gen_decided(uint8_t const * p_uid, uint8_t len);
+
+#else
+
+__STATIC_INLINE void load_gen_decided(uint8_t const * p_uid, uint8_t len)
+{
+    UNUSED_PARAMETER(p_uid);
+    UNUSED_PARAMETER(len);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,486 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(LOG_NUS)
+#include "log_nus.h"
+#include "ble_nus.h"
+#include "ble_srv_common.h"
+#include "nrf_log.h"
+#include "nrf_log_ctrl.h"
+#include "nrf_log_backend.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#include "ram_budget.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(NRF_LOG) || !NRF_LOG_DEFERRED || !NRF_LOG_BACKEND_SERIAL_BINARY
+#error "log_nus streams the deferred entries as binary frames, it needs NRF_LOG_ENABLED, NRF_LOG_DEFERRED and NRF_LOG_BACKEND_SERIAL_BINARY"
+#endif
+
+#define LOG_NUS_UUID_SERVICE    0x0012  /**< On the NUS base. */
+#define LOG_NUS_UUID_LOG        0x0013
+#define LOG_NUS_UUID_CTRL       0x0014
+
+#define FRAME_MAX               64      /**< One entry; %s arguments in RAM are cut to fit. */
+#define NAME_LEN                8       /**< Of a module name in a filter. */
+#define LEVELS                  4       /**< Error to debug; internal entries are never dropped. */
+
+STATIC_ASSERT(FRAME_MAX >= NRF_LOG_BACKEND_BINARY_STD_MIN);
+STATIC_ASSERT(IS_POWER_OF_TWO(LOG_NUS_BUF_SIZE) && (LOG_NUS_BUF_SIZE >= FRAME_MAX));
+STATIC_ASSERT(LOG_NUS_BUF_SIZE <= UINT16_MAX);
+
+typedef enum
+{
+    FRAME_PUT,
+    FRAME_DROPPED,
+    FRAME_STALLED,
+} frame_result_t;
+
+typedef struct
+{
+    char    name[NAME_LEN];     /**< Not terminated when all of it is used; empty for a free entry. */
+    uint8_t level;
+} filter_t;
+
+static const char m_drop_info[]  = NRF_LOG_ERROR_COLOR_CODE
+                                   "log_nus: %u error, %u warning, %u info, %u debug dropped\r\n";
+static const char m_stats_info[] = "log_nus: %u sent, %u filtered, %u dropped, %u credits\r\n";
+
+static uint16_t                 m_service_handle;
+static ble_gatts_char_handles_t m_log_handles;
+static ble_gatts_char_handles_t m_ctrl_handles;
+static volatile uint16_t        m_conn_handle = BLE_CONN_HANDLE_INVALID;   /**< Of the subscriber. */
+static volatile uint8_t         m_credits;
+static volatile bool            m_stats_pending;
+
+static uint8_t                  m_ring[LOG_NUS_BUF_SIZE];
+static uint16_t                 m_head;         /**< Free running; the ring index is masked. */
+static uint16_t                 m_tail;
+static bool                     m_stalled;      /**< An entry to keep waits for room. */
+
+static filter_t                 m_filters[LOG_NUS_FILTERS];
+static uint8_t                  m_default_level = LOG_NUS_DEFAULT_LEVEL;
+
+static uint32_t                 m_sent;
+static uint32_t                 m_filtered;
+static uint32_t                 m_dropped;
+static uint32_t                 m_drops[LEVELS];    /**< Not reported yet. */
+
+RAM_BUDGET_REGISTER(m_ring_budget, "log_nus", sizeof(m_ring), NULL);
+
+
+static uint16_t ring_used(void)
+{
+    return (uint16_t)(m_head - m_tail);
+}
+
+
+static void ring_put(uint8_t const * p_data, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        m_ring[(m_head + i) & (LOG_NUS_BUF_SIZE - 1)] = p_data[i];
+    }
+    m_head += len;
+}
+
+
+/**@brief Put a frame of the stream itself, the drop or stats info; never dropped. */
+static bool info_put(char const * p_str, uint32_t * p_args, uint32_t nargs)
+{
+    uint8_t  frame[FRAME_MAX];
+    uint32_t len = nrf_log_backend_binary_std_encode(NRF_LOG_LEVEL_INTERNAL, NULL, p_str, p_args,
+                                                     nargs, frame, sizeof(frame));
+
+    if (len > LOG_NUS_BUF_SIZE - ring_used())
+    {
+        return false;
+    }
+    ring_put(frame, len);
+    return true;
+}
+
+
+/**@brief Report the entries dropped since the last report, ahead of any other. */
+static bool drops_put(void)
+{
+    if ((m_drops[0] | m_drops[1] | m_drops[2] | m_drops[3]) == 0)
+    {
+        return true;
+    }
+    if (!info_put(m_drop_info, m_drops, LEVELS))
+    {
+        return false;
+    }
+    memset(m_drops, 0, sizeof(m_drops));
+    return true;
+}
+
+
+/**@brief Put a frame, or drop the entry if the stream is behind and it is not severe enough to
+ *        wait for room.
+ */
+static frame_result_t frame_put(uint8_t level, uint8_t const * p_frame, uint32_t len)
+{
+    if (drops_put() && (len <= LOG_NUS_BUF_SIZE - ring_used()))
+    {
+        ring_put(p_frame, len);
+        return FRAME_PUT;
+    }
+    if ((level > LOG_NUS_KEEP_LEVEL) && (level <= LEVELS))
+    {
+        m_drops[level - 1]++;
+        m_dropped++;
+        return FRAME_DROPPED;
+    }
+    m_stalled = true;
+    return FRAME_STALLED;
+}
+
+
+/**@brief Whether an entry of @p level goes out, by the filter of its module. The module name is
+ *        in the prefix of the string, after the colour code: "\x1B[1;31mNAME:ERROR:...".
+ */
+static bool entry_passes(uint8_t level, char const * p_str)
+{
+    char const * p_name = p_str;
+    uint8_t      name_len;
+    uint8_t      limit = m_default_level;
+
+    if (level == NRF_LOG_LEVEL_INTERNAL)
+    {
+        return true;
+    }
+
+    if (*p_name == '\x1B')
+    {
+        while ((*p_name != '\0') && (*p_name != 'm'))
+        {
+            p_name++;
+        }
+        if (*p_name == 'm')
+        {
+            p_name++;
+        }
+    }
+    name_len = 0;
+    while ((name_len <= NAME_LEN) && (p_name[name_len] != '\0') && (p_name[name_len] != ':'))
+    {
+        name_len++;
+    }
+
+    // A name too long for the table takes the default.
+    for (uint8_t i = 0; (name_len > 0) && (name_len <= NAME_LEN) && (i < LOG_NUS_FILTERS); i++)
+    {
+        if ((strncmp(m_filters[i].name, p_name, name_len) == 0) &&
+            ((name_len == NAME_LEN) || (m_filters[i].name[name_len] == '\0')))
+        {
+            limit = m_filters[i].level;
+            break;
+        }
+    }
+    return level <= limit;
+}
+
+
+static bool std_handler(uint8_t                severity_level,
+                        const uint32_t * const p_timestamp,
+                        const char * const     p_str,
+                        uint32_t             * p_args,
+                        uint32_t               nargs)
+{
+    uint8_t  frame[FRAME_MAX];
+    uint32_t len;
+    uint8_t  level = severity_level & NRF_LOG_LEVEL_MASK;
+
+    if (!entry_passes(level, p_str))
+    {
+        m_filtered++;
+        return true;
+    }
+
+    len = nrf_log_backend_binary_std_encode(severity_level, p_timestamp, p_str, p_args, nargs,
+                                            frame, sizeof(frame));
+    return frame_put(level, frame, len) != FRAME_STALLED;
+}
+
+
+static uint32_t hexdump_handler(uint8_t                severity_level,
+                                const uint32_t * const p_timestamp,
+                                const char * const     p_str,
+                                uint32_t               offset,
+                                const uint8_t * const  p_buf0,
+                                uint32_t               buf0_length,
+                                const uint8_t * const  p_buf1,
+                                uint32_t               buf1_length)
+{
+    uint8_t  frame[FRAME_MAX];
+    uint32_t len;
+    uint32_t count;
+    uint32_t length = buf0_length + buf1_length;
+    uint8_t  level  = severity_level & NRF_LOG_LEVEL_MASK;
+
+    if (!entry_passes(level, p_str))
+    {
+        m_filtered++;
+        return length;
+    }
+
+    while (offset < length)
+    {
+        len = nrf_log_backend_binary_hexdump_encode(severity_level, p_timestamp, p_str, offset,
+                                                    p_buf0, buf0_length, p_buf1, buf1_length,
+                                                    frame, sizeof(frame), &count);
+        switch (frame_put(level, frame, len))
+        {
+            case FRAME_PUT:
+                offset += count;
+                break;
+
+            case FRAME_DROPPED:
+                // The host sees a dump cut short; the rest of it is of no use.
+                return length;
+
+            default:
+                return offset;
+        }
+    }
+    return offset;
+}
+
+
+/**@brief Notify what the credits allow, up to a NUS payload each. */
+static void pump(void)
+{
+    uint8_t                chunk[BLE_NUS_MAX_DATA_LEN];
+    uint16_t               len;
+    uint16_t               conn_handle = m_conn_handle;
+    ble_gatts_hvx_params_t hvx_params;
+
+    while ((conn_handle != BLE_CONN_HANDLE_INVALID) && (m_credits > 0) && (ring_used() > 0))
+    {
+        len = MIN(ring_used(), sizeof(chunk));
+        for (uint16_t i = 0; i < len; i++)
+        {
+            chunk[i] = m_ring[(m_tail + i) & (LOG_NUS_BUF_SIZE - 1)];
+        }
+
+        memset(&hvx_params, 0, sizeof(hvx_params));
+        hvx_params.handle = m_log_handles.value_handle;
+        hvx_params.type   = BLE_GATT_HVX_NOTIFICATION;
+        hvx_params.p_len  = &len;
+        hvx_params.p_data = chunk;
+
+        if (sd_ble_gatts_hvx(conn_handle, &hvx_params) != NRF_SUCCESS)
+        {
+            // Out of TX buffers, or the link went; TX complete or the next credit comes back.
+            return;
+        }
+        m_tail += len;
+        m_sent++;
+        CRITICAL_REGION_ENTER();
+        if (m_credits > 0)
+        {
+            m_credits--;
+        }
+        CRITICAL_REGION_EXIT();
+    }
+}
+
+
+void log_nus_init(void)
+{
+    nrf_log_frontend_init(std_handler, hexdump_handler, app_timer_cnt_get);
+}
+
+
+ret_code_t log_nus_service_init(uint8_t uuid_type)
+{
+    ret_code_t          err_code;
+    ble_uuid_t          ble_uuid;
+    ble_gatts_char_md_t char_md;
+    ble_gatts_attr_md_t cccd_md;
+    ble_gatts_attr_md_t attr_md;
+    ble_gatts_attr_t    attr_char_value;
+
+    ble_uuid.type = uuid_type;
+    ble_uuid.uuid = LOG_NUS_UUID_SERVICE;
+    err_code = sd_ble_gatts_service_add(BLE_GATTS_SRVC_TYPE_PRIMARY, &ble_uuid, &m_service_handle);
+    VERIFY_SUCCESS(err_code);
+
+    memset(&cccd_md, 0, sizeof(cccd_md));
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&cccd_md.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&cccd_md.write_perm);
+    cccd_md.vloc = BLE_GATTS_VLOC_STACK;
+
+    memset(&char_md, 0, sizeof(char_md));
+    char_md.char_props.notify = 1;
+    char_md.p_cccd_md         = &cccd_md;
+
+    memset(&attr_md, 0, sizeof(attr_md));
+    BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(&attr_md.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(&attr_md.write_perm);
+    attr_md.vloc = BLE_GATTS_VLOC_STACK;
+    attr_md.vlen = 1;
+
+    ble_uuid.uuid = LOG_NUS_UUID_LOG;
+
+    memset(&attr_char_value, 0, sizeof(attr_char_value));
+    attr_char_value.p_uuid    = &ble_uuid;
+    attr_char_value.p_attr_md = &attr_md;
+    attr_char_value.init_len  = 1;
+    attr_char_value.max_len   = BLE_NUS_MAX_DATA_LEN;
+
+    err_code = sd_ble_gatts_characteristic_add(m_service_handle, &char_md, &attr_char_value,
+                                               &m_log_handles);
+    VERIFY_SUCCESS(err_code);
+
+    memset(&char_md, 0, sizeof(char_md));
+    char_md.char_props.write         = 1;
+    char_md.char_props.write_wo_resp = 1;
+
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr_md.write_perm);
+
+    ble_uuid.uuid = LOG_NUS_UUID_CTRL;
+
+    attr_char_value.max_len = 2 + NAME_LEN;
+
+    return sd_ble_gatts_characteristic_add(m_service_handle, &char_md, &attr_char_value,
+                                           &m_ctrl_handles);
+}
+
+
+void log_nus_process(void)
+{
+    uint8_t  batch = 0;
+    uint32_t stats[4];
+
+    if (m_stats_pending)
+    {
+        stats[0] = m_sent;
+        stats[1] = m_filtered;
+        stats[2] = m_dropped;
+        stats[3] = m_credits;
+        m_stats_pending = !info_put(m_stats_info, stats, ARRAY_SIZE(stats));
+    }
+
+    // A few entries a pass, so the scheduler is not held up by a burst of them.
+    m_stalled = false;
+    while (!m_stalled && (batch++ < LOG_NUS_BATCH) && NRF_LOG_PROCESS())
+    {
+    }
+    pump();
+}
+
+
+static void filter_set(uint8_t level, uint8_t const * p_name, uint16_t name_len)
+{
+    filter_t * p_free = NULL;
+
+    if (name_len == 0)
+    {
+        m_default_level = level;
+        return;
+    }
+
+    for (uint8_t i = 0; i < LOG_NUS_FILTERS; i++)
+    {
+        if ((strncmp(m_filters[i].name, (char const *)p_name, name_len) == 0) &&
+            ((name_len == NAME_LEN) || (m_filters[i].name[name_len] == '\0')))
+        {
+            m_filters[i].level = level;
+            return;
+        }
+        if ((p_free == NULL) && (m_filters[i].name[0] == '\0'))
+        {
+            p_free = &m_filters[i];
+        }
+    }
+    if (p_free != NULL)
+    {
+        // A full table keeps the filters it has.
+        memset(p_free->name, 0, sizeof(p_free->name));
+        memcpy(p_free->name, p_name, name_len);
+        p_free->level = level;
+    }
+}
+
+
+static void on_ctrl_write(uint16_t conn_handle, uint8_t const * p_data, uint16_t len)
+{
+    if ((len == 0) || (conn_handle != m_conn_handle))
+    {
+        return;
+    }
+
+    switch (p_data[0])
+    {
+        case LOG_NUS_CREDIT:
+            if (len == 2)
+            {
+                CRITICAL_REGION_ENTER();
+                m_credits = (uint8_t)MIN((uint16_t)m_credits + p_data[1], UINT8_MAX);
+                CRITICAL_REGION_EXIT();
+            }
+            break;
+
+        case LOG_NUS_FILTER:
+            if ((len >= 2) && (len <= 2 + NAME_LEN) && (p_data[1] <= NRF_LOG_LEVEL_DEBUG))
+            {
+                CRITICAL_REGION_ENTER();
+                filter_set(p_data[1], &p_data[2], len - 2);
+                CRITICAL_REGION_EXIT();
+            }
+            break;
+
+        case LOG_NUS_STATS:
+            m_stats_pending = true;
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+void log_nus_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_write_t const * p_evt_write = &p_ble_evt->evt.gatts_evt.params.write;
+    uint16_t                      conn_handle = p_ble_evt->evt.gatts_evt.conn_handle;
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_DISCONNECTED:
+            if (p_ble_evt->evt.gap_evt.conn_handle == m_conn_handle)
+            {
+                // What is in the ring waits for the next subscriber.
+                m_conn_handle = BLE_CONN_HANDLE_INVALID;
+                m_credits     = 0;
+            }
+            break;
+
+        case BLE_GATTS_EVT_WRITE:
+            if ((p_evt_write->handle == m_log_handles.cccd_handle) && (p_evt_write->len == 2))
+            {
+                // The last link to subscribe takes the stream, with no credits yet.
+                if (ble_srv_is_notification_enabled(p_evt_write->data))
+                {
+                    m_conn_handle = conn_handle;
+                    m_credits     = 0;
+                }
+                else if (conn_handle == m_conn_handle)
+                {
+                    m_conn_handle = BLE_CONN_HANDLE_INVALID;
+                    m_credits     = 0;
+                }
+            }
+            else if (p_evt_write->handle == m_ctrl_handles.value_handle)
+            {
+                on_ctrl_write(conn_handle, p_evt_write->data, p_evt_write->len);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(LOG_NUS)
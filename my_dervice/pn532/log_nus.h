@@ -0,0 +1,52 @@
+#ifndef __LOG_NUS_H__
+#define __LOG_NUS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "ble.h"
+
+/* nrf_log over BLE, for the field where no SWD and no UART are attached. A service of its own
+ * on the NUS base, next to NUS:
+ *
+ *   log       characteristic 0x0013, notify: the binary frames of the serial backend
+ *             (NRF_LOG_BACKEND_SERIAL_BINARY) as a byte stream, cut into notifications; the
+ *             host syncs on them and reads the strings from the ELF file (nrf_log_decode.py)
+ *   control   characteristic 0x0014, write: LOG_NUS_CREDIT, n lets n more notifications go;
+ *             LOG_NUS_FILTER, level, name sets the lowest severity a module is streamed at,
+ *             the default for modules without an entry with no name, 0 for none;
+ *             LOG_NUS_STATS has the counters streamed
+ *   credits   a notification goes only against a credit, so the host paces the stream. Credits
+ *             end with the link
+ *   drops     entries wait in the deferred buffer of nrf_log until they fit. When the stream
+ *             can not keep up, entries less severe than LOG_NUS_KEEP_LEVEL are dropped instead
+ *             and counted; the counts go out as an entry of their own once there is room
+ *
+ * Logging only ever queues into the deferred buffer; log_nus_process() in the main loop turns
+ * the entries into frames, so nothing on the card path waits for the link. Log notifications
+ * take the TX buffers after nus_tx, which refills on each acknowledgement first. Takes the
+ * place of the serial backend, whose binary encoder it shares; needs NRF_LOG with NRF_LOG_DEFERRED
+ * and NRF_LOG_BACKEND_SERIAL_BINARY. */
+
+#define LOG_NUS_CREDIT  0
+#define LOG_NUS_FILTER  1
+#define LOG_NUS_STATS   2
+
+/**@brief Start the nrf_log frontend with the handlers of the stream. As early as possible, so
+ *        the boot entries are kept for the first peer.
+ */
+void log_nus_init(void);
+
+/**@brief Add the log service.
+ *
+ * @param[in] uuid_type  Vendor UUID type of the NUS base.
+ */
+ret_code_t log_nus_service_init(uint8_t uuid_type);
+
+/**@brief Turn queued entries into frames and send what the credits allow. Main loop. */
+void log_nus_process(void);
+
+/**@brief Follow the subscription, the credits and the filters. */
+void log_nus_on_ble_evt(ble_evt_t * p_ble_evt);
+
+#endif
@@ -0,0 +1,142 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(MFC_KDF)
+#include "mfc_kdf.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(NRF_CRYPTO_AES)
+#error "mfc_kdf needs NRF_CRYPTO_AES_ENABLED"
+#endif
+
+#define BLOCK_SIZE      NRF_CRYPTO_AES_BLOCK_SIZE
+#define KDF_AES128      0x01    /**< Divider constant of an AES-128 key. */
+#define UID_MAX_LEN     10      /**< Triple size NFCID. */
+#define NTAG_SECTOR     0xFF    /**< Never a Classic sector. */
+
+STATIC_ASSERT(1 + 1 + UID_MAX_LEN + 2 + MFC_KDF_SYS_ID_MAX == 1 + MFC_KDF_INPUT_MAX);
+
+
+ret_code_t mfc_kdf_master_init(mfc_kdf_master_t * p_master,
+                               uint8_t const    * p_key,
+                               uint8_t const    * p_sys_id,
+                               uint8_t            sys_id_len)
+{
+    if (sys_id_len > MFC_KDF_SYS_ID_MAX)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    memcpy(p_master->key, p_key, BLOCK_SIZE);
+    if (sys_id_len > 0)
+    {
+        memcpy(p_master->sys_id, p_sys_id, sys_id_len);
+    }
+    p_master->sys_id_len = sys_id_len;
+
+    return nrf_crypto_aes_cmac_subkeys(p_master->key, p_master->k1, p_master->k2);
+}
+
+
+ret_code_t mfc_kdf_derive(mfc_kdf_master_t const * p_master,
+                          uint8_t const          * p_input,
+                          uint8_t                  len,
+                          uint8_t                * p_key)
+{
+    uint8_t         d[2 * BLOCK_SIZE] = {0};
+    uint8_t const * p_subkey;
+    ret_code_t      err_code;
+
+    if ((len == 0) || (len > MFC_KDF_INPUT_MAX))
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    // Always two blocks, padded or not: AN10922 differs from plain CMAC for short inputs.
+    d[0] = KDF_AES128;
+    memcpy(&d[1], p_input, len);
+    if (len < MFC_KDF_INPUT_MAX)
+    {
+        d[1 + len] = 0x80;
+        p_subkey   = p_master->k2;
+    }
+    else
+    {
+        p_subkey = p_master->k1;
+    }
+    for (uint8_t i = 0; i < BLOCK_SIZE; i++)
+    {
+        d[BLOCK_SIZE + i] ^= p_subkey[i];
+    }
+
+    // CBC with a zero IV; the key is the last block.
+    err_code = nrf_crypto_aes_ecb_encrypt(p_master->key, d, d);
+    VERIFY_SUCCESS(err_code);
+    for (uint8_t i = 0; i < BLOCK_SIZE; i++)
+    {
+        d[BLOCK_SIZE + i] ^= d[i];
+    }
+    return nrf_crypto_aes_ecb_encrypt(p_master->key, &d[BLOCK_SIZE], p_key);
+}
+
+
+/**@brief Key of a UID: M is the UID length, the UID, @p sector, @p type and the system identifier. */
+static ret_code_t uid_derive(mfc_kdf_master_t const * p_master,
+                             uint8_t const          * p_uid,
+                             uint8_t                  uid_len,
+                             uint8_t                  sector,
+                             uint8_t                  type,
+                             uint8_t                * p_key)
+{
+    uint8_t m[MFC_KDF_INPUT_MAX];
+    uint8_t len;
+
+    if (uid_len > UID_MAX_LEN)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    m[0]     = uid_len;
+    memcpy(&m[1], p_uid, uid_len);
+    len      = 1 + uid_len;
+    m[len++] = sector;
+    m[len++] = type;
+    memcpy(&m[len], p_master->sys_id, p_master->sys_id_len);
+    len     += p_master->sys_id_len;
+
+    return mfc_kdf_derive(p_master, m, len, p_key);
+}
+
+
+ret_code_t mfc_kdf_classic(mfc_kdf_master_t const * p_master,
+                           uint8_t const          * p_uid,
+                           uint8_t                  uid_len,
+                           uint8_t                  sector,
+                           uint8_t                  type,
+                           uint8_t                * p_key)
+{
+    uint8_t    key[BLOCK_SIZE];
+    ret_code_t err_code;
+
+    err_code = uid_derive(p_master, p_uid, uid_len, sector, type, key);
+    VERIFY_SUCCESS(err_code);
+    memcpy(p_key, key, 6);
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t mfc_kdf_ntag(mfc_kdf_master_t const * p_master,
+                        uint8_t const          * p_uid,
+                        uint8_t                  uid_len,
+                        uint8_t                * p_pwd,
+                        uint8_t                * p_pack)
+{
+    uint8_t    key[BLOCK_SIZE];
+    ret_code_t err_code;
+
+    err_code = uid_derive(p_master, p_uid, uid_len, NTAG_SECTOR, 0, key);
+    VERIFY_SUCCESS(err_code);
+    memcpy(p_pwd, key, 4);
+    memcpy(p_pack, &key[4], 2);
+    return NRF_SUCCESS;
+}
+
+#endif //NRF_MODULE_ENABLED(MFC_KDF)
@@ -0,0 +1,106 @@
+#ifndef __MFC_KDF_H__
+#define __MFC_KDF_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+#include "nrf_crypto_aes.h"
+
+/* Card keys diversified from a site master key and the UID, AES-128 as in NXP AN10922:
+ *
+ *   master    the CMAC subkeys of the master key are computed once, when the master is set;
+ *             with them a derivation is the two CBC blocks of its 32-byte input and nothing
+ *             else, a few microseconds on the ECB peripheral
+ *   input     0x01, then M of 1 to 31 bytes, padded with 0x80 00.. to 32 bytes; K1 is added
+ *             to the last block of a full input and K2 to that of a padded one
+ *   Classic   M is the UID length, the UID, the sector, the key type and the system identifier
+ *             of the site; the key is the first 6 bytes of the result
+ *   NTAG21x   M is the UID length, the UID, 0xFF in place of the sector, and the system
+ *             identifier; PWD is the first 4 bytes of the result and PACK the next 2
+ *
+ * The length keeps 4, 7 and 10-byte UIDs apart: a shorter UID followed by bytes that happen to
+ * continue it never gives the M of a longer one.
+ *
+ * The key is derived as soon as anticollision gives the UID, so the first authentication of a
+ * provisioned card is also the only one. */
+
+#define MFC_KDF_INPUT_MAX   31  /**< Longest diversification input M. */
+#define MFC_KDF_SYS_ID_MAX  18  /**< Longest system identifier, with a 10-byte UID and its length in M. */
+
+/**@brief Master key state of a site. */
+typedef struct
+{
+    uint8_t key[NRF_CRYPTO_AES_BLOCK_SIZE];
+    uint8_t k1[NRF_CRYPTO_AES_BLOCK_SIZE];
+    uint8_t k2[NRF_CRYPTO_AES_BLOCK_SIZE];
+    uint8_t sys_id[MFC_KDF_SYS_ID_MAX];
+    uint8_t sys_id_len;
+} mfc_kdf_master_t;
+
+/**@brief Set up the state of a master key.
+ *
+ * @param[out] p_master    State.
+ * @param[in]  p_key       Master key, 16 bytes.
+ * @param[in]  p_sys_id    System identifier of the site, can be NULL if @p sys_id_len is 0.
+ * @param[in]  sys_id_len  Up to MFC_KDF_SYS_ID_MAX.
+ *
+ * @retval NRF_SUCCESS               Ready.
+ * @retval NRF_ERROR_INVALID_LENGTH  The system identifier is too long.
+ * @retval NRF_ERROR_INTERNAL        The ECB peripheral did not finish.
+ */
+ret_code_t mfc_kdf_master_init(mfc_kdf_master_t * p_master,
+                               uint8_t const    * p_key,
+                               uint8_t const    * p_sys_id,
+                               uint8_t            sys_id_len);
+
+/**@brief Derive an AES-128 key.
+ *
+ * @param[in]  p_master  State.
+ * @param[in]  p_input   Diversification input M, for DESFire the UID, the AID and the
+ *                       system identifier.
+ * @param[in]  len       1 to MFC_KDF_INPUT_MAX.
+ * @param[out] p_key     Derived key, 16 bytes.
+ *
+ * @retval NRF_SUCCESS               Derived.
+ * @retval NRF_ERROR_INVALID_LENGTH  @p len is out of range.
+ * @retval NRF_ERROR_INTERNAL        The ECB peripheral did not finish.
+ */
+ret_code_t mfc_kdf_derive(mfc_kdf_master_t const * p_master,
+                          uint8_t const          * p_input,
+                          uint8_t                  len,
+                          uint8_t                * p_key);
+
+/**@brief Derive the key of a MIFARE Classic sector.
+ *
+ * @param[in]  p_master  State.
+ * @param[in]  p_uid     UID, 4, 7 or 10 bytes.
+ * @param[in]  uid_len   Its length.
+ * @param[in]  sector    Sector.
+ * @param[in]  type      MFC_KEY_TYPE_A or MFC_KEY_TYPE_B.
+ * @param[out] p_key     Key, 6 bytes.
+ *
+ * @return As @ref mfc_kdf_derive.
+ */
+ret_code_t mfc_kdf_classic(mfc_kdf_master_t const * p_master,
+                           uint8_t const          * p_uid,
+                           uint8_t                  uid_len,
+                           uint8_t                  sector,
+                           uint8_t                  type,
+                           uint8_t                * p_key);
+
+/**@brief Derive the password of an NTAG21x.
+ *
+ * @param[in]  p_master  State.
+ * @param[in]  p_uid     UID, 7 bytes.
+ * @param[in]  uid_len   Its length.
+ * @param[out] p_pwd     PWD, 4 bytes.
+ * @param[out] p_pack    PACK, 2 bytes, the answer a tag provisioned with @p p_pwd gives.
+ *
+ * @return As @ref mfc_kdf_derive.
+ */
+ret_code_t mfc_kdf_ntag(mfc_kdf_master_t const * p_master,
+                        uint8_t const          * p_uid,
+                        uint8_t                  uid_len,
+                        uint8_t                * p_pwd,
+                        uint8_t                * p_pack);
+
+#endif
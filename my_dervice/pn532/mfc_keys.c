@@ -0,0 +1,514 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(MFC_KEYS)
+#include "mfc_keys.h"
+#include "pn532_i2c.h"
+#include "pn532_retry.h"
+#include "fds.h"
+#include <string.h>
+
+#define RESELECT_TIMEOUT  100   /**< InListPassiveTarget timeout when selecting the card again. */
+#define KEY_UNKNOWN       0xFF  /**< No key remembered for the sector. */
+#define KEY_DIVERSIFIED   0xFE  /**< Diversified key, tried ahead of the dictionary. */
+#define ACCESS_UNKNOWN    0xFFFF /**< Access bits of the sector not read yet. */
+#define UID_MAX_LEN       7
+
+/**@brief Keys remembered for one card, by dictionary position per sector, and the access bits
+ *        of its sectors as mifareclassic_AccessDecode() gives them. */
+typedef struct
+{
+    uint8_t  uid_len;
+    uint8_t  uid[UID_MAX_LEN];
+    uint8_t  key_idx[MFC_KEYS_SECTOR_COUNT];
+    uint16_t access[MFC_KEYS_SECTOR_COUNT];
+} mfc_keys_entry_t;
+
+STATIC_ASSERT(sizeof(mfc_keys_entry_t) % sizeof(uint32_t) == 0);
+
+/* Transport keys tried after the site keys: factory default and the MAD/NDEF keys. */
+static mfc_key_t const m_builtin_keys[] =
+{
+    {MFC_KEY_TYPE_A, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}},
+    {MFC_KEY_TYPE_B, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}},
+    {MFC_KEY_TYPE_A, {0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5}},
+    {MFC_KEY_TYPE_A, {0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7}},
+};
+
+STATIC_ASSERT(ARRAY_SIZE(m_builtin_keys) <= MFC_KEYS_DICT_SIZE);
+STATIC_ASSERT(MFC_KEYS_DICT_SIZE < KEY_DIVERSIFIED);
+
+/* Most recently used card first. Written to flash as a single record. */
+__ALIGN(4) static mfc_keys_entry_t m_cache[MFC_KEYS_CACHE_SIZE];
+
+static mfc_key_t const * m_site_keys;
+static uint8_t           m_site_key_count;
+static fds_record_desc_t m_desc;
+static bool              m_record_found;
+static bool              m_dirty;
+static bool              m_write_pending;
+#if NRF_MODULE_ENABLED(MFC_KDF)
+static mfc_kdf_master_t const * mp_kdf_master;
+static uint8_t                  m_kdf_type;
+#endif
+
+
+static uint8_t dict_count(void)
+{
+    return m_site_key_count + ARRAY_SIZE(m_builtin_keys);
+}
+
+
+static mfc_key_t const * dict_key(uint8_t idx)
+{
+    if (idx < m_site_key_count)
+    {
+        return &m_site_keys[idx];
+    }
+    return &m_builtin_keys[idx - m_site_key_count];
+}
+
+
+/**@brief Sector of a block: 4 blocks per sector below block 128, 16 above (4K cards). */
+static uint8_t block_sector(uint32_t block)
+{
+    if (block < 128)
+    {
+        return block / 4;
+    }
+    return 32 + (block - 128) / 16;
+}
+
+
+/**@brief Find the entry for a card and move it to the front, or take over the oldest entry.
+ *
+ * @details Reordering alone does not mark the cache dirty, so a tap with a known key
+ *          costs no flash write.
+ */
+static mfc_keys_entry_t * cache_get(uint8_t const * uid, uint8_t uid_len)
+{
+    mfc_keys_entry_t entry;
+    uint8_t          i;
+
+    if (uid_len > UID_MAX_LEN)
+    {
+        uid_len = UID_MAX_LEN;
+    }
+
+    for (i = 0; i < MFC_KEYS_CACHE_SIZE - 1; i++)
+    {
+        if ((m_cache[i].uid_len == uid_len) && (memcmp(m_cache[i].uid, uid, uid_len) == 0))
+        {
+            break;
+        }
+    }
+
+    entry = m_cache[i];
+    if ((entry.uid_len != uid_len) || (memcmp(entry.uid, uid, uid_len) != 0))
+    {
+        memset(&entry, 0, sizeof(entry));
+        entry.uid_len = uid_len;
+        memcpy(entry.uid, uid, uid_len);
+        memset(entry.key_idx, KEY_UNKNOWN, sizeof(entry.key_idx));
+        memset(entry.access, 0xFF, sizeof(entry.access));
+    }
+
+    memmove(&m_cache[1], &m_cache[0], i * sizeof(m_cache[0]));
+    m_cache[0] = entry;
+
+    return &m_cache[0];
+}
+
+
+static void cache_reset(void)
+{
+    memset(m_cache, 0, sizeof(m_cache));
+    for (uint8_t i = 0; i < MFC_KEYS_CACHE_SIZE; i++)
+    {
+        memset(m_cache[i].key_idx, KEY_UNKNOWN, sizeof(m_cache[i].key_idx));
+        memset(m_cache[i].access, 0xFF, sizeof(m_cache[i].access));
+    }
+}
+
+
+static void cache_load(void)
+{
+    fds_find_token_t   token = {0};
+    fds_flash_record_t record;
+
+    if (fds_record_find(MFC_KEYS_FILE_ID, MFC_KEYS_RECORD_KEY, &m_desc, &token) != FDS_SUCCESS)
+    {
+        return;
+    }
+    m_record_found = true;
+
+    if (fds_record_open(&m_desc, &record) != FDS_SUCCESS)
+    {
+        return;
+    }
+    if (record.p_header->tl.length_words == BYTES_TO_WORDS(sizeof(m_cache)))
+    {
+        memcpy(m_cache, record.p_data, sizeof(m_cache));
+    }
+    (void)fds_record_close(&m_desc);
+}
+
+
+static void cache_store(void)
+{
+    fds_record_chunk_t chunk;
+    fds_record_t       record;
+    ret_code_t         err_code;
+
+    chunk.p_data       = m_cache;
+    chunk.length_words = BYTES_TO_WORDS(sizeof(m_cache));
+
+    record.file_id         = MFC_KEYS_FILE_ID;
+    record.key             = MFC_KEYS_RECORD_KEY;
+    record.data.p_chunks   = &chunk;
+    record.data.num_chunks = 1;
+
+    m_dirty = false;
+    if (m_record_found)
+    {
+        err_code = fds_record_update(&m_desc, &record);
+    }
+    else
+    {
+        err_code = fds_record_write(&m_desc, &record);
+    }
+
+    if (err_code == FDS_SUCCESS)
+    {
+        m_write_pending = true;
+    }
+    else if (err_code == FDS_ERR_NO_SPACE_IN_FLASH)
+    {
+        // Old copies of the record fill the pages; reclaim them and retry once gc is done.
+        m_dirty         = true;
+        m_write_pending = (fds_gc() == FDS_SUCCESS);
+    }
+    else
+    {
+        m_dirty = true;
+    }
+}
+
+
+static void fds_evt_handler(fds_evt_t const * const p_evt)
+{
+    switch (p_evt->id)
+    {
+        case FDS_EVT_INIT:
+            if (p_evt->result == FDS_SUCCESS)
+            {
+                cache_load();
+            }
+            break;
+
+        case FDS_EVT_WRITE:
+        case FDS_EVT_UPDATE:
+            if ((p_evt->write.file_id != MFC_KEYS_FILE_ID) ||
+                (p_evt->write.record_key != MFC_KEYS_RECORD_KEY))
+            {
+                break;
+            }
+            m_write_pending = false;
+            if (p_evt->result == FDS_SUCCESS)
+            {
+                m_record_found = true;
+            }
+            else
+            {
+                m_dirty = true;
+            }
+            break;
+
+        case FDS_EVT_GC:
+            if (m_write_pending && m_dirty)
+            {
+                m_write_pending = false;
+                cache_store();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+ret_code_t mfc_keys_init(void)
+{
+    ret_code_t err_code;
+
+    cache_reset();
+
+    err_code = fds_register(fds_evt_handler);
+    VERIFY_SUCCESS(err_code);
+
+    return fds_init();
+}
+
+
+ret_code_t mfc_keys_dict_set(mfc_key_t const * p_keys, uint8_t count)
+{
+    if ((p_keys == NULL) && (count != 0))
+    {
+        return NRF_ERROR_NULL;
+    }
+    if (count + ARRAY_SIZE(m_builtin_keys) > MFC_KEYS_DICT_SIZE)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    m_site_keys      = p_keys;
+    m_site_key_count = count;
+
+    return NRF_SUCCESS;
+}
+
+
+#if NRF_MODULE_ENABLED(MFC_KDF)
+void mfc_keys_kdf_set(mfc_kdf_master_t const * p_master, uint8_t type)
+{
+    mp_kdf_master = p_master;
+    m_kdf_type    = type;
+}
+#endif
+
+
+/**@brief Diversified key of a sector, false if there is none. */
+static bool kdf_key(uint8_t const * uid, uint8_t uidLen, uint8_t sector, mfc_key_t * p_key)
+{
+#if NRF_MODULE_ENABLED(MFC_KDF)
+    if (mp_kdf_master == NULL)
+    {
+        return false;
+    }
+    p_key->type = m_kdf_type;
+    return (mfc_kdf_classic(mp_kdf_master, uid, uidLen, sector, m_kdf_type, p_key->key) == NRF_SUCCESS);
+#else
+    UNUSED_PARAMETER(uid);
+    UNUSED_PARAMETER(uidLen);
+    UNUSED_PARAMETER(sector);
+    UNUSED_PARAMETER(p_key);
+    return false;
+#endif
+}
+
+
+/**@brief Authenticate with one key; an answer lost on the air says nothing about the key, so
+ *        it is tried again after a reselect. */
+static uint8_t key_try(uint8_t * uid, uint8_t uidLen, uint32_t block, mfc_key_t const * p_key)
+{
+#if NRF_MODULE_ENABLED(PN532_RETRY)
+    uint8_t tries = 0;
+
+    do
+    {
+        if (mifareclassic_AuthenticateBlock(uid, uidLen, block, p_key->type, (uint8_t *)p_key->key))
+        {
+            return 1;
+        }
+    } while (pn532_retry_recover(&tries));
+    return 0;
+#else
+    return mifareclassic_AuthenticateBlock(uid, uidLen, block, p_key->type, (uint8_t *)p_key->key);
+#endif
+}
+
+
+/**@brief Get the card active again after a refused key, which leaves it idle. */
+static bool card_reselect(uint8_t const * uid, uint8_t uidLen)
+{
+#if NRF_MODULE_ENABLED(PN532_RETRY)
+    // WUPA and SELECT with the known UID: the same card, no anticollision.
+    UNUSED_PARAMETER(uid);
+    UNUSED_PARAMETER(uidLen);
+    return (pn532_retry_reselect() == 0);
+#else
+    uint8_t sel_uid[PN532_UID_MAX_LEN];
+    uint8_t sel_len;
+
+    return readPassiveTargetID(PN532_MIFARE_ISO14443A, sel_uid, &sel_len, RESELECT_TIMEOUT) &&
+           (sel_len == uidLen) && (memcmp(sel_uid, uid, uidLen) == 0);
+#endif
+}
+
+
+/**@brief Key types that may do @p ops to the block, bit n for key type n; both if the access
+ *        bits of the sector are not known yet. */
+static uint8_t key_types_allowed(mfc_keys_entry_t const * p_entry, uint8_t sector, uint32_t block,
+                                 uint8_t ops)
+{
+    uint8_t types = 0;
+
+    if ((sector >= MFC_KEYS_SECTOR_COUNT) || (p_entry->access[sector] == ACCESS_UNKNOWN))
+    {
+        return (1 << MFC_KEY_TYPE_A) | (1 << MFC_KEY_TYPE_B);
+    }
+    for (uint8_t type = MFC_KEY_TYPE_A; type <= MFC_KEY_TYPE_B; type++)
+    {
+        uint8_t allowed = mifareclassic_AccessOps(p_entry->access[sector],
+                                                  mifareclassic_AccessGroup(block), type);
+        if ((allowed & ops) == ops)
+        {
+            types |= (1 << type);
+        }
+    }
+    return types;
+}
+
+
+/**@brief Read and keep the access bits of the sector just authenticated; any key may. */
+static void access_learn(mfc_keys_entry_t * p_entry, uint8_t sector, uint32_t block)
+{
+    uint8_t  trailer[16];
+    uint16_t access;
+
+    while (!mifareclassic_IsTrailerBlock(block))
+    {
+        block++;
+    }
+    if (mifareclassic_ReadDataBlock((uint8_t)block, trailer) &&
+        mifareclassic_AccessDecode(trailer, &access))
+    {
+        p_entry->access[sector] = access;
+        m_dirty = true;
+    }
+}
+
+
+static uint8_t keys_authenticate(uint8_t * uid, uint8_t uidLen, uint32_t block, uint8_t ops)
+{
+    mfc_keys_entry_t * p_entry = cache_get(uid, uidLen);
+    uint8_t            sector  = block_sector(block);
+    uint8_t            hint    = KEY_UNKNOWN;
+    uint8_t            count   = dict_count();
+    uint8_t            types   = key_types_allowed(p_entry, sector, block, ops);
+    bool               first   = true;
+    mfc_key_t          div_key;
+
+    // No key may, as the access bits say: the card is not asked at all.
+    if (types == 0)
+    {
+        return 0;
+    }
+
+    if (sector < MFC_KEYS_SECTOR_COUNT)
+    {
+        hint = p_entry->key_idx[sector];
+        if (hint >= count)
+        {
+            hint = KEY_UNKNOWN;
+        }
+    }
+
+    // Remembered key first, then the diversified one, then the dictionary in order without
+    // repeating the first; only keys of a type the access bits allow.
+    for (uint16_t n = 0; n <= count + 1; n++)
+    {
+        uint8_t           idx;
+        mfc_key_t const * p_key;
+
+        if (n == 0)
+        {
+            if (hint == KEY_UNKNOWN)
+            {
+                continue;
+            }
+            idx = hint;
+        }
+        else if (n == 1)
+        {
+            if (!kdf_key(uid, uidLen, sector, &div_key))
+            {
+                continue;
+            }
+            idx = KEY_DIVERSIFIED;
+        }
+        else
+        {
+            idx = n - 2;
+            if (idx == hint)
+            {
+                continue;
+            }
+        }
+
+        p_key = (idx == KEY_DIVERSIFIED) ? &div_key : dict_key(idx);
+        if ((types & (1 << p_key->type)) == 0)
+        {
+            continue;
+        }
+
+        if (!first && !card_reselect(uid, uidLen))
+        {
+            return 0;
+        }
+        first = false;
+
+        if (!key_try(uid, uidLen, block, p_key))
+        {
+            continue;
+        }
+        if ((sector < MFC_KEYS_SECTOR_COUNT) && (p_entry->access[sector] == ACCESS_UNKNOWN))
+        {
+            // First time in this sector: a key that may not do the operation is no use.
+            access_learn(p_entry, sector, block);
+            types = key_types_allowed(p_entry, sector, block, ops);
+            if (types == 0)
+            {
+                return 0;
+            }
+            if ((types & (1 << p_key->type)) == 0)
+            {
+                continue;
+            }
+        }
+        if ((idx != KEY_DIVERSIFIED) && (sector < MFC_KEYS_SECTOR_COUNT) &&
+            (p_entry->key_idx[sector] != idx))
+        {
+            p_entry->key_idx[sector] = idx;
+            m_dirty = true;
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+uint8_t mfc_keys_authenticate(uint8_t * uid, uint8_t uidLen, uint32_t block, void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    return keys_authenticate(uid, uidLen, block, MIFARE_ACCESS_READ);
+}
+
+
+uint8_t mfc_keys_authenticate_write(uint8_t * uid, uint8_t uidLen, uint32_t block, void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    // mifareclassic_WriteRange reads each block before it writes it, and reads it back.
+    return keys_authenticate(uid, uidLen, block, MIFARE_ACCESS_READ | MIFARE_ACCESS_WRITE);
+}
+
+
+void mfc_keys_flush(void)
+{
+    if (m_dirty && !m_write_pending)
+    {
+        cache_store();
+    }
+}
+
+
+void mfc_keys_clear(void)
+{
+    cache_reset();
+    m_dirty = true;
+    mfc_keys_flush();
+}
+
+#endif //NRF_MODULE_ENABLED(MFC_KEYS)
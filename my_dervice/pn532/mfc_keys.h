@@ -0,0 +1,86 @@
+#ifndef __MFC_KEYS_H__
+#define __MFC_KEYS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "mfc_kdf.h"
+
+#define MFC_KEY_TYPE_A  0  /**< Authenticate with key A (MIFARE_CMD_AUTH_A). */
+#define MFC_KEY_TYPE_B  1  /**< Authenticate with key B (MIFARE_CMD_AUTH_B). */
+
+/**@brief One dictionary entry. */
+typedef struct
+{
+    uint8_t type;    /**< MFC_KEY_TYPE_A or MFC_KEY_TYPE_B. */
+    uint8_t key[6];  /**< Key value. */
+} mfc_key_t;
+
+/**@brief Register with fds and load the key cache from flash.
+ *
+ * @details The cache is loaded when fds reports that it is initialized; until then
+ *          authentication works from the dictionary alone. Requires the SoftDevice to be
+ *          enabled and system events to be forwarded to fs_sys_event_handler().
+ */
+ret_code_t mfc_keys_init(void);
+
+/**@brief Install the site keys.
+ *
+ * @details The keys are tried in the given order, ahead of the built-in transport keys. The
+ *          table is referenced, not copied. Cache entries refer to keys by position, so changing
+ *          the table only costs one extra attempt per remembered sector.
+ *
+ * @param[in] p_keys  Key table, NULL to use the built-in keys only.
+ * @param[in] count   Number of entries in @p p_keys.
+ *
+ * @retval NRF_SUCCESS               Keys installed.
+ * @retval NRF_ERROR_INVALID_LENGTH  More than MFC_KEYS_DICT_SIZE keys in total.
+ */
+ret_code_t mfc_keys_dict_set(mfc_key_t const * p_keys, uint8_t count);
+
+/**@brief Try keys diversified from a site master key ahead of the dictionary.
+ *
+ * @details The key of a sector is derived from the UID with mfc_kdf_classic() right before its
+ *          first attempt. A card that takes it is not remembered, there is nothing to remember;
+ *          one that takes a dictionary key instead gets that key first from then on. Needs
+ *          MFC_KDF.
+ *
+ * @param[in] p_master  Master state, referenced, not copied. NULL to stop.
+ * @param[in] type      MFC_KEY_TYPE_A or MFC_KEY_TYPE_B, as the site provisions its cards.
+ */
+void mfc_keys_kdf_set(mfc_kdf_master_t const * p_master, uint8_t type);
+
+/**@brief Authenticate a block with the first key that works.
+ *
+ * @details The key remembered for this card and sector is tried first, then the diversified
+ *          key, if any, and the rest of the dictionary. A failed authentication leaves the card
+ *          halted, so the card is selected again before each further attempt. Matches
+ *          @ref mifareclassic_auth_handler_t.
+ *
+ *          The first authentication in a sector also reads its trailer, and the access bits are
+ *          remembered with the keys. From then on only keys of a type that may read the block
+ *          are tried, and a block no key may read is refused without asking the card.
+ *
+ * @param[in] uid        Card UID as returned by readPassiveTargetID().
+ * @param[in] uidLen     UID length.
+ * @param[in] block      Block to authenticate.
+ * @param[in] p_context  Unused.
+ *
+ * @return 1 if the block is authenticated, 0 if no key worked, none may, or the card went
+ *         away.
+ */
+uint8_t mfc_keys_authenticate(uint8_t * uid, uint8_t uidLen, uint32_t block, void * p_context);
+
+/**@brief As @ref mfc_keys_authenticate, for a block that is read and then written. */
+uint8_t mfc_keys_authenticate_write(uint8_t * uid, uint8_t uidLen, uint32_t block, void * p_context);
+
+/**@brief Write the key cache to flash if it changed.
+ *
+ * @details Call once the card session is over; the write completes in the background.
+ */
+void mfc_keys_flush(void);
+
+/**@brief Forget all remembered keys, in RAM and in flash. */
+void mfc_keys_clear(void);
+
+#endif
@@ -0,0 +1,251 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(NFC_PAIR)
+#include "nfc_pair.h"
+#include "nfc_t2t_lib.h"
+#include "nfc_ble_pair_msg.h"
+#include "nfc_ndef_record.h"
+#include "ble_advdata.h"
+#include "pn532_duty.h"
+#include "app_scheduler.h"
+#include "app_error.h"
+#include "nrf_soc.h"
+#include "nrf_peripherals.h"
+#include <string.h>
+
+#ifndef NFCT_PRESENT
+#error "nfc_pair needs the NFCT peripheral of the nRF52"
+#endif
+
+#define NDEF_MAX_LEN    250        /**< Fits the 1-byte length of the NDEF TLV. */
+#define TK_GROUP_SIZE   2
+#define TLV_NDEF        0x03
+#define TLV_TERMINATOR  0xFE
+#define TLV_HDR_LEN     2
+#define AD_ADDR_PUBLIC  0          /**< Last byte of the LE Bluetooth Device Address AD type. */
+#define AD_ADDR_RANDOM  1
+
+/* The tag memory as the reader sees it, laid out once: NDEF TLV, the message, terminator TLV.
+ * A new TK, or a new address, is written over the old one in place. */
+static uint8_t                m_image[TLV_HDR_LEN + NDEF_MAX_LEN + 1];
+static uint16_t               m_image_len;
+static uint8_t *              m_tk_group[TK_GROUP_SIZE];   /**< TK fields in m_image. */
+static uint8_t *              mp_addr;                     /**< Address field in m_image, or NULL. */
+static ble_advdata_tk_value_t m_tk;                        /**< TK in the emulated tag. */
+static ble_advdata_tk_value_t m_tk_read;                   /**< TK the last phone read, for its pairing. */
+static volatile bool          m_tk_read_valid;
+static volatile bool          m_read;                      /**< The tag was read in this field. */
+static volatile bool          m_renew_queued;
+
+
+static ret_code_t tk_generate(ble_advdata_tk_value_t * p_tk)
+{
+    uint8_t available;
+
+    // The SoftDevice fills its pool from the RNG at startup; wait for it only if it is short.
+    do
+    {
+        UNUSED_RETURN_VALUE(sd_rand_application_bytes_available_get(&available));
+    } while (available < sizeof(p_tk->tk));
+
+    return sd_rand_application_vector_get(p_tk->tk, sizeof(p_tk->tk));
+}
+
+
+/**@brief Find the LE Bluetooth Device Address in the payload of the LE OOB record.
+ *
+ * @param[in] p_msg    The simplified LE OOB message: one record of AD structures.
+ * @param[in] msg_len  Its length.
+ *
+ * @return The address field, or NULL.
+ */
+static uint8_t * addr_field_find(uint8_t * p_msg, uint32_t msg_len)
+{
+    uint8_t  flags    = p_msg[0];
+    uint32_t type_len = p_msg[1];
+    uint32_t offset   = 2;                // Flags and TYPE_LENGTH.
+    uint32_t id_len   = 0;
+    uint32_t payload_len;
+
+    if (flags & NDEF_RECORD_SR_MASK)
+    {
+        payload_len = p_msg[offset];
+        offset     += NDEF_RECORD_PAYLOAD_LEN_SHORT_SIZE;
+    }
+    else
+    {
+        payload_len = uint32_big_decode(&p_msg[offset]);
+        offset     += NDEF_RECORD_PAYLOAD_LEN_LONG_SIZE;
+    }
+    if (flags & NDEF_RECORD_IL_MASK)
+    {
+        id_len  = p_msg[offset];
+        offset += NDEF_RECORD_ID_LEN_SIZE;
+    }
+    offset += type_len + id_len;
+
+    if (offset + payload_len > msg_len)
+    {
+        return NULL;
+    }
+
+    for (uint32_t end = offset + payload_len;
+         offset + ADV_AD_DATA_OFFSET + AD_TYPE_BLE_DEVICE_ADDR_DATA_SIZE <= end;
+         offset += ADV_LENGTH_FIELD_SIZE + p_msg[offset])
+    {
+        if ((p_msg[offset] == ADV_AD_TYPE_FIELD_SIZE + AD_TYPE_BLE_DEVICE_ADDR_DATA_SIZE) &&
+            (p_msg[offset + 1] == BLE_GAP_AD_TYPE_LE_BLUETOOTH_DEVICE_ADDRESS))
+        {
+            return &p_msg[offset + ADV_AD_DATA_OFFSET];
+        }
+    }
+    return NULL;
+}
+
+
+/**@brief Write the current address over the one in the image, for a private address that has
+ *        changed since.
+ */
+static void addr_patch(void)
+{
+    ble_gap_addr_t addr;
+
+    if (mp_addr == NULL)
+    {
+        return;
+    }
+#if (NRF_SD_BLE_API_VERSION == 3)
+    if (sd_ble_gap_addr_get(&addr) != NRF_SUCCESS)
+#else
+    if (sd_ble_gap_address_get(&addr) != NRF_SUCCESS)
+#endif
+    {
+        return;
+    }
+    memcpy(mp_addr, addr.addr, BLE_GAP_ADDR_LEN);
+    mp_addr[BLE_GAP_ADDR_LEN] = (addr.addr_type == BLE_GAP_ADDR_TYPE_PUBLIC) ? AD_ADDR_PUBLIC :
+                                                                               AD_ADDR_RANDOM;
+}
+
+
+/**@brief Main loop: patch a new TK into the image. */
+static void renew_handler(void * p_event_data, uint16_t event_size)
+{
+    ret_code_t err_code;
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    m_renew_queued = false;
+
+    // The library reads the image where it is: stopped, no reader sees it half written.
+    err_code = nfc_t2t_emulation_stop();
+    APP_ERROR_CHECK(err_code);
+    err_code = tk_generate(&m_tk);
+    APP_ERROR_CHECK(err_code);
+    err_code = nfc_tk_group_modifier_update(&m_tk);
+    APP_ERROR_CHECK(err_code);
+    addr_patch();
+    err_code = nfc_t2t_emulation_start();
+    APP_ERROR_CHECK(err_code);
+}
+
+
+/**@brief NFCT interrupt. */
+static void nfc_callback(void          * p_context,
+                         nfc_t2t_event_t event,
+                         const uint8_t * p_data,
+                         size_t          data_length)
+{
+    UNUSED_PARAMETER(p_context);
+    UNUSED_PARAMETER(p_data);
+    UNUSED_PARAMETER(data_length);
+
+    switch (event)
+    {
+        case NFC_T2T_EVENT_FIELD_ON:
+            pn532_duty_hold(true);
+            break;
+
+        case NFC_T2T_EVENT_DATA_READ:
+            // Kept for the pairing of this phone, which may well start before it leaves.
+            m_tk_read       = m_tk;
+            m_tk_read_valid = true;
+            m_read          = true;
+            break;
+
+        case NFC_T2T_EVENT_FIELD_OFF:
+            pn532_duty_hold(false);
+            if (m_read && !m_renew_queued)
+            {
+                m_read         = false;
+                m_renew_queued = (app_sched_event_put(NULL, 0, renew_handler) == NRF_SUCCESS);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+ret_code_t nfc_pair_init(void)
+{
+    ret_code_t err_code;
+    uint32_t   ndef_len;
+
+    err_code = tk_generate(&m_tk);
+    VERIFY_SUCCESS(err_code);
+
+    // Encoded once, straight into the image, so the TK locations point into it.
+    ndef_len = NDEF_MAX_LEN;
+    err_code = nfc_ble_pair_msg_updatable_tk_encode(NFC_BLE_PAIR_MSG_BLUETOOTH_LE_SHORT,
+                                                    &m_tk,
+                                                    NULL,
+                                                    &m_image[TLV_HDR_LEN],
+                                                    &ndef_len,
+                                                    m_tk_group,
+                                                    TK_GROUP_SIZE);
+    VERIFY_SUCCESS(err_code);
+
+    m_image[0]                      = TLV_NDEF;
+    m_image[1]                      = (uint8_t)ndef_len;
+    m_image[TLV_HDR_LEN + ndef_len] = TLV_TERMINATOR;
+    m_image_len                     = TLV_HDR_LEN + ndef_len + 1;
+    mp_addr                         = addr_field_find(&m_image[TLV_HDR_LEN], ndef_len);
+
+    err_code = nfc_t2t_setup(nfc_callback, NULL);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = nfc_t2t_payload_raw_set(m_image, m_image_len);
+    VERIFY_SUCCESS(err_code);
+
+    return nfc_t2t_emulation_start();
+}
+
+
+void nfc_pair_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    ble_gap_evt_t const * p_gap_evt = &p_ble_evt->evt.gap_evt;
+
+    if ((p_ble_evt->header.evt_id != BLE_GAP_EVT_AUTH_KEY_REQUEST) ||
+        (p_gap_evt->params.auth_key_request.key_type != BLE_GAP_AUTH_KEY_TYPE_OOB))
+    {
+        return;
+    }
+
+    // Only a phone that read the tag has OOB data; without a read the pairing is refused.
+    if (m_tk_read_valid)
+    {
+        UNUSED_RETURN_VALUE(sd_ble_gap_auth_key_reply(p_gap_evt->conn_handle,
+                                                      BLE_GAP_AUTH_KEY_TYPE_OOB,
+                                                      m_tk_read.tk));
+    }
+    else
+    {
+        UNUSED_RETURN_VALUE(sd_ble_gap_auth_key_reply(p_gap_evt->conn_handle,
+                                                      BLE_GAP_AUTH_KEY_TYPE_NONE,
+                                                      NULL));
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(NFC_PAIR)
@@ -0,0 +1,34 @@
+#ifndef __NFC_PAIR_H__
+#define __NFC_PAIR_H__
+
+#include "sdk_errors.h"
+#include "ble.h"
+
+/* BLE OOB pairing from a tap on the lock, for the nRF52 variants with the NFCT peripheral:
+ *
+ *   tag         the NFCT emulates a Type 2 Tag with an LE OOB message: the lock's address,
+ *               name and role, and a random Temporary Key, so the phone connects without a scan
+ *   pairing     legacy OOB, when the phone has the TK and asks for it; phones that never read
+ *               the tag pair Just Works through peer_bond as before
+ *   next        once a phone has read the tag and left the field, a new TK, and the current
+ *               address, are written over the old ones in the main loop; the TK that was
+ *               read stays valid for its pairing
+ *   image       the tag memory (NDEF TLV, message, terminator) is encoded once at init and
+ *               handed to nfc_t2t_payload_raw_set(); later changes only patch the TK and
+ *               address fields at the offsets found then
+ *   PN532       while a phone is in the emulated field the PN532 bursts are held off, at the
+ *               slow interval, so two fields do not garble each other
+ *
+ * The nRF51 has no NFCT; NFC_PAIR_ENABLED stays 0 there. */
+
+/**@brief Encode the first message and start the emulation.
+ *
+ * @note Call after gap_params_init() and advertising_init(): the message is encoded from the
+ *       GAP settings of the SoftDevice. Requires app_scheduler.
+ */
+ret_code_t nfc_pair_init(void);
+
+/**@brief Answer the OOB key request of a pairing. Call from the BLE event dispatch. */
+void nfc_pair_on_ble_evt(ble_evt_t * p_ble_evt);
+
+#endif
@@ -0,0 +1,170 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(NTAG_AUTH)
+#include "ntag_auth.h"
+#include "ecc.h"
+#include "pn532_i2c.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(ECC)
+#error "ntag_auth needs ECC_ENABLED"
+#endif
+
+#define UID_LEN      7
+#define HALF_LEN     (NTAG2XX_SIG_LEN / 2)
+#define WORDS(len)   (((len) + 3) / 4)
+
+STATIC_ASSERT(NTAG_AUTH_CACHE_SIZE > 0);
+STATIC_ASSERT(NTAG2XX_SIG_LEN == 2 * ECC_P128_SK_LEN);
+
+/**@brief NXP's originality key of the NTAG21x, X then Y, little-endian. */
+static uint32_t const m_nxp_key[WORDS(ECC_P128_PK_LEN)] =
+{
+    0xE68A499B, 0x3DC10E5D, 0x6D3D3CFE, 0x494E1A38,
+    0x5BE8BC61, 0x89ED19FE, 0xB132393E, 0x1C202DB5
+};
+
+typedef struct
+{
+    uint8_t uid[UID_LEN];
+    bool    genuine;
+} cache_entry_t;
+
+static mfc_kdf_master_t const * mp_master;
+static cache_entry_t            m_cache[NTAG_AUTH_CACHE_SIZE];  /**< Most recent first. */
+static uint8_t                  m_count;
+
+
+/**@brief Look up a UID; a hit moves to the front. */
+static cache_entry_t const * cache_find(uint8_t const * p_uid)
+{
+    for (uint8_t i = 0; i < m_count; i++)
+    {
+        if (memcmp(m_cache[i].uid, p_uid, UID_LEN) == 0)
+        {
+            cache_entry_t entry = m_cache[i];
+
+            memmove(&m_cache[1], &m_cache[0], i * sizeof(cache_entry_t));
+            m_cache[0] = entry;
+            return &m_cache[0];
+        }
+    }
+    return NULL;
+}
+
+
+/**@brief Put a UID in front, dropping the least recent one when full. */
+static void cache_add(uint8_t const * p_uid, bool genuine)
+{
+    if (m_count < NTAG_AUTH_CACHE_SIZE)
+    {
+        m_count++;
+    }
+    memmove(&m_cache[1], &m_cache[0], (m_count - 1) * sizeof(cache_entry_t));
+    memcpy(m_cache[0].uid, p_uid, UID_LEN);
+    m_cache[0].genuine = genuine;
+}
+
+
+static void reverse(uint8_t * p_dst, uint8_t const * p_src, uint8_t len)
+{
+    for (uint8_t i = 0; i < len; i++)
+    {
+        p_dst[i] = p_src[len - 1 - i];
+    }
+}
+
+
+/**@brief READ_SIG and the check against the NXP key. */
+static ret_code_t sig_check(uint8_t const * p_uid, bool * p_genuine)
+{
+    uint8_t  sig_be[NTAG2XX_SIG_LEN];
+    uint32_t sig[WORDS(NTAG2XX_SIG_LEN)];
+    uint32_t hash[WORDS(UID_LEN)];
+    ret_code_t err_code;
+
+    if (!ntag2xx_ReadSig(sig_be))
+    {
+        return NRF_ERROR_TIMEOUT;
+    }
+
+    // The UID is the message, a big-endian number as short as a hash; r and s are big-endian.
+    reverse((uint8_t *)hash, p_uid, UID_LEN);
+    reverse((uint8_t *)sig, sig_be, HALF_LEN);
+    reverse((uint8_t *)sig + HALF_LEN, &sig_be[HALF_LEN], HALF_LEN);
+
+    err_code = ecc_p128_verify((uint8_t const *)m_nxp_key, (uint8_t const *)hash, UID_LEN,
+                               (uint8_t const *)sig);
+    if ((err_code != NRF_SUCCESS) && (err_code != NRF_ERROR_INVALID_DATA))
+    {
+        return err_code;
+    }
+    *p_genuine = (err_code == NRF_SUCCESS);
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t pwd_check(uint8_t const * p_uid)
+{
+    uint8_t    pwd[NTAG2XX_PWD_LEN];
+    uint8_t    pack[NTAG2XX_PACK_LEN];
+    uint8_t    answer[NTAG2XX_PACK_LEN];
+    ret_code_t err_code;
+
+    err_code = mfc_kdf_ntag(mp_master, p_uid, UID_LEN, pwd, pack);
+    VERIFY_SUCCESS(err_code);
+
+    if (!ntag2xx_PwdAuth(pwd, answer) || (memcmp(answer, pack, sizeof(pack)) != 0))
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+    return NRF_SUCCESS;
+}
+
+
+void ntag_auth_init(mfc_kdf_master_t const * p_master)
+{
+    mp_master = p_master;
+}
+
+
+ret_code_t ntag_auth_check(uint8_t const * p_uid, uint8_t uid_len)
+{
+    cache_entry_t const * p_entry;
+    bool                  genuine;
+    ret_code_t            err_code;
+
+    if (uid_len != UID_LEN)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    p_entry = cache_find(p_uid);
+    if (p_entry != NULL)
+    {
+        genuine = p_entry->genuine;
+    }
+    else
+    {
+        err_code = sig_check(p_uid, &genuine);
+        VERIFY_SUCCESS(err_code);
+        cache_add(p_uid, genuine);
+    }
+    if (!genuine)
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    if (mp_master != NULL)
+    {
+        return pwd_check(p_uid);
+    }
+    return NRF_SUCCESS;
+}
+
+
+void ntag_auth_cache_clear(void)
+{
+    m_count = 0;
+}
+
+#endif //NRF_MODULE_ENABLED(NTAG_AUTH)
@@ -0,0 +1,45 @@
+#ifndef __NTAG_AUTH_H__
+#define __NTAG_AUTH_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+#include "mfc_kdf.h"
+
+/* NTAG21x tags checked before their UID is let through:
+ *
+ *   origin    READ_SIG gives NXP's signature of the UID on secp128r1, checked with ecc against
+ *             the NXP public key: a tag that is not NXP's, or whose UID was changed, fails
+ *   password  PWD_AUTH with the password of the UID, derived with mfc_kdf_ntag(); the PACK the
+ *             tag answers must be the derived one too, so a tag that takes any password fails
+ *
+ * The ECC of the signature check is the slowest step of a tap on the nRF51, so its outcome is
+ * kept in a RAM cache of the NTAG_AUTH_CACHE_SIZE UIDs checked last: a known card skips READ_SIG
+ * and costs PWD_AUTH alone, one frame. Only outcomes are cached; a tag that did not answer is
+ * asked again on the next tap. */
+
+/**@brief Set the master the passwords are derived from.
+ *
+ * @param[in] p_master  Master state, referenced, not copied. NULL to skip PWD_AUTH.
+ */
+void ntag_auth_init(mfc_kdf_master_t const * p_master);
+
+/**@brief Check the selected tag.
+ *
+ * @details The tag must have been selected with readPassiveTargetID(). A tag that fails leaves
+ *          it HALTed.
+ *
+ * @param[in] p_uid    UID from anticollision.
+ * @param[in] uid_len  Its length, 7.
+ *
+ * @retval NRF_SUCCESS               Genuine, and it took its password.
+ * @retval NRF_ERROR_INVALID_DATA    The signature does not fit the UID, or the tag refused the
+ *                                   password or answered the wrong PACK.
+ * @retval NRF_ERROR_INVALID_LENGTH  Not a 7-byte UID.
+ * @retval NRF_ERROR_TIMEOUT         The tag did not answer READ_SIG.
+ */
+ret_code_t ntag_auth_check(uint8_t const * p_uid, uint8_t uid_len);
+
+/**@brief Forget the cached signature checks. */
+void ntag_auth_cache_clear(void);
+
+#endif
@@ -0,0 +1,338 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(NUS_BENCH)
+#include "nus_bench.h"
+#include "link_stats.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(LINK_STATS)
+#error "nus_bench reports the stalls and the interval of link_stats, it needs LINK_STATS_ENABLED"
+#endif
+
+#define BENCH_TICKS(ms)         APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+#define INTERVAL_MIN            6       /**< 7.5 ms. */
+#define INTERVAL_MAX            400     /**< 500 ms, so the supervision timeout covers it. */
+#define SUP_TIMEOUT             400     /**< 4 s, in 10 ms units. */
+
+typedef enum
+{
+    BENCH_IDLE,
+    BENCH_PARAM_WAIT,           /**< Stream asked for an interval and waits for the answer. */
+    BENCH_TX,
+    BENCH_RX,
+} bench_state_t;
+
+APP_TIMER_DEF(m_timer);
+
+static ble_nus_t *             m_p_nus;
+static volatile bench_state_t  m_state;
+static uint16_t                m_conn_handle = BLE_CONN_HANDLE_INVALID;
+static uint32_t                m_total;         /**< Bytes of the run. */
+static uint32_t                m_done;          /**< Bytes sent or taken. */
+static uint8_t                 m_len;           /**< Asked for, 0 for what the link takes. */
+static uint8_t                 m_tx_bufs;       /**< In flight at most. */
+static uint8_t                 m_in_flight;
+static bool                    m_started;       /**< m_start_tick is set. */
+static uint32_t                m_start_tick;
+static uint32_t                m_end_tick;
+static nus_bench_report_t      m_report;
+
+
+static void sat_inc(uint16_t * p_count)
+{
+    if (*p_count != UINT16_MAX)
+    {
+        (*p_count)++;
+    }
+}
+
+
+static uint32_t ticks_to_ms(uint32_t ticks)
+{
+    return (uint32_t)(((uint64_t)ticks * 1000 * (APP_TIMER_CONFIG_PRESCALER + 1)) / APP_TIMER_CLOCK_FREQ);
+}
+
+
+static void progress_mark(void)
+{
+    m_end_tick = app_timer_cnt_get();
+    if (!m_started)
+    {
+        m_started    = true;
+        m_start_tick = m_end_tick;
+    }
+}
+
+
+/**@brief Close the run and take the counters of link_stats. */
+static void run_end(void)
+{
+    link_stats_t stats;
+
+    UNUSED_RETURN_VALUE(app_timer_stop(m_timer));
+    if (link_stats_get(m_conn_handle, &stats) == NRF_SUCCESS)
+    {
+        m_report.in_flight_max = stats.in_flight_max;
+        m_report.interval      = stats.interval;
+        m_report.stalls        = stats.stalls;
+        m_report.stall_ms_max  = stats.stall_ms_max;
+    }
+    m_state = BENCH_IDLE;
+}
+
+
+/**@brief Hand the SoftDevice what the limits allow. In the BLE interrupt, or with it locked. */
+static void pump(void)
+{
+    uint8_t pkt[BLE_NUS_MAX_DATA_LEN];
+
+    while ((m_done < m_total) && (m_in_flight < m_tx_bufs))
+    {
+        uint16_t max      = ble_nus_data_len_get(m_p_nus, m_conn_handle);
+        uint16_t chunk    = (uint16_t)MIN(m_total - m_done, (m_len != 0) ? MIN(m_len, max) : max);
+        uint32_t err_code;
+
+        for (uint16_t i = 0; i < chunk; i++)
+        {
+            pkt[i] = (uint8_t)(m_done + i);
+        }
+
+        err_code = ble_nus_string_send_to(m_p_nus, m_conn_handle, pkt, chunk);
+        if (err_code == BLE_ERROR_NO_TX_PACKETS)
+        {
+            // The replies of nus_tx hold the rest; the next acknowledgement frees one.
+            sat_inc(&m_report.refused);
+            link_stats_tx_refused(m_conn_handle);
+            return;
+        }
+        if (err_code != NRF_SUCCESS)
+        {
+            // Notifications turned off, or the link is going.
+            run_end();
+            return;
+        }
+
+        progress_mark();
+        link_stats_tx_sent(m_conn_handle, chunk);
+        m_in_flight++;
+        m_done        += chunk;
+        m_report.bytes = m_done;
+        m_report.len   = (uint8_t)chunk;
+        sat_inc(&m_report.packets);
+    }
+}
+
+
+static void tx_run(void)
+{
+    uint8_t sd_bufs = 0;
+
+    CRITICAL_REGION_ENTER();
+    UNUSED_RETURN_VALUE(sd_ble_tx_packet_count_get(m_conn_handle, &sd_bufs));
+    m_tx_bufs        = ((m_tx_bufs != 0) && (m_tx_bufs < sd_bufs)) ? m_tx_bufs : sd_bufs;
+    m_report.tx_bufs = m_tx_bufs;
+    m_state          = BENCH_TX;
+    pump();
+    CRITICAL_REGION_EXIT();
+}
+
+
+/**@brief The central did not answer the parameter request: stream with what the link has. */
+static void timeout_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    if (m_state == BENCH_PARAM_WAIT)
+    {
+        tx_run();
+    }
+}
+
+
+static void run_prepare(uint16_t conn_handle, uint32_t total, bool upload)
+{
+    memset(&m_report, 0, sizeof(m_report));
+    m_report.upload = upload;
+    m_conn_handle   = conn_handle;
+    m_total         = total;
+    m_done          = 0;
+    m_in_flight     = 0;
+    m_started       = false;
+    // The stalls and the peaks of the link are those of the run.
+    link_stats_reset(conn_handle);
+}
+
+
+ret_code_t nus_bench_init(ble_nus_t * p_nus)
+{
+    m_p_nus = p_nus;
+    m_state = BENCH_IDLE;
+    return app_timer_create(&m_timer, APP_TIMER_MODE_SINGLE_SHOT, timeout_handler);
+}
+
+
+ret_code_t nus_bench_tx_start(uint16_t conn_handle, uint16_t kb, uint8_t len, uint8_t tx_bufs, uint16_t interval)
+{
+    ble_gap_conn_params_t params;
+
+    if (m_state != BENCH_IDLE)
+    {
+        return NRF_ERROR_BUSY;
+    }
+    if ((kb == 0) || ((interval != 0) && ((interval < INTERVAL_MIN) || (interval > INTERVAL_MAX))))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if (!ble_nus_is_notification_enabled(m_p_nus, conn_handle))
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    run_prepare(conn_handle, (uint32_t)kb * 1024, false);
+    m_len     = len;
+    m_tx_bufs = tx_bufs;
+
+    if (interval != 0)
+    {
+        params.min_conn_interval = interval;
+        params.max_conn_interval = interval;
+        params.slave_latency     = 0;
+        params.conn_sup_timeout  = SUP_TIMEOUT;
+        if ((sd_ble_gap_conn_param_update(conn_handle, &params) == NRF_SUCCESS) &&
+            (app_timer_start(m_timer, BENCH_TICKS(NUS_BENCH_PARAM_WAIT_MS), NULL) == NRF_SUCCESS))
+        {
+            m_state = BENCH_PARAM_WAIT;
+            return NRF_SUCCESS;
+        }
+        // A request of ble_conn_params in progress: stream with what the link has.
+    }
+
+    tx_run();
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t nus_bench_rx_start(uint16_t conn_handle, uint32_t bytes)
+{
+    if (m_state != BENCH_IDLE)
+    {
+        return NRF_ERROR_BUSY;
+    }
+    if (bytes == 0)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    CRITICAL_REGION_ENTER();
+    run_prepare(conn_handle, bytes, true);
+    m_state = BENCH_RX;
+    CRITICAL_REGION_EXIT();
+    return NRF_SUCCESS;
+}
+
+
+void nus_bench_stop(void)
+{
+    CRITICAL_REGION_ENTER();
+    if (m_state != BENCH_IDLE)
+    {
+        run_end();
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+
+bool nus_bench_is_active(void)
+{
+    return m_state != BENCH_IDLE;
+}
+
+
+void nus_bench_report_get(nus_bench_report_t * p_report)
+{
+    CRITICAL_REGION_ENTER();
+    *p_report    = m_report;
+    p_report->ms = 0;
+    if (m_started)
+    {
+        uint32_t ticks;
+
+        UNUSED_RETURN_VALUE(app_timer_cnt_diff_compute(m_end_tick, m_start_tick, &ticks));
+        p_report->ms = ticks_to_ms(ticks);
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+
+bool nus_bench_on_data(uint16_t conn_handle, uint8_t const * p_data, uint16_t length)
+{
+    UNUSED_PARAMETER(p_data);
+
+    if ((m_state != BENCH_RX) || (conn_handle != m_conn_handle))
+    {
+        return false;
+    }
+
+    progress_mark();
+    m_done        += length;
+    m_report.bytes = m_done;
+    sat_inc(&m_report.packets);
+    if (m_done >= m_total)
+    {
+        run_end();
+    }
+    return true;
+}
+
+
+void nus_bench_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    if ((m_state == BENCH_IDLE) || (p_ble_evt->evt.common_evt.conn_handle != m_conn_handle))
+    {
+        return;
+    }
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_EVT_TX_COMPLETE:
+        {
+            uint8_t count = p_ble_evt->evt.common_evt.params.tx_complete.count;
+
+            if ((m_state != BENCH_TX) || (m_in_flight == 0))
+            {
+                break;
+            }
+            // The count takes in the replies of nus_tx as well.
+            m_in_flight = (count < m_in_flight) ? (m_in_flight - count) : 0;
+            sat_inc(&m_report.events);
+            m_report.per_event_max = MAX(m_report.per_event_max, count);
+            progress_mark();
+            if ((m_done == m_total) && (m_in_flight == 0))
+            {
+                run_end();
+            }
+            else
+            {
+                pump();
+            }
+        } break;
+
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+            if (m_state == BENCH_PARAM_WAIT)
+            {
+                UNUSED_RETURN_VALUE(app_timer_stop(m_timer));
+                tx_run();
+            }
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            run_end();
+            break;
+
+        default:
+            break;
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(NUS_BENCH)
@@ -0,0 +1,95 @@
+#ifndef __NUS_BENCH_H__
+#define __NUS_BENCH_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "ble.h"
+#include "ble_nus.h"
+
+/* What NUS carries on a given phone with given settings, measured instead of guessed:
+ *
+ *   stream    a run sends kB of a counting pattern, byte n of the run is n & 0xFF, as
+ *             notifications on the link that started it, straight to the SoftDevice and
+ *             refilled on each BLE_EVT_TX_COMPLETE, so the phone can check what it got
+ *   upload    a run counts the next writes of the link up to a number of bytes, instead of
+ *             running them as commands
+ *   settings  per run: the notification length, up to what the ATT MTU of the link takes;
+ *             the notifications in flight, up to the TX buffers of the SoftDevice; and the
+ *             connection interval, asked of the central before the stream starts. The run
+ *             starts on the answer, or after NUS_BENCH_PARAM_WAIT_MS without one
+ *   measured  time from the first packet to the last acknowledgement or write, bytes,
+ *             packets, connection events with acknowledgements and the most in one, hand-overs
+ *             refused for lack of TX buffers, and from link_stats the stalls, the most in
+ *             flight and the interval at the end of the run
+ *
+ * One run at a time. Replies on the link still go through nus_tx meanwhile, and take TX
+ * buffers from the stream. conn_policy may ask for other parameters during a run; the interval
+ * of the report is the one the link ended with. Needs LINK_STATS. */
+
+/**@brief Results of the last run; so far while it runs. */
+typedef struct
+{
+    uint32_t ms;                /**< First packet to the last acknowledgement or write. */
+    uint32_t bytes;
+    uint16_t packets;           /**< Notifications sent or writes taken; saturated. */
+    uint16_t events;            /**< Connection events that acknowledged notifications; saturated. */
+    uint16_t refused;           /**< Hand-overs refused with BLE_ERROR_NO_TX_PACKETS; saturated. */
+    uint8_t  per_event_max;     /**< Most notifications acknowledged in one connection event. */
+    uint8_t  len;               /**< Notification length used last. */
+    uint8_t  tx_bufs;           /**< Notifications the run kept in flight at most. */
+    uint8_t  in_flight_max;     /**< link_stats: most in flight, replies included. */
+    uint16_t interval;          /**< link_stats: at the end, in 1.25 ms units. */
+    uint16_t stalls;            /**< link_stats: acknowledgements that came late. */
+    uint16_t stall_ms_max;      /**< link_stats: longest of them. */
+    bool     upload;
+} nus_bench_report_t;
+
+/**@brief Create the timer of the parameter request.
+ *
+ * @param[in] p_nus  Service the stream goes out on.
+ */
+ret_code_t nus_bench_init(ble_nus_t * p_nus);
+
+/**@brief Start a stream. Main loop.
+ *
+ * @param[in] conn_handle  Link, with notifications enabled.
+ * @param[in] kb           kB to send, 1 kB being 1024 bytes.
+ * @param[in] len          Notification length, 0 for what the link takes.
+ * @param[in] tx_bufs      Notifications in flight at most, 0 for what the SoftDevice takes.
+ * @param[in] interval     Connection interval to ask for, in 1.25 ms units, 0 to keep it.
+ *
+ * @retval NRF_SUCCESS              Started, or waiting for the connection parameters.
+ * @retval NRF_ERROR_BUSY           A run goes on.
+ * @retval NRF_ERROR_INVALID_PARAM  No kB, or an interval out of range.
+ * @retval NRF_ERROR_INVALID_STATE  Notifications are off on the link.
+ */
+ret_code_t nus_bench_tx_start(uint16_t conn_handle, uint16_t kb, uint8_t len, uint8_t tx_bufs, uint16_t interval);
+
+/**@brief Start an upload: the next @p bytes the link writes are counted, not run. Main loop.
+ *
+ * @retval NRF_SUCCESS              Started.
+ * @retval NRF_ERROR_BUSY           A run goes on.
+ * @retval NRF_ERROR_INVALID_PARAM  No bytes.
+ */
+ret_code_t nus_bench_rx_start(uint16_t conn_handle, uint32_t bytes);
+
+/**@brief End the run where it is; its report stays. */
+void nus_bench_stop(void);
+
+bool nus_bench_is_active(void);
+
+void nus_bench_report_get(nus_bench_report_t * p_report);
+
+/**@brief Take a NUS write, from the NUS data handler.
+ *
+ * @return true when it belonged to an upload.
+ */
+bool nus_bench_on_data(uint16_t conn_handle, uint8_t const * p_data, uint16_t length);
+
+/**@brief Refill on BLE_EVT_TX_COMPLETE, follow the parameters and the link. Call after
+ *        nus_tx_on_ble_evt(), so replies get the freed buffers first.
+ */
+void nus_bench_on_ble_evt(ble_evt_t * p_ble_evt);
+
+#endif
@@ -0,0 +1,251 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(NUS_CMD)
+#include "nus_cmd.h"
+#include "nus_tx.h"
+#include "crc16.h"
+#include "app_scheduler.h"
+#include "nrf_queue.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(NUS_TX)
+#error "nus_cmd needs NUS_TX_ENABLED"
+#endif
+
+#define REQ_HEADER_LEN   2                                  /**< id, cmd. */
+#define RESP_HEADER_LEN  3                                  /**< id, cmd, status. */
+#define FRAME_OVERHEAD   4                                  /**< SOF, len, crc16. */
+#define REQ_FRAME_MAX    (FRAME_OVERHEAD + REQ_HEADER_LEN + NUS_CMD_PAYLOAD_MAX)
+#define RESP_FRAME_MAX   (FRAME_OVERHEAD + RESP_HEADER_LEN + NUS_CMD_DATA_MAX)
+
+typedef struct
+{
+    uint16_t conn_handle;   /**< Link the request came in on, the response goes back on. */
+    uint8_t  id;
+    uint8_t  cmd;
+    uint8_t  len;
+    uint8_t  payload[NUS_CMD_PAYLOAD_MAX];
+} nus_cmd_req_t;
+
+/**@brief Partial request of one link. */
+typedef struct
+{
+    uint16_t conn_handle;
+    uint8_t  len;           /**< 0 when the entry is free. */
+    uint8_t  buf[REQ_FRAME_MAX];
+} nus_cmd_rx_t;
+
+NRF_QUEUE_DEF(nus_cmd_req_t, m_req_queue, NUS_CMD_QUEUE_SIZE, NRF_QUEUE_MODE_NO_OVERFLOW);
+
+static nus_cmd_handler_t m_handler;
+static nus_cmd_rx_t      m_rx[BLE_NUS_LINK_COUNT];
+static volatile bool     m_process_pending;
+static bool              m_active;
+static nus_cmd_req_t     m_req;             /**< Request being handled. */
+
+
+static void frame_send(uint16_t conn_handle, uint8_t id, uint8_t cmd, uint8_t status,
+                       uint8_t const * p_data, uint8_t len)
+{
+    uint8_t  frame[RESP_FRAME_MAX];
+    uint16_t crc;
+
+    frame[0] = NUS_CMD_SOF;
+    frame[1] = RESP_HEADER_LEN + len;
+    frame[2] = id;
+    frame[3] = cmd;
+    frame[4] = status;
+    if (len != 0)
+    {
+        memcpy(&frame[5], p_data, len);
+    }
+    crc = crc16_compute(&frame[1], 1 + RESP_HEADER_LEN + len, NULL);
+    UNUSED_RETURN_VALUE(uint16_encode(crc, &frame[5 + len]));
+
+    UNUSED_RETURN_VALUE(nus_tx_put(conn_handle, frame, FRAME_OVERHEAD + RESP_HEADER_LEN + len, NUS_TX_STREAM));
+}
+
+
+static void process_handler(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    m_process_pending = false;
+
+    // Pipelined requests run back to back, in arrival order.
+    while (nrf_queue_pop(&m_req_queue, &m_req) == NRF_SUCCESS)
+    {
+        ret_code_t err_code = NRF_ERROR_NOT_SUPPORTED;
+
+        // Raw replies of the handler go to the same peer.
+        m_active = true;
+        nus_tx_target_set(m_req.conn_handle);
+        if (m_handler != NULL)
+        {
+            err_code = m_handler(m_req.cmd, m_req.payload, m_req.len);
+        }
+        nus_tx_target_set(BLE_CONN_HANDLE_ALL);
+        m_active = false;
+
+        frame_send(m_req.conn_handle, m_req.id, m_req.cmd, (uint8_t)err_code, NULL, 0);
+    }
+}
+
+
+static void frame_received(nus_cmd_rx_t const * p_rx)
+{
+    uint8_t       len = p_rx->buf[1];
+    uint16_t      crc = crc16_compute(&p_rx->buf[1], 1 + len, NULL);
+    nus_cmd_req_t req;
+
+    req.conn_handle = p_rx->conn_handle;
+    req.id          = p_rx->buf[2];
+    req.cmd         = p_rx->buf[3];
+    req.len         = len - REQ_HEADER_LEN;
+
+    if (crc != uint16_decode(&p_rx->buf[2 + len]))
+    {
+        frame_send(req.conn_handle, req.id, req.cmd, (uint8_t)NRF_ERROR_INVALID_DATA, NULL, 0);
+        return;
+    }
+
+    memcpy(req.payload, &p_rx->buf[4], req.len);
+    if (nrf_queue_push(&m_req_queue, &req) != NRF_SUCCESS)
+    {
+        frame_send(req.conn_handle, req.id, req.cmd, (uint8_t)NRF_ERROR_BUSY, NULL, 0);
+        return;
+    }
+
+    if (!m_process_pending)
+    {
+        m_process_pending = true;
+        if (app_sched_event_put(NULL, 0, process_handler) != NRF_SUCCESS)
+        {
+            // Picked up with the next request that gets through to the scheduler.
+            m_process_pending = false;
+        }
+    }
+}
+
+
+/**@brief Partial request of a link, or NULL. */
+static nus_cmd_rx_t * rx_find(uint16_t conn_handle)
+{
+    for (uint32_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        if ((m_rx[i].len != 0) && (m_rx[i].conn_handle == conn_handle))
+        {
+            return &m_rx[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+/**@brief Free entry for a new request of a link, or NULL if every link has one going. */
+static nus_cmd_rx_t * rx_alloc(uint16_t conn_handle)
+{
+    for (uint32_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        if (m_rx[i].len == 0)
+        {
+            m_rx[i].conn_handle = conn_handle;
+            return &m_rx[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+void nus_cmd_init(nus_cmd_handler_t handler)
+{
+    m_handler = handler;
+    memset(m_rx, 0, sizeof(m_rx));
+}
+
+
+bool nus_cmd_on_data(uint16_t conn_handle, uint8_t const * p_data, uint16_t len)
+{
+    nus_cmd_rx_t * p_rx = rx_find(conn_handle);
+
+    if ((len == 0) || ((p_rx == NULL) && (p_data[0] != NUS_CMD_SOF)))
+    {
+        return false;
+    }
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        if (p_rx == NULL)
+        {
+            if (p_data[i] != NUS_CMD_SOF)
+            {
+                // Resynchronize on the next start of frame.
+                continue;
+            }
+
+            p_rx = rx_alloc(conn_handle);
+            if (p_rx == NULL)
+            {
+                return true;
+            }
+        }
+
+        p_rx->buf[p_rx->len++] = p_data[i];
+
+        if ((p_rx->len == 2) &&
+            ((p_rx->buf[1] < REQ_HEADER_LEN) || (p_rx->buf[1] > REQ_HEADER_LEN + NUS_CMD_PAYLOAD_MAX)))
+        {
+            p_rx->len = 0;
+            p_rx      = NULL;
+        }
+        else if ((p_rx->len > 2) && (p_rx->len == FRAME_OVERHEAD + p_rx->buf[1]))
+        {
+            frame_received(p_rx);
+            p_rx->len = 0;
+            p_rx      = NULL;
+        }
+    }
+
+    return true;
+}
+
+
+void nus_cmd_reset(uint16_t conn_handle)
+{
+    nus_cmd_rx_t * p_rx = rx_find(conn_handle);
+
+    if (p_rx != NULL)
+    {
+        p_rx->len = 0;
+    }
+}
+
+
+bool nus_cmd_active(void)
+{
+    return m_active;
+}
+
+
+ret_code_t nus_cmd_data(uint8_t const * p_data, uint16_t len)
+{
+    if (!m_active)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    while (len != 0)
+    {
+        uint8_t chunk = MIN(len, NUS_CMD_DATA_MAX);
+
+        frame_send(m_req.conn_handle, m_req.id, m_req.cmd, NUS_CMD_STATUS_MORE, p_data, chunk);
+        p_data += chunk;
+        len    -= chunk;
+    }
+
+    return NRF_SUCCESS;
+}
+
+#endif //NRF_MODULE_ENABLED(NUS_CMD)
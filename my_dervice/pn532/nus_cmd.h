@@ -0,0 +1,59 @@
+#ifndef __NUS_CMD_H__
+#define __NUS_CMD_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "ble_nus.h"
+
+/* Request:  SOF, len, id, cmd, payload..., crc16 (LE)
+ * Response: SOF, len, id, cmd, status, data..., crc16 (LE)
+ *
+ * len counts the bytes from id up to the CRC, the CRC (crc16_compute) covers len up to the
+ * last payload or data byte. A request may be split over several NUS writes and one write may
+ * carry several requests. Requests run one after the other; each ends with a response whose
+ * status is the low byte of the NRF_ERROR code, preceded by any number of
+ * NUS_CMD_STATUS_MORE responses carrying the data. The phone matches them by id, so it can
+ * send the next requests without waiting. Every link has its own partial request; responses
+ * go back on the link the request came in on. */
+
+#define NUS_CMD_SOF            0xA5  /**< First byte of every frame; raw commands start with 1..7. */
+#define NUS_CMD_STATUS_MORE    0xFF  /**< Data of a request that has not finished yet. */
+#define NUS_CMD_PAYLOAD_MAX    32    /**< Longest request payload. */
+#define NUS_CMD_DATA_MAX       32    /**< Data bytes per response frame. */
+
+/**@brief Command handler, run from the app_scheduler.
+ *
+ * @details Data sent with @ref nus_cmd_data meanwhile goes out in NUS_CMD_STATUS_MORE frames of
+ *          this request.
+ *
+ * @return Status for the final response.
+ */
+typedef ret_code_t (*nus_cmd_handler_t)(uint8_t cmd, uint8_t * p_payload, uint8_t len);
+
+/**@brief Set the command handler and forget any partial request. */
+void nus_cmd_init(nus_cmd_handler_t handler);
+
+/**@brief Feed bytes written by a phone.
+ *
+ * @details Called from the NUS data handler. Complete requests with a valid CRC are queued for
+ *          the scheduler; a bad CRC or a full queue is answered right away.
+ *
+ * @param[in] conn_handle  Link the bytes were written on.
+ *
+ * @return false if the write is not framed (no request in progress and the first byte is not
+ *         NUS_CMD_SOF), so the caller can treat it as a raw command.
+ */
+bool nus_cmd_on_data(uint16_t conn_handle, uint8_t const * p_data, uint16_t len);
+
+/**@brief Drop the partial request of a link, for example on disconnect. Queued requests still
+ *        run, their responses are dropped with the link. */
+void nus_cmd_reset(uint16_t conn_handle);
+
+/**@brief Whether a framed request is being handled, so replies go through @ref nus_cmd_data. */
+bool nus_cmd_active(void);
+
+/**@brief Send data of the request being handled, in frames of up to NUS_CMD_DATA_MAX bytes. */
+ret_code_t nus_cmd_data(uint8_t const * p_data, uint16_t len);
+
+#endif
@@ -0,0 +1,148 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(NUS_PB)
+#include "nus_pb.h"
+#include "nus_tx.h"
+#include "nus_cmd.h"
+#include "pn532_reader.h"
+#include "pb_encode.h"
+#include "nus_response.pb.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(NUS_TX)
+#error "nus_pb needs NUS_TX_ENABLED"
+#endif
+
+/* The largest record, a card: length, tag and length of the submessage, the submessage. */
+#define RESPONSE_MAX  (3 + CardInfo_size)
+
+STATIC_ASSERT(RESPONSE_MAX <= 127);
+
+typedef struct
+{
+    ret_code_t err_code;
+    uint8_t    flags;       /**< NUS_TX_STREAM, plus NUS_TX_ADMINS for card results. */
+} stream_state_t;
+
+
+/**@brief Output callback: the bytes go to the tail of the TX queues, nowhere else. */
+static bool stream_write(pb_ostream_t * p_stream, pb_byte_t const * p_buf, size_t count)
+{
+    stream_state_t * p_state = p_stream->state;
+
+    p_state->err_code = nus_tx_put(nus_tx_target_get(), p_buf, count, p_state->flags);
+    return (p_state->err_code == NRF_SUCCESS);
+}
+
+
+static bool block_data_encode(pb_ostream_t * p_stream, pb_field_t const * p_field, void * const * p_arg)
+{
+    return pb_encode_tag_for_field(p_stream, p_field) &&
+           pb_encode_string(p_stream, *p_arg, NUS_PB_BLOCK_SIZE);
+}
+
+
+static ret_code_t response_send(NusResponse const * p_rsp)
+{
+    stream_state_t state = {NRF_SUCCESS, NUS_TX_STREAM};
+
+    if (p_rsp->has_card)
+    {
+        state.flags |= NUS_TX_ADMINS;
+    }
+
+#if NRF_MODULE_ENABLED(NUS_CMD)
+    if (nus_cmd_active())
+    {
+        // A frame per write would cost a notification each; the record goes in one.
+        uint8_t      buf[RESPONSE_MAX];
+        pb_ostream_t stream = pb_ostream_from_buffer(buf, sizeof(buf));
+
+        if (!pb_encode_delimited(&stream, NusResponse_fields, p_rsp))
+        {
+            return NRF_ERROR_INTERNAL;
+        }
+        if (p_rsp->has_card)
+        {
+            UNUSED_RETURN_VALUE(nus_tx_put(BLE_CONN_HANDLE_INVALID, buf, stream.bytes_written, state.flags));
+        }
+        return nus_cmd_data(buf, stream.bytes_written);
+    }
+#endif
+
+    {
+        pb_ostream_t stream = {.callback = stream_write, .state = &state, .max_size = RESPONSE_MAX};
+
+        if (!pb_encode_delimited(&stream, NusResponse_fields, p_rsp) && (state.err_code == NRF_SUCCESS))
+        {
+            state.err_code = NRF_ERROR_INTERNAL;
+        }
+    }
+
+    return state.err_code;
+}
+
+
+static ret_code_t card_send(NusResponse * p_rsp, uint8_t const * p_uid, uint8_t uid_len)
+{
+    if (uid_len > sizeof(p_rsp->card.uid.bytes))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    p_rsp->has_card      = true;
+    p_rsp->card.uid.size = uid_len;
+    memcpy(p_rsp->card.uid.bytes, p_uid, uid_len);
+#if NRF_MODULE_ENABLED(PN532_READER)
+    p_rsp->card.has_reader = true;
+    p_rsp->card.reader     = pn532_reader_in_use();
+#endif
+
+    return response_send(p_rsp);
+}
+
+
+ret_code_t nus_pb_card_a(uint8_t const * p_uid, uint8_t uid_len, uint16_t sens_res, uint8_t sel_res)
+{
+    NusResponse rsp = NusResponse_init_zero;
+
+    rsp.card.has_sens_res = true;
+    rsp.card.sens_res     = sens_res;
+    rsp.card.has_sel_res  = true;
+    rsp.card.sel_res      = sel_res;
+
+    return card_send(&rsp, p_uid, uid_len);
+}
+
+
+ret_code_t nus_pb_card_b(uint8_t const * p_uid, uint8_t uid_len)
+{
+    NusResponse rsp = NusResponse_init_zero;
+
+    return card_send(&rsp, p_uid, uid_len);
+}
+
+
+ret_code_t nus_pb_block(uint8_t block, uint8_t const * p_data)
+{
+    NusResponse rsp = NusResponse_init_zero;
+
+    rsp.has_block               = true;
+    rsp.block.block             = block;
+    rsp.block.data.funcs.encode = block_data_encode;
+    rsp.block.data.arg          = (void *)p_data;
+
+    return response_send(&rsp);
+}
+
+
+ret_code_t nus_pb_error(ret_code_t error)
+{
+    NusResponse rsp = NusResponse_init_zero;
+
+    rsp.has_error = true;
+    rsp.error     = error;
+
+    return response_send(&rsp);
+}
+
+#endif //NRF_MODULE_ENABLED(NUS_PB)
@@ -0,0 +1,52 @@
+#ifndef __NUS_PB_H__
+#define __NUS_PB_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+
+/* Card command answers as NusResponse records (nus_response.proto), each preceded by its
+ * length as a varint. The records are encoded straight into the nus_tx notification slots,
+ * packed like stream data, or into the frames of a framed request while one is handled.
+ *
+ * A READ_CARD or WRITE_CARD answer is a card, the blocks read, and an error record with
+ * the result; scans and taps send card records only. */
+
+#define NUS_PB_BLOCK_SIZE  16
+
+/**@brief Send a type A card.
+ *
+ * @param[in] p_uid     NFCID.
+ * @param[in] uid_len   NFCID length, at most 10.
+ * @param[in] sens_res  SENS_RES (ATQA).
+ * @param[in] sel_res   SEL_RES (SAK).
+ *
+ * @retval NRF_SUCCESS             Queued.
+ * @retval NRF_ERROR_INVALID_PARAM UID too long.
+ * @return Otherwise as for @ref nus_tx_stream or @ref nus_cmd_data.
+ */
+ret_code_t nus_pb_card_a(uint8_t const * p_uid, uint8_t uid_len, uint16_t sens_res, uint8_t sel_res);
+
+/**@brief Send a type B card, identified by its PUPI or another UID.
+ *
+ * @return As for @ref nus_pb_card_a.
+ */
+ret_code_t nus_pb_card_b(uint8_t const * p_uid, uint8_t uid_len);
+
+/**@brief Send a block. Its data is encoded from @p p_data, without a copy in between.
+ *
+ * @param[in] block   Block number.
+ * @param[in] p_data  NUS_PB_BLOCK_SIZE bytes.
+ *
+ * @return As for @ref nus_pb_card_a.
+ */
+ret_code_t nus_pb_block(uint8_t block, uint8_t const * p_data);
+
+/**@brief Send the result that ends the answer to a card command.
+ *
+ * @param[in] error  NRF_SUCCESS, or the NRF_ERROR code of the failure.
+ *
+ * @return As for @ref nus_pb_card_a.
+ */
+ret_code_t nus_pb_error(ret_code_t error);
+
+#endif
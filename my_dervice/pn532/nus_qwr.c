@@ -0,0 +1,104 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(NUS_QWR)
+#include "nus_qwr.h"
+#include "nrf_ble_qwr.h"
+#include "app_error.h"
+#include "ram_budget.h"
+
+static ble_nus_t *   m_p_nus;
+static nrf_ble_qwr_t m_qwr[BLE_NUS_LINK_COUNT];
+static uint8_t       m_mem[BLE_NUS_LINK_COUNT][NUS_QWR_MEM_SIZE];   /**< Prepared writes, as the SoftDevice queues them. */
+static uint8_t       m_value[NUS_QWR_MEM_SIZE];                     /**< The data of the writes being executed, in order. */
+static uint16_t      m_value_len;
+
+RAM_BUDGET_REGISTER(m_qwr_budget, "nus_qwr", sizeof(m_mem) + sizeof(m_value), NULL);
+
+
+static void qwr_error_handler(uint32_t nrf_error)
+{
+    APP_ERROR_HANDLER(nrf_error);
+}
+
+
+/**@brief Runs in the BLE event, for the TX characteristic: first to accept the execute, then
+ *        once it has been answered.
+ */
+static uint16_t qwr_evt_handler(nrf_ble_qwr_t * p_qwr, nrf_ble_qwr_evt_t * p_evt)
+{
+    if (p_evt->attr_handle != m_p_nus->tx_handles.value_handle)
+    {
+        return BLE_GATT_STATUS_SUCCESS;
+    }
+
+    switch (p_evt->evt_type)
+    {
+        case NRF_BLE_QWR_EVT_AUTH_REQUEST:
+            m_value_len = sizeof(m_value);
+            if (nrf_ble_qwr_value_get(p_qwr, p_evt->attr_handle, m_value, &m_value_len) != NRF_SUCCESS)
+            {
+                m_value_len = 0;
+                return BLE_GATT_STATUS_ATTERR_INVALID_ATT_VAL_LENGTH;
+            }
+            break;
+
+        case NRF_BLE_QWR_EVT_EXECUTE_WRITE:
+            ble_nus_data_put(m_p_nus, p_qwr->conn_handle, m_value, m_value_len);
+            m_value_len = 0;
+            break;
+
+        default:
+            break;
+    }
+
+    return BLE_GATT_STATUS_SUCCESS;
+}
+
+
+ret_code_t nus_qwr_init(ble_nus_t * p_nus)
+{
+    ret_code_t err_code;
+
+    m_p_nus = p_nus;
+
+    for (uint8_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        nrf_ble_qwr_init_t qwr_init;
+
+        qwr_init.error_handler    = qwr_error_handler;
+        qwr_init.mem_buffer.p_mem = m_mem[i];
+        qwr_init.mem_buffer.len   = sizeof(m_mem[i]);
+        qwr_init.callback         = qwr_evt_handler;
+
+        err_code = nrf_ble_qwr_init(&m_qwr[i], &qwr_init);
+        VERIFY_SUCCESS(err_code);
+
+        err_code = nrf_ble_qwr_attr_register(&m_qwr[i], p_nus->tx_handles.value_handle);
+        VERIFY_SUCCESS(err_code);
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+void nus_qwr_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    if (p_ble_evt->header.evt_id == BLE_GAP_EVT_CONNECTED)
+    {
+        // An instance leaves its link by itself on BLE_GAP_EVT_DISCONNECTED.
+        for (uint8_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+        {
+            if (m_qwr[i].conn_handle == BLE_CONN_HANDLE_INVALID)
+            {
+                UNUSED_RETURN_VALUE(nrf_ble_qwr_conn_handle_assign(&m_qwr[i], p_ble_evt->evt.gap_evt.conn_handle));
+                break;
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        nrf_ble_qwr_on_ble_evt(&m_qwr[i], p_ble_evt);
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(NUS_QWR)
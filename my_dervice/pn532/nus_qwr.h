@@ -0,0 +1,29 @@
+#ifndef __NUS_QWR_H__
+#define __NUS_QWR_H__
+
+#include "sdk_errors.h"
+#include "ble_nus.h"
+
+/* Long writes of the NUS TX characteristic: the phone queues Prepare Write Requests of up to
+ * NUS_QWR_MEM_SIZE bytes in all and commits them with one Execute Write Request, which is
+ * answered once for the lot.
+ *
+ * The data goes to the NUS data handler like consecutive writes of up to
+ * BLE_NUS_MAX_DATA_LEN bytes. That suits the framed protocol of nus_cmd, which takes requests
+ * split over writes and several requests in one write; a raw command must still fit in one
+ * write. Each link has its own nrf_ble_qwr instance and buffer. */
+
+/**@brief Register the TX characteristic with the queued writes module.
+ *
+ * @details Call after ble_nus_init() with long_write set.
+ *
+ * @param[in] p_nus  Nordic UART Service.
+ */
+ret_code_t nus_qwr_init(ble_nus_t * p_nus);
+
+/**@brief Handle a BLE event. Call from the BLE event dispatch, before the application's own
+ *        handler.
+ */
+void nus_qwr_on_ble_evt(ble_evt_t * p_ble_evt);
+
+#endif
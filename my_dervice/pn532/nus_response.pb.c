@@ -0,0 +1,59 @@
+/* Automatically generated nanopb constant definitions */
+/* Generated by nanopb-0.3.6-dev */
+
+#include "nus_response.pb.h"
+
+/* @@protoc_insertion_point(includes) */
+#if PB_PROTO_HEADER_VERSION != 30
+#error Regenerate this file with the current version of nanopb generator.
+#endif
+
+
+
+const pb_field_t CardInfo_fields[5] = {
+    PB_FIELD(  1, BYTES   , REQUIRED, STATIC  , FIRST, CardInfo, uid, uid, 0),
+    PB_FIELD(  2, UINT32  , OPTIONAL, STATIC  , OTHER, CardInfo, sens_res, uid, 0),
+    PB_FIELD(  3, UINT32  , OPTIONAL, STATIC  , OTHER, CardInfo, sel_res, sens_res, 0),
+    PB_FIELD(  4, UINT32  , OPTIONAL, STATIC  , OTHER, CardInfo, reader, sel_res, 0),
+    PB_LAST_FIELD
+};
+
+const pb_field_t BlockData_fields[3] = {
+    PB_FIELD(  1, UINT32  , REQUIRED, STATIC  , FIRST, BlockData, block, block, 0),
+    PB_FIELD(  2, BYTES   , REQUIRED, CALLBACK, OTHER, BlockData, data, block, 0),
+    PB_LAST_FIELD
+};
+
+const pb_field_t NusResponse_fields[4] = {
+    PB_FIELD(  1, MESSAGE , OPTIONAL, STATIC  , FIRST, NusResponse, card, card, &CardInfo_fields),
+    PB_FIELD(  2, MESSAGE , OPTIONAL, STATIC  , OTHER, NusResponse, block, card, &BlockData_fields),
+    PB_FIELD(  3, UINT32  , OPTIONAL, STATIC  , OTHER, NusResponse, error, block, 0),
+    PB_LAST_FIELD
+};
+
+
+/* Check that field information fits in pb_field_t */
+#if !defined(PB_FIELD_32BIT)
+/* If you get an error here, it means that you need to define PB_FIELD_32BIT
+ * compile-time option. You can do that in pb.h or on compiler command line.
+ * 
+ * The reason you need to do this is that some of your messages contain tag
+ * numbers or field sizes that are larger than what can fit in 8 or 16 bit
+ * field descriptors.
+ */
+PB_STATIC_ASSERT((pb_membersize(NusResponse, card) < 65536 && pb_membersize(NusResponse, block) < 65536), YOU_MUST_DEFINE_PB_FIELD_32BIT_FOR_MESSAGES_CardInfo_BlockData_NusResponse)
+#endif
+
+#if !defined(PB_FIELD_16BIT) && !defined(PB_FIELD_32BIT)
+/* If you get an error here, it means that you need to define PB_FIELD_16BIT
+ * compile-time option. You can do that in pb.h or on compiler command line.
+ * 
+ * The reason you need to do this is that some of your messages contain tag
+ * numbers or field sizes that are larger than what can fit in the default
+ * 8 bit descriptors.
+ */
+PB_STATIC_ASSERT((pb_membersize(NusResponse, card) < 256 && pb_membersize(NusResponse, block) < 256), YOU_MUST_DEFINE_PB_FIELD_16BIT_FOR_MESSAGES_CardInfo_BlockData_NusResponse)
+#endif
+
+
+/* @@protoc_insertion_point(eof) */
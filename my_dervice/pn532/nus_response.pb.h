@@ -0,0 +1,90 @@
+/* Automatically generated nanopb header */
+/* Generated by nanopb-0.3.6-dev */
+
+#ifndef PB_NUS_RESPONSE_PB_H_INCLUDED
+#define PB_NUS_RESPONSE_PB_H_INCLUDED
+#include <pb.h>
+
+/* @@protoc_insertion_point(includes) */
+#if PB_PROTO_HEADER_VERSION != 30
+#error Regenerate this file with the current version of nanopb generator.
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Struct definitions */
+typedef PB_BYTES_ARRAY_T(10) CardInfo_uid_t;
+typedef struct _CardInfo {
+    CardInfo_uid_t uid;
+    bool has_sens_res;
+    uint32_t sens_res;
+    bool has_sel_res;
+    uint32_t sel_res;
+    bool has_reader;
+    uint32_t reader;
+/* @@protoc_insertion_point(struct:CardInfo) */
+} CardInfo;
+
+typedef struct _BlockData {
+    uint32_t block;
+    pb_callback_t data;
+/* @@protoc_insertion_point(struct:BlockData) */
+} BlockData;
+
+typedef struct _NusResponse {
+    bool has_card;
+    CardInfo card;
+    bool has_block;
+    BlockData block;
+    bool has_error;
+    uint32_t error;
+/* @@protoc_insertion_point(struct:NusResponse) */
+} NusResponse;
+
+/* Default values for struct fields */
+
+/* Initializer values for message structs */
+#define CardInfo_init_default                    {{0, {0}}, false, 0, false, 0, false, 0}
+#define BlockData_init_default                   {0, {{NULL}, NULL}}
+#define NusResponse_init_default                 {false, CardInfo_init_default, false, BlockData_init_default, false, 0}
+#define CardInfo_init_zero                       {{0, {0}}, false, 0, false, 0, false, 0}
+#define BlockData_init_zero                      {0, {{NULL}, NULL}}
+#define NusResponse_init_zero                    {false, CardInfo_init_zero, false, BlockData_init_zero, false, 0}
+
+/* Field tags (for use in manual encoding/decoding) */
+#define CardInfo_uid_tag                         1
+#define CardInfo_sens_res_tag                    2
+#define CardInfo_sel_res_tag                     3
+#define CardInfo_reader_tag                      4
+#define BlockData_block_tag                      1
+#define BlockData_data_tag                       2
+#define NusResponse_card_tag                     1
+#define NusResponse_block_tag                    2
+#define NusResponse_error_tag                    3
+
+/* Struct field encoding specification for nanopb */
+extern const pb_field_t CardInfo_fields[5];
+extern const pb_field_t BlockData_fields[3];
+extern const pb_field_t NusResponse_fields[4];
+
+/* Maximum encoded size of messages (where known) */
+#define CardInfo_size                            30
+/* BlockData_size depends on runtime parameters */
+/* NusResponse_size depends on runtime parameters */
+
+/* Message IDs (where set with "msgid" option) */
+#ifdef PB_MSGID
+
+#define NUS_RESPONSE_MESSAGES \
+
+
+#endif
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+/* @@protoc_insertion_point(eof) */
+
+#endif
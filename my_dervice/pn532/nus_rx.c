@@ -0,0 +1,296 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(NUS_RX)
+#include "nus_rx.h"
+#include "ble_nus.h"
+#include "ble_srv_common.h"
+#include "app_util.h"
+#include "app_util_platform.h"
+#include "ram_budget.h"
+#include <string.h>
+
+#define NUS_RX_UUID_SERVICE     0x0015  /**< On the NUS base. */
+#define NUS_RX_UUID_CREDIT      0x0016
+
+STATIC_ASSERT(IS_POWER_OF_TWO(NUS_RX_BUFS) && (NUS_RX_BUFS <= 128));
+// A link that keeps to its credits never finds the pool full.
+STATIC_ASSERT(NUS_RX_LINK_CREDITS * BLE_NUS_LINK_COUNT <= NUS_RX_BUFS);
+
+typedef struct
+{
+    uint16_t          conn_handle;  /**< BLE_CONN_HANDLE_INVALID when not in credit mode. */
+    volatile uint16_t received;     /**< Writes since the subscription. */
+    volatile uint16_t limit;        /**< Writes the link may have sent. */
+    uint16_t          notified;     /**< limit as the link last heard it. */
+} link_t;
+
+typedef struct
+{
+    uint16_t conn_handle;           /**< BLE_CONN_HANDLE_INVALID once its link is gone. */
+    uint16_t length;
+    uint8_t  data[BLE_NUS_MAX_DATA_LEN];
+} slot_t;
+
+static uint16_t                 m_service_handle;
+static ble_gatts_char_handles_t m_credit_handles;
+static nus_rx_handler_t         m_handler;
+static link_t                   m_links[BLE_NUS_LINK_COUNT];
+static slot_t                   m_slots[NUS_RX_BUFS];
+static volatile uint8_t         m_wr;       /**< Free running; the slot index is masked. */
+static volatile uint8_t         m_rd;
+static nus_rx_stats_t           m_stats;
+
+
+static uint16_t pool_peak_get(void)
+{
+    return m_stats.max_used * sizeof(slot_t);
+}
+RAM_BUDGET_REGISTER(m_pool_budget, "nus_rx", sizeof(m_slots), pool_peak_get);
+
+
+static void sat_inc(uint16_t * p_count)
+{
+    if (*p_count < UINT16_MAX)
+    {
+        (*p_count)++;
+    }
+}
+
+
+static link_t * link_find(uint16_t conn_handle)
+{
+    for (uint32_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        if (m_links[i].conn_handle == conn_handle)
+        {
+            return &m_links[i];
+        }
+    }
+    return NULL;
+}
+
+
+/**@brief Leave credit mode; what the link has in the pool is dropped. In the BLE interrupt. */
+static void link_end(uint16_t conn_handle)
+{
+    link_t * p_link = link_find(conn_handle);
+
+    if ((p_link == NULL) || (conn_handle == BLE_CONN_HANDLE_INVALID))
+    {
+        return;
+    }
+    p_link->conn_handle = BLE_CONN_HANDLE_INVALID;
+    for (uint8_t i = m_rd; i != m_wr; i++)
+    {
+        slot_t * p_slot = &m_slots[i & (NUS_RX_BUFS - 1)];
+
+        if (p_slot->conn_handle == conn_handle)
+        {
+            p_slot->conn_handle = BLE_CONN_HANDLE_INVALID;
+        }
+    }
+}
+
+
+static void link_start(uint16_t conn_handle)
+{
+    link_t * p_link = link_find(conn_handle);
+
+    if (p_link == NULL)
+    {
+        p_link = link_find(BLE_CONN_HANDLE_INVALID);
+        if (p_link == NULL)
+        {
+            return;
+        }
+    }
+    else
+    {
+        // Subscribed again: the count starts over, without what is left from before.
+        link_end(conn_handle);
+    }
+
+    CRITICAL_REGION_ENTER();
+    p_link->conn_handle = conn_handle;
+    p_link->received    = 0;
+    p_link->limit       = NUS_RX_LINK_CREDITS;
+    p_link->notified    = 0;
+    CRITICAL_REGION_EXIT();
+}
+
+
+/**@brief Notify the links whose limit went up. Main loop. */
+static void credits_notify(void)
+{
+    for (uint32_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        link_t *               p_link = &m_links[i];
+        ble_gatts_hvx_params_t hvx_params;
+        uint8_t                value[sizeof(uint16_t)];
+        uint16_t               len    = sizeof(value);
+        uint16_t               limit  = p_link->limit;
+
+        if ((p_link->conn_handle == BLE_CONN_HANDLE_INVALID) || (p_link->notified == limit))
+        {
+            continue;
+        }
+
+        UNUSED_RETURN_VALUE(uint16_encode(limit, value));
+        memset(&hvx_params, 0, sizeof(hvx_params));
+        hvx_params.handle = m_credit_handles.value_handle;
+        hvx_params.type   = BLE_GATT_HVX_NOTIFICATION;
+        hvx_params.p_len  = &len;
+        hvx_params.p_data = value;
+        if (sd_ble_gatts_hvx(p_link->conn_handle, &hvx_params) == NRF_SUCCESS)
+        {
+            p_link->notified = limit;
+        }
+        // Else out of TX buffers: the next pass, after a TX complete has woken the loop.
+    }
+}
+
+
+ret_code_t nus_rx_init(uint8_t uuid_type, nus_rx_handler_t handler)
+{
+    ret_code_t          err_code;
+    ble_uuid_t          ble_uuid;
+    ble_gatts_char_md_t char_md;
+    ble_gatts_attr_md_t cccd_md;
+    ble_gatts_attr_md_t attr_md;
+    ble_gatts_attr_t    attr_char_value;
+
+    m_handler = handler;
+    for (uint32_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        m_links[i].conn_handle = BLE_CONN_HANDLE_INVALID;
+    }
+
+    ble_uuid.type = uuid_type;
+    ble_uuid.uuid = NUS_RX_UUID_SERVICE;
+    err_code = sd_ble_gatts_service_add(BLE_GATTS_SRVC_TYPE_PRIMARY, &ble_uuid, &m_service_handle);
+    VERIFY_SUCCESS(err_code);
+
+    memset(&cccd_md, 0, sizeof(cccd_md));
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&cccd_md.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&cccd_md.write_perm);
+    cccd_md.vloc = BLE_GATTS_VLOC_STACK;
+
+    memset(&char_md, 0, sizeof(char_md));
+    char_md.char_props.notify = 1;
+    char_md.p_cccd_md         = &cccd_md;
+
+    // Notify only: each link has a value of its own.
+    memset(&attr_md, 0, sizeof(attr_md));
+    BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(&attr_md.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(&attr_md.write_perm);
+    attr_md.vloc = BLE_GATTS_VLOC_STACK;
+
+    ble_uuid.uuid = NUS_RX_UUID_CREDIT;
+    memset(&attr_char_value, 0, sizeof(attr_char_value));
+    attr_char_value.p_uuid    = &ble_uuid;
+    attr_char_value.p_attr_md = &attr_md;
+    attr_char_value.init_len  = sizeof(uint16_t);
+    attr_char_value.max_len   = sizeof(uint16_t);
+
+    return sd_ble_gatts_characteristic_add(m_service_handle, &char_md, &attr_char_value,
+                                           &m_credit_handles);
+}
+
+
+bool nus_rx_on_data(uint16_t conn_handle, uint8_t const * p_data, uint16_t length)
+{
+    link_t * p_link = link_find(conn_handle);
+    slot_t * p_slot;
+    uint8_t  used;
+
+    if ((p_link == NULL) || (conn_handle == BLE_CONN_HANDLE_INVALID))
+    {
+        return false;
+    }
+
+    used = (uint8_t)(m_wr - m_rd);
+    if ((p_link->received == p_link->limit) || (used >= NUS_RX_BUFS) || (length > BLE_NUS_MAX_DATA_LEN))
+    {
+        sat_inc(&m_stats.overruns);
+        return true;
+    }
+
+    p_slot = &m_slots[m_wr & (NUS_RX_BUFS - 1)];
+    p_slot->conn_handle = conn_handle;
+    p_slot->length      = length;
+    memcpy(p_slot->data, p_data, length);
+    p_link->received++;
+    m_wr++;
+
+    m_stats.received++;
+    m_stats.max_used = MAX(m_stats.max_used, used + 1);
+    return true;
+}
+
+
+void nus_rx_process(void)
+{
+    uint8_t batch = 0;
+
+    while ((m_rd != m_wr) && (batch++ < NUS_RX_BATCH))
+    {
+        slot_t * p_slot      = &m_slots[m_rd & (NUS_RX_BUFS - 1)];
+        uint16_t conn_handle = p_slot->conn_handle;
+        link_t * p_link;
+
+        if (conn_handle != BLE_CONN_HANDLE_INVALID)
+        {
+            m_handler(conn_handle, p_slot->data, p_slot->length);
+        }
+        m_rd++;
+
+        // The slot is free again: one more write for its link.
+        CRITICAL_REGION_ENTER();
+        p_link = link_find(conn_handle);
+        if ((p_link != NULL) && (conn_handle != BLE_CONN_HANDLE_INVALID))
+        {
+            p_link->limit++;
+        }
+        CRITICAL_REGION_EXIT();
+    }
+    credits_notify();
+}
+
+
+void nus_rx_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_write_t const * p_evt_write = &p_ble_evt->evt.gatts_evt.params.write;
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_DISCONNECTED:
+            link_end(p_ble_evt->evt.gap_evt.conn_handle);
+            break;
+
+        case BLE_GATTS_EVT_WRITE:
+            if ((p_evt_write->handle == m_credit_handles.cccd_handle) && (p_evt_write->len == 2))
+            {
+                if (ble_srv_is_notification_enabled(p_evt_write->data))
+                {
+                    link_start(p_ble_evt->evt.gatts_evt.conn_handle);
+                }
+                else
+                {
+                    link_end(p_ble_evt->evt.gatts_evt.conn_handle);
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+void nus_rx_stats_get(nus_rx_stats_t * p_stats)
+{
+    CRITICAL_REGION_ENTER();
+    *p_stats = m_stats;
+    CRITICAL_REGION_EXIT();
+}
+
+#endif //NRF_MODULE_ENABLED(NUS_RX)
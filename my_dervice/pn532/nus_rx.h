@@ -0,0 +1,56 @@
+#ifndef __NUS_RX_H__
+#define __NUS_RX_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "ble.h"
+
+/* Flow control for NUS writes, so uploads can go as write without response at the rate of the
+ * link and nothing is overwritten on the way in:
+ *
+ *   credits   service 0x0015 on the NUS base, characteristic 0x0016, notify. A link that
+ *             subscribes is in credit mode: the value, 16 bit little endian, is how many writes
+ *             the link may have sent since it subscribed. It starts at NUS_RX_LINK_CREDITS and
+ *             goes up by one for each write the application is done with
+ *   pool      writes of a link in credit mode are copied into one of NUS_RX_BUFS buffers, in
+ *             order, and handed to the application from the main loop by nus_rx_process();
+ *             there they run right away instead of through the scheduler queue
+ *   overruns  a write beyond the credits of its link is dropped and counted, never written
+ *             over another one
+ *
+ * Links that do not subscribe keep the plain path. A long write spends a credit for each
+ * BLE_NUS_MAX_DATA_LEN bytes of it. The writes of a link that goes are dropped with it. */
+
+/**@brief Gets a write of a link in credit mode, in the main loop. */
+typedef void (*nus_rx_handler_t)(uint16_t conn_handle, uint8_t * p_data, uint16_t length);
+
+typedef struct
+{
+    uint32_t received;      /**< Writes taken into the pool. */
+    uint16_t overruns;      /**< Writes dropped beyond the credits; saturated. */
+    uint8_t  max_used;      /**< Most buffers held at once. */
+} nus_rx_stats_t;
+
+/**@brief Add the credit service.
+ *
+ * @param[in] uuid_type  Vendor UUID type of the NUS base.
+ * @param[in] handler    Gets the writes of links in credit mode.
+ */
+ret_code_t nus_rx_init(uint8_t uuid_type, nus_rx_handler_t handler);
+
+/**@brief Take a NUS write. From the NUS data handler.
+ *
+ * @return false when the link is not in credit mode, so the write takes the plain path.
+ */
+bool nus_rx_on_data(uint16_t conn_handle, uint8_t const * p_data, uint16_t length);
+
+/**@brief Hand pooled writes to the handler and notify the credits they free. Main loop. */
+void nus_rx_process(void);
+
+/**@brief Follow the subscriptions and the links. */
+void nus_rx_on_ble_evt(ble_evt_t * p_ble_evt);
+
+void nus_rx_stats_get(nus_rx_stats_t * p_stats);
+
+#endif
@@ -0,0 +1,360 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(NUS_TX)
+#include "nus_tx.h"
+#include "app_util_platform.h"
+#include "softdevice_handler.h"
+#include "wdt_sup.h"
+#include "link_stats.h"
+#include "lat_trace.h"
+#include <string.h>
+
+/**@brief One notification. */
+typedef struct
+{
+    uint8_t len;
+    uint8_t data[BLE_NUS_MAX_DATA_LEN];
+} nus_tx_slot_t;
+
+/**@brief Queue of one peer. */
+typedef struct
+{
+    uint16_t      conn_handle;   /**< BLE_CONN_HANDLE_INVALID for a free queue. */
+    bool          admin;         /**< Gets a copy of every result. */
+    bool          tail_open;     /**< The last queued slot is stream data and may take more. */
+    uint8_t       head;          /**< Next slot to hand to the SoftDevice. */
+    uint8_t       count;         /**< Slots queued. */
+    nus_tx_slot_t slots[NUS_TX_QUEUE_SIZE];
+} nus_tx_link_t;
+
+static ble_nus_t *   m_p_nus;
+static nus_tx_link_t m_links[BLE_NUS_LINK_COUNT];
+static uint16_t      m_target = BLE_CONN_HANDLE_ALL;
+static uint8_t       m_first;       /**< Link that is pumped first on the next event. */
+
+
+static bool peer_listening(nus_tx_link_t const * p_link)
+{
+    return (p_link->conn_handle != BLE_CONN_HANDLE_INVALID) &&
+           ble_nus_is_notification_enabled(m_p_nus, p_link->conn_handle);
+}
+
+
+static void queue_drop(nus_tx_link_t * p_link)
+{
+    p_link->head      = 0;
+    p_link->count     = 0;
+    p_link->tail_open = false;
+#if NRF_MODULE_ENABLED(LINK_STATS)
+    link_stats_queue_depth(p_link->conn_handle, 0);
+#endif
+}
+
+
+/**@brief Hand queued slots of a link to the SoftDevice until it runs out of TX buffers.
+ *
+ * @details Called with the queues locked, from the thread after queueing and from the BLE
+ *          event on BLE_EVT_TX_COMPLETE, so every buffer freed in a connection event is refilled.
+ */
+static void queue_pump(nus_tx_link_t * p_link)
+{
+    while (p_link->count != 0)
+    {
+        nus_tx_slot_t * p_slot   = &p_link->slots[p_link->head];
+        uint32_t        err_code = ble_nus_string_send_to(m_p_nus, p_link->conn_handle,
+                                                          p_slot->data, p_slot->len);
+
+        if (err_code == BLE_ERROR_NO_TX_PACKETS)
+        {
+#if NRF_MODULE_ENABLED(LINK_STATS)
+            link_stats_tx_refused(p_link->conn_handle);
+            link_stats_queue_depth(p_link->conn_handle, p_link->count);
+#endif
+            return;
+        }
+        if (err_code == NRF_ERROR_INVALID_STATE)
+        {
+            // Disconnected or notifications turned off; nobody will read the rest.
+            queue_drop(p_link);
+            return;
+        }
+
+#if NRF_MODULE_ENABLED(LINK_STATS)
+        if (err_code == NRF_SUCCESS)
+        {
+            link_stats_tx_sent(p_link->conn_handle, p_slot->len);
+        }
+#endif
+        // Sent, or refused for good; either way the slot is done.
+        p_link->head = (p_link->head + 1) % NUS_TX_QUEUE_SIZE;
+        p_link->count--;
+        if (p_link->count == 0)
+        {
+            p_link->tail_open = false;
+        }
+    }
+#if NRF_MODULE_ENABLED(LINK_STATS)
+    link_stats_queue_depth(p_link->conn_handle, 0);
+#endif
+}
+
+
+/**@brief Pump every link, starting with another one each time, so a link whose buffers
+ *        the SoftDevice shares with the others does not always get them first.
+ */
+static void queue_pump_all(void)
+{
+    for (uint8_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        nus_tx_link_t * p_link = &m_links[(m_first + i) % BLE_NUS_LINK_COUNT];
+
+        if (p_link->conn_handle != BLE_CONN_HANDLE_INVALID)
+        {
+            queue_pump(p_link);
+        }
+    }
+    m_first = (m_first + 1) % BLE_NUS_LINK_COUNT;
+}
+
+
+static void cpu_wait(void)
+{
+    if (softdevice_handler_is_enabled())
+    {
+        UNUSED_RETURN_VALUE(sd_app_evt_wait());
+        return;
+    }
+    __WFE();
+    __SEV();
+    __WFE();
+}
+
+
+static ret_code_t queue_put(nus_tx_link_t * p_link, uint8_t const * p_data, uint16_t len, bool stream)
+{
+    bool       thread      = (current_int_priority_get() == APP_IRQ_PRIORITY_THREAD);
+    uint16_t   conn_handle = p_link->conn_handle;
+    ret_code_t err_code    = NRF_SUCCESS;
+    bool       waited      = false;
+#if NRF_MODULE_ENABLED(LAT_TRACE)
+    uint32_t   wait_start  = 0;
+#endif
+
+    while (len != 0)
+    {
+        bool     full;
+        bool     gone;
+        uint16_t max;
+
+        CRITICAL_REGION_ENTER();
+        // The peer went away, and its queue may already serve another.
+        gone = (p_link->conn_handle != conn_handle);
+        // Grows once the peer has exchanged a larger ATT MTU; slots queued before stay short.
+        max  = ble_nus_data_len_get(m_p_nus, conn_handle);
+        if (!gone && stream && p_link->tail_open)
+        {
+            nus_tx_slot_t * p_slot = &p_link->slots[(p_link->head + p_link->count - 1) % NUS_TX_QUEUE_SIZE];
+            uint16_t        chunk  = MIN(len, max - p_slot->len);
+
+            memcpy(&p_slot->data[p_slot->len], p_data, chunk);
+            p_slot->len += chunk;
+            p_data      += chunk;
+            len         -= chunk;
+        }
+        while (!gone && (len != 0) && (p_link->count < NUS_TX_QUEUE_SIZE))
+        {
+            nus_tx_slot_t * p_slot = &p_link->slots[(p_link->head + p_link->count) % NUS_TX_QUEUE_SIZE];
+            uint16_t        chunk  = MIN(len, max);
+
+            memcpy(p_slot->data, p_data, chunk);
+            p_slot->len = chunk;
+            p_data     += chunk;
+            len        -= chunk;
+            p_link->count++;
+        }
+        if (!gone)
+        {
+            p_link->tail_open = stream && (p_link->count != 0) &&
+                                (p_link->slots[(p_link->head + p_link->count - 1) % NUS_TX_QUEUE_SIZE].len < max);
+            queue_pump(p_link);
+        }
+        full = (len != 0) && (p_link->count == NUS_TX_QUEUE_SIZE);
+        CRITICAL_REGION_EXIT();
+
+        if (gone)
+        {
+            err_code = NRF_ERROR_NO_MEM;
+            break;
+        }
+        if (full)
+        {
+            if (!thread || !peer_listening(p_link))
+            {
+                err_code = NRF_ERROR_NO_MEM;
+                break;
+            }
+            if (!waited)
+            {
+                waited = true;
+#if NRF_MODULE_ENABLED(LAT_TRACE)
+                wait_start = app_timer_cnt_get();
+#endif
+            }
+#if NRF_MODULE_ENABLED(WDT_SUP)
+            // A peer that keeps the link up but stops taking notifications would hold us here.
+            wdt_sup_begin(WDT_SUP_BLE_TX);
+            if (wdt_sup_expired(WDT_SUP_BLE_TX))
+            {
+                err_code = NRF_ERROR_TIMEOUT;
+                break;
+            }
+#endif
+            // Room is made by BLE_EVT_TX_COMPLETE, which runs in the SoftDevice interrupt.
+            cpu_wait();
+        }
+    }
+    if (waited)
+    {
+#if NRF_MODULE_ENABLED(WDT_SUP)
+        wdt_sup_end(WDT_SUP_BLE_TX);
+#endif
+#if NRF_MODULE_ENABLED(LAT_TRACE)
+        lat_trace_record(LAT_STAGE_TX_WAIT, wait_start);
+#endif
+    }
+
+    return err_code;
+}
+
+
+void nus_tx_init(ble_nus_t * p_nus)
+{
+    m_p_nus  = p_nus;
+    m_target = BLE_CONN_HANDLE_ALL;
+    for (uint8_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        m_links[i].conn_handle = BLE_CONN_HANDLE_INVALID;
+        m_links[i].admin       = false;
+        queue_drop(&m_links[i]);
+    }
+}
+
+
+void nus_tx_target_set(uint16_t conn_handle)
+{
+    m_target = conn_handle;
+}
+
+
+uint16_t nus_tx_target_get(void)
+{
+    return m_target;
+}
+
+
+ret_code_t nus_tx_admin_set(uint16_t conn_handle, bool admin)
+{
+    for (uint8_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        if ((conn_handle != BLE_CONN_HANDLE_INVALID) && (m_links[i].conn_handle == conn_handle))
+        {
+            m_links[i].admin = admin;
+            return NRF_SUCCESS;
+        }
+    }
+    return NRF_ERROR_NOT_FOUND;
+}
+
+
+ret_code_t nus_tx_put(uint16_t conn_handle, uint8_t const * p_data, uint16_t len, uint8_t flags)
+{
+    ret_code_t err_code = NRF_ERROR_INVALID_STATE;
+
+    for (uint8_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+    {
+        nus_tx_link_t * p_link = &m_links[i];
+        bool            to     = (conn_handle == BLE_CONN_HANDLE_ALL) || (p_link->conn_handle == conn_handle);
+
+        if ((to || (((flags & NUS_TX_ADMINS) != 0) && p_link->admin)) && peer_listening(p_link))
+        {
+            ret_code_t link_err = queue_put(p_link, p_data, len, (flags & NUS_TX_STREAM) != 0);
+
+            if ((err_code == NRF_ERROR_INVALID_STATE) || (link_err != NRF_SUCCESS))
+            {
+                err_code = link_err;
+            }
+        }
+    }
+
+    return err_code;
+}
+
+
+ret_code_t nus_tx_send(uint8_t const * p_data, uint16_t len)
+{
+    return nus_tx_put(m_target, p_data, len, 0);
+}
+
+
+ret_code_t nus_tx_stream(uint8_t const * p_data, uint16_t len)
+{
+    return nus_tx_put(m_target, p_data, len, NUS_TX_STREAM);
+}
+
+
+ret_code_t nus_tx_result(uint8_t const * p_data, uint16_t len)
+{
+    return nus_tx_put(m_target, p_data, len, NUS_TX_ADMINS);
+}
+
+
+void nus_tx_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    uint16_t conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_EVT_TX_COMPLETE:
+#if NRF_MODULE_ENABLED(WDT_SUP)
+            wdt_sup_beat(WDT_SUP_BLE_TX);
+#endif
+            CRITICAL_REGION_ENTER();
+            queue_pump_all();
+            CRITICAL_REGION_EXIT();
+            break;
+
+        case BLE_GAP_EVT_CONNECTED:
+            for (uint8_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+            {
+                if (m_links[i].conn_handle == BLE_CONN_HANDLE_INVALID)
+                {
+                    CRITICAL_REGION_ENTER();
+                    queue_drop(&m_links[i]);
+                    m_links[i].admin       = false;
+                    m_links[i].conn_handle = conn_handle;
+                    CRITICAL_REGION_EXIT();
+                    break;
+                }
+            }
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            for (uint8_t i = 0; i < BLE_NUS_LINK_COUNT; i++)
+            {
+                if (m_links[i].conn_handle == conn_handle)
+                {
+                    CRITICAL_REGION_ENTER();
+                    queue_drop(&m_links[i]);
+                    m_links[i].admin       = false;
+                    m_links[i].conn_handle = BLE_CONN_HANDLE_INVALID;
+                    CRITICAL_REGION_EXIT();
+                }
+            }
+            // m_target is left alone: what is still sent for a request of this peer is dropped.
+            break;
+
+        default:
+            break;
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(NUS_TX)
@@ -0,0 +1,87 @@
+#ifndef __NUS_TX_H__
+#define __NUS_TX_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "ble.h"
+#include "ble_nus.h"
+
+/* Every connected peer has a queue of its own, BLE_NUS_LINK_COUNT in all. Messages go to the
+ * target link, the peer whose request is being served, or to every peer with notifications
+ * enabled while none is. Results can be copied to the admin links as well. */
+
+#define NUS_TX_STREAM  0x01  /**< Pack behind stream data not yet handed to the SoftDevice. */
+#define NUS_TX_ADMINS  0x02  /**< Copy to every admin link too. */
+
+/**@brief Start with empty queues and no admin links.
+ *
+ * @param[in] p_nus  Service the notifications are sent on.
+ */
+void nus_tx_init(ble_nus_t * p_nus);
+
+/**@brief Set the link that @ref nus_tx_send, @ref nus_tx_stream and @ref nus_tx_result go to.
+ *
+ * @param[in] conn_handle  Connection of the peer being served, or BLE_CONN_HANDLE_ALL for
+ *                         every peer with notifications enabled (the default).
+ */
+void nus_tx_target_set(uint16_t conn_handle);
+
+/**@brief Link set with @ref nus_tx_target_set. */
+uint16_t nus_tx_target_get(void);
+
+/**@brief Make a connected peer an admin link, which gets a copy of every result, or not.
+ *
+ * @retval NRF_SUCCESS         Set, until the peer disconnects.
+ * @retval NRF_ERROR_NOT_FOUND The peer is not connected.
+ */
+ret_code_t nus_tx_admin_set(uint16_t conn_handle, bool admin);
+
+/**@brief Queue data for one link, all links or the admin links only.
+ *
+ * @param[in] conn_handle  Link; BLE_CONN_HANDLE_ALL for every peer with notifications enabled,
+ *                         or BLE_CONN_HANDLE_INVALID with NUS_TX_ADMINS for the admin links only.
+ * @param[in] p_data       Data.
+ * @param[in] len          Length.
+ * @param[in] flags        NUS_TX_STREAM, NUS_TX_ADMINS.
+ *
+ * @retval NRF_SUCCESS             Queued for every link it was meant for.
+ * @retval NRF_ERROR_INVALID_STATE No such link has notifications enabled; nothing was queued.
+ * @retval NRF_ERROR_NO_MEM        A queue was full and this was called from an interrupt, or
+ *                                 the peer went away while waiting for room; the message
+ *                                 was cut short on that link.
+ */
+ret_code_t nus_tx_put(uint16_t conn_handle, uint8_t const * p_data, uint16_t len, uint8_t flags);
+
+/**@brief Queue a message that starts its own notification, for the target link.
+ *
+ * @details Use for replies the phone parses by position. Messages longer than the link
+ *          takes, ble_nus_data_len_get(), are split over several notifications.
+ *
+ * @return Same as @ref nus_tx_put.
+ */
+ret_code_t nus_tx_send(uint8_t const * p_data, uint16_t len);
+
+/**@brief Queue bytes of a stream for the target link, packed behind data of the stream not
+ *        yet handed to the SoftDevice.
+ *
+ * @details Card dumps go this way, so a 16-byte block shares a notification with the start
+ *          of the next one when the link is backed up.
+ *
+ * @return Same as @ref nus_tx_put.
+ */
+ret_code_t nus_tx_stream(uint8_t const * p_data, uint16_t len);
+
+/**@brief Queue a result, such as a card report, like @ref nus_tx_send with a copy for every
+ *        admin link.
+ *
+ * @return Same as @ref nus_tx_put.
+ */
+ret_code_t nus_tx_result(uint8_t const * p_data, uint16_t len);
+
+/**@brief Feed the queues from the BLE events: send on BLE_EVT_TX_COMPLETE, take a link on
+ *        connect and drop it on disconnect.
+ */
+void nus_tx_on_ble_evt(ble_evt_t * p_ble_evt);
+
+#endif
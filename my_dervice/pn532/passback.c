@@ -0,0 +1,456 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PASSBACK)
+#include "passback.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "app_util_platform.h"
+#include "nrf_crypto_aes.h"
+#include "reader_tlm.h"
+#include "wall_clock.h"
+#include "nrf.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(NRF_CRYPTO_AES) || !NRF_MODULE_ENABLED(WALL_CLOCK)
+#error "passback needs NRF_CRYPTO_AES and WALL_CLOCK"
+#endif
+
+#define PB_TICKS(ms)        APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+#define AGE_MAX             255
+
+#define STATES              2
+#define STATE_LEN           6                               /**< uid hash, state, age. */
+#define OFS_SITE            0
+#define OFS_READER          1
+#define OFS_TIME            3
+#define OFS_SEQ             7
+#define OFS_STATES          8
+#define OFS_MAC             (OFS_STATES + STATES * STATE_LEN)
+#define MAC_LEN             4
+#define FRAME_LEN           (OFS_MAC + MAC_LEN)             /**< Without the company id. */
+
+/** The state this reader gives the cards it lets through. */
+#define OWN_STATE           ((PASSBACK_DIRECTION == 0) ? PASSBACK_IN : PASSBACK_OUT)
+
+// Flags, then the manufacturer specific data: all of a legacy advertising packet.
+STATIC_ASSERT(3 + 2 + 2 + FRAME_LEN <= BLE_GAP_ADV_MAX_SIZE);
+STATIC_ASSERT(PASSBACK_TABLE_SIZE > 0);
+STATIC_ASSERT(PASSBACK_SCAN_WINDOW_MS <= PASSBACK_SCAN_INTERVAL_MS);
+
+typedef struct
+{
+    uint32_t hash;
+    uint32_t stamp;     /**< wall_clock_now() at the grant. */
+    uint8_t  state;     /**< PASSBACK_IN or PASSBACK_OUT. */
+} entry_t;
+
+typedef struct
+{
+    uint16_t reader;
+    uint32_t time;
+    uint8_t  seq;
+} peer_t;
+
+APP_TIMER_DEF(m_show_timer);
+APP_TIMER_DEF(m_scan_timer);
+
+static uint8_t const *          mp_key;
+static ble_advdata_t            m_advdata;
+static ble_advdata_t            m_srdata;
+static passback_restore_t       m_restore;
+static volatile bool            m_showing;
+
+static entry_t                  m_table[PASSBACK_TABLE_SIZE];  /**< Most recent first. */
+static uint8_t                  m_count;
+static entry_t                  m_own[STATES];                 /**< Newest first. */
+static peer_t                   m_peers[PASSBACK_PEERS];       /**< Most recent first. */
+static uint8_t                  m_peer_count;
+
+static uint16_t                 m_reader;
+static uint8_t                  m_seq;
+static uint8_t                  m_frame[FRAME_LEN];
+static ble_advdata_manuf_data_t m_manuf;
+static uint8_t                  m_last_rx[FRAME_LEN];          /**< Last frame scheduled. */
+
+
+/**@brief FNV-1a over the UID bytes. */
+static uint32_t uid_hash(uint8_t const * p_uid, uint8_t len)
+{
+    uint32_t hash = 2166136261UL;
+
+    for (uint8_t i = 0; i < len; i++)
+    {
+        hash = (hash ^ p_uid[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+
+/**@brief Truncated CMAC of a frame, over the company id and the fields before the MAC. */
+static ret_code_t frame_mac(uint8_t const * p_frame, uint8_t * p_mac)
+{
+    uint8_t    data[2 + OFS_MAC];
+    uint8_t    mac[NRF_CRYPTO_AES_BLOCK_SIZE];
+    ret_code_t err_code;
+
+    UNUSED_RETURN_VALUE(uint16_encode(PASSBACK_COMPANY_ID, data));
+    memcpy(&data[2], p_frame, OFS_MAC);
+
+    err_code = nrf_crypto_aes_cmac(mp_key, data, sizeof(data), mac);
+    VERIFY_SUCCESS(err_code);
+    memcpy(p_mac, mac, MAC_LEN);
+    return NRF_SUCCESS;
+}
+
+
+/**@brief Put a state in the table unless it holds a newer one of the card. Main loop. */
+static void table_merge(uint32_t hash, uint8_t state, uint32_t stamp)
+{
+    uint8_t i;
+
+    for (i = 0; i < m_count; i++)
+    {
+        if (m_table[i].hash == hash)
+        {
+            break;
+        }
+    }
+    if ((i < m_count) && ((int32_t)(stamp - m_table[i].stamp) <= 0))
+    {
+        return;
+    }
+
+    // passback_check() reads the table from the tap path.
+    CRITICAL_REGION_ENTER();
+    if (i == m_count)
+    {
+        if (m_count < PASSBACK_TABLE_SIZE)
+        {
+            m_count++;
+        }
+        i = m_count - 1;
+    }
+    memmove(&m_table[1], &m_table[0], i * sizeof(entry_t));
+    m_table[0].hash  = hash;
+    m_table[0].stamp = stamp;
+    m_table[0].state = state;
+    CRITICAL_REGION_EXIT();
+}
+
+
+/**@brief Fill the frame from the own states. */
+static void frame_build(void)
+{
+    uint32_t now = wall_clock_now();
+    uint8_t  len = OFS_STATES;
+
+    memset(m_frame, 0, sizeof(m_frame));
+    m_frame[OFS_SITE] = PASSBACK_SITE_ID;
+    UNUSED_RETURN_VALUE(uint16_encode(m_reader, &m_frame[OFS_READER]));
+    UNUSED_RETURN_VALUE(uint32_encode(now, &m_frame[OFS_TIME]));
+    m_frame[OFS_SEQ] = ++m_seq;
+
+    // A state older than AGE_MAX is left out: its age would make it look newer.
+    for (uint8_t i = 0; i < STATES; i++)
+    {
+        if ((m_own[i].state != 0) && ((now - m_own[i].stamp) < AGE_MAX))
+        {
+            len += uint32_encode(m_own[i].hash, &m_frame[len]);
+            m_frame[len++] = m_own[i].state;
+            m_frame[len++] = (uint8_t)(now - m_own[i].stamp);
+        }
+    }
+}
+
+
+static void frame_show(void)
+{
+    ble_advdata_t advdata;
+
+    frame_build();
+    if (frame_mac(m_frame, &m_frame[OFS_MAC]) != NRF_SUCCESS)
+    {
+        return;
+    }
+
+    memset(&advdata, 0, sizeof(advdata));
+    advdata.flags                 = BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE;
+    advdata.p_manuf_specific_data = &m_manuf;
+
+    m_showing = true;
+    // Takes effect with the next advertising event, also while advertising.
+    UNUSED_RETURN_VALUE(ble_advdata_set(&advdata, &m_srdata));
+    UNUSED_RETURN_VALUE(app_timer_stop(m_show_timer));
+    UNUSED_RETURN_VALUE(app_timer_start(m_show_timer, PB_TICKS(PASSBACK_SHOW_MS), NULL));
+}
+
+
+static void show_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    m_showing = false;
+#if NRF_MODULE_ENABLED(READER_TLM)
+    // The health frame took over meanwhile; it puts the data back when it is done.
+    if (reader_tlm_showing())
+    {
+        return;
+    }
+#endif
+    if (m_restore != NULL)
+    {
+        m_restore();
+    }
+    else
+    {
+        UNUSED_RETURN_VALUE(ble_advdata_set(&m_advdata, &m_srdata));
+    }
+}
+
+
+static void scan_start(void)
+{
+    ble_gap_scan_params_t scan_params;
+
+    memset(&scan_params, 0, sizeof(scan_params));
+    scan_params.active   = 0;
+    scan_params.interval = MSEC_TO_UNITS(PASSBACK_SCAN_INTERVAL_MS, UNIT_0_625_MS);
+    scan_params.window   = MSEC_TO_UNITS(PASSBACK_SCAN_WINDOW_MS, UNIT_0_625_MS);
+    scan_params.timeout  = 0;
+
+    // Fails while scanning already, or while gw_push connects: tried again by the timer.
+    UNUSED_RETURN_VALUE(sd_ble_gap_scan_start(&scan_params));
+}
+
+
+static void scan_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+    scan_start();
+}
+
+
+/**@brief Whether a frame is newer than the last one taken from its reader; remembers it. */
+static bool peer_fresh(uint16_t reader, uint32_t time, uint8_t seq)
+{
+    uint8_t i;
+
+    for (i = 0; i < m_peer_count; i++)
+    {
+        if (m_peers[i].reader == reader)
+        {
+            break;
+        }
+    }
+    if (i < m_peer_count)
+    {
+        int32_t diff = (int32_t)(time - m_peers[i].time);
+
+        if ((diff < 0) || ((diff == 0) && ((int8_t)(seq - m_peers[i].seq) <= 0)))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        if (m_peer_count < PASSBACK_PEERS)
+        {
+            m_peer_count++;
+        }
+        i = m_peer_count - 1;
+    }
+    memmove(&m_peers[1], &m_peers[0], i * sizeof(peer_t));
+    m_peers[0].reader = reader;
+    m_peers[0].time   = time;
+    m_peers[0].seq    = seq;
+    return true;
+}
+
+
+/**@brief Check a received frame and take its states. Main loop, the CMAC is not for interrupts. */
+static void frame_rx_handler(void * p_event_data, uint16_t event_size)
+{
+    uint8_t const * p_frame = p_event_data;
+    uint8_t         mac[MAC_LEN];
+    uint32_t        now;
+    uint32_t        time;
+    uint16_t        reader;
+    int32_t         skew;
+
+    UNUSED_PARAMETER(event_size);
+
+    if (!wall_clock_synced())
+    {
+        return;
+    }
+    now    = wall_clock_now();
+    time   = uint32_decode(&p_frame[OFS_TIME]);
+    reader = uint16_decode(&p_frame[OFS_READER]);
+    skew   = (int32_t)(now - time);
+    if ((reader == m_reader) || (skew > PASSBACK_MAX_SKEW_S) || (skew < -PASSBACK_MAX_SKEW_S))
+    {
+        return;
+    }
+    if ((frame_mac(p_frame, mac) != NRF_SUCCESS) || (memcmp(mac, &p_frame[OFS_MAC], MAC_LEN) != 0))
+    {
+        return;
+    }
+    if (!peer_fresh(reader, time, p_frame[OFS_SEQ]))
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < STATES; i++)
+    {
+        uint8_t const * p_state = &p_frame[OFS_STATES + i * STATE_LEN];
+
+        if ((p_state[4] == PASSBACK_IN) || (p_state[4] == PASSBACK_OUT))
+        {
+            table_merge(uint32_decode(p_state), p_state[4], time - p_state[5]);
+        }
+    }
+}
+
+
+/**@brief Find the frame of the site in an advertising report.
+ *
+ * @return The frame, or NULL.
+ */
+static uint8_t const * report_frame(ble_gap_evt_adv_report_t const * p_report)
+{
+    uint8_t i = 0;
+
+    while ((i + 1) < p_report->dlen)
+    {
+        uint8_t         len    = p_report->data[i];
+        uint8_t const * p_data = &p_report->data[i + 2];
+
+        if ((len == 0) || ((i + 1 + len) > p_report->dlen))
+        {
+            break;
+        }
+        if ((p_report->data[i + 1] == BLE_GAP_AD_TYPE_MANUFACTURER_SPECIFIC_DATA) &&
+            (len == 1 + 2 + FRAME_LEN) &&
+            (uint16_decode(p_data) == PASSBACK_COMPANY_ID) &&
+            (p_data[2 + OFS_SITE] == PASSBACK_SITE_ID))
+        {
+            return &p_data[2];
+        }
+        i += 1 + len;
+    }
+    return NULL;
+}
+
+
+ret_code_t passback_init(uint8_t const * p_key, ble_advdata_t const * p_advdata,
+                         ble_advdata_t const * p_srdata, passback_restore_t restore)
+{
+    ret_code_t err_code;
+
+    mp_key    = p_key;
+    m_advdata = *p_advdata;
+    m_srdata  = *p_srdata;
+    m_restore = restore;
+    m_showing = false;
+    m_reader  = (uint16_t)NRF_FICR->DEVICEID[0];
+
+    m_manuf.company_identifier = PASSBACK_COMPANY_ID;
+    m_manuf.data.p_data        = m_frame;
+    m_manuf.data.size          = sizeof(m_frame);
+
+    err_code = app_timer_create(&m_show_timer, APP_TIMER_MODE_SINGLE_SHOT, show_timer_handler);
+    VERIFY_SUCCESS(err_code);
+    err_code = app_timer_create(&m_scan_timer, APP_TIMER_MODE_REPEATED, scan_timer_handler);
+    VERIFY_SUCCESS(err_code);
+
+    scan_start();
+    return app_timer_start(m_scan_timer, PB_TICKS(PASSBACK_SCAN_RETRY_S * 1000), NULL);
+}
+
+
+bool passback_check(uint8_t const * p_uid, uint8_t len)
+{
+    uint32_t hash = uid_hash(p_uid, len);
+    uint32_t now;
+    bool     allow = true;
+
+    if (!wall_clock_synced())
+    {
+        return true;
+    }
+    now = wall_clock_now();
+
+    CRITICAL_REGION_ENTER();
+    for (uint8_t i = 0; i < m_count; i++)
+    {
+        if (m_table[i].hash == hash)
+        {
+            allow = (m_table[i].state != OWN_STATE) ||
+                    ((int32_t)(now - m_table[i].stamp) >= (int32_t)(PASSBACK_FORGET_MIN * 60UL));
+            break;
+        }
+    }
+    CRITICAL_REGION_EXIT();
+
+    return allow;
+}
+
+
+void passback_record(uint8_t const * p_uid, uint8_t len)
+{
+    uint32_t hash = uid_hash(p_uid, len);
+    uint32_t now;
+
+    // Without the time of the site the stamps mean nothing to the other readers.
+    if (!wall_clock_synced())
+    {
+        return;
+    }
+    now = wall_clock_now();
+
+    table_merge(hash, OWN_STATE, now);
+    if (m_own[0].hash != hash)
+    {
+        memmove(&m_own[1], &m_own[0], (STATES - 1) * sizeof(entry_t));
+    }
+    m_own[0].hash  = hash;
+    m_own[0].stamp = now;
+    m_own[0].state = OWN_STATE;
+
+    frame_show();
+}
+
+
+bool passback_showing(void)
+{
+    return m_showing;
+}
+
+
+void passback_scan_yield(void)
+{
+    UNUSED_RETURN_VALUE(sd_ble_gap_scan_stop());
+}
+
+
+void passback_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    uint8_t const * p_frame;
+
+    if (p_ble_evt->header.evt_id != BLE_GAP_EVT_ADV_REPORT)
+    {
+        return;
+    }
+
+    p_frame = report_frame(&p_ble_evt->evt.gap_evt.params.adv_report);
+    // A reader shows a frame for many advertising events: schedule each one once.
+    if ((p_frame == NULL) || (memcmp(p_frame, m_last_rx, FRAME_LEN) == 0))
+    {
+        return;
+    }
+    if (app_sched_event_put((void *)p_frame, FRAME_LEN, frame_rx_handler) == NRF_SUCCESS)
+    {
+        memcpy(m_last_rx, p_frame, FRAME_LEN);
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(PASSBACK)
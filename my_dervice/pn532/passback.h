@@ -0,0 +1,75 @@
+#ifndef __PASSBACK_H__
+#define __PASSBACK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "ble.h"
+#include "ble_advdata.h"
+
+/* Anti-passback between the entry and exit readers of a site, shared reader to reader over
+ * advertising, with no phone and no connection in between:
+ *
+ *   state     a card granted at an entry reader is in, at an exit reader out. A reader
+ *             refuses a card that is already in the state it would put it in; a card not seen
+ *             for PASSBACK_FORGET_MIN, or never seen, is let through
+ *   table     the PASSBACK_TABLE_SIZE cards seen last, by FNV-1a hash of the UID, in RAM; the
+ *             check on the tap path is a lookup there and nothing else
+ *   frame     after each grant the advertising data is the frame for PASSBACK_SHOW_MS, in the
+ *             manufacturer specific data under PASSBACK_COMPANY_ID:
+ *
+ *               site, reader (LE), time (LE), seq, 2 x {uid hash (LE), state, age}, mac
+ *
+ *             the two newest states of this reader, age the seconds before time, mac the first 4
+ *             bytes of the AES-CMAC under the site key of the company id and everything before it
+ *   scan      the readers scan passively, PASSBACK_SCAN_WINDOW_MS every
+ *             PASSBACK_SCAN_INTERVAL_MS, next to their advertising and their phone link. A frame
+ *             is taken if it is newer than the last one of its reader, within
+ *             PASSBACK_MAX_SKEW_S of the own clock and signed; then each state replaces an older
+ *             one of the same card
+ *
+ * time is wall_clock_now(), so frames are only sent and taken once the phone has set the clock.
+ * No advertising runs while a phone is connected: the frame then goes out once it has left. A
+ * missed frame makes the check lenient, never strict. */
+
+#define PASSBACK_IN   1  /**< Entered at an entry reader. */
+#define PASSBACK_OUT  2  /**< Left at an exit reader. */
+
+/**@brief Puts the normal advertising data back after a frame. */
+typedef void (*passback_restore_t)(void);
+
+/**@brief Start scanning for the frames of the other readers.
+ *
+ * @details Call after ble_advertising_init() with the same data, and after wall_clock_init().
+ *          The structures are copied; what they and @p p_key point to must stay valid.
+ *
+ * @param[in] p_key      AES-128 key the frames of the site are signed with.
+ * @param[in] p_advdata  Advertising data, put back after each frame when @p restore is NULL.
+ * @param[in] p_srdata   Scan response data, kept during the frames.
+ * @param[in] restore    Owner of the advertising data that puts it back, or NULL.
+ */
+ret_code_t passback_init(uint8_t const * p_key, ble_advdata_t const * p_advdata,
+                         ble_advdata_t const * p_srdata, passback_restore_t restore);
+
+/**@brief Whether this reader lets a card through. Any context; no radio, no flash.
+ *
+ * @param[in] p_uid  UID.
+ * @param[in] len    UID length.
+ */
+bool passback_check(uint8_t const * p_uid, uint8_t len);
+
+/**@brief A card has been let through: record its new state and send it. Main loop. */
+void passback_record(uint8_t const * p_uid, uint8_t len);
+
+/**@brief Whether the advertising data is a frame. */
+bool passback_showing(void);
+
+/**@brief Stop scanning for a while, for a connection the SoftDevice cannot make meanwhile.
+ *        Scanning starts again within PASSBACK_SCAN_RETRY_S.
+ */
+void passback_scan_yield(void);
+
+/**@brief Handle a BLE event: the advertising reports of the scan. */
+void passback_on_ble_evt(ble_evt_t * p_ble_evt);
+
+#endif
@@ -0,0 +1,225 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PEER_BOND)
+#include "peer_bond.h"
+#include "peer_manager.h"
+#include "ble_conn_state.h"
+#include "fds.h"
+#include "app_error.h"
+#include <string.h>
+
+#define SEC_PARAM_MIN_KEY_SIZE  7
+#define SEC_PARAM_MAX_KEY_SIZE  16
+
+static pm_peer_id_t m_last_peer = PM_PEER_ID_INVALID;   /**< Peer of the last bonded link. */
+
+
+/**@brief Whitelist the bonded peers; the last one first, in case there are more than fit. */
+static void whitelist_refresh(void)
+{
+#if PEER_BOND_WHITELIST
+    pm_peer_id_t peers[BLE_GAP_WHITELIST_ADDR_MAX_COUNT];
+    uint32_t     count = 0;
+    pm_peer_id_t peer  = pm_next_peer_id_get(PM_PEER_ID_INVALID);
+
+    if (m_last_peer != PM_PEER_ID_INVALID)
+    {
+        peers[count++] = m_last_peer;
+    }
+    while ((peer != PM_PEER_ID_INVALID) && (count < ARRAY_SIZE(peers)))
+    {
+        if (peer != m_last_peer)
+        {
+            peers[count++] = peer;
+        }
+        peer = pm_next_peer_id_get(peer);
+    }
+
+    // With S130 only cached here; ble_advertising asks for it when it starts.
+    UNUSED_RETURN_VALUE(pm_whitelist_set(peers, count));
+#endif
+}
+
+
+/**@brief Remember the peer of a bonded link, also across resets through its rank. */
+static void last_peer_set(pm_peer_id_t peer_id)
+{
+    if (peer_id == PM_PEER_ID_INVALID)
+    {
+        return;
+    }
+    m_last_peer = peer_id;
+    // NRF_ERROR_BUSY while FDS writes: the rank only picks the peer after a reset.
+    UNUSED_RETURN_VALUE(pm_peer_rank_highest(peer_id));
+}
+
+
+static void pm_evt_handler(pm_evt_t const * p_evt)
+{
+    ret_code_t err_code;
+
+    switch (p_evt->evt_id)
+    {
+        case PM_EVT_BONDED_PEER_CONNECTED:
+            last_peer_set(p_evt->peer_id);
+            break;
+
+        case PM_EVT_CONN_SEC_SUCCEEDED:
+            last_peer_set(p_evt->peer_id);
+            if (p_evt->params.conn_sec_succeeded.procedure == PM_LINK_SECURED_PROCEDURE_BONDING)
+            {
+                whitelist_refresh();
+            }
+            break;
+
+        case PM_EVT_CONN_SEC_CONFIG_REQ:
+        {
+            // A phone that lost its keys, after a reinstall of the app, may bond anew.
+            pm_conn_sec_config_t conn_sec_config = {.allow_repairing = true};
+            pm_conn_sec_config_reply(p_evt->conn_handle, &conn_sec_config);
+        } break;
+
+        case PM_EVT_STORAGE_FULL:
+            err_code = fds_gc();
+            if ((err_code != FDS_ERR_BUSY) && (err_code != FDS_ERR_NO_SPACE_IN_QUEUES))
+            {
+                APP_ERROR_CHECK(err_code);
+            }
+            break;
+
+        case PM_EVT_LOCAL_DB_CACHE_APPLY_FAILED:
+            // The GATT table has changed since the phone bonded.
+            pm_local_database_has_changed();
+            break;
+
+        case PM_EVT_PEER_DELETE_SUCCEEDED:
+            if (p_evt->peer_id == m_last_peer)
+            {
+                m_last_peer = PM_PEER_ID_INVALID;
+            }
+            whitelist_refresh();
+            break;
+
+        case PM_EVT_PEER_DATA_UPDATE_FAILED:
+            APP_ERROR_CHECK(p_evt->params.peer_data_update_failed.error);
+            break;
+
+        case PM_EVT_PEER_DELETE_FAILED:
+            APP_ERROR_CHECK(p_evt->params.peer_delete_failed.error);
+            break;
+
+        case PM_EVT_PEERS_DELETE_FAILED:
+            APP_ERROR_CHECK(p_evt->params.peers_delete_failed_evt.error);
+            break;
+
+        case PM_EVT_ERROR_UNEXPECTED:
+            APP_ERROR_CHECK(p_evt->params.error_unexpected.error);
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+ret_code_t peer_bond_init(void)
+{
+    ble_gap_sec_params_t sec_param;
+    ret_code_t           err_code;
+
+    err_code = pm_init();
+    VERIFY_SUCCESS(err_code);
+
+    memset(&sec_param, 0, sizeof(sec_param));
+
+    sec_param.bond           = 1;
+    sec_param.mitm           = 0;
+    sec_param.io_caps        = BLE_GAP_IO_CAPS_NONE;
+#if NRF_MODULE_ENABLED(NFC_PAIR)
+    // OOB only when the phone has the TK of the emulated tag as well; otherwise Just Works.
+    sec_param.oob            = 1;
+#else
+    sec_param.oob            = 0;
+#endif
+    sec_param.min_key_size   = SEC_PARAM_MIN_KEY_SIZE;
+    sec_param.max_key_size   = SEC_PARAM_MAX_KEY_SIZE;
+    sec_param.kdist_own.enc  = 1;
+    sec_param.kdist_own.id   = 1;
+    sec_param.kdist_peer.enc = 1;
+    sec_param.kdist_peer.id  = 1;
+
+    err_code = pm_sec_params_set(&sec_param);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = pm_register(pm_evt_handler);
+    VERIFY_SUCCESS(err_code);
+
+    if (pm_peer_ranks_get(&m_last_peer, NULL, NULL, NULL) != NRF_SUCCESS)
+    {
+        m_last_peer = PM_PEER_ID_INVALID;
+    }
+    whitelist_refresh();
+
+    return NRF_SUCCESS;
+}
+
+
+void peer_bond_adv_config(ble_adv_modes_config_t * p_config)
+{
+    p_config->ble_adv_directed_enabled  = true;
+    p_config->ble_adv_whitelist_enabled = (PEER_BOND_WHITELIST != 0);
+}
+
+
+void peer_bond_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    ble_conn_state_on_ble_evt(p_ble_evt);
+    pm_on_ble_evt(p_ble_evt);
+
+#if PEER_BOND_SEC_REQUEST
+    if (p_ble_evt->header.evt_id == BLE_GAP_EVT_CONNECTED)
+    {
+        // Busy when the phone has started encryption itself.
+        UNUSED_RETURN_VALUE(pm_conn_secure(p_ble_evt->evt.gap_evt.conn_handle, false));
+    }
+#endif
+}
+
+
+void peer_bond_on_adv_evt(ble_adv_evt_t ble_adv_evt)
+{
+    switch (ble_adv_evt)
+    {
+        case BLE_ADV_EVT_PEER_ADDR_REQUEST:
+        {
+            pm_peer_data_bonding_t bonding;
+
+            // Without an answer ble_advertising goes on with the fast stage.
+            if ((m_last_peer != PM_PEER_ID_INVALID) &&
+                (pm_peer_data_bonding_load(m_last_peer, &bonding) == NRF_SUCCESS))
+            {
+                UNUSED_RETURN_VALUE(ble_advertising_peer_addr_reply(&bonding.peer_ble_id.id_addr_info));
+            }
+        } break;
+
+        case BLE_ADV_EVT_WHITELIST_REQUEST:
+        {
+            ble_gap_addr_t addrs[BLE_GAP_WHITELIST_ADDR_MAX_COUNT];
+            // Sized as the SDK examples do: S132 has no IRK count of its own, it is 8 on both.
+            ble_gap_irk_t  irks[BLE_GAP_WHITELIST_ADDR_MAX_COUNT];
+            uint32_t       addr_count = ARRAY_SIZE(addrs);
+            uint32_t       irk_count  = ARRAY_SIZE(irks);
+
+            if (pm_whitelist_get(addrs, &addr_count, irks, &irk_count) != NRF_SUCCESS)
+            {
+                addr_count = 0;
+                irk_count  = 0;
+            }
+            UNUSED_RETURN_VALUE(ble_advertising_whitelist_reply(addrs, addr_count, irks, irk_count));
+        } break;
+
+        default:
+            break;
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(PEER_BOND)
@@ -0,0 +1,35 @@
+#ifndef __PEER_BOND_H__
+#define __PEER_BOND_H__
+
+#include "sdk_errors.h"
+#include "ble.h"
+#include "ble_advertising.h"
+
+/* Bonding through the Peer Manager, Just Works without MITM:
+ *
+ *   connect     the lock asks the phone to secure the link (PEER_BOND_SEC_REQUEST); a bonded
+ *               phone encrypts with its stored LTK, a new one pairs and bonds
+ *   reconnect   the CCCDs the phone enabled are restored from flash, so notifications flow
+ *               without it writing them again
+ *   disconnect  directed advertising to the phone of the last bonded link, for the 1.28 s
+ *               of high duty, before the fast stage
+ *
+ * With PEER_BOND_WHITELIST, the fast and slow stages only take bonded phones once there are
+ * any; a new phone then needs ble_advertising_restart_without_whitelist(). Bonds live in FDS,
+ * next to the other records. */
+
+/**@brief Start the Peer Manager. Call after ble_stack_init(), before advertising starts. */
+ret_code_t peer_bond_init(void);
+
+/**@brief Enable directed advertising and the whitelist in the advertising modes. */
+void peer_bond_adv_config(ble_adv_modes_config_t * p_config);
+
+/**@brief Handle a BLE event. Call first in the BLE event dispatch. */
+void peer_bond_on_ble_evt(ble_evt_t * p_ble_evt);
+
+/**@brief Answer the whitelist and peer address requests of ble_advertising. Call from the
+ *        advertising event handler.
+ */
+void peer_bond_on_adv_evt(ble_adv_evt_t ble_adv_evt);
+
+#endif
@@ -4,6 +4,57 @@
 #include "nrf_delay.h"
 #include "sdk_config.h"
 #include "lock_gpio.h"
+#include "pn532_async.h"
+#include "pn532_scan.h"
+#include "pn532_duty.h"
+#include "pn532_reader.h"
+#include "pn532_sim.h"
+#include "mfc_keys.h"
+#include "fds.h"
+#include "frame_pool.h"
+#include "pn532_isodep.h"
+#include "pn532_presence.h"
+#include "pn532_profile.h"
+#include "pn532_t4t.h"
+#include "hid_wedge.h"
+#include "pn532_tune.h"
+#include "pn532_diag.h"
+#include "pn532_hce.h"
+#include "pn532_snep.h"
+#include "pn532_ndef.h"
+#include "ntag_auth.h"
+#include "uid_filter.h"
+#include "lock_acl.h"
+#include "lock_acl_mph.h"
+#include "acl_sched.h"
+#include "lock_moto.h"
+#include "lock_state.h"
+#include "lock_journal.h"
+#include "sd_log.h"
+#include "app_rtos.h"
+#include "flash_io.h"
+#include "nus_tx.h"
+#include "nus_cmd.h"
+#include "lat_trace.h"
+#include "nus_pb.h"
+#include "conn_policy.h"
+#include "tap_beacon.h"
+#include "reader_tlm.h"
+#include "passback.h"
+#include "cmd_reg.h"
+#include "energy.h"
+#include "card_cache.h"
+#include "card_script.h"
+#include "host_spis.h"
+#include "pn532_deadline.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "adv_sched.h"
+#include "app_error.h"
+#include "wdt_sup.h"
+#include "keep_ram.h"
+#include "load_gen.h"
+#include <string.h>
 //#include "adafruit_pn532.h"
 
 
@@ -11,27 +62,154 @@
 
 uint8_t i2c_device_address;
 uint8_t success;
-uint8_t uid[] = { 0, 0, 0, 0, 0, 0, 0 };  // Buffer to store the returned UID
+uint8_t uid[PN532_UID_MAX_LEN] = {0};  // Buffer to store the returned UID
 uint8_t keya[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
 uint8_t uidLength; 
 uint8_t ab[18] = {0};
+static pn532_target_t m_target;   // card of the current command
 
 
 extern  ble_nus_t m_nus;
 
+#if NRF_MODULE_ENABLED(PN532_PRESENCE)
+static void card_presence_handler(pn532_presence_evt_t const * p_evt)
+{
+		if (p_evt->type == PN532_PRESENCE_EVT_REMOVED)
+		{
+				printf("card removed\r\n");
+#if NRF_MODULE_ENABLED(CARD_CACHE)
+				card_cache_clear();
+#endif
+		}
+}
+#endif
+
+#if NRF_MODULE_ENABLED(WDT_SUP)
+/* The RF wait tripped and gave up; the chip may still be busy with the command. */
+static void pn532_recover(void)
+{
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+		if (pn532_cmd_busy())
+		{
+				// The engine's own timeout ends that command.
+				return;
+		}
+#endif
+		if (!pn532_soft_reset())
+		{
+				printf("pn532 soft reset failed\r\n");
+		}
+}
+
+
+/* Whether the reset that started this boot already was the reader missing. */
+static bool pn532_missing_before(void)
+{
+		wdt_sup_crash_t crash;
+
+		return wdt_sup_crash_get(&crash) && (crash.part == WDT_SUP_RF) &&
+		       (crash.reason == WDT_SUP_REASON_FAIL);
+}
+#endif
+
+#if NRF_MODULE_ENABLED(MFC_KDF)
+#if !defined(MFC_KDF_MASTER_KEY) || !defined(MFC_KDF_SYSTEM_ID) || !defined(MFC_KDF_KEY_TYPE)
+#error "Define MFC_KDF_MASTER_KEY, MFC_KDF_SYSTEM_ID and MFC_KDF_KEY_TYPE, the key diversification of the site"
+#endif
+
+static uint8_t const    m_kdf_key[16]  = MFC_KDF_MASTER_KEY;
+static uint8_t const    m_kdf_sys_id[] = MFC_KDF_SYSTEM_ID;
+static mfc_kdf_master_t m_kdf_master;
+#endif
+
+#if NRF_MODULE_ENABLED(LOCK_ACL_ENROLL)
+APP_TIMER_DEF(m_enroll_timer);
+static void enroll_timer_handler(void * p_context);
+#endif
+
 void device_pn532_init() // ʼpn532
 {
 
 
 
-			init_pnc523_i2c();
+#if NRF_MODULE_ENABLED(WDT_SUP)
+			wdt_sup_recover_set(WDT_SUP_RF, pn532_recover);
+#endif
+			APP_ERROR_CHECK(pn532_bus_init());
       pn532_gpio_init();
+#if NRF_MODULE_ENABLED(PN532_SIM)
+      // No PN532 on the bus: the emulator stands in for the bus backend.
+      APP_ERROR_CHECK(pn532_simulator_init());
+#endif
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+      APP_ERROR_CHECK(pn532_async_init());
+#endif
+#if NRF_MODULE_ENABLED(PN532_READER)
+      APP_ERROR_CHECK(pn532_reader_init());
+#endif
+#if NRF_MODULE_ENABLED(MFC_KEYS)
+      APP_ERROR_CHECK(mfc_keys_init());
+#endif
+#if NRF_MODULE_ENABLED(MFC_KDF)
+      // The SoftDevice is up and runs the ECB: the master state is computed here, once.
+      APP_ERROR_CHECK(mfc_kdf_master_init(&m_kdf_master, m_kdf_key, m_kdf_sys_id, sizeof(m_kdf_sys_id)));
+      mfc_keys_kdf_set(&m_kdf_master, MFC_KDF_KEY_TYPE);
+#endif
+#if NRF_MODULE_ENABLED(NTAG_AUTH) && NRF_MODULE_ENABLED(MFC_KDF)
+      ntag_auth_init(&m_kdf_master);
+#endif
+#if NRF_MODULE_ENABLED(PN532_TUNE)
+      APP_ERROR_CHECK(pn532_tune_init());
+#endif
+#if NRF_MODULE_ENABLED(PN532_DEADLINE)
+      pn532_deadline_init();
+#endif
+#if NRF_MODULE_ENABLED(PN532_PRESENCE)
+      pn532_presence_init(card_presence_handler);
+#endif
+#if NRF_MODULE_ENABLED(UID_FILTER)
+      uid_filter_init();
+#endif
+#if NRF_MODULE_ENABLED(PN532_PROFILE)
+      pn532_profile_init();
+#endif
+#if NRF_MODULE_ENABLED(PN532_T4T)
+      pn532_t4t_init();
+#endif
+#if NRF_MODULE_ENABLED(PN532_DUTY)
+      APP_ERROR_CHECK(pn532_duty_init());
+#endif
+#if NRF_MODULE_ENABLED(LOCK_ACL_ENROLL)
+      APP_ERROR_CHECK(app_timer_create(&m_enroll_timer, APP_TIMER_MODE_SINGLE_SHOT, enroll_timer_handler));
+#endif
+#if NRF_MODULE_ENABLED(PN532_DIAG)
+      APP_ERROR_CHECK(pn532_diag_init());
+#endif
+#if !NRF_MODULE_ENABLED(BOOT_SEQ)
 	//	begin();
 			nrf_delay_ms(100);
+			UNUSED_RETURN_VALUE(device_pn532_probe());
+#endif
+}
+
+/* The firmware version: whether the PN532 is there. Not before it had its boot time after power-up;
+   boot_seq runs this as a stage of its own, BOOT_SEQ_PN532_BOOT_MS after device_pn532_init(). */
+bool device_pn532_probe(void)
+{
 			uint32_t versiondata = getFirmwareVersion();
+			if (!versiondata && pn532_soft_reset()) {
+					versiondata = getFirmwareVersion();
+			}
 			if (! versiondata) {
-					printf("Didn't find PN53x board");	
-					while(1); 			
+					printf("Didn't find PN53x board\r\n");
+#if NRF_MODULE_ENABLED(WDT_SUP)
+					// One reset for a bus or chip stuck since power up; after that the lock goes
+					// on without the reader, it still opens from the phone.
+					if (!pn532_missing_before()) {
+							wdt_sup_fail(WDT_SUP_RF);
+					}
+#endif
+					return false;
 			}
 			printf("---->i2c pn532 ok\r\n");
 			printf("---->Found chip PN5%02x\r\n",((versiondata>>24)&0xff)); 
@@ -39,21 +217,616 @@ void device_pn532_init() // 
 			printf(".%d\r\n",((versiondata>>8)&0xff));
 
 			printf("---->pn532 config ok\r\n");
+#if NRF_MODULE_ENABLED(PN532_DIAG)
+			// A first run, so the TLM frame has flags from the start.
+			UNUSED_RETURN_VALUE(pn532_diag_run());
+			if (pn532_diag_flags() != 0) {
+					printf("---->pn532 self test flags 0x%02x\r\n", pn532_diag_flags());
+			}
+			APP_ERROR_CHECK(pn532_diag_start());
+#endif
+#if NRF_MODULE_ENABLED(PN532_SIM)
+			pn532_sim_bench();
+#endif
 			printf("---->Waiting for an ISO14443A Card ...\r\n");
-			
+			return true;
+}
+
+
+
+/* Blocks collected before a NUS burst without the TX queue; a Classic 1K sector has 3 data
+   blocks. With the queue, see card_batch_size(). */
+#define CARD_BATCH_BLOCKS 12
+
+typedef struct
+{
+		uint8_t   data[CARD_BATCH_BLOCKS * 16];
+		uint16_t  len;
+		uint8_t * write_data;
+		bool      fill;        // blocks read from the card, for the cache
+} card_batch_t;
+
+static card_batch_t m_batch;
+
+#if NRF_MODULE_ENABLED(HOST_SPIS)
+/* Replies to a command of the SPI host go back to it, in replies of up to HOST_SPIS_REPLY_MAX
+   bytes, instead of to BLE. */
+static bool host_reply(uint8_t const * p_data, uint16_t len)
+{
+		if (!host_spis_active())
+		{
+				return false;
+		}
+		while (len > 0)
+		{
+				uint16_t chunk = MIN(len, HOST_SPIS_REPLY_MAX);
+
+				if (host_spis_reply(p_data, chunk) != NRF_SUCCESS)
+				{
+						break;
+				}
+				p_data += chunk;
+				len    -= chunk;
+		}
+		return true;
+}
+#else
+#define host_reply(p_data, len) false
+#endif
+
+#if NRF_MODULE_ENABLED(NUS_TX)
+/* Card data is a byte stream for the phone, so blocks are packed into
+   full notifications by the TX queue. */
+static void nus_send_buffer(uint8_t * p_data, uint16_t len)
+{
+		if (host_reply(p_data, len))
+		{
+				return;
+		}
+#if NRF_MODULE_ENABLED(NUS_CMD)
+		if (nus_cmd_active())
+		{
+				UNUSED_RETURN_VALUE(nus_cmd_data(p_data, len));
+				return;
+		}
+#endif
+		UNUSED_RETURN_VALUE(nus_tx_stream(p_data, len));
+}
+
+/* A UID or scan report, in a notification of its own; admin links get a copy. */
+static void nus_send_message(uint8_t * p_data, uint16_t len)
+{
+		if (host_reply(p_data, len))
+		{
+				return;
+		}
+#if NRF_MODULE_ENABLED(NUS_CMD)
+		if (nus_cmd_active())
+		{
+				UNUSED_RETURN_VALUE(nus_cmd_data(p_data, len));
+				UNUSED_RETURN_VALUE(nus_tx_put(BLE_CONN_HANDLE_INVALID, p_data, len, NUS_TX_ADMINS));
+				return;
+		}
+#endif
+		UNUSED_RETURN_VALUE(nus_tx_result(p_data, len));
+}
+
+/* The TX queue is the buffer between the card and BLE: the SoftDevice interrupt drains it
+   while the next blocks are read, so data goes in as soon as it fills a unit. The phone
+   has the first block while the second is read and little trails the last read; a full
+   queue holds the reads until BLE catches up (LAT_STAGE_TX_WAIT). */
+#if NRF_MODULE_ENABLED(NUS_CMD)
+STATIC_ASSERT(NUS_CMD_DATA_MAX <= CARD_BATCH_BLOCKS * 16);
+#endif
+static uint16_t card_batch_size(void)
+{
+#if NRF_MODULE_ENABLED(NUS_CMD)
+		if (nus_cmd_active())
+		{
+				// Whole response frames.
+				return NUS_CMD_DATA_MAX;
+		}
+#endif
+		// The queue packs the stream into notifications itself.
+		return 16;
+}
+#else
+/* Send a buffer as back-to-back NUS notifications, retrying while the
+   SoftDevice TX buffers are full. */
+static void nus_send_buffer(uint8_t * p_data, uint16_t len)
+{
+		uint16_t offset = 0;
+		uint8_t  retries = 0;
+
+		if (host_reply(p_data, len))
+		{
+				return;
+		}
+		while (offset < len)
+		{
+				uint16_t chunk = len - offset;
+				uint16_t max   = ble_nus_data_len_get(&m_nus, m_nus.conn_handle);
+				if (chunk > max)
+				{
+						chunk = max;
+				}
+
+				uint32_t err_code = ble_nus_string_send(&m_nus, &p_data[offset], chunk);
+				if ((err_code == BLE_ERROR_NO_TX_PACKETS) && (retries++ < 50))
+				{
+						nrf_delay_ms(2);
+						continue;
+				}
+				if (err_code != NRF_SUCCESS)
+				{
+						return;
+				}
+				offset += chunk;
+				retries = 0;
+		}
+}
+
+static void nus_send_message(uint8_t * p_data, uint16_t len)
+{
+		if (host_reply(p_data, len))
+		{
+				return;
+		}
+		UNUSED_RETURN_VALUE(ble_nus_string_send(&m_nus, p_data, len));
+}
+
+#define card_batch_size() sizeof(m_batch.data)
+#endif
+
+static void card_batch_handler(uint8_t block, uint8_t * data, void * context)
+{
+		card_batch_t * p_batch = (card_batch_t *)context;
+
+#if NRF_MODULE_ENABLED(CARD_CACHE)
+		if (p_batch->fill)
+		{
+				card_cache_put(block, data);
+		}
+#endif
+#if NRF_MODULE_ENABLED(NUS_PB)
+		// A record per block, encoded into the notifications; the TX queue does the packing.
+		UNUSED_VARIABLE(p_batch);
+		UNUSED_RETURN_VALUE(nus_pb_block(block, data));
+		return;
+#endif
+		memcpy(&p_batch->data[p_batch->len], data, 16);
+		p_batch->len += 16;
+		if (p_batch->len >= card_batch_size())
+		{
+				nus_send_buffer(p_batch->data, p_batch->len);
+				p_batch->len = 0;
+		}
+}
+
+/* Every block of a write command gets the same 16 bytes. */
+static uint8_t const * card_write_source(uint8_t block, void * context)
+{
+		UNUSED_PARAMETER(block);
+		return ((card_batch_t *)context)->write_data;
+}
+
+#if NRF_MODULE_ENABLED(MFC_KEYS)
+#define card_auth       mfc_keys_authenticate
+#define card_auth_write mfc_keys_authenticate_write
+#else
+/* Without the key store every sector is tried with key A = keya only. */
+static uint8_t card_auth(uint8_t * p_uid, uint8_t len, uint32_t block, void * context)
+{
+		return mifareclassic_AuthenticateBlock(p_uid, len, block, 0, keya);
+}
+#define card_auth_write card_auth
+#endif
+
+/* Read block_num .. block_num + excursion_num with one authentication per
+   sector and report the data blocks in batches. With write_data set the
+   blocks that differ are overwritten and read back, and the old contents
+   are reported. Returns the number of blocks reported. */
+static uint8_t card_read_range(uint8_t block_num, uint8_t excursion_num, uint8_t * write_data)
+{
+		uint16_t last = (uint16_t)block_num + excursion_num;
+		uint8_t  count;
+
+		if (last > 0xFF)
+		{
+				last = 0xFF;
+		}
+
+		m_batch.len        = 0;
+		m_batch.write_data = write_data;
+		m_batch.fill       = (write_data == NULL);
+		LAT_TRACE_START(t_dump);
+#if NRF_MODULE_ENABLED(FDS)
+		// A page erase stalls the CPU for ms, keep gc off the card transaction.
+		UNUSED_RETURN_VALUE(fds_gc_hold(true));
+#endif
+		if (write_data != NULL)
+		{
+				count = mifareclassic_WriteRange(uid, uidLength, block_num, (uint8_t)last, card_auth_write,
+				                                 card_write_source, card_batch_handler, &m_batch);
+		}
+		else
+		{
+				count = mifareclassic_ReadRange(uid, uidLength, block_num, (uint8_t)last, card_auth,
+				                                card_batch_handler, &m_batch);
+		}
+#if NRF_MODULE_ENABLED(FDS)
+		UNUSED_RETURN_VALUE(fds_gc_hold(false));
+#endif
+		if (m_batch.len != 0)
+		{
+				LAT_TRACE_START(t);
+				nus_send_buffer(m_batch.data, m_batch.len);
+				LAT_TRACE_STOP(LAT_STAGE_NOTIFY, t);
+		}
+		LAT_TRACE_STOP(LAT_STAGE_DUMP, t_dump);
+#if NRF_MODULE_ENABLED(MFC_KEYS)
+		mfc_keys_flush();
+#endif
+		return count;
+}
+
+/* Find the card for a command. A card still in the field from the previous
+   command is reselected without a new anticollision. */
+static uint8_t card_select(void)
+{
+		LAT_TRACE_START(t);
+
+#if NRF_MODULE_ENABLED(PN532_PRESENCE)
+		if (pn532_presence_select(&m_target, 1000) != NRF_SUCCESS)
+		{
+				return 0;
+		}
+#else
+		// The target table keeps SENS_RES and SEL_RES for the card type.
+		if (readPassiveTargets(PN532_MIFARE_ISO14443A, &m_target, 1, 1000) == 0)
+		{
+				return 0;
+		}
+#endif
+		LAT_TRACE_STOP(LAT_STAGE_SELECT, t);
+#if NRF_MODULE_ENABLED(PN532_ISODEP)
+		// Only a card activated by this poll takes the PPS; a tracked one keeps its rate.
+		if (m_target.ats_len > 0)
+		{
+				UNUSED_RETURN_VALUE(pn532_isodep_bitrate_raise(&m_target));
+		}
+#endif
+		memcpy(uid, m_target.uid, MIN(m_target.uid_len, sizeof(uid)));
+		uidLength = MIN(m_target.uid_len, sizeof(uid));
+#if NRF_MODULE_ENABLED(CARD_CACHE)
+		card_cache_session(uid, uidLength);
+#endif
+		return 1;
+}
+
+/* Card type of the selected card. Without the classifier the SAK is the
+   hint, not the UID length: Classic EV1 cards have 7 byte UIDs too. */
+static pn532_profile_t card_profile(void)
+{
+#if NRF_MODULE_ENABLED(PN532_PROFILE)
+		return pn532_profile_get(&m_target);
+#else
+		switch (m_target.sel_res)
+		{
+				case 0x08: return PN532_PROFILE_MIFARE_1K;
+				case 0x18: return PN532_PROFILE_MIFARE_4K;
+				case 0x00: return PN532_PROFILE_ULTRALIGHT;
+				default:   return PN532_PROFILE_UNKNOWN;
+		}
+#endif
+}
+
+static bool card_is_new(uint8_t const * p_uid, uint8_t len)
+{
+#if NRF_MODULE_ENABLED(UID_FILTER)
+		return (uid_filter_check(p_uid, len) == UID_FILTER_NEW);
+#else
+		UNUSED_PARAMETER(p_uid);
+		UNUSED_PARAMETER(len);
+		return true;
+#endif
+}
+
+#if NRF_MODULE_ENABLED(LOCK_ACL) || NRF_MODULE_ENABLED(LOCK_ACL_MPH)
+/* The internal flash table first, it answers without the MX25L16. A card on
+   either list is granted; one of the internal table only within the hours of its
+   schedule group. */
+static lock_acl_result_t acl_lookup(uint8_t const * p_uid, uint8_t len)
+{
+		lock_acl_result_t result = LOCK_ACL_NO_LIST;
+
+#if NRF_MODULE_ENABLED(LOCK_ACL_MPH)
+		uint8_t group = 0;
+
+		result = lock_acl_mph_check(p_uid, len, &group);
+		if (result == LOCK_ACL_GRANTED)
+		{
+#if NRF_MODULE_ENABLED(ACL_SCHED)
+				if (!acl_sched_allowed(group))
+				{
+						return LOCK_ACL_OFF_SCHEDULE;
+				}
+#endif
+				return result;
+		}
+#endif
+#if NRF_MODULE_ENABLED(LOCK_ACL)
+		{
+				lock_acl_result_t mx25 = lock_acl_check(p_uid, len);
+
+				if (mx25 != LOCK_ACL_NO_LIST)
+				{
+						result = mx25;
+				}
+		}
+#endif
+		return result;
+}
+#endif
+
+/* What a tap leaves behind once the lock has acted on it. */
+typedef struct
+{
+		uint8_t event;
+		uint8_t len;
+		uint8_t uid[PN532_UID_MAX_LEN];
+} tap_record_t;
+
+/* The journal entry, the tap beacon and a faster advertising burst: flash and
+   SoftDevice calls that have no place between the UID and the motor. */
+static void tap_record(tap_record_t const * p_rec)
+{
+#if NRF_MODULE_ENABLED(APP_RTOS) && NRF_MODULE_ENABLED(LOCK_JOURNAL)
+		// The storage task writes it after this tap is done.
+		UNUSED_RETURN_VALUE(app_rtos_journal_put(p_rec->event, p_rec->uid, MIN(p_rec->len, LOCK_JOURNAL_DATA_LEN)));
+#else
+#if NRF_MODULE_ENABLED(LOCK_JOURNAL)
+		UNUSED_RETURN_VALUE(lock_journal_append(p_rec->event, p_rec->uid, MIN(p_rec->len, LOCK_JOURNAL_DATA_LEN)));
+#endif
+#if NRF_MODULE_ENABLED(SD_LOG)
+		sd_log_kick();
+#endif
+#endif
+#if NRF_MODULE_ENABLED(TAP_BEACON)
+		tap_beacon_add(p_rec->event, p_rec->uid, p_rec->len);
+#endif
+#if NRF_MODULE_ENABLED(PASSBACK)
+		// After the tap beacon: the frame goes on the air in place of its data.
+		if (p_rec->event == LOCK_JOURNAL_EVT_GRANTED)
+		{
+				passback_record(p_rec->uid, p_rec->len);
+		}
+#endif
+#if NRF_MODULE_ENABLED(ADV_SCHED)
+		// A phone that comes with the tap finds the lock at once.
+		adv_sched_kick();
+#endif
+		UNUSED_PARAMETER(p_rec);
+}
+
+static void tap_record_handler(void * p_event_data, uint16_t event_size)
+{
+		UNUSED_PARAMETER(event_size);
+		tap_record(p_event_data);
 }
 
+/* Decide on a card against the local whitelist. Without a list the phone decides
+   from the UID it is sent, and the tap is only acknowledged. Returns true if the
+   lock opened.
+   Nothing between the UID and the motor waits for BLE or flash: the lookup, the
+   schedule, the motor start and the feedback pattern are all that runs before
+   the lock acts (LAT_STAGE_DECIDE). The record of the tap goes to the main loop,
+   behind the notification the caller queues. */
+static bool card_access(uint8_t const * p_uid, uint8_t len)
+{
+		uint8_t      event = LOCK_JOURNAL_EVT_TAP;
+		tap_record_t rec;
+#if NRF_MODULE_ENABLED(READER_TLM)
+		uint32_t start = app_timer_cnt_get();
+#endif
+
+		LAT_TRACE_START(t);
 
+#if NRF_MODULE_ENABLED(LOCK_ACL) || NRF_MODULE_ENABLED(LOCK_ACL_MPH)
+		switch (acl_lookup(p_uid, len))
+		{
+				case LOCK_ACL_GRANTED:
+#if NRF_MODULE_ENABLED(PASSBACK)
+						// A RAM lookup: the other readers' frames were taken in the main loop.
+						if (!passback_check(p_uid, len))
+						{
+								lock_feedback_play(LOCK_FB_DENIED);
+								event = LOCK_JOURNAL_EVT_PASSBACK;
+								break;
+						}
+#endif
+#if NRF_MODULE_ENABLED(LOCK_STATE)
+						UNUSED_RETURN_VALUE(lock_state_unlock());
+#elif NRF_MODULE_ENABLED(LOCK_MOTO)
+						UNUSED_RETURN_VALUE(lock_moto_unlock());
+#endif
+						lock_feedback_play(LOCK_FB_SUCCESS);
+						event = LOCK_JOURNAL_EVT_GRANTED;
+						break;
+
+				case LOCK_ACL_DENIED:
+						lock_feedback_play(LOCK_FB_DENIED);
+						event = LOCK_JOURNAL_EVT_DENIED;
+						break;
+
+				case LOCK_ACL_OFF_SCHEDULE:
+						lock_feedback_play(LOCK_FB_DENIED);
+						event = LOCK_JOURNAL_EVT_SCHEDULE;
+						break;
+
+				default:
+						lock_feedback_play(LOCK_FB_SUCCESS);
+						break;
+		}
+#else
+		lock_feedback_play(LOCK_FB_SUCCESS);
+#endif
+		LAT_TRACE_STOP(LAT_STAGE_DECIDE, t);
+		load_gen_decided(p_uid, len);
+#if NRF_MODULE_ENABLED(ENERGY)
+		// What the lock does for this tap from here on is charged to it.
+		energy_tap();
+#endif
+
+		rec.event = event;
+		rec.len   = MIN(len, sizeof(rec.uid));
+		memcpy(rec.uid, p_uid, rec.len);
+		if (app_sched_event_put(&rec, sizeof(rec), tap_record_handler) != NRF_SUCCESS)
+		{
+				tap_record(&rec);
+		}
+#if NRF_MODULE_ENABLED(READER_TLM)
+		reader_tlm_tap(start);
+#endif
+		keep_ram_count(KEEP_RAM_CNT_TAPS);
+		if ((event != LOCK_JOURNAL_EVT_GRANTED) && (event != LOCK_JOURNAL_EVT_TAP))
+		{
+				keep_ram_count(KEEP_RAM_CNT_DENIED);
+		}
+		return (event == LOCK_JOURNAL_EVT_GRANTED);
+}
+
+#if NRF_MODULE_ENABLED(HID_WEDGE)
+#if HID_WEDGE_NDEF_TEXT && NRF_MODULE_ENABLED(PN532_NDEF)
+static void wedge_ndef_handler(pn532_ndef_evt_t const * p_evt, void * p_context)
+{
+		bool * p_typed = (bool *)p_context;
+
+		if (!*p_typed && (p_evt->type == PN532_NDEF_REC_TEXT) && (p_evt->rec.text.utf == UTF_8))
+		{
+				*p_typed = (hid_wedge_type_text(p_evt->rec.text.p_data, p_evt->rec.text.data_len) == NRF_SUCCESS);
+		}
+}
+#endif
+
+/* Type the card on the keyboard of a bonded host: the first Text record of a
+   Type 2 Tag with HID_WEDGE_NDEF_TEXT, the UID otherwise. */
+static void wedge_type(void)
+{
+		bool typed = false;
+
+		if (!hid_wedge_is_ready())
+		{
+				return;
+		}
+#if HID_WEDGE_NDEF_TEXT && NRF_MODULE_ENABLED(PN532_NDEF)
+		if (m_target.sel_res == 0x00)
+		{
+				UNUSED_RETURN_VALUE(pn532_ndef_read(wedge_ndef_handler, &typed));
+		}
+#endif
+		if (!typed)
+		{
+				UNUSED_RETURN_VALUE(hid_wedge_type_uid(uid, uidLength));
+		}
+}
+#endif
+
+/* Beep and send the UID once per tap. A card left on the reader is only
+   reported again after it has been away for UID_FILTER_HOLDOFF_MS. */
+static void card_uid_report(void)
+{
+		if (!card_is_new(uid, uidLength))
+		{
+				return;
+		}
+		card_access(uid, uidLength);
+
+		LAT_TRACE_START(t);
+#if NRF_MODULE_ENABLED(NUS_PB)
+		UNUSED_RETURN_VALUE(nus_pb_card_a(uid, uidLength, m_target.sens_res, m_target.sel_res));
+#else
+		nus_send_message(uid, uidLength);
+#endif
+		LAT_TRACE_STOP(LAT_STAGE_NOTIFY, t);
+#if NRF_MODULE_ENABLED(HID_WEDGE)
+		wedge_type();
+#endif
+}
+
+/* End the answer to a card command, so the phone knows no more blocks follow. */
+static void card_result_report(ret_code_t result)
+{
+#if NRF_MODULE_ENABLED(READER_TLM)
+		// No card is no operation; a card type without support is no RF error.
+		if (result != NRF_ERROR_NOT_FOUND)
+		{
+				reader_tlm_card_op((result == NRF_SUCCESS) || (result == NRF_ERROR_NOT_SUPPORTED));
+		}
+#endif
+#if NRF_MODULE_ENABLED(NUS_PB)
+		UNUSED_RETURN_VALUE(nus_pb_error(result));
+#else
+		UNUSED_PARAMETER(result);
+#endif
+}
+
+#if NRF_MODULE_ENABLED(CARD_CACHE)
+/* A range read already in this tap session, from RAM: no anticollision, no
+   authentication and no RF read. The UID is reported as for a card found.
+   Returns false if the card has to be asked. */
+static bool card_cache_replay(uint8_t block_num, uint8_t excursion_num)
+{
+		uint16_t last = MIN((uint16_t)block_num + excursion_num, 0xFF);
+
+		if (!card_cache_range_has(block_num, (uint8_t)last) || !card_cache_uid_get(uid, &uidLength))
+		{
+				return false;
+		}
+		card_uid_report();
+
+		m_batch.len        = 0;
+		m_batch.write_data = NULL;
+		m_batch.fill       = false;
+		for (uint16_t block = block_num; block <= last; block++)
+		{
+				if (!mifareclassic_IsTrailerBlock(block))
+				{
+						card_batch_handler((uint8_t)block, (uint8_t *)card_cache_get((uint8_t)block), &m_batch);
+				}
+		}
+		if (m_batch.len != 0)
+		{
+				nus_send_buffer(m_batch.data, m_batch.len);
+		}
+		return true;
+}
+#endif
 
 	
 void read_data_card(uint8_t block_num, uint8_t excursion_num, uint8_t* read_data)
 {
+		ret_code_t result = NRF_ERROR_NOT_FOUND;
+
+#if NRF_MODULE_ENABLED(CONN_POLICY)
+		conn_policy_busy(CONN_POLICY_CARD, true);
+#endif
 	
-		success = readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength,1000); 
+		success = 0;
+#if NRF_MODULE_ENABLED(CARD_CACHE)
+		if (card_cache_replay(block_num, excursion_num))
+		{
+				result = NRF_SUCCESS;
+		}
+		else
+#endif
+		{
+				success = card_select();
+		}
     if (success) {
 //      printf("\r\n---->Found an ISO14443A card\r\n");	
 //		  printf("---->UID Length: %d\r\n",uidLength);
-		beep_test();
+		card_uid_report();
 //    printf("UID :");		
 //		for(uint8_t i=0; i<uidLength; i++)
 //		{
@@ -61,77 +834,20 @@ void read_data_card(uint8_t block_num, uint8_t excursion_num, uint8_t* read_data
 //		}
 //		printf("\r\n");	
 			
-    ble_nus_string_send(&m_nus, uid, uidLength);
-  /*  if (uidLength == 4)
+		pn532_profile_t profile = card_profile();
+		result = NRF_ERROR_NOT_SUPPORTED;
+
+    if (PN532_PROFILE_IS_CLASSIC(profile))
     {
-					// We probably have a Mifare Classic card ... 
-				
-//					 printf("Seems to be a Mifare Classic card (4 byte UID)\r\n");
-//					// Now we need to try to authenticate it for read/write access
-//					// Try with the factory default KeyA: 0xFF 0xFF 0xFF 0xFF 0xFF 0xFF
-//					printf("Trying to authenticate block 4 with default KEYA value\r\n");
-
-							  uint8_t keya[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
-
-//					key(keya);					
-					// Start with block 4 (the first block of sector 1) since sector 0
-					// contains the manufacturer data and it's probably better just
-					// to leave it alone unless you know what you're doing
-					
-//					printf("---->keyA : %02x %02x %02x %02x %02x %02x\r\n",keya[0],keya[1],keya[2],keya[3],keya[4],keya[5]);
-//          printf("----> : %02x %02x %02x %02x %02x %02x\r\n",block_num,excursion_num,keya[2],keya[3],keya[4],keya[5]);									
-          for(uint8_t i =block_num ; i <= (block_num+excursion_num); i++)
-					{
-										success = mifareclassic_AuthenticateBlock(uid, uidLength, i, 0, keya);
-									
-										if (success)
-										{
-//											printf("Sector 1 (Blocks 4..7) has been authenticated\r\n");
-											uint8_t data[16];
-
-											// If you want to write something to block 4 to test with, uncomment
-											// the following line and this text should be read back in a minute
-											//memcpy(data, (const uint8_t[]){ 'a', 'd', 'a', 'f', 'r', 'u', 'i', 't', '.', 'c', 'o', 'm', 0, 0, 0, 0 }, sizeof data);
-											//success = nfc.mifareclassic_WriteDataBlock (4, data);
-
-											
-														// Try to read the contents of block 4
-														success = mifareclassic_ReadDataBlock(i, data);
-												
-														if (success)
-														{
-															// Data seems to have been read ... spit it out
-//															 printf("Reading Block %2d:",i);
-//															for(uint8_t i = 0; i<16; i++)
-//															{
-//																printf("%02x ",data[i]);
-//															}
-//															 printf("\r\n");
-															nrf_delay_ms(20);
-															// Wait a bit before reading the card again
-                              ble_nus_string_send(&m_nus, data, 16);
-														}
-														else
-														{
-//															printf("Ooops ... unable to read the requested block.  Try another key?\r\n");
-														}
-														
-										}
-										else
-										{
-					//						printf("Ooops ... authentication failed: Try another key?\r\n");
-										}
-											
-					}
-					nrf_delay_ms(500);
+          result = (card_read_range(block_num, excursion_num, NULL) > 0) ? NRF_SUCCESS : NRF_ERROR_FORBIDDEN;
     }
-    */
-    if (uidLength == 7)
+    if (PN532_PROFILE_IS_T2T(profile))
     {
 //      printf("Seems to be a Mifare Ultralight tag (7 byte UID)\r\n");
 //			printf("Reading page 4\r\n");
       uint8_t data[32];
       success = mifareultralight_ReadPage (4, data);
+      result = success ? NRF_SUCCESS : NRF_ERROR_INTERNAL;
       if (success)
       {
        
@@ -141,7 +857,6 @@ void read_data_card(uint8_t block_num, uint8_t excursion_num, uint8_t* read_data
 //					}
 //					 printf("\r\n");
        
-        nrf_delay_ms(100);
       }
       else
       {
@@ -150,20 +865,29 @@ void read_data_card(uint8_t block_num, uint8_t excursion_num, uint8_t* read_data
     }
 			
     }
-	   my_memset(uid,0,7);
+	   card_result_report(result);
+	   my_memset(uid,0,sizeof(uid));
+#if NRF_MODULE_ENABLED(CONN_POLICY)
+	   conn_policy_busy(CONN_POLICY_CARD, false);
+#endif
 
 }
 
 
 void write_data_card(uint8_t block_num,uint8_t excursion_num, uint8_t* write_data)
 {
+		ret_code_t result = NRF_ERROR_NOT_FOUND;
+
+#if NRF_MODULE_ENABLED(CONN_POLICY)
+		conn_policy_busy(CONN_POLICY_CARD, true);
+#endif
 	
-		success = readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength,1000); 
+		success = card_select(); 
 
     if (success) {
 //      printf("\r\n---->Found an ISO14443A card\r\n");	
 //		  printf("---->UID Length: %d\r\n",uidLength);
-		beep_test();
+		card_uid_report();
 //    printf("UID :");		
 //		for(uint8_t i=0; i<uidLength; i++)
 //		{
@@ -171,79 +895,25 @@ void write_data_card(uint8_t block_num,uint8_t excursion_num, uint8_t* write_dat
 //		}
 //		printf("\r\n");	
 			
-    ble_nus_string_send(&m_nus, uid, uidLength);
-    if (uidLength == 4)
+		pn532_profile_t profile = card_profile();
+		result = NRF_ERROR_NOT_SUPPORTED;
+
+    if (PN532_PROFILE_IS_CLASSIC(profile))
     {
-					// We probably have a Mifare Classic card ... 
-				
-//					 printf("Seems to be a Mifare Classic card (4 byte UID)\r\n");
-//					// Now we need to try to authenticate it for read/write access
-//					// Try with the factory default KeyA: 0xFF 0xFF 0xFF 0xFF 0xFF 0xFF
-//					printf("Trying to authenticate block 4 with default KEYA value\r\n");
-
-							  uint8_t keya[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
-
-//					key(keya);					
-					// Start with block 4 (the first block of sector 1) since sector 0
-					// contains the manufacturer data and it's probably better just
-					// to leave it alone unless you know what you're doing
-					
-//					printf("---->keyA : %02x %02x %02x %02x %02x %02x\r\n",keya[0],keya[1],keya[2],keya[3],keya[4],keya[5]);
-//          printf("----> : %02x %02x %02x %02x %02x %02x\r\n",block_num,excursion_num,keya[2],keya[3],keya[4],keya[5]);									
-          for(uint8_t i =block_num ; i <= (block_num+excursion_num); i++)
-					{
-										success = mifareclassic_AuthenticateBlock(uid, uidLength, i, 0, keya);
-									
-										if (success)
-										{
-//											printf("Sector 1 (Blocks 4..7) has been authenticated\r\n");
-											uint8_t data[16];
-
-											// If you want to write something to block 4 to test with, uncomment
-											// the following line and this text should be read back in a minute
-											//memcpy(data, (const uint8_t[]){ 'a', 'd', 'a', 'f', 'r', 'u', 'i', 't', '.', 'c', 'o', 'm', 0, 0, 0, 0 }, sizeof data);
-											//success = nfc.mifareclassic_WriteDataBlock (4, data);
-
-											
-														// Try to read the contents of block 4
-														success = mifareclassic_ReadDataBlock(i, data);
-												
-														if (success)
-														{
-															// Data seems to have been read ... spit it out
-//															 printf("Reading Block %2d:",i);
-//															for(uint8_t i = 0; i<16; i++)
-//															{
-//																printf("%02x ",data[i]);
-//															}
-															ble_nus_string_send(&m_nus, data, 16);
-//															 printf("\r\n");
-															// Wait a bit before reading the card again
-                             mifareclassic_WriteDataBlock(i,write_data);
-															
-														}
-														
-														else
-														{
-//															printf("Ooops ... unable to read the requested block.  Try another key?\r\n");
-														}
-														
-										}
-										else
-										{
-					//						printf("Ooops ... authentication failed: Try another key?\r\n");
-										}
-											
-					}
-					nrf_delay_ms(500);
+#if NRF_MODULE_ENABLED(CARD_CACHE)
+          card_cache_clear();
+#endif
+          // Old contents are reported, then the block is overwritten under the same sector auth.
+          result = (card_read_range(block_num, excursion_num, write_data) > 0) ? NRF_SUCCESS : NRF_ERROR_FORBIDDEN;
     }
     
-    if (uidLength == 7)
+    if (PN532_PROFILE_IS_T2T(profile))
     {
-      printf("Seems to be a Mifare Ultralight tag (7 byte UID)\r\n");
+      printf("Seems to be a Mifare Ultralight or NTAG tag\r\n");
 			printf("Reading page 4\r\n");
       uint8_t data[32];
       success = mifareultralight_ReadPage (4, data);
+      result = success ? NRF_SUCCESS : NRF_ERROR_INTERNAL;
       if (success)
       {
        
@@ -262,60 +932,603 @@ void write_data_card(uint8_t block_num,uint8_t excursion_num, uint8_t* write_dat
     }
 			
     }
-	   my_memset(uid,0,7);
+	   card_result_report(result);
+	   my_memset(uid,0,sizeof(uid));
+#if NRF_MODULE_ENABLED(CONN_POLICY)
+	   conn_policy_busy(CONN_POLICY_CARD, false);
+#endif
 
 }
-void pn532_appliction(uint8_t *a)    //Ѱ,,
+
+
+#if NRF_MODULE_ENABLED(FRAME_POOL)
+/* READ_CARD_F, bit rate (PN532_FELICA_212 or _424), system code (big endian), service code
+   (little endian), first block, block count: the IDm, then the blocks as one stream. */
+static void read_felica_card(uint8_t const * a)
 {
-	
-	  SAMConfig();
-		switch(*a)
-		{
-				case READ_CARD:
-					
-							read_data_card(*(a+1),*(a+2),(a+3));
-
-							break;
-
-				case WRITE_CARD:
-					
-							write_data_card(*(a+1),*(a+2),(a+3));
-							break;
-				case READ_CARD_B:
-					
-							test_uid();
-							break;	
+	pn532_felica_target_t target;
+	pn532_frame_view_t    data;
+	uint16_t              service = uint16_decode(&a[4]);
+	uint16_t              blocks[PN532_FELICA_READ_MAX_BLOCKS];
+	uint8_t               count   = MIN(a[7], PN532_FELICA_READ_MAX_BLOCKS);
+	uint8_t             * p_rx;
+
+#if NRF_MODULE_ENABLED(PN532_PRESENCE)
+	pn532_presence_reset();
+#endif
+	if ((count == 0) || !pn532_rf_mode_set(PN532_RF_MODE_FELICA))
+		return;
+	if (!felica_Polling(a[1], uint16_big_decode(&a[2]), FELICA_REQUEST_NONE, &target, 1000))
+		return;
+	nus_send_message(target.idm, sizeof(target.idm));
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		blocks[i] = FELICA_BLOCK(0, a[6] + i);
+	}
+	// The answer of a full read is larger than the packet buffer.
+	p_rx = frame_pool_alloc();
+	if (p_rx == NULL)
+		return;
+	if (felica_ReadWithoutEncryption(&target, 1, &service, count, blocks, p_rx, FRAME_POOL_BLOCK_SIZE, &data))
+		nus_send_buffer((uint8_t *)data.p_data, data.len);
+	frame_pool_free(p_rx);
+}
+#endif
+
+/* Card commands need the field: a background scan gives it up. Returns false
+   for a SCAN_CARD that only stopped the scan. */
+static bool field_claim(uint8_t cmd)
+{
+#if NRF_MODULE_ENABLED(PN532_DUTY)
+		if (pn532_duty_is_active())
+		{
+				if (cmd == SCAN_CARD)
+				{
+						pn532_duty_stop();
+						return false;
+				}
+				// The bursts and the commands both run from the main loop, only the sleep is in the way.
+				pn532_duty_wake();
+		}
+#elif NRF_MODULE_ENABLED(PN532_SCAN)
+		// A running background scan owns the field.
+		if (pn532_scan_is_active())
+		{
+				pn532_scan_stop();
+				if (cmd == SCAN_CARD)
+						return false;
+		}
+#else
+		UNUSED_PARAMETER(cmd);
+#endif
+		return true;
+}
+
+
+#if NRF_MODULE_ENABLED(CARD_SCRIPT)
+#if !NRF_MODULE_ENABLED(NUS_CMD)
+#error "CARD_SCRIPT needs NUS_CMD_ENABLED, the result is the data of the request"
+#endif
+STATIC_ASSERT(CARD_SCRIPT_SIZE <= UINT8_MAX);
+
+static uint8_t  m_script[CARD_SCRIPT_SIZE];
+static uint16_t m_script_len;
+static uint16_t m_script_link;
+
+/* CARD_SCRIPT, flags, code. A script longer than one request comes in parts,
+   all but the last with CARD_SCRIPT_FLAG_MORE; the phone sends them back to
+   back. The last part runs it against the card in the field, answered with
+   the offset the script stopped at and its result as the data of one
+   response, and the status of the script. */
+ret_code_t pn532_script_request(uint8_t const * p_payload, uint8_t len)
+{
+		card_script_t script;
+		uint8_t       out[1 + CARD_SCRIPT_OUT_MAX];
+		uint16_t      code_len;
+		ret_code_t    err_code = NRF_ERROR_NOT_FOUND;
+
+		if (len == 0)
+		{
+				return NRF_ERROR_INVALID_LENGTH;
+		}
+		// Parts of another link are a new script.
+		if (nus_tx_target_get() != m_script_link)
+		{
+				m_script_link = nus_tx_target_get();
+				m_script_len  = 0;
+		}
+		if (len - 1 > sizeof(m_script) - m_script_len)
+		{
+				m_script_len = 0;
+				return NRF_ERROR_NO_MEM;
+		}
+		memcpy(&m_script[m_script_len], &p_payload[1], len - 1);
+		m_script_len += len - 1;
+		if (p_payload[0] & CARD_SCRIPT_FLAG_MORE)
+		{
+				return NRF_SUCCESS;
+		}
+		code_len     = m_script_len;
+		m_script_len = 0;
+
+		if (!field_claim(CARD_SCRIPT) || !pn532_rf_mode_set(PN532_RF_MODE_ISO14443A))
+		{
+				return NRF_ERROR_INVALID_STATE;
+		}
+#if NRF_MODULE_ENABLED(CONN_POLICY)
+		conn_policy_busy(CONN_POLICY_CARD, true);
+#endif
+		if (card_select())
+		{
+				script.p_uid     = uid;
+				script.uid_len   = uidLength;
+				script.auth      = card_auth;
+				script.p_context = NULL;
+				script.p_out     = &out[1];
+				script.out_max   = CARD_SCRIPT_OUT_MAX;
+				err_code = card_script_run(&script, m_script, code_len);
+
+				out[0] = (uint8_t)script.stop;
+				UNUSED_RETURN_VALUE(nus_cmd_data(out, 1 + script.out_len));
+#if NRF_MODULE_ENABLED(CARD_CACHE)
+				// Whatever the script wrote is not in the cache.
+				card_cache_clear();
+#endif
+#if NRF_MODULE_ENABLED(MFC_KEYS)
+				mfc_keys_flush();
+#endif
+		}
+		my_memset(uid,0,sizeof(uid));
+#if NRF_MODULE_ENABLED(CONN_POLICY)
+		conn_policy_busy(CONN_POLICY_CARD, false);
+#endif
+		return err_code;
+}
+#endif
+
+/* The card commands, READ_CARD to SCAN_CARD; a card command that finds a scan
+   running takes the field over first. */
+static ret_code_t read_card_cmd(uint8_t * a, uint16_t len)
+{
+		UNUSED_PARAMETER(len);
+		if (field_claim(*a) && pn532_rf_mode_set(PN532_RF_MODE_ISO14443A))
+				read_data_card(*(a+1),*(a+2),(a+3));
+		return NRF_SUCCESS;
+}
+CMD_REG_REGISTER(m_read_card_cmd, READ_CARD, 3, CMD_REG_CLASS_FIELD, read_card_cmd);
+
+static ret_code_t write_card_cmd(uint8_t * a, uint16_t len)
+{
+		UNUSED_PARAMETER(len);
+		if (field_claim(*a) && pn532_rf_mode_set(PN532_RF_MODE_ISO14443A))
+				write_data_card(*(a+1),*(a+2),(a+3));
+		return NRF_SUCCESS;
+}
+// Opcode, block, count and at least the data of one block.
+CMD_REG_REGISTER(m_write_card_cmd, WRITE_CARD, 3 + 16, CMD_REG_CLASS_FIELD, write_card_cmd);
+
+static ret_code_t read_card_b_cmd(uint8_t * a, uint16_t len)
+{
+		UNUSED_PARAMETER(len);
+		if (field_claim(*a))
+				test_uid();
+		return NRF_SUCCESS;
+}
+CMD_REG_REGISTER(m_read_card_b_cmd, READ_CARD_B, 1, CMD_REG_CLASS_FIELD, read_card_b_cmd);
+
+#if NRF_MODULE_ENABLED(FRAME_POOL)
+static ret_code_t read_card_f_cmd(uint8_t * a, uint16_t len)
+{
+		UNUSED_PARAMETER(len);
+		if (field_claim(*a))
+				read_felica_card(a);
+		return NRF_SUCCESS;
+}
+CMD_REG_REGISTER(m_read_card_f_cmd, READ_CARD_F, 8, CMD_REG_CLASS_FIELD, read_card_f_cmd);
+#endif
+
+#if NRF_MODULE_ENABLED(PN532_SCAN) || NRF_MODULE_ENABLED(PN532_DUTY)
+static ret_code_t scan_card_cmd(uint8_t * a, uint16_t len)
+{
+		UNUSED_PARAMETER(len);
+		// A second SCAN_CARD stops the scan.
+		if (field_claim(*a))
+		{
+#if NRF_MODULE_ENABLED(PN532_PRESENCE)
+				pn532_presence_reset();
+#endif
+				scan_card_start();
+		}
+		return NRF_SUCCESS;
+}
+CMD_REG_REGISTER(m_scan_card_cmd, SCAN_CARD, 1, CMD_REG_CLASS_FIELD, scan_card_cmd);
+#endif
+
+
+#if NRF_MODULE_ENABLED(LOCK_ACL_ENROLL)
+#if !NRF_MODULE_ENABLED(PN532_DUTY)
+#error "LOCK_ACL_ENROLL needs PN532_DUTY_ENABLED, the cards come from its bursts"
+#endif
+#define ENROLL_COMMIT_TICKS  APP_TIMER_TICKS(LOCK_ACL_ENROLL_COMMIT_MS, APP_TIMER_CONFIG_PRESCALER)
+#define ENROLL_IDLE_TICKS    APP_TIMER_TICKS(1000UL * LOCK_ACL_ENROLL_IDLE_S, APP_TIMER_CONFIG_PRESCALER)
+
+static uint16_t m_enroll_added;   // UIDs added since the last summary
+static bool     m_enroll_idle;    // the batch is written, the timer runs to the end of the session
+
+/* Summary: ACL_ENROLL, op, result, UIDs added (2), entries (4) and version (4) of
+   the list, little endian. With the UIDs of the card reports the phone has the
+   list of this version and can go on with deltas from there. */
+static void enroll_report(uint8_t op, ret_code_t result)
+{
+		uint8_t report[3 + sizeof(uint16_t) + 2 * sizeof(uint32_t)];
+		uint8_t len = 3;
+
+		report[0] = ACL_ENROLL;
+		report[1] = op;
+		report[2] = (uint8_t)result;
+		len += uint16_encode(m_enroll_added, &report[len]);
+		len += uint32_encode(lock_acl_count(), &report[len]);
+		len += uint32_encode(lock_acl_version(), &report[len]);
+		nus_send_message(report, len);
+		m_enroll_added = 0;
+}
+
+static void enroll_leave(void)
+{
+		UNUSED_RETURN_VALUE(app_timer_stop(m_enroll_timer));
+		pn532_duty_rush(false);
+}
+
+static void enroll_commit(void)
+{
+		enroll_report(ACL_ENROLL_COMMIT, lock_acl_enroll_commit());
+		if (!lock_acl_enroll_is_active())
+		{
+				// A failed commit ends the session and leaves no list: the phone sends a full image.
+				enroll_leave();
+		}
+}
+
+static ret_code_t enroll_end(void)
+{
+		ret_code_t err_code = lock_acl_enroll_end();
+
+		enroll_leave();
+		enroll_report(ACL_ENROLL_END, err_code);
+		return err_code;
+}
+
+/* Main loop: a pause commits the batch, a longer one ends the session, so a
+   reader is never left enrolling whatever is tapped on it. */
+static void enroll_timeout(void * p_event_data, uint16_t event_size)
+{
+		UNUSED_PARAMETER(p_event_data);
+		UNUSED_PARAMETER(event_size);
+
+		if (!lock_acl_enroll_is_active())
+		{
+				return;
+		}
+		if (m_enroll_idle)
+		{
+				UNUSED_RETURN_VALUE(enroll_end());
+				return;
+		}
+		enroll_commit();
+		m_enroll_idle = true;
+		if (lock_acl_enroll_is_active())
+		{
+				UNUSED_RETURN_VALUE(app_timer_start(m_enroll_timer, ENROLL_IDLE_TICKS, NULL));
+		}
+}
+
+static void enroll_timer_handler(void * p_context)
+{
+		UNUSED_PARAMETER(p_context);
+		UNUSED_RETURN_VALUE(app_sched_event_put(NULL, 0, enroll_timeout));
+}
+
+/* A tap while enrolling: the UID goes into the batch instead of through the
+   list. Answered with ACL_ENROLL, ACL_ENROLL_CARD, result, added, UID; a full
+   batch is written right away. */
+static void card_enroll(uint8_t const * p_uid, uint8_t len)
+{
+		uint8_t    report[4 + PN532_UID_MAX_LEN];
+		bool       added;
+		ret_code_t err_code = lock_acl_enroll_add(p_uid, len, &added);
+
+		if (err_code != NRF_SUCCESS)
+		{
+				lock_feedback_play(LOCK_FB_FAIL);
+		}
+		else
+		{
+				// A card already on the list gets the plain beep: the operator sees it went through.
+				lock_feedback_play(added ? LOCK_FB_SUCCESS : LOCK_FB_BEEP);
+		}
+		len = MIN(len, PN532_UID_MAX_LEN);
+		report[0] = ACL_ENROLL;
+		report[1] = ACL_ENROLL_CARD;
+		report[2] = (uint8_t)err_code;
+		report[3] = added;
+		memcpy(&report[4], p_uid, len);
+		nus_send_message(report, 4 + len);
+
+		m_enroll_added += added;
+		if (lock_acl_enroll_pending() == LOCK_ACL_ENROLL_BATCH)
+		{
+				enroll_commit();
+		}
+		if (lock_acl_enroll_is_active())
+		{
+				m_enroll_idle = false;
+				UNUSED_RETURN_VALUE(app_timer_stop(m_enroll_timer));
+				UNUSED_RETURN_VALUE(app_timer_start(m_enroll_timer, ENROLL_COMMIT_TICKS, NULL));
+		}
+}
+
+/* ACL_ENROLL, ACL_ENROLL_BEGIN, 16-byte CMAC: the cards tapped from now on are
+   added to the list, the reader polling as fast as it can. ACL_ENROLL,
+   ACL_ENROLL_END: write the rest and stop; answered with the summary too. */
+ret_code_t pn532_enroll_request(uint8_t const * p_payload, uint8_t len)
+{
+		ret_code_t err_code;
+
+		if (len == 0)
+		{
+				return NRF_ERROR_INVALID_LENGTH;
+		}
+		switch (p_payload[0])
+		{
+				case ACL_ENROLL_BEGIN:
+						if (len != 1 + NRF_CRYPTO_AES_BLOCK_SIZE)
+						{
+								return NRF_ERROR_INVALID_LENGTH;
+						}
+						err_code = lock_acl_enroll_begin(&p_payload[1]);
+						VERIFY_SUCCESS(err_code);
+						m_enroll_added = 0;
+						m_enroll_idle  = true;
+						UNUSED_RETURN_VALUE(app_timer_start(m_enroll_timer, ENROLL_IDLE_TICKS, NULL));
+						if (!pn532_duty_is_active())
+						{
+								scan_card_start();
+						}
+						pn532_duty_rush(true);
+						return NRF_SUCCESS;
+
+				case ACL_ENROLL_END:
+						return enroll_end();
+
 				default:
-							 printf("no_card \r\n");
-						
+						return NRF_ERROR_NOT_SUPPORTED;
 		}
 }
+#endif
+
+#if NRF_MODULE_ENABLED(PN532_DUTY)
+static void scan_card_handler(pn532_target_t const * p_target)
+{
+		uint8_t report[5 + sizeof(p_target->uid)];
+		uint8_t len = MIN(p_target->uid_len, sizeof(p_target->uid));
+		uint8_t rlen = 4 + len;
 
+		if (!card_is_new(p_target->uid, len))
+		{
+				return;
+		}
+#if NRF_MODULE_ENABLED(NTAG_AUTH)
+		// A Type 2 tag, still selected: its UID only counts once the tag is shown to be genuine.
+		if ((p_target->sel_res == 0x00) && (ntag_auth_check(p_target->uid, len) != NRF_SUCCESS))
+		{
+				lock_feedback_play(LOCK_FB_DENIED);
+				return;
+		}
+#endif
+#if NRF_MODULE_ENABLED(LOCK_ACL_ENROLL)
+		if (lock_acl_enroll_is_active())
+		{
+				card_enroll(p_target->uid, len);
+				return;
+		}
+#endif
+		card_access(p_target->uid, len);
+
+#if NRF_MODULE_ENABLED(NUS_PB)
+		UNUSED_VARIABLE(report);
+		UNUSED_VARIABLE(rlen);
+		UNUSED_RETURN_VALUE(nus_pb_card_a(p_target->uid, len, p_target->sens_res, p_target->sel_res));
+		return;
+#endif
+		// Same layout as the InAutoPoll reports: SENS_RES(2), SEL_RES, NFCID length, NFCID.
+		report[0] = (uint8_t)(p_target->sens_res >> 8);
+		report[1] = (uint8_t)p_target->sens_res;
+		report[2] = p_target->sel_res;
+		report[3] = len;
+		memcpy(&report[4], p_target->uid, len);
+#if NRF_MODULE_ENABLED(PN532_READER)
+		// Followed by the reader that saw the card.
+		report[rlen++] = pn532_reader_in_use();
+#endif
+		nus_send_message(report, MIN(rlen, BLE_NUS_MAX_DATA_LEN));
+}
+
+#if NRF_MODULE_ENABLED(PN532_HCE)
+#ifndef PN532_HCE_KEY
+#error "Define PN532_HCE_KEY, the AES-128 key phone credentials are signed with, as {0x.., ...}"
+#endif
+
+static uint8_t const m_hce_key[16] = PN532_HCE_KEY;
+
+/* A phone id goes through the whitelist like the UID of a card. */
+static bool hce_access(uint8_t const * p_id, uint8_t len)
+{
+		return card_access(p_id, len);
+}
+#endif
+
+#if NRF_MODULE_ENABLED(PN532_SNEP)
+static uint8_t hex_nibble(uint8_t c)
+{
+		if ((c >= '0') && (c <= '9'))
+		{
+				return c - '0';
+		}
+		c |= 0x20;
+		return ((c >= 'a') && (c <= 'f')) ? (c - 'a' + 10) : 0xFF;
+}
+
+/* A Text record with the id in hex, as a phone app pushes it; the id goes through the
+   whitelist like the UID of a card. */
+static void snep_record(pn532_ndef_evt_t const * p_evt, void * p_context)
+{
+		uint8_t id[10];
+		uint8_t len = p_evt->rec.text.data_len / 2;
+
+		UNUSED_PARAMETER(p_context);
+		if ((p_evt->type != PN532_NDEF_REC_TEXT) || (len == 0) || (len > sizeof(id)) ||
+		    (p_evt->rec.text.data_len % 2 != 0))
+		{
+				return;
+		}
+		for (uint8_t i = 0; i < len; i++)
+		{
+				uint8_t hi = hex_nibble(p_evt->rec.text.p_data[2 * i]);
+				uint8_t lo = hex_nibble(p_evt->rec.text.p_data[2 * i + 1]);
+
+				if ((hi | lo) > 0x0F)
+				{
+						return;
+				}
+				id[i] = (uint8_t)((hi << 4) | lo);
+		}
+		UNUSED_RETURN_VALUE(card_access(id, len));
+}
+
+static void snep_push(uint8_t * p_msg, uint16_t len)
+{
+		UNUSED_RETURN_VALUE(pn532_ndef_msg_dispatch(p_msg, len, snep_record, NULL));
+}
+#endif
+
+/* Wake the PN532 for short type A polls and keep it in PowerDown in between. */
+void scan_card_start(void)
+{
+#if NRF_MODULE_ENABLED(PN532_HCE)
+		// The bursts that find no card listen for a phone.
+		APP_ERROR_CHECK(pn532_hce_init(m_hce_key, hce_access));
+#endif
+#if NRF_MODULE_ENABLED(PN532_SNEP)
+		// And for a phone in peer to peer mode that pushes an id.
+		APP_ERROR_CHECK(pn532_snep_init(snep_push));
+#endif
+		if (pn532_duty_start(scan_card_handler) != NRF_SUCCESS)
+		{
+				printf("scan start failed\r\n");
+		}
+}
+#elif NRF_MODULE_ENABLED(PN532_SCAN)
+static void scan_card_handler(pn532_scan_evt_t const * p_evt)
+{
+		if (p_evt->result != NRF_SUCCESS)
+		{
+				printf("scan stopped, err %d\r\n", p_evt->result);
+				return;
+		}
+		for (uint8_t i = 0; i < p_evt->target_count; i++)
+		{
+				if (p_evt->targets[i].data_len < 2)
+				{
+						continue;
+				}
+				// 106A target data: Tg, SENS_RES(2), SEL_RES, NFCID length, NFCID.
+				if (p_evt->targets[i].type == PN532_SCAN_TYPE_106A)
+				{
+						uint8_t const * p_data = p_evt->targets[i].p_data;
+
+						if ((p_evt->targets[i].data_len >= 5) && (p_evt->targets[i].data_len >= 5 + p_data[4]) &&
+						    card_is_new(&p_data[5], p_data[4]))
+						{
+								card_access(&p_data[5], p_data[4]);
+						}
+				}
+#if NRF_MODULE_ENABLED(NUS_PB)
+				{
+						uint8_t const * p_data = p_evt->targets[i].p_data;
+
+						// 106B target data: Tg, ATQB (0x50, PUPI(4), ...).
+						if ((p_evt->targets[i].type == PN532_SCAN_TYPE_106A) && (p_evt->targets[i].data_len >= 5 + p_data[4]))
+						{
+								UNUSED_RETURN_VALUE(nus_pb_card_a(&p_data[5], p_data[4],
+								                                  ((uint16_t)p_data[1] << 8) | p_data[2], p_data[3]));
+						}
+						else if ((p_evt->targets[i].type == PN532_SCAN_TYPE_106B) && (p_evt->targets[i].data_len >= 6))
+						{
+								UNUSED_RETURN_VALUE(nus_pb_card_b(&p_data[2], 4));
+						}
+						continue;
+				}
+#endif
+				// Skip the Tg byte, NUS notifications carry at most 20 bytes.
+				uint16_t len = p_evt->targets[i].data_len - 1;
+				if (len > BLE_NUS_MAX_DATA_LEN)
+				{
+						len = BLE_NUS_MAX_DATA_LEN;
+				}
+				nus_send_message((uint8_t *)p_evt->targets[i].p_data + 1, len);
+		}
+}
+
+/* Poll for type A and type B cards in the background, report each detection over NUS. */
+void scan_card_start(void)
+{
+		static uint8_t const types[] = {PN532_SCAN_TYPE_106A, PN532_SCAN_TYPE_106B};
+
+		if (pn532_scan_start(types, sizeof(types), 2, scan_card_handler) != NRF_SUCCESS)
+		{
+				printf("scan start failed\r\n");
+		}
+}
+#endif
 
 void power_down_pn532(void)
 {
+#if NRF_MODULE_ENABLED(MX25_POWER)
+	// Nothing reads the whitelist while the reader sleeps.
+	mx25lxx_idle_sleep();
+#endif
 	pn532_power_down();
 	nrf_delay_ms(1000);
 }
 
 void wake_up_pn532(void)
 {
+	LAT_TRACE_START(t);
 	pn532_wake_up();
+	LAT_TRACE_STOP(LAT_STAGE_WAKE, t);
 }
 
 void test_uid(void)
 {
-	uint8_t cardbaudrate; 
+	uint8_t cardbaudrate = PN532_TYPEB_BITRATE_424; 
 	uint8_t uid[16]={0}; 
 	uint8_t uidLength = 0xff; 
 	uint16_t timeout = 1000;
 	
 	
-  SetRFConfiguration();		
-	CategoryBConfig();
-  SetParameters();
-  readTypeBuid(cardbaudrate,uid,&uidLength,timeout);
-	ble_nus_string_send(&m_nus, uid, uidLength);
+#if NRF_MODULE_ENABLED(PN532_PRESENCE)
+	pn532_presence_reset();
+#endif
+	if (!pn532_rf_mode_set(PN532_RF_MODE_ISO14443B))
+		return;
+  if (!readTypeBuid(cardbaudrate,uid,&uidLength,timeout))
+		return;
+#if NRF_MODULE_ENABLED(NUS_PB)
+	UNUSED_RETURN_VALUE(nus_pb_card_b(uid, uidLength));
+#else
+	nus_send_message(uid, uidLength);
+#endif
 
 }
 
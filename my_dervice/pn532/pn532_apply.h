@@ -2,20 +2,55 @@
 #ifndef __PN532_APPLY_H__
 #define __PN532_APPLY_H__
 
+#include <stdbool.h>
 #include <stdint.h>
+#include "sdk_errors.h"
  enum _num_
 {
 	READ_CARD = 1,
 	WRITE_CARD = 2,
 	READ_CARD_B = 3,
+	SCAN_CARD = 4,
+	UNLOCK_DOOR = 5,
+	ACL_LOAD = 6,
+	JOURNAL_READ = 7,
+	TRACE_READ = 8,
+	ACL_DELTA = 9,
+	LINK_ADMIN = 10,
+	POST_MORTEM = 11,
+	RF_TUNE = 12,
+	READ_CARD_F = 13,
+	CARD_SCRIPT = 14,
+	ACL_TABLE = 15,
+	TIME_SET = 16,
+	JOURNAL_FIND = 17,
+	JOURNAL_SYNC = 18,
+	DEV_CONFIG = 19,
+	READER_DIAG = 20,
+	ACL_ENROLL = 21,
+	ENERGY = 22,
+	LOAD_GEN = 23,
+	RAM_BUDGET = 24,
+	NUS_BENCH = 25,
 };
 
+#define CARD_SCRIPT_FLAG_MORE  0x01  // CARD_SCRIPT: more parts of the script follow
+
+#define ACL_ENROLL_BEGIN   0  // ACL_ENROLL: start, with the CMAC of lock_acl_enroll_begin()
+#define ACL_ENROLL_END     1  // ACL_ENROLL: write the rest and stop
+#define ACL_ENROLL_CARD    2  // ACL_ENROLL report: a card was tapped
+#define ACL_ENROLL_COMMIT  3  // ACL_ENROLL report: a batch was written
+
+
 void device_pn532_init();
-void pn532_appliction(uint8_t *);
+bool device_pn532_probe(void);
 void power_down_pn532(void);
 void wake_up_pn532(void);
 void pn532_timeout_handler(void * p_context);
 void read_data_card(uint8_t block_num, uint8_t excursion_num ,uint8_t *read_data);
 void write_data_card(uint8_t block_num, uint8_t excursion_num, uint8_t *write_data);
 void test_uid(void);
+void scan_card_start(void);
+ret_code_t pn532_script_request(uint8_t const * p_payload, uint8_t len);
+ret_code_t pn532_enroll_request(uint8_t const * p_payload, uint8_t len);
 #endif
\ No newline at end of file
@@ -0,0 +1,591 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+#include "pn532_async.h"
+#include "pn532_i2c.h"
+#include "nrf_queue.h"
+#include "app_error.h"
+#include "nrf_drv_gpiote.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "app_util_platform.h"
+#include "nrf_delay.h"
+#include <string.h>
+#if NRF_MODULE_ENABLED(PN532_PPI_RX)
+#include "nrf_drv_ppi.h"
+#endif
+#ifdef SOFTDEVICE_PRESENT
+#include "softdevice_handler.h"
+#include "wdt_sup.h"
+#endif
+
+#define PN532_ACK_FRAME_LEN 6
+
+#if NRF_MODULE_ENABLED(PN532_PPI_RX)
+#if !PPI_ENABLED
+#error "PN532_PPI_RX needs PPI_ENABLED"
+#endif
+#if (PN532_TRANSPORT != PN532_TRANSPORT_I2C) || NRF_MODULE_ENABLED(PN532_SIM)
+#error "PN532_PPI_RX starts TWI reads, it needs the I2C transport"
+#endif
+#define PN532_IRQ_HI_ACCURACY  true     /**< PPI needs an IN event, the PORT event has no pin. */
+#define PN532_IRQ_PORT_SENSE   0
+#else
+#define PN532_IRQ_HI_ACCURACY  false
+#define PN532_IRQ_PORT_SENSE   NRF_MODULE_ENABLED(PORT_SENSE)
+#endif
+
+#if PN532_IRQ_PORT_SENSE
+#include "port_sense.h"
+#endif
+
+#if NRF_MODULE_ENABLED(HF_CLOCK) && (PN532_TRANSPORT == PN532_TRANSPORT_HSU) && !NRF_MODULE_ENABLED(PN532_SIM)
+#include "hf_clock.h"
+#define PN532_HFXO  1   /**< The UART of HSU needs the crystal while the chip is awake. */
+#else
+#define PN532_HFXO  0
+#endif
+
+typedef enum
+{
+    PN532_CMD_IDLE,      /**< No command in flight. */
+    PN532_CMD_TX,        /**< Command frame is being written. */
+    PN532_CMD_WAIT_ACK,  /**< Command written, waiting for the ACK frame. */
+    PN532_CMD_RX_ACK,    /**< ACK frame is being read. */
+    PN532_CMD_WAIT_RESP, /**< ACK read, waiting for the response frame. */
+    PN532_CMD_RX_RESP,   /**< Response frame is being read. */
+} pn532_cmd_state_t;
+
+/**@brief Command waiting in the queue. The frame is built when the command is queued, so that
+ *        building the next frame overlaps with the transfer of the current one.
+ */
+typedef struct
+{
+    uint8_t             frame[PN532_ASYNC_FRAME_MAX_LEN];
+    uint8_t             frame_len;
+    uint8_t             resp_len;
+    uint8_t *           p_resp;
+    uint32_t            timeout_ms;
+    pn532_cmd_handler_t handler;
+    void *              p_context;
+} pn532_cmd_desc_t;
+
+NRF_QUEUE_DEF(pn532_cmd_desc_t, m_cmd_queue, PN532_ASYNC_QUEUE_SIZE, NRF_QUEUE_MODE_NO_OVERFLOW);
+
+APP_TIMER_DEF(m_cmd_timer);
+APP_TIMER_DEF(m_wait_timer);
+
+static volatile pn532_cmd_state_t m_state = PN532_CMD_IDLE;
+static volatile bool              m_wait_expired;
+static volatile bool              m_irq_sched_pending;
+static volatile ret_code_t        m_bus_result;
+
+static pn532_cmd_desc_t m_cmd;                                  /**< Command in flight. */
+static uint8_t          m_rx_buf[PN532_ASYNC_FRAME_MAX_LEN + 1]; /**< Status byte plus frame. */
+
+static const uint8_t m_ack_frame[PN532_ACK_FRAME_LEN] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+
+#if NRF_MODULE_ENABLED(PN532_PPI_RX)
+static nrf_ppi_channel_t m_ppi_channel;         /**< IRQ falling edge -> TWI STARTRX. */
+#endif
+
+static void cmd_next(void);
+#if NRF_MODULE_ENABLED(PN532_PPI_RX)
+static void rx_disarm(void);
+#endif
+
+
+static void cpu_wait(void)
+{
+#ifdef SOFTDEVICE_PRESENT
+    if (softdevice_handler_is_enabled())
+    {
+        UNUSED_RETURN_VALUE(sd_app_evt_wait());
+        return;
+    }
+#endif
+    __WFE();
+    __SEV();
+    __WFE();
+}
+
+
+/**@brief Whether the supervisor gave up on the wait, see waitUntilReady(). */
+static bool rf_expired(void)
+{
+#if NRF_MODULE_ENABLED(WDT_SUP)
+    return wdt_sup_expired(WDT_SUP_RF);
+#else
+    return false;
+#endif
+}
+
+
+static void cmd_complete(ret_code_t result)
+{
+    pn532_cmd_handler_t handler = m_cmd.handler;
+
+    UNUSED_RETURN_VALUE(app_timer_stop(m_cmd_timer));
+#if NRF_MODULE_ENABLED(PN532_PPI_RX)
+    rx_disarm();
+#endif
+    m_state       = PN532_CMD_IDLE;
+    m_cmd.handler = NULL;
+
+    if (handler != NULL)
+    {
+        handler(result, m_cmd.p_context);
+    }
+
+    // The handler may already have started the next command.
+    if (m_state == PN532_CMD_IDLE)
+    {
+        cmd_next();
+    }
+}
+
+
+/**@brief Bus transfer finished. Runs in the main loop. */
+static void bus_sched_handler(void * p_event_data, uint16_t event_size);
+
+
+static void bus_done_handler(ret_code_t result)
+{
+    m_bus_result = result;
+    UNUSED_RETURN_VALUE(app_sched_event_put_high(bus_sched_handler));
+}
+
+
+static ret_code_t rx_start(uint8_t len)
+{
+    return pn532_bus_read_async(m_rx_buf, len, bus_done_handler);
+}
+
+
+#if NRF_MODULE_ENABLED(PN532_PPI_RX)
+/**@brief Set up the read of the next frame so that the falling edge of IRQ starts it through
+ *        PPI. Between "ready" and the first SCL edge there is then no interrupt and no main loop.
+ */
+static void rx_arm(void)
+{
+    ret_code_t err_code;
+    uint8_t    irq_pin = pn532_reader_current()->bus.irq_pin;
+
+    if (m_state == PN532_CMD_WAIT_ACK)
+    {
+        m_state  = PN532_CMD_RX_ACK;
+        err_code = pn532_bus_read_hold(m_rx_buf, PN532_ACK_FRAME_LEN + 1, bus_done_handler);
+    }
+    else
+    {
+        m_state  = PN532_CMD_RX_RESP;
+        err_code = pn532_bus_read_hold(m_rx_buf, m_cmd.resp_len + 1, bus_done_handler);
+    }
+    if (err_code != NRF_SUCCESS)
+    {
+        cmd_complete(err_code);
+        return;
+    }
+
+    if (wirereadstatus() == PN532_I2C_READY)
+    {
+        // The edge has already passed.
+        pn532_bus_read_release();
+        return;
+    }
+
+    UNUSED_RETURN_VALUE(nrf_drv_ppi_channel_assign(m_ppi_channel,
+                                                   nrf_drv_gpiote_in_event_addr_get(irq_pin),
+                                                   pn532_bus_read_task()));
+    UNUSED_RETURN_VALUE(nrf_drv_ppi_channel_enable(m_ppi_channel));
+    // An edge in the few cycles since the check may have come before the channel was on; that
+    // read then waits for the command deadline, which releases it.
+}
+
+
+/**@brief Take the trigger off and free the bus of a read that never started. */
+static void rx_disarm(void)
+{
+    UNUSED_RETURN_VALUE(nrf_drv_ppi_channel_disable(m_ppi_channel));
+    pn532_bus_read_release();
+}
+#endif //NRF_MODULE_ENABLED(PN532_PPI_RX)
+
+
+/**@brief Start the next queued command if the bus is free. */
+static void cmd_next(void)
+{
+    ret_code_t err_code;
+
+    if ((m_state != PN532_CMD_IDLE) || nrf_queue_is_empty(&m_cmd_queue))
+    {
+        return;
+    }
+
+    UNUSED_RETURN_VALUE(nrf_queue_peek(&m_cmd_queue, &m_cmd));
+
+    m_state  = PN532_CMD_TX;
+    err_code = pn532_bus_write_async(m_cmd.frame, m_cmd.frame_len, bus_done_handler);
+    if (err_code == NRF_ERROR_BUSY)
+    {
+        // A transfer of a timed out command still owns the bus, retry when it ends.
+        m_state = PN532_CMD_IDLE;
+        return;
+    }
+
+    // m_cmd already holds the command, the queue only lets go of it.
+    UNUSED_RETURN_VALUE(nrf_queue_consume(&m_cmd_queue, 1));
+
+    if (err_code != NRF_SUCCESS)
+    {
+        cmd_complete(err_code);
+        return;
+    }
+
+    if (m_cmd.timeout_ms != 0)
+    {
+        err_code = app_timer_start(m_cmd_timer,
+                                   APP_TIMER_TICKS(m_cmd.timeout_ms, APP_TIMER_CONFIG_PRESCALER),
+                                   NULL);
+        APP_ERROR_CHECK(err_code);
+    }
+}
+
+
+/**@brief Advance the command state machine on the ready signal. Runs in the main loop. */
+static void irq_sched_handler(void * p_event_data, uint16_t event_size)
+{
+    ret_code_t err_code;
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    m_irq_sched_pending = false;
+
+    if (wirereadstatus() != PN532_I2C_READY)
+    {
+        return;
+    }
+
+    if (m_state == PN532_CMD_WAIT_ACK)
+    {
+        m_state  = PN532_CMD_RX_ACK;
+        err_code = rx_start(PN532_ACK_FRAME_LEN + 1);
+    }
+    else if (m_state == PN532_CMD_WAIT_RESP)
+    {
+        m_state  = PN532_CMD_RX_RESP;
+        err_code = rx_start(m_cmd.resp_len + 1);
+    }
+    else
+    {
+        return;
+    }
+
+    if (err_code != NRF_SUCCESS)
+    {
+        cmd_complete(err_code);
+    }
+}
+
+
+static void irq_sched_request(void)
+{
+    if (!m_irq_sched_pending)
+    {
+        m_irq_sched_pending = true;
+        if (app_sched_event_put_high(irq_sched_handler) != NRF_SUCCESS)
+        {
+            m_irq_sched_pending = false;
+        }
+    }
+}
+
+
+static void bus_sched_handler(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    if (m_state == PN532_CMD_IDLE)
+    {
+        // Late transfer of a timed out or aborted command; the bus is free again.
+        cmd_next();
+        return;
+    }
+
+    if (m_bus_result != NRF_SUCCESS)
+    {
+        cmd_complete(m_bus_result);
+        return;
+    }
+
+    switch (m_state)
+    {
+        case PN532_CMD_TX:
+            m_state = PN532_CMD_WAIT_ACK;
+            break;
+
+        case PN532_CMD_RX_ACK:
+            // First byte is the I2C status byte.
+            if (memcmp(&m_rx_buf[1], m_ack_frame, PN532_ACK_FRAME_LEN) != 0)
+            {
+                cmd_complete(NRF_ERROR_INVALID_DATA);
+                return;
+            }
+            m_state = PN532_CMD_WAIT_RESP;
+            break;
+
+        case PN532_CMD_RX_RESP:
+        {
+            pn532_frame_view_t view;
+
+            if (pn532_frame_decode(&m_rx_buf[1], m_cmd.resp_len, &view) != NRF_SUCCESS)
+            {
+                cmd_complete(NRF_ERROR_INVALID_DATA);
+                return;
+            }
+            memcpy(m_cmd.p_resp, &m_rx_buf[1], m_cmd.resp_len);
+            cmd_complete(NRF_SUCCESS);
+            return;
+        }
+
+        default:
+            return;
+    }
+
+#if NRF_MODULE_ENABLED(PN532_PPI_RX)
+    rx_arm();
+#else
+    // The edge may have passed while the previous frame was on the bus.
+    if (wirereadstatus() == PN532_I2C_READY)
+    {
+        irq_sched_request();
+    }
+#endif
+}
+
+
+#if PN532_IRQ_PORT_SENSE
+static void pn532_irq_handler(uint8_t pin, bool level)
+{
+    UNUSED_PARAMETER(pin);
+
+    if (level)
+    {
+        // The host has read the frame.
+        return;
+    }
+#else
+static void pn532_irq_handler(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action)
+{
+    UNUSED_PARAMETER(pin);
+    UNUSED_PARAMETER(action);
+#endif
+
+    if ((m_state == PN532_CMD_WAIT_ACK) || (m_state == PN532_CMD_WAIT_RESP))
+    {
+        irq_sched_request();
+    }
+#if PN532_HFXO
+    else if (m_state == PN532_CMD_IDLE)
+    {
+        // Woken by a card or a field: the crystal starts while the host gets to its commands.
+        hf_clock_request(HF_CLOCK_USER_PN532);
+    }
+#endif
+}
+
+
+static void cmd_timeout_sched_handler(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    if (m_state != PN532_CMD_IDLE)
+    {
+        cmd_complete(NRF_ERROR_TIMEOUT);
+    }
+}
+
+
+static void cmd_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+    UNUSED_RETURN_VALUE(app_sched_event_put_high(cmd_timeout_sched_handler));
+}
+
+
+static void wait_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+    m_wait_expired = true;
+}
+
+
+ret_code_t pn532_async_init(void)
+{
+    ret_code_t err_code;
+
+#if PN532_IRQ_PORT_SENSE
+    // A level that stays low until the host reads: the shared PORT event of port_sense.
+    err_code = port_sense_init();
+    VERIFY_SUCCESS(err_code);
+    err_code = pn532_async_irq_add(PN532_IRQ);
+    VERIFY_SUCCESS(err_code);
+#else
+    if (!nrf_drv_gpiote_is_init())
+    {
+        err_code = nrf_drv_gpiote_init();
+        VERIFY_SUCCESS(err_code);
+    }
+
+    // Low accuracy (PORT event) is enough for a level that stays low until the host reads;
+    // PN532_PPI_RX routes the event to the TWI and needs a GPIOTE channel.
+    nrf_drv_gpiote_in_config_t irq_config = GPIOTE_CONFIG_IN_SENSE_HITOLO(PN532_IRQ_HI_ACCURACY);
+    irq_config.pull = NRF_GPIO_PIN_NOPULL;
+
+    err_code = nrf_drv_gpiote_in_init(PN532_IRQ, &irq_config, pn532_irq_handler);
+    VERIFY_SUCCESS(err_code);
+    nrf_drv_gpiote_in_event_enable(PN532_IRQ, true);
+#endif
+
+#if NRF_MODULE_ENABLED(PN532_PPI_RX)
+    err_code = nrf_drv_ppi_init();
+    if ((err_code != NRF_SUCCESS) && (err_code != NRF_ERROR_MODULE_ALREADY_INITIALIZED))
+    {
+        return err_code;
+    }
+    err_code = nrf_drv_ppi_channel_alloc(&m_ppi_channel);
+    VERIFY_SUCCESS(err_code);
+#endif
+
+    err_code = app_timer_create(&m_cmd_timer, APP_TIMER_MODE_SINGLE_SHOT, cmd_timer_handler);
+    VERIFY_SUCCESS(err_code);
+
+    return app_timer_create(&m_wait_timer, APP_TIMER_MODE_SINGLE_SHOT, wait_timer_handler);
+}
+
+
+ret_code_t pn532_async_irq_add(uint8_t pin)
+{
+#if PN532_IRQ_PORT_SENSE
+    // The handler checks the line of the selected reader, edges of the others are ignored.
+    return port_sense_pin_add(pin, NRF_GPIO_PIN_NOPULL, false, pn532_irq_handler);
+#else
+    ret_code_t err_code;
+
+    nrf_drv_gpiote_in_config_t irq_config = GPIOTE_CONFIG_IN_SENSE_HITOLO(PN532_IRQ_HI_ACCURACY);
+    irq_config.pull = NRF_GPIO_PIN_NOPULL;
+
+    // The handler checks the line of the selected reader, edges of the others are ignored.
+    err_code = nrf_drv_gpiote_in_init(pin, &irq_config, pn532_irq_handler);
+    VERIFY_SUCCESS(err_code);
+    nrf_drv_gpiote_in_event_enable(pin, true);
+
+    return NRF_SUCCESS;
+#endif
+}
+
+
+ret_code_t pn532_cmd_start(uint8_t *           p_cmd,
+                           uint8_t             cmd_len,
+                           uint8_t *           p_resp,
+                           uint8_t             resp_len,
+                           uint32_t            timeout_ms,
+                           pn532_cmd_handler_t handler,
+                           void *              p_context)
+{
+    pn532_cmd_desc_t desc;
+    ret_code_t       err_code;
+
+    if ((cmd_len + PN532_FRAME_OVERHEAD > PN532_ASYNC_FRAME_MAX_LEN) ||
+        (resp_len > PN532_ASYNC_FRAME_MAX_LEN))
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    memcpy(&desc.frame[HEADER_SEQUENCE_LENGTH], p_cmd, cmd_len);
+    desc.frame_len  = (uint8_t)pn532_frame_encode(&desc.frame[HEADER_SEQUENCE_LENGTH], cmd_len);
+    desc.p_resp     = p_resp;
+    desc.resp_len   = resp_len;
+    desc.timeout_ms = timeout_ms;
+    desc.handler    = handler;
+    desc.p_context  = p_context;
+
+    err_code = nrf_queue_push(&m_cmd_queue, &desc);
+    if (err_code != NRF_SUCCESS)
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    cmd_next();
+
+    return NRF_SUCCESS;
+}
+
+
+bool pn532_cmd_busy(void)
+{
+    return (m_state != PN532_CMD_IDLE) || !nrf_queue_is_empty(&m_cmd_queue);
+}
+
+
+void pn532_cmd_abort(void)
+{
+    UNUSED_RETURN_VALUE(app_timer_stop(m_cmd_timer));
+#if NRF_MODULE_ENABLED(PN532_PPI_RX)
+    rx_disarm();
+#endif
+    nrf_queue_reset(&m_cmd_queue);
+    m_state       = PN532_CMD_IDLE;
+    m_cmd.handler = NULL;
+}
+
+
+bool pn532_wait_ready(uint32_t timeout_ms)
+{
+    if (wirereadstatus() == PN532_I2C_READY)
+    {
+        return true;
+    }
+
+    if (current_int_priority_get() != APP_IRQ_PRIORITY_THREAD)
+    {
+        // Sleeping here would block the event that wakes us; poll the pin instead.
+        uint32_t polls = timeout_ms * 10;
+        while (wirereadstatus() != PN532_I2C_READY)
+        {
+            if (((timeout_ms != 0) && (polls-- == 0)) || rf_expired())
+            {
+                return false;
+            }
+            nrf_delay_us(100);
+        }
+        return true;
+    }
+
+    m_wait_expired = false;
+    if (timeout_ms != 0)
+    {
+        if (app_timer_start(m_wait_timer,
+                            APP_TIMER_TICKS(timeout_ms, APP_TIMER_CONFIG_PRESCALER),
+                            NULL) != NRF_SUCCESS)
+        {
+            // Fall back to one full timeout worth of polling.
+            nrf_delay_ms(timeout_ms);
+            return (wirereadstatus() == PN532_I2C_READY);
+        }
+    }
+
+    // The supervisor's check wakes the CPU too, so a wait without a timeout ends as well.
+    while ((wirereadstatus() != PN532_I2C_READY) && !m_wait_expired && !rf_expired())
+    {
+        cpu_wait();
+    }
+
+    UNUSED_RETURN_VALUE(app_timer_stop(m_wait_timer));
+
+    return (wirereadstatus() == PN532_I2C_READY);
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_ASYNC)
@@ -0,0 +1,75 @@
+#ifndef __PN532_ASYNC_H__
+#define __PN532_ASYNC_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+#define PN532_ASYNC_FRAME_MAX_LEN  64 /**< Largest frame (either direction) handled by the engine. */
+
+/**@brief PN532 command completion handler.
+ *
+ * @details Called from the main loop (app_scheduler context), never from an interrupt.
+ *
+ * @param[in] result     NRF_SUCCESS when the response has been read into the buffer given to
+ *                       @ref pn532_cmd_start, NRF_ERROR_TIMEOUT when no ACK or response arrived
+ *                       in time, NRF_ERROR_INVALID_DATA when the ACK frame was malformed or the
+ *                       response failed its LCS/DCS check.
+ * @param[in] p_context  Context pointer passed to @ref pn532_cmd_start.
+ */
+typedef void (*pn532_cmd_handler_t)(ret_code_t result, void * p_context);
+
+/**@brief Set up the IRQ line (GPIOTE, falling edge) and the command deadline timer.
+ *
+ * @note Requires app_timer, app_scheduler and nrf_drv_gpiote to be available.
+ */
+ret_code_t pn532_async_init(void);
+
+/**@brief Watch the IRQ line of one more PN532, see pn532_reader.h. */
+ret_code_t pn532_async_irq_add(uint8_t pin);
+
+/**@brief Queue a command frame and complete it through a callback.
+ *
+ * @details The frame is built and queued, after which the function returns. Commands are sent
+ *          one at a time in queue order; all bus transfers run in the bus interrupt and the ACK
+ *          and the response are read when the PN532 pulls its IRQ line low, so the CPU can sleep
+ *          in sd_app_evt_wait() during the bus transfers and the chip turnaround.
+ *
+ * @param[in]  p_cmd       Command bytes (command code followed by parameters, no framing).
+ * @param[in]  cmd_len     Number of command bytes.
+ * @param[out] p_resp      Buffer receiving the raw response frame.
+ * @param[in]  resp_len    Number of response bytes to read.
+ * @param[in]  timeout_ms  Deadline for ACK plus response, 0 for no deadline.
+ * @param[in]  handler     Completion handler.
+ * @param[in]  p_context   Passed back to @p handler.
+ *
+ * @retval NRF_SUCCESS               Command queued, completion pending.
+ * @retval NRF_ERROR_BUSY            The command queue is full.
+ * @retval NRF_ERROR_INVALID_LENGTH  Command or response does not fit in a frame.
+ */
+ret_code_t pn532_cmd_start(uint8_t *           p_cmd,
+                           uint8_t             cmd_len,
+                           uint8_t *           p_resp,
+                           uint8_t             resp_len,
+                           uint32_t            timeout_ms,
+                           pn532_cmd_handler_t handler,
+                           void *              p_context);
+
+/**@brief Whether a command started with @ref pn532_cmd_start is in flight or queued. */
+bool pn532_cmd_busy(void);
+
+/**@brief Drop the command in flight and all queued commands without calling their handlers. */
+void pn532_cmd_abort(void);
+
+/**@brief Wait for the PN532 ready signal (IRQ low) with a deadline.
+ *
+ * @details In thread mode the CPU sleeps until the IRQ edge or the deadline timer wakes it. When
+ *          called from an interrupt handler it falls back to polling the pin.
+ *
+ * @param[in] timeout_ms  Deadline in milliseconds, 0 to wait forever.
+ *
+ * @return true if the chip is ready, false if the deadline expired.
+ */
+bool pn532_wait_ready(uint32_t timeout_ms);
+
+#endif
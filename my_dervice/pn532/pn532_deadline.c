@@ -0,0 +1,166 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_DEADLINE)
+#include "pn532_deadline.h"
+#include "pn532_i2c.h"
+#include "app_timer.h"
+#include <string.h>
+
+#define MEAN_SHIFT  3   /**< Gain 1/8. */
+#define DEV_SHIFT   2   /**< Gain 1/4. */
+
+typedef struct
+{
+    uint16_t key;
+    uint8_t  count;     /**< Responses seen, up to PN532_DEADLINE_SAMPLES; 0 for a free entry. */
+    uint8_t  age;       /**< Uses since this entry was last used, for the replacement. */
+    uint32_t mean_us;
+    uint32_t dev_us;
+} deadline_t;
+
+static deadline_t m_table[PN532_DEADLINE_KEYS];
+
+
+static deadline_t * entry_find(uint16_t key)
+{
+    for (uint8_t i = 0; i < PN532_DEADLINE_KEYS; i++)
+    {
+        if ((m_table[i].count != 0) && (m_table[i].key == key))
+        {
+            return &m_table[i];
+        }
+    }
+    return NULL;
+}
+
+
+/**@brief Entry of a key, a free or the least recently used one if it has none. */
+static deadline_t * entry_get(uint16_t key)
+{
+    deadline_t * p_entry = entry_find(key);
+
+    if (p_entry == NULL)
+    {
+        p_entry = &m_table[0];
+        for (uint8_t i = 0; i < PN532_DEADLINE_KEYS; i++)
+        {
+            if (m_table[i].count == 0)
+            {
+                p_entry = &m_table[i];
+                break;
+            }
+            if (m_table[i].age > p_entry->age)
+            {
+                p_entry = &m_table[i];
+            }
+        }
+        memset(p_entry, 0, sizeof(*p_entry));
+        p_entry->key = key;
+    }
+
+    for (uint8_t i = 0; i < PN532_DEADLINE_KEYS; i++)
+    {
+        if (m_table[i].age < UINT8_MAX)
+        {
+            m_table[i].age++;
+        }
+    }
+    p_entry->age = 0;
+    return p_entry;
+}
+
+
+void pn532_deadline_init(void)
+{
+    memset(m_table, 0, sizeof(m_table));
+}
+
+
+bool pn532_deadline_learns(uint16_t key, uint16_t timeout_ms)
+{
+    if ((timeout_ms == 0) || (timeout_ms > PN532_DEADLINE_MAX_MS))
+    {
+        return false;
+    }
+    switch (key >> 8)
+    {
+        case PN532_COMMAND_INLISTPASSIVETARGET:
+        case PN532_COMMAND_INAUTOPOLL:
+        case PN532_COMMAND_INJUMPFORDEP:
+        case PN532_COMMAND_INJUMPFORPSL:
+        case PN532_COMMAND_TGINITASTARGET:
+        case PN532_COMMAND_TGGETDATA:
+        case PN532_COMMAND_TGGETINITIATORCOMMAND:
+            // The wait is for somebody else.
+            return false;
+
+        default:
+            return true;
+    }
+}
+
+
+uint16_t pn532_deadline_get(uint16_t key, uint16_t timeout_ms)
+{
+    deadline_t const * p_entry = entry_find(key);
+    uint32_t           ms;
+
+    if ((p_entry == NULL) || (p_entry->count < PN532_DEADLINE_SAMPLES))
+    {
+        return timeout_ms;
+    }
+    ms = (p_entry->mean_us + PN532_DEADLINE_K * p_entry->dev_us + 999) / 1000;
+    return (uint16_t)MIN(MAX(ms, PN532_DEADLINE_MIN_MS), timeout_ms);
+}
+
+
+void pn532_deadline_put(uint16_t key, uint32_t us)
+{
+    deadline_t * p_entry = entry_get(key);
+
+    if (p_entry->count == 0)
+    {
+        p_entry->mean_us = us;
+        p_entry->dev_us  = us / 2;
+    }
+    else
+    {
+        uint32_t diff = (us > p_entry->mean_us) ? (us - p_entry->mean_us) : (p_entry->mean_us - us);
+
+        p_entry->mean_us = p_entry->mean_us - (p_entry->mean_us >> MEAN_SHIFT) + (us >> MEAN_SHIFT);
+        p_entry->dev_us  = p_entry->dev_us - (p_entry->dev_us >> DEV_SHIFT) + (diff >> DEV_SHIFT);
+    }
+    if (p_entry->count < PN532_DEADLINE_SAMPLES)
+    {
+        p_entry->count++;
+    }
+}
+
+
+void pn532_deadline_miss(uint16_t key)
+{
+    deadline_t * p_entry = entry_find(key);
+
+    if (p_entry != NULL)
+    {
+        // Capped, so a run of misses only ever gets back to the caller's timeout.
+        p_entry->dev_us = MIN(MAX(p_entry->dev_us * 2, 1000), PN532_DEADLINE_MAX_MS * 1000UL);
+    }
+}
+
+
+uint32_t pn532_deadline_now(void)
+{
+    return app_timer_cnt_get();
+}
+
+
+uint32_t pn532_deadline_us_since(uint32_t start)
+{
+    uint32_t ticks;
+
+    UNUSED_RETURN_VALUE(app_timer_cnt_diff_compute(app_timer_cnt_get(), start, &ticks));
+    return (uint32_t)(((uint64_t)ticks * 1000000 * (APP_TIMER_CONFIG_PRESCALER + 1)) /
+                      APP_TIMER_CLOCK_FREQ);
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_DEADLINE)
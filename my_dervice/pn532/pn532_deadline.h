@@ -0,0 +1,56 @@
+#ifndef __PN532_DEADLINE_H__
+#define __PN532_DEADLINE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Response deadlines learned from the latencies the PN532 has shown, instead of the fixed
+ * timeouts of the callers:
+ *
+ *   key        the command, and for InDataExchange and InListPassiveTarget the card command or
+ *              baud rate (see resp_key_set in PN532_I2C.c), so a Classic read and an NTAG fast
+ *              read each have their own
+ *   estimate   a smoothed mean and mean deviation of successful responses, as for TCP round
+ *              trip times: mean += (x - mean) / 8, dev += (|x - mean| - dev) / 4
+ *   deadline   mean + PN532_DEADLINE_K * dev, at least PN532_DEADLINE_MIN_MS and never more
+ *              than the caller asked for; the caller's timeout until
+ *              PN532_DEADLINE_SAMPLES responses have been seen
+ *   miss       a response late for its deadline is aborted and doubles the deviation, so a
+ *              card that is slow for real gets through on the next try
+ *
+ * Responses that report an RF error are not counted: what is learned is how long a card that
+ * is there takes, a card that is gone gives up at that. */
+
+#define PN532_DEADLINE_ACK_KEY  0xFFFF  /**< The ACK of any command. */
+
+/**@brief Forget all estimates. */
+void pn532_deadline_init(void);
+
+/**@brief Whether waits for the response of a command are learned.
+ *
+ * @details Not for the commands that wait for a card to enter the field or a reader to talk
+ *          to the target, nor for waits longer than PN532_DEADLINE_MAX_MS, which allow for
+ *          ISO-DEP waiting time extensions.
+ */
+bool pn532_deadline_learns(uint16_t key, uint16_t timeout_ms);
+
+/**@brief How long to wait for the response, in ms.
+ *
+ * @param[in] key         Command key.
+ * @param[in] timeout_ms  Timeout of the caller, the most that is returned.
+ */
+uint16_t pn532_deadline_get(uint16_t key, uint16_t timeout_ms);
+
+/**@brief A successful response took @p us. */
+void pn532_deadline_put(uint16_t key, uint32_t us);
+
+/**@brief The deadline of @p key passed without a response. */
+void pn532_deadline_miss(uint16_t key);
+
+/**@brief Start of a wait, for @ref pn532_deadline_us_since. */
+uint32_t pn532_deadline_now(void);
+
+/**@brief Microseconds since @p start. */
+uint32_t pn532_deadline_us_since(uint32_t start);
+
+#endif
@@ -0,0 +1,680 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_DESFIRE)
+#include "pn532_desfire.h"
+#include "pn532_isodep.h"
+#include "nrf_crypto_aes.h"
+#include "rand_pool.h"
+#include "pn532_sam.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(PN532_ISODEP) || !NRF_MODULE_ENABLED(NRF_CRYPTO_AES)
+#error "pn532_desfire needs PN532_ISODEP_ENABLED and NRF_CRYPTO_AES_ENABLED"
+#endif
+#if !NRF_MODULE_ENABLED(RAND_POOL)
+#error "pn532_desfire takes its nonces from RAND_POOL_ENABLED"
+#endif
+
+#define CLA_NATIVE          0x90    /**< ISO 7816 wrapping of native commands. */
+#define SW1_NATIVE          0x91    /**< SW2 of such an answer is the native status. */
+
+#define CMD_AUTHENTICATE_AES    0xAA
+#define CMD_SELECT_APPLICATION  0x5A
+#define CMD_READ_DATA           0xBD
+#define CMD_WRITE_DATA          0x3D
+#define CMD_GET_VALUE           0x6C
+#define CMD_CREDIT              0x0C
+#define CMD_DEBIT               0xDC
+#define CMD_LIMITED_CREDIT      0x1C
+#define CMD_COMMIT              0xC7
+#define CMD_ABORT               0xA7
+#define CMD_ADDITIONAL_FRAME    0xAF
+
+#define STATUS_OK           0x00
+#define STATUS_MORE         0xAF    /**< Additional frame: the card sends or expects more. */
+#define STATUS_INTEGRITY    0x1E
+#define STATUS_NO_CHANGES   0x0C    /**< Commit or abort with nothing pending, not an error. */
+#define STATUS_BOUNDARY     0xBE
+#define STATUS_LENGTH       0x7E
+#define STATUS_PARAMETER    0x9E
+#define STATUS_PERMISSION   0x9D
+#define STATUS_NO_APP       0xA0
+#define STATUS_AUTH         0xAE
+#define STATUS_NO_FILE      0xF0
+
+#define BLOCK_LEN           NRF_CRYPTO_AES_BLOCK_SIZE
+#define CMAC_LEN            8       /**< Bytes of the CMAC sent in frames. */
+#define FRAME_DATA_MAX      52      /**< Command bytes per frame, within the card's frame buffer. */
+#define APDU_OVERHEAD       6       /**< CLA INS P1 P2 Lc and Le. */
+#define RAPDU_SIZE          64      /**< A native answer frame holds at most 59 bytes and SW1 SW2. */
+
+#define SAM_INS_AUTH_PICC   0x0A    /**< SAM_AuthenticatePICC, both parts. */
+#define SAM_INS_DUMP_KEY    0xD5    /**< SAM_DumpSessionKey. */
+#define SAM_AUTH_DIV        0x11    /**< P1: the SAM diversifies the key, as in AN10922. */
+#define SAM_DIV_MAX         31
+
+/**@brief Authenticated session. */
+typedef struct
+{
+    bool    authenticated;
+    uint8_t key[BLOCK_LEN];     /**< Session key. */
+    uint8_t iv[BLOCK_LEN];      /**< CMAC of the last command or response. */
+    uint8_t status;             /**< Status byte of the last answer. */
+} desfire_session_t;
+
+/**@brief Command parameters, data and CMAC, sent as one stream over the frames. */
+typedef struct
+{
+    uint8_t const * p_part[3];
+    uint32_t        len[3];
+} desfire_payload_t;
+
+static desfire_session_t m_session;
+
+
+static void session_end(void)
+{
+    m_session.authenticated = false;
+    memset(m_session.key, 0, sizeof(m_session.key));
+}
+
+
+void pn532_desfire_reset(void)
+{
+    session_end();
+    m_session.status = STATUS_OK;
+}
+
+
+uint8_t pn532_desfire_status(void)
+{
+    return m_session.status;
+}
+
+
+bool pn532_desfire_authenticated(void)
+{
+    return m_session.authenticated;
+}
+
+
+static ret_code_t status_decode(uint8_t status)
+{
+    switch (status)
+    {
+        case STATUS_OK:
+        case STATUS_NO_CHANGES:
+            return NRF_SUCCESS;
+
+        case STATUS_NO_APP:
+        case STATUS_NO_FILE:
+            return NRF_ERROR_NOT_FOUND;
+
+        case STATUS_AUTH:
+        case STATUS_PERMISSION:
+            return NRF_ERROR_FORBIDDEN;
+
+        case STATUS_BOUNDARY:
+        case STATUS_LENGTH:
+        case STATUS_PARAMETER:
+            return NRF_ERROR_INVALID_PARAM;
+
+        case STATUS_INTEGRITY:
+            return NRF_ERROR_INVALID_DATA;
+
+        default:
+            return NRF_ERROR_INTERNAL;
+    }
+}
+
+
+/**@brief Send one native frame and get the answer data and status.
+ *
+ * @param[out]    p_rapdu  Answer, RAPDU_SIZE bytes. Only the data is left in it.
+ * @param[out]    p_len    Length of the answer data.
+ */
+static ret_code_t frame_exchange(uint8_t         ins,
+                                 uint8_t const * p_data,
+                                 uint8_t         len,
+                                 uint8_t       * p_rapdu,
+                                 uint16_t      * p_len)
+{
+    uint8_t    capdu[FRAME_DATA_MAX + APDU_OVERHEAD];
+    uint16_t   capdu_len = 0;
+    uint16_t   rapdu_len = RAPDU_SIZE;
+    ret_code_t err_code;
+
+    capdu[capdu_len++] = CLA_NATIVE;
+    capdu[capdu_len++] = ins;
+    capdu[capdu_len++] = 0;
+    capdu[capdu_len++] = 0;
+    if (len != 0)
+    {
+        capdu[capdu_len++] = len;
+        memcpy(&capdu[capdu_len], p_data, len);
+        capdu_len += len;
+    }
+    capdu[capdu_len++] = 0;
+
+    err_code = pn532_isodep_transceive(capdu, capdu_len, p_rapdu, &rapdu_len);
+    if (err_code != NRF_SUCCESS)
+    {
+        session_end();
+        return err_code;
+    }
+    if ((rapdu_len < 2) || (p_rapdu[rapdu_len - 2] != SW1_NATIVE))
+    {
+        // An ISO status: the card did not take the native command.
+        session_end();
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    m_session.status = p_rapdu[rapdu_len - 1];
+    (*p_len)         = rapdu_len - 2;
+    if ((m_session.status != STATUS_OK) && (m_session.status != STATUS_MORE))
+    {
+        session_end();
+        return status_decode(m_session.status);
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+/**@brief Copy up to @p len bytes of the payload from @p offset, return the number copied. */
+static uint32_t payload_copy(desfire_payload_t const * p_payload,
+                             uint32_t                  offset,
+                             uint8_t                 * p_dst,
+                             uint32_t                  len)
+{
+    uint32_t copied = 0;
+
+    for (uint32_t i = 0; (i < ARRAY_SIZE(p_payload->p_part)) && (copied < len); i++)
+    {
+        if (offset >= p_payload->len[i])
+        {
+            offset -= p_payload->len[i];
+            continue;
+        }
+
+        const uint32_t chunk = MIN(p_payload->len[i] - offset, len - copied);
+
+        memcpy(&p_dst[copied], &p_payload->p_part[i][offset], chunk);
+        copied += chunk;
+        offset  = 0;
+    }
+
+    return copied;
+}
+
+
+static bool cmac_equal(uint8_t const * p_a, uint8_t const * p_b)
+{
+    uint8_t diff = 0;
+
+    for (uint32_t i = 0; i < CMAC_LEN; i++)
+    {
+        diff |= (uint8_t)(p_a[i] ^ p_b[i]);
+    }
+    return (diff == 0);
+}
+
+
+/**@brief Run a native command with the secure messaging of the session.
+ *
+ * @details The command CMAC covers the command byte, parameters and data; with @p mac_data its
+ *          first bytes are also sent behind the data. The response CMAC covers the data of all
+ *          answer frames and the final status and is checked as the frames come in.
+ *
+ * @param[in]  cmd       Command byte.
+ * @param[in]  p_hdr     Parameters (file number, offset, ...).
+ * @param[in]  hdr_len   Length of the parameters.
+ * @param[in]  p_data    Data of the command.
+ * @param[in]  data_len  Length of the data.
+ * @param[in]  mac_data  Send the CMAC with the data (MACed communication mode).
+ * @param[out] p_resp    Receives exactly @p resp_len bytes of answer data.
+ * @param[in]  resp_len  Expected length of the answer data.
+ */
+static ret_code_t command(uint8_t         cmd,
+                          uint8_t const * p_hdr,
+                          uint8_t         hdr_len,
+                          uint8_t const * p_data,
+                          uint32_t        data_len,
+                          bool            mac_data,
+                          uint8_t       * p_resp,
+                          uint32_t        resp_len)
+{
+    nrf_crypto_aes_cmac_ctx_t cmac;
+    desfire_payload_t         payload;
+    uint8_t                   mac[BLOCK_LEN];
+    uint8_t                   frame[FRAME_DATA_MAX];
+    uint8_t                   rapdu[RAPDU_SIZE];
+    uint16_t                  rlen;
+    uint32_t                  sent     = 0;
+    uint32_t                  received = 0;
+    uint8_t                   ins      = cmd;
+    ret_code_t                err_code;
+
+    const bool session = m_session.authenticated;
+
+    if (mac_data && !session)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if (session)
+    {
+        nrf_crypto_aes_cmac_init(&cmac, m_session.key, m_session.iv);
+        err_code = nrf_crypto_aes_cmac_update(&cmac, &cmd, 1);
+        VERIFY_SUCCESS(err_code);
+        err_code = nrf_crypto_aes_cmac_update(&cmac, p_hdr, hdr_len);
+        VERIFY_SUCCESS(err_code);
+        err_code = nrf_crypto_aes_cmac_update(&cmac, p_data, data_len);
+        VERIFY_SUCCESS(err_code);
+        err_code = nrf_crypto_aes_cmac_finish(&cmac, m_session.iv);
+        VERIFY_SUCCESS(err_code);
+    }
+
+    payload.p_part[0] = p_hdr;
+    payload.len[0]    = hdr_len;
+    payload.p_part[1] = p_data;
+    payload.len[1]    = data_len;
+    payload.p_part[2] = m_session.iv;
+    payload.len[2]    = mac_data ? CMAC_LEN : 0;
+
+    const uint32_t payload_len = hdr_len + data_len + payload.len[2];
+
+    // The command, continued in additional frames while the card asks for them.
+    for (;;)
+    {
+        const uint32_t chunk = payload_copy(&payload, sent, frame, FRAME_DATA_MAX);
+
+        sent    += chunk;
+        err_code = frame_exchange(ins, frame, (uint8_t)chunk, rapdu, &rlen);
+        VERIFY_SUCCESS(err_code);
+        if (m_session.status == STATUS_NO_CHANGES)
+        {
+            // Commit or abort with nothing pending; the session has ended with it.
+            return NRF_SUCCESS;
+        }
+        ins = CMD_ADDITIONAL_FRAME;
+
+        if (sent == payload_len)
+        {
+            break;
+        }
+        if ((m_session.status != STATUS_MORE) || (rlen != 0))
+        {
+            session_end();
+            return NRF_ERROR_INVALID_DATA;
+        }
+    }
+
+    if (session)
+    {
+        nrf_crypto_aes_cmac_init(&cmac, m_session.key, m_session.iv);
+    }
+
+    // The answer, fetched with additional frames while the card has more.
+    for (;;)
+    {
+        uint16_t data_len_rx = rlen;
+
+        if (session && (m_session.status == STATUS_OK))
+        {
+            if (data_len_rx < CMAC_LEN)
+            {
+                session_end();
+                return NRF_ERROR_INVALID_DATA;
+            }
+            data_len_rx -= CMAC_LEN;
+        }
+        if (received + data_len_rx > resp_len)
+        {
+            session_end();
+            return NRF_ERROR_INVALID_DATA;
+        }
+
+        memcpy(&p_resp[received], rapdu, data_len_rx);
+        received += data_len_rx;
+        if (session)
+        {
+            err_code = nrf_crypto_aes_cmac_update(&cmac, rapdu, data_len_rx);
+            VERIFY_SUCCESS(err_code);
+        }
+
+        if (m_session.status != STATUS_MORE)
+        {
+            break;
+        }
+        err_code = frame_exchange(CMD_ADDITIONAL_FRAME, NULL, 0, rapdu, &rlen);
+        VERIFY_SUCCESS(err_code);
+    }
+
+    if (session)
+    {
+        err_code = nrf_crypto_aes_cmac_update(&cmac, &m_session.status, 1);
+        VERIFY_SUCCESS(err_code);
+        err_code = nrf_crypto_aes_cmac_finish(&cmac, mac);
+        VERIFY_SUCCESS(err_code);
+        memcpy(m_session.iv, mac, BLOCK_LEN);
+
+        if (!cmac_equal(mac, &rapdu[rlen - CMAC_LEN]))
+        {
+            session_end();
+            return NRF_ERROR_INVALID_DATA;
+        }
+    }
+
+    return (received == resp_len) ? NRF_SUCCESS : NRF_ERROR_INVALID_DATA;
+}
+
+
+ret_code_t pn532_desfire_select_application(uint8_t const * p_aid)
+{
+    uint8_t  rapdu[RAPDU_SIZE];
+    uint16_t rlen;
+
+    // Selecting ends the authentication, the answer carries no CMAC.
+    session_end();
+
+    return frame_exchange(CMD_SELECT_APPLICATION, p_aid, PN532_DESFIRE_AID_LEN, rapdu, &rlen);
+}
+
+
+/**@brief Rotate a block left by one byte. */
+static void rotate_left(uint8_t * p_dst, uint8_t const * p_src)
+{
+    memcpy(p_dst, &p_src[1], BLOCK_LEN - 1);
+    p_dst[BLOCK_LEN - 1] = p_src[0];
+}
+
+
+/**@brief CBC step: @p p_block = E(@p p_block xor @p p_iv). */
+static ret_code_t cbc_encrypt(uint8_t const * p_key, uint8_t * p_block, uint8_t const * p_iv)
+{
+    for (uint32_t i = 0; i < BLOCK_LEN; i++)
+    {
+        p_block[i] ^= p_iv[i];
+    }
+    return nrf_crypto_aes_ecb_encrypt(p_key, p_block, p_block);
+}
+
+
+ret_code_t pn532_desfire_authenticate_aes(uint8_t key_no, uint8_t const * p_key)
+{
+    uint8_t    rapdu[RAPDU_SIZE];
+    uint8_t    rnd_a[BLOCK_LEN];
+    uint8_t    rnd_b[BLOCK_LEN];
+    uint8_t    token[2 * BLOCK_LEN];
+    uint8_t    expected[BLOCK_LEN];
+    uint16_t   rlen;
+    ret_code_t err_code;
+
+    session_end();
+
+    // Draw RndA while the card is not waiting yet.
+    rand_pool_get(rnd_a, BLOCK_LEN);
+
+    err_code = frame_exchange(CMD_AUTHENTICATE_AES, &key_no, 1, rapdu, &rlen);
+    VERIFY_SUCCESS(err_code);
+    if ((m_session.status != STATUS_MORE) || (rlen != BLOCK_LEN))
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    // RndB under a zero IV; its ciphertext is the IV of what follows.
+    err_code = nrf_crypto_aes_ecb_decrypt(p_key, rapdu, rnd_b);
+    VERIFY_SUCCESS(err_code);
+
+    memcpy(token, rnd_a, BLOCK_LEN);
+    err_code = cbc_encrypt(p_key, token, rapdu);
+    VERIFY_SUCCESS(err_code);
+    rotate_left(&token[BLOCK_LEN], rnd_b);
+    err_code = cbc_encrypt(p_key, &token[BLOCK_LEN], token);
+    VERIFY_SUCCESS(err_code);
+
+    // The card answers E(RndA rotated xor last token block); encrypting ours saves a decryption.
+    rotate_left(expected, rnd_a);
+    err_code = cbc_encrypt(p_key, expected, &token[BLOCK_LEN]);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = frame_exchange(CMD_ADDITIONAL_FRAME, token, sizeof(token), rapdu, &rlen);
+    VERIFY_SUCCESS(err_code);
+    if ((m_session.status != STATUS_OK) || (rlen != BLOCK_LEN))
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+    if (memcmp(rapdu, expected, BLOCK_LEN) != 0)
+    {
+        return NRF_ERROR_FORBIDDEN;
+    }
+
+    memcpy(&m_session.key[0],  &rnd_a[0],  4);
+    memcpy(&m_session.key[4],  &rnd_b[0],  4);
+    memcpy(&m_session.key[8],  &rnd_a[12], 4);
+    memcpy(&m_session.key[12], &rnd_b[12], 4);
+    memset(m_session.iv, 0, sizeof(m_session.iv));
+    m_session.authenticated = true;
+
+    return NRF_SUCCESS;
+}
+
+
+#if NRF_MODULE_ENABLED(PN532_SAM)
+/**@brief One SAM command with the answer data left in @p p_rapdu.
+ *
+ * @param[in] sw  Status word the step ends with.
+ */
+static ret_code_t sam_command(uint8_t         ins,
+                              uint8_t         p1,
+                              uint8_t const * p_data,
+                              uint8_t         len,
+                              bool            le,
+                              uint16_t        sw,
+                              uint8_t       * p_rapdu,
+                              uint16_t      * p_len)
+{
+    uint8_t    capdu[5 + 2 + BLOCK_LEN + SAM_DIV_MAX + 1];
+    uint16_t   capdu_len = 0;
+    uint16_t   rapdu_len = RAPDU_SIZE;
+    uint16_t   got;
+    ret_code_t err_code;
+
+    capdu[capdu_len++] = PN532_SAM_CLA;
+    capdu[capdu_len++] = ins;
+    capdu[capdu_len++] = p1;
+    capdu[capdu_len++] = 0;
+    if (len != 0)
+    {
+        capdu[capdu_len++] = len;
+        memcpy(&capdu[capdu_len], p_data, len);
+        capdu_len += len;
+    }
+    if (le)
+    {
+        capdu[capdu_len++] = 0;
+    }
+
+    err_code = pn532_sam_apdu(capdu, capdu_len, p_rapdu, &rapdu_len);
+    VERIFY_SUCCESS(err_code);
+
+    got = pn532_sam_sw(p_rapdu, rapdu_len);
+    if (got != sw)
+    {
+        // 0x901E: the card's answer did not check out against the key of the SAM.
+        return (got == 0x901E) ? NRF_ERROR_FORBIDDEN : NRF_ERROR_INVALID_DATA;
+    }
+    (*p_len) = rapdu_len - 2;
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t pn532_desfire_authenticate_sam(uint8_t         key_no,
+                                          uint8_t         sam_key_no,
+                                          uint8_t         sam_key_v,
+                                          uint8_t const * p_div,
+                                          uint8_t         div_len)
+{
+    uint8_t    rapdu[RAPDU_SIZE];
+    uint8_t    data[2 + BLOCK_LEN + SAM_DIV_MAX];
+    uint16_t   rlen;
+    ret_code_t err_code;
+
+    if (div_len > SAM_DIV_MAX)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    session_end();
+
+    err_code = frame_exchange(CMD_AUTHENTICATE_AES, &key_no, 1, rapdu, &rlen);
+    VERIFY_SUCCESS(err_code);
+    if ((m_session.status != STATUS_MORE) || (rlen != BLOCK_LEN))
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    // Part one: E(RndB) from the card, E(RndA || RndB') for it.
+    data[0] = sam_key_no;
+    data[1] = sam_key_v;
+    memcpy(&data[2], rapdu, BLOCK_LEN);
+    if (div_len != 0)
+    {
+        memcpy(&data[2 + BLOCK_LEN], p_div, div_len);
+    }
+    err_code = sam_command(SAM_INS_AUTH_PICC, (div_len != 0) ? SAM_AUTH_DIV : 0,
+                           data, (uint8_t)(2 + BLOCK_LEN + div_len), true,
+                           PN532_SAM_SW_MORE, rapdu, &rlen);
+    VERIFY_SUCCESS(err_code);
+    if (rlen != 2 * BLOCK_LEN)
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    err_code = frame_exchange(CMD_ADDITIONAL_FRAME, rapdu, 2 * BLOCK_LEN, rapdu, &rlen);
+    VERIFY_SUCCESS(err_code);
+    if ((m_session.status != STATUS_OK) || (rlen != BLOCK_LEN))
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    // Part two: the SAM checks E(RndA') of the card.
+    memcpy(data, rapdu, BLOCK_LEN);
+    err_code = sam_command(SAM_INS_AUTH_PICC, 0, data, BLOCK_LEN, false,
+                           PN532_SAM_SW_OK, rapdu, &rlen);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = sam_command(SAM_INS_DUMP_KEY, 0, NULL, 0, true, PN532_SAM_SW_OK, rapdu, &rlen);
+    VERIFY_SUCCESS(err_code);
+    if (rlen < BLOCK_LEN)
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    memcpy(m_session.key, rapdu, BLOCK_LEN);
+    memset(rapdu, 0, sizeof(rapdu));
+    memset(m_session.iv, 0, sizeof(m_session.iv));
+    m_session.authenticated = true;
+
+    return NRF_SUCCESS;
+}
+#endif
+
+
+ret_code_t pn532_desfire_read_data(uint8_t              file_no,
+                                   uint32_t             offset,
+                                   uint32_t             len,
+                                   uint8_t            * p_data,
+                                   pn532_desfire_comm_t comm)
+{
+    uint8_t hdr[7];
+
+    UNUSED_PARAMETER(comm);     // The answer has a CMAC in a session either way.
+    if (len == 0)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    hdr[0] = file_no;
+    UNUSED_RETURN_VALUE(uint24_encode(offset, &hdr[1]));
+    UNUSED_RETURN_VALUE(uint24_encode(len, &hdr[4]));
+
+    return command(CMD_READ_DATA, hdr, sizeof(hdr), NULL, 0, false, p_data, len);
+}
+
+
+ret_code_t pn532_desfire_write_data(uint8_t              file_no,
+                                    uint32_t             offset,
+                                    uint8_t const      * p_data,
+                                    uint32_t             len,
+                                    pn532_desfire_comm_t comm)
+{
+    uint8_t hdr[7];
+
+    if (len == 0)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    hdr[0] = file_no;
+    UNUSED_RETURN_VALUE(uint24_encode(offset, &hdr[1]));
+    UNUSED_RETURN_VALUE(uint24_encode(len, &hdr[4]));
+
+    return command(CMD_WRITE_DATA, hdr, sizeof(hdr), p_data, len,
+                   (comm == PN532_DESFIRE_COMM_MAC), NULL, 0);
+}
+
+
+ret_code_t pn532_desfire_get_value(uint8_t file_no, int32_t * p_value, pn532_desfire_comm_t comm)
+{
+    uint8_t    value[4];
+    ret_code_t err_code;
+
+    UNUSED_PARAMETER(comm);
+    err_code = command(CMD_GET_VALUE, &file_no, 1, NULL, 0, false, value, sizeof(value));
+    VERIFY_SUCCESS(err_code);
+
+    (*p_value) = (int32_t)uint32_decode(value);
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t value_change(uint8_t cmd, uint8_t file_no, int32_t amount, pn532_desfire_comm_t comm)
+{
+    uint8_t value[4];
+
+    UNUSED_RETURN_VALUE(uint32_encode((uint32_t)amount, value));
+    return command(cmd, &file_no, 1, value, sizeof(value), (comm == PN532_DESFIRE_COMM_MAC), NULL, 0);
+}
+
+
+ret_code_t pn532_desfire_credit(uint8_t file_no, int32_t amount, pn532_desfire_comm_t comm)
+{
+    return value_change(CMD_CREDIT, file_no, amount, comm);
+}
+
+
+ret_code_t pn532_desfire_debit(uint8_t file_no, int32_t amount, pn532_desfire_comm_t comm)
+{
+    return value_change(CMD_DEBIT, file_no, amount, comm);
+}
+
+
+ret_code_t pn532_desfire_limited_credit(uint8_t file_no, int32_t amount, pn532_desfire_comm_t comm)
+{
+    return value_change(CMD_LIMITED_CREDIT, file_no, amount, comm);
+}
+
+
+ret_code_t pn532_desfire_commit(void)
+{
+    return command(CMD_COMMIT, NULL, 0, NULL, 0, false, NULL, 0);
+}
+
+
+ret_code_t pn532_desfire_abort(void)
+{
+    return command(CMD_ABORT, NULL, 0, NULL, 0, false, NULL, 0);
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_DESFIRE)
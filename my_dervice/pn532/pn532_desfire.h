@@ -0,0 +1,184 @@
+#ifndef __PN532_DESFIRE_H__
+#define __PN532_DESFIRE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/**@brief MIFARE DESFire EV1/EV2 native commands, wrapped in ISO 7816-4 APDUs over pn532_isodep.
+ *
+ * @details After @ref pn532_desfire_authenticate_aes every command and response is chained
+ *          through the EV1 secure messaging CMAC of the session key: the CMAC of a command is
+ *          computed as it is framed, the CMAC of a response as its frames arrive, so each byte
+ *          passes the ECB peripheral once. Responses whose CMAC does not match end the session.
+ *
+ *          Files and values can be read and written in plain and MACed communication mode.
+ *          Enciphered mode needs the AES inverse cipher on every response, which the ECB
+ *          peripheral does not have; it is not supported.
+ *
+ *          The card must have been selected with readPassiveTargets() and report ISO14443-4
+ *          support. Select a new card with @ref pn532_desfire_reset before using it.
+ */
+
+#define PN532_DESFIRE_AES_KEY_LEN   16    /**< Length of an AES key. */
+#define PN532_DESFIRE_AID_LEN       3     /**< Length of an application identifier. */
+
+/**@brief Communication mode of a file, as in its access settings. */
+typedef enum
+{
+    PN532_DESFIRE_COMM_PLAIN = 0x00,    /**< Data is sent as is. */
+    PN532_DESFIRE_COMM_MAC   = 0x01,    /**< Data is sent with an 8-byte CMAC. */
+} pn532_desfire_comm_t;
+
+/**@brief Forget the session, for a new card or after the field was lost. */
+void pn532_desfire_reset(void);
+
+/**@brief Select an application, ending any authentication.
+ *
+ * @param[in] p_aid  Application identifier, PN532_DESFIRE_AID_LEN bytes, least significant byte
+ *                   first as on the card. All zero for the PICC level.
+ *
+ * @retval NRF_SUCCESS          Selected.
+ * @retval NRF_ERROR_NOT_FOUND  The card has no such application.
+ * @return Otherwise as for @ref pn532_desfire_status.
+ */
+ret_code_t pn532_desfire_select_application(uint8_t const * p_aid);
+
+/**@brief Authenticate with an AES key of the selected application (EV1 AuthenticateAES, 0xAA).
+ *
+ * @details Takes two exchanges. The card's challenge is the one block that is decrypted in
+ *          software; the card's answer is checked by encrypting the expected value.
+ *
+ * @param[in] key_no  Key number.
+ * @param[in] p_key   Key, PN532_DESFIRE_AES_KEY_LEN bytes.
+ *
+ * @retval NRF_SUCCESS          Authenticated, the session starts.
+ * @retval NRF_ERROR_FORBIDDEN  Wrong key, or the card answered with another RndA.
+ * @return Otherwise as for @ref pn532_desfire_status.
+ */
+ret_code_t pn532_desfire_authenticate_aes(uint8_t key_no, uint8_t const * p_key);
+
+/**@brief Authenticate with an AES key held by the SAM, see pn532_sam.h.
+ *
+ * @details The card's challenge goes to SAM_AuthenticatePICC and its answer back to the SAM;
+ *          the session key is then dumped from the SAM, so the session runs as after
+ *          @ref pn532_desfire_authenticate_aes. Needs PN532_SAM.
+ *
+ * @param[in] key_no      Key number on the card.
+ * @param[in] sam_key_no  Key entry of the SAM.
+ * @param[in] sam_key_v   Version of the key in the entry.
+ * @param[in] p_div       Diversification input, as for mfc_kdf; NULL for none.
+ * @param[in] div_len     Up to 31 bytes.
+ *
+ * @retval NRF_SUCCESS              Authenticated, the session starts.
+ * @retval NRF_ERROR_FORBIDDEN      The SAM refused the card's answer: wrong key.
+ * @retval NRF_ERROR_INVALID_DATA   The SAM refused a step or the dump, with another status word.
+ * @retval NRF_ERROR_INVALID_LENGTH Diversification input too long.
+ * @return Otherwise as for pn532_sam_apdu() and @ref pn532_desfire_status.
+ */
+ret_code_t pn532_desfire_authenticate_sam(uint8_t         key_no,
+                                          uint8_t         sam_key_no,
+                                          uint8_t         sam_key_v,
+                                          uint8_t const * p_div,
+                                          uint8_t         div_len);
+
+/**@brief Read from a standard or backup data file (ReadData, 0xBD).
+ *
+ * @param[in]  file_no  File number.
+ * @param[in]  offset   First byte to read.
+ * @param[in]  len      Bytes to read, not 0.
+ * @param[out] p_data   Receives @p len bytes.
+ * @param[in]  comm     Communication mode of the file.
+ *
+ * @retval NRF_SUCCESS             Read, and the CMAC of a session matched.
+ * @retval NRF_ERROR_INVALID_DATA  The card sent other than @p len bytes, or a wrong CMAC.
+ * @return Otherwise as for @ref pn532_desfire_status.
+ */
+ret_code_t pn532_desfire_read_data(uint8_t              file_no,
+                                   uint32_t             offset,
+                                   uint32_t             len,
+                                   uint8_t            * p_data,
+                                   pn532_desfire_comm_t comm);
+
+/**@brief Write to a standard or backup data file (WriteData, 0x3D).
+ *
+ * @details A backup file keeps the old data until @ref pn532_desfire_commit.
+ *
+ * @param[in] file_no  File number.
+ * @param[in] offset   First byte to write.
+ * @param[in] p_data   Data.
+ * @param[in] len      Bytes to write, not 0.
+ * @param[in] comm     Communication mode of the file.
+ *
+ * @return As for @ref pn532_desfire_status.
+ */
+ret_code_t pn532_desfire_write_data(uint8_t              file_no,
+                                    uint32_t             offset,
+                                    uint8_t const      * p_data,
+                                    uint32_t             len,
+                                    pn532_desfire_comm_t comm);
+
+/**@brief Read a value file (GetValue, 0x6C).
+ *
+ * @param[in]  file_no  File number.
+ * @param[out] p_value  Value.
+ * @param[in]  comm     Communication mode of the file.
+ *
+ * @return As for @ref pn532_desfire_read_data.
+ */
+ret_code_t pn532_desfire_get_value(uint8_t file_no, int32_t * p_value, pn532_desfire_comm_t comm);
+
+/**@brief Add to a value file (Credit, 0x0C). Takes effect with @ref pn532_desfire_commit.
+ *
+ * @param[in] file_no  File number.
+ * @param[in] amount   Positive amount.
+ * @param[in] comm     Communication mode of the file.
+ *
+ * @return As for @ref pn532_desfire_status.
+ */
+ret_code_t pn532_desfire_credit(uint8_t file_no, int32_t amount, pn532_desfire_comm_t comm);
+
+/**@brief Subtract from a value file (Debit, 0xDC). Takes effect with @ref pn532_desfire_commit.
+ *
+ * @return As for @ref pn532_desfire_credit.
+ */
+ret_code_t pn532_desfire_debit(uint8_t file_no, int32_t amount, pn532_desfire_comm_t comm);
+
+/**@brief Add at most the last debits to a value file (LimitedCredit, 0x1C).
+ *
+ * @return As for @ref pn532_desfire_credit.
+ */
+ret_code_t pn532_desfire_limited_credit(uint8_t file_no, int32_t amount, pn532_desfire_comm_t comm);
+
+/**@brief Make the changes to backup and value files since the last commit valid (0xC7).
+ *
+ * @return As for @ref pn532_desfire_status.
+ */
+ret_code_t pn532_desfire_commit(void);
+
+/**@brief Drop the changes to backup and value files since the last commit (0xA7).
+ *
+ * @return As for @ref pn532_desfire_status.
+ */
+ret_code_t pn532_desfire_abort(void);
+
+/**@brief Status byte of the last answer from the card.
+ *
+ * @details Errors of the card map to:
+ *          - NRF_ERROR_NOT_FOUND for an unknown application or file (0xA0, 0xF0),
+ *          - NRF_ERROR_FORBIDDEN for a failed authentication or missing rights (0xAE, 0x9D),
+ *          - NRF_ERROR_INVALID_PARAM for an offset or length past the file or a value past its
+ *            limits (0xBE, 0x7E, 0x9E),
+ *          - NRF_ERROR_INVALID_DATA for an integrity error (0x1E),
+ *          - NRF_ERROR_INTERNAL for the others.
+ *          The card ends the authentication on an error, so does this module.
+ *          Errors of the transport are those of @ref pn532_isodep_transceive.
+ *
+ * @return Status byte, 0x00 for success.
+ */
+uint8_t pn532_desfire_status(void);
+
+/**@brief Whether an authenticated session is running. */
+bool pn532_desfire_authenticated(void);
+
+#endif
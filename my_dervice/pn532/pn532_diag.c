@@ -0,0 +1,150 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_DIAG)
+#include "pn532_diag.h"
+#include "pn532_i2c.h"
+#include "app_timer.h"
+#include "radio_gap.h"
+#include "lat_trace.h"
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+#include "pn532_async.h"
+#endif
+#if NRF_MODULE_ENABLED(PN532_DUTY)
+#include "pn532_duty.h"
+#elif NRF_MODULE_ENABLED(PN532_SCAN)
+#include "pn532_scan.h"
+#endif
+
+// app_timer counts 24 bits of RTC1: the period is kept in minutes, one timer event each.
+#define MINUTE_TICKS   APP_TIMER_TICKS(60000, APP_TIMER_CONFIG_PRESCALER)
+
+APP_TIMER_DEF(m_minute_timer);
+
+static pn532_diag_result_t m_result = {.flags = PN532_DIAG_NOT_RUN};
+static uint16_t            m_minutes;
+
+
+static void run_handler(void * p_event_data, uint16_t event_size)
+{
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    // A busy reader is tested at the next minute instead.
+    if (pn532_diag_run() == NRF_ERROR_BUSY)
+    {
+        m_minutes = PN532_DIAG_PERIOD_MIN - 1;
+    }
+}
+
+
+static void minute_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    if (++m_minutes >= PN532_DIAG_PERIOD_MIN)
+    {
+        m_minutes = 0;
+        UNUSED_RETURN_VALUE(radio_gap_run(RADIO_GAP_PN532, run_handler));
+    }
+}
+
+
+static uint16_t count(uint16_t value)
+{
+    return (value < UINT16_MAX) ? (value + 1) : value;
+}
+
+
+ret_code_t pn532_diag_init(void)
+{
+    return app_timer_create(&m_minute_timer, APP_TIMER_MODE_REPEATED, minute_timer_handler);
+}
+
+
+ret_code_t pn532_diag_start(void)
+{
+    m_minutes = 0;
+    return app_timer_start(m_minute_timer, MINUTE_TICKS, NULL);
+}
+
+
+ret_code_t pn532_diag_run(void)
+{
+    pn532_general_status_t status;
+    uint8_t                flags = 0;
+
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+    if (pn532_cmd_busy())
+    {
+        return NRF_ERROR_BUSY;
+    }
+#endif
+#if NRF_MODULE_ENABLED(PN532_DUTY)
+    // Awake until the end of the next burst; the bursts and the tests both run from the main loop.
+    if (pn532_duty_is_active())
+    {
+        pn532_duty_wake();
+    }
+#elif NRF_MODULE_ENABLED(PN532_SCAN)
+    if (pn532_scan_is_active())
+    {
+        return NRF_ERROR_BUSY;
+    }
+#endif
+
+    LAT_TRACE_START(t);
+    if (!pn532_diag_line())
+    {
+        flags |= PN532_DIAG_LINE_FAIL;
+    }
+    m_result.antenna_status = pn532_diag_antenna(PN532_DIAG_ANTENNA_THRESHOLD);
+    if (m_result.antenna_status != 0)
+    {
+        flags |= PN532_DIAG_ANTENNA_FAIL;
+    }
+    if (!getGeneralStatus(&status))
+    {
+        flags |= PN532_DIAG_NO_ANSWER;
+    }
+    else
+    {
+        m_result.last_err = status.err;
+        if (status.field != 0)
+        {
+            flags |= PN532_DIAG_EXT_FIELD;
+        }
+    }
+    LAT_TRACE_STOP(LAT_STAGE_DIAG, t);
+
+    // The antenna test drives the field itself; the next card command sets the RF up again.
+    pn532_rf_mode_invalidate();
+
+    m_result.flags = flags;
+    m_result.runs  = count(m_result.runs);
+    if (flags & PN532_DIAG_LINE_FAIL)
+    {
+        m_result.line_fails = count(m_result.line_fails);
+    }
+    if (flags & PN532_DIAG_ANTENNA_FAIL)
+    {
+        m_result.antenna_fails = count(m_result.antenna_fails);
+    }
+    if (flags & PN532_DIAG_EXT_FIELD)
+    {
+        m_result.ext_fields = count(m_result.ext_fields);
+    }
+    return NRF_SUCCESS;
+}
+
+
+void pn532_diag_result_get(pn532_diag_result_t * p_result)
+{
+    *p_result = m_result;
+}
+
+
+uint8_t pn532_diag_flags(void)
+{
+    return m_result.flags;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_DIAG)
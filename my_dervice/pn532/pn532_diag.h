@@ -0,0 +1,63 @@
+#ifndef __PN532_DIAG_H__
+#define __PN532_DIAG_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* Periodic self test of the PN532, every PN532_DIAG_PERIOD_MIN minutes from the main loop while the
+ * reader is idle:
+ *
+ *   line      Diagnose 0x00, a pattern echoed back: the bus and the chip answer
+ *   antenna   Diagnose 0x07 with PN532_DIAG_ANTENNA_THRESHOLD: the driver current is in range,
+ *             so the antenna is neither open, shorted nor badly detuned
+ *   field     GetGeneralStatus: an external field, another reader or a phone close by, that
+ *             can garble the frames of the cards
+ *
+ * A test costs a few milliseconds of bus time and one short field pulse. The flags of the last
+ * run go into the reader TLM frame, the time of a run into the "diag" stage of lat_trace, and
+ * the failures are counted since boot. A reader that starts to fail the antenna test shows it
+ * there before its slower reads and retries are noticed at the door. */
+
+#define PN532_DIAG_LINE_FAIL     0x01  /**< The echo did not come back unchanged. */
+#define PN532_DIAG_ANTENNA_FAIL  0x02  /**< The antenna current is out of range. */
+#define PN532_DIAG_EXT_FIELD     0x04  /**< An external field was present. */
+#define PN532_DIAG_NO_ANSWER     0x08  /**< The chip did not answer GetGeneralStatus. */
+#define PN532_DIAG_NOT_RUN       0x80  /**< No run since boot. */
+
+/**@brief Results of the runs since boot. */
+typedef struct
+{
+    uint8_t  flags;             /**< PN532_DIAG_* of the last run. */
+    uint8_t  antenna_status;    /**< Status byte of the last antenna test. */
+    uint8_t  last_err;          /**< Err of the last GetGeneralStatus. */
+    uint8_t  rfu;
+    uint16_t runs;
+    uint16_t line_fails;
+    uint16_t antenna_fails;
+    uint16_t ext_fields;
+} pn532_diag_result_t;
+
+/**@brief Create the period timer.
+ *
+ * @note Requires app_timer and app_scheduler.
+ */
+ret_code_t pn532_diag_init(void);
+
+/**@brief Start the periodic runs, once the reader is up. */
+ret_code_t pn532_diag_start(void);
+
+/**@brief Run the tests now. Main loop.
+ *
+ * @retval NRF_SUCCESS     Run; the flags may still show failures.
+ * @retval NRF_ERROR_BUSY  A PN532 command or a scan holds the reader.
+ */
+ret_code_t pn532_diag_run(void);
+
+/**@brief Results so far. */
+void pn532_diag_result_get(pn532_diag_result_t * p_result);
+
+/**@brief Flags of the last run, PN532_DIAG_NOT_RUN before the first. */
+uint8_t pn532_diag_flags(void);
+
+#endif
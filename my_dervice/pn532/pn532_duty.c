@@ -0,0 +1,427 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_DUTY)
+#include "pn532_duty.h"
+#include "pn532_presence.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "lat_trace.h"
+#include "radio_gap.h"
+#if NRF_MODULE_ENABLED(PN532_HCE)
+#include "pn532_hce.h"
+#endif
+#if NRF_MODULE_ENABLED(PN532_SNEP)
+#include "pn532_snep.h"
+#endif
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+#include "pwr_idle.h"
+#if NRF_MODULE_ENABLED(TWI_BUS)
+#include "twi_bus.h"
+#endif
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+#include "pn532_async.h"
+#endif
+#endif
+#if NRF_MODULE_ENABLED(PN532_READER)
+#include "pn532_reader.h"
+#define READERS      PN532_READER_COUNT
+#else
+#define READERS      1
+#endif
+
+#define FAST_TICKS   APP_TIMER_TICKS(PN532_DUTY_FAST_MS, APP_TIMER_CONFIG_PRESCALER)
+#define SLOW_TICKS   APP_TIMER_TICKS(PN532_DUTY_SLOW_MS, APP_TIMER_CONFIG_PRESCALER)
+#define SAVE_TICKS   APP_TIMER_TICKS(PN532_DUTY_SAVE_MS, APP_TIMER_CONFIG_PRESCALER)
+#define IDLE_TICKS   APP_TIMER_TICKS(PN532_DUTY_IDLE_MS, APP_TIMER_CONFIG_PRESCALER)
+#define WAIT_FOREVER 0xFF   /**< MxRtyPassiveActivation default, restored for the card commands. */
+#define WAKE_US      2000   /**< pn532_wake_up() waits for the oscillator of the chip. */
+
+APP_TIMER_DEF(m_burst_timer);
+
+static pn532_duty_handler_t m_handler;
+static bool                 m_active;
+static bool                 m_asleep;
+static bool                 m_recent;     /**< A command used the reader since the last burst. */
+static uint32_t             m_interval;   /**< Ticks to the next burst. */
+static volatile bool        m_hold;
+static bool                 m_save;       /**< Low battery: every interval one step longer. */
+static bool                 m_idle;       /**< Nobody near the reader: back off to IDLE_TICKS. */
+static bool                 m_paused;     /**< No bursts at all until resumed. */
+static bool                 m_rush;       /**< Bursts back to back, the reader kept awake. */
+
+
+/**@brief Point the driver calls at reader @p i; there is only reader 0 without pn532_reader. */
+static void reader_use(uint8_t i)
+{
+#if NRF_MODULE_ENABLED(PN532_READER)
+    pn532_reader_use(i);
+#else
+    UNUSED_PARAMETER(i);
+#endif
+}
+
+
+static uint32_t fast_ticks(void)
+{
+    return m_save ? SLOW_TICKS : FAST_TICKS;
+}
+
+
+static uint32_t slow_ticks(void)
+{
+    if (m_idle)
+    {
+        return MAX(IDLE_TICKS, SAVE_TICKS);
+    }
+    return m_save ? SAVE_TICKS : SLOW_TICKS;
+}
+
+
+static void reader_wake(void)
+{
+    if (m_asleep)
+    {
+        LAT_TRACE_START(t);
+        for (uint8_t i = READERS; i-- != 0; )
+        {
+            reader_use(i);
+            UNUSED_RETURN_VALUE(pn532_wake_up());
+        }
+        LAT_TRACE_STOP(LAT_STAGE_WAKE, t);
+        m_asleep = false;
+    }
+}
+
+
+static void reader_sleep(void)
+{
+#if NRF_MODULE_ENABLED(PN532_PRESENCE)
+    // PowerDown halts the card, it has to go through the anticollision again.
+    pn532_presence_reset();
+#endif
+    for (uint8_t i = READERS; i-- != 0; )
+    {
+        reader_use(i);
+        UNUSED_RETURN_VALUE(pn532_power_down());
+    }
+    m_asleep = true;
+}
+
+
+#if NRF_MODULE_ENABLED(PN532_READER)
+static void reader_found(uint8_t reader, pn532_target_t const * p_target)
+{
+    UNUSED_PARAMETER(reader);
+
+    // pn532_reader_list leaves the reader selected, the handler gets it from pn532_reader_in_use.
+    UNUSED_RETURN_VALUE(setPassiveActivationRetries(WAIT_FOREVER));
+    if (m_active)
+    {
+        m_handler(p_target);
+    }
+}
+#endif
+
+
+static void burst_handler(void * p_event_data, uint16_t event_size)
+{
+#if !NRF_MODULE_ENABLED(PN532_READER)
+    pn532_target_t target;
+#endif
+    uint8_t        found = 0;
+    bool           armed = true;
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    if (!m_active || m_paused)
+    {
+        return;
+    }
+
+    if (m_hold)
+    {
+        // A second field next to the one of the phone would garble both.
+        m_interval = slow_ticks();
+        if (app_timer_start(m_burst_timer, m_interval, NULL) != NRF_SUCCESS)
+        {
+            m_active = false;
+        }
+        return;
+    }
+
+    reader_wake();
+
+    // A limited number of retries lets InListPassiveTarget give up on its own, so the field is
+    // only on for a few ms when no card is there.
+    for (uint8_t i = READERS; i-- != 0; )
+    {
+        reader_use(i);
+        UNUSED_RETURN_VALUE(setPassiveActivationRetries(PN532_DUTY_RETRIES));
+        armed = pn532_rf_mode_set(PN532_RF_MODE_ISO14443A) && armed;
+    }
+#if NRF_MODULE_ENABLED(PN532_READER)
+    // All readers poll at once; the handler is called as the burst ends.
+    if (armed)
+    {
+        found = pn532_reader_list(PN532_DUTY_BURST_MS, reader_found);
+    }
+#else
+    if (armed)
+    {
+        found = readPassiveTargets(PN532_MIFARE_ISO14443A, &target, 1, PN532_DUTY_BURST_MS);
+    }
+#endif
+    for (uint8_t i = READERS; i-- != 0; )
+    {
+        reader_use(i);
+        UNUSED_RETURN_VALUE(setPassiveActivationRetries(WAIT_FOREVER));
+    }
+
+    if (m_rush)
+    {
+        m_interval = APP_TIMER_MIN_TIMEOUT_TICKS;
+    }
+    else if ((found != 0) || m_recent)
+    {
+        m_interval = fast_ticks();
+    }
+    else
+    {
+        m_interval = MIN(2 * m_interval, slow_ticks());
+    }
+    m_recent = false;
+    radio_gap_tap(found != 0);
+
+#if !NRF_MODULE_ENABLED(PN532_READER)
+    if (found != 0)
+    {
+        m_handler(&target);
+    }
+#endif
+
+    // The handler may have stopped the bursts.
+    if (!m_active)
+    {
+        return;
+    }
+
+#if NRF_MODULE_ENABLED(PN532_HCE)
+    // No card: listen for a phone before going back to sleep, with the field off.
+    if ((found == 0) && !m_rush)
+    {
+        reader_use(0);
+        if (pn532_hce_listen(PN532_HCE_LISTEN_MS) != NRF_ERROR_NOT_FOUND)
+        {
+            m_interval = fast_ticks();
+        }
+    }
+#endif
+#if NRF_MODULE_ENABLED(PN532_SNEP)
+    // Then for a phone in peer to peer mode, which the emulated card does not answer.
+    if ((found == 0) && !m_rush)
+    {
+        reader_use(0);
+        if (pn532_snep_poll(NULL, 0) != NRF_ERROR_NOT_FOUND)
+        {
+            m_interval = fast_ticks();
+        }
+    }
+#endif
+
+    // Waking up takes longer than the whole gap between rushed bursts.
+    if (!m_rush)
+    {
+        reader_sleep();
+    }
+    if (app_timer_start(m_burst_timer, m_interval, NULL) != NRF_SUCCESS)
+    {
+        m_active = false;
+    }
+}
+
+
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+/**@brief pwr_idle hook: PowerDown the readers a command left awake, instead of at the next burst. */
+static bool reader_idle(void)
+{
+    if (!m_active || m_asleep || m_rush)
+    {
+        return false;
+    }
+#if NRF_MODULE_ENABLED(TWI_BUS)
+    if (!twi_bus_idle())
+    {
+        return false;
+    }
+#endif
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+    if (pn532_cmd_busy())
+    {
+        return false;
+    }
+#endif
+    reader_sleep();
+    return true;
+}
+
+
+static const pwr_idle_hook_t m_idle_hook =
+{
+    .idle    = reader_idle,
+    .wake_us = WAKE_US * READERS,
+};
+#endif
+
+
+static void burst_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    // The bus transfers block, run the burst from the main loop, after the next radio event.
+    UNUSED_RETURN_VALUE(radio_gap_run(RADIO_GAP_PN532, burst_handler));
+}
+
+
+ret_code_t pn532_duty_init(void)
+{
+    ret_code_t err_code;
+
+    m_active = false;
+    m_asleep = false;
+
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+    err_code = pwr_idle_register(&m_idle_hook);
+    VERIFY_SUCCESS(err_code);
+#endif
+    err_code = app_timer_create(&m_burst_timer, APP_TIMER_MODE_SINGLE_SHOT, burst_timer_handler);
+    return err_code;
+}
+
+
+ret_code_t pn532_duty_start(pn532_duty_handler_t handler)
+{
+    if (handler == NULL)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if (m_active)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    m_handler  = handler;
+    m_interval = fast_ticks();
+    m_recent   = false;
+    m_active   = true;
+
+    // First burst right away, later ones from the timer.
+    if (app_sched_event_put_high(burst_handler) != NRF_SUCCESS)
+    {
+        m_active = false;
+        return NRF_ERROR_NO_MEM;
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+void pn532_duty_stop(void)
+{
+    if (!m_active)
+    {
+        return;
+    }
+    m_active = false;
+    UNUSED_RETURN_VALUE(app_timer_stop(m_burst_timer));
+    reader_wake();
+}
+
+
+void pn532_duty_wake(void)
+{
+    reader_wake();
+    m_recent = true;
+}
+
+
+void pn532_duty_hold(bool hold)
+{
+    m_hold = hold;
+}
+
+
+void pn532_duty_save(bool save)
+{
+    // Taken up by the next burst.
+    m_save = save;
+}
+
+
+void pn532_duty_idle(bool idle)
+{
+    m_idle = idle;
+}
+
+
+void pn532_duty_pause(bool pause)
+{
+    if (pause == m_paused)
+    {
+        return;
+    }
+    m_paused = pause;
+    if (!m_active)
+    {
+        return;
+    }
+
+    // A burst already queued returns at once; the reader sleeps from the end of the last one.
+    UNUSED_RETURN_VALUE(app_timer_stop(m_burst_timer));
+    if (!pause)
+    {
+        m_interval = fast_ticks();
+        if (app_timer_start(m_burst_timer, APP_TIMER_MIN_TIMEOUT_TICKS, NULL) != NRF_SUCCESS)
+        {
+            m_active = false;
+        }
+    }
+}
+
+
+void pn532_duty_rush(bool rush)
+{
+    if (rush == m_rush)
+    {
+        return;
+    }
+    m_rush = rush;
+    if (rush)
+    {
+        pn532_duty_kick();
+    }
+}
+
+
+void pn532_duty_kick(void)
+{
+    if (!m_active || m_hold || m_paused)
+    {
+        return;
+    }
+
+    // A start is ignored while the timer runs, so it is stopped first; both go in order.
+    m_interval = fast_ticks();
+    UNUSED_RETURN_VALUE(app_timer_stop(m_burst_timer));
+    if (app_timer_start(m_burst_timer, APP_TIMER_MIN_TIMEOUT_TICKS, NULL) != NRF_SUCCESS)
+    {
+        m_active = false;
+    }
+}
+
+
+bool pn532_duty_is_active(void)
+{
+    return m_active;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_DUTY)
@@ -0,0 +1,88 @@
+#ifndef __PN532_DUTY_H__
+#define __PN532_DUTY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "pn532_i2c.h"
+
+/**@brief Card handler, called from the main loop with the card found by a burst.
+ *
+ * @details The reader is still awake and the card selected; commands to it may be sent from
+ *          the handler. The reader is powered down after the handler returns.
+ */
+typedef void (*pn532_duty_handler_t)(pn532_target_t const * p_target);
+
+/**@brief Create the burst timer.
+ *
+ * @note Requires app_timer and app_scheduler.
+ */
+ret_code_t pn532_duty_init(void);
+
+/**@brief Start duty-cycled card detection.
+ *
+ * @details The PN532 is kept in PowerDown and woken by app_timer for a short InListPassiveTarget
+ *          burst with a limited number of retries, after which it is put back in PowerDown, so
+ *          the RF field is only on for the burst. The bursts start PN532_DUTY_FAST_MS apart and
+ *          back off to PN532_DUTY_SLOW_MS while no card turns up; a card or a command brings
+ *          them back to the fast interval.
+ *
+ * @retval NRF_SUCCESS              Detection started.
+ * @retval NRF_ERROR_INVALID_PARAM  @p handler is NULL.
+ * @retval NRF_ERROR_INVALID_STATE  Already running.
+ */
+ret_code_t pn532_duty_start(pn532_duty_handler_t handler);
+
+/**@brief Stop the bursts and leave the reader awake. */
+void pn532_duty_stop(void);
+
+/**@brief Wake the reader for a command.
+ *
+ * @details The reader stays awake until the end of the next burst, which starts the fast
+ *          interval again.
+ */
+void pn532_duty_wake(void);
+
+/**@brief Hold the bursts off, e.g. while a phone reads the tag the nRF52 emulates. Any context.
+ *
+ * @details A burst due while held is skipped and the next one comes at the slow interval.
+ */
+void pn532_duty_hold(bool hold);
+
+/**@brief Poll less often, e.g. on a low battery. Main loop.
+ *
+ * @details The bursts come PN532_DUTY_SLOW_MS apart after a card or a command and back off to
+ *          PN532_DUTY_SAVE_MS, from the next burst on.
+ */
+void pn532_duty_save(bool save);
+
+/**@brief Nobody is near the reader: back off to PN532_DUTY_IDLE_MS, from the next burst on.
+ *        Main loop.
+ */
+void pn532_duty_idle(bool idle);
+
+/**@brief No bursts at all until resumed, e.g. while the door stands open. Main loop.
+ *
+ * @details Unlike pn532_duty_hold() the timer does not run meanwhile. On resume the next burst
+ *          comes right away, at the fast interval from there on.
+ */
+void pn532_duty_pause(bool pause);
+
+/**@brief Poll as fast as the reader goes, e.g. while cards are enrolled one after the other.
+ *        Main loop.
+ *
+ * @details The bursts come back to back, the reader stays awake between them and no phone is
+ *          listened for. Held and paused bursts stay so. Ended, the bursts are back at the fast
+ *          interval and back off from there.
+ */
+void pn532_duty_rush(bool rush);
+
+/**@brief Burst right away and go on at the fast interval, e.g. when a hand comes near. Main
+ *        loop. No effect while stopped, held or paused.
+ */
+void pn532_duty_kick(void);
+
+/**@brief Whether duty-cycled detection is running. */
+bool pn532_duty_is_active(void);
+
+#endif
@@ -0,0 +1,192 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_HCE)
+#include "pn532_hce.h"
+#include "pn532_i2c.h"
+#include "nrf_crypto_aes.h"
+#include "rand_pool.h"
+#include "wdt_sup.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(NRF_CRYPTO_AES)
+#error "pn532_hce needs NRF_CRYPTO_AES_ENABLED"
+#endif
+#if !NRF_MODULE_ENABLED(RAND_POOL)
+#error "pn532_hce takes its nonces from RAND_POOL_ENABLED"
+#endif
+
+#define INS_SELECT          0xA4
+#define INS_PRESENT         0x10
+#define CLA_PROPRIETARY     0x80
+#define APDU_HEADER_LEN     5       // CLA INS P1 P2 Lc
+#define APDU_MAX            (APDU_HEADER_LEN + 1 + PN532_HCE_ID_MAX + PN532_HCE_MAC_LEN + 1)
+#define APDUS_MAX           4       // A phone gets this many APDUs per activation
+#define RXBUF_LEN           (1 + PN532_FRAME_OVERHEAD + 2 + APDU_MAX)
+
+#define SW_OK               0x9000
+#define SW_WRONG_LENGTH     0x6700
+#define SW_SECURITY         0x6982
+#define SW_CONDITIONS       0x6985
+#define SW_NOT_FOUND        0x6A82
+#define SW_INS_UNKNOWN      0x6D00
+
+/* Proprietary AID, "F0" then "LOCK" and a version byte. */
+static uint8_t const m_aid[] = {0xF0, 0x4C, 0x4F, 0x43, 0x4B, 0x01};
+
+/* Historical bytes of the ATS: the same name, for readers that look at them. */
+static uint8_t const m_hist[] = {0x4C, 0x4F, 0x43, 0x4B};
+
+static uint8_t const *      mp_key;
+static pn532_hce_handler_t  m_handler;
+static uint8_t              m_challenge[PN532_HCE_CHALLENGE_LEN];
+static bool                 m_challenge_valid;
+
+
+static uint8_t sw_put(uint8_t * p_rapdu, uint8_t len, uint16_t sw)
+{
+    p_rapdu[len++] = (uint8_t)(sw >> 8);
+    p_rapdu[len++] = (uint8_t)sw;
+    return len;
+}
+
+
+/**@brief SELECT by name: a new challenge for our AID. */
+static uint8_t select_run(uint8_t const * p_capdu, uint8_t len, uint8_t * p_rapdu)
+{
+    if ((p_capdu[2] != 0x04) || (len < APDU_HEADER_LEN + sizeof(m_aid)) ||
+        (p_capdu[4] != sizeof(m_aid)) || (memcmp(&p_capdu[5], m_aid, sizeof(m_aid)) != 0))
+    {
+        m_challenge_valid = false;
+        return sw_put(p_rapdu, 0, SW_NOT_FOUND);
+    }
+
+    rand_pool_get(m_challenge, sizeof(m_challenge));
+    m_challenge_valid = true;
+    memcpy(p_rapdu, m_challenge, sizeof(m_challenge));
+    return sw_put(p_rapdu, sizeof(m_challenge), SW_OK);
+}
+
+
+/**@brief Check the MAC of a presented id; the challenge is gone afterwards. */
+static bool mac_check(uint8_t const * p_id, uint8_t id_len, uint8_t const * p_mac)
+{
+    nrf_crypto_aes_cmac_ctx_t ctx;
+    uint8_t                   mac[NRF_CRYPTO_AES_BLOCK_SIZE];
+    uint8_t                   diff = 0;
+    bool                      valid = m_challenge_valid;
+
+    m_challenge_valid = false;
+    nrf_crypto_aes_cmac_init(&ctx, mp_key, NULL);
+    if ((nrf_crypto_aes_cmac_update(&ctx, m_challenge, sizeof(m_challenge)) != NRF_SUCCESS) ||
+        (nrf_crypto_aes_cmac_update(&ctx, &id_len, 1) != NRF_SUCCESS) ||
+        (nrf_crypto_aes_cmac_update(&ctx, p_id, id_len) != NRF_SUCCESS) ||
+        (nrf_crypto_aes_cmac_finish(&ctx, mac) != NRF_SUCCESS))
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < PN532_HCE_MAC_LEN; i++)
+    {
+        diff |= mac[i] ^ p_mac[i];
+    }
+    return valid && (diff == 0);
+}
+
+
+/**@brief PRESENT: id length, id, MAC. */
+static uint8_t present_run(uint8_t const * p_capdu, uint8_t len, uint8_t * p_rapdu, ret_code_t * p_result)
+{
+    uint8_t id_len = (len > APDU_HEADER_LEN) ? p_capdu[5] : 0;
+
+    if ((id_len == 0) || (id_len > PN532_HCE_ID_MAX) ||
+        (p_capdu[4] != 1 + id_len + PN532_HCE_MAC_LEN) ||
+        (len < APDU_HEADER_LEN + p_capdu[4]))
+    {
+        m_challenge_valid = false;
+        return sw_put(p_rapdu, 0, SW_WRONG_LENGTH);
+    }
+    if (!mac_check(&p_capdu[6], id_len, &p_capdu[6 + id_len]))
+    {
+        *p_result = NRF_ERROR_FORBIDDEN;
+        return sw_put(p_rapdu, 0, SW_SECURITY);
+    }
+
+    *p_result = NRF_SUCCESS;
+    return sw_put(p_rapdu, 0, m_handler(&p_capdu[6], id_len) ? SW_OK : SW_CONDITIONS);
+}
+
+
+ret_code_t pn532_hce_init(uint8_t const * p_key, pn532_hce_handler_t handler)
+{
+    if ((p_key == NULL) || (handler == NULL))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    mp_key    = p_key;
+    m_handler = handler;
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t pn532_hce_listen(uint16_t window_ms)
+{
+    uint8_t            rxbuf[RXBUF_LEN];
+    uint8_t            rapdu[PN532_HCE_CHALLENGE_LEN + 2];
+    uint8_t            nfcid1[3];
+    pn532_frame_view_t capdu;
+    ret_code_t         result = NRF_ERROR_NOT_FOUND;
+
+    if (m_handler == NULL)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    // SAMConfiguration, if the reader just woke up; the RF setup it gets is dropped below.
+    if (!pn532_rf_mode_set(PN532_RF_MODE_ISO14443A))
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+    // A new UID per window, so that the lock cannot be followed around by its UID.
+    rand_pool_get(nfcid1, sizeof(nfcid1));
+    m_challenge_valid = false;
+
+    if (tgInitAsTarget(nfcid1, m_hist, sizeof(m_hist), window_ms))
+    {
+        for (uint8_t i = 0; (i < APDUS_MAX) && (result == NRF_ERROR_NOT_FOUND); i++)
+        {
+            uint8_t len;
+
+            if (tgGetData(rxbuf, sizeof(rxbuf), &capdu, PN532_HCE_APDU_MS) != 0)
+            {
+                break;
+            }
+#if NRF_MODULE_ENABLED(WDT_SUP)
+            wdt_sup_beat(WDT_SUP_MAIN);
+#endif
+            if (capdu.len < 4)
+            {
+                len = sw_put(rapdu, 0, SW_WRONG_LENGTH);
+            }
+            else if ((capdu.p_data[0] == 0x00) && (capdu.p_data[1] == INS_SELECT))
+            {
+                len = select_run(capdu.p_data, (uint8_t)capdu.len, rapdu);
+            }
+            else if ((capdu.p_data[0] == CLA_PROPRIETARY) && (capdu.p_data[1] == INS_PRESENT))
+            {
+                len = present_run(capdu.p_data, (uint8_t)capdu.len, rapdu, &result);
+            }
+            else
+            {
+                len = sw_put(rapdu, 0, SW_INS_UNKNOWN);
+            }
+            if (tgSetData(rapdu, len) != 0)
+            {
+                break;
+            }
+        }
+    }
+
+    // tgInitAsTarget left the RF mode unset, the next pn532_rf_mode_set restores the reader flags.
+    m_challenge_valid = false;
+    return result;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_HCE)
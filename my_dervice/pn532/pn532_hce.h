@@ -0,0 +1,54 @@
+#ifndef __PN532_HCE_H__
+#define __PN532_HCE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* Phone credentials over NFC, the PN532 emulating an ISO-DEP card that the phone reads:
+ *
+ *   listen    pn532_hce_listen() puts the reader in target mode (TgInitAsTarget) for a
+ *             window; pn532_duty opens one after each burst that found no card, so the
+ *             field of the lock is off while the phone looks for a card
+ *   select    SELECT by name of PN532_HCE_AID: the lock answers a fresh 8-byte challenge
+ *   present   80 10 00 00 Lc, then the id length, the id (1 to 10 bytes) and the first
+ *             8 bytes of the AES-CMAC over challenge | id length | id under the HCE key.
+ *             The answer is 9000 granted, 6985 denied, 6982 for a wrong MAC or no challenge;
+ *             the challenge is used up either way, so a recorded exchange does not replay
+ *
+ * The phone is done in two APDU exchanges after the activation, without a BLE connection. */
+
+#define PN532_HCE_CHALLENGE_LEN  8
+#define PN532_HCE_MAC_LEN        8
+#define PN532_HCE_ID_MAX         10
+
+/**@brief Called from the main loop with an id whose MAC checked out.
+ *
+ * @return true if the lock grants access to it.
+ */
+typedef bool (*pn532_hce_handler_t)(uint8_t const * p_id, uint8_t len);
+
+/**@brief Set the key and the handler.
+ *
+ * @param[in] p_key    AES-128 key, 16 bytes. Kept by reference, must stay valid.
+ * @param[in] handler  Decides on the ids.
+ *
+ * @retval NRF_SUCCESS              Ready for pn532_hce_listen().
+ * @retval NRF_ERROR_INVALID_PARAM  @p p_key or @p handler is NULL.
+ */
+ret_code_t pn532_hce_init(uint8_t const * p_key, pn532_hce_handler_t handler);
+
+/**@brief Emulate the card for up to @p window_ms, and serve a phone that turns up.
+ *
+ * @details Blocks for the window, and for the exchange with a phone found in it, each APDU
+ *          waited for up to PN532_HCE_APDU_MS. The reader in use must be awake; its RF setup
+ *          is dropped, so that the next pn532_rf_mode_set() restores it. Main loop.
+ *
+ * @retval NRF_SUCCESS              A phone presented an id; the handler was called.
+ * @retval NRF_ERROR_NOT_FOUND      No phone, or it went away before presenting an id.
+ * @retval NRF_ERROR_FORBIDDEN      A phone presented an id with a wrong MAC.
+ * @retval NRF_ERROR_INVALID_STATE  Not initialized.
+ */
+ret_code_t pn532_hce_listen(uint16_t window_ms);
+
+#endif
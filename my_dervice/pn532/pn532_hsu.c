@@ -0,0 +1,296 @@
+#include "sdk_common.h"
+#include "pn532_i2c.h"
+#if (PN532_TRANSPORT == PN532_TRANSPORT_HSU) && !NRF_MODULE_ENABLED(PN532_SIM)
+#include "nrf_drv_uart.h"
+#include "nrf_delay.h"
+#if NRF_MODULE_ENABLED(HF_CLOCK)
+#include "hf_clock.h"
+#endif
+
+#if APP_UART_ENABLED
+#error "The nRF51 has one UART; the PN532 on HSU needs APP_UART (and the console on it) disabled"
+#endif
+
+#define HSU_RX_RING_SIZE     64    /**< Bytes the chip sends before they are read, a power of two. */
+#define HSU_READ_TIMEOUT_MS  30    /**< Longest frame at 115200 baud, with margin. */
+
+static const nrf_drv_uart_t m_uart = NRF_DRV_UART_INSTANCE(0);
+
+/* The chip sends its frames without being clocked, so the UART interrupt collects every byte:
+ * into the pending read, or into the ring until the next read starts. Reads end with the frame,
+ * which is usually shorter than the requested length. */
+static uint8_t              m_rx_byte;
+static uint8_t              m_ring[HSU_RX_RING_SIZE];
+static uint8_t              m_ring_wr;
+static uint8_t              m_ring_rd;
+
+static uint8_t *            mp_rd_buf;          /**< Frame goes to mp_rd_buf[1]. */
+static uint8_t              m_rd_len;           /**< Frame bytes that fit mp_rd_buf. */
+static uint16_t             m_rd_pos;           /**< Frame bytes received, start code included. */
+static uint16_t             m_rd_total;         /**< Frame length, 0 until the header is in. */
+static uint8_t              m_rd_hdr[EXT_HEADER_SEQUENCE_LENGTH];
+static pn532_bus_handler_t  m_rd_handler;
+static volatile bool        m_rd_done = true;
+
+static volatile bool        m_tx_done = true;
+static pn532_bus_handler_t  m_tx_handler;
+
+static uint8_t const m_wakeup[] = {PN532_WAKEUP, PN532_WAKEUP, 0x00, 0x00, 0x00};
+
+
+/**@brief Feed one byte to the pending read. Runs with the UART interrupt masked or inside it. */
+static void rd_byte(uint8_t byte)
+{
+    if (m_rd_pos < 3)
+    {
+        // Hunt for 00 00 FF; extra preamble bytes are skipped.
+        if ((m_rd_pos < 2) ? (byte != PN532_PREAMBLE) : (byte != PN532_STARTCODE2))
+        {
+            if (byte != PN532_PREAMBLE)
+            {
+                m_rd_pos = 0;
+            }
+            return;
+        }
+    }
+
+    if (m_rd_pos < EXT_HEADER_SEQUENCE_LENGTH)
+    {
+        m_rd_hdr[m_rd_pos] = byte;
+    }
+    if (m_rd_pos < m_rd_len)
+    {
+        mp_rd_buf[1 + m_rd_pos] = byte;
+    }
+    m_rd_pos++;
+
+    if ((m_rd_total == 0) && (m_rd_pos == PN532_TFI_OFFSET))
+    {
+        if ((m_rd_hdr[3] == 0x00) && (m_rd_hdr[4] == 0xFF))
+        {
+            m_rd_total = 6;                                           // ACK
+        }
+        else if (!((m_rd_hdr[3] == 0xFF) && (m_rd_hdr[4] == 0xFF)))
+        {
+            m_rd_total = PN532_TFI_OFFSET + m_rd_hdr[3] + CHECKSUM_SEQUENCE_LENGTH;
+        }
+    }
+    else if ((m_rd_total == 0) && (m_rd_pos == EXT_HEADER_SEQUENCE_LENGTH - 1))
+    {
+        m_rd_total = EXT_HEADER_SEQUENCE_LENGTH - 1 +
+                     (((uint16_t)m_rd_hdr[5] << 8) | m_rd_hdr[6]) + CHECKSUM_SEQUENCE_LENGTH;
+    }
+
+    if ((m_rd_total != 0) && (m_rd_pos >= m_rd_total))
+    {
+        pn532_bus_handler_t handler = m_rd_handler;
+
+        m_rd_handler = NULL;
+        m_rd_done    = true;
+        if (handler != NULL)
+        {
+            handler(NRF_SUCCESS);
+        }
+    }
+}
+
+
+/**@brief UART event handler, at APP_IRQ_PRIORITY_HIGH like the other PN532 bus backends. */
+static void uart_evt_handler(nrf_drv_uart_event_t * p_event, void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    switch (p_event->type)
+    {
+        case NRF_DRV_UART_EVT_RX_DONE:
+            if (!m_rd_done)
+            {
+                rd_byte(m_rx_byte);
+            }
+            else if ((uint8_t)(m_ring_wr - m_ring_rd) < HSU_RX_RING_SIZE)
+            {
+                m_ring[m_ring_wr++ & (HSU_RX_RING_SIZE - 1)] = m_rx_byte;
+            }
+            UNUSED_RETURN_VALUE(nrf_drv_uart_rx(&m_uart, &m_rx_byte, 1));
+            break;
+
+        case NRF_DRV_UART_EVT_TX_DONE:
+        {
+            pn532_bus_handler_t handler = m_tx_handler;
+
+            m_tx_handler = NULL;
+            m_tx_done    = true;
+            if (handler != NULL)
+            {
+                handler(NRF_SUCCESS);
+            }
+            break;
+        }
+
+        case NRF_DRV_UART_EVT_ERROR:
+            // Framing or overrun; the frame check of the reader catches the damage.
+            UNUSED_RETURN_VALUE(nrf_drv_uart_rx(&m_uart, &m_rx_byte, 1));
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+static ret_code_t rd_start(uint8_t * p_buf, uint8_t len, pn532_bus_handler_t handler)
+{
+    if (len < 2)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    CRITICAL_REGION_ENTER();
+    mp_rd_buf    = p_buf;
+    m_rd_len     = len - 1;
+    m_rd_pos     = 0;
+    m_rd_total   = 0;
+    m_rd_handler = handler;
+    m_rd_done    = false;
+    p_buf[0]     = PN532_I2C_READY;
+    while (!m_rd_done && (m_ring_rd != m_ring_wr))
+    {
+        rd_byte(m_ring[m_ring_rd++ & (HSU_RX_RING_SIZE - 1)]);
+    }
+    CRITICAL_REGION_EXIT();
+
+    return NRF_SUCCESS;
+}
+
+
+/**@brief Forget a read the chip never answered, so the next command can go out. */
+static void rd_abort(void)
+{
+    CRITICAL_REGION_ENTER();
+    m_rd_handler = NULL;
+    m_rd_done    = true;
+    CRITICAL_REGION_EXIT();
+}
+
+
+static ret_code_t tx_start(uint8_t const * p_data, uint8_t len, pn532_bus_handler_t handler)
+{
+    ret_code_t err_code;
+
+    if (!m_tx_done)
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    // A new command means the answer to the previous one is no longer awaited.
+    rd_abort();
+
+    m_tx_done    = false;
+    m_tx_handler = handler;
+    err_code = nrf_drv_uart_tx(&m_uart, p_data, len);
+    if (err_code != NRF_SUCCESS)
+    {
+        m_tx_handler = NULL;
+        m_tx_done    = true;
+    }
+    return err_code;
+}
+
+
+ret_code_t pn532_bus_init(void)
+{
+    ret_code_t            err_code;
+    nrf_drv_uart_config_t uart_config = NRF_DRV_UART_DEFAULT_CONFIG;
+
+    uart_config.pseltxd            = PN532_CONFIG_TXD;
+    uart_config.pselrxd            = PN532_CONFIG_RXD;
+    uart_config.hwfc               = NRF_UART_HWFC_DISABLED;
+    uart_config.parity             = NRF_UART_PARITY_EXCLUDED;
+    uart_config.baudrate           = PN532_HSU_BAUDRATE;
+    uart_config.interrupt_priority = APP_IRQ_PRIORITY_HIGH;
+
+    err_code = nrf_drv_uart_init(&m_uart, &uart_config, uart_evt_handler);
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+#if NRF_MODULE_ENABLED(HF_CLOCK)
+    // The chip comes out of reset awake.
+    hf_clock_request(HF_CLOCK_USER_PN532);
+#endif
+    nrf_drv_uart_rx_enable(&m_uart);
+    return nrf_drv_uart_rx(&m_uart, &m_rx_byte, 1);
+}
+
+
+ret_code_t pn532_bus_write(uint8_t const * p_data, uint8_t len)
+{
+    ret_code_t err_code;
+
+    // An asynchronous transfer may still own the line.
+    while (!m_tx_done)
+    {
+    }
+    err_code = tx_start(p_data, len, NULL);
+    while ((err_code == NRF_SUCCESS) && !m_tx_done)
+    {
+    }
+    return err_code;
+}
+
+
+ret_code_t pn532_bus_read(uint8_t * p_buf, uint8_t len)
+{
+    uint32_t   waited   = 0;
+    ret_code_t err_code = rd_start(p_buf, len, NULL);
+
+    while ((err_code == NRF_SUCCESS) && !m_rd_done)
+    {
+        if (waited++ == HSU_READ_TIMEOUT_MS * 100)
+        {
+            rd_abort();
+            return NRF_ERROR_TIMEOUT;
+        }
+        nrf_delay_us(10);
+    }
+    return err_code;
+}
+
+
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+ret_code_t pn532_bus_write_async(uint8_t const * p_data, uint8_t len, pn532_bus_handler_t handler)
+{
+    return tx_start(p_data, len, handler);
+}
+
+
+ret_code_t pn532_bus_read_async(uint8_t * p_buf, uint8_t len, pn532_bus_handler_t handler)
+{
+    if (!m_rd_done)
+    {
+        return NRF_ERROR_BUSY;
+    }
+    return rd_start(p_buf, len, handler);
+}
+#endif //NRF_MODULE_ENABLED(PN532_ASYNC)
+
+
+ret_code_t pn532_bus_wake(void)
+{
+#if NRF_MODULE_ENABLED(HF_CLOCK)
+    // Until PowerDown; the preamble itself does not care about the baud rate.
+    hf_clock_request(HF_CLOCK_USER_PN532);
+#endif
+    // A long preamble brings the HSU out of PowerDown (User Manual, 7.2.11).
+    return pn532_bus_write(m_wakeup, sizeof(m_wakeup));
+}
+
+
+void pn532_bus_select(pn532_bus_cfg_t const * p_cfg)
+{
+    // Point to point, one reader only.
+    UNUSED_PARAMETER(p_cfg);
+}
+
+#endif //PN532_TRANSPORT_HSU
@@ -0,0 +1,154 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_ISODEP)
+#include "pn532_isodep.h"
+#include "pn532_i2c.h"
+#include "frame_pool.h"
+#include <string.h>
+
+#define PN532_ERROR_TIMEOUT  0x01  /**< Status error code: the target did not answer. */
+#define TX_CHUNK_MAX         (PN532_PACKET_BUFFER_SIZE - 2)  /**< InDataExchange command and Tg take two bytes. */
+#define RX_OVERHEAD          (1 + PN532_FRAME_OVERHEAD + 2)  /**< TWI status, framing, response code and status. */
+
+STATIC_ASSERT(PN532_ISODEP_MAX_RAPDU_DATA + 2 + RX_OVERHEAD <= PN532_TWI_MAX_READ + 1);
+
+static uint16_t m_fallbacks;
+
+
+static ret_code_t status_decode(uint8_t status)
+{
+    if (status == PN532_STATUS_NO_FRAME)
+    {
+        return NRF_ERROR_TIMEOUT;
+    }
+    switch (status & PN532_STATUS_ERROR_MASK)
+    {
+        case 0:
+            return NRF_SUCCESS;
+
+        case PN532_ERROR_TIMEOUT:
+            return NRF_ERROR_TIMEOUT;
+
+        default:
+            return NRF_ERROR_INVALID_DATA;
+    }
+}
+
+
+/**@brief Exchange one block into p_rx, reading only as much as the expected answer needs. */
+static uint8_t block_exchange(uint8_t const      * p_data,
+                              uint8_t              len,
+                              bool                 more,
+                              uint16_t             rx_expected,
+                              uint8_t            * p_rx,
+                              pn532_frame_view_t * p_view)
+{
+    uint16_t rx_len = MIN(rx_expected + RX_OVERHEAD, PN532_TWI_MAX_READ + 1);
+
+    return inDataExchangeStatus(p_data, len, more, p_rx, rx_len, p_view, PN532_ISODEP_TIMEOUT_MS);
+}
+
+
+static ret_code_t apdu_transceive(uint8_t const * p_capdu,
+                                  uint16_t        capdu_len,
+                                  uint8_t       * p_rapdu,
+                                  uint16_t      * p_rapdu_len,
+                                  uint8_t       * p_rx)
+{
+    pn532_frame_view_t view;
+    uint16_t           sent = 0;
+    uint16_t           received = 0;
+    uint8_t            status;
+    ret_code_t         err_code;
+
+    // C-APDU: every block but the last carries MI and is answered with an empty frame.
+    do
+    {
+        uint8_t chunk = (uint8_t)MIN(capdu_len - sent, TX_CHUNK_MAX);
+        bool    more  = (sent + chunk < capdu_len);
+
+        status = block_exchange(&p_capdu[sent], chunk, more, more ? 0 : *p_rapdu_len, p_rx, &view);
+        err_code = status_decode(status);
+        VERIFY_SUCCESS(err_code);
+
+        sent += chunk;
+    } while (sent < capdu_len);
+
+    // R-APDU: an empty InDataExchange fetches the next part while MI is set.
+    for (;;)
+    {
+        if (received + view.len > *p_rapdu_len)
+        {
+            return NRF_ERROR_NO_MEM;
+        }
+        memcpy(&p_rapdu[received], view.p_data, view.len);
+        received += view.len;
+
+        if ((status & PN532_STATUS_MI) == 0)
+        {
+            break;
+        }
+
+        status = block_exchange(NULL, 0, false, *p_rapdu_len - received, p_rx, &view);
+        err_code = status_decode(status);
+        VERIFY_SUCCESS(err_code);
+    }
+
+    *p_rapdu_len = received;
+    return NRF_SUCCESS;
+}
+
+
+/**@brief Halt the card and activate it again, which brings it back to 106 kbps. */
+static ret_code_t bitrate_fallback(void)
+{
+    uint8_t tg = pn532_reader_current()->tg;
+
+    m_fallbacks++;
+    UNUSED_RETURN_VALUE(inDeselect(tg));
+    return (inSelect(tg) == 0) ? NRF_SUCCESS : NRF_ERROR_TIMEOUT;
+}
+
+
+bool pn532_isodep_bitrate_raise(pn532_target_t const * p_target)
+{
+    return (inPSL(p_target, PN532_ISODEP_MAX_BITRATE) == 1);
+}
+
+
+uint16_t pn532_isodep_fallbacks(void)
+{
+    return m_fallbacks;
+}
+
+
+ret_code_t pn532_isodep_transceive(uint8_t const * p_capdu,
+                                   uint16_t        capdu_len,
+                                   uint8_t       * p_rapdu,
+                                   uint16_t      * p_rapdu_len)
+{
+    // The response frames are only needed until their data is copied to p_rapdu.
+    uint8_t  * p_rx     = frame_pool_alloc();
+    uint16_t   rapdu_max = *p_rapdu_len;
+    ret_code_t err_code;
+
+    if (p_rx == NULL)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+    err_code = apdu_transceive(p_capdu, capdu_len, p_rapdu, p_rapdu_len, p_rx);
+    if (((err_code == NRF_ERROR_TIMEOUT) || (err_code == NRF_ERROR_INVALID_DATA)) &&
+        (pn532_reader_current()->psl_speed != 0))
+    {
+        // The card does not hold the higher bit rate. A C-APDU the answer wrote over is lost.
+        if ((bitrate_fallback() == NRF_SUCCESS) && (p_capdu != p_rapdu))
+        {
+            *p_rapdu_len = rapdu_max;
+            err_code     = apdu_transceive(p_capdu, capdu_len, p_rapdu, p_rapdu_len, p_rx);
+        }
+    }
+    frame_pool_free(p_rx);
+
+    return err_code;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_ISODEP)
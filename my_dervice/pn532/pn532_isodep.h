@@ -0,0 +1,63 @@
+#ifndef __PN532_ISODEP_H__
+#define __PN532_ISODEP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "pn532_i2c.h"
+
+/**@brief Largest R-APDU data field (without SW1 SW2) returned in one PN532 frame.
+ *
+ * @details A response frame has to fit in one TWI read of PN532_TWI_MAX_READ bytes, which leaves
+ *          room for 242 data bytes and the status word. Longer responses are only returned with
+ *          MI chaining past the PN532's own 262-byte limit, so Le should stay at or below this.
+ */
+#define PN532_ISODEP_MAX_RAPDU_DATA  242
+
+/**@brief Exchange one APDU with the selected ISO14443-4 target.
+ *
+ * @details The PN532 does the ISO-DEP work on the RF side: RATS and the FSD/FSC frame sizes are
+ *          negotiated in InListPassiveTarget, and I-block chaining and S(WTX) requests from the
+ *          card are handled inside the chip. This function covers the host side: a C-APDU larger
+ *          than the host frame buffer is sent as chained InDataExchange blocks with MI set in
+ *          the Tg byte, and response parts flagged with MI in the status byte are fetched until
+ *          the R-APDU is complete. The response deadline is PN532_ISODEP_TIMEOUT_MS so that
+ *          cards asking for waiting time extensions are not cut off.
+ *
+ *          The target must have been selected with readPassiveTargets() or
+ *          readPassiveTargetID() and report ISO14443-4 support (SEL_RES bit 5).
+ *          @p p_capdu and @p p_rapdu may point to the same buffer.
+ *
+ * @param[in]     p_capdu      Encoded C-APDU.
+ * @param[in]     capdu_len    C-APDU length.
+ * @param[out]    p_rapdu      Receives the R-APDU including SW1 SW2.
+ * @param[in,out] p_rapdu_len  In: size of @p p_rapdu, also used to size the TWI reads.
+ *                             Out: R-APDU length.
+ *
+ * @retval NRF_SUCCESS             R-APDU received.
+ * @retval NRF_ERROR_TIMEOUT       No answer from the PN532 or the card.
+ * @retval NRF_ERROR_NO_MEM        The R-APDU does not fit in @p p_rapdu, or no frame buffer is free.
+ * @retval NRF_ERROR_INVALID_DATA  The PN532 reported a protocol error.
+ */
+ret_code_t pn532_isodep_transceive(uint8_t const * p_capdu,
+                                   uint16_t        capdu_len,
+                                   uint8_t       * p_rapdu,
+                                   uint16_t      * p_rapdu_len);
+
+/**@brief Raise the bit rate of a target just activated, up to PN532_ISODEP_MAX_BITRATE.
+ *
+ * @details Call right after readPassiveTargets(), before any other command: the PPS is only
+ *          allowed between the ATS and the first block. The rate comes from TA(1) of the ATS.
+ *          If an exchange fails at the higher rate, @ref pn532_isodep_transceive halts the
+ *          card, activates it again at 106 kbps and retries the APDU once. A session the
+ *          card was in ends with that, and an APDU whose buffer the answer shares is not
+ *          retried.
+ *
+ * @return true if the target now runs above 106 kbps.
+ */
+bool pn532_isodep_bitrate_raise(pn532_target_t const * p_target);
+
+/**@brief Exchanges that fell back to 106 kbps since power on. */
+uint16_t pn532_isodep_fallbacks(void);
+
+#endif
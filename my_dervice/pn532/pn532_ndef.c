@@ -0,0 +1,534 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_NDEF)
+#include "pn532_ndef.h"
+#include "pn532_t2t.h"
+#if NRF_MODULE_ENABLED(PN532_T1T)
+#include "pn532_t1t.h"
+#endif
+#if NRF_MODULE_ENABLED(PN532_T4T)
+#include "pn532_t4t.h"
+#include "nfc_ndef_record_parser.h"
+#endif
+#include "nfc_ndef_msg_parser.h"
+
+#define NDEF_TLV_MAX  4  /**< TLV blocks kept per tag: NDEF, lock and memory control, spare. */
+
+#if NFC_NDEF_MSG_TAG_TYPE != 2
+#error "The NDEF writer stores messages in TLVs, set NFC_NDEF_MSG_TAG_TYPE to 2 (no NLEN field)"
+#endif
+
+#define T2T_PAGE_SIZE       4
+#define T2T_CC_PAGE         3
+#define T2T_DATA_PAGE       4       /**< First page of the data area. */
+#define T2T_CC_MAGIC        0xE1
+#define T2T_CC_READ_ONLY    0x0F    /**< Write access nibble of CC byte 3. */
+#define T2T_STATIC_AREA     48      /**< Data bytes covered by the static lock bits. */
+
+#define MFC_NDEF_FIRST_BLOCK  4     /**< Sector 1, the first NDEF sector behind the MAD. */
+#define MFC_NDEF_LAST_BLOCK   62    /**< Last data block of a 1K card. */
+
+#define TLV_HDR_MAX  (TLV_T_LENGTH + TLV_L_LONG_LENGTH)
+
+NFC_TYPE_2_TAG_DESC_DEF(m_t2t, NDEF_TLV_MAX);
+
+static uint8_t m_msg_buf[PN532_NDEF_MAX_MSG_LEN];
+
+/* Message and record descriptors built by ndef_msg_parser, pointing into m_msg_buf. */
+__ALIGN(4) static uint8_t m_desc_buf[NFC_NDEF_PARSER_REQIRED_MEMO_SIZE_CALC(PN532_NDEF_MAX_RECORDS)];
+
+
+/**@brief Fill in the event for a well-known URI or Text record.
+ *
+ * @return true if the record is one of the two and well formed.
+ */
+static bool record_decode(nfc_ndef_record_desc_t const * p_record, pn532_ndef_evt_t * p_evt)
+{
+    nfc_ndef_bin_payload_desc_t const * p_payload = p_record->p_payload_descriptor;
+    uint8_t const                     * p_data    = p_payload->p_payload;
+    uint32_t                            len       = p_payload->payload_length;
+
+    if ((p_record->tnf != TNF_WELL_KNOWN) || (p_record->type_length != 1) || (len == 0))
+    {
+        return false;
+    }
+
+    switch (p_record->p_type[0])
+    {
+        case 'U':
+            p_evt->type           = PN532_NDEF_REC_URI;
+            p_evt->rec.uri.id     = (nfc_uri_id_t)p_data[0];
+            p_evt->rec.uri.p_data = &p_data[1];
+            p_evt->rec.uri.len    = len - 1;
+            return true;
+
+        case 'T':
+        {
+            // Status byte: bit 7 UTF-16, bits 5..0 language code length.
+            uint8_t lang_len = p_data[0] & 0x3F;
+
+            if (1 + lang_len > len)
+            {
+                return false;
+            }
+            p_evt->type                   = PN532_NDEF_REC_TEXT;
+            p_evt->rec.text.utf           = (p_data[0] & 0x80) ? UTF_16 : UTF_8;
+            p_evt->rec.text.p_lang_code   = &p_data[1];
+            p_evt->rec.text.lang_code_len = lang_len;
+            p_evt->rec.text.p_data        = &p_data[1 + lang_len];
+            p_evt->rec.text.data_len      = len - 1 - lang_len;
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+
+ret_code_t pn532_ndef_msg_dispatch(uint8_t *            p_msg,
+                                   uint32_t             len,
+                                   pn532_ndef_handler_t handler,
+                                   void *               p_context)
+{
+    nfc_ndef_msg_desc_t * p_msg_desc = (nfc_ndef_msg_desc_t *)m_desc_buf;
+    uint32_t              desc_len   = sizeof(m_desc_buf);
+    ret_code_t            err_code;
+
+    err_code = ndef_msg_parser(m_desc_buf, &desc_len, p_msg, &len);
+    VERIFY_SUCCESS(err_code);
+
+    for (uint32_t i = 0; i < p_msg_desc->record_count; i++)
+    {
+        pn532_ndef_evt_t evt;
+
+        evt.p_record = p_msg_desc->pp_record[i];
+        evt.index    = (uint8_t)i;
+        if (record_decode(evt.p_record, &evt))
+        {
+            handler(&evt, p_context);
+        }
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+/**@brief Dispatch the first non-empty NDEF Message TLV the tag reader found. */
+static ret_code_t tlv_dispatch(type_2_tag_t const * p_t2t, pn532_ndef_handler_t handler, void * p_context)
+{
+    for (uint16_t i = 0; i < p_t2t->tlv_count; i++)
+    {
+        tlv_block_t * p_tlv = &p_t2t->p_tlv_block_array[i];
+
+        if ((p_tlv->tag == TLV_NDEF_MESSAGE) && (p_tlv->length > 0))
+        {
+            return pn532_ndef_msg_dispatch(p_tlv->p_value, p_tlv->length, handler, p_context);
+        }
+    }
+
+    return NRF_ERROR_NOT_FOUND;
+}
+
+
+ret_code_t pn532_ndef_read(pn532_ndef_handler_t handler, void * p_context)
+{
+    type_2_tag_t * p_t2t = &NFC_TYPE_2_TAG_DESC(m_t2t);
+    ret_code_t     err_code;
+
+    err_code = pn532_t2t_read(p_t2t, m_msg_buf, sizeof(m_msg_buf));
+    VERIFY_SUCCESS(err_code);
+
+    return tlv_dispatch(p_t2t, handler, p_context);
+}
+
+#if NRF_MODULE_ENABLED(PN532_T1T)
+ret_code_t pn532_ndef_read_t1t(pn532_jewel_target_t const * p_target,
+                               pn532_ndef_handler_t         handler,
+                               void *                       p_context)
+{
+    type_2_tag_t * p_t2t = &NFC_TYPE_2_TAG_DESC(m_t2t);
+    ret_code_t     err_code;
+
+    err_code = pn532_t1t_read(p_target, p_t2t, m_msg_buf, sizeof(m_msg_buf));
+    VERIFY_SUCCESS(err_code);
+
+    return tlv_dispatch(p_t2t, handler, p_context);
+}
+#endif
+
+#if NRF_MODULE_ENABLED(PN532_T4T)
+typedef struct
+{
+    pn532_ndef_handler_t handler;
+    void *               p_context;
+    uint16_t             pos;       /**< Start of the first record not reported. */
+    uint8_t              index;
+    bool                 end;       /**< The record with ME has been reported. */
+} t4t_stream_t;
+
+
+/**@brief Report the records the last ReadBinary completed; a record cut off waits for the next. */
+static ret_code_t t4t_chunk_handler(uint8_t const * p_msg, uint16_t have, uint16_t nlen, void * p_context)
+{
+    t4t_stream_t * p_stream = (t4t_stream_t *)p_context;
+
+    while (!p_stream->end && (p_stream->pos < have))
+    {
+        nfc_ndef_bin_payload_desc_t payload;
+        nfc_ndef_record_desc_t      record;
+        nfc_ndef_record_location_t  location;
+        pn532_ndef_evt_t            evt;
+        uint32_t                    len = have - p_stream->pos;
+        ret_code_t                  err_code;
+
+        err_code = ndef_record_parser(&payload, &record, &location, &p_msg[p_stream->pos], &len);
+        if ((err_code == NRF_ERROR_INVALID_LENGTH) && (have < nlen))
+        {
+            return NRF_SUCCESS;
+        }
+        VERIFY_SUCCESS(err_code);
+
+        p_stream->pos += (uint16_t)len;
+        p_stream->end  = ((location & NDEF_LAST_RECORD) != 0);
+
+        evt.p_record = &record;
+        evt.index    = p_stream->index++;
+        if (record_decode(&record, &evt))
+        {
+            p_stream->handler(&evt, p_stream->p_context);
+        }
+    }
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t pn532_ndef_read_t4t(pn532_target_t const * p_target,
+                               pn532_ndef_handler_t   handler,
+                               void *                 p_context)
+{
+    t4t_stream_t stream = {handler, p_context, 0, 0, false};
+    ret_code_t   err_code;
+
+    err_code = pn532_t4t_ndef_read(p_target, m_msg_buf, sizeof(m_msg_buf), t4t_chunk_handler, &stream);
+    VERIFY_SUCCESS(err_code);
+
+    if (stream.index == 0)
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+    return stream.end ? NRF_SUCCESS : NRF_ERROR_INVALID_DATA;
+}
+#endif
+
+
+/**@brief Wrap the message of @p msg_len bytes at m_msg_buf[TLV_HDR_MAX] in an NDEF Message TLV
+ *        and a Terminator TLV.
+ *
+ * @details The message sits behind room for a long length field; a short one is placed right
+ *          in front of it, so the stream starts at m_msg_buf[0] or m_msg_buf[2].
+ */
+static void tlv_wrap(uint32_t msg_len, uint8_t ** pp_stream, uint16_t * p_len)
+{
+    uint8_t * p_stream;
+
+    if (msg_len < TLV_L_FORMAT_FLAG)
+    {
+        p_stream    = &m_msg_buf[TLV_HDR_MAX - TLV_T_LENGTH - TLV_L_SHORT_LENGTH];
+        p_stream[1] = (uint8_t)msg_len;
+    }
+    else
+    {
+        p_stream    = m_msg_buf;
+        p_stream[1] = TLV_L_FORMAT_FLAG;
+        UNUSED_RETURN_VALUE(uint16_big_encode((uint16_t)msg_len, &p_stream[2]));
+    }
+    p_stream[0]                       = TLV_NDEF_MESSAGE;
+    m_msg_buf[TLV_HDR_MAX + msg_len]  = TLV_TERMINATOR;
+
+    *pp_stream = p_stream;
+    *p_len     = (uint16_t)(&m_msg_buf[TLV_HDR_MAX + msg_len + 1] - p_stream);
+}
+
+
+/**@brief Encode @p p_msg as an NDEF Message TLV followed by a Terminator TLV into m_msg_buf. */
+static ret_code_t tlv_encode(nfc_ndef_msg_desc_t const * p_msg, uint8_t ** pp_stream, uint16_t * p_len)
+{
+    uint32_t   msg_len = sizeof(m_msg_buf) - TLV_HDR_MAX - TLV_T_LENGTH;
+    ret_code_t err_code;
+
+    err_code = nfc_ndef_msg_encode(p_msg, &m_msg_buf[TLV_HDR_MAX], &msg_len);
+    VERIFY_SUCCESS(err_code);
+
+    tlv_wrap(msg_len, pp_stream, p_len);
+    return NRF_SUCCESS;
+}
+
+
+/**@brief Copy an encoded message into m_msg_buf as an NDEF Message TLV and a Terminator TLV. */
+static ret_code_t tlv_copy(uint8_t const * p_msg, uint32_t len, uint8_t ** pp_stream, uint16_t * p_len)
+{
+    if (len > sizeof(m_msg_buf) - TLV_HDR_MAX - TLV_T_LENGTH)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+    memcpy(&m_msg_buf[TLV_HDR_MAX], p_msg, len);
+
+    tlv_wrap(len, pp_stream, p_len);
+    return NRF_SUCCESS;
+}
+
+
+/**@brief Skip the NULL, Lock Control and Memory Control TLVs at the start of the data area.
+ *
+ * @return Offset of the first other TLV, where the NDEF Message TLV goes.
+ */
+static uint16_t t2t_tlv_start(uint8_t const * p_area, uint16_t len)
+{
+    uint16_t pos = 0;
+
+    while (pos < len)
+    {
+        if (p_area[pos] == TLV_NULL)
+        {
+            pos++;
+        }
+        else if (((p_area[pos] == TLV_LOCK_CONTROL) || (p_area[pos] == TLV_MEMORY_CONTROL)) &&
+                 (pos + 1 < len))
+        {
+            pos += TLV_T_LENGTH + TLV_L_SHORT_LENGTH + p_area[pos + 1];
+        }
+        else
+        {
+            break;
+        }
+    }
+    return pos;
+}
+
+
+/**@brief Set the lock bits of a Type 2 Tag: CC write access first, since the static lock bits
+ *        also freeze the CC page, then the dynamic and the static lock bytes.
+ *
+ * @details Without a Lock Control TLV the dynamic lock bytes follow the data area, which is
+ *          the NTAG21x layout; tags with only the static area have none.
+ */
+static ret_code_t t2t_lock(uint8_t const * p_hdr, uint16_t data_size)
+{
+    uint8_t page[T2T_PAGE_SIZE];
+
+    memcpy(page, &p_hdr[T2T_CC_PAGE * T2T_PAGE_SIZE], T2T_PAGE_SIZE);
+    page[3] = T2T_CC_READ_ONLY;
+    if (!ntag2xx_WritePage(T2T_CC_PAGE, page))
+    {
+        return NRF_ERROR_TIMEOUT;
+    }
+
+    if (data_size > T2T_STATIC_AREA)
+    {
+        uint8_t dyn_page = T2T_DATA_PAGE + data_size / T2T_PAGE_SIZE;
+
+        if (!mifareultralight_ReadPage(dyn_page, page))
+        {
+            return NRF_ERROR_TIMEOUT;
+        }
+        page[0] = 0xFF;
+        page[1] = 0xFF;
+        page[2] = 0xFF;     // byte 3 is RFUI and keeps its value
+        if (!ntag2xx_WritePage(dyn_page, page))
+        {
+            return NRF_ERROR_TIMEOUT;
+        }
+    }
+
+    memcpy(page, &p_hdr[2 * T2T_PAGE_SIZE], T2T_PAGE_SIZE);
+    page[2] = 0xFF;
+    page[3] = 0xFF;
+    return ntag2xx_WritePage(2, page) ? NRF_SUCCESS : NRF_ERROR_TIMEOUT;
+}
+
+
+/**@brief Write the TLV stream in m_msg_buf to the selected Type 2 Tag. */
+static ret_code_t t2t_stream_write(uint8_t const * p_stream, uint16_t stream_len, bool lock)
+{
+    uint8_t    hdr[16];
+    uint8_t    group[16];
+    uint16_t   data_size;
+    uint16_t   start = 0;
+
+    if (!mifareultralight_ReadPages(0, hdr))
+    {
+        return NRF_ERROR_TIMEOUT;
+    }
+    if ((hdr[T2T_CC_PAGE * T2T_PAGE_SIZE] != T2T_CC_MAGIC) ||
+        ((hdr[T2T_CC_PAGE * T2T_PAGE_SIZE + 3] & 0x0F) != 0))
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    data_size = hdr[T2T_CC_PAGE * T2T_PAGE_SIZE + 2] * 8;
+
+    // Read ahead four pages per READ, write back only the pages the stream changes.
+    for (uint16_t offset = 0; offset < start + stream_len; offset += sizeof(group))
+    {
+        if (!mifareultralight_ReadPages(T2T_DATA_PAGE + offset / T2T_PAGE_SIZE, group))
+        {
+            return NRF_ERROR_TIMEOUT;
+        }
+        if (offset == 0)
+        {
+            start = t2t_tlv_start(group, sizeof(group));
+            if (start + stream_len > data_size)
+            {
+                return NRF_ERROR_NO_MEM;
+            }
+        }
+
+        for (uint8_t page = 0; page < sizeof(group) / T2T_PAGE_SIZE; page++)
+        {
+            uint16_t pos     = offset + page * T2T_PAGE_SIZE;
+            bool     changed = false;
+
+            for (uint8_t i = 0; i < T2T_PAGE_SIZE; i++, pos++)
+            {
+                if ((pos >= start) && (pos < start + stream_len) &&
+                    (group[page * T2T_PAGE_SIZE + i] != p_stream[pos - start]))
+                {
+                    group[page * T2T_PAGE_SIZE + i] = p_stream[pos - start];
+                    changed = true;
+                }
+            }
+            if (changed &&
+                !ntag2xx_WritePage(T2T_DATA_PAGE + (offset + page * T2T_PAGE_SIZE) / T2T_PAGE_SIZE,
+                                   &group[page * T2T_PAGE_SIZE]))
+            {
+                return NRF_ERROR_TIMEOUT;
+            }
+        }
+    }
+
+    return lock ? t2t_lock(hdr, data_size) : NRF_SUCCESS;
+}
+
+
+ret_code_t pn532_ndef_write(nfc_ndef_msg_desc_t const * p_msg, bool lock)
+{
+    uint8_t  * p_stream;
+    uint16_t   stream_len;
+    ret_code_t err_code;
+
+    err_code = tlv_encode(p_msg, &p_stream, &stream_len);
+    VERIFY_SUCCESS(err_code);
+
+    return t2t_stream_write(p_stream, stream_len, lock);
+}
+
+
+ret_code_t pn532_ndef_write_encoded(uint8_t const * p_msg, uint32_t len, bool lock)
+{
+    uint8_t  * p_stream;
+    uint16_t   stream_len;
+    ret_code_t err_code;
+
+    err_code = tlv_copy(p_msg, len, &p_stream, &stream_len);
+    VERIFY_SUCCESS(err_code);
+
+    return t2t_stream_write(p_stream, stream_len, lock);
+}
+
+
+/**@brief Stream position of an MFC data block, counted from block 4 without the trailers. */
+static uint16_t mfc_stream_pos(uint8_t block)
+{
+    return (uint16_t)((block / 4 - 1) * 3 + block % 4) * 16;
+}
+
+
+typedef struct
+{
+    uint8_t const *              p_stream;
+    uint16_t                     len;
+    mifareclassic_auth_handler_t auth;
+    void *                       p_context;
+    uint8_t                      block[16];
+} mfc_write_ctx_t;
+
+
+static uint8_t const * mfc_write_source(uint8_t block, void * context)
+{
+    mfc_write_ctx_t * p_ctx = (mfc_write_ctx_t *)context;
+    uint16_t          pos   = mfc_stream_pos(block);
+    uint16_t          n     = MIN(p_ctx->len - pos, sizeof(p_ctx->block));
+
+    // The tail of the last block is padded with NULL TLVs.
+    memset(p_ctx->block, TLV_NULL, sizeof(p_ctx->block));
+    memcpy(p_ctx->block, &p_ctx->p_stream[pos], n);
+    return p_ctx->block;
+}
+
+
+static uint8_t mfc_write_auth(uint8_t * uid, uint8_t uidLen, uint32_t block, void * context)
+{
+    mfc_write_ctx_t * p_ctx = (mfc_write_ctx_t *)context;
+
+    return p_ctx->auth(uid, uidLen, block, p_ctx->p_context);
+}
+
+
+/**@brief Write the TLV stream in m_msg_buf to the NDEF sectors of the selected MIFARE Classic. */
+static ret_code_t mfc_stream_write(uint8_t * uid, uint8_t uidLen,
+                                   uint8_t const * p_stream, uint16_t stream_len,
+                                   mifareclassic_auth_handler_t auth, void * context)
+{
+    mfc_write_ctx_t ctx;
+    uint8_t         last;
+    uint8_t         blocks;
+
+    if (stream_len > mfc_stream_pos(MFC_NDEF_LAST_BLOCK) + 16)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+    ctx.p_stream  = p_stream;
+    ctx.len       = stream_len;
+    ctx.auth      = auth;
+    ctx.p_context = context;
+
+    blocks = (uint8_t)((ctx.len + 15) / 16);
+    last   = (uint8_t)(MFC_NDEF_FIRST_BLOCK + (blocks - 1) / 3 * 4 + (blocks - 1) % 3);
+
+    if (mifareclassic_WriteRange(uid, uidLen, MFC_NDEF_FIRST_BLOCK, last,
+                                 mfc_write_auth, mfc_write_source, NULL, &ctx) != blocks)
+    {
+        return NRF_ERROR_TIMEOUT;
+    }
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t pn532_ndef_write_classic(uint8_t * uid, uint8_t uidLen, nfc_ndef_msg_desc_t const * p_msg,
+                                    mifareclassic_auth_handler_t auth, void * context)
+{
+    uint8_t  * p_stream;
+    uint16_t   stream_len;
+    ret_code_t err_code;
+
+    err_code = tlv_encode(p_msg, &p_stream, &stream_len);
+    VERIFY_SUCCESS(err_code);
+
+    return mfc_stream_write(uid, uidLen, p_stream, stream_len, auth, context);
+}
+
+
+ret_code_t pn532_ndef_write_classic_encoded(uint8_t * uid, uint8_t uidLen,
+                                            uint8_t const * p_msg, uint32_t len,
+                                            mifareclassic_auth_handler_t auth, void * context)
+{
+    uint8_t  * p_stream;
+    uint16_t   stream_len;
+    ret_code_t err_code;
+
+    err_code = tlv_copy(p_msg, len, &p_stream, &stream_len);
+    VERIFY_SUCCESS(err_code);
+
+    return mfc_stream_write(uid, uidLen, p_stream, stream_len, auth, context);
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_NDEF)
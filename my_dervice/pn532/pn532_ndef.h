@@ -0,0 +1,161 @@
+#ifndef __PN532_NDEF_H__
+#define __PN532_NDEF_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+#include "nfc_ndef_record.h"
+#include "nfc_ndef_msg.h"
+#include "pn532_i2c.h"
+#include "nfc_uri_rec.h"
+#include "nfc_text_rec.h"
+
+/**@brief Record types reported by @ref pn532_ndef_read. */
+typedef enum
+{
+    PN532_NDEF_REC_URI,   /**< Well-known "U" record. */
+    PN532_NDEF_REC_TEXT,  /**< Well-known "T" record. */
+} pn532_ndef_rec_type_t;
+
+/**@brief URI record contents. */
+typedef struct
+{
+    nfc_uri_id_t    id;      /**< Prefix code (NFC_URI_HTTPS_WWW, ...). */
+    uint8_t const * p_data;  /**< URI without the prefix, not NUL terminated. */
+    uint32_t        len;     /**< Length of @p p_data. */
+} pn532_ndef_uri_t;
+
+/**@brief NDEF record event.
+ *
+ * @details All pointers refer to the tag read buffer and are valid only during the handler call.
+ */
+typedef struct
+{
+    pn532_ndef_rec_type_t          type;      /**< Record type, selects the union member. */
+    nfc_ndef_record_desc_t const * p_record;  /**< Parsed record descriptor. */
+    uint8_t                        index;     /**< Position of the record in the message. */
+    union
+    {
+        pn532_ndef_uri_t            uri;      /**< Valid for PN532_NDEF_REC_URI. */
+        nfc_text_rec_payload_desc_t text;     /**< Valid for PN532_NDEF_REC_TEXT. */
+    } rec;
+} pn532_ndef_evt_t;
+
+/**@brief NDEF record handler, called once per recognised record. */
+typedef void (*pn532_ndef_handler_t)(pn532_ndef_evt_t const * p_evt, void * p_context);
+
+/**@brief Read the NDEF message of the selected Type 2 Tag and report its URI and Text records.
+ *
+ * @details The tag is read page by page through pn532_t2t_read() into a static buffer of
+ *          PN532_NDEF_MAX_MSG_LEN bytes, and nfc_ndef_msg_parser builds the record descriptors
+ *          on top of it, so payloads are never copied.
+ *
+ * @retval NRF_SUCCESS          Message parsed, @p handler called for each recognised record.
+ * @retval NRF_ERROR_NOT_FOUND  The tag holds no NDEF Message TLV or an empty one.
+ * @return Any error from pn532_t2t_read() or ndef_msg_parser().
+ */
+ret_code_t pn532_ndef_read(pn532_ndef_handler_t handler, void * p_context);
+
+/**@brief Read the NDEF message of a Type 1 Tag (Jewel, Topaz) and report its URI and Text
+ *        records, as @ref pn532_ndef_read does.
+ *
+ * @details The tag is read through pn532_t1t_read(): one RALL, and READ8 past the static
+ *          memory of a Topaz 512. Needs PN532_T1T.
+ *
+ * @param[in] p_target  Tag from jewel_Poll().
+ *
+ * @return As @ref pn532_ndef_read, or any error from pn532_t1t_read().
+ */
+ret_code_t pn532_ndef_read_t1t(pn532_jewel_target_t const * p_target,
+                               pn532_ndef_handler_t         handler,
+                               void *                       p_context);
+
+/**@brief Read the NDEF message of a Type 4 Tag and report its URI and Text records, as
+ *        @ref pn532_ndef_read does, each as soon as the ReadBinary that completes it arrives.
+ *
+ * @details The file is read through pn532_t4t_ndef_read(), MLe bytes per ReadBinary and with the
+ *          capability container cached per card profile. A message takes up to
+ *          PN532_NDEF_MAX_MSG_LEN - PN532_T4T_BUF_OVERHEAD bytes. A message that turns out
+ *          malformed halfway has had its first records reported. Needs PN532_T4T.
+ *
+ * @param[in] p_target  Target from readPassiveTargets(), ISO14443-4.
+ *
+ * @retval NRF_ERROR_INVALID_DATA  The message ends inside a record or without one flagged ME.
+ * @return As @ref pn532_ndef_read, or any error from pn532_t4t_ndef_read() or
+ *         ndef_record_parser().
+ */
+ret_code_t pn532_ndef_read_t4t(pn532_target_t const * p_target,
+                               pn532_ndef_handler_t   handler,
+                               void *                 p_context);
+
+/**@brief Parse an NDEF message already in memory and report its URI and Text records.
+ *
+ * @details Used by @ref pn532_ndef_read; also suitable for messages read from Type 4 Tags.
+ *          @p p_msg must stay valid while the handler runs.
+ */
+ret_code_t pn532_ndef_msg_dispatch(uint8_t *            p_msg,
+                                   uint32_t             len,
+                                   pn532_ndef_handler_t handler,
+                                   void *               p_context);
+
+/**@brief Write an NDEF message to the selected Type 2 Tag (Ultralight, NTAG2xx).
+ *
+ * @details The message is encoded with nfc_ndef_msg_encode() into an NDEF Message TLV and a
+ *          Terminator TLV, placed after the Lock and Memory Control TLVs already on the tag.
+ *          The pages are read four at a time first and only the ones that change are written
+ *          with WRITE, so rewriting a tag with the same message costs reads only. The tag must
+ *          have been selected with readPassiveTargetID() and carry an NDEF capability container.
+ *
+ * @param[in] p_msg  Message to write; needs NFC_NDEF_MSG_TAG_TYPE 2.
+ * @param[in] lock   Make the tag read-only afterwards: write access in the CC, then the dynamic
+ *                   and the static lock bits. This cannot be undone.
+ *
+ * @retval NRF_SUCCESS              Message written (and tag locked).
+ * @retval NRF_ERROR_INVALID_STATE  No NDEF capability container, or the CC is read-only.
+ * @retval NRF_ERROR_NO_MEM         The TLV stream does not fit the data area or the buffer.
+ * @retval NRF_ERROR_TIMEOUT        The tag did not answer a READ or refused a WRITE.
+ * @return Any error from nfc_ndef_msg_encode().
+ */
+ret_code_t pn532_ndef_write(nfc_ndef_msg_desc_t const * p_msg, bool lock);
+
+/**@brief Write an NDEF message that is already encoded, as @ref pn532_ndef_write does.
+ *
+ * @details For fixed messages laid out at compile time with the @ref nfc_ndef_const_msg
+ *          macros: the bytes are copied into the TLV buffer and nfc_ndef_msg_encode() is not
+ *          run, so no descriptors or payload constructors are needed.
+ *
+ * @param[in] p_msg  Encoded message, without an NLEN field.
+ * @param[in] len    Its length.
+ * @param[in] lock   As for @ref pn532_ndef_write.
+ *
+ * @retval NRF_ERROR_NO_MEM  The message does not fit the buffer, or the TLV stream the tag.
+ * @return As @ref pn532_ndef_write otherwise.
+ */
+ret_code_t pn532_ndef_write_encoded(uint8_t const * p_msg, uint32_t len, bool lock);
+
+/**@brief Write an NDEF message to the NDEF sectors of the selected MIFARE Classic card.
+ *
+ * @details The same TLV stream as @ref pn532_ndef_write is laid out from block 4 (sector 1)
+ *          on, over the data blocks, and written with mifareclassic_WriteRange(): blocks that
+ *          already hold the right bytes are not written and the sector trailers are never
+ *          touched. The card must already be formatted, MAD in sector 0 and NDEF sector
+ *          trailers (mifareclassic_FormatNDEF()).
+ *
+ * @param[in] auth     Authenticates each sector for writing, with the NDEF key of the card.
+ * @param[in] context  Passed to @p auth.
+ *
+ * @retval NRF_SUCCESS       Every block needed holds its part of the stream.
+ * @retval NRF_ERROR_NO_MEM  The TLV stream does not fit sectors 1..15 or the buffer.
+ * @retval NRF_ERROR_TIMEOUT A sector failed to authenticate, write or verify.
+ * @return Any error from nfc_ndef_msg_encode().
+ */
+ret_code_t pn532_ndef_write_classic(uint8_t * uid, uint8_t uidLen, nfc_ndef_msg_desc_t const * p_msg,
+                                    mifareclassic_auth_handler_t auth, void * context);
+
+/**@brief Write an already encoded NDEF message to a MIFARE Classic card, as
+ *        @ref pn532_ndef_write_classic does; see @ref pn532_ndef_write_encoded.
+ */
+ret_code_t pn532_ndef_write_classic_encoded(uint8_t * uid, uint8_t uidLen,
+                                            uint8_t const * p_msg, uint32_t len,
+                                            mifareclassic_auth_handler_t auth, void * context);
+
+#endif
@@ -0,0 +1,132 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_PRESENCE)
+#include "pn532_presence.h"
+#include <string.h>
+
+#define SEL_RES_ISO14443_4  0x20  /**< SEL_RES bit: the card speaks ISO14443-4. */
+
+static pn532_presence_handler_t m_handler;
+static pn532_target_t           m_target;
+static bool                     m_tracked;
+
+
+static void evt_send(pn532_presence_evt_type_t type)
+{
+    pn532_presence_evt_t evt;
+
+    if (m_handler != NULL)
+    {
+        evt.type     = type;
+        evt.p_target = &m_target;
+        m_handler(&evt);
+    }
+}
+
+
+void pn532_presence_init(pn532_presence_handler_t handler)
+{
+    m_handler = handler;
+    m_tracked = false;
+}
+
+
+/**@brief Whether the tracked card answers. An ISO14443-4 card keeps its state. */
+static bool tracked_answers(void)
+{
+    uint8_t status;
+
+    if (!m_tracked)
+    {
+        return false;
+    }
+
+    pn532_target_select(m_target.tg);
+    if (m_target.sel_res & SEL_RES_ISO14443_4)
+    {
+        status = pn532_presence_test();
+    }
+    else
+    {
+        // InSelect alone may be answered from the target table; halting first forces the
+        // WUPA and SELECT with the known UID onto the air.
+        status = inDeselect(m_target.tg);
+        if (status == 0)
+        {
+            status = inSelect(m_target.tg);
+        }
+    }
+
+    return (status == 0);
+}
+
+
+static void tracked_drop(void)
+{
+    m_tracked = false;
+    (void)inRelease(m_target.tg);
+    evt_send(PN532_PRESENCE_EVT_REMOVED);
+}
+
+
+bool pn532_presence_check(void)
+{
+    if (tracked_answers())
+    {
+        return true;
+    }
+    if (m_tracked)
+    {
+        tracked_drop();
+    }
+    return false;
+}
+
+
+ret_code_t pn532_presence_select(pn532_target_t * p_target, uint16_t timeout_ms)
+{
+    pn532_target_t target;
+    bool           same;
+
+    if (tracked_answers())
+    {
+        *p_target = m_target;
+        return NRF_SUCCESS;
+    }
+
+    if (readPassiveTargets(PN532_MIFARE_ISO14443A, &target, 1, timeout_ms) == 0)
+    {
+        if (m_tracked)
+        {
+            tracked_drop();
+        }
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    // A card that missed the quick check but answers the poll is still the same card.
+    same = m_tracked && (target.uid_len == m_target.uid_len) &&
+           (memcmp(target.uid, m_target.uid, target.uid_len) == 0);
+    if (m_tracked && !same)
+    {
+        m_tracked = false;
+        evt_send(PN532_PRESENCE_EVT_REMOVED);
+    }
+
+    m_target  = target;
+    m_tracked = true;
+    if (!same)
+    {
+        evt_send(PN532_PRESENCE_EVT_ARRIVED);
+    }
+
+    pn532_target_select(m_target.tg);
+    *p_target = m_target;
+    return NRF_SUCCESS;
+}
+
+
+void pn532_presence_reset(void)
+{
+    m_tracked = false;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_PRESENCE)
@@ -0,0 +1,56 @@
+#ifndef __PN532_PRESENCE_H__
+#define __PN532_PRESENCE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "pn532_i2c.h"
+
+/**@brief Presence events. */
+typedef enum
+{
+    PN532_PRESENCE_EVT_ARRIVED,  /**< A new card is tracked. */
+    PN532_PRESENCE_EVT_REMOVED,  /**< The tracked card no longer answers. */
+} pn532_presence_evt_type_t;
+
+/**@brief Presence event, valid only for the duration of the handler call. */
+typedef struct
+{
+    pn532_presence_evt_type_t type;
+    pn532_target_t const *    p_target;  /**< The card the event is about. */
+} pn532_presence_evt_t;
+
+/**@brief Presence event handler, called from the context of the function that detected the change. */
+typedef void (*pn532_presence_handler_t)(pn532_presence_evt_t const * p_evt);
+
+/**@brief Set the event handler, NULL for none. */
+void pn532_presence_init(pn532_presence_handler_t handler);
+
+/**@brief Get a card to talk to, skipping the anticollision if the tracked card is still there.
+ *
+ * @details With a card tracked its presence is checked first: Diagnose (card presence test)
+ *          for ISO14443-4 cards, which keeps the card state, or InDeselect and InSelect
+ *          otherwise, which halts the card and wakes it again with its known UID. Only if that fails is the field polled with
+ *          InListPassiveTarget; a card that is gone is reported with PN532_PRESENCE_EVT_REMOVED
+ *          and a different card with PN532_PRESENCE_EVT_ARRIVED.
+ *
+ * @param[out] p_target    Receives the card, also selected with pn532_target_select().
+ * @param[in]  timeout_ms  How long InListPassiveTarget waits for a new card.
+ *
+ * @retval NRF_SUCCESS          A card is selected.
+ * @retval NRF_ERROR_NOT_FOUND  No card in the field.
+ */
+ret_code_t pn532_presence_select(pn532_target_t * p_target, uint16_t timeout_ms);
+
+/**@brief Check whether the tracked card is still in the field.
+ *
+ * @details Emits PN532_PRESENCE_EVT_REMOVED and drops the card when it does not answer.
+ *
+ * @return true if a card is tracked and answered.
+ */
+bool pn532_presence_check(void);
+
+/**@brief Stop tracking without an event, e.g. after the RF field has been switched. */
+void pn532_presence_reset(void);
+
+#endif
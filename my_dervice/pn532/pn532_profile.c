@@ -0,0 +1,178 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_PROFILE)
+#include "pn532_profile.h"
+#include <string.h>
+
+#define RESELECT_TIMEOUT_MS   100   /**< Card was in the field a moment ago. */
+
+#define NXP_PRODUCT_ULTRALIGHT  0x03
+#define NXP_PRODUCT_NTAG        0x04
+
+/* Storage size byte of GET_VERSION. */
+#define NTAG213_STORAGE  0x0F
+#define NTAG215_STORAGE  0x11
+#define NTAG216_STORAGE  0x13
+
+typedef struct
+{
+    uint8_t  uid_len;               /**< 0 for a free entry. */
+    uint8_t  uid[10];
+    uint8_t  sel_res;
+    uint16_t sens_res;
+    uint8_t  profile;
+    uint8_t  used;                  /**< m_clock at the last hit. */
+} profile_entry_t;
+
+static profile_entry_t m_cache[PN532_PROFILE_CACHE_SIZE];
+static uint8_t         m_clock;
+
+
+void pn532_profile_init(void)
+{
+    memset(m_cache, 0, sizeof(m_cache));
+    m_clock = 0;
+}
+
+
+/**@brief Tell an NTAG21x and an Ultralight EV1 from a plain Ultralight by GET_VERSION. */
+static pn532_profile_t profile_t2t(void)
+{
+    uint8_t        version[NTAG2XX_VERSION_LEN];
+    pn532_target_t again;
+
+    if (!ntag2xx_GetVersion(version))
+    {
+        // The NAK sent the tag to IDLE, it still answers the next REQA.
+        UNUSED_RETURN_VALUE(readPassiveTargets(PN532_MIFARE_ISO14443A, &again, 1, RESELECT_TIMEOUT_MS));
+        return PN532_PROFILE_ULTRALIGHT;
+    }
+
+    if (version[2] == NXP_PRODUCT_ULTRALIGHT)
+    {
+        return PN532_PROFILE_ULTRALIGHT_EV1;
+    }
+    if (version[2] != NXP_PRODUCT_NTAG)
+    {
+        // Another vendor's Type 2 Tag, the Ultralight command set is the common ground.
+        return PN532_PROFILE_ULTRALIGHT;
+    }
+    switch (version[6])
+    {
+        case NTAG213_STORAGE:
+            return PN532_PROFILE_NTAG213;
+        case NTAG215_STORAGE:
+            return PN532_PROFILE_NTAG215;
+        case NTAG216_STORAGE:
+            return PN532_PROFILE_NTAG216;
+        default:
+            return PN532_PROFILE_NTAG;
+    }
+}
+
+
+/**@brief Tell DESFire and MIFARE Plus from other ISO-DEP cards by the ATS historical bytes. */
+static pn532_profile_t profile_iso_dep(pn532_target_t const * p_target)
+{
+    uint8_t const * p_ats = p_target->ats;
+    uint8_t         len   = MIN(p_target->ats_len, sizeof(p_target->ats));
+    uint8_t         hist;
+
+    // The ATQA of DESFire carries the proprietary value 0x03.
+    if ((p_target->sens_res >> 8) == 0x03)
+    {
+        return PN532_PROFILE_DESFIRE;
+    }
+    if (len < 2)
+    {
+        return PN532_PROFILE_ISO14443_4;
+    }
+
+    // TL, T0, then TA, TB and TC as announced by T0 bits 4..6.
+    hist = 2 + ((p_ats[1] >> 4) & 1) + ((p_ats[1] >> 5) & 1) + ((p_ats[1] >> 6) & 1);
+    if ((hist < len) && (p_ats[hist] == 0x80))
+    {
+        return PN532_PROFILE_DESFIRE;
+    }
+    if ((hist + 1 < len) && (p_ats[hist] == 0xC1) && (p_ats[hist + 1] == 0x05))
+    {
+        return PN532_PROFILE_MIFARE_PLUS;
+    }
+    return PN532_PROFILE_ISO14443_4;
+}
+
+
+static pn532_profile_t profile_classify(pn532_target_t const * p_target)
+{
+    switch (p_target->sel_res)
+    {
+        case 0x00:
+            return profile_t2t();
+
+        case 0x09:
+            return PN532_PROFILE_MIFARE_MINI;
+
+        case 0x08:
+        case 0x28:      // Classic emulation of a SmartMX or a Plus with ISO14443-4
+        case 0x88:      // Infineon
+            return PN532_PROFILE_MIFARE_1K;
+
+        case 0x18:
+        case 0x38:
+        case 0x98:
+            return PN532_PROFILE_MIFARE_4K;
+
+        case 0x10:
+        case 0x11:
+            return PN532_PROFILE_MIFARE_PLUS;
+
+        default:
+            return (p_target->sel_res & 0x20) ? profile_iso_dep(p_target) : PN532_PROFILE_UNKNOWN;
+    }
+}
+
+
+pn532_profile_t pn532_profile_get(pn532_target_t const * p_target)
+{
+    profile_entry_t * p_old  = &m_cache[0];
+    uint8_t           len    = MIN(p_target->uid_len, sizeof(m_cache[0].uid));
+    uint8_t           oldest = 0;
+
+    m_clock++;
+    for (uint8_t i = 0; i < PN532_PROFILE_CACHE_SIZE; i++)
+    {
+        profile_entry_t * p_entry = &m_cache[i];
+        uint8_t           age     = (uint8_t)(m_clock - p_entry->used);
+
+        if ((p_entry->uid_len == len) && (len != 0) && (memcmp(p_entry->uid, p_target->uid, len) == 0))
+        {
+            if ((p_entry->sel_res == p_target->sel_res) && (p_entry->sens_res == p_target->sens_res))
+            {
+                p_entry->used = m_clock;
+                return (pn532_profile_t)p_entry->profile;
+            }
+            // Same UID, other card (or a UID changeable one): classify again in its place.
+            p_old = p_entry;
+            break;
+        }
+        if (p_entry->uid_len == 0)
+        {
+            age = 0xFF;
+        }
+        if (age >= oldest)
+        {
+            oldest = age;
+            p_old  = p_entry;
+        }
+    }
+
+    p_old->profile  = (uint8_t)profile_classify(p_target);
+    p_old->uid_len  = len;
+    p_old->sel_res  = p_target->sel_res;
+    p_old->sens_res = p_target->sens_res;
+    p_old->used     = m_clock;
+    memcpy(p_old->uid, p_target->uid, len);
+
+    return (pn532_profile_t)p_old->profile;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_PROFILE)
@@ -0,0 +1,50 @@
+#ifndef __PN532_PROFILE_H__
+#define __PN532_PROFILE_H__
+
+#include <stdint.h>
+#include "pn532_i2c.h"
+
+/**@brief Card families, each with its own command set. */
+typedef enum
+{
+    PN532_PROFILE_UNKNOWN,
+    PN532_PROFILE_MIFARE_MINI,      /**< MIFARE Classic Mini, 5 sectors. */
+    PN532_PROFILE_MIFARE_1K,        /**< MIFARE Classic 1K, or Plus in security level 1. */
+    PN532_PROFILE_MIFARE_4K,        /**< MIFARE Classic 4K, or Plus 4K in security level 1. */
+    PN532_PROFILE_ULTRALIGHT,       /**< Ultralight or Ultralight C, no GET_VERSION. */
+    PN532_PROFILE_ULTRALIGHT_EV1,
+    PN532_PROFILE_NTAG213,
+    PN532_PROFILE_NTAG215,
+    PN532_PROFILE_NTAG216,
+    PN532_PROFILE_NTAG,             /**< Other NTAG2xx size. */
+    PN532_PROFILE_MIFARE_PLUS,      /**< MIFARE Plus in security level 2 or 3. */
+    PN532_PROFILE_DESFIRE,
+    PN532_PROFILE_ISO14443_4,       /**< Other ISO-DEP card. */
+} pn532_profile_t;
+
+/**@brief Card answers to the MIFARE Classic commands (authenticate, 16-byte blocks). */
+#define PN532_PROFILE_IS_CLASSIC(profile) \
+    (((profile) >= PN532_PROFILE_MIFARE_MINI) && ((profile) <= PN532_PROFILE_MIFARE_4K))
+
+/**@brief Card is a Type 2 Tag (READ, WRITE on 4-byte pages). */
+#define PN532_PROFILE_IS_T2T(profile) \
+    (((profile) >= PN532_PROFILE_ULTRALIGHT) && ((profile) <= PN532_PROFILE_NTAG))
+
+/**@brief Forget all cards. */
+void pn532_profile_init(void);
+
+/**@brief Card family of the selected target.
+ *
+ * @details Most families follow from SENS_RES (ATQA), SEL_RES (SAK) and the ATS alone
+ *          (NXP AN10833). Only cards with SAK 0x00 need a GET_VERSION to tell NTAG21x and
+ *          Ultralight EV1 from the plain Ultralight, which NAKs it and has to be selected again.
+ *          The result is cached by UID in a table of PN532_PROFILE_CACHE_SIZE entries, so that
+ *          GET_VERSION goes out once per card; an entry only counts while ATQA and SAK match.
+ *
+ * @param[in] p_target  Target from readPassiveTargets(), selected.
+ *
+ * @return Card family, PN532_PROFILE_UNKNOWN if the SAK is not in the table.
+ */
+pn532_profile_t pn532_profile_get(pn532_target_t const * p_target);
+
+#endif
@@ -0,0 +1,319 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_PT)
+#include "pn532_pt.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(PN532_ASYNC)
+#error "pn532_pt needs PN532_ASYNC"
+#endif
+
+#define STATUS(p_pt)  ((p_pt)->view.p_data[1] & PN532_STATUS_ERROR_MASK)
+
+static pn532_pt_t * mp_running;
+static bool         m_in_step;      /**< The sequence is running, a completion only records. */
+
+
+/**@brief Run the sequence to its next wait, or to its end. */
+static void seq_step(void)
+{
+    pn532_pt_t * p_pt = mp_running;
+    char         state;
+
+    m_in_step = true;
+    state     = p_pt->seq(p_pt);
+    m_in_step = false;
+
+    if (PT_SCHEDULE(state))
+    {
+        return;
+    }
+    mp_running = NULL;
+    if (p_pt->handler != NULL)
+    {
+        p_pt->handler(p_pt, p_pt->result);
+    }
+}
+
+
+static void cmd_done(ret_code_t result, void * p_context)
+{
+    pn532_pt_t * p_pt = (pn532_pt_t *)p_context;
+
+    if (p_pt != mp_running)
+    {
+        return;
+    }
+    if ((result == NRF_SUCCESS) &&
+        ((pn532_frame_decode(p_pt->resp, p_pt->resp_len, &p_pt->view) != NRF_SUCCESS) ||
+         (p_pt->view.len < 1) || (p_pt->view.p_data[0] != (uint8_t)(p_pt->cmd[0] + 1))))
+    {
+        result = NRF_ERROR_INVALID_DATA;
+    }
+    p_pt->result  = result;
+    p_pt->pending = false;
+
+    // The queue may complete a command before pn532_cmd_start returns.
+    if (!m_in_step)
+    {
+        seq_step();
+    }
+}
+
+
+ret_code_t pn532_pt_cmd(pn532_pt_t * p_pt, uint8_t len, uint8_t resp_len, uint32_t timeout_ms)
+{
+    ret_code_t err_code;
+
+    p_pt->resp_len = resp_len;
+    p_pt->pending  = true;
+    err_code = pn532_cmd_start(p_pt->cmd, len, p_pt->resp, resp_len, timeout_ms, cmd_done, p_pt);
+    if (err_code != NRF_SUCCESS)
+    {
+        p_pt->pending = false;
+    }
+    return err_code;
+}
+
+
+ret_code_t pn532_pt_run(pn532_pt_t * p_pt, pn532_pt_seq_t seq, void * p_args, pn532_pt_handler_t handler)
+{
+    if ((mp_running != NULL) || pn532_cmd_busy())
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    PT_INIT(&p_pt->pt);
+    p_pt->seq     = seq;
+    p_pt->handler = handler;
+    p_pt->p_args  = p_args;
+    p_pt->result  = NRF_SUCCESS;
+    p_pt->pending = false;
+
+    mp_running = p_pt;
+    seq_step();
+    return NRF_SUCCESS;
+}
+
+
+bool pn532_pt_busy(void)
+{
+    return (mp_running != NULL);
+}
+
+
+void pn532_pt_abort(void)
+{
+    static uint8_t const ack_frame[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+
+    if (mp_running == NULL)
+    {
+        return;
+    }
+    if (mp_running->pending)
+    {
+        // An ACK frame from the host aborts the command the PN532 is executing.
+        pn532_cmd_abort();
+        UNUSED_RETURN_VALUE(pn532_bus_write(ack_frame, sizeof(ack_frame)));
+    }
+    mp_running = NULL;
+}
+
+
+PT_THREAD(pn532_pt_rf_setup(pn532_pt_t * p_pt))
+{
+    PT_BEGIN(&p_pt->pt);
+
+    p_pt->cmd[0] = PN532_COMMAND_SETPARAMETERS;
+    p_pt->cmd[1] = 0x14;
+    PN532_PT_CMD(p_pt, 2, PN532_PT_RESP_LEN(0), PN532_RESP_TIMEOUT_CONFIG);
+
+    // MaxRtyCOM, RF field off then on, then endless activation retries.
+    p_pt->cmd[0] = PN532_COMMAND_RFCONFIGURATION;
+    p_pt->cmd[1] = 0x01;
+    p_pt->cmd[2] = 0x00;
+    PN532_PT_CMD(p_pt, 3, PN532_PT_RESP_LEN(0), PN532_RESP_TIMEOUT_CONFIG);
+
+    p_pt->cmd[0] = PN532_COMMAND_RFCONFIGURATION;
+    p_pt->cmd[1] = 0x01;
+    p_pt->cmd[2] = 0x01;
+    PN532_PT_CMD(p_pt, 3, PN532_PT_RESP_LEN(0), PN532_RESP_TIMEOUT_CONFIG);
+
+    p_pt->cmd[0] = PN532_COMMAND_RFCONFIGURATION;
+    p_pt->cmd[1] = 0x05;
+    p_pt->cmd[2] = 0xFF;
+    p_pt->cmd[3] = 0xFF;
+    p_pt->cmd[4] = 0xFF;
+    PN532_PT_CMD(p_pt, 5, PN532_PT_RESP_LEN(0), PN532_RESP_TIMEOUT_CONFIG);
+
+    PT_END(&p_pt->pt);
+}
+
+
+/**@brief InDataExchange header of a Mifare command to the selected target. */
+static void mfc_cmd(pn532_pt_t * p_pt, uint8_t cmd, uint8_t block)
+{
+    p_pt->cmd[0] = PN532_COMMAND_INDATAEXCHANGE;
+    p_pt->cmd[1] = pn532_reader_current()->tg;
+    p_pt->cmd[2] = cmd;
+    p_pt->cmd[3] = block;
+}
+
+
+PT_THREAD(pn532_pt_mfc_rmw(pn532_pt_t * p_pt))
+{
+    pn532_pt_mfc_rmw_t * p_args = (pn532_pt_mfc_rmw_t *)p_pt->p_args;
+
+    PT_BEGIN(&p_pt->pt);
+
+    mfc_cmd(p_pt, p_args->key_b ? MIFARE_CMD_AUTH_B : MIFARE_CMD_AUTH_A, p_args->block);
+    memcpy(&p_pt->cmd[4], p_args->key, sizeof(p_args->key));
+    memcpy(&p_pt->cmd[10], p_args->uid, sizeof(p_args->uid));
+    PN532_PT_CMD(p_pt, 10 + PN532_MFC_UID_LEN, PN532_PT_RESP_LEN(1), PN532_RESP_TIMEOUT_CARD);
+    if ((p_pt->view.len < 2) || (STATUS(p_pt) != 0))
+    {
+        PN532_PT_FAIL(p_pt, NRF_ERROR_FORBIDDEN);
+    }
+
+    mfc_cmd(p_pt, MIFARE_CMD_READ, p_args->block);
+    PN532_PT_CMD(p_pt, 4, PN532_PT_RESP_LEN(1 + 16), PN532_RESP_TIMEOUT_CARD);
+    if ((p_pt->view.len < 2 + 16) || (STATUS(p_pt) != 0))
+    {
+        PN532_PT_FAIL(p_pt, NRF_ERROR_INTERNAL);
+    }
+    memcpy(p_args->data, &p_pt->view.p_data[2], sizeof(p_args->data));
+
+    if (p_args->modify(p_args->data, p_args->p_context))
+    {
+        mfc_cmd(p_pt, MIFARE_CMD_WRITE, p_args->block);
+        memcpy(&p_pt->cmd[4], p_args->data, sizeof(p_args->data));
+        PN532_PT_CMD(p_pt, 4 + 16, PN532_PT_RESP_LEN(1), PN532_RESP_TIMEOUT_CARD);
+        if ((p_pt->view.len < 2) || (STATUS(p_pt) != 0))
+        {
+            PN532_PT_FAIL(p_pt, NRF_ERROR_INTERNAL);
+        }
+    }
+
+    PT_END(&p_pt->pt);
+}
+
+
+/**@brief InCommunicateThru of the @p len frame bytes at cmd[1], the CRC_B appended. */
+static uint8_t typeb_frame(pn532_pt_t * p_pt, uint8_t len)
+{
+    uint16_t crc = pn532_typeb_crc(&p_pt->cmd[1], len);
+
+    p_pt->cmd[0]       = PN532_COMMAND_INCOMMUNICATETHRU;
+    p_pt->cmd[1 + len] = (uint8_t)crc;
+    p_pt->cmd[2 + len] = (uint8_t)(crc >> 8);
+    return 1 + len + TYPEB_CRC_LEN;
+}
+
+
+/**@brief Check status and CRC_B of the answer and leave it in view without them. */
+static bool typeb_answer(pn532_pt_t * p_pt, uint8_t min_len)
+{
+    pn532_frame_view_t * p_view = &p_pt->view;
+    uint16_t             crc;
+
+    if ((p_view->len < 2 + min_len + TYPEB_CRC_LEN) || (STATUS(p_pt) != 0))
+    {
+        return false;
+    }
+    p_view->p_data += 2;
+    p_view->len    -= 2 + TYPEB_CRC_LEN;
+    crc = pn532_typeb_crc(p_view->p_data, (uint8_t)p_view->len);
+    return (p_view->p_data[p_view->len] == (uint8_t)crc) &&
+           (p_view->p_data[p_view->len + 1] == (uint8_t)(crc >> 8));
+}
+
+
+/**@brief Send a Type B frame of @p len bytes at cmd[1] and end the sequence unless at least
+ *        @p min_len bytes come back intact. */
+#define TYPEB_CMD(p_pt, len, min_len)                                                   \
+    do                                                                                  \
+    {                                                                                   \
+        PN532_PT_CMD((p_pt), typeb_frame((p_pt), (len)),                                \
+                     PN532_PT_RESP_LEN(1 + (min_len) + TYPEB_CRC_LEN),                  \
+                     PN532_RESP_TIMEOUT_CARD);                                          \
+        if (!typeb_answer((p_pt), (min_len)))                                           \
+        {                                                                               \
+            PN532_PT_FAIL((p_pt), NRF_ERROR_NOT_FOUND);                                 \
+        }                                                                               \
+    } while (0)
+
+
+PT_THREAD(pn532_pt_typeb_uid(pn532_pt_t * p_pt))
+{
+    pn532_pt_typeb_uid_t * p_args = (pn532_pt_typeb_uid_t *)p_pt->p_args;
+    pn532_typeb_target_t * p_tgt  = &p_args->target;
+
+    PT_BEGIN(&p_pt->pt);
+
+    if (pn532_reader_current()->typeb_speed != 0)
+    {
+        // CIU_TxMode / CIU_RxMode back to 106 kbps, type B framing.
+        p_pt->cmd[0] = PN532_COMMAND_WRITEREGISTER;
+        p_pt->cmd[1] = 0x63;
+        p_pt->cmd[2] = 0x02;
+        p_pt->cmd[3] = 0x03;
+        p_pt->cmd[4] = 0x63;
+        p_pt->cmd[5] = 0x03;
+        p_pt->cmd[6] = 0x03;
+        PN532_PT_CMD(p_pt, 7, PN532_PT_RESP_LEN(0), PN532_RESP_TIMEOUT_CONFIG);
+        pn532_reader_current()->typeb_speed = 0;
+    }
+
+    // WUPB with a single slot: an ID card is read on its own.
+    p_pt->cmd[1] = TYPEB_APF;
+    p_pt->cmd[2] = 0x00;
+    p_pt->cmd[3] = TYPEB_PARAM_WUPB;
+    TYPEB_CMD(p_pt, 3, TYPEB_ATQB_LEN);
+    if (p_pt->view.p_data[0] != TYPEB_ATQB)
+    {
+        PN532_PT_FAIL(p_pt, NRF_ERROR_NOT_FOUND);
+    }
+    memcpy(p_tgt->pupi,      &p_pt->view.p_data[1], 4);
+    memcpy(p_tgt->app_data,  &p_pt->view.p_data[5], 4);
+    memcpy(p_tgt->prot_info, &p_pt->view.p_data[9], 3);
+    p_tgt->dri = 0;
+    p_tgt->dsi = 0;
+    p_tgt->cid = (p_tgt->prot_info[2] & 0x01) ? 1 : 0;
+
+    p_pt->cmd[1] = TYPEB_ATTRIB;
+    memcpy(&p_pt->cmd[2], p_tgt->pupi, 4);
+    p_pt->cmd[6] = 0x00;
+    p_pt->cmd[7] = TYPEB_FSDI;
+    p_pt->cmd[8] = p_tgt->prot_info[1] & 0x0F;
+    p_pt->cmd[9] = p_tgt->cid;
+    TYPEB_CMD(p_pt, 9, 1);
+    if ((p_pt->view.p_data[0] & 0x0F) != p_tgt->cid)
+    {
+        PN532_PT_FAIL(p_pt, NRF_ERROR_NOT_FOUND);
+    }
+
+    // GET UID, answered with the UID and SW1 SW2.
+    p_pt->cmd[1] = 0x00;
+    p_pt->cmd[2] = 0x36;
+    p_pt->cmd[3] = 0x00;
+    p_pt->cmd[4] = 0x00;
+    p_pt->cmd[5] = 0x08;
+    TYPEB_CMD(p_pt, 5, 8 + 2);
+    if ((p_pt->view.p_data[p_pt->view.len - 2] != 0x90) ||
+        (p_pt->view.p_data[p_pt->view.len - 1] != 0x00))
+    {
+        PN532_PT_FAIL(p_pt, NRF_ERROR_NOT_FOUND);
+    }
+    memcpy(p_args->uid, p_pt->view.p_data, sizeof(p_args->uid));
+
+    // HLTB; the UID is read whatever the card says to it.
+    p_pt->cmd[1] = TYPEB_HLTB;
+    memcpy(&p_pt->cmd[2], p_tgt->pupi, 4);
+    UNUSED_RETURN_VALUE(pn532_pt_cmd(p_pt, typeb_frame(p_pt, 5), PN532_PT_RESP_LEN(1 + 1 + TYPEB_CRC_LEN),
+                                     PN532_RESP_TIMEOUT_CARD));
+    PT_WAIT_WHILE(&p_pt->pt, p_pt->pending);
+    p_pt->result = NRF_SUCCESS;
+
+    PT_END(&p_pt->pt);
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_PT)
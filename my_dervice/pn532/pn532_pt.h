@@ -0,0 +1,143 @@
+#ifndef __PN532_PT_H__
+#define __PN532_PT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "nrf_pt.h"
+#include "pn532_i2c.h"
+#include "pn532_async.h"
+
+/* Multi-command PN532 sequences as protothreads on top of pn532_async, so they run from the
+ * main loop without blocking it and without a stack of their own:
+ *
+ *   sequence   a PT_THREAD function of a pn532_pt_t; PN532_PT_CMD sends the command in
+ *              cmd and returns to the main loop until the response is in resp
+ *   state      locals do not survive a wait, what a sequence keeps between commands is in
+ *              its arguments (p_args) or in the pn532_pt_t
+ *   result     the first command that fails ends the sequence with its result, the handler
+ *              gets NRF_SUCCESS when the sequence got to its end
+ *
+ * One sequence runs at a time. The blocking driver calls share the PN532 and must not be used
+ * until the handler has been called. */
+
+#define PN532_PT_CMD_MAX  PN532_ASYNC_FRAME_MAX_LEN
+
+typedef struct pn532_pt_s pn532_pt_t;
+
+/**@brief A sequence, written with PT_BEGIN and PT_END on &p_pt->pt. */
+typedef char (*pn532_pt_seq_t)(pn532_pt_t * p_pt);
+
+/**@brief Called from the main loop when a sequence has ended. */
+typedef void (*pn532_pt_handler_t)(pn532_pt_t * p_pt, ret_code_t result);
+
+/**@brief A sequence and its state. */
+struct pn532_pt_s
+{
+    pt_t               pt;
+    pn532_pt_seq_t     seq;
+    pn532_pt_handler_t handler;
+    void *             p_args;                              /**< Arguments of the sequence. */
+    ret_code_t         result;                              /**< Of the last command, then of the sequence. */
+    bool               pending;                             /**< A command is in flight. */
+    uint8_t            resp_len;
+    pn532_frame_view_t view;                                /**< Payload of the last response, in resp. */
+    uint8_t            cmd[PN532_PT_CMD_MAX];               /**< Next command, without framing. */
+    uint8_t            resp[PN532_ASYNC_FRAME_MAX_LEN];
+};
+
+/**@brief Bytes read for a response with @p n bytes after the response code. */
+#define PN532_PT_RESP_LEN(n)  (PN532_FRAME_OVERHEAD + 1 + (n))
+
+/**@brief Send the @p len bytes of cmd and wait for the response, in a sequence.
+ *
+ * @details Ends the sequence with the result unless the response came back with the code of
+ *          the command; its payload is in view then.
+ */
+#define PN532_PT_CMD(p_pt, len, resp_len, timeout_ms)                                   \
+    do                                                                                  \
+    {                                                                                   \
+        (p_pt)->result = pn532_pt_cmd((p_pt), (len), (resp_len), (timeout_ms));         \
+        if ((p_pt)->result == NRF_SUCCESS)                                              \
+        {                                                                               \
+            PT_WAIT_WHILE(&(p_pt)->pt, (p_pt)->pending);                                \
+        }                                                                               \
+        if ((p_pt)->result != NRF_SUCCESS)                                              \
+        {                                                                               \
+            PT_EXIT(&(p_pt)->pt);                                                       \
+        }                                                                               \
+    } while (0)
+
+/**@brief End the sequence with @p err_code. */
+#define PN532_PT_FAIL(p_pt, err_code)                                                   \
+    do                                                                                  \
+    {                                                                                   \
+        (p_pt)->result = (err_code);                                                    \
+        PT_EXIT(&(p_pt)->pt);                                                           \
+    } while (0)
+
+/**@brief Start a sequence.
+ *
+ * @param[in] p_pt     State, kept by the caller until the handler has been called.
+ * @param[in] seq      The sequence.
+ * @param[in] p_args   Arguments of the sequence.
+ * @param[in] handler  End handler, may be NULL.
+ *
+ * @retval NRF_SUCCESS     Running; it may have ended already and called the handler.
+ * @retval NRF_ERROR_BUSY  Another sequence or an async command is running.
+ */
+ret_code_t pn532_pt_run(pn532_pt_t * p_pt, pn532_pt_seq_t seq, void * p_args, pn532_pt_handler_t handler);
+
+/**@brief Whether a sequence is running. */
+bool pn532_pt_busy(void);
+
+/**@brief Stop the running sequence without calling its handler.
+ *
+ * @details The command in flight is aborted, other queued pn532_async commands are dropped
+ *          with it.
+ */
+void pn532_pt_abort(void);
+
+/**@brief Send cmd, for @ref PN532_PT_CMD. */
+ret_code_t pn532_pt_cmd(pn532_pt_t * p_pt, uint8_t len, uint8_t resp_len, uint32_t timeout_ms);
+
+/**@brief The commands of SetRFConfiguration(), p_args unused. */
+PT_THREAD(pn532_pt_rf_setup(pn532_pt_t * p_pt));
+
+/**@brief Changes a Mifare Classic block, return false to leave it as it is. */
+typedef bool (*pn532_pt_modify_t)(uint8_t * p_data, void * p_context);
+
+/**@brief Arguments of @ref pn532_pt_mfc_rmw. */
+typedef struct
+{
+    uint8_t           uid[PN532_MFC_UID_LEN];  /**< Last 4 bytes of the UID of the selected card. */
+    uint8_t           block;
+    bool              key_b;
+    uint8_t           key[6];
+    pn532_pt_modify_t modify;
+    void *            p_context;               /**< Passed to @p modify. */
+    uint8_t           data[16];                /**< The block as read, then as written. */
+} pn532_pt_mfc_rmw_t;
+
+/**@brief Authenticate, read a block, let @p modify change it and write it back.
+ *
+ * @details Ends with NRF_ERROR_FORBIDDEN for a refused key and NRF_ERROR_INTERNAL for a read
+ *          or write the card did not do.
+ */
+PT_THREAD(pn532_pt_mfc_rmw(pn532_pt_t * p_pt));
+
+/**@brief Arguments of @ref pn532_pt_typeb_uid. */
+typedef struct
+{
+    pn532_typeb_target_t target;  /**< ATQB fields, set by the sequence. */
+    uint8_t              uid[8];  /**< Set by the sequence. */
+} pn532_pt_typeb_uid_t;
+
+/**@brief readTypeBuid() at 106 kbps: WUPB with one slot, ATTRIB, GET UID and HLTB.
+ *
+ * @details The reader must be in PN532_RF_MODE_ISO14443B. Ends with NRF_ERROR_NOT_FOUND when
+ *          no card answered, or not with a UID.
+ */
+PT_THREAD(pn532_pt_typeb_uid(pn532_pt_t * p_pt));
+
+#endif
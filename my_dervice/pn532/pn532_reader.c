@@ -0,0 +1,165 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_READER)
+#include "pn532_reader.h"
+#include "nrf_gpio.h"
+#include "nrf_delay.h"
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+#include "pn532_async.h"
+#endif
+
+#if (PN532_READER_COUNT < 1) || (PN532_READER_COUNT > 2)
+#error "PN532_READER_COUNT must be 1 or 2, the board has select and IRQ lines for two readers"
+#endif
+#if (PN532_TRANSPORT == PN532_TRANSPORT_HSU) && (PN532_READER_COUNT > 1)
+#error "HSU is point to point, there is one UART for one PN532"
+#endif
+
+#if (PN532_TRANSPORT == PN532_TRANSPORT_SPI)
+static const pn532_bus_cfg_t m_bus_cfg[PN532_READER_COUNT] = {
+    {.irq_pin = PN532_IRQ,         .sel_pin = PN532_CONFIG_NSS,  .sel_level = 0},
+#if PN532_READER_COUNT > 1
+    {.irq_pin = PN532_READER1_IRQ, .sel_pin = PN532_READER1_NSS, .sel_level = 0},
+#endif
+};
+#else
+static const pn532_bus_cfg_t m_bus_cfg[PN532_READER_COUNT] = {
+    {.irq_pin = PN532_IRQ,         .sel_pin = (PN532_READER_COUNT > 1) ? PN532_READER_SEL : PN532_PIN_NOT_USED, .sel_level = 0},
+#if PN532_READER_COUNT > 1
+    {.irq_pin = PN532_READER1_IRQ, .sel_pin = PN532_READER_SEL, .sel_level = 1},
+#endif
+};
+#endif
+
+static uint8_t const    m_ack_frame[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+
+/* Reader 0 keeps the state the driver started with, the others get their own. */
+static pn532_reader_t   m_readers[PN532_READER_COUNT];      /**< Entry 0 unused. */
+static pn532_reader_t * mp_readers[PN532_READER_COUNT];
+static uint8_t          m_in_use;
+static pn532_target_t   m_targets[PN532_READER_COUNT];
+
+
+ret_code_t pn532_reader_init(void)
+{
+    mp_readers[0]      = pn532_reader_current();
+    mp_readers[0]->bus = m_bus_cfg[0];
+
+    for (uint8_t i = 1; i < PN532_READER_COUNT; i++)
+    {
+        mp_readers[i]          = &m_readers[i];
+        mp_readers[i]->bus     = m_bus_cfg[i];
+        mp_readers[i]->rf_mode = PN532_RF_MODE_NONE;
+        mp_readers[i]->tg      = 1;
+
+        nrf_gpio_cfg_input(m_bus_cfg[i].irq_pin, NRF_GPIO_PIN_NOPULL);
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+        VERIFY_SUCCESS(pn532_async_irq_add(m_bus_cfg[i].irq_pin));
+#endif
+#if (PN532_TRANSPORT == PN532_TRANSPORT_SPI)
+        nrf_gpio_pin_set(m_bus_cfg[i].sel_pin);
+        nrf_gpio_cfg_output(m_bus_cfg[i].sel_pin);
+#endif
+    }
+
+#if (PN532_TRANSPORT == PN532_TRANSPORT_I2C) && (PN532_READER_COUNT > 1)
+    // Reader 0 is on the bus from the start.
+    nrf_gpio_pin_clear(PN532_READER_SEL);
+    nrf_gpio_cfg_output(PN532_READER_SEL);
+#endif
+
+    m_in_use = 0;
+    return NRF_SUCCESS;
+}
+
+
+void pn532_reader_use(uint8_t reader)
+{
+    if ((reader >= PN532_READER_COUNT) || (mp_readers[reader] == NULL))
+    {
+        return;
+    }
+    m_in_use = reader;
+    pn532_reader_select(mp_readers[reader]);
+}
+
+
+uint8_t pn532_reader_in_use(void)
+{
+    return m_in_use;
+}
+
+
+uint8_t pn532_reader_list(uint16_t timeout_ms, pn532_reader_list_handler_t handler)
+{
+    uint8_t  pending = 0;
+    uint8_t  found   = 0;
+    uint32_t polls   = (uint32_t)timeout_ms * 10;
+
+    // Start all polls first, the chips search their fields while the bus serves the next one.
+    for (uint8_t i = 0; i < PN532_READER_COUNT; i++)
+    {
+        pn532_reader_use(i);
+        if (readPassiveTargetsStart(PN532_MIFARE_ISO14443A, 1))
+        {
+            pending |= (1 << i);
+        }
+    }
+
+    while (pending != 0)
+    {
+        for (uint8_t i = 0; i < PN532_READER_COUNT; i++)
+        {
+            if ((pending & (1 << i)) == 0)
+            {
+                continue;
+            }
+            pn532_reader_use(i);
+            if (wirereadstatus() != PN532_I2C_READY)
+            {
+                continue;
+            }
+            pending &= ~(1 << i);
+            if (readPassiveTargetsFinish(&m_targets[i], 1, timeout_ms) != 0)
+            {
+                found |= (1 << i);
+            }
+        }
+
+        if ((pending == 0) || (polls-- == 0))
+        {
+            break;
+        }
+        nrf_delay_us(100);
+    }
+
+    // An ACK frame from the host aborts the poll of a reader that is still searching.
+    for (uint8_t i = 0; i < PN532_READER_COUNT; i++)
+    {
+        if ((pending & (1 << i)) != 0)
+        {
+            pn532_reader_use(i);
+            UNUSED_RETURN_VALUE(pn532_bus_write(m_ack_frame, sizeof(m_ack_frame)));
+        }
+    }
+
+    // Handlers run after the burst, so a slow one does not hold back the other readers.
+    pending = found;
+    found   = 0;
+    for (uint8_t i = 0; i < PN532_READER_COUNT; i++)
+    {
+        if ((pending & (1 << i)) != 0)
+        {
+            found++;
+            pn532_reader_use(i);
+            if (handler != NULL)
+            {
+                handler(i, &m_targets[i]);
+            }
+        }
+    }
+
+    pn532_reader_use(0);
+    return found;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_READER)
@@ -0,0 +1,44 @@
+#ifndef __PN532_READER_H__
+#define __PN532_READER_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+#include "pn532_i2c.h"
+
+/* Second reader. On I2C both chips answer to the same address, so an analog switch on
+ * PN532_READER_SEL routes SDA/SCL to one of them; on SPI each chip has its own NSS. */
+#define PN532_READER1_IRQ   3
+#define PN532_READER_SEL    5   //I2C bus switch: low reader 0, high reader 1
+#define PN532_READER1_NSS   7
+
+/**@brief Card handler of @ref pn532_reader_list, called with @p reader selected. */
+typedef void (*pn532_reader_list_handler_t)(uint8_t reader, pn532_target_t const * p_target);
+
+/**@brief Set up the select and IRQ lines of all readers and select reader 0.
+ *
+ * @note Call after pn532_bus_init and, with PN532_ASYNC, after pn532_async_init.
+ */
+ret_code_t pn532_reader_init(void);
+
+/**@brief Send the following driver calls to reader @p reader (0..PN532_READER_COUNT-1). */
+void pn532_reader_use(uint8_t reader);
+
+/**@brief Reader the driver calls go to. */
+uint8_t pn532_reader_in_use(void);
+
+/**@brief Poll for an ISO14443A card on every reader at once.
+ *
+ * @details InListPassiveTarget is started on each reader in turn and the bus is free while the
+ *          chips search their fields, so the readers poll in parallel and the burst takes about
+ *          as long as on one reader. The answers are collected as the IRQ lines drop; readers
+ *          that have not answered when @p timeout_ms runs out get their command aborted.
+ *          The RF mode of every reader must already be ISO14443A.
+ *
+ * @param[in] timeout_ms  Deadline of the burst.
+ * @param[in] handler     Called for each reader that found a card.
+ *
+ * @return Number of readers that found a card. Reader 0 is selected on return.
+ */
+uint8_t pn532_reader_list(uint16_t timeout_ms, pn532_reader_list_handler_t handler);
+
+#endif
@@ -0,0 +1,77 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_RETRY)
+#include "pn532_retry.h"
+#include "nrf_delay.h"
+#include "dev_cfg.h"
+
+
+pn532_retry_class_t pn532_retry_classify(uint8_t status)
+{
+    switch (status)
+    {
+        case 0:
+            return PN532_RETRY_CLASS_NONE;
+
+        case PN532_STATUS_NO_FRAME:
+        case PN532_STATUS_TIMEOUT:
+        case PN532_STATUS_CRC:
+        case PN532_STATUS_PARITY:
+        case PN532_STATUS_BIT_COUNT:
+        case PN532_STATUS_FRAMING:
+        case PN532_STATUS_COLLISION:
+        case PN532_STATUS_RF_OVERFLOW:
+        case PN532_STATUS_RF_PROTOCOL:
+            return PN532_RETRY_CLASS_TRANSIENT;
+
+        case PN532_STATUS_AUTH:
+            return PN532_RETRY_CLASS_AUTH;
+
+        case PN532_STATUS_WRONG_CARD:
+        case PN532_STATUS_CARD_GONE:
+            return PN532_RETRY_CLASS_GONE;
+
+        default:
+            return PN532_RETRY_CLASS_FATAL;
+    }
+}
+
+
+uint8_t pn532_retry_reselect(void)
+{
+    uint8_t tg = pn532_reader_current()->tg;
+    uint8_t status;
+
+    // Halting first, InSelect alone may be answered from the target table.
+    status = inDeselect(tg);
+    if (status == 0)
+    {
+        status = inSelect(tg);
+    }
+    return status;
+}
+
+
+bool pn532_retry_recover(uint8_t * p_tries)
+{
+    uint8_t status = pn532_exchange_status();
+
+    while ((pn532_retry_classify(status) == PN532_RETRY_CLASS_TRANSIENT) &&
+           (*p_tries < DEV_CFG_GET(retry_max, PN532_RETRY_MAX)))
+    {
+        if (*p_tries > 0)
+        {
+            // A card on the edge of the field may have moved closer by then.
+            nrf_delay_ms(DEV_CFG_GET(retry_backoff_ms, PN532_RETRY_BACKOFF_MS) << (*p_tries - 1));
+        }
+        (*p_tries)++;
+
+        status = pn532_retry_reselect();
+        if (status == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_RETRY)
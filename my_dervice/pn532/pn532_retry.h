@@ -0,0 +1,51 @@
+#ifndef __PN532_RETRY_H__
+#define __PN532_RETRY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pn532_i2c.h"
+
+/* Recovery from a failed exchange with the selected card, without a new poll of the field:
+ *
+ *   class      what the status of the exchange (pn532_exchange_status) says about the card
+ *   reselect   InDeselect and InSelect: HLTA, then WUPA and SELECT with the known UID; a
+ *              Classic card that saw an error is idle and has forgotten its authentication,
+ *              this gets it back to ACTIVE with no anticollision
+ *   retry      only transient errors, the first one right away, then after
+ *              PN532_RETRY_BACKOFF_MS, doubled each time, up to PN532_RETRY_MAX tries
+ *
+ * A wrong key, a different card or one that is gone are final: trying again would only hold
+ * up the answer. */
+
+/**@brief What a failed exchange says about the card. */
+typedef enum
+{
+    PN532_RETRY_CLASS_NONE,       /**< No error. */
+    PN532_RETRY_CLASS_TRANSIENT,  /**< No answer or a garbled one: timeout, CRC, parity, framing. */
+    PN532_RETRY_CLASS_AUTH,       /**< The card refused the key. */
+    PN532_RETRY_CLASS_GONE,       /**< The card left or another one answered. */
+    PN532_RETRY_CLASS_FATAL,      /**< The command itself was wrong, repeating it fails too. */
+} pn532_retry_class_t;
+
+/**@brief Class of a PN532 status byte, PN532_STATUS_NO_FRAME included. */
+pn532_retry_class_t pn532_retry_classify(uint8_t status);
+
+/**@brief Wake the selected target again with its known UID.
+ *
+ * @return The PN532 status byte, 0 if the card is active again.
+ */
+uint8_t pn532_retry_reselect(void);
+
+/**@brief After a failed exchange: whether to try it again.
+ *
+ * @details For a transient error the card is reselected, after the backoff of the try. The
+ *          caller authenticates again before it repeats a Mifare Classic command.
+ *
+ * @param[in,out] p_tries  Tries made for the exchange, 0 for its first failure; counts the
+ *                         reselects.
+ *
+ * @return true if the card is active again and the exchange is worth another try.
+ */
+bool pn532_retry_recover(uint8_t * p_tries);
+
+#endif
@@ -0,0 +1,90 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_SAM)
+#include "pn532_sam.h"
+#include "pn532_isodep.h"
+#include "pn532_i2c.h"
+
+#if !NRF_MODULE_ENABLED(PN532_ISODEP)
+#error "pn532_sam talks to the SAM with ISO-DEP, it needs PN532_ISODEP_ENABLED"
+#endif
+
+#define SAM_LIST_TIMEOUT_MS     100     /**< The SAM is on the wire, it answers at once. */
+
+static uint8_t m_sam_tg;                /**< Target number of the SAM, 0 until listed. */
+
+
+void pn532_sam_reset(void)
+{
+    m_sam_tg = 0;
+}
+
+
+uint16_t pn532_sam_sw(uint8_t const * p_rapdu, uint16_t rapdu_len)
+{
+    if (rapdu_len < 2)
+    {
+        return 0;
+    }
+    return ((uint16_t)p_rapdu[rapdu_len - 2] << 8) | p_rapdu[rapdu_len - 1];
+}
+
+
+ret_code_t pn532_sam_apdu(uint8_t const * p_capdu,
+                          uint16_t        capdu_len,
+                          uint8_t       * p_rapdu,
+                          uint16_t      * p_rapdu_len)
+{
+    pn532_reader_t * p_reader  = pn532_reader_current();
+    uint8_t          card_tg   = p_reader->tg;
+    uint8_t          psl_speed = p_reader->psl_speed;
+    bool             psl_open  = p_reader->psl_open;
+    pn532_target_t   sam;
+    ret_code_t       err_code  = NRF_SUCCESS;
+
+    if (!pn532_sam_wired(true))
+    {
+        pn532_rf_mode_invalidate();
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if (m_sam_tg == 0)
+    {
+        if ((readPassiveTargets(PN532_MIFARE_ISO14443A, &sam, 1, SAM_LIST_TIMEOUT_MS) == 0) ||
+            (sam.ats_len == 0))
+        {
+            err_code = NRF_ERROR_NOT_FOUND;
+        }
+        else
+        {
+            m_sam_tg = sam.tg;
+        }
+    }
+
+    if (err_code == NRF_SUCCESS)
+    {
+        pn532_target_select(m_sam_tg);
+        p_reader->psl_speed = 0;
+        p_reader->psl_open  = false;
+        err_code = pn532_isodep_transceive(p_capdu, capdu_len, p_rapdu, p_rapdu_len);
+        if (err_code != NRF_SUCCESS)
+        {
+            // Listed again next time, in case the SAM was reset.
+            m_sam_tg = 0;
+        }
+    }
+
+    // Back to the card, with what its activation left.
+    pn532_target_select(card_tg);
+    p_reader->psl_speed = psl_speed;
+    p_reader->psl_open  = psl_open;
+
+    if (!pn532_sam_wired(false))
+    {
+        // The next pn532_rf_mode_set() sends the whole setup again.
+        pn532_rf_mode_invalidate();
+        return NRF_ERROR_INVALID_STATE;
+    }
+    return err_code;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_SAM)
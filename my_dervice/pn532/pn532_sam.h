@@ -0,0 +1,52 @@
+#ifndef __PN532_SAM_H__
+#define __PN532_SAM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* A secure access module (MIFARE SAM AV2 or AV3) on the S2C pins of the PN532, so the card keys
+ * stay in certified storage and the key derivation runs in the SAM:
+ *
+ *   mode      PN532_SAM_MODE is what SAMConfiguration puts the chip in after power up: normal
+ *             when the SAM is only used by the lock, virtual or dual card when an outside reader
+ *             talks to the SAM through the antenna of the lock
+ *   apdu      pn532_sam_apdu() switches the chip to wired card mode, lists the SAM as an
+ *             ISO14443-4 A target the first time, exchanges the APDU with InDataExchange as with
+ *             a card, and switches back with the card selected again. A card lost over the
+ *             switch answers its next exchange with a timeout, and the caller starts over
+ *   auth      pn532_desfire_authenticate_sam() relays EV1 AuthenticateAES between the card and
+ *             SAM_AuthenticatePICC, with the diversification of the SAM, and takes the session
+ *             key with SAM_DumpSessionKey for the secure messaging of pn532_desfire. The key
+ *             entry of the SAM must allow the dump and use without host authentication
+ *
+ * The SAM stays listed until pn532_sam_reset(), which a reader that was powered down needs. */
+
+#define PN532_SAM_CLA               0x80    /**< Class of the SAM commands. */
+#define PN532_SAM_SW_OK             0x9000
+#define PN532_SAM_SW_MORE           0x90AF  /**< The SAM expects a second part. */
+
+/**@brief Forget the SAM target; it is listed again with the next APDU. */
+void pn532_sam_reset(void);
+
+/**@brief Exchange one APDU with the SAM.
+ *
+ * @param[in]     p_capdu      Encoded C-APDU.
+ * @param[in]     capdu_len    C-APDU length.
+ * @param[out]    p_rapdu      Receives the R-APDU with SW1 SW2.
+ * @param[in,out] p_rapdu_len  In: size of @p p_rapdu. Out: R-APDU length.
+ *
+ * @retval NRF_SUCCESS              R-APDU received; its status word is the caller's.
+ * @retval NRF_ERROR_NOT_FOUND      No SAM answered in wired card mode.
+ * @retval NRF_ERROR_INVALID_STATE  The chip did not take a SAMConfiguration.
+ * @return Otherwise as for pn532_isodep_transceive().
+ */
+ret_code_t pn532_sam_apdu(uint8_t const * p_capdu,
+                          uint16_t        capdu_len,
+                          uint8_t       * p_rapdu,
+                          uint16_t      * p_rapdu_len);
+
+/**@brief Status word at the end of an R-APDU, 0 if it is too short. */
+uint16_t pn532_sam_sw(uint8_t const * p_rapdu, uint16_t rapdu_len);
+
+#endif
@@ -0,0 +1,192 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_SCAN)
+#include "pn532_scan.h"
+#include "pn532_async.h"
+#include "pn532_i2c.h"
+#include "frame_pool.h"
+#include <string.h>
+
+#define POLLNR_ENDLESS 0xFF
+#define RESP_LEN       PN532_ASYNC_FRAME_MAX_LEN
+
+static bool                 m_active;
+static bool                 m_poll_in_flight;
+static uint8_t              m_poll_cmd[3 + PN532_SCAN_MAX_TYPES];
+static uint8_t              m_poll_cmd_len;
+static uint8_t *            mp_resp;        /**< Frame from frame_pool while a poll is in flight. */
+static pn532_scan_handler_t m_handler;
+
+static void poll_start(void);
+
+
+/**@brief Split an InAutoPoll response into targets.
+ *
+ * @details Layout after the frame header: D5 61 NbTg, then per target Type, Len, TargetData.
+ */
+static void poll_parse(pn532_scan_evt_t * p_evt)
+{
+    uint8_t const * p_resp = mp_resp;
+    uint8_t         end    = 5 + p_resp[3];
+    uint8_t         pos    = 8;
+
+    if (end > RESP_LEN - 2)
+    {
+        end = RESP_LEN - 2;
+    }
+
+    if ((p_resp[5] != PN532_PN532TOHOST) || (p_resp[6] != PN532_COMMAND_INAUTOPOLL + 1))
+    {
+        p_evt->result = NRF_ERROR_INVALID_DATA;
+        return;
+    }
+
+    while ((p_evt->target_count < p_resp[7]) &&
+           (p_evt->target_count < PN532_SCAN_MAX_TARGETS) &&
+           (pos + 2 <= end))
+    {
+        pn532_scan_target_t * p_target = &p_evt->targets[p_evt->target_count];
+
+        p_target->type     = p_resp[pos];
+        p_target->data_len = p_resp[pos + 1];
+        p_target->p_data   = &p_resp[pos + 2];
+        pos += 2 + p_target->data_len;
+        if (pos > end)
+        {
+            break;
+        }
+        p_evt->target_count++;
+    }
+}
+
+
+static void poll_done(ret_code_t result, void * p_context)
+{
+    pn532_scan_evt_t evt;
+
+    UNUSED_PARAMETER(p_context);
+
+    m_poll_in_flight = false;
+    if (!m_active)
+    {
+        frame_pool_free(mp_resp);
+        mp_resp = NULL;
+        return;
+    }
+
+    memset(&evt, 0, sizeof(evt));
+    evt.result = result;
+    if (result == NRF_SUCCESS)
+    {
+        poll_parse(&evt);
+    }
+
+    // An empty endless poll means the chip gave up, just re-arm.
+    if ((evt.result != NRF_SUCCESS) || (evt.target_count != 0))
+    {
+        m_handler(&evt);
+    }
+
+    // The targets point into the frame, it goes back once the handler is done with them.
+    frame_pool_free(mp_resp);
+    mp_resp = NULL;
+
+    if (m_active)
+    {
+        poll_start();
+    }
+}
+
+
+static void poll_start(void)
+{
+    ret_code_t err_code = NRF_ERROR_NO_MEM;
+
+    mp_resp = frame_pool_alloc();
+    if (mp_resp != NULL)
+    {
+        err_code = pn532_cmd_start(m_poll_cmd, m_poll_cmd_len, mp_resp, RESP_LEN,
+                                   0, poll_done, NULL);
+    }
+    if (err_code == NRF_SUCCESS)
+    {
+        m_poll_in_flight = true;
+    }
+    else
+    {
+        pn532_scan_evt_t evt;
+
+        frame_pool_free(mp_resp);
+        mp_resp = NULL;
+
+        memset(&evt, 0, sizeof(evt));
+        evt.result = err_code;
+        m_active   = false;
+        m_handler(&evt);
+    }
+}
+
+
+ret_code_t pn532_scan_start(uint8_t const *      p_types,
+                            uint8_t              type_count,
+                            uint8_t              period,
+                            pn532_scan_handler_t handler)
+{
+    if (m_active)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if ((p_types == NULL) || (handler == NULL) ||
+        (type_count == 0) || (type_count > PN532_SCAN_MAX_TYPES) ||
+        (period == 0) || (period > 0x0F))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    // SAMConfiguration must have been sent; InAutoPoll programs the CIU for each type itself.
+    if (!pn532_rf_mode_set(PN532_RF_MODE_ISO14443A))
+    {
+        return NRF_ERROR_INTERNAL;
+    }
+
+    m_poll_cmd[0] = PN532_COMMAND_INAUTOPOLL;
+    m_poll_cmd[1] = POLLNR_ENDLESS;
+    m_poll_cmd[2] = period;
+    memcpy(&m_poll_cmd[3], p_types, type_count);
+    m_poll_cmd_len = 3 + type_count;
+
+    m_handler = handler;
+    m_active  = true;
+    poll_start();
+
+    return NRF_SUCCESS;
+}
+
+
+void pn532_scan_stop(void)
+{
+    static uint8_t const ack_frame[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+
+    if (!m_active)
+    {
+        return;
+    }
+    m_active = false;
+
+    if (m_poll_in_flight)
+    {
+        m_poll_in_flight = false;
+        // An ACK frame from the host aborts the command the PN532 is executing.
+        pn532_cmd_abort();
+        UNUSED_RETURN_VALUE(pn532_bus_write(ack_frame, sizeof(ack_frame)));
+        frame_pool_free(mp_resp);
+        mp_resp = NULL;
+    }
+}
+
+
+bool pn532_scan_is_active(void)
+{
+    return m_active;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_SCAN)
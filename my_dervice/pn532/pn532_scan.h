@@ -0,0 +1,71 @@
+#ifndef __PN532_SCAN_H__
+#define __PN532_SCAN_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/**@brief InAutoPoll target types. */
+#define PN532_SCAN_TYPE_106A       0x00  /**< Generic passive 106 kbps ISO14443A. */
+#define PN532_SCAN_TYPE_FELICA_212 0x01  /**< Generic passive 212 kbps FeliCa. */
+#define PN532_SCAN_TYPE_FELICA_424 0x02  /**< Generic passive 424 kbps FeliCa. */
+#define PN532_SCAN_TYPE_106B       0x03  /**< Passive 106 kbps ISO14443B. */
+#define PN532_SCAN_TYPE_JEWEL      0x04  /**< Innovision Jewel. */
+
+#define PN532_SCAN_MAX_TYPES       15    /**< InAutoPoll accepts up to 15 types per poll. */
+#define PN532_SCAN_MAX_TARGETS     2     /**< InAutoPoll reports at most two targets. */
+
+/**@brief One target reported by InAutoPoll. */
+typedef struct
+{
+    uint8_t         type;      /**< Target type, one of PN532_SCAN_TYPE_*. */
+    uint8_t         data_len;  /**< Length of @p p_data. */
+    uint8_t const * p_data;    /**< Target data as defined for InListPassiveTarget (Tg first), valid until the handler returns. */
+} pn532_scan_target_t;
+
+/**@brief Scan event, valid only for the duration of the handler call. */
+typedef struct
+{
+    ret_code_t          result;                          /**< NRF_SUCCESS or the error that ended the poll. */
+    uint8_t             target_count;                    /**< Number of entries in @p targets. */
+    pn532_scan_target_t targets[PN532_SCAN_MAX_TARGETS]; /**< Detected targets. */
+} pn532_scan_evt_t;
+
+/**@brief Scan event handler, called from the main loop.
+ *
+ * @details The scan is re-armed after the handler returns. Call @ref pn532_scan_stop from the
+ *          handler to keep the field for commands to the detected card; commands queued from the
+ *          handler run before the poll is re-armed.
+ */
+typedef void (*pn532_scan_handler_t)(pn532_scan_evt_t const * p_evt);
+
+/**@brief Start continuous background scanning with InAutoPoll.
+ *
+ * @details The PN532 polls the field on its own and only raises its IRQ line when a target has
+ *          been found, so the TWI bus is idle and the nRF51 sleeps between detections.
+ *
+ * @param[in] p_types     Target types to poll for, PN532_SCAN_TYPE_*.
+ * @param[in] type_count  Number of entries in @p p_types (1..PN532_SCAN_MAX_TYPES).
+ * @param[in] period      Time between polls of one type, in units of 150 ms (1..15).
+ * @param[in] handler     Detection handler.
+ *
+ * @retval NRF_SUCCESS              Scanning started.
+ * @retval NRF_ERROR_INVALID_PARAM  Bad type list or period.
+ * @retval NRF_ERROR_INVALID_STATE  Already scanning.
+ */
+ret_code_t pn532_scan_start(uint8_t const *      p_types,
+                            uint8_t              type_count,
+                            uint8_t              period,
+                            pn532_scan_handler_t handler);
+
+/**@brief Stop scanning.
+ *
+ * @details A poll in flight is aborted by sending an ACK frame to the chip, which also drops any
+ *          command queued behind it. Called from the scan handler it only disarms the scan.
+ */
+void pn532_scan_stop(void);
+
+/**@brief Whether background scanning is active. */
+bool pn532_scan_is_active(void);
+
+#endif
@@ -0,0 +1,1087 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_SIM)
+#include "pn532_sim.h"
+#include "pn532_i2c.h"
+#include "app_timer.h"
+#if NRF_MODULE_ENABLED(CRC16)
+#include "crc16.h"
+#endif
+#if NRF_MODULE_ENABLED(CRC32)
+#include "crc32.h"
+#endif
+#include <stdio.h>
+#include <string.h>
+
+#define BODY_MAX            (PN532_TWI_MAX_READ - PN532_FRAME_OVERHEAD)  /**< TFI not included. */
+#define LATENCY_OVERRIDES   8
+
+#define MFC_BLOCKS          64
+#define NTAG213_PAGES       45
+#define TOPAZ512_BLOCKS     64
+#define TOPAZ512_HR1        0x4C
+
+#define STATUS_OK           0x00
+#define STATUS_TIMEOUT      0x01    /**< The card did not answer. */
+#define STATUS_CRC          0x02
+#define STATUS_AUTH_ERROR   0x14
+
+typedef enum
+{
+    SIM_IDLE,       /**< Nothing to read, IRQ high. */
+    SIM_ACK,        /**< Command taken, the ACK frame is waiting. */
+    SIM_RESP,       /**< The response frame is waiting. */
+    SIM_POLL,       /**< InAutoPoll with no card; the chip keeps polling. */
+} sim_state_t;
+
+typedef struct
+{
+    uint8_t  cmd;
+    uint32_t us;
+} sim_latency_t;
+
+static bool               m_active;
+static sim_state_t        m_state;
+static pn532_sim_card_t   m_card;
+static uint8_t            m_uid[8];
+static uint8_t            m_uid_len;
+static uint8_t            m_mem[MFC_BLOCKS * 16];
+static int16_t            m_auth_sector;     /**< Authenticated MIFARE sector, -1 for none. */
+static int32_t            m_value;           /**< MIFARE transfer buffer. */
+static uint8_t            m_value_addr;      /**< Address byte of the source block, kept on transfer. */
+static bool               m_value_valid;
+static uint8_t            m_out[PN532_TWI_MAX_READ];
+static uint16_t           m_out_len;
+static uint8_t            m_body[BODY_MAX];  /**< Response code, then data. */
+static pn532_sim_stats_t  m_stats;
+static sim_latency_t      m_latency[LATENCY_OVERRIDES];
+static pn532_sim_faults_t m_faults;
+static uint32_t           m_rand;
+
+static uint8_t const m_ack_frame[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+static uint8_t const m_nack_frame[] = {0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00};
+
+
+/**@brief Time a real PN532 takes to answer, taken from the data sheet and measurements. */
+static uint32_t latency_get(uint8_t cmd, uint8_t const * p_data)
+{
+    for (uint8_t i = 0; i < LATENCY_OVERRIDES; i++)
+    {
+        if ((m_latency[i].us != 0) && (m_latency[i].cmd == cmd))
+        {
+            return m_latency[i].us;
+        }
+    }
+
+    switch (cmd)
+    {
+        case PN532_COMMAND_INLISTPASSIVETARGET:
+            return (m_card == PN532_SIM_CARD_NONE) ? 5000 : 3000;
+
+        case PN532_COMMAND_INDATAEXCHANGE:
+            return ((p_data[1] == MIFARE_CMD_AUTH_A) || (p_data[1] == MIFARE_CMD_AUTH_B)) ? 2500 : 1500;
+
+        case PN532_COMMAND_INCOMMUNICATETHRU:
+            return 1500;
+
+        case PN532_COMMAND_INSELECT:
+        case PN532_COMMAND_INDESELECT:
+        case PN532_COMMAND_INRELEASE:
+        case PN532_COMMAND_DIAGNOSE:
+            return 1000;
+
+        default:
+            return 300;
+    }
+}
+
+
+/**@brief Next of the xorshift32 sequence started by the seed of pn532_sim_faults_set. */
+static uint32_t rand_next(void)
+{
+    m_rand ^= m_rand << 13;
+    m_rand ^= m_rand >> 17;
+    m_rand ^= m_rand << 5;
+    return m_rand;
+}
+
+
+/**@brief Whether to inject a fault of @p per_mille rate now. */
+static bool fault_roll(uint16_t per_mille)
+{
+    if ((per_mille == 0) || ((rand_next() % 1000) >= per_mille))
+    {
+        return false;
+    }
+    m_stats.faults++;
+    return true;
+}
+
+
+/**@brief @p us spread by the configured jitter. */
+static uint32_t jitter_add(uint32_t us)
+{
+    uint32_t spread;
+
+    if (m_faults.jitter_pct == 0)
+    {
+        return us;
+    }
+    spread = us * m_faults.jitter_pct / 100;
+    return us - spread + (rand_next() % (2 * spread + 1));
+}
+
+
+/**@brief An injected RF error in place of the answer of the card. */
+static bool rf_fault(void)
+{
+    if (fault_roll(m_faults.rf_timeout))
+    {
+        m_body[1] = STATUS_TIMEOUT;
+    }
+    else if (fault_roll(m_faults.rf_crc))
+    {
+        m_body[1] = STATUS_CRC;
+    }
+    else
+    {
+        return false;
+    }
+    // A Classic card that saw an error goes idle, its authentication is gone.
+    m_auth_sector = -1;
+    return true;
+}
+
+
+static void time_add(uint32_t us)
+{
+    m_stats.virtual_us += us;
+}
+
+
+#if PN532_TRANSPORT == PN532_TRANSPORT_SPI
+#define BUS_US(bytes)  (((uint32_t)(bytes) + 1) * 2)       /**< 8 clocks per byte at 4 MHz, opcode included. */
+#elif PN532_TRANSPORT == PN532_TRANSPORT_HSU
+#define BUS_US(bytes)  ((uint32_t)(bytes) * 868 / 10)      /**< 10 bits per byte at 115200 baud. */
+#else
+#define BUS_US(bytes)  (((uint32_t)(bytes) + 1) * 45 / 2)  /**< 9 clocks per byte at 400 kHz, address included. */
+#endif
+
+/**@brief Bus time of one transfer over the configured PN532_TRANSPORT. */
+static void bus_add(uint16_t bytes)
+{
+    m_stats.transfers++;
+    time_add(BUS_US(bytes));
+}
+
+
+static uint16_t crc_b(uint8_t const * p_data, uint16_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    while (len--)
+    {
+        uint8_t b = *p_data++ ^ (uint8_t)crc;
+        b   ^= (uint8_t)(b << 4);
+        crc  = (crc >> 8) ^ ((uint16_t)b << 8) ^ ((uint16_t)b << 3) ^ (b >> 4);
+    }
+    return (uint16_t)~crc;
+}
+
+
+/**@brief Frame the response in m_body, len bytes from the response code on. */
+static void resp_set(uint16_t len)
+{
+    uint8_t dcs = PN532_PN532TOHOST;
+
+    m_out[0] = PN532_PREAMBLE;
+    m_out[1] = PN532_STARTCODE1;
+    m_out[2] = PN532_STARTCODE2;
+    m_out[3] = (uint8_t)(len + 1);
+    m_out[4] = (uint8_t)(~(len + 1) + 1);
+    m_out[5] = PN532_PN532TOHOST;
+    memcpy(&m_out[6], m_body, len);
+    for (uint16_t i = 0; i < len; i++)
+    {
+        dcs += m_body[i];
+    }
+    m_out[6 + len] = (uint8_t)(~dcs + 1);
+    m_out[7 + len] = PN532_POSTAMBLE;
+    m_out_len      = len + PN532_FRAME_OVERHEAD;
+}
+
+
+static void card_reset(void)
+{
+    static uint8_t const mfc_uid[]   = {0xDE, 0xAD, 0xBE, 0xEF};
+    static uint8_t const ntag_uid[]  = {0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+    static uint8_t const typeb_uid[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+    static uint8_t const topaz_uid[] = {0x3B, 0x21, 0x43, 0x65};
+    // CC, then the Lock and Memory Control TLVs of block 0x0F, an empty NDEF Message, Terminator.
+    static uint8_t const topaz_fmt[] = {0xE1, 0x10, 0x3F, 0x00,
+                                        0x01, 0x03, 0xF2, 0x30, 0x33, 0x02, 0x03, 0xF0, 0x02, 0x03,
+                                        0x03, 0x00, 0xFE};
+    static uint8_t const trailer[]   = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x07, 0x80, 0x69,
+                                        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+    memset(m_mem, 0, sizeof(m_mem));
+    m_auth_sector = -1;
+    m_value_valid = false;
+
+    switch (m_card)
+    {
+        case PN532_SIM_CARD_MIFARE_1K:
+            memcpy(m_uid, mfc_uid, sizeof(mfc_uid));
+            m_uid_len = sizeof(mfc_uid);
+            memcpy(m_mem, m_uid, 4);
+            m_mem[4] = m_uid[0] ^ m_uid[1] ^ m_uid[2] ^ m_uid[3];
+            m_mem[5] = 0x08;
+            for (uint8_t block = 3; block < MFC_BLOCKS; block += 4)
+            {
+                memcpy(&m_mem[block * 16], trailer, sizeof(trailer));
+            }
+            break;
+
+        case PN532_SIM_CARD_NTAG213:
+            memcpy(m_uid, ntag_uid, sizeof(ntag_uid));
+            m_uid_len = sizeof(ntag_uid);
+            // UID with its two check bytes, then the capability container.
+            m_mem[0] = m_uid[0];
+            m_mem[1] = m_uid[1];
+            m_mem[2] = m_uid[2];
+            m_mem[3] = 0x88 ^ m_uid[0] ^ m_uid[1] ^ m_uid[2];
+            memcpy(&m_mem[4], &m_uid[3], 4);
+            m_mem[8]  = m_uid[3] ^ m_uid[4] ^ m_uid[5] ^ m_uid[6];
+            m_mem[12] = 0xE1;
+            m_mem[13] = 0x10;
+            m_mem[14] = 0x12;
+            break;
+
+        case PN532_SIM_CARD_TYPE_B:
+            memcpy(m_uid, typeb_uid, sizeof(typeb_uid));
+            m_uid_len = sizeof(typeb_uid);
+            break;
+
+        case PN532_SIM_CARD_TOPAZ512:
+            memcpy(m_uid, topaz_uid, sizeof(topaz_uid));
+            m_uid_len = sizeof(topaz_uid);
+            memcpy(m_mem, m_uid, JEWEL_ID_LEN);
+            memcpy(&m_mem[JEWEL_BLOCK_LEN], topaz_fmt, sizeof(topaz_fmt));
+            break;
+
+        default:
+            m_uid_len = 0;
+            break;
+    }
+}
+
+
+/**@brief InListPassiveTarget and InAutoPoll target data: Tg, SENS_RES, SEL_RES, NFCID. */
+static uint16_t target_a_put(uint8_t * p_out)
+{
+    bool mfc = (m_card == PN532_SIM_CARD_MIFARE_1K);
+
+    p_out[0] = 1;
+    p_out[1] = 0x00;
+    p_out[2] = mfc ? 0x04 : 0x44;
+    p_out[3] = mfc ? 0x08 : 0x00;
+    p_out[4] = m_uid_len;
+    memcpy(&p_out[5], m_uid, m_uid_len);
+    return 5 + m_uid_len;
+}
+
+
+static bool card_is_a(void)
+{
+    return (m_card == PN532_SIM_CARD_MIFARE_1K) || (m_card == PN532_SIM_CARD_NTAG213);
+}
+
+
+/**@brief Card part of InDataExchange and InCommunicateThru: status and answer after m_body[0]. */
+static uint16_t card_exchange(uint8_t const * p_req, uint16_t len)
+{
+    uint8_t * p_ans = &m_body[2];
+
+    m_body[1] = STATUS_TIMEOUT;
+    if (len == 0)
+    {
+        return 2;
+    }
+
+    if (m_card == PN532_SIM_CARD_MIFARE_1K)
+    {
+        uint8_t block = (len > 1) ? p_req[1] : 0;
+
+        if (block >= MFC_BLOCKS)
+        {
+            return 2;
+        }
+        switch (p_req[0])
+        {
+            case MIFARE_CMD_AUTH_A:
+            case MIFARE_CMD_AUTH_B:
+            {
+                uint8_t const * p_key = &m_mem[(block | 3) * 16 + ((p_req[0] == MIFARE_CMD_AUTH_A) ? 0 : 10)];
+
+                m_auth_sector = -1;
+                if ((len >= 12) && (memcmp(&p_req[2], p_key, 6) == 0) &&
+                    (memcmp(&p_req[8], &m_uid[m_uid_len - 4], 4) == 0))
+                {
+                    m_auth_sector = block / 4;
+                    m_body[1]     = STATUS_OK;
+                }
+                else
+                {
+                    m_body[1] = STATUS_AUTH_ERROR;
+                }
+                return 2;
+            }
+
+            case MIFARE_CMD_READ:
+                if (m_auth_sector == block / 4)
+                {
+                    memcpy(p_ans, &m_mem[block * 16], 16);
+                    m_body[1] = STATUS_OK;
+                    return 2 + 16;
+                }
+                return 2;
+
+            case MIFARE_CMD_WRITE:
+                if ((m_auth_sector == block / 4) && (len >= 18))
+                {
+                    memcpy(&m_mem[block * 16], &p_req[2], 16);
+                    m_body[1] = STATUS_OK;
+                }
+                return 2;
+
+            case MIFARE_CMD_INCREMENT:
+            case MIFARE_CMD_DECREMENT:
+            case MIFARE_CMD_STORE:
+            {
+                int32_t value;
+
+                // The result waits in the transfer buffer; a bad value block fails the command.
+                m_value_valid = false;
+                if ((m_auth_sector == block / 4) && (len >= 6) &&
+                    mifareclassic_ValueBlockDecode(&m_mem[block * 16], &value, &m_value_addr))
+                {
+                    uint32_t delta = uint32_decode(&p_req[2]);
+
+                    m_value       = (p_req[0] == MIFARE_CMD_INCREMENT) ? value + (int32_t)delta :
+                                    (p_req[0] == MIFARE_CMD_DECREMENT) ? value - (int32_t)delta : value;
+                    m_value_valid = true;
+                    m_body[1]     = STATUS_OK;
+                }
+                return 2;
+            }
+
+            case MIFARE_CMD_TRANSFER:
+                if ((m_auth_sector == block / 4) && m_value_valid)
+                {
+                    mifareclassic_ValueBlockEncode(m_value, m_value_addr, &m_mem[block * 16]);
+                    m_value_valid = false;
+                    m_body[1]     = STATUS_OK;
+                }
+                return 2;
+
+            default:
+                return 2;
+        }
+    }
+
+    if (m_card == PN532_SIM_CARD_NTAG213)
+    {
+        static uint8_t const version[] = {0x00, 0x04, 0x04, 0x02, 0x01, 0x00, 0x0F, 0x03};
+
+        switch (p_req[0])
+        {
+            case MIFARE_CMD_READ:
+                // Four pages, rolling over at the end of the memory.
+                if ((len >= 2) && (p_req[1] < NTAG213_PAGES))
+                {
+                    for (uint8_t i = 0; i < 4; i++)
+                    {
+                        memcpy(&p_ans[4 * i], &m_mem[((p_req[1] + i) % NTAG213_PAGES) * 4], 4);
+                    }
+                    m_body[1] = STATUS_OK;
+                    return 2 + 16;
+                }
+                return 2;
+
+            case NTAG2XX_CMD_FAST_READ:
+                if ((len >= 3) && (p_req[1] <= p_req[2]) && (p_req[2] < NTAG213_PAGES) &&
+                    (2u + 4u * (p_req[2] - p_req[1] + 1) <= BODY_MAX))
+                {
+                    uint16_t n = 4 * (p_req[2] - p_req[1] + 1);
+
+                    memcpy(p_ans, &m_mem[p_req[1] * 4], n);
+                    m_body[1] = STATUS_OK;
+                    return 2 + n;
+                }
+                return 2;
+
+            case MIFARE_ULTRALIGHT_CMD_WRITE:
+                // UID pages are read-only, lock bytes and CC are one-time programmable.
+                if ((len >= 6) && (p_req[1] >= 2) && (p_req[1] < NTAG213_PAGES))
+                {
+                    uint8_t * p_page = &m_mem[p_req[1] * 4];
+
+                    for (uint8_t i = 0; i < 4; i++)
+                    {
+                        if (p_req[1] > 3)
+                        {
+                            p_page[i] = p_req[2 + i];
+                        }
+                        else if ((p_req[1] == 3) || (i >= 2))
+                        {
+                            p_page[i] |= p_req[2 + i];
+                        }
+                    }
+                    m_body[1] = STATUS_OK;
+                }
+                return 2;
+
+            case NTAG2XX_CMD_GET_VERSION:
+                memcpy(p_ans, version, sizeof(version));
+                m_body[1] = STATUS_OK;
+                return 2 + sizeof(version);
+
+            default:
+                return 2;
+        }
+    }
+
+    if (m_card == PN532_SIM_CARD_TOPAZ512)
+    {
+        // JEWELID closes every command.
+        if ((len < 3 + JEWEL_ID_LEN) || (memcmp(&p_req[len - JEWEL_ID_LEN], m_uid, JEWEL_ID_LEN) != 0))
+        {
+            return 2;
+        }
+
+        switch (p_req[0])
+        {
+            case JEWEL_CMD_RALL:
+                p_ans[0] = JEWEL_HR0_DYNAMIC;
+                p_ans[1] = TOPAZ512_HR1;
+                memcpy(&p_ans[2], m_mem, JEWEL_RALL_LEN - 2);
+                m_body[1] = STATUS_OK;
+                return 2 + JEWEL_RALL_LEN;
+
+            case JEWEL_CMD_READ8:
+                if ((len == 2 + JEWEL_BLOCK_LEN + JEWEL_ID_LEN) && (p_req[1] < TOPAZ512_BLOCKS))
+                {
+                    p_ans[0] = p_req[1];
+                    memcpy(&p_ans[1], &m_mem[p_req[1] * JEWEL_BLOCK_LEN], JEWEL_BLOCK_LEN);
+                    m_body[1] = STATUS_OK;
+                    return 2 + 1 + JEWEL_BLOCK_LEN;
+                }
+                return 2;
+
+            default:
+                return 2;
+        }
+    }
+
+    if ((m_card == PN532_SIM_CARD_TYPE_B) && (len > 2) &&
+        (crc_b(p_req, len - 2) == uint16_decode(&p_req[len - 2])))
+    {
+        uint16_t n = 0;
+        uint16_t crc;
+
+        if ((p_req[0] == TYPEB_APF) && (len == 5))
+        {
+            // ATQB in the first slot: PUPI, application data, protocol info (106 kbps,
+            // FSCI 8, ISO14443-4, FWI 7, CID supported).
+            p_ans[n++] = 0x50;
+            memcpy(&p_ans[n], m_uid, 4);
+            n += 4;
+            memset(&p_ans[n], 0, 4);
+            n += 4;
+            p_ans[n++] = 0x00;
+            p_ans[n++] = 0x81;
+            p_ans[n++] = 0x71;
+        }
+        else if ((p_req[0] == TYPEB_ATTRIB) && (len == 11))
+        {
+            p_ans[n++] = p_req[8] & 0x0F;
+        }
+        else if (p_req[0] == TYPEB_HLTB)
+        {
+            p_ans[n++] = 0x00;
+        }
+        else if ((len == 7) && (p_req[0] == 0x00) && (p_req[1] == 0x36))
+        {
+            memcpy(&p_ans[n], m_uid, 8);
+            n += 8;
+            p_ans[n++] = 0x90;
+            p_ans[n++] = 0x00;
+        }
+        else
+        {
+            return 2;
+        }
+        crc = crc_b(p_ans, n);
+        p_ans[n++] = (uint8_t)crc;
+        p_ans[n++] = (uint8_t)(crc >> 8);
+        m_body[1]  = STATUS_OK;
+        return 2 + n;
+    }
+
+    return 2;
+}
+
+
+/**@brief Run one command; the response goes to m_body. */
+static uint16_t command_run(uint8_t const * p_cmd, uint16_t len)
+{
+    uint8_t cmd = p_cmd[0];
+
+    m_body[0] = cmd + 1;
+
+    switch (cmd)
+    {
+        case PN532_COMMAND_GETFIRMWAREVERSION:
+            m_body[1] = 0x32;
+            m_body[2] = 0x01;
+            m_body[3] = 0x06;
+            m_body[4] = 0x07;
+            return 5;
+
+        case PN532_COMMAND_READREGISTER:
+            memset(&m_body[1], 0, (len - 1) / 2);
+            return 1 + (len - 1) / 2;
+
+        case PN532_COMMAND_POWERDOWN:
+        case PN532_COMMAND_INSELECT:
+            m_body[1] = (m_card == PN532_SIM_CARD_NONE) && (cmd == PN532_COMMAND_INSELECT) ?
+                        STATUS_TIMEOUT : STATUS_OK;
+            return 2;
+
+        case PN532_COMMAND_INDESELECT:
+        case PN532_COMMAND_INRELEASE:
+            m_auth_sector = -1;
+            m_body[1]     = STATUS_OK;
+            return 2;
+
+        case PN532_COMMAND_DIAGNOSE:
+            if ((len >= 2) && (p_cmd[1] == 0x00))
+            {
+                // Communication line test: NumTst and the parameters back.
+                memcpy(&m_body[1], &p_cmd[1], MIN(len - 1, BODY_MAX - 1));
+                return (uint16_t)MIN(len, BODY_MAX);
+            }
+            if ((len >= 2) && (p_cmd[1] == 0x07))
+            {
+                // Antenna self test: the simulated antenna is always in range.
+                m_body[1] = STATUS_OK;
+                return 2;
+            }
+            m_body[1] = (m_card == PN532_SIM_CARD_NONE) ? STATUS_TIMEOUT : STATUS_OK;
+            return 2;
+
+        case PN532_COMMAND_GETGENERALSTATUS:
+            // No error, no external field, no target kept, SAM status.
+            memset(&m_body[1], 0, 4);
+            return 5;
+
+        case PN532_COMMAND_INLISTPASSIVETARGET:
+            m_auth_sector = -1;
+            if ((len >= 3) && (p_cmd[2] == PN532_MIFARE_ISO14443A) && card_is_a())
+            {
+                m_body[1] = 1;
+                return 2 + target_a_put(&m_body[2]);
+            }
+            if ((len >= 3) && (p_cmd[2] == PN532_MIFARE_ISOJEWEL) && (m_card == PN532_SIM_CARD_TOPAZ512))
+            {
+                // Tg, SENS_RES, JEWELID.
+                m_body[1] = 1;
+                m_body[2] = 1;
+                m_body[3] = 0x0C;
+                m_body[4] = 0x00;
+                memcpy(&m_body[5], m_uid, JEWEL_ID_LEN);
+                return 5 + JEWEL_ID_LEN;
+            }
+            // A real chip keeps trying; the host gives up at its deadline all the same.
+            m_body[1] = 0;
+            return 2;
+
+        case PN532_COMMAND_INAUTOPOLL:
+            if (!card_is_a())
+            {
+                return 0;
+            }
+            m_body[1] = 1;
+            m_body[2] = 0x00;
+            m_body[3] = (uint8_t)target_a_put(&m_body[4]);
+            return 4 + m_body[3];
+
+        case PN532_COMMAND_INDATAEXCHANGE:
+            if (rf_fault())
+            {
+                return 2;
+            }
+            // Tg first, only one target is emulated.
+            return (len < 2) ? 2 : card_exchange(&p_cmd[2], len - 2);
+
+        case PN532_COMMAND_INCOMMUNICATETHRU:
+            return rf_fault() ? 2 : card_exchange(&p_cmd[1], len - 1);
+
+        default:
+            // SAMConfiguration, RFConfiguration, SetParameters, WriteRegister, ...: no data.
+            return 1;
+    }
+}
+
+
+/**@brief Take a command frame written by the host.
+ *
+ * @return Latency of the response in us, 0 if none is coming.
+ */
+static uint32_t frame_write(uint8_t const * p_frame, uint16_t len)
+{
+    uint16_t body_len;
+    uint16_t hdr;
+    uint16_t resp_len;
+    uint32_t latency;
+
+    if ((len == sizeof(m_ack_frame)) && (memcmp(p_frame, m_ack_frame, len) == 0))
+    {
+        // ACK from the host aborts the command in progress.
+        m_state = SIM_IDLE;
+        return 0;
+    }
+    if ((len == sizeof(m_nack_frame)) && (memcmp(p_frame, m_nack_frame, len) == 0))
+    {
+        // NACK: the last response once more, the host read only its start.
+        if ((m_state == SIM_IDLE) && (m_out_len != 0))
+        {
+            m_state = SIM_RESP;
+        }
+        return 0;
+    }
+    if ((len < HEADER_SEQUENCE_LENGTH + 1) ||
+        (p_frame[0] != PN532_PREAMBLE) || (p_frame[1] != PN532_STARTCODE1) ||
+        (p_frame[2] != PN532_STARTCODE2))
+    {
+        // Wake up byte or noise.
+        return 0;
+    }
+
+    if ((p_frame[3] == 0xFF) && (p_frame[4] == 0xFF))
+    {
+        body_len = ((uint16_t)p_frame[5] << 8) | p_frame[6];
+        hdr      = EXT_HEADER_SEQUENCE_LENGTH;
+    }
+    else
+    {
+        body_len = p_frame[3];
+        hdr      = HEADER_SEQUENCE_LENGTH;
+    }
+    if ((body_len < 2) || (hdr + body_len > len) || (p_frame[hdr - 1] != PN532_HOSTTOPN532))
+    {
+        return 0;
+    }
+
+    m_stats.commands++;
+    if (fault_roll(m_faults.no_ack))
+    {
+        // Lost on the bus: the host sees neither the ACK nor a response.
+        m_state = SIM_IDLE;
+        return 0;
+    }
+    latency = jitter_add(latency_get(p_frame[hdr], &p_frame[hdr]));
+    time_add(latency);
+
+    resp_len = command_run(&p_frame[hdr], body_len - 1);
+    if (resp_len == 0)
+    {
+        m_state = SIM_POLL;
+        return 0;
+    }
+    resp_set(resp_len);
+    if (fault_roll(m_faults.bad_dcs))
+    {
+        m_out[m_out_len - 2] ^= 0xFF;
+    }
+    m_state = SIM_ACK;
+    return latency;
+}
+
+
+/**@brief Status byte, then the waiting frame; zeros past its end. The frame stays waiting. */
+static uint16_t frame_peek(uint8_t * p_buf, uint16_t len)
+{
+    uint8_t const * p_src;
+    uint16_t        src_len;
+
+    memset(p_buf, 0, len);
+    if (m_state == SIM_ACK)
+    {
+        p_src   = m_ack_frame;
+        src_len = sizeof(m_ack_frame);
+    }
+    else if (m_state == SIM_RESP)
+    {
+        p_src   = m_out;
+        src_len = m_out_len;
+    }
+    else
+    {
+        return MIN(len, 1);
+    }
+    if (len == 0)
+    {
+        return 0;
+    }
+
+    p_buf[0] = PN532_I2C_READY;
+    memcpy(&p_buf[1], p_src, MIN(src_len, len - 1));
+    return MIN(src_len + 1, len);
+}
+
+
+/**@brief The waiting frame has been read: the response follows the ACK. */
+static void frame_take(void)
+{
+    if (m_state == SIM_ACK)
+    {
+        m_state = SIM_RESP;
+    }
+    else if (m_state == SIM_RESP)
+    {
+        m_state = SIM_IDLE;
+    }
+}
+
+
+/**@brief Host read: the waiting frame, which is taken. */
+static void frame_read(uint8_t * p_buf, uint16_t len)
+{
+    if ((frame_peek(p_buf, len) != 0) && (p_buf[0] == PN532_I2C_READY))
+    {
+        frame_take();
+    }
+}
+
+
+ret_code_t pn532_simulator_init(void)
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+    memset(m_latency, 0, sizeof(m_latency));
+#if PN532_SIM_FAULTS_ENABLED
+    {
+        pn532_sim_faults_t faults =
+        {
+            .rf_timeout = PN532_SIM_FAULT_RF_TIMEOUT,
+            .rf_crc     = PN532_SIM_FAULT_RF_CRC,
+            .no_ack     = PN532_SIM_FAULT_NO_ACK,
+            .bad_dcs    = PN532_SIM_FAULT_BAD_DCS,
+            .jitter_pct = PN532_SIM_FAULT_JITTER,
+        };
+        pn532_sim_faults_set(&faults, PN532_SIM_FAULT_SEED);
+    }
+#else
+    pn532_sim_faults_set(NULL, 0);
+#endif
+    m_state  = SIM_IDLE;
+    m_active = true;
+    pn532_sim_card_set(PN532_SIM_CARD_MIFARE_1K, NULL);
+
+    return NRF_SUCCESS;
+}
+
+
+bool pn532_sim_is_active(void)
+{
+    return m_active;
+}
+
+
+void pn532_sim_card_set(pn532_sim_card_t card, uint8_t const * p_uid)
+{
+    m_card = card;
+    card_reset();
+    if ((p_uid != NULL) && (m_uid_len != 0))
+    {
+        memcpy(m_uid, p_uid, m_uid_len);
+        if (card == PN532_SIM_CARD_MIFARE_1K)
+        {
+            memcpy(m_mem, m_uid, 4);
+            m_mem[4] = m_uid[0] ^ m_uid[1] ^ m_uid[2] ^ m_uid[3];
+        }
+        else if (card == PN532_SIM_CARD_TOPAZ512)
+        {
+            memcpy(m_mem, m_uid, JEWEL_ID_LEN);
+        }
+    }
+
+    // A poll waiting for a card is answered now; it is read on the next check of the IRQ line.
+    if ((m_state == SIM_POLL) && card_is_a())
+    {
+        m_body[0] = PN532_COMMAND_INAUTOPOLL + 1;
+        m_body[1] = 1;
+        m_body[2] = 0x00;
+        m_body[3] = (uint8_t)target_a_put(&m_body[4]);
+        resp_set(4 + m_body[3]);
+        m_state = SIM_RESP;
+    }
+}
+
+
+void pn532_sim_latency_set(uint8_t cmd, uint32_t latency_us)
+{
+    sim_latency_t * p_free = NULL;
+
+    for (uint8_t i = 0; i < LATENCY_OVERRIDES; i++)
+    {
+        if ((m_latency[i].us != 0) && (m_latency[i].cmd == cmd))
+        {
+            m_latency[i].us = latency_us;
+            return;
+        }
+        if ((m_latency[i].us == 0) && (p_free == NULL))
+        {
+            p_free = &m_latency[i];
+        }
+    }
+    if ((latency_us != 0) && (p_free != NULL))
+    {
+        p_free->cmd = cmd;
+        p_free->us  = latency_us;
+    }
+}
+
+
+void pn532_sim_faults_set(pn532_sim_faults_t const * p_faults, uint32_t seed)
+{
+    if (p_faults == NULL)
+    {
+        memset(&m_faults, 0, sizeof(m_faults));
+    }
+    else
+    {
+        m_faults = *p_faults;
+    }
+    // xorshift32 never leaves 0.
+    m_rand = (seed != 0) ? seed : 0x2545F491;
+}
+
+
+void pn532_sim_stats_get(pn532_sim_stats_t * p_stats)
+{
+    *p_stats = m_stats;
+}
+
+
+void pn532_sim_stats_reset(void)
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+uint32_t pn532_sim_write(uint8_t const * p_data, uint16_t len)
+{
+    m_stats.transfers++;
+    m_stats.bytes_tx += len;
+    return frame_write(p_data, len);
+}
+
+
+uint16_t pn532_sim_peek(uint8_t * p_buf, uint16_t len)
+{
+    return frame_peek(p_buf, len);
+}
+
+
+void pn532_sim_take(uint16_t len)
+{
+    m_stats.transfers++;
+    m_stats.bytes_rx += len;
+    // A status read alone leaves the frame for the next read.
+    if ((len > 1) && pn532_sim_ready())
+    {
+        frame_take();
+    }
+}
+
+
+bool pn532_sim_ready(void)
+{
+    return (m_state == SIM_ACK) || (m_state == SIM_RESP);
+}
+
+
+ret_code_t pn532_bus_init(void)
+{
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t pn532_bus_write(uint8_t const * p_data, uint8_t len)
+{
+    if (!m_active)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    bus_add(len);
+    m_stats.bytes_tx += len;
+    UNUSED_RETURN_VALUE(frame_write(p_data, len));
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t pn532_bus_read(uint8_t * p_buf, uint8_t len)
+{
+    if (!m_active)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    bus_add(len);
+    m_stats.bytes_rx += len;
+    frame_read(p_buf, len);
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t pn532_bus_write_async(uint8_t const * p_data, uint8_t len, pn532_bus_handler_t handler)
+{
+    ret_code_t err_code = pn532_bus_write(p_data, len);
+
+    // Done at once; the handler only queues a scheduler event.
+    if (err_code == NRF_SUCCESS)
+    {
+        handler(NRF_SUCCESS);
+    }
+    return err_code;
+}
+
+
+ret_code_t pn532_bus_read_async(uint8_t * p_buf, uint8_t len, pn532_bus_handler_t handler)
+{
+    ret_code_t err_code = pn532_bus_read(p_buf, len);
+
+    if (err_code == NRF_SUCCESS)
+    {
+        handler(NRF_SUCCESS);
+    }
+    return err_code;
+}
+
+
+ret_code_t pn532_bus_wake(void)
+{
+    return NRF_SUCCESS;
+}
+
+
+void pn532_bus_select(pn532_bus_cfg_t const * p_cfg)
+{
+    // One emulated chip answers for every reader.
+    UNUSED_PARAMETER(p_cfg);
+}
+
+
+static uint8_t bench_auth(uint8_t * p_uid, uint8_t len, uint32_t block, void * p_context)
+{
+    static uint8_t key[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+    UNUSED_PARAMETER(p_context);
+    return mifareclassic_AuthenticateBlock(p_uid, len, block, 0, key);
+}
+
+
+#define BENCH_CRC_PASSES    128
+
+static void bench_print(char const * p_name, bool ok, uint32_t start)
+{
+    pn532_sim_stats_t stats;
+    uint32_t          ticks;
+
+    UNUSED_RETURN_VALUE(app_timer_cnt_diff_compute(app_timer_cnt_get(), start, &ticks));
+    pn532_sim_stats_get(&stats);
+    printf("%-10s %-4s cmd %3lu xfer %4lu tx %5lu rx %5lu virt %7lu us cpu %5lu ticks fault %lu\r\n",
+           p_name, ok ? "ok" : "FAIL",
+           (unsigned long)stats.commands, (unsigned long)stats.transfers,
+           (unsigned long)stats.bytes_tx, (unsigned long)stats.bytes_rx,
+           (unsigned long)stats.virtual_us, (unsigned long)ticks, (unsigned long)stats.faults);
+}
+
+
+void pn532_sim_bench(void)
+{
+    static uint8_t data[NTAG213_PAGES * 4];
+    uint8_t        uid[PN532_UID_MAX_LEN];
+    uint8_t        uid_len;
+    uint32_t       start;
+    bool           ok;
+
+    if (!m_active)
+    {
+        return;
+    }
+
+    // Each run starts from a configured chip, so SAMConfiguration is not counted.
+    pn532_sim_card_set(PN532_SIM_CARD_MIFARE_1K, NULL);
+    ok = pn532_rf_mode_set(PN532_RF_MODE_ISO14443A);
+    pn532_sim_stats_reset();
+    start = app_timer_cnt_get();
+    ok = ok && readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uid_len, 1000);
+    bench_print("uid", ok, start);
+
+    pn532_sim_stats_reset();
+    start = app_timer_cnt_get();
+    ok = readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uid_len, 1000) &&
+         (mifareclassic_ReadRange(uid, uid_len, 0, MFC_BLOCKS - 1, bench_auth, NULL, NULL) ==
+          MFC_BLOCKS / 4 * 3);
+    bench_print("mfc1k", ok, start);
+
+    pn532_sim_card_set(PN532_SIM_CARD_NTAG213, NULL);
+    pn532_sim_stats_reset();
+    start = app_timer_cnt_get();
+    ok = readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uid_len, 1000) &&
+         (ntag2xx_FastRead(0, NTAG213_PAGES - 1, data) == sizeof(data));
+    bench_print("ntag213", ok, start);
+
+    pn532_sim_card_set(PN532_SIM_CARD_TYPE_B, NULL);
+    ok = pn532_rf_mode_set(PN532_RF_MODE_ISO14443B);
+    pn532_sim_stats_reset();
+    start = app_timer_cnt_get();
+    ok = ok && readTypeBuid(PN532_TYPEB_BITRATE_106, uid, &uid_len, 0);
+    bench_print("typeb", ok, start);
+
+    UNUSED_RETURN_VALUE(pn532_rf_mode_set(PN532_RF_MODE_ISO14443A));
+    pn532_sim_card_set(PN532_SIM_CARD_MIFARE_1K, NULL);
+    pn532_sim_stats_reset();
+
+    // fds records, DFU packets and images: 128 passes over the tag dump, about 23 KB. Build
+    // with each CRC16_CONFIG_TABLE / CRC32_CONFIG_METHOD and compare the cpu ticks.
+#if NRF_MODULE_ENABLED(CRC16)
+    {
+        crc16_ctx_t crc16;
+
+        start = app_timer_cnt_get();
+        crc16_init(&crc16);
+        for (uint8_t i = 0; i < BENCH_CRC_PASSES; i++)
+        {
+            crc16_update(&crc16, data, sizeof(data));
+        }
+        bench_print("crc16", crc16_final(&crc16) != 0, start);
+    }
+#endif
+#if NRF_MODULE_ENABLED(CRC32)
+    {
+        uint32_t crc32 = 0;
+
+        start = app_timer_cnt_get();
+        for (uint8_t i = 0; i < BENCH_CRC_PASSES; i++)
+        {
+            crc32 = crc32_compute(data, sizeof(data), (i == 0) ? NULL : &crc32);
+        }
+        bench_print("crc32", crc32 != 0, start);
+    }
+#endif
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_SIM)
@@ -0,0 +1,98 @@
+#ifndef __PN532_SIM_H__
+#define __PN532_SIM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/**@brief Card in the field of the emulated PN532. */
+typedef enum
+{
+    PN532_SIM_CARD_NONE,        /**< Empty field. */
+    PN532_SIM_CARD_MIFARE_1K,   /**< MIFARE Classic 1K, transport keys (FF..FF). */
+    PN532_SIM_CARD_NTAG213,     /**< NTAG213, 45 pages. */
+    PN532_SIM_CARD_TYPE_B,      /**< ISO14443-3B card answering the GET_UID APDU. */
+    PN532_SIM_CARD_TOPAZ512,    /**< Topaz 512, NDEF formatted and empty; RALL and READ8. */
+} pn532_sim_card_t;
+
+/**@brief Bus and virtual time counters. */
+typedef struct
+{
+    uint32_t commands;     /**< Command frames written by the host. */
+    uint32_t transfers;    /**< Bus transfers, either direction. */
+    uint32_t bytes_tx;     /**< Bytes written by the host, address or opcode byte not counted. */
+    uint32_t bytes_rx;     /**< Bytes read by the host, status byte included. */
+    uint32_t virtual_us;   /**< Bus time of PN532_TRANSPORT plus the command latencies of a real chip. */
+    uint32_t faults;       /**< Errors injected. */
+} pn532_sim_stats_t;
+
+/**@brief Injected errors, rates in per mille of the commands they can hit. */
+typedef struct
+{
+    uint16_t rf_timeout;   /**< InDataExchange/InCommunicateThru answered with status 0x01. */
+    uint16_t rf_crc;       /**< Same with status 0x02; either way the card loses its authentication. */
+    uint16_t no_ack;       /**< Command lost: neither the ACK nor a response comes. */
+    uint16_t bad_dcs;      /**< Response with a wrong data checksum. */
+    uint8_t  jitter_pct;   /**< Latencies spread by up to this percentage either way. */
+} pn532_sim_faults_t;
+
+/* With PN532_SIM the emulator is the bus backend: it provides the pn532_bus_* functions of
+ * pn532_i2c.h in place of the PN532_TRANSPORT driver. ret_code_t pn532_simulator_init(void),
+ * also declared there, connects it and the IRQ line of the PN532 driver, with a MIFARE
+ * Classic 1K in the field.
+ *
+ * With PN532_TWIS as well, the emulator is a firmware of its own instead: pn532_twis puts it
+ * behind a TWI slave and an IRQ pin, for a real host on the other end of the bus. The image
+ * links PN532_I2C.c for the value block codec; nothing in it calls the bus backend then. */
+
+/**@brief Whether the driver talks to the emulator. */
+bool pn532_sim_is_active(void);
+
+/**@brief Put a card in the field, or take it away with PN532_SIM_CARD_NONE.
+ *
+ * @param[in] card   Card type; its memory is reset to the factory contents.
+ * @param[in] p_uid  UID of 4 (MIFARE, Topaz), 7 (NTAG) or 8 (Type B) bytes, NULL for a default one.
+ */
+void pn532_sim_card_set(pn532_sim_card_t card, uint8_t const * p_uid);
+
+/**@brief Override the latency of a command, in us of virtual time; 0 restores the default. */
+void pn532_sim_latency_set(uint8_t cmd, uint32_t latency_us);
+
+/**@brief Inject errors, NULL for none.
+ *
+ * @param[in] p_faults  Rates.
+ * @param[in] seed      Start of the pseudo random sequence, so a failing run can be repeated.
+ */
+void pn532_sim_faults_set(pn532_sim_faults_t const * p_faults, uint32_t seed);
+
+/**@brief Counters since the last @ref pn532_sim_stats_reset. */
+void pn532_sim_stats_get(pn532_sim_stats_t * p_stats);
+
+void pn532_sim_stats_reset(void);
+
+/**@brief Level of the emulated IRQ line: true when a frame is waiting to be read. */
+bool pn532_sim_ready(void);
+
+/**@brief Bytes written by the host, a frame or a wake up.
+ *
+ * @return Latency of the response in us, 0 if no ACK and response are coming.
+ */
+uint32_t pn532_sim_write(uint8_t const * p_data, uint16_t len);
+
+/**@brief What a host read gets: the status byte and the waiting frame, without taking it.
+ *
+ * @return Bytes that matter in @p p_buf, at most @p len; zeros follow.
+ */
+uint16_t pn532_sim_peek(uint8_t * p_buf, uint16_t len);
+
+/**@brief The host has read @p len bytes; more than the status byte takes the waiting frame. */
+void pn532_sim_take(uint16_t len);
+
+/**@brief Run the driver benchmarks against the emulator and print the counters.
+ *
+ * @details UID read, MIFARE Classic 1K dump, NTAG213 dump and Type B UID read. Leaves a MIFARE
+ *          Classic 1K in the field.
+ */
+void pn532_sim_bench(void);
+
+#endif
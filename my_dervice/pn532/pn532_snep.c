@@ -0,0 +1,673 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_SNEP)
+#include "pn532_snep.h"
+#include "pn532_i2c.h"
+#include "app_timer.h"
+#include "wdt_sup.h"
+#include <string.h>
+
+/* LLCP PDU types. */
+#define PTYPE_SYMM          0x0
+#define PTYPE_AGF           0x2
+#define PTYPE_CONNECT       0x4
+#define PTYPE_DISC          0x5
+#define PTYPE_CC            0x6
+#define PTYPE_DM            0x7
+#define PTYPE_I             0xC
+#define PTYPE_RR            0xD
+#define PTYPE_RNR           0xE
+
+/* LLCP parameters. */
+#define TLV_VERSION         0x01
+#define TLV_MIUX            0x02
+#define TLV_WKS             0x03
+#define TLV_LTO             0x04
+#define TLV_RW              0x05
+#define TLV_SN              0x06
+#define TLV_OPT             0x07
+
+#define LLCP_VERSION        0x11    /**< 1.1 */
+#define LLCP_MIU            128     /**< Default MIU; ours, so no MIUX is sent. */
+#define LLCP_LTO            15      /**< Our link timeout, 10 ms units. */
+#define LLCP_LTO_DEFAULT    100     /**< Of a peer that sends none, ms. */
+#define LLCP_HDR_LEN        2
+#define LLCP_SEQ_LEN        1
+
+#define SAP_SDP             1
+#define SAP_SNEP            4
+#define SAP_CLIENT          0x20    /**< First SAP that is not well known. */
+
+#define DM_DISCONNECTED     0x00
+#define DM_NO_SERVICE       0x02
+#define DM_REJECTED         0x03
+
+#define SNEP_VERSION        0x10
+#define SNEP_HDR_LEN        6
+#define SNEP_REQ_CONTINUE   0x00
+#define SNEP_REQ_PUT        0x02
+#define SNEP_RSP_CONTINUE   0x80
+#define SNEP_RSP_SUCCESS    0x81
+#define SNEP_RSP_BAD_REQ    0xC2
+#define SNEP_RSP_NOT_IMPL   0xE0
+#define SNEP_RSP_VERSION    0xE1
+#define SNEP_RSP_REJECT     0xFF
+
+#define TX_PDU_MAX          (PN532_PACKET_BUFFER_SIZE - 2)  /**< InDataExchange command and Tg take two bytes. */
+#define TX_INFO_MAX         (TX_PDU_MAX - LLCP_HDR_LEN - LLCP_SEQ_LEN)
+#define RX_PDU_MAX          (LLCP_HDR_LEN + LLCP_SEQ_LEN + LLCP_MIU)
+#define RXBUF_LEN           (1 + PN532_FRAME_OVERHEAD + 2 + RX_PDU_MAX)
+
+#define SESSION_TICKS       APP_TIMER_TICKS(PN532_SNEP_SESSION_MS, APP_TIMER_CONFIG_PRESCALER)
+
+STATIC_ASSERT(TX_INFO_MAX >= SNEP_HDR_LEN);
+STATIC_ASSERT((PN532_SNEP_RW >= 1) && (PN532_SNEP_RW <= 15));
+
+typedef enum
+{
+    DLC_IDLE,
+    DLC_CONNECTING,     /**< Client: CONNECT to send, then the CC to wait for. */
+    DLC_CONNECTED,      /**< Server: CC to send first. */
+    DLC_DISCONNECTING,  /**< Client: DISC to send, then the DM to wait for. */
+} dlc_state_t;
+
+/**@brief Data link connection, with the SNEP message it sends. */
+typedef struct
+{
+    dlc_state_t     state;
+    bool            ctl_owed;       /**< CONNECT, CC or DISC of the state still to go out. */
+    uint8_t         lsap;
+    uint8_t         rsap;
+    uint8_t         vs;             /**< N(S) of the next I-PDU. */
+    uint8_t         vr;             /**< N(S) expected next. */
+    uint8_t         vsa;            /**< First N(S) the peer has not acknowledged. */
+    uint8_t         nr_sent;        /**< Last N(R) sent. */
+    uint8_t         peer_rw;
+    bool            peer_busy;      /**< RNR received. */
+    uint16_t        peer_miu;
+    uint8_t         hdr[SNEP_HDR_LEN];
+    uint8_t const * p_body;         /**< After hdr in the message. */
+    uint32_t        tx_len;         /**< Header and body. */
+    uint32_t        tx_pos;
+    uint32_t        tx_limit;       /**< Sent before a Continue. */
+} dlc_t;
+
+/* Parameters of the general bytes: magic, version, well-known services (LLC, SDP and SNEP),
+ * link timeout, connection-oriented transport. */
+static uint8_t const m_gi[] =
+{
+    0x46, 0x66, 0x6D,
+    TLV_VERSION, 1, LLCP_VERSION,
+    TLV_WKS,     2, 0x00, (1 << 0) | (1 << SAP_SDP) | (1 << SAP_SNEP),
+    TLV_LTO,     1, LLCP_LTO,
+    TLV_OPT,     1, 0x02,
+};
+
+static char const m_snep_sn[] = "urn:nfc:sn:snep";
+
+static pn532_snep_handler_t m_handler;
+static dlc_t                m_server;
+static dlc_t                m_client;
+static uint16_t             m_link_miu;
+static uint16_t             m_exchange_ms;
+static bool                 m_link_closed;
+static bool                 m_dm_owed;
+static uint8_t              m_dm_pdu[LLCP_HDR_LEN + 1];
+static uint8_t              m_msg[PN532_SNEP_MAX_MSG_LEN];
+static uint32_t             m_rx_total;     /**< Length of the PUT being received, 0 for none. */
+static uint16_t             m_rx_len;
+static bool                 m_got_msg;
+static bool                 m_pushed;
+
+
+static uint8_t hdr_put(uint8_t * p_pdu, uint8_t dsap, uint8_t ptype, uint8_t ssap)
+{
+    p_pdu[0] = (uint8_t)((dsap << 2) | (ptype >> 2));
+    p_pdu[1] = (uint8_t)((ptype << 6) | ssap);
+    return LLCP_HDR_LEN;
+}
+
+
+/**@brief MIU, RW and SN of a parameter list; the ones not in it keep their values. */
+static void params_parse(uint8_t const * p_tlv, uint16_t len, uint16_t * p_miu, uint8_t * p_rw,
+                         uint8_t const ** pp_sn, uint8_t * p_sn_len)
+{
+    for (uint16_t pos = 0; pos + 2 <= len; pos += 2 + p_tlv[pos + 1])
+    {
+        uint8_t const * p_value = &p_tlv[pos + 2];
+        uint8_t         vlen    = p_tlv[pos + 1];
+
+        if (pos + 2 + vlen > len)
+        {
+            break;
+        }
+        if ((p_tlv[pos] == TLV_MIUX) && (vlen == 2) && (p_miu != NULL))
+        {
+            *p_miu = LLCP_MIU + (uint16_big_decode(p_value) & 0x07FF);
+        }
+        else if ((p_tlv[pos] == TLV_RW) && (vlen == 1) && (p_rw != NULL))
+        {
+            *p_rw = p_value[0] & 0x0F;
+        }
+        else if ((p_tlv[pos] == TLV_LTO) && (vlen == 1) && (p_value[0] != 0))
+        {
+            m_exchange_ms = p_value[0] * 10;
+        }
+        else if ((p_tlv[pos] == TLV_SN) && (pp_sn != NULL))
+        {
+            *pp_sn    = p_value;
+            *p_sn_len = vlen;
+        }
+    }
+}
+
+
+/**@brief LLCP parameters of ATR_RES: magic, then a parameter list.
+ *
+ * @return false if the target does not speak LLCP 1.x.
+ */
+static bool link_open(pn532_dep_target_t const * p_target)
+{
+    uint8_t const * p_gt = p_target->gt;
+
+    if ((p_target->gt_len < 3) || (p_gt[0] != 0x46) || (p_gt[1] != 0x66) || (p_gt[2] != 0x6D))
+    {
+        return false;
+    }
+    for (uint8_t pos = 3; pos + 3 <= p_target->gt_len; pos += 2 + p_gt[pos + 1])
+    {
+        if ((p_gt[pos] == TLV_VERSION) && ((p_gt[pos + 2] >> 4) != (LLCP_VERSION >> 4)))
+        {
+            return false;
+        }
+    }
+
+    m_link_miu    = LLCP_MIU;
+    m_exchange_ms = LLCP_LTO_DEFAULT;
+    params_parse(&p_gt[3], p_target->gt_len - 3, &m_link_miu, NULL, NULL, NULL);
+    return true;
+}
+
+
+static void dlc_open(dlc_t * p_dlc, dlc_state_t state, uint8_t lsap, uint8_t rsap)
+{
+    memset(p_dlc, 0, sizeof(*p_dlc));
+    p_dlc->state    = state;
+    p_dlc->ctl_owed = true;
+    p_dlc->lsap     = lsap;
+    p_dlc->rsap     = rsap;
+    p_dlc->peer_rw  = 1;
+    p_dlc->peer_miu = LLCP_MIU;
+}
+
+
+/**@brief Start sending a SNEP message: the first fragment, the rest after a Continue. */
+static void dlc_send(dlc_t * p_dlc, uint8_t code, uint8_t const * p_body, uint32_t body_len)
+{
+    p_dlc->hdr[0]   = SNEP_VERSION;
+    p_dlc->hdr[1]   = code;
+    UNUSED_RETURN_VALUE(uint32_big_encode(body_len, &p_dlc->hdr[2]));
+    p_dlc->p_body   = p_body;
+    p_dlc->tx_len   = SNEP_HDR_LEN + body_len;
+    p_dlc->tx_pos   = 0;
+    p_dlc->tx_limit = MIN(p_dlc->tx_len, MIN(p_dlc->peer_miu, TX_INFO_MAX));
+}
+
+
+static bool dlc_tx_done(dlc_t const * p_dlc)
+{
+    return (p_dlc->tx_pos == p_dlc->tx_len) && (p_dlc->vsa == p_dlc->vs);
+}
+
+
+static void dm_owe(uint8_t dsap, uint8_t ssap, uint8_t reason)
+{
+    UNUSED_RETURN_VALUE(hdr_put(m_dm_pdu, dsap, PTYPE_DM, ssap));
+    m_dm_pdu[LLCP_HDR_LEN] = reason;
+    m_dm_owed              = true;
+}
+
+
+/**@brief Information field of an I-PDU to the SNEP server: a PUT, in fragments. */
+static void server_rx(uint8_t const * p_info, uint16_t len)
+{
+    if (m_rx_total == 0)
+    {
+        uint32_t total;
+
+        if (len < SNEP_HDR_LEN)
+        {
+            dlc_send(&m_server, SNEP_RSP_BAD_REQ, NULL, 0);
+            return;
+        }
+        if ((p_info[0] >> 4) != (SNEP_VERSION >> 4))
+        {
+            dlc_send(&m_server, SNEP_RSP_VERSION, NULL, 0);
+            return;
+        }
+        if (p_info[1] != SNEP_REQ_PUT)
+        {
+            dlc_send(&m_server, SNEP_RSP_NOT_IMPL, NULL, 0);
+            return;
+        }
+        total = uint32_big_decode(&p_info[2]);
+        if ((total == 0) || (total > sizeof(m_msg)))
+        {
+            dlc_send(&m_server, SNEP_RSP_REJECT, NULL, 0);
+            return;
+        }
+        m_rx_total = total;
+        m_rx_len   = 0;
+        p_info    += SNEP_HDR_LEN;
+        len       -= SNEP_HDR_LEN;
+        if (len < total)
+        {
+            // The rest comes without waiting for anything else than this.
+            dlc_send(&m_server, SNEP_RSP_CONTINUE, NULL, 0);
+        }
+    }
+
+    if (m_rx_len + len > m_rx_total)
+    {
+        m_rx_total = 0;
+        dlc_send(&m_server, SNEP_RSP_BAD_REQ, NULL, 0);
+        return;
+    }
+    memcpy(&m_msg[m_rx_len], p_info, len);
+    m_rx_len += len;
+
+    if (m_rx_len == m_rx_total)
+    {
+        m_rx_total = 0;
+        m_got_msg  = true;
+        m_handler(m_msg, m_rx_len);
+        dlc_send(&m_server, SNEP_RSP_SUCCESS, NULL, 0);
+    }
+}
+
+
+/**@brief Information field of an I-PDU to the SNEP client: the answer to the PUT. */
+static void client_rx(uint8_t const * p_info, uint16_t len)
+{
+    if ((len < 2) || (m_client.tx_pos < m_client.tx_limit))
+    {
+        return;
+    }
+    if ((p_info[1] == SNEP_RSP_CONTINUE) && (m_client.tx_limit < m_client.tx_len))
+    {
+        m_client.tx_limit = m_client.tx_len;
+        return;
+    }
+
+    m_pushed            = (p_info[1] == SNEP_RSP_SUCCESS);
+    m_client.tx_len     = m_client.tx_pos;
+    m_client.state      = DLC_DISCONNECTING;
+    m_client.ctl_owed   = true;
+}
+
+
+static void connect_rx(uint8_t dsap, uint8_t ssap, uint8_t const * p_params, uint16_t len)
+{
+    uint8_t const * p_sn   = NULL;
+    uint8_t         sn_len = 0;
+    uint16_t        miu    = LLCP_MIU;
+    uint8_t         rw     = 1;
+
+    params_parse(p_params, len, &miu, &rw, &p_sn, &sn_len);
+    if ((dsap != SAP_SNEP) &&
+        ((dsap != SAP_SDP) || (sn_len != sizeof(m_snep_sn) - 1) || (memcmp(p_sn, m_snep_sn, sn_len) != 0)))
+    {
+        dm_owe(ssap, dsap, DM_NO_SERVICE);
+        return;
+    }
+    if (m_server.state != DLC_IDLE)
+    {
+        dm_owe(ssap, dsap, DM_REJECTED);
+        return;
+    }
+
+    dlc_open(&m_server, DLC_CONNECTED, SAP_SNEP, ssap);
+    m_server.peer_miu = MIN(miu, m_link_miu);
+    m_server.peer_rw  = rw;
+    m_rx_total        = 0;
+}
+
+
+static dlc_t * dlc_find(uint8_t dsap, uint8_t ssap)
+{
+    if ((m_server.state != DLC_IDLE) && (m_server.lsap == dsap) && (m_server.rsap == ssap))
+    {
+        return &m_server;
+    }
+    if ((m_client.state != DLC_IDLE) && (m_client.lsap == dsap) && (m_client.rsap == ssap))
+    {
+        return &m_client;
+    }
+    return NULL;
+}
+
+
+static void ack_rx(dlc_t * p_dlc, uint8_t nr)
+{
+    // Only N(R) between the acknowledged and the sent ones count.
+    if (((nr - p_dlc->vsa) & 0x0F) <= ((p_dlc->vs - p_dlc->vsa) & 0x0F))
+    {
+        p_dlc->vsa = nr;
+    }
+}
+
+
+static void pdu_rx(uint8_t const * p_pdu, uint16_t len)
+{
+    uint8_t dsap;
+    uint8_t ptype;
+    uint8_t ssap;
+    dlc_t * p_dlc;
+
+    if (len < LLCP_HDR_LEN)
+    {
+        return;
+    }
+    dsap  = p_pdu[0] >> 2;
+    ptype = (uint8_t)(((p_pdu[0] & 0x03) << 2) | (p_pdu[1] >> 6));
+    ssap  = p_pdu[1] & 0x3F;
+    p_dlc = dlc_find(dsap, ssap);
+
+    switch (ptype)
+    {
+        case PTYPE_AGF:
+            for (uint16_t pos = LLCP_HDR_LEN; pos + 2 <= len; )
+            {
+                uint16_t n = uint16_big_decode(&p_pdu[pos]);
+
+                // No AGF inside an AGF.
+                if ((pos + 2 + n > len) || (n < LLCP_HDR_LEN) ||
+                    ((((p_pdu[pos + 2] & 0x03) << 2) | (p_pdu[pos + 3] >> 6)) == PTYPE_AGF))
+                {
+                    break;
+                }
+                pdu_rx(&p_pdu[pos + 2], n);
+                pos += 2 + n;
+            }
+            break;
+
+        case PTYPE_CONNECT:
+            connect_rx(dsap, ssap, &p_pdu[LLCP_HDR_LEN], len - LLCP_HDR_LEN);
+            break;
+
+        case PTYPE_CC:
+            if ((m_client.state == DLC_CONNECTING) && !m_client.ctl_owed && (dsap == m_client.lsap))
+            {
+                uint16_t miu = LLCP_MIU;
+                uint8_t  rw  = 1;
+
+                params_parse(&p_pdu[LLCP_HDR_LEN], len - LLCP_HDR_LEN, &miu, &rw, NULL, NULL);
+                m_client.state    = DLC_CONNECTED;
+                m_client.rsap     = ssap;
+                m_client.peer_miu = MIN(miu, m_link_miu);
+                m_client.peer_rw  = rw;
+                m_client.tx_limit = MIN(m_client.tx_len, MIN(m_client.peer_miu, TX_INFO_MAX));
+            }
+            break;
+
+        case PTYPE_DISC:
+            if ((dsap == 0) && (ssap == 0))
+            {
+                m_link_closed = true;
+            }
+            else if (p_dlc != NULL)
+            {
+                p_dlc->state = DLC_IDLE;
+                dm_owe(ssap, dsap, DM_DISCONNECTED);
+            }
+            break;
+
+        case PTYPE_DM:
+            if ((m_client.state != DLC_IDLE) && (dsap == m_client.lsap))
+            {
+                // Refused, gone, or the answer to our DISC.
+                m_client.state = DLC_IDLE;
+            }
+            else if (p_dlc != NULL)
+            {
+                p_dlc->state = DLC_IDLE;
+            }
+            break;
+
+        case PTYPE_I:
+            if ((p_dlc == NULL) || (p_dlc->state == DLC_CONNECTING) || (len < LLCP_HDR_LEN + LLCP_SEQ_LEN))
+            {
+                break;
+            }
+            ack_rx(p_dlc, p_pdu[2] & 0x0F);
+            if ((p_pdu[2] >> 4) != p_dlc->vr)
+            {
+                break;
+            }
+            p_dlc->vr = (p_dlc->vr + 1) & 0x0F;
+            if (p_dlc == &m_server)
+            {
+                server_rx(&p_pdu[3], len - 3);
+            }
+            else
+            {
+                client_rx(&p_pdu[3], len - 3);
+            }
+            break;
+
+        case PTYPE_RR:
+        case PTYPE_RNR:
+            if ((p_dlc != NULL) && (len >= LLCP_HDR_LEN + LLCP_SEQ_LEN))
+            {
+                ack_rx(p_dlc, p_pdu[2] & 0x0F);
+                p_dlc->peer_busy = (ptype == PTYPE_RNR);
+            }
+            break;
+
+        default:
+            // SYMM, and the connectionless and discovery PDUs nothing here uses.
+            break;
+    }
+}
+
+
+/**@brief CONNECT, CC or DISC of a connection, 0 if none is due. */
+static uint8_t ctl_put(dlc_t * p_dlc, uint8_t * p_pdu)
+{
+    uint8_t len;
+
+    if ((p_dlc->state == DLC_IDLE) || !p_dlc->ctl_owed)
+    {
+        return 0;
+    }
+    p_dlc->ctl_owed = false;
+
+    switch (p_dlc->state)
+    {
+        case DLC_CONNECTING:
+            len = hdr_put(p_pdu, SAP_SNEP, PTYPE_CONNECT, p_dlc->lsap);
+            break;
+
+        case DLC_CONNECTED:
+            len = hdr_put(p_pdu, p_dlc->rsap, PTYPE_CC, p_dlc->lsap);
+            break;
+
+        default:
+            return hdr_put(p_pdu, p_dlc->rsap, PTYPE_DISC, p_dlc->lsap);
+    }
+    p_pdu[len++] = TLV_RW;
+    p_pdu[len++] = 1;
+    p_pdu[len++] = PN532_SNEP_RW;
+    return len;
+}
+
+
+/**@brief The next fragment, if the window of the peer has room, 0 else. */
+static uint8_t i_put(dlc_t * p_dlc, uint8_t * p_pdu)
+{
+    uint32_t n;
+    uint8_t  len;
+
+    if ((p_dlc->state != DLC_CONNECTED) || (p_dlc->tx_pos >= p_dlc->tx_limit) || p_dlc->peer_busy ||
+        (((p_dlc->vs - p_dlc->vsa) & 0x0F) >= p_dlc->peer_rw))
+    {
+        return 0;
+    }
+
+    len            = hdr_put(p_pdu, p_dlc->rsap, PTYPE_I, p_dlc->lsap);
+    p_pdu[len++]   = (uint8_t)((p_dlc->vs << 4) | p_dlc->vr);
+    p_dlc->nr_sent = p_dlc->vr;
+    p_dlc->vs      = (p_dlc->vs + 1) & 0x0F;
+
+    n = MIN(p_dlc->tx_limit - p_dlc->tx_pos, MIN(p_dlc->peer_miu, TX_INFO_MAX));
+    for (uint32_t i = 0; i < n; i++, p_dlc->tx_pos++)
+    {
+        p_pdu[len++] = (p_dlc->tx_pos < SNEP_HDR_LEN) ?
+                       p_dlc->hdr[p_dlc->tx_pos] : p_dlc->p_body[p_dlc->tx_pos - SNEP_HDR_LEN];
+    }
+    return len;
+}
+
+
+/**@brief The PDU for the next exchange: control first, then data, then acknowledgements. */
+static uint8_t pdu_next(uint8_t * p_pdu)
+{
+    dlc_t * const dlcs[] = {&m_server, &m_client};
+    uint8_t       len;
+
+    if (m_dm_owed)
+    {
+        m_dm_owed = false;
+        memcpy(p_pdu, m_dm_pdu, sizeof(m_dm_pdu));
+        return sizeof(m_dm_pdu);
+    }
+    for (uint8_t i = 0; i < ARRAY_SIZE(dlcs); i++)
+    {
+        if ((len = ctl_put(dlcs[i], p_pdu)) != 0)
+        {
+            return len;
+        }
+    }
+    for (uint8_t i = 0; i < ARRAY_SIZE(dlcs); i++)
+    {
+        if ((len = i_put(dlcs[i], p_pdu)) != 0)
+        {
+            return len;
+        }
+    }
+    for (uint8_t i = 0; i < ARRAY_SIZE(dlcs); i++)
+    {
+        dlc_t * p_dlc = dlcs[i];
+
+        if ((p_dlc->state == DLC_CONNECTED) && (p_dlc->vr != p_dlc->nr_sent))
+        {
+            len            = hdr_put(p_pdu, p_dlc->rsap, PTYPE_RR, p_dlc->lsap);
+            p_pdu[len++]   = p_dlc->vr;
+            p_dlc->nr_sent = p_dlc->vr;
+            return len;
+        }
+    }
+    return hdr_put(p_pdu, 0, PTYPE_SYMM, 0);
+}
+
+
+static bool session_done(void)
+{
+    if (m_link_closed)
+    {
+        return true;
+    }
+    if (m_dm_owed || (m_client.state != DLC_IDLE))
+    {
+        return false;
+    }
+    if ((m_server.state != DLC_IDLE) &&
+        (m_server.ctl_owed || (m_rx_total != 0) || !dlc_tx_done(&m_server)))
+    {
+        return false;
+    }
+    return m_got_msg || m_pushed;
+}
+
+
+static void session_run(void)
+{
+    uint8_t            tx[TX_PDU_MAX];
+    uint8_t            rxbuf[RXBUF_LEN];
+    pn532_frame_view_t rx;
+    uint32_t           start = app_timer_cnt_get();
+    uint32_t           ticks = 0;
+
+    while (!session_done() && (ticks < SESSION_TICKS))
+    {
+        uint8_t len = pdu_next(tx);
+
+        // Status 0 only: with no MIUX of ours, a PDU of the phone fits one frame.
+        if (inDataExchangeStatus(tx, len, false, rxbuf, sizeof(rxbuf), &rx,
+                                 m_exchange_ms + PN532_RESP_TIMEOUT_CARD) != 0)
+        {
+            // The phone went away.
+            break;
+        }
+#if NRF_MODULE_ENABLED(WDT_SUP)
+        wdt_sup_beat(WDT_SUP_MAIN);
+#endif
+        pdu_rx(rx.p_data, rx.len);
+        UNUSED_RETURN_VALUE(app_timer_cnt_diff_compute(app_timer_cnt_get(), start, &ticks));
+    }
+}
+
+
+ret_code_t pn532_snep_init(pn532_snep_handler_t handler)
+{
+    if (handler == NULL)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    m_handler = handler;
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t pn532_snep_poll(uint8_t const * p_push, uint16_t push_len)
+{
+    pn532_dep_target_t target;
+
+    if (m_handler == NULL)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    // SAMConfiguration, if the reader just woke up; the RF setup it gets is dropped below.
+    if (!pn532_rf_mode_set(PN532_RF_MODE_ISO14443A))
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+    if (!inJumpForDEP(PN532_SNEP_BITRATE, m_gi, sizeof(m_gi), &target, PN532_SNEP_POLL_MS))
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    memset(&m_server, 0, sizeof(m_server));
+    memset(&m_client, 0, sizeof(m_client));
+    m_link_closed = false;
+    m_dm_owed     = false;
+    m_rx_total    = 0;
+    m_got_msg     = false;
+    m_pushed      = false;
+
+    if (link_open(&target))
+    {
+        if (p_push != NULL)
+        {
+            dlc_open(&m_client, DLC_CONNECTING, SAP_CLIENT, SAP_SNEP);
+            dlc_send(&m_client, SNEP_REQ_PUT, p_push, push_len);
+        }
+        session_run();
+    }
+
+    // RLS_REQ ends the LLCP link with the DEP one.
+    UNUSED_RETURN_VALUE(inRelease(0));
+    return (m_got_msg || m_pushed) ? NRF_SUCCESS : NRF_ERROR_TIMEOUT;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_SNEP)
@@ -0,0 +1,56 @@
+#ifndef __PN532_SNEP_H__
+#define __PN532_SNEP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* NDEF push between a phone and the lock over NFC-DEP, the phone in peer to peer mode:
+ *
+ *   link      pn532_snep_poll() activates the phone with InJumpForDEP, passive at
+ *             PN532_SNEP_BITRATE, the LLCP parameters in the general bytes both ways; the
+ *             reader is the initiator and sends one LLCP PDU per exchange, SYMM when it has
+ *             nothing to say
+ *   server    SNEP on SAP 4, reached by number or by the name urn:nfc:sn:snep. A PUT of up
+ *             to PN532_SNEP_MAX_MSG_LEN bytes goes to the handler; a longer one is rejected
+ *   client    an NDEF message handed to pn532_snep_poll() is PUT to the SNEP server of the
+ *             phone
+ *
+ * The whole session runs on the reader side of the link, with no BLE in between. Messages
+ * longer than one PDU are fragmented as SNEP does it (first fragment, Continue, the rest) and
+ * the fragments of the phone are acknowledged in the PDU that goes out next anyway: N(R) of an
+ * I-PDU where there is one, RR instead of SYMM otherwise, never an exchange of its own. The
+ * receive window of PN532_SNEP_RW lets the phone send its fragments back to back. Each PDU
+ * stays within one PN532 frame; the PN532 chains the DEP blocks of a frame itself. */
+
+/**@brief Called from the main loop with an NDEF message the phone pushed.
+ *
+ * @details @p p_msg is valid during the call only; pn532_ndef_msg_dispatch() can parse it.
+ */
+typedef void (*pn532_snep_handler_t)(uint8_t * p_msg, uint16_t len);
+
+/**@brief Set the handler.
+ *
+ * @retval NRF_SUCCESS              Ready for pn532_snep_poll().
+ * @retval NRF_ERROR_INVALID_PARAM  @p handler is NULL.
+ */
+ret_code_t pn532_snep_init(pn532_snep_handler_t handler);
+
+/**@brief Look for a phone for up to PN532_SNEP_POLL_MS and run a session with one found.
+ *
+ * @details Blocks for the poll and for the session, up to PN532_SNEP_SESSION_MS. The session
+ *          ends once the phone has pushed a message and has the answer, and @p p_push, if
+ *          given, has been taken; or when the phone leaves. The reader in use must be awake;
+ *          its RF setup is dropped, so that the next pn532_rf_mode_set() restores it. Main loop.
+ *
+ * @param[in] p_push    NDEF message to push to the phone, NULL for none. Must stay valid.
+ * @param[in] push_len  Its length.
+ *
+ * @retval NRF_SUCCESS              A message went either way.
+ * @retval NRF_ERROR_NOT_FOUND      No phone.
+ * @retval NRF_ERROR_TIMEOUT        A phone, but no message within the session.
+ * @retval NRF_ERROR_INVALID_STATE  Not initialized.
+ */
+ret_code_t pn532_snep_poll(uint8_t const * p_push, uint16_t push_len);
+
+#endif
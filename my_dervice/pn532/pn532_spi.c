@@ -0,0 +1,197 @@
+#include "sdk_common.h"
+#include "pn532_i2c.h"
+#if (PN532_TRANSPORT == PN532_TRANSPORT_SPI) && !NRF_MODULE_ENABLED(PN532_SIM)
+#include "nrf_drv_spi.h"
+#include "nrf_delay.h"
+
+/* SPI0 drives the MX25 flash. SPI1 and TWI1 are one peripheral on the nRF51, which is free
+ * because the PN532 no longer sits on the TWI. */
+#define PN532_SPI_INSTANCE  1
+
+#if !SPI1_ENABLED
+#error "The PN532 on SPI needs SPI1_ENABLED"
+#endif
+#if TWI1_ENABLED
+#error "SPI1 and TWI1 share one peripheral, disable TWI1 for the PN532 on SPI"
+#endif
+
+static const nrf_drv_spi_t m_spi = NRF_DRV_SPI_INSTANCE(PN532_SPI_INSTANCE);
+
+static volatile bool        m_spi_xfer_done = true;
+static pn532_bus_handler_t  m_spi_xfer_handler;
+static uint8_t const *      mp_tx_next;     /**< Frame to clock out after the DATAWRITE opcode. */
+static uint8_t              m_tx_next_len;
+static uint8_t              m_nss_pin = PN532_CONFIG_NSS;   /**< NSS of the selected reader. */
+
+// In RAM, as SPIM reads nothing else.
+static uint8_t       m_op_datawrite = PN532_SPI_DATAWRITE;
+static uint8_t       m_op_dataread  = PN532_SPI_DATAREAD;
+
+#ifdef SPIM_PRESENT
+/* The ACK and NACK frames in flash go through this copy; const command frames are copied into
+ * the frame buffer by wiresendframe. */
+#define DMA_BUF_LEN 8
+static uint8_t       m_dma_buf[DMA_BUF_LEN];
+#endif
+
+
+/**@brief SPI event handler. Runs at APP_IRQ_PRIORITY_HIGH so that blocking transfers issued from
+ *        lower priority interrupts still complete.
+ */
+static void spi_evt_handler(nrf_drv_spi_evt_t const * p_event)
+{
+    pn532_bus_handler_t handler = m_spi_xfer_handler;
+    ret_code_t          result  = NRF_SUCCESS;
+
+    UNUSED_PARAMETER(p_event);
+
+    if (mp_tx_next != NULL)
+    {
+        // The opcode is out, the frame follows with NSS still low.
+        uint8_t const * p_frame = mp_tx_next;
+
+        mp_tx_next = NULL;
+        result     = nrf_drv_spi_transfer(&m_spi, p_frame, m_tx_next_len, NULL, 0);
+        if (result == NRF_SUCCESS)
+        {
+            return;
+        }
+    }
+
+    nrf_gpio_pin_set(m_nss_pin);
+    m_spi_xfer_handler = NULL;
+    m_spi_xfer_done    = true;
+
+    if (handler != NULL)
+    {
+        handler(result);
+    }
+}
+
+
+/**@brief Select the chip and start a transfer; @p p_next is sent right after @p p_tx. */
+static ret_code_t spi_start(uint8_t const * p_tx, uint8_t const * p_next, uint8_t next_len,
+                            uint8_t * p_rx, uint8_t rx_len, pn532_bus_handler_t handler)
+{
+    ret_code_t err_code;
+
+    if (!m_spi_xfer_done)
+    {
+        return NRF_ERROR_BUSY;
+    }
+#ifdef SPIM_PRESENT
+    if (m_spi.use_easy_dma && (p_next != NULL) && !nrf_drv_is_in_RAM(p_next))
+    {
+        if (next_len > DMA_BUF_LEN)
+        {
+            return NRF_ERROR_INVALID_LENGTH;
+        }
+        memcpy(m_dma_buf, p_next, next_len);
+        p_next = m_dma_buf;
+    }
+#endif
+
+    m_spi_xfer_done    = false;
+    m_spi_xfer_handler = handler;
+    mp_tx_next         = p_next;
+    m_tx_next_len      = next_len;
+
+    nrf_gpio_pin_clear(m_nss_pin);
+    err_code = nrf_drv_spi_transfer(&m_spi, p_tx, 1, p_rx, rx_len);
+    if (err_code != NRF_SUCCESS)
+    {
+        nrf_gpio_pin_set(m_nss_pin);
+        mp_tx_next         = NULL;
+        m_spi_xfer_handler = NULL;
+        m_spi_xfer_done    = true;
+    }
+    return err_code;
+}
+
+
+static ret_code_t spi_wait(ret_code_t err_code)
+{
+    while ((err_code == NRF_SUCCESS) && !m_spi_xfer_done)
+    {
+    }
+    return err_code;
+}
+
+
+ret_code_t pn532_bus_init(void)
+{
+    nrf_drv_spi_config_t spi_config = NRF_DRV_SPI_DEFAULT_CONFIG;
+
+    // NSS stays low from the opcode to the end of the frame, so it is not left to the driver.
+    spi_config.sck_pin      = PN532_CONFIG_SCK;
+    spi_config.mosi_pin     = PN532_CONFIG_MOSI;
+    spi_config.miso_pin     = PN532_CONFIG_MISO;
+    spi_config.irq_priority = APP_IRQ_PRIORITY_HIGH;
+    spi_config.frequency    = PN532_SPI_FREQUENCY;
+    spi_config.mode         = NRF_DRV_SPI_MODE_0;
+    spi_config.bit_order    = NRF_DRV_SPI_BIT_ORDER_LSB_FIRST;
+
+    nrf_gpio_pin_set(PN532_CONFIG_NSS);
+    nrf_gpio_cfg_output(PN532_CONFIG_NSS);
+
+    return nrf_drv_spi_init(&m_spi, &spi_config, spi_evt_handler);
+}
+
+
+ret_code_t pn532_bus_write(uint8_t const * p_data, uint8_t len)
+{
+    // An asynchronous transfer may still own the bus.
+    while (!m_spi_xfer_done)
+    {
+    }
+    return spi_wait(spi_start(&m_op_datawrite, p_data, len, NULL, 0, NULL));
+}
+
+
+ret_code_t pn532_bus_read(uint8_t * p_buf, uint8_t len)
+{
+    while (!m_spi_xfer_done)
+    {
+    }
+    // Full duplex: the byte clocked in with the opcode lands in p_buf[0], the frame follows.
+    return spi_wait(spi_start(&m_op_dataread, NULL, 0, p_buf, len, NULL));
+}
+
+
+#if NRF_MODULE_ENABLED(PN532_ASYNC)
+ret_code_t pn532_bus_write_async(uint8_t const * p_data, uint8_t len, pn532_bus_handler_t handler)
+{
+    return spi_start(&m_op_datawrite, p_data, len, NULL, 0, handler);
+}
+
+
+ret_code_t pn532_bus_read_async(uint8_t * p_buf, uint8_t len, pn532_bus_handler_t handler)
+{
+    return spi_start(&m_op_dataread, NULL, 0, p_buf, len, handler);
+}
+#endif //NRF_MODULE_ENABLED(PN532_ASYNC)
+
+
+ret_code_t pn532_bus_wake(void)
+{
+    // On SPI the PN532 leaves PowerDown on the falling edge of NSS (User Manual, 7.2.11).
+    while (!m_spi_xfer_done)
+    {
+    }
+    nrf_gpio_pin_clear(m_nss_pin);
+    nrf_delay_ms(1);
+    nrf_gpio_pin_set(m_nss_pin);
+
+    return NRF_SUCCESS;
+}
+
+
+void pn532_bus_select(pn532_bus_cfg_t const * p_cfg)
+{
+    while (!m_spi_xfer_done)
+    {
+    }
+    m_nss_pin = (p_cfg->sel_pin != PN532_PIN_NOT_USED) ? p_cfg->sel_pin : PN532_CONFIG_NSS;
+}
+
+#endif //PN532_TRANSPORT_SPI
@@ -0,0 +1,101 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_T1T)
+#include "pn532_t1t.h"
+#include <string.h>
+
+#define T1T_CC_OFFSET       8       /**< CC in the first half of block 0x01. */
+#define T1T_DATA_OFFSET     12      /**< Data area right after the CC. */
+#define T1T_STATIC_END      104     /**< Blocks 0x0D and 0x0E: reserved, static lock bytes. */
+#define T1T_DYNAMIC_START   128     /**< Block 0x10, after the reserved and dynamic lock bytes. */
+#define T1T_CC_TMS          2       /**< Tag memory size byte: (TMS + 1) * 8 bytes. */
+#define T1T_READ8_MAX_BLOCK 0xFF    /**< READ8 takes a one-byte block address. */
+
+#define STATIC_DATA_LEN     (T1T_STATIC_END - T1T_DATA_OFFSET)
+
+/* RALL answer: HR0, HR1, then the tag from byte 0. */
+#define RALL_HR0            0
+#define RALL_MEM            2
+
+
+/**@brief Bytes of the data area, as the parser sees it. */
+static uint16_t data_len_get(uint8_t hr0, uint8_t const * p_cc)
+{
+    uint16_t mem_size = (p_cc[T1T_CC_TMS] + 1) * JEWEL_BLOCK_LEN;
+
+    if ((hr0 != JEWEL_HR0_DYNAMIC) || (mem_size <= T1T_DYNAMIC_START))
+    {
+        return STATIC_DATA_LEN;
+    }
+    mem_size = MIN(mem_size, (T1T_READ8_MAX_BLOCK + 1) * JEWEL_BLOCK_LEN);
+    return STATIC_DATA_LEN + mem_size - T1T_DYNAMIC_START;
+}
+
+
+ret_code_t pn532_t1t_read(pn532_jewel_target_t const * p_target,
+                          type_2_tag_t               * p_type_2_tag,
+                          uint8_t                    * p_value_buf,
+                          uint16_t                     value_buf_size)
+{
+    type_2_tag_stream_t stream;
+    uint8_t             rxbuf[JEWEL_RALL_RXBUF_LEN];
+    pn532_frame_view_t  rall;
+    uint8_t             header[T2T_FIRST_DATA_BLOCK_OFFSET] = {0};
+    uint8_t             block[JEWEL_BLOCK_LEN];
+    uint8_t const     * p_mem;
+    uint16_t            data_len;
+    ret_code_t          err_code;
+
+    if (!jewel_ReadAll(p_target, rxbuf, sizeof(rxbuf), &rall))
+    {
+        return NRF_ERROR_TIMEOUT;
+    }
+    if ((rall.p_data[RALL_HR0] != JEWEL_HR0_STATIC) && (rall.p_data[RALL_HR0] != JEWEL_HR0_DYNAMIC))
+    {
+        return NRF_ERROR_NOT_SUPPORTED;
+    }
+    p_mem    = &rall.p_data[RALL_MEM];
+    data_len = data_len_get(rall.p_data[RALL_HR0], &p_mem[T1T_CC_OFFSET]);
+
+    // Type 2 Tag header: the UID block, then the CC in the place of the Type 2 one. The CC has
+    // the same layout, but its size byte counts the whole tag in 8-byte units; the parser takes
+    // the data area rounded up, and the exact size once the header is in.
+    memcpy(header, p_mem, JEWEL_BLOCK_LEN);
+    memcpy(&header[T2T_CC_BLOCK_OFFSET], &p_mem[T1T_CC_OFFSET], T2T_BLOCK_SIZE);
+    header[T2T_CC_BLOCK_OFFSET + T1T_CC_TMS] = (uint8_t)CEIL_DIV(data_len, 8);
+
+    type_2_tag_stream_init(&stream, p_type_2_tag, p_value_buf, value_buf_size);
+    err_code = type_2_tag_stream_feed(&stream, 0, header, sizeof(header));
+    VERIFY_SUCCESS(err_code);
+    p_type_2_tag->cc.data_area_size = data_len;
+
+    err_code = type_2_tag_stream_feed(&stream, T2T_FIRST_DATA_BLOCK_OFFSET,
+                                      &p_mem[T1T_DATA_OFFSET], STATIC_DATA_LEN);
+    VERIFY_SUCCESS(err_code);
+
+    // Topaz 512: the rest block by block, from where the parser goes on.
+    while (!type_2_tag_stream_is_done(&stream))
+    {
+        uint16_t pos  = type_2_tag_stream_offset(&stream) - T2T_FIRST_DATA_BLOCK_OFFSET;
+        uint16_t addr = T1T_DYNAMIC_START + (pos - STATIC_DATA_LEN);
+
+        if ((pos < STATIC_DATA_LEN) || (addr / JEWEL_BLOCK_LEN > T1T_READ8_MAX_BLOCK))
+        {
+            return NRF_ERROR_INVALID_DATA;
+        }
+        addr -= addr % JEWEL_BLOCK_LEN;
+        if (!jewel_Read8(p_target, (uint8_t)(addr / JEWEL_BLOCK_LEN), block))
+        {
+            return NRF_ERROR_TIMEOUT;
+        }
+
+        err_code = type_2_tag_stream_feed(&stream,
+                                          T2T_FIRST_DATA_BLOCK_OFFSET + STATIC_DATA_LEN +
+                                          (addr - T1T_DYNAMIC_START),
+                                          block, sizeof(block));
+        VERIFY_SUCCESS(err_code);
+    }
+
+    return NRF_SUCCESS;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_T1T)
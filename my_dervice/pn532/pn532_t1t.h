@@ -0,0 +1,39 @@
+#ifndef __PN532_T1T_H__
+#define __PN532_T1T_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+#include "nfc_t2t_parser.h"
+#include "pn532_i2c.h"
+
+/**@brief Read the TLV area of a Type 1 Tag (Innovision Jewel, Topaz 96, Topaz 512).
+ *
+ * @details The TLVs of a Type 1 Tag follow the same rules as those of a Type 2 Tag, so the tag
+ *          is fed to the incremental nfc_t2t_parser: its data area, blocks 0x01..0x0C after the
+ *          capability container and on a Topaz 512 blocks 0x10 and up, is laid out where the
+ *          parser expects the data area of a Type 2 Tag. Blocks 0x0D..0x0F hold the static
+ *          lock bytes and the reserved and dynamic lock bytes of the factory Lock and Memory
+ *          Control TLVs; they are left out.
+ *
+ *          One RALL reads the static memory, all of a Jewel or Topaz 96. A Topaz 512 goes on
+ *          with READ8 only while the parser needs more, so blocks past the Terminator TLV or
+ *          inside skipped TLV values are not read. The tag must have been found with
+ *          jewel_Poll() first.
+ *
+ * @param[in]  p_target        Tag from jewel_Poll().
+ * @param[out] p_type_2_tag    Receives the capability container and the TLV blocks.
+ * @param[in]  p_value_buf     Receives the NDEF Message and Lock/Memory Control values; the TLV
+ *                             blocks point into it.
+ * @param[in]  value_buf_size  Size of @p p_value_buf.
+ *
+ * @retval NRF_SUCCESS              The TLV area has been parsed.
+ * @retval NRF_ERROR_TIMEOUT        The tag did not answer a RALL or READ8.
+ * @retval NRF_ERROR_NOT_SUPPORTED  HR0 is not that of an NDEF capable Type 1 Tag.
+ * @return Any error from type_2_tag_stream_feed().
+ */
+ret_code_t pn532_t1t_read(pn532_jewel_target_t const * p_target,
+                          type_2_tag_t               * p_type_2_tag,
+                          uint8_t                    * p_value_buf,
+                          uint16_t                     value_buf_size);
+
+#endif
@@ -0,0 +1,38 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_T2T)
+#include "pn532_t2t.h"
+#include "pn532_i2c.h"
+
+#define T2T_READ_LEN    16   /**< Bytes returned by one READ (four pages). */
+#define T2T_MAX_PAGE    0xFF /**< READ takes a one-byte page address. */
+
+
+ret_code_t pn532_t2t_read(type_2_tag_t * p_type_2_tag, uint8_t * p_value_buf, uint16_t value_buf_size)
+{
+    type_2_tag_stream_t stream;
+    uint8_t             data[T2T_READ_LEN];
+    ret_code_t          err_code;
+
+    type_2_tag_stream_init(&stream, p_type_2_tag, p_value_buf, value_buf_size);
+
+    while (!type_2_tag_stream_is_done(&stream))
+    {
+        uint16_t page = type_2_tag_stream_offset(&stream) / T2T_BLOCK_SIZE;
+
+        if (page > T2T_MAX_PAGE)
+        {
+            return NRF_ERROR_INVALID_DATA;
+        }
+        if (!mifareultralight_ReadPages((uint8_t)page, data))
+        {
+            return NRF_ERROR_TIMEOUT;
+        }
+
+        err_code = type_2_tag_stream_feed(&stream, page * T2T_BLOCK_SIZE, data, sizeof(data));
+        VERIFY_SUCCESS(err_code);
+    }
+
+    return NRF_SUCCESS;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_T2T)
@@ -0,0 +1,26 @@
+#ifndef __PN532_T2T_H__
+#define __PN532_T2T_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+#include "nfc_t2t_parser.h"
+
+/**@brief Read the TLV area of the selected Type 2 Tag with 16-byte READ commands.
+ *
+ * @details The pages are fed to the incremental nfc_t2t_parser as they arrive. Reading stops at
+ *          the Terminator TLV or the end of the data area, and pages that only hold skipped TLV
+ *          values are not read at all. The tag must have been selected with
+ *          readPassiveTargetID() first.
+ *
+ * @param[out] p_type_2_tag    Receives the header and the TLV blocks.
+ * @param[in]  p_value_buf     Receives the NDEF Message and Lock/Memory Control values; the TLV
+ *                             blocks point into it.
+ * @param[in]  value_buf_size  Size of @p p_value_buf.
+ *
+ * @retval NRF_SUCCESS         The TLV area has been parsed.
+ * @retval NRF_ERROR_TIMEOUT   The tag did not answer a READ.
+ * @return Any error from type_2_tag_stream_feed().
+ */
+ret_code_t pn532_t2t_read(type_2_tag_t * p_type_2_tag, uint8_t * p_value_buf, uint16_t value_buf_size);
+
+#endif
@@ -0,0 +1,308 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_T4T)
+#include "pn532_t4t.h"
+#include "pn532_isodep.h"
+#include "nfc_t4t_cc_file.h"
+#include <string.h>
+
+#define T4T_CC_FILE_ID     0xE103
+#define T4T_CC_LEN_MIN     0x0F     /**< CC of a version 2.0 tag, one NDEF File Control TLV. */
+#define T4T_CC_LEN_MAX     0x13     /**< The same with the Extended NDEF File Control TLV of 3.0. */
+#define T4T_CC_TLV         7        /**< Offset of the first File Control TLV, the NDEF file's. */
+#define T4T_NLEN_SIZE      2
+#define T4T_SW_SIZE        2
+#define T4T_SW_OK          0x9000
+#define T4T_SW_NOT_FOUND   0x6A82
+
+#define INS_SELECT         0xA4
+#define INS_READ_BINARY    0xB0
+
+STATIC_ASSERT(PN532_T4T_BUF_OVERHEAD == T4T_NLEN_SIZE + T4T_SW_SIZE);
+
+typedef struct
+{
+    uint8_t  ats_len;               /**< 0 for a free entry; TL, so never 0 for a card. */
+    uint8_t  ats[PN532_TARGET_ATS_LEN];
+    uint8_t  sel_res;
+    uint16_t sens_res;
+    uint16_t file_id;               /**< NDEF file. */
+    uint16_t max_size;              /**< Its size, NLEN included. */
+    uint16_t chunk;                 /**< Le of a ReadBinary: MLe, as far as one frame carries. */
+    uint8_t  used;                  /**< m_clock at the last hit. */
+} cc_entry_t;
+
+static cc_entry_t m_cache[PN532_T4T_CACHE_SIZE];
+static uint8_t    m_clock;
+
+NFC_T4T_CC_DESC_DEF(m_cc, 1);
+
+static uint8_t const m_select_app[] =
+{
+    0x00, INS_SELECT, 0x04, 0x00, 0x07, 0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01, 0x00
+};
+
+
+void pn532_t4t_init(void)
+{
+    memset(m_cache, 0, sizeof(m_cache));
+    m_clock = 0;
+}
+
+
+/**@brief Exchange an APDU whose answer is up to @p *p_len data bytes and the status word.
+ *
+ * @param[in,out] p_len  In: data bytes asked for; @p p_rapdu has room for them and the status
+ *                       word. Out: data bytes received.
+ */
+static ret_code_t apdu(uint8_t const * p_capdu, uint8_t capdu_len, uint8_t * p_rapdu, uint16_t * p_len)
+{
+    uint16_t   len = *p_len + T4T_SW_SIZE;
+    uint16_t   sw;
+    ret_code_t err_code;
+
+    err_code = pn532_isodep_transceive(p_capdu, capdu_len, p_rapdu, &len);
+    VERIFY_SUCCESS(err_code);
+    if (len < T4T_SW_SIZE)
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+    len -= T4T_SW_SIZE;
+
+    sw = uint16_big_decode(&p_rapdu[len]);
+    if (sw == T4T_SW_NOT_FOUND)
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+    if (sw != T4T_SW_OK)
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+    *p_len = len;
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t file_select(uint16_t file_id)
+{
+    uint8_t  capdu[7] = {0x00, INS_SELECT, 0x00, 0x0C, 0x02};
+    uint8_t  sw[T4T_SW_SIZE];
+    uint16_t len = 0;
+
+    UNUSED_RETURN_VALUE(uint16_big_encode(file_id, &capdu[5]));
+    return apdu(capdu, sizeof(capdu), sw, &len);
+}
+
+
+/**@brief ReadBinary of @p le bytes at @p offset into @p p_dst, which has room for the status word too. */
+static ret_code_t binary_read(uint16_t offset, uint8_t le, uint8_t * p_dst, uint16_t * p_len)
+{
+    uint8_t capdu[5] = {0x00, INS_READ_BINARY};
+
+    UNUSED_RETURN_VALUE(uint16_big_encode(offset, &capdu[2]));
+    capdu[4] = le;
+    *p_len   = le;
+    return apdu(capdu, sizeof(capdu), p_dst, p_len);
+}
+
+
+/**@brief Entry of the card's profile, NULL if there is none. */
+static cc_entry_t * cache_find(pn532_target_t const * p_target)
+{
+    uint8_t len = MIN(p_target->ats_len, sizeof(m_cache[0].ats));
+
+    for (uint8_t i = 0; i < PN532_T4T_CACHE_SIZE; i++)
+    {
+        cc_entry_t * p_entry = &m_cache[i];
+
+        if ((p_entry->ats_len == p_target->ats_len) && (p_entry->ats_len != 0) &&
+            (p_entry->sel_res == p_target->sel_res) && (p_entry->sens_res == p_target->sens_res) &&
+            (memcmp(p_entry->ats, p_target->ats, len) == 0))
+        {
+            p_entry->used = ++m_clock;
+            return p_entry;
+        }
+    }
+    return NULL;
+}
+
+
+/**@brief Free entry, or the one unused the longest, filled in with the card's profile. */
+static cc_entry_t * cache_add(pn532_target_t const * p_target)
+{
+    cc_entry_t * p_old  = &m_cache[0];
+    uint8_t      oldest = 0;
+
+    m_clock++;
+    for (uint8_t i = 0; i < PN532_T4T_CACHE_SIZE; i++)
+    {
+        uint8_t age = (m_cache[i].ats_len == 0) ? 0xFF : (uint8_t)(m_clock - m_cache[i].used);
+
+        if (age >= oldest)
+        {
+            oldest = age;
+            p_old  = &m_cache[i];
+        }
+    }
+
+    p_old->ats_len  = p_target->ats_len;
+    p_old->sel_res  = p_target->sel_res;
+    p_old->sens_res = p_target->sens_res;
+    p_old->used     = m_clock;
+    memcpy(p_old->ats, p_target->ats, MIN(p_target->ats_len, sizeof(p_old->ats)));
+    return p_old;
+}
+
+
+/**@brief Select and read the CC file, and keep what the NDEF read needs of it in @p p_entry. */
+static ret_code_t cc_read(cc_entry_t * p_entry)
+{
+    nfc_t4t_capability_container_t * p_cc = &NFC_T4T_CC_DESC(m_cc);
+    nfc_t4t_tlv_block_t const      * p_tlv;
+    uint8_t                          raw[T4T_CC_LEN_MAX + T4T_SW_SIZE];
+    uint16_t                         have;
+    uint16_t                         len;
+    ret_code_t                       err_code;
+
+    err_code = file_select(T4T_CC_FILE_ID);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = binary_read(0, T4T_CC_LEN_MIN, raw, &have);
+    VERIFY_SUCCESS(err_code);
+    if (have < T4T_CC_LEN_MIN)
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    // Up to the end of the first TLV; the TLVs of proprietary files behind it are not needed.
+    len = MIN(uint16_big_decode(raw), T4T_CC_TLV + 2 + raw[T4T_CC_TLV + 1]);
+    if (len > T4T_CC_LEN_MAX)
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+    if (len > have)
+    {
+        uint16_t more;
+
+        err_code = binary_read(have, (uint8_t)(len - have), &raw[have], &more);
+        VERIFY_SUCCESS(err_code);
+        have += more;
+    }
+
+    err_code = nfc_t4t_cc_file_parse(p_cc, raw, MIN(have, len));
+    VERIFY_SUCCESS(err_code);
+
+    p_tlv = &p_cc->p_tlv_block_array[0];
+    if (p_tlv->value.read_access != CONTROL_FILE_READ_ACCESS_GRANTED)
+    {
+        return NRF_ERROR_FORBIDDEN;
+    }
+    p_entry->file_id  = p_tlv->value.file_id;
+    p_entry->max_size = (uint16_t)MIN(p_tlv->value.max_file_size, UINT16_MAX);
+    p_entry->chunk    = MIN(p_cc->max_rapdu_size, PN532_ISODEP_MAX_RAPDU_DATA);
+    return NRF_SUCCESS;
+}
+
+
+/**@brief Find the NDEF file of the card and select it, through the cache where it can. */
+static ret_code_t ndef_select(pn532_target_t const * p_target, cc_entry_t ** pp_entry)
+{
+    uint8_t      sw[T4T_SW_SIZE];
+    uint16_t     len = 0;
+    cc_entry_t * p_entry;
+    ret_code_t   err_code;
+
+    err_code = apdu(m_select_app, sizeof(m_select_app), sw, &len);
+    VERIFY_SUCCESS(err_code);
+
+    p_entry = cache_find(p_target);
+    if (p_entry != NULL)
+    {
+        err_code = file_select(p_entry->file_id);
+        if (err_code != NRF_ERROR_NOT_FOUND)
+        {
+            *pp_entry = p_entry;
+            return err_code;
+        }
+        // Another CC than the rest of its product.
+        p_entry->ats_len = 0;
+    }
+
+    p_entry  = cache_add(p_target);
+    err_code = cc_read(p_entry);
+    if (err_code == NRF_SUCCESS)
+    {
+        err_code = file_select(p_entry->file_id);
+    }
+    if (err_code != NRF_SUCCESS)
+    {
+        p_entry->ats_len = 0;
+    }
+    *pp_entry = p_entry;
+    return err_code;
+}
+
+
+ret_code_t pn532_t4t_ndef_read(pn532_target_t const    * p_target,
+                               uint8_t                 * p_buf,
+                               uint16_t                  buf_size,
+                               pn532_t4t_chunk_handler_t handler,
+                               void                    * p_context)
+{
+    cc_entry_t * p_entry;
+    uint16_t     nlen;
+    uint16_t     have;
+    uint16_t     len;
+    ret_code_t   err_code;
+
+    if (buf_size < PN532_T4T_BUF_OVERHEAD)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    err_code = ndef_select(p_target, &p_entry);
+    VERIFY_SUCCESS(err_code);
+
+    // NLEN and as much of the message as one ReadBinary brings.
+    len = MIN(MIN(p_entry->chunk, p_entry->max_size), buf_size - T4T_SW_SIZE);
+    err_code = binary_read(0, (uint8_t)len, p_buf, &have);
+    VERIFY_SUCCESS(err_code);
+    if (have < T4T_NLEN_SIZE)
+    {
+        return NRF_ERROR_INVALID_DATA;
+    }
+
+    nlen = uint16_big_decode(p_buf);
+    if (nlen + T4T_NLEN_SIZE > p_entry->max_size)
+    {
+        p_entry->ats_len = 0;
+        return NRF_ERROR_INVALID_DATA;
+    }
+    if (nlen + PN532_T4T_BUF_OVERHEAD > buf_size)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+    have = MIN(have - T4T_NLEN_SIZE, nlen);
+
+    while (have > 0)
+    {
+        err_code = handler(&p_buf[T4T_NLEN_SIZE], have, nlen, p_context);
+        VERIFY_SUCCESS(err_code);
+        if (have == nlen)
+        {
+            break;
+        }
+
+        err_code = binary_read(T4T_NLEN_SIZE + have, (uint8_t)MIN(nlen - have, p_entry->chunk),
+                               &p_buf[T4T_NLEN_SIZE + have], &len);
+        VERIFY_SUCCESS(err_code);
+        if (len == 0)
+        {
+            return NRF_ERROR_INVALID_DATA;
+        }
+        have += MIN(len, nlen - have);
+    }
+
+    return NRF_SUCCESS;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_T4T)
@@ -0,0 +1,69 @@
+#ifndef __PN532_T4T_H__
+#define __PN532_T4T_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+#include "pn532_i2c.h"
+
+/**@brief Room @ref pn532_t4t_ndef_read needs in its buffer besides the message: NLEN in front of
+ *        it, and behind it the status word of the last ReadBinary.
+ */
+#define PN532_T4T_BUF_OVERHEAD  4
+
+/**@brief Part of the NDEF message has arrived.
+ *
+ * @param[in] p_msg      The message, its first @p have bytes read; they do not move until the read
+ *                       returns.
+ * @param[in] have       Bytes of the message read so far.
+ * @param[in] nlen       Length of the whole message.
+ * @param[in] p_context  As passed to @ref pn532_t4t_ndef_read.
+ *
+ * @return NRF_SUCCESS to go on; any other value ends the read and is returned from it.
+ */
+typedef ret_code_t (*pn532_t4t_chunk_handler_t)(uint8_t const * p_msg,
+                                                uint16_t        have,
+                                                uint16_t        nlen,
+                                                void          * p_context);
+
+/**@brief Forget the capability containers. */
+void pn532_t4t_init(void);
+
+/**@brief Read the NDEF file of the selected Type 4 Tag, handing each part on as it arrives.
+ *
+ * @details The NDEF Detection Procedure of the T4T specification, with fewer exchanges:
+ *
+ *          - The capability container is cached per card profile, by ATQA, SAK and ATS, in a
+ *            table of PN532_T4T_CACHE_SIZE entries. Cards of one product carry the same CC, so
+ *            after the first card only the NDEF Tag Application and the NDEF file are
+ *            selected; the CC file is neither selected nor read. An NDEF file that is not where
+ *            the cached CC put it, or is longer than it allowed, drops the entry and the
+ *            procedure runs in full once.
+ *          - NLEN is not read on its own: the first ReadBinary asks for as much as MLe allows
+ *            and brings NLEN and the start of the message.
+ *          - Each ReadBinary asks for MLe bytes, as far as one PN532 frame carries
+ *            (PN532_ISODEP_MAX_RAPDU_DATA), and answers straight into @p p_buf, so the message
+ *            is never copied.
+ *
+ *          The target must have been selected with readPassiveTargets() and report ISO14443-4
+ *          support. Needs PN532_ISODEP.
+ *
+ * @param[in]  p_target   Target from readPassiveTargets().
+ * @param[out] p_buf      Receives the message at p_buf + 2.
+ * @param[in]  buf_size   Size of @p p_buf, the longest message and PN532_T4T_BUF_OVERHEAD.
+ * @param[in]  handler    Called after each ReadBinary that brought part of the message.
+ * @param[in]  p_context  Passed to @p handler.
+ *
+ * @retval NRF_SUCCESS              The message has been read; NLEN may have been 0.
+ * @retval NRF_ERROR_NOT_FOUND      The card has no NDEF Tag Application or NDEF file.
+ * @retval NRF_ERROR_FORBIDDEN      The NDEF file may not be read without security.
+ * @retval NRF_ERROR_NO_MEM         The message does not fit @p p_buf.
+ * @retval NRF_ERROR_INVALID_DATA   The card refused an APDU, or its CC or NLEN is not valid.
+ * @return Any error from pn532_isodep_transceive(), nfc_t4t_cc_file_parse() or @p handler.
+ */
+ret_code_t pn532_t4t_ndef_read(pn532_target_t const    * p_target,
+                               uint8_t                 * p_buf,
+                               uint16_t                  buf_size,
+                               pn532_t4t_chunk_handler_t handler,
+                               void                    * p_context);
+
+#endif
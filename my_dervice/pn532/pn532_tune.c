@@ -0,0 +1,464 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_TUNE)
+#include "pn532_tune.h"
+#include "pn532_i2c.h"
+#include "pn532_async.h"
+#include "wdt_sup.h"
+#include "fds.h"
+#include "nrf_delay.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(FDS)
+#error "pn532_tune needs FDS"
+#endif
+
+#define CFG_ITEM_FIELD      0x01    /**< RFConfiguration: RF field. */
+#define CFG_ITEM_RETRIES    0x05    /**< RFConfiguration: MxRtyATR, MxRtyPSL, MxRtyPassiveActivation. */
+#define CFG_ITEM_ANALOG_A   0x0A    /**< RFConfiguration: analog settings, 106 kbps type A. */
+#define CFG_ITEM_ANALOG_F   0x0B    /**< RFConfiguration: analog settings, 212 and 424 kbps. */
+#define FIELD_OFF           0x00
+#define FIELD_AUTO          0x01    /**< Off, and on by itself for the next command (AutoRFCA). */
+#define FIELD_OFF_MS        6       /**< Longer than the 5.1 ms that reset an ISO14443 card. */
+#define RETRIES_ONCE        0x01
+#define RETRIES_FOREVER     0xFF
+#define RX_GAIN_POS         4
+#define RX_GAIN_MASK        0x70
+#define RX_GAIN_STEPS       8
+#define UID_MAX_LEN         10
+
+/**@brief What is kept in flash. */
+typedef struct
+{
+    uint8_t         profile[PN532_TUNE_FAMILIES];
+    uint8_t         rfu;
+    pn532_tune_rf_t rf[PN532_TUNE_FAMILIES];
+    uint8_t         pad;
+} pn532_tune_save_t;
+
+STATIC_ASSERT(sizeof(pn532_tune_save_t) % sizeof(uint32_t) == 0);
+
+typedef struct
+{
+    char const *        p_name;
+    pn532_tune_family_t family;
+    pn532_tune_rf_t     rf;
+} profile_t;
+
+/* RFCfg, GsNOn, CWGsP, ModGsP, RxThreshold. */
+static profile_t const m_profiles[PN532_TUNE_PROFILES] =
+{
+    [PN532_TUNE_A_DEFAULT]      = {"iso_a",         PN532_TUNE_FAMILY_A,      {0x59, 0xF4, 0x3F, 0x11, 0x85}},
+    [PN532_TUNE_A_HIGH_GAIN]    = {"iso_a_high",    PN532_TUNE_FAMILY_A,      {0x79, 0xFF, 0x3F, 0x11, 0x55}},
+    [PN532_TUNE_B_DEFAULT]      = {"typeb",         PN532_TUNE_FAMILY_B,      {0x59, 0xFF, 0x3F, 0x18, 0x4D}},
+    [PN532_TUNE_B_ID_CARD]      = {"typeb_id_card", PN532_TUNE_FAMILY_B,      {0x69, 0xFF, 0x3F, 0x18, 0x4D}},
+    [PN532_TUNE_FELICA_DEFAULT] = {"felica",        PN532_TUNE_FAMILY_FELICA, {0x69, 0xFF, 0x3F, 0x11, 0x85}},
+};
+
+static pn532_tune_profile_t const m_defaults[PN532_TUNE_FAMILIES] =
+{
+    PN532_TUNE_A_DEFAULT, PN532_TUNE_B_DEFAULT, PN532_TUNE_FELICA_DEFAULT,
+};
+
+/* CWGsP steps of the sweep, strongest first. */
+static uint8_t const m_cw_gs_p[] = {0x3F, 0x2F, 0x1F, 0x0F};
+
+__ALIGN(4) static pn532_tune_save_t m_save;
+
+static fds_record_desc_t m_desc;
+static bool              m_sent[PN532_TUNE_FAMILIES];  /**< Settings other than the defaults sent since boot. */
+static bool              m_record_found;
+static bool              m_dirty;
+static bool              m_write_pending;
+
+
+static void save_reset(void)
+{
+    memset(&m_save, 0, sizeof(m_save));
+    for (uint8_t i = 0; i < PN532_TUNE_FAMILIES; i++)
+    {
+        m_save.profile[i] = (uint8_t)m_defaults[i];
+        m_save.rf[i]      = m_profiles[m_defaults[i]].rf;
+    }
+}
+
+
+static void save_load(void)
+{
+    fds_find_token_t   token = {0};
+    fds_flash_record_t record;
+
+    if (fds_record_find(PN532_TUNE_FILE_ID, PN532_TUNE_RECORD_KEY, &m_desc, &token) != FDS_SUCCESS)
+    {
+        return;
+    }
+    m_record_found = true;
+
+    if (fds_record_open(&m_desc, &record) != FDS_SUCCESS)
+    {
+        return;
+    }
+    if (record.p_header->tl.length_words == BYTES_TO_WORDS(sizeof(m_save)))
+    {
+        memcpy(&m_save, record.p_data, sizeof(m_save));
+    }
+    (void)fds_record_close(&m_desc);
+
+    // The chip picks the settings up on its next setup.
+    pn532_rf_mode_invalidate();
+}
+
+
+static void save_store(void)
+{
+    fds_record_chunk_t chunk;
+    fds_record_t       record;
+    ret_code_t         err_code;
+
+    if (m_write_pending)
+    {
+        // Written again once the write in flight is done.
+        m_dirty = true;
+        return;
+    }
+
+    chunk.p_data       = &m_save;
+    chunk.length_words = BYTES_TO_WORDS(sizeof(m_save));
+
+    record.file_id         = PN532_TUNE_FILE_ID;
+    record.key             = PN532_TUNE_RECORD_KEY;
+    record.data.p_chunks   = &chunk;
+    record.data.num_chunks = 1;
+
+    m_dirty = false;
+    if (m_record_found)
+    {
+        err_code = fds_record_update(&m_desc, &record);
+    }
+    else
+    {
+        err_code = fds_record_write(&m_desc, &record);
+    }
+
+    if (err_code == FDS_SUCCESS)
+    {
+        m_write_pending = true;
+    }
+    else if (err_code == FDS_ERR_NO_SPACE_IN_FLASH)
+    {
+        // Old copies of the record fill the pages; reclaim them and retry once gc is done.
+        m_dirty         = true;
+        m_write_pending = (fds_gc() == FDS_SUCCESS);
+    }
+    else
+    {
+        m_dirty = true;
+    }
+}
+
+
+static void fds_evt_handler(fds_evt_t const * const p_evt)
+{
+    switch (p_evt->id)
+    {
+        case FDS_EVT_INIT:
+            if (p_evt->result == FDS_SUCCESS)
+            {
+                save_load();
+            }
+            break;
+
+        case FDS_EVT_WRITE:
+        case FDS_EVT_UPDATE:
+            if ((p_evt->write.file_id != PN532_TUNE_FILE_ID) ||
+                (p_evt->write.record_key != PN532_TUNE_RECORD_KEY))
+            {
+                break;
+            }
+            m_write_pending = false;
+            if (p_evt->result == FDS_SUCCESS)
+            {
+                m_record_found = true;
+            }
+            if (m_dirty)
+            {
+                save_store();
+            }
+            break;
+
+        case FDS_EVT_GC:
+            if (m_write_pending && m_dirty)
+            {
+                m_write_pending = false;
+                save_store();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+/**@brief RFConfiguration with the analog settings of one item, the rest at the chip defaults. */
+static uint8_t analog_send(pn532_tune_family_t family)
+{
+    pn532_tune_rf_t const * p_rf = &m_save.rf[family];
+
+    if (family == PN532_TUNE_FAMILY_A)
+    {
+        // RFCfg, GsNOn, CWGsP, ModGsP, DemodOwnRfOn, RxThreshold, DemodOwnRfOff, GsNOff,
+        // ModWidth, MifNFC, TxBitPhase.
+        uint8_t item[11] = {p_rf->rf_cfg, p_rf->gs_n_on, p_rf->cw_gs_p, p_rf->mod_gs_p, 0x4D,
+                            p_rf->rx_threshold, 0x61, 0x6F, 0x26, 0x62, 0x87};
+
+        return pn532_rf_config(CFG_ITEM_ANALOG_A, item, sizeof(item));
+    }
+    else
+    {
+        // RFCfg, GsNOn, CWGsP, ModGsP, DemodOwnRfOn, RxThreshold, DemodOwnRfOff, GsNOff.
+        uint8_t item[8] = {p_rf->rf_cfg, p_rf->gs_n_on, p_rf->cw_gs_p, p_rf->mod_gs_p, 0x41,
+                           p_rf->rx_threshold, 0x61, 0x6F};
+
+        return pn532_rf_config(CFG_ITEM_ANALOG_F, item, sizeof(item));
+    }
+}
+
+
+static uint8_t field_cycle(void)
+{
+    uint8_t off = FIELD_OFF;
+    uint8_t on  = FIELD_AUTO;
+
+    if (!pn532_rf_config(CFG_ITEM_FIELD, &off, 1))
+    {
+        return 0;
+    }
+    nrf_delay_ms(FIELD_OFF_MS);
+    return pn532_rf_config(CFG_ITEM_FIELD, &on, 1);
+}
+
+
+/**@brief One pass of the current settings over the reference card.
+ *
+ * @return Polls that found the card, out of PN532_TUNE_POLLS; 0xFF if the chip stopped answering.
+ */
+static uint8_t score(pn532_tune_family_t family)
+{
+    uint8_t               uid[UID_MAX_LEN];
+    uint8_t               uid_len;
+    pn532_felica_target_t felica;
+    uint8_t               hits = 0;
+
+    if (family != PN532_TUNE_FAMILY_B)
+    {
+        if (!analog_send(family))
+        {
+            return 0xFF;
+        }
+    }
+    else if (!CategoryBConfig())
+    {
+        return 0xFF;
+    }
+
+    for (uint8_t i = 0; i < PN532_TUNE_POLLS; i++)
+    {
+        if (!field_cycle())
+        {
+            return 0xFF;
+        }
+        if (family == PN532_TUNE_FAMILY_A)
+        {
+            hits += readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uid_len, PN532_TUNE_POLL_MS) ? 1 : 0;
+        }
+        else if (family == PN532_TUNE_FAMILY_FELICA)
+        {
+            hits += felica_Polling(PN532_FELICA_212, FELICA_SYSTEM_CODE_ANY, FELICA_REQUEST_NONE,
+                                   &felica, PN532_TUNE_POLL_MS);
+        }
+        else
+        {
+            hits += readTypeBuid(PN532_TYPEB_BITRATE_106, uid, &uid_len, PN532_TUNE_POLL_MS) ? 1 : 0;
+        }
+    }
+    return hits;
+}
+
+
+ret_code_t pn532_tune_init(void)
+{
+    ret_code_t err_code;
+
+    save_reset();
+
+    err_code = fds_register(fds_evt_handler);
+    VERIFY_SUCCESS(err_code);
+
+    return fds_init();
+}
+
+
+pn532_tune_rf_t const * pn532_tune_rf_get(pn532_tune_family_t family)
+{
+    return &m_save.rf[family];
+}
+
+
+pn532_tune_profile_t pn532_tune_profile_get(pn532_tune_family_t family)
+{
+    return (pn532_tune_profile_t)m_save.profile[family];
+}
+
+
+char const * pn532_tune_profile_name(pn532_tune_profile_t profile)
+{
+    if (profile < PN532_TUNE_PROFILES)
+    {
+        return m_profiles[profile].p_name;
+    }
+    return (profile == PN532_TUNE_CALIBRATED) ? "calibrated" : "?";
+}
+
+
+ret_code_t pn532_tune_select(pn532_tune_profile_t profile)
+{
+    pn532_tune_family_t family;
+
+    if (profile >= PN532_TUNE_PROFILES)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    family                 = m_profiles[profile].family;
+    m_save.profile[family] = (uint8_t)profile;
+    m_save.rf[family]      = m_profiles[profile].rf;
+    pn532_rf_mode_invalidate();
+    save_store();
+
+    return NRF_SUCCESS;
+}
+
+
+uint8_t pn532_tune_apply(void)
+{
+    static pn532_tune_family_t const families[] = {PN532_TUNE_FAMILY_A, PN532_TUNE_FAMILY_FELICA};
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(families); i++)
+    {
+        pn532_tune_family_t family = families[i];
+
+        bool custom = (memcmp(&m_save.rf[family], &m_profiles[m_defaults[family]].rf,
+                              sizeof(pn532_tune_rf_t)) != 0);
+
+        // The chip comes out of reset with the defaults; they only go out to undo other settings.
+        if (!custom && !m_sent[family])
+        {
+            continue;
+        }
+        if (!analog_send(family))
+        {
+            return 0;
+        }
+        m_sent[family] = custom;
+    }
+    return 1;
+}
+
+
+ret_code_t pn532_tune_calibrate(pn532_tune_family_t family, uint8_t * p_hits)
+{
+    static pn532_rf_mode_t const modes[PN532_TUNE_FAMILIES] =
+    {
+        PN532_RF_MODE_ISO14443A, PN532_RF_MODE_ISO14443B, PN532_RF_MODE_FELICA,
+    };
+    pn532_tune_rf_t prev;
+    pn532_tune_rf_t best;
+    uint8_t         best_hits = 0;
+    uint8_t         retries[3];
+    ret_code_t      err_code  = NRF_SUCCESS;
+
+    if (family >= PN532_TUNE_FAMILIES)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if (pn532_cmd_busy())
+    {
+        return NRF_ERROR_BUSY;
+    }
+    if (!pn532_rf_mode_set(modes[family]))
+    {
+        return NRF_ERROR_INTERNAL;
+    }
+
+    // One activation attempt per poll: a step without the card costs PN532_TUNE_POLL_MS, not more.
+    retries[0] = RETRIES_FOREVER;
+    retries[1] = RETRIES_ONCE;
+    retries[2] = RETRIES_ONCE;
+    if (!pn532_rf_config(CFG_ITEM_RETRIES, retries, sizeof(retries)))
+    {
+        return NRF_ERROR_INTERNAL;
+    }
+
+    prev = m_save.rf[family];
+    best = prev;
+    m_sent[family] = true;  // The chip keeps the last step until the next setup sends the result.
+    for (uint8_t i = 0; (i < ARRAY_SIZE(m_cw_gs_p)) && (err_code == NRF_SUCCESS); i++)
+    {
+        for (uint8_t gain = 0; gain < RX_GAIN_STEPS; gain++)
+        {
+            uint8_t hits;
+
+            m_save.rf[family].cw_gs_p = m_cw_gs_p[i];
+            m_save.rf[family].rf_cfg  = (uint8_t)((prev.rf_cfg & ~RX_GAIN_MASK) | (gain << RX_GAIN_POS));
+
+            hits = score(family);
+#if NRF_MODULE_ENABLED(WDT_SUP)
+            wdt_sup_beat(WDT_SUP_MAIN);
+#endif
+            if (hits == 0xFF)
+            {
+                err_code = NRF_ERROR_INTERNAL;
+                break;
+            }
+            // Strictly better only: on a tie the stronger carrier and the lower gain stay.
+            if (hits > best_hits)
+            {
+                best_hits = hits;
+                best      = m_save.rf[family];
+            }
+            if (best_hits == PN532_TUNE_POLLS)
+            {
+                break;
+            }
+        }
+        if (best_hits == PN532_TUNE_POLLS)
+        {
+            break;
+        }
+    }
+
+    if ((err_code == NRF_SUCCESS) && (best_hits == 0))
+    {
+        err_code = NRF_ERROR_NOT_FOUND;
+    }
+    if (err_code == NRF_SUCCESS)
+    {
+        m_save.rf[family]      = best;
+        m_save.profile[family] = PN532_TUNE_CALIBRATED;
+        save_store();
+    }
+    else
+    {
+        m_save.rf[family] = prev;
+    }
+    *p_hits = best_hits;
+
+    // What the reader ran with before: retries as after SAMConfiguration, the settings kept.
+    retries[2] = RETRIES_FOREVER;
+    UNUSED_RETURN_VALUE(pn532_rf_config(CFG_ITEM_RETRIES, retries, sizeof(retries)));
+    pn532_rf_mode_invalidate();
+
+    return err_code;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_TUNE)
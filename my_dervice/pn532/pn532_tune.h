@@ -0,0 +1,99 @@
+#ifndef __PN532_TUNE_H__
+#define __PN532_TUNE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* RF analog settings of the PN532 as named profiles, one in use per RF family:
+ *
+ *   A, FeliCa  sent with RFConfiguration (CfgItem 0x0A, 0x0B) right after SAMConfiguration.
+ *              The PN532 loads them into the CIU itself on every InListPassiveTarget, which
+ *              would undo a WriteRegister; the chip defaults only go out to undo other settings
+ *   B          the reader drives Type B through InCommunicateThru, so its settings go into
+ *              the CIU with the one batched WriteRegister of CategoryBConfig()
+ *   flash      the profile in use for each family, and its settings, are one FDS record
+ *   tuning     pn532_tune_calibrate() sweeps RxGain and CWGsP with a reference card held
+ *              at the range wanted, PN532_TUNE_POLLS polls per step, and keeps the step that
+ *              found the card most often: the highest CWGsP, then the lowest gain, on a tie
+ *
+ * RFCfg holds RxGain in bits 6:4 (18 to 48 dB) and the RF level detector in bits 3:0; CWGsP
+ * is the conductance of the P driver while the carrier is on, 0x00 to 0x3F. */
+
+/**@brief RF families with settings of their own. */
+typedef enum
+{
+    PN532_TUNE_FAMILY_A,        /**< ISO14443A and MIFARE, 106 kbps. */
+    PN532_TUNE_FAMILY_B,        /**< ISO14443B, 106 kbps. */
+    PN532_TUNE_FAMILY_FELICA,   /**< FeliCa, 212 and 424 kbps. */
+    PN532_TUNE_FAMILIES
+} pn532_tune_family_t;
+
+/**@brief Built-in profiles. */
+typedef enum
+{
+    PN532_TUNE_A_DEFAULT,       /**< PN532 defaults. */
+    PN532_TUNE_A_HIGH_GAIN,     /**< Full RxGain and a lower MinLevel, for weak cards. */
+    PN532_TUNE_B_DEFAULT,       /**< The CategoryBConfig() settings the lock always had. */
+    PN532_TUNE_B_ID_CARD,       /**< ID cards: more RxGain, deeper modulation. */
+    PN532_TUNE_FELICA_DEFAULT,  /**< PN532 defaults. */
+    PN532_TUNE_PROFILES,
+    PN532_TUNE_CALIBRATED = 0xFF  /**< Found by pn532_tune_calibrate(). */
+} pn532_tune_profile_t;
+
+/**@brief Analog settings, as the CIU registers take them. */
+typedef struct
+{
+    uint8_t rf_cfg;         /**< CIU_RFCfg: RxGain, RF level detector. */
+    uint8_t gs_n_on;        /**< CIU_GsNOn: N driver conductance, carrier on and modulating. */
+    uint8_t cw_gs_p;        /**< CIU_CWGsP: P driver conductance, carrier on. */
+    uint8_t mod_gs_p;       /**< CIU_ModGsP: P driver conductance while modulating. */
+    uint8_t rx_threshold;   /**< CIU_RxThreshold: MinLevel, CollLevel. */
+} pn532_tune_rf_t;
+
+/**@brief Register with fds; the profiles in flash take over once it is initialized.
+ *
+ * @details Until then, and without a record, the default profile of each family is in use.
+ */
+ret_code_t pn532_tune_init(void);
+
+/**@brief Settings in use for @p family. */
+pn532_tune_rf_t const * pn532_tune_rf_get(pn532_tune_family_t family);
+
+/**@brief Profile in use for @p family, or PN532_TUNE_CALIBRATED. */
+pn532_tune_profile_t pn532_tune_profile_get(pn532_tune_family_t family);
+
+/**@brief Name of a profile, for the console. */
+char const * pn532_tune_profile_name(pn532_tune_profile_t profile);
+
+/**@brief Use a built-in profile for its family from the next RF setup on, and store it.
+ *
+ * @retval NRF_SUCCESS             In use; the record is written in the background.
+ * @retval NRF_ERROR_INVALID_PARAM No such profile.
+ */
+ret_code_t pn532_tune_select(pn532_tune_profile_t profile);
+
+/**@brief Send the A and FeliCa settings. Called by pn532_rf_mode_set() after SAMConfiguration.
+ *
+ * @return 1 on success, 0 if the PN532 did not take them.
+ */
+uint8_t pn532_tune_apply(void);
+
+/**@brief Find the best RxGain and CWGsP for @p family with a reference card on the antenna.
+ *
+ * @details Blocks for up to a few seconds: 32 steps of PN532_TUNE_POLLS polls, the carrier
+ *          turned off and on before each poll so that the card starts from IDLE. The result
+ *          is stored as PN532_TUNE_CALIBRATED; the settings before stay if no step found
+ *          the card. Main loop, with the reader idle.
+ *
+ * @param[in]  family   Family; FeliCa is polled at 212 kbps, for any system code.
+ * @param[out] p_hits   Polls out of PN532_TUNE_POLLS that found the card at the best step.
+ *
+ * @retval NRF_SUCCESS              Calibrated.
+ * @retval NRF_ERROR_NOT_FOUND      No step found the card.
+ * @retval NRF_ERROR_BUSY           A PN532 command is running.
+ * @retval NRF_ERROR_INTERNAL       The PN532 did not take the settings.
+ */
+ret_code_t pn532_tune_calibrate(pn532_tune_family_t family, uint8_t * p_hits);
+
+#endif
@@ -0,0 +1,125 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PN532_TWIS)
+#include "pn532_twis.h"
+#include "pn532_sim.h"
+#include "pn532_i2c.h"
+#include "nrf_drv_twis.h"
+#include "nrf_gpio.h"
+#include "app_timer.h"
+
+#if !NRF_MODULE_ENABLED(PN532_SIM)
+#error "PN532_TWIS needs PN532_SIM"
+#endif
+#if !TWIS_ENABLED
+#error "PN532_TWIS needs TWIS_ENABLED, an nRF52 peripheral"
+#endif
+
+#define RX_MAX  (PN532_TWI_MAX_READ + EXT_HEADER_SEQUENCE_LENGTH)  /**< Longest host frame. */
+
+/**@brief @p us in ticks of the IRQ timer, at least the app_timer minimum. */
+#define US_TO_TICKS(us)                                                                    \
+    MAX((uint32_t)ROUNDED_DIV((uint64_t)(us) * APP_TIMER_CLOCK_FREQ,                       \
+                              (APP_TIMER_CONFIG_PRESCALER + 1) * 1000000ULL),              \
+        APP_TIMER_MIN_TIMEOUT_TICKS)
+
+APP_TIMER_DEF(m_irq_timer);
+
+static nrf_drv_twis_t const m_twis = NRF_DRV_TWIS_INSTANCE(PN532_TWIS_INSTANCE);
+static uint8_t              m_rx[RX_MAX];
+static uint8_t              m_tx[PN532_TWI_MAX_READ + 1];  /**< Status byte, then the frame. */
+static uint32_t             m_resp_us;                     /**< Latency of the waiting response. */
+
+
+static void irq_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    // An ACK from the host may have aborted the command since.
+    if (pn532_sim_ready())
+    {
+        nrf_gpio_pin_clear(PN532_TWIS_IRQ_PIN);
+    }
+}
+
+
+/**@brief IRQ high now, low in @p us if a frame is waiting by then. */
+static void irq_later(uint32_t us)
+{
+    nrf_gpio_pin_set(PN532_TWIS_IRQ_PIN);
+    UNUSED_RETURN_VALUE(app_timer_stop(m_irq_timer));
+    if (pn532_sim_ready())
+    {
+        UNUSED_RETURN_VALUE(app_timer_start(m_irq_timer, US_TO_TICKS(us), NULL));
+    }
+}
+
+
+static void twis_evt_handler(nrf_drv_twis_evt_t const * const p_event)
+{
+    switch (p_event->type)
+    {
+        case TWIS_EVT_WRITE_REQ:
+            if (p_event->data.buf_req)
+            {
+                UNUSED_RETURN_VALUE(nrf_drv_twis_rx_prepare(&m_twis, m_rx, sizeof(m_rx)));
+            }
+            break;
+
+        case TWIS_EVT_WRITE_DONE:
+            m_resp_us = pn532_sim_write(m_rx, (uint16_t)p_event->data.rx_amount);
+            // The ACK of a command, or the response again after a NACK.
+            irq_later(PN532_TWIS_ACK_US);
+            break;
+
+        case TWIS_EVT_READ_REQ:
+            if (p_event->data.buf_req)
+            {
+                // Zeros past the frame, as the chip sends.
+                UNUSED_RETURN_VALUE(pn532_sim_peek(m_tx, sizeof(m_tx)));
+                UNUSED_RETURN_VALUE(nrf_drv_twis_tx_prepare(&m_twis, m_tx, sizeof(m_tx)));
+            }
+            break;
+
+        case TWIS_EVT_READ_DONE:
+            if ((m_tx[0] == PN532_I2C_READY) && (p_event->data.tx_amount > 1))
+            {
+                pn532_sim_take((uint16_t)p_event->data.tx_amount);
+                // After the ACK the response comes when the command is done; 0 if it was lost.
+                irq_later(m_resp_us);
+                m_resp_us = 0;
+            }
+            break;
+
+        default:
+            // Read and write errors: the host times out and sends the command again.
+            break;
+    }
+}
+
+
+ret_code_t pn532_twis_init(void)
+{
+    nrf_drv_twis_config_t config = NRF_DRV_TWIS_DEFAULT_CONFIG;
+    ret_code_t            err_code;
+
+    err_code = pn532_simulator_init();
+    VERIFY_SUCCESS(err_code);
+
+    nrf_gpio_pin_set(PN532_TWIS_IRQ_PIN);
+    nrf_gpio_cfg_output(PN532_TWIS_IRQ_PIN);
+
+    err_code = app_timer_create(&m_irq_timer, APP_TIMER_MODE_SINGLE_SHOT, irq_timer_handler);
+    VERIFY_SUCCESS(err_code);
+
+    config.addr[0] = PN532_I2C_ADDRESS;
+    config.addr[1] = 0;
+    config.scl     = PN532_TWIS_SCL_PIN;
+    config.sda     = PN532_TWIS_SDA_PIN;
+    err_code = nrf_drv_twis_init(&m_twis, &config, twis_evt_handler);
+    VERIFY_SUCCESS(err_code);
+
+    nrf_drv_twis_enable(&m_twis);
+    return NRF_SUCCESS;
+}
+
+#endif //NRF_MODULE_ENABLED(PN532_TWIS)
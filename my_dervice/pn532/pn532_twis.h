@@ -0,0 +1,27 @@
+#ifndef __PN532_TWIS_H__
+#define __PN532_TWIS_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+
+/* The PN532 emulator of pn532_sim behind a TWI slave, a firmware for a second board that a
+ * host running the PN532 driver talks to over a real bus, for throughput and soak runs with
+ * no reader and no cards:
+ *
+ *   bus        TWIS at PN532_I2C_ADDRESS; a write is a host frame for pn532_sim_write, a read
+ *              gets the status byte and the waiting frame, and takes it unless only the status
+ *              byte was read
+ *   IRQ        PN532_TWIS_IRQ_PIN goes low when a frame is waiting: PN532_TWIS_ACK_US after a
+ *              command for its ACK, then the latency of the command after the ACK was read
+ *   faults     rates and latencies are those of pn532_sim, PN532_SIM_FAULTS in sdk_config or
+ *              pn532_sim_faults_set and pn532_sim_latency_set at run time
+ *
+ * TWIS is an nRF52 peripheral: the emulator does not run on the nRF51 of the reader. */
+
+/**@brief Start the emulator and its TWI slave.
+ *
+ * @details app_timer must be initialized.
+ */
+ret_code_t pn532_twis_init(void);
+
+#endif
@@ -0,0 +1,152 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(PROX_WAKE)
+#include "prox_wake.h"
+#include "pn532_duty.h"
+#include "nrf_drv_csense.h"
+#include "nrf_gpio.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+
+#if !NRF_MODULE_ENABLED(NRF_DRV_CSENSE) || !NRF_MODULE_ENABLED(PN532_DUTY)
+#error "prox_wake needs NRF_DRV_CSENSE_ENABLED and PN532_DUTY_ENABLED"
+#endif
+
+#define PROX_TICKS(ms)  APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+#define IDLE_SAMPLES    ((PROX_WAKE_IDLE_S * 1000UL) / PROX_WAKE_PERIOD_MS)
+#define RECAL_SAMPLES   ((PROX_WAKE_RECAL_S * 1000UL) / PROX_WAKE_PERIOD_MS)
+
+APP_TIMER_DEF(m_timer);
+
+static volatile bool     m_busy;
+static volatile uint16_t m_value;
+static uint32_t          m_baseline;    /**< mV << PROX_WAKE_BASELINE_SHIFT, 0 before the first sample. */
+static bool              m_near;
+static bool              m_idle;
+static uint32_t          m_count;       /**< Samples since the last change of m_near. */
+
+
+static void approach(void)
+{
+    m_idle = false;
+    pn532_duty_idle(false);
+    pn532_duty_kick();
+}
+
+
+static void sample_process(void * p_event_data, uint16_t event_size)
+{
+    int32_t value = m_value;
+    int32_t base  = (int32_t)(m_baseline >> PROX_WAKE_BASELINE_SHIFT);
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    m_busy = false;
+    if (m_baseline == 0)
+    {
+        m_baseline = (uint32_t)value << PROX_WAKE_BASELINE_SHIFT;
+        return;
+    }
+
+    m_count++;
+    if (!m_near)
+    {
+        if (value > base + PROX_WAKE_THRESHOLD_MV)
+        {
+            m_near  = true;
+            m_count = 0;
+            approach();
+            return;
+        }
+        // Too slow to follow a hand, fast enough for the weather.
+        m_baseline = (uint32_t)((int32_t)m_baseline + value - base);
+        if (!m_idle && (m_count >= IDLE_SAMPLES))
+        {
+            m_idle = true;
+            pn532_duty_idle(true);
+        }
+    }
+    else if (value < base + PROX_WAKE_THRESHOLD_MV / 2)
+    {
+        m_near  = false;
+        m_count = 0;
+    }
+    else if (m_count >= RECAL_SAMPLES)
+    {
+        // Something stays on the pad, a sticker or rain: it is part of the pad from now on.
+        m_baseline = (uint32_t)value << PROX_WAKE_BASELINE_SHIFT;
+        m_near     = false;
+        m_count    = 0;
+    }
+}
+
+
+static void csense_handler(nrf_drv_csense_evt_t * p_event)
+{
+    m_value = p_event->read_value;
+    UNUSED_RETURN_VALUE(nrf_drv_csense_uninit());
+    if (app_sched_event_put(NULL, 0, sample_process) != NRF_SUCCESS)
+    {
+        m_busy = false;
+    }
+}
+
+
+/**@brief Take the ADC for one sample; skipped while batt_mon has it. */
+static void sample_start(void * p_event_data, uint16_t event_size)
+{
+    nrf_drv_csense_config_t config = {.output_pin = PROX_WAKE_OUTPUT_PIN};
+
+    UNUSED_PARAMETER(p_event_data);
+    UNUSED_PARAMETER(event_size);
+
+    if (nrf_drv_csense_init(&config, csense_handler) != NRF_SUCCESS)
+    {
+        m_busy = false;
+        return;
+    }
+    nrf_drv_csense_channels_enable(1 << PROX_WAKE_AIN);
+    if (nrf_drv_csense_sample() != NRF_SUCCESS)
+    {
+        UNUSED_RETURN_VALUE(nrf_drv_csense_uninit());
+        m_busy = false;
+    }
+}
+
+
+static void timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    if (m_busy)
+    {
+        return;
+    }
+    m_busy = true;
+    if (app_sched_event_put(NULL, 0, sample_start) != NRF_SUCCESS)
+    {
+        m_busy = false;
+    }
+}
+
+
+ret_code_t prox_wake_init(void)
+{
+    ret_code_t err_code;
+
+    // The pad charges between samples, the first one included.
+    nrf_gpio_pin_set(PROX_WAKE_OUTPUT_PIN);
+    nrf_gpio_cfg_output(PROX_WAKE_OUTPUT_PIN);
+
+    err_code = app_timer_create(&m_timer, APP_TIMER_MODE_REPEATED, timer_handler);
+    VERIFY_SUCCESS(err_code);
+    return app_timer_start(m_timer, PROX_TICKS(PROX_WAKE_PERIOD_MS), NULL);
+}
+
+
+bool prox_wake_is_near(void)
+{
+    return m_near;
+}
+
+#endif //NRF_MODULE_ENABLED(PROX_WAKE)
@@ -0,0 +1,28 @@
+#ifndef __PROX_WAKE_H__
+#define __PROX_WAKE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+/* Capacitive proximity in front of the reader, gating the bursts of pn532_duty:
+ *
+ *   pad       a copper area behind the antenna on PROX_WAKE_AIN, charged through a resistor
+ *             from PROX_WAKE_OUTPUT_PIN; nrf_drv_csense samples it every PROX_WAKE_PERIOD_MS,
+ *             in mV on the nRF51, higher with a hand or a card nearby
+ *   baseline  follows the empty pad with a 1/2^PROX_WAKE_BASELINE_SHIFT step per sample, for
+ *             drift from temperature and moisture; frozen while something is near, and taken
+ *             from the pad again when it stays near for PROX_WAKE_RECAL_S
+ *   near      PROX_WAKE_THRESHOLD_MV above the baseline; gone again below half of that
+ *   gating    coming near starts a burst at once and undoes the idle back-off; after
+ *             PROX_WAKE_IDLE_S with nobody near the bursts back off to PN532_DUTY_IDLE_MS
+ *
+ * The ADC driver is held only from the sample to its result, so batt_mon can use it too. */
+
+/**@brief Start sampling the pad. Call after app_timer, app_scheduler and pn532_duty_init(). */
+ret_code_t prox_wake_init(void);
+
+/**@brief Whether something is near the pad. */
+bool prox_wake_is_near(void);
+
+#endif
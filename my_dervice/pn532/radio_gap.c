@@ -0,0 +1,177 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(RADIO_GAP)
+#include "radio_gap.h"
+#include "ble_radio_notification.h"
+#include "app_timer.h"
+#include "app_error.h"
+#include "app_util_platform.h"
+#if NRF_MODULE_ENABLED(ENERGY)
+#include "energy.h"
+#endif
+#include <string.h>
+
+#define TAP_TICKS  APP_TIMER_TICKS(RADIO_GAP_TAP_MAX_MS, APP_TIMER_CONFIG_PRESCALER)
+
+APP_TIMER_DEF(m_tap_timer);
+
+static app_sched_event_handler_t m_held[RADIO_GAP_CLASS_COUNT][RADIO_GAP_QUEUE_SIZE];
+static uint8_t                   m_held_count[RADIO_GAP_CLASS_COUNT];
+static volatile bool             m_radio_active;
+static volatile bool             m_tap;
+static bool                      m_tap_spent;     /**< The tap ran out of time; ends with the card. */
+
+
+static ret_code_t put(radio_gap_class_t cls, app_sched_event_handler_t handler)
+{
+    return (cls == RADIO_GAP_PN532) ? app_sched_event_put_high(handler) :
+                                      app_sched_event_put(NULL, 0, handler);
+}
+
+
+static bool may_run(radio_gap_class_t cls)
+{
+    if (m_tap)
+    {
+        return (cls == RADIO_GAP_PN532);
+    }
+    return !m_radio_active;
+}
+
+
+/**@brief Schedule the handlers of @p cls that wait. */
+static void held_release(radio_gap_class_t cls)
+{
+    app_sched_event_handler_t held[RADIO_GAP_QUEUE_SIZE];
+    uint8_t                   count;
+
+    CRITICAL_REGION_ENTER();
+    count = m_held_count[cls];
+    memcpy(held, m_held[cls], count * sizeof(held[0]));
+    m_held_count[cls] = 0;
+    CRITICAL_REGION_EXIT();
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        // The owners wait for these; a full scheduler queue is a sizing error.
+        APP_ERROR_CHECK(put(cls, held[i]));
+    }
+}
+
+
+/**@brief SWI1: the radio is about to start, or has stopped. */
+static void radio_evt_handler(bool radio_active)
+{
+    m_radio_active = radio_active;
+#if NRF_MODULE_ENABLED(ENERGY)
+    // The one radio notification there is; the energy count takes its edges from here.
+    if (radio_active)
+    {
+        energy_on(ENERGY_RADIO);
+    }
+    else
+    {
+        energy_off(ENERGY_RADIO);
+    }
+#endif
+
+    if (!radio_active)
+    {
+        for (uint8_t cls = 0; cls < RADIO_GAP_CLASS_COUNT; cls++)
+        {
+            if (may_run((radio_gap_class_t)cls))
+            {
+                held_release((radio_gap_class_t)cls);
+            }
+        }
+    }
+}
+
+
+static void tap_end(void)
+{
+    m_tap = false;
+    if (may_run(RADIO_GAP_MX25))
+    {
+        held_release(RADIO_GAP_MX25);
+    }
+}
+
+
+static void tap_timer_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    // A card left on the reader does not hold the flash up for good.
+    m_tap_spent = true;
+    tap_end();
+}
+
+
+ret_code_t radio_gap_init(void)
+{
+    ret_code_t err_code;
+
+    err_code = app_timer_create(&m_tap_timer, APP_TIMER_MODE_SINGLE_SHOT, tap_timer_handler);
+    VERIFY_SUCCESS(err_code);
+
+    return ble_radio_notification_init(RADIO_GAP_IRQ_PRIORITY, RADIO_GAP_DISTANCE, radio_evt_handler);
+}
+
+
+ret_code_t radio_gap_run(radio_gap_class_t cls, app_sched_event_handler_t handler)
+{
+    bool now = true;
+
+    CRITICAL_REGION_ENTER();
+    if (!may_run(cls))
+    {
+        uint8_t i;
+
+        for (i = 0; (i < m_held_count[cls]) && (m_held[cls][i] != handler); i++)
+        {
+        }
+        if (i < m_held_count[cls])
+        {
+            now = false;
+        }
+        else if (m_held_count[cls] < RADIO_GAP_QUEUE_SIZE)
+        {
+            m_held[cls][m_held_count[cls]++] = handler;
+            now = false;
+        }
+    }
+    CRITICAL_REGION_EXIT();
+
+    return now ? put(cls, handler) : NRF_SUCCESS;
+}
+
+
+void radio_gap_tap(bool active)
+{
+    if (!active)
+    {
+        m_tap_spent = false;
+        if (m_tap)
+        {
+            UNUSED_RETURN_VALUE(app_timer_stop(m_tap_timer));
+            tap_end();
+        }
+        return;
+    }
+
+    if (!m_tap && !m_tap_spent)
+    {
+        m_tap = true;
+        if (app_timer_start(m_tap_timer, TAP_TICKS, NULL) != NRF_SUCCESS)
+        {
+            m_tap = false;
+        }
+        else
+        {
+            // Bursts that wait for the radio are needed now.
+            held_release(RADIO_GAP_PN532);
+        }
+    }
+}
+
+#endif //NRF_MODULE_ENABLED(RADIO_GAP)
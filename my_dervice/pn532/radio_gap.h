@@ -0,0 +1,64 @@
+#ifndef __RADIO_GAP_H__
+#define __RADIO_GAP_H__
+
+#include <stdbool.h>
+#include "sdk_common.h"
+#include "app_scheduler.h"
+
+/* Background bus work started between radio events, from the SoftDevice's radio notification:
+ *
+ *   gap         from the end of a radio event until RADIO_GAP_DISTANCE before the next one;
+ *               work asked for then is scheduled at once
+ *   radio       work asked for while the radio is busy, or about to be, waits for the end of
+ *               the event, so a PN532 burst or an MX25 transfer starts with the most time to the
+ *               next one
+ *   tap         while a card is being read, PN532 work is scheduled at once and MX25 work
+ *               waits until the card is gone, for up to RADIO_GAP_TAP_MAX_MS
+ *
+ * A transfer that has started is not cut short by the next radio event; only when it starts
+ * is chosen. Without advertising or a link there are no radio events and nothing waits.
+ * Without RADIO_GAP_ENABLED the work is scheduled at once, as before. */
+
+typedef enum
+{
+    RADIO_GAP_PN532,    /**< Card detection bursts, in the high priority scheduler queue. */
+    RADIO_GAP_MX25,     /**< Flash status polls and background reads. */
+    RADIO_GAP_CLASS_COUNT
+} radio_gap_class_t;
+
+#if NRF_MODULE_ENABLED(RADIO_GAP)
+
+/**@brief Create the tap timer and enable the radio notification on SWI1.
+ *
+ * @note Call after ble_stack_init(), with app_timer and app_scheduler initialized.
+ */
+ret_code_t radio_gap_init(void);
+
+/**@brief Schedule @p handler in the next radio gap. Any context.
+ *
+ * @details A handler already waiting is not queued twice. When RADIO_GAP_QUEUE_SIZE handlers
+ *          of the class wait, it is scheduled at once.
+ *
+ * @return NRF_SUCCESS, or the error of app_scheduler when scheduled at once.
+ */
+ret_code_t radio_gap_run(radio_gap_class_t cls, app_sched_event_handler_t handler);
+
+/**@brief Mark the start or the end of a tap. Call from the main loop. */
+void radio_gap_tap(bool active);
+
+#else
+
+__STATIC_INLINE ret_code_t radio_gap_run(radio_gap_class_t cls, app_sched_event_handler_t handler)
+{
+    return (cls == RADIO_GAP_PN532) ? app_sched_event_put_high(handler) :
+                                      app_sched_event_put(NULL, 0, handler);
+}
+
+__STATIC_INLINE void radio_gap_tap(bool active)
+{
+    UNUSED_PARAMETER(active);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,216 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(READER_TLM)
+#include "reader_tlm.h"
+#include "es.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#include "batt_mon.h"
+#include "lock_journal.h"
+#include "pn532_diag.h"
+#include <string.h>
+
+#if READER_TLM_SHOW_MS >= (READER_TLM_PERIOD_S * 1000)
+#error "READER_TLM_SHOW_MS has to be shorter than READER_TLM_PERIOD_S"
+#endif
+
+STATIC_ASSERT(sizeof(es_tlm_reader_frame_t) == ES_TLM_READER_LENGTH);
+
+#define TLM_TICKS(ms)           APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+#define ES_UUID                 0xFEAA
+
+APP_TIMER_DEF(m_phase_timer);
+
+static ble_advdata_t              m_advdata;
+static ble_advdata_t              m_srdata;
+static reader_tlm_restore_t       m_restore;
+static volatile bool              m_showing;
+
+static es_tlm_reader_frame_t      m_frame;
+static ble_uuid_t                 m_es_uuid = {ES_UUID, BLE_UUID_TYPE_BLE};
+static ble_advdata_service_data_t m_service_data;
+
+static uint32_t                   m_taps;
+static uint32_t                   m_latency_ms;     /**< Sum over m_taps. */
+static uint32_t                   m_card_ops;
+static uint32_t                   m_card_errors;
+static uint32_t                   m_window_tick;    /**< Start of what the next frame covers. */
+static uint32_t                   m_uptime_ms;      /**< Up to m_window_tick, below 100. */
+static uint32_t                   m_uptime_100ms;
+
+
+static uint32_t ms_since(uint32_t tick)
+{
+    uint32_t ticks;
+
+    UNUSED_RETURN_VALUE(app_timer_cnt_diff_compute(app_timer_cnt_get(), tick, &ticks));
+    return (uint32_t)(((uint64_t)ticks * 1000 * (APP_TIMER_CONFIG_PRESCALER + 1)) / APP_TIMER_CLOCK_FREQ);
+}
+
+
+static void be16_put(uint8_t * p_field, uint32_t value)
+{
+    value      = MIN(value, UINT16_MAX);
+    p_field[0] = (uint8_t)(value >> 8);
+    p_field[1] = (uint8_t)value;
+}
+
+
+/**@brief Fill the frame from the counters and start them over. */
+static void frame_build(void)
+{
+    uint32_t window_ms;
+    uint32_t taps;
+    uint32_t latency_ms;
+    uint32_t card_ops;
+    uint32_t card_errors;
+    uint8_t  fill = 0;
+
+    CRITICAL_REGION_ENTER();
+    window_ms      = MAX(ms_since(m_window_tick), 1);
+    m_window_tick  = app_timer_cnt_get();
+    taps           = m_taps;
+    latency_ms     = m_latency_ms;
+    card_ops       = m_card_ops;
+    card_errors    = m_card_errors;
+    m_taps         = 0;
+    m_latency_ms   = 0;
+    m_card_ops     = 0;
+    m_card_errors  = 0;
+    CRITICAL_REGION_EXIT();
+
+    // The window of the RTC wraps after 512 s at prescaler 0, the frames come more often.
+    m_uptime_ms    += window_ms;
+    m_uptime_100ms += m_uptime_ms / 100;
+    m_uptime_ms    %= 100;
+
+#if NRF_MODULE_ENABLED(LOCK_JOURNAL)
+    fill = (uint8_t)MIN(((uint64_t)(lock_journal_head() - lock_journal_oldest()) * 100) /
+                        lock_journal_capacity(), 100);
+#endif
+
+    memset(&m_frame, 0, sizeof(m_frame));
+    m_frame.frame_type = ES_FRAME_TYPE_TLM;
+    m_frame.version    = ES_TLM_VERSION_READER;
+#if NRF_MODULE_ENABLED(BATT_MON)
+    be16_put(m_frame.vbatt, batt_mon_mv_get());
+#endif
+    be16_put(m_frame.taps, (uint32_t)(((uint64_t)taps * 60 * 1000 * 100) / window_ms));
+    be16_put(m_frame.latency, (taps != 0) ? (latency_ms / taps) : 0);
+    be16_put(m_frame.rf_errors, (card_ops != 0) ? ((card_errors * 1000) / card_ops) : 0);
+    m_frame.journal_fill = fill;
+    m_frame.sec_cnt[0]   = (uint8_t)(m_uptime_100ms >> 24);
+    m_frame.sec_cnt[1]   = (uint8_t)(m_uptime_100ms >> 16);
+    m_frame.sec_cnt[2]   = (uint8_t)(m_uptime_100ms >> 8);
+    m_frame.sec_cnt[3]   = (uint8_t)m_uptime_100ms;
+#if NRF_MODULE_ENABLED(PN532_DIAG)
+    m_frame.diag         = pn532_diag_flags();
+#endif
+}
+
+
+static void frame_show(void)
+{
+    ble_advdata_t advdata;
+
+    frame_build();
+
+    memset(&advdata, 0, sizeof(advdata));
+    advdata.flags                   = BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE;
+    advdata.uuids_complete.uuid_cnt = 1;
+    advdata.uuids_complete.p_uuids  = &m_es_uuid;
+    advdata.service_data_count      = 1;
+    advdata.p_service_data_array    = &m_service_data;
+
+    m_showing = true;
+    // Takes effect with the next advertising event, also while advertising.
+    UNUSED_RETURN_VALUE(ble_advdata_set(&advdata, &m_srdata));
+}
+
+
+static void frame_hide(void)
+{
+    m_showing = false;
+    if (m_restore != NULL)
+    {
+        m_restore();
+    }
+    else
+    {
+        UNUSED_RETURN_VALUE(ble_advdata_set(&m_advdata, &m_srdata));
+    }
+}
+
+
+static void phase_timer_handler(void * p_context)
+{
+    uint32_t next_ms;
+
+    UNUSED_PARAMETER(p_context);
+
+    if (m_showing)
+    {
+        frame_hide();
+        next_ms = (READER_TLM_PERIOD_S * 1000) - READER_TLM_SHOW_MS;
+    }
+    else
+    {
+        frame_show();
+        next_ms = READER_TLM_SHOW_MS;
+    }
+    UNUSED_RETURN_VALUE(app_timer_start(m_phase_timer, TLM_TICKS(next_ms), NULL));
+}
+
+
+ret_code_t reader_tlm_init(ble_advdata_t const * p_advdata, ble_advdata_t const * p_srdata,
+                           reader_tlm_restore_t restore)
+{
+    ret_code_t err_code;
+
+    m_advdata = *p_advdata;
+    m_srdata  = *p_srdata;
+    m_restore = restore;
+    m_showing = false;
+
+    m_service_data.service_uuid = ES_UUID;
+    m_service_data.data.p_data  = (uint8_t *)&m_frame;
+    m_service_data.data.size    = sizeof(m_frame);
+
+    m_window_tick = app_timer_cnt_get();
+
+    err_code = app_timer_create(&m_phase_timer, APP_TIMER_MODE_SINGLE_SHOT, phase_timer_handler);
+    VERIFY_SUCCESS(err_code);
+
+    return app_timer_start(m_phase_timer,
+                           TLM_TICKS((READER_TLM_PERIOD_S * 1000) - READER_TLM_SHOW_MS), NULL);
+}
+
+
+void reader_tlm_tap(uint32_t start)
+{
+    uint32_t latency_ms = ms_since(start);
+
+    CRITICAL_REGION_ENTER();
+    m_taps++;
+    m_latency_ms += latency_ms;
+    CRITICAL_REGION_EXIT();
+}
+
+
+void reader_tlm_card_op(bool ok)
+{
+    CRITICAL_REGION_ENTER();
+    m_card_ops++;
+    if (!ok)
+    {
+        m_card_errors++;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+
+bool reader_tlm_showing(void)
+{
+    return m_showing;
+}
+
+#endif //NRF_MODULE_ENABLED(READER_TLM)
@@ -0,0 +1,52 @@
+#ifndef __READER_TLM_H__
+#define __READER_TLM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "ble_advdata.h"
+
+/* Reader health as an Eddystone TLM frame of its own, es_tlm_reader_frame_t, for fleet
+ * monitoring by scanners that never connect:
+ *
+ *   taps       taps per minute, and the average time from the card found to the decision
+ *   rf         card operations that failed, per 1000
+ *   journal    fill level of the journal
+ *   diag       flags of the last PN532 self test, with PN532_DIAG
+ *   battery    from batt_mon, with BATT_MON
+ *
+ * The rates cover the time since the previous frame. Every READER_TLM_PERIOD_S the advertising
+ * data is the frame, with the Eddystone UUID, for READER_TLM_SHOW_MS; advertising itself is not
+ * stopped and stays connectable, and the scan response keeps the NUS UUID, so phones that
+ * filter on it still find the lock. */
+
+/**@brief Puts the normal advertising data back after a frame. */
+typedef void (*reader_tlm_restore_t)(void);
+
+/**@brief Start the frames.
+ *
+ * @details Call after ble_advertising_init() with the same data. The structures are copied;
+ *          what they point to must stay valid.
+ *
+ * @param[in] p_advdata  Advertising data, put back after each frame when @p restore is NULL.
+ * @param[in] p_srdata   Scan response data, kept during the frames.
+ * @param[in] restore    Owner of the advertising data that puts it back, or NULL.
+ *
+ * @note Requires app_timer to be initialized.
+ */
+ret_code_t reader_tlm_init(ble_advdata_t const * p_advdata, ble_advdata_t const * p_srdata,
+                           reader_tlm_restore_t restore);
+
+/**@brief A tap has been decided. Call from the main loop.
+ *
+ * @param[in] start  app_timer_cnt_get() when the card was found.
+ */
+void reader_tlm_tap(uint32_t start);
+
+/**@brief A card operation on a card in the field has ended. Call from the main loop. */
+void reader_tlm_card_op(bool ok);
+
+/**@brief Whether the advertising data is the frame now; others leave it alone meanwhile. */
+bool reader_tlm_showing(void);
+
+#endif
@@ -0,0 +1,168 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(STREAM_FRAME)
+#include "stream_frame.h"
+#include "crc16.h"
+
+#if !NRF_MODULE_ENABLED(CRC16)
+#error "stream_frame needs CRC16_ENABLED"
+#endif
+
+typedef enum
+{
+    STATE_UNSYNCED,     /**< No END seen yet. */
+    STATE_DATA,
+    STATE_ESC,          /**< The byte after ESC. */
+    STATE_DISCARD,      /**< Frame dropped, up to the next END. */
+} state_t;
+
+
+void stream_frame_dec_init(stream_frame_dec_t * p_dec, uint8_t * p_buf, uint16_t size)
+{
+    p_dec->p_buf = p_buf;
+    p_dec->size  = size;
+    stream_frame_dec_reset(p_dec);
+}
+
+
+void stream_frame_dec_reset(stream_frame_dec_t * p_dec)
+{
+    p_dec->len   = 0;
+    p_dec->state = STATE_UNSYNCED;
+}
+
+
+bool stream_frame_dec_busy(stream_frame_dec_t const * p_dec)
+{
+    return ((p_dec->state == STATE_DATA) && (p_dec->len > 0)) ||
+           (p_dec->state == STATE_ESC) || (p_dec->state == STATE_DISCARD);
+}
+
+
+static void frame_end(stream_frame_dec_t * p_dec, stream_frame_handler_t handler, void * p_context)
+{
+    uint16_t len;
+
+    // Back to back ENDs are empty frames, and a payload takes at least one byte.
+    if ((p_dec->state != STATE_DATA) || (p_dec->len <= STREAM_FRAME_CRC_LEN))
+    {
+        return;
+    }
+
+    len = p_dec->len - STREAM_FRAME_CRC_LEN;
+    if (crc16_compute(p_dec->p_buf, len, NULL) == uint16_decode(&p_dec->p_buf[len]))
+    {
+        handler(p_context, p_dec->p_buf, len);
+    }
+}
+
+
+void stream_frame_feed(stream_frame_dec_t   * p_dec,
+                       uint8_t const        * p_data,
+                       uint16_t               len,
+                       stream_frame_handler_t handler,
+                       void                 * p_context)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        uint8_t c = p_data[i];
+
+        if (c == STREAM_FRAME_END)
+        {
+            frame_end(p_dec, handler, p_context);
+            p_dec->state = STATE_DATA;
+            p_dec->len   = 0;
+            continue;
+        }
+
+        switch (p_dec->state)
+        {
+            case STATE_DATA:
+                if (c == STREAM_FRAME_ESC)
+                {
+                    p_dec->state = STATE_ESC;
+                    continue;
+                }
+                break;
+
+            case STATE_ESC:
+                if ((c != STREAM_FRAME_ESC_END) && (c != STREAM_FRAME_ESC_ESC))
+                {
+                    p_dec->state = STATE_DISCARD;
+                    continue;
+                }
+                c            = (c == STREAM_FRAME_ESC_END) ? STREAM_FRAME_END : STREAM_FRAME_ESC;
+                p_dec->state = STATE_DATA;
+                break;
+
+            default:
+                continue;
+        }
+
+        if (p_dec->len == p_dec->size)
+        {
+            p_dec->state = STATE_DISCARD;
+            continue;
+        }
+        p_dec->p_buf[p_dec->len++] = c;
+    }
+}
+
+
+/**@brief Append @p len stuffed bytes at @p pos.
+ *
+ * @return Position after them, or 0 if they do not fit.
+ */
+static uint16_t stuff(uint8_t const * p_data, uint16_t len, uint8_t * p_out, uint16_t pos, uint16_t size)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        uint8_t c = p_data[i];
+
+        if ((c == STREAM_FRAME_END) || (c == STREAM_FRAME_ESC))
+        {
+            if (pos + 2 > size)
+            {
+                return 0;
+            }
+            p_out[pos++] = STREAM_FRAME_ESC;
+            p_out[pos++] = (c == STREAM_FRAME_END) ? STREAM_FRAME_ESC_END : STREAM_FRAME_ESC_ESC;
+        }
+        else
+        {
+            if (pos + 1 > size)
+            {
+                return 0;
+            }
+            p_out[pos++] = c;
+        }
+    }
+    return pos;
+}
+
+
+uint16_t stream_frame_encode(uint8_t const * p_data, uint16_t len, uint8_t * p_out, uint16_t out_size)
+{
+    uint8_t  crc[STREAM_FRAME_CRC_LEN];
+    uint16_t pos = 0;
+
+    if (out_size < 2)
+    {
+        return 0;
+    }
+    UNUSED_RETURN_VALUE(uint16_encode(crc16_compute(p_data, len, NULL), crc));
+
+    p_out[pos++] = STREAM_FRAME_END;
+    pos = stuff(p_data, len, p_out, pos, out_size);
+    if (pos != 0)
+    {
+        pos = stuff(crc, sizeof(crc), p_out, pos, out_size);
+    }
+    if ((pos == 0) || (pos == out_size))
+    {
+        return 0;
+    }
+    p_out[pos++] = STREAM_FRAME_END;
+    return pos;
+}
+
+#endif //NRF_MODULE_ENABLED(STREAM_FRAME)
@@ -0,0 +1,74 @@
+#ifndef __STREAM_FRAME_H__
+#define __STREAM_FRAME_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* SLIP (RFC 1055) framing with a CRC16, the same on every byte stream link:
+ *
+ *   frame     END, the payload and its crc16_compute (little endian), byte stuffed, END; the
+ *             END in front puts a receiver that joined mid-stream back in step
+ *   decoder   one per link, fed whatever the transport hands over (a UART frame, a NUS write,
+ *             a USB packet) with no regard to frame bounds; it unescapes straight into its own
+ *             buffer and calls the handler once per frame with a good CRC, never per byte
+ *   errors    a frame too long for the buffer, a bad escape or a bad CRC is dropped, up to
+ *             the next END */
+
+#define STREAM_FRAME_END      0xC0
+#define STREAM_FRAME_ESC      0xDB
+#define STREAM_FRAME_ESC_END  0xDC
+#define STREAM_FRAME_ESC_ESC  0xDD
+
+#define STREAM_FRAME_CRC_LEN  2
+
+/**@brief Decoder buffer for payloads of up to @p max_len bytes. */
+#define STREAM_FRAME_BUF_SIZE(max_len)  ((max_len) + STREAM_FRAME_CRC_LEN)
+
+/**@brief Encoded size of a @p len byte payload at worst, every byte escaped. */
+#define STREAM_FRAME_ENC_MAX(len)       (2 + 2 * ((len) + STREAM_FRAME_CRC_LEN))
+
+/**@brief Frame handler, in the context of @ref stream_frame_feed.
+ *
+ * @param[in] p_data  Payload without the CRC, in the decoder buffer: valid until the handler
+ *                    returns, and may be changed in place.
+ */
+typedef void (*stream_frame_handler_t)(void * p_context, uint8_t * p_data, uint16_t len);
+
+/**@brief Decoder of one link. Set up with @ref stream_frame_dec_init; the members are private. */
+typedef struct
+{
+    uint8_t * p_buf;
+    uint16_t  size;
+    uint16_t  len;
+    uint8_t   state;
+} stream_frame_dec_t;
+
+/**@brief Set a decoder up on @p p_buf, outside any frame until the first END. */
+void stream_frame_dec_init(stream_frame_dec_t * p_dec, uint8_t * p_buf, uint16_t size);
+
+/**@brief Drop the partial frame and wait for the next END, for example when the link drops. */
+void stream_frame_dec_reset(stream_frame_dec_t * p_dec);
+
+/**@brief Whether a frame has started and not ended, so the next bytes belong to it. */
+bool stream_frame_dec_busy(stream_frame_dec_t const * p_dec);
+
+/**@brief Decode bytes of the link.
+ *
+ * @details Bytes come in any cut; @p handler is called for each frame that ends in them.
+ */
+void stream_frame_feed(stream_frame_dec_t   * p_dec,
+                       uint8_t const        * p_data,
+                       uint16_t               len,
+                       stream_frame_handler_t handler,
+                       void                 * p_context);
+
+/**@brief Frame a payload.
+ *
+ * @param[out] p_out     Encoded frame; @ref STREAM_FRAME_ENC_MAX bytes always fit.
+ * @param[in]  out_size  Size of @p p_out.
+ *
+ * @return Length of the frame, or 0 if it does not fit.
+ */
+uint16_t stream_frame_encode(uint8_t const * p_data, uint16_t len, uint8_t * p_out, uint16_t out_size);
+
+#endif
@@ -0,0 +1,164 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(TAP_BEACON)
+#include "tap_beacon.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#include "crc16.h"
+#include "reader_tlm.h"
+#include "passback.h"
+#include <string.h>
+
+#define BEACON_TICKS(ms)  APP_TIMER_TICKS(ms, APP_TIMER_CONFIG_PRESCALER)
+#define TICKS_PER_S       (APP_TIMER_CLOCK_FREQ / (APP_TIMER_CONFIG_PRESCALER + 1))
+#define AGE_MAX           255
+
+// Ages are measured against the 24-bit RTC, so they are frozen before it wraps.
+STATIC_ASSERT((AGE_MAX + TAP_BEACON_REFRESH_S) * TICKS_PER_S < 0x1000000);
+
+typedef struct
+{
+    uint32_t stamp;     /**< app_timer_cnt_get() at the tap. */
+    uint16_t uid_hash;
+    uint8_t  result;
+    uint8_t  age;       /**< Seconds, AGE_MAX once no longer counted. */
+} tap_t;
+
+APP_TIMER_DEF(m_age_timer);
+
+static tap_t                    m_taps[TAP_BEACON_EVENTS];  /**< Newest first. */
+static uint8_t                  m_used;
+static uint8_t                  m_count;                    /**< Taps so far, modulo 256. */
+static uint8_t                  m_payload[TAP_BEACON_LEN(TAP_BEACON_EVENTS)];
+static ble_advdata_manuf_data_t m_manuf;
+static ble_advdata_t            m_advdata;
+static ble_advdata_t            m_srdata;
+
+
+/**@brief Bring the ages up to date.
+ *
+ * @return Whether a tap is still younger than AGE_MAX.
+ */
+static bool ages_update(void)
+{
+    uint32_t now   = app_timer_cnt_get();
+    bool     young = false;
+
+    for (uint8_t i = 0; i < m_used; i++)
+    {
+        uint32_t ticks;
+
+        if (m_taps[i].age == AGE_MAX)
+        {
+            continue;
+        }
+        UNUSED_RETURN_VALUE(app_timer_cnt_diff_compute(now, m_taps[i].stamp, &ticks));
+        m_taps[i].age = MIN(ticks / TICKS_PER_S, AGE_MAX);
+        young        |= (m_taps[i].age < AGE_MAX);
+    }
+
+    return young;
+}
+
+
+/**@brief Encode the taps and hand the advertising data to the SoftDevice. */
+static void payload_set(void)
+{
+    uint16_t len = 0;
+
+    CRITICAL_REGION_ENTER();
+    m_payload[len++] = m_count;
+    for (uint8_t i = 0; i < m_used; i++)
+    {
+        len += uint16_encode(m_taps[i].uid_hash, &m_payload[len]);
+        m_payload[len++] = m_taps[i].result;
+        m_payload[len++] = m_taps[i].age;
+    }
+    m_manuf.data.size = len;
+    CRITICAL_REGION_EXIT();
+
+#if NRF_MODULE_ENABLED(READER_TLM)
+    // The health frame is on the air; it puts the taps back when it is done.
+    if (reader_tlm_showing())
+    {
+        return;
+    }
+#endif
+#if NRF_MODULE_ENABLED(PASSBACK)
+    // So is an anti-passback frame, likewise.
+    if (passback_showing())
+    {
+        return;
+    }
+#endif
+    // Takes effect with the next advertising event, also while advertising.
+    UNUSED_RETURN_VALUE(ble_advdata_set(&m_advdata, &m_srdata));
+}
+
+
+static void age_timer_handler(void * p_context)
+{
+    bool young;
+
+    UNUSED_PARAMETER(p_context);
+
+    CRITICAL_REGION_ENTER();
+    young = ages_update();
+    CRITICAL_REGION_EXIT();
+
+    if (!young)
+    {
+        UNUSED_RETURN_VALUE(app_timer_stop(m_age_timer));
+    }
+    payload_set();
+}
+
+
+ret_code_t tap_beacon_init(ble_advdata_t const * p_advdata, ble_advdata_t const * p_srdata)
+{
+    ret_code_t err_code;
+
+    err_code = app_timer_create(&m_age_timer, APP_TIMER_MODE_REPEATED, age_timer_handler);
+    VERIFY_SUCCESS(err_code);
+
+    m_advdata = *p_advdata;
+    m_srdata  = *p_srdata;
+
+    m_used  = 0;
+    m_count = 0;
+
+    m_payload[0]                    = m_count;
+    m_manuf.company_identifier      = TAP_BEACON_COMPANY_ID;
+    m_manuf.data.p_data             = m_payload;
+    m_manuf.data.size               = TAP_BEACON_LEN(0);
+    m_advdata.p_manuf_specific_data = &m_manuf;
+
+    return ble_advdata_set(&m_advdata, &m_srdata);
+}
+
+
+void tap_beacon_add(uint8_t result, uint8_t const * p_uid, uint8_t len)
+{
+    CRITICAL_REGION_ENTER();
+    UNUSED_RETURN_VALUE(ages_update());
+    memmove(&m_taps[1], &m_taps[0], (TAP_BEACON_EVENTS - 1) * sizeof(m_taps[0]));
+    m_taps[0].stamp    = app_timer_cnt_get();
+    m_taps[0].uid_hash = crc16_compute(p_uid, len, NULL);
+    m_taps[0].result   = result;
+    m_taps[0].age      = 0;
+    m_used             = MIN(m_used + 1, TAP_BEACON_EVENTS);
+    m_count++;
+    CRITICAL_REGION_EXIT();
+
+    payload_set();
+
+    // Ignored while the timer runs.
+    UNUSED_RETURN_VALUE(app_timer_start(m_age_timer, BEACON_TICKS(TAP_BEACON_REFRESH_S * 1000), NULL));
+}
+
+
+void tap_beacon_refresh(void)
+{
+    payload_set();
+}
+
+#endif //NRF_MODULE_ENABLED(TAP_BEACON)
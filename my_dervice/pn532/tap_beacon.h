@@ -0,0 +1,48 @@
+#ifndef __TAP_BEACON_H__
+#define __TAP_BEACON_H__
+
+#include <stdint.h>
+#include "ble_advdata.h"
+
+/* The last taps in the manufacturer specific data of the advertising packet, for scanners
+ * that watch many locks without connecting:
+ *
+ *   company id (LE), taps, then per tap, newest first: uid hash (LE), result, age
+ *
+ * taps counts every tap modulo 256, so a scanner tells new taps from repeats and sees the
+ * ones it missed. The uid hash is crc16_compute() of the UID, the result a
+ * lock_journal_type_t, the age the seconds since the tap, 255 for 255 and more. Up to
+ * TAP_BEACON_EVENTS taps are sent, all in every packet.
+ *
+ * With adv_sched the lock advertises fast for a while after a tap, then slowly; scanners need
+ * ADV_SCHED_SLOW_TIMEOUT 0 to see every tap. No advertising runs while a phone is connected;
+ * the new data goes out once it has disconnected. */
+
+#define TAP_BEACON_TAP_LEN  4   /**< Bytes per tap. */
+#define TAP_BEACON_LEN(n)   (1 + (n) * TAP_BEACON_TAP_LEN)
+
+/**@brief Put the tap data into the advertising data.
+ *
+ * @details Call after ble_advertising_init() with the same data. The structures are copied;
+ *          what they point to must stay valid.
+ *
+ * @param[in] p_advdata  Advertising data, without manufacturer specific data.
+ * @param[in] p_srdata   Scan response data.
+ *
+ * @return NRF_SUCCESS, or an error from ble_advdata_set(), such as NRF_ERROR_DATA_SIZE when
+ *         the tap data does not fit next to the name.
+ */
+ret_code_t tap_beacon_init(ble_advdata_t const * p_advdata, ble_advdata_t const * p_srdata);
+
+/**@brief Add a tap. Call from the main loop.
+ *
+ * @param[in] result  lock_journal_type_t of the tap.
+ * @param[in] p_uid   UID.
+ * @param[in] len     UID length.
+ */
+void tap_beacon_add(uint8_t result, uint8_t const * p_uid, uint8_t len);
+
+/**@brief Hand the tap data to the SoftDevice again, for whoever swapped the advertising data. */
+void tap_beacon_refresh(void);
+
+#endif
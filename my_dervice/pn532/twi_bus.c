@@ -0,0 +1,458 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(TWI_BUS)
+#include "twi_bus.h"
+#include "app_util_platform.h"
+#include "app_timer.h"
+#include "app_error.h"
+#include "nrf_gpio.h"
+#include "nrf_drv_common.h"
+#include "nrf_delay.h"
+#include <string.h>
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+#include "pwr_idle.h"
+#endif
+#if NRF_MODULE_ENABLED(ENERGY)
+#include "energy.h"
+#endif
+
+#if !TWI1_ENABLED
+#error "twi_bus runs on TWI1, set TWI1_ENABLED"
+#endif
+
+#define WATCH_TICKS     APP_TIMER_TICKS(TWI_BUS_TIMEOUT_MS, APP_TIMER_CONFIG_PRESCALER)
+
+typedef struct
+{
+    volatile bool       done;
+    volatile ret_code_t result;
+} perform_ctx_t;
+
+static const nrf_drv_twi_t m_twi = NRF_DRV_TWI_INSTANCE(1);
+
+APP_TIMER_DEF(m_watch_timer);
+
+static bool                     m_initialized;
+static twi_bus_txn_t *          mp_head[TWI_BUS_PRIO_COUNT];
+static twi_bus_txn_t *          mp_tail[TWI_BUS_PRIO_COUNT];
+static twi_bus_txn_t * volatile mp_current;     /**< On the bus, or NULL. */
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+static bool                     m_suspended;    /**< Peripheral disabled between transactions. */
+#endif
+static bool                     m_watching;     /**< The watch timer runs; it stops on an idle tick. */
+static volatile uint8_t         m_xfer_seq;     /**< Bumped by each transfer put on the bus. */
+static uint8_t                  m_xfer_seen;    /**< At the last tick of the watch. */
+static twi_bus_stats_t          m_stats;
+#ifdef TWIM_IN_USE
+static uint8_t                  m_dma_buf[UINT8_MAX];   /**< Writes from flash, for EasyDMA. */
+#endif
+
+
+static void sat_inc(uint16_t * p_count)
+{
+    if (*p_count < UINT16_MAX)
+    {
+        (*p_count)++;
+    }
+}
+
+
+static void frequency_set(nrf_twi_frequency_t frequency)
+{
+#ifdef TWIM_IN_USE
+    if (m_twi.use_easy_dma)
+    {
+        // TWIM has its own register values for the same clocks.
+        nrf_twim_frequency_set(m_twi.reg.p_twim,
+                               (frequency == NRF_TWI_FREQ_100K) ? NRF_TWIM_FREQ_100K :
+                               (frequency == NRF_TWI_FREQ_250K) ? NRF_TWIM_FREQ_250K :
+                                                                  NRF_TWIM_FREQ_400K);
+        return;
+    }
+#endif
+    nrf_twi_frequency_set(m_twi.reg.p_twi, frequency);
+}
+
+
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+/**@brief pwr_idle hook: disable TWI1 while nothing is queued; next_start() enables it. */
+static bool bus_idle(void)
+{
+    bool down = false;
+
+    CRITICAL_REGION_ENTER();
+    if (!m_suspended && twi_bus_idle())
+    {
+        nrf_drv_twi_disable(&m_twi);
+        m_suspended = true;
+        down        = true;
+    }
+    CRITICAL_REGION_EXIT();
+    return down;
+}
+
+
+static const pwr_idle_hook_t m_idle_hook =
+{
+    .idle    = bus_idle,
+    .wake_us = 1,
+};
+#endif
+
+
+static ret_code_t xfer_start(twi_bus_txn_t * p_txn)
+{
+    twi_bus_xfer_t const *  p_xfer = &p_txn->p_xfers[p_txn->index];
+    uint8_t *               p_data = p_xfer->p_data;
+    nrf_drv_twi_xfer_desc_t desc;
+
+#ifdef TWIM_IN_USE
+    // TWIM reads RAM only. One transfer at a time is on the bus, so one copy does.
+    if (m_twi.use_easy_dma && !(p_xfer->flags & TWI_BUS_READ) && !nrf_drv_is_in_RAM(p_data))
+    {
+        memcpy(m_dma_buf, p_data, p_xfer->length);
+        p_data = m_dma_buf;
+    }
+#endif
+    desc = (p_xfer->flags & TWI_BUS_READ) ?
+           (nrf_drv_twi_xfer_desc_t)NRF_DRV_TWI_XFER_DESC_RX(p_txn->p_dev->address, p_data, p_xfer->length) :
+           (nrf_drv_twi_xfer_desc_t)NRF_DRV_TWI_XFER_DESC_TX(p_txn->p_dev->address, p_data, p_xfer->length);
+
+    m_xfer_seq++;
+    return nrf_drv_twi_xfer(&m_twi, &desc,
+                            (p_xfer->flags & TWI_BUS_NO_STOP) ? NRF_DRV_TWI_FLAG_TX_NO_STOP : 0);
+}
+
+
+static void config_get(nrf_drv_twi_config_t * p_config)
+{
+    nrf_drv_twi_config_t config = NRF_DRV_TWI_DEFAULT_CONFIG;
+
+    config.scl                = TWI_BUS_SCL_PIN;
+    config.sda                = TWI_BUS_SDA_PIN;
+    config.frequency          = NRF_TWI_FREQ_400K;
+    config.interrupt_priority = TWI_BUS_IRQ_PRIORITY;
+    // The pull-ups stay on over a recovery, so the lines do not float.
+    config.hold_bus_uninit    = true;
+    *p_config = config;
+}
+
+
+static void twi_evt_handler(nrf_drv_twi_evt_t const * p_event, void * p_context);
+
+
+/**@brief Set the driver up again with the bus cleared: up to nine clocks on SCL, until the
+ *        part holding SDA lets go, then a STOP. Nothing may be on the bus any more.
+ */
+static void bus_recover(void)
+{
+    nrf_drv_twi_config_t config;
+
+    config_get(&config);
+    config.clear_bus_init = true;
+
+    nrf_drv_twi_uninit(&m_twi);
+#ifdef NRF51
+    // The state machine of the nRF51 TWI starts over only with its power cycled.
+    m_twi.reg.p_twi->POWER = 0;
+    m_twi.reg.p_twi->POWER = 1;
+#endif
+    APP_ERROR_CHECK(nrf_drv_twi_init(&m_twi, &config, twi_evt_handler, NULL));
+    nrf_drv_twi_enable(&m_twi);
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+    m_suspended = false;
+#endif
+    sat_inc(&m_stats.recoveries);
+}
+
+
+static void txn_finish(twi_bus_txn_t * p_txn, ret_code_t result);
+
+
+/**@brief Start the first transaction of the highest queue that has one, if the bus is free. */
+static void next_start(void)
+{
+    twi_bus_txn_t * p_txn = NULL;
+    ret_code_t      err_code;
+
+    CRITICAL_REGION_ENTER();
+    if (mp_current == NULL)
+    {
+        for (uint8_t prio = 0; (prio < TWI_BUS_PRIO_COUNT) && (p_txn == NULL); prio++)
+        {
+            p_txn = mp_head[prio];
+            if (p_txn != NULL)
+            {
+                mp_head[prio] = p_txn->p_next;
+                if (mp_head[prio] == NULL)
+                {
+                    mp_tail[prio] = NULL;
+                }
+            }
+        }
+        mp_current = p_txn;
+        if ((p_txn != NULL) && !m_watching)
+        {
+            m_xfer_seen = m_xfer_seq;
+            m_watching  = (app_timer_start(m_watch_timer, WATCH_TICKS, NULL) == NRF_SUCCESS);
+        }
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+        if ((p_txn != NULL) && m_suspended)
+        {
+            nrf_drv_twi_enable(&m_twi);
+            m_suspended = false;
+        }
+#endif
+    }
+#if NRF_MODULE_ENABLED(ENERGY)
+    if (mp_current != NULL)
+    {
+        energy_on(ENERGY_TWI);
+    }
+    else
+    {
+        energy_off(ENERGY_TWI);
+    }
+#endif
+    CRITICAL_REGION_EXIT();
+
+    if (p_txn == NULL)
+    {
+        return;
+    }
+
+    // The bus is idle between transactions: the clock of the next part can be set.
+    frequency_set(p_txn->p_dev->frequency);
+    p_txn->index = 0;
+    err_code     = xfer_start(p_txn);
+    if (err_code != NRF_SUCCESS)
+    {
+        sat_inc(&m_stats.refused);
+        txn_finish(p_txn, err_code);
+    }
+}
+
+
+static void txn_finish(twi_bus_txn_t * p_txn, ret_code_t result)
+{
+    mp_current    = NULL;
+    p_txn->queued = false;
+
+    // The callback may queue the transaction again.
+    if (p_txn->callback != NULL)
+    {
+        p_txn->callback(result, p_txn->p_context);
+    }
+    next_start();
+}
+
+
+static void twi_evt_handler(nrf_drv_twi_evt_t const * p_event, void * p_context)
+{
+    twi_bus_txn_t * p_txn = mp_current;
+    ret_code_t      result;
+
+    UNUSED_PARAMETER(p_context);
+
+    switch (p_event->type)
+    {
+        case NRF_DRV_TWI_EVT_DONE:
+            result = NRF_SUCCESS;
+            break;
+
+        case NRF_DRV_TWI_EVT_ADDRESS_NACK:
+            result = NRF_ERROR_DRV_TWI_ERR_ANACK;
+            sat_inc(&m_stats.anack);
+            break;
+
+        default:
+            result = NRF_ERROR_DRV_TWI_ERR_DNACK;
+            sat_inc(&m_stats.dnack);
+            break;
+    }
+
+    if (p_txn == NULL)
+    {
+        return;
+    }
+
+    if ((result == NRF_SUCCESS) && (++p_txn->index < p_txn->count))
+    {
+        result = xfer_start(p_txn);
+        if (result == NRF_SUCCESS)
+        {
+            return;
+        }
+        sat_inc(&m_stats.refused);
+    }
+    else if (result != NRF_SUCCESS)
+    {
+        // The STOP after the error leaves SDA high, unless a part holds it. Wait out the edge.
+        nrf_delay_us(10);
+        if (nrf_gpio_pin_read(TWI_BUS_SDA_PIN) == 0)
+        {
+            sat_inc(&m_stats.stuck);
+            bus_recover();
+        }
+    }
+    txn_finish(p_txn, result);
+}
+
+
+/**@brief Every TWI_BUS_TIMEOUT_MS while the bus is busy: a transfer that was on the bus at the
+ *        last tick already and still is has hung. Stops at the first idle tick.
+ */
+static void watch_handler(void * p_context)
+{
+    twi_bus_txn_t * p_txn = NULL;
+
+    UNUSED_PARAMETER(p_context);
+
+    CRITICAL_REGION_ENTER();
+    if (mp_current == NULL)
+    {
+        // Stopped in here, so a start from the TWI interrupt comes after it.
+        UNUSED_RETURN_VALUE(app_timer_stop(m_watch_timer));
+        m_watching = false;
+    }
+    else if (m_xfer_seq == m_xfer_seen)
+    {
+        p_txn = mp_current;
+        // No event of the hung transfer comes in after this.
+        nrf_drv_twi_disable(&m_twi);
+    }
+    m_xfer_seen = m_xfer_seq;
+    CRITICAL_REGION_EXIT();
+
+    if (p_txn != NULL)
+    {
+        sat_inc(&m_stats.timeouts);
+        bus_recover();
+        txn_finish(p_txn, NRF_ERROR_TIMEOUT);
+    }
+}
+
+
+ret_code_t twi_bus_init(void)
+{
+    ret_code_t           err_code;
+    nrf_drv_twi_config_t config;
+
+    if (m_initialized)
+    {
+        return NRF_SUCCESS;
+    }
+
+    err_code = app_timer_create(&m_watch_timer, APP_TIMER_MODE_REPEATED, watch_handler);
+    VERIFY_SUCCESS(err_code);
+
+    config_get(&config);
+    err_code = nrf_drv_twi_init(&m_twi, &config, twi_evt_handler, NULL);
+    VERIFY_SUCCESS(err_code);
+
+    nrf_drv_twi_enable(&m_twi);
+
+#if NRF_MODULE_ENABLED(PWR_IDLE)
+    err_code = pwr_idle_register(&m_idle_hook);
+    VERIFY_SUCCESS(err_code);
+#endif
+    m_initialized = true;
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t twi_bus_schedule(twi_bus_txn_t * p_txn)
+{
+    ret_code_t err_code = NRF_SUCCESS;
+    uint8_t    prio;
+
+    if ((p_txn->count == 0) || (p_txn->p_xfers == NULL) || (p_txn->p_dev->prio >= TWI_BUS_PRIO_COUNT))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    prio = p_txn->p_dev->prio;
+
+    CRITICAL_REGION_ENTER();
+    if (p_txn->queued)
+    {
+        err_code = NRF_ERROR_BUSY;
+    }
+    else
+    {
+        p_txn->queued = true;
+        p_txn->p_next = NULL;
+        if (mp_tail[prio] == NULL)
+        {
+            mp_head[prio] = p_txn;
+        }
+        else
+        {
+            mp_tail[prio]->p_next = p_txn;
+        }
+        mp_tail[prio] = p_txn;
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (err_code == NRF_SUCCESS)
+    {
+        next_start();
+    }
+    return err_code;
+}
+
+
+static void perform_done(ret_code_t result, void * p_context)
+{
+    perform_ctx_t * p_ctx = (perform_ctx_t *)p_context;
+
+    p_ctx->result = result;
+    p_ctx->done   = true;
+}
+
+
+ret_code_t twi_bus_perform(twi_bus_dev_t const * p_dev, twi_bus_xfer_t const * p_xfers, uint8_t count)
+{
+    perform_ctx_t ctx = {.done = false};
+    twi_bus_txn_t txn =
+    {
+        .p_dev     = p_dev,
+        .p_xfers   = p_xfers,
+        .count     = count,
+        .callback  = perform_done,
+        .p_context = &ctx,
+    };
+    ret_code_t    err_code;
+
+    err_code = twi_bus_schedule(&txn);
+    VERIFY_SUCCESS(err_code);
+
+    while (!ctx.done)
+    {
+    }
+    return ctx.result;
+}
+
+
+bool twi_bus_idle(void)
+{
+    bool idle;
+
+    CRITICAL_REGION_ENTER();
+    idle = (mp_current == NULL);
+    for (uint8_t prio = 0; prio < TWI_BUS_PRIO_COUNT; prio++)
+    {
+        idle = idle && (mp_head[prio] == NULL);
+    }
+    CRITICAL_REGION_EXIT();
+
+    return idle;
+}
+
+
+void twi_bus_stats_get(twi_bus_stats_t * p_stats)
+{
+    CRITICAL_REGION_ENTER();
+    *p_stats = m_stats;
+    CRITICAL_REGION_EXIT();
+}
+
+#endif //NRF_MODULE_ENABLED(TWI_BUS)
@@ -0,0 +1,114 @@
+#ifndef __TWI_BUS_H__
+#define __TWI_BUS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "nrf_drv_twi.h"
+
+/* One TWI instance shared by the PN532 and the other I2C parts, without blocking:
+ *
+ *   device       address, clock and priority of one part; the clock is set before each of
+ *                its transactions, so a 100 kHz sensor and the 400 kHz PN532 share the bus
+ *   transaction  the transfers to one device, back to back (a register write without stop,
+ *                then the read); owned by the caller and queued by pointer, so the queue
+ *                needs no size
+ *   priority     the high queue is drained first: a card exchange waits at most for the end
+ *                of the sensor transaction already on the bus, a few bytes, never for a queue
+ *   callback     from the TWI interrupt, at TWI_BUS_IRQ_PRIORITY, when the last transfer
+ *                ends or one fails
+ *
+ * twi_bus_perform() runs a transaction and waits for it, for drivers written blocking.
+ *
+ * A part that resets or browns out in the middle of a byte can hold SDA low, and every transfer
+ * after fails. A transfer that ends in an error with SDA still low, or that does not end within
+ * TWI_BUS_TIMEOUT_MS, has the bus recovered: the driver is set up again, which clocks SCL up to
+ * nine times and sends a STOP. The transaction ends with its error, or NRF_ERROR_TIMEOUT, and the
+ * queue goes on. A timeout is called from the app_timer interrupt. */
+
+typedef enum
+{
+    TWI_BUS_PRIO_HIGH,      /**< Card exchanges. */
+    TWI_BUS_PRIO_LOW,       /**< Sensor polling and the like. */
+    TWI_BUS_PRIO_COUNT
+} twi_bus_prio_t;
+
+/**@brief One part on the bus. */
+typedef struct
+{
+    uint8_t             address;    /**< 7-bit address. */
+    nrf_twi_frequency_t frequency;
+    twi_bus_prio_t      prio;
+} twi_bus_dev_t;
+
+#define TWI_BUS_READ     0x01       /**< Read into p_data, else write from it. */
+#define TWI_BUS_NO_STOP  0x02       /**< Repeated start into the next transfer (writes only). */
+
+/**@brief One transfer of a transaction. */
+typedef struct
+{
+    uint8_t * p_data;
+    uint8_t   length;
+    uint8_t   flags;                /**< TWI_BUS_READ, TWI_BUS_NO_STOP. */
+} twi_bus_xfer_t;
+
+#define TWI_BUS_WRITE_XFER(p_data, length, flags)  { (uint8_t *)(p_data), (length), (flags) }
+#define TWI_BUS_READ_XFER(p_data, length)          { (p_data), (length), TWI_BUS_READ }
+
+typedef void (*twi_bus_callback_t)(ret_code_t result, void * p_context);
+
+/**@brief A transaction. Fill in the first five members; the rest belong to the bus. The
+ *        transaction, its transfers and their buffers must stay valid until the callback.
+ */
+typedef struct twi_bus_txn_s
+{
+    twi_bus_dev_t const *  p_dev;
+    twi_bus_xfer_t const * p_xfers;
+    uint8_t                count;
+    twi_bus_callback_t     callback;   /**< May be NULL. */
+    void *                 p_context;
+
+    struct twi_bus_txn_s * p_next;
+    uint8_t                index;
+    volatile bool          queued;
+} twi_bus_txn_t;
+
+/**@brief Initialize and enable the TWI instance, once. Later calls return NRF_SUCCESS, so
+ *        each driver on the bus may call it.
+ */
+ret_code_t twi_bus_init(void);
+
+/**@brief Queue a transaction and start it if the bus is free. Any context.
+ *
+ * @retval NRF_SUCCESS              Queued; the callback reports the result.
+ * @retval NRF_ERROR_INVALID_PARAM  No transfers.
+ * @retval NRF_ERROR_BUSY           The transaction is still queued or running.
+ */
+ret_code_t twi_bus_schedule(twi_bus_txn_t * p_txn);
+
+/**@brief Run the transfers at the priority of @p p_dev and return when they have finished.
+ *
+ * @note Spins: not from an interrupt at or above TWI_BUS_IRQ_PRIORITY.
+ *
+ * @return NRF_SUCCESS, NRF_ERROR_DRV_TWI_ERR_ANACK or NRF_ERROR_DRV_TWI_ERR_DNACK, or an error
+ *         of nrf_drv_twi_xfer().
+ */
+ret_code_t twi_bus_perform(twi_bus_dev_t const * p_dev, twi_bus_xfer_t const * p_xfers, uint8_t count);
+
+/**@brief Whether no transaction is queued or running. */
+bool twi_bus_idle(void);
+
+/**@brief Errors on the bus since start, saturated. */
+typedef struct
+{
+    uint16_t anack;         /**< Address not acknowledged: the part is away or busy. */
+    uint16_t dnack;         /**< Data byte not acknowledged. */
+    uint16_t refused;       /**< The driver did not start a transfer. */
+    uint16_t timeouts;      /**< Transfers that did not end: SCL or SDA held. */
+    uint16_t stuck;         /**< Errors after which SDA stayed low. */
+    uint16_t recoveries;    /**< Bus cleared and driver set up again. */
+} twi_bus_stats_t;
+
+void twi_bus_stats_get(twi_bus_stats_t * p_stats);
+
+#endif
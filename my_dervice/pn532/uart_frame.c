@@ -0,0 +1,471 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(UART_FRAME)
+#include "uart_frame.h"
+#include "app_fifo.h"
+#include "app_util_platform.h"
+#include "nrf_drv_ppi.h"
+#include "nrf_timer.h"
+#include "nrf_gpio.h"
+#ifdef UARTE_PRESENT
+#include "nrf_uarte.h"
+#else
+#include "nrf_uart.h"
+#endif
+
+#if APP_UART_ENABLED || UART0_ENABLED
+#error "uart_frame takes UART0, set APP_UART_ENABLED and UART0_ENABLED to 0"
+#endif
+#if TIMER2_ENABLED
+#error "uart_frame times the idle line on TIMER2, set TIMER2_ENABLED to 0"
+#endif
+#if !PPI_ENABLED
+#error "uart_frame starts the idle timer by PPI, set PPI_ENABLED"
+#endif
+#if (UART_FRAME_MAX_LEN < 1) || (UART_FRAME_MAX_LEN > 255)
+#error "UART_FRAME_MAX_LEN must fit the 8-bit MAXCNT of the UARTE"
+#endif
+
+#define IDLE_TIMER      NRF_TIMER2
+#define TX_SPAN_MAX     255         /**< MAXCNT of the UARTE: bytes per EasyDMA transmission. */
+
+static uart_frame_handler_t m_handler;
+static uint8_t              m_rx_buf[2][UART_FRAME_MAX_LEN];
+static app_fifo_t           m_tx_fifo;
+static uint8_t              m_tx_fifo_buf[UART_FRAME_TX_BUF_SIZE];
+static volatile bool        m_tx_active;    /**< The transmitter owns the FIFO head. */
+static nrf_ppi_channel_t    m_ppi_clear;
+static nrf_ppi_channel_t    m_ppi_start;
+
+#ifdef UARTE_PRESENT
+static uint8_t              m_tx_len;       /**< Bytes of the FIFO the DMA is sending in place. */
+static uint8_t              m_rx_cur;       /**< Buffer the DMA fills. */
+#else
+static volatile uint8_t     m_fill;         /**< Buffer the UART interrupt fills. */
+static volatile uint16_t    m_fill_len;
+static volatile bool        m_ready;        /**< The other buffer holds a frame to hand over. */
+static uint16_t             m_ready_len;
+static volatile bool        m_dropped;
+static volatile uint32_t    m_error_mask;
+#endif
+
+
+static void rx_deliver(uint8_t const * p_data, uint16_t len)
+{
+    uart_frame_evt_t evt = {.type = UART_FRAME_EVT_RX};
+
+    evt.params.rx.p_data = p_data;
+    evt.params.rx.len    = len;
+    m_handler(&evt);
+}
+
+
+static void evt_send(uart_frame_evt_type_t type, uint32_t error_mask)
+{
+    uart_frame_evt_t evt = {.type = type};
+
+    evt.params.error_mask = error_mask;
+    m_handler(&evt);
+}
+
+
+/**@brief Send the next byte (nRF51) or chunk (nRF52) of the FIFO.
+ *
+ * @return false if the FIFO is empty.
+ */
+static bool tx_next(void)
+{
+#ifdef UARTE_PRESENT
+    uint8_t * p_span;
+    uint32_t  len;
+
+    // Sent in place; the bytes stay in the FIFO until the ENDTX releases them.
+    if (app_fifo_read_span_get(&m_tx_fifo, &p_span, &len) != NRF_SUCCESS)
+    {
+        return false;
+    }
+    m_tx_len = (uint8_t)MIN(len, TX_SPAN_MAX);
+    nrf_uarte_tx_buffer_set(NRF_UARTE0, p_span, m_tx_len);
+    nrf_uarte_task_trigger(NRF_UARTE0, NRF_UARTE_TASK_STARTTX);
+#else
+    uint8_t byte;
+
+    if (app_fifo_get(&m_tx_fifo, &byte) != NRF_SUCCESS)
+    {
+        return false;
+    }
+    nrf_uart_txd_set(NRF_UART0, byte);
+#endif
+    return true;
+}
+
+
+static void tx_end(void);
+
+
+/**@brief Start the transmitter unless it is already running. Any context. */
+static void tx_kick(void)
+{
+    bool start;
+
+    CRITICAL_REGION_ENTER();
+    start       = !m_tx_active;
+    m_tx_active = true;
+    CRITICAL_REGION_EXIT();
+
+    if (!start)
+    {
+        return;
+    }
+#ifndef UARTE_PRESENT
+    nrf_uart_task_trigger(NRF_UART0, NRF_UART_TASK_STARTTX);
+#endif
+    if (!tx_next())
+    {
+        tx_end();
+    }
+}
+
+
+/**@brief The FIFO ran dry: let the transmitter go, unless a byte was put in meanwhile. */
+static void tx_end(void)
+{
+    uint8_t byte;
+
+#ifndef UARTE_PRESENT
+    nrf_uart_task_trigger(NRF_UART0, NRF_UART_TASK_STOPTX);
+#endif
+    m_tx_active = false;
+
+    // A put between the empty read and here found the transmitter still active.
+    if (app_fifo_peek(&m_tx_fifo, 0, &byte) == NRF_SUCCESS)
+    {
+        tx_kick();
+    }
+}
+
+
+uint32_t app_uart_put(uint8_t byte)
+{
+    uint32_t err_code;
+
+    err_code = app_fifo_put(&m_tx_fifo, byte);
+    if (err_code == NRF_SUCCESS)
+    {
+        tx_kick();
+    }
+    return err_code;
+}
+
+
+uint32_t app_uart_get(uint8_t * p_byte)
+{
+    UNUSED_PARAMETER(p_byte);
+
+    // Received bytes only leave as frames.
+    return NRF_ERROR_NOT_FOUND;
+}
+
+
+#ifdef UARTE_PRESENT
+
+void UART0_IRQHandler(void)
+{
+    NRF_UARTE_Type * p_uarte = NRF_UARTE0;
+
+    if (nrf_uarte_event_check(p_uarte, NRF_UARTE_EVENT_ERROR))
+    {
+        nrf_uarte_event_clear(p_uarte, NRF_UARTE_EVENT_ERROR);
+        evt_send(UART_FRAME_EVT_ERROR, nrf_uarte_errorsrc_get_and_clear(p_uarte));
+    }
+
+    // Before RXSTARTED: when both are pending, the buffer that ended is the one started last.
+    if (nrf_uarte_event_check(p_uarte, NRF_UARTE_EVENT_ENDRX))
+    {
+        uint8_t const * p_data = m_rx_buf[m_rx_cur];
+        uint32_t        len;
+
+        nrf_uarte_event_clear(p_uarte, NRF_UARTE_EVENT_ENDRX);
+        len = nrf_uarte_rx_amount_get(p_uarte);
+        if (len > 0)
+        {
+            rx_deliver(p_data, len);
+        }
+    }
+
+    if (nrf_uarte_event_check(p_uarte, NRF_UARTE_EVENT_RXSTARTED))
+    {
+        nrf_uarte_event_clear(p_uarte, NRF_UARTE_EVENT_RXSTARTED);
+
+        // The pointer is latched: it names the buffer now filling, and can take the next one.
+        m_rx_cur = (p_uarte->RXD.PTR == (uint32_t)m_rx_buf[0]) ? 0 : 1;
+        nrf_uarte_rx_buffer_set(p_uarte, m_rx_buf[m_rx_cur ^ 1], UART_FRAME_MAX_LEN);
+    }
+
+    if (nrf_uarte_event_check(p_uarte, NRF_UARTE_EVENT_RXTO))
+    {
+        // Stopped on an idle line; the ENDRX of the frame came before.
+        nrf_uarte_event_clear(p_uarte, NRF_UARTE_EVENT_RXTO);
+        nrf_uarte_shorts_enable(p_uarte, NRF_UARTE_SHORT_ENDRX_STARTRX);
+        nrf_uarte_task_trigger(p_uarte, NRF_UARTE_TASK_STARTRX);
+    }
+
+    if (nrf_uarte_event_check(p_uarte, NRF_UARTE_EVENT_ENDTX))
+    {
+        nrf_uarte_event_clear(p_uarte, NRF_UARTE_EVENT_ENDTX);
+        UNUSED_RETURN_VALUE(app_fifo_read_span_release(&m_tx_fifo, m_tx_len));
+        m_tx_len = 0;
+        if (!tx_next())
+        {
+            tx_end();
+        }
+    }
+}
+
+#else
+
+/**@brief End the frame in the fill buffer and hand it to the TIMER2 interrupt. Any priority. */
+static void frame_close(void)
+{
+    bool pend = false;
+
+    CRITICAL_REGION_ENTER();
+    if (m_fill_len > 0)
+    {
+        if (m_ready)
+        {
+            m_dropped = true;
+        }
+        else
+        {
+            m_ready_len = m_fill_len;
+            m_ready     = true;
+            m_fill     ^= 1;
+        }
+        m_fill_len = 0;
+        pend       = true;
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (pend)
+    {
+        NVIC_SetPendingIRQ(TIMER2_IRQn);
+    }
+}
+
+
+void UART0_IRQHandler(void)
+{
+    if (nrf_uart_event_check(NRF_UART0, NRF_UART_EVENT_ERROR))
+    {
+        nrf_uart_event_clear(NRF_UART0, NRF_UART_EVENT_ERROR);
+        m_error_mask |= nrf_uart_errorsrc_get_and_clear(NRF_UART0);
+        NVIC_SetPendingIRQ(TIMER2_IRQn);
+    }
+
+    while (nrf_uart_event_check(NRF_UART0, NRF_UART_EVENT_RXDRDY))
+    {
+        nrf_uart_event_clear(NRF_UART0, NRF_UART_EVENT_RXDRDY);
+        m_rx_buf[m_fill][m_fill_len++] = nrf_uart_rxd_get(NRF_UART0);
+        if (m_fill_len == UART_FRAME_MAX_LEN)
+        {
+            frame_close();
+        }
+    }
+
+    if (nrf_uart_event_check(NRF_UART0, NRF_UART_EVENT_TXDRDY))
+    {
+        nrf_uart_event_clear(NRF_UART0, NRF_UART_EVENT_TXDRDY);
+        if (!tx_next())
+        {
+            tx_end();
+        }
+    }
+}
+
+#endif
+
+
+void TIMER2_IRQHandler(void)
+{
+    if (nrf_timer_event_check(IDLE_TIMER, NRF_TIMER_EVENT_COMPARE0))
+    {
+        nrf_timer_event_clear(IDLE_TIMER, NRF_TIMER_EVENT_COMPARE0);
+#ifdef UARTE_PRESENT
+        // The ENDRX of the stop carries the frame, the RXTO restarts the reception.
+        nrf_uarte_shorts_disable(NRF_UARTE0, NRF_UARTE_SHORT_ENDRX_STARTRX);
+        nrf_uarte_task_trigger(NRF_UARTE0, NRF_UARTE_TASK_STOPRX);
+#else
+        frame_close();
+#endif
+    }
+
+#ifndef UARTE_PRESENT
+    uint32_t error_mask;
+    bool     dropped;
+
+    CRITICAL_REGION_ENTER();
+    error_mask   = m_error_mask;
+    m_error_mask = 0;
+    dropped      = m_dropped;
+    m_dropped    = false;
+    CRITICAL_REGION_EXIT();
+
+    if (error_mask != 0)
+    {
+        evt_send(UART_FRAME_EVT_ERROR, error_mask);
+    }
+    if (dropped)
+    {
+        evt_send(UART_FRAME_EVT_DROPPED, 0);
+    }
+
+    // While a frame is ready the fill buffer does not change, so the other one is stable.
+    if (m_ready)
+    {
+        rx_deliver(m_rx_buf[m_fill ^ 1], m_ready_len);
+        m_ready = false;
+    }
+#endif
+}
+
+
+/**@brief TIMER2 at 1 MHz, cleared and started by each received byte, stopping at the idle time. */
+static ret_code_t idle_timer_init(void)
+{
+    ret_code_t err_code;
+    uint32_t   rxdrdy;
+
+    nrf_timer_mode_set(IDLE_TIMER, NRF_TIMER_MODE_TIMER);
+    nrf_timer_bit_width_set(IDLE_TIMER, NRF_TIMER_BIT_WIDTH_16);
+    nrf_timer_frequency_set(IDLE_TIMER, NRF_TIMER_FREQ_1MHz);
+    nrf_timer_cc_write(IDLE_TIMER, NRF_TIMER_CC_CHANNEL0, UART_FRAME_IDLE_US);
+    nrf_timer_shorts_enable(IDLE_TIMER,
+                            NRF_TIMER_SHORT_COMPARE0_STOP_MASK | NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK);
+    nrf_timer_event_clear(IDLE_TIMER, NRF_TIMER_EVENT_COMPARE0);
+    nrf_timer_int_enable(IDLE_TIMER, NRF_TIMER_INT_COMPARE0_MASK);
+    NVIC_ClearPendingIRQ(TIMER2_IRQn);
+    NVIC_SetPriority(TIMER2_IRQn, UART_FRAME_IRQ_PRIORITY);
+    NVIC_EnableIRQ(TIMER2_IRQn);
+
+#ifdef UARTE_PRESENT
+    // nrf_uarte has no RXDRDY in its event list; the register is there all the same.
+    rxdrdy = (uint32_t)&NRF_UARTE0->EVENTS_RXDRDY;
+#else
+    rxdrdy = nrf_uart_event_address_get(NRF_UART0, NRF_UART_EVENT_RXDRDY);
+#endif
+
+    err_code = nrf_drv_ppi_init();
+    if ((err_code != NRF_SUCCESS) && (err_code != NRF_ERROR_MODULE_ALREADY_INITIALIZED))
+    {
+        return err_code;
+    }
+    err_code = nrf_drv_ppi_channel_alloc(&m_ppi_clear);
+    VERIFY_SUCCESS(err_code);
+    err_code = nrf_drv_ppi_channel_alloc(&m_ppi_start);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = nrf_drv_ppi_channel_assign(m_ppi_clear, rxdrdy,
+                                          (uint32_t)nrf_timer_task_address_get(IDLE_TIMER, NRF_TIMER_TASK_CLEAR));
+    VERIFY_SUCCESS(err_code);
+    err_code = nrf_drv_ppi_channel_assign(m_ppi_start, rxdrdy,
+                                          (uint32_t)nrf_timer_task_address_get(IDLE_TIMER, NRF_TIMER_TASK_START));
+    VERIFY_SUCCESS(err_code);
+
+    err_code = nrf_drv_ppi_channel_enable(m_ppi_clear);
+    VERIFY_SUCCESS(err_code);
+    return nrf_drv_ppi_channel_enable(m_ppi_start);
+}
+
+
+static void pins_init(app_uart_comm_params_t const * p_params)
+{
+    nrf_gpio_pin_set(p_params->tx_pin_no);
+    nrf_gpio_cfg_output(p_params->tx_pin_no);
+    nrf_gpio_cfg_input(p_params->rx_pin_no, NRF_GPIO_PIN_NOPULL);
+
+    if (p_params->flow_control != APP_UART_FLOW_CONTROL_DISABLED)
+    {
+        nrf_gpio_pin_set(p_params->rts_pin_no);
+        nrf_gpio_cfg_output(p_params->rts_pin_no);
+        nrf_gpio_cfg_input(p_params->cts_pin_no, NRF_GPIO_PIN_NOPULL);
+    }
+}
+
+
+ret_code_t uart_frame_init(app_uart_comm_params_t const * p_params, uart_frame_handler_t handler)
+{
+    ret_code_t err_code;
+    bool       hwfc = (p_params->flow_control != APP_UART_FLOW_CONTROL_DISABLED);
+
+    if (handler == NULL)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    m_handler = handler;
+
+    err_code = app_fifo_init(&m_tx_fifo, m_tx_fifo_buf, sizeof(m_tx_fifo_buf));
+    VERIFY_SUCCESS(err_code);
+
+    pins_init(p_params);
+    err_code = idle_timer_init();
+    VERIFY_SUCCESS(err_code);
+
+#ifdef UARTE_PRESENT
+    NRF_UARTE_Type * p_uarte = NRF_UARTE0;
+
+    nrf_uarte_baudrate_set(p_uarte, (nrf_uarte_baudrate_t)p_params->baud_rate);
+    nrf_uarte_configure(p_uarte,
+                        p_params->use_parity ? NRF_UARTE_PARITY_INCLUDED : NRF_UARTE_PARITY_EXCLUDED,
+                        hwfc ? NRF_UARTE_HWFC_ENABLED : NRF_UARTE_HWFC_DISABLED);
+    nrf_uarte_txrx_pins_set(p_uarte, p_params->tx_pin_no, p_params->rx_pin_no);
+    if (hwfc)
+    {
+        nrf_uarte_hwfc_pins_set(p_uarte, p_params->rts_pin_no, p_params->cts_pin_no);
+    }
+
+    nrf_uarte_event_clear(p_uarte, NRF_UARTE_EVENT_ENDRX);
+    nrf_uarte_event_clear(p_uarte, NRF_UARTE_EVENT_ENDTX);
+    nrf_uarte_event_clear(p_uarte, NRF_UARTE_EVENT_ERROR);
+    nrf_uarte_event_clear(p_uarte, NRF_UARTE_EVENT_RXTO);
+    nrf_uarte_event_clear(p_uarte, NRF_UARTE_EVENT_RXSTARTED);
+    nrf_uarte_int_enable(p_uarte, NRF_UARTE_INT_ENDRX_MASK | NRF_UARTE_INT_ENDTX_MASK |
+                                  NRF_UARTE_INT_ERROR_MASK | NRF_UARTE_INT_RXTO_MASK |
+                                  NRF_UARTE_INT_RXSTARTED_MASK);
+    NVIC_ClearPendingIRQ(UART0_IRQn);
+    NVIC_SetPriority(UART0_IRQn, UART_FRAME_IRQ_PRIORITY);
+    NVIC_EnableIRQ(UART0_IRQn);
+    nrf_uarte_enable(p_uarte);
+
+    // The first buffer is taken at STARTRX; RXSTARTED hands over the second.
+    m_rx_cur = 0;
+    nrf_uarte_rx_buffer_set(p_uarte, m_rx_buf[0], UART_FRAME_MAX_LEN);
+    nrf_uarte_shorts_enable(p_uarte, NRF_UARTE_SHORT_ENDRX_STARTRX);
+    nrf_uarte_task_trigger(p_uarte, NRF_UARTE_TASK_STARTRX);
+#else
+    nrf_uart_baudrate_set(NRF_UART0, (nrf_uart_baudrate_t)p_params->baud_rate);
+    nrf_uart_configure(NRF_UART0,
+                       p_params->use_parity ? NRF_UART_PARITY_INCLUDED : NRF_UART_PARITY_EXCLUDED,
+                       hwfc ? NRF_UART_HWFC_ENABLED : NRF_UART_HWFC_DISABLED);
+    nrf_uart_txrx_pins_set(NRF_UART0, p_params->tx_pin_no, p_params->rx_pin_no);
+    if (hwfc)
+    {
+        nrf_uart_hwfc_pins_set(NRF_UART0, p_params->rts_pin_no, p_params->cts_pin_no);
+    }
+
+    nrf_uart_event_clear(NRF_UART0, NRF_UART_EVENT_RXDRDY);
+    nrf_uart_event_clear(NRF_UART0, NRF_UART_EVENT_TXDRDY);
+    nrf_uart_event_clear(NRF_UART0, NRF_UART_EVENT_ERROR);
+    nrf_uart_int_enable(NRF_UART0, NRF_UART_INT_MASK_RXDRDY | NRF_UART_INT_MASK_TXDRDY |
+                                   NRF_UART_INT_MASK_ERROR);
+    // Above the frame handler, so the six byte RX FIFO is emptied while a frame is handed over.
+    NVIC_ClearPendingIRQ(UART0_IRQn);
+    NVIC_SetPriority(UART0_IRQn, APP_IRQ_PRIORITY_HIGH);
+    NVIC_EnableIRQ(UART0_IRQn);
+    nrf_uart_enable(NRF_UART0);
+    nrf_uart_task_trigger(NRF_UART0, NRF_UART_TASK_STARTRX);
+#endif
+
+    return NRF_SUCCESS;
+}
+
+#endif //NRF_MODULE_ENABLED(UART_FRAME)
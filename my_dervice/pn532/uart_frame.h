@@ -0,0 +1,64 @@
+#ifndef __UART_FRAME_H__
+#define __UART_FRAME_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+#include "app_uart.h"
+
+/* The command link to the building controller, one event per frame instead of per byte:
+ *
+ *   frame     the bytes up to an idle line of UART_FRAME_IDLE_US, or UART_FRAME_MAX_LEN of them;
+ *             TIMER2 is cleared and started by each RXDRDY through PPI and stops at the idle
+ *             time, so no interrupt runs per byte for the timing
+ *   nRF52     UARTE moves the bytes by EasyDMA into two buffers, the next one given to the
+ *             peripheral as soon as it starts on the current one; an idle line stops the
+ *             reception and restarts it on the other buffer
+ *   nRF51     no EasyDMA: the UART interrupt, at APP_IRQ_PRIORITY_HIGH, only stores each byte
+ *             into the current buffer; the frame is handed over from the TIMER2 interrupt, at
+ *             UART_FRAME_IRQ_PRIORITY, while the next one fills the other buffer
+ *   TX        app_uart_put() is served here, from a UART_FRAME_TX_BUF_SIZE FIFO, so printf and
+ *             the echo keep working; app_uart_get() has nothing to give
+ *
+ * At 1 Mbaud the nRF51 needs flow control: the SoftDevice can hold the CPU for longer than its
+ * six byte RX FIFO lasts. Replaces app_uart on UART0: APP_UART_ENABLED and UART0_ENABLED must
+ * be 0, and TIMER2_ENABLED as well. */
+
+typedef enum
+{
+    UART_FRAME_EVT_RX,          /**< A frame arrived. */
+    UART_FRAME_EVT_ERROR,       /**< Overrun, parity, framing or break; the frame goes on. */
+    UART_FRAME_EVT_DROPPED,     /**< A frame ended while the one before was still handed over. */
+} uart_frame_evt_type_t;
+
+typedef struct
+{
+    uart_frame_evt_type_t type;
+    union
+    {
+        struct
+        {
+            uint8_t const * p_data;     /**< Valid during the handler call only. */
+            uint16_t        len;
+        } rx;
+        uint32_t error_mask;            /**< ERRORSRC, for UART_FRAME_EVT_ERROR. */
+    } params;
+} uart_frame_evt_t;
+
+/**@brief Frame handler, called from the UART (nRF52) or TIMER2 (nRF51) interrupt at
+ *        UART_FRAME_IRQ_PRIORITY.
+ */
+typedef void (*uart_frame_handler_t)(uart_frame_evt_t const * p_evt);
+
+/**@brief Set UART0 up and start receiving.
+ *
+ * @param[in] p_params  Pins, flow control and the BAUDRATE register value of the peripheral
+ *                      used (UARTE on the nRF52); use_parity is honoured.
+ * @param[in] handler   Frame handler.
+ *
+ * @retval NRF_SUCCESS              Receiving.
+ * @retval NRF_ERROR_INVALID_PARAM  @p handler is NULL.
+ * @return Any error from nrf_drv_ppi.
+ */
+ret_code_t uart_frame_init(app_uart_comm_params_t const * p_params, uart_frame_handler_t handler);
+
+#endif
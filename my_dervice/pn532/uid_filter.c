@@ -0,0 +1,123 @@
+#include "sdk_common.h"
+#if NRF_MODULE_ENABLED(UID_FILTER)
+#include "uid_filter.h"
+#include "wall_clock.h"
+#include "app_timer.h"
+#include <string.h>
+
+#if !NRF_MODULE_ENABLED(WALL_CLOCK)
+#error "uid_filter ages its entries with wall_clock_ticks(), set WALL_CLOCK_ENABLED"
+#endif
+
+#define HOLDOFF_TICKS  APP_TIMER_TICKS(UID_FILTER_HOLDOFF_MS, APP_TIMER_CONFIG_PRESCALER)
+
+STATIC_ASSERT(IS_POWER_OF_TWO(UID_FILTER_TABLE_SIZE));
+
+typedef enum
+{
+    SLOT_EMPTY,    /**< Never used, ends a probe sequence. */
+    SLOT_USED,
+    SLOT_EXPIRED,  /**< Free, but lookups have to probe past it. */
+} slot_state_t;
+
+typedef struct
+{
+    uint8_t  state;
+    uint8_t  uid_len;
+    uint8_t  uid[UID_FILTER_UID_MAX_LEN];
+    uint64_t last_seen;  /**< wall_clock_ticks() at the last detection. */
+} uid_filter_slot_t;
+
+static uid_filter_slot_t m_table[UID_FILTER_TABLE_SIZE];
+
+
+/**@brief FNV-1a over the UID bytes. */
+static uint32_t uid_hash(uint8_t const * p_uid, uint8_t uid_len)
+{
+    uint32_t hash = 2166136261UL;
+
+    for (uint8_t i = 0; i < uid_len; i++)
+    {
+        hash = (hash ^ p_uid[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+
+static uint64_t age_get(uid_filter_slot_t const * p_slot, uint64_t now)
+{
+    return now - p_slot->last_seen;
+}
+
+
+void uid_filter_init(void)
+{
+    memset(m_table, 0, sizeof(m_table));
+}
+
+
+uid_filter_result_t uid_filter_check(uint8_t const * p_uid, uint8_t uid_len)
+{
+    uint64_t            now    = wall_clock_ticks();
+    uint32_t            start  = uid_hash(p_uid, MIN(uid_len, UID_FILTER_UID_MAX_LEN));
+    uid_filter_slot_t * p_free = NULL;
+    uid_filter_slot_t * p_old  = NULL;
+    uint64_t            oldest = 0;
+
+    uid_len = MIN(uid_len, UID_FILTER_UID_MAX_LEN);
+
+    // Expire first, so that a stale entry never counts as present after the hold-off.
+    for (uint32_t i = 0; i < UID_FILTER_TABLE_SIZE; i++)
+    {
+        if ((m_table[i].state == SLOT_USED) && (age_get(&m_table[i], now) >= HOLDOFF_TICKS))
+        {
+            m_table[i].state = SLOT_EXPIRED;
+        }
+    }
+
+    for (uint32_t n = 0; n < UID_FILTER_TABLE_SIZE; n++)
+    {
+        uid_filter_slot_t * p_slot = &m_table[(start + n) & (UID_FILTER_TABLE_SIZE - 1)];
+
+        if (p_slot->state == SLOT_EMPTY)
+        {
+            if (p_free == NULL)
+            {
+                p_free = p_slot;
+            }
+            break;
+        }
+        if (p_slot->state == SLOT_EXPIRED)
+        {
+            if (p_free == NULL)
+            {
+                p_free = p_slot;
+            }
+            continue;
+        }
+        if ((p_slot->uid_len == uid_len) && (memcmp(p_slot->uid, p_uid, uid_len) == 0))
+        {
+            p_slot->last_seen = now;
+            return UID_FILTER_STILL_PRESENT;
+        }
+        if (age_get(p_slot, now) >= oldest)
+        {
+            oldest = age_get(p_slot, now);
+            p_old  = p_slot;
+        }
+    }
+
+    if (p_free == NULL)
+    {
+        p_free = p_old;
+    }
+
+    p_free->state     = SLOT_USED;
+    p_free->uid_len   = uid_len;
+    p_free->last_seen = now;
+    memcpy(p_free->uid, p_uid, uid_len);
+
+    return UID_FILTER_NEW;
+}
+
+#endif //NRF_MODULE_ENABLED(UID_FILTER)
@@ -0,0 +1,30 @@
+#ifndef __UID_FILTER_H__
+#define __UID_FILTER_H__
+
+#include <stdint.h>
+
+#define UID_FILTER_UID_MAX_LEN  10  /**< Triple size NFCID. */
+
+/**@brief What a detection means once repeats have been merged. */
+typedef enum
+{
+    UID_FILTER_NEW,            /**< First detection, or the card was away for longer than the hold-off. */
+    UID_FILTER_STILL_PRESENT,  /**< Seen again within the hold-off window; no new event. */
+} uid_filter_result_t;
+
+/**@brief Forget all cards. */
+void uid_filter_init(void);
+
+/**@brief Record a detection and tell whether it starts a new event.
+ *
+ * @details Every detection restarts the card's hold-off window of UID_FILTER_HOLDOFF_MS, so a
+ *          card left on the reader stays in the "still present" state for as long as it keeps
+ *          being detected. Cards are kept in a table of UID_FILTER_TABLE_SIZE entries hashed by
+ *          UID; when it is full the card seen least recently is forgotten.
+ *
+ * @param[in] p_uid    Card UID.
+ * @param[in] uid_len  UID length, longer UIDs are cut to UID_FILTER_UID_MAX_LEN.
+ */
+uid_filter_result_t uid_filter_check(uint8_t const * p_uid, uint8_t uid_len);
+
+#endif